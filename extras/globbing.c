@@ -28,85 +28,567 @@
  */
 
 
-static int matchesPattern(const char *fname, const char *wildcard,
-                          int caseSensitive)
+/*
+ * A pattern is compiled into one GlobComponent per '/'-separated piece.
+ *  Each of those is split at its '*'s into GlobParts: the first part has to
+ *  be at the start of a name, the last at the end, and the ones between
+ *  are found leftmost-first. That's enough for '*' and '?', and never needs
+ *  to back up, unlike trying every way each '*' could expand.
+ */
+typedef struct GlobPart
+{
+    const char *text;  /* folded already; '?' matches any byte. */
+    size_t len;
+} GlobPart;
+
+typedef struct GlobComponent
+{
+    int recursive;  /* it's "**": any number of directories, even none. */
+    int stars;  /* non-zero if there was a '*' in it at all. */
+    int literal;  /* no wildcards; a name has to be (parts[0]), exactly. */
+    const char *prefix;  /* as written, up to the first wildcard. */
+    size_t minlen;  /* shortest name this could match. */
+    GlobPart *parts;
+    size_t partCount;
+} GlobComponent;
+
+struct PHYSFSEXT_Glob
 {
-    char x, y;
-    const char *fnameptr = fname;
-    const char *wildptr = wildcard;
+    int caseSensitive;
+    unsigned char fold[256];  /* maps each byte to what we compare. */
+    GlobComponent *components;
+    size_t count;
+    GlobPart *parts;
+    char *text;  /* everything (components) and (parts) point into. */
+};
 
-    while ((*wildptr) && (*fnameptr))
+
+void PHYSFSEXT_freeGlob(PHYSFSEXT_Glob *glob)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    if (glob != NULL)
     {
-        y = *wildptr;
-        if (y == '*')
-        {
-            do
-            {
-                wildptr++;  /* skip multiple '*' in a row... */
-            } while (*wildptr == '*');
+        allocator->Free(glob->components);
+        allocator->Free(glob->parts);
+        allocator->Free(glob->text);
+        allocator->Free(glob);
+    } /* if */
+} /* PHYSFSEXT_freeGlob */
 
-            y = (caseSensitive) ? *wildptr : (char) tolower(*wildptr);
 
-            while (1)
-            {
-                x = (caseSensitive) ? *fnameptr : (char) tolower(*fnameptr);
-                if ((!x) || (x == y))
-                    break;
-                else
-                    fnameptr++;
-            } /* while */
-        } /* if */
+PHYSFSEXT_Glob *PHYSFSEXT_compileGlob(const char *wildcard, int caseSensitive)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    const size_t len = strlen(wildcard);
+    PHYSFSEXT_Glob *glob;
+    const char *ptr;
+    GlobComponent *comp;
+    GlobPart *part;
+    char *text;
+    size_t maxcomps = 2;  /* room for an implied "*" after a final "**". */
+    size_t maxparts = 1;
+    int i;
 
-        else if (y == '?')
+    for (ptr = wildcard; *ptr; ptr++)
+    {
+        if (*ptr == '/')
+            maxcomps++;
+        else if (*ptr == '*')
+            maxparts++;
+    } /* for */
+    maxparts += maxcomps;
+
+    glob = (PHYSFSEXT_Glob *) allocator->Malloc(sizeof (PHYSFSEXT_Glob));
+    if (glob == NULL)
+        return NULL;
+
+    memset(glob, '\0', sizeof (*glob));
+    glob->components = (GlobComponent *)
+                          allocator->Malloc(maxcomps * sizeof (GlobComponent));
+    glob->parts = (GlobPart *) allocator->Malloc(maxparts * sizeof (GlobPart));
+    glob->text = (char *) allocator->Malloc((len * 2) + maxcomps);
+    if ((!glob->components) || (!glob->parts) || (!glob->text))
+    {
+        PHYSFSEXT_freeGlob(glob);
+        return NULL;
+    } /* if */
+
+    glob->caseSensitive = caseSensitive;
+    for (i = 0; i < 256; i++)
+    {
+        const int lower = ((i >= 'A') && (i <= 'Z')) ? (i - 'A' + 'a') : i;
+        glob->fold[i] = (unsigned char) (caseSensitive ? i : lower);
+    } /* for */
+
+    part = glob->parts;
+    text = glob->text;
+    ptr = wildcard;
+    while (1)
+    {
+        const char *name;
+        const char *end;
+
+        while (*ptr == '/')  /* "a//b" is "a/b", as paths are. */
+            ptr++;
+        if (*ptr == '\0')
+            break;
+
+        end = ptr + strcspn(ptr, "/");
+        comp = &glob->components[glob->count++];
+        memset(comp, '\0', sizeof (*comp));
+
+        if ((end - ptr == 2) && (ptr[0] == '*') && (ptr[1] == '*'))
         {
-            wildptr++;
-            fnameptr++;
-        } /* else if */
+            comp->recursive = 1;
+            ptr = end;
+            continue;
+        } /* if */
 
-        else
+        /* the prefix is kept as written, for the archives to fold. */
+        comp->prefix = text;
+        for (name = ptr; (ptr < end) && (*ptr != '*') && (*ptr != '?'); ptr++)
+            *(text++) = *ptr;
+        *(text++) = '\0';
+        ptr = name;
+
+        comp->parts = part;
+        comp->literal = 1;
+        part->text = text;
+        part->len = 0;
+        for (; ptr < end; ptr++)
         {
-            if (caseSensitive)
-                x = *fnameptr;
-            else
+            if (*ptr == '*')
             {
-                x = tolower(*fnameptr);
-                y = tolower(y);
+                comp->stars = 1;
+                comp->literal = 0;
+                comp->minlen += part->len;
+                while ((ptr + 1 < end) && (ptr[1] == '*'))
+                    ptr++;  /* "**" inside a name is just "*". */
+                part++;
+                part->text = text;
+                part->len = 0;
             } /* if */
+            else
+            {
+                if (*ptr == '?')
+                    comp->literal = 0;
+                *(text++) = (char) glob->fold[(unsigned char) *ptr];
+                part->len++;
+            } /* else */
+        } /* for */
+        comp->minlen += part->len;
+        part++;
+        comp->partCount = (size_t) (part - comp->parts);
+    } /* while */
+
+    /* a "**" at the end is everything under there, at any depth. */
+    if ((glob->count > 0) && (glob->components[glob->count - 1].recursive))
+    {
+        comp = &glob->components[glob->count++];
+        memset(comp, '\0', sizeof (*comp));
+        comp->stars = 1;
+        comp->prefix = text;
+        *(text++) = '\0';
+        comp->parts = part;
+        comp->partCount = 2;
+        part[0].text = part[1].text = text;
+        part[0].len = part[1].len = 0;
+    } /* if */
+
+    return glob;
+} /* PHYSFSEXT_compileGlob */
 
-            wildptr++;
-            fnameptr++;
 
-            if (x != y)
+static int partMatchesAt(const PHYSFSEXT_Glob *glob, const GlobPart *part,
+                         const char *str)
+{
+    const unsigned char *fold = glob->fold;
+    const char *text = part->text;
+    size_t i;
+
+    for (i = 0; i < part->len; i++)
+    {
+        const char ch = text[i];
+        if ((ch != '?') && ((char) fold[(unsigned char) str[i]] != ch))
+            return 0;
+    } /* for */
+
+    return 1;
+} /* partMatchesAt */
+
+
+static int componentMatches(const PHYSFSEXT_Glob *glob,
+                            const GlobComponent *comp,
+                            const char *name, size_t len)
+{
+    const GlobPart *first = &comp->parts[0];
+    const GlobPart *last = &comp->parts[comp->partCount - 1];
+    size_t pos, end, i;
+
+    if (!comp->stars)
+        return ((len == first->len) && (partMatchesAt(glob, first, name)));
+    else if (len < comp->minlen)
+        return 0;
+    else if (!partMatchesAt(glob, first, name))
+        return 0;
+    else if (!partMatchesAt(glob, last, name + (len - last->len)))
+        return 0;
+
+    /* taking the leftmost match for each part leaves the most for the rest. */
+    pos = first->len;
+    end = len - last->len;
+    for (i = 1; i < comp->partCount - 1; i++)
+    {
+        const GlobPart *part = &comp->parts[i];
+        while (1)
+        {
+            if (end - pos < part->len)
                 return 0;
+            else if (partMatchesAt(glob, part, name + pos))
+                break;
+            pos++;
+        } /* while */
+        pos += part->len;
+    } /* for */
+
+    return 1;
+} /* componentMatches */
+
+
+int PHYSFSEXT_matchGlob(const PHYSFSEXT_Glob *glob, const char *path)
+{
+    size_t k = 0;
+    size_t starK = 0;
+    const char *starPath = NULL;
+
+    /*
+     * "**" is to whole names what '*' is to characters, so this is the
+     *  usual wildcard match, one name at a time: if a name doesn't fit,
+     *  let the last "**" swallow one more and try again from there.
+     */
+    while (1)
+    {
+        size_t len;
+
+        while (*path == '/')
+            path++;
+        if (*path == '\0')
+            break;
+
+        len = strcspn(path, "/");
+        if ((k < glob->count) && (glob->components[k].recursive))
+        {
+            starK = ++k;
+            starPath = path;
+        } /* if */
+        else if ( (k < glob->count) &&
+                  (componentMatches(glob, &glob->components[k], path, len)) )
+        {
+            k++;
+            path += len;
+        } /* else if */
+        else if (starPath != NULL)
+        {
+            while (*starPath == '/')
+                starPath++;
+            starPath += strcspn(starPath, "/");
+            path = starPath;
+            k = starK;
+        } /* else if */
+        else
+        {
+            return 0;
         } /* else */
     } /* while */
 
-    while (*wildptr == '*')
-        wildptr++;
+    while ((k < glob->count) && (glob->components[k].recursive))
+        k++;
 
-    return (*fnameptr == *wildptr);
-} /* matchesPattern */
+    return ((k == glob->count) && (glob->count > 0));
+} /* PHYSFSEXT_matchGlob */
 
+
+/* A growable list of strings, in PhysicsFS's allocator. */
 typedef struct
 {
-    const PHYSFS_Allocator *allocator;
-    const char *wildcard;
-    int caseSensitive;
-    PHYSFS_EnumFilesCallback callback;
-    void *origData;
-} WildcardCallbackData;
+    char **items;
+    size_t count;
+    size_t allocated;
+    int failed;
+} GlobList;
+
+static void globListAdd(GlobList *list, const char *dir, const char *name)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    size_t dirlen = strlen(dir);
+    char *str;
+
+    if (list->failed)
+        return;
+
+    while ((dirlen > 0) && (dir[dirlen - 1] == '/'))
+        dirlen--;  /* so "/" and "" are both the root. */
+
+    if (list->count == list->allocated)
+    {
+        const size_t newalloc = list->allocated ? list->allocated * 2 : 32;
+        void *ptr = allocator->Realloc(list->items, newalloc * sizeof (char*));
+        if (ptr == NULL)
+        {
+            list->failed = 1;
+            return;
+        } /* if */
+        list->items = (char **) ptr;
+        list->allocated = newalloc;
+    } /* if */
+
+    str = (char *) allocator->Malloc(dirlen + strlen(name) + 2);
+    if (str == NULL)
+    {
+        list->failed = 1;
+        return;
+    } /* if */
+
+    if (dirlen == 0)
+        strcpy(str, name);
+    else
+    {
+        memcpy(str, dir, dirlen);
+        str[dirlen] = '/';
+        strcpy(str + dirlen + 1, name);
+    } /* else */
+
+    list->items[list->count++] = str;
+} /* globListAdd */
+
+
+static int globListCompare(const void *a, const void *b)
+{
+    return strcmp(*((char * const *) a), *((char * const *) b));
+} /* globListCompare */
+
+
+/* Sort the list and drop duplicates, as every archive reports its own. */
+static void globListSortUnique(GlobList *list)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    size_t i, j;
+
+    if (list->count < 2)
+        return;
+
+    qsort(list->items, list->count, sizeof (char *), globListCompare);
+    for (i = 1, j = 0; i < list->count; i++)
+    {
+        if (strcmp(list->items[i], list->items[j]) == 0)
+            allocator->Free(list->items[i]);
+        else
+            list->items[++j] = list->items[i];
+    } /* for */
+    list->count = j + 1;
+} /* globListSortUnique */
+
+
+static void globListFree(GlobList *list)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    size_t i;
+    for (i = 0; i < list->count; i++)
+        allocator->Free(list->items[i]);
+    allocator->Free(list->items);
+} /* globListFree */
+
+
+typedef struct GlobWalk GlobWalk;
+typedef void (*GlobHitCallback)(GlobWalk *walk, const char *origdir,
+                                const char *fname);
+
+struct GlobWalk
+{
+    const PHYSFSEXT_Glob *glob;
+    GlobHitCallback hit;
+    PHYSFS_EnumFilesCallback callback;  /* for hitCallback(). */
+    void *callbackData;
+    GlobList *results;  /* for hitList(). */
+    const GlobComponent *comp;  /* the one the current listing is for. */
+    const char *rel;  /* the current listing's dir, under the caller's. */
+    GlobList *names;  /* the names a listing found, if not the last one. */
+};
+
+
+static void hitCallback(GlobWalk *walk, const char *origdir, const char *fname)
+{
+    walk->callback(walk->callbackData, origdir, fname);
+} /* hitCallback */
+
+
+static void hitList(GlobWalk *walk, const char *origdir, const char *fname)
+{
+    globListAdd(walk->results, walk->rel, fname);
+} /* hitList */
+
+
+static void globMatchCallback(void *data, const char *origdir,
+                              const char *fname)
+{
+    GlobWalk *walk = (GlobWalk *) data;
+    if (componentMatches(walk->glob, walk->comp, fname, strlen(fname)))
+    {
+        if (walk->names != NULL)
+            globListAdd(walk->names, "", fname);
+        else
+            walk->hit(walk, origdir, fname);
+    } /* if */
+} /* globMatchCallback */
+
+
+static void globDirCallback(void *data, const char *origdir,
+                            const char *fname, const PHYSFS_Stat *stat)
+{
+    if (stat->filetype == PHYSFS_FILETYPE_DIRECTORY)
+        globListAdd((GlobList *) data, "", fname);
+} /* globDirCallback */
+
+
+/* The path to (name) in (dir); free it with the allocator. */
+static char *globJoin(const char *dir, const char *name)
+{
+    GlobList list;
+    memset(&list, '\0', sizeof (list));
+    globListAdd(&list, dir, name);
+    if (list.failed)
+        return NULL;
+
+    name = list.items[0];
+    PHYSFS_getAllocator()->Free(list.items);
+    return (char *) name;
+} /* globJoin */
+
+
+static void globWalkDir(GlobWalk *walk, const char *dir, const char *rel,
+                        size_t k);
+
+/* Go on with component (k) in (dir)'s subdirectory (name). */
+static void globWalkSubdir(GlobWalk *walk, const char *dir, const char *rel,
+                           const char *name, size_t k)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    char *subdir = globJoin(dir, name);
+    char *subrel = globJoin(rel, name);
+    if ((subdir != NULL) && (subrel != NULL))
+        globWalkDir(walk, subdir, subrel, k);
+    allocator->Free(subdir);
+    allocator->Free(subrel);
+} /* globWalkSubdir */
+
+
+/* Go on with component (k) in each of the subdirectories named in (list). */
+static void globWalkSubdirs(GlobWalk *walk, const char *dir, const char *rel,
+                            GlobList *list, size_t k)
+{
+    size_t i;
+    globListSortUnique(list);
+    for (i = 0; i < list->count; i++)
+        globWalkSubdir(walk, dir, rel, list->items[i], k);
+} /* globWalkSubdirs */
 
 
 /*
- * This callback sits between the enumerator and the enduser callback,
- *  filtering out files that don't match the wildcard pattern.
+ * Match component (k) and the ones after it against what's in (dir). Only
+ *  directories a component can match are listed at all, and only names
+ *  starting with its literal prefix are asked for, so "a/b*" looks at the
+ *  b-names in "a", and never at anything else anywhere.
  */
-static void wildcardCallback(void *_d, const char *origdir, const char *fname)
+static void globWalkDir(GlobWalk *walk, const char *dir, const char *rel,
+                        size_t k)
 {
-    const WildcardCallbackData *data = (const WildcardCallbackData *) _d;
-    if (matchesPattern(fname, data->wildcard, data->caseSensitive))
-        data->callback(data->origData, origdir, fname);
-} /* wildcardCallback */
+    const PHYSFSEXT_Glob *glob = walk->glob;
+    const GlobComponent *comp = &glob->components[k];
+    const int last = (k == glob->count - 1);
+    GlobList list;
+
+    memset(&list, '\0', sizeof (list));
+
+    if (comp->recursive)
+    {
+        globWalkDir(walk, dir, rel, k + 1);  /* it can match no dirs... */
+        PHYSFS_enumerateFilesStatCallback(dir, globDirCallback, &list);
+        globWalkSubdirs(walk, dir, rel, &list, k);  /* ...or one more. */
+    } /* if */
+
+    else if ((comp->literal) && (glob->caseSensitive) && (!last))
+    {
+        /* nothing to search for; listing a file or nothing finds nothing. */
+        globWalkSubdir(walk, dir, rel, comp->prefix, k + 1);
+    } /* else if */
+
+    else
+    {
+        walk->comp = comp;
+        walk->rel = rel;
+        walk->names = last ? NULL : &list;
+        PHYSFS_enumerateFilesPrefixCallback(dir, comp->prefix,
+                                            globMatchCallback, walk);
+        if (!last)
+            globWalkSubdirs(walk, dir, rel, &list, k + 1);
+    } /* else */
+
+    globListFree(&list);
+} /* globWalkDir */
+
+
+void PHYSFSEXT_enumerateFilesCallbackGlob(const char *dir,
+                                          const PHYSFSEXT_Glob *glob,
+                                          PHYSFS_EnumFilesCallback c,
+                                          void *d)
+{
+    GlobWalk walk;
+    if (glob->count == 0)
+        return;
+
+    memset(&walk, '\0', sizeof (walk));
+    walk.glob = glob;
+    walk.hit = hitCallback;
+    walk.callback = c;
+    walk.callbackData = d;
+    globWalkDir(&walk, dir, "", 0);
+} /* PHYSFSEXT_enumerateFilesCallbackGlob */
+
+
+char **PHYSFSEXT_enumerateFilesGlob(const char *dir,
+                                    const PHYSFSEXT_Glob *glob)
+{
+    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
+    GlobList results;
+    GlobWalk walk;
+    void *ptr;
+
+    memset(&results, '\0', sizeof (results));
+    memset(&walk, '\0', sizeof (walk));
+    walk.glob = glob;
+    walk.hit = hitList;
+    walk.results = &results;
+    if (glob->count != 0)
+        globWalkDir(&walk, dir, "", 0);
+
+    globListSortUnique(&results);
+    ptr = NULL;
+    if (!results.failed)
+    {
+        ptr = allocator->Realloc(results.items,
+                                 (results.count + 1) * sizeof (char *));
+    } /* if */
+
+    if (ptr == NULL)
+    {
+        globListFree(&results);
+        return NULL;
+    } /* if */
+
+    results.items = (char **) ptr;
+    results.items[results.count] = NULL;
+    return results.items;
+} /* PHYSFSEXT_enumerateFilesGlob */
 
 
 void PHYSFSEXT_enumerateFilesCallbackWildcard(const char *dir,
@@ -115,13 +597,12 @@ void PHYSFSEXT_enumerateFilesCallbackWildcard(const char *dir,
                                               PHYSFS_EnumFilesCallback c,
                                               void *d)
 {
-    WildcardCallbackData data;
-    data.allocator = PHYSFS_getAllocator();
-    data.wildcard = wildcard;
-    data.caseSensitive = caseSensitive;
-    data.callback = c;
-    data.origData = d;
-    PHYSFS_enumerateFilesCallback(dir, wildcardCallback, &data);
+    PHYSFSEXT_Glob *glob = PHYSFSEXT_compileGlob(wildcard, caseSensitive);
+    if (glob != NULL)
+    {
+        PHYSFSEXT_enumerateFilesCallbackGlob(dir, glob, c, d);
+        PHYSFSEXT_freeGlob(glob);
+    } /* if */
 } /* PHYSFSEXT_enumerateFilesCallbackWildcard */
 
 
@@ -141,53 +622,13 @@ void PHYSFSEXT_freeEnumeration(char **list)
 char **PHYSFSEXT_enumerateFilesWildcard(const char *dir, const char *wildcard,
                                         int caseSensitive)
 {
-    const PHYSFS_Allocator *allocator = PHYSFS_getAllocator();
-    char **list = PHYSFS_enumerateFiles(dir);
+    PHYSFSEXT_Glob *glob = PHYSFSEXT_compileGlob(wildcard, caseSensitive);
     char **retval = NULL;
-    int totalmatches = 0;
-    int matches = 0;
-    char **i;
-
-    for (i = list; *i != NULL; i++)
-    {
-        #if 0
-        printf("matchesPattern: '%s' vs '%s' (%s) ... %s\n", *i, wildcard,
-               caseSensitive ? "case" : "nocase",
-               matchesPattern(*i, wildcard, caseSensitive) ? "true" : "false");
-        #endif
-        if (matchesPattern(*i, wildcard, caseSensitive))
-            totalmatches++;
-    } /* for */
-
-    retval = (char **) allocator->Malloc(sizeof (char *) * (totalmatches+1));
-    if (retval != NULL)
+    if (glob != NULL)
     {
-        for (i = list; ((matches < totalmatches) && (*i != NULL)); i++)
-        {
-            if (matchesPattern(*i, wildcard, caseSensitive))
-            {
-                retval[matches] = (char *) allocator->Malloc(strlen(*i) + 1);
-                if (retval[matches] == NULL)
-                {
-                    while (matches--)
-                        allocator->Free(retval[matches]);
-                    allocator->Free(retval);
-                    retval = NULL;
-                    break;
-                } /* if */
-                strcpy(retval[matches], *i);
-                matches++;
-            } /* if */
-        } /* for */
-
-        if (retval != NULL)
-        {
-            assert(totalmatches == matches);
-            retval[matches] = NULL;
-        } /* if */
+        retval = PHYSFSEXT_enumerateFilesGlob(dir, glob);
+        PHYSFSEXT_freeGlob(glob);
     } /* if */
-
-    PHYSFS_freeList(list);
     return retval;
 } /* PHYSFSEXT_enumerateFilesWildcard */
 
@@ -65,11 +65,13 @@ extern "C" {
  * We've got [y.Sav].
  * We've got [w.sav].\endverbatim
  *
- * Feel free to sort the list however you like. We only promise there will
- *  be no duplicates, but not what order the final list will come back in.
+ * The list is sorted with strcmp(), and has no duplicates. If the pattern
+ *  has a '/' in it, the names are paths relative to (dir), like
+ *  "textures/ui_button.png".
  *
  * Wildcard strings can use the '*' and '?' characters, currently.
  * Matches can be case-insensitive if you pass a zero for argument 3.
+ * See PHYSFSEXT_compileGlob() for patterns that look in subdirectories.
  *
  * Don't forget to call PHYSFSEXT_freeEnumerator() with the return value from
  *  this function when you are done with it. As we use PhysicsFS's allocator
@@ -138,6 +140,7 @@ PHYSFS_DECL void PHYSFSEXT_freeEnumeration(char **list);
  *
  * Wildcard strings can use the '*' and '?' characters, currently.
  * Matches can be case-insensitive if you pass a zero for argument 3.
+ * See PHYSFSEXT_compileGlob() for patterns that look in subdirectories.
  *
  *    \param dir Directory, in platform-independent notation, to enumerate.
  *    \param wildcard Wildcard pattern to use for filtering.
@@ -155,6 +158,104 @@ PHYSFS_DECL void PHYSFSEXT_enumerateFilesCallbackWildcard(const char *dir,
                                               PHYSFS_EnumFilesCallback c,
                                               void *d);
 
+
+/**
+ * \brief A wildcard pattern, compiled for matching many names quickly.
+ *
+ * \sa PHYSFSEXT_compileGlob
+ */
+typedef struct PHYSFSEXT_Glob PHYSFSEXT_Glob;
+
+/**
+ * \fn PHYSFSEXT_Glob *PHYSFSEXT_compileGlob(const char *wildcard, int caseSensitive)
+ * \brief Compile a wildcard pattern once, to use it many times.
+ *
+ * The *Wildcard functions compile their pattern on every call; if you
+ *  use the same pattern over and over, compile it yourself and use the
+ *  *Glob functions instead.
+ *
+ * '*' matches any run of characters (even none) and '?' matches any one
+ *  byte, within a name. A pattern can have '/' in it to look in
+ *  subdirectories: "textures/ui_*.png" only ever lists "textures", and only
+ *  asks it for names that start with "ui_", which archives that keep their
+ *  names sorted can find without looking at the rest. A "**" on its own
+ *  between slashes (or at either end) matches any number of directories,
+ *  including none, so a "**", a slash and "*.lua" finds .lua files at any
+ *  depth. A "**" at the end of the pattern matches everything under there.
+ *
+ *    \param wildcard Wildcard pattern to compile.
+ *    \param caseSensitive Zero for case-insensitive matching (of ASCII
+ *                         letters), non-zero for case-sensitive.
+ *   \return The compiled pattern, or NULL if we ran out of memory. Free it
+ *           with PHYSFSEXT_freeGlob().
+ *
+ * \sa PHYSFSEXT_freeGlob
+ * \sa PHYSFSEXT_matchGlob
+ * \sa PHYSFSEXT_enumerateFilesGlob
+ * \sa PHYSFSEXT_enumerateFilesCallbackGlob
+ */
+PHYSFS_DECL PHYSFSEXT_Glob *PHYSFSEXT_compileGlob(const char *wildcard,
+                                                  int caseSensitive);
+
+/**
+ * \fn void PHYSFSEXT_freeGlob(PHYSFSEXT_Glob *glob)
+ * \brief Free a pattern from PHYSFSEXT_compileGlob().
+ *
+ *    \param glob The pattern to free. It is safe to pass a NULL here.
+ *
+ * \sa PHYSFSEXT_compileGlob
+ */
+PHYSFS_DECL void PHYSFSEXT_freeGlob(PHYSFSEXT_Glob *glob);
+
+/**
+ * \fn int PHYSFSEXT_matchGlob(const PHYSFSEXT_Glob *glob, const char *path)
+ * \brief See if a path matches a compiled pattern.
+ *
+ * This only looks at the string; nothing is enumerated, and (path) doesn't
+ *  have to exist.
+ *
+ *    \param glob Pattern from PHYSFSEXT_compileGlob().
+ *    \param path Name, or '/'-separated path, to match.
+ *   \return non-zero if it matches, zero if it doesn't.
+ *
+ * \sa PHYSFSEXT_compileGlob
+ */
+PHYSFS_DECL int PHYSFSEXT_matchGlob(const PHYSFSEXT_Glob *glob,
+                                    const char *path);
+
+/**
+ * \fn char **PHYSFSEXT_enumerateFilesGlob(const char *dir, const PHYSFSEXT_Glob *glob)
+ * \brief PHYSFSEXT_enumerateFilesWildcard(), with a compiled pattern.
+ *
+ *    \param dir Directory, in platform-independent notation, to search.
+ *    \param glob Pattern from PHYSFSEXT_compileGlob().
+ *   \return Null-terminated array of null-terminated strings, or NULL if
+ *           we ran out of memory. Free it with PHYSFSEXT_freeEnumeration().
+ *
+ * \sa PHYSFSEXT_enumerateFilesWildcard
+ */
+PHYSFS_DECL char **PHYSFSEXT_enumerateFilesGlob(const char *dir,
+                                                const PHYSFSEXT_Glob *glob);
+
+/**
+ * \fn void PHYSFSEXT_enumerateFilesCallbackGlob(const char *dir, const PHYSFSEXT_Glob *glob, PHYSFS_EnumFilesCallback c, void *d)
+ * \brief PHYSFSEXT_enumerateFilesCallbackWildcard(), with a compiled pattern.
+ *
+ * If the pattern has a '/' in it, the callback's (origdir) is the
+ *  directory each name was found in, not (dir).
+ *
+ *    \param dir Directory, in platform-independent notation, to search.
+ *    \param glob Pattern from PHYSFSEXT_compileGlob().
+ *    \param c Callback function to notify about each match.
+ *    \param d Application-defined data passed to callback. Can be NULL.
+ *
+ * \sa PHYSFSEXT_enumerateFilesCallbackWildcard
+ */
+PHYSFS_DECL void PHYSFSEXT_enumerateFilesCallbackGlob(const char *dir,
+                                              const PHYSFSEXT_Glob *glob,
+                                              PHYSFS_EnumFilesCallback c,
+                                              void *d);
+
 #ifdef __cplusplus
 }
 #endif
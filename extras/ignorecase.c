@@ -27,23 +27,82 @@
  *  \author Ryan C. Gordon.
  */
 
-/* I'm not screwing around with stricmp vs. strcasecmp... */
-/* !!! FIXME: this will NOT work with UTF-8 strings in physfs2.0 */
-static int caseInsensitiveStringCompare(const char *x, const char *y)
+/*
+ * Fold (str) for comparing without case, as PhysicsFS does. Returns a new
+ *  string from malloc(), or NULL if we ran out of memory.
+ */
+static char *foldName(const char *str)
 {
-    int ux, uy;
-    do
+    const size_t len = strlen(str);
+    PHYSFS_uint32 *ucs4;
+    PHYSFS_uint32 *folded;
+    char *retval;
+    size_t i, j;
+
+    for (i = 0; i < len; i++)
     {
-        ux = toupper((int) *x);
-        uy = toupper((int) *y);
-        if (ux != uy)
-            return ((ux > uy) ? 1 : -1);
-        x++;
-        y++;
-    } while ((ux) && (uy));
+        if (((unsigned char) str[i]) & 0x80)
+            break;
+    } /* for */
 
-    return 0;
-} /* caseInsensitiveStringCompare */
+    if (i == len)  /* just ASCII, which is most of the time. */
+    {
+        retval = (char *) malloc(len + 1);
+        if (retval != NULL)
+        {
+            for (i = 0; i <= len; i++)
+            {
+                const char ch = str[i];
+                retval[i] = ((ch >= 'A') && (ch <= 'Z')) ? (ch + 32) : ch;
+            } /* for */
+        } /* if */
+        return retval;
+    } /* if */
+
+    /* each byte is a codepoint at most, and that folds to three at most. */
+    ucs4 = (PHYSFS_uint32 *) malloc((len + 1) * sizeof (PHYSFS_uint32));
+    folded = (PHYSFS_uint32 *) malloc((len * 3 + 1) * sizeof (PHYSFS_uint32));
+    retval = (char *) malloc((len * 3 * 4) + 1);
+    if ((ucs4 != NULL) && (folded != NULL) && (retval != NULL))
+    {
+        PHYSFS_utf8ToUcs4(str, ucs4, (len + 1) * sizeof (PHYSFS_uint32));
+        for (i = j = 0; ucs4[i] != 0; i++)
+            j += PHYSFS_caseFold(ucs4[i], &folded[j]);
+        folded[j] = 0;
+        PHYSFS_utf8FromUcs4(folded, retval, (len * 3 * 4) + 1);
+    } /* if */
+    else
+    {
+        free(retval);
+        retval = NULL;
+    } /* else */
+
+    free(folded);
+    free(ucs4);
+    return retval;
+} /* foldName */
+
+
+/*
+ * Does (x) match (y) without case? Matches that aren't the same length in
+ *  bytes don't count, as we couldn't put one in the other's place.
+ */
+static int caseInsensitiveMatch(const char *x, const char *y)
+{
+    char *foldx, *foldy;
+    int retval = 0;
+
+    if (strlen(x) != strlen(y))
+        return 0;
+
+    foldx = foldName(x);
+    foldy = foldName(y);
+    if ((foldx != NULL) && (foldy != NULL))
+        retval = (strcmp(foldx, foldy) == 0);
+    free(foldx);
+    free(foldy);
+    return retval;
+} /* caseInsensitiveMatch */
 
 
 static int locateOneElement(char *buf)
@@ -69,9 +128,12 @@ static int locateOneElement(char *buf)
         ptr++;  /* point past dirsep to entry itself. */
     } /* else */
 
+    if (rc == NULL)
+        return 0;
+
     for (i = rc; *i != NULL; i++)
     {
-        if (caseInsensitiveStringCompare(*i, ptr) == 0)
+        if (caseInsensitiveMatch(*i, ptr))
         {
             strcpy(ptr, *i); /* found a match. Overwrite with this case. */
             PHYSFS_freeList(rc);
@@ -111,12 +173,337 @@ int PHYSFSEXT_locateCorrectCase(char *buf)
 } /* PHYSFSEXT_locateCorrectCase */
 
 
+/*
+ * The index is a hash table of directories, each listed once, with a hash
+ *  table of its names by their folded form. A directory is only listed the
+ *  first time a path goes through it, and everything is thrown away when
+ *  PHYSFS_getSearchPathGeneration() says the search path has changed.
+ */
+typedef struct CaseName
+{
+    PHYSFS_uint32 hash;  /* of (folded). */
+    size_t len;  /* strlen(name), which might not be strlen(folded). */
+    char *folded;
+    char *name;  /* as it really is. */
+    struct CaseName *next;
+} CaseName;
+
+typedef struct CaseDir
+{
+    PHYSFS_uint32 hash;  /* of (path). */
+    char *path;  /* as it really is; "" for the root. */
+    size_t nameBuckets;  /* a power of two. */
+    CaseName **names;
+    struct CaseDir *next;
+} CaseDir;
+
+struct PHYSFSEXT_CaseIndex
+{
+    PHYSFS_uint32 generation;
+    size_t dirBuckets;  /* a power of two. */
+    size_t dirCount;
+    CaseDir **dirs;
+};
+
+
+static PHYSFS_uint32 hashString(const char *str)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (*str)
+    {
+        const PHYSFS_uint32 ch = (PHYSFS_uint32) (unsigned char) *(str++);
+        hash = ((hash << 5) + hash) ^ ch;
+    } /* while */
+    return hash;
+} /* hashString */
+
+
+static void freeCaseDir(CaseDir *dir)
+{
+    size_t i;
+    for (i = 0; i < dir->nameBuckets; i++)
+    {
+        CaseName *name = dir->names[i];
+        while (name != NULL)
+        {
+            CaseName *next = name->next;
+            free(name->folded);
+            free(name);
+            name = next;
+        } /* while */
+    } /* for */
+    free(dir->names);
+    free(dir->path);
+    free(dir);
+} /* freeCaseDir */
+
+
+static void clearCaseIndex(PHYSFSEXT_CaseIndex *index)
+{
+    size_t i;
+    for (i = 0; i < index->dirBuckets; i++)
+    {
+        CaseDir *dir = index->dirs[i];
+        while (dir != NULL)
+        {
+            CaseDir *next = dir->next;
+            freeCaseDir(dir);
+            dir = next;
+        } /* while */
+        index->dirs[i] = NULL;
+    } /* for */
+    index->dirCount = 0;
+} /* clearCaseIndex */
+
+
+PHYSFSEXT_CaseIndex *PHYSFSEXT_createCaseIndex(void)
+{
+    PHYSFSEXT_CaseIndex *index;
+
+    index = (PHYSFSEXT_CaseIndex *) malloc(sizeof (PHYSFSEXT_CaseIndex));
+    if (index == NULL)
+        return NULL;
+
+    index->generation = PHYSFS_getSearchPathGeneration();
+    index->dirBuckets = 64;
+    index->dirCount = 0;
+    index->dirs = (CaseDir **) calloc(index->dirBuckets, sizeof (CaseDir *));
+    if (index->dirs == NULL)
+    {
+        free(index);
+        return NULL;
+    } /* if */
+
+    return index;
+} /* PHYSFSEXT_createCaseIndex */
+
+
+void PHYSFSEXT_destroyCaseIndex(PHYSFSEXT_CaseIndex *index)
+{
+    if (index != NULL)
+    {
+        clearCaseIndex(index);
+        free(index->dirs);
+        free(index);
+    } /* if */
+} /* PHYSFSEXT_destroyCaseIndex */
+
+
+/* (list) is sorted, so the first of names that only differ by case wins. */
+static CaseDir *buildCaseDir(const char *path, PHYSFS_uint32 hash)
+{
+    char **list = PHYSFS_enumerateFiles(*path ? path : "/");
+    CaseDir *dir = NULL;
+    size_t count = 0;
+    char **i;
+
+    if (list == NULL)
+        return NULL;
+
+    for (i = list; *i != NULL; i++)
+        count++;
+
+    dir = (CaseDir *) calloc(1, sizeof (CaseDir));
+    if (dir == NULL)
+        goto buildCaseDir_failed;
+
+    dir->hash = hash;
+    dir->nameBuckets = 1;
+    while (dir->nameBuckets < count)
+        dir->nameBuckets <<= 1;
+
+    dir->path = (char *) malloc(strlen(path) + 1);
+    dir->names = (CaseName **) calloc(dir->nameBuckets, sizeof (CaseName *));
+    if ((dir->path == NULL) || (dir->names == NULL))
+        goto buildCaseDir_failed;
+    strcpy(dir->path, path);
+
+    for (i = list; *i != NULL; i++)
+    {
+        const size_t len = strlen(*i);
+        CaseName **tail;
+        CaseName *name = (CaseName *) malloc(sizeof (CaseName) + len + 1);
+        if (name == NULL)
+            goto buildCaseDir_failed;
+
+        name->folded = foldName(*i);
+        if (name->folded == NULL)
+        {
+            free(name);
+            goto buildCaseDir_failed;
+        } /* if */
+
+        name->name = (char *) (name + 1);
+        strcpy(name->name, *i);
+        name->len = len;
+        name->hash = hashString(name->folded);
+        name->next = NULL;
+
+        tail = &dir->names[name->hash & (dir->nameBuckets - 1)];
+        while (*tail != NULL)
+            tail = &(*tail)->next;
+        *tail = name;
+    } /* for */
+
+    PHYSFS_freeList(list);
+    return dir;
+
+buildCaseDir_failed:
+    if (dir != NULL)
+        freeCaseDir(dir);
+    PHYSFS_freeList(list);
+    return NULL;
+} /* buildCaseDir */
+
+
+/* Find (path), which must be in its real case, listing it if need be. */
+static CaseDir *findCaseDir(PHYSFSEXT_CaseIndex *index, const char *path)
+{
+    const PHYSFS_uint32 hash = hashString(path);
+    CaseDir *dir = index->dirs[hash & (index->dirBuckets - 1)];
+
+    for (; dir != NULL; dir = dir->next)
+    {
+        if ((dir->hash == hash) && (strcmp(dir->path, path) == 0))
+            return dir;
+    } /* for */
+
+    /* keep the chains short as we go. */
+    if (index->dirCount >= index->dirBuckets)
+    {
+        const size_t newbuckets = index->dirBuckets * 2;
+        CaseDir **newdirs = (CaseDir **) calloc(newbuckets, sizeof (*newdirs));
+        if (newdirs != NULL)
+        {
+            size_t i;
+            for (i = 0; i < index->dirBuckets; i++)
+            {
+                while (index->dirs[i] != NULL)
+                {
+                    CaseDir *moving = index->dirs[i];
+                    CaseDir **bucket = &newdirs[moving->hash & (newbuckets-1)];
+                    index->dirs[i] = moving->next;
+                    moving->next = *bucket;
+                    *bucket = moving;
+                } /* while */
+            } /* for */
+            free(index->dirs);
+            index->dirs = newdirs;
+            index->dirBuckets = newbuckets;
+        } /* if */
+    } /* if */
+
+    dir = buildCaseDir(path, hash);
+    if (dir != NULL)
+    {
+        CaseDir **bucket = &index->dirs[hash & (index->dirBuckets - 1)];
+        dir->next = *bucket;
+        *bucket = dir;
+        index->dirCount++;
+    } /* if */
+
+    return dir;
+} /* findCaseDir */
+
+
+/* Find the real name of (element) in (dir), favoring an exact match. */
+static const char *findCaseName(const CaseDir *dir, const char *element)
+{
+    const size_t len = strlen(element);
+    const char *retval = NULL;
+    const CaseName *name;
+    PHYSFS_uint32 hash;
+    char *folded;
+
+    folded = foldName(element);
+    if (folded == NULL)
+        return NULL;
+
+    hash = hashString(folded);
+    name = dir->names[hash & (dir->nameBuckets - 1)];
+    for (; name != NULL; name = name->next)
+    {
+        if ((name->hash != hash) || (name->len != len))
+            continue;
+        else if (strcmp(name->folded, folded) != 0)
+            continue;
+        else if (strcmp(name->name, element) == 0)
+        {
+            retval = name->name;
+            break;  /* can't beat this. */
+        } /* else if */
+        else if (retval == NULL)
+        {
+            retval = name->name;
+        } /* else if */
+    } /* for */
+
+    free(folded);
+    return retval;
+} /* findCaseName */
+
+
+int PHYSFSEXT_locateCorrectCaseIndexed(PHYSFSEXT_CaseIndex *index, char *buf)
+{
+    const PHYSFS_uint32 generation = PHYSFS_getSearchPathGeneration();
+    char *element;
+    char *end;
+
+    if (index->generation != generation)
+    {
+        clearCaseIndex(index);
+        index->generation = generation;
+    } /* if */
+
+    while (*buf == '/')  /* skip any '/' at start of string... */
+        buf++;
+
+    for (element = buf; *element != '\0'; element = end + 1)
+    {
+        const int last = (strchr(element, '/') == NULL);
+        const CaseDir *dir;
+        const char *name;
+
+        /* (buf) up to (element) is already the real case of its parent. */
+        if (element == buf)
+            dir = findCaseDir(index, "");
+        else
+        {
+            element[-1] = '\0';
+            dir = findCaseDir(index, buf);
+            element[-1] = '/';
+        } /* else */
+
+        end = element + strcspn(element, "/");
+        if (dir == NULL)
+            name = NULL;
+        else
+        {
+            const char ch = *end;
+            *end = '\0';
+            name = findCaseName(dir, element);
+            *end = ch;
+        } /* else */
+
+        if (name == NULL)
+            return last ? -1 : -2;
+
+        memcpy(element, name, (size_t) (end - element));
+        if (last)
+            break;
+    } /* for */
+
+    return 0;
+} /* PHYSFSEXT_locateCorrectCaseIndexed */
+
+
 #ifdef TEST_PHYSFSEXT_LOCATECORRECTCASE
 int main(int argc, char **argv)
 {
     int rc;
     char buf[128];
     PHYSFS_File *f;
+    PHYSFSEXT_CaseIndex *index;
 
     if (!PHYSFS_init(argv[0]))
     {
@@ -200,10 +587,42 @@ int main(int argc, char **argv)
     if ((rc != -2) || (strcmp(buf, "/a/b/Z/z.txt") != 0))
         printf("test 6 failed\n");
 
+    index = PHYSFSEXT_createCaseIndex();
+    if (index == NULL)
+        printf("test 7 failed\n");
+    else
+    {
+        strcpy(buf, "/a/B/c/x.txt");
+        rc = PHYSFSEXT_locateCorrectCaseIndexed(index, buf);
+        if ((rc != 0) || (strcmp(buf, "/a/b/c/x.txt") != 0))
+            printf("test 8 failed\n");
+
+        strcpy(buf, "/a/b/C/x.txt");
+        rc = PHYSFSEXT_locateCorrectCaseIndexed(index, buf);
+        if ((rc != 0) || (strcmp(buf, "/a/b/C/X.txt") != 0))
+            printf("test 9 failed\n");
+
+        strcpy(buf, "/A/B/Z/z.txt");
+        rc = PHYSFSEXT_locateCorrectCaseIndexed(index, buf);
+        if ((rc != -2) || (strcmp(buf, "/a/b/Z/z.txt") != 0))
+            printf("test 10 failed\n");
+
+        /* writing makes the index list things again. */
+        f = PHYSFS_openWrite("/a/b/c/Y.txt");
+        PHYSFS_close(f);
+        strcpy(buf, "/A/B/c/y.TXT");
+        rc = PHYSFSEXT_locateCorrectCaseIndexed(index, buf);
+        if ((rc != 0) || (strcmp(buf, "/a/b/c/Y.txt") != 0))
+            printf("test 11 failed\n");
+
+        PHYSFSEXT_destroyCaseIndex(index);
+    } /* else */
+
     printf("Testing completed.\n");
     printf("  If no errors were reported, you're good to go.\n");
 
     PHYSFS_delete("/a/b/c/x.txt");
+    PHYSFS_delete("/a/b/c/Y.txt");
     PHYSFS_delete("/a/b/C/X.txt");
     PHYSFS_delete("/a/b/c");
     PHYSFS_delete("/a/b/C");
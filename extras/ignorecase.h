@@ -29,7 +29,10 @@
  *
  * Usage: Set up PhysicsFS as you normally would, then use
  *  PHYSFSEXT_locateCorrectCase() to get a "correct" pathname to pass to
- *  functions like PHYSFS_openRead(), etc.
+ *  functions like PHYSFS_openRead(), etc. If you do this for every file you
+ *  open, make a PHYSFSEXT_CaseIndex and use
+ *  PHYSFSEXT_locateCorrectCaseIndexed() instead, which remembers what it
+ *  finds.
  *
  * License: this code is public domain. I make no warranty that it is useful,
  *  correct, harmless, or environmentally safe.
@@ -65,7 +68,12 @@ extern "C" {
  *
  * Each element of the buffer is overwritten with the actual case of an
  *  existing match. If there is no match, the search aborts and reports an
- *  error. Exact matches are favored over case-insensitive matches.
+ *  error. Exact matches are favored over case-insensitive matches. Case is
+ *  folded as PHYSFS_caseFold() does, but a match has to be the same length
+ *  in bytes as what it replaces.
+ *
+ * This lists every directory along the path, every time. See
+ *  PHYSFSEXT_locateCorrectCaseIndexed() if you'll be doing this a lot.
  *
  * THIS IS RISKY. Please do not use this function for anything but legacy code.
  *
@@ -76,6 +84,60 @@ extern "C" {
  */
 int PHYSFSEXT_locateCorrectCase(char *buf);
 
+
+/**
+ * \brief What PHYSFSEXT_locateCorrectCaseIndexed() remembers.
+ *
+ * \sa PHYSFSEXT_createCaseIndex
+ */
+typedef struct PHYSFSEXT_CaseIndex PHYSFSEXT_CaseIndex;
+
+/**
+ * \fn PHYSFSEXT_CaseIndex *PHYSFSEXT_createCaseIndex(void)
+ * \brief Make an empty index for PHYSFSEXT_locateCorrectCaseIndexed().
+ *
+ * An index isn't thread safe; use one per thread, or serialize access to it
+ *  yourself. It doesn't use PhysicsFS's allocator, so it can outlive
+ *  PHYSFS_deinit(), but don't use it again until PhysicsFS is initialized.
+ *
+ *  \return a new index, or NULL if we ran out of memory.
+ *
+ * \sa PHYSFSEXT_destroyCaseIndex
+ */
+PHYSFSEXT_CaseIndex *PHYSFSEXT_createCaseIndex(void);
+
+/**
+ * \fn void PHYSFSEXT_destroyCaseIndex(PHYSFSEXT_CaseIndex *index)
+ * \brief Free an index and everything it remembers.
+ *
+ *   \param index The index to free. It is safe to pass a NULL here.
+ */
+void PHYSFSEXT_destroyCaseIndex(PHYSFSEXT_CaseIndex *index);
+
+/**
+ * \fn int PHYSFSEXT_locateCorrectCaseIndexed(PHYSFSEXT_CaseIndex *index, char *buf)
+ * \brief PHYSFSEXT_locateCorrectCase(), remembering what it lists.
+ *
+ * This finds the same thing PHYSFSEXT_locateCorrectCase() would, but each
+ *  directory is only listed the first time a path goes through it. After
+ *  that, its names are kept in (index), by their folded case, so finding a
+ *  path takes a few hash lookups instead of reading and comparing whole
+ *  directories. Everything is forgotten, and listed again as needed, once
+ *  PHYSFS_getSearchPathGeneration() changes: after any mount, unmount or
+ *  write, for example. Directories that don't exist are remembered, too.
+ *
+ * If something other than PhysicsFS changes mounted native directories,
+ *  call PHYSFS_invalidateCache() or let PHYSFS_setChangeCallback() do it,
+ *  or this might not see the change.
+ *
+ *   \param index Index from PHYSFSEXT_createCaseIndex().
+ *   \param buf Buffer with null-terminated string of path/file to locate.
+ *               This buffer will be modified by this function.
+ *  \return zero if match was found, -1 if the final element (the file itself)
+ *               is missing, -2 if one of the parent directories is missing.
+ */
+int PHYSFSEXT_locateCorrectCaseIndexed(PHYSFSEXT_CaseIndex *index, char *buf);
+
 #ifdef __cplusplus
 }
 #endif
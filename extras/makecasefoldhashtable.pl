@@ -20,11 +20,16 @@ print <<__EOF__;
 __EOF__
 
 
-my @foldPairs;
+# Every fold is looked up in constant time through a two-level table: the
+#  codepoint's high bits pick a block of (1 << $blockshift) entries, and its
+#  low bits pick an entry in that block, which is an index into the mapping
+#  list (zero means "no mapping"). Blocks without any mappings all share the
+#  same all-zero block, so the table stays small.
 
-for (my $i = 0; $i < 256; $i++) {
-    $foldPairs[$i] = '';
-}
+my $blockshift = 6;
+my $blocksize = 1 << $blockshift;
+
+my %foldMaps;
 
 open(FH,'<','casefolding.txt') or die("failed to open casefolding.txt: $!\n");
 while (<FH>) {
@@ -38,10 +43,7 @@ while (<FH>) {
 
     next if not /\A([a-fA-F0-9]+)\;\s*(.)\;\s*(.+)\;/;
     my ($code, $status, $mapping) = ($1, $2, $3);
-    my $hexxed = hex($code);
-    my $hashed = (($hexxed ^ ($hexxed >> 8)) & 0xFF);
     #print("// code '$code'   status '$status'   mapping '$mapping'\n");
-    #print("// hexxed '$hexxed'  hashed '$hashed'\n");
 
     if (($status eq 'C') or ($status eq 'F')) {
         my ($map1, $map2, $map3) = ('0000', '0000', '0000');
@@ -49,32 +51,67 @@ while (<FH>) {
         $map2 = $1 if $mapping =~ s/\A([a-fA-F0-9]+)(\s*|\Z)//;
         $map3 = $1 if $mapping =~ s/\A([a-fA-F0-9]+)(\s*|\Z)//;
         die("mapping space too small for '$code'\n") if ($mapping ne '');
-        $foldPairs[$hashed] .= "    { 0x$code, 0x$map1, 0x$map2, 0x$map3 },\n";
+        $foldMaps{hex($code)} = "    { 0x$map1, 0x$map2, 0x$map3 }, /* 0x$code */\n";
     }
 }
 close(FH);
 
-for (my $i = 0; $i < 256; $i++) {
-    $foldPairs[$i] =~ s/,\n\Z//;
-    my $str = $foldPairs[$i];
-    next if $str eq '';
-    my $num = '000' . $i;
-    $num =~ s/\A.*?(\d\d\d)\Z/$1/;
-    my $sym = "case_fold_${num}";
-    print("static const CaseFoldMapping ${sym}[] = {\n$str\n};\n\n");
+my @codes = sort { $a <=> $b } keys(%foldMaps);
+die("no mappings in casefolding.txt\n") if (not @codes);
+die("too many mappings for 16-bit indices\n") if (scalar(@codes) >= 0xFFFF);
+
+my $numblocks = ($codes[-1] >> $blockshift) + 1;
+my $limit = $numblocks << $blockshift;
+
+my @entries;
+my $mappings = '';
+my $index = 0;
+foreach my $code (@codes) {
+    $entries[$code] = ++$index;
+    $mappings .= $foldMaps{$code};
+}
+$mappings =~ s/,( \/\*.*?\*\/)\n\Z/ $1\n/;
+
+my @blocks = ( '' );  # block 0 is the shared empty block.
+my %blockids = ( join(',', (0) x $blocksize) => 0 );
+my @blockmap;
+for (my $i = 0; $i < $numblocks; $i++) {
+    my @block;
+    for (my $j = 0; $j < $blocksize; $j++) {
+        push @block, $entries[($i << $blockshift) | $j] || 0;
+    }
+    my $key = join(',', @block);
+    if (not defined $blockids{$key}) {
+        $blockids{$key} = scalar(@blocks);
+        push @blocks, $key;
+    }
+    push @blockmap, $blockids{$key};
 }
 
-print("\nstatic const CaseFoldHashBucket case_fold_hash[256] = {\n");
-
-for (my $i = 0; $i < 256; $i++) {
-    my $str = $foldPairs[$i];
-    if ($str eq '') {
-        print("    { 0, NULL },\n");
-    } else {
-        my $num = '000' . $i;
-        $num =~ s/\A.*?(\d\d\d)\Z/$1/;
-        my $sym = "case_fold_${num}";
-        print("    { __PHYSFS_ARRAYLEN($sym), $sym },\n");
+my $blocktype = (scalar(@blocks) <= 256) ? 'PHYSFS_uint8' : 'PHYSFS_uint16';
+
+print("#define CASE_FOLD_BLOCK_SHIFT $blockshift\n");
+print("#define CASE_FOLD_LIMIT $limit\n\n");
+
+print("static const CaseFoldMapping case_fold_mappings[] = {\n$mappings};\n\n");
+
+print("static const $blocktype case_fold_blockmap[$numblocks] = {\n");
+for (my $i = 0; $i < $numblocks; $i += 16) {
+    my $end = ($i + 16 < $numblocks) ? $i + 16 : $numblocks;
+    my $line = join(', ', @blockmap[$i .. $end - 1]);
+    $line .= ',' if ($end < $numblocks);
+    print("    $line\n");
+}
+print("};\n\n");
+
+my $numentries = scalar(@blocks) << $blockshift;
+print("static const PHYSFS_uint16 case_fold_entries[$numentries] = {\n");
+for (my $i = 0; $i < scalar(@blocks); $i++) {
+    my @block = ($i == 0) ? ((0) x $blocksize) : split(/,/, $blocks[$i]);
+    for (my $j = 0; $j < $blocksize; $j += 16) {
+        my $line = join(', ', @block[$j .. $j + 15]);
+        $line .= ',' if (($i < scalar(@blocks) - 1) or ($j + 16 < $blocksize));
+        print("    $line\n");
     }
 }
 print("};\n\n");
@@ -68,6 +68,40 @@
 %rename(readULE64) PHYSFS_readULE64;
 %rename(readSBE64) PHYSFS_readSBE64;
 %rename(readUBE64) PHYSFS_readUBE64;
+%rename(readULE16Array) PHYSFS_readULE16Array;
+%rename(readUBE16Array) PHYSFS_readUBE16Array;
+%rename(readULE32Array) PHYSFS_readULE32Array;
+%rename(readUBE32Array) PHYSFS_readUBE32Array;
+%rename(readULE64Array) PHYSFS_readULE64Array;
+%rename(readUBE64Array) PHYSFS_readUBE64Array;
+%rename(readUntil) PHYSFS_readUntil;
+%rename(readLine) PHYSFS_readLine;
+%rename(crc32) PHYSFS_crc32;
+%rename(getChecksum) PHYSFS_getChecksum;
+%rename(setVerifyChecksums) PHYSFS_setVerifyChecksums;
+%rename(setSpillCacheDir) PHYSFS_setSpillCacheDir;
+%rename(setReadCoalescing) PHYSFS_setReadCoalescing;
+%rename(freeze) PHYSFS_freeze;
+%rename(isFrozen) PHYSFS_isFrozen;
+%rename(createContext) PHYSFS_createContext;
+%rename(destroyContext) PHYSFS_destroyContext;
+%rename(setCurrentContext) PHYSFS_setCurrentContext;
+%rename(getCurrentContext) PHYSFS_getCurrentContext;
+%rename(replaceMount) PHYSFS_replaceMount;
+%rename(setMountRoutes) PHYSFS_setMountRoutes;
+%rename(openDirectory) PHYSFS_openDirectory;
+%rename(readDirectory) PHYSFS_readDirectory;
+%rename(closeDirectory) PHYSFS_closeDirectory;
+%rename(statMany) PHYSFS_statMany;
+%rename(existsMany) PHYSFS_existsMany;
+%rename(setOpenFileCacheTime) PHYSFS_setOpenFileCacheTime;
+%rename(setMountStatCacheTime) PHYSFS_setMountStatCacheTime;
+%rename(copyFile) PHYSFS_copyFile;
+%rename(compactArchive) PHYSFS_compactArchive;
+%rename(startTraceCapture) PHYSFS_startTraceCapture;
+%rename(stopTraceCapture) PHYSFS_stopTraceCapture;
+%rename(startCdRomDetection) PHYSFS_startCdRomDetection;
+%rename(isCdRomDetectionDone) PHYSFS_isCdRomDetectionDone;
 %rename(writeSLE16) PHYSFS_writeSLE16;
 %rename(writeULE16) PHYSFS_writeULE16;
 %rename(writeSBE16) PHYSFS_writeSBE16;
@@ -86,13 +120,110 @@
 %rename(getMountPoint) PHYSFS_getMountPoint;
 %rename(Stat) PHYSFS_Stat;   /* !!! FIXME: case insensitive script languages? */
 %rename(stat) PHYSFS_stat;
+%rename(EntryLayout) PHYSFS_EntryLayout;
+%rename(statLayout) PHYSFS_statLayout;
 %rename(readBytes) PHYSFS_readBytes;
 %rename(writeBytes) PHYSFS_writeBytes;
 %rename(unmount) PHYSFS_unmount;
 %rename(mountMemory) PHYSFS_mountMemory;
 %rename(mountHandle) PHYSFS_mountHandle;
+%rename(mountRange) PHYSFS_mountRange;
+%rename(Path) PHYSFS_Path;
+%rename(internPath) PHYSFS_internPath;
+%rename(freePath) PHYSFS_freePath;
+%rename(openReadInterned) PHYSFS_openReadInterned;
+%rename(statInterned) PHYSFS_statInterned;
+%rename(Entry) PHYSFS_Entry;
+%rename(Directory) PHYSFS_Directory;
+%rename(lookup) PHYSFS_lookup;
+%rename(freeEntry) PHYSFS_freeEntry;
+%rename(openEntry) PHYSFS_openEntry;
+%rename(statEntry) PHYSFS_statEntry;
 %rename(getPrefDir) PHYSFS_getPrefDir;
 #endif
 
 %include "../src/physfs.h"
 
+#ifdef SWIGPYTHON
+/*
+ * PHYSFS_readBytes() and friends take a raw pointer, which isn't much use
+ *  from a script, so Python gets these too. They read straight into any
+ *  object with a writable buffer (bytearray, memoryview, array, numpy...),
+ *  as many bytes as it holds, instead of making a new bytes object for
+ *  every read, and let other threads run while they wait on the disk.
+ *  They return the number of bytes read, like io.RawIOBase.readinto().
+ *
+ * PHYSFS_mapReadView() gives the file's contents as a read-only memoryview
+ *  with no copy at all, or None if PHYSFS_mapRead() can't do this file
+ *  (read it normally then). The view is only good until the handle is
+ *  closed, so don't keep it (or slices of it) around past that.
+ */
+%{
+static PyObject *physfsReadResult(const PHYSFS_sint64 rc)
+{
+    if (rc >= 0)
+        return PyLong_FromLongLong((long long) rc);
+    PyErr_SetString(PyExc_IOError,
+                    PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    return NULL;
+} /* physfsReadResult */
+
+static PyObject *physfsReadInto(PHYSFS_File *handle, PyObject *buffer,
+                                const PHYSFS_sint64 offset)
+{
+    Py_buffer view;
+    PHYSFS_sint64 rc;
+
+    if (PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE) != 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    if (offset < 0)
+        rc = PHYSFS_readBytes(handle, view.buf, (PHYSFS_uint64) view.len);
+    else
+    {
+        rc = PHYSFS_readAt(handle, view.buf, (PHYSFS_uint64) view.len,
+                           (PHYSFS_uint64) offset);
+    } /* else */
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+    return physfsReadResult(rc);
+} /* physfsReadInto */
+%}
+
+%inline %{
+PyObject *PHYSFS_readInto(PHYSFS_File *handle, PyObject *buffer)
+{
+    return physfsReadInto(handle, buffer, -1);
+} /* PHYSFS_readInto */
+
+PyObject *PHYSFS_readAtInto(PHYSFS_File *handle, PyObject *buffer,
+                            PHYSFS_sint64 offset)
+{
+    if (offset < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "negative offset");
+        return NULL;
+    } /* if */
+    return physfsReadInto(handle, buffer, offset);
+} /* PHYSFS_readAtInto */
+
+PyObject *PHYSFS_mapReadView(PHYSFS_File *handle)
+{
+    const void *ptr = NULL;
+    PHYSFS_uint64 len = 0;
+
+    if ((!PHYSFS_mapRead(handle, &ptr, &len)) ||
+        (len > (PHYSFS_uint64) PY_SSIZE_T_MAX))
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    } /* if */
+
+    return PyMemoryView_FromMemory((char *) ptr, (Py_ssize_t) len,
+                                   PyBUF_READ);
+} /* PHYSFS_mapReadView */
+%}
+#endif
+
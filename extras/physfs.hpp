@@ -0,0 +1,1070 @@
+/*
+ * This code provides a C++17 layer over PhysicsFS's C API: handles that
+ *  close themselves, mounts that unmount themselves, reads into spans,
+ *  whole-file reads into a std::pmr::memory_resource, directory listings
+ *  you can use in a range-based for loop, and fixed-layout binary records
+ *  described at compile time.
+ *
+ * It's header-only, and adds nothing to physfs.h's ABI; just include it.
+ *  Nothing here allocates except where it says so: reads go straight into
+ *  your memory, and listings hand back the library's own name strings.
+ *  Failures throw PhysFS::Error, with the PHYSFS_ErrorCode that caused
+ *  them. Destructors never throw; call close() yourself to hear about a
+ *  failed close.
+ *
+ * std::span overloads and the co_await-able async reads need C++20; the
+ *  rest works in C++17.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#ifndef _INCLUDE_PHYSFS_HPP_
+#define _INCLUDE_PHYSFS_HPP_
+
+#include "physfs.h"
+
+#if defined(_MSVC_LANG)
+#define PHYSFS_HPP_CPLUSPLUS _MSVC_LANG
+#else
+#define PHYSFS_HPP_CPLUSPLUS __cplusplus
+#endif
+
+#if PHYSFS_HPP_CPLUSPLUS < 201703L
+#error physfs.hpp needs C++17 or later.
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if (PHYSFS_HPP_CPLUSPLUS >= 202002L) && __has_include(<span>)
+#include <span>
+#define PHYSFS_HPP_HAVE_SPAN 1
+#endif
+
+#if PHYSFS_HPP_HAVE_SPAN && __has_include(<coroutine>)
+#include <atomic>
+#include <coroutine>
+#define PHYSFS_HPP_HAVE_COROUTINES 1
+#endif
+
+namespace PhysFS
+{
+
+/**
+ * What everything here throws when PhysicsFS says no. what() is
+ *  PHYSFS_getErrorByCode()'s string for code().
+ */
+class Error : public std::runtime_error
+{
+public:
+    explicit Error(PHYSFS_ErrorCode code)
+        : std::runtime_error(message(code)), code_(code) {}
+
+    PHYSFS_ErrorCode code() const noexcept { return code_; }
+
+private:
+    static const char *message(PHYSFS_ErrorCode code)
+    {
+        const char *str = PHYSFS_getErrorByCode(code);
+        return str ? str : "unknown error";
+    } // message
+
+    PHYSFS_ErrorCode code_;
+}; // Error
+
+
+/** Throw whatever PHYSFS_getLastErrorCode() says went wrong. */
+[[noreturn]] inline void throwLastError()
+{
+    PHYSFS_ErrorCode code = PHYSFS_getLastErrorCode();
+    if (code == PHYSFS_ERR_OK)
+        code = PHYSFS_ERR_OTHER_ERROR;  /* something failed; say so anyhow. */
+    throw Error(code);
+} // throwLastError
+
+
+/**
+ * A PHYSFS_File that closes itself. It can be moved but not copied, so
+ *  there's always exactly one owner. A default-constructed or moved-from
+ *  File is empty, and tests false.
+ */
+class File
+{
+public:
+    File() noexcept : handle_(nullptr) {}
+
+    /** Take ownership of (handle), which may be NULL. */
+    explicit File(PHYSFS_File *handle) noexcept : handle_(handle) {}
+
+    File(File &&other) noexcept : handle_(other.release()) {}
+
+    File &operator=(File &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            handle_ = other.release();
+        } // if
+        return *this;
+    } // operator=
+
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+
+    ~File() { reset(); }
+
+    static File openRead(const char *filename)
+    {
+        return File(check(PHYSFS_openRead(filename)));
+    } // openRead
+
+    static File openWrite(const char *filename)
+    {
+        return File(check(PHYSFS_openWrite(filename)));
+    } // openWrite
+
+    static File openAppend(const char *filename)
+    {
+        return File(check(PHYSFS_openAppend(filename)));
+    } // openAppend
+
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+    PHYSFS_File *get() const noexcept { return handle_; }
+
+    /** Give up ownership, leaving this empty. */
+    PHYSFS_File *release() noexcept
+    {
+        PHYSFS_File *retval = handle_;
+        handle_ = nullptr;
+        return retval;
+    } // release
+
+    /** Close now, throwing if PHYSFS_close() fails. Empty afterwards. */
+    void close()
+    {
+        if (handle_ != nullptr)
+        {
+            if (!PHYSFS_close(handle_))
+                throwLastError();  /* still ours; the destructor retries. */
+            handle_ = nullptr;
+        } // if
+    } // close
+
+    /**
+     * Read up to (len) bytes into (buf); returns how many arrived, which
+     *  is less than (len) only at the end of the file.
+     */
+    std::size_t read(void *buf, std::size_t len)
+    {
+        const PHYSFS_sint64 rc = PHYSFS_readBytes(handle_, buf,
+                                                  (PHYSFS_uint64) len);
+        if (rc < 0)
+            throwLastError();
+        return (std::size_t) rc;
+    } // read
+
+    /** Like read(), but from (offset), leaving the file position alone. */
+    std::size_t readAt(void *buf, std::size_t len, PHYSFS_uint64 offset)
+    {
+        const PHYSFS_sint64 rc = PHYSFS_readAt(handle_, buf,
+                                               (PHYSFS_uint64) len, offset);
+        if (rc < 0)
+            throwLastError();
+        return (std::size_t) rc;
+    } // readAt
+
+    /** Write all (len) bytes of (buf), or throw. */
+    void write(const void *buf, std::size_t len)
+    {
+        if (PHYSFS_writeBytes(handle_, buf, (PHYSFS_uint64) len) !=
+            (PHYSFS_sint64) len)
+            throwLastError();
+    } // write
+
+#if PHYSFS_HPP_HAVE_SPAN
+    std::size_t read(std::span<std::byte> buf)
+    {
+        return read(buf.data(), buf.size());
+    } // read
+
+    std::size_t readAt(std::span<std::byte> buf, PHYSFS_uint64 offset)
+    {
+        return readAt(buf.data(), buf.size(), offset);
+    } // readAt
+
+    void write(std::span<const std::byte> buf)
+    {
+        write(buf.data(), buf.size());
+    } // write
+#endif
+
+    void seek(PHYSFS_uint64 pos)
+    {
+        if (!PHYSFS_seek(handle_, pos))
+            throwLastError();
+    } // seek
+
+    PHYSFS_uint64 tell() const
+    {
+        const PHYSFS_sint64 rc = PHYSFS_tell(handle_);
+        if (rc < 0)
+            throwLastError();
+        return (PHYSFS_uint64) rc;
+    } // tell
+
+    /** The file's length, or -1 if it can't be known (a stream, say). */
+    PHYSFS_sint64 length() const noexcept { return PHYSFS_fileLength(handle_); }
+
+    bool eof() const noexcept { return PHYSFS_eof(handle_) != 0; }
+
+private:
+    static PHYSFS_File *check(PHYSFS_File *handle)
+    {
+        if (handle == nullptr)
+            throwLastError();
+        return handle;
+    } // check
+
+    void reset() noexcept
+    {
+        if (handle_ != nullptr)
+            PHYSFS_close(handle_);
+        handle_ = nullptr;
+    } // reset
+
+    PHYSFS_File *handle_;
+}; // File
+
+
+/**
+ * Bytes from readAll(), owned by the memory_resource they came from. Move
+ *  only. A null byte follows the last one, so text can be used as a C
+ *  string; it isn't counted in size().
+ */
+class Buffer
+{
+public:
+    Buffer() noexcept
+        : data_(nullptr), size_(0), capacity_(0), resource_(nullptr) {}
+
+    Buffer(Buffer &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          resource_(other.resource_) {}
+
+    Buffer &operator=(Buffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+            resource_ = other.resource_;
+        } // if
+        return *this;
+    } // operator=
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    ~Buffer() { reset(); }
+
+    std::byte *data() noexcept { return data_; }
+    const std::byte *data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+    std::string_view view() const noexcept
+    {
+        return std::string_view((const char *) data_, size_);
+    } // view
+
+#if PHYSFS_HPP_HAVE_SPAN
+    std::span<std::byte> span() noexcept { return { data_, size_ }; }
+    std::span<const std::byte> span() const noexcept
+    {
+        return { data_, size_ };
+    } // span
+#endif
+
+private:
+    friend Buffer readAll(const char *, std::pmr::memory_resource *);
+#if PHYSFS_HPP_HAVE_COROUTINES
+    template <typename Executor> friend class ReadFileAwaitable;
+#endif
+
+    /* room for (len) bytes and the null, none of them used yet. */
+    Buffer(std::size_t len, std::pmr::memory_resource *resource)
+        : data_((std::byte *) resource->allocate(len + 1)),
+          size_(0), capacity_(len + 1), resource_(resource) {}
+
+    /* for files that run longer than they said (or don't say). */
+    void grow(std::size_t len)
+    {
+        Buffer bigger(len, resource_);
+        std::memcpy(bigger.data_, data_, size_);
+        bigger.size_ = size_;
+        *this = std::move(bigger);
+    } // grow
+
+    void reset() noexcept
+    {
+        if (data_ != nullptr)
+            resource_->deallocate(data_, capacity_);
+        data_ = nullptr;
+        size_ = capacity_ = 0;
+    } // reset
+
+    std::byte *data_;
+    std::size_t size_;
+    std::size_t capacity_;  /* what was allocated, null byte and all. */
+    std::pmr::memory_resource *resource_;
+}; // Buffer
+
+
+/**
+ * Read all of (filename) into memory from (resource), in one allocation.
+ *
+ * Files PhysicsFS already has in memory (see PHYSFS_mapRead()) are copied
+ *  once, straight out of that memory. Others are read with one
+ *  PHYSFS_readBytes() of the whole length, which skips the handle's
+ *  buffer, so compressed ZIP entries inflate straight into yours. Only
+ *  files whose length can't be known take more than one read.
+ */
+inline Buffer readAll(const char *filename,
+                      std::pmr::memory_resource *resource =
+                          std::pmr::get_default_resource())
+{
+    File file = File::openRead(filename);
+    const void *ptr = nullptr;
+    PHYSFS_uint64 maplen = 0;
+
+    if (PHYSFS_mapRead(file.get(), &ptr, &maplen))
+    {
+        Buffer retval((std::size_t) maplen, resource);
+        std::memcpy(retval.data_, ptr, (std::size_t) maplen);
+        retval.size_ = (std::size_t) maplen;
+        retval.data_[retval.size_] = std::byte(0);
+        return retval;
+    } // if
+
+    const PHYSFS_sint64 len = file.length();
+    Buffer retval((len >= 0) ? (std::size_t) len : 4096, resource);
+    while (true)
+    {
+        const std::size_t avail = retval.capacity_ - 1 - retval.size_;
+        const std::size_t br = file.read(retval.data_ + retval.size_, avail);
+        retval.size_ += br;
+        if ((br < avail) || (file.eof()))
+            break;  /* usually the first time, with the whole file. */
+        retval.grow((retval.capacity_ - 1) * 2 + 4096);
+    } // while
+
+    retval.data_[retval.size_] = std::byte(0);
+    return retval;
+} // readAll
+
+
+/**
+ * A search path entry that's removed when this goes away. Move only. A
+ *  default-constructed or moved-from Mount is empty and does nothing.
+ *
+ * This keeps a copy of the path, which PHYSFS_unmount() needs; that's
+ *  the only allocation, and it's at mount time.
+ */
+class Mount
+{
+public:
+    Mount() noexcept {}
+
+    /** PHYSFS_mount(), throwing on failure. */
+    explicit Mount(const char *dir, const char *mountPoint = nullptr,
+                   bool appendToPath = true)
+    {
+        if (!PHYSFS_mount(dir, mountPoint, appendToPath ? 1 : 0))
+            throwLastError();
+        dir_ = dir;
+    } // Mount
+
+    Mount(Mount &&other) noexcept : dir_(std::move(other.dir_))
+    {
+        other.dir_.clear();
+    } // Mount
+
+    Mount &operator=(Mount &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            dir_ = std::move(other.dir_);
+            other.dir_.clear();
+        } // if
+        return *this;
+    } // operator=
+
+    Mount(const Mount &) = delete;
+    Mount &operator=(const Mount &) = delete;
+
+    ~Mount() { reset(); }
+
+    explicit operator bool() const noexcept { return !dir_.empty(); }
+    const std::string &dir() const noexcept { return dir_; }
+
+    /** Unmount now, throwing if PHYSFS_unmount() fails. */
+    void unmount()
+    {
+        if (!dir_.empty())
+        {
+            if (!PHYSFS_unmount(dir_.c_str()))
+                throwLastError();
+            dir_.clear();
+        } // if
+    } // unmount
+
+private:
+    void reset() noexcept
+    {
+        if (!dir_.empty())
+            PHYSFS_unmount(dir_.c_str());
+        dir_.clear();
+    } // reset
+
+    std::string dir_;
+}; // Mount
+
+
+/**
+ * A directory listing, read lazily with PHYSFS_openDirectory() and
+ *  PHYSFS_readDirectory() as you iterate:
+ *
+ * \code
+ * for (const PhysFS::Directory::Entry &entry : PhysFS::Directory("maps"))
+ *     load(entry.name, entry.stat.filesize);
+ * \endcode
+ *
+ * Each entry's name points at the library's copy, which is only good until
+ *  the iterator moves on. It's a single-pass range; begin() once.
+ */
+class Directory
+{
+public:
+    struct Entry
+    {
+        std::string_view name;
+        PHYSFS_Stat stat;
+    }; // Entry
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry *;
+        using reference = const Entry &;
+
+        iterator() noexcept : dir_(nullptr) {}
+
+        reference operator*() const noexcept { return dir_->entry_; }
+        pointer operator->() const noexcept { return &dir_->entry_; }
+
+        iterator &operator++()
+        {
+            if (!dir_->next())
+                dir_ = nullptr;
+            return *this;
+        } // operator++
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator &rhs) const noexcept
+        {
+            return dir_ == rhs.dir_;
+        } // operator==
+
+        bool operator!=(const iterator &rhs) const noexcept
+        {
+            return dir_ != rhs.dir_;
+        } // operator!=
+
+    private:
+        friend class Directory;
+        explicit iterator(Directory *dir) noexcept : dir_(dir) {}
+        Directory *dir_;
+    }; // iterator
+
+    /** PHYSFS_openDirectory(), throwing on failure. */
+    explicit Directory(const char *dir) : dir_(PHYSFS_openDirectory(dir))
+    {
+        if (dir_ == nullptr)
+            throwLastError();
+    } // Directory
+
+    Directory(Directory &&other) noexcept
+        : dir_(std::exchange(other.dir_, nullptr)), entry_(other.entry_) {}
+
+    Directory &operator=(Directory &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            dir_ = std::exchange(other.dir_, nullptr);
+            entry_ = other.entry_;
+        } // if
+        return *this;
+    } // operator=
+
+    Directory(const Directory &) = delete;
+    Directory &operator=(const Directory &) = delete;
+
+    ~Directory() { reset(); }
+
+    iterator begin()
+    {
+        if ((dir_ == nullptr) || (!next()))
+            return iterator();
+        return iterator(this);
+    } // begin
+
+    iterator end() noexcept { return iterator(); }
+
+private:
+    /* false at the end; throws on error. */
+    bool next()
+    {
+        const char *name = nullptr;
+        const int rc = PHYSFS_readDirectory(dir_, &name, &entry_.stat);
+        if (rc < 0)
+            throwLastError();
+        entry_.name = (rc > 0) ? std::string_view(name) : std::string_view();
+        return (rc > 0);
+    } // next
+
+    void reset() noexcept
+    {
+        if (dir_ != nullptr)
+            PHYSFS_closeDirectory(dir_);
+        dir_ = nullptr;
+    } // reset
+
+    PHYSFS_Directory *dir_;
+    Entry entry_ {};
+}; // Directory
+
+
+/*
+ * Binary layouts...
+ *
+ * Describe how a fixed-size record sits in a file once, at compile time,
+ *  and read it with one call instead of a PHYSFS_readULE32() per field:
+ *
+ * \code
+ * struct Header { PHYSFS_uint32 magic; PHYSFS_uint16 version; char name[8]; };
+ * using HeaderLayout = PhysFS::Layout<Header, 14,
+ *     PhysFS::Field<&Header::magic, 0, PhysFS::Endian::Big>,
+ *     PhysFS::Field<&Header::version, 4>,   // little endian by default.
+ *     PhysFS::Field<&Header::name, 6>>;
+ *
+ * Header hdr = PhysFS::readStruct<HeaderLayout>(file);
+ * \endcode
+ *
+ * The record's bytes come in with a single read into a stack buffer, and
+ *  each field is memcpy'd out of it; only fields whose byte order isn't
+ *  the host's get swapped, and which ones is settled at compile time, so
+ *  on a little-endian host a little-endian record is nothing but copies.
+ *  readStructs() reads an array of records in a few big reads.
+ *
+ * Fields can be integers, enums, floats and doubles of 1, 2, 4 or 8 bytes,
+ *  or arrays of single bytes (names, magic strings), which are copied as-is.
+ */
+
+/* The same guess physfs_internal.h makes, for apps that can't see it. */
+#ifndef PHYSFS_HPP_BIG_ENDIAN
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+#define PHYSFS_HPP_BIG_ENDIAN (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#elif defined(__hppa__) || \
+    defined(__m68k__) || defined(mc68000) || defined(_M_M68K) || \
+    (defined(__MIPS__) && defined(__MISPEB__)) || \
+    defined(__ppc__) || defined(__POWERPC__) || defined(_M_PPC) || \
+    defined(__sparc__)
+#define PHYSFS_HPP_BIG_ENDIAN 1
+#else
+#define PHYSFS_HPP_BIG_ENDIAN 0
+#endif
+#endif
+
+enum class Endian
+{
+    Little,
+    Big,
+    Native = PHYSFS_HPP_BIG_ENDIAN ? Big : Little
+}; // Endian
+
+
+namespace detail
+{
+
+template <typename M> struct MemberOf;
+template <typename C, typename V> struct MemberOf<V C::*>
+{
+    using Class = C;
+    using Value = V;
+}; // MemberOf
+
+template <typename U> constexpr U byteswap(U x) noexcept
+{
+    U retval = 0;
+    for (std::size_t i = 0; i < sizeof (U); i++, x >>= 8)
+        retval = (U) ((retval << 8) | (x & 0xFF));
+    return retval;
+} // byteswap
+
+/* the unsigned integer a field's bytes get swapped as. */
+template <std::size_t N> struct SwapType;
+template <> struct SwapType<1> { using Type = PHYSFS_uint8; };
+template <> struct SwapType<2> { using Type = PHYSFS_uint16; };
+template <> struct SwapType<4> { using Type = PHYSFS_uint32; };
+template <> struct SwapType<8> { using Type = PHYSFS_uint64; };
+
+template <typename V> constexpr bool isRawBytes()
+{
+    if constexpr (std::is_array_v<V>)
+        return (sizeof (std::remove_all_extents_t<V>) == 1);
+    else
+        return false;
+} // isRawBytes
+
+} // namespace detail
+
+
+/**
+ * Where one member of a record lives: (Offset) bytes into it, stored in
+ *  (Order) byte order. (Member) is a pointer to the member, like
+ *  &Header::magic.
+ */
+template <auto Member, std::size_t Offset, Endian Order = Endian::Little>
+struct Field
+{
+    using Class = typename detail::MemberOf<decltype(Member)>::Class;
+    using Value = typename detail::MemberOf<decltype(Member)>::Value;
+
+    static constexpr std::size_t offset = Offset;
+    static constexpr std::size_t size = sizeof (Value);
+    static constexpr bool raw = detail::isRawBytes<Value>();
+    static constexpr bool swapped = (!raw) && (size > 1) &&
+                                    (Order != Endian::Native);
+
+    static_assert(raw || std::is_arithmetic_v<Value> || std::is_enum_v<Value>,
+                  "Fields are numbers, enums or arrays of bytes");
+    static_assert(raw || (size == 1) || (size == 2) || (size == 4) ||
+                  (size == 8), "Fields are 1, 2, 4 or 8 bytes");
+
+    static void decode(const std::byte *src, Class &out) noexcept
+    {
+        src += Offset;
+        if constexpr (swapped)
+        {
+            using U = typename detail::SwapType<size>::Type;
+            U bits;
+            std::memcpy(&bits, src, size);
+            bits = detail::byteswap(bits);
+            std::memcpy(&(out.*Member), &bits, size);
+        } // if
+        else
+        {
+            std::memcpy(&(out.*Member), src, size);
+        } // else
+    } // decode
+}; // Field
+
+
+/**
+ * A record of type (T) that takes (Size) bytes on disk, made of (Fields).
+ *  Bytes no field covers are skipped. It's all checked when it's compiled:
+ *  every field has to be a member of (T) and fit inside (Size).
+ */
+template <typename T, std::size_t Size, typename... Fields>
+struct Layout
+{
+    using Struct = T;
+    static constexpr std::size_t size = Size;
+
+    /* true if reading one of these never swaps anything. */
+    static constexpr bool native = (!Fields::swapped && ...);
+
+    static_assert(Size > 0, "A layout needs at least one byte");
+    static_assert((std::is_same_v<typename Fields::Class, T> && ...),
+                  "Every Field must be a member of the Layout's struct");
+    static_assert(((Fields::offset + Fields::size <= Size) && ...),
+                  "A Field runs past the end of its Layout");
+    static_assert(std::is_default_constructible_v<T>,
+                  "Layouts fill in default-constructed structs");
+
+    /** Fill (out) from the (Size) bytes at (src). */
+    static void decode(const std::byte *src, T &out) noexcept
+    {
+        (Fields::decode(src, out), ...);
+    } // decode
+
+    static T decode(const std::byte *src) noexcept
+    {
+        T retval {};
+        decode(src, retval);
+        return retval;
+    } // decode
+}; // Layout
+
+
+/**
+ * Read one (L)-shaped record from (file)'s current position. Throws
+ *  PhysFS::Error, with PHYSFS_ERR_PAST_EOF if the file ends first.
+ */
+template <typename L>
+typename L::Struct readStruct(File &file)
+{
+    std::byte bytes[L::size];
+    if (file.read(bytes, sizeof (bytes)) != sizeof (bytes))
+        throw Error(PHYSFS_ERR_PAST_EOF);
+    return L::decode(bytes);
+} // readStruct
+
+
+/**
+ * Read (count) (L)-shaped records, one after another in (file), into
+ *  (out). They come in through a fixed stack buffer, many records per
+ *  read, so this doesn't allocate. Throws PhysFS::Error, with
+ *  PHYSFS_ERR_PAST_EOF if the file ends first; records before the one
+ *  that was cut short are already filled in then.
+ */
+template <typename L>
+void readStructs(File &file, typename L::Struct *out, std::size_t count)
+{
+    constexpr std::size_t perRead = (L::size >= 4096) ? 1 : (4096 / L::size);
+    std::byte bytes[perRead * L::size];
+
+    while (count > 0)
+    {
+        const std::size_t n = (count < perRead) ? count : perRead;
+        const std::size_t br = file.read(bytes, n * L::size);
+        const std::size_t got = br / L::size;
+        for (std::size_t i = 0; i < got; i++)
+            L::decode(bytes + (i * L::size), out[i]);
+        if (got < n)
+            throw Error(PHYSFS_ERR_PAST_EOF);
+        out += n;
+        count -= n;
+    } // while
+} // readStructs
+
+#if PHYSFS_HPP_HAVE_SPAN
+template <typename L>
+void readStructs(File &file, std::span<typename L::Struct> out)
+{
+    readStructs<L>(file, out.data(), out.size());
+} // readStructs
+#endif
+
+
+/**
+ * A PHYSFS_AsyncQueue that's destroyed when this goes away, which waits
+ *  for its reads to finish. Move only.
+ */
+class AsyncQueue
+{
+public:
+    AsyncQueue() noexcept : queue_(nullptr) {}
+
+    /** PHYSFS_createAsyncQueue(), throwing on failure. */
+    explicit AsyncQueue(PHYSFS_uint32 threads)
+        : queue_(PHYSFS_createAsyncQueue(threads))
+    {
+        if (queue_ == nullptr)
+            throwLastError();
+    } // AsyncQueue
+
+    AsyncQueue(AsyncQueue &&other) noexcept
+        : queue_(std::exchange(other.queue_, nullptr)) {}
+
+    AsyncQueue &operator=(AsyncQueue &&other) noexcept
+    {
+        if (this != &other)
+        {
+            PHYSFS_destroyAsyncQueue(queue_);
+            queue_ = std::exchange(other.queue_, nullptr);
+        } // if
+        return *this;
+    } // operator=
+
+    AsyncQueue(const AsyncQueue &) = delete;
+    AsyncQueue &operator=(const AsyncQueue &) = delete;
+
+    ~AsyncQueue() { PHYSFS_destroyAsyncQueue(queue_); }
+
+    PHYSFS_AsyncQueue *get() const noexcept { return queue_; }
+    operator PHYSFS_AsyncQueue *() const noexcept { return queue_; }
+
+private:
+    PHYSFS_AsyncQueue *queue_;
+}; // AsyncQueue
+
+
+#if PHYSFS_HPP_HAVE_COROUTINES
+
+/*
+ * Coroutines...
+ *
+ * readAsync() and readFileAsync() return awaitables over PHYSFS_readAsync(),
+ *  so a coroutine can co_await a read without a thread sitting in it:
+ *
+ * \code
+ * Task load(PhysFS::AsyncQueue &queue, MyExecutor exec)
+ * {
+ *     PhysFS::Buffer level = co_await PhysFS::readFileAsync(queue,
+ *                                                 "level.dat", &arena, exec);
+ *     ...
+ * }
+ * \endcode
+ *
+ * The coroutine is resumed by handing its std::coroutine_handle<> to the
+ *  executor, which is anything that can be called with one: a job system's
+ *  "post", a lambda that pushes onto a queue, etc. It's called on one of
+ *  the queue's worker threads, so it should hand the work off rather than
+ *  do it there. InlineExecutor, the default, resumes right there on the
+ *  worker. A read that finishes before the coroutine has suspended (one on
+ *  a queue without threads, say) just carries on without going through the
+ *  executor at all.
+ */
+
+/** An executor that resumes the coroutine on whatever thread finished. */
+struct InlineExecutor
+{
+    void operator()(std::coroutine_handle<> handle) const { handle.resume(); }
+}; // InlineExecutor
+
+
+/* What readAsync() returns; co_await it for the byte count. */
+template <typename Executor>
+class ReadAwaitable
+{
+public:
+    ReadAwaitable(PHYSFS_AsyncQueue *queue, PHYSFS_File *file,
+                  std::span<std::byte> buf, PHYSFS_uint64 offset,
+                  Executor executor)
+        : queue_(queue), file_(file), buf_(buf), offset_(offset),
+          executor_(std::move(executor)), result_(-1),
+          error_(PHYSFS_ERR_OK), raced_(false) {}
+
+    ReadAwaitable(const ReadAwaitable &) = delete;
+    ReadAwaitable &operator=(const ReadAwaitable &) = delete;
+
+    bool await_ready() const noexcept { return buf_.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        if (!PHYSFS_readAsync(queue_, file_, buf_.data(),
+                              (PHYSFS_uint64) buf_.size(), offset_,
+                              completed, this))
+        {
+            error_ = PHYSFS_getLastErrorCode();
+            return false;  /* resume now, and throw. */
+        } // if
+
+        /* whoever gets here second resumes; see completed(). */
+        return !raced_.exchange(true, std::memory_order_acq_rel);
+    } // await_suspend
+
+    std::size_t await_resume()
+    {
+        if (buf_.empty())
+            return 0;
+        else if (result_ < 0)
+            throw Error((error_ == PHYSFS_ERR_OK) ? PHYSFS_ERR_OTHER_ERROR
+                                                  : error_);
+        return (std::size_t) result_;
+    } // await_resume
+
+private:
+    static void completed(void *userdata, PHYSFS_File *, void *,
+                          PHYSFS_sint64 result)
+    {
+        ReadAwaitable *self = (ReadAwaitable *) userdata;
+        self->result_ = result;
+        if (result < 0)
+            self->error_ = PHYSFS_getLastErrorCode();
+        if (self->raced_.exchange(true, std::memory_order_acq_rel))
+            self->executor_(self->handle_);  /* it's suspended; wake it. */
+    } // completed
+
+    PHYSFS_AsyncQueue *queue_;
+    PHYSFS_File *file_;
+    std::span<std::byte> buf_;
+    PHYSFS_uint64 offset_;
+    Executor executor_;
+    std::coroutine_handle<> handle_;
+    PHYSFS_sint64 result_;
+    PHYSFS_ErrorCode error_;
+    std::atomic<bool> raced_;
+}; // ReadAwaitable
+
+
+/**
+ * co_await this to read up to (buf).size() bytes from (offset) of (file)
+ *  on (queue), like File::readAt(), and get how many arrived. (file) and
+ *  (buf) must outlive the co_await. Throws PhysFS::Error on failure.
+ */
+template <typename Executor = InlineExecutor>
+ReadAwaitable<Executor> readAsync(PHYSFS_AsyncQueue *queue, File &file,
+                                  std::span<std::byte> buf,
+                                  PHYSFS_uint64 offset,
+                                  Executor executor = Executor())
+{
+    return ReadAwaitable<Executor>(queue, file.get(), buf, offset,
+                                   std::move(executor));
+} // readAsync
+
+
+/* What readFileAsync() returns; co_await it for a Buffer. */
+template <typename Executor>
+class ReadFileAwaitable
+{
+public:
+    ReadFileAwaitable(PHYSFS_AsyncQueue *queue, const char *filename,
+                      std::pmr::memory_resource *resource, Executor executor)
+        : queue_(queue), filename_(filename), resource_(resource),
+          executor_(std::move(executor)) {}
+
+    ReadFileAwaitable(const ReadFileAwaitable &) = delete;
+    ReadFileAwaitable &operator=(const ReadFileAwaitable &) = delete;
+
+    /*
+     * Opening is done here, on the awaiting thread; it doesn't read file
+     *  data. Files that are already in memory are copied without
+     *  suspending, and the odd file with no known length is read with
+     *  readAll(), also without suspending.
+     */
+    bool await_ready()
+    {
+        const void *ptr = nullptr;
+        PHYSFS_uint64 maplen = 0;
+        PHYSFS_sint64 len;
+
+        file_ = File::openRead(filename_);
+        if (PHYSFS_mapRead(file_.get(), &ptr, &maplen))
+        {
+            buffer_ = Buffer((std::size_t) maplen, resource_);
+            std::memcpy(buffer_.data_, ptr, (std::size_t) maplen);
+            finish((PHYSFS_sint64) maplen);
+            return true;
+        } // if
+
+        len = file_.length();
+        if (len < 0)
+        {
+            file_ = File();
+            buffer_ = readAll(filename_, resource_);
+            return true;
+        } // if
+
+        buffer_ = Buffer((std::size_t) len, resource_);
+        if (len == 0)
+        {
+            finish(0);
+            return true;
+        } // if
+
+        read_.emplace(queue_, file_.get(),
+                      std::span<std::byte>(buffer_.data_, (std::size_t) len),
+                      0, std::move(executor_));
+        return false;
+    } // await_ready
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        return read_->await_suspend(handle);
+    } // await_suspend
+
+    Buffer await_resume()
+    {
+        if (read_)
+            finish((PHYSFS_sint64) read_->await_resume());  /* may throw. */
+        return std::move(buffer_);
+    } // await_resume
+
+private:
+    void finish(PHYSFS_sint64 len)
+    {
+        file_ = File();
+        buffer_.size_ = (std::size_t) len;
+        buffer_.data_[len] = std::byte(0);
+    } // finish
+
+    /* ReadAwaitable can't be moved, so it's built in place here. */
+    struct OptionalRead
+    {
+        OptionalRead() noexcept : live(false) {}
+        ~OptionalRead() { if (live) get()->~ReadAwaitable(); }
+
+        template <typename... Args> void emplace(Args &&...args)
+        {
+            new (storage) ReadAwaitable<Executor>(std::forward<Args>(args)...);
+            live = true;
+        } // emplace
+
+        ReadAwaitable<Executor> *get() noexcept
+        {
+            return std::launder((ReadAwaitable<Executor> *) storage);
+        } // get
+
+        ReadAwaitable<Executor> *operator->() noexcept { return get(); }
+        explicit operator bool() const noexcept { return live; }
+
+        alignas(ReadAwaitable<Executor>)
+            unsigned char storage[sizeof (ReadAwaitable<Executor>)];
+        bool live;
+    }; // OptionalRead
+
+    PHYSFS_AsyncQueue *queue_;
+    const char *filename_;
+    std::pmr::memory_resource *resource_;
+    Executor executor_;
+    File file_;
+    Buffer buffer_;
+    OptionalRead read_;
+}; // ReadFileAwaitable
+
+
+/**
+ * co_await this to read all of (filename) into memory from (resource), in
+ *  one allocation, like readAll(), with the read done on (queue). The file
+ *  is opened on the awaiting thread, and (filename) must outlive the
+ *  co_await. Throws PhysFS::Error on failure.
+ */
+template <typename Executor = InlineExecutor>
+ReadFileAwaitable<Executor> readFileAsync(PHYSFS_AsyncQueue *queue,
+                                          const char *filename,
+                                          std::pmr::memory_resource *resource
+                                              = std::pmr::get_default_resource(),
+                                          Executor executor = Executor())
+{
+    return ReadFileAwaitable<Executor>(queue, filename, resource,
+                                       std::move(executor));
+} // readFileAsync
+
+#endif /* PHYSFS_HPP_HAVE_COROUTINES */
+
+} // namespace PhysFS
+
+#endif /* include-once blocker */
+
+/* end of physfs.hpp ... */
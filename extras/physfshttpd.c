@@ -1,20 +1,33 @@
 /*
  * This is a quick and dirty HTTP server that uses PhysicsFS to retrieve
- *  files. It is not robust at all, probably buggy, and definitely poorly
- *  designed. It's just meant to show that it can be done.
+ *  files. It's not a general purpose web server: it does GET and HEAD of
+ *  whatever is in the search path, and that's it. It's just meant to show
+ *  that it can be done, and to serve assets out of mounted packs.
  *
  * Basically, you compile this code, and run it:
- *   ./physfshttpd archive1.zip archive2.zip /path/to/a/real/dir etc...
+ *   ./physfshttpd [-p port] [-t threads] archive1.zip archive2.zip /a/dir
  *
  * The files are appended in order to the PhysicsFS search path, and when
  *  a client request comes it, it looks for the file in said search path.
  *
- * My goal was to make this work in less than 300 lines of C, so again, it's
- *  not to be used for any serious purpose. Patches to make this application
- *  suck less will be readily and gratefully accepted.
+ * One thread owns every socket, and waits on all of them at once with
+ *  epoll (Linux), kqueue (BSD and macOS) or poll() (anything else). File
+ *  i/o goes to a fixed pool of worker threads, since reading an archive can
+ *  block on the disk or spend a while decompressing: a worker opens the
+ *  file and fills the connection's buffer, and the socket thread sends it
+ *  as fast as the client takes it. Connections stay open for more requests
+ *  (HTTP/1.1 keep-alive), so thousands of clients can be downloading at
+ *  once without thousands of threads.
+ *
+ * Files that sit verbatim in a real file (loose files, stored .zip entries,
+ *  .grp/.pak/.wad entries...) don't get read at all: PHYSFS_getFileBacking()
+ *  says where they are, and sendfile() sends them straight from the OS's
+ *  cache to the socket. Clients that take "Content-Encoding: deflate" get
+ *  deflated .zip entries as they're stored, without inflating them here,
+ *  and "Range:" requests let them resume or fetch just part of a file.
  *
  * Command line I used to build this on Linux:
- *  gcc -Wall -Werror -g -o bin/physfshttpd extras/physfshttpd.c -lphysfs
+ *  gcc -Wall -Werror -g -o bin/physfshttpd extras/physfshttpd.c -lphysfs -lpthread
  *
  * License: this code is public domain. I make no warranty that it is useful,
  *  correct, harmless, or environmentally safe.
@@ -38,6 +51,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -51,127 +66,1054 @@
 #include <netdb.h>
 #endif
 
+#if defined(__linux__)
+#define USE_EPOLL 1
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__) || defined(__DragonFly__)
+#define USE_KQUEUE 1
+#include <sys/event.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#else
+#define USE_POLL 1
+#include <poll.h>
+#endif
+
 #include "physfs.h"
 
 
 #define DEFAULT_PORTNUM  6667
+#define DEFAULT_THREADS  4
+#define MAX_THREADS  64
+#define LISTEN_BACKLOG  1024
+#define REQUEST_MAX  (8 * 1024)    /* a request's headers must fit in this. */
+#define SENDBUF_SIZE  (256 * 1024)  /* file data goes out this much at once. */
+#define MAX_EVENTS  256
+#define SENDFILE_MAX  (4 * 1024 * 1024)  /* most to sendfile() in one call. */
 
-typedef struct
+#define WANT_READ  1
+#define WANT_WRITE  2
+
+typedef enum
+{
+    CONN_READING,  /* waiting for (the rest of) a request. */
+    CONN_WORKING,  /* a worker has it; the socket thread leaves it alone. */
+    CONN_SENDING,  /* sending (buf), then more from (file) or the next one. */
+    CONN_DEAD      /* closed; freed once this batch of events is handled. */
+} ConnState;
+
+typedef struct Conn
 {
     int sock;
-    struct sockaddr *addr;
-    socklen_t addrlen;
-} http_args;
+    ConnState state;
+    char ipstr[64];
+    char req[REQUEST_MAX];  /* what's come in and hasn't been handled. */
+    size_t reqlen;
+    char *fname;  /* file the worker should open, or NULL. */
+    int headonly;  /* HEAD request: just the headers. */
+    int keepalive;  /* non-zero to wait for another request after this. */
+    int deflateok;  /* client takes "Content-Encoding: deflate". */
+    int rangeset;  /* non-zero if "Range:" asked for part of the file. */
+    PHYSFS_sint64 rangefirst;  /* first byte wanted, or -1 for a suffix. */
+    PHYSFS_sint64 rangelast;  /* last byte (or suffix length), or -1. */
+    PHYSFS_File *file;  /* what we're sending, or NULL when it's all read. */
+    PHYSFS_sint64 remaining;  /* bytes of (file) left, -1 if unknown. */
+    char *buf;  /* SENDBUF_SIZE bytes, while there's a response going. */
+    size_t buflen;
+    size_t bufpos;
+    int sendfd;  /* after (buf), sendfile() this, which (file) owns... */
+    PHYSFS_uint64 sendpos;  /* ...from here... */
+    PHYSFS_uint64 sendleft;  /* ...for this many bytes. */
+    struct Conn *next;  /* in the work, done or dead list. */
+} Conn;
+
 
+static const char *txt400 =
+"HTTP/1.1 400 Bad Request\r\n"
+"Connection: close\r\n"
+"Content-Length: 0\r\n"
+"\r\n";
 
-static char *txt404 =
-"HTTP/1.0 404 Not Found\n"
-"Connection: close\n"
-"Content-Type: text/html; charset=utf-8\n"
-"\n"
+static const char *txt404 =
+"HTTP/1.1 404 Not Found\r\n"
+"Connection: %s\r\n"
+"Content-Type: text/html; charset=utf-8\r\n"
+"Content-Length: %d\r\n"
+"\r\n";
+
+static const char *body404 =
 "<html><head><title>404 Not Found</title></head>\n"
-"<body>Can't find that.</body></html>\n\n";
+"<body>Can't find that.</body></html>\n";
+
+static const char *txt416 =
+"HTTP/1.1 416 Range Not Satisfiable\r\n"
+"Connection: %s\r\n"
+"Content-Range: bytes */%lld\r\n"
+"Content-Length: 0\r\n"
+"\r\n";
 
+static const char *txt500 =
+"HTTP/1.1 500 Internal Server Error\r\n"
+"Connection: close\r\n"
+"Content-Length: 0\r\n"
+"\r\n";
 
-static void feed_file_http(const char *ipstr, int sock, const char *fname)
+static const char *txt501 =
+"HTTP/1.1 501 Not Implemented\r\n"
+"Connection: close\r\n"
+"Content-Length: 0\r\n"
+"\r\n";
+
+
+/* the worker pool: connections go in (work), come back out in (done). */
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolCond = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_THREADS];
+static int numWorkers = 0;
+static int stopWorkers = 0;
+static Conn *workHead = NULL;
+static Conn *workTail = NULL;
+static Conn *doneList = NULL;
+static int wakepipe[2] = { -1, -1 };  /* workers poke the socket thread. */
+
+static Conn *deadList = NULL;  /* closed during this batch of events. */
+static int listensocket = -1;
+static volatile sig_atomic_t quitRequested = 0;
+
+
+/* Event polling: one of these three, depending on what the OS has. */
+
+typedef struct
 {
-    PHYSFS_File *in = PHYSFS_openRead(fname);
-    char buffer[1024];
-    printf("%s: requested [%s].\n", ipstr, fname);
-    if (in == NULL)
+    void *data;
+    int readable;
+    int writable;
+} PollEvent;
+
+#if USE_EPOLL
+static int poller = -1;
+
+static int poller_init(void)
+{
+    poller = epoll_create(1024);  /* the size is just a hint. */
+    return (poller >= 0);
+} /* poller_init */
+
+
+static int poller_watch(int fd, void *data, int want, int adding)
+{
+    struct epoll_event ev;
+    memset(&ev, '\0', sizeof (ev));
+    ev.events = ((want & WANT_READ) ? EPOLLIN : 0) |
+                ((want & WANT_WRITE) ? EPOLLOUT : 0);
+    ev.data.ptr = data;
+    return (epoll_ctl(poller, adding ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                      fd, &ev) == 0);
+} /* poller_watch */
+
+
+static void poller_forget(int fd)
+{
+    struct epoll_event ev;  /* old kernels want one, even if it's unused. */
+    epoll_ctl(poller, EPOLL_CTL_DEL, fd, &ev);
+} /* poller_forget */
+
+
+static int poller_wait(PollEvent *events, int max)
+{
+    struct epoll_event ev[MAX_EVENTS];
+    int i, rc;
+
+    rc = epoll_wait(poller, ev, (max < MAX_EVENTS) ? max : MAX_EVENTS, -1);
+    for (i = 0; i < rc; i++)
     {
-        printf("%s: Can't open [%s]: %s.\n",
-               ipstr, fname, PHYSFS_getLastError());
-        write(sock, txt404, strlen(txt404));  /* !!! FIXME: Check retval */
+        const int err = (ev[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+        events[i].data = ev[i].data.ptr;
+        events[i].readable = err || ((ev[i].events & EPOLLIN) != 0);
+        events[i].writable = err || ((ev[i].events & EPOLLOUT) != 0);
+    } /* for */
+    return rc;
+} /* poller_wait */
+
+#elif USE_KQUEUE
+static int poller = -1;
+
+static int poller_init(void)
+{
+    poller = kqueue();
+    return (poller >= 0);
+} /* poller_init */
+
+
+static int poller_watch(int fd, void *data, int want, int adding)
+{
+    struct kevent kev[2];
+    const int rd = (want & WANT_READ) ? EV_ENABLE : EV_DISABLE;
+    const int wr = (want & WANT_WRITE) ? EV_ENABLE : EV_DISABLE;
+    EV_SET(&kev[0], fd, EVFILT_READ, EV_ADD | rd, 0, 0, data);
+    EV_SET(&kev[1], fd, EVFILT_WRITE, EV_ADD | wr, 0, 0, data);
+    return (kevent(poller, kev, 2, NULL, 0, NULL) == 0);
+} /* poller_watch */
+
+
+static void poller_forget(int fd)
+{
+    (void) fd;  /* closing the socket takes it out of the kqueue. */
+} /* poller_forget */
+
+
+static int poller_wait(PollEvent *events, int max)
+{
+    struct kevent kev[MAX_EVENTS];
+    int i, rc;
+
+    rc = kevent(poller, NULL, 0, kev, (max < MAX_EVENTS) ? max : MAX_EVENTS,
+                NULL);
+    for (i = 0; i < rc; i++)
+    {
+        const int err = (kev[i].flags & (EV_EOF | EV_ERROR)) != 0;
+        events[i].data = kev[i].udata;
+        events[i].readable = err || (kev[i].filter == EVFILT_READ);
+        events[i].writable = err || (kev[i].filter == EVFILT_WRITE);
+    } /* for */
+    return rc;
+} /* poller_wait */
+
+#else  /* plain poll(), which scans everything every time, but works. */
+static struct pollfd *pollfds = NULL;
+static void **polldata = NULL;
+static int pollcount = 0;
+static int pollcapacity = 0;
+
+static int poller_init(void)
+{
+    return 1;
+} /* poller_init */
+
+
+static int poller_watch(int fd, void *data, int want, int adding)
+{
+    int i = 0;
+
+    if (adding)
+    {
+        if (pollcount == pollcapacity)
+        {
+            const int newcap = pollcapacity ? pollcapacity * 2 : 64;
+            void *ptr = realloc(pollfds, newcap * sizeof (struct pollfd));
+            if (ptr == NULL)
+                return 0;
+            pollfds = (struct pollfd *) ptr;
+            ptr = realloc(polldata, newcap * sizeof (void *));
+            if (ptr == NULL)
+                return 0;
+            polldata = (void **) ptr;
+            pollcapacity = newcap;
+        } /* if */
+        i = pollcount++;
+        pollfds[i].fd = fd;
+        polldata[i] = data;
     } /* if */
     else
     {
-        do
+        while ((i < pollcount) && (pollfds[i].fd != fd))
+            i++;
+        if (i == pollcount)
+            return 0;
+    } /* else */
+
+    pollfds[i].events = ((want & WANT_READ) ? POLLIN : 0) |
+                        ((want & WANT_WRITE) ? POLLOUT : 0);
+    pollfds[i].revents = 0;
+    return 1;
+} /* poller_watch */
+
+
+static void poller_forget(int fd)
+{
+    int i;
+    for (i = 0; i < pollcount; i++)
+    {
+        if (pollfds[i].fd == fd)
         {
-            PHYSFS_sint64 br = PHYSFS_read(in, buffer, 1, sizeof (buffer));
-            if (br == -1)
-            {
-                printf("%s: Read error: %s.\n", ipstr, PHYSFS_getLastError());
-                break;
-            } /* if */
+            pollcount--;
+            pollfds[i] = pollfds[pollcount];
+            polldata[i] = polldata[pollcount];
+            return;
+        } /* if */
+    } /* for */
+} /* poller_forget */
 
-            write(sock, buffer, (int) br);   /* !!! FIXME: CHECK THIS RETVAL! */
-        } while (!PHYSFS_eof(in));
 
-        PHYSFS_close(in);
-    } /* else */
-} /* feed_file_http */
+static int poller_wait(PollEvent *events, int max)
+{
+    int i, rc, found = 0;
+
+    rc = poll(pollfds, (nfds_t) pollcount, -1);
+    for (i = 0; (rc > 0) && (i < pollcount) && (found < max); i++)
+    {
+        const short revents = pollfds[i].revents;
+        const int err = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+        if (revents == 0)
+            continue;
+        events[found].data = polldata[i];
+        events[found].readable = err || ((revents & POLLIN) != 0);
+        events[found].writable = err || ((revents & POLLOUT) != 0);
+        found++;
+    } /* for */
+    return (rc < 0) ? rc : found;
+} /* poller_wait */
+#endif
+
+
+/* Send up to (len) bytes of (fd) from (pos) to (sock), without copying. */
+static ssize_t send_from_file(int sock, int fd, PHYSFS_uint64 pos, size_t len)
+{
+#if defined(__linux__)
+    off_t off = (off_t) pos;
+    return sendfile(sock, fd, &off, len);
+#elif defined(__FreeBSD__) || defined(__DragonFly__)
+    off_t sent = 0;
+    if ((sendfile(fd, sock, (off_t) pos, len, NULL, &sent, 0) == -1) &&
+        (sent == 0))
+        return -1;
+    return (ssize_t) sent;  /* partial sends fail with EAGAIN, but count. */
+#elif defined(__APPLE__)
+    off_t sent = (off_t) len;
+    if ((sendfile(fd, sock, (off_t) pos, &sent, NULL, 0) == -1) &&
+        (sent == 0))
+        return -1;
+    return (ssize_t) sent;
+#else
+    (void) sock; (void) fd; (void) pos; (void) len;
+    errno = ENOSYS;  /* the caller goes back to reading it. */
+    return -1;
+#endif
+} /* send_from_file */
+
+
+static int set_nonblocking(int fd)
+{
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return ((flags != -1) && (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1));
+} /* set_nonblocking */
 
 
-static void *do_http(void *_args)
+/* Start (c) on a response that's entirely (text), then close or carry on. */
+static void set_response(Conn *c, const char *text, int keepalive)
 {
-    http_args *args = (http_args *) _args;
-    char ipstr[128];
-    char buffer[512];
-    char *ptr;
-    strncpy(ipstr, inet_ntoa(((struct sockaddr_in *) args->addr)->sin_addr),
-            sizeof (ipstr));
-    ipstr[sizeof (ipstr) - 1] = '\0';
+    const size_t len = strlen(text);
+    memcpy(c->buf, text, len);
+    c->buflen = len;
+    c->bufpos = 0;
+    c->keepalive = keepalive;
+} /* set_response */
 
-    printf("%s: connected.\n", ipstr);
-    read(args->sock, buffer, sizeof (buffer));
-    buffer[sizeof (buffer) - 1] = '\0';
-    ptr = strchr(buffer, '\n');
-    if (!ptr)
-        printf("%s: potentially bogus request.\n", ipstr);
+
+/* Worker side: open (c->fname) and put the response's headers in (buf). */
+static void start_response(Conn *c)
+{
+    const char *connection = c->keepalive ? "keep-alive" : "close";
+    PHYSFS_Encoding encoding = PHYSFS_ENCODING_IDENTITY;
+    PHYSFS_FileBacking backing;
+    PHYSFS_sint64 len;
+    PHYSFS_sint64 first;
+    PHYSFS_sint64 last;
+    char range[128];
+
+    printf("%s: requested [%s].\n", c->ipstr, c->fname);
+    if (c->deflateok)  /* send deflated entries as they are, if we can. */
+        c->file = PHYSFS_openReadRaw(c->fname, &encoding);
     else
+        c->file = PHYSFS_openRead(c->fname);
+
+    if (c->file == NULL)
+    {
+        printf("%s: Can't open [%s]: %s.\n", c->ipstr, c->fname,
+               PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        c->buflen = (size_t) sprintf(c->buf, txt404, connection,
+                                     (int) strlen(body404));
+        if (!c->headonly)
+        {
+            strcpy(c->buf + c->buflen, body404);
+            c->buflen += strlen(body404);
+        } /* if */
+        return;
+    } /* if */
+
+    len = PHYSFS_fileLength(c->file);
+    if (len < 0)  /* no length? Then EOF ends it, and ranges are out. */
     {
-        *ptr = '\0';
-        ptr = strchr(buffer, '\r');
-        if (ptr != NULL)
-            *ptr = '\0';
+        c->keepalive = 0;
+        c->remaining = c->headonly ? 0 : -1;
+        c->buflen = (size_t) sprintf(c->buf,
+                        "HTTP/1.1 200 OK\r\n"
+                        "Connection: close\r\n"
+                        "%s"
+                        "\r\n",
+                        encoding ? "Content-Encoding: deflate\r\n" : "");
+        return;
+    } /* if */
+
+    first = 0;
+    last = len - 1;
+    range[0] = '\0';
+    if (c->rangeset)
+    {
+        if (c->rangefirst < 0)  /* "bytes=-N" is the last N bytes. */
+            first = (c->rangelast < len) ? len - c->rangelast : 0;
+        else
+        {
+            first = c->rangefirst;
+            if ((c->rangelast >= 0) && (c->rangelast < last))
+                last = c->rangelast;
+        } /* else */
 
-        if ((toupper(buffer[0]) == 'G') &&
-            (toupper(buffer[1]) == 'E') &&
-            (toupper(buffer[2]) == 'T') &&
-            (toupper(buffer[3]) == ' ') &&
-            (toupper(buffer[4]) == '/'))
+        if ((first >= len) || (first > last))
         {
-            ptr = strchr(buffer + 5, ' ');
-            if (ptr != NULL)
-                *ptr = '\0';
-            feed_file_http(ipstr, args->sock, buffer + 4);
+            PHYSFS_close(c->file);
+            c->file = NULL;
+            c->buflen = (size_t) sprintf(c->buf, txt416, connection,
+                                         (long long) len);
+            return;
         } /* if */
-    } /* else */
 
-    /* !!! FIXME: Time the transfer. */
-    printf("%s: closing connection.\n", ipstr);
-    close(args->sock);
-    free(args->addr);
-    free(args);
+        if (!PHYSFS_seek(c->file, (PHYSFS_uint64) first))
+        {
+            printf("%s: Can't seek [%s]: %s.\n", c->ipstr, c->fname,
+                   PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+            PHYSFS_close(c->file);
+            c->file = NULL;
+            set_response(c, txt500, 0);
+            return;
+        } /* if */
+
+        sprintf(range, "Content-Range: bytes %lld-%lld/%lld\r\n",
+                (long long) first, (long long) last, (long long) len);
+    } /* if */
+
+    c->remaining = (last - first) + 1;
+    c->buflen = (size_t) sprintf(c->buf,
+                    "HTTP/1.1 %s\r\n"
+                    "Connection: %s\r\n"
+                    "Accept-Ranges: bytes\r\n"
+                    "Vary: Accept-Encoding\r\n"
+                    "%s"
+                    "%s"
+                    "Content-Length: %lld\r\n"
+                    "\r\n",
+                    c->rangeset ? "206 Partial Content" : "200 OK",
+                    connection,
+                    encoding ? "Content-Encoding: deflate\r\n" : "",
+                    range, (long long) c->remaining);
+
+    if (c->headonly)
+        c->remaining = 0;
+    else if ((c->remaining > 0) && (PHYSFS_getFileBacking(c->file, &backing)))
+    {
+        /* it's in a real file, as-is; let the kernel send it. */
+        c->sendfd = backing.fd;
+        c->sendpos = backing.offset + (PHYSFS_uint64) first;
+        c->sendleft = (PHYSFS_uint64) c->remaining;
+        c->remaining = 0;
+    } /* else if */
+} /* start_response */
+
+
+/*
+ * Worker side: start the response if this is a new request, then fill the
+ *  rest of the buffer from the file. Closes the file once it's all read.
+ */
+static void fill_conn(Conn *c)
+{
+    size_t avail;
+
+    c->buflen = c->bufpos = 0;
+
+    if (c->fname != NULL)
+    {
+        start_response(c);
+        free(c->fname);
+        c->fname = NULL;
+    } /* if */
+
+    if ((c->file != NULL) && (c->remaining != 0))
+    {
+        PHYSFS_sint64 br;
+        avail = SENDBUF_SIZE - c->buflen;
+        if ((c->remaining > 0) && (((PHYSFS_uint64) c->remaining) < avail))
+            avail = (size_t) c->remaining;
+
+        br = PHYSFS_readBytes(c->file, c->buf + c->buflen, avail);
+        if (br > 0)
+        {
+            c->buflen += (size_t) br;
+            if (c->remaining > 0)
+                c->remaining -= br;
+        } /* if */
+
+        if ((br < 0) || ((br < (PHYSFS_sint64) avail) && (c->remaining > 0)))
+        {
+            /* we promised more than this, so all we can do is hang up. */
+            printf("%s: Read error: %s.\n", c->ipstr,
+                   PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+            c->keepalive = 0;
+            c->remaining = 0;
+        } /* if */
+        else if ((c->remaining < 0) && (PHYSFS_eof(c->file)))
+            c->remaining = 0;
+    } /* if */
+
+    if ((c->file != NULL) && (c->remaining == 0) && (c->sendleft == 0))
+    {
+        PHYSFS_close(c->file);
+        c->file = NULL;
+    } /* if */
+} /* fill_conn */
+
+
+static void *worker_thread(void *arg)
+{
+    (void) arg;
+
+    pthread_mutex_lock(&poolLock);
+    while (1)
+    {
+        Conn *c;
+        while ((workHead == NULL) && (!stopWorkers))
+            pthread_cond_wait(&poolCond, &poolLock);
+        if (stopWorkers)
+            break;
+
+        c = workHead;
+        workHead = c->next;
+        if (workHead == NULL)
+            workTail = NULL;
+        pthread_mutex_unlock(&poolLock);
+
+        fill_conn(c);
+
+        pthread_mutex_lock(&poolLock);
+        c->next = doneList;
+        doneList = c;
+        if (c->next == NULL)  /* first one in; the socket thread needs it. */
+        {
+            const char ch = 0;
+            ssize_t rc;
+            do
+            {
+                rc = write(wakepipe[1], &ch, 1);
+            } while ((rc < 0) && (errno == EINTR));
+        } /* if */
+    } /* while */
+    pthread_mutex_unlock(&poolLock);
+
     return NULL;
-} /* do_http */
+} /* worker_thread */
 
 
-static void serve_http_request(int sock, struct sockaddr *addr,
-                               socklen_t addrlen)
+static int start_workers(int count)
 {
-    http_args *args = (http_args *) malloc(sizeof (http_args));
-    if (args == NULL)
+    sigset_t blocked, prev;
+    int i;
+
+    /* signals are for the socket thread, to wake it from waiting. */
+    sigfillset(&blocked);
+    pthread_sigmask(SIG_BLOCK, &blocked, &prev);
+    for (i = 0; i < count; i++)
     {
-        printf("out of memory.\n");
+        if (pthread_create(&workers[i], NULL, worker_thread, NULL) != 0)
+            break;
+        numWorkers++;
+    } /* for */
+    pthread_sigmask(SIG_SETMASK, &prev, NULL);
+
+    return (numWorkers > 0);
+} /* start_workers */
+
+
+static void stop_workers(void)
+{
+    int i;
+
+    pthread_mutex_lock(&poolLock);
+    stopWorkers = 1;
+    pthread_cond_broadcast(&poolCond);
+    pthread_mutex_unlock(&poolLock);
+
+    for (i = 0; i < numWorkers; i++)
+        pthread_join(workers[i], NULL);
+    numWorkers = 0;
+} /* stop_workers */
+
+
+/* Hand (c) to a worker to open or keep reading its file. */
+static void queue_work(Conn *c)
+{
+    c->state = CONN_WORKING;
+    poller_watch(c->sock, c, 0, 0);  /* don't tell us about it meanwhile. */
+
+    pthread_mutex_lock(&poolLock);
+    c->next = NULL;
+    if (workTail != NULL)
+        workTail->next = c;
+    else
+        workHead = c;
+    workTail = c;
+    pthread_cond_signal(&poolCond);
+    pthread_mutex_unlock(&poolLock);
+} /* queue_work */
+
+
+static void close_conn(Conn *c)
+{
+    if (c->state == CONN_DEAD)
         return;
-    } /* if */
-    args->addr = (struct sockaddr *) malloc(addrlen);
-    if (args->addr == NULL)
+
+    poller_forget(c->sock);
+    close(c->sock);
+    if (c->file != NULL)
+        PHYSFS_close(c->file);
+    free(c->fname);
+    free(c->buf);
+    c->file = NULL;
+    c->fname = NULL;
+    c->buf = NULL;
+
+    /* there might be more events for it in this batch, so free it later. */
+    c->state = CONN_DEAD;
+    c->next = deadList;
+    deadList = c;
+} /* close_conn */
+
+
+static void free_dead_conns(void)
+{
+    while (deadList != NULL)
+    {
+        Conn *next = deadList->next;
+        free(deadList);
+        deadList = next;
+    } /* while */
+} /* free_dead_conns */
+
+
+/* Find (token) in a header's value; returns what's after it, or NULL. */
+static const char *find_token(const char *value, const char *token)
+{
+    const size_t len = strlen(token);
+    while (*value)
+    {
+        if (strncasecmp(value, token, len) == 0)
+            return value + len;
+        value++;
+    } /* while */
+    return NULL;
+} /* find_token */
+
+
+/* "Accept-Encoding: gzip, deflate", but not "deflate;q=0". */
+static int accepts_deflate(const char *value)
+{
+    const char *ptr = find_token(value, "deflate");
+    if (ptr == NULL)
+        return 0;
+
+    while ((*ptr == ' ') || (*ptr == '\t'))
+        ptr++;
+    if (*ptr != ';')
+        return 1;
+    ptr++;
+    while ((*ptr == ' ') || (*ptr == '\t'))
+        ptr++;
+    if (((*ptr != 'q') && (*ptr != 'Q')) || (ptr[1] != '='))
+        return 1;
+    return (strtod(ptr + 2, NULL) > 0.0);
+} /* accepts_deflate */
+
+
+/* "Range: bytes=A-B", "bytes=A-" or "bytes=-N"; we ignore anything else. */
+static void parse_range(Conn *c, const char *value)
+{
+    PHYSFS_sint64 first = -1;
+    PHYSFS_sint64 last = -1;
+    char *end;
+
+    while ((*value == ' ') || (*value == '\t'))
+        value++;
+    if ((strncasecmp(value, "bytes=", 6) != 0) || (strchr(value, ',')))
+        return;  /* not bytes, or several ranges; just send all of it. */
+    value += 6;
+
+    if (isdigit((unsigned char) *value))
     {
-        free(args);
-        printf("out of memory.\n");
+        first = (PHYSFS_sint64) strtoll(value, &end, 10);
+        value = end;
+    } /* if */
+
+    if (*(value++) != '-')
         return;
+
+    if (isdigit((unsigned char) *value))
+    {
+        last = (PHYSFS_sint64) strtoll(value, &end, 10);
+        value = end;
+    } /* if */
+
+    while ((*value == ' ') || (*value == '\t') || (*value == '\r'))
+        value++;
+
+    if ((*value != '\0') || ((first < 0) && (last < 0)) ||
+        ((last >= 0) && (first > last)))
+        return;  /* malformed, so it doesn't count. */
+
+    c->rangeset = 1;
+    c->rangefirst = first;
+    c->rangelast = last;
+} /* parse_range */
+
+
+/*
+ * Look for a whole request in (c->req). Returns 1 and starts handling it if
+ *  there is one, 0 if we need more, and -1 if it's hopeless.
+ */
+static int parse_request(Conn *c)
+{
+    char *end = NULL;
+    char *line;
+    char *next;
+    char *method;
+    char *path;
+    char *version;
+    size_t hdrlen;
+    size_t i;
+
+    for (i = 0; i < c->reqlen; i++)
+    {
+        if ((c->req[i] == '\n') && (i + 1 < c->reqlen) &&
+            ((c->req[i + 1] == '\n') ||
+             ((c->req[i + 1] == '\r') && (i + 2 < c->reqlen) &&
+              (c->req[i + 2] == '\n'))))
+        {
+            end = c->req + i + ((c->req[i + 1] == '\n') ? 2 : 3);
+            break;
+        } /* if */
+    } /* for */
+
+    if (end == NULL)
+        return (c->reqlen == sizeof (c->req)) ? -1 : 0;
+
+    hdrlen = (size_t) (end - c->req);
+    end[-1] = '\0';
+
+    if (c->buf == NULL)
+    {
+        c->buf = (char *) malloc(SENDBUF_SIZE);
+        if (c->buf == NULL)
+        {
+            printf("%s: out of memory.\n", c->ipstr);
+            return -1;
+        } /* if */
+    } /* if */
+
+    /* the request line: METHOD /path HTTP/x.y */
+    line = c->req;
+    next = strchr(line, '\n');
+    *next++ = '\0';
+    method = strtok(line, " \t\r");
+    path = strtok(NULL, " \t\r");
+    version = strtok(NULL, " \t\r");
+
+    if ((method == NULL) || (path == NULL) || (*path != '/'))
+    {
+        set_response(c, txt400, 0);
+        c->state = CONN_SENDING;
+    } /* if */
+    else if ((strcmp(method, "GET") != 0) && (strcmp(method, "HEAD") != 0))
+    {
+        set_response(c, txt501, 0);
+        c->state = CONN_SENDING;
+    } /* else if */
+    else
+    {
+        char *query = strpbrk(path, "?#");
+        if (query != NULL)
+            *query = '\0';
+
+        c->headonly = (strcmp(method, "HEAD") == 0);
+        c->keepalive = ((version != NULL) &&
+                        (strcmp(version, "HTTP/1.0") != 0));
+        c->deflateok = 0;
+        c->rangeset = 0;
+
+        /* the rest are headers; we only care about a few of them. */
+        for (line = next; *line; line = next)
+        {
+            next = strchr(line, '\n');
+            if (next != NULL)
+                *next++ = '\0';
+            else
+                next = line + strlen(line);
+
+            if (strncasecmp(line, "Connection:", 11) == 0)
+            {
+                if (find_token(line + 11, "close"))
+                    c->keepalive = 0;
+                else if (find_token(line + 11, "keep-alive"))
+                    c->keepalive = 1;
+            } /* if */
+            else if (strncasecmp(line, "Accept-Encoding:", 16) == 0)
+                c->deflateok = accepts_deflate(line + 16);
+            else if (strncasecmp(line, "Range:", 6) == 0)
+                parse_range(c, line + 6);
+        } /* for */
+
+        c->fname = (char *) malloc(strlen(path) + 1);
+        if (c->fname == NULL)
+        {
+            printf("%s: out of memory.\n", c->ipstr);
+            return -1;
+        } /* if */
+        strcpy(c->fname, path);
+    } /* else */
+
+    /* keep anything pipelined behind it for later. */
+    c->reqlen -= hdrlen;
+    memmove(c->req, c->req + hdrlen, c->reqlen);
+
+    if (c->fname != NULL)
+        queue_work(c);
+    return 1;
+} /* parse_request */
+
+
+static void handle_sending(Conn *c);
+
+/* (c) is between requests: start the next one, or wait for it. */
+static void handle_reading(Conn *c, int readable)
+{
+    int rc;
+
+    while (readable && (c->reqlen < sizeof (c->req)))
+    {
+        const ssize_t br = read(c->sock, c->req + c->reqlen,
+                                sizeof (c->req) - c->reqlen);
+        if (br > 0)
+            c->reqlen += (size_t) br;
+        else if ((br < 0) && (errno == EINTR))
+            continue;
+        else if ((br < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+            break;
+        else  /* hung up, or something's wrong. */
+        {
+            close_conn(c);
+            return;
+        } /* else */
+    } /* while */
+
+    rc = parse_request(c);
+    if (rc < 0)
+    {
+        printf("%s: bogus request.\n", c->ipstr);
+        close_conn(c);
+    } /* if */
+    else if ((rc > 0) && (c->state == CONN_SENDING))
+        handle_sending(c);
+    else if (rc == 0)
+    {
+        /* nothing to send while we're waiting, so don't hold a buffer. */
+        free(c->buf);
+        c->buf = NULL;
+        poller_watch(c->sock, c, WANT_READ, 0);
+    } /* else if */
+} /* handle_reading */
+
+
+/*
+ * sendfile() as much as the socket takes. Returns 1 when it's all gone (or
+ *  it has to be read after all), 0 if we have to wait or (c) is closed.
+ */
+static int send_backing(Conn *c)
+{
+    while (c->sendleft > 0)
+    {
+        const size_t len = (c->sendleft < SENDFILE_MAX) ?
+                                (size_t) c->sendleft : SENDFILE_MAX;
+        const ssize_t bw = send_from_file(c->sock, c->sendfd, c->sendpos, len);
+        if (bw > 0)
+        {
+            c->sendpos += (PHYSFS_uint64) bw;
+            c->sendleft -= (PHYSFS_uint64) bw;
+        } /* if */
+        else if ((bw < 0) && (errno == EINTR))
+            continue;
+        else if ((bw < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            poller_watch(c->sock, c, WANT_WRITE, 0);
+            return 0;
+        } /* else if */
+        else if ((bw < 0) && ((errno == EINVAL) || (errno == ENOSYS) ||
+                              (errno == ENOTSOCK) || (errno == EOPNOTSUPP)))
+        {
+            /* can't sendfile() this pair; read the rest the usual way. */
+            const PHYSFS_sint64 flen = PHYSFS_fileLength(c->file);
+            if (!PHYSFS_seek(c->file, flen - c->sendleft))
+            {
+                close_conn(c);
+                return 0;
+            } /* if */
+            c->remaining = (PHYSFS_sint64) c->sendleft;
+            c->sendleft = 0;
+            return 1;
+        } /* else if */
+        else  /* client went away, or the file came up short. */
+        {
+            close_conn(c);
+            return 0;
+        } /* else */
+    } /* while */
+
+    if (c->remaining == 0)
+    {
+        PHYSFS_close(c->file);
+        c->file = NULL;
     } /* if */
+    return 1;
+} /* send_backing */
+
 
-    args->sock = sock;
-    args->addrlen = addrlen;
-    memcpy(args->addr, addr, addrlen);
+/* Send what's buffered, then get more, or move on to the next request. */
+static void handle_sending(Conn *c)
+{
+    while (c->bufpos < c->buflen)
+    {
+        const ssize_t bw = write(c->sock, c->buf + c->bufpos,
+                                 c->buflen - c->bufpos);
+        if (bw >= 0)
+            c->bufpos += (size_t) bw;
+        else if (errno == EINTR)
+            continue;
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+            poller_watch(c->sock, c, WANT_WRITE, 0);
+            return;
+        } /* else if */
+        else  /* client went away. */
+        {
+            close_conn(c);
+            return;
+        } /* else */
+    } /* while */
 
-    /* !!! FIXME: optionally spin a thread... */
-    do_http((void *) args);
-} /* server_http_request */
+    if ((c->sendleft > 0) && (!send_backing(c)))
+        return;  /* waiting for the socket, or it's closed. */
+
+    if (c->file != NULL)
+        queue_work(c);  /* more where that came from. */
+    else if (!c->keepalive)
+        close_conn(c);
+    else
+    {
+        c->state = CONN_READING;
+        handle_reading(c, 0);  /* might have one pipelined already. */
+    } /* else */
+} /* handle_sending */
+
+
+static void accept_conns(void)
+{
+    while (1)
+    {
+        struct sockaddr_in addr;
+        socklen_t len = (socklen_t) sizeof (addr);
+        Conn *c;
+        int s = accept(listensocket, (struct sockaddr *) &addr, &len);
+        if (s < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+                (errno != EINTR))
+                printf("accept() failed: %s\n", strerror(errno));
+            return;  /* out of fds is no reason to stop serving the rest. */
+        } /* if */
+
+        c = (Conn *) calloc(1, sizeof (Conn));
+        if ((c == NULL) || (!set_nonblocking(s)) ||
+            (!poller_watch(s, c, WANT_READ, 1)))
+        {
+            printf("couldn't take a new connection.\n");
+            free(c);
+            close(s);
+            continue;
+        } /* if */
+
+        c->sock = s;
+        c->state = CONN_READING;
+        strncpy(c->ipstr, inet_ntoa(addr.sin_addr), sizeof (c->ipstr));
+        c->ipstr[sizeof (c->ipstr) - 1] = '\0';
+    } /* while */
+} /* accept_conns */
+
+
+/* Take back every connection the workers are done with. */
+static void collect_done(void)
+{
+    Conn *c;
+    char junk[64];
+
+    while (read(wakepipe[0], junk, sizeof (junk)) > 0) { /* drain it. */ }
+
+    pthread_mutex_lock(&poolLock);
+    c = doneList;
+    doneList = NULL;
+    pthread_mutex_unlock(&poolLock);
+
+    while (c != NULL)
+    {
+        Conn *next = c->next;
+        c->state = CONN_SENDING;
+        handle_sending(c);
+        c = next;
+    } /* while */
+} /* collect_done */
+
+
+static void serve_forever(void)
+{
+    static PollEvent events[MAX_EVENTS];
+
+    while (!quitRequested)
+    {
+        int woke = 0;
+        int i;
+        const int rc = poller_wait(events, MAX_EVENTS);
+        if ((rc < 0) && (errno != EINTR))
+        {
+            printf("waiting for events failed: %s\n", strerror(errno));
+            return;
+        } /* if */
+
+        for (i = 0; i < rc; i++)
+        {
+            Conn *c = (Conn *) events[i].data;
+            if (c == NULL)
+                accept_conns();
+            else if (events[i].data == (void *) wakepipe)
+                woke = 1;
+            else if (c->state == CONN_READING)
+                handle_reading(c, events[i].readable);
+            else if ((c->state == CONN_SENDING) && (events[i].writable))
+                handle_sending(c);
+            /* CONN_WORKING belongs to a worker; CONN_DEAD is gone. */
+        } /* for */
+
+        /* after the rest, so nothing in this batch refers to a freed one. */
+        if (woke)
+            collect_done();
+        free_dead_conns();
+    } /* while */
+} /* serve_forever */
 
 
 static int create_listen_socket(short portnum)
@@ -191,11 +1133,16 @@ static int create_listen_socket(short portnum)
     if (retval >= 0)
     {
         struct sockaddr_in addr;
+        const int on = 1;
+        setsockopt(retval, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+        memset(&addr, '\0', sizeof (addr));
         addr.sin_family = AF_INET;
         addr.sin_port = htons(portnum);
         addr.sin_addr.s_addr = INADDR_ANY;
-        if ((bind(retval, &addr, (socklen_t) sizeof (addr)) == -1) ||
-            (listen(retval, 5) == -1))
+        if ((bind(retval, (struct sockaddr *) &addr,
+                  (socklen_t) sizeof (addr)) == -1) ||
+            (listen(retval, LISTEN_BACKLOG) == -1) ||
+            (!set_nonblocking(retval)))
         {
             close(retval);
             retval = -1;
@@ -206,86 +1153,107 @@ static int create_listen_socket(short portnum)
 } /* create_listen_socket */
 
 
-static int listensocket = -1;
-
 void at_exit_cleanup(void)
 {
-    /*
-     * !!! FIXME: If thread support, signal threads to terminate and
-     * !!! FIXME:  wait for them to clean up.
-     */
+    stop_workers();  /* nobody's reading when PhysicsFS goes away. */
 
     if (listensocket >= 0)
         close(listensocket);
 
     if (!PHYSFS_deinit())
-        printf("PHYSFS_deinit() failed: %s\n", PHYSFS_getLastError());
+    {
+        printf("PHYSFS_deinit() failed: %s\n",
+               PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    } /* if */
 } /* at_exit_cleanup */
 
 
+#ifndef LACKING_SIGNALS
+static void request_quit(int sig)
+{
+    (void) sig;
+    quitRequested = 1;  /* the wait for events returns, and we're done. */
+} /* request_quit */
+#endif
+
+
 int main(int argc, char **argv)
 {
     int i;
     int portnum = DEFAULT_PORTNUM;
+    int threads = DEFAULT_THREADS;
 
     setbuf(stdout, NULL);
     setbuf(stderr, NULL);
 
 #ifndef LACKING_SIGNALS
-    /* I'm not sure if this qualifies as a cheap trick... */
-    signal(SIGTERM, exit);
-    signal(SIGINT, exit);
+    signal(SIGTERM, request_quit);
+    signal(SIGINT, request_quit);
+    signal(SIGPIPE, SIG_IGN);  /* a client hanging up isn't fatal. */
     signal(SIGFPE, exit);
     signal(SIGSEGV, exit);
-    signal(SIGPIPE, exit);
     signal(SIGILL, exit);
 #endif
 
-    if (argc == 1)
+    for (i = 1; (i + 1 < argc) && (argv[i][0] == '-'); i += 2)
     {
-        printf("USAGE: %s <archive1> [archive2 [... archiveN]]\n", argv[0]);
+        if (strcmp(argv[i], "-p") == 0)
+            portnum = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-t") == 0)
+            threads = atoi(argv[i + 1]);
+        else
+            break;
+    } /* for */
+
+    if ((i >= argc) || (portnum <= 0) || (portnum > 65535) ||
+        (threads <= 0) || (threads > MAX_THREADS))
+    {
+        printf("USAGE: %s [-p port] [-t threads]"
+               " <archive1> [archive2 [... archiveN]]\n", argv[0]);
         return 42;
     } /* if */
 
     if (!PHYSFS_init(argv[0]))
     {
-        printf("PHYSFS_init() failed: %s\n", PHYSFS_getLastError());
+        printf("PHYSFS_init() failed: %s\n",
+               PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
         return 42;
     } /* if */
 
     /* normally, this is bad practice, but oh well. */
     atexit(at_exit_cleanup);
 
-    for (i = 1; i < argc; i++)
+    for (; i < argc; i++)
     {
-        if (!PHYSFS_addToSearchPath(argv[i], 1))
+        if (!PHYSFS_mount(argv[i], NULL, 1))
             printf(" WARNING: failed to add [%s] to search path.\n", argv[i]);
     } /* else */
 
-    listensocket = create_listen_socket(portnum);
+    listensocket = create_listen_socket((short) portnum);
     if (listensocket < 0)
     {
         printf("listen socket failed to create.\n");
         return 42;
     } /* if */
 
-    while (1)  /* infinite loop for now. */
+    if ((pipe(wakepipe) == -1) || (!set_nonblocking(wakepipe[0])) ||
+        (!poller_init()) ||
+        (!poller_watch(listensocket, NULL, WANT_READ, 1)) ||
+        (!poller_watch(wakepipe[0], wakepipe, WANT_READ, 1)))
     {
-        struct sockaddr addr;
-        socklen_t len;
-        int s = accept(listensocket, &addr, &len);
-        if (s < 0)
-        {
-            printf("accept() failed: %s\n", strerror(errno));
-            close(listensocket);
-            return 42;
-        } /* if */
+        printf("couldn't set up to wait for events: %s\n", strerror(errno));
+        return 42;
+    } /* if */
 
-        serve_http_request(s, &addr, len);
-    } /* while */
+    if (!start_workers(threads))
+    {
+        printf("couldn't start any worker threads.\n");
+        return 42;
+    } /* if */
 
-    return 0;
+    printf("serving on port %d with %d threads.\n", portnum, numWorkers);
+    serve_forever();
+    return 0;  /* at_exit_cleanup() does the rest. */
 } /* main */
 
 /* end of physfshttpd.c ... */
-
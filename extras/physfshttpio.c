@@ -0,0 +1,1047 @@
+/*
+ * This code provides a PHYSFS_Io that reads a file off a web server with
+ *  HTTP range requests. Please see physfshttpio.h for details.
+ *
+ * Every duplicate() of an Io shares one HttpShared: the block cache, the
+ *  idle connections and the read-ahead threads. A block in the cache is
+ *  FREE, LOADING (someone has a request out for it) or READY. Readers that
+ *  want a LOADING block wait for it rather than asking again, so a block
+ *  is only ever fetched once while it's cached.
+ *
+ * Command line I used to build this on Linux, with physfshttpd serving the
+ *  other end:
+ *  gcc -Wall -Werror -g -c extras/physfshttpio.c -Isrc
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#include "physfshttpio.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  /* hope the app ignores SIGPIPE, then. */
+#endif
+
+#define HTTPIO_DEFAULT_BLOCKSIZE (64 * 1024)
+#define HTTPIO_DEFAULT_CACHEBLOCKS 256
+#define HTTPIO_DEFAULT_READAHEAD 4
+#define HTTPIO_DEFAULT_THREADS 2
+#define HTTPIO_DEFAULT_CONNECTIONS 4
+
+/* most blocks one request asks for; runs longer than this are split. */
+#define HTTPIO_MAXRUN 32
+
+/* response headers have to fit in this, and so does anything after them. */
+#define HTTPIO_HEADERMAX 8192
+
+typedef struct
+{
+    int fd;
+    size_t avail;  /* bytes in (buf) past the headers, not consumed yet. */
+    size_t pos;  /* where those start. */
+    char buf[HTTPIO_HEADERMAX];
+} HttpConn;
+
+typedef enum
+{
+    SLOT_FREE,
+    SLOT_LOADING,
+    SLOT_READY
+} SlotState;
+
+typedef struct
+{
+    PHYSFS_uint64 block;
+    PHYSFS_uint64 used;  /* (tick) when last read from; lowest is evicted. */
+    PHYSFS_uint8 *data;  /* allocated the first time the slot is used. */
+    SlotState state;
+} Slot;
+
+typedef struct
+{
+    PHYSFS_uint64 first;
+    PHYSFS_uint32 count;
+} Run;
+
+typedef struct
+{
+    char *host;
+    char *port;
+    char *path;
+    PHYSFS_uint64 length;
+    PHYSFS_uint64 blocks;
+    PHYSFSHTTPIO_Config config;
+    pthread_mutex_t lock;
+    pthread_cond_t loaded;  /* some slot left SLOT_LOADING. */
+    pthread_cond_t work;  /* a read-ahead run was queued, or we're quitting. */
+    Slot *slots;
+    PHYSFS_uint64 tick;
+    Run *runs;  /* read-ahead queue; each run holds a slot, so it can't fill. */
+    PHYSFS_uint32 runhead;
+    PHYSFS_uint32 runcount;
+    HttpConn **idle;
+    PHYSFS_uint32 idlecount;
+    pthread_t *threads;
+    PHYSFS_uint32 threadcount;
+    int quitting;
+    int refcount;
+} HttpShared;
+
+typedef struct
+{
+    HttpShared *shared;
+    PHYSFS_uint64 pos;
+} HttpIo;
+
+
+/* Connections... */
+
+static void conn_close(HttpConn *conn)
+{
+    if (conn != NULL)
+    {
+        close(conn->fd);
+        free(conn);
+    } /* if */
+} /* conn_close */
+
+
+static HttpConn *conn_open(const HttpShared *sh)
+{
+    struct addrinfo hints;
+    struct addrinfo *addrs = NULL;
+    struct addrinfo *ai;
+    HttpConn *conn;
+    int fd = -1;
+
+    memset(&hints, '\0', sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(sh->host, sh->port, &hints, &addrs) != 0)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+        return NULL;
+    } /* if */
+
+    for (ai = addrs; ai != NULL; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1)
+            continue;
+        else if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    } /* for */
+    freeaddrinfo(addrs);
+
+    if (fd == -1)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_IO);
+        return NULL;
+    } /* if */
+
+    conn = (HttpConn *) malloc(sizeof (HttpConn));
+    if (conn == NULL)
+    {
+        close(fd);
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return NULL;
+    } /* if */
+
+    {
+        const int one = 1;  /* requests are small; don't let Nagle sit on them. */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    }
+
+    conn->fd = fd;
+    conn->avail = conn->pos = 0;
+    return conn;
+} /* conn_open */
+
+
+/* an idle keep-alive connection, or NULL if there isn't one. */
+static HttpConn *conn_take(HttpShared *sh)
+{
+    HttpConn *retval = NULL;
+    pthread_mutex_lock(&sh->lock);
+    if (sh->idlecount > 0)
+        retval = sh->idle[--sh->idlecount];
+    pthread_mutex_unlock(&sh->lock);
+    return retval;
+} /* conn_take */
+
+
+static void conn_give(HttpShared *sh, HttpConn *conn)
+{
+    pthread_mutex_lock(&sh->lock);
+    if (sh->idlecount < sh->config.connections)
+    {
+        sh->idle[sh->idlecount++] = conn;
+        conn = NULL;
+    } /* if */
+    pthread_mutex_unlock(&sh->lock);
+    conn_close(conn);  /* pool's full. */
+} /* conn_give */
+
+
+static int conn_send(HttpConn *conn, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        const ssize_t rc = send(conn->fd, buf, len, MSG_NOSIGNAL);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        } /* if */
+        buf += rc;
+        len -= (size_t) rc;
+    } /* while */
+    return 1;
+} /* conn_send */
+
+
+/* recv() into (buf), retrying on EINTR. 0 at EOF, -1 on error. */
+static ssize_t conn_recv(HttpConn *conn, void *buf, size_t len)
+{
+    ssize_t rc;
+    do
+    {
+        rc = recv(conn->fd, buf, len, 0);
+    } while ((rc < 0) && (errno == EINTR));
+    return rc;
+} /* conn_recv */
+
+
+/* HTTP... */
+
+static const char *header_value(const char *headers, const char *name)
+{
+    const size_t namelen = strlen(name);
+    const char *line = strstr(headers, "\r\n");
+
+    while ((line != NULL) && (line[2] != '\r'))
+    {
+        line += 2;
+        if ((strncasecmp(line, name, namelen) == 0) && (line[namelen] == ':'))
+        {
+            line += namelen + 1;
+            while ((*line == ' ') || (*line == '\t'))
+                line++;
+            return line;
+        } /* if */
+        line = strstr(line, "\r\n");
+    } /* while */
+
+    return NULL;
+} /* header_value */
+
+
+/*
+ * Ask for (len) bytes from (offset) and read them into (iov), which has
+ *  room for all of them. (*got) gets how many the server sent, which is
+ *  fewer only past the end of the file, and (*total) the file's length,
+ *  from Content-Range.
+ *
+ * Returns 1 on success, 0 on an error worth reporting, and -1 if the
+ *  connection died before a response started, which is what a server
+ *  timing out an idle keep-alive connection looks like. (*keep) says if
+ *  the connection can take another request.
+ */
+static int http_get_range(const HttpShared *sh, HttpConn *conn,
+                          PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                          const PHYSFS_IoVec *iov, PHYSFS_uint32 count,
+                          PHYSFS_uint64 *got, PHYSFS_uint64 *total, int *keep)
+{
+    char req[1024];
+    char *end = NULL;
+    const char *val;
+    size_t have = 0;
+    long long first = 0, last = 0, size = 0;
+    PHYSFS_uint64 bodylen;
+    PHYSFS_uint64 want;
+    PHYSFS_uint32 i;
+    int status = 0;
+
+    *keep = 0;
+
+    if (snprintf(req, sizeof (req),
+                 "GET %s HTTP/1.1\r\n"
+                 "Host: %s\r\n"
+                 "Range: bytes=%llu-%llu\r\n"
+                 "Connection: keep-alive\r\n"
+                 "\r\n", sh->path, sh->host, (unsigned long long) offset,
+                 (unsigned long long) (offset + len - 1)) >= (int) sizeof (req))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_BAD_FILENAME);  /* path's too long. */
+        return 0;
+    } /* if */
+
+    if (!conn_send(conn, req, strlen(req)))
+        return -1;
+
+    /* read until the headers are all here. */
+    while (end == NULL)
+    {
+        ssize_t br;
+        if (have >= sizeof (conn->buf) - 1)
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* absurd headers. */
+            return 0;
+        } /* if */
+
+        br = conn_recv(conn, conn->buf + have, sizeof (conn->buf) - 1 - have);
+        if (br <= 0)
+        {
+            if (have == 0)
+                return -1;
+            PHYSFS_setErrorCode(PHYSFS_ERR_IO);
+            return 0;
+        } /* if */
+
+        have += (size_t) br;
+        conn->buf[have] = '\0';
+        end = strstr(conn->buf, "\r\n\r\n");
+    } /* while */
+
+    end[2] = '\0';  /* headers end with the last "\r\n" now. */
+    conn->pos = (size_t) ((end + 4) - conn->buf);
+    conn->avail = have - conn->pos;
+
+    if (sscanf(conn->buf, "HTTP/1.%*d %d", &status) != 1)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+        return 0;
+    } /* if */
+
+    val = header_value(conn->buf, "Content-Range");
+
+    if (status == 416)  /* nothing at (offset). Empty file? */
+    {
+        if ((val == NULL) || (sscanf(val, "bytes */%lld", &size) != 1))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_PAST_EOF);
+            return 0;
+        } /* if */
+        *got = 0;
+        *total = (PHYSFS_uint64) size;
+        return 1;  /* (*keep) is 0; we didn't read whatever body it had. */
+    } /* if */
+
+    else if (status != 206)
+    {
+        /* 200 means the whole file is coming, because ranges don't work. */
+        PHYSFS_setErrorCode((status == 404) ? PHYSFS_ERR_NOT_FOUND :
+                            (status == 403) ? PHYSFS_ERR_PERMISSION :
+                                              PHYSFS_ERR_UNSUPPORTED);
+        return 0;
+    } /* else if */
+
+    if ((val == NULL) ||
+        (sscanf(val, "bytes %lld-%lld/%lld", &first, &last, &size) != 3) ||
+        ((PHYSFS_uint64) first != offset) || (last < first) || (size <= last))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+        return 0;
+    } /* if */
+
+    bodylen = (PHYSFS_uint64) (last - first + 1);
+    want = ((PHYSFS_uint64) size - offset < len) ?
+                (PHYSFS_uint64) size - offset : len;
+    val = header_value(conn->buf, "Transfer-Encoding");
+    if ((bodylen != want) || ((val != NULL) && (strncasecmp(val, "identity", 8))))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+        return 0;
+    } /* if */
+
+    /* the body: first what came in with the headers, then straight in. */
+    for (i = 0; (i < count) && (want > 0); i++)
+    {
+        PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) iov[i].buf;
+        PHYSFS_uint64 room = (iov[i].len < want) ? iov[i].len : want;
+        want -= room;
+
+        while (room > 0)
+        {
+            ssize_t br;
+            if (conn->avail > 0)
+            {
+                br = (ssize_t) ((conn->avail < room) ? conn->avail : room);
+                memcpy(ptr, conn->buf + conn->pos, (size_t) br);
+                conn->pos += (size_t) br;
+                conn->avail -= (size_t) br;
+            } /* if */
+            else
+            {
+                br = conn_recv(conn, ptr, (size_t) room);
+                if (br <= 0)
+                {
+                    PHYSFS_setErrorCode(PHYSFS_ERR_IO);
+                    return 0;
+                } /* if */
+            } /* else */
+            ptr += br;
+            room -= (PHYSFS_uint64) br;
+        } /* while */
+    } /* for */
+
+    val = header_value(conn->buf, "Connection");
+    *keep = ((conn->avail == 0) &&
+             ((val == NULL) || (strncasecmp(val, "close", 5) != 0)));
+    *got = bodylen;
+    *total = (PHYSFS_uint64) size;
+    return 1;
+} /* http_get_range */
+
+
+/* http_get_range() on a pooled connection, or a new one if that fails. */
+static int fetch_range(HttpShared *sh, PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                       const PHYSFS_IoVec *iov, PHYSFS_uint32 count,
+                       PHYSFS_uint64 *got, PHYSFS_uint64 *total)
+{
+    int attempt;
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        HttpConn *conn = (attempt == 0) ? conn_take(sh) : NULL;
+        const int reused = (conn != NULL);
+        int keep = 0;
+        int rc;
+
+        if (!reused)
+        {
+            conn = conn_open(sh);
+            if (conn == NULL)
+                return 0;
+        } /* if */
+
+        rc = http_get_range(sh, conn, offset, len, iov, count,
+                            got, total, &keep);
+        if (keep)
+            conn_give(sh, conn);
+        else
+            conn_close(conn);
+
+        if (rc == 1)
+            return 1;
+        else if ((rc == 0) || (!reused))
+            break;
+        /* else a stale keep-alive connection; try once more on a new one. */
+    } /* for */
+
+    if (PHYSFS_getLastErrorCode() == PHYSFS_ERR_OK)
+        PHYSFS_setErrorCode(PHYSFS_ERR_IO);
+    return 0;
+} /* fetch_range */
+
+
+/* The block cache... */
+
+static PHYSFS_uint32 block_len(const HttpShared *sh, PHYSFS_uint64 block)
+{
+    const PHYSFS_uint64 start = block * sh->config.blockSize;
+    const PHYSFS_uint64 left = sh->length - start;
+    return (left < sh->config.blockSize) ? (PHYSFS_uint32) left :
+                                           sh->config.blockSize;
+} /* block_len */
+
+
+/*
+ * (block)'s slot, or NULL. The cache is a few hundred slots and every miss
+ *  costs a round trip, so a scan is plenty. Lock held.
+ */
+static Slot *find_slot(const HttpShared *sh, PHYSFS_uint64 block)
+{
+    PHYSFS_uint32 i;
+    for (i = 0; i < sh->config.cacheBlocks; i++)
+    {
+        Slot *slot = &sh->slots[i];
+        if ((slot->state != SLOT_FREE) && (slot->block == block))
+            return slot;
+    } /* for */
+    return NULL;
+} /* find_slot */
+
+
+/* Mark a free or least-recently-read slot LOADING for (block). Lock held. */
+static Slot *reserve_slot(HttpShared *sh, PHYSFS_uint64 block)
+{
+    Slot *victim = NULL;
+    PHYSFS_uint32 i;
+
+    for (i = 0; i < sh->config.cacheBlocks; i++)
+    {
+        Slot *slot = &sh->slots[i];
+        if (slot->state == SLOT_FREE)
+        {
+            victim = slot;
+            break;
+        } /* if */
+        else if ((slot->state == SLOT_READY) &&
+                 ((victim == NULL) || (slot->used < victim->used)))
+        {
+            victim = slot;
+        } /* else if */
+    } /* for */
+
+    if (victim == NULL)
+        return NULL;  /* everything's loading. */
+
+    if (victim->data == NULL)
+    {
+        victim->data = (PHYSFS_uint8 *) malloc(sh->config.blockSize);
+        if (victim->data == NULL)
+            return NULL;
+    } /* if */
+
+    victim->block = block;
+    victim->state = SLOT_LOADING;
+    return victim;
+} /* reserve_slot */
+
+
+/*
+ * Reserve slots for (block) onward, stopping at (last), at a block that's
+ *  already cached or loading, or at HTTPIO_MAXRUN. Returns how many. Lock
+ *  held.
+ */
+static PHYSFS_uint32 reserve_run(HttpShared *sh, PHYSFS_uint64 block,
+                                 PHYSFS_uint64 last)
+{
+    PHYSFS_uint32 retval = 0;
+
+    if (last >= sh->blocks)
+        last = sh->blocks - 1;
+
+    while ((block + retval <= last) && (retval < HTTPIO_MAXRUN))
+    {
+        if (find_slot(sh, block + retval) != NULL)
+            break;
+        else if (reserve_slot(sh, block + retval) == NULL)
+            break;
+        retval++;
+    } /* while */
+
+    return retval;
+} /* reserve_run */
+
+
+/* Fetch a run of reserved blocks and mark them READY (or FREE). */
+static int load_run(HttpShared *sh, PHYSFS_uint64 first, PHYSFS_uint32 count)
+{
+    PHYSFS_IoVec iov[HTTPIO_MAXRUN];
+    PHYSFS_uint64 len = 0;
+    PHYSFS_uint64 got = 0;
+    PHYSFS_uint64 total = 0;
+    PHYSFS_uint32 i;
+    int ok;
+
+    /* only the loader touches LOADING slots, so these are ours to fill. */
+    pthread_mutex_lock(&sh->lock);
+    for (i = 0; i < count; i++)
+    {
+        iov[i].buf = find_slot(sh, first + i)->data;
+        iov[i].len = block_len(sh, first + i);
+        len += iov[i].len;
+    } /* for */
+    pthread_mutex_unlock(&sh->lock);
+
+    ok = fetch_range(sh, first * sh->config.blockSize, len, iov, count,
+                     &got, &total);
+    if ((ok) && ((got != len) || (total != sh->length)))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* it changed under us! */
+        ok = 0;
+    } /* if */
+
+    pthread_mutex_lock(&sh->lock);
+    for (i = 0; i < count; i++)
+    {
+        Slot *slot = find_slot(sh, first + i);
+        slot->state = ok ? SLOT_READY : SLOT_FREE;
+        slot->used = ++sh->tick;
+    } /* for */
+    pthread_cond_broadcast(&sh->loaded);
+    pthread_mutex_unlock(&sh->lock);
+
+    return ok;
+} /* load_run */
+
+
+/* Queue the blocks from (block) on for the read-ahead threads. Lock held. */
+static void queue_read_ahead(HttpShared *sh, PHYSFS_uint64 block)
+{
+    PHYSFS_uint32 count;
+    Run *run;
+
+    if ((sh->threadcount == 0) || (block >= sh->blocks))
+        return;
+
+    count = reserve_run(sh, block, block + sh->config.readAhead - 1);
+    if (count == 0)
+        return;
+
+    run = &sh->runs[(sh->runhead + sh->runcount) % sh->config.cacheBlocks];
+    run->first = block;
+    run->count = count;
+    sh->runcount++;
+    pthread_cond_signal(&sh->work);
+} /* queue_read_ahead */
+
+
+static void *read_ahead_thread(void *_sh)
+{
+    HttpShared *sh = (HttpShared *) _sh;
+
+    pthread_mutex_lock(&sh->lock);
+    while (!sh->quitting)
+    {
+        Run run;
+        if (sh->runcount == 0)
+        {
+            pthread_cond_wait(&sh->work, &sh->lock);
+            continue;
+        } /* if */
+
+        run = sh->runs[sh->runhead];
+        sh->runhead = (sh->runhead + 1) % sh->config.cacheBlocks;
+        sh->runcount--;
+        pthread_mutex_unlock(&sh->lock);
+
+        load_run(sh, run.first, run.count);  /* readers will retry if it fails. */
+
+        pthread_mutex_lock(&sh->lock);
+    } /* while */
+    pthread_mutex_unlock(&sh->lock);
+
+    return NULL;
+} /* read_ahead_thread */
+
+
+/* The PHYSFS_Io... */
+
+static PHYSFS_sint64 httpIo_readAt(PHYSFS_Io *io, void *_buf,
+                                   PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    HttpShared *sh = ((HttpIo *) io->opaque)->shared;
+    const PHYSFS_uint32 bs = sh->config.blockSize;
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) _buf;
+    PHYSFS_uint64 done = 0;
+
+    if (offset >= sh->length)
+        return 0;
+    else if (len > sh->length - offset)
+        len = sh->length - offset;
+
+    pthread_mutex_lock(&sh->lock);
+    while (done < len)
+    {
+        const PHYSFS_uint64 pos = offset + done;
+        const PHYSFS_uint64 block = pos / bs;
+        Slot *slot = find_slot(sh, block);
+        PHYSFS_uint32 count;
+
+        if ((slot != NULL) && (slot->state == SLOT_READY))
+        {
+            const PHYSFS_uint32 from = (PHYSFS_uint32) (pos % bs);
+            const PHYSFS_uint64 avail = block_len(sh, block) - from;
+            const PHYSFS_uint64 cpy = (avail < len - done) ? avail : len - done;
+            memcpy(buf + done, slot->data + from, (size_t) cpy);
+            slot->used = ++sh->tick;
+            done += cpy;
+            continue;
+        } /* if */
+
+        else if (slot != NULL)  /* somebody's fetching it already. */
+        {
+            pthread_cond_wait(&sh->loaded, &sh->lock);
+            continue;
+        } /* else if */
+
+        count = reserve_run(sh, block, (offset + len - 1) / bs);
+        if (count == 0)  /* every slot's loading. Wait for one. */
+        {
+            pthread_cond_wait(&sh->loaded, &sh->lock);
+            continue;
+        } /* if */
+
+        queue_read_ahead(sh, block + count);
+        pthread_mutex_unlock(&sh->lock);
+        if (!load_run(sh, block, count))
+            return (done > 0) ? (PHYSFS_sint64) done : -1;
+        pthread_mutex_lock(&sh->lock);
+    } /* while */
+    pthread_mutex_unlock(&sh->lock);
+
+    return (PHYSFS_sint64) done;
+} /* httpIo_readAt */
+
+
+static PHYSFS_sint64 httpIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
+{
+    HttpIo *info = (HttpIo *) io->opaque;
+    const PHYSFS_sint64 rc = httpIo_readAt(io, buf, len, info->pos);
+    if (rc > 0)
+        info->pos += (PHYSFS_uint64) rc;
+    return rc;
+} /* httpIo_read */
+
+
+static PHYSFS_sint64 httpIo_write(PHYSFS_Io *io, const void *buf,
+                                  PHYSFS_uint64 len)
+{
+    (void) io; (void) buf; (void) len;
+    PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+    return -1;
+} /* httpIo_write */
+
+
+static int httpIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    HttpIo *info = (HttpIo *) io->opaque;
+    if (offset > info->shared->length)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_PAST_EOF);
+        return 0;
+    } /* if */
+    info->pos = offset;
+    return 1;
+} /* httpIo_seek */
+
+
+static PHYSFS_sint64 httpIo_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((HttpIo *) io->opaque)->pos;
+} /* httpIo_tell */
+
+
+static PHYSFS_sint64 httpIo_length(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((HttpIo *) io->opaque)->shared->length;
+} /* httpIo_length */
+
+
+static int httpIo_flush(PHYSFS_Io *io)
+{
+    (void) io;
+    return 1;  /* nothing to flush. */
+} /* httpIo_flush */
+
+
+static void shared_release(HttpShared *sh)
+{
+    PHYSFS_uint32 i;
+    int last;
+
+    pthread_mutex_lock(&sh->lock);
+    last = (--sh->refcount == 0);
+    if (last)
+    {
+        sh->quitting = 1;
+        pthread_cond_broadcast(&sh->work);
+    } /* if */
+    pthread_mutex_unlock(&sh->lock);
+
+    if (!last)
+        return;
+
+    /* a thread in the middle of a fetch finishes it first. */
+    for (i = 0; i < sh->threadcount; i++)
+        pthread_join(sh->threads[i], NULL);
+
+    for (i = 0; i < sh->idlecount; i++)
+        conn_close(sh->idle[i]);
+
+    if (sh->slots != NULL)
+    {
+        for (i = 0; i < sh->config.cacheBlocks; i++)
+            free(sh->slots[i].data);
+    } /* if */
+
+    pthread_cond_destroy(&sh->work);
+    pthread_cond_destroy(&sh->loaded);
+    pthread_mutex_destroy(&sh->lock);
+    free(sh->threads);
+    free(sh->idle);
+    free(sh->runs);
+    free(sh->slots);
+    free(sh->host);
+    free(sh->port);
+    free(sh->path);
+    free(sh);
+} /* shared_release */
+
+
+static PHYSFS_Io *create_io(HttpShared *sh);
+
+static PHYSFS_Io *httpIo_duplicate(PHYSFS_Io *io)
+{
+    HttpShared *sh = ((HttpIo *) io->opaque)->shared;
+    PHYSFS_Io *retval;
+
+    pthread_mutex_lock(&sh->lock);
+    sh->refcount++;
+    pthread_mutex_unlock(&sh->lock);
+
+    retval = create_io(sh);
+    if (retval == NULL)
+        shared_release(sh);
+    return retval;
+} /* httpIo_duplicate */
+
+
+static void httpIo_destroy(PHYSFS_Io *io)
+{
+    HttpIo *info = (HttpIo *) io->opaque;
+    shared_release(info->shared);
+    free(info);
+    free(io);
+} /* httpIo_destroy */
+
+
+static const PHYSFS_Io httpIoInterface =
+{
+    1,  /* map() and readAt() are there; readv() and later aren't. */
+    NULL,
+    httpIo_read,
+    httpIo_write,
+    httpIo_seek,
+    httpIo_tell,
+    httpIo_length,
+    httpIo_duplicate,
+    httpIo_flush,
+    httpIo_destroy,
+    NULL,  /* map: nothing's in memory for long. */
+    httpIo_readAt,
+    NULL,  /* readv */
+    NULL,  /* advise */
+    NULL,  /* backing */
+    NULL   /* raw */
+};
+
+
+/* a new Io on (sh), which already counts it in (refcount). */
+static PHYSFS_Io *create_io(HttpShared *sh)
+{
+    PHYSFS_Io *io = (PHYSFS_Io *) malloc(sizeof (PHYSFS_Io));
+    HttpIo *info = (HttpIo *) malloc(sizeof (HttpIo));
+
+    if ((io == NULL) || (info == NULL))
+    {
+        free(io);
+        free(info);
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return NULL;
+    } /* if */
+
+    memcpy(io, &httpIoInterface, sizeof (*io));
+    io->opaque = info;
+    info->shared = sh;
+    info->pos = 0;
+    return io;
+} /* create_io */
+
+
+static char *dup_range(const char *str, size_t len)
+{
+    char *retval = (char *) malloc(len + 1);
+    if (retval != NULL)
+    {
+        memcpy(retval, str, len);
+        retval[len] = '\0';
+    } /* if */
+    return retval;
+} /* dup_range */
+
+
+/* split "http://host[:port]/path" into (sh). */
+static int parse_url(HttpShared *sh, const char *url)
+{
+    const char *host;
+    const char *path;
+    const char *port;
+
+    if (strncasecmp(url, "http://", 7) != 0)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+        return 0;
+    } /* if */
+
+    host = url + 7;
+    path = strchr(host, '/');
+    if (path == NULL)
+        path = host + strlen(host);
+
+    port = (const char *) memchr(host, ':', (size_t) (path - host));
+    if ((port == host) || (port == path - 1))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_BAD_FILENAME);
+        return 0;
+    } /* if */
+
+    if (port == NULL)
+    {
+        sh->host = dup_range(host, (size_t) (path - host));
+        sh->port = dup_range("80", 2);
+    } /* if */
+    else
+    {
+        sh->host = dup_range(host, (size_t) (port - host));
+        sh->port = dup_range(port + 1, (size_t) (path - (port + 1)));
+    } /* else */
+    sh->path = (*path == '\0') ? dup_range("/", 1) : dup_range(path, strlen(path));
+
+    if ((sh->host == NULL) || (sh->port == NULL) || (sh->path == NULL))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return 0;
+    } /* if */
+    else if (*sh->host == '\0')
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_BAD_FILENAME);
+        return 0;
+    } /* else if */
+
+    return 1;
+} /* parse_url */
+
+
+/* fetch block 0, which tells us how long the file is. */
+static int probe_length(HttpShared *sh)
+{
+    Slot *slot = &sh->slots[0];
+    PHYSFS_IoVec iov;
+    PHYSFS_uint64 got = 0;
+
+    slot->data = (PHYSFS_uint8 *) malloc(sh->config.blockSize);
+    if (slot->data == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return 0;
+    } /* if */
+
+    iov.buf = slot->data;
+    iov.len = sh->config.blockSize;
+    if (!fetch_range(sh, 0, sh->config.blockSize, &iov, 1, &got, &sh->length))
+        return 0;
+
+    sh->blocks = (sh->length + sh->config.blockSize - 1) / sh->config.blockSize;
+    if (got > 0)
+    {
+        slot->block = 0;
+        slot->state = SLOT_READY;
+        slot->used = ++sh->tick;
+    } /* if */
+
+    return 1;
+} /* probe_length */
+
+
+PHYSFS_Io *PHYSFSHTTPIO_createIo(const char *url,
+                                 const PHYSFSHTTPIO_Config *config)
+{
+    HttpShared *sh;
+    PHYSFS_Io *retval;
+    PHYSFS_uint32 i;
+
+    if (url == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_INVALID_ARGUMENT);
+        return NULL;
+    } /* if */
+
+    sh = (HttpShared *) calloc(1, sizeof (HttpShared));
+    if (sh == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        return NULL;
+    } /* if */
+
+    if (config != NULL)
+        sh->config = *config;
+    if (sh->config.blockSize == 0)
+        sh->config.blockSize = HTTPIO_DEFAULT_BLOCKSIZE;
+    if (sh->config.cacheBlocks == 0)
+        sh->config.cacheBlocks = HTTPIO_DEFAULT_CACHEBLOCKS;
+    if (sh->config.readAhead == 0)
+        sh->config.readAhead = HTTPIO_DEFAULT_READAHEAD;
+    if (sh->config.threads == 0)
+        sh->config.threads = HTTPIO_DEFAULT_THREADS;
+    if (sh->config.connections == 0)
+        sh->config.connections = HTTPIO_DEFAULT_CONNECTIONS;
+
+    /* a read needs a run's worth of slots, plus room for read-ahead. */
+    if (sh->config.readAhead > HTTPIO_MAXRUN)
+        sh->config.readAhead = HTTPIO_MAXRUN;
+    if (sh->config.cacheBlocks < HTTPIO_MAXRUN + sh->config.readAhead)
+        sh->config.cacheBlocks = HTTPIO_MAXRUN + sh->config.readAhead;
+
+    pthread_mutex_init(&sh->lock, NULL);
+    pthread_cond_init(&sh->loaded, NULL);
+    pthread_cond_init(&sh->work, NULL);
+    sh->refcount = 1;
+
+    sh->slots = (Slot *) calloc(sh->config.cacheBlocks, sizeof (Slot));
+    sh->runs = (Run *) malloc(sh->config.cacheBlocks * sizeof (Run));
+    sh->idle = (HttpConn **) malloc(sh->config.connections * sizeof (HttpConn *));
+    sh->threads = (pthread_t *) malloc(sh->config.threads * sizeof (pthread_t));
+    if ((!sh->slots) || (!sh->runs) || (!sh->idle) || (!sh->threads))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        shared_release(sh);
+        return NULL;
+    } /* if */
+
+    if ((!parse_url(sh, url)) || (!probe_length(sh)))
+    {
+        shared_release(sh);
+        return NULL;
+    } /* if */
+
+    for (i = 0; i < sh->config.threads; i++)
+    {
+        if (pthread_create(&sh->threads[i], NULL, read_ahead_thread, sh) != 0)
+            break;  /* fewer threads is fine; none just means no read-ahead. */
+        sh->threadcount++;
+    } /* for */
+
+    retval = create_io(sh);
+    if (retval == NULL)
+        shared_release(sh);
+    return retval;
+} /* PHYSFSHTTPIO_createIo */
+
+
+int PHYSFSHTTPIO_mount(const char *url, const char *mountPoint,
+                       int appendToPath)
+{
+    PHYSFS_Io *io = PHYSFSHTTPIO_createIo(url, NULL);
+    if (io == NULL)
+        return 0;
+
+    /* PHYSFS_mountIo() leaves (io) to us if it fails. */
+    if (!PHYSFS_mountIo(io, url, mountPoint, appendToPath))
+    {
+        io->destroy(io);
+        return 0;
+    } /* if */
+
+    return 1;
+} /* PHYSFSHTTPIO_mount */
+
+/* end of physfshttpio.c ... */
+
@@ -0,0 +1,81 @@
+/*
+ * This code provides a PHYSFS_Io that reads a file off a web server with
+ *  HTTP range requests, so archives can be mounted straight from a CDN
+ *  without downloading them first. Only the parts an archiver actually
+ *  touches (the central directory, the entries you open) are fetched.
+ *
+ * It speaks plain HTTP/1.1 over POSIX sockets and threads; put a TLS
+ *  terminator in front of it for https:// origins.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#ifndef _INCLUDE_PHYSFSHTTPIO_H_
+#define _INCLUDE_PHYSFSHTTPIO_H_
+
+#include "physfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * How a PHYSFSHTTPIO_createIo() instance fetches and caches. Zero in any
+ *  field means "use the default".
+ */
+typedef struct PHYSFSHTTPIO_Config
+{
+    PHYSFS_uint32 blockSize;  /**< bytes per request and cache block. 64k. */
+    PHYSFS_uint32 cacheBlocks;  /**< blocks kept in the LRU cache. 256. */
+    PHYSFS_uint32 readAhead;  /**< blocks fetched past a miss. 4. */
+    PHYSFS_uint32 threads;  /**< read-ahead threads. 2. */
+    PHYSFS_uint32 connections;  /**< idle keep-alive connections kept. 4. */
+} PHYSFSHTTPIO_Config;
+
+/**
+ * Make a read-only PHYSFS_Io over the file at (url), which has to look
+ *  like "http://host[:port]/path", on a server that honors "Range:".
+ *
+ * This asks for the first block right away, to learn the file's length,
+ *  so it fails here if the server is unreachable or ignores ranges.
+ *
+ * Reads are served from a block cache. A miss fetches every missing block
+ *  the read needs in one request, then has background threads fetch the
+ *  next (readAhead) blocks on connections of their own, so sequential
+ *  reads usually find their data already there. The cache, threads and
+ *  connections are shared by every duplicate() of the Io, and the Io is
+ *  safe to read from several threads (readAt() doesn't serialize them).
+ *
+ *   @param url The file to read.
+ *   @param config Tuning, or NULL for the defaults.
+ *  @return A new PHYSFS_Io on success, NULL on error. Specifics of the error
+ *           can be gleaned from PHYSFS_getLastErrorCode().
+ */
+PHYSFS_DECL PHYSFS_Io *PHYSFSHTTPIO_createIo(const char *url,
+                                         const PHYSFSHTTPIO_Config *config);
+
+/**
+ * PHYSFSHTTPIO_createIo() with the defaults, then PHYSFS_mountIo() it
+ *  under (url), which is also the name PHYSFS_unmount() wants later.
+ *  The last piece of the URL's path picks the archiver to try first.
+ *
+ *   @param url The archive to mount.
+ *   @param mountPoint Location in the interpolated tree that this archive
+ *                     will be "mounted", in platform-independent notation.
+ *                     NULL or "" is equivalent to "/".
+ *   @param appendToPath nonzero to append to search path, zero to prepend.
+ *  @return nonzero if added to path, zero on failure (bogus archive, server
+ *          not there, etc). Use PHYSFS_getLastErrorCode() to obtain
+ *          the specific error.
+ */
+PHYSFS_DECL int PHYSFSHTTPIO_mount(const char *url, const char *mountPoint,
+                                   int appendToPath);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* include-once blocker */
+
+/* end of physfshttpio.h ... */
+
@@ -0,0 +1,1592 @@
+/*
+ * physfspack: make a PPK or ZIP archive from a directory tree.
+ *
+ * PPK is PhysicsFS's indexed pack format; src/archiver_ppk.c describes it.
+ *  Its prebuilt hash index means mounting it doesn't parse anything. If
+ *  the output file's name ends in ".zip", a ZIP archive is made instead.
+ *
+ * Files go in stored by default, each one's data starting on an "-a"
+ *  boundary (4096 bytes, unless told otherwise), so it can be mapped and
+ *  read without copying. In a ZIP, only stored files are aligned, by
+ *  padding their local headers with an extra field, the way Android's
+ *  zipalign does. Build with -DPHYSFSPACK_LZ4 and -llz4, and/or
+ *  -DPHYSFSPACK_ZSTD and -lzstd, to be able to compress PPK files, or
+ *  -DPHYSFSPACK_ZLIB and -lz to deflate ZIP files; each file is only kept
+ *  compressed if that makes it meaningfully smaller. "-c auto" tries every
+ *  compressor on every file, times decompressing what each one made, and
+ *  keeps whatever gets the file into memory soonest, counting a disk that
+ *  reads "-r" megabytes a second (100, unless told otherwise); stored wins
+ *  if nothing beats it.
+ *
+ * "-p profile.csv" puts files' data in the order that a program first
+ *  opened them, from PHYSFS_writeAccessProfile()'s CSV, so loading becomes
+ *  one long read instead of a lot of seeking. Files it doesn't mention go
+ *  after those that it does, in the order they were found.
+ *
+ * In a PPK, files with identical contents are stored once, and every entry
+ *  gets its content hash, so PhysicsFS can share their decompressed copies
+ *  between archives, too.
+ *
+ * With zstd, "-d bytes" trains a dictionary of up to that many bytes on the
+ *  smaller files and compresses everything with it, which does far better
+ *  than compressing lots of little files on their own. It's stored in the
+ *  archive and loaded once when it's mounted.
+ *
+ *  Usage: physfspack [-c none|auto|lz4|zstd|deflate] [-l level] [-a align]
+ *                    [-d bytes] [-p profile.csv] [-r MB/s]
+ *                    out.ppk|out.zip dir
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "physfs.h"
+
+#ifdef PHYSFSPACK_LZ4
+#include <lz4frame.h>
+#endif
+
+#ifdef PHYSFSPACK_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+#ifdef PHYSFSPACK_ZLIB
+#include <zlib.h>
+#endif
+
+/* these have to match src/archiver_ppk.c. */
+#define PPK_HEADER_LEN 32
+#define PPK_ENTRY_LEN 48
+#define PPK_VERSION 2
+#define PPK_FLAG_DIR 1
+#define PPK_HEADER_HASHES 1
+#define PPK_HASH_LEN 16
+#define PPK_COMP_NONE 0
+#define PPK_COMP_LZ4 1
+#define PPK_COMP_ZSTD 2
+#define PPK_COMP_ZSTD_DICT 3
+
+/* these are from the ZIP spec; see src/archiver_zip.c. */
+#define ZIP_LOCAL_HEADER_LEN 30
+#define ZIP_CENTRAL_RECORD_LEN 46
+#define ZIP_LOCAL_FILE_SIG 0x04034b50
+#define ZIP_CENTRAL_DIR_SIG 0x02014b50
+#define ZIP_END_OF_CENTRAL_DIR_SIG 0x06054b50
+#define ZIP64_END_OF_CENTRAL_DIR_SIG 0x06064b50
+#define ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIG 0x07064b50
+#define ZIP64_EXTRA_SIG 0x0001
+#define ZIP_ALIGN_EXTRA_SIG 0xD935  /* Android's zipalign uses this one. */
+#define ZIP_VERSION 20
+#define ZIP_VERSION_ZIP64 45
+#define ZIP_GENERAL_BITS_UTF8 0x0800
+#define ZIP_MSDOS_DIRECTORY 0x10
+#define ZIP_COMP_DEFLATE 8  /* stored is zero, just like PPK_COMP_NONE. */
+
+/* "-c auto": whichever compressor, if any, reads back the soonest. */
+#define COMP_AUTO -1
+
+/* files bigger than this don't go into training a dictionary. */
+#define DICT_SAMPLE_MAX (128 * 1024)
+
+typedef struct
+{
+    char *path;  /* full path in the archive; "" for the root. */
+    int isdir;
+    PHYSFS_uint64 offset;  /* dirs: first child. */
+    PHYSFS_uint64 size;  /* dirs: number of children. */
+    PHYSFS_uint64 csize;
+    PHYSFS_sint64 modtime;
+    PHYSFS_uint32 nameOffset;
+    PHYSFS_uint32 next;
+    PHYSFS_uint32 crc;  /* ZIP only. */
+    PHYSFS_uint32 order;  /* from the access profile; zero if not in it. */
+    PHYSFS_uint16 compression;
+    int duplicate;  /* non-zero if an earlier file's data is used. */
+    unsigned char hash[PPK_HASH_LEN];
+} PackEntry;
+
+static PackEntry *entries = NULL;
+static PHYSFS_uint32 entryCount = 0;
+static PHYSFS_uint32 entryAlloc = 0;
+
+static int zipOutput = 0;  /* non-zero to make a ZIP instead of a PPK. */
+static int compression = PPK_COMP_NONE;
+static int level = 0;  /* zero means the compressor's default. */
+static double diskRate = 100.0 * 1024.0 * 1024.0;  /* -r, in bytes. */
+static PHYSFS_uint32 alignment = 4096;
+static size_t dictWanted = 0;  /* -d; zero means no dictionary. */
+static void *dict = NULL;
+static PHYSFS_uint32 dictLen = 0;
+
+#ifdef PHYSFSPACK_ZSTD
+static ZSTD_CDict *cdict = NULL;
+#endif
+
+
+static const char *lastError(void)
+{
+    return PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode());
+} /* lastError */
+
+
+/* 32-bit FNV-1a; this has to match src/archiver_ppk.c. */
+static PHYSFS_uint32 hashPath(const char *path)
+{
+    PHYSFS_uint32 hash = 0x811C9DC5;
+    while (*path)
+    {
+        hash ^= (PHYSFS_uint32) (unsigned char) *(path++);
+        hash *= 0x01000193;
+    } /* while */
+    return hash;
+} /* hashPath */
+
+
+static void put16(unsigned char *ptr, PHYSFS_uint16 val)
+{
+    ptr[0] = (unsigned char) (val & 0xFF);
+    ptr[1] = (unsigned char) ((val >> 8) & 0xFF);
+} /* put16 */
+
+
+static void put32(unsigned char *ptr, PHYSFS_uint32 val)
+{
+    put16(ptr, (PHYSFS_uint16) (val & 0xFFFF));
+    put16(ptr + 2, (PHYSFS_uint16) ((val >> 16) & 0xFFFF));
+} /* put32 */
+
+
+static void put64(unsigned char *ptr, PHYSFS_uint64 val)
+{
+    put32(ptr, (PHYSFS_uint32) (val & 0xFFFFFFFF));
+    put32(ptr + 4, (PHYSFS_uint32) ((val >> 32) & 0xFFFFFFFF));
+} /* put64 */
+
+
+static PHYSFS_uint64 get64(const unsigned char *ptr)
+{
+    PHYSFS_uint64 val = 0;
+    int i;
+    for (i = 7; i >= 0; i--)
+        val = (val << 8) | (PHYSFS_uint64) ptr[i];
+    return val;
+} /* get64 */
+
+
+static PHYSFS_uint64 mix64(PHYSFS_uint64 k)
+{
+    k ^= k >> 33;
+    k *= (PHYSFS_uint64) 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    k *= (PHYSFS_uint64) 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33;
+    return k;
+} /* mix64 */
+
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* MurmurHash3 x64_128, zero seed; this has to match src/physfs.c. */
+static void hashContent(const unsigned char *buf, PHYSFS_uint64 len,
+                        unsigned char *hash)
+{
+    const PHYSFS_uint64 c1 = (PHYSFS_uint64) 0x87C37B91114253D5ULL;
+    const PHYSFS_uint64 c2 = (PHYSFS_uint64) 0x4CF5AD432745937FULL;
+    PHYSFS_uint64 remain = len;
+    PHYSFS_uint64 h1 = 0;
+    PHYSFS_uint64 h2 = 0;
+    PHYSFS_uint64 k1, k2;
+    unsigned char tail[16];
+
+    for (; remain >= 16; remain -= 16, buf += 16)
+    {
+        k1 = get64(buf) * c1;
+        k1 = ROTL64(k1, 31) * c2;
+        h1 ^= k1;
+        h1 = ROTL64(h1, 27) + h2;
+        h1 = (h1 * 5) + 0x52DCE729;
+
+        k2 = get64(buf + 8) * c2;
+        k2 = ROTL64(k2, 33) * c1;
+        h2 ^= k2;
+        h2 = ROTL64(h2, 31) + h1;
+        h2 = (h2 * 5) + 0x38495AB5;
+    } /* for */
+
+    memset(tail, '\0', sizeof (tail));
+    memcpy(tail, buf, (size_t) remain);
+    k1 = get64(tail) * c1;
+    h1 ^= ROTL64(k1, 31) * c2;
+    k2 = get64(tail + 8) * c2;
+    h2 ^= ROTL64(k2, 33) * c1;
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = mix64(h1);
+    h2 = mix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    put64(hash, h1);
+    put64(hash + 8, h2);
+} /* hashContent */
+
+#undef ROTL64
+
+
+static int addEntry(const char *path, const PHYSFS_Stat *st)
+{
+    PackEntry *entry;
+
+    if (entryCount == entryAlloc)
+    {
+        const PHYSFS_uint32 newalloc = entryAlloc ? entryAlloc * 2 : 256;
+        void *ptr = realloc(entries, newalloc * sizeof (PackEntry));
+        if (ptr == NULL)
+        {
+            fprintf(stderr, "physfspack: out of memory.\n");
+            return 0;
+        } /* if */
+        entries = (PackEntry *) ptr;
+        entryAlloc = newalloc;
+    } /* if */
+
+    entry = &entries[entryCount];
+    memset(entry, '\0', sizeof (PackEntry));
+    entry->path = (char *) malloc(strlen(path) + 1);
+    if (entry->path == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    strcpy(entry->path, path);
+    entry->isdir = (st->filetype == PHYSFS_FILETYPE_DIRECTORY);
+    entry->modtime = st->modtime;
+    if (!entry->isdir)
+        entry->size = (PHYSFS_uint64) st->filesize;
+    entryCount++;
+    return 1;
+} /* addEntry */
+
+
+static int cmpNames(const void *a, const void *b)
+{
+    return strcmp(*((const char * const *) a), *((const char * const *) b));
+} /* cmpNames */
+
+
+/*
+ * List everything, a directory at a time, so each directory's children
+ *  end up next to each other, sorted, which is what PPK wants.
+ */
+static int gatherEntries(void)
+{
+    PHYSFS_Stat st;
+    PHYSFS_uint32 i;
+
+    memset(&st, '\0', sizeof (st));
+    st.filetype = PHYSFS_FILETYPE_DIRECTORY;
+    st.modtime = -1;
+    if (!addEntry("", &st))
+        return 0;
+
+    for (i = 0; i < entryCount; i++)
+    {
+        char **list;
+        char **name;
+        size_t count = 0;
+
+        if (!entries[i].isdir)
+            continue;
+
+        list = PHYSFS_enumerateFiles(entries[i].path);
+        if (list == NULL)
+        {
+            fprintf(stderr, "physfspack: can't list '%s': %s\n",
+                    entries[i].path, lastError());
+            return 0;
+        } /* if */
+
+        for (name = list; *name != NULL; name++)
+            count++;
+        qsort(list, count, sizeof (char *), cmpNames);
+
+        entries[i].offset = entryCount;
+        for (name = list; *name != NULL; name++)
+        {
+            const char *dir = entries[i].path;
+            char *path = (char *) malloc(strlen(dir) + strlen(*name) + 2);
+            int ok = 0;
+
+            if (path == NULL)
+                fprintf(stderr, "physfspack: out of memory.\n");
+            else
+            {
+                sprintf(path, "%s%s%s", dir, *dir ? "/" : "", *name);
+                if (!PHYSFS_stat(path, &st))
+                {
+                    fprintf(stderr, "physfspack: can't stat '%s': %s\n",
+                            path, lastError());
+                } /* if */
+                else if ((st.filetype != PHYSFS_FILETYPE_REGULAR) &&
+                         (st.filetype != PHYSFS_FILETYPE_DIRECTORY))
+                {
+                    ok = 1;  /* symlinks, devices, etc; skip it. */
+                } /* else if */
+                else
+                {
+                    ok = addEntry(path, &st);
+                } /* else */
+                free(path);
+            } /* else */
+
+            if (!ok)
+            {
+                PHYSFS_freeList(list);
+                return 0;
+            } /* if */
+        } /* for */
+
+        entries[i].size = entryCount - entries[i].offset;
+        PHYSFS_freeList(list);
+    } /* for */
+
+    return 1;
+} /* gatherEntries */
+
+
+/* Pull the next field out of a line of CSV at (*ptr), unquoting it. */
+static char *csvField(char **ptr)
+{
+    char *src = *ptr;
+    char *dst = src;
+    char *retval = src;
+    char *end;
+
+    if (*src == '"')
+    {
+        retval = dst = ++src;
+        while (*src)
+        {
+            if ((src[0] == '"') && (src[1] == '"'))
+                src++;  /* a doubled quote is a quote. */
+            else if (src[0] == '"')
+            {
+                src++;
+                break;
+            } /* else if */
+            *(dst++) = *(src++);
+        } /* while */
+    } /* if */
+    else
+    {
+        while ((*src) && (*src != ',') && (*src != '\r') && (*src != '\n'))
+            *(dst++) = *(src++);
+    } /* else */
+
+    for (end = src; (*end) && (*end != ','); end++) { /* spin */ }
+    *ptr = (*end == ',') ? end + 1 : end;
+    *dst = '\0';
+    return retval;
+} /* csvField */
+
+
+static int cmpEntryPaths(const void *a, const void *b)
+{
+    const PackEntry *one = *((const PackEntry * const *) a);
+    const PackEntry *two = *((const PackEntry * const *) b);
+    return strcmp(one->path, two->path);
+} /* cmpEntryPaths */
+
+
+/*
+ * Read the order files were first opened in from (fname), a CSV file from
+ *  PHYSFS_writeAccessProfile(), and set each entry's (order) to match.
+ *  Paths in it are inside the archive, so they match ours as they are.
+ */
+static int loadProfile(const char *fname)
+{
+    PackEntry **sorted;
+    PackEntry key;
+    PackEntry *pkey = &key;
+    PHYSFS_uint32 found = 0;
+    PHYSFS_uint32 i;
+    char line[8192];
+    int header = 1;
+    FILE *in;
+
+    sorted = (PackEntry **) malloc(entryCount * sizeof (PackEntry *));
+    if (sorted == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    in = fopen(fname, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "physfspack: can't open '%s'.\n", fname);
+        free(sorted);
+        return 0;
+    } /* if */
+
+    for (i = 0; i < entryCount; i++)
+        sorted[i] = &entries[i];
+    qsort(sorted, entryCount, sizeof (PackEntry *), cmpEntryPaths);
+
+    /* one line per span, so each file shows up once or more, in order. */
+    while (fgets(line, sizeof (line), in) != NULL)
+    {
+        char *ptr = line;
+        PackEntry **entry;
+        PHYSFS_uint32 order;
+
+        if (header)
+        {
+            header = 0;  /* "archive,mountpoint,order,path,..." */
+            continue;
+        } /* if */
+
+        csvField(&ptr);  /* archive */
+        csvField(&ptr);  /* mountpoint */
+        order = (PHYSFS_uint32) strtoul(csvField(&ptr), NULL, 10) + 1;
+        key.path = csvField(&ptr);
+        entry = (PackEntry **) bsearch(&pkey, sorted, entryCount,
+                                       sizeof (PackEntry *), cmpEntryPaths);
+        if ((entry == NULL) || ((*entry)->isdir))
+            continue;  /* not one of ours. */
+        else if ((*entry)->order == 0)
+        {
+            (*entry)->order = order;
+            found++;
+        } /* else if */
+        else if ((*entry)->order > order)
+            (*entry)->order = order;  /* opened from another archive first. */
+    } /* while */
+
+    fclose(in);
+    free(sorted);
+    printf("%s: %u files are in the profile.\n", fname, (unsigned int) found);
+    return 1;
+} /* loadProfile */
+
+
+static int cmpDataOrder(const void *a, const void *b)
+{
+    const PHYSFS_uint32 one = *((const PHYSFS_uint32 *) a);
+    const PHYSFS_uint32 two = *((const PHYSFS_uint32 *) b);
+    const PHYSFS_uint32 oneorder = entries[one].order;
+    const PHYSFS_uint32 twoorder = entries[two].order;
+
+    if (oneorder != twoorder)
+    {
+        if (oneorder == 0)
+            return 1;  /* not in the profile; after everything that is. */
+        else if (twoorder == 0)
+            return -1;
+        return (oneorder < twoorder) ? -1 : 1;
+    } /* if */
+
+    return (one < two) ? -1 : ((one > two) ? 1 : 0);
+} /* cmpDataOrder */
+
+
+/*
+ * The order that files' data goes in: the access profile's, if there was
+ *  one, and otherwise the order they were found. Returns (*count) entry
+ *  indexes, or NULL if out of memory.
+ */
+static PHYSFS_uint32 *dataOrder(PHYSFS_uint32 *count)
+{
+    PHYSFS_uint32 *retval;
+    PHYSFS_uint32 i;
+
+    *count = 0;
+    retval = (PHYSFS_uint32 *) malloc((entryCount + 1) * sizeof (*retval));
+    if (retval == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return NULL;
+    } /* if */
+
+    for (i = 0; i < entryCount; i++)
+    {
+        if (!entries[i].isdir)
+            retval[(*count)++] = i;
+    } /* for */
+
+    qsort(retval, *count, sizeof (*retval), cmpDataOrder);
+    return retval;
+} /* dataOrder */
+
+
+static void *readFile(const char *path, PHYSFS_uint64 len)
+{
+    void *retval = malloc((size_t) (len ? len : 1));
+    PHYSFS_File *in;
+
+    if (retval == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory reading '%s'.\n", path);
+        return NULL;
+    } /* if */
+
+    in = PHYSFS_openRead(path);
+    if ((in == NULL) ||
+        (PHYSFS_readBytes(in, retval, len) != (PHYSFS_sint64) len))
+    {
+        fprintf(stderr, "physfspack: can't read '%s': %s\n",
+                path, lastError());
+        free(retval);
+        retval = NULL;
+    } /* if */
+
+    if (in != NULL)
+        PHYSFS_close(in);
+    return retval;
+} /* readFile */
+
+
+/* Non-zero if we can compress files with (method) for this archive. */
+static int canCompress(int method)
+{
+    switch (method)
+    {
+#ifdef PHYSFSPACK_LZ4
+        case PPK_COMP_LZ4: return !zipOutput;
+#endif
+#ifdef PHYSFSPACK_ZSTD
+        case PPK_COMP_ZSTD: return !zipOutput;
+#endif
+#ifdef PHYSFSPACK_ZLIB
+        case ZIP_COMP_DEFLATE: return zipOutput;
+#endif
+        default: break;
+    } /* switch */
+
+    return 0;
+} /* canCompress */
+
+
+/*
+ * Compress (len) bytes of (data) with (method). Returns a new buffer and
+ *  sets (*outlen), or NULL if it's not worth it (or failed).
+ */
+static void *compressData(int method, const void *data, PHYSFS_uint64 len,
+                          PHYSFS_uint64 *outlen)
+{
+    void *retval = NULL;
+    size_t rc = 0;
+
+    if ((len == 0) || (len != (size_t) len))
+        return NULL;
+
+#ifdef PHYSFSPACK_LZ4
+    if (method == PPK_COMP_LZ4)
+    {
+        LZ4F_preferences_t prefs;
+        size_t bound;
+        memset(&prefs, '\0', sizeof (prefs));
+        prefs.frameInfo.contentSize = len;
+        prefs.compressionLevel = level;
+        bound = LZ4F_compressFrameBound((size_t) len, &prefs);
+        retval = malloc(bound);
+        if (retval == NULL)
+            return NULL;
+        rc = LZ4F_compressFrame(retval, bound, data, (size_t) len, &prefs);
+        if (LZ4F_isError(rc))
+            rc = 0;
+    } /* if */
+#endif
+
+#ifdef PHYSFSPACK_ZSTD
+    if (method == PPK_COMP_ZSTD)
+    {
+        const size_t bound = ZSTD_compressBound((size_t) len);
+        retval = malloc(bound);
+        if (retval == NULL)
+            return NULL;
+        else if (cdict != NULL)
+        {
+            ZSTD_CCtx *cctx = ZSTD_createCCtx();
+            rc = cctx ? ZSTD_compress_usingCDict(cctx, retval, bound, data,
+                                                 (size_t) len, cdict) : 0;
+            ZSTD_freeCCtx(cctx);
+        } /* else if */
+        else
+        {
+            rc = ZSTD_compress(retval, bound, data, (size_t) len,
+                               level ? level : 3);
+        } /* else */
+        if (ZSTD_isError(rc))
+            rc = 0;
+    } /* if */
+#endif
+
+#ifdef PHYSFSPACK_ZLIB
+    if ((method == ZIP_COMP_DEFLATE) && (len <= 0x7FFFFFFF))
+    {
+        z_stream strm;
+        uLong bound;
+        memset(&strm, '\0', sizeof (strm));
+        if (deflateInit2(&strm, level ? level : Z_DEFAULT_COMPRESSION,
+                         Z_DEFLATED, -MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            return NULL;
+        bound = deflateBound(&strm, (uLong) len);
+        retval = malloc((size_t) bound);
+        if (retval != NULL)
+        {
+            strm.next_in = (Bytef *) data;
+            strm.avail_in = (uInt) len;
+            strm.next_out = (Bytef *) retval;
+            strm.avail_out = (uInt) bound;
+            if (deflate(&strm, Z_FINISH) == Z_STREAM_END)
+                rc = (size_t) strm.total_out;
+        } /* if */
+        deflateEnd(&strm);
+    } /* if */
+#endif
+
+    /* decompressing costs something; it has to save at least 1/16th. */
+    if ((rc == 0) || (rc > len - (len / 16)))
+    {
+        free(retval);
+        return NULL;
+    } /* if */
+
+    *outlen = (PHYSFS_uint64) rc;
+    return retval;
+} /* compressData */
+
+
+/* Decompress what compressData() made, into (len) bytes at (dst). */
+static int decompressData(int method, const void *src, PHYSFS_uint64 srclen,
+                          void *dst, PHYSFS_uint64 len)
+{
+    int retval = 0;
+
+#ifdef PHYSFSPACK_LZ4
+    if (method == PPK_COMP_LZ4)
+    {
+        LZ4F_dctx *dctx = NULL;
+        size_t dstlen = (size_t) len;
+        size_t consumed = (size_t) srclen;
+        size_t rc;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)))
+            return 0;
+        rc = LZ4F_decompress(dctx, dst, &dstlen, src, &consumed, NULL);
+        retval = ((!LZ4F_isError(rc)) && (dstlen == len));
+        LZ4F_freeDecompressionContext(dctx);
+    } /* if */
+#endif
+
+#ifdef PHYSFSPACK_ZSTD
+    if (method == PPK_COMP_ZSTD)
+    {
+        ZSTD_DCtx *dctx = ZSTD_createDCtx();
+        size_t rc;
+        if (dctx == NULL)
+            return 0;
+        rc = ZSTD_decompress_usingDict(dctx, dst, (size_t) len, src,
+                                       (size_t) srclen, dict, dictLen);
+        retval = ((!ZSTD_isError(rc)) && (rc == len));
+        ZSTD_freeDCtx(dctx);
+    } /* if */
+#endif
+
+#ifdef PHYSFSPACK_ZLIB
+    if (method == ZIP_COMP_DEFLATE)
+    {
+        z_stream strm;
+        memset(&strm, '\0', sizeof (strm));
+        if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+            return 0;
+        strm.next_in = (Bytef *) src;
+        strm.avail_in = (uInt) srclen;
+        strm.next_out = (Bytef *) dst;
+        strm.avail_out = (uInt) len;
+        retval = ( (inflate(&strm, Z_FINISH) == Z_STREAM_END) &&
+                   (strm.total_out == len) );
+        inflateEnd(&strm);
+    } /* if */
+#endif
+
+    return retval;
+} /* decompressData */
+
+
+/*
+ * Seconds it takes to decompress (packed) back into (len) bytes, averaged
+ *  over enough tries for clock() to see it, or less than zero if it can't.
+ */
+static double timeDecode(int method, const void *packed, PHYSFS_uint64 clen,
+                         PHYSFS_uint64 len)
+{
+    void *buf = malloc((size_t) (len ? len : 1));
+    clock_t start;
+    clock_t elapsed;
+    int tries = 0;
+
+    if (buf == NULL)
+        return -1.0;
+
+    start = clock();
+    do
+    {
+        if (!decompressData(method, packed, clen, buf, len))
+        {
+            free(buf);
+            return -1.0;
+        } /* if */
+        tries++;
+        elapsed = clock() - start;
+    } while ((elapsed < (CLOCKS_PER_SEC / 1000)) && (tries < 64));
+
+    free(buf);
+    return (((double) elapsed) / ((double) CLOCKS_PER_SEC)) / tries;
+} /* timeDecode */
+
+
+/*
+ * Decide how to store (entry), whose contents are (data): as-is, or with
+ *  the compressor "-c" asked for. For "-c auto", that's whichever one gets
+ *  it into memory soonest: reading what it made at (diskRate), plus the
+ *  measured time to decompress that. Sets entry->compression and
+ *  entry->csize, and returns what to write, if that isn't (data).
+ */
+static void *packEntry(PackEntry *entry, const void *data)
+{
+    static const int methods[] = {
+        PPK_COMP_LZ4, PPK_COMP_ZSTD, ZIP_COMP_DEFLATE
+    };
+    double best = ((double) entry->size) / diskRate;
+    void *retval = NULL;
+    size_t i;
+
+    entry->compression = PPK_COMP_NONE;
+    entry->csize = entry->size;
+
+    for (i = 0; i < sizeof (methods) / sizeof (methods[0]); i++)
+    {
+        const int method = methods[i];
+        PHYSFS_uint64 clen = 0;
+        double secs = 0.0;
+        void *packed;
+
+        if ((compression != COMP_AUTO) && (compression != method))
+            continue;
+        else if (!canCompress(method))
+            continue;
+
+        packed = compressData(method, data, entry->size, &clen);
+        if (packed == NULL)
+            continue;
+
+        if (compression == COMP_AUTO)
+        {
+            secs = timeDecode(method, packed, clen, entry->size);
+            if ((secs < 0.0) || ((((double) clen) / diskRate) + secs >= best))
+            {
+                free(packed);
+                continue;
+            } /* if */
+            best = (((double) clen) / diskRate) + secs;
+        } /* if */
+
+        free(retval);
+        retval = packed;
+        entry->compression = (PHYSFS_uint16) method;
+        entry->csize = clen;
+    } /* for */
+
+    if ((entry->compression == PPK_COMP_ZSTD) && (dict != NULL))
+        entry->compression = PPK_COMP_ZSTD_DICT;
+
+    return retval;
+} /* packEntry */
+
+
+static int writeZeros(FILE *out, PHYSFS_uint64 len)
+{
+    static const unsigned char zeros[4096];
+    while (len > 0)
+    {
+        size_t chunk = sizeof (zeros);
+        if (len < chunk)
+            chunk = (size_t) len;
+        if (fwrite(zeros, chunk, 1, out) != 1)
+            return 0;
+        len -= chunk;
+    } /* while */
+    return 1;
+} /* writeZeros */
+
+
+/*
+ * Find an earlier file with the same contents as (entry) in (seen), an
+ *  open-addressed table of (mask + 1) entry indexes + 1, or add (entry).
+ */
+static PackEntry *findDuplicate(PHYSFS_uint32 *seen, PHYSFS_uint32 mask,
+                                PackEntry *entry)
+{
+    PHYSFS_uint32 i = (PHYSFS_uint32) get64(entry->hash) & mask;
+    while (seen[i] != 0)
+    {
+        PackEntry *other = &entries[seen[i] - 1];
+        if ((other->size == entry->size) &&
+            (memcmp(other->hash, entry->hash, PPK_HASH_LEN) == 0))
+            return other;
+        i = (i + 1) & mask;
+    } /* while */
+
+    seen[i] = (PHYSFS_uint32) (entry - entries) + 1;
+    return NULL;
+} /* findDuplicate */
+
+
+/*
+ * Write every file's data, starting at (pos), in dataOrder(), and fill in
+ *  where it went.
+ */
+static int writeData(FILE *out, PHYSFS_uint64 pos)
+{
+    PHYSFS_uint32 mask = 1;
+    PHYSFS_uint32 *seen;
+    PHYSFS_uint32 *order;
+    PHYSFS_uint32 count;
+    PHYSFS_uint32 i;
+
+    order = dataOrder(&count);
+    if (order == NULL)
+        return 0;
+
+    while (mask / 2 < entryCount)
+        mask *= 2;
+    seen = (PHYSFS_uint32 *) calloc(mask, sizeof (PHYSFS_uint32));
+    if (seen == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        free(order);
+        return 0;
+    } /* if */
+    mask--;
+
+    for (i = 0; i < count; i++)
+    {
+        PackEntry *entry = &entries[order[i]];
+        const PHYSFS_uint64 aligned = (pos + alignment - 1) &
+                                      ~((PHYSFS_uint64) alignment - 1);
+        const PackEntry *dup;
+        void *data;
+        void *packed;
+
+        data = readFile(entry->path, entry->size);
+        if (data == NULL)
+        {
+            free(seen);
+            free(order);
+            return 0;
+        } /* if */
+
+        hashContent((const unsigned char *) data, entry->size, entry->hash);
+        dup = findDuplicate(seen, mask, entry);
+        if (dup != NULL)
+        {
+            entry->duplicate = 1;
+            entry->offset = dup->offset;
+            entry->csize = dup->csize;
+            entry->compression = dup->compression;
+            free(data);
+            continue;
+        } /* if */
+
+        packed = packEntry(entry, data);
+        entry->offset = aligned;
+        if ((!writeZeros(out, aligned - pos)) ||
+            ((entry->csize > 0) &&
+             (fwrite(packed ? packed : data, (size_t) entry->csize, 1,
+                     out) != 1)))
+        {
+            fprintf(stderr, "physfspack: write failed.\n");
+            free(packed);
+            free(data);
+            free(seen);
+            free(order);
+            return 0;
+        } /* if */
+
+        pos = aligned + entry->csize;
+        free(packed);
+        free(data);
+    } /* for */
+
+    free(seen);
+    free(order);
+    return 1;
+} /* writeData */
+
+
+#ifdef PHYSFSPACK_ZSTD
+/*
+ * Train a zstd dictionary of up to (dictWanted) bytes on the smaller files,
+ *  which are the ones it helps. Not having enough to train on isn't an
+ *  error; the archive just doesn't get a dictionary.
+ */
+static int trainDictionary(void)
+{
+    unsigned char *samples;
+    size_t *sizes;
+    size_t total = 0;
+    unsigned int count = 0;
+    PHYSFS_uint32 i;
+    size_t rc;
+
+    for (i = 0; i < entryCount; i++)
+    {
+        if ((!entries[i].isdir) && (entries[i].size > 0) &&
+            (entries[i].size <= DICT_SAMPLE_MAX))
+            total += (size_t) entries[i].size;
+    } /* for */
+
+    samples = (unsigned char *) malloc(total ? total : 1);
+    sizes = (size_t *) malloc((entryCount + 1) * sizeof (size_t));
+    dict = malloc(dictWanted);
+    if ((samples == NULL) || (sizes == NULL) || (dict == NULL))
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        free(samples);
+        free(sizes);
+        return 0;
+    } /* if */
+
+    total = 0;
+    for (i = 0; i < entryCount; i++)
+    {
+        const PackEntry *entry = &entries[i];
+        void *data;
+
+        if ((entry->isdir) || (entry->size == 0) ||
+            (entry->size > DICT_SAMPLE_MAX))
+            continue;
+
+        data = readFile(entry->path, entry->size);
+        if (data == NULL)
+        {
+            free(samples);
+            free(sizes);
+            return 0;
+        } /* if */
+
+        memcpy(samples + total, data, (size_t) entry->size);
+        total += (size_t) entry->size;
+        sizes[count++] = (size_t) entry->size;
+        free(data);
+    } /* for */
+
+    rc = ZDICT_trainFromBuffer(dict, dictWanted, samples, sizes, count);
+    free(samples);
+    free(sizes);
+
+    if (ZDICT_isError(rc))
+    {
+        fprintf(stderr, "physfspack: no dictionary (%s); not using one.\n",
+                ZDICT_getErrorName(rc));
+        free(dict);
+        dict = NULL;
+        return 1;
+    } /* if */
+
+    dictLen = (PHYSFS_uint32) rc;
+    cdict = ZSTD_createCDict(dict, dictLen, level ? level : 3);
+    if (cdict == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    return 1;
+} /* trainDictionary */
+#endif
+
+
+static int writeArchive(const char *fname)
+{
+    PHYSFS_uint32 buckets = 2;
+    PHYSFS_uint32 namesLen = 0;
+    PHYSFS_uint64 indexLen;
+    unsigned char *index;
+    unsigned char *ptr;
+    char *names;
+    FILE *out;
+    PHYSFS_uint32 i;
+    int retval = 0;
+
+    while (buckets < entryCount)
+        buckets *= 2;
+
+    for (i = 0; i < entryCount; i++)
+    {
+        entries[i].nameOffset = namesLen;
+        namesLen += (PHYSFS_uint32) strlen(entries[i].path) + 1;
+    } /* for */
+
+    indexLen = PPK_HEADER_LEN + (((PHYSFS_uint64) buckets) * 4) +
+               (((PHYSFS_uint64) entryCount) * PPK_ENTRY_LEN) + namesLen +
+               (((PHYSFS_uint64) entryCount) * PPK_HASH_LEN) + dictLen;
+    index = (unsigned char *) calloc(1, (size_t) indexLen);
+    if (index == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    out = fopen(fname, "wb");
+    if (out == NULL)
+    {
+        fprintf(stderr, "physfspack: can't create '%s'.\n", fname);
+        free(index);
+        return 0;
+    } /* if */
+
+    /* data first, so we know where it all went; the index goes over this. */
+    if (fwrite(index, (size_t) indexLen, 1, out) != 1)
+        fprintf(stderr, "physfspack: write failed.\n");
+    else if (writeData(out, indexLen))
+    {
+        /* older PhysicsFS can read it if there's no dictionary. */
+        memcpy(index, "PPK\x1A", 4);
+        put32(index + 4, dictLen ? PPK_VERSION : 1);
+        put32(index + 8, entryCount);
+        put32(index + 12, buckets);
+        put32(index + 16, namesLen);
+        put32(index + 20, alignment);
+        put32(index + 24, PPK_HEADER_HASHES);
+        put32(index + 28, dictLen);
+
+        /* the root is found without hashing; everything else is chained. */
+        ptr = index + PPK_HEADER_LEN;
+        for (i = 1; i < entryCount; i++)
+        {
+            const PHYSFS_uint32 b = hashPath(entries[i].path) & (buckets - 1);
+            unsigned char *bucket = ptr + (((size_t) b) * 4);
+            entries[i].next = (PHYSFS_uint32) bucket[0] |
+                              ((PHYSFS_uint32) bucket[1] << 8) |
+                              ((PHYSFS_uint32) bucket[2] << 16) |
+                              ((PHYSFS_uint32) bucket[3] << 24);
+            put32(bucket, i + 1);
+        } /* for */
+
+        ptr += ((size_t) buckets) * 4;
+        for (i = 0; i < entryCount; i++, ptr += PPK_ENTRY_LEN)
+        {
+            const PackEntry *entry = &entries[i];
+            put64(ptr, entry->offset);
+            put64(ptr + 8, entry->size);
+            put64(ptr + 16, entry->isdir ? 0 : entry->csize);
+            put64(ptr + 24, (PHYSFS_uint64) entry->modtime);
+            put32(ptr + 32, entry->nameOffset);
+            put32(ptr + 36, (PHYSFS_uint32) strlen(entry->path));
+            put32(ptr + 40, entry->next);
+            put16(ptr + 44, (PHYSFS_uint16) (entry->isdir ? PPK_FLAG_DIR : 0));
+            put16(ptr + 46, entry->compression);
+        } /* for */
+
+        names = (char *) ptr;
+        for (i = 0; i < entryCount; i++)
+            strcpy(names + entries[i].nameOffset, entries[i].path);
+
+        ptr += namesLen;
+        for (i = 0; i < entryCount; i++, ptr += PPK_HASH_LEN)
+            memcpy(ptr, entries[i].hash, PPK_HASH_LEN);
+
+        if (dictLen > 0)
+            memcpy(ptr, dict, dictLen);
+
+        if ((fseek(out, 0, SEEK_SET) != 0) ||
+            (fwrite(index, (size_t) indexLen, 1, out) != 1))
+            fprintf(stderr, "physfspack: write failed.\n");
+        else
+            retval = 1;
+    } /* else if */
+
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "physfspack: write failed.\n");
+        retval = 0;
+    } /* if */
+
+    free(index);
+    return retval;
+} /* writeArchive */
+
+
+/* ZIP has MS-DOS dates and times, in local time, from 1980 on. */
+static PHYSFS_uint32 dosTime(PHYSFS_sint64 modtime)
+{
+    const time_t t = (time_t) modtime;
+    const struct tm *tm = (modtime >= 0) ? localtime(&t) : NULL;
+
+    if ((tm == NULL) || (tm->tm_year < 80))
+        return (1 << 21) | (1 << 16);  /* 1980-01-01 is as early as it goes. */
+
+    return ( (((PHYSFS_uint32) (tm->tm_year - 80)) << 25) |
+             (((PHYSFS_uint32) (tm->tm_mon + 1)) << 21) |
+             (((PHYSFS_uint32) tm->tm_mday) << 16) |
+             (((PHYSFS_uint32) tm->tm_hour) << 11) |
+             (((PHYSFS_uint32) tm->tm_min) << 5) |
+             (((PHYSFS_uint32) tm->tm_sec) >> 1) );
+} /* dosTime */
+
+
+/* Non-zero if (entry)'s sizes or offset need ZIP64 extensions. */
+static int zipNeeds64(const PackEntry *entry)
+{
+    return ( (entry->offset >= 0xFFFFFFFF) ||
+             ((!entry->isdir) && (entry->size >= 0xFFFFFFFF)) ||
+             (entry->csize >= 0xFFFFFFFF) );
+} /* zipNeeds64 */
+
+
+/*
+ * Write (entry)'s local header at (*pos), and then its data, (data), and
+ *  move (*pos) past them. A stored file's header is padded with an extra
+ *  field so its data starts on an (alignment) boundary.
+ */
+static int writeZipLocal(FILE *out, PackEntry *entry, const void *data,
+                         PHYSFS_uint64 *pos)
+{
+    const size_t namelen = strlen(entry->path) + (entry->isdir ? 1 : 0);
+    const PHYSFS_uint64 size = entry->isdir ? 0 : entry->size;
+    size_t extralen;
+    size_t padlen = 0;
+    size_t hdrlen;
+    unsigned char *hdr;
+    unsigned char *ptr;
+    int zip64;
+    int rc;
+
+    entry->offset = *pos;
+    zip64 = zipNeeds64(entry);
+    extralen = zip64 ? 20 : 0;
+    if ((entry->csize > 0) && (entry->compression == PPK_COMP_NONE) &&
+        (alignment > 1))
+    {
+        const PHYSFS_uint64 start = *pos + ZIP_LOCAL_HEADER_LEN + namelen +
+                                    extralen + 6;
+        padlen = 6 + (size_t) ((alignment - (start % alignment)) % alignment);
+    } /* if */
+
+    hdrlen = ZIP_LOCAL_HEADER_LEN + namelen + extralen + padlen;
+    hdr = (unsigned char *) calloc(1, hdrlen);
+    if (hdr == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    put32(hdr, ZIP_LOCAL_FILE_SIG);
+    put16(hdr + 4, zip64 ? ZIP_VERSION_ZIP64 : ZIP_VERSION);
+    put16(hdr + 6, ZIP_GENERAL_BITS_UTF8);
+    put16(hdr + 8, entry->compression);
+    put32(hdr + 10, dosTime(entry->modtime));
+    put32(hdr + 14, entry->crc);
+    put32(hdr + 18, zip64 ? 0xFFFFFFFF : (PHYSFS_uint32) entry->csize);
+    put32(hdr + 22, zip64 ? 0xFFFFFFFF : (PHYSFS_uint32) size);
+    put16(hdr + 26, (PHYSFS_uint16) namelen);
+    put16(hdr + 28, (PHYSFS_uint16) (extralen + padlen));
+    ptr = hdr + ZIP_LOCAL_HEADER_LEN;
+    memcpy(ptr, entry->path, strlen(entry->path));
+    if (entry->isdir)
+        ptr[namelen - 1] = '/';
+    ptr += namelen;
+
+    if (zip64)
+    {
+        put16(ptr, ZIP64_EXTRA_SIG);
+        put16(ptr + 2, 16);
+        put64(ptr + 4, size);
+        put64(ptr + 12, entry->csize);
+        ptr += 20;
+    } /* if */
+
+    if (padlen > 0)  /* the alignment, then zeros up to it. */
+    {
+        put16(ptr, ZIP_ALIGN_EXTRA_SIG);
+        put16(ptr + 2, (PHYSFS_uint16) (padlen - 4));
+        put16(ptr + 4, (PHYSFS_uint16) alignment);
+    } /* if */
+
+    rc = ( (fwrite(hdr, hdrlen, 1, out) == 1) &&
+           ((entry->csize == 0) ||
+            (fwrite(data, (size_t) entry->csize, 1, out) == 1)) );
+    free(hdr);
+    if (!rc)
+    {
+        fprintf(stderr, "physfspack: write failed.\n");
+        return 0;
+    } /* if */
+
+    *pos += hdrlen + entry->csize;
+    return 1;
+} /* writeZipLocal */
+
+
+/*
+ * Write every entry's local header and data: directories first, then
+ *  files, in dataOrder(). Sets (*pos) to where they end.
+ */
+static int writeZipData(FILE *out, PHYSFS_uint64 *pos)
+{
+    PHYSFS_uint32 *order;
+    PHYSFS_uint32 count;
+    PHYSFS_uint32 i;
+
+    *pos = 0;
+    for (i = 1; i < entryCount; i++)  /* skip the root. */
+    {
+        if ((entries[i].isdir) && (!writeZipLocal(out, &entries[i], NULL, pos)))
+            return 0;
+    } /* for */
+
+    order = dataOrder(&count);
+    if (order == NULL)
+        return 0;
+
+    for (i = 0; i < count; i++)
+    {
+        PackEntry *entry = &entries[order[i]];
+        void *data = readFile(entry->path, entry->size);
+        void *packed;
+        int rc;
+
+        if (data == NULL)
+        {
+            free(order);
+            return 0;
+        } /* if */
+
+        entry->crc = PHYSFS_crc32(0, data, entry->size);
+        packed = packEntry(entry, data);
+        rc = writeZipLocal(out, entry, packed ? packed : data, pos);
+        free(packed);
+        free(data);
+        if (!rc)
+        {
+            free(order);
+            return 0;
+        } /* if */
+    } /* for */
+
+    free(order);
+    return 1;
+} /* writeZipData */
+
+
+/* Write the central directory and end records, starting at (pos). */
+static int writeZipCentral(FILE *out, PHYSFS_uint64 pos)
+{
+    const PHYSFS_uint64 count = entryCount - 1;  /* no record for root. */
+    PHYSFS_uint64 size = 0;
+    PHYSFS_uint64 total;
+    unsigned char *buf;
+    unsigned char *ptr;
+    int zip64 = ((count >= 0xFFFF) || (pos >= 0xFFFFFFFF));
+    PHYSFS_uint32 i;
+    int rc;
+
+    for (i = 1; i < entryCount; i++)
+    {
+        size += ZIP_CENTRAL_RECORD_LEN + strlen(entries[i].path);
+        size += (entries[i].isdir ? 1 : 0);
+        size += (zipNeeds64(&entries[i]) ? 28 : 0);
+    } /* for */
+
+    if (size >= 0xFFFFFFFF)
+        zip64 = 1;
+
+    total = size + (zip64 ? (56 + 20) : 0) + 22;
+    buf = (unsigned char *) calloc(1, (size_t) total);
+    if (buf == NULL)
+    {
+        fprintf(stderr, "physfspack: out of memory.\n");
+        return 0;
+    } /* if */
+
+    ptr = buf;
+    for (i = 1; i < entryCount; i++)
+    {
+        const PackEntry *entry = &entries[i];
+        const size_t namelen = strlen(entry->path);
+        const PHYSFS_uint64 usize = entry->isdir ? 0 : entry->size;
+        const int big = zipNeeds64(entry);
+
+        put32(ptr, ZIP_CENTRAL_DIR_SIG);
+        put16(ptr + 4, ZIP_VERSION);  /* made by MS-DOS; no unix perms. */
+        put16(ptr + 6, big ? ZIP_VERSION_ZIP64 : ZIP_VERSION);
+        put16(ptr + 8, ZIP_GENERAL_BITS_UTF8);
+        put16(ptr + 10, entry->compression);
+        put32(ptr + 12, dosTime(entry->modtime));
+        put32(ptr + 16, entry->crc);
+        put32(ptr + 20, big ? 0xFFFFFFFF : (PHYSFS_uint32) entry->csize);
+        put32(ptr + 24, big ? 0xFFFFFFFF : (PHYSFS_uint32) usize);
+        put16(ptr + 28, (PHYSFS_uint16) (namelen + (entry->isdir ? 1 : 0)));
+        put16(ptr + 30, big ? 28 : 0);
+        /* comment, starting disk and internal attributes are zero. */
+        put32(ptr + 38, entry->isdir ? ZIP_MSDOS_DIRECTORY : 0);
+        put32(ptr + 42, big ? 0xFFFFFFFF : (PHYSFS_uint32) entry->offset);
+        ptr += ZIP_CENTRAL_RECORD_LEN;
+        memcpy(ptr, entry->path, namelen);
+        ptr += namelen;
+        if (entry->isdir)
+            *(ptr++) = '/';
+        if (big)
+        {
+            put16(ptr, ZIP64_EXTRA_SIG);
+            put16(ptr + 2, 24);
+            put64(ptr + 4, usize);
+            put64(ptr + 12, entry->csize);
+            put64(ptr + 20, entry->offset);
+            ptr += 28;
+        } /* if */
+    } /* for */
+
+    if (zip64)
+    {
+        put32(ptr, ZIP64_END_OF_CENTRAL_DIR_SIG);
+        put64(ptr + 4, 44);  /* size of the rest of this record. */
+        put16(ptr + 12, ZIP_VERSION_ZIP64);  /* made by */
+        put16(ptr + 14, ZIP_VERSION_ZIP64);  /* needed */
+        /* this disk, and the one with the central dir, are zero. */
+        put64(ptr + 24, count);  /* entries on this disk */
+        put64(ptr + 32, count);  /* entries, total */
+        put64(ptr + 40, size);
+        put64(ptr + 48, pos);
+        ptr += 56;
+
+        put32(ptr, ZIP64_END_OF_CENTRAL_DIR_LOCATOR_SIG);
+        put64(ptr + 8, pos + size);  /* where the record above is. */
+        put32(ptr + 16, 1);  /* total disks */
+        ptr += 20;
+    } /* if */
+
+    put32(ptr, ZIP_END_OF_CENTRAL_DIR_SIG);
+    put16(ptr + 8, (PHYSFS_uint16) ((count >= 0xFFFF) ? 0xFFFF : count));
+    put16(ptr + 10, (PHYSFS_uint16) ((count >= 0xFFFF) ? 0xFFFF : count));
+    put32(ptr + 12, (size >= 0xFFFFFFFF) ? 0xFFFFFFFF : (PHYSFS_uint32) size);
+    put32(ptr + 16, (pos >= 0xFFFFFFFF) ? 0xFFFFFFFF : (PHYSFS_uint32) pos);
+
+    rc = (fwrite(buf, (size_t) total, 1, out) == 1);
+    free(buf);
+    if (!rc)
+        fprintf(stderr, "physfspack: write failed.\n");
+    return rc;
+} /* writeZipCentral */
+
+
+static int writeZipArchive(const char *fname)
+{
+    PHYSFS_uint64 pos = 0;
+    int retval;
+    FILE *out;
+
+    out = fopen(fname, "wb");
+    if (out == NULL)
+    {
+        fprintf(stderr, "physfspack: can't create '%s'.\n", fname);
+        return 0;
+    } /* if */
+
+    retval = ((writeZipData(out, &pos)) && (writeZipCentral(out, pos)));
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "physfspack: write failed.\n");
+        retval = 0;
+    } /* if */
+
+    return retval;
+} /* writeZipArchive */
+
+
+/* Non-zero if (fname) ends in ".zip", any case. */
+static int isZipName(const char *fname)
+{
+    const char *ext = strrchr(fname, '.');
+    return ( (ext != NULL) && ((ext[1] == 'z') || (ext[1] == 'Z')) &&
+             ((ext[2] == 'i') || (ext[2] == 'I')) &&
+             ((ext[3] == 'p') || (ext[3] == 'P')) && (ext[4] == '\0') );
+} /* isZipName */
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "USAGE: %s [-c none|auto|lz4|zstd|deflate] [-l level]"
+            " [-a align] [-d bytes]\n"
+            "          [-p profile.csv] [-r MB/s] out.ppk|out.zip dir\n",
+            argv0);
+} /* usage */
+
+
+int main(int argc, char **argv)
+{
+    const char *profile = NULL;
+    const char *method = "none";
+    PHYSFS_uint64 stored = 0;
+    PHYSFS_uint64 total = 0;
+    PHYSFS_uint32 dups = 0;
+    PHYSFS_uint32 i;
+    int argi = 1;
+    int rc = 1;
+
+    while ((argi < argc - 2) && (argv[argi][0] == '-'))
+    {
+        const char *opt = argv[argi++];
+        const char *val = argv[argi++];
+        if (strcmp(opt, "-c") == 0)
+        {
+            method = val;
+            if (strcmp(val, "none") == 0)
+                compression = PPK_COMP_NONE;
+            else if (strcmp(val, "auto") == 0)
+                compression = COMP_AUTO;
+            else if (strcmp(val, "lz4") == 0)
+                compression = PPK_COMP_LZ4;
+            else if (strcmp(val, "zstd") == 0)
+                compression = PPK_COMP_ZSTD;
+            else if (strcmp(val, "deflate") == 0)
+                compression = ZIP_COMP_DEFLATE;
+            else
+            {
+                fprintf(stderr, "physfspack: no compressor '%s'.\n", val);
+                return 1;
+            } /* else */
+        } /* if */
+        else if (strcmp(opt, "-l") == 0)
+            level = atoi(val);
+        else if (strcmp(opt, "-a") == 0)
+        {
+            alignment = (PHYSFS_uint32) strtoul(val, NULL, 10);
+            if ((alignment == 0) || (alignment & (alignment - 1)))
+            {
+                fprintf(stderr, "physfspack: bad alignment '%s'.\n", val);
+                return 1;
+            } /* if */
+        } /* else if */
+#ifdef PHYSFSPACK_ZSTD
+        else if (strcmp(opt, "-d") == 0)
+        {
+            dictWanted = (size_t) strtoul(val, NULL, 10);
+            if (dictWanted < 1024)
+            {
+                fprintf(stderr, "physfspack: bad dictionary size '%s'.\n",
+                        val);
+                return 1;
+            } /* if */
+            if (compression != COMP_AUTO)
+            {
+                method = "zstd";
+                compression = PPK_COMP_ZSTD;
+            } /* if */
+        } /* else if */
+#endif
+        else if (strcmp(opt, "-p") == 0)
+            profile = val;
+        else if (strcmp(opt, "-r") == 0)
+        {
+            diskRate = atof(val) * 1024.0 * 1024.0;
+            if (diskRate <= 0.0)
+            {
+                fprintf(stderr, "physfspack: bad disk speed '%s'.\n", val);
+                return 1;
+            } /* if */
+        } /* else if */
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* while */
+
+    if (argi != argc - 2)
+    {
+        usage(argv[0]);
+        return 1;
+    } /* if */
+
+    zipOutput = isZipName(argv[argi]);
+    if ((compression > PPK_COMP_NONE) && (!canCompress(compression)))
+    {
+        fprintf(stderr, "physfspack: can't use '%s' for %s archives.\n",
+                method, zipOutput ? "ZIP" : "PPK");
+        return 1;
+    } /* if */
+    else if ((zipOutput) && (dictWanted > 0))
+    {
+        fprintf(stderr, "physfspack: ZIP archives can't have dictionaries.\n");
+        return 1;
+    } /* else if */
+    else if ((zipOutput) && (alignment > 32768))
+    {
+        fprintf(stderr, "physfspack: ZIP can't align to more than 32768.\n");
+        return 1;
+    } /* else if */
+
+    if (!PHYSFS_init(argv[0]))
+    {
+        fprintf(stderr, "PHYSFS_init() failed: %s\n", lastError());
+        return 1;
+    } /* if */
+
+    if (!PHYSFS_mount(argv[argi + 1], NULL, 0))
+    {
+        fprintf(stderr, "physfspack: can't open '%s': %s\n",
+                argv[argi + 1], lastError());
+    } /* if */
+    else if ((gatherEntries()) &&
+             ((profile == NULL) || (loadProfile(profile))) &&
+#ifdef PHYSFSPACK_ZSTD
+             ((dictWanted == 0) || (trainDictionary())) &&
+#endif
+             ((zipOutput) ? writeZipArchive(argv[argi]) :
+                            writeArchive(argv[argi])))
+    {
+        for (i = 0; i < entryCount; i++)
+        {
+            if (entries[i].isdir)
+                continue;
+            total += entries[i].size;
+            if (entries[i].duplicate)
+                dups++;
+            else
+                stored += entries[i].csize;
+        } /* for */
+        printf("%s: %u entries, %llu bytes of data stored as %llu"
+               " (%u duplicate files, %u bytes of dictionary).\n",
+               argv[argi], (unsigned int) entryCount,
+               (unsigned long long) total, (unsigned long long) stored,
+               (unsigned int) dups, (unsigned int) dictLen);
+        rc = 0;
+    } /* else if */
+
+    for (i = 0; i < entryCount; i++)
+        free(entries[i].path);
+    free(entries);
+#ifdef PHYSFSPACK_ZSTD
+    ZSTD_freeCDict(cdict);
+#endif
+    free(dict);
+
+    PHYSFS_deinit();
+    return rc;
+} /* main */
+
+/* end of physfspack.c ... */
@@ -37,6 +37,21 @@
 #define RW_SEEK_END SEEK_END
 #endif
 
+/*
+ * Files PHYSFSRWOPS_openRead() can't map get an adaptive buffer up to this
+ *  big, so decoders doing lots of tiny reads don't each go to PhysicsFS.
+ */
+#define PHYSFSRWOPS_BUFFER_MAX (64 * 1024)
+
+/* What a RWops over a file that PHYSFS_mapRead() handed us keeps around. */
+typedef struct
+{
+    PHYSFS_File *handle;  /* keeps (base) valid; closed with the RWops. */
+    const Uint8 *base;
+    const Uint8 *here;
+    const Uint8 *stop;
+} MappedRWops;
+
 #if TARGET_SDL2
 static Sint64 SDLCALL physfsrwops_size(struct SDL_RWops *rw)
 {
@@ -185,6 +200,153 @@ static int physfsrwops_close(SDL_RWops *rw)
 } /* physfsrwops_close */
 
 
+/*
+ * Files PhysicsFS can hand us a pointer to get these instead, which work
+ *  like SDL_RWFromConstMem(), but also close the PhysicsFS handle, which
+ *  the pointer needs, when they're closed.
+ */
+
+#if TARGET_SDL2
+static Sint64 SDLCALL mappedrwops_size(struct SDL_RWops *rw)
+{
+    const MappedRWops *m = (const MappedRWops *) rw->hidden.unknown.data1;
+    return (Sint64) (m->stop - m->base);
+} /* mappedrwops_size */
+#endif
+
+
+#if TARGET_SDL2
+static Sint64 SDLCALL mappedrwops_seek(struct SDL_RWops *rw, Sint64 offset, int whence)
+#else
+static int mappedrwops_seek(SDL_RWops *rw, int offset, int whence)
+#endif
+{
+    MappedRWops *m = (MappedRWops *) rw->hidden.unknown.data1;
+    const PHYSFS_sint64 len = (PHYSFS_sint64) (m->stop - m->base);
+    PHYSFS_sint64 pos = 0;
+
+    if (whence == RW_SEEK_SET)
+        pos = (PHYSFS_sint64) offset;
+    else if (whence == RW_SEEK_CUR)
+        pos = ((PHYSFS_sint64) (m->here - m->base)) + offset;
+    else if (whence == RW_SEEK_END)
+        pos = len + ((PHYSFS_sint64) offset);
+    else
+    {
+        SDL_SetError("Invalid 'whence' parameter.");
+        return -1;
+    } /* else */
+
+    if ( pos < 0 )
+    {
+        SDL_SetError("Attempt to seek past start of file.");
+        return -1;
+    } /* if */
+
+    if (pos > len)  /* same as SDL_RWFromConstMem(): stop at the end. */
+        pos = len;
+
+    m->here = m->base + (size_t) pos;
+
+    #if TARGET_SDL2
+    return (Sint64) pos;
+    #else
+    return (int) pos;
+    #endif
+} /* mappedrwops_seek */
+
+
+#if TARGET_SDL2
+static size_t SDLCALL mappedrwops_read(struct SDL_RWops *rw, void *ptr,
+                                       size_t size, size_t maxnum)
+#else
+static int mappedrwops_read(SDL_RWops *rw, void *ptr, int size, int maxnum)
+#endif
+{
+    MappedRWops *m = (MappedRWops *) rw->hidden.unknown.data1;
+    const size_t avail = (size_t) (m->stop - m->here);
+    size_t num = (size_t) maxnum;
+
+    if ((size <= 0) || (maxnum <= 0))
+        return 0;
+    else if (avail / ((size_t) size) < num)
+        num = avail / ((size_t) size);
+
+    SDL_memcpy(ptr, m->here, num * ((size_t) size));
+    m->here += num * ((size_t) size);
+
+    #if TARGET_SDL2
+    return num;
+    #else
+    return (int) num;
+    #endif
+} /* mappedrwops_read */
+
+
+#if TARGET_SDL2
+static size_t SDLCALL mappedrwops_write(struct SDL_RWops *rw, const void *ptr,
+                                        size_t size, size_t num)
+#else
+static int mappedrwops_write(SDL_RWops *rw, const void *ptr, int size, int num)
+#endif
+{
+    SDL_SetError("Can't write to a file opened for reading.");
+    #if TARGET_SDL2
+    return 0;
+    #else
+    return -1;
+    #endif
+} /* mappedrwops_write */
+
+
+static int mappedrwops_close(SDL_RWops *rw)
+{
+    MappedRWops *m = (MappedRWops *) rw->hidden.unknown.data1;
+    if (!PHYSFS_close(m->handle))
+    {
+        SDL_SetError("PhysicsFS error: %s", PHYSFS_getLastError());
+        return -1;
+    } /* if */
+
+    SDL_free(m);
+    SDL_FreeRW(rw);
+    return 0;
+} /* mappedrwops_close */
+
+
+static SDL_RWops *create_mapped_rwops(PHYSFS_File *handle, const void *ptr,
+                                      size_t len)
+{
+    SDL_RWops *retval = NULL;
+    MappedRWops *m = (MappedRWops *) SDL_malloc(sizeof (MappedRWops));
+
+    if (m == NULL)
+        SDL_OutOfMemory();
+    else
+    {
+        retval = SDL_AllocRW();
+        if (retval == NULL)
+            SDL_free(m);
+        else
+        {
+            m->handle = handle;
+            m->base = m->here = (const Uint8 *) ptr;
+            m->stop = m->base + len;
+            #if TARGET_SDL2
+            retval->size  = mappedrwops_size;
+            #endif
+            retval->seek  = mappedrwops_seek;
+            retval->read  = mappedrwops_read;
+            retval->write = mappedrwops_write;
+            retval->close = mappedrwops_close;
+            retval->hidden.unknown.data1 = m;
+        } /* else */
+    } /* else */
+
+    return retval;
+} /* create_mapped_rwops */
+
+
 static SDL_RWops *create_rwops(PHYSFS_File *handle)
 {
     SDL_RWops *retval = NULL;
@@ -225,7 +387,30 @@ SDL_RWops *PHYSFSRWOPS_makeRWops(PHYSFS_File *handle)
 
 SDL_RWops *PHYSFSRWOPS_openRead(const char *fname)
 {
-    return create_rwops(PHYSFS_openRead(fname));
+    PHYSFS_File *handle = PHYSFS_openRead(fname);
+    SDL_RWops *retval = NULL;
+    const void *ptr = NULL;
+    PHYSFS_uint64 len = 0;
+
+    if (handle == NULL)
+        return create_rwops(NULL);  /* sets the error. */
+
+    /* already in memory? Then read straight out of it, no copies. */
+    if ( (PHYSFS_mapRead(handle, &ptr, &len)) && (len == (size_t) len) )
+        retval = create_mapped_rwops(handle, ptr, (size_t) len);
+    else
+    {
+        PHYSFS_getLastErrorCode();  /* not mapped; that's not an error. */
+
+        /* decoders love tiny reads; don't send every one to PhysicsFS. */
+        PHYSFS_setAdaptiveBuffer(handle, PHYSFSRWOPS_BUFFER_MAX, NULL);
+        retval = create_rwops(handle);
+    } /* else */
+
+    if (retval == NULL)
+        PHYSFS_close(handle);
+
+    return retval;
 } /* PHYSFSRWOPS_openRead */
 
 
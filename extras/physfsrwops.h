@@ -36,6 +36,12 @@ extern "C" {
  *  RWops is closed. PhysicsFS should be configured to your liking before
  *  opening files through this method.
  *
+ * Files PhysicsFS already has in memory (see PHYSFS_mapRead()) are read
+ *  straight out of that memory, like SDL_RWFromConstMem() would. Others get
+ *  an adaptive read buffer (see PHYSFS_setAdaptiveBuffer()), so the small
+ *  reads image and sound decoders like to make are cheap. If you'd rather
+ *  have neither, use PHYSFSRWOPS_makeRWops() on your own handle.
+ *
  *   @param filename File to open in platform-independent notation.
  *  @return A valid SDL_RWops structure on success, NULL on error. Specifics
  *           of the error can be gleaned from PHYSFS_getLastError().
@@ -3,10 +3,54 @@
 #include <string.h>
 #include <time.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 #include "physfs.h"
 
+/*
+ * Files up to SMALL_FILE_MAX bytes are read together, a batch at a time,
+ *  with PHYSFS_readFilesBatch(), which reads a .zip's compressed data in
+ *  the order it's in the archive and decompresses it on the queue's
+ *  threads. Bigger ones are streamed, STREAM_BUFFER bytes at a time, with
+ *  the queue reading ahead and writing behind.
+ */
+#define SMALL_FILE_MAX (4 * 1024 * 1024)
+#define BATCH_MAX_BYTES (64 * 1024 * 1024)
+#define BATCH_MAX_FILES 1024
+#define STREAM_BUFFER (4 * 1024 * 1024)
+#define DEFAULT_THREADS 4
+
+typedef struct
+{
+    char *fname;
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 modtime;
+} UnpackEntry;
 
 static int failure = 0;
+static int quiet = 0;
+static PHYSFS_AsyncQueue *queue = NULL;
+static UnpackEntry *entries = NULL;
+static size_t entryCount = 0;
+static size_t entryAlloc = 0;
+static PHYSFS_uint64 totalBytes = 0;
+static PHYSFS_uint32 totalFiles = 0;
+
+static double nowSeconds(void)
+{
+#ifdef _WIN32
+    return ((double) GetTickCount()) / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return ((double) tv.tv_sec) + (((double) tv.tv_usec) / 1000000.0);
+#endif
+} /* nowSeconds */
+
 
 static void modTimeToStr(PHYSFS_sint64 modtime, char *modstr, size_t strsize)
 {
@@ -34,117 +78,304 @@ static void fail(const char *what, const char *why)
 } /* fail */
 
 
-static void dumpFile(const char *fname)
+static void printFile(const UnpackEntry *entry)
+{
+    char modstr[64];
+
+    if (quiet)
+        return;
+
+    printf("%s (", entry->fname);
+    if (entry->size == -1)
+        printf("?");
+    else
+        printf("%lld", (long long) entry->size);
+    printf(" bytes");
+
+    modTimeToStr(entry->modtime, modstr, sizeof (modstr));
+    printf(", %s)\n", modstr);
+} /* printFile */
+
+
+/* Write (len) bytes of (buf) to (out) in chunks the write-behind can take. */
+static int writeAll(PHYSFS_File *out, const void *buf, PHYSFS_uint64 len)
+{
+    const char *ptr = (const char *) buf;
+    while (len > 0)
+    {
+        const PHYSFS_uint64 chunk = (len > STREAM_BUFFER) ? STREAM_BUFFER : len;
+        if (PHYSFS_writeBytes(out, ptr, chunk) != (PHYSFS_sint64) chunk)
+        {
+            fail("PHYSFS_write", NULL);
+            return 0;
+        } /* if */
+        ptr += chunk;
+        len -= chunk;
+    } /* while */
+    return 1;
+} /* writeAll */
+
+
+/* Close (out), and delete what was written if anything went wrong. */
+static void finishFile(const UnpackEntry *entry, PHYSFS_File *out,
+                       PHYSFS_uint64 written, int origfailure)
+{
+    if ((out != NULL) && (!PHYSFS_close(out)))
+        fail("PHYSFS_close", NULL);
+
+    if (failure)
+        PHYSFS_delete(entry->fname);
+    else
+    {
+        failure = origfailure;
+        totalBytes += written;
+        totalFiles++;
+    } /* else */
+} /* finishFile */
+
+
+/* Copy a big (or unknown-sized) file over, a chunk at a time. */
+static void dumpStream(const UnpackEntry *entry)
 {
     const int origfailure = failure;
     PHYSFS_File *out = NULL;
     PHYSFS_File *in = NULL;
+    PHYSFS_uint64 written = 0;
+    const void *mapped = NULL;
+    PHYSFS_uint64 mappedlen = 0;
+    char *buf = NULL;
 
     failure = 0;
+    printFile(entry);
 
-    if ((in = PHYSFS_openRead(fname)) == NULL)
-        fail("\nPHYSFS_openRead", NULL);
-    else if ((out = PHYSFS_openWrite(fname)) == NULL)
-        fail("\nPHYSFS_openWrite", NULL);
-    else
+    if ((in = PHYSFS_openRead(entry->fname)) == NULL)
+        fail("PHYSFS_openRead", NULL);
+    else if ((out = PHYSFS_openWrite(entry->fname)) == NULL)
+        fail("PHYSFS_openWrite", NULL);
+
+    /* stored files in a mapped archive can be written straight out. */
+    else if (PHYSFS_mapRead(in, &mapped, &mappedlen))
     {
-        char modstr[64];
-        PHYSFS_sint64 size = PHYSFS_fileLength(in);
+        PHYSFS_setWriteBehind(out, STREAM_BUFFER, queue);
+        if (writeAll(out, mapped, mappedlen))
+            written = mappedlen;
+    } /* else if */
 
-        printf("(");
-        if (size == -1)
-            printf("?");
-        else
-            printf("%lld", (long long) size);
-        printf(" bytes");
+    else if ((buf = (char *) malloc(STREAM_BUFFER)) == NULL)
+        fail("malloc", "Out of memory!");
 
-        modTimeToStr(PHYSFS_getLastModTime(fname), modstr, sizeof (modstr));
-        printf(", %s)\n", modstr);
+    else
+    {
+        /* these are just faster; it still works if they fail. */
+        PHYSFS_setAdaptiveBuffer(in, STREAM_BUFFER, queue);
+        PHYSFS_setWriteBehind(out, STREAM_BUFFER, queue);
 
-        while ( (!failure) && (!PHYSFS_eof(in)) )
+        while (!failure)
         {
-            static char buf[64 * 1024];
-            PHYSFS_sint64 br = PHYSFS_read(in, buf, 1, sizeof (buf));
+            const PHYSFS_sint64 br = PHYSFS_readBytes(in, buf, STREAM_BUFFER);
             if (br == -1)
                 fail("PHYSFS_read", NULL);
-            else
-            {
-                PHYSFS_sint64 bw = PHYSFS_write(out, buf, 1, br);
-                if (bw != br)
-                    fail("PHYSFS_write", NULL);
-                else
-                    size -= bw;
-            } /* else */
+            else if (br == 0)
+                break;
+            else if (writeAll(out, buf, (PHYSFS_uint64) br))
+                written += (PHYSFS_uint64) br;
         } /* while */
 
-        if ((!failure) && (size != 0))
+        if ((!failure) && (entry->size != -1) &&
+            (written != (PHYSFS_uint64) entry->size))
             fail("PHYSFS_eof", "BUG! eof != PHYSFS_fileLength bytes!");
     } /* else */
 
+    free(buf);
     if (in != NULL)
         PHYSFS_close(in);
+    finishFile(entry, out, written, origfailure);
+} /* dumpStream */
 
-    if (out != NULL)
-    {
-        if (!PHYSFS_close(out))
-            fail("PHYSFS_close", NULL);
-    } /* if */
 
-    if (failure)
-        PHYSFS_delete(fname);
+/* Read (count) small files from (batch) all at once, then write them. */
+static void dumpBatch(const UnpackEntry *batch, size_t count)
+{
+    const char **paths = (const char **) malloc(count * sizeof (char *));
+    void **buffers = (void **) malloc(count * sizeof (void *));
+    PHYSFS_uint64 *lens = (PHYSFS_uint64 *) malloc(count * sizeof (*lens));
+    PHYSFS_sint64 *results = (PHYSFS_sint64 *) malloc(count * sizeof (*lens));
+    const char *err = NULL;
+    char *block = NULL;
+    size_t total = 0;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+        total += (size_t) batch[i].size;
+
+    if ((!paths) || (!buffers) || (!lens) || (!results))
+        fail("malloc", "Out of memory!");
+    else if ((block = (char *) malloc(total + 1)) == NULL)
+        fail("malloc", "Out of memory!");
     else
-        failure = origfailure;
-} /* dumpFile */
+    {
+        char *ptr = block;
+        for (i = 0; i < count; i++)
+        {
+            paths[i] = batch[i].fname;
+            buffers[i] = ptr;
+            lens[i] = (PHYSFS_uint64) batch[i].size;
+            ptr += (size_t) batch[i].size;
+        } /* for */
+
+        if (!PHYSFS_readFilesBatch(queue, paths, buffers, lens, results,
+                                   (PHYSFS_uint32) count))
+            err = PHYSFS_getLastError();  /* only the first one's. */
+
+        for (i = 0; i < count; i++)
+        {
+            const int origfailure = failure;
+            PHYSFS_File *out = NULL;
+            PHYSFS_uint64 written = 0;
+
+            failure = 0;
+            printFile(&batch[i]);
+            if (results[i] == -1)
+                fail("PHYSFS_readFilesBatch", err ? err : "unknown error");
+            else if (results[i] != batch[i].size)
+                fail("PHYSFS_eof", "BUG! eof != PHYSFS_fileLength bytes!");
+            else if ((out = PHYSFS_openWrite(batch[i].fname)) == NULL)
+                fail("PHYSFS_openWrite", NULL);
+            else if (writeAll(out, buffers[i], lens[i]))
+                written = lens[i];
+
+            finishFile(&batch[i], out, written, origfailure);
+        } /* for */
+    } /* else */
+
+    free(block);
+    free(results);
+    free(lens);
+    free(buffers);
+    free(paths);
+} /* dumpBatch */
 
 
-static void unpackCallback(void *_depth, const char *origdir, const char *str)
+static void dumpFiles(void)
+{
+    size_t batchStart = 0;
+    size_t batchBytes = 0;
+    size_t i;
+
+    for (i = 0; i < entryCount; i++)
+    {
+        const UnpackEntry *entry = &entries[i];
+        const int small = ((entry->size >= 0) &&
+                           (entry->size <= SMALL_FILE_MAX));
+
+        /* a big file ends the batch, so files still go in walk order. */
+        if ( (!small) || (i - batchStart == BATCH_MAX_FILES) ||
+             (batchBytes + (size_t) entry->size > BATCH_MAX_BYTES) )
+        {
+            if (i > batchStart)
+                dumpBatch(&entries[batchStart], i - batchStart);
+            batchStart = i;
+            batchBytes = 0;
+        } /* if */
+
+        if (small)
+            batchBytes += (size_t) entry->size;
+        else
+        {
+            dumpStream(entry);
+            batchStart = i + 1;
+        } /* else */
+    } /* for */
+
+    if (entryCount > batchStart)
+        dumpBatch(&entries[batchStart], entryCount - batchStart);
+} /* dumpFiles */
+
+
+static void unpackCallback(void *data, const char *origdir, const char *str,
+                           const PHYSFS_Stat *stat)
 {
-    int depth = *((int *) _depth);
     const int len = strlen(origdir) + strlen(str) + 2;
     char *fname = (char *) malloc(len);
     if (fname == NULL)
         fail("malloc", "Out of memory!");
     else
     {
-        if (strcmp(origdir, "/") == 0)
-            origdir = "";
-
-        snprintf(fname, len, "%s/%s", origdir, str);
+        snprintf(fname, len, "%s%s%s", origdir, *origdir ? "/" : "", str);
 
-        printf("%s ", fname);
-        if (PHYSFS_isDirectory(fname))
+        if (stat->filetype == PHYSFS_FILETYPE_DIRECTORY)
         {
-            depth++;
-            printf("(directory)\n");
+            if (!quiet)
+                printf("%s (directory)\n", fname);
             if (!PHYSFS_mkdir(fname))
                 fail("PHYSFS_mkdir", NULL);
-            else
-                PHYSFS_enumerateFilesCallback(fname, unpackCallback, &depth);
+            free(fname);
         } /* if */
 
-        else if (PHYSFS_isSymbolicLink(fname))
+        else if (stat->filetype == PHYSFS_FILETYPE_SYMLINK)
         {
-            printf("(symlink)\n");
+            if (!quiet)
+                printf("%s (symlink)\n", fname);
             /* !!! FIXME: ?  if (!symlink(fname, */
+            free(fname);
         } /* else if */
 
-        else  /* ...file. */
+        else  /* ...file. Copy it once we know what they all are. */
         {
-            dumpFile(fname);
+            if (entryCount == entryAlloc)
+            {
+                const size_t newalloc = entryAlloc ? entryAlloc * 2 : 256;
+                void *ptr = realloc(entries, newalloc * sizeof (UnpackEntry));
+                if (ptr == NULL)
+                {
+                    fail("realloc", "Out of memory!");
+                    free(fname);
+                    return;
+                } /* if */
+                entries = (UnpackEntry *) ptr;
+                entryAlloc = newalloc;
+            } /* if */
+
+            entries[entryCount].fname = fname;
+            entries[entryCount].size = stat->filesize;
+            entries[entryCount].modtime = stat->modtime;
+            entryCount++;
         } /* else */
-
-        free(fname);
     } /* else */
 } /* unpackCallback */
 
 
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "USAGE: %s [-t threads] [-q] <archive> <unpackDirectory>\n"
+            "  -t  threads to decompress and do I/O on (default %d).\n"
+            "      0 does everything on the main thread.\n"
+            "  -q  don't list each file, just the totals.\n",
+            argv0, DEFAULT_THREADS);
+} /* usage */
+
+
 int main(int argc, char **argv)
 {
-    int zero = 0;
+    int threads = DEFAULT_THREADS;
+    double start, elapsed;
+    size_t i;
+    int argi;
 
-    if (argc != 3)
+    for (argi = 1; argi < argc; argi++)
     {
-        fprintf(stderr, "USAGE: %s <archive> <unpackDirectory>\n", argv[0]);
+        if ((strcmp(argv[argi], "-t") == 0) && (argi + 1 < argc))
+            threads = atoi(argv[++argi]);
+        else if (strcmp(argv[argi], "-q") == 0)
+            quiet = 1;
+        else
+            break;
+    } /* for */
+
+    if ((argc - argi != 2) || (threads < 0))
+    {
+        usage(argv[0]);
         return 1;
     } /* if */
 
@@ -154,23 +385,46 @@ int main(int argc, char **argv)
         return 2;
     } /* if */
 
-    if (!PHYSFS_setWriteDir(argv[2]))
+    if (!PHYSFS_setWriteDir(argv[argi + 1]))
     {
         fprintf(stderr, "PHYSFS_setWriteDir('%s') failed: %s\n",
-                argv[2], PHYSFS_getLastError());
+                argv[argi + 1], PHYSFS_getLastError());
         return 3;
     } /* if */
 
-    if (!PHYSFS_mount(argv[1], NULL, 1))
+    if (!PHYSFS_mount(argv[argi], NULL, 1))
     {
         fprintf(stderr, "PHYSFS_mount('%s') failed: %s\n",
-                argv[1], PHYSFS_getLastError());
+                argv[argi], PHYSFS_getLastError());
         return 4;
     } /* if */
 
+    /* without threads, this still works; it just does it all itself. */
+    queue = PHYSFS_createAsyncQueue((PHYSFS_uint32) threads);
+    if (queue == NULL)
+        fail("PHYSFS_createAsyncQueue", NULL);
+
+    start = nowSeconds();
     PHYSFS_permitSymbolicLinks(1);
-    PHYSFS_enumerateFilesCallback("/", unpackCallback, &zero);
+    if (!PHYSFS_walkTree("", unpackCallback, NULL, 0))
+        fail("PHYSFS_walkTree", NULL);
+    dumpFiles();
+    elapsed = nowSeconds() - start;
+
+    PHYSFS_destroyAsyncQueue(queue);
     PHYSFS_deinit();
+
+    printf("%u files, %llu bytes in %.2f seconds",
+           (unsigned int) totalFiles, (unsigned long long) totalBytes,
+           elapsed);
+    if (elapsed > 0.0)
+        printf(" (%.1f MB/s)", ((double) totalBytes) / elapsed / 1048576.0);
+    printf("\n");
+
+    for (i = 0; i < entryCount; i++)
+        free(entries[i].fname);
+    free(entries);
+
     if (failure)
         return 5;
 
@@ -29,14 +29,107 @@
  *
  * This may not work on all platforms, and it probably only works with
  *  .zip files, since they are designed to be appended to another file.
+ *
+ * Better, let the program attach the archive itself:
+ *   gcc -o selfextract.tmp selfextract.c -lphysfs && \
+ *   ./selfextract.tmp --pack myarchive.7z selfextract && \
+ *   chmod a+x selfextract && \
+ *   rm -f selfextract.tmp
+ *
+ * This follows the archive with a trailer that says where it is (see
+ *  PHYSFS_EMBEDDED_TRAILER_MAGIC in physfs.h), so any archive type works,
+ *  and PhysicsFS goes straight to it instead of searching the end of the
+ *  executable for a .zip file's central directory.
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "physfs.h"
 
+/* append all of file (fname) to (out), and count the bytes in (*total). */
+static int appendFile(const char *fname, FILE *out, PHYSFS_uint64 *total)
+{
+    char buf[64 * 1024];
+    FILE *in = fopen(fname, "rb");
+    size_t br;
+    int ok;
+
+    if (in == NULL)
+    {
+        printf("Couldn't open '%s' for reading.\n", fname);
+        return 0;
+    } /* if */
+
+    while ((br = fread(buf, 1, sizeof (buf), in)) > 0)
+    {
+        if (fwrite(buf, 1, br, out) != br)
+            break;
+        *total += br;
+    } /* while */
+
+    ok = ((!ferror(in)) && (!ferror(out)));
+    fclose(in);
+    if (!ok)
+        printf("Couldn't copy '%s'.\n", fname);
+    return ok;
+} /* appendFile */
+
+
+static void writeLE64(unsigned char *ptr, PHYSFS_uint64 val)
+{
+    int i;
+    for (i = 0; i < 8; i++, val >>= 8)
+        ptr[i] = (unsigned char) (val & 0xFF);
+} /* writeLE64 */
+
+
+/* write a copy of (self) with (archive) and an embedded trailer on it. */
+static int pack(const char *self, const char *archive, const char *outname)
+{
+    unsigned char trailer[PHYSFS_EMBEDDED_TRAILER_SIZE];
+    PHYSFS_uint64 offset = 0;
+    PHYSFS_uint64 len = 0;
+    FILE *out = fopen(outname, "wb");
+    int ok;
+
+    if (out == NULL)
+    {
+        printf("Couldn't open '%s' for writing.\n", outname);
+        return 0;
+    } /* if */
+
+    ok = appendFile(self, out, &offset) && appendFile(archive, out, &len);
+    if (ok)
+    {
+        writeLE64(trailer, offset);
+        writeLE64(trailer + 8, len);
+        memcpy(trailer + 16, PHYSFS_EMBEDDED_TRAILER_MAGIC, 8);
+        ok = (fwrite(trailer, sizeof (trailer), 1, out) == 1);
+    } /* if */
+
+    if ((fclose(out) != 0) && (ok))
+        ok = 0;
+    if (!ok)
+        printf("Couldn't write '%s'.\n", outname);
+    else
+    {
+        printf("Packed %llu bytes from '%s' at offset %llu of '%s'.\n",
+               (unsigned long long) len, archive,
+               (unsigned long long) offset, outname);
+    } /* else */
+
+    return ok;
+} /* pack */
+
+
 int main(int argc, char **argv)
 {
     int rc = 0;
+    char **files;
+    char **i;
+
+    if ((argc == 4) && (strcmp(argv[1], "--pack") == 0))
+        return pack(argv[0], argv[2], argv[3]) ? 0 : 42;
 
     if (!PHYSFS_init(argv[0]))
     {
@@ -44,7 +137,7 @@ int main(int argc, char **argv)
         return 42;
     } /* if */
 
-    rc = PHYSFS_addToSearchPath(argv[0], 0);
+    rc = PHYSFS_mount(argv[0], NULL, 0);
     if (!rc)
     {
         printf("Couldn't find self-extract data: %s\n", PHYSFS_getLastError());
@@ -52,8 +145,7 @@ int main(int argc, char **argv)
         return 42;
     } /* if */
 
-    char **files = PHYSFS_enumerateFiles("/");
-    char **i;
+    files = PHYSFS_enumerateFiles("/");
     for (i = files; *i != NULL; i++)
     {
         const char *dirorfile = PHYSFS_isDirectory(*i) ? "Directory" : "File";
@@ -61,6 +153,6 @@ int main(int argc, char **argv)
     } /* for */
     PHYSFS_freeList(files);
 
+    PHYSFS_deinit();
     return 0;
 } /* main */
-
@@ -35,12 +35,32 @@ static char *cvtToDependent(const char *prepend, const char *path, char *buf)
 }
 
 
+typedef struct
+{
+    char *base;  /* the dir's own path, with a dir separator at the end. */
+    void *dir;  /* held open for read-only mounts, if the platform can. */
+} DIRinfo;
+
+#define DIR_BASE(opaque) (((DIRinfo *) (opaque))->base)
+
+/* platformStatAt() wants '/' between elements, and "." for the root. */
+static void *dirHandleFor(void *opaque, const char **name)
+{
+    void *dir = ((DIRinfo *) opaque)->dir;
+    if ((dir == NULL) || (__PHYSFS_platformDirSeparator != '/'))
+        return NULL;
+    if (**name == '\0')
+        *name = ".";
+    return dir;
+} /* dirHandleFor */
+
+
 
 static void *DIR_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 {
     PHYSFS_Stat st;
     const char dirsep = __PHYSFS_platformDirSeparator;
-    char *retval = NULL;
+    DIRinfo *info = NULL;
     const size_t namelen = strlen(name);
     const size_t seplen = 1;
 
@@ -49,19 +69,31 @@ static void *DIR_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
     if (st.filetype != PHYSFS_FILETYPE_DIRECTORY)
         BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
 
-    retval = allocator.Malloc(namelen + seplen + 1);
-    BAIL_IF_MACRO(retval == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    info = (DIRinfo *) allocator.Malloc(sizeof (DIRinfo));
+    BAIL_IF_MACRO(info == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    info->base = (char *) allocator.Malloc(namelen + seplen + 1);
+    if (info->base == NULL)
+    {
+        allocator.Free(info);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
 
-    strcpy(retval, name);
+    strcpy(info->base, name);
 
     /* make sure there's a dir separator at the end of the string */
-    if (retval[namelen - 1] != dirsep)
+    if (info->base[namelen - 1] != dirsep)
     {
-        retval[namelen] = dirsep;
-        retval[namelen + 1] = '\0';
+        info->base[namelen] = dirsep;
+        info->base[namelen + 1] = '\0';
     } /* if */
 
-    return retval;
+    /*
+     * A write dir may get deleted and recreated under us (that's the
+     *  point of having one), so only read-only mounts get held open.
+     */
+    info->dir = (forWriting) ? NULL : __PHYSFS_platformOpenDir(name);
+
+    return info;
 } /* DIR_openArchive */
 
 
@@ -71,7 +103,7 @@ static void DIR_enumerateFiles(void *opaque, const char *dname,
 {
     char *d;
 
-    CVT_TO_DEPENDENT(d, opaque, dname);
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), dname);
     if (d != NULL)
     {
         __PHYSFS_platformEnumerateFiles(d, cb, origdir, callbackdata);
@@ -80,20 +112,55 @@ static void DIR_enumerateFiles(void *opaque, const char *dname,
 } /* DIR_enumerateFiles */
 
 
+static void DIR_enumerateFilesStat(void *opaque, const char *dname,
+                                   PHYSFS_EnumFilesStatCallback cb,
+                                   const char *origdir, void *callbackdata)
+{
+    char *d;
+
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), dname);
+    if (d != NULL)
+    {
+        __PHYSFS_platformEnumerateFilesStat(d, cb, origdir, callbackdata);
+        __PHYSFS_smallFree(d);
+    } /* if */
+} /* DIR_enumerateFilesStat */
+
+
+void __PHYSFS_DIR_enumerateFilesType(void *opaque, const char *dname,
+                                     PHYSFS_EnumFilesStatCallback cb,
+                                     const char *origdir, void *callbackdata)
+{
+    char *d;
+
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), dname);
+    if (d != NULL)
+    {
+        __PHYSFS_platformEnumerateFilesType(d, cb, origdir, callbackdata);
+        __PHYSFS_smallFree(d);
+    } /* if */
+} /* __PHYSFS_DIR_enumerateFilesType */
+
+
 static PHYSFS_Io *doOpen(void *opaque, const char *name, const int mode)
 {
+    const char *relpath = name;
+    void *dir = (mode == 'r') ? dirHandleFor(opaque, &relpath) : NULL;
     PHYSFS_Io *io = NULL;
     char *f = NULL;
 
-    CVT_TO_DEPENDENT(f, opaque, name);
+    CVT_TO_DEPENDENT(f, DIR_BASE(opaque), name);
     BAIL_IF_MACRO(!f, ERRPASS, NULL);
 
-    io = __PHYSFS_createNativeIo(f, mode);
+    io = __PHYSFS_createNativeIoAt(dir, relpath, f, mode);
     if (io == NULL)
     {
         const PHYSFS_ErrorCode err = PHYSFS_getLastErrorCode();
         PHYSFS_Stat statbuf;
-        __PHYSFS_platformStat(f, &statbuf);
+        if (dir != NULL)
+            __PHYSFS_platformStatAt(dir, relpath, &statbuf);
+        else
+            __PHYSFS_platformStat(f, &statbuf);
         PHYSFS_setErrorCode(err);
     } /* if */
 
@@ -126,7 +193,7 @@ static int DIR_remove(void *opaque, const char *name)
     int retval;
     char *f;
 
-    CVT_TO_DEPENDENT(f, opaque, name);
+    CVT_TO_DEPENDENT(f, DIR_BASE(opaque), name);
     BAIL_IF_MACRO(!f, ERRPASS, 0);
     retval = __PHYSFS_platformDelete(f);
     __PHYSFS_smallFree(f);
@@ -139,7 +206,7 @@ static int DIR_mkdir(void *opaque, const char *name)
     int retval;
     char *f;
 
-    CVT_TO_DEPENDENT(f, opaque, name);
+    CVT_TO_DEPENDENT(f, DIR_BASE(opaque), name);
     BAIL_IF_MACRO(!f, ERRPASS, 0);
     retval = __PHYSFS_platformMkDir(f);
     __PHYSFS_smallFree(f);
@@ -147,18 +214,85 @@ static int DIR_mkdir(void *opaque, const char *name)
 } /* DIR_mkdir */
 
 
+int __PHYSFS_DIR_rename(void *opaque, const char *src, const char *dst)
+{
+    int retval = 0;
+    char *s;
+    char *d;
+
+    CVT_TO_DEPENDENT(s, DIR_BASE(opaque), src);
+    BAIL_IF_MACRO(!s, ERRPASS, 0);
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), dst);
+    if (d != NULL)
+    {
+        retval = __PHYSFS_platformRename(s, d);
+        __PHYSFS_smallFree(d);
+    } /* if */
+    __PHYSFS_smallFree(s);
+    return retval;
+} /* __PHYSFS_DIR_rename */
+
+
+int __PHYSFS_DIR_sync(void *opaque, const char *name)
+{
+    int retval;
+    char *f;
+
+    CVT_TO_DEPENDENT(f, DIR_BASE(opaque), name);
+    BAIL_IF_MACRO(!f, ERRPASS, 0);
+    retval = __PHYSFS_platformSyncPath(f);
+    __PHYSFS_smallFree(f);
+    return retval;
+} /* __PHYSFS_DIR_sync */
+
+
+int __PHYSFS_DIR_syncData(void *opaque, const char *name)
+{
+    int retval;
+    char *f;
+
+    CVT_TO_DEPENDENT(f, DIR_BASE(opaque), name);
+    BAIL_IF_MACRO(!f, ERRPASS, 0);
+    retval = __PHYSFS_platformSyncData(f);
+    __PHYSFS_smallFree(f);
+    return retval;
+} /* __PHYSFS_DIR_syncData */
+
+
+int __PHYSFS_DIR_syncFilesystem(void *opaque)
+{
+    int retval;
+    char *d;
+
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), "");
+    BAIL_IF_MACRO(!d, ERRPASS, 0);
+    retval = __PHYSFS_platformSyncFilesystem(d);
+    __PHYSFS_smallFree(d);
+    return retval;
+} /* __PHYSFS_DIR_syncFilesystem */
+
+
 static void DIR_closeArchive(void *opaque)
 {
-    allocator.Free(opaque);
+    DIRinfo *info = (DIRinfo *) opaque;
+    if (info->dir != NULL)
+        __PHYSFS_platformCloseDir(info->dir);
+    allocator.Free(info->base);
+    allocator.Free(info);
 } /* DIR_closeArchive */
 
 
 static int DIR_stat(void *opaque, const char *name, PHYSFS_Stat *stat)
 {
     int retval = 0;
+    void *dir = dirHandleFor(opaque, &name);
     char *d;
 
-    CVT_TO_DEPENDENT(d, opaque, name);
+    /* no path to build, and the kernel starts from the dir, not from "/". */
+    if (dir != NULL)
+        return __PHYSFS_platformStatAt(dir, name, stat);
+
+    CVT_TO_DEPENDENT(d, DIR_BASE(opaque), name);
     BAIL_IF_MACRO(!d, ERRPASS, 0);
     retval = __PHYSFS_platformStat(d, stat);
     __PHYSFS_smallFree(d);
@@ -166,6 +300,21 @@ static int DIR_stat(void *opaque, const char *name, PHYSFS_Stat *stat)
 } /* DIR_stat */
 
 
+static int DIR_layout(void *opaque, const char *name,
+                      PHYSFS_EntryLayout *layout)
+{
+    PHYSFS_Stat statbuf;
+
+    BAIL_IF_MACRO(!DIR_stat(opaque, name, &statbuf), ERRPASS, 0);
+    BAIL_IF_MACRO(statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY,
+                  PHYSFS_ERR_NOT_A_FILE, 0);
+
+    /* every file is its own archive, stored as it is, from the start. */
+    layout->storedSize = layout->size = (PHYSFS_uint64) statbuf.filesize;
+    return 1;
+} /* DIR_layout */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_DIR =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -184,7 +333,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_DIR =
     DIR_remove,
     DIR_mkdir,
     DIR_stat,
-    DIR_closeArchive
+    DIR_closeArchive,
+    DIR_enumerateFilesStat,
+    NULL,  /* claim */
+    NULL,  /* enumerateFilesPrefix */
+    NULL,  /* checksum */
+    DIR_layout
 };
 
 /* end of archiver_dir.c ... */
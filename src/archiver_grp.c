@@ -34,17 +34,22 @@ static UNPKentry *grpLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
     PHYSFS_uint32 location = 16;  /* sizeof sig. */
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 *table = NULL;
+    const PHYSFS_uint8 *rec = NULL;
     char *ptr = NULL;
 
+    table = (PHYSFS_uint8 *) UNPK_readTable(io, fileCount, 16);
+    BAIL_IF_MACRO(!table, ERRPASS, NULL);
+
     entries = (UNPKentry *) allocator.Malloc(sizeof (UNPKentry) * fileCount);
-    BAIL_IF_MACRO(entries == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
 
     location += (16 * fileCount);
 
-    for (entry = entries; fileCount > 0; fileCount--, entry++)
+    for (entry = entries, rec = table; fileCount > 0; fileCount--, entry++)
     {
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->name, 12), ERRPASS, failed);
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->size, 4), ERRPASS, failed);
+        memcpy(entry->name, rec, 12);
+        memcpy(&entry->size, rec + 12, 4);
         entry->name[12] = '\0';  /* name isn't null-terminated in file. */
         if ((ptr = strchr(entry->name, ' ')) != NULL)
             *ptr = '\0';  /* trim extra spaces. */
@@ -52,12 +57,14 @@ static UNPKentry *grpLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
         entry->size = PHYSFS_swapULE32(entry->size);
         entry->startPos = location;
         location += entry->size;
+        rec += 16;
     } /* for */
 
+    allocator.Free(table);
     return entries;
 
 failed:
-    allocator.Free(entries);
+    allocator.Free(table);
     return NULL;
 } /* grpLoadEntries */
 
@@ -85,6 +92,14 @@ static void *GRP_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* GRP_openArchive */
 
 
+static int GRP_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 12) && (memcmp(head, "KenSilverman", 12) == 0));
+} /* GRP_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_GRP =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -103,7 +118,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_GRP =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    GRP_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_GRP */
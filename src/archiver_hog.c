@@ -38,28 +38,34 @@ static UNPKentry *hogLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 *_entCount)
 {
     const PHYSFS_uint64 iolen = io->length(io);
     PHYSFS_uint32 entCount = 0;
+    PHYSFS_uint32 entAlloc = 0;
     void *ptr = NULL;
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 hdr[17];  /* 13 byte name, 4 byte size. */
     PHYSFS_uint32 size = 0;
     PHYSFS_uint32 pos = 3;
 
+    /* headers sit between the files, so there's no table to read at once. */
     while (pos < iolen)
     {
-        entCount++;
-        ptr = allocator.Realloc(ptr, sizeof (UNPKentry) * entCount);
-        GOTO_IF_MACRO(ptr == NULL, PHYSFS_ERR_OUT_OF_MEMORY, failed);
-        entries = (UNPKentry *) ptr;
-        entry = &entries[entCount-1];
-
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->name, 13), ERRPASS, failed);
-        pos += 13;
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &size, 4), ERRPASS, failed);
-        pos += 4;
+        if (entCount == entAlloc)
+        {
+            entAlloc = entAlloc ? entAlloc * 2 : 64;
+            ptr = allocator.Realloc(entries, sizeof (UNPKentry) * entAlloc);
+            GOTO_IF_MACRO(ptr == NULL, PHYSFS_ERR_OUT_OF_MEMORY, failed);
+            entries = (UNPKentry *) ptr;
+        } /* if */
+        entry = &entries[entCount++];
+
+        GOTO_IF_MACRO(!__PHYSFS_readAll(io, hdr, 17), ERRPASS, failed);
+        memcpy(entry->name, hdr, 13);
+        memcpy(&size, hdr + 13, 4);
+        pos += 17;
 
         entry->size = PHYSFS_swapULE32(size);
         entry->startPos = pos;
-        pos += size;
+        pos += entry->size;
 
         /* skip over entry */
         GOTO_IF_MACRO(!io->seek(io, pos), ERRPASS, failed);
@@ -91,6 +97,14 @@ static void *HOG_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* HOG_openArchive */
 
 
+static int HOG_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 3) && (memcmp(head, "DHF", 3) == 0));
+} /* HOG_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_HOG =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -109,7 +123,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_HOG =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    HOG_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_HOG */
@@ -31,8 +31,13 @@
 
 #include <time.h>
 
-/* cache files smaller than this completely in memory */
-#define ISO9660_FULLCACHEMAXSIZE 2048
+/*
+ * each open file reads this much ahead of reads smaller than it; bigger
+ *  reads go straight to the image.
+ */
+#ifndef ISO9660_READAHEAD
+#define ISO9660_READAHEAD (16 * 1024)
+#endif
 
 /* !!! FIXME: this is going to cause trouble. */
 #pragma pack(push)  /* push current alignment to stack */
@@ -196,15 +201,52 @@ typedef struct
 
 #pragma pack(pop)   /* restore original alignment from stack */
 
+/*
+ * One file or directory on the disc, as found by iso_build_index() when the
+ *  image is opened. A directory's children are the (childcount) entries
+ *  starting at index (children), in the order they're recorded on disc.
+ */
+typedef struct
+{
+    char *name;                  /* full path from the root; "" for root. */
+    PHYSFS_uint32 extentpos;
+    PHYSFS_uint32 datalen;
+    PHYSFS_uint8 extattributelen;
+    PHYSFS_uint8 directory;
+    ISO9660FileTimestamp recordtime;
+    PHYSFS_uint32 children;
+    PHYSFS_uint32 childcount;
+} ISO9660Entry;
+
+/*
+ * A sector of the image kept by iso_readimage(), so small reads near each
+ *  other don't all go back to a (possibly slow) image.
+ */
+typedef struct
+{
+    PHYSFS_uint64 sector;        /* which one; (PHYSFS_uint64) -1 if unused. */
+    PHYSFS_uint32 len;           /* bytes of it there are; short at the end. */
+    PHYSFS_uint32 lastuse;       /* sectorclock when it was last read.       */
+    PHYSFS_uint8 data[2048];
+} ISO9660Sector;
+
 typedef struct
 {
     PHYSFS_Io *io;
     PHYSFS_uint32 rootdirstart;
     PHYSFS_uint32 rootdirsize;
-    PHYSFS_uint64 currpos;
     int isjoliet;
-    char *path;
-    void *mutex;
+    ISO9660Entry *entries;       /* every entry; index zero is the root. */
+    PHYSFS_uint32 entrycount;
+    PHYSFS_uint32 entriesallocated;
+    __PHYSFS_HashTable hash;     /* entry indices, hashed by full path.  */
+    __PHYSFS_Arena names;        /* every entry's name lives in here.    */
+    ISO9660Sector *sectors;      /* least recently used one goes first.  */
+    PHYSFS_uint32 sectorcount;   /* zero if we don't cache sectors.      */
+    PHYSFS_uint32 sectorclock;   /* bumped on every cached sector read.  */
+    void *sectorlock;            /* protects the sectors and the clock.  */
+    __PHYSFS_MemAccount *mem;    /* the mount's, for memory accounting.  */
+    PHYSFS_uint64 indexcharged;  /* PHYSFS_MEMORY_INDEX charged to mem.  */
 } ISO9660Handle;
 
 
@@ -214,17 +256,9 @@ typedef struct __ISO9660FileHandle
     PHYSFS_uint64 currpos;
     PHYSFS_uint64 startblock;
     ISO9660Handle *isohandle;
-    PHYSFS_uint32 (*read) (struct __ISO9660FileHandle *filehandle, void *buffer,
-            PHYSFS_uint64 len);
-    int (*seek)(struct __ISO9660FileHandle *filehandle,  PHYSFS_sint64 offset);
-    void (*close)(struct __ISO9660FileHandle *filehandle);
-    /* !!! FIXME: anonymouse union is going to cause problems. */
-    union
-    {
-        /* !!! FIXME: just use a memory PHYSFS_Io here, unify all this code. */
-        char *cacheddata; /* data of file when cached */
-        PHYSFS_Io *io; /* handle to separate opened file */
-    };
+    PHYSFS_uint8 *window;        /* read-ahead buffer; NULL until needed.   */
+    PHYSFS_uint64 windowpos;     /* file offset of window[0].               */
+    PHYSFS_uint32 windowlen;     /* bytes in the window; zero if it's empty. */
 } ISO9660FileHandle;
 
 /*******************************************************************************
@@ -291,14 +325,25 @@ static int iso_extractfilenameISO(ISO9660FileDescriptor *descriptor,
         for(;pos < descriptor->filenamelen; pos++)
             if (descriptor->filename[pos] == ';')
                 lastfound = pos;
+
+        /* some mastering tools leave the version off; that's all name. */
+        if (lastfound == -1)
+        {
+            lastfound = descriptor->filenamelen;
+            *version = 0;
+        } /* if */
+        else
+        {
+            BAIL_IF_MACRO(lastfound == (descriptor->filenamelen -1), PHYSFS_ERR_NOT_FOUND /* !!! PHYSFS_ERR_BAD_FILENAME */, -1);
+            *version = atoi(descriptor->filename + lastfound);
+        } /* else */
         BAIL_IF_MACRO(lastfound < 1, PHYSFS_ERR_NOT_FOUND /* !!! FIXME: PHYSFS_ERR_BAD_FILENAME */, -1);
-        BAIL_IF_MACRO(lastfound == (descriptor->filenamelen -1), PHYSFS_ERR_NOT_FOUND /* !!! PHYSFS_ERR_BAD_FILENAME */, -1);
+
         strncpy(filename, descriptor->filename, lastfound);
         if (filename[lastfound - 1] == '.')
             filename[lastfound - 1] = '\0'; /* consume trailing ., as done in all implementations */
         else
             filename[lastfound] = '\0';
-        *version = atoi(descriptor->filename + lastfound);
     } /* else */
 
     return 0;
@@ -341,129 +386,339 @@ static int iso_extractfilename(ISO9660Handle *handle,
  * Basic image read functions
  ******************************************************************************/
 
-static int iso_readimage(ISO9660Handle *handle, PHYSFS_uint64 where,
-                         void *buffer, PHYSFS_uint64 len)
+/*
+ * The cached copy of (sector), or the least recently used slot to replace
+ *  with it. Call with handle->sectorlock held.
+ */
+static ISO9660Sector *iso_pick_sector(ISO9660Handle *handle,
+                                      const PHYSFS_uint64 sector)
 {
-    BAIL_IF_MACRO(!__PHYSFS_platformGrabMutex(handle->mutex), ERRPASS, -1);
-    int rc = -1;
-    if (where != handle->currpos)
-        GOTO_IF_MACRO(!handle->io->seek(handle->io,where), ERRPASS, unlockme);
-    rc = handle->io->read(handle->io, buffer, len);
-    if (rc == -1)
+    ISO9660Sector *retval = &handle->sectors[0];
+    PHYSFS_uint32 i;
+
+    /* there are only ever a few of these, so just look at them all. */
+    for (i = 0; i < handle->sectorcount; i++)
     {
-        handle->currpos = (PHYSFS_uint64) -1;
-        goto unlockme;
+        ISO9660Sector *slot = &handle->sectors[i];
+        if (slot->sector == sector)
+            return slot;
+        else if ((handle->sectorclock - slot->lastuse) >
+                 (handle->sectorclock - retval->lastuse))
+            retval = slot;
+    } /* for */
+
+    return retval;
+} /* iso_pick_sector */
+
+
+/*
+ * Copy up to (len) bytes from (offset) into (sector) of the image, reading
+ *  and caching the whole sector if we don't have it. Returns bytes copied,
+ *  which is short at the end of the image, or -1 on error.
+ */
+static PHYSFS_sint64 iso_read_sector(ISO9660Handle *handle,
+                                     const PHYSFS_uint64 sector,
+                                     const PHYSFS_uint32 offset,
+                                     void *buffer, PHYSFS_uint32 len)
+{
+    PHYSFS_uint8 data[2048];
+    ISO9660Sector *slot;
+    PHYSFS_sint64 rc;
+
+    __PHYSFS_platformGrabMutex(handle->sectorlock);
+    slot = iso_pick_sector(handle, sector);
+    if (slot->sector != sector)
+    {
+        /* don't hold the lock while the image is slow for us. */
+        __PHYSFS_platformReleaseMutex(handle->sectorlock);
+        rc = __PHYSFS_ioReadAt(handle->io, data, sizeof (data), sector * 2048);
+        BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
+
+        __PHYSFS_platformGrabMutex(handle->sectorlock);
+        slot = iso_pick_sector(handle, sector);
+        slot->sector = sector;
+        slot->len = (PHYSFS_uint32) rc;
+        memcpy(slot->data, data, (size_t) rc);
     } /* if */
-    handle->currpos += rc;
 
-    unlockme:
-    __PHYSFS_platformReleaseMutex(handle->mutex);
-    return rc;
-} /* iso_readimage */
+    slot->lastuse = ++handle->sectorclock;
+    if (offset >= slot->len)
+        len = 0;
+    else if (len > slot->len - offset)
+        len = slot->len - offset;
+    memcpy(buffer, slot->data + offset, len);
+    __PHYSFS_platformReleaseMutex(handle->sectorlock);
 
+    return (PHYSFS_sint64) len;
+} /* iso_read_sector */
 
-static PHYSFS_sint64 iso_readfiledescriptor(ISO9660Handle *handle,
-                                            PHYSFS_uint64 where,
-                                            ISO9660FileDescriptor *descriptor)
+
+/*
+ * Every read goes through here, at an explicit position, so any number of
+ *  open files (on any number of threads) can share handle->io; none of them
+ *  moves its file pointer. Reads of a sector or less come from the sector
+ *  cache; bigger ones would only push out what's worth keeping.
+ */
+static PHYSFS_sint64 iso_readimage(ISO9660Handle *handle, PHYSFS_uint64 where,
+                                   void *buffer, PHYSFS_uint64 len)
 {
-    PHYSFS_sint64 rc = iso_readimage(handle, where, descriptor,
-                                     sizeof (descriptor->recordlen));
-    BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
-    BAIL_IF_MACRO(rc != 1, PHYSFS_ERR_CORRUPT, -1);
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buffer;
+    PHYSFS_sint64 retval = 0;
 
-    if (descriptor->recordlen == 0)
-        return 0; /* fill bytes at the end of a sector */
+    if ((handle->sectorcount == 0) || (len > 2048))
+        return __PHYSFS_ioReadAt(handle->io, buffer, len, where);
+
+    while (len > 0)
+    {
+        const PHYSFS_uint32 offset = (PHYSFS_uint32) (where % 2048);
+        PHYSFS_uint32 chunk = 2048 - offset;
+        PHYSFS_sint64 rc;
+
+        if (chunk > len)
+            chunk = (PHYSFS_uint32) len;
+
+        rc = iso_read_sector(handle, where / 2048, offset, ptr, chunk);
+        BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
+        retval += rc;
+        if (rc < chunk)
+            break;  /* end of the image. */
+
+        ptr += rc;
+        where += rc;
+        len -= rc;
+    } /* while */
+
+    return retval;
+} /* iso_readimage */
 
-    rc = iso_readimage(handle, where + 1, &descriptor->extattributelen,
-            descriptor->recordlen - sizeof(descriptor->recordlen));
-    BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
-    BAIL_IF_MACRO(rc != 1, PHYSFS_ERR_CORRUPT, -1);
+
+/*******************************************************************************
+ * Directory index
+ ******************************************************************************/
+
+/* Index of the entry named (path), or zero if there isn't one. */
+static PHYSFS_uint32 iso_lookup(const ISO9660Handle *handle, const char *path)
+{
+    const PHYSFS_uint32 hashval = __PHYSFS_hashString(path, strlen(path));
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 i;
+
+    while ((i = __PHYSFS_hashTableFind(&handle->hash, hashval, &probe)) != 0)
+    {
+        if (strcmp(handle->entries[i].name, path) == 0)
+            return i;
+    } /* while */
 
     return 0;
-} /* iso_readfiledescriptor */
+} /* iso_lookup */
 
-static void iso_extractsubpath(char *path, char **subpath)
+
+static ISO9660Entry *iso_find_entry(ISO9660Handle *handle, const char *path)
 {
-    *subpath = strchr(path,'/');
-    if (*subpath != 0)
+    PHYSFS_uint32 i;
+
+    if (*path == '\0')
+        return &handle->entries[0];
+
+    i = iso_lookup(handle, path);
+    BAIL_IF_MACRO(i == 0, PHYSFS_ERR_NOT_FOUND, NULL);
+    return &handle->entries[i];
+} /* iso_find_entry */
+
+
+/*
+ * Add the file or directory (descriptor) to the index as a child of entry
+ *  (parent). Returns zero on error; a name we already have is skipped, so
+ *  the first version of a file on the disc wins, as it always did.
+ */
+static int iso_add_entry(ISO9660Handle *handle, const PHYSFS_uint32 parent,
+                         const ISO9660FileDescriptor *descriptor,
+                         const char *filename)
+{
+    const char *parentname = handle->entries[parent].name;
+    const size_t parentlen = strlen(parentname);
+    const size_t namelen = strlen(filename);
+    ISO9660Entry *entry;
+    PHYSFS_uint32 hashval;
+    char *name;
+
+    name = (char *) __PHYSFS_smallAlloc(parentlen + namelen + 2);
+    BAIL_IF_MACRO(!name, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    if (parentlen == 0)
+        strcpy(name, filename);
+    else
     {
-        **subpath = 0;
-        *subpath +=1;
+        memcpy(name, parentname, parentlen);
+        name[parentlen] = '/';
+        strcpy(name + parentlen + 1, filename);
+    } /* else */
+
+    if (iso_lookup(handle, name) != 0)
+    {
+        __PHYSFS_smallFree(name);
+        return 1;
+    } /* if */
+
+    if (handle->entrycount == handle->entriesallocated)
+    {
+        const PHYSFS_uint32 count = handle->entriesallocated * 2;
+        void *ptr;
+        GOTO_IF_MACRO(count <= handle->entriesallocated,
+                      PHYSFS_ERR_OUT_OF_MEMORY, failed);
+        ptr = allocator.Realloc(handle->entries, count * sizeof (ISO9660Entry));
+        GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, failed);
+        handle->entries = (ISO9660Entry *) ptr;
+        handle->entriesallocated = count;
     } /* if */
-} /* iso_extractsubpath */
+
+    hashval = __PHYSFS_hashString(name, strlen(name));
+    GOTO_IF_MACRO(!__PHYSFS_hashTableInsert(&handle->hash, hashval,
+                                            handle->entrycount),
+                  ERRPASS, failed);
+
+    entry = &handle->entries[handle->entrycount];
+    memset(entry, '\0', sizeof (*entry));
+    entry->name = __PHYSFS_arenaStrdup(&handle->names, name);
+    GOTO_IF_MACRO(!entry->name, ERRPASS, failed);  /* hash is harmless. */
+    handle->entrycount++;
+    __PHYSFS_smallFree(name);
+    entry->extentpos = descriptor->extentpos;
+    entry->datalen = descriptor->datalen;
+    entry->extattributelen = descriptor->extattributelen;
+    entry->directory = descriptor->flags.directory;
+    memcpy(&entry->recordtime, &descriptor->recordtime,
+           sizeof (entry->recordtime));
+    handle->entries[parent].childcount++;
+    return 1;
+
+failed:
+    __PHYSFS_smallFree(name);
+    return 0;
+} /* iso_add_entry */
+
 
 /*
- * Don't use path tables, they are not necessarily faster, but more complicated
- * to implement as they store only directories and not files, so searching for
- * a file needs to branch to the directory extent sooner or later.
+ * Read the whole extent of directory entry (dir) in one go and add what's
+ *  in it to the index. Records never straddle a sector; a zero length means
+ *  the rest of the sector is padding.
  */
-static int iso_find_dir_entry(ISO9660Handle *handle,const char *path,
-                              ISO9660FileDescriptor *descriptor)
-{
-    char *subpath = 0;
-    PHYSFS_uint64 readpos, end_of_dir;
-    char filename[255];
-    char pathcopy[256];
-    char *mypath;
+static int iso_load_dir(ISO9660Handle *handle, const PHYSFS_uint32 dir)
+{
+    const PHYSFS_uint64 pos = ((PHYSFS_uint64) handle->entries[dir].extentpos) * 2048;
+    const PHYSFS_uint32 len = handle->entries[dir].datalen;
+    const PHYSFS_sint64 imagelen = handle->io->length(handle->io);
+    ISO9660FileDescriptor descriptor;
+    char filename[256];
+    PHYSFS_uint8 *buf;
+    PHYSFS_uint32 i = 0;
     int version = 0;
 
-    strcpy(pathcopy, path);
-    mypath = pathcopy;
+    BAIL_IF_MACRO(imagelen < 0, ERRPASS, 0);
+    BAIL_IF_MACRO(pos + len > (PHYSFS_uint64) imagelen, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(len > 0x7FFFFFFF, PHYSFS_ERR_CORRUPT, 0);
+    if (len == 0)
+        return 1;  /* nothing in here, not even "." and "..". */
+
+    buf = (PHYSFS_uint8 *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    GOTO_IF_MACRO(iso_readimage(handle, pos, buf, len) != (PHYSFS_sint64) len,
+                  PHYSFS_ERR_CORRUPT, failed);
 
-    readpos = handle->rootdirstart;
-    end_of_dir = handle->rootdirstart + handle->rootdirsize;
-    iso_extractsubpath(mypath, &subpath);
-    while (1)
-    {
-        BAIL_IF_MACRO(iso_readfiledescriptor(handle, readpos, descriptor), ERRPASS, -1);
+    handle->entries[dir].children = handle->entrycount;
 
-        /* recordlen = 0 -> no more entries or fill entry */
-        if (!descriptor->recordlen)
+    while (i < len)
+    {
+        const PHYSFS_uint8 recordlen = buf[i];
+        if (recordlen == 0)
         {
-            /* if we are in the last sector of the directory & it's 0 -> end */
-            if ((end_of_dir - 2048) <= (readpos -1))
-                break; /* finished */
-
-            /* else skip to the next sector & continue; */
-            readpos = (((readpos - 1) / 2048) + 1) * 2048;
+            i = ((i / 2048) + 1) * 2048;  /* skip to the next sector. */
             continue;
         } /* if */
 
-        readpos += descriptor->recordlen;
-        if (descriptor->filenamelen == 1 && (descriptor->filename[0] == 0
-                || descriptor->filename[0] == 1))
+        GOTO_IF_MACRO(recordlen < 34, PHYSFS_ERR_CORRUPT, failed);
+        GOTO_IF_MACRO(recordlen > len - i, PHYSFS_ERR_CORRUPT, failed);
+        memcpy(&descriptor, buf + i, recordlen);
+        i += recordlen;
+        GOTO_IF_MACRO(descriptor.filenamelen > recordlen - 33,
+                      PHYSFS_ERR_CORRUPT, failed);
+
+        if (descriptor.filenamelen == 1 && (descriptor.filename[0] == 0
+                || descriptor.filename[0] == 1))
             continue; /* special ones, ignore */
 
-        BAIL_IF_MACRO(
-            iso_extractfilename(handle, descriptor, filename, &version),
-            ERRPASS, -1);
+        if (iso_extractfilename(handle, &descriptor, filename, &version))
+            continue;
 
-        if (strcmp(filename, mypath) == 0)
-        {
-            if ( (subpath == 0) || (subpath[0] == 0) )
-                return 0;  /* no subpaths left and we found the entry */
-
-            if (descriptor->flags.directory)
-            {
-                /* shorten the path to the subpath */
-                mypath = subpath;
-                iso_extractsubpath(mypath, &subpath);
-                /* gosub to the new directory extent */
-                readpos = descriptor->extentpos * 2048;
-                end_of_dir = readpos + descriptor->datalen;
-            } /* if */
-            else
-            {
-                /* !!! FIXME: set PHYSFS_ERR_NOT_FOUND? */
-                /* we're at a file but have a remaining subpath -> no match */
-                return 0;
-            } /* else */
-        } /* if */
+        /* every record is at least 34 bytes, so a sane disc can't have
+           more of them than this; it stops us going around in circles. */
+        GOTO_IF_MACRO(handle->entrycount >= ((PHYSFS_uint64) imagelen) / 34,
+                      PHYSFS_ERR_CORRUPT, failed);
+        GOTO_IF_MACRO(!iso_add_entry(handle, dir, &descriptor, filename),
+                      ERRPASS, failed);
     } /* while */
 
-    /* !!! FIXME: set PHYSFS_ERR_NOT_FOUND? */
+    allocator.Free(buf);
+    return 1;
+
+failed:
+    allocator.Free(buf);
     return 0;
-} /* iso_find_dir_entry */
+} /* iso_load_dir */
+
+
+/*
+ * Walk the whole directory tree from the root once, when the archive is
+ *  opened, so lookups and enumerations never have to touch the image.
+ *  Don't use path tables; they only list directories, so we'd have to read
+ *  every directory's extent for the files anyhow.
+ *
+ * New directories are appended to handle->entries as they're found, so
+ *  scanning that array front to back visits them all without recursion.
+ */
+static int iso_build_index(ISO9660Handle *handle,
+                           const ISO9660FileTimestamp *roottime)
+{
+    ISO9660Entry *root;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!__PHYSFS_hashTableInit(&handle->hash, 64), ERRPASS, 0);
+    handle->entries = (ISO9660Entry *) allocator.Malloc(64 * sizeof (ISO9660Entry));
+    BAIL_IF_MACRO(!handle->entries, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    handle->entriesallocated = 64;
+
+    root = &handle->entries[0];
+    memset(root, '\0', sizeof (*root));
+    root->name = __PHYSFS_arenaStrdup(&handle->names, "");
+    BAIL_IF_MACRO(!root->name, ERRPASS, 0);
+    root->extentpos = handle->rootdirstart / 2048;
+    root->datalen = handle->rootdirsize;
+    root->directory = 1;
+    memcpy(&root->recordtime, roottime, sizeof (root->recordtime));
+    handle->entrycount = 1;
+
+    for (i = 0; i < handle->entrycount; i++)
+    {
+        if (handle->entries[i].directory)
+            BAIL_IF_MACRO(!iso_load_dir(handle, i), ERRPASS, 0);
+    } /* for */
+
+    handle->indexcharged =
+        (((PHYSFS_uint64) handle->entriesallocated) * sizeof (ISO9660Entry)) +
+        handle->names.size + __PHYSFS_hashTableBytes(&handle->hash);
+    __PHYSFS_memCharge(handle->mem, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) handle->indexcharged);
+    return 1;
+} /* iso_build_index */
+
+
+static void iso_free_index(ISO9660Handle *handle)
+{
+    __PHYSFS_memCharge(handle->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) handle->indexcharged));
+    __PHYSFS_arenaDeinit(&handle->names);
+    allocator.Free(handle->entries);
+    __PHYSFS_hashTableDeinit(&handle->hash);
+} /* iso_free_index */
 
 
 static int iso_read_ext_attributes(ISO9660Handle *handle, int block,
@@ -476,24 +731,33 @@ static int iso_read_ext_attributes(ISO9660Handle *handle, int block,
 
 static int ISO9660_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
 
+static PHYSFS_Io *iso_file_open(ISO9660Handle *handle,
+                                PHYSFS_uint64 startblock,
+                                PHYSFS_sint64 filesize);
+
 static PHYSFS_Io *ISO9660_duplicate(PHYSFS_Io *_io)
 {
-    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);  /* !!! FIXME: write me. */
+    ISO9660FileHandle *fhandle = (ISO9660FileHandle*) _io->opaque;
+    return iso_file_open(fhandle->isohandle, fhandle->startblock,
+                         fhandle->filesize);
 } /* ISO9660_duplicate */
 
 
 static void ISO9660_destroy(PHYSFS_Io *io)
 {
     ISO9660FileHandle *fhandle = (ISO9660FileHandle*) io->opaque;
-    fhandle->close(fhandle);
-    allocator.Free(io);
+    allocator.Free(fhandle->window);
+    __PHYSFS_poolFree(fhandle, sizeof (ISO9660FileHandle));
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
 } /* ISO9660_destroy */
 
 
+static PHYSFS_sint64 iso_file_read(ISO9660FileHandle *fhandle, void *buf,
+                                   PHYSFS_uint64 len);
+
 static PHYSFS_sint64 ISO9660_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
 {
-    ISO9660FileHandle *fhandle = (ISO9660FileHandle*) io->opaque;
-    return fhandle->read(fhandle, buf, len);
+    return iso_file_read((ISO9660FileHandle*) io->opaque, buf, len);
 } /* ISO9660_read */
 
 
@@ -512,7 +776,12 @@ static PHYSFS_sint64 ISO9660_tell(PHYSFS_Io *io)
 static int ISO9660_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 {
     ISO9660FileHandle *fhandle = (ISO9660FileHandle*) io->opaque;
-    return fhandle->seek(fhandle, offset);
+    BAIL_IF_MACRO(offset > (PHYSFS_uint64) fhandle->filesize,
+                  PHYSFS_ERR_PAST_EOF, 0);
+
+    /* nothing to move in the image; reads say where they want to be. */
+    fhandle->currpos = offset;
+    return 1;
 } /* ISO9660_seek */
 
 
@@ -522,6 +791,35 @@ static PHYSFS_sint64 ISO9660_length(PHYSFS_Io *io)
 } /* ISO9660_length */
 
 
+static int iso_file_map(ISO9660FileHandle *fhandle, const void **ptr,
+                        PHYSFS_uint64 *len);
+
+static int ISO9660_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    return iso_file_map((ISO9660FileHandle*) io->opaque, ptr, len);
+} /* ISO9660_map */
+
+
+static PHYSFS_sint64 iso_file_readat(ISO9660FileHandle *fhandle, void *buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 offset);
+
+static PHYSFS_sint64 ISO9660_readAt(PHYSFS_Io *io, void *buf,
+                                    PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    return iso_file_readat((ISO9660FileHandle*) io->opaque, buf, len, offset);
+} /* ISO9660_readAt */
+
+
+static int iso_file_advise(ISO9660FileHandle *fhandle, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint);
+
+static int ISO9660_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                          PHYSFS_uint64 len, int hint)
+{
+    return iso_file_advise((ISO9660FileHandle*) io->opaque, offset, len, hint);
+} /* ISO9660_advise */
+
+
 static const PHYSFS_Io ISO9660_Io =
 {
     CURRENT_PHYSFS_IO_API_VERSION, NULL,
@@ -532,7 +830,11 @@ static const PHYSFS_Io ISO9660_Io =
     ISO9660_length,
     ISO9660_duplicate,
     ISO9660_flush,
-    ISO9660_destroy
+    ISO9660_destroy,
+    ISO9660_map,
+    ISO9660_readAt,
+    NULL,  /* readv */
+    ISO9660_advise
 };
 
 
@@ -540,10 +842,58 @@ static const PHYSFS_Io ISO9660_Io =
  * Archive management functions
  ******************************************************************************/
 
+static int iso_alloc_sectors(ISO9660Handle *handle)
+{
+    PHYSFS_uint32 count = __PHYSFS_getSectorCacheSize();
+    PHYSFS_uint32 i;
+
+    /* fewer sectors, or none, if caches are near their memory limit. */
+    while ((count > 0) &&
+           (!__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES,
+                                 ((PHYSFS_uint64) count) *
+                                    sizeof (ISO9660Sector))))
+        count /= 2;
+
+    if (count == 0)
+        return 1;  /* not caching. */
+
+    BAIL_IF_MACRO(count > 0xFFFFFFFF / sizeof (ISO9660Sector),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    handle->sectors = (ISO9660Sector *)
+                        allocator.Malloc(count * sizeof (ISO9660Sector));
+    BAIL_IF_MACRO(!handle->sectors, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    handle->sectorlock = __PHYSFS_platformCreateMutex();
+    BAIL_IF_MACRO(!handle->sectorlock, ERRPASS, 0);
+
+    for (i = 0; i < count; i++)
+    {
+        handle->sectors[i].sector = (PHYSFS_uint64) -1;
+        handle->sectors[i].len = 0;
+        handle->sectors[i].lastuse = 0;
+    } /* for */
+
+    handle->sectorcount = count;
+    __PHYSFS_memCharge(handle->mem, PHYSFS_MEMORY_CACHES,
+                       (PHYSFS_sint64) (count * sizeof (ISO9660Sector)));
+    return 1;
+} /* iso_alloc_sectors */
+
+
+static void iso_free_sectors(ISO9660Handle *handle)
+{
+    __PHYSFS_memCharge(handle->mem, PHYSFS_MEMORY_CACHES,
+        -((PHYSFS_sint64) (handle->sectorcount * sizeof (ISO9660Sector))));
+    if (handle->sectorlock)
+        __PHYSFS_platformDestroyMutex(handle->sectorlock);
+    allocator.Free(handle->sectors);
+} /* iso_free_sectors */
+
+
 static void *ISO9660_openArchive(PHYSFS_Io *io, const char *filename, int forWriting)
 {
     char magicnumber[6];
     ISO9660Handle *handle;
+    ISO9660FileTimestamp roottime;
     int founddescriptor = 0;
     int foundjoliet = 0;
 
@@ -554,23 +904,15 @@ static void *ISO9660_openArchive(PHYSFS_Io *io, const char *filename, int forWri
     /* Skip system area to magic number in Volume descriptor */
     BAIL_IF_MACRO(!io->seek(io, 32769), ERRPASS, NULL);
     BAIL_IF_MACRO(io->read(io, magicnumber, 5) != 5, ERRPASS, NULL);
-    if (memcmp(magicnumber, "CD001", 6) != 0)
+    if (memcmp(magicnumber, "CD001", 5) != 0)
         BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
 
     handle = allocator.Malloc(sizeof(ISO9660Handle));
     GOTO_IF_MACRO(!handle, PHYSFS_ERR_OUT_OF_MEMORY, errorcleanup);
-    handle->path = 0;
-    handle->mutex= 0;
-    handle->io = NULL;
-
-    handle->path = allocator.Malloc(strlen(filename) + 1);
-    GOTO_IF_MACRO(!handle->path, PHYSFS_ERR_OUT_OF_MEMORY, errorcleanup);
-    strcpy(handle->path, filename);
-
-    handle->mutex = __PHYSFS_platformCreateMutex();
-    GOTO_IF_MACRO(!handle->mutex, ERRPASS, errorcleanup);
+    memset(handle, '\0', sizeof (ISO9660Handle));
 
     handle->io = io;
+    handle->mem = __PHYSFS_memMountAccount();
 
     /* seek Primary Volume Descriptor */
     GOTO_IF_MACRO(!io->seek(io, 32768), PHYSFS_ERR_IO, errorcleanup);
@@ -584,18 +926,17 @@ static void *ISO9660_openArchive(PHYSFS_Io *io, const char *filename, int forWri
         if (descriptor.type == 255)
         {
             /* type 255 terminates the volume descriptor list */
-            if (founddescriptor)
-                return handle; /* ok, we've found one volume descriptor */
-            else
-                GOTO_MACRO(PHYSFS_ERR_CORRUPT, errorcleanup);
+            GOTO_IF_MACRO(!founddescriptor, PHYSFS_ERR_CORRUPT, errorcleanup);
+            break;  /* ok, we've found one volume descriptor */
         } /* if */
         if (descriptor.type == 1 && !founddescriptor)
         {
-            handle->currpos = io->tell(io);
             handle->rootdirstart =
                     descriptor.rootdirectory.extent_location * 2048;
             handle->rootdirsize =
                     descriptor.rootdirectory.data_length;
+            memcpy(&roottime, &descriptor.rootdirectory.timestamp,
+                   sizeof (roottime));
             handle->isjoliet = 0;
             founddescriptor = 1; /* continue search for joliet */
         } /* if */
@@ -610,26 +951,27 @@ static void *ISO9660_openArchive(PHYSFS_Io *io, const char *filename, int forWri
             if (!joliet)
                 continue;
 
-            handle->currpos = io->tell(io);
             handle->rootdirstart =
                     descriptor.rootdirectory.extent_location * 2048;
             handle->rootdirsize =
                     descriptor.rootdirectory.data_length;
+            memcpy(&roottime, &descriptor.rootdirectory.timestamp,
+                   sizeof (roottime));
             handle->isjoliet = 1;
             founddescriptor = 1;
             foundjoliet = 1;
         } /* if */
     } /* while */
 
-    GOTO_MACRO(PHYSFS_ERR_CORRUPT, errorcleanup);  /* not found. */
+    GOTO_IF_MACRO(!iso_alloc_sectors(handle), ERRPASS, errorcleanup);
+    GOTO_IF_MACRO(!iso_build_index(handle, &roottime), ERRPASS, errorcleanup);
+    return handle;
 
 errorcleanup:
     if (handle)
     {
-        if (handle->path)
-            allocator.Free(handle->path);
-        if (handle->mutex)
-            __PHYSFS_platformDestroyMutex(handle->mutex);
+        iso_free_index(handle);
+        iso_free_sectors(handle);
         allocator.Free(handle);
     } /* if */
     return NULL;
@@ -640,8 +982,8 @@ static void ISO9660_closeArchive(void *opaque)
 {
     ISO9660Handle *handle = (ISO9660Handle*) opaque;
     handle->io->destroy(handle->io);
-    __PHYSFS_platformDestroyMutex(handle->mutex);
-    allocator.Free(handle->path);
+    iso_free_index(handle);
+    iso_free_sectors(handle);
     allocator.Free(handle);
 } /* ISO9660_closeArchive */
 
@@ -651,159 +993,158 @@ static void ISO9660_closeArchive(void *opaque)
  ******************************************************************************/
 
 
-static PHYSFS_uint32 iso_file_read_mem(ISO9660FileHandle *filehandle,
-                                       void *buffer, PHYSFS_uint64 len)
+/*
+ * Read from the image for (fhandle), at its position. Small reads are
+ *  served from a window of up to ISO9660_READAHEAD bytes, refilled with one
+ *  read from wherever they left off, so reading a file a little at a time
+ *  doesn't go to the image every time, and memory stays bounded however big
+ *  the file is.
+ */
+static PHYSFS_sint64 iso_file_read(ISO9660FileHandle *fhandle, void *buf,
+                                   PHYSFS_uint64 len)
 {
+    const PHYSFS_uint64 filesize = (PHYSFS_uint64) fhandle->filesize;
+    const PHYSFS_uint64 start = fhandle->startblock * 2048;
+    const PHYSFS_uint64 pos = fhandle->currpos;
+    PHYSFS_sint64 rc;
+
     /* check remaining bytes & max obj which can be fetched */
-    const PHYSFS_sint64 bytesleft = filehandle->filesize - filehandle->currpos;
-    if (bytesleft < len)
-        len = bytesleft;
+    if (len > filesize - pos)
+        len = filesize - pos;
 
     if (len == 0)
         return 0;
 
-    memcpy(buffer, filehandle->cacheddata + filehandle->currpos, (size_t) len);
-
-    filehandle->currpos += len;
-    return (PHYSFS_uint32) len;
-} /* iso_file_read_mem */
-
+    if (len >= ISO9660_READAHEAD)
+    {
+        rc = iso_readimage(fhandle->isohandle, start + pos, buf, len);
+        BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
+        BAIL_IF_MACRO(rc < len, PHYSFS_ERR_CORRUPT, -1);
+        fhandle->currpos += len;
+        return (PHYSFS_sint64) len;
+    } /* if */
 
-static int iso_file_seek_mem(ISO9660FileHandle *fhandle, PHYSFS_sint64 offset)
-{
-    BAIL_IF_MACRO(offset < 0, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(offset >= fhandle->filesize, PHYSFS_ERR_PAST_EOF, 0);
+    if ((pos < fhandle->windowpos) ||
+        (pos + len > fhandle->windowpos + fhandle->windowlen))
+    {
+        PHYSFS_uint64 fill = filesize - pos;
+        if (fill > ISO9660_READAHEAD)
+            fill = ISO9660_READAHEAD;
 
-    fhandle->currpos = offset;
-    return 0;
-} /* iso_file_seek_mem */
+        if (fhandle->window == NULL)
+        {
+            fhandle->window = (PHYSFS_uint8 *) allocator.Malloc(ISO9660_READAHEAD);
+            BAIL_IF_MACRO(!fhandle->window, PHYSFS_ERR_OUT_OF_MEMORY, -1);
+        } /* if */
 
+        fhandle->windowlen = 0;  /* in case this fails. */
+        rc = iso_readimage(fhandle->isohandle, start + pos,
+                           fhandle->window, fill);
+        BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
+        BAIL_IF_MACRO(rc < fill, PHYSFS_ERR_CORRUPT, -1);
+        fhandle->windowpos = pos;
+        fhandle->windowlen = (PHYSFS_uint32) fill;
+    } /* if */
 
-static void iso_file_close_mem(ISO9660FileHandle *fhandle)
-{
-    allocator.Free(fhandle->cacheddata);
-    allocator.Free(fhandle);
-} /* iso_file_close_mem */
+    memcpy(buf, fhandle->window + (pos - fhandle->windowpos), (size_t) len);
+    fhandle->currpos += len;
+    return (PHYSFS_sint64) len;
+} /* iso_file_read */
 
 
-static PHYSFS_uint32 iso_file_read_foreign(ISO9660FileHandle *filehandle,
-                                           void *buffer, PHYSFS_uint64 len)
+static int iso_file_map(ISO9660FileHandle *fhandle, const void **ptr,
+                        PHYSFS_uint64 *len)
 {
-    /* check remaining bytes & max obj which can be fetched */
-    const PHYSFS_sint64 bytesleft = filehandle->filesize - filehandle->currpos;
-    if (bytesleft < len)
-        len = bytesleft;
-
-    const PHYSFS_sint64 rc = filehandle->io->read(filehandle->io, buffer, len);
-    BAIL_IF_MACRO(rc == -1, ERRPASS, -1);
-
-    filehandle->currpos += rc; /* i trust my internal book keeping */
-    BAIL_IF_MACRO(rc < len, PHYSFS_ERR_CORRUPT, -1);
-    return rc;
-} /* iso_file_read_foreign */
+    ISO9660Handle *handle = fhandle->isohandle;
+    const PHYSFS_uint64 pos = fhandle->startblock * 2048;
+    const PHYSFS_uint8 *image = NULL;
+    PHYSFS_uint64 imagelen = 0;
 
+    /* file data is contiguous in the image, so point into it if mapped. */
+    if (!__PHYSFS_ioMap(handle->io, (const void **) &image, &imagelen))
+        return 0;
 
-static int iso_file_seek_foreign(ISO9660FileHandle *fhandle,
-                                 PHYSFS_sint64 offset)
-{
-    BAIL_IF_MACRO(offset < 0, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(offset >= fhandle->filesize, PHYSFS_ERR_PAST_EOF, 0);
-
-    PHYSFS_sint64 pos = fhandle->startblock * 2048 + offset;
-    BAIL_IF_MACRO(!fhandle->io->seek(fhandle->io, pos), ERRPASS, -1);
+    BAIL_IF_MACRO(pos > imagelen, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(((PHYSFS_uint64) fhandle->filesize) > imagelen - pos,
+                  PHYSFS_ERR_CORRUPT, 0);
 
-    fhandle->currpos = offset;
-    return 0;
-} /* iso_file_seek_foreign */
+    *ptr = image + pos;
+    *len = (PHYSFS_uint64) fhandle->filesize;
+    return 1;
+} /* iso_file_map */
 
 
-static void iso_file_close_foreign(ISO9660FileHandle *fhandle)
+static PHYSFS_sint64 iso_file_readat(ISO9660FileHandle *fhandle, void *buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 offset)
 {
-    fhandle->io->destroy(fhandle->io);
-    allocator.Free(fhandle);
-} /* iso_file_close_foreign */
+    const PHYSFS_uint64 filesize = (PHYSFS_uint64) fhandle->filesize;
 
+    if (offset >= filesize)
+        return 0;
 
-static int iso_file_open_mem(ISO9660Handle *handle, ISO9660FileHandle *fhandle)
-{
-    fhandle->cacheddata = allocator.Malloc(fhandle->filesize);
-    BAIL_IF_MACRO(!fhandle->cacheddata, PHYSFS_ERR_OUT_OF_MEMORY, -1);
-    int rc = iso_readimage(handle, fhandle->startblock * 2048,
-                           fhandle->cacheddata, fhandle->filesize);
-    GOTO_IF_MACRO(rc < 0, ERRPASS, freemem);
-    GOTO_IF_MACRO(rc == 0, PHYSFS_ERR_CORRUPT, freemem);
-
-    fhandle->read = iso_file_read_mem;
-    fhandle->seek = iso_file_seek_mem;
-    fhandle->close = iso_file_close_mem;
-    return 0;
+    if (len > filesize - offset)
+        len = filesize - offset;
 
-freemem:
-    allocator.Free(fhandle->cacheddata);
-    return -1;
-} /* iso_file_open_mem */
+    /* leave the window alone; another thread may be reading through it. */
+    return iso_readimage(fhandle->isohandle,
+                         (fhandle->startblock * 2048) + offset, buf, len);
+} /* iso_file_readat */
 
 
-static int iso_file_open_foreign(ISO9660Handle *handle,
-                                 ISO9660FileHandle *fhandle)
+static int iso_file_advise(ISO9660FileHandle *fhandle, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint)
 {
-    int rc;
-    fhandle->io = __PHYSFS_createNativeIo(handle->path, 'r');
-    BAIL_IF_MACRO(!fhandle->io, ERRPASS, -1);
-    rc = fhandle->io->seek(fhandle->io, fhandle->startblock * 2048);
-    GOTO_IF_MACRO(!rc, ERRPASS, closefile);
+    const PHYSFS_uint64 filesize = (PHYSFS_uint64) fhandle->filesize;
 
-    fhandle->read = iso_file_read_foreign;
-    fhandle->seek = iso_file_seek_foreign;
-    fhandle->close = iso_file_close_foreign;
-    return 0;
-
-closefile:
-    fhandle->io->destroy(fhandle->io);
-    return -1;
-} /* iso_file_open_foreign */
+    /* file data is contiguous in the image, so just shift the range. */
+    if (offset >= filesize)
+        return 1;  /* nothing there to hint about. */
+    else if ((len == 0) || (len > filesize - offset))
+        len = filesize - offset;
+    return __PHYSFS_ioAdvise(fhandle->isohandle->io,
+                             (fhandle->startblock * 2048) + offset, len, hint);
+} /* iso_file_advise */
 
 
-static PHYSFS_Io *ISO9660_openRead(void *opaque, const char *filename)
+static PHYSFS_Io *iso_file_open(ISO9660Handle *handle,
+                                PHYSFS_uint64 startblock,
+                                PHYSFS_sint64 filesize)
 {
     PHYSFS_Io *retval = NULL;
-    ISO9660Handle *handle = (ISO9660Handle*) opaque;
     ISO9660FileHandle *fhandle;
-    ISO9660FileDescriptor descriptor;
-    int rc;
-
-    fhandle = allocator.Malloc(sizeof(ISO9660FileHandle));
-    BAIL_IF_MACRO(fhandle == 0, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    fhandle->cacheddata = 0;
 
-    retval = allocator.Malloc(sizeof(PHYSFS_Io));
-    GOTO_IF_MACRO(retval == 0, PHYSFS_ERR_OUT_OF_MEMORY, errorhandling);
+    fhandle = __PHYSFS_poolAlloc(sizeof (ISO9660FileHandle));
+    BAIL_IF_MACRO(fhandle == 0, ERRPASS, NULL);
 
-    /* find file descriptor */
-    rc = iso_find_dir_entry(handle, filename, &descriptor);
-    GOTO_IF_MACRO(rc, ERRPASS, errorhandling);
+    retval = __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(retval == 0, ERRPASS, errorhandling);
 
-    fhandle->startblock = descriptor.extentpos + descriptor.extattributelen;
-    fhandle->filesize = descriptor.datalen;
-    fhandle->currpos = 0;
+    /* files share handle->io, so there's nothing to open. */
+    memset(fhandle, '\0', sizeof (ISO9660FileHandle));
+    fhandle->startblock = startblock;
+    fhandle->filesize = filesize;
     fhandle->isohandle = handle;
-    fhandle->cacheddata = NULL;
-    fhandle->io = NULL;
-
-    if (descriptor.datalen <= ISO9660_FULLCACHEMAXSIZE)
-        rc = iso_file_open_mem(handle, fhandle);
-    else
-        rc = iso_file_open_foreign(handle, fhandle);
-    GOTO_IF_MACRO(rc, ERRPASS, errorhandling);
 
     memcpy(retval, &ISO9660_Io, sizeof (PHYSFS_Io));
     retval->opaque = fhandle;
     return retval;
 
 errorhandling:
-    if (retval) allocator.Free(retval);
-    if (fhandle) allocator.Free(fhandle);
+    __PHYSFS_poolFree(fhandle, sizeof (ISO9660FileHandle));
     return NULL;
+} /* iso_file_open */
+
+
+static PHYSFS_Io *ISO9660_openRead(void *opaque, const char *filename)
+{
+    ISO9660Handle *handle = (ISO9660Handle*) opaque;
+    const ISO9660Entry *entry = iso_find_entry(handle, filename);
+
+    BAIL_IF_MACRO(!entry, ERRPASS, NULL);
+    BAIL_IF_MACRO(entry->directory, PHYSFS_ERR_NOT_A_FILE, NULL);
+
+    return iso_file_open(handle, entry->extentpos + entry->extattributelen,
+                         entry->datalen);
 } /* ISO9660_openRead */
 
 
@@ -817,88 +1158,54 @@ static void ISO9660_enumerateFiles(void *opaque, const char *dname,
                                    const char *origdir, void *callbackdata)
 {
     ISO9660Handle *handle = (ISO9660Handle*) opaque;
-    ISO9660FileDescriptor descriptor;
-    PHYSFS_uint64 readpos;
-    PHYSFS_uint64 end_of_dir;
-    char filename[130]; /* ISO allows 31, Joliet 128 -> 128 + 2 eol bytes */
-    int version = 0;
-
-    if (*dname == '\0')
-    {
-        readpos = handle->rootdirstart;
-        end_of_dir = readpos + handle->rootdirsize;
-    } /* if */
-    else
-    {
-        printf("pfad %s\n",dname);
-        BAIL_IF_MACRO(iso_find_dir_entry(handle,dname, &descriptor), ERRPASS,);
-        BAIL_IF_MACRO(!descriptor.flags.directory, ERRPASS,);
+    const ISO9660Entry *entry = iso_find_entry(handle, dname);
+    PHYSFS_uint32 i;
 
-        readpos = descriptor.extentpos * 2048;
-        end_of_dir = readpos + descriptor.datalen;
-    } /* else */
+    BAIL_IF_MACRO(!entry, ERRPASS,);
+    BAIL_IF_MACRO(!entry->directory, PHYSFS_ERR_NOT_FOUND,);
 
-    while (1)
+    for (i = 0; i < entry->childcount; i++)
     {
-        BAIL_IF_MACRO(iso_readfiledescriptor(handle, readpos, &descriptor), ERRPASS, );
-
-        /* recordlen = 0 -> no more entries or fill entry */
-        if (!descriptor.recordlen)
-        {
-            /* if we are in the last sector of the directory & it's 0 -> end */
-            if ((end_of_dir - 2048) <= (readpos -1))
-                break;  /* finished */
-
-            /* else skip to the next sector & continue; */
-            readpos = (((readpos - 1) / 2048) + 1) * 2048;
-            continue;
-        } /* if */
-
-        readpos +=  descriptor.recordlen;
-        if (descriptor.filenamelen == 1 && (descriptor.filename[0] == 0
-                || descriptor.filename[0] == 1))
-            continue; /* special ones, ignore */
-
-        strncpy(filename,descriptor.filename,descriptor.filenamelen);
-        iso_extractfilename(handle, &descriptor, filename, &version);
-        cb(callbackdata, origdir,filename);
-    } /* while */
+        const char *name = handle->entries[entry->children + i].name;
+        const char *ptr = strrchr(name, '/');
+        cb(callbackdata, origdir, ptr ? ptr + 1 : name);
+    } /* for */
 } /* ISO9660_enumerateFiles */
 
 
 static int ISO9660_stat(void *opaque, const char *name, PHYSFS_Stat *stat)
 {
     ISO9660Handle *handle = (ISO9660Handle*) opaque;
-    ISO9660FileDescriptor descriptor;
+    ISO9660Entry *entry = iso_find_entry(handle, name);
     ISO9660ExtAttributeRec extattr;
-    BAIL_IF_MACRO(iso_find_dir_entry(handle, name, &descriptor), ERRPASS, -1);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
 
     stat->readonly = 1;
 
     /* try to get extended info */
-    if (descriptor.extattributelen)
+    if (entry->extattributelen)
     {
         BAIL_IF_MACRO(iso_read_ext_attributes(handle,
-                descriptor.extentpos, &extattr), ERRPASS, -1);
+                entry->extentpos, &extattr) == -1, ERRPASS, 0);
         stat->createtime = iso_volume_mktime(&extattr.create_time);
         stat->modtime = iso_volume_mktime(&extattr.mod_time);
         stat->accesstime = iso_volume_mktime(&extattr.mod_time);
     } /* if */
     else
     {
-        stat->createtime = iso_mktime(&descriptor.recordtime);
-        stat->modtime = iso_mktime(&descriptor.recordtime);
-        stat->accesstime = iso_mktime(&descriptor.recordtime);
+        stat->createtime = iso_mktime(&entry->recordtime);
+        stat->modtime = iso_mktime(&entry->recordtime);
+        stat->accesstime = iso_mktime(&entry->recordtime);
     } /* else */
 
-    if (descriptor.flags.directory)
+    if (entry->directory)
     {
         stat->filesize = 0;
         stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
     } /* if */
     else
     {
-        stat->filesize = descriptor.datalen;
+        stat->filesize = entry->datalen;
         stat->filetype = PHYSFS_FILETYPE_REGULAR;
     } /* else */
 
@@ -906,6 +1213,23 @@ static int ISO9660_stat(void *opaque, const char *name, PHYSFS_Stat *stat)
 } /* ISO9660_stat */
 
 
+static int ISO9660_layout(void *opaque, const char *name,
+                          PHYSFS_EntryLayout *layout)
+{
+    ISO9660Handle *handle = (ISO9660Handle*) opaque;
+    const ISO9660Entry *entry = iso_find_entry(handle, name);
+
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->directory, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    /* file data is contiguous in the image, past any extended attributes. */
+    layout->offset = (((PHYSFS_uint64) entry->extentpos) +
+                      entry->extattributelen) * 2048;
+    layout->storedSize = layout->size = entry->datalen;
+    return 1;
+} /* ISO9660_layout */
+
+
 /*******************************************************************************
  * Not supported functions
  ******************************************************************************/
@@ -934,6 +1258,16 @@ static int ISO9660_mkdir(void *opaque, const char *name)
 } /* ISO9660_mkdir */
 
 
+static int ISO9660_claim(const void *head, PHYSFS_uint64 headLen,
+                         const void *tail, PHYSFS_uint64 tailLen,
+                         PHYSFS_uint64 fileLen)
+{
+    /* the first volume descriptor's magic number, past the system area. */
+    const char *ptr = ((const char *) head) + 32769;
+    return ((headLen >= 32774) && (memcmp(ptr, "CD001", 5) == 0));
+} /* ISO9660_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_ISO9660 =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -952,7 +1286,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_ISO9660 =
     ISO9660_remove,
     ISO9660_mkdir,
     ISO9660_stat,
-    ISO9660_closeArchive
+    ISO9660_closeArchive,
+    NULL,  /* enumerateFilesStat */
+    ISO9660_claim,
+    NULL,  /* enumerateFilesPrefix */
+    NULL,  /* checksum */
+    ISO9660_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_ISO9660 */
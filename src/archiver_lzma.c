@@ -15,6 +15,7 @@
 #include "lzma/C/7zCrc.h"
 #include "lzma/C/Archive/7z/7zIn.h"
 #include "lzma/C/Archive/7z/7zExtract.h"
+#include "lzma/C/Compress/Lzma/Lzma2StateDecode.h"
 
 
 /* 7z internal from 7zIn.c */
@@ -25,9 +26,46 @@ extern int TestSignatureCandidate(Byte *testBytes);
 # define BUFFER_SIZE (1 << 12)
 #endif /* _LZMA_IN_CB */
 
+/* 7z method IDs of stored data, plain LZMA and LZMA2, from 7zDecode.c */
+#define COPY_METHOD_ID 0x0
+#define LZMA_METHOD_ID 0x30101
+#define LZMA2_METHOD_ID 0x21
+
+/* Bytes of compressed data a folder stream reads from the archive at once. */
+#define LZMA_STREAM_BUFSIZE (1 << 16)
+
+/* Most bytes a folder stream decodes at once when skipping ahead. */
+#define LZMA_STREAM_SKIPSIZE (1 << 14)
+
+/* Bytes lzma_window_read() reads at once while opening an archive. */
+#define LZMA_HEADER_WINDOW (1 << 16)
+
+/*
+ * Decodes a folder from its start, as far as it's read and no further,
+ *  instead of all of it up front. Only used for folders that are plain
+ *  LZMA or LZMA2 and aren't cached; see lzma_folder_streams().
+ */
+typedef struct _LZMAstream
+{
+    CLzma2DecoderState state; /* For 7z: decoder, and its recent output */
+    int lzma2; /* Nonzero if (state) decodes LZMA2, not just (state.Lzma) */
+    PHYSFS_uint64 size; /* Size of folder */
+    PHYSFS_uint64 position; /* Bytes of folder decoded so far */
+    PHYSFS_uint64 pack_pos; /* Archive offset of next compressed byte */
+    PHYSFS_uint64 pack_left; /* Compressed bytes not read into buffer */
+    UInt32 crc; /* CRC of the first (position) bytes of folder */
+    size_t start; /* Where the undecoded bytes in buffer start */
+    size_t avail; /* How many undecoded bytes buffer holds */
+    PHYSFS_uint64 charged; /* PHYSFS_MEMORY_DECODERS charged for this */
+    PHYSFS_uint8 buffer[LZMA_STREAM_BUFSIZE]; /* Compressed bytes */
+    PHYSFS_uint8 scratch[LZMA_STREAM_SKIPSIZE]; /* For bytes skipped over */
+} LZMAstream;
+
 
 /*
- * Carries filestream metadata through 7z
+ * Carries filestream metadata through 7z. It keeps its own position and
+ *  reads with __PHYSFS_ioReadAt(), so copies of it can read the same (io)
+ *  from several threads at once.
  */
 typedef struct _FileInputStream
 {
@@ -35,6 +73,10 @@ typedef struct _FileInputStream
     ISzAlloc allocTempImp; /* Temporary allocation implementation, used by 7z */
     ISzInStream inStream; /* Input stream with read callbacks, used by 7z */
     PHYSFS_Io *io;  /* Filehandle, used by read implementation */
+    PHYSFS_uint64 pos; /* Where the next read from (io) starts */
+    PHYSFS_uint8 *window; /* Recently read bytes, or NULL after opening */
+    PHYSFS_uint64 window_pos; /* Offset in (io) of window[0] */
+    size_t window_len; /* Bytes in (window) */
 #ifdef _LZMA_IN_CB
     Byte buffer[BUFFER_SIZE]; /* Buffer, used by read implementation */
 #endif /* _LZMA_IN_CB */
@@ -43,6 +85,25 @@ typedef struct _FileInputStream
 /*
  * In the 7z format archives are splited into blocks, those are called folders
  * Set by LZMA_read()
+ *
+ * Decompressed folders sit on their archive's LRU list, most recently read
+ *  first. Once the decompressed folders add up to more than
+ *  __PHYSFS_getDecompressionCacheSize(), the least recently read ones are
+ *  dropped, open or not, and decompressed again if they're read later.
+ *  Folders that LZMA_map() handed out a pointer into stay until the last
+ *  file using them is closed. With no budget set, every folder stays until
+ *  the last file using it is closed, and no longer.
+ *
+ * Plain LZMA and LZMA2 folders bigger than that budget aren't decompressed whole to
+ *  be read at all: an LZMAstream decodes them only as far as they're read.
+ *  Folders stored with the Copy method are never decompressed or cached;
+ *  reads go straight to where their files are in the archive.
+ *
+ * Threads reading different folders don't wait for each other. The
+ *  archive's lock covers the LRU list and every folder's fields, but it's
+ *  never held while decoding. Decoding a folder, whole or by its stream,
+ *  holds that folder's latch instead, so the first thread to need it
+ *  decodes it, and the rest wait for that and then use what it decoded.
 */
 typedef struct _LZMAfolder
 {
@@ -50,6 +111,16 @@ typedef struct _LZMAfolder
     PHYSFS_uint32 references; /* Number of files using this block */
     PHYSFS_uint8 *cache; /* Cached folder */
     size_t size; /* Size of folder */
+    void *spill; /* Mapped spill file (cache) points into, or NULL */
+    int mapped; /* Nonzero if an open file mapped (cache). */
+    int streamable; /* Nonzero if plain LZMA(2), which LZMAstream can do. */
+    int copy; /* Nonzero if stored as it is, so it's read in place. */
+    PHYSFS_uint64 pack_pos; /* Archive offset of a (copy) folder's data */
+    LZMAstream *stream; /* Decoder for reading without (cache), or NULL */
+    void *latch; /* Held while decoding, made on first use, or NULL */
+    PHYSFS_uint32 pins; /* Reads copying out of (cache) right now */
+    struct _LZMAfolder *lru_prev; /* Next more recently read cached folder */
+    struct _LZMAfolder *lru_next; /* Next less recently read cached folder */
 } LZMAfolder;
 
 /*
@@ -60,11 +131,20 @@ typedef struct _LZMAarchive
 {
     struct _LZMAfile *files; /* Array of files, size == archive->db.Database.NumFiles */
     LZMAfolder *folders; /* Array of folders, size == archive->db.Database.NumFolders */
+    LZMAfolder *lru_head; /* Most recently read cached folder */
+    LZMAfolder *lru_tail; /* Least recently read cached folder */
+    PHYSFS_uint64 cache_used; /* Bytes of all cached folders */
+    LZMAfolder *idle_stream; /* Unused folder whose stream is kept anyway */
+    __PHYSFS_HashTable hash; /* Index + 1 of every file, hashed by name */
+    PHYSFS_uint32 root; /* Index + 1 of first file in root dir, or 0 */
     CArchiveDatabaseEx db; /* For 7z: Database */
     FileInputStream stream; /* For 7z: Input file incl. read and seek callbacks */
+    void *lock; /* Guards the LRU list and (folders), but not decoding */
+    __PHYSFS_MemAccount *mem; /* The mount's, for memory accounting */
+    PHYSFS_uint64 index_charged; /* PHYSFS_MEMORY_INDEX charged to (mem) */
 } LZMAarchive;
 
-/* Set by LZMA_openArchive(), except offset which is set by LZMA_read() */
+/* Set by LZMA_openArchive() */
 typedef struct _LZMAfile
 {
     PHYSFS_uint32 index; /* Index of file in archive */
@@ -72,9 +152,18 @@ typedef struct _LZMAfile
     LZMAfolder *folder; /* Link to corresponding folder */
     CFileItem *item; /* For 7z: File info, eg. name, size */
     size_t offset; /* Offset in folder */
-    size_t position; /* Current "virtual" position in file */
+    PHYSFS_uint32 children; /* Index + 1 of first file in this dir, or 0 */
+    PHYSFS_uint32 sibling; /* Index + 1 of next file in same dir, or 0 */
 } LZMAfile;
 
+/* Set by LZMA_openRead(), one per open file */
+typedef struct _LZMAfileinfo
+{
+    LZMAfile *file; /* What's open */
+    PHYSFS_uint64 position; /* Current "virtual" position in file */
+    __PHYSFS_CrcCheck crccheck; /* If verifying checksums */
+} LZMAfileinfo;
+
 
 /* Memory management implementations to be passed to 7z */
 
@@ -91,8 +180,78 @@ static void SzFreePhysicsFS(void *address)
 } /* SzFreePhysicsFS */
 
 
+/*
+ * A folder decode's scratch (its packed input, the decoder's probability
+ *  tables) comes from the shared pool, so decoding one small folder after
+ *  another doesn't allocate and free the same things every time.
+ */
+static void *SzScratchAllocPhysicsFS(size_t size)
+{
+    return ((size == 0) ? NULL : __PHYSFS_scratchAlloc(size));
+} /* SzScratchAllocPhysicsFS */
+
+
+/* Decompressed folders go in the cache, so they get cache memory. */
+static void *SzCacheAllocPhysicsFS(size_t size)
+{
+    return ((size == 0) ? NULL : __PHYSFS_cacheAlloc(size));
+} /* SzCacheAllocPhysicsFS */
+
+
 /* Filesystem implementations to be passed to 7z */
 
+/*
+ * SzArchiveOpen() reads the archive's start header a few bytes at a time,
+ *  then the header at the end, then (if the header is compressed) the
+ *  packed header just before it. While it runs, small reads go through
+ *  (s)'s window instead: LZMA_openArchive() fills it from the start of the
+ *  archive, and a read outside it refills it, from the end of the archive
+ *  if that's near, so the packed header usually comes along with the
+ *  header. For archives no bigger than the window, that's all one read.
+ */
+static PHYSFS_sint64 lzma_window_read(FileInputStream *s, void *buffer,
+                                      size_t size)
+{
+    PHYSFS_uint64 offset;
+    size_t avail;
+
+    if ((s->pos < s->window_pos) ||
+        (s->pos + size > s->window_pos + s->window_len))
+    {
+        const PHYSFS_sint64 len = s->io->length(s->io);
+        PHYSFS_uint64 start = s->pos;
+        PHYSFS_sint64 rc;
+
+        if (size >= LZMA_HEADER_WINDOW)  /* it wouldn't fit anyhow. */
+            return __PHYSFS_ioReadAt(s->io, buffer, size, s->pos);
+        else if (len < 0)
+            return -1;
+        else if (s->pos >= (PHYSFS_uint64) len)
+            return 0;
+
+        /* 7z puts the header, and anything packed for it, at the end. */
+        if (start + LZMA_HEADER_WINDOW > (PHYSFS_uint64) len)
+        {
+            start = ((PHYSFS_uint64) len > LZMA_HEADER_WINDOW) ?
+                        ((PHYSFS_uint64) len) - LZMA_HEADER_WINDOW : 0;
+        } /* if */
+
+        rc = __PHYSFS_ioReadAt(s->io, s->window, LZMA_HEADER_WINDOW, start);
+        if (rc < 0)
+            return -1;
+        s->window_pos = start;
+        s->window_len = (size_t) rc;
+    } /* if */
+
+    offset = s->pos - s->window_pos;
+    avail = (offset < s->window_len) ? s->window_len - (size_t) offset : 0;
+    if (size > avail)
+        size = avail;
+    memcpy(buffer, s->window + offset, size);
+    return (PHYSFS_sint64) size;
+} /* lzma_window_read */
+
+
 #ifdef _LZMA_IN_CB
 
 /*
@@ -107,7 +266,10 @@ SZ_RESULT SzFileReadImp(void *object, void **buffer, size_t maxReqSize,
 
     if (maxReqSize > BUFFER_SIZE)
         maxReqSize = BUFFER_SIZE;
-    processedSizeLoc = s->io->read(s->io, s->buffer, maxReqSize);
+    processedSizeLoc = __PHYSFS_ioReadAt(s->io, s->buffer, maxReqSize, s->pos);
+    if (processedSizeLoc < 0)
+        return SZE_FAIL;
+    s->pos += processedSizeLoc;
     *buffer = s->buffer;
     if (processedSize != NULL)
         *processedSize = (size_t) processedSizeLoc;
@@ -125,9 +287,14 @@ SZ_RESULT SzFileReadImp(void *object, void *buffer, size_t size,
                         size_t *processedSize)
 {
     FileInputStream *s = (FileInputStream *)((size_t)object - offsetof(FileInputStream, inStream)); /* HACK! */
-    const size_t processedSizeLoc = s->io->read(s->io, buffer, size);
+    const PHYSFS_sint64 processedSizeLoc = (s->window != NULL) ?
+                lzma_window_read(s, buffer, size) :
+                __PHYSFS_ioReadAt(s->io, buffer, size, s->pos);
+    if (processedSizeLoc < 0)
+        return SZE_FAIL;
+    s->pos += processedSizeLoc;
     if (processedSize != NULL)
-        *processedSize = processedSizeLoc;
+        *processedSize = (size_t) processedSizeLoc;
     return SZ_OK;
 } /* SzFileReadImp */
 
@@ -140,9 +307,11 @@ SZ_RESULT SzFileReadImp(void *object, void *buffer, size_t size,
 SZ_RESULT SzFileSeekImp(void *object, CFileSize pos)
 {
     FileInputStream *s = (FileInputStream *)((size_t)object - offsetof(FileInputStream, inStream)); /* HACK! */
-    if (s->io->seek(s->io, (PHYSFS_uint64) pos))
-        return SZ_OK;
-    return SZE_FAIL;
+    const PHYSFS_sint64 len = s->io->length(s->io);
+    if ((len < 0) || ((PHYSFS_uint64) pos > (PHYSFS_uint64) len))
+        return SZE_FAIL;
+    s->pos = (PHYSFS_uint64) pos;
+    return SZ_OK;
 } /* SzFileSeekImp */
 
 
@@ -162,40 +331,26 @@ static PHYSFS_sint64 lzma_filetime_to_unix_timestamp(CArchiveFileTime *ft)
 
 
 /*
- * Compare a file with a given name, C89 stdlib variant
- * Used for sorting
+ * Find entry whose name is the first (len) chars of (name) in (archive), or
+ *  NULL if there isn't one. Doesn't set the error state.
  */
-static int lzma_file_cmp_stdlib(const void *key, const void *object)
+static LZMAfile *lzma_find_file_len(const LZMAarchive *archive,
+                                    const char *name, size_t len)
 {
-    const char *name = (const char *) key;
-    LZMAfile *file = (LZMAfile *) object;
-    return strcmp(name, file->item->Name);
-} /* lzma_file_cmp_posix */
-
+    const PHYSFS_uint32 hashval = __PHYSFS_hashString(name, len);
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 i;
 
-/*
- * Compare two files with each other based on the name
- * Used for sorting
- */
-static int lzma_file_cmp(void *_a, size_t one, size_t two)
-{
-    LZMAfile *files = (LZMAfile *) _a;
-    return strcmp(files[one].item->Name, files[two].item->Name);
-} /* lzma_file_cmp */
+    while ((i = __PHYSFS_hashTableFind(&archive->hash, hashval, &probe)) != 0)
+    {
+        LZMAfile *file = &archive->files[i - 1];
+        const char *fname = file->item->Name;
+        if ((strncmp(fname, name, len) == 0) && (fname[len] == '\0'))
+            return file;
+    } /* while */
 
-
-/*
- * Swap two entries in the file array
- */
-static void lzma_file_swap(void *_a, size_t one, size_t two)
-{
-    LZMAfile tmp;
-    LZMAfile *first = &(((LZMAfile *) _a)[one]);
-    LZMAfile *second = &(((LZMAfile *) _a)[two]);
-    memcpy(&tmp, first, sizeof (LZMAfile));
-    memcpy(first, second, sizeof (LZMAfile));
-    memcpy(second, &tmp, sizeof (LZMAfile));
-} /* lzma_file_swap */
+    return NULL;
+} /* lzma_find_file_len */
 
 
 /*
@@ -203,7 +358,7 @@ static void lzma_file_swap(void *_a, size_t one, size_t two)
  */
 static LZMAfile * lzma_find_file(const LZMAarchive *archive, const char *name)
 {
-    LZMAfile *file = bsearch(name, archive->files, archive->db.Database.NumFiles, sizeof(*archive->files), lzma_file_cmp_stdlib); /* FIXME: Should become __PHYSFS_search!!! */
+    LZMAfile *file = lzma_find_file_len(archive, name, strlen(name));
 
     BAIL_IF_MACRO(file == NULL, PHYSFS_ERR_NOT_FOUND, NULL);
 
@@ -219,12 +374,11 @@ static int lzma_file_init(LZMAarchive *archive, PHYSFS_uint32 fileIndex)
     LZMAfile *file = &archive->files[fileIndex];
     PHYSFS_uint32 folderIndex = archive->db.FileIndexToFolderIndexMap[fileIndex];
 
-    file->index = fileIndex; /* Store index into 7z array, since we sort our own. */
+    file->index = fileIndex; /* Index into 7z array, same as ours. */
     file->archive = archive;
     file->folder = (folderIndex != (PHYSFS_uint32)-1 ? &archive->folders[folderIndex] : NULL); /* Directories don't have a folder (they contain no own data...) */
     file->item = &archive->db.Database.Files[fileIndex]; /* Holds crucial data and is often referenced -> Store link */
-    file->position = 0;
-    file->offset = 0; /* Offset will be set by LZMA_read() */
+    file->offset = 0; /* Offset will be set by lzma_files_init() */
 
     return 1;
 } /* lzma_load_file */
@@ -236,21 +390,105 @@ static int lzma_file_init(LZMAarchive *archive, PHYSFS_uint32 fileIndex)
 static int lzma_files_init(LZMAarchive *archive)
 {
     PHYSFS_uint32 fileIndex = 0, numFiles = archive->db.Database.NumFiles;
+    size_t offset = 0;
 
     for (fileIndex = 0; fileIndex < numFiles; fileIndex++ )
     {
+        const PHYSFS_uint32 folderIndex =
+                        archive->db.FileIndexToFolderIndexMap[fileIndex];
+
         if (!lzma_file_init(archive, fileIndex))
         {
             return 0; /* FALSE on failure */
         }
+
+        /*
+         * A folder's files are stored back to back, from its first one on,
+         *  so work out where each lives now, the same way SzExtract does.
+         */
+        if ((folderIndex != (PHYSFS_uint32)-1) &&
+            (archive->db.FolderStartFileIndex[folderIndex] == fileIndex))
+            offset = 0;
+        archive->files[fileIndex].offset = offset;
+        offset += (UInt32)archive->db.Database.Files[fileIndex].Size;
     } /* for */
 
-   __PHYSFS_sort(archive->files, (size_t) numFiles, lzma_file_cmp, lzma_file_swap);
+    BAIL_IF_MACRO(!__PHYSFS_hashTableInit(&archive->hash, numFiles),
+                  ERRPASS, 0);
+    for (fileIndex = 0; fileIndex < numFiles; fileIndex++)
+    {
+        const char *name = archive->files[fileIndex].item->Name;
+        const PHYSFS_uint32 hashval = __PHYSFS_hashString(name, strlen(name));
+        BAIL_IF_MACRO(!__PHYSFS_hashTableInsert(&archive->hash, hashval,
+                                                fileIndex + 1), ERRPASS, 0);
+    } /* for */
+
+    /*
+     * Now every dir can be found, hang each file off its own. Going
+     *  backwards leaves each dir's children in archive order. Files whose
+     *  dir isn't in the archive aren't listed anywhere, as before.
+     */
+    for (fileIndex = numFiles; fileIndex-- > 0; )
+    {
+        LZMAfile *file = &archive->files[fileIndex];
+        const char *name = file->item->Name;
+        const char *sep = strrchr(name, '/');
+        if (sep == NULL)
+        {
+            file->sibling = archive->root;
+            archive->root = fileIndex + 1;
+        } /* if */
+        else
+        {
+            LZMAfile *dir = lzma_find_file_len(archive, name,
+                                               (size_t) (sep - name));
+            if (dir != NULL)
+            {
+                file->sibling = dir->children;
+                dir->children = fileIndex + 1;
+            } /* if */
+        } /* else */
+    } /* for */
 
     return 1;
 } /* lzma_load_files */
 
 
+/*
+ * Note which folders are plain LZMA or LZMA2, which can be decoded a bit at a time,
+ *  and which are stored as they are, which needn't be decoded at all.
+ */
+static void lzma_folders_init(LZMAarchive *archive)
+{
+    PHYSFS_uint32 folderIndex = 0;
+
+    for (folderIndex = 0; folderIndex < archive->db.Database.NumFolders;
+         folderIndex++)
+    {
+        CFolder *f = &archive->db.Database.Folders[folderIndex];
+        LZMAfolder *folder = &archive->folders[folderIndex];
+        const int single = ((f->NumCoders == 1) &&
+                            (f->Coders[0].NumInStreams == 1) &&
+                            (f->Coders[0].NumOutStreams == 1) &&
+                            (f->NumPackStreams == 1) &&
+                            (f->NumBindPairs == 0));
+        folder->index = folderIndex;
+        folder->streamable = ((single) &&
+                              ((f->Coders[0].MethodID == LZMA_METHOD_ID) ||
+                               (f->Coders[0].MethodID == LZMA2_METHOD_ID)));
+        if ((single) && (f->Coders[0].MethodID == COPY_METHOD_ID))
+        {
+            const PHYSFS_uint32 packIndex =
+                        archive->db.FolderStartPackStreamIndex[folderIndex];
+            folder->copy = (archive->db.Database.PackSizes[packIndex] ==
+                            SzFolderGetUnPackSize(f));
+            folder->pack_pos = SzArDbGetFolderStreamPos(&archive->db,
+                                                        folderIndex, 0);
+        } /* if */
+    } /* for */
+} /* lzma_folders_init */
+
+
 /*
  * Initialise specified archive
  */
@@ -276,6 +514,9 @@ static void lzma_archive_init(LZMAarchive *archive)
 static void lzma_archive_exit(LZMAarchive *archive)
 {
     /* Free arrays */
+    if (archive->lock != NULL)
+        __PHYSFS_platformDestroyMutex(archive->lock);
+    __PHYSFS_hashTableDeinit(&archive->hash);
     allocator.Free(archive->folders);
     allocator.Free(archive->files);
     allocator.Free(archive);
@@ -316,52 +557,626 @@ static int lzma_err(SZ_RESULT rc)
 } /* lzma_err */
 
 
-static PHYSFS_sint64 LZMA_read(PHYSFS_Io *io, void *outBuf, PHYSFS_uint64 len)
+static void lzma_folder_unlink(LZMAarchive *archive, LZMAfolder *folder)
+{
+    if (folder->lru_prev != NULL)
+        folder->lru_prev->lru_next = folder->lru_next;
+    else
+        archive->lru_head = folder->lru_next;
+
+    if (folder->lru_next != NULL)
+        folder->lru_next->lru_prev = folder->lru_prev;
+    else
+        archive->lru_tail = folder->lru_prev;
+
+    folder->lru_prev = folder->lru_next = NULL;
+} /* lzma_folder_unlink */
+
+
+static void lzma_folder_link(LZMAarchive *archive, LZMAfolder *folder)
 {
-    LZMAfile *file = (LZMAfile *) io->opaque;
+    folder->lru_prev = NULL;
+    folder->lru_next = archive->lru_head;
+    if (archive->lru_head != NULL)
+        archive->lru_head->lru_prev = folder;
+    else
+        archive->lru_tail = folder;
+    archive->lru_head = folder;
+} /* lzma_folder_link */
+
+
+/* Free a folder's decompressed data; it's decompressed again when needed. */
+static void lzma_folder_drop(LZMAarchive *archive, LZMAfolder *folder)
+{
+    if (folder->cache != NULL)
+    {
+        lzma_folder_unlink(archive, folder);
+        if (folder->spill != NULL)
+            __PHYSFS_platformUnmapFile(folder->spill);
+        else
+        {
+            archive->cache_used -= folder->size;
+            __PHYSFS_cacheFree(folder->cache);
+        } /* else */
+        folder->cache = NULL;
+        folder->spill = NULL;
+        folder->size = 0;
+    } /* if */
+} /* lzma_folder_drop */
+
+
+/*
+ * Drop least recently read folders until the archive is within budget.
+ *  (keep) is never dropped, nor is anything mapped or being copied out of.
+ *  Without a budget, only folders no open file uses are dropped. Call with
+ *  the archive's lock held.
+ */
+static void lzma_cache_trim(LZMAarchive *archive, const LZMAfolder *keep)
+{
+    const PHYSFS_uint64 budget = __PHYSFS_getDecompressionCacheSize();
+    LZMAfolder *folder = archive->lru_tail;
+
+    while ((folder != NULL) && ((archive->cache_used > budget) ||
+                                __PHYSFS_memExcess(PHYSFS_MEMORY_CACHES)))
+    {
+        LZMAfolder *prev = folder->lru_prev;
+        if ((folder != keep) && (!folder->mapped) && (folder->pins == 0) &&
+            ((budget > 0) || (folder->references == 0)))
+            lzma_folder_drop(archive, folder);
+        folder = prev;
+    } /* while */
+} /* lzma_cache_trim */
+
+
+/*
+ * Grab (folder)'s latch, making it first if need be. Call with the
+ *  archive's lock held; it's let go meanwhile, since whoever has the latch
+ *  now might want the lock before they let go of it, and grabbed again
+ *  before this returns. Returns zero on failure, with the error set.
+ */
+static int lzma_folder_grab_latch(LZMAarchive *archive, LZMAfolder *folder)
+{
+    if (folder->latch == NULL)
+    {
+        folder->latch = __PHYSFS_platformCreateMutex();
+        BAIL_IF_MACRO(folder->latch == NULL, ERRPASS, 0);
+    } /* if */
+
+    __PHYSFS_platformReleaseMutex(archive->lock);
+    __PHYSFS_platformGrabMutex(folder->latch);
+    __PHYSFS_platformGrabMutex(archive->lock);
+    return 1;
+} /* lzma_folder_grab_latch */
+
+
+/* The most coders a folder can have and still get a spill key. */
+#define LZMA_SPILL_MAX_CODERS 4
+
+/*
+ * Fill in (key) with what identifies folder (folderIndex)'s decompressed
+ *  data for the spill cache, and return how many bytes that is, or zero if
+ *  it can't be spilled: its checksum and sizes, and how it was compressed,
+ *  but not where it is, so the same folder in another archive shares it.
+ */
+static size_t lzma_spill_key(const LZMAarchive *archive,
+                             const PHYSFS_uint32 folderIndex, PHYSFS_uint8 *key)
+{
+    CFolder *f = &archive->db.Database.Folders[folderIndex];
+    PHYSFS_uint64 vals[3 + LZMA_SPILL_MAX_CODERS];
+    CFileSize packSize = 0;
+    size_t count = 0;
+    size_t i, j;
+
+    if ((!f->UnPackCRCDefined) || (f->NumCoders > LZMA_SPILL_MAX_CODERS))
+        return 0;
+    else if (SzArDbGetFolderFullPackSize((CArchiveDatabaseEx *) &archive->db,
+                                         folderIndex, &packSize) != SZ_OK)
+        return 0;
+
+    vals[count++] = (PHYSFS_uint64) f->UnPackCRC;
+    vals[count++] = (PHYSFS_uint64) SzFolderGetUnPackSize(f);
+    vals[count++] = (PHYSFS_uint64) packSize;
+    for (i = 0; i < f->NumCoders; i++)
+        vals[count++] = (PHYSFS_uint64) f->Coders[i].MethodID;
+
+    /* little endian, so a spill dir can be shared between machines. */
+    key[0] = '7';
+    key[1] = 'z';
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < 8; j++)
+            key[2 + (i * 8) + j] = (PHYSFS_uint8) (vals[i] >> (j * 8));
+    } /* for */
+
+    return 2 + (count * 8);
+} /* lzma_spill_key */
+
+/* Big enough for anything from lzma_spill_key(). */
+#define LZMA_SPILL_KEY_LEN (2 + ((3 + LZMA_SPILL_MAX_CODERS) * 8))
+
+
+/*
+ * Map folder (folderIndex)'s decompressed data in from the spill cache.
+ *  Returns the mapping, with (buf) and (len) set, or NULL if it isn't
+ *  there. Never sets an error.
+ */
+static void *lzma_spill_load(const LZMAarchive *archive,
+                             const PHYSFS_uint32 folderIndex,
+                             const void **buf, size_t *len)
+{
+    CFolder *f = &archive->db.Database.Folders[folderIndex];
+    const PHYSFS_uint64 size = (PHYSFS_uint64) SzFolderGetUnPackSize(f);
+    PHYSFS_uint8 key[LZMA_SPILL_KEY_LEN];
+    const size_t keylen = lzma_spill_key(archive, folderIndex, key);
+    void *retval;
+
+    if ((keylen == 0) || (size == 0) || (size > (PHYSFS_uint64) ((size_t) -1)))
+        return NULL;
+
+    retval = __PHYSFS_spillLoad(key, keylen, size, buf);
+    if (retval != NULL)
+        *len = (size_t) size;
+    return retval;
+} /* lzma_spill_load */
+
+
+/*
+ * Decompress folder (folderIndex), like __PHYSFS_lzmaDecodeFolder(), and
+ *  save what comes out to the spill cache, if there is one. It's saved now,
+ *  instead of when it's dropped, because by then nobody's sure to have the
+ *  time to write it out.
+ */
+static int lzma_decode_folder(const LZMAarchive *archive,
+                              PHYSFS_uint32 folderIndex, PHYSFS_Io *src,
+                              void **buf, size_t *len);
+
+
+/*
+ * Make sure (file)'s folder is decompressed, and mark it as the most
+ *  recently read. Call with the archive's lock held. It's let go while
+ *  decompressing, so other folders can be read meanwhile, and only one
+ *  thread decompresses this one; the rest wait for it and use its work.
+ *  Returns zero on failure, with the error set.
+ */
+static int lzma_folder_load(LZMAfile *file)
+{
+    LZMAarchive *archive = file->archive;
+    LZMAfolder *folder = file->folder;
+    void *buf = NULL;
+    size_t len = 0;
+    int rc = 1;
+
+    if (folder->cache != NULL)
+    {
+        if (archive->lru_head != folder)
+        {
+            lzma_folder_unlink(archive, folder);
+            lzma_folder_link(archive, folder);
+        } /* if */
+        return 1;
+    } /* if */
+
+    BAIL_IF_MACRO(!lzma_folder_grab_latch(archive, folder), ERRPASS, 0);
+
+    if (folder->cache == NULL)  /* nobody did it while we waited? */
+    {
+        const void *spilled = NULL;
+        void *spill = NULL;
+
+        __PHYSFS_platformReleaseMutex(archive->lock);
+        spill = lzma_spill_load(archive, folder->index, &spilled, &len);
+        if (spill == NULL)
+        {
+            rc = lzma_decode_folder(archive, folder->index,
+                                    archive->stream.io, &buf, &len);
+        } /* if */
+        __PHYSFS_platformGrabMutex(archive->lock);
+
+        /* PHYSFS_prefetch() caches without the latch, so check again. */
+        if ((spill != NULL) && (folder->cache != NULL))
+            __PHYSFS_platformUnmapFile(spill);
+        else if (spill != NULL)
+        {
+            /* mapped, so it doesn't count against the budget. */
+            folder->cache = (PHYSFS_uint8 *) spilled;
+            folder->spill = spill;
+            folder->size = len;
+            lzma_folder_link(archive, folder);
+            lzma_cache_trim(archive, folder);
+        } /* else if */
+        else if ((rc) && (folder->cache != NULL))
+            __PHYSFS_cacheFree(buf);
+        else if (rc)
+        {
+            __PHYSFS_cacheOwner(buf, archive->mem);
+            folder->cache = (PHYSFS_uint8 *) buf;
+            folder->size = len;
+            lzma_folder_link(archive, folder);
+            archive->cache_used += len;
+            lzma_cache_trim(archive, folder);
+        } /* else if */
+    } /* if */
+
+    __PHYSFS_platformReleaseMutex(folder->latch);
+    return rc;
+} /* lzma_folder_load */
+
+
+/*
+ * Nonzero if (folder) should be read through an LZMAstream instead of being
+ *  decompressed whole: it's plain LZMA(2), it isn't cached already, and it's
+ *  too big to stay cached anyhow.
+ */
+static int lzma_folder_streams(LZMAarchive *archive, LZMAfolder *folder)
+{
+    CFolder *f = &archive->db.Database.Folders[folder->index];
+    const PHYSFS_uint64 size = SzFolderGetUnPackSize(f);
+    return ((folder->streamable) && (folder->cache == NULL) &&
+            ((size > __PHYSFS_getDecompressionCacheSize()) ||
+             (!__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES, size))));
+} /* lzma_folder_streams */
+
+
+static void lzma_stream_free(LZMAarchive *archive, LZMAstream *stream)
+{
+    if (stream != NULL)
+    {
+        __PHYSFS_memCharge(archive->mem, PHYSFS_MEMORY_DECODERS,
+                           -((PHYSFS_sint64) stream->charged));
+        allocator.Free(stream->state.Lzma.Probs);
+        allocator.Free(stream->state.Lzma.Dictionary);
+        allocator.Free(stream);
+    } /* if */
+} /* lzma_stream_free */
+
+
+/* Drop (folder)'s stream, if any. It's started over if it's needed again. */
+static void lzma_folder_drop_stream(LZMAarchive *archive, LZMAfolder *folder)
+{
+    lzma_stream_free(archive, folder->stream);
+    folder->stream = NULL;
+    if (archive->idle_stream == folder)
+        archive->idle_stream = NULL;
+} /* lzma_folder_drop_stream */
+
+
+static LZMAstream *lzma_stream_create(LZMAarchive *archive, LZMAfolder *folder)
+{
+    CFolder *f = &archive->db.Database.Folders[folder->index];
+    const CSzByteBuffer *props = &f->Coders[0].Properties;
+    const PHYSFS_uint32 packIndex =
+                    archive->db.FolderStartPackStreamIndex[folder->index];
+    CLzmaProperties *lzmaprops = NULL;
+    LZMAstream *stream = NULL;
+    size_t numProbs;
+    int rc;
+
+    stream = (LZMAstream *) allocator.Malloc(sizeof (LZMAstream));
+    BAIL_IF_MACRO(stream == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    stream->state.Lzma.Probs = NULL;
+    stream->state.Lzma.Dictionary = NULL;
+    stream->charged = 0;
+    stream->size = SzFolderGetUnPackSize(f);
+    stream->lzma2 = (f->Coders[0].MethodID == LZMA2_METHOD_ID);
+
+    lzmaprops = &stream->state.Lzma.Properties;
+    if (stream->lzma2)
+        rc = Lzma2DecodeProperties(&lzmaprops->DictionarySize, props->Items,
+                                   (int) props->Capacity);
+    else
+        rc = LzmaDecodeProperties(lzmaprops, props->Items,
+                                  (int) props->Capacity);
+    if (rc != LZMA_RESULT_OK)
+    {
+        lzma_stream_free(archive, stream);
+        BAIL_MACRO(PHYSFS_ERR_CORRUPT, NULL);
+    } /* if */
+
+    /* Nothing refers back past the folder's start, so that's plenty. */
+    if (lzmaprops->DictionarySize > stream->size)
+        lzmaprops->DictionarySize = (UInt32) stream->size;
+
+    /* LZMA2 chunks may change lc and lp, so make room for the most. */
+    numProbs = stream->lzma2 ? Lzma2GetNumProbs() : LzmaGetNumProbs(lzmaprops);
+    stream->state.Lzma.Probs = (CProb *) allocator.Malloc(
+                                                numProbs * sizeof (CProb));
+    if (lzmaprops->DictionarySize > 0)
+        stream->state.Lzma.Dictionary = (unsigned char *)
+                            allocator.Malloc(lzmaprops->DictionarySize);
+    if ((stream->state.Lzma.Probs == NULL) ||
+        ((lzmaprops->DictionarySize > 0) &&
+         (stream->state.Lzma.Dictionary == NULL)))
+    {
+        lzma_stream_free(archive, stream);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    stream->charged = sizeof (LZMAstream) + (numProbs * sizeof (CProb)) +
+                      lzmaprops->DictionarySize;
+    __PHYSFS_memCharge(archive->mem, PHYSFS_MEMORY_DECODERS,
+                       (PHYSFS_sint64) stream->charged);
+
+    if (stream->lzma2)
+    {
+        Lzma2DecoderInit(&stream->state);
+    } /* if */
+    else
+    {
+        LzmaDecoderInit(&stream->state.Lzma);
+    } /* else */
+    stream->position = 0;
+    stream->pack_pos = SzArDbGetFolderStreamPos(&archive->db, folder->index, 0);
+    stream->pack_left = archive->db.Database.PackSizes[packIndex];
+    stream->crc = CRC_INIT_VAL;
+    stream->start = stream->avail = 0;
+
+    folder->stream = stream;
+    __PHYSFS_STAT_INCR(folderDecodes7z);
+    return stream;
+} /* lzma_stream_create */
+
+
+/*
+ * Decode the next (len) bytes of (folder)'s stream into (buf). Returns zero
+ *  on failure, with the error set; the stream can't go on after that.
+ */
+static int lzma_stream_decode(LZMAarchive *archive, LZMAfolder *folder,
+                              PHYSFS_uint8 *buf, size_t len)
+{
+    LZMAstream *stream = folder->stream;
+    const CFolder *f = &archive->db.Database.Folders[folder->index];
+    PHYSFS_Io *io = archive->stream.io;
+
+    while (len > 0)
+    {
+        SizeT inProcessed = 0;
+        SizeT outProcessed = 0;
+        int rc;
+
+        if ((stream->avail == 0) && (stream->pack_left > 0))
+        {
+            size_t readlen = sizeof (stream->buffer);
+            PHYSFS_sint64 br;
+            if (readlen > stream->pack_left)
+                readlen = (size_t) stream->pack_left;
+            br = __PHYSFS_ioReadAt(io, stream->buffer, readlen,
+                                   stream->pack_pos);
+            BAIL_IF_MACRO(br < 0, ERRPASS, 0);
+            BAIL_IF_MACRO((size_t) br != readlen, PHYSFS_ERR_CORRUPT, 0);
+            stream->start = 0;
+            stream->avail = readlen;
+            stream->pack_pos += readlen;
+            stream->pack_left -= readlen;
+        } /* if */
+
+        if (stream->lzma2)
+            rc = Lzma2Decode(&stream->state, stream->buffer + stream->start,
+                             stream->avail, &inProcessed,
+                             buf, len, &outProcessed);
+        else
+            rc = LzmaDecode(&stream->state.Lzma,
+                            stream->buffer + stream->start,
+                            stream->avail, &inProcessed,
+                            buf, len, &outProcessed,
+                            stream->pack_left == 0);
+        BAIL_IF_MACRO(rc != LZMA_RESULT_OK, PHYSFS_ERR_CORRUPT, 0);
+
+        /* the stream ended before the folder did? */
+        BAIL_IF_MACRO((inProcessed == 0) && (outProcessed == 0),
+                      PHYSFS_ERR_CORRUPT, 0);
+
+        stream->start += inProcessed;
+        stream->avail -= inProcessed;
+        stream->crc = CrcUpdate(stream->crc, buf, outProcessed);
+        stream->position += outProcessed;
+        __PHYSFS_STAT_ADD(bytesDecompressed7z, outProcessed);
+        buf += outProcessed;
+        len -= outProcessed;
+
+        if ((stream->position == stream->size) && (f->UnPackCRCDefined))
+        {
+            BAIL_IF_MACRO(CRC_GET_DIGEST(stream->crc) != f->UnPackCRC,
+                          PHYSFS_ERR_CORRUPT, 0);
+        } /* if */
+    } /* while */
+
+    return 1;
+} /* lzma_stream_decode */
+
+
+/*
+ * Read (len) bytes from (pos) in (file) out of its decompressed folder.
+ *  Call with the archive's lock held; it's let go while copying. Returns
+ *  zero on failure.
+ */
+static int lzma_folder_read(LZMAfile *file, PHYSFS_uint8 *buf, size_t len,
+                            PHYSFS_uint64 pos)
+{
+    LZMAarchive *archive = file->archive;
+    LZMAfolder *folder = file->folder;
+
+    /* Only decompress the folder if it is not already cached */
+    if (!lzma_folder_load(file))
+        return 0;
+
+    /* Copy wanted bytes over from cache to outBuf, keeping the cache put */
+    folder->pins++;
+    __PHYSFS_platformReleaseMutex(archive->lock);
+    memcpy(buf, (folder->cache + file->offset + pos), len);
+    __PHYSFS_platformGrabMutex(archive->lock);
+    folder->pins--;
+    return 1;
+} /* lzma_folder_read */
+
+
+/*
+ * Read (len) bytes from (pos) in (file) through its folder's stream. The
+ *  decoder's dictionary holds what it decoded most recently, so going back
+ *  a little doesn't mean starting over. Going back further means this
+ *  folder is read out of order, so it's decompressed whole from then on
+ *  instead, like any other. Call with the archive's lock held; it's let go
+ *  while decoding, and the folder's latch is held instead, so others
+ *  reading this folder wait their turn. Returns zero on failure.
+ */
+static int lzma_stream_read(LZMAfile *file, PHYSFS_uint8 *buf, size_t len,
+                            PHYSFS_uint64 pos)
+{
+    LZMAarchive *archive = file->archive;
+    LZMAfolder *folder = file->folder;
+    LZMAstream *stream = NULL;
+    size_t decodelen;
+
+    BAIL_IF_MACRO(!lzma_folder_grab_latch(archive, folder), ERRPASS, 0);
+
+    /* somebody else might have given up on streaming it meanwhile. */
+    if (!lzma_folder_streams(archive, folder))
+    {
+        __PHYSFS_platformReleaseMutex(folder->latch);
+        return lzma_folder_read(file, buf, len, pos);
+    } /* if */
+
+    stream = folder->stream;
+    if (stream == NULL)
+    {
+        stream = lzma_stream_create(archive, folder);
+        if (stream == NULL)
+        {
+            __PHYSFS_platformReleaseMutex(folder->latch);
+            return 0;
+        } /* if */
+    } /* if */
+
+    pos += file->offset;
+    if ((pos < stream->position) &&
+        (stream->position - pos > stream->state.Lzma.DistanceLimit))
+    {
+        lzma_folder_drop_stream(archive, folder);
+        folder->streamable = 0;
+        __PHYSFS_platformReleaseMutex(folder->latch);
+        return lzma_folder_read(file, buf, len, pos - file->offset);
+    } /* if */
+
+    __PHYSFS_platformReleaseMutex(archive->lock);
+
+    if (pos < stream->position)
+    {
+        const PHYSFS_uint64 back = stream->position - pos;
+        const UInt32 dictsize = stream->state.Lzma.Properties.DictionarySize;
+        const PHYSFS_uint64 end = stream->state.Lzma.DictionaryPos;
+        UInt32 from = (UInt32) ((end + dictsize - back) % dictsize);
+        size_t cpy = (len < back) ? len : (size_t) back;
+        pos += cpy;
+        len -= cpy;
+        while (cpy > 0)
+        {
+            size_t n = dictsize - from;
+            if (n > cpy)
+                n = cpy;
+            memcpy(buf, stream->state.Lzma.Dictionary + from, n);
+            buf += n;
+            cpy -= n;
+            from = 0;
+        } /* while */
+    } /* if */
+
+    decodelen = len;
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_DECOMPRESS, file->item->Name, NULL,
+                         (PHYSFS_sint64) decodelen);
+    while ((len > 0) && (stream->position < pos))
+    {
+        const PHYSFS_uint64 skip = pos - stream->position;
+        const size_t n = (skip < LZMA_STREAM_SKIPSIZE) ? (size_t) skip :
+                                                         LZMA_STREAM_SKIPSIZE;
+        if (!lzma_stream_decode(archive, folder, stream->scratch, n))
+            break;
+    } /* while */
+
+    if ((len > 0) && (stream->position == pos) &&
+        (lzma_stream_decode(archive, folder, buf, len)))
+        len = 0;
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_DECOMPRESS, file->item->Name, NULL,
+                       (len == 0) ? (PHYSFS_sint64) decodelen : -1, len == 0);
 
+    __PHYSFS_platformGrabMutex(archive->lock);
+    if (len > 0)  /* it failed; the stream can't go on. */
+        lzma_folder_drop_stream(archive, folder);
+    __PHYSFS_platformReleaseMutex(folder->latch);
+    return (len == 0);
+} /* lzma_stream_read */
+
+
+/*
+ * Read up to (len) bytes from (pos) in (file), which any number of threads
+ *  can do at once. Returns bytes read, or -1 on failure.
+ */
+static PHYSFS_sint64 lzma_file_read(LZMAfile *file, void *outBuf,
+                                    PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    LZMAarchive *archive = file->archive;
     size_t wantedSize = (size_t) len;
-    const size_t remainingSize = file->item->Size - file->position;
-    size_t fileSize = 0;
+    size_t remainingSize;
+    int rc;
 
     BAIL_IF_MACRO(wantedSize == 0, ERRPASS, 0); /* quick rejection. */
-    BAIL_IF_MACRO(remainingSize == 0, PHYSFS_ERR_PAST_EOF, 0);
+    BAIL_IF_MACRO(pos >= file->item->Size, PHYSFS_ERR_PAST_EOF, 0);
 
+    remainingSize = (size_t) (file->item->Size - pos);
     if (wantedSize > remainingSize)
         wantedSize = remainingSize;
 
-    /* Only decompress the folder if it is not already cached */
-    if (file->folder->cache == NULL)
-    {
-        const int rc = lzma_err(SzExtract(
-            &file->archive->stream.inStream, /* compressed data */
-            &file->archive->db, /* 7z's database, containing everything */
-            file->index, /* Index into database arrays */
-            /* Index of cached folder, will be changed by SzExtract */
-            &file->folder->index,
-            /* Cache for decompressed folder, allocated/freed by SzExtract */
-            &file->folder->cache,
-            /* Size of cache, will be changed by SzExtract */
-            &file->folder->size,
-            /* Offset of this file inside the cache, set by SzExtract */
-            &file->offset,
-            &fileSize, /* Size of this file */
-            &file->archive->stream.allocImp,
-            &file->archive->stream.allocTempImp));
-
-        if (rc != SZ_OK)
-            return -1;
+    /* stored as it is: nothing to decode, cache or lock. */
+    if (file->folder->copy)
+    {
+        const PHYSFS_uint64 at = file->folder->pack_pos + file->offset + pos;
+        const PHYSFS_sint64 br = __PHYSFS_ioReadAt(archive->stream.io, outBuf,
+                                                   wantedSize, at);
+        BAIL_IF_MACRO(br < 0, ERRPASS, -1);
+        BAIL_IF_MACRO((size_t) br != wantedSize, PHYSFS_ERR_CORRUPT, -1);
+        return br;
     } /* if */
 
-    /* Copy wanted bytes over from cache to outBuf */
-    memcpy(outBuf, (file->folder->cache + file->offset + file->position),
-            wantedSize);
-    file->position += wantedSize; /* Increase virtual position */
+    __PHYSFS_platformGrabMutex(archive->lock);
+    if (lzma_folder_streams(archive, file->folder))
+        rc = lzma_stream_read(file, (PHYSFS_uint8 *) outBuf, wantedSize, pos);
+    else
+        rc = lzma_folder_read(file, (PHYSFS_uint8 *) outBuf, wantedSize, pos);
+    __PHYSFS_platformReleaseMutex(archive->lock);
+
+    return rc ? (PHYSFS_sint64) wantedSize : -1;
+} /* lzma_file_read */
+
+
+static PHYSFS_sint64 LZMA_read(PHYSFS_Io *io, void *outBuf, PHYSFS_uint64 len)
+{
+    LZMAfileinfo *finfo = (LZMAfileinfo *) io->opaque;
+    const CFileItem *item = finfo->file->item;
+    const PHYSFS_sint64 rc = lzma_file_read(finfo->file, outBuf, len,
+                                            finfo->position);
+
+    if (rc > 0)
+    {
+        const PHYSFS_uint64 pos = finfo->position;
+        finfo->position += rc; /* Increase virtual position */
 
-    return wantedSize;
+        /* the folder's crc only gets checked if it's decoded to the end. */
+        if (!__PHYSFS_crcCheckRead(&finfo->crccheck, outBuf,
+                                   (PHYSFS_uint64) rc, pos, item->Size,
+                                   item->FileCRC))
+            return -1;
+    } /* if */
+
+    return rc;
 } /* LZMA_read */
 
 
+static PHYSFS_sint64 LZMA_readAt(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len,
+                                 PHYSFS_uint64 offset)
+{
+    return lzma_file_read(((LZMAfileinfo *) io->opaque)->file, buf, len,
+                          offset);
+} /* LZMA_readAt */
+
+
 static PHYSFS_sint64 LZMA_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 {
     BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
@@ -370,18 +1185,18 @@ static PHYSFS_sint64 LZMA_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 
 static PHYSFS_sint64 LZMA_tell(PHYSFS_Io *io)
 {
-    LZMAfile *file = (LZMAfile *) io->opaque;
-    return file->position;
+    LZMAfileinfo *finfo = (LZMAfileinfo *) io->opaque;
+    return finfo->position;
 } /* LZMA_tell */
 
 
 static int LZMA_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 {
-    LZMAfile *file = (LZMAfile *) io->opaque;
+    LZMAfileinfo *finfo = (LZMAfileinfo *) io->opaque;
 
-    BAIL_IF_MACRO(offset > file->item->Size, PHYSFS_ERR_PAST_EOF, 0);
+    BAIL_IF_MACRO(offset > finfo->file->item->Size, PHYSFS_ERR_PAST_EOF, 0);
 
-    file->position = offset; /* We only use a virtual position... */
+    finfo->position = offset; /* We only use a virtual position... */
 
     return 1;
 } /* LZMA_seek */
@@ -389,16 +1204,16 @@ static int LZMA_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 
 static PHYSFS_sint64 LZMA_length(PHYSFS_Io *io)
 {
-    const LZMAfile *file = (LZMAfile *) io->opaque;
-    return (file->item->Size);
+    const LZMAfileinfo *finfo = (LZMAfileinfo *) io->opaque;
+    return (finfo->file->item->Size);
 } /* LZMA_length */
 
 
+static PHYSFS_Io *lzma_open_io(LZMAfile *file);
+
 static PHYSFS_Io *LZMA_duplicate(PHYSFS_Io *_io)
 {
-    /* !!! FIXME: this archiver needs to be reworked to allow multiple
-     * !!! FIXME:  opens before we worry about duplication. */
-    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+    return lzma_open_io(((LZMAfileinfo *) _io->opaque)->file);
 } /* LZMA_duplicate */
 
 
@@ -407,8 +1222,10 @@ static int LZMA_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
 
 static void LZMA_destroy(PHYSFS_Io *io)
 {
-    LZMAfile *file = (LZMAfile *) io->opaque;
+    LZMAfileinfo *finfo = (LZMAfileinfo *) io->opaque;
+    LZMAfile *file = finfo->file;
 
+    __PHYSFS_platformGrabMutex(file->archive->lock);
     if (file->folder != NULL)
     {
         /* Only decrease refcount if someone actually requested this file... Prevents from overflows and close-on-open... */
@@ -416,15 +1233,82 @@ static void LZMA_destroy(PHYSFS_Io *io)
             file->folder->references--;
         if (file->folder->references == 0)
         {
-            /* Free the cache which might have been allocated by LZMA_read() */
-            allocator.Free(file->folder->cache);
-            file->folder->cache = NULL;
+            /* Nothing can still be pointing into it, so it may go now. */
+            file->folder->mapped = 0;
+
+            /*
+             * Keep this one's stream, in case the next file read is the
+             *  next one in this folder, but only this one's.
+             */
+            if (file->folder->stream != NULL)
+            {
+                LZMAfolder *idle = file->archive->idle_stream;
+                if ((idle != NULL) && (idle != file->folder) &&
+                    (idle->references == 0))
+                    lzma_folder_drop_stream(file->archive, idle);
+                file->archive->idle_stream = file->folder;
+            } /* if */
+
+            if (__PHYSFS_getDecompressionCacheSize() == 0)
+                lzma_folder_drop(file->archive, file->folder);
+            else
+                lzma_cache_trim(file->archive, NULL);
         }
         /* !!! FIXME: we don't free (file) or (file->folder)?! */
     } /* if */
+    __PHYSFS_platformReleaseMutex(file->archive->lock);
+
+    __PHYSFS_poolFree(finfo, sizeof (LZMAfileinfo));
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
 } /* LZMA_destroy */
 
 
+static int LZMA_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    LZMAfile *file = ((LZMAfileinfo *) io->opaque)->file;
+
+    /*
+     * Stored as it is: it's in the archive's own mapping, if it has one.
+     *  If not, it's copied into the folder cache like anything else, since
+     *  mapping has to hand back all of it at once.
+     */
+    if (file->folder->copy)
+    {
+        const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+        const PHYSFS_uint64 at = file->folder->pack_pos + file->offset;
+        const void *archptr = NULL;
+        PHYSFS_uint64 archlen = 0;
+
+        if (__PHYSFS_ioMap(file->archive->stream.io, &archptr, &archlen))
+        {
+            BAIL_IF_MACRO(at > archlen, PHYSFS_ERR_CORRUPT, 0);
+            BAIL_IF_MACRO(file->item->Size > archlen - at,
+                          PHYSFS_ERR_CORRUPT, 0);
+            *ptr = ((const PHYSFS_uint8 *) archptr) + at;
+            *len = (PHYSFS_uint64) file->item->Size;
+            return 1;
+        } /* if */
+
+        PHYSFS_getLastErrorCode();
+        PHYSFS_setErrorCode(prevErr);
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(file->archive->lock);
+    if (!lzma_folder_load(file))
+    {
+        __PHYSFS_platformReleaseMutex(file->archive->lock);
+        return 0;
+    } /* if */
+
+    /* the folder cache lives until the last file using it is destroyed. */
+    file->folder->mapped = 1;
+    *ptr = file->folder->cache + file->offset;
+    *len = (PHYSFS_uint64) file->item->Size;
+    __PHYSFS_platformReleaseMutex(file->archive->lock);
+    return 1;
+} /* LZMA_map */
+
+
 static const PHYSFS_Io LZMA_Io =
 {
     CURRENT_PHYSFS_IO_API_VERSION, NULL,
@@ -435,37 +1319,102 @@ static const PHYSFS_Io LZMA_Io =
     LZMA_length,
     LZMA_duplicate,
     LZMA_flush,
-    LZMA_destroy
+    LZMA_destroy,
+    LZMA_map,
+    LZMA_readAt
 };
 
 
+/* Open (file), which must be a file, on its own: nothing but (file) and its
+ *  folder is shared with other opens. */
+static PHYSFS_Io *lzma_open_io(LZMAfile *file)
+{
+    PHYSFS_Io *io = NULL;
+    LZMAfileinfo *finfo = NULL;
+
+    io = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    BAIL_IF_MACRO(io == NULL, ERRPASS, NULL);
+    finfo = (LZMAfileinfo *) __PHYSFS_poolAlloc(sizeof (LZMAfileinfo));
+    if (finfo == NULL)
+    {
+        __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
+        return NULL;
+    } /* if */
+
+    memcpy(io, &LZMA_Io, sizeof (*io));
+    io->opaque = finfo;
+    finfo->file = file;
+    finfo->position = 0;
+    __PHYSFS_crcCheckInit(&finfo->crccheck);
+    if (!file->item->IsFileCRCDefined)
+        finfo->crccheck.checking = 0;  /* nothing to check it against. */
+
+    __PHYSFS_platformGrabMutex(file->archive->lock);
+    file->folder->references++; /* Increase refcount for automatic cleanup... */
+    __PHYSFS_platformReleaseMutex(file->archive->lock);
+
+    return io;
+} /* lzma_open_io */
+
+
 static void *LZMA_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 {
-    PHYSFS_uint8 sig[k7zSignatureSize];
+    PHYSFS_uint8 *window = NULL;
+    PHYSFS_sint64 rc;
     size_t len = 0;
     LZMAarchive *archive = NULL;
+    int opened;
 
     assert(io != NULL);  /* shouldn't ever happen. */
 
     BAIL_IF_MACRO(forWriting, PHYSFS_ERR_READ_ONLY, NULL);
 
-    if (io->read(io, sig, k7zSignatureSize) != k7zSignatureSize)
-        return 0;
-    BAIL_IF_MACRO(!TestSignatureCandidate(sig), PHYSFS_ERR_UNSUPPORTED, NULL);
-    BAIL_IF_MACRO(!io->seek(io, 0), ERRPASS, NULL);
+    /* the signature, and the start header SzArchiveOpen() reads next. */
+    window = (PHYSFS_uint8 *) allocator.Malloc(LZMA_HEADER_WINDOW);
+    BAIL_IF_MACRO(!window, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    rc = __PHYSFS_ioReadAt(io, window, LZMA_HEADER_WINDOW, 0);
+    if ((rc < k7zSignatureSize) || (!TestSignatureCandidate(window)))
+    {
+        allocator.Free(window);
+        BAIL_IF_MACRO(rc < 0, ERRPASS, NULL);
+        BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+    } /* if */
 
     archive = (LZMAarchive *) allocator.Malloc(sizeof (LZMAarchive));
-    BAIL_IF_MACRO(archive == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    if (archive == NULL)
+    {
+        allocator.Free(window);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
 
     lzma_archive_init(archive);
     archive->stream.io = io;
 
+    archive->lock = __PHYSFS_platformCreateMutex();
+    if (archive->lock == NULL)
+    {
+        allocator.Free(window);
+        lzma_archive_exit(archive);
+        return NULL;
+    } /* if */
+
+    archive->stream.window = window;
+    archive->stream.window_pos = 0;
+    archive->stream.window_len = (size_t) rc;
+
     CrcGenerateTable();
     SzArDbExInit(&archive->db);
-    if (lzma_err(SzArchiveOpen(&archive->stream.inStream,
-                               &archive->db,
-                               &archive->stream.allocImp,
-                               &archive->stream.allocTempImp)) != SZ_OK)
+    opened = (lzma_err(SzArchiveOpen(&archive->stream.inStream,
+                                     &archive->db,
+                                     &archive->stream.allocImp,
+                                     &archive->stream.allocTempImp)) == SZ_OK);
+
+    /* the streams copied from this read folders, which go straight to (io). */
+    allocator.Free(window);
+    archive->stream.window = NULL;
+    archive->stream.window_len = 0;
+
+    if (!opened)
     {
         SzArDbExFree(&archive->db, SzFreePhysicsFS);
         lzma_archive_exit(archive);
@@ -501,77 +1450,52 @@ static void *LZMA_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
      * Values will be set by LZMA_read()
      */
     memset(archive->folders, 0, len);
+    lzma_folders_init(archive);
 
     if(!lzma_files_init(archive))
     {
         SzArDbExFree(&archive->db, SzFreePhysicsFS);
         lzma_archive_exit(archive);
-        BAIL_MACRO(PHYSFS_ERR_OTHER_ERROR, NULL);
+        return NULL; /* Error is set by lzma_files_init! */
     }
 
+    /* 7z's own tables are close enough to this; names aren't counted. */
+    archive->mem = __PHYSFS_memMountAccount();
+    archive->index_charged =
+        (((PHYSFS_uint64) archive->db.Database.NumFiles) *
+            (sizeof (LZMAfile) + sizeof (CFileItem))) +
+        (((PHYSFS_uint64) archive->db.Database.NumFolders) *
+            (sizeof (LZMAfolder) + sizeof (CFolder))) +
+        __PHYSFS_hashTableBytes(&archive->hash);
+    __PHYSFS_memCharge(archive->mem, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) archive->index_charged);
+
     return archive;
 } /* LZMA_openArchive */
 
 
-/*
- * Moved to seperate function so we can use alloca then immediately throw
- *  away the allocated stack space...
- */
-static void doEnumCallback(PHYSFS_EnumFilesCallback cb, void *callbackdata,
-                           const char *odir, const char *str, size_t flen)
-{
-    char *newstr = __PHYSFS_smallAlloc(flen + 1);
-    if (newstr == NULL)
-        return;
-
-    memcpy(newstr, str, flen);
-    newstr[flen] = '\0';
-    cb(callbackdata, odir, newstr);
-    __PHYSFS_smallFree(newstr);
-} /* doEnumCallback */
-
-
 static void LZMA_enumerateFiles(void *opaque, const char *dname,
                                 PHYSFS_EnumFilesCallback cb,
                                 const char *origdir, void *callbackdata)
 {
-    size_t dlen = strlen(dname),
-           dlen_inc = dlen + ((dlen > 0) ? 1 : 0);
     LZMAarchive *archive = (LZMAarchive *) opaque;
-    LZMAfile *file = NULL,
-            *lastFile = &archive->files[archive->db.Database.NumFiles];
-        if (dlen)
-        {
-            file = lzma_find_file(archive, dname);
-            if (file != NULL) /* if 'file' is NULL it should stay so, otherwise errors will not be handled */
-                file += 1;
-        }
-        else
-        {
-            file = archive->files;
-        }
-
-    BAIL_IF_MACRO(file == NULL, PHYSFS_ERR_NOT_FOUND, );
+    PHYSFS_uint32 i = archive->root;
 
-    while (file < lastFile)
+    if (*dname != '\0')
     {
-        const char * fname = file->item->Name;
-        const char * dirNameEnd = fname + dlen_inc;
-
-        if (strncmp(dname, fname, dlen) != 0) /* Stop after mismatch, archive->files is sorted */
-            break;
-
-        if (strchr(dirNameEnd, '/')) /* Skip subdirs */
-        {
-            file++;
-            continue;
-        }
-
-        /* Do the actual callback... */
-        doEnumCallback(cb, callbackdata, origdir, dirNameEnd, strlen(dirNameEnd));
+        const LZMAfile *dir = lzma_find_file(archive, dname);
+        BAIL_IF_MACRO(dir == NULL, ERRPASS, );
+        i = dir->children;
+    } /* if */
 
-        file++;
-    }
+    while (i != 0)
+    {
+        const LZMAfile *file = &archive->files[i - 1];
+        const char *name = file->item->Name;
+        const char *sep = strrchr(name, '/');
+        cb(callbackdata, origdir, (sep != NULL) ? sep + 1 : name);
+        i = file->sibling;
+    } /* while */
 } /* LZMA_enumerateFiles */
 
 
@@ -579,20 +1503,11 @@ static PHYSFS_Io *LZMA_openRead(void *opaque, const char *name)
 {
     LZMAarchive *archive = (LZMAarchive *) opaque;
     LZMAfile *file = lzma_find_file(archive, name);
-    PHYSFS_Io *io = NULL;
 
     BAIL_IF_MACRO(file == NULL, PHYSFS_ERR_NOT_FOUND, NULL);
     BAIL_IF_MACRO(file->folder == NULL, PHYSFS_ERR_NOT_A_FILE, NULL);
 
-    file->position = 0;
-    file->folder->references++; /* Increase refcount for automatic cleanup... */
-
-    io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    BAIL_IF_MACRO(io == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    memcpy(io, &LZMA_Io, sizeof (*io));
-    io->opaque = file;
-
-    return io;
+    return lzma_open_io(file);
 } /* LZMA_openRead */
 
 
@@ -611,6 +1526,7 @@ static PHYSFS_Io *LZMA_openAppend(void *opaque, const char *filename)
 static void LZMA_closeArchive(void *opaque)
 {
     LZMAarchive *archive = (LZMAarchive *) opaque;
+    PHYSFS_uint32 folderIndex = 0;
 
 #if 0  /* !!! FIXME: you shouldn't have to do this. */
     PHYSFS_uint32 fileIndex = 0, numFiles = archive->db.Database.NumFiles;
@@ -620,6 +1536,19 @@ static void LZMA_closeArchive(void *opaque)
     } /* for */
 #endif
 
+    while (archive->lru_head != NULL)
+        lzma_folder_drop(archive, archive->lru_head);
+
+    for (folderIndex = 0; folderIndex < archive->db.Database.NumFolders;
+         folderIndex++)
+    {
+        lzma_stream_free(archive, archive->folders[folderIndex].stream);
+        if (archive->folders[folderIndex].latch != NULL)
+            __PHYSFS_platformDestroyMutex(archive->folders[folderIndex].latch);
+    } /* for */
+
+    __PHYSFS_memCharge(archive->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) archive->index_charged));
     SzArDbExFree(&archive->db, SzFreePhysicsFS);
     archive->stream.io->destroy(archive->stream.io);
     lzma_archive_exit(archive);
@@ -637,14 +1566,8 @@ static int LZMA_mkdir(void *opaque, const char *name)
     BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
 } /* LZMA_mkdir */
 
-static int LZMA_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
+static void lzma_file_stat(const LZMAfile *file, PHYSFS_Stat *stat)
 {
-    const LZMAarchive *archive = (const LZMAarchive *) opaque;
-    const LZMAfile *file = lzma_find_file(archive, filename);
-
-    if (!file)
-        return 0;
-
     if(file->item->IsDirectory)
     {
         stat->filesize = 0;
@@ -667,11 +1590,336 @@ static int LZMA_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
     stat->accesstime = 0;
 
     stat->readonly = 1;  /* 7zips are always read only */
+} /* lzma_file_stat */
+
+
+static int LZMA_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
+{
+    const LZMAarchive *archive = (const LZMAarchive *) opaque;
+    const LZMAfile *file = lzma_find_file(archive, filename);
 
+    if (!file)
+        return 0;
+
+    lzma_file_stat(file, stat);
     return 1;
 } /* LZMA_stat */
 
 
+static int LZMA_checksum(void *opaque, const char *filename,
+                         PHYSFS_uint32 *crc)
+{
+    const LZMAarchive *archive = (const LZMAarchive *) opaque;
+    const LZMAfile *file = lzma_find_file(archive, filename);
+
+    BAIL_IF_MACRO(!file, ERRPASS, 0);
+    BAIL_IF_MACRO(file->item->IsDirectory, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    if (!file->item->HasStream)
+        *crc = 0;  /* empty files have no data, or crc, but that's it. */
+    else
+    {
+        BAIL_IF_MACRO(!file->item->IsFileCRCDefined,
+                      PHYSFS_ERR_UNSUPPORTED, 0);
+        *crc = (PHYSFS_uint32) file->item->FileCRC;
+    } /* else */
+
+    return 1;
+} /* LZMA_checksum */
+
+
+static int LZMA_layout(void *opaque, const char *filename,
+                       PHYSFS_EntryLayout *layout)
+{
+    LZMAarchive *archive = (LZMAarchive *) opaque;
+    const LZMAfile *file = lzma_find_file(archive, filename);
+    const LZMAfolder *folder;
+    const CFolder *f;
+    PHYSFS_uint32 packIndex;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!file, ERRPASS, 0);
+    BAIL_IF_MACRO(file->item->IsDirectory, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    layout->size = file->item->Size;
+    folder = file->folder;
+    if (folder == NULL)  /* empty files have no data anywhere. */
+        return 1;
+
+    f = &archive->db.Database.Folders[folder->index];
+    layout->method = (PHYSFS_uint32) f->Coders[0].MethodID;
+    if (folder->copy)  /* a stored folder is just its files, one by one. */
+    {
+        layout->offset = folder->pack_pos + file->offset;
+        layout->storedSize = file->item->Size;
+        return 1;
+    } /* if */
+
+    layout->offset = SzArDbGetFolderStreamPos(&archive->db, folder->index, 0);
+    packIndex = archive->db.FolderStartPackStreamIndex[folder->index];
+    for (i = 0; i < f->NumPackStreams; i++)
+        layout->storedSize += archive->db.Database.PackSizes[packIndex + i];
+    layout->encoding = PHYSFS_ENCODING_OTHER;
+    layout->group = (PHYSFS_sint64) folder->index;
+    layout->groupOffset = file->offset;
+    return 1;
+} /* LZMA_layout */
+
+
+static void LZMA_enumerateFilesStat(void *opaque, const char *dname,
+                                    PHYSFS_EnumFilesStatCallback cb,
+                                    const char *origdir, void *callbackdata)
+{
+    LZMAarchive *archive = (LZMAarchive *) opaque;
+    PHYSFS_uint32 i = archive->root;
+
+    if (*dname != '\0')
+    {
+        const LZMAfile *dir = lzma_find_file(archive, dname);
+        BAIL_IF_MACRO(dir == NULL, ERRPASS, );
+        i = dir->children;
+    } /* if */
+
+    while (i != 0)
+    {
+        const LZMAfile *file = &archive->files[i - 1];
+        const char *name = file->item->Name;
+        const char *sep = strrchr(name, '/');
+        PHYSFS_Stat stat;
+        lzma_file_stat(file, &stat);
+        cb(callbackdata, origdir, (sep != NULL) ? sep + 1 : name, &stat);
+        i = file->sibling;
+    } /* while */
+} /* LZMA_enumerateFilesStat */
+
+
+int __PHYSFS_lzmaGetFolder(PHYSFS_Io *io, void **archive, PHYSFS_Io **src,
+                           PHYSFS_uint32 *folder, PHYSFS_uint64 *len)
+{
+    LZMAfile *file = NULL;
+    int retval;
+
+    if (io->read != LZMA_read)
+        return 0;
+
+    file = ((LZMAfileinfo *) io->opaque)->file;
+    if (file->folder->copy)
+        return 0;  /* it's never decompressed. */
+
+    __PHYSFS_platformGrabMutex(file->archive->lock);
+    retval = (file->folder->cache == NULL);
+    __PHYSFS_platformReleaseMutex(file->archive->lock);
+    if (!retval)
+        return 0;  /* nothing to do. */
+
+    *archive = file->archive;
+    *src = file->archive->stream.io;
+    *folder = file->folder->index;
+    *len = SzFolderGetUnPackSize(
+                &file->archive->db.Database.Folders[file->folder->index]);
+    return 1;
+} /* __PHYSFS_lzmaGetFolder */
+
+
+static int lzma_decode_folder(const LZMAarchive *archive,
+                              PHYSFS_uint32 folderIndex, PHYSFS_Io *src,
+                              void **buf, size_t *len)
+{
+    const UInt32 fileIndex = archive->db.FolderStartFileIndex[folderIndex];
+    const char *name = archive->db.Database.Files[fileIndex].Name;
+    FileInputStream stream;
+    UInt32 blockIndex = (UInt32) -1;
+    Byte *outBuffer = NULL;
+    size_t outSize = 0;
+    size_t offset = 0;
+    size_t fileSize = 0;
+    int rc;
+
+    /* Same as the archive's, but reading from (src), and nothing else. */
+    memcpy(&stream, &archive->stream, sizeof (stream));
+    stream.io = src;
+
+    /* SzExtract() only uses this for the folder it hands back. */
+    stream.allocImp.Alloc = SzCacheAllocPhysicsFS;
+    stream.allocImp.Free = __PHYSFS_cacheFree;
+
+    /* ...and this for what it needs while decoding it. */
+    stream.allocTempImp.Alloc = SzScratchAllocPhysicsFS;
+    stream.allocTempImp.Free = __PHYSFS_scratchFree;
+
+    /* the database isn't changed by this, so it can be shared. */
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_DECOMPRESS, name, NULL, 0);
+    rc = lzma_err(SzExtract(&stream.inStream,
+                            (CArchiveDatabaseEx *) &archive->db, fileIndex,
+                            &blockIndex, &outBuffer, &outSize, &offset,
+                            &fileSize, &stream.allocImp,
+                            &stream.allocTempImp));
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_DECOMPRESS, name, NULL,
+                       (rc == SZ_OK) ? (PHYSFS_sint64) outSize : -1,
+                       rc == SZ_OK);
+    if (rc != SZ_OK)
+    {
+        __PHYSFS_cacheFree(outBuffer);
+        return 0;
+    } /* if */
+
+    __PHYSFS_STAT_INCR(folderDecodes7z);
+    __PHYSFS_STAT_ADD(bytesDecompressed7z, outSize);
+
+    if (outSize > 0)
+    {
+        PHYSFS_uint8 key[LZMA_SPILL_KEY_LEN];
+        const size_t keylen = lzma_spill_key(archive, folderIndex, key);
+        if (keylen > 0)
+            __PHYSFS_spillSave(key, keylen, outBuffer, outSize);
+    } /* if */
+
+    *buf = outBuffer;
+    *len = outSize;
+    return 1;
+} /* lzma_decode_folder */
+
+
+int __PHYSFS_lzmaDecodeFolder(const void *_archive, PHYSFS_uint32 folderIndex,
+                              PHYSFS_Io *src, void **buf, size_t *len)
+{
+    const LZMAarchive *archive = (const LZMAarchive *) _archive;
+    const void *spilled = NULL;
+    void *spill = lzma_spill_load(archive, folderIndex, &spilled, len);
+
+    /* this hands back cache memory, so copy it; that's still quicker. */
+    if (spill != NULL)
+    {
+        *buf = __PHYSFS_cacheAlloc(*len);
+        if (*buf != NULL)
+            memcpy(*buf, spilled, *len);
+        __PHYSFS_platformUnmapFile(spill);
+        if (*buf != NULL)
+            return 1;
+    } /* if */
+
+    return lzma_decode_folder(archive, folderIndex, src, buf, len);
+} /* __PHYSFS_lzmaDecodeFolder */
+
+
+void __PHYSFS_lzmaCacheFolder(void *_archive, PHYSFS_uint32 folderIndex,
+                              void *buf, size_t len)
+{
+    LZMAarchive *archive = (LZMAarchive *) _archive;
+    LZMAfolder *folder = &archive->folders[folderIndex];
+
+    __PHYSFS_platformGrabMutex(archive->lock);
+    if (folder->cache != NULL)  /* somebody read it meanwhile? */
+        __PHYSFS_cacheFree(buf);
+    else if (__PHYSFS_memExcess(PHYSFS_MEMORY_CACHES))  /* no room after all */
+        __PHYSFS_cacheFree(buf);
+    else
+    {
+        __PHYSFS_cacheOwner(buf, archive->mem);
+        folder->cache = (PHYSFS_uint8 *) buf;
+        folder->size = len;
+        lzma_folder_link(archive, folder);
+        archive->cache_used += len;
+        lzma_cache_trim(archive, folder);
+    } /* else */
+    __PHYSFS_platformReleaseMutex(archive->lock);
+} /* __PHYSFS_lzmaCacheFolder */
+
+
+int __PHYSFS_lzmaGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                               PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                               PHYSFS_uint64 *len)
+{
+    const LZMAfile *file;
+
+    if (io->read != LZMA_read)
+        return 0;
+
+    file = ((const LZMAfileinfo *) io->opaque)->file;
+    if (!file->folder->copy)
+        return 0;
+
+    *archive = file->archive;
+    *src = file->archive->stream.io;
+    *pos = file->folder->pack_pos + file->offset;
+    *len = file->item->Size;
+    return 1;
+} /* __PHYSFS_lzmaGetStoredSpan */
+
+
+int __PHYSFS_lzmaCheckWhole(PHYSFS_Io *io, const void *buf, PHYSFS_uint64 len)
+{
+    LZMAfileinfo *finfo;
+
+    if (io->read != LZMA_read)
+        return 1;
+
+    finfo = (LZMAfileinfo *) io->opaque;
+    return __PHYSFS_crcCheckRead(&finfo->crccheck, buf, len, 0,
+                                 finfo->file->item->Size,
+                                 finfo->file->item->FileCRC);
+} /* __PHYSFS_lzmaCheckWhole */
+
+
+int __PHYSFS_lzmaGetFileSpan(PHYSFS_Io *io, const void **archive,
+                             PHYSFS_uint32 *folder, PHYSFS_uint64 *offset)
+{
+    LZMAfile *file = NULL;
+
+    if (io->read != LZMA_read)
+        return 0;
+
+    file = ((LZMAfileinfo *) io->opaque)->file;
+    *archive = file->archive;
+    *folder = file->folder->index;
+    *offset = (PHYSFS_uint64) file->offset;
+    return 1;
+} /* __PHYSFS_lzmaGetFileSpan */
+
+
+int __PHYSFS_lzmaHoldFolder(PHYSFS_Io *io)
+{
+    LZMAfile *file = ((LZMAfileinfo *) io->opaque)->file;
+    LZMAarchive *archive = file->archive;
+    int retval = 0;
+
+    if (file->folder->copy)
+        return 0;  /* it's read in place, so there's nothing to hold. */
+
+    __PHYSFS_platformGrabMutex(archive->lock);
+    if ((!lzma_folder_streams(archive, file->folder)) &&
+        (lzma_folder_load(file)))
+    {
+        file->folder->pins++;  /* lzma_cache_trim() leaves it alone now. */
+        retval = 1;
+    } /* if */
+    __PHYSFS_platformReleaseMutex(archive->lock);
+
+    return retval;
+} /* __PHYSFS_lzmaHoldFolder */
+
+
+void __PHYSFS_lzmaReleaseFolder(PHYSFS_Io *io)
+{
+    LZMAfile *file = ((LZMAfileinfo *) io->opaque)->file;
+    LZMAarchive *archive = file->archive;
+
+    __PHYSFS_platformGrabMutex(archive->lock);
+    file->folder->pins--;
+    lzma_cache_trim(archive, NULL);  /* in case it held us over budget. */
+    __PHYSFS_platformReleaseMutex(archive->lock);
+} /* __PHYSFS_lzmaReleaseFolder */
+
+
+static int LZMA_claim(const void *head, PHYSFS_uint64 headLen,
+                      const void *tail, PHYSFS_uint64 tailLen,
+                      PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= k7zSignatureSize) &&
+            (TestSignatureCandidate((Byte *) head)));
+} /* LZMA_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_LZMA =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -690,7 +1938,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_LZMA =
     LZMA_remove,
     LZMA_mkdir,
     LZMA_stat,
-    LZMA_closeArchive
+    LZMA_closeArchive,
+    LZMA_enumerateFilesStat,
+    LZMA_claim,
+    NULL,  /* enumerateFilesPrefix */
+    LZMA_checksum,
+    LZMA_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_7Z */
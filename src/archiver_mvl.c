@@ -37,25 +37,33 @@ static UNPKentry *mvlLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
     PHYSFS_uint32 location = 8;  /* sizeof sig. */
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 *table = NULL;
+    const PHYSFS_uint8 *rec = NULL;
+
+    table = (PHYSFS_uint8 *) UNPK_readTable(io, fileCount, 17);
+    BAIL_IF_MACRO(!table, ERRPASS, NULL);
 
     entries = (UNPKentry *) allocator.Malloc(sizeof (UNPKentry) * fileCount);
-    BAIL_IF_MACRO(entries == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
 
     location += (17 * fileCount);
 
-    for (entry = entries; fileCount > 0; fileCount--, entry++)
+    for (entry = entries, rec = table; fileCount > 0; fileCount--, entry++)
     {
-        if (!__PHYSFS_readAll(io, &entry->name, 13)) goto failed;
-        if (!__PHYSFS_readAll(io, &entry->size, 4)) goto failed;
+        memcpy(entry->name, rec, 13);
+        entry->name[13] = '\0';  /* in case the name fills the field. */
+        memcpy(&entry->size, rec + 13, 4);
         entry->size = PHYSFS_swapULE32(entry->size);
         entry->startPos = location;
         location += entry->size;
+        rec += 17;
     } /* for */
 
+    allocator.Free(table);
     return entries;
 
 failed:
-    allocator.Free(entries);
+    allocator.Free(table);
     return NULL;
 } /* mvlLoadEntries */
 
@@ -78,6 +86,14 @@ static void *MVL_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* MVL_openArchive */
 
 
+static int MVL_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 4) && (memcmp(head, "DMVL", 4) == 0));
+} /* MVL_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_MVL =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -96,7 +112,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_MVL =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    MVL_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_MVL */
@@ -0,0 +1,678 @@
+/*
+ * Overlay support routines for PhysicsFS.
+ *
+ * An overlay is a base archive with patch archives merged over it, mounted
+ *  as one thing by PHYSFS_mountOverlay(). Every layer is listed once, when
+ *  it's mounted, into one table of every path the overlay has and which
+ *  layer it comes from, so a lookup is one probe of that table instead of
+ *  a trip down the search path asking each patch and then the base.
+ *
+ * Patches win over the layers under them. A file named ".wh.NAME" in a
+ *  patch is a whiteout: it deletes NAME (and everything in it, if it's a
+ *  directory) from the layers under that patch, and isn't listed itself.
+ *  A file named ".wh..wh..opq" in a patch's directory deletes everything
+ *  the layers under it have in that directory, but not the directory.
+ *  Those are the names union filesystems and container images use.
+ *
+ * Since the table is built from what each layer lists, names match
+ *  exactly, even if a layer's own lookups wouldn't.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#define __PHYSICSFS_INTERNAL__
+#include "physfs_internal.h"
+
+#define OVERLAY_WHITEOUT ".wh."
+#define OVERLAY_WHITEOUT_LEN 4
+#define OVERLAY_OPAQUE ".wh..wh..opq"
+
+typedef struct
+{
+    const char *path;       /* full path in the overlay; "" for the root.  */
+    PHYSFS_uint32 hash;
+    PHYSFS_uint32 layer;    /* which layer it comes from.                  */
+    int deleted;            /* non-zero if a patch took it away.           */
+    PHYSFS_Stat stat;       /* from when that layer was listed.            */
+    size_t firstChild;      /* index + 1, or zero. Only once it's built.   */
+    size_t nextSibling;     /* index + 1, or zero.                         */
+} OverlayEntry;
+
+typedef struct
+{
+    const PHYSFS_Archiver **funcs;  /* one for each layer, base first.     */
+    void **opaques;
+    size_t numLayers;
+    OverlayEntry *entries;  /* entry 0 is the root.                        */
+    size_t numEntries;
+    size_t allocEntries;
+    size_t *slots;          /* open-addressed entry indexes + 1.           */
+    size_t numSlots;        /* always a power of two.                      */
+    __PHYSFS_Arena names;
+} OverlayInfo;
+
+static PHYSFS_uint32 overlayHash(const char *path)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (*path)
+        hash = ((hash << 5) + hash) ^ ((PHYSFS_uint32) (PHYSFS_uint8) *path++);
+    return hash;
+} /* overlayHash */
+
+
+/* Returns the index of (path)'s entry, deleted or not, or -1. */
+static PHYSFS_sint64 overlayFind(const OverlayInfo *info, const char *path)
+{
+    const PHYSFS_uint32 hash = overlayHash(path);
+    const size_t mask = info->numSlots - 1;
+    size_t i;
+
+    for (i = hash & mask; info->slots[i] != 0; i = (i + 1) & mask)
+    {
+        const OverlayEntry *entry = &info->entries[info->slots[i] - 1];
+        if ((entry->hash == hash) && (strcmp(entry->path, path) == 0))
+            return (PHYSFS_sint64) (info->slots[i] - 1);
+    } /* for */
+
+    return -1;
+} /* overlayFind */
+
+
+/* Find (path), if it's there and nothing deleted it. */
+static const OverlayEntry *overlayLookup(const OverlayInfo *info,
+                                         const char *path)
+{
+    const PHYSFS_sint64 idx = overlayFind(info, path);
+    BAIL_IF_MACRO(idx < 0, PHYSFS_ERR_NOT_FOUND, NULL);
+    BAIL_IF_MACRO(info->entries[idx].deleted, PHYSFS_ERR_NOT_FOUND, NULL);
+    return &info->entries[idx];
+} /* overlayLookup */
+
+
+static void overlaySlot(OverlayInfo *info, const size_t idx)
+{
+    const size_t mask = info->numSlots - 1;
+    size_t i = info->entries[idx].hash & mask;
+    while (info->slots[i] != 0)
+        i = (i + 1) & mask;
+    info->slots[i] = idx + 1;
+} /* overlaySlot */
+
+
+/* Make room for one more entry, keeping the table at least half empty. */
+static int overlayGrow(OverlayInfo *info)
+{
+    size_t i;
+
+    if (info->numEntries == info->allocEntries)
+    {
+        const size_t newalloc = info->allocEntries * 2;
+        void *ptr = allocator.Realloc(info->entries,
+                                      newalloc * sizeof (OverlayEntry));
+        BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        info->entries = (OverlayEntry *) ptr;
+        info->allocEntries = newalloc;
+    } /* if */
+
+    if ((info->numEntries + 1) * 2 > info->numSlots)
+    {
+        const size_t newslots = info->numSlots * 2;
+        size_t *ptr = (size_t *) allocator.Malloc(newslots * sizeof (size_t));
+        BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        memset(ptr, '\0', newslots * sizeof (size_t));
+        allocator.Free(info->slots);
+        info->slots = ptr;
+        info->numSlots = newslots;
+        for (i = 0; i < info->numEntries; i++)
+            overlaySlot(info, i);
+    } /* if */
+
+    return 1;
+} /* overlayGrow */
+
+
+/* Delete everything under (dir), but not (dir) itself. */
+static void overlayDeleteChildren(OverlayInfo *info, const char *dir)
+{
+    const size_t len = strlen(dir);
+    size_t i;
+
+    /* whiting out directories is rare; a walk of everything will do. */
+    for (i = 1; i < info->numEntries; i++)
+    {
+        OverlayEntry *entry = &info->entries[i];
+        if (len == 0)
+            entry->deleted = 1;
+        else if ((strncmp(entry->path, dir, len) == 0) &&
+                 (entry->path[len] == '/'))
+            entry->deleted = 1;
+    } /* for */
+} /* overlayDeleteChildren */
+
+
+static void overlayDelete(OverlayInfo *info, const char *path)
+{
+    const PHYSFS_sint64 idx = overlayFind(info, path);
+    if ((idx > 0) && (!info->entries[idx].deleted))
+    {
+        OverlayEntry *entry = &info->entries[idx];
+        entry->deleted = 1;
+        if (entry->stat.filetype == PHYSFS_FILETYPE_DIRECTORY)
+            overlayDeleteChildren(info, path);
+    } /* if */
+} /* overlayDelete */
+
+
+/* (layer) has (path); put it over whatever was there. */
+static int overlayAdd(OverlayInfo *info, const char *path,
+                      const PHYSFS_Stat *stat, const PHYSFS_uint32 layer)
+{
+    const int isdir = (stat->filetype == PHYSFS_FILETYPE_DIRECTORY);
+    const PHYSFS_sint64 idx = overlayFind(info, path);
+    OverlayEntry *entry;
+
+    if (idx >= 0)
+    {
+        entry = &info->entries[idx];
+        if ((!entry->deleted) && (!isdir) &&
+            (entry->stat.filetype == PHYSFS_FILETYPE_DIRECTORY))
+            overlayDeleteChildren(info, path);  /* a file replaces it all. */
+        entry->deleted = 0;
+    } /* if */
+
+    else
+    {
+        BAIL_IF_MACRO(!overlayGrow(info), ERRPASS, 0);
+        entry = &info->entries[info->numEntries];
+        memset(entry, '\0', sizeof (OverlayEntry));
+        entry->path = __PHYSFS_arenaStrdup(&info->names, path);
+        BAIL_IF_MACRO(!entry->path, ERRPASS, 0);
+        entry->hash = overlayHash(path);
+        overlaySlot(info, info->numEntries++);
+    } /* else */
+
+    entry->layer = layer;
+    memcpy(&entry->stat, stat, sizeof (PHYSFS_Stat));
+    entry->stat.readonly = 1;
+    return 1;
+} /* overlayAdd */
+
+
+static void overlayListAdd(__PHYSFS_ArchiveListing *list, const char *dir,
+                           const char *fname, const PHYSFS_Stat *stat)
+{
+    const size_t dirlen = strlen(dir);
+    char *path;
+
+    if (list->failed)
+        return;
+
+    if (list->count == list->alloced)
+    {
+        const size_t newalloc = list->alloced ? list->alloced * 2 : 64;
+        void *ptr = allocator.Realloc(list->paths, newalloc * sizeof (char *));
+        if (ptr != NULL)
+        {
+            list->paths = (char **) ptr;
+            ptr = allocator.Realloc(list->stats,
+                                    newalloc * sizeof (PHYSFS_Stat));
+        } /* if */
+
+        if (ptr == NULL)
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+            list->failed = 1;
+            return;
+        } /* if */
+
+        list->stats = (PHYSFS_Stat *) ptr;
+        list->alloced = newalloc;
+    } /* if */
+
+    path = (char *) allocator.Malloc(dirlen + strlen(fname) + 2);
+    if (path == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        list->failed = 1;
+        return;
+    } /* if */
+
+    if (dirlen == 0)
+        strcpy(path, fname);
+    else
+        sprintf(path, "%s/%s", dir, fname);
+
+    list->paths[list->count] = path;
+    memcpy(&list->stats[list->count], stat, sizeof (PHYSFS_Stat));
+    list->count++;
+} /* overlayListAdd */
+
+
+static void overlayListStatCallback(void *data, const char *origdir,
+                                    const char *fname,
+                                    const PHYSFS_Stat *stat)
+{
+    overlayListAdd((__PHYSFS_ArchiveListing *) data, origdir, fname, stat);
+} /* overlayListStatCallback */
+
+
+typedef struct
+{
+    const PHYSFS_Archiver *funcs;
+    void *opaque;
+    __PHYSFS_ArchiveListing *list;
+} OverlayStatData;
+
+/* For archivers without enumerateFilesStat(), stat each name as it comes. */
+static void overlayListCallback(void *data, const char *origdir,
+                                const char *fname)
+{
+    OverlayStatData *sd = (OverlayStatData *) data;
+    const size_t dirlen = strlen(origdir);
+    PHYSFS_Stat stat;
+    char *path;
+
+    if (sd->list->failed)
+        return;
+
+    path = (char *) __PHYSFS_smallAlloc(dirlen + strlen(fname) + 2);
+    if (path == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        sd->list->failed = 1;
+        return;
+    } /* if */
+
+    if (dirlen == 0)
+        strcpy(path, fname);
+    else
+        sprintf(path, "%s/%s", origdir, fname);
+
+    if (sd->funcs->stat(sd->opaque, path, &stat))
+        overlayListAdd(sd->list, origdir, fname, &stat);
+    __PHYSFS_smallFree(path);
+} /* overlayListCallback */
+
+
+static void overlayListDir(const PHYSFS_Archiver *funcs, void *opaque,
+                           const char *dir, __PHYSFS_ArchiveListing *list)
+{
+    if (funcs->enumerateFilesStat != NULL)
+    {
+        funcs->enumerateFilesStat(opaque, dir, overlayListStatCallback,
+                                  dir, list);
+    } /* if */
+    else
+    {
+        OverlayStatData sd;
+        sd.funcs = funcs;
+        sd.opaque = opaque;
+        sd.list = list;
+        funcs->enumerateFiles(opaque, dir, overlayListCallback, dir, &sd);
+    } /* else */
+} /* overlayListDir */
+
+
+int __PHYSFS_listArchive(const PHYSFS_Archiver *funcs, void *opaque,
+                         __PHYSFS_ArchiveListing *list)
+{
+    size_t i;
+
+    memset(list, '\0', sizeof (*list));
+    overlayListDir(funcs, opaque, "", list);
+
+    /* (list) is its own work queue, so parents always come first. */
+    for (i = 0; (!list->failed) && (i < list->count); i++)
+    {
+        if (list->stats[i].filetype == PHYSFS_FILETYPE_DIRECTORY)
+            overlayListDir(funcs, opaque, list->paths[i], list);
+    } /* for */
+
+    return !list->failed;
+} /* __PHYSFS_listArchive */
+
+
+void __PHYSFS_freeArchiveListing(__PHYSFS_ArchiveListing *list)
+{
+    size_t i;
+    for (i = 0; i < list->count; i++)
+        allocator.Free(list->paths[i]);
+    allocator.Free(list->paths);
+    allocator.Free(list->stats);
+} /* __PHYSFS_freeArchiveListing */
+
+
+/* Is (path)'s last component (name)? */
+static const char *overlayBaseName(const char *path)
+{
+    const char *ptr = strrchr(path, '/');
+    return ptr ? ptr + 1 : path;
+} /* overlayBaseName */
+
+
+/* List all of layer (layer), then merge it over the layers under it. */
+static int overlayMergeLayer(OverlayInfo *info, const PHYSFS_uint32 layer)
+{
+    const PHYSFS_Archiver *funcs = info->funcs[layer];
+    void *opaque = info->opaques[layer];
+    __PHYSFS_ArchiveListing list;
+    size_t i;
+
+    GOTO_IF_MACRO(!__PHYSFS_listArchive(funcs, opaque, &list),
+                  ERRPASS, mergeFailed);
+
+    /* whiteouts only hide what's under this layer, so they go first. */
+    for (i = 0; (layer > 0) && (i < list.count); i++)
+    {
+        char *path = list.paths[i];
+        char *name = (char *) overlayBaseName(path);
+        if (strncmp(name, OVERLAY_WHITEOUT, OVERLAY_WHITEOUT_LEN) != 0)
+            continue;
+        else if (strcmp(name, OVERLAY_OPAQUE) == 0)
+        {
+            if (name != path)
+                name[-1] = '\0';  /* chop it to the directory it's in. */
+            overlayDeleteChildren(info, (name != path) ? path : "");
+            if (name != path)
+                name[-1] = '/';
+        } /* else if */
+        else
+        {
+            /* ".wh.NAME" in "dir" -> "dir/NAME". */
+            memmove(name, name + OVERLAY_WHITEOUT_LEN,
+                    strlen(name + OVERLAY_WHITEOUT_LEN) + 1);
+            overlayDelete(info, path);
+            *name = '\0';  /* so it isn't added below. */
+        } /* else */
+    } /* for */
+
+    for (i = 0; i < list.count; i++)
+    {
+        const char *name = overlayBaseName(list.paths[i]);
+        if (*name == '\0')
+            continue;  /* a whiteout, already dealt with. */
+        else if ((layer > 0) && (strcmp(name, OVERLAY_OPAQUE) == 0))
+            continue;
+        GOTO_IF_MACRO(!overlayAdd(info, list.paths[i], &list.stats[i], layer),
+                      ERRPASS, mergeFailed);
+    } /* for */
+
+    __PHYSFS_freeArchiveListing(&list);
+    return 1;
+
+mergeFailed:
+    __PHYSFS_freeArchiveListing(&list);
+    return 0;
+} /* overlayMergeLayer */
+
+
+/* Link everything that survived to its parent directory, for listings. */
+static void overlayLinkChildren(OverlayInfo *info)
+{
+    size_t i;
+
+    for (i = 1; i < info->numEntries; i++)
+    {
+        OverlayEntry *entry = &info->entries[i];
+        const char *ptr = strrchr(entry->path, '/');
+        PHYSFS_sint64 parent = 0;
+
+        if (entry->deleted)
+            continue;
+
+        if (ptr != NULL)
+        {
+            const size_t len = (size_t) (ptr - entry->path);
+            char *dir = (char *) __PHYSFS_smallAlloc(len + 1);
+            if (dir == NULL)
+                parent = -1;
+            else
+            {
+                memcpy(dir, entry->path, len);
+                dir[len] = '\0';
+                parent = overlayFind(info, dir);
+                __PHYSFS_smallFree(dir);
+            } /* else */
+        } /* if */
+
+        /* parents are listed first, and deleting one deletes its kids. */
+        if ((parent >= 0) && (!info->entries[parent].deleted))
+        {
+            entry->nextSibling = info->entries[parent].firstChild;
+            info->entries[parent].firstChild = i + 1;
+        } /* if */
+        else
+        {
+            entry->deleted = 1;  /* can't be reached; don't pretend. */
+        } /* else */
+    } /* for */
+} /* overlayLinkChildren */
+
+
+static void overlayFreeInfo(OverlayInfo *info)
+{
+    allocator.Free(info->funcs);
+    allocator.Free(info->opaques);
+    allocator.Free(info->entries);
+    allocator.Free(info->slots);
+    __PHYSFS_arenaDeinit(&info->names);
+    allocator.Free(info);
+} /* overlayFreeInfo */
+
+
+void *__PHYSFS_createOverlay(const PHYSFS_Archiver **funcs, void **opaques,
+                             const size_t count)
+{
+    OverlayInfo *info;
+    PHYSFS_Stat rootstat;
+    size_t i;
+
+    BAIL_IF_MACRO(count == 0, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+
+    info = (OverlayInfo *) allocator.Malloc(sizeof (OverlayInfo));
+    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(info, '\0', sizeof (OverlayInfo));
+    __PHYSFS_arenaInit(&info->names);
+
+    info->funcs = (const PHYSFS_Archiver **)
+                        allocator.Malloc(count * sizeof (PHYSFS_Archiver *));
+    info->opaques = (void **) allocator.Malloc(count * sizeof (void *));
+    info->allocEntries = 64;
+    info->entries = (OverlayEntry *)
+                        allocator.Malloc(64 * sizeof (OverlayEntry));
+    info->numSlots = 128;
+    info->slots = (size_t *) allocator.Malloc(128 * sizeof (size_t));
+    if (!info->funcs || !info->opaques || !info->entries || !info->slots)
+    {
+        overlayFreeInfo(info);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    memcpy(info->funcs, funcs, count * sizeof (PHYSFS_Archiver *));
+    memcpy(info->opaques, opaques, count * sizeof (void *));
+    info->numLayers = count;
+    memset(info->slots, '\0', 128 * sizeof (size_t));
+
+    memset(&rootstat, '\0', sizeof (rootstat));
+    rootstat.filetype = PHYSFS_FILETYPE_DIRECTORY;
+    rootstat.modtime = rootstat.createtime = rootstat.accesstime = -1;
+    if (!overlayAdd(info, "", &rootstat, 0))
+    {
+        overlayFreeInfo(info);
+        return NULL;
+    } /* if */
+
+    for (i = 0; i < count; i++)
+    {
+        if (!overlayMergeLayer(info, (PHYSFS_uint32) i))
+        {
+            overlayFreeInfo(info);
+            return NULL;
+        } /* if */
+    } /* for */
+
+    overlayLinkChildren(info);
+    return info;
+} /* __PHYSFS_createOverlay */
+
+
+static void *OVERLAY_openArchive(PHYSFS_Io *io, const char *name,
+                                 int forWriting)
+{
+    /* only PHYSFS_mountOverlay() makes these. */
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* OVERLAY_openArchive */
+
+
+static void OVERLAY_enumerateFiles(void *opaque, const char *dname,
+                                   PHYSFS_EnumFilesCallback cb,
+                                   const char *origdir, void *callbackdata)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *dir = overlayLookup(info, dname);
+    size_t i;
+
+    if ((dir == NULL) || (dir->stat.filetype != PHYSFS_FILETYPE_DIRECTORY))
+        return;
+
+    for (i = dir->firstChild; i != 0; i = info->entries[i - 1].nextSibling)
+        cb(callbackdata, origdir, overlayBaseName(info->entries[i - 1].path));
+} /* OVERLAY_enumerateFiles */
+
+
+static void OVERLAY_enumerateFilesStat(void *opaque, const char *dname,
+                                       PHYSFS_EnumFilesStatCallback cb,
+                                       const char *origdir,
+                                       void *callbackdata)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *dir = overlayLookup(info, dname);
+    size_t i;
+
+    if ((dir == NULL) || (dir->stat.filetype != PHYSFS_FILETYPE_DIRECTORY))
+        return;
+
+    for (i = dir->firstChild; i != 0; i = info->entries[i - 1].nextSibling)
+    {
+        const OverlayEntry *entry = &info->entries[i - 1];
+        cb(callbackdata, origdir, overlayBaseName(entry->path), &entry->stat);
+    } /* for */
+} /* OVERLAY_enumerateFilesStat */
+
+
+static PHYSFS_Io *OVERLAY_openRead(void *opaque, const char *fnm)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *entry = overlayLookup(info, fnm);
+    BAIL_IF_MACRO(!entry, ERRPASS, NULL);
+    BAIL_IF_MACRO(entry->stat.filetype == PHYSFS_FILETYPE_DIRECTORY,
+                  PHYSFS_ERR_NOT_A_FILE, NULL);
+    return info->funcs[entry->layer]->openRead(info->opaques[entry->layer],
+                                               fnm);
+} /* OVERLAY_openRead */
+
+
+static PHYSFS_Io *OVERLAY_openWrite(void *opaque, const char *filename)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* OVERLAY_openWrite */
+
+
+static PHYSFS_Io *OVERLAY_openAppend(void *opaque, const char *filename)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* OVERLAY_openAppend */
+
+
+static int OVERLAY_remove(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* OVERLAY_remove */
+
+
+static int OVERLAY_mkdir(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* OVERLAY_mkdir */
+
+
+static int OVERLAY_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *entry = overlayLookup(info, filename);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    memcpy(stat, &entry->stat, sizeof (PHYSFS_Stat));
+    return 1;
+} /* OVERLAY_stat */
+
+
+static int OVERLAY_checksum(void *opaque, const char *filename,
+                            PHYSFS_uint32 *crc)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *entry = overlayLookup(info, filename);
+    const PHYSFS_Archiver *funcs;
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->stat.filetype == PHYSFS_FILETYPE_DIRECTORY,
+                  PHYSFS_ERR_NOT_A_FILE, 0);
+    funcs = info->funcs[entry->layer];
+    BAIL_IF_MACRO(!funcs->checksum, PHYSFS_ERR_UNSUPPORTED, 0);
+    return funcs->checksum(info->opaques[entry->layer], filename, crc);
+} /* OVERLAY_checksum */
+
+
+static int OVERLAY_layout(void *opaque, const char *filename,
+                          PHYSFS_EntryLayout *layout)
+{
+    const OverlayInfo *info = (const OverlayInfo *) opaque;
+    const OverlayEntry *entry = overlayLookup(info, filename);
+    const PHYSFS_Archiver *funcs;
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->stat.filetype == PHYSFS_FILETYPE_DIRECTORY,
+                  PHYSFS_ERR_NOT_A_FILE, 0);
+
+    /* the overlay's mounted under the base's name; a patch's is lost. */
+    BAIL_IF_MACRO(entry->layer != 0, PHYSFS_ERR_UNSUPPORTED, 0);
+    funcs = info->funcs[0];
+    BAIL_IF_MACRO(!funcs->layout, PHYSFS_ERR_UNSUPPORTED, 0);
+    return funcs->layout(info->opaques[0], filename, layout);
+} /* OVERLAY_layout */
+
+
+static void OVERLAY_closeArchive(void *opaque)
+{
+    OverlayInfo *info = (OverlayInfo *) opaque;
+    size_t i;
+    for (i = 0; i < info->numLayers; i++)
+        info->funcs[i]->closeArchive(info->opaques[i]);
+    overlayFreeInfo(info);
+} /* OVERLAY_closeArchive */
+
+
+const PHYSFS_Archiver __PHYSFS_Archiver_OVERLAY =
+{
+    CURRENT_PHYSFS_ARCHIVER_API_VERSION,
+    {
+        "",
+        "Overlay of patch archives over a base archive",
+        "agent <agent@local>",
+        "https://icculus.org/physfs/",
+        0,  /* supportsSymlinks */
+    },
+    OVERLAY_openArchive,
+    OVERLAY_enumerateFiles,
+    OVERLAY_openRead,
+    OVERLAY_openWrite,
+    OVERLAY_openAppend,
+    OVERLAY_remove,
+    OVERLAY_mkdir,
+    OVERLAY_stat,
+    OVERLAY_closeArchive,
+    OVERLAY_enumerateFilesStat,
+    NULL,  /* claim */
+    NULL,  /* enumerateFilesPrefix */
+    OVERLAY_checksum,
+    OVERLAY_layout
+};
+
+/* end of archiver_overlay.c ... */
@@ -0,0 +1,1140 @@
+/*
+ * PPK support routines for PhysicsFS.
+ *
+ * PPK ("PhysicsFS pack") is PhysicsFS's own archive format, laid out so
+ *  mounting one costs the same no matter how many files it holds: the index
+ *  is stored exactly as it's searched, so opening an archive just maps (or
+ *  reads, in one go) the index, and nothing is parsed, sorted or hashed.
+ *  extras/physfspack.c makes them.
+ *
+ * Everything is little endian. The file starts with a 32-byte header:
+ *
+ *    0  "PPK\x1A"
+ *    4  uint32 version, 1 or 2.
+ *    8  uint32 number of entries; entry 0 is the root directory.
+ *   12  uint32 number of hash buckets, a power of two, at least 2.
+ *   16  uint32 bytes of names.
+ *   20  uint32 file data alignment, a power of two.
+ *   24  uint32 flags; 1 means there are content hashes.
+ *   28  uint32 bytes of zstd dictionary. Version 1 has none; this is zero.
+ *
+ * Then the buckets, a uint32 each: the index + 1 of the first entry whose
+ *  path hashes there, or zero. The hash is 32-bit FNV-1a of the path's
+ *  bytes, and its low bits pick the bucket.
+ *
+ * Then the entries, 48 bytes each:
+ *
+ *    0  uint64 file: offset of its data. dir: index of its first child.
+ *    8  uint64 file: uncompressed size. dir: number of children.
+ *   16  uint64 file: stored size. dir: zero.
+ *   24  sint64 modification time, in seconds since the epoch, or -1.
+ *   32  uint32 offset of its path in the names.
+ *   36  uint32 length of its path, in bytes.
+ *   40  uint32 index + 1 of the next entry in its bucket, or zero.
+ *   44  uint16 flags; 1 means it's a directory.
+ *   46  uint16 compression: 0 stored, 1 LZ4 frame, 2 zstd frame, 3 zstd
+ *       frame made with the archive's dictionary.
+ *
+ * Then the names: each entry's full path, in platform-independent notation,
+ *  null-terminated. The root's is "". A directory's children are a span of
+ *  consecutive entries, sorted by name, so listing one is a walk down that
+ *  span that hands back names straight from the index.
+ *
+ * Then, if the header says so, each entry's content hash: 16 bytes of
+ *  __PHYSFS_hashContent() of its uncompressed data (zeros for directories).
+ *  Files with the same contents are stored once, every entry pointing at
+ *  the same data, and compressed ones are decompressed into the blob cache
+ *  that all mounted archives share, keyed by that hash, so one that's in
+ *  several archives is decompressed and kept once.
+ *
+ * Then the zstd dictionary, if there is one. Packs of lots of small files
+ *  (configs, shader snippets) compress poorly one at a time, because each
+ *  starts from nothing; one dictionary trained on all of them gives every
+ *  entry a head start. It's digested once, when the archive's mounted, and
+ *  closed files' decoders are kept for the next file to use, so opening a
+ *  small file doesn't cost a decoder's setup either.
+ *
+ * Each file's data starts at a multiple of the alignment after the index
+ *  (usually 4096, a page), so stored files can be mapped in place.
+ *
+ * Since none of that is checked when it's mounted, every entry is checked
+ *  against the index's bounds when it's looked at instead.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#define __PHYSICSFS_INTERNAL__
+#include "physfs_internal.h"
+
+#if PHYSFS_SUPPORTS_PPK
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+#include <zstd.h>
+#endif
+
+#if PHYSFS_SUPPORTS_PPK_LZ4
+#include <lz4frame.h>
+#endif
+
+#define PPK_HEADER_LEN 32
+#define PPK_ENTRY_LEN 48
+#define PPK_HASH_LEN __PHYSFS_CONTENT_HASH_LEN
+#define PPK_VERSION 2
+
+#define PPK_FLAG_DIR 1
+
+#define PPK_HEADER_HASHES 1
+
+#define PPK_COMP_NONE 0
+#define PPK_COMP_LZ4 1
+#define PPK_COMP_ZSTD 2
+#define PPK_COMP_ZSTD_DICT 3
+
+/* most closed files' zstd decoders kept per archive, for the next ones. */
+#define PPK_SPARE_DECODERS 8
+
+/* compressed data read at once, for files that aren't mapped. */
+#define PPK_READBUFSIZE (64 * 1024)
+
+typedef struct
+{
+    PHYSFS_Io *io;
+    const PHYSFS_uint8 *mapped;    /* the whole archive, or NULL.          */
+    PHYSFS_uint8 *owned;           /* the index, if it wasn't mapped.      */
+    const PHYSFS_uint8 *buckets;
+    const PHYSFS_uint8 *entries;
+    const char *names;
+    const PHYSFS_uint8 *hashes;    /* content hashes, or NULL.             */
+    PHYSFS_uint32 entryCount;
+    PHYSFS_uint32 bucketMask;
+    PHYSFS_uint32 namesLen;
+    PHYSFS_uint64 archiveLen;
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    ZSTD_DDict *ddict;             /* the dictionary, or NULL.             */
+    ZSTD_DCtx *spares[PPK_SPARE_DECODERS];  /* closed files' decoders.     */
+    PHYSFS_uint32 spareCount;      /* number of things in spares.          */
+    void *spareMutex;              /* serializes spares.                   */
+#endif
+} PPKinfo;
+
+typedef struct
+{
+    PHYSFS_uint64 offset;
+    PHYSFS_uint64 size;
+    PHYSFS_uint64 csize;
+    PHYSFS_sint64 modtime;
+    const char *name;              /* points into the index's names.       */
+    const PHYSFS_uint8 *hash;      /* points into the index too, or NULL.  */
+    PHYSFS_uint32 nameLen;
+    PHYSFS_uint32 next;
+    PHYSFS_uint16 flags;
+    PHYSFS_uint16 compression;
+} PPKentry;
+
+typedef struct
+{
+    PPKinfo *info;                 /* the archive it's in.                 */
+    PHYSFS_Io *io;                 /* the archive's own; shared.           */
+    const PHYSFS_uint8 *mapped;    /* the entry's stored data, or NULL.    */
+    PPKentry entry;
+    PHYSFS_uint64 curPos;          /* uncompressed.                        */
+    PHYSFS_uint64 compPos;         /* stored bytes handed to the decoder.  */
+    PHYSFS_uint8 *buffer;          /* stored data, if it isn't mapped.     */
+    const PHYSFS_uint8 *in;        /* next stored byte to decode.          */
+    size_t inLen;                  /* bytes at (in).                       */
+    void *decoder;                 /* zstd/LZ4 state, or NULL.             */
+} PPKfileinfo;
+
+
+static PHYSFS_uint16 ppkRead16(const PHYSFS_uint8 *ptr)
+{
+    PHYSFS_uint16 val;
+    memcpy(&val, ptr, sizeof (val));
+    return PHYSFS_swapULE16(val);
+} /* ppkRead16 */
+
+
+static PHYSFS_uint32 ppkRead32(const PHYSFS_uint8 *ptr)
+{
+    PHYSFS_uint32 val;
+    memcpy(&val, ptr, sizeof (val));
+    return PHYSFS_swapULE32(val);
+} /* ppkRead32 */
+
+
+static PHYSFS_uint64 ppkRead64(const PHYSFS_uint8 *ptr)
+{
+    PHYSFS_uint64 val;
+    memcpy(&val, ptr, sizeof (val));
+    return PHYSFS_swapULE64(val);
+} /* ppkRead64 */
+
+
+/* 32-bit FNV-1a; extras/physfspack.c has to agree with this. */
+static PHYSFS_uint32 ppkHash(const char *name, size_t len)
+{
+    PHYSFS_uint32 hash = 0x811C9DC5;
+    while (len--)
+    {
+        hash ^= (PHYSFS_uint32) (PHYSFS_uint8) *(name++);
+        hash *= 0x01000193;
+    } /* while */
+    return hash;
+} /* ppkHash */
+
+
+static int ppkCompressionSupported(const PHYSFS_uint16 compression)
+{
+    switch (compression)
+    {
+        case PPK_COMP_NONE: return 1;
+#if PHYSFS_SUPPORTS_PPK_LZ4
+        case PPK_COMP_LZ4: return 1;
+#endif
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+        case PPK_COMP_ZSTD: return 1;
+        case PPK_COMP_ZSTD_DICT: return 1;
+#endif
+        default: return 0;
+    } /* switch */
+} /* ppkCompressionSupported */
+
+
+/* Decode entry (idx) into (entry), checking it against the index's bounds. */
+static int ppkGetEntry(const PPKinfo *info, const PHYSFS_uint32 idx,
+                       PPKentry *entry)
+{
+    const PHYSFS_uint8 *rec;
+    PHYSFS_uint32 nameOffset;
+
+    BAIL_IF_MACRO(idx >= info->entryCount, PHYSFS_ERR_CORRUPT, 0);
+    rec = info->entries + (((size_t) idx) * PPK_ENTRY_LEN);
+
+    entry->offset = ppkRead64(rec);
+    entry->size = ppkRead64(rec + 8);
+    entry->csize = ppkRead64(rec + 16);
+    entry->modtime = (PHYSFS_sint64) ppkRead64(rec + 24);
+    nameOffset = ppkRead32(rec + 32);
+    entry->nameLen = ppkRead32(rec + 36);
+    entry->next = ppkRead32(rec + 40);
+    entry->flags = ppkRead16(rec + 44);
+    entry->compression = ppkRead16(rec + 46);
+
+    BAIL_IF_MACRO(nameOffset >= info->namesLen, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(entry->nameLen >= info->namesLen - nameOffset,
+                  PHYSFS_ERR_CORRUPT, 0);
+    entry->name = info->names + nameOffset;
+    entry->hash = NULL;
+    if (info->hashes != NULL)
+        entry->hash = info->hashes + (((size_t) idx) * PPK_HASH_LEN);
+    BAIL_IF_MACRO(entry->name[entry->nameLen] != '\0', PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(entry->next > info->entryCount, PHYSFS_ERR_CORRUPT, 0);
+
+    if (entry->flags & PPK_FLAG_DIR)
+    {
+        BAIL_IF_MACRO(entry->offset > info->entryCount, PHYSFS_ERR_CORRUPT, 0);
+        BAIL_IF_MACRO(entry->size > info->entryCount - entry->offset,
+                      PHYSFS_ERR_CORRUPT, 0);
+    } /* if */
+    else
+    {
+        BAIL_IF_MACRO(entry->offset > info->archiveLen, PHYSFS_ERR_CORRUPT, 0);
+        BAIL_IF_MACRO(entry->csize > info->archiveLen - entry->offset,
+                      PHYSFS_ERR_CORRUPT, 0);
+        BAIL_IF_MACRO((entry->compression == PPK_COMP_NONE) &&
+                      (entry->csize != entry->size), PHYSFS_ERR_CORRUPT, 0);
+    } /* else */
+
+    return 1;
+} /* ppkGetEntry */
+
+
+/* Find (path), in platform-independent notation, and decode it to (entry). */
+static int ppkFind(const PPKinfo *info, const char *path, PPKentry *entry)
+{
+    const size_t len = strlen(path);
+    PHYSFS_uint32 steps = 0;
+    PHYSFS_uint32 i;
+
+    if (*path == '\0')  /* root dir? */
+        return ppkGetEntry(info, 0, entry);
+
+    i = ppkHash(path, len) & info->bucketMask;
+    i = ppkRead32(info->buckets + (((size_t) i) * 4));
+    while (i != 0)
+    {
+        BAIL_IF_MACRO(steps++ >= info->entryCount, PHYSFS_ERR_CORRUPT, 0);
+        BAIL_IF_MACRO(!ppkGetEntry(info, i - 1, entry), ERRPASS, 0);
+        if ((entry->nameLen == len) && (memcmp(entry->name, path, len) == 0))
+            return 1;
+        i = entry->next;
+    } /* while */
+
+    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, 0);
+} /* ppkFind */
+
+
+static PHYSFS_sint64 PPK_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
+} /* PPK_write */
+
+
+static PHYSFS_sint64 PPK_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((PPKfileinfo *) io->opaque)->curPos;
+} /* PPK_tell */
+
+
+static PHYSFS_sint64 PPK_length(PHYSFS_Io *io)
+{
+    const PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    return (PHYSFS_sint64) finfo->entry.size;
+} /* PPK_length */
+
+
+static int PPK_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
+
+
+static PHYSFS_sint64 PPK_readAt(PHYSFS_Io *io, void *buffer,
+                                PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    const PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    const PPKentry *entry = &finfo->entry;
+
+    if (offset >= entry->size)
+        return 0;
+
+    if (len > entry->size - offset)
+        len = entry->size - offset;
+
+    return __PHYSFS_ioReadAt(finfo->io, buffer, len, entry->offset + offset);
+} /* PPK_readAt */
+
+
+static PHYSFS_sint64 PPK_read(PHYSFS_Io *io, void *buffer, PHYSFS_uint64 len)
+{
+    PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    const PHYSFS_sint64 rc = PPK_readAt(io, buffer, len, finfo->curPos);
+    if (rc > 0)
+        finfo->curPos += (PHYSFS_uint64) rc;
+    return rc;
+} /* PPK_read */
+
+
+static int PPK_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    BAIL_IF_MACRO(offset > finfo->entry.size, PHYSFS_ERR_PAST_EOF, 0);
+    finfo->curPos = offset;  /* reads say where they want to be. */
+    return 1;
+} /* PPK_seek */
+
+
+static int PPK_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    const PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    BAIL_IF_MACRO(!finfo->mapped, PHYSFS_ERR_UNSUPPORTED, 0);
+    *ptr = finfo->mapped;
+    *len = finfo->entry.size;
+    return 1;
+} /* PPK_map */
+
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD || PHYSFS_SUPPORTS_PPK_LZ4
+/* Point (finfo)'s input at more stored data. Running out is corruption. */
+static int ppkRefill(PPKfileinfo *finfo)
+{
+    const PHYSFS_uint64 remain = finfo->entry.csize - finfo->compPos;
+    PHYSFS_uint64 len = remain;
+
+    if (finfo->inLen > 0)
+        return 1;
+
+    BAIL_IF_MACRO(remain == 0, PHYSFS_ERR_CORRUPT, 0);  /* truncated. */
+
+    if (finfo->mapped != NULL)
+    {
+        if (len > 0x40000000)  /* keep it a size_t on 32-bit systems. */
+            len = 0x40000000;
+        finfo->in = finfo->mapped + finfo->compPos;
+    } /* if */
+    else
+    {
+        PHYSFS_sint64 rc;
+        if (len > PPK_READBUFSIZE)
+            len = PPK_READBUFSIZE;
+        rc = __PHYSFS_ioReadAt(finfo->io, finfo->buffer, len,
+                               finfo->entry.offset + finfo->compPos);
+        BAIL_IF_MACRO(rc < 0, ERRPASS, 0);
+        BAIL_IF_MACRO(rc == 0, PHYSFS_ERR_CORRUPT, 0);
+        len = (PHYSFS_uint64) rc;
+        finfo->in = finfo->buffer;
+    } /* else */
+
+    finfo->compPos += len;
+    finfo->inLen = (size_t) len;
+    return 1;
+} /* ppkRefill */
+#endif
+
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+static int ppkIsZstd(const PPKentry *entry)
+{
+    return ((entry->compression == PPK_COMP_ZSTD) ||
+            (entry->compression == PPK_COMP_ZSTD_DICT));
+} /* ppkIsZstd */
+
+
+/*
+ * Get a zstd decoder for (entry): a spare from (info) if there is one,
+ *  otherwise a new one, using the archive's dictionary if (entry) does.
+ */
+static ZSTD_DCtx *ppkTakeZstd(PPKinfo *info, const PPKentry *entry)
+{
+    const int usesDict = (entry->compression == PPK_COMP_ZSTD_DICT);
+    ZSTD_DCtx *dctx = NULL;
+    size_t rc;
+
+    __PHYSFS_platformGrabMutex(info->spareMutex);
+    if (info->spareCount > 0)
+        dctx = info->spares[--info->spareCount];
+    __PHYSFS_platformReleaseMutex(info->spareMutex);
+
+    if (dctx == NULL)
+    {
+        dctx = ZSTD_createDCtx();
+        BAIL_IF_MACRO(!dctx, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    /* referencing a digested dictionary is free; NULL means none. */
+    rc = ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+    if (!ZSTD_isError(rc))
+        rc = ZSTD_DCtx_refDDict(dctx, usesDict ? info->ddict : NULL);
+    if (ZSTD_isError(rc))
+    {
+        ZSTD_freeDCtx(dctx);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    return dctx;
+} /* ppkTakeZstd */
+
+
+/* Keep (dctx) for (info)'s next file, or free it. */
+static void ppkGiveZstd(PPKinfo *info, ZSTD_DCtx *dctx)
+{
+    /* spares are only worth it while there's room for decoders. */
+    if (!__PHYSFS_memExcess(PHYSFS_MEMORY_DECODERS))
+    {
+        __PHYSFS_platformGrabMutex(info->spareMutex);
+        if (info->spareCount < PPK_SPARE_DECODERS)
+        {
+            info->spares[info->spareCount++] = dctx;
+            dctx = NULL;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(info->spareMutex);
+    } /* if */
+
+    if (dctx != NULL)
+        ZSTD_freeDCtx(dctx);
+} /* ppkGiveZstd */
+
+
+static PHYSFS_sint64 ppkReadZstd(PPKfileinfo *finfo, void *buf,
+                                 PHYSFS_uint64 len)
+{
+    ZSTD_DCtx *dctx = (ZSTD_DCtx *) finfo->decoder;
+    ZSTD_outBuffer out;
+
+    out.dst = buf;
+    out.size = (size_t) len;
+    out.pos = 0;
+
+    while (out.pos < out.size)
+    {
+        const size_t before = out.pos;
+        ZSTD_inBuffer in;
+        size_t rc;
+
+        if (!ppkRefill(finfo))
+            break;
+
+        in.src = finfo->in;
+        in.size = finfo->inLen;
+        in.pos = 0;
+        rc = ZSTD_decompressStream(dctx, &out, &in);
+        finfo->in += in.pos;
+        finfo->inLen -= in.pos;
+
+        if (ZSTD_isError(rc))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            break;
+        } /* if */
+
+        else if ((in.pos == 0) && (out.pos == before))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* stuck. */
+            break;
+        } /* else if */
+    } /* while */
+
+    return ((out.pos == 0) ? -1 : (PHYSFS_sint64) out.pos);
+} /* ppkReadZstd */
+#endif
+
+
+#if PHYSFS_SUPPORTS_PPK_LZ4
+static PHYSFS_sint64 ppkReadLz4(PPKfileinfo *finfo, void *buf,
+                                PHYSFS_uint64 len)
+{
+    LZ4F_dctx *dctx = (LZ4F_dctx *) finfo->decoder;
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+    PHYSFS_uint64 retval = 0;
+
+    while (retval < len)
+    {
+        size_t outlen = (size_t) (len - retval);
+        size_t inlen;
+        size_t rc;
+
+        if (!ppkRefill(finfo))
+            break;
+
+        inlen = finfo->inLen;
+        rc = LZ4F_decompress(dctx, ptr + retval, &outlen,
+                             finfo->in, &inlen, NULL);
+        finfo->in += inlen;
+        finfo->inLen -= inlen;
+        retval += outlen;
+
+        if (LZ4F_isError(rc))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            break;
+        } /* if */
+
+        else if ((inlen == 0) && (outlen == 0))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* stuck. */
+            break;
+        } /* else if */
+    } /* while */
+
+    return ((retval == 0) ? -1 : (PHYSFS_sint64) retval);
+} /* ppkReadLz4 */
+#endif
+
+
+static PHYSFS_sint64 PPK_readCompressed(PHYSFS_Io *io, void *buf,
+                                        PHYSFS_uint64 len)
+{
+    PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    const PHYSFS_uint64 avail = finfo->entry.size - finfo->curPos;
+    PHYSFS_sint64 rc = -1;
+
+    if (len > avail)
+        len = avail;
+
+    if (len == 0)
+        return 0;
+
+    BAIL_IF_MACRO(len != (size_t) len, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    if (ppkIsZstd(&finfo->entry))
+        rc = ppkReadZstd(finfo, buf, len);
+#endif
+#if PHYSFS_SUPPORTS_PPK_LZ4
+    if (finfo->entry.compression == PPK_COMP_LZ4)
+        rc = ppkReadLz4(finfo, buf, len);
+#endif
+
+    if (rc > 0)
+        finfo->curPos += (PHYSFS_uint64) rc;
+    return rc;
+} /* PPK_readCompressed */
+
+
+/* Start (finfo)'s decoder over from the top, without reallocating it. */
+static void ppkRewind(PPKfileinfo *finfo)
+{
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    /* keeps the dictionary; ZSTD_initDStream() would drop it. */
+    if (ppkIsZstd(&finfo->entry))
+        ZSTD_DCtx_reset((ZSTD_DCtx *) finfo->decoder, ZSTD_reset_session_only);
+#endif
+#if PHYSFS_SUPPORTS_PPK_LZ4
+    if (finfo->entry.compression == PPK_COMP_LZ4)
+        LZ4F_resetDecompressionContext((LZ4F_dctx *) finfo->decoder);
+#endif
+    finfo->curPos = 0;
+    finfo->compPos = 0;
+    finfo->in = NULL;
+    finfo->inLen = 0;
+} /* ppkRewind */
+
+
+static int PPK_seekCompressed(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+
+    BAIL_IF_MACRO(offset > finfo->entry.size, PHYSFS_ERR_PAST_EOF, 0);
+
+    /* frames only decode forward; going back means starting over. */
+    if (offset < finfo->curPos)
+        ppkRewind(finfo);
+
+    while (finfo->curPos < offset)
+    {
+        PHYSFS_uint8 buf[4096];
+        PHYSFS_uint64 maxread = offset - finfo->curPos;
+        if (maxread > sizeof (buf))
+            maxread = sizeof (buf);
+        if (PPK_readCompressed(io, buf, maxread) != (PHYSFS_sint64) maxread)
+            return 0;
+    } /* while */
+
+    return 1;
+} /* PPK_seekCompressed */
+
+
+static void ppkFreeFileInfo(PPKfileinfo *finfo)
+{
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    if ((finfo->decoder) && (ppkIsZstd(&finfo->entry)))
+        ppkGiveZstd(finfo->info, (ZSTD_DCtx *) finfo->decoder);
+#endif
+#if PHYSFS_SUPPORTS_PPK_LZ4
+    if ((finfo->decoder) && (finfo->entry.compression == PPK_COMP_LZ4))
+        LZ4F_freeDecompressionContext((LZ4F_dctx *) finfo->decoder);
+#endif
+
+    allocator.Free(finfo->buffer);
+    __PHYSFS_poolFree(finfo, sizeof (PPKfileinfo));
+} /* ppkFreeFileInfo */
+
+
+static void PPK_destroy(PHYSFS_Io *io)
+{
+    ppkFreeFileInfo((PPKfileinfo *) io->opaque);
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
+} /* PPK_destroy */
+
+
+static PHYSFS_Io *ppkCreateIo(PPKinfo *info, const PHYSFS_uint8 *mapped,
+                              const PPKentry *entry);
+
+/* What (entry)'s stored data is, as a PHYSFS_Encoding. */
+static int ppkEncoding(const PPKentry *entry)
+{
+    switch (entry->compression)
+    {
+        case PPK_COMP_LZ4: return (int) PHYSFS_ENCODING_LZ4;
+        case PPK_COMP_ZSTD: return (int) PHYSFS_ENCODING_ZSTD;
+        default: return (int) PHYSFS_ENCODING_IDENTITY;
+    } /* switch */
+} /* ppkEncoding */
+
+
+static PHYSFS_Io *PPK_raw(PHYSFS_Io *io, int *encoding)
+{
+    const PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    PHYSFS_Io *archio;
+    PHYSFS_Io *retval;
+
+    /* nobody else has our dictionary. */
+    BAIL_IF_MACRO(finfo->entry.compression == PPK_COMP_ZSTD_DICT,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    archio = finfo->io->duplicate(finfo->io);
+    BAIL_IF_MACRO(!archio, ERRPASS, NULL);
+    retval = __PHYSFS_createSliceIo(archio, finfo->entry.offset,
+                                    finfo->entry.csize);
+    if (retval == NULL)
+    {
+        archio->destroy(archio);
+        return NULL;
+    } /* if */
+
+    *encoding = ppkEncoding(&finfo->entry);
+    return retval;
+} /* PPK_raw */
+
+
+static PHYSFS_Io *PPK_duplicate(PHYSFS_Io *io)
+{
+    const PPKfileinfo *finfo = (PPKfileinfo *) io->opaque;
+    return ppkCreateIo(finfo->info, finfo->mapped, &finfo->entry);
+} /* PPK_duplicate */
+
+
+static const PHYSFS_Io PPK_Io =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    PPK_read,
+    PPK_write,
+    PPK_seek,
+    PPK_tell,
+    PPK_length,
+    PPK_duplicate,
+    PPK_flush,
+    PPK_destroy,
+    PPK_map,
+    PPK_readAt
+};
+
+/* no map() or readAt() for these; there's nowhere to point or jump to. */
+static const PHYSFS_Io PPK_CompressedIo =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    PPK_readCompressed,
+    PPK_write,
+    PPK_seekCompressed,
+    PPK_tell,
+    PPK_length,
+    PPK_duplicate,
+    PPK_flush,
+    PPK_destroy,
+    NULL,
+    NULL,
+    NULL,  /* readv */
+    NULL,  /* advise */
+    NULL,  /* backing */
+    PPK_raw
+};
+
+
+/*
+ * Make an Io for (entry), in (info). (mapped) is the entry's stored data,
+ *  if the archive is in memory; otherwise it's read from the archive's Io,
+ *  which every file shares, so it's only read with __PHYSFS_ioReadAt().
+ */
+static PHYSFS_Io *ppkCreateIo(PPKinfo *info, const PHYSFS_uint8 *mapped,
+                              const PPKentry *entry)
+{
+    const int compressed = (entry->compression != PPK_COMP_NONE);
+    PHYSFS_Io *retval = NULL;
+    PPKfileinfo *finfo = NULL;
+
+    retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, ERRPASS, ppkCreateIo_failed);
+    finfo = (PPKfileinfo *) __PHYSFS_poolAlloc(sizeof (PPKfileinfo));
+    GOTO_IF_MACRO(!finfo, ERRPASS, ppkCreateIo_failed);
+
+    memset(finfo, '\0', sizeof (PPKfileinfo));
+    finfo->info = info;
+    finfo->io = info->io;
+    finfo->mapped = mapped;
+    memcpy(&finfo->entry, entry, sizeof (PPKentry));
+
+    if ((compressed) && (mapped == NULL))
+    {
+        finfo->buffer = (PHYSFS_uint8 *) allocator.Malloc(PPK_READBUFSIZE);
+        GOTO_IF_MACRO(!finfo->buffer, PHYSFS_ERR_OUT_OF_MEMORY,
+                      ppkCreateIo_failed);
+    } /* if */
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    if (ppkIsZstd(entry))
+    {
+        finfo->decoder = ppkTakeZstd(info, entry);
+        GOTO_IF_MACRO(!finfo->decoder, ERRPASS, ppkCreateIo_failed);
+    } /* if */
+#endif
+
+#if PHYSFS_SUPPORTS_PPK_LZ4
+    if (entry->compression == PPK_COMP_LZ4)
+    {
+        LZ4F_dctx *dctx = NULL;
+        const LZ4F_errorCode_t rc = LZ4F_createDecompressionContext(&dctx,
+                                                                 LZ4F_VERSION);
+        GOTO_IF_MACRO(LZ4F_isError(rc), PHYSFS_ERR_OUT_OF_MEMORY,
+                      ppkCreateIo_failed);
+        finfo->decoder = dctx;
+    } /* if */
+#endif
+
+    memcpy(retval, compressed ? &PPK_CompressedIo : &PPK_Io, sizeof (*retval));
+    retval->opaque = finfo;
+    return retval;
+
+ppkCreateIo_failed:
+    if (finfo != NULL)
+        ppkFreeFileInfo(finfo);
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
+    return NULL;
+} /* ppkCreateIo */
+
+
+static PHYSFS_Io *PPK_openRead(void *opaque, const char *name)
+{
+    PPKinfo *info = (PPKinfo *) opaque;
+    const int shared = (info->hashes != NULL);
+    PHYSFS_Io *retval = NULL;
+    PPKentry entry;
+
+    BAIL_IF_MACRO(!ppkFind(info, name, &entry), ERRPASS, NULL);
+    BAIL_IF_MACRO(entry.flags & PPK_FLAG_DIR, PHYSFS_ERR_NOT_A_FILE, NULL);
+    BAIL_IF_MACRO(!ppkCompressionSupported(entry.compression),
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+
+    /* stored files are as cheap as they get already. */
+    if ((shared) && (entry.compression != PPK_COMP_NONE))
+    {
+        retval = __PHYSFS_blobCacheLookup(entry.hash, entry.size);
+        if (retval != NULL)
+            return retval;
+    } /* if */
+
+    retval = ppkCreateIo(info,
+                         info->mapped ? info->mapped + entry.offset : NULL,
+                         &entry);
+    if ((retval != NULL) && (shared) && (entry.compression != PPK_COMP_NONE))
+        retval = __PHYSFS_blobCacheFill(entry.hash, retval);
+    return retval;
+} /* PPK_openRead */
+
+
+static void ppkFillStat(PHYSFS_Stat *stat, const PPKentry *entry)
+{
+    if (entry->flags & PPK_FLAG_DIR)
+    {
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        stat->filesize = 0;
+    } /* if */
+    else
+    {
+        stat->filetype = PHYSFS_FILETYPE_REGULAR;
+        stat->filesize = (PHYSFS_sint64) entry->size;
+    } /* else */
+
+    stat->modtime = entry->modtime;
+    stat->createtime = entry->modtime;
+    stat->accesstime = -1;
+    stat->readonly = 1;
+} /* ppkFillStat */
+
+
+static void PPK_enumerateFiles(void *opaque, const char *dname,
+                               PHYSFS_EnumFilesCallback cb,
+                               const char *origdir, void *callbackdata)
+{
+    const PPKinfo *info = (const PPKinfo *) opaque;
+    PPKentry dir;
+    PPKentry child;
+    PHYSFS_uint32 prefixlen;
+    PHYSFS_uint64 i;
+
+    if ((!ppkFind(info, dname, &dir)) || !(dir.flags & PPK_FLAG_DIR))
+        return;
+
+    /* children's paths start with ours, so their names are right there. */
+    prefixlen = dir.nameLen ? dir.nameLen + 1 : 0;
+    for (i = 0; i < dir.size; i++)
+    {
+        if (!ppkGetEntry(info, (PHYSFS_uint32) (dir.offset + i), &child))
+            break;
+        else if (child.nameLen > prefixlen)
+            cb(callbackdata, origdir, child.name + prefixlen);
+    } /* for */
+} /* PPK_enumerateFiles */
+
+
+static void PPK_enumerateFilesStat(void *opaque, const char *dname,
+                                   PHYSFS_EnumFilesStatCallback cb,
+                                   const char *origdir, void *callbackdata)
+{
+    const PPKinfo *info = (const PPKinfo *) opaque;
+    PPKentry dir;
+    PPKentry child;
+    PHYSFS_uint32 prefixlen;
+    PHYSFS_Stat stat;
+    PHYSFS_uint64 i;
+
+    if ((!ppkFind(info, dname, &dir)) || !(dir.flags & PPK_FLAG_DIR))
+        return;
+
+    prefixlen = dir.nameLen ? dir.nameLen + 1 : 0;
+    for (i = 0; i < dir.size; i++)
+    {
+        if (!ppkGetEntry(info, (PHYSFS_uint32) (dir.offset + i), &child))
+            break;
+        else if (child.nameLen > prefixlen)
+        {
+            ppkFillStat(&stat, &child);
+            cb(callbackdata, origdir, child.name + prefixlen, &stat);
+        } /* else if */
+    } /* for */
+} /* PPK_enumerateFilesStat */
+
+
+static int PPK_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
+{
+    PPKentry entry;
+    BAIL_IF_MACRO(!ppkFind((const PPKinfo *) opaque, filename, &entry),
+                  ERRPASS, 0);
+    ppkFillStat(stat, &entry);
+    return 1;
+} /* PPK_stat */
+
+
+static int PPK_layout(void *opaque, const char *filename,
+                      PHYSFS_EntryLayout *layout)
+{
+    PPKentry entry;
+    BAIL_IF_MACRO(!ppkFind((const PPKinfo *) opaque, filename, &entry),
+                  ERRPASS, 0);
+    BAIL_IF_MACRO(entry.flags & PPK_FLAG_DIR, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    layout->offset = entry.offset;
+    layout->storedSize = entry.csize;
+    layout->size = entry.size;
+    layout->method = entry.compression;
+    if (entry.compression == PPK_COMP_ZSTD_DICT)
+        layout->encoding = PHYSFS_ENCODING_OTHER;  /* needs our dictionary. */
+    else
+        layout->encoding = (PHYSFS_Encoding) ppkEncoding(&entry);
+    return 1;
+} /* PPK_layout */
+
+
+static PHYSFS_Io *PPK_openWrite(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* PPK_openWrite */
+
+
+static PHYSFS_Io *PPK_openAppend(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* PPK_openAppend */
+
+
+static int PPK_remove(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* PPK_remove */
+
+
+static int PPK_mkdir(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* PPK_mkdir */
+
+
+static void ppkFreeInfo(PPKinfo *info)
+{
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    while (info->spareCount > 0)
+        ZSTD_freeDCtx(info->spares[--info->spareCount]);
+    if (info->ddict)
+        ZSTD_freeDDict(info->ddict);
+    if (info->spareMutex)
+        __PHYSFS_platformDestroyMutex(info->spareMutex);
+#endif
+    allocator.Free(info->owned);
+    allocator.Free(info);
+} /* ppkFreeInfo */
+
+
+static void PPK_closeArchive(void *opaque)
+{
+    PPKinfo *info = (PPKinfo *) opaque;
+    info->io->destroy(info->io);
+    ppkFreeInfo(info);
+} /* PPK_closeArchive */
+
+
+static void *PPK_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
+{
+    PHYSFS_uint8 header[PPK_HEADER_LEN];
+    const PHYSFS_uint8 *index = NULL;
+    const void *mapped = NULL;
+    PHYSFS_uint64 mappedLen = 0;
+    PHYSFS_uint32 entryCount, buckets, namesLen, alignment, flags, dictLen;
+    PHYSFS_uint32 version;
+    PHYSFS_uint64 indexLen;
+    PHYSFS_sint64 len;
+    PPKinfo *info;
+    PPKentry root;
+
+    assert(io != NULL);  /* shouldn't ever happen. */
+
+    BAIL_IF_MACRO(forWriting, PHYSFS_ERR_READ_ONLY, NULL);
+    BAIL_IF_MACRO(!__PHYSFS_readAll(io, header, sizeof (header)),
+                  ERRPASS, NULL);
+    BAIL_IF_MACRO(memcmp(header, "PPK\x1A", 4) != 0,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    version = ppkRead32(header + 4);
+    BAIL_IF_MACRO((version < 1) || (version > PPK_VERSION),
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+
+    entryCount = ppkRead32(header + 8);
+    buckets = ppkRead32(header + 12);
+    namesLen = ppkRead32(header + 16);
+    alignment = ppkRead32(header + 20);
+    flags = ppkRead32(header + 24);
+    dictLen = (version >= 2) ? ppkRead32(header + 28) : 0;
+    BAIL_IF_MACRO(entryCount == 0, PHYSFS_ERR_CORRUPT, NULL);
+    BAIL_IF_MACRO(namesLen == 0, PHYSFS_ERR_CORRUPT, NULL);
+    BAIL_IF_MACRO((buckets < 2) || (buckets & (buckets - 1)),
+                  PHYSFS_ERR_CORRUPT, NULL);
+    BAIL_IF_MACRO((alignment == 0) || (alignment & (alignment - 1)),
+                  PHYSFS_ERR_CORRUPT, NULL);
+
+    indexLen = PPK_HEADER_LEN + (((PHYSFS_uint64) buckets) * 4) +
+               (((PHYSFS_uint64) entryCount) * PPK_ENTRY_LEN) + namesLen;
+    if (flags & PPK_HEADER_HASHES)
+        indexLen += ((PHYSFS_uint64) entryCount) * PPK_HASH_LEN;
+    indexLen += dictLen;
+
+    info = (PPKinfo *) allocator.Malloc(sizeof (PPKinfo));
+    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(info, '\0', sizeof (PPKinfo));
+
+    /* if the archive's in memory, the index is used right where it is. */
+    if (__PHYSFS_ioMap(io, &mapped, &mappedLen))
+    {
+        GOTO_IF_MACRO(indexLen > mappedLen, PHYSFS_ERR_CORRUPT, failed);
+        info->mapped = (const PHYSFS_uint8 *) mapped;
+        info->archiveLen = mappedLen;
+        index = info->mapped;
+    } /* if */
+    else
+    {
+        len = io->length(io);
+        GOTO_IF_MACRO(len < 0, ERRPASS, failed);
+        GOTO_IF_MACRO(indexLen > (PHYSFS_uint64) len, PHYSFS_ERR_CORRUPT,
+                      failed);
+        GOTO_IF_MACRO(indexLen != (size_t) indexLen,
+                      PHYSFS_ERR_OUT_OF_MEMORY, failed);
+        info->owned = (PHYSFS_uint8 *) allocator.Malloc((size_t) indexLen);
+        GOTO_IF_MACRO(!info->owned, PHYSFS_ERR_OUT_OF_MEMORY, failed);
+        GOTO_IF_MACRO(__PHYSFS_ioReadAt(io, info->owned, indexLen, 0) !=
+                      (PHYSFS_sint64) indexLen, PHYSFS_ERR_CORRUPT, failed);
+        info->archiveLen = (PHYSFS_uint64) len;
+        index = info->owned;
+    } /* else */
+
+    info->entryCount = entryCount;
+    info->bucketMask = buckets - 1;
+    info->namesLen = namesLen;
+    info->buckets = index + PPK_HEADER_LEN;
+    info->entries = info->buckets + (((size_t) buckets) * 4);
+    info->names = (const char *) (info->entries +
+                                  (((size_t) entryCount) * PPK_ENTRY_LEN));
+    if (flags & PPK_HEADER_HASHES)
+        info->hashes = ((const PHYSFS_uint8 *) info->names) + namesLen;
+
+    /* the names have to end somewhere, so nothing can run off the end. */
+    GOTO_IF_MACRO(info->names[namesLen - 1] != '\0', PHYSFS_ERR_CORRUPT,
+                  failed);
+    GOTO_IF_MACRO(!ppkGetEntry(info, 0, &root), ERRPASS, failed);
+    GOTO_IF_MACRO(!(root.flags & PPK_FLAG_DIR), PHYSFS_ERR_CORRUPT, failed);
+    GOTO_IF_MACRO(root.nameLen != 0, PHYSFS_ERR_CORRUPT, failed);
+
+#if PHYSFS_SUPPORTS_PPK_ZSTD
+    info->spareMutex = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!info->spareMutex, ERRPASS, failed);
+
+    /* digested once here, so files opened later only reference it. */
+    if (dictLen > 0)
+    {
+        info->ddict = ZSTD_createDDict(index + indexLen - dictLen, dictLen);
+        GOTO_IF_MACRO(!info->ddict, PHYSFS_ERR_CORRUPT, failed);
+    } /* if */
+#endif
+
+    info->io = io;
+    return info;
+
+failed:
+    ppkFreeInfo(info);
+    return NULL;
+} /* PPK_openArchive */
+
+
+int __PHYSFS_ppkGetRawSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len, int *encoding)
+{
+    const PPKfileinfo *finfo;
+
+    if (io->read != PPK_readCompressed)
+        return 0;  /* not ours, stored, or it's come from the cache. */
+
+    finfo = (const PPKfileinfo *) io->opaque;
+    if ((finfo->curPos != 0) || (finfo->compPos != 0))
+        return 0;
+    else if (finfo->entry.compression == PPK_COMP_ZSTD_DICT)
+        return 0;  /* nobody else has our dictionary. */
+
+    *archive = finfo->io;  /* every file in an archive shares it. */
+    *src = finfo->io;
+    *pos = finfo->entry.offset;
+    *len = finfo->entry.csize;
+    *encoding = ppkEncoding(&finfo->entry);
+    return 1;
+} /* __PHYSFS_ppkGetRawSpan */
+
+
+int __PHYSFS_ppkGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len)
+{
+    const PPKfileinfo *finfo;
+
+    if (io->read != PPK_read)
+        return 0;  /* not ours, compressed, or it's come from the cache. */
+
+    finfo = (const PPKfileinfo *) io->opaque;
+    if (finfo->mapped != NULL)
+        return 0;  /* nothing to gain. */
+
+    *archive = finfo->io;
+    *src = finfo->io;
+    *pos = finfo->entry.offset;
+    *len = finfo->entry.size;
+    return 1;
+} /* __PHYSFS_ppkGetStoredSpan */
+
+
+static int PPK_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 4) && (memcmp(head, "PPK\x1A", 4) == 0));
+} /* PPK_claim */
+
+
+const PHYSFS_Archiver __PHYSFS_Archiver_PPK =
+{
+    CURRENT_PHYSFS_ARCHIVER_API_VERSION,
+    {
+        "PPK",
+        "PhysicsFS indexed pack",
+        "agent <agent@local>",
+        "https://icculus.org/physfs/",
+        0,  /* supportsSymlinks */
+    },
+    PPK_openArchive,
+    PPK_enumerateFiles,
+    PPK_openRead,
+    PPK_openWrite,
+    PPK_openAppend,
+    PPK_remove,
+    PPK_mkdir,
+    PPK_stat,
+    PPK_closeArchive,
+    PPK_enumerateFilesStat,
+    PPK_claim,
+    NULL,  /* enumerateFilesPrefix */
+    NULL,  /* checksum */
+    PPK_layout
+};
+
+#endif  /* defined PHYSFS_SUPPORTS_PPK */
+
+/* end of archiver_ppk.c ... */
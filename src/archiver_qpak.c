@@ -40,23 +40,31 @@ static UNPKentry *qpakLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
 {
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 *table = NULL;
+    const PHYSFS_uint8 *rec = NULL;
+
+    table = (PHYSFS_uint8 *) UNPK_readTable(io, fileCount, 64);
+    BAIL_IF_MACRO(!table, ERRPASS, NULL);
 
     entries = (UNPKentry *) allocator.Malloc(sizeof (UNPKentry) * fileCount);
-    BAIL_IF_MACRO(entries == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
 
-    for (entry = entries; fileCount > 0; fileCount--, entry++)
+    for (entry = entries, rec = table; fileCount > 0; fileCount--, entry++)
     {
-        if (!__PHYSFS_readAll(io, &entry->name, 56)) goto failed;
-        if (!__PHYSFS_readAll(io, &entry->startPos, 4)) goto failed;
-        if (!__PHYSFS_readAll(io, &entry->size, 4)) goto failed;
+        memcpy(entry->name, rec, 56);
+        entry->name[56] = '\0';  /* in case the name fills the field. */
+        memcpy(&entry->startPos, rec + 56, 4);
+        memcpy(&entry->size, rec + 60, 4);
         entry->size = PHYSFS_swapULE32(entry->size);
         entry->startPos = PHYSFS_swapULE32(entry->startPos);
+        rec += 64;
     } /* for */
 
+    allocator.Free(table);
     return entries;
 
 failed:
-    allocator.Free(entries);
+    allocator.Free(table);
     return NULL;
 } /* qpakLoadEntries */
 
@@ -94,6 +102,14 @@ static void *QPAK_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* QPAK_openArchive */
 
 
+static int QPAK_claim(const void *head, PHYSFS_uint64 headLen,
+                      const void *tail, PHYSFS_uint64 tailLen,
+                      PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 4) && (memcmp(head, "PACK", 4) == 0));
+} /* QPAK_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_QPAK =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -112,7 +128,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_QPAK =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    QPAK_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_QPAK */
@@ -0,0 +1,1104 @@
+/*
+ * RAM directory support routines for PhysicsFS.
+ *
+ * A RAM directory is a writable tree that lives in memory, made by
+ *  PHYSFS_createRamDir() and found by name when it's mounted or made the
+ *  write dir, so scratch data never touches the disk. Every mount of it,
+ *  and the write dir, see the same tree.
+ *
+ * Paths are found with one probe of a hash table of every node; each
+ *  directory also links its children, for enumerating. A file's contents
+ *  sit in chunks that double in size as it grows (a big write gets a chunk
+ *  big enough for all of it), so nothing already written is ever moved and
+ *  readers can be handed pointers straight into it.
+ *
+ * A reader sees the file as it was when it was opened. Appending doesn't
+ *  bother readers, since they don't look past the length they started
+ *  with, but writing over bytes a reader might see copies the file first,
+ *  and the writer (and the tree) carry on with the copy.
+ *
+ * Past the RAM directory's spill limit, a file that needs more room is
+ *  moved to a temporary file in its spill directory, and carries on there;
+ *  without a spill directory, the write fails with PHYSFS_ERR_NO_SPACE.
+ *  Spilled files are deleted when the last thing using them lets go.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#define __PHYSICSFS_INTERNAL__
+#include "physfs_internal.h"
+
+#include <time.h>
+
+#define RAM_CHUNK_MIN (4 * 1024)
+#define RAM_CHUNK_MAX (1024 * 1024)
+#define RAM_COPY_BUFFER (64 * 1024)
+
+typedef struct
+{
+    PHYSFS_uint8 *buf;
+    PHYSFS_uint64 start;    /* offset of buf[0] in the file.               */
+    PHYSFS_uint64 size;
+} RamChunk;
+
+/* A file's contents. Everything in here is guarded by the RamFs's lock. */
+typedef struct
+{
+    int refcount;           /* the node, plus every reader and writer.     */
+    int readers;
+    RamChunk *chunks;
+    size_t numChunks;
+    size_t allocChunks;
+    PHYSFS_uint64 len;
+    PHYSFS_uint64 capacity; /* bytes in (chunks).                          */
+    char *spillPath;        /* non-NULL if it lives on disk instead.       */
+    PHYSFS_Io *spillWrite;
+    PHYSFS_Io *spillRead;   /* opened the first time someone reads it.     */
+} RamData;
+
+typedef struct RamNode
+{
+    const char *path;       /* full path in the tree; "" for the root.     */
+    PHYSFS_uint32 hash;
+    int isDir;
+    int refcount;           /* one for being in the tree, one per writer.  */
+    struct RamNode *parent; /* NULL once it's removed.                     */
+    struct RamNode *children;
+    struct RamNode *sibling;
+    struct RamNode *hashNext;
+    RamData *data;          /* NULL for directories.                       */
+    PHYSFS_sint64 modtime;
+    PHYSFS_sint64 createtime;
+} RamNode;
+
+typedef struct
+{
+    void *lock;
+    volatile int refcount;  /* only touch with __PHYSFS_ATOMIC_*.          */
+    RamNode **buckets;
+    size_t numBuckets;      /* always a power of two.                      */
+    size_t numNodes;
+    PHYSFS_uint64 bytes;    /* in chunks, counting toward (spillLimit).    */
+    PHYSFS_uint64 spillLimit;
+    char *spillDir;
+    PHYSFS_uint32 spillSerial;
+} RamFs;
+
+typedef struct
+{
+    RamFs *fs;
+    RamNode *node;          /* NULL for readers.                           */
+    RamData *data;
+    PHYSFS_uint64 len;      /* what readers see; writers use data->len.    */
+    PHYSFS_uint64 pos;
+} RamFile;
+
+
+static PHYSFS_uint32 ramHash(const char *path)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (*path)
+        hash = ((hash << 5) + hash) ^ ((PHYSFS_uint32) (PHYSFS_uint8) *path++);
+    return hash;
+} /* ramHash */
+
+
+static RamNode *ramFind(const RamFs *fs, const char *path)
+{
+    const PHYSFS_uint32 hash = ramHash(path);
+    RamNode *node;
+
+    for (node = fs->buckets[hash & (fs->numBuckets - 1)]; node != NULL;
+         node = node->hashNext)
+    {
+        if ((node->hash == hash) && (strcmp(node->path, path) == 0))
+            return node;
+    } /* for */
+
+    return NULL;
+} /* ramFind */
+
+
+static int ramGrowBuckets(RamFs *fs)
+{
+    const size_t count = fs->numBuckets * 2;
+    RamNode **buckets;
+    size_t i;
+
+    buckets = (RamNode **) allocator.Malloc(sizeof (RamNode *) * count);
+    BAIL_IF_MACRO(!buckets, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(buckets, '\0', sizeof (RamNode *) * count);
+
+    for (i = 0; i < fs->numBuckets; i++)
+    {
+        RamNode *node = fs->buckets[i];
+        while (node != NULL)
+        {
+            RamNode *next = node->hashNext;
+            RamNode **bucket = &buckets[node->hash & (count - 1)];
+            node->hashNext = *bucket;
+            *bucket = node;
+            node = next;
+        } /* while */
+    } /* for */
+
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX, (PHYSFS_sint64)
+                       (sizeof (RamNode *) * (count - fs->numBuckets)));
+    allocator.Free(fs->buckets);
+    fs->buckets = buckets;
+    fs->numBuckets = count;
+    return 1;
+} /* ramGrowBuckets */
+
+
+static RamData *ramCreateData(void)
+{
+    RamData *data = (RamData *) allocator.Malloc(sizeof (RamData));
+    BAIL_IF_MACRO(!data, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(data, '\0', sizeof (RamData));
+    data->refcount = 1;
+    return data;
+} /* ramCreateData */
+
+
+static void ramReleaseData(RamFs *fs, RamData *data)
+{
+    size_t i;
+
+    if ((data == NULL) || (--data->refcount > 0))
+        return;
+
+    for (i = 0; i < data->numChunks; i++)
+        allocator.Free(data->chunks[i].buf);
+    allocator.Free(data->chunks);
+    fs->bytes -= data->capacity;
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_BUFFERS,
+                       -((PHYSFS_sint64) data->capacity));
+
+    if (data->spillRead != NULL)
+        data->spillRead->destroy(data->spillRead);
+    if (data->spillWrite != NULL)
+        data->spillWrite->destroy(data->spillWrite);
+    if (data->spillPath != NULL)
+    {
+        __PHYSFS_platformDelete(data->spillPath);
+        allocator.Free(data->spillPath);
+    } /* if */
+
+    allocator.Free(data);
+} /* ramReleaseData */
+
+
+/* How much bigger (data) gets if it has to hold (end) bytes. */
+static PHYSFS_uint64 ramGrowth(const RamData *data, PHYSFS_uint64 end)
+{
+    PHYSFS_uint64 capacity = data->capacity;
+    PHYSFS_uint64 size;
+
+    if ((data->spillPath != NULL) || (end <= capacity))
+        return 0;
+
+    /* chunks double in size, but one write never needs more than one. */
+    size = capacity;
+    if (size < RAM_CHUNK_MIN)
+        size = RAM_CHUNK_MIN;
+    else if (size > RAM_CHUNK_MAX)
+        size = RAM_CHUNK_MAX;
+    if (end - capacity > size)
+    {
+        size = end - capacity + RAM_CHUNK_MIN - 1;
+        size -= size % RAM_CHUNK_MIN;
+    } /* if */
+    return size;
+} /* ramGrowth */
+
+
+static int ramGrow(RamFs *fs, RamData *data, PHYSFS_uint64 end)
+{
+    const PHYSFS_uint64 size = ramGrowth(data, end);
+    RamChunk *chunk;
+
+    if (size == 0)
+        return 1;
+
+    BAIL_IF_MACRO(size != (size_t) size, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (data->numChunks == data->allocChunks)
+    {
+        const size_t count = data->allocChunks ? data->allocChunks * 2 : 4;
+        void *ptr = allocator.Realloc(data->chunks, sizeof (RamChunk) * count);
+        BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        data->chunks = (RamChunk *) ptr;
+        data->allocChunks = count;
+    } /* if */
+
+    chunk = &data->chunks[data->numChunks];
+    chunk->buf = (PHYSFS_uint8 *) allocator.Malloc((size_t) size);
+    BAIL_IF_MACRO(!chunk->buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    chunk->start = data->capacity;
+    chunk->size = size;
+    data->numChunks++;
+    data->capacity += size;
+    fs->bytes += size;
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_BUFFERS, (PHYSFS_sint64) size);
+    return 1;
+} /* ramGrow */
+
+
+/* Index of the chunk that holds byte (pos), which has to be in one. */
+static size_t ramChunkFor(const RamData *data, PHYSFS_uint64 pos)
+{
+    size_t lo = 0;
+    size_t hi = data->numChunks - 1;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + ((hi - lo + 1) / 2);
+        if (data->chunks[mid].start <= pos)
+            lo = mid;
+        else
+            hi = mid - 1;
+    } /* while */
+
+    return lo;
+} /* ramChunkFor */
+
+
+/* (pos + len) has to be within data->len. */
+static int ramReadData(RamData *data, void *buf, PHYSFS_uint64 len,
+                       PHYSFS_uint64 pos)
+{
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+    size_t i;
+
+    if (len == 0)
+        return 1;
+
+    if (data->spillPath != NULL)
+    {
+        if (data->spillRead == NULL)
+        {
+            data->spillRead = __PHYSFS_createNativeIo(data->spillPath, 'r');
+            BAIL_IF_MACRO(!data->spillRead, ERRPASS, 0);
+        } /* if */
+        return (__PHYSFS_ioReadAt(data->spillRead, buf, len, pos) ==
+                (PHYSFS_sint64) len);
+    } /* if */
+
+    for (i = ramChunkFor(data, pos); len > 0; i++)
+    {
+        const RamChunk *chunk = &data->chunks[i];
+        const PHYSFS_uint64 off = pos - chunk->start;
+        PHYSFS_uint64 cpy = chunk->size - off;
+        if (cpy > len)
+            cpy = len;
+        memcpy(ptr, chunk->buf + off, (size_t) cpy);
+        ptr += cpy;
+        pos += cpy;
+        len -= cpy;
+    } /* for */
+
+    return 1;
+} /* ramReadData */
+
+
+/* ramGrow() has to have made room for this already. */
+static int ramWriteData(RamData *data, const void *buf, PHYSFS_uint64 len,
+                        PHYSFS_uint64 pos)
+{
+    const PHYSFS_uint8 *ptr = (const PHYSFS_uint8 *) buf;
+    size_t i;
+
+    if (len == 0)
+        return 1;
+
+    if (data->spillPath != NULL)
+    {
+        PHYSFS_Io *io = data->spillWrite;
+        BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
+        BAIL_IF_MACRO(io->write(io, buf, len) != (PHYSFS_sint64) len,
+                      ERRPASS, 0);
+        pos += len;
+    } /* if */
+    else
+    {
+        for (i = ramChunkFor(data, pos); len > 0; i++)
+        {
+            const RamChunk *chunk = &data->chunks[i];
+            const PHYSFS_uint64 off = pos - chunk->start;
+            PHYSFS_uint64 cpy = chunk->size - off;
+            if (cpy > len)
+                cpy = len;
+            memcpy(chunk->buf + off, ptr, (size_t) cpy);
+            ptr += cpy;
+            pos += cpy;
+            len -= cpy;
+        } /* for */
+    } /* else */
+
+    if (pos > data->len)
+        data->len = pos;
+    return 1;
+} /* ramWriteData */
+
+
+static int ramSpill(RamFs *fs, RamData *data)
+{
+    const size_t len = strlen(fs->spillDir) + 48;
+    char *path = (char *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    snprintf(path, len, "%s%cphysfs-ram-%p-%u.tmp", fs->spillDir,
+             __PHYSFS_platformDirSeparator, (void *) fs,
+             (unsigned int) ++fs->spillSerial);
+
+    data->spillWrite = __PHYSFS_createNativeIo(path, 'w');
+    if (data->spillWrite == NULL)
+    {
+        allocator.Free(path);
+        return 0;
+    } /* if */
+
+    data->spillPath = path;
+    return 1;
+} /* ramSpill */
+
+
+/*
+ * A copy of (src), to carry on writing to instead of it, with room for at
+ *  least (end) bytes. It's on disk if (toDisk), and in one chunk if not,
+ *  which is the only time a file's data gets copied, so files that are
+ *  read while they're written to end up in one piece.
+ */
+static RamData *ramCopyData(RamFs *fs, RamData *src, PHYSFS_uint64 end,
+                            int toDisk)
+{
+    RamData *dst = ramCreateData();
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_uint64 pos;
+
+    BAIL_IF_MACRO(!dst, ERRPASS, NULL);
+
+    if (!toDisk)
+    {
+        if (end < src->len)
+            end = src->len;
+        /* it's empty, so this is one chunk that holds all of it. */
+        GOTO_IF_MACRO(!ramGrow(fs, dst, end), ERRPASS, copyFailed);
+        GOTO_IF_MACRO(!ramReadData(src, dst->chunks[0].buf, src->len, 0),
+                      ERRPASS, copyFailed);
+        dst->len = src->len;
+        return dst;
+    } /* if */
+
+    GOTO_IF_MACRO(!ramSpill(fs, dst), ERRPASS, copyFailed);
+
+    if (src->spillPath == NULL)  /* write straight from the chunks. */
+    {
+        size_t i;
+        for (i = 0; (i < src->numChunks) && (dst->len < src->len); i++)
+        {
+            const RamChunk *chunk = &src->chunks[i];
+            PHYSFS_uint64 cpy = src->len - chunk->start;
+            if (cpy > chunk->size)
+                cpy = chunk->size;
+            GOTO_IF_MACRO(!ramWriteData(dst, chunk->buf, cpy, chunk->start),
+                          ERRPASS, copyFailed);
+        } /* for */
+        return dst;
+    } /* if */
+
+    buf = (PHYSFS_uint8 *) allocator.Malloc(RAM_COPY_BUFFER);
+    GOTO_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, copyFailed);
+    for (pos = 0; pos < src->len; )
+    {
+        PHYSFS_uint64 cpy = src->len - pos;
+        if (cpy > RAM_COPY_BUFFER)
+            cpy = RAM_COPY_BUFFER;
+        GOTO_IF_MACRO(!ramReadData(src, buf, cpy, pos), ERRPASS, copyFailed);
+        GOTO_IF_MACRO(!ramWriteData(dst, buf, cpy, pos), ERRPASS, copyFailed);
+        pos += cpy;
+    } /* for */
+    allocator.Free(buf);
+    return dst;
+
+copyFailed:
+    allocator.Free(buf);
+    ramReleaseData(fs, dst);
+    return NULL;
+} /* ramCopyData */
+
+
+/*
+ * Get (f)'s data ready to take (len) bytes at its position: copy it if a
+ *  reader could see those bytes change, and move it to disk if it would
+ *  go over the spill limit.
+ */
+static int ramPrepareWrite(RamFile *f, PHYSFS_uint64 len)
+{
+    RamFs *fs = f->fs;
+    RamData *data = f->data;
+    const PHYSFS_uint64 end = f->pos + len;
+    const int mustCopy = ((data->readers > 0) && (f->pos < data->len));
+    PHYSFS_uint64 need = ramGrowth(data, end);
+    int toDisk = (data->spillPath != NULL);
+    RamData *copy;
+
+    if (mustCopy)
+        need = (end > data->len) ? end : data->len;
+
+    if ((!toDisk) && (fs->spillLimit > 0) && (fs->bytes + need > fs->spillLimit))
+    {
+        BAIL_IF_MACRO(!fs->spillDir, PHYSFS_ERR_NO_SPACE, 0);
+        toDisk = 1;
+    } /* if */
+
+    if ((!mustCopy) && (toDisk == (data->spillPath != NULL)))
+        return ramGrow(fs, data, end);
+
+    copy = ramCopyData(fs, data, end, toDisk);
+    BAIL_IF_MACRO(!copy, ERRPASS, 0);
+
+    if (f->node->data == data)  /* someone may have truncated it since. */
+    {
+        copy->refcount++;
+        f->node->data = copy;
+        ramReleaseData(fs, data);
+    } /* if */
+    ramReleaseData(fs, data);
+    f->data = copy;
+    return 1;
+} /* ramPrepareWrite */
+
+
+static void ramReleaseNode(RamFs *fs, RamNode *node)
+{
+    if (--node->refcount > 0)
+        return;
+
+    ramReleaseData(fs, node->data);
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX, -((PHYSFS_sint64)
+                       (sizeof (RamNode) + strlen(node->path) + 1)));
+    allocator.Free(node);
+} /* ramReleaseNode */
+
+
+/* Make a node for (path), whose parent has to be a directory already. */
+static RamNode *ramCreateNode(RamFs *fs, const char *path, int isDir)
+{
+    const char *name = strrchr(path, '/');
+    const size_t len = strlen(path) + 1;
+    RamNode *parent;
+    RamNode *node;
+    RamNode **bucket;
+
+    if (name == NULL)
+        parent = ramFind(fs, "");
+    else
+    {
+        char *dir = (char *) __PHYSFS_smallAlloc((size_t) (name - path) + 1);
+        BAIL_IF_MACRO(!dir, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+        memcpy(dir, path, (size_t) (name - path));
+        dir[name - path] = '\0';
+        parent = ramFind(fs, dir);
+        __PHYSFS_smallFree(dir);
+    } /* else */
+
+    BAIL_IF_MACRO(!parent, PHYSFS_ERR_NOT_FOUND, NULL);
+    BAIL_IF_MACRO(!parent->isDir, PHYSFS_ERR_NOT_FOUND, NULL);
+
+    if ((fs->numNodes >= fs->numBuckets) && (!ramGrowBuckets(fs)))
+        return NULL;
+
+    node = (RamNode *) allocator.Malloc(sizeof (RamNode) + len);
+    BAIL_IF_MACRO(!node, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(node, '\0', sizeof (RamNode));
+    memcpy(node + 1, path, len);
+    node->path = (const char *) (node + 1);
+    node->hash = ramHash(path);
+    node->isDir = isDir;
+    node->refcount = 1;
+    node->modtime = node->createtime = (PHYSFS_sint64) time(NULL);
+
+    if (!isDir)
+    {
+        node->data = ramCreateData();
+        if (node->data == NULL)
+        {
+            allocator.Free(node);
+            return NULL;
+        } /* if */
+    } /* if */
+
+    node->parent = parent;
+    node->sibling = parent->children;
+    parent->children = node;
+    bucket = &fs->buckets[node->hash & (fs->numBuckets - 1)];
+    node->hashNext = *bucket;
+    *bucket = node;
+    fs->numNodes++;
+
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) (sizeof (RamNode) + len));
+    return node;
+} /* ramCreateNode */
+
+
+static void ramUnlinkNode(RamFs *fs, RamNode *node)
+{
+    RamNode **prev;
+
+    for (prev = &node->parent->children; *prev != node;
+         prev = &(*prev)->sibling) { /* spin */ }
+    *prev = node->sibling;
+
+    for (prev = &fs->buckets[node->hash & (fs->numBuckets - 1)];
+         *prev != node; prev = &(*prev)->hashNext) { /* spin */ }
+    *prev = node->hashNext;
+
+    node->parent = NULL;
+    fs->numNodes--;
+    ramReleaseNode(fs, node);
+} /* ramUnlinkNode */
+
+
+static void ramStatNode(const RamNode *node, PHYSFS_Stat *st)
+{
+    st->filesize = node->isDir ? 0 : (PHYSFS_sint64) node->data->len;
+    st->modtime = node->modtime;
+    st->createtime = node->createtime;
+    st->accesstime = -1;
+    st->filetype = node->isDir ? PHYSFS_FILETYPE_DIRECTORY :
+                                 PHYSFS_FILETYPE_REGULAR;
+    st->readonly = 0;
+} /* ramStatNode */
+
+
+void *__PHYSFS_ramCreate(PHYSFS_uint64 spillLimit, const char *spillDir)
+{
+    RamFs *fs = (RamFs *) allocator.Malloc(sizeof (RamFs));
+    BAIL_IF_MACRO(!fs, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(fs, '\0', sizeof (RamFs));
+    fs->refcount = 1;
+    fs->spillLimit = spillLimit;
+
+    fs->numBuckets = 16;
+    fs->buckets = (RamNode **) allocator.Malloc(sizeof (RamNode *) * 16);
+    GOTO_IF_MACRO(!fs->buckets, PHYSFS_ERR_OUT_OF_MEMORY, createFailed);
+    memset(fs->buckets, '\0', sizeof (RamNode *) * 16);
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX, sizeof (RamNode *) * 16);
+
+    if (spillDir != NULL)
+    {
+        fs->spillDir = (char *) allocator.Malloc(strlen(spillDir) + 1);
+        GOTO_IF_MACRO(!fs->spillDir, PHYSFS_ERR_OUT_OF_MEMORY, createFailed);
+        strcpy(fs->spillDir, spillDir);
+    } /* if */
+
+    fs->lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!fs->lock, ERRPASS, createFailed);
+
+    /* the root doesn't have a parent, so it's put in by hand. */
+    {
+        RamNode *root = (RamNode *) allocator.Malloc(sizeof (RamNode) + 1);
+        GOTO_IF_MACRO(!root, PHYSFS_ERR_OUT_OF_MEMORY, createFailed);
+        memset(root, '\0', sizeof (RamNode) + 1);
+        root->path = (const char *) (root + 1);
+        root->hash = ramHash("");
+        root->isDir = 1;
+        root->refcount = 1;
+        root->modtime = root->createtime = (PHYSFS_sint64) time(NULL);
+        fs->buckets[root->hash & 15] = root;
+        fs->numNodes = 1;
+        __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX, sizeof (RamNode) + 1);
+    }
+
+    return fs;
+
+createFailed:
+    if (fs->lock != NULL)
+        __PHYSFS_platformDestroyMutex(fs->lock);
+    if (fs->buckets != NULL)
+    {
+        __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX,
+                           -((PHYSFS_sint64) (sizeof (RamNode *) * 16)));
+        allocator.Free(fs->buckets);
+    } /* if */
+    allocator.Free(fs->spillDir);
+    allocator.Free(fs);
+    return NULL;
+} /* __PHYSFS_ramCreate */
+
+
+void __PHYSFS_ramRetain(void *opaque)
+{
+    __PHYSFS_ATOMIC_INCR(&((RamFs *) opaque)->refcount);
+} /* __PHYSFS_ramRetain */
+
+
+/* Everything's in the hash table, so it's emptied without walking the tree. */
+void __PHYSFS_ramRelease(void *opaque)
+{
+    RamFs *fs = (RamFs *) opaque;
+    size_t i;
+
+    if ((fs == NULL) || (__PHYSFS_ATOMIC_DECR(&fs->refcount) > 0))
+        return;
+
+    for (i = 0; i < fs->numBuckets; i++)
+    {
+        RamNode *node = fs->buckets[i];
+        while (node != NULL)
+        {
+            RamNode *next = node->hashNext;
+            ramReleaseNode(fs, node);  /* nothing's open, so it's the last. */
+            node = next;
+        } /* while */
+    } /* for */
+
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) (sizeof (RamNode *) * fs->numBuckets)));
+    __PHYSFS_platformDestroyMutex(fs->lock);
+    allocator.Free(fs->buckets);
+    allocator.Free(fs->spillDir);
+    allocator.Free(fs);
+} /* __PHYSFS_ramRelease */
+
+
+static PHYSFS_sint64 RAM_readAt(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len,
+                                PHYSFS_uint64 offset)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    int rc;
+
+    BAIL_IF_MACRO(f->node != NULL, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+    if (offset >= f->len)
+        return 0;
+    if (len > f->len - offset)
+        len = f->len - offset;
+
+    __PHYSFS_platformGrabMutex(f->fs->lock);
+    rc = ramReadData(f->data, buf, len, offset);
+    __PHYSFS_platformReleaseMutex(f->fs->lock);
+    return rc ? (PHYSFS_sint64) len : -1;
+} /* RAM_readAt */
+
+
+static PHYSFS_sint64 RAM_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    PHYSFS_sint64 rc;
+
+    BAIL_IF_MACRO(f->node != NULL, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+    rc = RAM_readAt(io, buf, len, f->pos);
+    if (rc > 0)
+        f->pos += (PHYSFS_uint64) rc;
+    return rc;
+} /* RAM_read */
+
+
+static PHYSFS_sint64 RAM_write(PHYSFS_Io *io, const void *buf,
+                               PHYSFS_uint64 len)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    RamFs *fs = f->fs;
+    int rc;
+
+    BAIL_IF_MACRO(f->node == NULL, PHYSFS_ERR_OPEN_FOR_READING, -1);
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    rc = ramPrepareWrite(f, len) && ramWriteData(f->data, buf, len, f->pos);
+    if (rc)
+    {
+        f->pos += len;
+        f->node->modtime = (PHYSFS_sint64) time(NULL);
+    } /* if */
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    return rc ? (PHYSFS_sint64) len : -1;
+} /* RAM_write */
+
+
+static PHYSFS_sint64 RAM_length(PHYSFS_Io *io)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    PHYSFS_sint64 retval;
+
+    if (f->node == NULL)
+        return (PHYSFS_sint64) f->len;
+
+    __PHYSFS_platformGrabMutex(f->fs->lock);
+    retval = (PHYSFS_sint64) f->data->len;
+    __PHYSFS_platformReleaseMutex(f->fs->lock);
+    return retval;
+} /* RAM_length */
+
+
+static int RAM_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    BAIL_IF_MACRO(offset > (PHYSFS_uint64) RAM_length(io), PHYSFS_ERR_PAST_EOF, 0);
+    f->pos = offset;
+    return 1;
+} /* RAM_seek */
+
+
+static PHYSFS_sint64 RAM_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((RamFile *) io->opaque)->pos;
+} /* RAM_tell */
+
+
+static int RAM_flush(PHYSFS_Io *io) { return 1;  /* nothing's buffered. */ }
+
+
+/* Zero-copy, as long as everything the reader sees is in the first chunk. */
+static int RAM_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    int retval = 0;
+
+    if (f->node != NULL)
+        return 0;  /* writers' data can still be copied away from them. */
+
+    __PHYSFS_platformGrabMutex(f->fs->lock);
+    if (f->len == 0)
+    {
+        *ptr = "";
+        *len = 0;
+        retval = 1;
+    } /* if */
+    else if ((f->data->spillPath == NULL) && (f->len <= f->data->chunks[0].size))
+    {
+        *ptr = f->data->chunks[0].buf;
+        *len = f->len;
+        retval = 1;
+    } /* else if */
+    __PHYSFS_platformReleaseMutex(f->fs->lock);
+
+    return retval;
+} /* RAM_map */
+
+
+static void RAM_destroy(PHYSFS_Io *io)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    RamFs *fs = f->fs;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    if (f->node == NULL)
+        f->data->readers--;
+    else
+        ramReleaseNode(fs, f->node);
+    ramReleaseData(fs, f->data);
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    allocator.Free(f);
+    allocator.Free(io);
+} /* RAM_destroy */
+
+
+static PHYSFS_Io *RAM_duplicate(PHYSFS_Io *io);
+
+static const PHYSFS_Io RAM_Io =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    RAM_read,
+    RAM_write,
+    RAM_seek,
+    RAM_tell,
+    RAM_length,
+    RAM_duplicate,
+    RAM_flush,
+    RAM_destroy,
+    RAM_map,
+    RAM_readAt,
+    NULL,  /* readv */
+    NULL,  /* advise */
+    NULL,  /* backing */
+    NULL   /* raw */
+};
+
+
+/* Call with the lock held. Takes a reference on (node) if it's a writer. */
+static PHYSFS_Io *ramCreateIo(RamFs *fs, RamNode *node, RamData *data,
+                              int forWriting)
+{
+    PHYSFS_Io *io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    RamFile *f = (RamFile *) allocator.Malloc(sizeof (RamFile));
+
+    if ((!io) || (!f))
+    {
+        allocator.Free(io);
+        allocator.Free(f);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    memset(f, '\0', sizeof (RamFile));
+    f->fs = fs;
+    f->data = data;
+    data->refcount++;
+    if (forWriting)
+    {
+        f->node = node;
+        node->refcount++;
+    } /* if */
+    else
+    {
+        f->len = data->len;
+        data->readers++;
+    } /* else */
+
+    memcpy(io, &RAM_Io, sizeof (*io));
+    io->opaque = f;
+    return io;
+} /* ramCreateIo */
+
+
+static PHYSFS_Io *RAM_duplicate(PHYSFS_Io *io)
+{
+    RamFile *f = (RamFile *) io->opaque;
+    PHYSFS_Io *retval;
+
+    BAIL_IF_MACRO(f->node != NULL, PHYSFS_ERR_UNSUPPORTED, NULL);
+    __PHYSFS_platformGrabMutex(f->fs->lock);
+    retval = ramCreateIo(f->fs, NULL, f->data, 0);
+    __PHYSFS_platformReleaseMutex(f->fs->lock);
+    if (retval != NULL)
+        ((RamFile *) retval->opaque)->len = f->len;  /* same snapshot. */
+    return retval;
+} /* RAM_duplicate */
+
+
+static void *RAM_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
+{
+    /* not one of ours is no error; DIR gets its turn next. */
+    if ((io != NULL) || (name == NULL))
+        return NULL;
+    return __PHYSFS_ramLookup(name);
+} /* RAM_openArchive */
+
+
+static PHYSFS_Io *RAM_openRead(void *opaque, const char *name)
+{
+    RamFs *fs = (RamFs *) opaque;
+    PHYSFS_Io *retval = NULL;
+    RamNode *node;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    node = ramFind(fs, name);
+    if (node == NULL)
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+    else if (node->isDir)
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
+    else
+        retval = ramCreateIo(fs, NULL, node->data, 0);
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    return retval;
+} /* RAM_openRead */
+
+
+static PHYSFS_Io *ramOpenWriter(RamFs *fs, const char *name, int append)
+{
+    PHYSFS_Io *retval = NULL;
+    RamNode *node;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    node = ramFind(fs, name);
+    if (node == NULL)
+        node = ramCreateNode(fs, name, 0);
+    else if (node->isDir)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
+        node = NULL;
+    } /* else if */
+    else if ((!append) && (node->data->len > 0))
+    {
+        /* truncating: anyone reading it keeps what they had. */
+        RamData *data = ramCreateData();
+        if (data == NULL)
+            node = NULL;
+        else
+        {
+            ramReleaseData(fs, node->data);
+            node->data = data;
+            node->modtime = (PHYSFS_sint64) time(NULL);
+        } /* else */
+    } /* else if */
+
+    if (node != NULL)
+    {
+        retval = ramCreateIo(fs, node, node->data, 1);
+        if ((retval != NULL) && (append))
+            ((RamFile *) retval->opaque)->pos = node->data->len;
+    } /* if */
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    return retval;
+} /* ramOpenWriter */
+
+
+static PHYSFS_Io *RAM_openWrite(void *opaque, const char *name)
+{
+    return ramOpenWriter((RamFs *) opaque, name, 0);
+} /* RAM_openWrite */
+
+
+static PHYSFS_Io *RAM_openAppend(void *opaque, const char *name)
+{
+    return ramOpenWriter((RamFs *) opaque, name, 1);
+} /* RAM_openAppend */
+
+
+static int RAM_remove(void *opaque, const char *name)
+{
+    RamFs *fs = (RamFs *) opaque;
+    RamNode *node;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    node = ramFind(fs, name);
+    BAIL_IF_MACRO_MUTEX(!node, PHYSFS_ERR_NOT_FOUND, fs->lock, 0);
+    BAIL_IF_MACRO_MUTEX(!node->parent, PHYSFS_ERR_PERMISSION, fs->lock, 0);
+    BAIL_IF_MACRO_MUTEX(node->children, PHYSFS_ERR_DIR_NOT_EMPTY, fs->lock, 0);
+    ramUnlinkNode(fs, node);
+    __PHYSFS_platformReleaseMutex(fs->lock);
+    return 1;
+} /* RAM_remove */
+
+
+static int RAM_mkdir(void *opaque, const char *name)
+{
+    RamFs *fs = (RamFs *) opaque;
+    RamNode *node;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    node = ramFind(fs, name);
+    if (node == NULL)
+        node = ramCreateNode(fs, name, 1);
+    else if (!node->isDir)
+        BAIL_MACRO_MUTEX(PHYSFS_ERR_DUPLICATE, fs->lock, 0);
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    return (node != NULL);
+} /* RAM_mkdir */
+
+
+static int RAM_stat(void *opaque, const char *name, PHYSFS_Stat *stat)
+{
+    RamFs *fs = (RamFs *) opaque;
+    RamNode *node;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    node = ramFind(fs, name);
+    if (node != NULL)
+        ramStatNode(node, stat);
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    BAIL_IF_MACRO(!node, PHYSFS_ERR_NOT_FOUND, 0);
+    return 1;
+} /* RAM_stat */
+
+
+/*
+ * The callbacks can open, write and delete files here, so the listing is
+ *  copied out, with each entry's stat, and handed over without the lock.
+ */
+static void ramEnumerate(RamFs *fs, const char *dname,
+                         PHYSFS_EnumFilesCallback cb,
+                         PHYSFS_EnumFilesStatCallback statcb,
+                         const char *origdir, void *callbackdata)
+{
+    PHYSFS_Stat *stats = NULL;
+    char *names = NULL;
+    const RamNode *dir;
+    const RamNode *i;
+    size_t count = 0;
+    size_t len = 0;
+    size_t n;
+    char *ptr;
+
+    __PHYSFS_platformGrabMutex(fs->lock);
+    dir = ramFind(fs, dname);
+    if ((dir != NULL) && (dir->isDir))
+    {
+        for (i = dir->children; i != NULL; i = i->sibling)
+        {
+            count++;
+            len += strlen(i->path) + 1;
+        } /* for */
+
+        stats = (PHYSFS_Stat *) allocator.Malloc(sizeof (PHYSFS_Stat) * count);
+        names = (char *) allocator.Malloc(len);
+        if ((count > 0) && ((!stats) || (!names)))
+            count = 0;
+
+        ptr = names;
+        for (i = dir->children, n = 0; n < count; i = i->sibling, n++)
+        {
+            const char *name = strrchr(i->path, '/');
+            name = name ? name + 1 : i->path;
+            strcpy(ptr, name);
+            ptr += strlen(name) + 1;
+            ramStatNode(i, &stats[n]);
+        } /* for */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(fs->lock);
+
+    for (n = 0, ptr = names; n < count; n++, ptr += strlen(ptr) + 1)
+    {
+        if (statcb != NULL)
+            statcb(callbackdata, origdir, ptr, &stats[n]);
+        else
+            cb(callbackdata, origdir, ptr);
+    } /* for */
+
+    allocator.Free(stats);
+    allocator.Free(names);
+} /* ramEnumerate */
+
+
+static void RAM_enumerateFiles(void *opaque, const char *dname,
+                               PHYSFS_EnumFilesCallback cb,
+                               const char *origdir, void *callbackdata)
+{
+    ramEnumerate((RamFs *) opaque, dname, cb, NULL, origdir, callbackdata);
+} /* RAM_enumerateFiles */
+
+
+static void RAM_enumerateFilesStat(void *opaque, const char *dname,
+                                   PHYSFS_EnumFilesStatCallback cb,
+                                   const char *origdir, void *callbackdata)
+{
+    ramEnumerate((RamFs *) opaque, dname, NULL, cb, origdir, callbackdata);
+} /* RAM_enumerateFilesStat */
+
+
+static void RAM_closeArchive(void *opaque)
+{
+    __PHYSFS_ramRelease(opaque);
+} /* RAM_closeArchive */
+
+
+const PHYSFS_Archiver __PHYSFS_Archiver_RAM =
+{
+    CURRENT_PHYSFS_ARCHIVER_API_VERSION,
+    {
+        "",
+        "Writable directory in memory",
+        "agent <agent@local>",
+        "https://icculus.org/physfs/",
+        0,  /* supportsSymlinks */
+    },
+    RAM_openArchive,
+    RAM_enumerateFiles,
+    RAM_openRead,
+    RAM_openWrite,
+    RAM_openAppend,
+    RAM_remove,
+    RAM_mkdir,
+    RAM_stat,
+    RAM_closeArchive,
+    RAM_enumerateFilesStat
+};
+
+/* end of archiver_ram.c ... */
@@ -30,6 +30,8 @@
  *   (4 bytes)     file directory
  *   (40 bytes)    unknown
  *
+ *  A file whose two lengths differ is stored as a zlib stream.
+ *
  *  Directory
  *   (NULL-termed) file name
  *   (16 bytes)    unknown
@@ -45,11 +47,23 @@
 
 #if PHYSFS_SUPPORTS_RAS
 
+#include "physfs_inflate.h"
+
 #define RAS_SIG 0x00534152   /* "RAS " in ASCII. */
 #define RAS_FULLHEADERLEN 44
 
 #define RAS_ROL(x,y)  ((x<<y) | (x>>(8-y)))
 
+/*
+ * An entry whose compressed and uncompressed sizes differ is a zlib stream.
+ *  Each open one reads compressed data into a buffer of RAS_READBUFSIZE.
+ *  When it's closed, the buffer and inflater are kept for the next
+ *  compressed file opened in the same archive, up to RAS_SPARE_INFLATERS of
+ *  them (about 60k each), instead of being freed and allocated again.
+ */
+#define RAS_READBUFSIZE (16 * 1024)
+#define RAS_SPARE_INFLATERS 8
+
 typedef struct
 {
     PHYSFS_uint32 filecount;
@@ -63,22 +77,6 @@ typedef struct
     PHYSFS_uint32 unknown5;
 } RAS_baseinfo;
 
-typedef struct
-{
-    char* name;
-    PHYSFS_uint32 namelen;
-} RAS_dir;
-
-typedef struct
-{
-    char* name;
-    PHYSFS_uint32 namelen;
-    PHYSFS_uint32 uncompsize;
-    PHYSFS_uint32 size;
-    PHYSFS_uint32 dir;
-    PHYSFS_uint32 offset;
-} RAS_file;
-
 typedef enum
 {
     RAS_FILE,
@@ -87,48 +85,278 @@ typedef enum
 
 typedef struct _RASentry
 {
-    char* name;                         /* Name of file in archive        */
+    PHYSFS_uint32 name;                 /* offset of name in names pool   */
     RasEntryType type;
     PHYSFS_uint32 offset;               /* offset of data in archive      */
     PHYSFS_uint32 compressed_size;      /* compressed size                */
     PHYSFS_uint32 uncompressed_size;    /* uncompressed size              */
-    struct _RASentry *hashnext;         /* next item in this hash bucket  */
-    struct _RASentry *children;         /* linked list of kids, if dir    */
-    struct _RASentry *sibling;          /* next item in same dir          */
+    PHYSFS_uint32 children;             /* index of first kid, 0 if none  */
+    PHYSFS_uint32 sibling;              /* index of next in dir, 0 if none */
 } RASentry;
 
 typedef struct
 {
     PHYSFS_Io *io;            /* the i/o interface for this archive.    */
-    RASentry root;            /* root of directory tree.                */
-    RASentry **hash;          /* all entries hashed for fast lookup.    */
-    size_t hashBuckets;       /* number of buckets in hash.             */
+    RASentry *entries;        /* [0] is root; the rest by hash index.   */
+    PHYSFS_uint32 entry_count;        /* elements of entries in use.    */
+    PHYSFS_uint32 entries_allocated;  /* elements of entries allocated. */
+    char *names;              /* every entry's name, null-terminated.   */
+    PHYSFS_uint32 names_len;          /* bytes of names in use.         */
+    PHYSFS_uint32 names_allocated;    /* bytes of names allocated.      */
+    __PHYSFS_HashTable hash;  /* entry indices hashed for fast lookup.  */
+    void *spare_mutex;        /* guards spares and spare_count.         */
+    struct _RASfileinfo *spares;      /* closed files' inflaters.       */
+    PHYSFS_uint32 spare_count;        /* elements of spares.            */
 } RASinfo;
 
-typedef struct
+typedef struct _RASfileinfo
 {
-    PHYSFS_Io *io;
+    PHYSFS_Io *io;  /* the archive's own; shared by every open file. */
+    RASinfo *info;  /* where our inflater goes when we're closed.    */
     RASentry *entry;
-    PHYSFS_uint32 curPos;
+    PHYSFS_uint64 curPos;              /* uncompressed position.     */
+    PHYSFS_uint64 compressed_position; /* next compressed byte.      */
+    PHYSFS_uint8 *buffer;     /* compressed data; NULL if stored.    */
+    z_stream stream;          /* inflater, if (buffer) isn't NULL.   */
+    struct _RASfileinfo *next_spare;
 } RASfileinfo;
 
+
+static voidpf ras_zalloc(voidpf opaque, uInt items, uInt size)
+{
+    return ((PHYSFS_Allocator *) opaque)->Malloc(items * size);
+} /* ras_zalloc */
+
+static void ras_zfree(voidpf opaque, voidpf address)
+{
+    ((PHYSFS_Allocator *) opaque)->Free(address);
+} /* ras_zfree */
+
+/* Wrap all zlib calls in this, so the physfs error state is set. */
+static int ras_zlib_err(const int rc)
+{
+    if (rc == Z_MEM_ERROR)
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+    else if ((rc != Z_OK) && (rc != Z_STREAM_END))
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+    return rc;
+} /* ras_zlib_err */
+
+static inline int ras_entry_is_compressed(const RASentry *entry)
+{
+    return (entry->compressed_size != entry->uncompressed_size);
+} /* ras_entry_is_compressed */
+
+
+/*
+ * Get a RASfileinfo for (entry), with a buffer and inflater ready to go if
+ *  it's compressed: a spare from (info) if there is one, otherwise a new one.
+ */
+static RASfileinfo *ras_alloc_fileinfo(RASinfo *info, RASentry *entry)
+{
+    const int compressed = ras_entry_is_compressed(entry);
+    RASfileinfo *finfo = NULL;
+
+    if (compressed)
+    {
+        __PHYSFS_platformGrabMutex(info->spare_mutex);
+        finfo = info->spares;
+        if (finfo != NULL)
+        {
+            info->spares = finfo->next_spare;
+            info->spare_count--;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(info->spare_mutex);
+    } /* if */
+
+    if (finfo != NULL)
+        inflateReset(&finfo->stream);  /* can't fail once it's initialized. */
+
+    else
+    {
+        finfo = (RASfileinfo *) __PHYSFS_poolAlloc(sizeof (RASfileinfo));
+        BAIL_IF_MACRO(!finfo, ERRPASS, NULL);
+        memset(finfo, '\0', sizeof (RASfileinfo));
+
+        if (compressed)
+        {
+            finfo->stream.zalloc = ras_zalloc;
+            finfo->stream.zfree = ras_zfree;
+            finfo->stream.opaque = &allocator;
+            finfo->buffer = (PHYSFS_uint8 *) allocator.Malloc(RAS_READBUFSIZE);
+            if (!finfo->buffer)
+            {
+                __PHYSFS_poolFree(finfo, sizeof (RASfileinfo));
+                BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+            } /* if */
+            else if (ras_zlib_err(inflateInit2(&finfo->stream, MAX_WBITS)) != Z_OK)
+            {
+                allocator.Free(finfo->buffer);
+                __PHYSFS_poolFree(finfo, sizeof (RASfileinfo));
+                return NULL;
+            } /* else if */
+        } /* if */
+    } /* else */
+
+    finfo->io = info->io;  /* no duplicate (or file descriptor); see RAS_read(). */
+    finfo->info = info;
+    finfo->entry = entry;
+    finfo->curPos = 0;
+    finfo->compressed_position = 0;
+    finfo->stream.next_in = finfo->buffer;
+    finfo->stream.avail_in = 0;
+    finfo->next_spare = NULL;
+    return finfo;
+} /* ras_alloc_fileinfo */
+
+static void ras_destroy_fileinfo(RASfileinfo *finfo)
+{
+    if (finfo->buffer != NULL)
+    {
+        inflateEnd(&finfo->stream);
+        allocator.Free(finfo->buffer);
+    } /* if */
+    __PHYSFS_poolFree(finfo, sizeof (RASfileinfo));
+} /* ras_destroy_fileinfo */
+
+/* Free (finfo), or keep its buffer and inflater for the next file opened. */
+static void ras_free_fileinfo(RASfileinfo *finfo)
+{
+    RASinfo *info = finfo->info;
+
+    if (finfo->buffer != NULL)
+    {
+        int kept = 0;
+        __PHYSFS_platformGrabMutex(info->spare_mutex);
+        if (info->spare_count < RAS_SPARE_INFLATERS)
+        {
+            finfo->next_spare = info->spares;
+            info->spares = finfo;
+            info->spare_count++;
+            kept = 1;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(info->spare_mutex);
+
+        if (kept)
+            return;
+    } /* if */
+
+    ras_destroy_fileinfo(finfo);
+} /* ras_free_fileinfo */
+
+
+static PHYSFS_sint64 ras_inflate_read(RASfileinfo *finfo, void *buffer,
+                                      PHYSFS_uint64 len)
+{
+    const RASentry *entry = finfo->entry;
+    const char *name = finfo->info->names + entry->name;
+    PHYSFS_sint64 retval = 0;
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_DECOMPRESS, name, NULL,
+                         (PHYSFS_sint64) len);
+
+    finfo->stream.next_out = buffer;
+    finfo->stream.avail_out = (uInt) len;
+
+    while (retval < (PHYSFS_sint64) len)
+    {
+        const PHYSFS_uint32 before = finfo->stream.total_out;
+        int rc;
+
+        if (finfo->stream.avail_in == 0)
+        {
+            PHYSFS_uint64 br = entry->compressed_size -
+                               finfo->compressed_position;
+            if (br > 0)
+            {
+                PHYSFS_sint64 rc64;
+                if (br > RAS_READBUFSIZE)
+                    br = RAS_READBUFSIZE;
+                rc64 = __PHYSFS_ioReadAt(finfo->io, finfo->buffer, br,
+                                         ((PHYSFS_uint64) entry->offset) +
+                                         finfo->compressed_position);
+                if (rc64 <= 0)
+                    break;
+                finfo->compressed_position += (PHYSFS_uint64) rc64;
+                finfo->stream.next_in = finfo->buffer;
+                finfo->stream.avail_in = (uInt) rc64;
+            } /* if */
+        } /* if */
+
+        rc = ras_zlib_err(inflate(&finfo->stream, Z_SYNC_FLUSH));
+        retval += (finfo->stream.total_out - before);
+
+        if (rc != Z_OK)
+            break;
+    } /* while */
+
+    if (retval > 0)
+        __PHYSFS_STAT_ADD(bytesDecompressedRas, retval);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_DECOMPRESS, name, NULL, retval, 1);
+    return retval;
+} /* ras_inflate_read */
+
 static PHYSFS_sint64 RAS_read(PHYSFS_Io *io, void *buffer, PHYSFS_uint64 len)
 {
     RASfileinfo *finfo = (RASfileinfo *) io->opaque;
     const RASentry *entry = finfo->entry;
-    const PHYSFS_uint64 bytesLeft = (PHYSFS_uint64)(entry->compressed_size-finfo->curPos);
+    const PHYSFS_uint64 bytesLeft = (PHYSFS_uint64)(entry->uncompressed_size-finfo->curPos);
     PHYSFS_sint64 rc;
 
     if (bytesLeft < len)
         len = bytesLeft;
 
-    rc = finfo->io->read(finfo->io, buffer, len);
+    if (len == 0)
+        return 0;
+    else if (finfo->buffer != NULL)
+        rc = ras_inflate_read(finfo, buffer, len);
+    else
+    {
+        rc = __PHYSFS_ioReadAt(finfo->io, buffer, len,
+                               ((PHYSFS_uint64) entry->offset) + finfo->curPos);
+    } /* else */
+
     if (rc > 0)
-        finfo->curPos += (PHYSFS_uint32) rc;
+        finfo->curPos += (PHYSFS_uint64) rc;
 
     return rc;
 } /* RAS_read */
 
+static PHYSFS_sint64 RAS_readAt(PHYSFS_Io *io, void *buffer,
+                                PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    const RASfileinfo *finfo = (RASfileinfo *) io->opaque;
+    const RASentry *entry = finfo->entry;
+
+    if (offset >= entry->compressed_size)
+        return 0;
+
+    if (len > entry->compressed_size - offset)
+        len = entry->compressed_size - offset;
+
+    return __PHYSFS_ioReadAt(finfo->io, buffer, len, entry->offset + offset);
+} /* RAS_readAt */
+
+int __PHYSFS_rasGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len)
+{
+    const RASfileinfo *finfo;
+
+    if (io->read != RAS_read)
+        return 0;
+
+    finfo = (const RASfileinfo *) io->opaque;
+    if (finfo->buffer != NULL)
+        return 0;  /* compressed. */
+
+    *archive = finfo->info;
+    *src = finfo->io;
+    *pos = finfo->entry->offset;
+    *len = finfo->entry->uncompressed_size;
+    return 1;
+} /* __PHYSFS_rasGetStoredSpan */
+
 static PHYSFS_sint64 RAS_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 {
     BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
@@ -136,51 +364,72 @@ static PHYSFS_sint64 RAS_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 
 static PHYSFS_sint64 RAS_tell(PHYSFS_Io *io)
 {
-    return ((RASfileinfo *) io->opaque)->curPos;
+    return (PHYSFS_sint64) ((RASfileinfo *) io->opaque)->curPos;
 } /* RAS_tell */
 
 static int RAS_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 {
     RASfileinfo *finfo = (RASfileinfo *) io->opaque;
     const RASentry *entry = finfo->entry;
-    int rc;
 
-    BAIL_IF_MACRO(offset >= entry->compressed_size, PHYSFS_ERR_PAST_EOF, 0);
-    rc = finfo->io->seek(finfo->io, entry->offset + offset);
-    if (rc)
-        finfo->curPos = (PHYSFS_uint32) offset;
+    BAIL_IF_MACRO(offset > entry->uncompressed_size, PHYSFS_ERR_PAST_EOF, 0);
 
-    return rc;
+    if (finfo->buffer == NULL)
+    {
+        /* reads say where they want to be, so the archive's Io never moves. */
+        finfo->curPos = offset;
+        return 1;
+    } /* if */
+
+    /*
+     * Compressed data has to be decoded in order: going backwards means
+     *  starting over from the top, and going forwards means decoding and
+     *  throwing away everything in between.
+     */
+    if (offset < finfo->curPos)
+    {
+        inflateReset(&finfo->stream);
+        finfo->stream.next_in = finfo->buffer;
+        finfo->stream.avail_in = 0;
+        finfo->curPos = finfo->compressed_position = 0;
+    } /* if */
+
+    while (finfo->curPos != offset)
+    {
+        PHYSFS_uint8 buf[512];
+        PHYSFS_uint64 maxread = offset - finfo->curPos;
+        if (maxread > sizeof (buf))
+            maxread = sizeof (buf);
+
+        if (RAS_read(io, buf, maxread) != maxread)
+            return 0;
+    } /* while */
+
+    return 1;
 } /* RAS_seek */
 
 static PHYSFS_sint64 RAS_length(PHYSFS_Io *io)
 {
     const RASfileinfo *finfo = (RASfileinfo *) io->opaque;
-    return ((PHYSFS_sint64) finfo->entry->compressed_size);
+    return ((PHYSFS_sint64) finfo->entry->uncompressed_size);
 } /* RAS_length */
 
 static PHYSFS_Io *RAS_duplicate(PHYSFS_Io *_io)
 {
     RASfileinfo *origfinfo = (RASfileinfo *) _io->opaque;
-    PHYSFS_Io *io = NULL;
-    PHYSFS_Io *retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    RASfileinfo *finfo = (RASfileinfo *) allocator.Malloc(sizeof (RASfileinfo));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, RAS_duplicate_failed);
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, RAS_duplicate_failed);
-
-    io = origfinfo->io->duplicate(origfinfo->io);
-    if (!io) goto RAS_duplicate_failed;
-    finfo->io = io;
-    finfo->entry = origfinfo->entry;
-    finfo->curPos = 0;
+    PHYSFS_Io *retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    RASfileinfo *finfo = NULL;
+    GOTO_IF_MACRO(!retval, ERRPASS, RAS_duplicate_failed);
+
+    finfo = ras_alloc_fileinfo(origfinfo->info, origfinfo->entry);
+    GOTO_IF_MACRO(!finfo, ERRPASS, RAS_duplicate_failed);
+
     memcpy(retval, _io, sizeof (PHYSFS_Io));
     retval->opaque = finfo;
     return retval;
 
 RAS_duplicate_failed:
-    if (finfo != NULL) allocator.Free(finfo);
-    if (retval != NULL) allocator.Free(retval);
-    if (io != NULL) io->destroy(io);
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
     return NULL;
 } /* RAS_duplicate */
 
@@ -188,10 +437,8 @@ static int RAS_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
 
 static void RAS_destroy(PHYSFS_Io *io)
 {
-    RASfileinfo *finfo = (RASfileinfo *) io->opaque;
-    finfo->io->destroy(finfo->io);
-    allocator.Free(finfo);
-    allocator.Free(io);
+    ras_free_fileinfo((RASfileinfo *) io->opaque);
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
 } /* RAS_destroy */
 
 static const PHYSFS_Io RAS_Io =
@@ -204,274 +451,397 @@ static const PHYSFS_Io RAS_Io =
     RAS_length,
     RAS_duplicate,
     RAS_flush,
-    RAS_destroy
+    RAS_destroy,
+    NULL,  /* map */
+    RAS_readAt
+};
+
+static const PHYSFS_Io RAS_InflateIo =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    RAS_read,
+    RAS_write,
+    RAS_seek,
+    RAS_tell,
+    RAS_length,
+    RAS_duplicate,
+    RAS_flush,
+    RAS_destroy,
+    NULL,  /* map */
+    NULL   /* readAt: compressed entries have to be inflated in order. */
 };
 
 /*
  * Hash a string for lookup an a RASinfo hashtable.
  */
-static inline PHYSFS_uint32 ras_hash_string(const RASinfo *info, const char *s)
+static inline PHYSFS_uint32 ras_hash_string(const char *s, PHYSFS_uint32 len)
 {
-    return __PHYSFS_hashString(s, strlen(s)) % info->hashBuckets;
+    return __PHYSFS_hashString(s, len);
 } /* ras_hash_string */
 
-/* Find the RASentry for a path in platform-independent notation. */
-static RASentry *ras_find_entry(RASinfo *info, const char *path)
+/* Find the RASentry for the first (len) bytes of (path). */
+static RASentry *ras_find_entry_len(RASinfo *info, const char *path,
+                                    PHYSFS_uint32 len)
 {
     PHYSFS_uint32 hashval;
-    RASentry *prev = NULL;
-    RASentry *retval;
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 i;
 
-    if (*path == '\0')
-        return &info->root;
+    if (len == 0)
+        return &info->entries[0];
 
-    hashval = ras_hash_string(info, path);
-    for (retval = info->hash[hashval]; retval; retval = retval->hashnext)
+    /*
+     * Lookups can run on several threads at once, so the table has to
+     *  stay read-only after the archive is opened.
+     */
+    hashval = ras_hash_string(path, len);
+    while ((i = __PHYSFS_hashTableFind(&info->hash, hashval, &probe)) != 0)
     {
-        if (strcmp(retval->name, path) == 0)
-        {
-            if (prev != NULL)  /* move this to the front of the list */
-            {
-                prev->hashnext = retval->hashnext;
-                retval->hashnext = info->hash[hashval];
-                info->hash[hashval] = retval;
-            } /* if */
-
+        RASentry *retval = &info->entries[i];
+        const char *name = info->names + retval->name;
+        if ((strncmp(name, path, len) == 0) && (name[len] == '\0'))
             return retval;
-        } /* if */
-
-        prev = retval;
-    } /* for */
+    } /* while */
 
     BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, NULL);
-} /* ras_find_entry */
+} /* ras_find_entry_len */
 
-static int ras_hash_entry(RASinfo *info, RASentry *entry);
-
-/* Fill in missing parent directories. */
-static RASentry *ras_hash_ancestors(RASinfo *info, char *name)
+/* Find the RASentry for a path in platform-independent notation. */
+static RASentry *ras_find_entry(RASinfo *info, const char *path)
 {
-    RASentry *retval = &info->root;
-    char *sep = strrchr(name, '/');
-
-    if (sep)
-    {
-        const size_t namelen = (sep - name);
-
-        *sep = '\0';  /* chop off last piece. */
-        retval = ras_find_entry(info, name);
-        *sep = '/';
-
-        if (retval != NULL)
-        {
-            if (retval->type != RAS_DIRECTORY)
-                BAIL_MACRO(PHYSFS_ERR_CORRUPT, NULL);
-            return retval;  /* already hashed. */
-        } /* if */
-
-        /* okay, this is a new dir. Build and hash us. */
-        retval = (RASentry *) allocator.Malloc(sizeof (RASentry) + namelen + 1);
-        BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-        memset(retval, '\0', sizeof (*retval));
-        retval->name = ((char *) retval) + sizeof (RASentry);
-        memcpy(retval->name, name, namelen);
-        retval->name[namelen] = '\0';
-        retval->type = RAS_DIRECTORY;
-        if (!ras_hash_entry(info, retval))
-        {
-            allocator.Free(retval);
-            return NULL;
-        } /* if */
-    } /* else */
+    return ras_find_entry_len(info, path, (PHYSFS_uint32) strlen(path));
+} /* ras_find_entry */
 
-    return retval;
-} /* ras_hash_ancestors */
+/* Make room for (len) more bytes of names. The pool might move. */
+static int ras_reserve_names(RASinfo *info, PHYSFS_uint32 len)
+{
+    const PHYSFS_uint64 needed = ((PHYSFS_uint64) info->names_len) + len;
+    PHYSFS_uint64 count = info->names_allocated;
+    void *ptr;
+
+    if (needed <= count)
+        return 1;
+
+    while (count < needed)
+        count = count ? count * 2 : 256;
+    BAIL_IF_MACRO(count > 0xFFFFFFFF, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    ptr = allocator.Realloc(info->names, (size_t) count);
+    BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    info->names = (char *) ptr;
+    info->names_allocated = (PHYSFS_uint32) count;
+    return 1;
+} /* ras_reserve_names */
 
-static int ras_hash_entry(RASinfo *info, RASentry *entry)
+/*
+ * Claim the next slot of info->entries for the (len) byte name at (ofs) in
+ *  the names pool, hash it and make it one of (parent)'s kids.
+ */
+static RASentry *ras_add_entry(RASinfo *info, RASentry *parent,
+                               PHYSFS_uint32 ofs, PHYSFS_uint32 len,
+                               RasEntryType type)
 {
+    RASentry *entry;
     PHYSFS_uint32 hashval;
-    RASentry *parent;
 
-    assert(!ras_find_entry(info, entry->name));  /* checked elsewhere */
+    /* we counted every entry there can be before we started. */
+    BAIL_IF_MACRO(info->entry_count == info->entries_allocated,
+                  PHYSFS_ERR_CORRUPT, NULL);
 
-    parent = ras_hash_ancestors(info, entry->name);
-    if (!parent)
-        return 0;
-
-    hashval = ras_hash_string(info, entry->name);
-    entry->hashnext = info->hash[hashval];
-    info->hash[hashval] = entry;
+    hashval = ras_hash_string(info->names + ofs, len);
+    if (!__PHYSFS_hashTableInsert(&info->hash, hashval, info->entry_count))
+        return NULL;
 
+    entry = &info->entries[info->entry_count];
+    memset(entry, '\0', sizeof (*entry));
+    entry->name = ofs;
+    entry->type = type;
     entry->sibling = parent->children;
-    parent->children = entry;
-    return 1;
-} /* ras_hash_entry */
+    parent->children = info->entry_count++;
+    return entry;
+} /* ras_add_entry */
 
-static RASentry *ras_load_entry(RAS_file *file)
+/*
+ * Find the directory named by the (len) bytes at (ofs) in the names pool,
+ *  adding it and any missing parents if needed.
+ */
+static RASentry *ras_find_dir(RASinfo *info, PHYSFS_uint32 ofs,
+                              PHYSFS_uint32 len)
 {
-    RASentry* entry;
-    entry = (RASentry *) allocator.Malloc(sizeof (RASentry) + file->namelen + 1);
-    BAIL_IF_MACRO(entry == NULL, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    entry->name = ((char *) entry) + sizeof (RASentry);
-    strncpy(entry->name, file->name, file->namelen);
-    entry->name[file->namelen] = '\0';
-    if (entry->name[file->namelen - 1] == '/')
+    RASentry *parent;
+    RASentry *retval;
+    PHYSFS_uint32 parentlen = len;
+    PHYSFS_uint32 newofs;
+
+    retval = ras_find_entry_len(info, info->names + ofs, len);
+    if (retval != NULL)
     {
-        entry->name[file->namelen - 1] = '\0';
-        entry->type = RAS_DIRECTORY;
+        BAIL_IF_MACRO(retval->type != RAS_DIRECTORY, PHYSFS_ERR_CORRUPT, NULL);
+        return retval;
     } /* if */
-    else
-    {
-        entry->type = RAS_FILE;
-    }
-    entry->offset = file->offset;
-    entry->compressed_size = file->size;
-    entry->uncompressed_size = file->uncompsize;
-    entry->children = NULL;
-    entry->sibling = NULL;
-    return entry;
-} /* ras_load_entry */
 
-static int ras_load_entries(RASinfo *info, PHYSFS_uint32 fileCount, RAS_file* files)
-{
-    PHYSFS_uint32 i;
+    while ((parentlen > 0) && (info->names[ofs + parentlen - 1] != '/'))
+        parentlen--;
 
-    for (i = 0; i < fileCount; i++)
-    {
-        RASentry *entry = ras_load_entry(&files[i]);
-        RASentry *find;
+    parent = ras_find_dir(info, ofs, parentlen ? parentlen - 1 : 0);
+    if ((!parent) || (!ras_reserve_names(info, len + 1)))
+        return NULL;
 
-        find = ras_find_entry(info, entry->name);
-        if (find != NULL)  /* duplicate? */
-        {
-            find->offset = entry->offset;
-            find->compressed_size = entry->compressed_size;
-            find->uncompressed_size = entry->uncompressed_size;
-            allocator.Free(entry);
-            continue;
-        } /* if */
+    newofs = info->names_len;
+    memcpy(info->names + newofs, info->names + ofs, len);
+    info->names[newofs + len] = '\0';
+    info->names_len += len + 1;
+    return ras_add_entry(info, parent, newofs, len, RAS_DIRECTORY);
+} /* ras_find_dir */
 
-        if (!ras_hash_entry(info, entry))
-        {
-            allocator.Free(entry);
-            return 0;
-        } /* if */
-    }
-    return 1;
-} /* ras_load_entries */
+/*
+ * The keystream only depends on the seed, and every table restarts it at
+ *  position zero, so it's made once and applied to all the tables. The seed
+ *  is a small LCG that falls into a cycle (at most 30268 long) after a few
+ *  steps, so once the state we saw at RAS_KEYMARK comes back, the rest of
+ *  the keystream is copied from what we've already made.
+ */
+#define RAS_KEYMARK 256
 
-static void ras_decrypt(char* data, PHYSFS_uint32 length, PHYSFS_sint32 seed)
+static void ras_keystream(PHYSFS_uint8* key, PHYSFS_uint32 length, PHYSFS_sint32 seed)
 {
+    PHYSFS_sint32 mark = 0;
+    PHYSFS_uint32 pos;
+
     if (seed == 0)
         seed = 1;
 
-    if (length > 0) {
-        PHYSFS_sint32 pos;
-        for (pos = 0; pos < length; pos++) {
-            data[pos] = (PHYSFS_uint8) RAS_ROL((PHYSFS_uint8 )data[pos], (PHYSFS_uint8 )(pos % 5));
+    for (pos = 0; pos < length; pos++) {
+        /* Schrage's form of (seed * 171) % 30269, without the fixup. */
+        seed = (PHYSFS_sint32) (((PHYSFS_uint32) seed * 0xab) -
+                                ((PHYSFS_uint32) (seed / 177) * 0x763d));
+        key[pos] = (PHYSFS_uint8) seed;
 
-            PHYSFS_sint32 edx = ((PHYSFS_sint32) (((PHYSFS_sint64) seed * (PHYSFS_sint32) 0xb92143fb) >> 32) + seed) >> 7;
-            seed = (seed * 0xab) - ((((PHYSFS_uint32) edx >> 0x1f) + edx) * 0x763d);
+        if (pos == RAS_KEYMARK)
+            mark = seed;
+        else if ((pos > RAS_KEYMARK) && (seed == mark))
+            break;  /* key[pos + n] == key[RAS_KEYMARK + n] from here on. */
+    }
 
-            data[pos] = ((((PHYSFS_uint8) pos + 3) * 6) ^ data[pos]) + (PHYSFS_uint8) seed;
+    if (pos < length) {
+        const PHYSFS_uint32 period = pos - RAS_KEYMARK;
+        for (pos++; pos < length; pos += period) {
+            const PHYSFS_uint32 avail = length - pos;
+            memcpy(key + pos, key + pos - period, (avail < period) ? avail : period);
         }
     }
 }
 
-static RAS_dir* RAS_loadDirs(char* data, PHYSFS_uint32 datalen, PHYSFS_uint32 dircount)
+static void ras_decrypt_table(PHYSFS_uint8* data, PHYSFS_uint32 length, const PHYSFS_uint8* key)
 {
-    RAS_dir* dirs = (RAS_dir *) allocator.Malloc(sizeof (RAS_dir) * dircount);
+    PHYSFS_uint8 x = 18;  /* ((pos + 3) * 6), mod 256. */
+    PHYSFS_uint32 pos = 0;
+
+    #define RAS_DECRYPT_BYTE(rot) \
+        data[pos] = (PHYSFS_uint8) ((RAS_ROL(data[pos], rot) ^ x) + key[pos]); \
+        x += 6; pos++
+
+    while (pos + 5 <= length) {
+        RAS_DECRYPT_BYTE(0);
+        RAS_DECRYPT_BYTE(1);
+        RAS_DECRYPT_BYTE(2);
+        RAS_DECRYPT_BYTE(3);
+        RAS_DECRYPT_BYTE(4);
+    }
 
-    PHYSFS_uint32 ptr = 0;
-    PHYSFS_uint32 dirindex;
-    for (dirindex = 0; dirindex < dircount; dirindex++) {
-        PHYSFS_uint32 baseptr = ptr;
-        RAS_dir dir;
-        while (ptr < datalen && data[ptr] != 0) {
-            ptr++;
-        }
-        if(ptr > baseptr && data[baseptr] == '\\')
-            baseptr++;
-        PHYSFS_uint32 nameend = ptr;
-        ptr = baseptr;
-        PHYSFS_uint32 namelen = nameend - baseptr;
-        char* name = (char *) allocator.Malloc(sizeof (char) * (namelen + 1));
-        while (ptr < nameend) {
-            name[ptr - baseptr] = (data[ptr] == '\\') ? '/' : data[ptr];
-            ptr++;
-        }
-        name[namelen] = '\0';
-        dir.name = name;
-        dir.namelen = namelen;
-        ptr++;
-        ptr += sizeof(PHYSFS_uint32) + sizeof(PHYSFS_uint16) * 6;
-        dirs[dirindex] = dir;
+    while (pos < length) {
+        const int rot = (int) (pos % 5);
+        RAS_DECRYPT_BYTE(rot);
     }
-    return dirs;
+
+    #undef RAS_DECRYPT_BYTE
 }
 
-static RAS_file* RAS_loadFiles(char* data, PHYSFS_uint32 datalen, PHYSFS_uint32 filecount, RAS_dir* dirs, PHYSFS_uint32 dircount, PHYSFS_uint32 offset)
+static int ras_decrypt(char** data, const PHYSFS_uint32* length, int count, PHYSFS_sint32 seed)
 {
-    RAS_file* files = (RAS_file *) allocator.Malloc(sizeof (RAS_file) * filecount);
-    RAS_file* f = files;
+    PHYSFS_uint32 maxlen = 0;
+    PHYSFS_uint8* key;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (length[i] > maxlen)
+            maxlen = length[i];
+    }
+
+    key = (PHYSFS_uint8 *) allocator.Malloc(maxlen ? maxlen : 1);
+    BAIL_IF_MACRO(!key, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    ras_keystream(key, maxlen, seed);
+
+    for (i = 0; i < count; i++)
+        ras_decrypt_table((PHYSFS_uint8 *) data[i], length[i], key);
+
+    allocator.Free(key);
+    return 1;
+}
+
+static PHYSFS_uint32 ras_le32(const char* ptr)
+{
+    PHYSFS_uint32 val;
+    memcpy(&val, ptr, sizeof (val));
+    return PHYSFS_swapULE32(val);
+} /* ras_le32 */
+
+/*
+ * Build the entry table and names pool from the decrypted file and dir
+ *  tables. Dir names are fixed up where they sit in (dirs), and each file's
+ *  full path goes straight into the pool.
+ */
+static int ras_load_tables(RASinfo *info, const RAS_baseinfo *binfo,
+                           const char* files, char* dirs)
+{
+    PHYSFS_uint32 *dirspans = NULL;  /* start and length of each dir name. */
+    PHYSFS_uint64 maxentries = 1 + (PHYSFS_uint64) binfo->filecount;
+    PHYSFS_uint32 offset = RAS_FULLHEADERLEN + binfo->fileinfolen + binfo->dirinfolen;
     PHYSFS_uint32 ptr = 0;
-    PHYSFS_uint32 fileindex;
-    for (fileindex = 0; fileindex < filecount; fileindex++) {
-        PHYSFS_uint32 baseptr = ptr;
-        while (ptr < datalen && data[ptr] != 0) {
-            ptr++;
+    PHYSFS_uint32 i;
+
+    /* records are at least 17 and 41 bytes, so don't believe any more. */
+    BAIL_IF_MACRO(binfo->dircount > binfo->dirinfolen / 17, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(binfo->filecount > binfo->fileinfolen / 41, PHYSFS_ERR_CORRUPT, 0);
+
+    dirspans = (PHYSFS_uint32 *) allocator.Malloc((binfo->dircount + 1) * sizeof (PHYSFS_uint32) * 2);
+    BAIL_IF_MACRO(!dirspans, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    /* each record is a null-terminated name and 16 more bytes. */
+    for (i = 0; i < binfo->dircount; i++) {
+        char* name = dirs + ptr;
+        const char* end = (ptr < binfo->dirinfolen) ? (const char *) memchr(name, '\0', binfo->dirinfolen - ptr) : NULL;
+        GOTO_IF_MACRO(!end || ((PHYSFS_uint32) (end - dirs) + 17 > binfo->dirinfolen), PHYSFS_ERR_CORRUPT, failed);
+        ptr = (PHYSFS_uint32) (end - dirs) + 17;
+
+        if (*name == '\\')
+            name++;
+        dirspans[i * 2] = (PHYSFS_uint32) (name - dirs);
+        dirspans[i * 2 + 1] = (PHYSFS_uint32) (end - name);
+        for (; name < end; name++) {
+            if (*name == '\\') {
+                *name = '/';
+                maxentries++;  /* room for every dir on the way down. */
+            }
         }
-        PHYSFS_uint32 nameend = ptr;
-        ptr = baseptr;
-        PHYSFS_uint32 namelen = nameend - baseptr;
-        char* name = (char *) allocator.Malloc(sizeof (char) * (namelen + 1));
-        while (ptr < nameend) {
-            name[ptr - baseptr] = data[ptr];
-            ptr++;
+    }
+
+    /* a '/' anywhere in the file table could be another dir. */
+    for (i = 0; i < binfo->fileinfolen; i++) {
+        if (files[i] == '/')
+            maxentries++;
+    }
+
+    GOTO_IF_MACRO(maxentries > 0x7FFFFFFF, PHYSFS_ERR_CORRUPT, failed);
+    GOTO_IF_MACRO(!__PHYSFS_hashTableInit(&info->hash, (PHYSFS_uint32) maxentries), ERRPASS, failed);
+    info->entries = (RASentry *) allocator.Malloc((size_t) maxentries * sizeof (RASentry));
+    GOTO_IF_MACRO(!info->entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
+    info->entries_allocated = (PHYSFS_uint32) maxentries;
+    info->entry_count = 1;
+    memset(&info->entries[0], '\0', sizeof (RASentry));
+    info->entries[0].type = RAS_DIRECTORY;
+
+    /* the pool starts with the root's empty name. */
+    GOTO_IF_MACRO(!ras_reserve_names(info, binfo->fileinfolen + binfo->dirinfolen + 1), ERRPASS, failed);
+    info->names[0] = '\0';
+    info->names_len = 1;
+
+    /* each record is a null-terminated name and 40 more bytes. */
+    ptr = 0;
+    for (i = 0; i < binfo->filecount; i++) {
+        const char* name = files + ptr;
+        const char* end = (ptr < binfo->fileinfolen) ? (const char *) memchr(name, '\0', binfo->fileinfolen - ptr) : NULL;
+        PHYSFS_uint32 dir, dirlen, namelen, len, parentlen;
+        PHYSFS_uint32 uncompressed_size, compressed_size;
+        char* path;
+        RASentry* entry;
+
+        GOTO_IF_MACRO(!end || ((PHYSFS_uint32) (end - files) + 41 > binfo->fileinfolen), PHYSFS_ERR_CORRUPT, failed);
+        ptr = (PHYSFS_uint32) (end - files) + 41;
+        namelen = (PHYSFS_uint32) (end - name);
+        uncompressed_size = ras_le32(end + 1);
+        compressed_size = ras_le32(end + 5);
+        dir = ras_le32(end + 13);
+        GOTO_IF_MACRO(dir >= binfo->dircount, PHYSFS_ERR_CORRUPT, failed);
+        dirlen = dirspans[dir * 2 + 1];
+
+        /* put the full path at the end of the pool, but don't keep it yet. */
+        GOTO_IF_MACRO(!ras_reserve_names(info, dirlen + namelen + 1), ERRPASS, failed);
+        path = info->names + info->names_len;
+        memcpy(path, dirs + dirspans[dir * 2], dirlen);
+        memcpy(path + dirlen, name, namelen);
+        len = dirlen + namelen;
+
+        entry = (len > 0) ? ras_find_entry_len(info, path, len) : NULL;
+        if ((entry == NULL) && (len > 0)) {
+            /* not a duplicate; keep the name, and find (or make) its dir. */
+            const PHYSFS_uint32 ofs = info->names_len;
+            const int isdir = (path[len - 1] == '/');
+            RASentry* parent;
+
+            path[len] = '\0';
+            info->names_len += len + 1;
+
+            if (isdir)
+                len--;  /* a dir of its own, with the sizes of a file. */
+            for (parentlen = len; parentlen > 0; parentlen--) {
+                if (info->names[ofs + parentlen - 1] == '/')
+                    break;
+            }
+
+            parent = ras_find_dir(info, ofs, parentlen ? parentlen - 1 : 0);
+            GOTO_IF_MACRO(!parent, ERRPASS, failed);
+            if (!isdir)
+                entry = ras_add_entry(info, parent, ofs, len, RAS_FILE);
+            else {
+                info->names[ofs + len] = '\0';
+                entry = ras_find_dir(info, ofs, len);
+            }
+            GOTO_IF_MACRO(!entry, ERRPASS, failed);
         }
-        name[namelen] = '\0';
-        ptr++;
-        f->uncompsize = *((PHYSFS_uint32*) (data + ptr));
-        f->size = *((PHYSFS_uint32*) (data + ptr + sizeof(PHYSFS_uint32)));
-        f->dir = *((PHYSFS_uint32*) (data + ptr + sizeof(PHYSFS_uint32) * 3));
-        f->namelen = dirs[f->dir].namelen + namelen;
-        f->name = (char *) allocator.Malloc(sizeof (char) * (f->namelen + 1));
-        strncpy(f->name, dirs[f->dir].name, dirs[f->dir].namelen + 1);
-        strncat(f->name, name, namelen);
-        f->name[f->namelen] = '\0';
-        f->offset = offset;
-        offset += f->size;
-        ptr += sizeof(PHYSFS_uint32) * 7 + sizeof(PHYSFS_uint16) * 6;
-
-        f++;
-        allocator.Free(name);
+
+        if (entry != NULL) {
+            entry->offset = offset;
+            entry->compressed_size = compressed_size;
+            entry->uncompressed_size = uncompressed_size;
+        }
+
+        offset += compressed_size;
     }
-    return files;
-}
 
-static int ras_alloc_hashtable(RASinfo *info, const PHYSFS_uint64 entry_count)
-{
-    size_t alloclen;
+    allocator.Free(dirspans);
 
-    info->hashBuckets = (size_t) (entry_count / 5);
-    if (!info->hashBuckets)
-        info->hashBuckets = 1;
+    /* everything is found by index or offset, so shrink both to fit. */
+    {
+        void *ptr = allocator.Realloc(info->names, info->names_len);
+        if (ptr != NULL) {
+            info->names = (char *) ptr;
+            info->names_allocated = info->names_len;
+        }
 
-    alloclen = info->hashBuckets * sizeof (RASentry *);
-    info->hash = (RASentry **) allocator.Malloc(alloclen);
-    BAIL_IF_MACRO(!info->hash, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    memset(info->hash, '\0', alloclen);
+        ptr = allocator.Realloc(info->entries, info->entry_count * sizeof (RASentry));
+        if (ptr != NULL) {
+            info->entries = (RASentry *) ptr;
+            info->entries_allocated = info->entry_count;
+        }
+    }
 
     return 1;
-} /* ras_alloc_hashtable */
+
+failed:
+    allocator.Free(dirspans);
+    return 0;
+} /* ras_load_tables */
 
 static void RAS_closeArchive(void *opaque);
 
 static void *RAS_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 {
     RASinfo *info = NULL;
+    char *tables = NULL;
     PHYSFS_uint32 val = 0;
     PHYSFS_sint32 seed = 0;
+    PHYSFS_uint64 tableslen;
+    PHYSFS_sint64 iolen;
     RAS_baseinfo binfo;
 
     assert(io != NULL);  /* shouldn't ever happen. */
@@ -482,55 +852,58 @@ static void *RAS_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
     if (PHYSFS_swapULE32(val) != RAS_SIG)
         BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
 
-    info = (RASinfo *) allocator.Malloc(sizeof (RASinfo));
-    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    memset(info, '\0', sizeof (RASinfo));
-    info->io = io;
-    info->root.type = RAS_DIRECTORY;
-
     BAIL_IF_MACRO(!__PHYSFS_readAll(io, &seed, 4), ERRPASS, NULL);
+    seed = PHYSFS_swapSLE32(seed);
 
     BAIL_IF_MACRO(!__PHYSFS_readAll(io, &binfo, sizeof(RAS_baseinfo)), ERRPASS, NULL);
-    ras_decrypt((char*) &binfo, sizeof(RAS_baseinfo), seed);
-
-    char* fileinfodata = (char *) allocator.Malloc(sizeof (char) * binfo.fileinfolen);
-    BAIL_IF_MACRO(!__PHYSFS_readAll(io, fileinfodata, binfo.fileinfolen), ERRPASS, NULL);
-    ras_decrypt(fileinfodata, binfo.fileinfolen, seed);
+    {
+        char* table = (char*) &binfo;
+        PHYSFS_uint32 length = sizeof(RAS_baseinfo);
+        BAIL_IF_MACRO(!ras_decrypt(&table, &length, 1, seed), ERRPASS, NULL);
+    }
+    binfo.filecount = PHYSFS_swapULE32(binfo.filecount);
+    binfo.dircount = PHYSFS_swapULE32(binfo.dircount);
+    binfo.fileinfolen = PHYSFS_swapULE32(binfo.fileinfolen);
+    binfo.dirinfolen = PHYSFS_swapULE32(binfo.dirinfolen);
+
+    /* both tables come in one read, and get parsed where they sit. */
+    tableslen = ((PHYSFS_uint64) binfo.fileinfolen) + binfo.dirinfolen;
+    iolen = io->length(io);
+    BAIL_IF_MACRO(tableslen > 0x7FFFFFFF, PHYSFS_ERR_CORRUPT, NULL);
+    BAIL_IF_MACRO((iolen >= 0) && (tableslen + RAS_FULLHEADERLEN > (PHYSFS_uint64) iolen), PHYSFS_ERR_CORRUPT, NULL);
+    tables = (char *) allocator.Malloc((size_t) (tableslen ? tableslen : 1));
+    BAIL_IF_MACRO(!tables, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!__PHYSFS_readAll(io, tables, tableslen), ERRPASS, RAS_openarchive_failed);
 
-    char* dirinfodata = (char *) allocator.Malloc(sizeof (char) * binfo.dirinfolen);
-    BAIL_IF_MACRO(!__PHYSFS_readAll(io, dirinfodata, binfo.dirinfolen), ERRPASS, NULL);
-    ras_decrypt(dirinfodata, binfo.dirinfolen, seed);
+    {
+        char* tablelist[2];
+        PHYSFS_uint32 lengths[2];
+        tablelist[0] = tables;
+        lengths[0] = binfo.fileinfolen;
+        tablelist[1] = tables + binfo.fileinfolen;
+        lengths[1] = binfo.dirinfolen;
+        if (!ras_decrypt(tablelist, lengths, 2, seed))
+            goto RAS_openarchive_failed;
+    }
 
-    RAS_dir* dirs = RAS_loadDirs(dirinfodata, binfo.dirinfolen, binfo.dircount);
-    RAS_file* files = RAS_loadFiles(fileinfodata, binfo.fileinfolen, binfo.filecount, dirs, binfo.dircount, RAS_FULLHEADERLEN + binfo.fileinfolen + binfo.dirinfolen);
+    info = (RASinfo *) allocator.Malloc(sizeof (RASinfo));
+    GOTO_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, RAS_openarchive_failed);
+    memset(info, '\0', sizeof (RASinfo));
 
-    allocator.Free(fileinfodata);
-    allocator.Free(dirinfodata);
+    info->spare_mutex = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!info->spare_mutex, ERRPASS, RAS_openarchive_failed);
 
-    if(!ras_alloc_hashtable(info, binfo.dircount + binfo.filecount))
+    if (!ras_load_tables(info, &binfo, tables, tables + binfo.fileinfolen))
         goto RAS_openarchive_failed;
-    else if (!ras_load_entries(info, binfo.filecount, files))
-        goto RAS_openarchive_failed;
-
-    PHYSFS_uint32 fileindex;
-    for (fileindex = 0; fileindex < binfo.filecount; fileindex++) {
-        allocator.Free(files[fileindex].name);
-    }
-    allocator.Free(files);
-
-    PHYSFS_uint32 dirindex;
-    for (dirindex = 0; dirindex < binfo.dircount; dirindex++) {
-        allocator.Free(dirs[dirindex].name);
-    }
-    allocator.Free(dirs);
 
-    assert(info->root.sibling == NULL);
+    allocator.Free(tables);
+    info->io = io;
+    assert(info->entries[0].sibling == 0);
     return info;
 
 RAS_openarchive_failed:
-    info->io = NULL;  /* don't let RAS_closeArchive destroy (io). */
-
-    RAS_closeArchive(info);
+    allocator.Free(tables);
+    RAS_closeArchive(info);  /* info->io is still NULL, so (io) survives. */
     return NULL;
 } /* RAS_openArchive */
 
@@ -543,10 +916,12 @@ static void RAS_enumerateFiles(void *opaque, const char *dname,
     const RASentry *entry = ras_find_entry(info, dname);
     if (entry && (entry->type == RAS_DIRECTORY))
     {
-        for (entry = entry->children; entry; entry = entry->sibling)
+        PHYSFS_uint32 i;
+        for (i = entry->children; i != 0; i = info->entries[i].sibling)
         {
-            const char *ptr = strrchr(entry->name, '/');
-            cb(callbackdata, origdir, ptr ? ptr + 1 : entry->name);
+            const char *name = info->names + info->entries[i].name;
+            const char *ptr = strrchr(name, '/');
+            cb(callbackdata, origdir, ptr ? ptr + 1 : name);
         } /* for */
     } /* if */
 } /* RAS_enumerateFiles */
@@ -563,36 +938,21 @@ static PHYSFS_Io *RAS_openRead(void *opaque, const char *name)
     GOTO_IF_MACRO(!entry, ERRPASS, RAS_openRead_failed);
     GOTO_IF_MACRO(entry->type == RAS_DIRECTORY, PHYSFS_ERR_NOT_A_FILE, RAS_openRead_failed);
 
-    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, RAS_openRead_failed);
-
-    finfo = (RASfileinfo *) allocator.Malloc(sizeof (RASfileinfo));
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, RAS_openRead_failed);
+    retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, ERRPASS, RAS_openRead_failed);
 
-    finfo->io = info->io->duplicate(info->io);
-    GOTO_IF_MACRO(!finfo->io, ERRPASS, RAS_openRead_failed);
+    finfo = ras_alloc_fileinfo(info, entry);
+    GOTO_IF_MACRO(!finfo, ERRPASS, RAS_openRead_failed);
 
-    if (!finfo->io->seek(finfo->io, entry->offset))
-        goto RAS_openRead_failed;
-
-    finfo->curPos = 0;
-    finfo->entry = entry;
-
-    memcpy(retval, &RAS_Io, sizeof (*retval));
+    if (finfo->buffer != NULL)
+        memcpy(retval, &RAS_InflateIo, sizeof (*retval));
+    else
+        memcpy(retval, &RAS_Io, sizeof (*retval));
     retval->opaque = finfo;
     return retval;
 
 RAS_openRead_failed:
-    if (finfo != NULL)
-    {
-        if (finfo->io != NULL)
-            finfo->io->destroy(finfo->io);
-        allocator.Free(finfo);
-    } /* if */
-
-    if (retval != NULL)
-        allocator.Free(retval);
-
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
     return NULL;
 } /* UNPK_openRead */
 
@@ -634,8 +994,7 @@ static int RAS_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
     } /* if */
     else
     {
-        //stat->filesize = (PHYSFS_sint64) entry->uncompressed_size;
-        stat->filesize = (PHYSFS_sint64) entry->compressed_size;
+        stat->filesize = (PHYSFS_sint64) entry->uncompressed_size;
         stat->filetype = PHYSFS_FILETYPE_REGULAR;
     } /* else */
 
@@ -647,6 +1006,29 @@ static int RAS_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
     return 1;
 } /* RAS_stat */
 
+static int RAS_layout(void *opaque, const char *filename,
+                      PHYSFS_EntryLayout *layout)
+{
+    RASinfo *info = (RASinfo *) opaque;
+    const RASentry *entry = ras_find_entry(info, filename);
+
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->type == RAS_DIRECTORY, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    layout->offset = entry->offset;
+    layout->storedSize = entry->compressed_size;
+    layout->size = entry->uncompressed_size;
+
+    /* a zlib stream, header and all, which isn't what DEFLATE means. */
+    if (entry->compressed_size != entry->uncompressed_size)
+    {
+        layout->encoding = PHYSFS_ENCODING_OTHER;
+        layout->method = 8;  /* zlib's one and only. */
+    } /* if */
+
+    return 1;
+} /* RAS_layout */
+
 void RAS_closeArchive(void *opaque)
 {
     RASinfo *info = ((RASinfo *) opaque);
@@ -657,28 +1039,40 @@ void RAS_closeArchive(void *opaque)
     if (info->io)
         info->io->destroy(info->io);
 
-    assert(info->root.sibling == NULL);
-    assert(info->hash || (info->root.children == NULL));
+    if (__PHYSFS_isFastDeinit())
+        return;  /* the process is exiting; leave the index to the OS. */
+
+    /* every entry and name is in these two blocks. */
+    allocator.Free(info->entries);
+    allocator.Free(info->names);
 
-    if (info->hash)
+    __PHYSFS_hashTableDeinit(&info->hash);
+
+    while (info->spares != NULL)
     {
-        size_t i;
-        for (i = 0; i < info->hashBuckets; i++)
-        {
-            RASentry *entry;
-            RASentry *next;
-            for (entry = info->hash[i]; entry; entry = next)
-            {
-                next = entry->hashnext;
-                allocator.Free(entry);
-            } /* for */
-        } /* for */
-        allocator.Free(info->hash);
-    } /* if */
+        RASfileinfo *finfo = info->spares;
+        info->spares = finfo->next_spare;
+        ras_destroy_fileinfo(finfo);
+    } /* while */
+
+    if (info->spare_mutex)
+        __PHYSFS_platformDestroyMutex(info->spare_mutex);
 
     allocator.Free(info);
 } /* RAS_closeArchive */
 
+static int RAS_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    PHYSFS_uint32 val;
+    if (headLen < 4)
+        return 0;
+    memcpy(&val, head, 4);
+    return (PHYSFS_swapULE32(val) == RAS_SIG);
+} /* RAS_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_RAS =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -697,7 +1091,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_RAS =
     RAS_remove,
     RAS_mkdir,
     RAS_stat,
-    RAS_closeArchive
+    RAS_closeArchive,
+    NULL,  /* enumerateFilesStat */
+    RAS_claim,
+    NULL,  /* enumerateFilesPrefix */
+    NULL,  /* checksum */
+    RAS_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_RAS */
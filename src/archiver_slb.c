@@ -24,21 +24,24 @@ static UNPKentry *slbLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
 {
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 *table = NULL;
+    const PHYSFS_uint8 *rec = NULL;
+
+    table = (PHYSFS_uint8 *) UNPK_readTable(io, fileCount, 72);
+    BAIL_IF_MACRO(!table, ERRPASS, NULL);
 
     entries = (UNPKentry *) allocator.Malloc(sizeof (UNPKentry) * fileCount);
-    BAIL_IF_MACRO(entries == NULL, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
 
-    for (entry = entries; fileCount > 0; fileCount--, entry++)
+    for (entry = entries, rec = table; fileCount > 0; fileCount--, entry++)
     {
         char *ptr;
 
         /* don't include the '\' in the beginning */
-        char backslash;
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &backslash, 1), ERRPASS, failed);
-        GOTO_IF_MACRO(backslash != '\\', ERRPASS, failed);
+        GOTO_IF_MACRO(rec[0] != '\\', ERRPASS, failed);
 
-        /* read the rest of the buffer, 63 bytes */
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->name, 63), ERRPASS, failed);
+        /* the rest of the buffer, 63 bytes */
+        memcpy(entry->name, rec + 1, 63);
         entry->name[63] = '\0'; /* in case the name lacks the null terminator */
 
         /* convert backslashes */
@@ -48,18 +51,20 @@ static UNPKentry *slbLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
                 *ptr = '/';
         } /* for */
 
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->startPos, 4),
-                      ERRPASS, failed);
+        memcpy(&entry->startPos, rec + 64, 4);
         entry->startPos = PHYSFS_swapULE32(entry->startPos);
 
-        GOTO_IF_MACRO(!__PHYSFS_readAll(io, &entry->size, 4), ERRPASS, failed);
+        memcpy(&entry->size, rec + 68, 4);
         entry->size = PHYSFS_swapULE32(entry->size);
+        rec += 72;
     } /* for */
-    
+
+    allocator.Free(table);
     return entries;
 
 failed:
     allocator.Free(entries);
+    allocator.Free(table);
     return NULL;
 
 } /* slbLoadEntries */
@@ -99,6 +104,15 @@ static void *SLB_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* SLB_openArchive */
 
 
+static int SLB_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    /* all there is to go on is a version field that's always zero. */
+    return ((headLen >= 4) && (memcmp(head, "\0\0\0\0", 4) == 0));
+} /* SLB_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_SLB =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -117,7 +131,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_SLB =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    SLB_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_SLB */
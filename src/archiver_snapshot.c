@@ -0,0 +1,771 @@
+/*
+ * Index snapshot support routines for PhysicsFS.
+ *
+ * Mounting an archive means parsing its directory: a ZIP's central
+ *  directory, a 7z header (which is usually compressed itself), an ISO's
+ *  directory records, and so on. With PHYSFS_setIndexCacheDir(), the first
+ *  mount of an archive also saves everything it lists to a snapshot file,
+ *  keyed by the archive's path, size and modification time. Later mounts
+ *  of it, as long as those still match, read that back with one read and
+ *  answer stat() and enumerateFiles() from it, without opening the archive
+ *  at all. It's opened for real, and its directory parsed, the first time
+ *  a file in it is read, if that ever happens.
+ *
+ * Everything in a snapshot is an offset or an index, never a pointer, so
+ *  it's used right where it sits: where the platform can, the file is
+ *  mapped read-only and never copied. Every process mounting an archive
+ *  from the same cache dir then shares one copy of its index, in the OS's
+ *  page cache, and a mount only costs a map and a check of the header.
+ *
+ * Snapshots are written in this machine's byte order and struct layout,
+ *  and anything that doesn't look exactly right is ignored, so the archive
+ *  just gets parsed like it would have been without one. They're trusted
+ *  otherwise: don't use a cache dir that anyone else can write to.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#define __PHYSICSFS_INTERNAL__
+#include "physfs_internal.h"
+
+#define SNAPSHOT_SIG 0x58444950  /* "PIDX", little endian. */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_TMP_EXTENSION ".tmp"
+
+/*
+ * The file is one of these, then the entries, then the hash buckets, then
+ *  the archive's path, the archiver's extension and every entry's path,
+ *  each with its null. Entry 0 is the root, "".
+ */
+typedef struct
+{
+    PHYSFS_uint32 sig;
+    PHYSFS_uint32 version;
+    PHYSFS_uint32 headerSize;   /* sizeof (SnapshotHeader), for sanity.    */
+    PHYSFS_uint32 entrySize;    /* sizeof (SnapshotEntry), likewise.       */
+    PHYSFS_sint64 archiveSize;  /* what the archive was when it was taken. */
+    PHYSFS_sint64 archiveModtime;
+    PHYSFS_uint32 indexMode;    /* INDEX_* value from physfs.c.            */
+    PHYSFS_uint32 numEntries;
+    PHYSFS_uint32 numBuckets;   /* always a power of two.                  */
+    PHYSFS_uint32 pathLen;      /* lengths of the strings, with nulls.     */
+    PHYSFS_uint32 extLen;
+    PHYSFS_uint32 namesLen;
+} SnapshotHeader;
+
+typedef struct
+{
+    PHYSFS_sint64 filesize;
+    PHYSFS_sint64 modtime;
+    PHYSFS_sint64 createtime;
+    PHYSFS_sint64 accesstime;
+    PHYSFS_uint32 name;         /* offset of its full path in the names.   */
+    PHYSFS_uint32 hash;
+    PHYSFS_uint32 hashNext;     /* index + 1 of the next in its bucket.    */
+    PHYSFS_uint32 firstChild;   /* index + 1, or zero.                     */
+    PHYSFS_uint32 nextSibling;  /* index + 1, or zero.                     */
+    PHYSFS_uint32 filetype;
+    PHYSFS_uint32 readonly;
+    PHYSFS_uint32 unused;       /* keeps this a multiple of eight bytes.   */
+} SnapshotEntry;
+
+/* physfs.c's INDEX_* values, which is all a snapshot needs to know. */
+#define SNAPSHOT_INDEX_NONE 0
+#define SNAPSHOT_INDEX_NOCASE_ASCII 2
+
+typedef struct
+{
+    const void *data;           /* the whole file, after the header.       */
+    void *mapping;              /* what (data) is in, if it's mapped.      */
+    const SnapshotEntry *entries;
+    PHYSFS_uint32 numEntries;
+    const PHYSFS_uint32 *buckets;
+    PHYSFS_uint32 numBuckets;
+    const char *names;
+    const char *path;           /* the archive, platform-dependent.        */
+    int nocase;                 /* names match like stricmpASCII().        */
+    int authoritative;          /* not found here means not there at all.  */
+    const PHYSFS_Archiver *funcs;
+    void *opaque;               /* the real archive, once it's opened.     */
+    void *lock;                 /* protects opaque.                        */
+    __PHYSFS_MemAccount *mem;   /* the mount's, which (opaque) charges.    */
+    PHYSFS_uint64 datalen;      /* bytes of heap charged as its index.     */
+} SnapshotInfo;
+
+
+/* ASCII case is folded, so one hash works for either way of matching. */
+static PHYSFS_uint32 snapshotHash(const char *path)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (*path)
+    {
+        PHYSFS_uint8 ch = (PHYSFS_uint8) *path++;
+        if ((ch >= 'A') && (ch <= 'Z'))
+            ch += 'a' - 'A';
+        hash = ((hash << 5) + hash) ^ ((PHYSFS_uint32) ch);
+    } /* while */
+    return hash;
+} /* snapshotHash */
+
+
+static const SnapshotEntry *snapshotFind(const SnapshotEntry *entries,
+                                         const PHYSFS_uint32 numEntries,
+                                         const PHYSFS_uint32 *buckets,
+                                         const PHYSFS_uint32 numBuckets,
+                                         const char *names, const int nocase,
+                                         const char *path)
+{
+    const PHYSFS_uint32 hash = snapshotHash(path);
+    PHYSFS_uint32 i = buckets[hash & (numBuckets - 1)];
+    PHYSFS_uint32 steps;
+
+    /* bounded, so a damaged chain can't go around in circles. */
+    for (steps = 0; (i != 0) && (steps < numEntries); steps++)
+    {
+        const SnapshotEntry *entry = &entries[i - 1];
+        const char *name = names + entry->name;
+        if ((entry->hash == hash) &&
+            ((nocase) ? (__PHYSFS_stricmpASCII(name, path) == 0)
+                      : (strcmp(name, path) == 0)))
+            return entry;
+        i = entry->hashNext;
+    } /* for */
+
+    return NULL;
+} /* snapshotFind */
+
+
+static const SnapshotEntry *snapshotLookup(const SnapshotInfo *info,
+                                           const char *path)
+{
+    return snapshotFind(info->entries, info->numEntries, info->buckets,
+                        info->numBuckets, info->names, info->nocase, path);
+} /* snapshotLookup */
+
+
+static const char *snapshotBaseName(const char *path)
+{
+    const char *ptr = strrchr(path, '/');
+    return ptr ? ptr + 1 : path;
+} /* snapshotBaseName */
+
+
+/* Open the real archive, if it isn't already, and hand back its opaque. */
+static void *snapshotArchive(SnapshotInfo *info)
+{
+    void *retval;
+
+    __PHYSFS_platformGrabMutex(info->lock);
+    if (info->opaque == NULL)
+    {
+        PHYSFS_Io *io = __PHYSFS_createArchiveIo(info->path);
+        if (io != NULL)
+        {
+            __PHYSFS_MemAccount *prevMem;
+            prevMem = __PHYSFS_memSetMountAccount(info->mem);
+            info->opaque = info->funcs->openArchive(io, info->path, 0);
+            __PHYSFS_memSetMountAccount(prevMem);
+            if (info->opaque == NULL)
+                io->destroy(io);
+        } /* if */
+    } /* if */
+    retval = info->opaque;
+    __PHYSFS_platformReleaseMutex(info->lock);
+
+    return retval;
+} /* snapshotArchive */
+
+
+static int snapshotWriteFile(const char *fname, const void *buf,
+                             const PHYSFS_uint64 len)
+{
+    const size_t tmplen = strlen(fname) + sizeof (SNAPSHOT_TMP_EXTENSION);
+    char *tmp = (char *) __PHYSFS_smallAlloc(tmplen);
+    PHYSFS_Io *io = NULL;
+    int retval = 0;
+
+    BAIL_IF_MACRO(!tmp, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    strcpy(tmp, fname);
+    strcat(tmp, SNAPSHOT_TMP_EXTENSION);
+
+    /* write it aside and rename it over, so nobody reads half of one. */
+    io = __PHYSFS_createNativeIo(tmp, 'w');
+    if (io != NULL)
+    {
+        retval = ((io->write(io, buf, len) == (PHYSFS_sint64) len) &&
+                  (io->flush(io)));
+        io->destroy(io);
+        if (retval)
+            retval = __PHYSFS_platformRename(tmp, fname);
+        if (!retval)
+            __PHYSFS_platformDelete(tmp);
+    } /* if */
+
+    __PHYSFS_smallFree(tmp);
+    return retval;
+} /* snapshotWriteFile */
+
+
+int __PHYSFS_saveIndexSnapshot(const char *fname, const char *path,
+                               const PHYSFS_Stat *st,
+                               const PHYSFS_Archiver *funcs, void *opaque,
+                               const int indexMode)
+{
+    const size_t pathLen = strlen(path) + 1;
+    const size_t extLen = strlen(funcs->info.extension) + 1;
+    __PHYSFS_ArchiveListing list;
+    SnapshotHeader *header;
+    SnapshotEntry *entries;
+    PHYSFS_uint32 *buckets;
+    PHYSFS_uint32 numEntries;
+    PHYSFS_uint32 numBuckets = 1;
+    PHYSFS_uint64 namesLen = 1;  /* the root's "". */
+    PHYSFS_uint64 total;
+    char *names;
+    char *ptr;
+    PHYSFS_uint8 *buf = NULL;
+    int retval = 0;
+    size_t i;
+
+    GOTO_IF_MACRO(!__PHYSFS_listArchive(funcs, opaque, &list),
+                  ERRPASS, saveSnapshotFailed);
+    GOTO_IF_MACRO(((PHYSFS_uint64) list.count) >= 0xFFFFFFFF,
+                  PHYSFS_ERR_UNSUPPORTED, saveSnapshotFailed);
+
+    numEntries = (PHYSFS_uint32) (list.count + 1);
+    while ((numBuckets < numEntries) && (numBuckets < 0x80000000))
+        numBuckets <<= 1;
+    for (i = 0; i < list.count; i++)
+        namesLen += strlen(list.paths[i]) + 1;
+
+    total = sizeof (SnapshotHeader) +
+            (((PHYSFS_uint64) numEntries) * sizeof (SnapshotEntry)) +
+            (((PHYSFS_uint64) numBuckets) * sizeof (PHYSFS_uint32)) +
+            pathLen + extLen + namesLen;
+    GOTO_IF_MACRO(namesLen > 0xFFFFFFFF, PHYSFS_ERR_UNSUPPORTED,
+                  saveSnapshotFailed);
+    GOTO_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(total),
+                  PHYSFS_ERR_OUT_OF_MEMORY, saveSnapshotFailed);
+    buf = (PHYSFS_uint8 *) allocator.Malloc((size_t) total);
+    GOTO_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, saveSnapshotFailed);
+    memset(buf, '\0', (size_t) total);
+
+    header = (SnapshotHeader *) buf;
+    entries = (SnapshotEntry *) (header + 1);
+    buckets = (PHYSFS_uint32 *) (entries + numEntries);
+    ptr = (char *) (buckets + numBuckets);
+    memcpy(ptr, path, pathLen);
+    memcpy(ptr + pathLen, funcs->info.extension, extLen);
+    names = ptr + pathLen + extLen;
+
+    header->sig = SNAPSHOT_SIG;
+    header->version = SNAPSHOT_VERSION;
+    header->headerSize = sizeof (SnapshotHeader);
+    header->entrySize = sizeof (SnapshotEntry);
+    header->archiveSize = st->filesize;
+    header->archiveModtime = st->modtime;
+    header->indexMode = (PHYSFS_uint32) indexMode;
+    header->numEntries = numEntries;
+    header->numBuckets = numBuckets;
+    header->pathLen = (PHYSFS_uint32) pathLen;
+    header->extLen = (PHYSFS_uint32) extLen;
+    header->namesLen = (PHYSFS_uint32) namesLen;
+
+    entries[0].filetype = PHYSFS_FILETYPE_DIRECTORY;
+    entries[0].modtime = entries[0].createtime = entries[0].accesstime = -1;
+    entries[0].readonly = 1;
+    entries[0].hash = snapshotHash("");
+    buckets[entries[0].hash & (numBuckets - 1)] = 1;
+
+    ptr = names + 1;
+    for (i = 0; i < list.count; i++)
+    {
+        SnapshotEntry *entry = &entries[i + 1];
+        const PHYSFS_Stat *stat = &list.stats[i];
+        const size_t len = strlen(list.paths[i]) + 1;
+        PHYSFS_uint32 *bucket;
+
+        memcpy(ptr, list.paths[i], len);
+        entry->name = (PHYSFS_uint32) (ptr - names);
+        ptr += len;
+
+        entry->filesize = stat->filesize;
+        entry->modtime = stat->modtime;
+        entry->createtime = stat->createtime;
+        entry->accesstime = stat->accesstime;
+        entry->filetype = (PHYSFS_uint32) stat->filetype;
+        entry->readonly = (PHYSFS_uint32) stat->readonly;
+        entry->hash = snapshotHash(list.paths[i]);
+
+        bucket = &buckets[entry->hash & (numBuckets - 1)];
+        entry->hashNext = *bucket;
+        *bucket = (PHYSFS_uint32) (i + 2);
+    } /* for */
+
+    /* backwards, so each directory lists its children in the same order. */
+    for (i = list.count; i > 0; i--)
+    {
+        SnapshotEntry *entry = &entries[i];
+        char *name = names + entry->name;
+        char *slash = strrchr(name, '/');
+        const SnapshotEntry *found;
+
+        if (slash != NULL)
+            *slash = '\0';  /* chop it to its parent, just for a moment. */
+        found = snapshotFind(entries, numEntries, buckets, numBuckets, names,
+                             0, (slash != NULL) ? name : "");
+        if (slash != NULL)
+            *slash = '/';
+
+        if (found != NULL)  /* it listed its parent, so this can't fail. */
+        {
+            SnapshotEntry *parent = &entries[found - entries];
+            entry->nextSibling = parent->firstChild;
+            parent->firstChild = (PHYSFS_uint32) i + 1;
+        } /* if */
+    } /* for */
+
+    retval = snapshotWriteFile(fname, buf, total);
+
+saveSnapshotFailed:
+    __PHYSFS_freeArchiveListing(&list);
+    allocator.Free(buf);
+    return retval;
+} /* __PHYSFS_saveIndexSnapshot */
+
+
+/* Make sure nothing in a loaded snapshot points outside of it. */
+static int snapshotValid(const SnapshotInfo *info, const PHYSFS_uint32 len)
+{
+    const PHYSFS_uint32 count = info->numEntries;
+    PHYSFS_uint32 i;
+
+    if ((len == 0) || (info->names[len - 1] != '\0'))
+        return 0;
+    else if (info->entries[0].filetype != PHYSFS_FILETYPE_DIRECTORY)
+        return 0;
+
+    for (i = 0; i < info->numBuckets; i++)
+    {
+        if (info->buckets[i] > count)
+            return 0;
+    } /* for */
+
+    for (i = 0; i < count; i++)
+    {
+        const SnapshotEntry *entry = &info->entries[i];
+        if ((entry->name >= len) || (entry->hashNext > count) ||
+            (entry->firstChild > count) || (entry->nextSibling > count))
+            return 0;
+    } /* for */
+
+    return 1;
+} /* snapshotValid */
+
+
+/*
+ * Map (fname) if the platform can, or read it into the heap if not. Either
+ *  way, (*data) is the whole file, and (*len) its size.
+ */
+static int snapshotLoadFile(const char *fname, const void **data,
+                            PHYSFS_uint64 *len, void **mapping)
+{
+    PHYSFS_Io *io;
+    PHYSFS_sint64 filelen;
+    void *buf;
+
+    *mapping = __PHYSFS_platformMapFile(fname, data, len);
+    if (*mapping != NULL)
+        return 1;
+
+    io = __PHYSFS_createNativeIo(fname, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    filelen = io->length(io);
+    if (filelen < 0)
+    {
+        io->destroy(io);
+        return 0;
+    } /* if */
+    else if ((filelen < (PHYSFS_sint64) sizeof (SnapshotHeader)) ||
+             (!__PHYSFS_ui64FitsAddressSpace((PHYSFS_uint64) filelen)))
+    {
+        io->destroy(io);
+        BAIL_MACRO(PHYSFS_ERR_CORRUPT, 0);
+    } /* else if */
+
+    buf = allocator.Malloc((size_t) filelen);
+    if (buf == NULL)
+    {
+        io->destroy(io);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+
+    if (!__PHYSFS_readAll(io, buf, (PHYSFS_uint64) filelen))
+    {
+        io->destroy(io);
+        allocator.Free(buf);
+        return 0;
+    } /* if */
+
+    io->destroy(io);
+    *data = buf;
+    *len = (PHYSFS_uint64) filelen;
+    return 1;
+} /* snapshotLoadFile */
+
+
+static void snapshotFreeFile(SnapshotInfo *info)
+{
+    if (info->mapping != NULL)
+        __PHYSFS_platformUnmapFile(info->mapping);
+    else if (info->data != NULL)  /* it's just after the header. */
+    {
+        const SnapshotHeader *header = ((const SnapshotHeader *) info->data);
+        allocator.Free((void *) (header - 1));
+    } /* else if */
+} /* snapshotFreeFile */
+
+
+void *__PHYSFS_loadIndexSnapshot(const char *fname, const char *path,
+                                 const PHYSFS_Stat *st,
+                                 const PHYSFS_Archiver **archivers,
+                                 const PHYSFS_Archiver **funcs)
+{
+    SnapshotInfo *info = NULL;
+    const SnapshotHeader *header;
+    const void *file = NULL;
+    void *mapping = NULL;
+    PHYSFS_uint64 filelen;
+    PHYSFS_uint64 len;
+    const char *ptr;
+
+    BAIL_IF_MACRO(!snapshotLoadFile(fname, &file, &filelen, &mapping),
+                  ERRPASS, NULL);
+
+    info = (SnapshotInfo *) allocator.Malloc(sizeof (SnapshotInfo));
+    if (info == NULL)
+    {
+        if (mapping != NULL)
+            __PHYSFS_platformUnmapFile(mapping);
+        else
+            allocator.Free((void *) file);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+    memset(info, '\0', sizeof (SnapshotInfo));
+    header = (const SnapshotHeader *) file;
+    info->data = header + 1;
+    info->mapping = mapping;
+
+    /* only a snapshot this build took of this very file will do. */
+    GOTO_IF_MACRO(filelen < sizeof (SnapshotHeader), PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO(header->sig != SNAPSHOT_SIG, PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO(header->version != SNAPSHOT_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, loadSnapshotFailed);
+    GOTO_IF_MACRO(header->headerSize != sizeof (SnapshotHeader),
+                  PHYSFS_ERR_UNSUPPORTED, loadSnapshotFailed);
+    GOTO_IF_MACRO(header->entrySize != sizeof (SnapshotEntry),
+                  PHYSFS_ERR_UNSUPPORTED, loadSnapshotFailed);
+    GOTO_IF_MACRO(header->archiveSize != st->filesize, PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO(header->archiveModtime != st->modtime, PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO(header->pathLen != strlen(path) + 1, PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO((header->numEntries == 0) || (header->numBuckets == 0) ||
+                  (header->numBuckets & (header->numBuckets - 1)) ||
+                  (header->extLen == 0),
+                  PHYSFS_ERR_CORRUPT, loadSnapshotFailed);
+
+    len = (((PHYSFS_uint64) header->numEntries) * sizeof (SnapshotEntry)) +
+          (((PHYSFS_uint64) header->numBuckets) * sizeof (PHYSFS_uint32)) +
+          ((PHYSFS_uint64) header->pathLen) + header->extLen +
+          header->namesLen;
+    GOTO_IF_MACRO(filelen != sizeof (SnapshotHeader) + len,
+                  PHYSFS_ERR_CORRUPT, loadSnapshotFailed);
+
+    info->entries = (const SnapshotEntry *) info->data;
+    info->numEntries = header->numEntries;
+    info->buckets = (const PHYSFS_uint32 *) (info->entries +
+                                             header->numEntries);
+    info->numBuckets = header->numBuckets;
+    info->path = (const char *) (info->buckets + header->numBuckets);
+    ptr = info->path + header->pathLen;  /* the archiver's extension. */
+    info->names = ptr + header->extLen;
+    info->nocase = (header->indexMode == SNAPSHOT_INDEX_NOCASE_ASCII);
+    info->authoritative = (header->indexMode != SNAPSHOT_INDEX_NONE);
+
+    GOTO_IF_MACRO(memcmp(info->path, path, header->pathLen) != 0,
+                  PHYSFS_ERR_CORRUPT, loadSnapshotFailed);
+    GOTO_IF_MACRO(ptr[header->extLen - 1] != '\0', PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+    GOTO_IF_MACRO(!snapshotValid(info, header->namesLen), PHYSFS_ERR_CORRUPT,
+                  loadSnapshotFailed);
+
+    /* it has to be an archiver we still have. */
+    for (; (*archivers != NULL) && (info->funcs == NULL); archivers++)
+    {
+        if (strcmp((*archivers)->info.extension, ptr) == 0)
+            info->funcs = *archivers;
+    } /* for */
+    GOTO_IF_MACRO(!info->funcs, PHYSFS_ERR_UNSUPPORTED, loadSnapshotFailed);
+
+    info->lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!info->lock, ERRPASS, loadSnapshotFailed);
+
+    /* a mapped one is shared page cache, not this process's heap. */
+    info->mem = __PHYSFS_memMountAccount();
+    info->datalen = (mapping != NULL) ? 0 : filelen;
+    __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) info->datalen);
+
+    *funcs = info->funcs;
+    return info;
+
+loadSnapshotFailed:
+    snapshotFreeFile(info);
+    allocator.Free(info);
+    return NULL;
+} /* __PHYSFS_loadIndexSnapshot */
+
+
+static void *SNAPSHOT_openArchive(PHYSFS_Io *io, const char *name,
+                                  int forWriting)
+{
+    /* only physfs.c makes these, when it mounts an archive by path. */
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* SNAPSHOT_openArchive */
+
+
+static void SNAPSHOT_enumerateFiles(void *opaque, const char *dname,
+                                    PHYSFS_EnumFilesCallback cb,
+                                    const char *origdir, void *callbackdata)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *dir = snapshotLookup(info, dname);
+    PHYSFS_uint32 steps = 0;
+    PHYSFS_uint32 i;
+
+    if ((dir == NULL) && (!info->authoritative))
+    {
+        void *archive = snapshotArchive(info);
+        if (archive != NULL)
+            info->funcs->enumerateFiles(archive, dname, cb, origdir,
+                                        callbackdata);
+        return;
+    } /* if */
+
+    if ((dir == NULL) || (dir->filetype != PHYSFS_FILETYPE_DIRECTORY))
+        return;
+
+    for (i = dir->firstChild; (i != 0) && (steps < info->numEntries); steps++)
+    {
+        const SnapshotEntry *entry = &info->entries[i - 1];
+        cb(callbackdata, origdir, snapshotBaseName(info->names + entry->name));
+        i = entry->nextSibling;
+    } /* for */
+} /* SNAPSHOT_enumerateFiles */
+
+
+static void snapshotStat(const SnapshotEntry *entry, PHYSFS_Stat *stat)
+{
+    stat->filesize = entry->filesize;
+    stat->modtime = entry->modtime;
+    stat->createtime = entry->createtime;
+    stat->accesstime = entry->accesstime;
+    stat->filetype = (PHYSFS_FileType) entry->filetype;
+    stat->readonly = (int) entry->readonly;
+} /* snapshotStat */
+
+
+static void SNAPSHOT_enumerateFilesStat(void *opaque, const char *dname,
+                                        PHYSFS_EnumFilesStatCallback cb,
+                                        const char *origdir,
+                                        void *callbackdata)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *dir = snapshotLookup(info, dname);
+    PHYSFS_uint32 steps = 0;
+    PHYSFS_uint32 i;
+
+    if ((dir == NULL) && (!info->authoritative))
+    {
+        void *archive = snapshotArchive(info);
+        if ((archive != NULL) && (info->funcs->enumerateFilesStat != NULL))
+            info->funcs->enumerateFilesStat(archive, dname, cb, origdir,
+                                            callbackdata);
+        return;
+    } /* if */
+
+    if ((dir == NULL) || (dir->filetype != PHYSFS_FILETYPE_DIRECTORY))
+        return;
+
+    for (i = dir->firstChild; (i != 0) && (steps < info->numEntries); steps++)
+    {
+        const SnapshotEntry *entry = &info->entries[i - 1];
+        PHYSFS_Stat stat;
+        snapshotStat(entry, &stat);
+        cb(callbackdata, origdir, snapshotBaseName(info->names + entry->name),
+           &stat);
+        i = entry->nextSibling;
+    } /* for */
+} /* SNAPSHOT_enumerateFilesStat */
+
+
+static PHYSFS_Io *SNAPSHOT_openRead(void *opaque, const char *fnm)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *entry = snapshotLookup(info, fnm);
+    void *archive;
+
+    if (entry != NULL)
+    {
+        BAIL_IF_MACRO(entry->filetype == PHYSFS_FILETYPE_DIRECTORY,
+                      PHYSFS_ERR_NOT_A_FILE, NULL);
+    } /* if */
+    else
+    {
+        BAIL_IF_MACRO(info->authoritative, PHYSFS_ERR_NOT_FOUND, NULL);
+    } /* else */
+
+    archive = snapshotArchive(info);
+    BAIL_IF_MACRO(!archive, ERRPASS, NULL);
+    return info->funcs->openRead(archive, fnm);
+} /* SNAPSHOT_openRead */
+
+
+static PHYSFS_Io *SNAPSHOT_openWrite(void *opaque, const char *filename)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* SNAPSHOT_openWrite */
+
+
+static PHYSFS_Io *SNAPSHOT_openAppend(void *opaque, const char *filename)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
+} /* SNAPSHOT_openAppend */
+
+
+static int SNAPSHOT_remove(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* SNAPSHOT_remove */
+
+
+static int SNAPSHOT_mkdir(void *opaque, const char *name)
+{
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
+} /* SNAPSHOT_mkdir */
+
+
+static int SNAPSHOT_stat(void *opaque, const char *filename,
+                         PHYSFS_Stat *stat)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *entry = snapshotLookup(info, filename);
+    void *archive;
+
+    if (entry != NULL)
+    {
+        snapshotStat(entry, stat);
+        return 1;
+    } /* if */
+
+    BAIL_IF_MACRO(info->authoritative, PHYSFS_ERR_NOT_FOUND, 0);
+    archive = snapshotArchive(info);
+    BAIL_IF_MACRO(!archive, ERRPASS, 0);
+    return info->funcs->stat(archive, filename, stat);
+} /* SNAPSHOT_stat */
+
+
+/* Snapshots don't keep checksums, so this opens the archive to ask it. */
+static int SNAPSHOT_checksum(void *opaque, const char *filename,
+                             PHYSFS_uint32 *crc)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *entry = snapshotLookup(info, filename);
+    void *archive;
+
+    if (entry != NULL)
+    {
+        BAIL_IF_MACRO(entry->filetype == PHYSFS_FILETYPE_DIRECTORY,
+                      PHYSFS_ERR_NOT_A_FILE, 0);
+    } /* if */
+    else
+    {
+        BAIL_IF_MACRO(info->authoritative, PHYSFS_ERR_NOT_FOUND, 0);
+    } /* else */
+
+    BAIL_IF_MACRO(!info->funcs->checksum, PHYSFS_ERR_UNSUPPORTED, 0);
+    archive = snapshotArchive(info);
+    BAIL_IF_MACRO(!archive, ERRPASS, 0);
+    return info->funcs->checksum(archive, filename, crc);
+} /* SNAPSHOT_checksum */
+
+
+/* Nor where things are, so this opens the archive to ask it that, too. */
+static int SNAPSHOT_layout(void *opaque, const char *filename,
+                           PHYSFS_EntryLayout *layout)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    const SnapshotEntry *entry = snapshotLookup(info, filename);
+    void *archive;
+
+    if (entry != NULL)
+    {
+        BAIL_IF_MACRO(entry->filetype == PHYSFS_FILETYPE_DIRECTORY,
+                      PHYSFS_ERR_NOT_A_FILE, 0);
+    } /* if */
+    else
+    {
+        BAIL_IF_MACRO(info->authoritative, PHYSFS_ERR_NOT_FOUND, 0);
+    } /* else */
+
+    BAIL_IF_MACRO(!info->funcs->layout, PHYSFS_ERR_UNSUPPORTED, 0);
+    archive = snapshotArchive(info);
+    BAIL_IF_MACRO(!archive, ERRPASS, 0);
+    return info->funcs->layout(archive, filename, layout);
+} /* SNAPSHOT_layout */
+
+
+static void SNAPSHOT_closeArchive(void *opaque)
+{
+    SnapshotInfo *info = (SnapshotInfo *) opaque;
+    if (info->opaque != NULL)
+        info->funcs->closeArchive(info->opaque);
+    __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) info->datalen));
+    __PHYSFS_platformDestroyMutex(info->lock);
+    snapshotFreeFile(info);
+    allocator.Free(info);
+} /* SNAPSHOT_closeArchive */
+
+
+const PHYSFS_Archiver __PHYSFS_Archiver_SNAPSHOT =
+{
+    CURRENT_PHYSFS_ARCHIVER_API_VERSION,
+    {
+        "",
+        "Index snapshot of an archive that hasn't been opened yet",
+        "agent <agent@local>",
+        "https://icculus.org/physfs/",
+        0,  /* supportsSymlinks */
+    },
+    SNAPSHOT_openArchive,
+    SNAPSHOT_enumerateFiles,
+    SNAPSHOT_openRead,
+    SNAPSHOT_openWrite,
+    SNAPSHOT_openAppend,
+    SNAPSHOT_remove,
+    SNAPSHOT_mkdir,
+    SNAPSHOT_stat,
+    SNAPSHOT_closeArchive,
+    SNAPSHOT_enumerateFilesStat,
+    NULL,  /* claim */
+    NULL,  /* enumerateFilesPrefix */
+    SNAPSHOT_checksum,
+    SNAPSHOT_layout
+};
+
+/* end of archiver_snapshot.c ... */
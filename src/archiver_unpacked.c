@@ -18,17 +18,37 @@
 #define __PHYSICSFS_INTERNAL__
 #include "physfs_internal.h"
 
+/*
+ * Entries are sorted by name, so everything under a directory is one span
+ *  of them. Directories are found from the entry names when the archive is
+ *  opened; the root is dirs[0].
+ */
+typedef struct
+{
+    const char *name;       /* points into entries[start].name.            */
+    PHYSFS_uint32 nameLen;  /* bytes of (name) that are this dir's path.    */
+    PHYSFS_uint32 start;    /* first entry under this dir.                  */
+    PHYSFS_uint32 end;      /* one past the last entry under this dir.      */
+    PHYSFS_uint32 children; /* dirs index + 1 of first subdir, 0 if none.   */
+    PHYSFS_uint32 sibling;  /* dirs index + 1 of next subdir, 0 if none.    */
+} UNPKdir;
+
 typedef struct
 {
     PHYSFS_Io *io;
     PHYSFS_uint32 entryCount;
     UNPKentry *entries;
+    PHYSFS_uint32 dirCount;
+    UNPKdir *dirs;
+    __PHYSFS_HashTable hash;  /* entries as index + 1, dirs after them.    */
+    __PHYSFS_MemAccount *mem;  /* the mount's, for memory accounting.     */
+    PHYSFS_uint64 indexCharged;  /* PHYSFS_MEMORY_INDEX charged to (mem).  */
 } UNPKinfo;
 
 
 typedef struct
 {
-    PHYSFS_Io *io;
+    PHYSFS_Io *io;  /* the archive's own; shared by every open file. */
     UNPKentry *entry;
     PHYSFS_uint32 curPos;
 } UNPKfileinfo;
@@ -38,6 +58,12 @@ void UNPK_closeArchive(void *opaque)
 {
     UNPKinfo *info = ((UNPKinfo *) opaque);
     info->io->destroy(info->io);
+    if (__PHYSFS_isFastDeinit())
+        return;  /* the process is exiting; leave the index to the OS. */
+    __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) info->indexCharged));
+    __PHYSFS_hashTableDeinit(&info->hash);
+    allocator.Free(info->dirs);
     allocator.Free(info->entries);
     allocator.Free(info);
 } /* UNPK_closeArchive */
@@ -53,7 +79,8 @@ static PHYSFS_sint64 UNPK_read(PHYSFS_Io *io, void *buffer, PHYSFS_uint64 len)
     if (bytesLeft < len)
         len = bytesLeft;
 
-    rc = finfo->io->read(finfo->io, buffer, len);
+    rc = __PHYSFS_ioReadAt(finfo->io, buffer, len,
+                           ((PHYSFS_uint64) entry->startPos) + finfo->curPos);
     if (rc > 0)
         finfo->curPos += (PHYSFS_uint32) rc;
 
@@ -61,6 +88,22 @@ static PHYSFS_sint64 UNPK_read(PHYSFS_Io *io, void *buffer, PHYSFS_uint64 len)
 } /* UNPK_read */
 
 
+static PHYSFS_sint64 UNPK_readAt(PHYSFS_Io *io, void *buffer,
+                                 PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    const UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
+    const UNPKentry *entry = finfo->entry;
+
+    if (offset >= entry->size)
+        return 0;
+
+    if (len > entry->size - offset)
+        len = entry->size - offset;
+
+    return __PHYSFS_ioReadAt(finfo->io, buffer, len, entry->startPos + offset);
+} /* UNPK_readAt */
+
+
 static PHYSFS_sint64 UNPK_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 {
     BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
@@ -77,14 +120,12 @@ static int UNPK_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 {
     UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
     const UNPKentry *entry = finfo->entry;
-    int rc;
 
     BAIL_IF_MACRO(offset >= entry->size, PHYSFS_ERR_PAST_EOF, 0);
-    rc = finfo->io->seek(finfo->io, entry->startPos + offset);
-    if (rc)
-        finfo->curPos = (PHYSFS_uint32) offset;
 
-    return rc;
+    /* reads say where they want to be, so the archive's Io never moves. */
+    finfo->curPos = (PHYSFS_uint32) offset;
+    return 1;
 } /* UNPK_seek */
 
 
@@ -98,15 +139,12 @@ static PHYSFS_sint64 UNPK_length(PHYSFS_Io *io)
 static PHYSFS_Io *UNPK_duplicate(PHYSFS_Io *_io)
 {
     UNPKfileinfo *origfinfo = (UNPKfileinfo *) _io->opaque;
-    PHYSFS_Io *io = NULL;
-    PHYSFS_Io *retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    UNPKfileinfo *finfo = (UNPKfileinfo *) allocator.Malloc(sizeof (UNPKfileinfo));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, UNPK_duplicate_failed);
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, UNPK_duplicate_failed);
-
-    io = origfinfo->io->duplicate(origfinfo->io);
-    if (!io) goto UNPK_duplicate_failed;
-    finfo->io = io;
+    PHYSFS_Io *retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    UNPKfileinfo *finfo = (UNPKfileinfo *) __PHYSFS_poolAlloc(sizeof (UNPKfileinfo));
+    GOTO_IF_MACRO(!retval, ERRPASS, UNPK_duplicate_failed);
+    GOTO_IF_MACRO(!finfo, ERRPASS, UNPK_duplicate_failed);
+
+    finfo->io = origfinfo->io;
     finfo->entry = origfinfo->entry;
     finfo->curPos = 0;
     memcpy(retval, _io, sizeof (PHYSFS_Io));
@@ -114,9 +152,8 @@ static PHYSFS_Io *UNPK_duplicate(PHYSFS_Io *_io)
     return retval;
 
 UNPK_duplicate_failed:
-    if (finfo != NULL) allocator.Free(finfo);
-    if (retval != NULL) allocator.Free(retval);
-    if (io != NULL) io->destroy(io);
+    __PHYSFS_poolFree(finfo, sizeof (UNPKfileinfo));
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
     return NULL;
 } /* UNPK_duplicate */
 
@@ -124,13 +161,82 @@ static int UNPK_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
 
 static void UNPK_destroy(PHYSFS_Io *io)
 {
-    UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
-    finfo->io->destroy(finfo->io);
-    allocator.Free(finfo);
-    allocator.Free(io);
+    __PHYSFS_poolFree(io->opaque, sizeof (UNPKfileinfo));
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
 } /* UNPK_destroy */
 
 
+static int UNPK_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    const UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
+    const UNPKentry *entry = finfo->entry;
+    const PHYSFS_uint8 *archptr = NULL;
+    PHYSFS_uint64 archlen = 0;
+
+    /* entries are stored raw, so we only need the archive to be mapped. */
+    if (!__PHYSFS_ioMap(finfo->io, (const void **) &archptr, &archlen))
+        return 0;
+
+    BAIL_IF_MACRO(((PHYSFS_uint64) entry->startPos) + entry->size > archlen,
+                  PHYSFS_ERR_CORRUPT, 0);
+
+    *ptr = archptr + entry->startPos;
+    *len = entry->size;
+    return 1;
+} /* UNPK_map */
+
+
+static int UNPK_advise(PHYSFS_Io *io, PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                       int hint)
+{
+    const UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
+    const UNPKentry *entry = finfo->entry;
+
+    /* entries are stored raw, so just move the range to where it lives. */
+    if (offset >= entry->size)
+        return 1;  /* nothing there to hint about. */
+    else if ((len == 0) || (len > entry->size - offset))
+        len = entry->size - offset;
+    return __PHYSFS_ioAdvise(finfo->io, entry->startPos + offset, len, hint);
+} /* UNPK_advise */
+
+
+static int UNPK_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    const UNPKfileinfo *finfo = (UNPKfileinfo *) io->opaque;
+    const UNPKentry *entry = finfo->entry;
+
+    /* entries are stored raw, so they're wherever the archive is. */
+    if (!__PHYSFS_ioBacking(finfo->io, backing))
+        return 0;
+
+    BAIL_IF_MACRO(((PHYSFS_uint64) entry->startPos) + entry->size >
+                  backing->length, PHYSFS_ERR_CORRUPT, 0);
+
+    backing->offset += entry->startPos;
+    backing->length = entry->size;
+    return 1;
+} /* UNPK_backing */
+
+
+int __PHYSFS_unpkGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                               PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                               PHYSFS_uint64 *len)
+{
+    const UNPKfileinfo *finfo;
+
+    if (io->read != UNPK_read)
+        return 0;
+
+    finfo = (const UNPKfileinfo *) io->opaque;
+    *archive = finfo->io;  /* every file in an archive shares it. */
+    *src = finfo->io;
+    *pos = finfo->entry->startPos;
+    *len = finfo->entry->size;
+    return 1;
+} /* __PHYSFS_unpkGetStoredSpan */
+
+
 static const PHYSFS_Io UNPK_Io =
 {
     CURRENT_PHYSFS_IO_API_VERSION, NULL,
@@ -141,7 +247,12 @@ static const PHYSFS_Io UNPK_Io =
     UNPK_length,
     UNPK_duplicate,
     UNPK_flush,
-    UNPK_destroy
+    UNPK_destroy,
+    UNPK_map,
+    UNPK_readAt,
+    NULL,  /* readv */
+    UNPK_advise,
+    UNPK_backing
 };
 
 
@@ -171,57 +282,125 @@ static void entrySwap(void *_a, size_t one, size_t two)
 } /* entrySwap */
 
 
-static PHYSFS_sint32 findStartOfDir(UNPKinfo *info, const char *path,
-                                    int stop_on_first_find)
+/* For sorting an array of indices to entries, instead of the entries. */
+typedef struct
 {
-    PHYSFS_sint32 lo = 0;
-    PHYSFS_sint32 hi = (PHYSFS_sint32) (info->entryCount - 1);
-    PHYSFS_sint32 middle;
-    PHYSFS_uint32 dlen = (PHYSFS_uint32) strlen(path);
-    PHYSFS_sint32 retval = -1;
-    const char *name;
-    int rc;
+    const UNPKentry *entries;
+    PHYSFS_uint32 *order;
+} UNPKsortData;
 
-    if (*path == '\0')  /* root dir? */
-        return 0;
 
-    if ((dlen > 0) && (path[dlen - 1] == '/')) /* ignore trailing slash. */
-        dlen--;
+static int entryOrderCmp(void *_d, size_t one, size_t two)
+{
+    const UNPKsortData *d = (const UNPKsortData *) _d;
+    const UNPKentry *a = &d->entries[d->order[one]];
+    const UNPKentry *b = &d->entries[d->order[two]];
+    return __PHYSFS_stricmpASCII(a->name, b->name);
+} /* entryOrderCmp */
+
+
+static void entryOrderSwap(void *_d, size_t one, size_t two)
+{
+    UNPKsortData *d = (UNPKsortData *) _d;
+    const PHYSFS_uint32 tmp = d->order[one];
+    d->order[one] = d->order[two];
+    d->order[two] = tmp;
+} /* entryOrderSwap */
 
-    while (lo <= hi)
+
+/*
+ * Sort (e) by name. Entries are big, so this sorts indices and copies them
+ *  over in order once, which means a second array; if there isn't memory
+ *  for that, it sorts them in place. Returns the sorted array, and (e) is
+ *  either that or freed.
+ */
+static UNPKentry *sortEntries(UNPKentry *e, const PHYSFS_uint32 num)
+{
+    const size_t len = ((size_t) num) + 1;  /* +1 so it's never zero. */
+    UNPKentry *sorted = (UNPKentry *) allocator.Malloc(len * sizeof (*e));
+    UNPKsortData data;
+    PHYSFS_uint32 i;
+
+    data.entries = e;
+    data.order = (PHYSFS_uint32 *) allocator.Malloc(len * sizeof (i));
+    if ((sorted == NULL) || (data.order == NULL))
     {
-        middle = lo + ((hi - lo) / 2);
-        name = info->entries[middle].name;
-        rc = __PHYSFS_strnicmpASCII(path, name, dlen);
-        if (rc == 0)
-        {
-            char ch = name[dlen];
-            if (ch < '/') /* make sure this isn't just a substr match. */
-                rc = -1;
-            else if (ch > '/')
-                rc = 1;
-            else 
-            {
-                if (stop_on_first_find) /* Just checking dir's existance? */
-                    return middle;
+        allocator.Free(sorted);
+        allocator.Free(data.order);
+        __PHYSFS_sort(e, (size_t) num, entryCmp, entrySwap);
+        return e;
+    } /* if */
 
-                if (name[dlen + 1] == '\0') /* Skip initial dir entry. */
-                    return (middle + 1);
+    for (i = 0; i < num; i++)
+        data.order[i] = i;
+    __PHYSFS_sort(&data, (size_t) num, entryOrderCmp, entryOrderSwap);
+    for (i = 0; i < num; i++)
+        memcpy(&sorted[i], &e[data.order[i]], sizeof (UNPKentry));
 
-                /* there might be more entries earlier in the list. */
-                retval = middle;
-                hi = middle - 1;
-            } /* else */
-        } /* if */
+    allocator.Free(data.order);
+    allocator.Free(e);
+    return sorted;
+} /* sortEntries */
 
-        if (rc > 0)
-            lo = middle + 1;
+
+/* Like __PHYSFS_hashString(), but ASCII case-insensitive, as names are. */
+static PHYSFS_uint32 hashName(const char *name, PHYSFS_uint32 len)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (len--)
+    {
+        char ch = *(name++);
+        if ((ch >= 'A') && (ch <= 'Z'))
+            ch -= ('A' - 'a');
+        hash = ((hash << 5) + hash) ^ ((PHYSFS_uint32) (PHYSFS_uint8) ch);
+    } /* while */
+    return hash;
+} /* hashName */
+
+
+/*
+ * This will find the UNPKentry associated with a path in platform-independent
+ *  notation. Directories don't have UNPKentries associated with them, but 
+ *  (*dir) will be set to the directory if a dir was hit, or NULL otherwise.
+ */
+static UNPKentry *findEntry(const UNPKinfo *info, const char *path,
+                            const UNPKdir **dir)
+{
+    const PHYSFS_uint32 pathlen = (PHYSFS_uint32) strlen(path);
+    const PHYSFS_uint32 hashval = hashName(path, pathlen);
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 i;
+
+    *dir = NULL;
+
+    if (*path == '\0')  /* root dir? */
+    {
+        *dir = &info->dirs[0];
+        return NULL;
+    } /* if */
+
+    while ((i = __PHYSFS_hashTableFind(&info->hash, hashval, &probe)) != 0)
+    {
+        if (i <= info->entryCount)
+        {
+            UNPKentry *entry = &info->entries[i - 1];
+            if (__PHYSFS_stricmpASCII(entry->name, path) == 0)
+                return entry;
+        } /* if */
         else
-            hi = middle - 1;
+        {
+            const UNPKdir *d = &info->dirs[i - info->entryCount - 1];
+            if ((d->nameLen == pathlen) &&
+                (__PHYSFS_strnicmpASCII(d->name, path, pathlen) == 0))
+            {
+                *dir = d;
+                return NULL;
+            } /* if */
+        } /* else */
     } /* while */
 
-    return retval;
-} /* findStartOfDir */
+    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, NULL);
+} /* findEntry */
 
 
 /*
@@ -247,101 +426,170 @@ void UNPK_enumerateFiles(void *opaque, const char *dname,
                          const char *origdir, void *callbackdata)
 {
     UNPKinfo *info = ((UNPKinfo *) opaque);
-    PHYSFS_sint32 dlen, dlen_inc, max, i;
+    const UNPKdir *dir = NULL;
+    PHYSFS_uint32 prefixlen, child, i;
 
-    i = findStartOfDir(info, dname, 0);
-    if (i == -1)  /* no such directory. */
+    findEntry(info, dname, &dir);
+    if (dir == NULL)  /* no such directory. */
         return;
 
-    dlen = (PHYSFS_sint32) strlen(dname);
-    if ((dlen > 0) && (dname[dlen - 1] == '/')) /* ignore trailing slash. */
-        dlen--;
-
-    dlen_inc = ((dlen > 0) ? 1 : 0) + dlen;
-    max = (PHYSFS_sint32) info->entryCount;
-    while (i < max)
+    prefixlen = dir->nameLen ? dir->nameLen + 1 : 0;
+    child = dir->children;
+    i = dir->start;
+    while (i < dir->end)
     {
-        char *add;
-        char *ptr;
-        PHYSFS_sint32 ln;
-        char *e = info->entries[i].name;
-        if ((dlen) &&
-            ((__PHYSFS_strnicmpASCII(e, dname, dlen)) || (e[dlen] != '/')))
+        /* subdirs are spans of our span; step over them whole. */
+        if ((child != 0) && (info->dirs[child - 1].start == i))
         {
-            break;  /* past end of this dir; we're done. */
+            const UNPKdir *subdir = &info->dirs[child - 1];
+            doEnumCallback(cb, callbackdata, origdir, subdir->name + prefixlen,
+                           (PHYSFS_sint32) (subdir->nameLen - prefixlen));
+            i = subdir->end;
+            child = subdir->sibling;
         } /* if */
-
-        add = e + dlen_inc;
-        ptr = strchr(add, '/');
-        ln = (PHYSFS_sint32) ((ptr) ? ptr-add : strlen(add));
-        doEnumCallback(cb, callbackdata, origdir, add, ln);
-        ln += dlen_inc;  /* point past entry to children... */
-
-        /* increment counter and skip children of subdirs... */
-        while ((++i < max) && (ptr != NULL))
+        else
         {
-            char *e_new = info->entries[i].name;
-            if ((__PHYSFS_strnicmpASCII(e, e_new, ln) != 0) ||
-                (e_new[ln] != '/'))
-            {
-                break;
-            } /* if */
-        } /* while */
+            cb(callbackdata, origdir, info->entries[i].name + prefixlen);
+            i++;
+        } /* else */
     } /* while */
 } /* UNPK_enumerateFiles */
 
 
-/*
- * This will find the UNPKentry associated with a path in platform-independent
- *  notation. Directories don't have UNPKentries associated with them, but 
- *  (*isDir) will be set to non-zero if a dir was hit.
- */
-static UNPKentry *findEntry(const UNPKinfo *info, const char *path, int *isDir)
+void UNPK_enumerateFilesPrefix(void *opaque, const char *dname,
+                               const char *prefix,
+                               PHYSFS_EnumFilesCallback cb,
+                               const char *origdir, void *callbackdata)
 {
-    UNPKentry *a = info->entries;
-    PHYSFS_sint32 pathlen = (PHYSFS_sint32) strlen(path);
-    PHYSFS_sint32 lo = 0;
-    PHYSFS_sint32 hi = (PHYSFS_sint32) (info->entryCount - 1);
-    PHYSFS_sint32 middle;
-    const char *thispath = NULL;
-    int rc;
+    UNPKinfo *info = ((UNPKinfo *) opaque);
+    const UNPKdir *dir = NULL;
+    PHYSFS_uint32 prefixlen, keylen, child, lo, hi, i;
+    char *key;
 
-    while (lo <= hi)
-    {
-        middle = lo + ((hi - lo) / 2);
-        thispath = a[middle].name;
-        rc = __PHYSFS_strnicmpASCII(path, thispath, pathlen);
+    findEntry(info, dname, &dir);
+    if (dir == NULL)  /* no such directory. */
+        return;
+
+    /* every name in (dir) starting with (prefix) starts with this key. */
+    prefixlen = dir->nameLen ? dir->nameLen + 1 : 0;
+    keylen = prefixlen + (PHYSFS_uint32) strlen(prefix);
+    key = (char *) __PHYSFS_smallAlloc(keylen + 1);
+    if (key == NULL)
+        return;  /* oh well. */
 
-        if (rc > 0)
+    memcpy(key, dir->name, prefixlen);
+    strcpy(key + prefixlen, prefix);
+
+    /* entries are sorted, so the matches are one run; find its start. */
+    lo = dir->start;
+    hi = dir->end;
+    while (lo < hi)
+    {
+        const PHYSFS_uint32 middle = lo + ((hi - lo) / 2);
+        const char *name = info->entries[middle].name;
+        if (__PHYSFS_strnicmpASCII(name, key, keylen) < 0)
             lo = middle + 1;
+        else
+            hi = middle;
+    } /* while */
+
+    /*
+     * (prefix) has no '/', so a subdir's span is wholly inside the run or
+     *  wholly outside it; the ones before it are skipped here.
+     */
+    child = dir->children;
+    while ((child != 0) && (info->dirs[child - 1].start < lo))
+        child = info->dirs[child - 1].sibling;
+
+    /* then it's the same walk as UNPK_enumerateFiles(). */
+    i = lo;
+    while (i < dir->end)
+    {
+        if (__PHYSFS_strnicmpASCII(info->entries[i].name, key, keylen) != 0)
+            break;  /* past the run. */
+        else if ((child != 0) && (info->dirs[child - 1].start == i))
+        {
+            const UNPKdir *subdir = &info->dirs[child - 1];
+            doEnumCallback(cb, callbackdata, origdir, subdir->name + prefixlen,
+                           (PHYSFS_sint32) (subdir->nameLen - prefixlen));
+            i = subdir->end;
+            child = subdir->sibling;
+        } /* else if */
+        else
+        {
+            cb(callbackdata, origdir, info->entries[i].name + prefixlen);
+            i++;
+        } /* else */
+    } /* while */
+
+    __PHYSFS_smallFree(key);
+} /* UNPK_enumerateFilesPrefix */
+
+
+/* Fill in (stat) for (entry), or for a directory if (entry) is NULL. */
+static void fillStat(PHYSFS_Stat *stat, const UNPKentry *entry)
+{
+    if (entry == NULL)
+    {
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        stat->filesize = 0;
+    } /* if */
+    else
+    {
+        stat->filetype = PHYSFS_FILETYPE_REGULAR;
+        stat->filesize = entry->size;
+    } /* else */
+
+    stat->modtime = -1;
+    stat->createtime = -1;
+    stat->accesstime = -1;
+    stat->readonly = 1;
+} /* fillStat */
 
-        else if (rc < 0)
-            hi = middle - 1;
 
-        else /* substring match...might be dir or entry or nothing. */
+void UNPK_enumerateFilesStat(void *opaque, const char *dname,
+                             PHYSFS_EnumFilesStatCallback cb,
+                             const char *origdir, void *callbackdata)
+{
+    UNPKinfo *info = ((UNPKinfo *) opaque);
+    const UNPKdir *dir = NULL;
+    PHYSFS_uint32 prefixlen, child, i;
+    PHYSFS_Stat stat;
+
+    findEntry(info, dname, &dir);
+    if (dir == NULL)  /* no such directory. */
+        return;
+
+    /* same walk as UNPK_enumerateFiles(). */
+    prefixlen = dir->nameLen ? dir->nameLen + 1 : 0;
+    child = dir->children;
+    i = dir->start;
+    while (i < dir->end)
+    {
+        if ((child != 0) && (info->dirs[child - 1].start == i))
         {
-            if (isDir != NULL)
+            const UNPKdir *subdir = &info->dirs[child - 1];
+            const PHYSFS_uint32 len = subdir->nameLen - prefixlen;
+            char *name = (char *) __PHYSFS_smallAlloc(len + 1);
+            if (name != NULL)
             {
-                *isDir = (thispath[pathlen] == '/');
-                if (*isDir)
-                    return NULL;
+                memcpy(name, subdir->name + prefixlen, len);
+                name[len] = '\0';
+                fillStat(&stat, NULL);
+                cb(callbackdata, origdir, name, &stat);
+                __PHYSFS_smallFree(name);
             } /* if */
-
-            if (thispath[pathlen] == '\0') /* found entry? */
-                return &a[middle];
-            /* adjust search params, try again. */
-            else if (thispath[pathlen] > '/')
-                hi = middle - 1;
-            else
-                lo = middle + 1;
+            i = subdir->end;
+            child = subdir->sibling;
         } /* if */
+        else
+        {
+            fillStat(&stat, &info->entries[i]);
+            cb(callbackdata, origdir, info->entries[i].name + prefixlen, &stat);
+            i++;
+        } /* else */
     } /* while */
-
-    if (isDir != NULL)
-        *isDir = 0;
-
-    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, NULL);
-} /* findEntry */
+} /* UNPK_enumerateFilesStat */
 
 
 PHYSFS_Io *UNPK_openRead(void *opaque, const char *name)
@@ -349,24 +597,20 @@ PHYSFS_Io *UNPK_openRead(void *opaque, const char *name)
     PHYSFS_Io *retval = NULL;
     UNPKinfo *info = (UNPKinfo *) opaque;
     UNPKfileinfo *finfo = NULL;
-    int isdir = 0;
-    UNPKentry *entry = findEntry(info, name, &isdir);
+    const UNPKdir *dir = NULL;
+    UNPKentry *entry = findEntry(info, name, &dir);
 
-    GOTO_IF_MACRO(isdir, PHYSFS_ERR_NOT_A_FILE, UNPK_openRead_failed);
+    GOTO_IF_MACRO(dir, PHYSFS_ERR_NOT_A_FILE, UNPK_openRead_failed);
     GOTO_IF_MACRO(!entry, ERRPASS, UNPK_openRead_failed);
 
-    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, UNPK_openRead_failed);
+    retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, ERRPASS, UNPK_openRead_failed);
 
-    finfo = (UNPKfileinfo *) allocator.Malloc(sizeof (UNPKfileinfo));
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, UNPK_openRead_failed);
-
-    finfo->io = info->io->duplicate(info->io);
-    GOTO_IF_MACRO(!finfo->io, ERRPASS, UNPK_openRead_failed);
-
-    if (!finfo->io->seek(finfo->io, entry->startPos))
-        goto UNPK_openRead_failed;
+    finfo = (UNPKfileinfo *) __PHYSFS_poolAlloc(sizeof (UNPKfileinfo));
+    GOTO_IF_MACRO(!finfo, ERRPASS, UNPK_openRead_failed);
 
+    /* no duplicate (and no new file descriptor); see UNPK_read(). */
+    finfo->io = info->io;
     finfo->curPos = 0;
     finfo->entry = entry;
 
@@ -375,16 +619,8 @@ PHYSFS_Io *UNPK_openRead(void *opaque, const char *name)
     return retval;
 
 UNPK_openRead_failed:
-    if (finfo != NULL)
-    {
-        if (finfo->io != NULL)
-            finfo->io->destroy(finfo->io);
-        allocator.Free(finfo);
-    } /* if */
-
-    if (retval != NULL)
-        allocator.Free(retval);
-
+    __PHYSFS_poolFree(finfo, sizeof (UNPKfileinfo));
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
     return NULL;
 } /* UNPK_openRead */
 
@@ -415,32 +651,167 @@ int UNPK_mkdir(void *opaque, const char *name)
 
 int UNPK_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
 {
-    int isDir = 0;
+    const UNPKdir *dir = NULL;
+    const UNPKinfo *info = (const UNPKinfo *) opaque;
+    const UNPKentry *entry = findEntry(info, filename, &dir);
+
+    if ((dir == NULL) && (entry == NULL))
+        return 0;
+
+    fillStat(stat, (dir != NULL) ? NULL : entry);
+    return 1;
+} /* UNPK_stat */
+
+
+int UNPK_layout(void *opaque, const char *filename,
+                PHYSFS_EntryLayout *layout)
+{
+    const UNPKdir *dir = NULL;
     const UNPKinfo *info = (const UNPKinfo *) opaque;
-    const UNPKentry *entry = findEntry(info, filename, &isDir);
+    const UNPKentry *entry = findEntry(info, filename, &dir);
+
+    BAIL_IF_MACRO(dir, PHYSFS_ERR_NOT_A_FILE, 0);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+
+    /* entries are stored raw, so that's all there is to it. */
+    layout->offset = entry->startPos;
+    layout->storedSize = layout->size = entry->size;
+    return 1;
+} /* UNPK_layout */
+
 
-    if (isDir)
+/* Add the dir (name), (len) bytes of it, starting at entry (start). */
+static PHYSFS_uint32 addDir(UNPKinfo *info, PHYSFS_uint32 *allocated,
+                            const char *name, const PHYSFS_uint32 len,
+                            const PHYSFS_uint32 start)
+{
+    UNPKdir *dir;
+
+    if (info->dirCount == *allocated)
     {
-        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
-        stat->filesize = 0;
+        const PHYSFS_uint32 count = *allocated * 2;
+        void *ptr;
+        BAIL_IF_MACRO(count <= *allocated, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        ptr = allocator.Realloc(info->dirs, count * sizeof (UNPKdir));
+        BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        info->dirs = (UNPKdir *) ptr;
+        *allocated = count;
     } /* if */
-    else if (entry != NULL)
+
+    if (len > 0)  /* root is never hashed; see findEntry(). */
     {
-        stat->filetype = PHYSFS_FILETYPE_REGULAR;
-        stat->filesize = entry->size;
-    } /* else if */
-    else
+        BAIL_IF_MACRO(!__PHYSFS_hashTableInsert(&info->hash,
+                        hashName(name, len),
+                        info->entryCount + info->dirCount + 1), ERRPASS, 0);
+    } /* if */
+
+    dir = &info->dirs[info->dirCount++];
+    dir->name = name;
+    dir->nameLen = len;
+    dir->start = start;
+    dir->end = info->entryCount;
+    dir->children = 0;
+    dir->sibling = 0;
+    return 1;
+} /* addDir */
+
+
+/*
+ * Hash every entry, and find every directory from the (sorted) names. We
+ *  walk down the list keeping the stack of dirs the current entry is in;
+ *  names are under 64 bytes, so it's never more than 32 deep.
+ */
+static int buildIndex(UNPKinfo *info)
+{
+    PHYSFS_uint32 stack[33];
+    PHYSFS_uint32 lastChild[33];
+    PHYSFS_uint32 depth = 1;
+    PHYSFS_uint32 allocated = 16;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!__PHYSFS_hashTableInit(&info->hash, info->entryCount),
+                  ERRPASS, 0);
+    info->dirs = (UNPKdir *) allocator.Malloc(allocated * sizeof (UNPKdir));
+    BAIL_IF_MACRO(!info->dirs, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    BAIL_IF_MACRO(!addDir(info, &allocated, "", 0, 0), ERRPASS, 0);
+    stack[0] = 0;
+    lastChild[0] = 0;
+
+    for (i = 0; i < info->entryCount; i++)
     {
-        return 0;
-    } /* else */
+        const char *name = info->entries[i].name;
+        const PHYSFS_uint32 namelen = (PHYSFS_uint32) strlen(name);
+        const char *ptr;
 
-    stat->modtime = -1;
-    stat->createtime = -1;
-    stat->accesstime = -1;
-    stat->readonly = 1;
+        BAIL_IF_MACRO(!__PHYSFS_hashTableInsert(&info->hash,
+                        hashName(name, namelen), i + 1), ERRPASS, 0);
+
+        /* close the dirs this entry isn't in. */
+        while (depth > 1)
+        {
+            UNPKdir *dir = &info->dirs[stack[depth - 1]];
+            if ((__PHYSFS_strnicmpASCII(name, dir->name, dir->nameLen) == 0) &&
+                (name[dir->nameLen] == '/'))
+                break;
+            dir->end = i;
+            depth--;
+        } /* while */
+
+        /* open the dirs it's in that we haven't seen yet. */
+        ptr = name + info->dirs[stack[depth - 1]].nameLen;
+        if (depth > 1)
+            ptr++;  /* skip the '/'. */
+
+        while ((ptr = strchr(ptr, '/')) != NULL)
+        {
+            const PHYSFS_uint32 d = info->dirCount;
+            const PHYSFS_uint32 parent = stack[depth - 1];
+            BAIL_IF_MACRO(depth >= 33, PHYSFS_ERR_CORRUPT, 0);
+            BAIL_IF_MACRO(!addDir(info, &allocated, name,
+                                  (PHYSFS_uint32) (ptr - name), i), ERRPASS, 0);
+
+            if (lastChild[depth - 1] == 0)
+                info->dirs[parent].children = d + 1;
+            else
+                info->dirs[lastChild[depth - 1] - 1].sibling = d + 1;
+            lastChild[depth - 1] = d + 1;
+
+            stack[depth] = d;
+            lastChild[depth] = 0;
+            depth++;
+            ptr++;
+        } /* while */
+    } /* for */
 
     return 1;
-} /* UNPK_stat */
+} /* buildIndex */
+
+
+void *UNPK_readTable(PHYSFS_Io *io, PHYSFS_uint32 count, PHYSFS_uint32 recLen)
+{
+    const PHYSFS_uint64 len = ((PHYSFS_uint64) count) * recLen;
+    const PHYSFS_sint64 iolen = io->length(io);
+    const PHYSFS_sint64 pos = io->tell(io);
+    void *retval;
+
+    /* a corrupt count shouldn't get to ask for gigabytes of memory. */
+    if ((iolen >= 0) && (pos >= 0))
+    {
+        const PHYSFS_uint64 avail = (PHYSFS_uint64) (iolen - pos);
+        BAIL_IF_MACRO(len > avail, PHYSFS_ERR_CORRUPT, NULL);
+    } /* if */
+    BAIL_IF_MACRO(len != (size_t) len, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+
+    retval = allocator.Malloc((size_t) (len ? len : 1));
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    if (!__PHYSFS_readAll(io, retval, len))
+    {
+        allocator.Free(retval);
+        return NULL;
+    } /* if */
+
+    return retval;
+} /* UNPK_readTable */
 
 
 void *UNPK_openArchive(PHYSFS_Io *io, UNPKentry *e, const PHYSFS_uint32 num)
@@ -452,11 +823,28 @@ void *UNPK_openArchive(PHYSFS_Io *io, UNPKentry *e, const PHYSFS_uint32 num)
         BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
     } /* if */
 
-    __PHYSFS_sort(e, (size_t) num, entryCmp, entrySwap);
+    e = sortEntries(e, num);
+    memset(info, '\0', sizeof (UNPKinfo));
     info->io = io;
     info->entryCount = num;
     info->entries = e;
 
+    if (!buildIndex(info))
+    {
+        __PHYSFS_hashTableDeinit(&info->hash);
+        allocator.Free(info->dirs);
+        allocator.Free(info->entries);
+        allocator.Free(info);
+        return NULL;
+    } /* if */
+
+    info->mem = __PHYSFS_memMountAccount();
+    info->indexCharged =
+        (((PHYSFS_uint64) info->entryCount) * sizeof (UNPKentry)) +
+        (((PHYSFS_uint64) info->dirCount) * sizeof (UNPKdir)) +
+        __PHYSFS_hashTableBytes(&info->hash);
+    __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) info->indexCharged);
     return info;
 } /* UNPK_openArchive */
 
@@ -52,30 +52,37 @@ static UNPKentry *wadLoadEntries(PHYSFS_Io *io, PHYSFS_uint32 fileCount)
     PHYSFS_uint32 directoryOffset;
     UNPKentry *entries = NULL;
     UNPKentry *entry = NULL;
+    PHYSFS_uint8 *table = NULL;
+    const PHYSFS_uint8 *rec = NULL;
 
     BAIL_IF_MACRO(!__PHYSFS_readAll(io, &directoryOffset, 4), ERRPASS, 0);
     directoryOffset = PHYSFS_swapULE32(directoryOffset);
 
     BAIL_IF_MACRO(!io->seek(io, directoryOffset), ERRPASS, 0);
 
+    table = (PHYSFS_uint8 *) UNPK_readTable(io, fileCount, 16);
+    BAIL_IF_MACRO(!table, ERRPASS, NULL);
+
     entries = (UNPKentry *) allocator.Malloc(sizeof (UNPKentry) * fileCount);
-    BAIL_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    GOTO_IF_MACRO(!entries, PHYSFS_ERR_OUT_OF_MEMORY, failed);
 
-    for (entry = entries; fileCount > 0; fileCount--, entry++)
+    for (entry = entries, rec = table; fileCount > 0; fileCount--, entry++)
     {
-        if (!__PHYSFS_readAll(io, &entry->startPos, 4)) goto failed;
-        if (!__PHYSFS_readAll(io, &entry->size, 4)) goto failed;
-        if (!__PHYSFS_readAll(io, &entry->name, 8)) goto failed;
+        memcpy(&entry->startPos, rec, 4);
+        memcpy(&entry->size, rec + 4, 4);
+        memcpy(entry->name, rec + 8, 8);
 
         entry->name[8] = '\0'; /* name might not be null-terminated in file. */
         entry->size = PHYSFS_swapULE32(entry->size);
         entry->startPos = PHYSFS_swapULE32(entry->startPos);
+        rec += 16;
     } /* for */
 
+    allocator.Free(table);
     return entries;
 
 failed:
-    allocator.Free(entries);
+    allocator.Free(table);
     return NULL;
 } /* wadLoadEntries */
 
@@ -102,6 +109,15 @@ static void *WAD_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
 } /* WAD_openArchive */
 
 
+static int WAD_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    return ((headLen >= 4) && ((memcmp(head, "IWAD", 4) == 0) ||
+                               (memcmp(head, "PWAD", 4) == 0)));
+} /* WAD_claim */
+
+
 const PHYSFS_Archiver __PHYSFS_Archiver_WAD =
 {
     CURRENT_PHYSFS_ARCHIVER_API_VERSION,
@@ -120,7 +136,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_WAD =
     UNPK_remove,
     UNPK_mkdir,
     UNPK_stat,
-    UNPK_closeArchive
+    UNPK_closeArchive,
+    UNPK_enumerateFilesStat,
+    WAD_claim,
+    UNPK_enumerateFilesPrefix,
+    NULL,  /* checksum */
+    UNPK_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_WAD */
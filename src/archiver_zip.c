@@ -15,7 +15,19 @@
 #include <errno.h>
 #include <time.h>
 
-#include "physfs_miniz.h"
+#include "physfs_inflate.h"
+
+#if PHYSFS_SUPPORTS_ZIP_ZSTD
+#include <zstd.h>
+#endif
+
+#if PHYSFS_SUPPORTS_ZIP_LZ4
+#include <lz4frame.h>
+#endif
+
+#if PHYSFS_SUPPORTS_ZIP_LIBDEFLATE
+#include <libdeflate.h>
+#endif
 
 /*
  * A buffer of ZIP_READBUFSIZE is allocated for each compressed file opened,
@@ -31,6 +43,34 @@
  */
 #define ZIP_READBUFSIZE   (16 * 1024)
 
+/*
+ * When a compressed file is closed, its buffer and inflater are kept for
+ *  the next one opened in the same archive, instead of being freed and
+ *  allocated again, up to this many per archive. Each one is about 60k.
+ *  They get their own lock, since files are closed with stateLock held,
+ *  and holding the ZIPinfo's rwlock can lead to taking stateLock.
+ */
+#define ZIP_SPARE_INFLATERS 8
+
+/*
+ * With PHYSFS_setResolveOnMount(), every entry's local header is checked
+ *  at mount, in archive order, reading ZIP_RESOLVE_WINDOW bytes at a time,
+ *  so small files packed together get many headers per read. Archives with
+ *  more than ZIP_RESOLVE_PER_THREAD files to check get split into runs
+ *  for up to ZIP_RESOLVE_THREADS threads, each reading its own part.
+ */
+#define ZIP_RESOLVE_WINDOW (64 * 1024)
+#define ZIP_RESOLVE_PER_THREAD 2048
+#define ZIP_RESOLVE_THREADS 4
+
+/*
+ * Central directories of at least twice ZIP_PARSE_PER_THREAD records are
+ *  split into runs for up to ZIP_PARSE_THREADS threads to parse at once.
+ *  Hashing them all into the table is still done on one, in order.
+ */
+#define ZIP_PARSE_PER_THREAD 8192
+#define ZIP_PARSE_THREADS 4
+
 
 /*
  * Entries are "unresolved" until they are first opened. At that time,
@@ -53,26 +93,72 @@ typedef enum
 
 
 /*
- * One ZIPentry is kept for each file in an open ZIP archive.
+ * A copy of an inflater partway through an entry, so ZIP_seek() can pick up
+ *  decompressing from here instead of from the start of the entry. These
+ *  are big (the inflater's 32k window is most of it), so they're only kept
+ *  every __PHYSFS_getSeekIndexInterval() bytes, or come from a seek index
+ *  file with (state) left NULL until they're needed.
+ */
+typedef struct
+{
+    PHYSFS_uint64 uncompressed_position;  /* tell() position here.        */
+    PHYSFS_uint64 compressed_position;    /* next compressed byte to use. */
+    void *state;                          /* the inflater at this point.  */
+} ZIPcheckpoint;
+
+/*
+ * Small compressed entries (up to a quarter of the
+ *  __PHYSFS_getDecompressionCacheSize() budget) are kept fully inflated in
+ *  a per-archive LRU list, so opening one again is a memoryIo duplicate
+ *  instead of a new z_stream and another inflate. The list holds one
+ *  reference to each memoryIo and open files hold the rest, so evicting
+ *  something that's still open just drops the list's reference.
+ */
+typedef struct _ZIPcached
+{
+    struct _ZIPentry *entry;   /* what this is the contents of. */
+    PHYSFS_Io *io;             /* memoryIo we hand out dups of. */
+    PHYSFS_uint64 len;         /* size of the inflated data.    */
+    struct _ZIPcached *prev;   /* more recently used, or NULL.  */
+    struct _ZIPcached *next;   /* less recently used, or NULL.  */
+} ZIPcached;
+
+/*
+ * Checkpoints loaded from a seek index file, with their states left in the
+ *  file until they're needed. Allocated in one piece with the array.
+ */
+typedef struct
+{
+    ZIPcheckpoint *checkpoints;  /* in file order, all with NULL states. */
+    PHYSFS_uint32 count;         /* elements in checkpoints.              */
+    PHYSFS_uint64 states;        /* seek index offset of their states.    */
+} ZIPstored;
+
+/*
+ * One ZIPentry is kept for each file in an open ZIP archive. They all live
+ *  in one array, ZIPinfo::entries, with their names in a string pool, and
+ *  refer to each other by index. Element zero is the root directory, which
+ *  is never a symlink target, sibling or in the hash, so an index of zero
+ *  means "none".
  */
 typedef struct _ZIPentry
 {
-    char *name;                         /* Name of file in archive        */
-    struct _ZIPentry *symlink;          /* NULL or file we symlink to     */
-    ZipResolveType resolved;            /* Have we resolved file/symlink? */
     PHYSFS_uint64 offset;               /* offset of data in archive      */
+    PHYSFS_uint64 compressed_size;      /* compressed size                */
+    PHYSFS_uint64 uncompressed_size;    /* uncompressed size              */
+    PHYSFS_uint32 name;                 /* offset of name in names pool   */
+    PHYSFS_uint32 symlink;              /* zero or file we symlink to     */
+    PHYSFS_uint32 children;             /* first of our kids, if dir      */
+    PHYSFS_uint32 sibling;              /* next item in same dir          */
+    PHYSFS_uint32 crc;                  /* crc-32                         */
+    PHYSFS_uint32 dos_mod_time;         /* original MS-DOS style mod time */
     PHYSFS_uint16 version;              /* version made by                */
     PHYSFS_uint16 version_needed;       /* version needed to extract      */
     PHYSFS_uint16 general_bits;         /* general purpose bits           */
     PHYSFS_uint16 compression_method;   /* compression method             */
-    PHYSFS_uint32 crc;                  /* crc-32                         */
-    PHYSFS_uint64 compressed_size;      /* compressed size                */
-    PHYSFS_uint64 uncompressed_size;    /* uncompressed size              */
-    PHYSFS_sint64 last_mod_time;        /* last file mod time             */
-    PHYSFS_uint32 dos_mod_time;         /* original MS-DOS style mod time */
-    struct _ZIPentry *hashnext;         /* next item in this hash bucket  */
-    struct _ZIPentry *children;         /* linked list of kids, if dir    */
-    struct _ZIPentry *sibling;          /* next item in same dir          */
+    PHYSFS_uint8 resolved;              /* a ZipResolveType               */
+    ZIPstored *stored;                  /* from the seek index, or NULL   */
+    ZIPcached *cached;                  /* inflated copy, or NULL         */
 } ZIPentry;
 
 /*
@@ -81,26 +167,63 @@ typedef struct _ZIPentry
 typedef struct
 {
     PHYSFS_Io *io;            /* the i/o interface for this archive.    */
-    ZIPentry root;            /* root of directory tree.                */
-    ZIPentry **hash;          /* all entries hashed for fast lookup.    */
-    size_t hashBuckets;       /* number of buckets in hash.             */
+    ZIPentry *entries;        /* root, then everything else; see above. */
+    PHYSFS_uint32 entries_used;       /* elements of entries in use.    */
+    PHYSFS_uint32 entries_allocated;  /* elements of entries allocated. */
+    char *names;              /* all entries' names, null-terminated.   */
+    PHYSFS_uint32 names_used;         /* bytes of names in use.         */
+    PHYSFS_uint32 names_allocated;    /* bytes of names allocated.      */
+    __PHYSFS_HashTable hash;  /* entry indices hashed for fast lookup.  */
+    __PHYSFS_Arena arena;     /* stored checkpoints, till it's closed.  */
     int zip64;                /* non-zero if this is a Zip64 archive.   */
     int has_crypto;           /* non-zero if any entry uses encryption. */
+    void *rwlock;             /* exclusive to resolve or touch cache.   */
+    PHYSFS_Io *seekindex;     /* stored checkpoints' states, or NULL.   */
+    ZIPcached *cache_head;    /* most recently used cached entry.       */
+    ZIPcached *cache_tail;    /* least recently used cached entry.      */
+    PHYSFS_uint64 cache_used; /* bytes of inflated data in the cache.   */
+    struct _ZIPfileinfo *spares;  /* closed files' inflaters, for reuse. */
+    PHYSFS_uint32 spare_count;    /* number of things in spares list.    */
+    void *spare_mutex;            /* serializes the spares list.         */
+    PHYSFS_Io *centraldir;        /* not parsed yet, or NULL.            */
+    PHYSFS_uint64 data_start;     /* prepended bytes, for entry offsets. */
+    PHYSFS_uint64 centraldir_ofs; /* where the central dir starts.       */
+    PHYSFS_uint64 entry_count;    /* records in the central directory.   */
+    char *name;                   /* archive path, to find seek index.   */
+    PHYSFS_ErrorCode load_error;  /* why the central dir didn't parse.   */
+    struct _ZIPwriter *writer;    /* non-NULL if this is a write dir.    */
+    __PHYSFS_MemAccount *mem;     /* the mount's, for memory accounting. */
+    PHYSFS_uint64 index_charged;  /* PHYSFS_MEMORY_INDEX charged to it.  */
+    PHYSFS_uint32 max_entries;    /* PHYSFS_setMountLimits(), at mount.  */
+    PHYSFS_uint32 max_depth;      /*  ...zero for these three means no   */
+    PHYSFS_uint32 max_hops;       /*  limit, but max_hops is never zero. */
+    PHYSFS_uint64 max_index;
 } ZIPinfo;
 
 /*
  * One ZIPfileinfo is kept for each open file in a ZIP archive.
  */
-typedef struct
+typedef struct _ZIPfileinfo
 {
+    ZIPinfo *info;                        /* archive this came from.    */
     ZIPentry *entry;                      /* Info on file.              */
     PHYSFS_Io *io;                        /* physical file handle.      */
-    PHYSFS_uint32 compressed_position;    /* offset in compressed data. */
-    PHYSFS_uint32 uncompressed_position;  /* tell() position.           */
+    PHYSFS_Io *seekindex;                 /* the archive's, not ours.   */
+    PHYSFS_uint64 compressed_position;    /* offset in compressed data. */
+    PHYSFS_uint64 uncompressed_position;  /* tell() position.           */
     PHYSFS_uint8 *buffer;                 /* decompression buffer.      */
     PHYSFS_uint32 crypto_keys[3];         /* for "traditional" crypto.  */
     PHYSFS_uint32 initial_crypto_keys[3]; /* for "traditional" crypto.  */
+    PHYSFS_uint32 *crypto_checkpoints;    /* keys, every so often.      */
+    PHYSFS_uint32 crypto_checkpoint_count;  /* key triples in that.     */
     z_stream stream;                      /* zlib stream state.         */
+    ZIPcheckpoint *checkpoints;           /* seek index, in file order. */
+    PHYSFS_uint32 checkpoint_count;       /* elements in checkpoints.   */
+    PHYSFS_uint32 checkpoint_interval;    /* zero if not keeping any.   */
+    void *decoder;                        /* zstd/LZ4 state, or NULL.   */
+    PHYSFS_uint16 decoder_method;         /* what (decoder) decodes.    */
+    __PHYSFS_CrcCheck crccheck;           /* if verifying checksums.    */
+    struct _ZIPfileinfo *next_spare;      /* in ZIPinfo::spares.        */
 } ZIPfileinfo;
 
 
@@ -112,10 +235,25 @@ typedef struct
 #define ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG  0x07064b50
 #define ZIP64_EXTENDED_INFO_EXTRA_FIELD_SIG         0x0001
 
+/* the fixed part of a local file header, before its name and extra field. */
+#define ZIP_LOCAL_HEADER_SIZE 30
+
 /* compression methods... */
 #define COMPMETH_NONE 0
+#define COMPMETH_DEFLATE 8
+#define COMPMETH_ZSTD_OLD 20  /* what zstd used before APPNOTE 6.3.8. */
+#define COMPMETH_ZSTD 93
 /* ...and others... */
 
+/*
+ * APPNOTE.TXT doesn't assign LZ4 a method, so by default we use one well
+ *  clear of the ones it does; define this to match your packer instead.
+ */
+#ifndef PHYSFS_ZIP_LZ4_METHOD
+#define PHYSFS_ZIP_LZ4_METHOD 0x4C34  /* "L4" */
+#endif
+#define COMPMETH_LZ4 PHYSFS_ZIP_LZ4_METHOD
+
 
 #define UNIX_FILETYPE_MASK    0170000
 #define UNIX_FILETYPE_SYMLINK 0120000
@@ -129,6 +267,39 @@ static int zip_entry_is_tradional_crypto(const ZIPentry *entry)
     return (entry->general_bits & ZIP_GENERAL_BITS_TRADITIONAL_CRYPTO) != 0;
 } /* zip_entry_is_traditional_crypto */
 
+static int zip_entry_is_zstd(const ZIPentry *entry)
+{
+    return ( (entry->compression_method == COMPMETH_ZSTD) ||
+             (entry->compression_method == COMPMETH_ZSTD_OLD) );
+} /* zip_entry_is_zstd */
+
+static int zip_entry_is_lz4(const ZIPentry *entry)
+{
+    return (entry->compression_method == COMPMETH_LZ4);
+} /* zip_entry_is_lz4 */
+
+/* anything that isn't stored or one of the optional decoders is deflate. */
+static int zip_entry_is_deflated(const ZIPentry *entry)
+{
+    if (entry->compression_method == COMPMETH_NONE)
+        return 0;
+    return ((!zip_entry_is_zstd(entry)) && (!zip_entry_is_lz4(entry)));
+} /* zip_entry_is_deflated */
+
+/* zstd and LZ4 entries can only be read if we were built to decode them. */
+static int zip_entry_is_supported(const ZIPentry *entry)
+{
+#if !PHYSFS_SUPPORTS_ZIP_ZSTD
+    if (zip_entry_is_zstd(entry))
+        return 0;
+#endif
+#if !PHYSFS_SUPPORTS_ZIP_LZ4
+    if (zip_entry_is_lz4(entry))
+        return 0;
+#endif
+    return 1;
+} /* zip_entry_is_supported */
+
 static int zip_entry_ignore_local_header(const ZIPentry *entry)
 {
     return (entry->general_bits & ZIP_GENERAL_BITS_IGNORE_LOCAL_HEADER) != 0;
@@ -136,12 +307,8 @@ static int zip_entry_ignore_local_header(const ZIPentry *entry)
 
 static PHYSFS_uint32 zip_crypto_crc32(const PHYSFS_uint32 crc, const PHYSFS_uint8 val)
 {
-    int i;
-    PHYSFS_uint32 xorval = (crc ^ ((PHYSFS_uint32) val)) & 0xFF;
-    for (i = 0; i < 8; i++)
-        xorval = ((xorval & 1) ? (0xEDB88320 ^ (xorval >> 1)) : (xorval >> 1));
-    return xorval ^ (crc >> 8);
-} /* zip_crc32 */
+    return __PHYSFS_crcByteTable[(crc ^ val) & 0xFF] ^ (crc >> 8);
+} /* zip_crypto_crc32 */
 
 static void zip_update_crypto_keys(PHYSFS_uint32 *keys, const PHYSFS_uint8 val)
 {
@@ -153,10 +320,71 @@ static void zip_update_crypto_keys(PHYSFS_uint32 *keys, const PHYSFS_uint8 val)
 
 static PHYSFS_uint8 zip_decrypt_byte(const PHYSFS_uint32 *keys)
 {
-    const PHYSFS_uint16 tmp = keys[2] | 2;
+    const PHYSFS_uint32 tmp = (keys[2] | 2) & 0xFFFF;
     return (PHYSFS_uint8) ((tmp * (tmp ^ 1)) >> 8);
 } /* zip_decrypt_byte */
 
+/*
+ * Decrypt (len) bytes at (ptr) in place. This is zip_decrypt_byte() and
+ *  zip_update_crypto_keys() with the keys kept in registers.
+ */
+static void zip_decrypt_block(PHYSFS_uint32 *keys, PHYSFS_uint8 *ptr,
+                              PHYSFS_uint64 len)
+{
+    const PHYSFS_uint32 *table = __PHYSFS_crcByteTable;
+    PHYSFS_uint32 key0 = keys[0];
+    PHYSFS_uint32 key1 = keys[1];
+    PHYSFS_uint32 key2 = keys[2];
+
+    while (len--)
+    {
+        const PHYSFS_uint32 tmp = (key2 | 2) & 0xFFFF;
+        const PHYSFS_uint8 ch = *ptr ^ (PHYSFS_uint8) ((tmp * (tmp ^ 1)) >> 8);
+        *(ptr++) = ch;
+        key0 = table[(key0 ^ ch) & 0xFF] ^ (key0 >> 8);
+        key1 = ((key1 + (key0 & 0xFF)) * 134775813) + 1;
+        key2 = table[(key2 ^ (key1 >> 24)) & 0xFF] ^ (key2 >> 8);
+    } /* while */
+
+    keys[0] = key0;
+    keys[1] = key1;
+    keys[2] = key2;
+} /* zip_decrypt_block */
+
+
+/*
+ * The keys depend on every byte decrypted so far, so there's no jumping
+ *  ahead in an encrypted entry, but we can go back: for stored entries we
+ *  note the keys every this many bytes on the way through, and ZIP_seek()
+ *  restarts from the nearest one instead of the start of the file.
+ */
+#define ZIP_CRYPTO_CHECKPOINT_INTERVAL (64 * 1024)
+
+/*
+ * Note (finfo)'s keys as the ones for (pos), if that's the next checkpoint
+ *  we don't have yet. These are only an optimization, so if we're out of
+ *  memory, skip it.
+ */
+static void zip_add_crypto_checkpoint(ZIPfileinfo *finfo,
+                                      const PHYSFS_uint64 pos)
+{
+    const PHYSFS_uint32 count = finfo->crypto_checkpoint_count;
+    PHYSFS_uint32 *ptr;
+
+    if ((pos / ZIP_CRYPTO_CHECKPOINT_INTERVAL) != (count + 1))
+        return;  /* zero is initial_crypto_keys, or we've got this one. */
+
+    ptr = (PHYSFS_uint32 *) allocator.Realloc(finfo->crypto_checkpoints,
+                                     (count + 1) * sizeof (PHYSFS_uint32) * 3);
+    if (ptr == NULL)
+        return;
+
+    memcpy(ptr + (count * 3), finfo->crypto_keys, 12);
+    finfo->crypto_checkpoints = ptr;
+    finfo->crypto_checkpoint_count++;
+} /* zip_add_crypto_checkpoint */
+
+
 static PHYSFS_sint64 zip_read_decrypt(ZIPfileinfo *finfo, void *buf, PHYSFS_uint64 len)
 {
     PHYSFS_Io *io = finfo->io;
@@ -165,15 +393,31 @@ static PHYSFS_sint64 zip_read_decrypt(ZIPfileinfo *finfo, void *buf, PHYSFS_uint
     /* Decompression the new data if necessary. */
     if (zip_entry_is_tradional_crypto(finfo->entry) && (br > 0))
     {
-        PHYSFS_uint32 *keys = finfo->crypto_keys;
         PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
-        PHYSFS_sint64 i;
-        for (i = 0; i < br; i++, ptr++)
+        PHYSFS_uint64 remain = (PHYSFS_uint64) br;
+
+        if (finfo->entry->compression_method != COMPMETH_NONE)
+            zip_decrypt_block(finfo->crypto_keys, ptr, remain);
+        else
         {
-            const PHYSFS_uint8 ch = *ptr ^ zip_decrypt_byte(keys);
-            zip_update_crypto_keys(keys, ch);
-            *ptr = ch;
-        } /* for */
+            /* stored: the file position is the ciphertext position, too. */
+            PHYSFS_uint64 pos = finfo->uncompressed_position;
+            while (remain > 0)
+            {
+                const PHYSFS_uint64 into = pos % ZIP_CRYPTO_CHECKPOINT_INTERVAL;
+                PHYSFS_uint64 chunk = ZIP_CRYPTO_CHECKPOINT_INTERVAL - into;
+                if (chunk > remain)
+                    chunk = remain;
+
+                if ((into == 0) && (pos > 0))
+                    zip_add_crypto_checkpoint(finfo, pos);
+
+                zip_decrypt_block(finfo->crypto_keys, ptr, chunk);
+                ptr += chunk;
+                pos += chunk;
+                remain -= chunk;
+            } /* while */
+        } /* else */
     } /* if  */
 
     return br;
@@ -218,12 +462,27 @@ static int zip_prep_crypto_keys(ZIPfileinfo *finfo, const PHYSFS_uint8 *crypto_h
 } /* zip_prep_crypto_keys */
 
 
+/*
+ * zlib's state counts as PHYSFS_MEMORY_DECODERS, charged to (opaque), the
+ *  archive's __PHYSFS_MemAccount or NULL. zlib doesn't say how much it's
+ *  freeing, so each block remembers in a header, padded to keep what
+ *  zlib gets aligned as well as malloc's own.
+ */
+#define ZLIB_ALLOC_HEADER 16
+
 /*
  * Bridge physfs allocation functions to zlib's format...
  */
 static voidpf zlibPhysfsAlloc(voidpf opaque, uInt items, uInt size)
 {
-    return ((PHYSFS_Allocator *) opaque)->Malloc(items * size);
+    const size_t len = ((size_t) items) * size + ZLIB_ALLOC_HEADER;
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) allocator.Malloc(len);
+    if (ptr == NULL)
+        return NULL;
+    *((size_t *) ptr) = len;
+    __PHYSFS_memCharge((__PHYSFS_MemAccount *) opaque, PHYSFS_MEMORY_DECODERS,
+                       (PHYSFS_sint64) len);
+    return ptr + ZLIB_ALLOC_HEADER;
 } /* zlibPhysfsAlloc */
 
 /*
@@ -231,19 +490,50 @@ static voidpf zlibPhysfsAlloc(voidpf opaque, uInt items, uInt size)
  */
 static void zlibPhysfsFree(voidpf opaque, voidpf address)
 {
-    ((PHYSFS_Allocator *) opaque)->Free(address);
+    PHYSFS_uint8 *ptr = ((PHYSFS_uint8 *) address) - ZLIB_ALLOC_HEADER;
+    __PHYSFS_memCharge((__PHYSFS_MemAccount *) opaque, PHYSFS_MEMORY_DECODERS,
+                       -((PHYSFS_sint64) *((size_t *) ptr)));
+    allocator.Free(ptr);
 } /* zlibPhysfsFree */
 
 
+/* For memoryIos over buffers we allocated. */
+static void zip_free_buffer(void *buf)
+{
+    allocator.Free(buf);
+} /* zip_free_buffer */
+
+
+/*
+ * Each compressed file's ZIP_READBUFSIZE bytes of input to inflate, which
+ *  count as decoder memory, like the inflater it feeds.
+ */
+static PHYSFS_uint8 *zip_alloc_readbuf(__PHYSFS_MemAccount *mem)
+{
+    void *retval = __PHYSFS_alignedMalloc(ZIP_READBUFSIZE,
+                                          __PHYSFS_SIMD_ALIGN);
+    if (retval != NULL)
+        __PHYSFS_memCharge(mem, PHYSFS_MEMORY_DECODERS, ZIP_READBUFSIZE);
+    return (PHYSFS_uint8 *) retval;
+} /* zip_alloc_readbuf */
+
+static void zip_free_readbuf(__PHYSFS_MemAccount *mem, PHYSFS_uint8 *buf)
+{
+    __PHYSFS_alignedFree(buf, ZIP_READBUFSIZE, __PHYSFS_SIMD_ALIGN);
+    __PHYSFS_memCharge(mem, PHYSFS_MEMORY_DECODERS, -ZIP_READBUFSIZE);
+} /* zip_free_readbuf */
+
+
 /*
- * Construct a new z_stream to a sane state.
+ * Construct a new z_stream to a sane state, charging what it allocates to
+ *  (mem), which may be NULL.
  */
-static void initializeZStream(z_stream *pstr)
+static void initializeZStream(z_stream *pstr, __PHYSFS_MemAccount *mem)
 {
     memset(pstr, '\0', sizeof (z_stream));
     pstr->zalloc = zlibPhysfsAlloc;
     pstr->zfree = zlibPhysfsFree;
-    pstr->opaque = &allocator;
+    pstr->opaque = mem;
 } /* initializeZStream */
 
 
@@ -272,11 +562,27 @@ static int zlib_err(const int rc)
 /*
  * Hash a string for lookup an a ZIPinfo hashtable.
  */
-static inline PHYSFS_uint32 zip_hash_string(const ZIPinfo *info, const char *s)
+static inline PHYSFS_uint32 zip_hash_string(const char *s)
 {
-    return __PHYSFS_hashString(s, strlen(s)) % info->hashBuckets;
+    return __PHYSFS_hashString(s, strlen(s));
 } /* zip_hash_string */
 
+/*
+ * Get at an entry's name. This is only safe to hang on to after the central
+ *  directory is loaded, since the pool can move while we're filling it.
+ */
+static inline char *zip_entry_name(const ZIPinfo *info, const ZIPentry *entry)
+{
+    return info->names + entry->name;
+} /* zip_entry_name */
+
+/* Get the entry a symlink points to, or NULL if it isn't resolved one. */
+static inline ZIPentry *zip_symlink_target(const ZIPinfo *info,
+                                           const ZIPentry *entry)
+{
+    return (entry->symlink == 0) ? NULL : &info->entries[entry->symlink];
+} /* zip_symlink_target */
+
 /*
  * Read an unsigned 64-bit int and swap to native byte order.
  */
@@ -312,1539 +618,5910 @@ static int readui16(PHYSFS_Io *io, PHYSFS_uint16 *val)
 } /* readui16 */
 
 
-static PHYSFS_sint64 ZIP_read(PHYSFS_Io *_io, void *buf, PHYSFS_uint64 len)
-{
-    ZIPfileinfo *finfo = (ZIPfileinfo *) _io->opaque;
-    ZIPentry *entry = finfo->entry;
-    PHYSFS_sint64 retval = 0;
-    PHYSFS_sint64 maxread = (PHYSFS_sint64) len;
-    PHYSFS_sint64 avail = entry->uncompressed_size -
-                          finfo->uncompressed_position;
-
-    if (avail < maxread)
-        maxread = avail;
-
-    BAIL_IF_MACRO(maxread == 0, ERRPASS, 0);    /* quick rejection. */
-
-    if (entry->compression_method == COMPMETH_NONE)
-        retval = zip_read_decrypt(finfo, buf, maxread);
-    else
-    {
-        finfo->stream.next_out = buf;
-        finfo->stream.avail_out = (uInt) maxread;
+/*
+ * A seek index file ("archive.zip.seekindex", from PHYSFS_buildSeekIndex())
+ *  sits next to an archive and holds checkpoints for its big entries, so
+ *  seeks are cheap from the first time they're opened. Everything is little
+ *  endian, except that the checkpoints' inflater states are dumped as-is, so
+ *  a seek index is only used by builds with the same inflate_state, which
+ *  the header checks. Builds whose inflater can't be dumped like that (see
+ *  physfs_inflate.h) don't use them at all:
+ *
+ *   uint32 ZIP_SEEKINDEX_SIG, uint32 ZIP_SEEKINDEX_VERSION,
+ *   uint32 PHYSFS_INFLATE_STATE_SIZE, uint32 ZIP_SEEKINDEX_BYTEORDER (native
+ *   byte order), uint32 number of entries.
+ *
+ * ...then, for each entry:
+ *
+ *   uint32 name length, name (not null-terminated), uint32 crc, uint64
+ *   compressed size, uint64 uncompressed size, uint32 checkpoint count,
+ *   that many (uint64 uncompressed position, uint64 compressed position)
+ *   pairs, and then that many inflate_states.
+ *
+ * Entries whose CRC or sizes don't match the central directory are ignored,
+ *  so a stale seek index for a changed archive does no harm.
+ */
+#define ZIP_SEEKINDEX_EXTENSION ".seekindex"
+#define ZIP_SEEKINDEX_SIG 0x58444953  /* "SIDX" */
+#define ZIP_SEEKINDEX_VERSION 2  /* 1 had 32-bit checkpoint positions. */
+#define ZIP_SEEKINDEX_BYTEORDER 0x01020304
 
-        while (retval < maxread)
-        {
-            PHYSFS_uint32 before = finfo->stream.total_out;
-            int rc;
 
-            if (finfo->stream.avail_in == 0)
-            {
-                PHYSFS_sint64 br;
+/*
+ * Only entries we can jump into the middle of get a seek index; "traditional"
+ *  crypto needs every byte before the one you want, so those can't.
+ */
+static PHYSFS_uint32 zip_checkpoint_interval(const ZIPentry *entry)
+{
+    if ((!zip_entry_is_deflated(entry)) || (!PHYSFS_INFLATE_FLAT_STATE))
+        return 0;  /* only (flat) inflaters can be snapshotted. */
+    else if (zip_entry_is_tradional_crypto(entry))
+        return 0;
+    else if (entry->stored != NULL)
+        return 0;  /* the seek index already has them. */
+    return __PHYSFS_getSeekIndexInterval();
+} /* zip_checkpoint_interval */
 
-                br = entry->compressed_size - finfo->compressed_position;
-                if (br > 0)
-                {
-                    if (br > ZIP_READBUFSIZE)
-                        br = ZIP_READBUFSIZE;
 
-                    br = zip_read_decrypt(finfo, finfo->buffer, (PHYSFS_uint64) br);
-                    if (br <= 0)
-                        break;
+/*
+ * Remember where (finfo)'s inflater is, now that it has handed out everything
+ *  up to (pos), if that's an interval or more past the last checkpoint. The
+ *  seek index is only an optimization, so if we're out of memory, skip it.
+ */
+static void zip_add_checkpoint(ZIPfileinfo *finfo, const PHYSFS_uint64 pos)
+{
+    const PHYSFS_uint32 count = finfo->checkpoint_count;
+    PHYSFS_uint64 next = (PHYSFS_uint64) finfo->checkpoint_interval;
+    ZIPcheckpoint *cp;
+    void *ptr;
 
-                    finfo->compressed_position += (PHYSFS_uint32) br;
-                    finfo->stream.next_in = finfo->buffer;
-                    finfo->stream.avail_in = (PHYSFS_uint32) br;
-                } /* if */
-            } /* if */
+    if (count > 0)
+        next += finfo->checkpoints[count - 1].uncompressed_position;
 
-            rc = zlib_err(inflate(&finfo->stream, Z_SYNC_FLUSH));
-            retval += (finfo->stream.total_out - before);
+    if (pos < next)
+        return;  /* too close to the last one (or we're behind it). */
 
-            if (rc != Z_OK)
-                break;
-        } /* while */
-    } /* else */
+    ptr = allocator.Realloc(finfo->checkpoints, sizeof (ZIPcheckpoint) *
+                            (count + 1));
+    if (ptr == NULL)
+        return;
+    finfo->checkpoints = (ZIPcheckpoint *) ptr;
 
-    if (retval > 0)
-        finfo->uncompressed_position += (PHYSFS_uint32) retval;
+    cp = &finfo->checkpoints[count];
+    cp->state = allocator.Malloc(PHYSFS_INFLATE_STATE_SIZE);
+    if (cp->state == NULL)
+        return;
 
-    return retval;
-} /* ZIP_read */
+    memcpy(cp->state, finfo->stream.state, PHYSFS_INFLATE_STATE_SIZE);
+    cp->uncompressed_position = pos;
+    cp->compressed_position = finfo->compressed_position -
+                              finfo->stream.avail_in;
+    finfo->checkpoint_count++;
+} /* zip_add_checkpoint */
 
 
-static PHYSFS_sint64 ZIP_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
+/* Find the last checkpoint at or before (pos), or NULL if there isn't one. */
+static const ZIPcheckpoint *zip_find_checkpoint(const ZIPcheckpoint *list,
+                                                const PHYSFS_uint32 count,
+                                                const PHYSFS_uint64 pos)
 {
-    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
-} /* ZIP_write */
+    PHYSFS_uint32 lo = 0;
+    PHYSFS_uint32 hi = count;
 
+    /* binary search for the first checkpoint past (pos). */
+    while (lo < hi)
+    {
+        const PHYSFS_uint32 middle = lo + ((hi - lo) / 2);
+        if (list[middle].uncompressed_position <= pos)
+            lo = middle + 1;
+        else
+            hi = middle;
+    } /* while */
 
-static PHYSFS_sint64 ZIP_tell(PHYSFS_Io *io)
-{
-    return ((ZIPfileinfo *) io->opaque)->uncompressed_position;
-} /* ZIP_tell */
+    return (lo == 0) ? NULL : &list[lo - 1];
+} /* zip_find_checkpoint */
 
 
-static int ZIP_seek(PHYSFS_Io *_io, PHYSFS_uint64 offset)
+/*
+ * Put (finfo)'s inflater (and i/o position) back where it was at (cp). If
+ *  this fails, the inflater might be garbage; the caller has to start over.
+ */
+static int zip_resume_checkpoint(ZIPfileinfo *finfo, const ZIPcheckpoint *cp)
 {
-    ZIPfileinfo *finfo = (ZIPfileinfo *) _io->opaque;
-    ZIPentry *entry = finfo->entry;
+    const ZIPentry *entry = finfo->entry;
     PHYSFS_Io *io = finfo->io;
-    const int encrypted = zip_entry_is_tradional_crypto(entry);
+    const PHYSFS_uint64 pos = entry->offset + cp->compressed_position;
 
-    BAIL_IF_MACRO(offset > entry->uncompressed_size, PHYSFS_ERR_PAST_EOF, 0);
-
-    if (!encrypted && (entry->compression_method == COMPMETH_NONE))
-    {
-        PHYSFS_sint64 newpos = offset + entry->offset;
-        BAIL_IF_MACRO(!io->seek(io, newpos), ERRPASS, 0);
-        finfo->uncompressed_position = (PHYSFS_uint32) offset;
-    } /* if */
+    BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
 
-    else
+    if (cp->state != NULL)
+        memcpy(finfo->stream.state, cp->state, PHYSFS_INFLATE_STATE_SIZE);
+    else  /* stored in the seek index. */
     {
-        /*
-         * If seeking backwards, we need to redecode the file
-         *  from the start and throw away the compressed bits until we hit
-         *  the offset we need. If seeking forward, we still need to
-         *  decode, but we don't rewind first.
-         */
-        if (offset < finfo->uncompressed_position)
-        {
-            /* we do a copy so state is sane if inflateInit2() fails. */
-            z_stream str;
-            initializeZStream(&str);
-            if (zlib_err(inflateInit2(&str, -MAX_WBITS)) != Z_OK)
-                return 0;
+        const size_t idx = (size_t) (cp - entry->stored->checkpoints);
+        const PHYSFS_uint64 statepos = entry->stored->states +
+                                       (((PHYSFS_uint64) idx) *
+                                        PHYSFS_INFLATE_STATE_SIZE);
+        const PHYSFS_sint64 br = __PHYSFS_ioReadAt(finfo->seekindex,
+                                                   finfo->stream.state,
+                                                   PHYSFS_INFLATE_STATE_SIZE,
+                                                   statepos);
+        BAIL_IF_MACRO(br != PHYSFS_INFLATE_STATE_SIZE, ERRPASS, 0);
+    } /* else */
 
-            if (!io->seek(io, entry->offset + (encrypted ? 12 : 0)))
-                return 0;
+    finfo->stream.next_in = finfo->buffer;
+    finfo->stream.avail_in = 0;
+    finfo->compressed_position = cp->compressed_position;
+    finfo->uncompressed_position = cp->uncompressed_position;
+    return 1;
+} /* zip_resume_checkpoint */
 
-            inflateEnd(&finfo->stream);
-            memcpy(&finfo->stream, &str, sizeof (z_stream));
-            finfo->uncompressed_position = finfo->compressed_position = 0;
 
-            if (encrypted)
-                memcpy(finfo->crypto_keys, finfo->initial_crypto_keys, 12);
-        } /* if */
+static void zip_free_checkpoints(ZIPfileinfo *finfo)
+{
+    PHYSFS_uint32 i;
+    for (i = 0; i < finfo->checkpoint_count; i++)
+        allocator.Free(finfo->checkpoints[i].state);
+    allocator.Free(finfo->checkpoints);
+    finfo->checkpoints = NULL;
+    finfo->checkpoint_count = 0;
 
-        while (finfo->uncompressed_position != offset)
-        {
-            PHYSFS_uint8 buf[512];
-            PHYSFS_uint32 maxread;
+    allocator.Free(finfo->crypto_checkpoints);
+    finfo->crypto_checkpoints = NULL;
+    finfo->crypto_checkpoint_count = 0;
+} /* zip_free_checkpoints */
 
-            maxread = (PHYSFS_uint32) (offset - finfo->uncompressed_position);
-            if (maxread > sizeof (buf))
-                maxread = sizeof (buf);
 
-            if (ZIP_read(_io, buf, maxread) != maxread)
-                return 0;
-        } /* while */
-    } /* else */
+/* Free (finfo)'s zstd or LZ4 decoder, if it has one. */
+static void zip_free_decoder(ZIPfileinfo *finfo)
+{
+    if (finfo->decoder == NULL)
+        return;
+#if PHYSFS_SUPPORTS_ZIP_ZSTD
+    else if (finfo->decoder_method == COMPMETH_ZSTD)
+        ZSTD_freeDStream((ZSTD_DStream *) finfo->decoder);
+#endif
+#if PHYSFS_SUPPORTS_ZIP_LZ4
+    else if (finfo->decoder_method == COMPMETH_LZ4)
+        LZ4F_freeDecompressionContext((LZ4F_dctx *) finfo->decoder);
+#endif
 
-    return 1;
-} /* ZIP_seek */
+    finfo->decoder = NULL;
+    finfo->decoder_method = COMPMETH_NONE;
+} /* zip_free_decoder */
 
 
-static PHYSFS_sint64 ZIP_length(PHYSFS_Io *io)
+/*
+ * Start (finfo)'s inflater (and zstd or LZ4 decoder) over, without
+ *  reallocating anything.
+ */
+static void zip_reset_inflater(ZIPfileinfo *finfo)
 {
-    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
-    return (PHYSFS_sint64) finfo->entry->uncompressed_size;
-} /* ZIP_length */
-
+    inflateReset(&finfo->stream);  /* can't fail once it's initialized. */
+#if PHYSFS_SUPPORTS_ZIP_ZSTD
+    if ((finfo->decoder) && (finfo->decoder_method == COMPMETH_ZSTD))
+        ZSTD_initDStream((ZSTD_DStream *) finfo->decoder);
+#endif
+#if PHYSFS_SUPPORTS_ZIP_LZ4
+    if ((finfo->decoder) && (finfo->decoder_method == COMPMETH_LZ4))
+        LZ4F_resetDecompressionContext((LZ4F_dctx *) finfo->decoder);
+#endif
+    finfo->stream.next_in = finfo->buffer;
+    finfo->stream.avail_in = 0;
+    finfo->stream.next_out = NULL;
+    finfo->stream.avail_out = 0;
+} /* zip_reset_inflater */
 
-static PHYSFS_Io *zip_get_io(PHYSFS_Io *io, ZIPinfo *inf, ZIPentry *entry);
 
-static PHYSFS_Io *ZIP_duplicate(PHYSFS_Io *io)
+/*
+ * Get a ZIPfileinfo for (entry), with a buffer and inflater ready to go if
+ *  it's compressed: a spare from (info) if there is one, otherwise a new one.
+ *  Everything else is zeroed. (info) is where it goes back to when it's
+ *  freed, and may be NULL.
+ */
+static ZIPfileinfo *zip_alloc_fileinfo(ZIPinfo *info, ZIPentry *entry)
 {
-    ZIPfileinfo *origfinfo = (ZIPfileinfo *) io->opaque;
-    PHYSFS_Io *retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    ZIPfileinfo *finfo = (ZIPfileinfo *) allocator.Malloc(sizeof (ZIPfileinfo));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, failed);
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, failed);
-    memset(finfo, '\0', sizeof (*finfo));
-
-    finfo->entry = origfinfo->entry;
-    finfo->io = zip_get_io(origfinfo->io, NULL, finfo->entry);
-    GOTO_IF_MACRO(!finfo->io, ERRPASS, failed);
+    const int compressed = (entry->compression_method != COMPMETH_NONE);
+    __PHYSFS_MemAccount *mem = (info != NULL) ? info->mem : NULL;
+    ZIPfileinfo *finfo = NULL;
 
-    if (finfo->entry->compression_method != COMPMETH_NONE)
+    if ((compressed) && (info != NULL))
     {
-        finfo->buffer = (PHYSFS_uint8 *) allocator.Malloc(ZIP_READBUFSIZE);
-        GOTO_IF_MACRO(!finfo->buffer, PHYSFS_ERR_OUT_OF_MEMORY, failed);
-        if (zlib_err(inflateInit2(&finfo->stream, -MAX_WBITS)) != Z_OK)
-            goto failed;
+        __PHYSFS_platformGrabMutex(info->spare_mutex);
+        finfo = info->spares;
+        if (finfo != NULL)
+        {
+            info->spares = finfo->next_spare;
+            info->spare_count--;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(info->spare_mutex);
     } /* if */
 
-    memcpy(retval, io, sizeof (PHYSFS_Io));
-    retval->opaque = finfo;
-    return retval;
-
-failed:
     if (finfo != NULL)
     {
-        if (finfo->io != NULL)
-            finfo->io->destroy(finfo->io);
+        z_stream stream;
+        PHYSFS_uint8 *buffer = finfo->buffer;
+        void *decoder = finfo->decoder;
+        const PHYSFS_uint16 decoder_method = finfo->decoder_method;
+        memcpy(&stream, &finfo->stream, sizeof (z_stream));
+        memset(finfo, '\0', sizeof (ZIPfileinfo));
+        memcpy(&finfo->stream, &stream, sizeof (z_stream));
+        finfo->buffer = buffer;
+        finfo->decoder = decoder;
+        finfo->decoder_method = decoder_method;
+        zip_reset_inflater(finfo);
+    } /* if */
 
-        if (finfo->buffer != NULL)
+    else
+    {
+        finfo = (ZIPfileinfo *) __PHYSFS_poolAlloc(sizeof (ZIPfileinfo));
+        BAIL_IF_MACRO(!finfo, ERRPASS, NULL);
+        memset(finfo, '\0', sizeof (ZIPfileinfo));
+        initializeZStream(&finfo->stream, mem);
+
+        if (compressed)
         {
-            allocator.Free(finfo->buffer);
-            inflateEnd(&finfo->stream);
+            finfo->buffer = zip_alloc_readbuf(mem);
+            if (!finfo->buffer)
+            {
+                __PHYSFS_poolFree(finfo, sizeof (ZIPfileinfo));
+                BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+            } /* if */
+            else if (zlib_err(inflateInit2(&finfo->stream, -MAX_WBITS)) != Z_OK)
+            {
+                zip_free_readbuf(mem, finfo->buffer);
+                __PHYSFS_poolFree(finfo, sizeof (ZIPfileinfo));
+                return NULL;
+            } /* else if */
         } /* if */
+    } /* else */
 
-        allocator.Free(finfo);
-    } /* if */
+    finfo->info = info;
+    finfo->entry = entry;
+    if (compressed)
+        finfo->checkpoint_interval = zip_checkpoint_interval(entry);
+    __PHYSFS_crcCheckInit(&finfo->crccheck);
+    return finfo;
+} /* zip_alloc_fileinfo */
 
-    if (retval != NULL)
-        allocator.Free(retval);
 
-    return NULL;
-} /* ZIP_duplicate */
+/*
+ * Free (finfo), or keep its buffer and inflater for the next file opened
+ *  in its archive. Closing (finfo->io) is up to the caller.
+ */
+static void zip_free_fileinfo(ZIPfileinfo *finfo)
+{
+    ZIPinfo *info = finfo->info;
 
-static int ZIP_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
+    zip_free_checkpoints(finfo);
 
-static void ZIP_destroy(PHYSFS_Io *io)
-{
-    ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
-    finfo->io->destroy(finfo->io);
+    if (finfo->buffer == NULL)
+    {
+        __PHYSFS_poolFree(finfo, sizeof (ZIPfileinfo));
+        return;
+    } /* if */
 
-    if (finfo->entry->compression_method != COMPMETH_NONE)
-        inflateEnd(&finfo->stream);
+    /*
+     * spares are only worth it while there's room for decoders (and if the
+     *  inflater's still good: a failed zip_clone_inflater() ends it).
+     */
+    if ((info != NULL) && (finfo->stream.state != NULL) &&
+        (!__PHYSFS_memExcess(PHYSFS_MEMORY_DECODERS)))
+    {
+        int kept = 0;
+        __PHYSFS_platformGrabMutex(info->spare_mutex);
+        if (info->spare_count < ZIP_SPARE_INFLATERS)
+        {
+            finfo->next_spare = info->spares;
+            info->spares = finfo;
+            info->spare_count++;
+            kept = 1;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(info->spare_mutex);
 
-    if (finfo->buffer != NULL)
-        allocator.Free(finfo->buffer);
+        if (kept)
+            return;
+    } /* if */
 
-    allocator.Free(finfo);
-    allocator.Free(io);
-} /* ZIP_destroy */
+    zip_free_decoder(finfo);
+    inflateEnd(&finfo->stream);
+    zip_free_readbuf((info != NULL) ? info->mem : NULL, finfo->buffer);
+    __PHYSFS_poolFree(finfo, sizeof (ZIPfileinfo));
+} /* zip_free_fileinfo */
 
 
-static const PHYSFS_Io ZIP_Io =
+/*
+ * Write an unsigned 64-bit int in little endian byte order.
+ */
+static int writeui64(PHYSFS_Io *io, const PHYSFS_uint64 val)
 {
-    CURRENT_PHYSFS_IO_API_VERSION, NULL,
-    ZIP_read,
-    ZIP_write,
-    ZIP_seek,
-    ZIP_tell,
-    ZIP_length,
-    ZIP_duplicate,
-    ZIP_flush,
-    ZIP_destroy
-};
+    const PHYSFS_uint64 v = PHYSFS_swapULE64(val);
+    return (io->write(io, &v, sizeof (v)) == sizeof (v));
+} /* writeui64 */
 
 
+/*
+ * Write an unsigned 32-bit int in little endian byte order.
+ */
+static int writeui32(PHYSFS_Io *io, const PHYSFS_uint32 val)
+{
+    const PHYSFS_uint32 v = PHYSFS_swapULE32(val);
+    return (io->write(io, &v, sizeof (v)) == sizeof (v));
+} /* writeui32 */
 
-static PHYSFS_sint64 zip_find_end_of_central_dir(PHYSFS_Io *io, PHYSFS_sint64 *len)
+
+/* Can zip_inflate_all() do (finfo)'s entry, from where (finfo) is now? */
+static int zip_can_inflate_whole(const ZIPfileinfo *finfo)
 {
-    PHYSFS_uint8 buf[256];
-    PHYSFS_uint8 extra[4] = { 0, 0, 0, 0 };
-    PHYSFS_sint32 i = 0;
-    PHYSFS_sint64 filelen;
-    PHYSFS_sint64 filepos;
-    PHYSFS_sint32 maxread;
-    PHYSFS_sint32 totalread = 0;
-    int found = 0;
+    const ZIPentry *entry = finfo->entry;
 
-    filelen = io->length(io);
-    BAIL_IF_MACRO(filelen == -1, ERRPASS, -1);
+    if (finfo->compressed_position != 0)
+        return 0;  /* been here before and it didn't work out. */
+    else if (finfo->checkpoint_interval)
+        return 0;  /* wants checkpoints on the way through. */
+    else if (zip_entry_is_tradional_crypto(entry))
+        return 0;
+    else if ((entry->compressed_size > 0xFFFFFFFF) ||
+             (entry->uncompressed_size > 0xFFFFFFFF))
+        return 0;  /* z_stream counts in uInts. */
+    return 1;
+} /* zip_can_inflate_whole */
 
-    /*
-     * Jump to the end of the file and start reading backwards.
-     *  The last thing in the file is the zipfile comment, which is variable
-     *  length, and the field that specifies its size is before it in the
-     *  file (argh!)...this means that we need to scan backwards until we
-     *  hit the end-of-central-dir signature. We can then sanity check that
-     *  the comment was as big as it should be to make sure we're in the
-     *  right place. The comment length field is 16 bits, so we can stop
-     *  searching for that signature after a little more than 64k at most,
-     *  and call it a corrupted zipfile.
-     */
 
-    if (sizeof (buf) < filelen)
-    {
-        filepos = filelen - sizeof (buf);
-        maxread = sizeof (buf);
-    } /* if */
-    else
-    {
-        filepos = 0;
-        maxread = (PHYSFS_uint32) filelen;
-    } /* else */
+#if PHYSFS_SUPPORTS_ZIP_LIBDEFLATE
+/*
+ * Inflate (srclen) bytes of raw deflate data at (src) into exactly (dstlen)
+ *  bytes at (dst) with libdeflate, which only does whole buffers, but does
+ *  them a lot faster than a streaming inflater. Returns zero if that didn't
+ *  work, bad data or otherwise; the caller tries its own inflater next.
+ */
+static int zip_libdeflate(const void *src, const PHYSFS_uint64 srclen,
+                          void *dst, const PHYSFS_uint64 dstlen)
+{
+    struct libdeflate_decompressor *d = libdeflate_alloc_decompressor();
+    enum libdeflate_result rc;
 
-    while ((totalread < filelen) && (totalread < 65557))
-    {
-        BAIL_IF_MACRO(!io->seek(io, filepos), ERRPASS, -1);
+    if (d == NULL)
+        return 0;
 
-        /* make sure we catch a signature between buffers. */
-        if (totalread != 0)
-        {
-            if (!__PHYSFS_readAll(io, buf, maxread - 4))
-                return -1;
-            memcpy(&buf[maxread - 4], &extra, sizeof (extra));
-            totalread += maxread - 4;
-        } /* if */
-        else
-        {
-            if (!__PHYSFS_readAll(io, buf, maxread))
-                return -1;
-            totalread += maxread;
-        } /* else */
+    /* no actual length asked for, so anything but exactly (dstlen) fails. */
+    rc = libdeflate_deflate_decompress(d, src, (size_t) srclen,
+                                       dst, (size_t) dstlen, NULL);
+    libdeflate_free_decompressor(d);
+    return (rc == LIBDEFLATE_SUCCESS);
+} /* zip_libdeflate */
+#endif
 
-        memcpy(&extra, buf, sizeof (extra));
 
-        for (i = maxread - 4; i > 0; i--)
-        {
-            if ((buf[i + 0] == 0x50) &&
-                (buf[i + 1] == 0x4B) &&
-                (buf[i + 2] == 0x05) &&
-                (buf[i + 3] == 0x06) )
-            {
-                found = 1;  /* that's the signature! */
-                break;  
-            } /* if */
-        } /* for */
+/*
+ * Inflate all of (finfo)'s entry in one shot from (compressed), all of its
+ *  compressed data, straight into (buf), skipping finfo->buffer and the
+ *  inflater's wrapping 32k window, or with the app's PHYSFS_Inflater if it
+ *  has one that will take it (or libdeflate, if we were built with it).
+ *  Returns zero if the data is bad, with (finfo)'s inflater reset to try
+ *  again the usual way. This doesn't touch finfo->io.
+ */
+static int zip_inflate_all(ZIPfileinfo *finfo, const PHYSFS_uint8 *compressed,
+                           void *buf)
+{
+    const ZIPentry *entry = finfo->entry;
+    int done;
+    int rc;
 
-        if (found)
-            break;
+    assert(zip_can_inflate_whole(finfo));
 
-        filepos -= (maxread - 4);
-        if (filepos < 0)
-            filepos = 0;
-    } /* while */
+    /* the app's inflater gets first try, if it has one. */
+    done = __PHYSFS_offloadInflate(compressed, entry->compressed_size, buf,
+                                   entry->uncompressed_size);
 
-    BAIL_IF_MACRO(!found, PHYSFS_ERR_UNSUPPORTED, -1);
+#if PHYSFS_SUPPORTS_ZIP_LIBDEFLATE
+    if (!done)
+    {
+        done = zip_libdeflate(compressed, entry->compressed_size, buf,
+                              entry->uncompressed_size);
+    } /* if */
+#endif
 
-    if (len != NULL)
-        *len = filelen;
+    if (!done)
+    {
+        finfo->stream.next_in = compressed;
+        finfo->stream.avail_in = (uInt) entry->compressed_size;
+        finfo->stream.next_out = (unsigned char *) buf;
+        finfo->stream.avail_out = (uInt) entry->uncompressed_size;
+        rc = inflate(&finfo->stream, Z_FINISH);
+
+        if ((rc != Z_STREAM_END) ||
+            (finfo->stream.total_out != entry->uncompressed_size))
+        {
+            /* let the streaming code find (and report) the problem. */
+            zip_reset_inflater(finfo);
+            return 0;
+        } /* if */
+    } /* if */
 
-    return (filepos + i);
-} /* zip_find_end_of_central_dir */
+    finfo->stream.next_in = finfo->buffer;
+    finfo->stream.avail_in = 0;
+    finfo->compressed_position = entry->compressed_size;
+    return 1;
+} /* zip_inflate_all */
 
 
-static int isZip(PHYSFS_Io *io)
+/*
+ * Fast path for reading all of a compressed entry at once, which is what
+ *  most loaders do: inflate in one shot from all of the compressed data,
+ *  mapped or read in one go, straight into (buf). Returns zero if that
+ *  can't be done, or the data is bad, with (finfo) ready to try it the
+ *  usual way.
+ */
+static int zip_inflate_whole(ZIPfileinfo *finfo, void *buf)
 {
-    PHYSFS_uint32 sig = 0;
-    int retval = 0;
+    const ZIPentry *entry = finfo->entry;
+    const PHYSFS_uint64 complen = entry->compressed_size;
+    PHYSFS_Io *io = finfo->io;
+    const PHYSFS_uint8 *mapped = NULL;
+    PHYSFS_uint8 *compressed = NULL;
+    PHYSFS_uint64 mappedlen = 0;
+    PHYSFS_ErrorCode prevErr;
 
-    /*
-     * The first thing in a zip file might be the signature of the
-     *  first local file record, so it makes for a quick determination.
-     */
-    if (readui32(io, &sig))
+    if (!zip_can_inflate_whole(finfo))
+        return 0;
+
+    /* a failed map is no error as far as our caller is concerned. */
+    prevErr = PHYSFS_getLastErrorCode();
+    if (!__PHYSFS_ioMap(io, (const void **) &mapped, &mappedlen))
+        mapped = NULL;
+    else if ((entry->offset > mappedlen) ||
+             (complen > mappedlen - entry->offset))
+        mapped = NULL;
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    if (mapped != NULL)
     {
-        retval = (sig == ZIP_LOCAL_FILE_SIG);
-        if (!retval)
-        {
-            /*
-             * No sig...might be a ZIP with data at the start
-             *  (a self-extracting executable, etc), so we'll have to do
-             *  it the hard way...
-             */
-            retval = (zip_find_end_of_central_dir(io, NULL) != -1);
-        } /* if */
+        if (!zip_inflate_all(finfo, mapped + entry->offset, buf))
+            return 0;
+        /* keep the i/o position where we say it is. */
+        io->seek(io, entry->offset + complen);
+        return 1;
     } /* if */
 
-    return retval;
-} /* isZip */
+    if (!__PHYSFS_ui64FitsAddressSpace(complen))
+        return 0;
+    compressed = (PHYSFS_uint8 *) allocator.Malloc((size_t) complen);
+    if (compressed == NULL)
+        return 0;
+    else if ( (!__PHYSFS_readAll(io, compressed, complen)) ||
+              (!zip_inflate_all(finfo, compressed, buf)) )
+    {
+        allocator.Free(compressed);
+        io->seek(io, entry->offset);
+        return 0;
+    } /* else if */
 
+    allocator.Free(compressed);
+    return 1;
+} /* zip_inflate_whole */
 
-/* Find the ZIPentry for a path in platform-independent notation. */
-static ZIPentry *zip_find_entry(ZIPinfo *info, const char *path)
+
+/*
+ * If (finfo)'s buffer is used up, read the next chunk of compressed data into
+ *  it. Returns zero on i/o error; running out of compressed data isn't one.
+ *  The z_stream's next_in/avail_in are the buffer's cursor for every method.
+ */
+static int zip_refill_buffer(ZIPfileinfo *finfo)
 {
-    PHYSFS_uint32 hashval;
-    ZIPentry *prev = NULL;
-    ZIPentry *retval;
+    const ZIPentry *entry = finfo->entry;
+    PHYSFS_sint64 br;
 
-    if (*path == '\0')
-        return &info->root;
+    if (finfo->stream.avail_in > 0)
+        return 1;
 
-    hashval = zip_hash_string(info, path);
-    for (retval = info->hash[hashval]; retval; retval = retval->hashnext)
+    br = entry->compressed_size - finfo->compressed_position;
+    if (br > 0)
     {
-        if (strcmp(retval->name, path) == 0)
-        {
-            if (prev != NULL)  /* move this to the front of the list */
-            {
-                prev->hashnext = retval->hashnext;
-                retval->hashnext = info->hash[hashval];
-                info->hash[hashval] = retval;
-            } /* if */
+        if (br > ZIP_READBUFSIZE)
+            br = ZIP_READBUFSIZE;
 
-            return retval;
-        } /* if */
+        br = zip_read_decrypt(finfo, finfo->buffer, (PHYSFS_uint64) br);
+        if (br <= 0)
+            return 0;
 
-        prev = retval;
-    } /* for */
+        finfo->compressed_position += (PHYSFS_uint64) br;
+        finfo->stream.next_in = finfo->buffer;
+        finfo->stream.avail_in = (PHYSFS_uint32) br;
+    } /* if */
 
-    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, NULL);
-} /* zip_find_entry */
+    return 1;
+} /* zip_refill_buffer */
 
 
-/* Convert paths from old, buggy DOS zippers... */
-static void zip_convert_dos_path(ZIPentry *entry, char *path)
+#if PHYSFS_SUPPORTS_ZIP_ZSTD
+static PHYSFS_sint64 zip_read_zstd(ZIPfileinfo *finfo, void *buf,
+                                   PHYSFS_uint64 len)
 {
-    PHYSFS_uint8 hosttype = (PHYSFS_uint8) ((entry->version >> 8) & 0xFF);
-    if (hosttype == 0)  /* FS_FAT_ */
+    ZSTD_DStream *dstream;
+    ZSTD_outBuffer out;
+
+    if (finfo->decoder_method != COMPMETH_ZSTD)
+        zip_free_decoder(finfo);  /* a spare that did something else. */
+
+    if (finfo->decoder == NULL)
     {
-        while (*path)
+        dstream = ZSTD_createDStream();
+        BAIL_IF_MACRO(!dstream, PHYSFS_ERR_OUT_OF_MEMORY, -1);
+        if (ZSTD_isError(ZSTD_initDStream(dstream)))
         {
-            if (*path == '\\')
-                *path = '/';
-            path++;
-        } /* while */
+            ZSTD_freeDStream(dstream);
+            BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, -1);
+        } /* if */
+        finfo->decoder = dstream;
+        finfo->decoder_method = COMPMETH_ZSTD;
     } /* if */
-} /* zip_convert_dos_path */
 
+    dstream = (ZSTD_DStream *) finfo->decoder;
+    out.dst = buf;
+    out.size = (size_t) len;
+    out.pos = 0;
 
-static void zip_expand_symlink_path(char *path)
-{
-    char *ptr = path;
-    char *prevptr = path;
-
-    while (1)
+    while (out.pos < out.size)
     {
-        ptr = strchr(ptr, '/');
-        if (ptr == NULL)
-            break;
-
-        if (*(ptr + 1) == '.')
-        {
-            if (*(ptr + 2) == '/')
-            {
-                /* current dir in middle of string: ditch it. */
-                memmove(ptr, ptr + 2, strlen(ptr + 2) + 1);
-            } /* else if */
+        const size_t before = out.pos;
+        ZSTD_inBuffer in;
+        size_t rc;
 
-            else if (*(ptr + 2) == '\0')
-            {
-                /* current dir at end of string: ditch it. */
-                *ptr = '\0';
-            } /* else if */
+        if (!zip_refill_buffer(finfo))
+            break;
 
-            else if (*(ptr + 2) == '.')
-            {
-                if (*(ptr + 3) == '/')
-                {
-                    /* parent dir in middle: move back one, if possible. */
-                    memmove(prevptr, ptr + 4, strlen(ptr + 4) + 1);
-                    ptr = prevptr;
-                    while (prevptr != path)
-                    {
-                        prevptr--;
-                        if (*prevptr == '/')
-                        {
-                            prevptr++;
-                            break;
-                        } /* if */
-                    } /* while */
-                } /* if */
+        in.src = finfo->stream.next_in;
+        in.size = finfo->stream.avail_in;
+        in.pos = 0;
+        rc = ZSTD_decompressStream(dstream, &out, &in);
+        finfo->stream.next_in += in.pos;
+        finfo->stream.avail_in -= (PHYSFS_uint32) in.pos;
 
-                if (*(ptr + 3) == '\0')
-                {
-                    /* parent dir at end: move back one, if possible. */
-                    *prevptr = '\0';
-                } /* if */
-            } /* if */
+        if (ZSTD_isError(rc))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            break;
         } /* if */
-        else
+
+        else if ((in.pos == 0) && (out.pos == before))
         {
-            prevptr = ptr;
-            ptr++;
-        } /* else */
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* truncated. */
+            break;
+        } /* else if */
     } /* while */
-} /* zip_expand_symlink_path */
 
-/* (forward reference: zip_follow_symlink and zip_resolve call each other.) */
-static int zip_resolve(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry);
+    return ((out.pos == 0) ? -1 : (PHYSFS_sint64) out.pos);
+} /* zip_read_zstd */
+#endif
 
-/*
- * Look for the entry named by (path). If it exists, resolve it, and return
- *  a pointer to that entry. If it's another symlink, keep resolving until you
- *  hit a real file and then return a pointer to the final non-symlink entry.
- *  If there's a problem, return NULL.
- */
-static ZIPentry *zip_follow_symlink(PHYSFS_Io *io, ZIPinfo *info, char *path)
+
+#if PHYSFS_SUPPORTS_ZIP_LZ4
+static PHYSFS_sint64 zip_read_lz4(ZIPfileinfo *finfo, void *buf,
+                                  PHYSFS_uint64 len)
 {
-    ZIPentry *entry;
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+    PHYSFS_uint64 retval = 0;
+    LZ4F_dctx *dctx;
 
-    zip_expand_symlink_path(path);
-    entry = zip_find_entry(info, path);
-    if (entry != NULL)
+    if (finfo->decoder_method != COMPMETH_LZ4)
+        zip_free_decoder(finfo);  /* a spare that did something else. */
+
+    if (finfo->decoder == NULL)
     {
-        if (!zip_resolve(io, info, entry))  /* recursive! */
-            entry = NULL;
-        else
-        {
-            if (entry->symlink != NULL)
-                entry = entry->symlink;
-        } /* else */
+        const LZ4F_errorCode_t rc = LZ4F_createDecompressionContext(&dctx,
+                                                                 LZ4F_VERSION);
+        BAIL_IF_MACRO(LZ4F_isError(rc), PHYSFS_ERR_OUT_OF_MEMORY, -1);
+        finfo->decoder = dctx;
+        finfo->decoder_method = COMPMETH_LZ4;
     } /* if */
 
-    return entry;
-} /* zip_follow_symlink */
+    dctx = (LZ4F_dctx *) finfo->decoder;
 
+    while (retval < len)
+    {
+        size_t outlen = (size_t) (len - retval);
+        size_t inlen;
+        size_t rc;
 
-static int zip_resolve_symlink(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry)
-{
-    const PHYSFS_uint64 size = entry->uncompressed_size;
-    char *path = NULL;
-    int rc = 0;
+        if (!zip_refill_buffer(finfo))
+            break;
 
-    /*
-     * We've already parsed the local file header of the symlink at this
-     *  point. Now we need to read the actual link from the file data and
-     *  follow it.
-     */
+        inlen = finfo->stream.avail_in;
+        rc = LZ4F_decompress(dctx, ptr + retval, &outlen,
+                             finfo->stream.next_in, &inlen, NULL);
+        finfo->stream.next_in += inlen;
+        finfo->stream.avail_in -= (PHYSFS_uint32) inlen;
+        retval += outlen;
 
-    BAIL_IF_MACRO(!io->seek(io, entry->offset), ERRPASS, 0);
+        if (LZ4F_isError(rc))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+            break;
+        } /* if */
 
-    path = (char *) __PHYSFS_smallAlloc(size + 1);
-    BAIL_IF_MACRO(!path, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    
-    if (entry->compression_method == COMPMETH_NONE)
-        rc = __PHYSFS_readAll(io, path, size);
+        else if ((inlen == 0) && (outlen == 0))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);  /* truncated. */
+            break;
+        } /* else if */
+    } /* while */
 
-    else  /* symlink target path is compressed... */
+    return ((retval == 0) ? -1 : (PHYSFS_sint64) retval);
+} /* zip_read_lz4 */
+#endif
+
+
+static PHYSFS_sint64 ZIP_read(PHYSFS_Io *_io, void *buf, PHYSFS_uint64 len)
+{
+    ZIPfileinfo *finfo = (ZIPfileinfo *) _io->opaque;
+    ZIPentry *entry = finfo->entry;
+    const int compressed = (entry->compression_method != COMPMETH_NONE);
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_sint64 maxread = (PHYSFS_sint64) len;
+    PHYSFS_sint64 avail = (PHYSFS_sint64) (entry->uncompressed_size -
+                                           finfo->uncompressed_position);
+
+    if (avail < maxread)
+        maxread = avail;
+
+    BAIL_IF_MACRO(maxread == 0, ERRPASS, 0);    /* quick rejection. */
+
+    if (compressed)
     {
-        z_stream stream;
-        const PHYSFS_uint64 complen = entry->compressed_size;
-        PHYSFS_uint8 *compressed = (PHYSFS_uint8*) __PHYSFS_smallAlloc(complen);
-        if (compressed != NULL)
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_DECOMPRESS,
+                             zip_entry_name(finfo->info, entry), NULL, maxread);
+    } /* if */
+
+    if (!compressed)
+        retval = zip_read_decrypt(finfo, buf, maxread);
+#if PHYSFS_SUPPORTS_ZIP_ZSTD
+    else if (zip_entry_is_zstd(entry))
+        retval = zip_read_zstd(finfo, buf, (PHYSFS_uint64) maxread);
+#endif
+#if PHYSFS_SUPPORTS_ZIP_LZ4
+    else if (zip_entry_is_lz4(entry))
+        retval = zip_read_lz4(finfo, buf, (PHYSFS_uint64) maxread);
+#endif
+    else if ((maxread == entry->uncompressed_size) &&
+             (zip_inflate_whole(finfo, buf)))
+        retval = maxread;
+    else
+    {
+        PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+
+        finfo->stream.avail_out = 0;
+        while (retval < maxread)
         {
-            if (__PHYSFS_readAll(io, compressed, complen))
+            PHYSFS_uint32 before = finfo->stream.total_out;
+            int rc;
+
+            if (__PHYSFS_asyncCancelled())
             {
-                initializeZStream(&stream);
-                stream.next_in = compressed;
-                stream.avail_in = complen;
-                stream.next_out = (unsigned char *) path;
-                stream.avail_out = size;
-                if (zlib_err(inflateInit2(&stream, -MAX_WBITS)) == Z_OK)
-                {
-                    rc = zlib_err(inflate(&stream, Z_FINISH));
-                    inflateEnd(&stream);
+                PHYSFS_setErrorCode(PHYSFS_ERR_CANCELLED);
+                if (retval == 0)
+                    retval = -1;
+                break;
+            } /* if */
 
-                    /* both are acceptable outcomes... */
-                    rc = ((rc == Z_OK) || (rc == Z_STREAM_END));
-                } /* if */
+            if (!zip_refill_buffer(finfo))
+                break;
+
+            /* z_stream counts in uInts, so go a gigabyte at a time. */
+            if (finfo->stream.avail_out == 0)
+            {
+                const PHYSFS_sint64 left = maxread - retval;
+                finfo->stream.next_out = ptr + retval;
+                finfo->stream.avail_out = (uInt) ((left > 0x40000000) ?
+                                                    0x40000000 : left);
             } /* if */
-            __PHYSFS_smallFree(compressed);
-        } /* if */
+
+            rc = zlib_err(inflate(&finfo->stream, Z_SYNC_FLUSH));
+            retval += (finfo->stream.total_out - before);
+
+            if (rc != Z_OK)
+                break;
+
+            if (finfo->checkpoint_interval)
+            {
+                zip_add_checkpoint(finfo, finfo->uncompressed_position +
+                                          (PHYSFS_uint64) retval);
+            } /* if */
+        } /* while */
     } /* else */
 
-    if (rc)
+    if (retval > 0)
     {
-        path[entry->uncompressed_size] = '\0';    /* null-terminate it. */
-        zip_convert_dos_path(entry, path);
-        entry->symlink = zip_follow_symlink(io, info, path);
-    } /* else */
+        const PHYSFS_uint64 pos = finfo->uncompressed_position;
+        finfo->uncompressed_position += (PHYSFS_uint64) retval;
+        if (compressed)
+            __PHYSFS_STAT_ADD(bytesDecompressedZip, retval);
+        if (!__PHYSFS_crcCheckRead(&finfo->crccheck, buf,
+                                   (PHYSFS_uint64) retval, pos,
+                                   entry->uncompressed_size, entry->crc))
+            retval = -1;
+    } /* if */
 
-    __PHYSFS_smallFree(path);
+    if (compressed)
+    {
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_DECOMPRESS,
+                           zip_entry_name(finfo->info, entry), NULL,
+                           retval, retval >= 0);
+    } /* if */
 
-    return (entry->symlink != NULL);
-} /* zip_resolve_symlink */
+    return retval;
+} /* ZIP_read */
 
 
-/*
- * Parse the local file header of an entry, and update entry->offset.
- */
-static int zip_parse_local(PHYSFS_Io *io, ZIPentry *entry)
+static PHYSFS_sint64 ZIP_write(PHYSFS_Io *io, const void *b, PHYSFS_uint64 len)
 {
-    PHYSFS_uint32 ui32;
-    PHYSFS_uint16 ui16;
-    PHYSFS_uint16 fnamelen;
-    PHYSFS_uint16 extralen;
+    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, -1);
+} /* ZIP_write */
 
-    /*
-     * crc and (un)compressed_size are always zero if this is a "JAR"
-     *  archive created with Sun's Java tools, apparently. We only
-     *  consider this archive corrupted if those entries don't match and
-     *  aren't zero. That seems to work well.
-     * We also ignore a mismatch if the value is 0xFFFFFFFF here, since it's
-     *  possible that's a Zip64 thing.
-     */
 
-    /* !!! FIXME: apparently these are zero if general purpose bit 3 is set,
-       !!! FIXME:  which is probably true for Jar files, fwiw, but we don't
-       !!! FIXME:  care about these values anyhow. */
+static PHYSFS_sint64 ZIP_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((ZIPfileinfo *) io->opaque)->uncompressed_position;
+} /* ZIP_tell */
 
-    BAIL_IF_MACRO(!io->seek(io, entry->offset), ERRPASS, 0);
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != ZIP_LOCAL_FILE_SIG, PHYSFS_ERR_CORRUPT, 0);
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
-    BAIL_IF_MACRO(ui16 != entry->version_needed, PHYSFS_ERR_CORRUPT, 0);
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);  /* general bits. */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
-    BAIL_IF_MACRO(ui16 != entry->compression_method, PHYSFS_ERR_CORRUPT, 0);
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);  /* date/time */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 && (ui32 != entry->crc), PHYSFS_ERR_CORRUPT, 0);
 
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 && (ui32 != 0xFFFFFFFF) &&
-                  (ui32 != entry->compressed_size), PHYSFS_ERR_CORRUPT, 0);
+/* Decode and throw away everything from where (_io) is up to (offset). */
+static int zip_read_forward(PHYSFS_Io *_io, const PHYSFS_uint64 offset)
+{
+    ZIPfileinfo *finfo = (ZIPfileinfo *) _io->opaque;
 
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 && (ui32 != 0xFFFFFFFF) &&
-                 (ui32 != entry->uncompressed_size), PHYSFS_ERR_CORRUPT, 0);
+    while (finfo->uncompressed_position != offset)
+    {
+        PHYSFS_uint8 buf[512];
+        PHYSFS_uint64 maxread;
 
-    BAIL_IF_MACRO(!readui16(io, &fnamelen), ERRPASS, 0);
-    BAIL_IF_MACRO(!readui16(io, &extralen), ERRPASS, 0);
+        maxread = offset - finfo->uncompressed_position;
+        if (maxread > sizeof (buf))
+            maxread = sizeof (buf);
+
+        if (ZIP_read(_io, buf, maxread) != maxread)
+            return 0;
+    } /* while */
 
-    entry->offset += fnamelen + extralen + 30;
     return 1;
-} /* zip_parse_local */
+} /* zip_read_forward */
 
 
-static int zip_resolve(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry)
+static int ZIP_seek(PHYSFS_Io *_io, PHYSFS_uint64 offset)
 {
-    int retval = 1;
-    const ZipResolveType resolve_type = entry->resolved;
-
-    if (resolve_type == ZIP_DIRECTORY)
-        return 1;   /* we're good. */
+    ZIPfileinfo *finfo = (ZIPfileinfo *) _io->opaque;
+    ZIPentry *entry = finfo->entry;
+    PHYSFS_Io *io = finfo->io;
+    const int encrypted = zip_entry_is_tradional_crypto(entry);
 
-    /* Don't bother if we've failed to resolve this entry before. */
-    BAIL_IF_MACRO(resolve_type == ZIP_BROKEN_FILE, PHYSFS_ERR_CORRUPT, 0);
-    BAIL_IF_MACRO(resolve_type == ZIP_BROKEN_SYMLINK, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(offset > entry->uncompressed_size, PHYSFS_ERR_PAST_EOF, 0);
 
-    /* uhoh...infinite symlink loop! */
-    BAIL_IF_MACRO(resolve_type == ZIP_RESOLVING, PHYSFS_ERR_SYMLINK_LOOP, 0);
+    if (!encrypted && (entry->compression_method == COMPMETH_NONE))
+    {
+        PHYSFS_sint64 newpos = offset + entry->offset;
+        BAIL_IF_MACRO(!io->seek(io, newpos), ERRPASS, 0);
+        finfo->uncompressed_position = offset;
+    } /* if */
 
-    /*
-     * We fix up the offset to point to the actual data on the
-     *  first open, since we don't want to seek across the whole file on
-     *  archive open (can be SLOW on large, CD-stored files), but we
-     *  need to check the local file header...not just for corruption,
-     *  but since it stores offset info the central directory does not.
-     */
-    if (resolve_type != ZIP_RESOLVED)
+    else if (entry->compression_method == COMPMETH_NONE)  /* encrypted. */
     {
-        entry->resolved = ZIP_RESOLVING;
+        /* restart from the last key checkpoint at or before (offset)... */
+        PHYSFS_uint64 idx = offset / ZIP_CRYPTO_CHECKPOINT_INTERVAL;
+        PHYSFS_uint64 start;
 
-        retval = zip_parse_local(io, entry);
-        if (retval)
+        if (idx > finfo->crypto_checkpoint_count)
+            idx = finfo->crypto_checkpoint_count;
+        start = idx * ZIP_CRYPTO_CHECKPOINT_INTERVAL;
+
+        /* ...unless we're already between there and (offset). */
+        if ((offset < finfo->uncompressed_position) ||
+            (start > finfo->uncompressed_position))
         {
-            /*
-             * If it's a symlink, find the original file. This will cause
-             *  resolution of other entries (other symlinks and, eventually,
-             *  the real file) if all goes well.
-             */
-            if (resolve_type == ZIP_UNRESOLVED_SYMLINK)
-                retval = zip_resolve_symlink(io, info, entry);
-        } /* if */
+            if (offset < finfo->uncompressed_position)
+                __PHYSFS_STAT_INCR(zipBackwardSeeks);
 
-        if (resolve_type == ZIP_UNRESOLVED_SYMLINK)
-            entry->resolved = ((retval) ? ZIP_RESOLVED : ZIP_BROKEN_SYMLINK);
-        else if (resolve_type == ZIP_UNRESOLVED_FILE)
-            entry->resolved = ((retval) ? ZIP_RESOLVED : ZIP_BROKEN_FILE);
-    } /* if */
+            start += entry->offset + 12;  /* past the crypto header. */
+            BAIL_IF_MACRO(!io->seek(io, start), ERRPASS, 0);
+            if (idx == 0)
+                memcpy(finfo->crypto_keys, finfo->initial_crypto_keys, 12);
+            else
+            {
+                memcpy(finfo->crypto_keys,
+                       finfo->crypto_checkpoints + ((idx - 1) * 3), 12);
+            } /* else */
+            finfo->uncompressed_position = idx * ZIP_CRYPTO_CHECKPOINT_INTERVAL;
+        } /* if */
 
-    return retval;
-} /* zip_resolve */
+        BAIL_IF_MACRO(!zip_read_forward(_io, offset), ERRPASS, 0);
+    } /* else if */
 
+    else
+    {
+        const ZIPcheckpoint *cp;
+        const ZIPcheckpoint *stored;
+        int rewind = (offset < finfo->uncompressed_position);
 
-static int zip_hash_entry(ZIPinfo *info, ZIPentry *entry);
+        if (rewind)
+            __PHYSFS_STAT_INCR(zipBackwardSeeks);
 
-/* Fill in missing parent directories. */
-static ZIPentry *zip_hash_ancestors(ZIPinfo *info, char *name)
-{
-    ZIPentry *retval = &info->root;
-    char *sep = strrchr(name, '/');
+        cp = zip_find_checkpoint(finfo->checkpoints,
+                                 finfo->checkpoint_count, offset);
+        stored = NULL;
+        if (entry->stored != NULL)
+        {
+            stored = zip_find_checkpoint(entry->stored->checkpoints,
+                                         entry->stored->count, offset);
+        } /* if */
 
-    if (sep)
-    {
-        const size_t namelen = (sep - name) + 1;
+        if ((stored != NULL) && ((cp == NULL) ||
+            (stored->uncompressed_position > cp->uncompressed_position)))
+            cp = stored;
 
-        *sep = '\0';  /* chop off last piece. */
-        retval = zip_find_entry(info, name);
-        *sep = '/';
+        /*
+         * If seeking backwards, we need to redecode the file
+         *  from the start and throw away the compressed bits until we hit
+         *  the offset we need. If seeking forward, we still need to
+         *  decode, but we don't rewind first. Either way, if there's a
+         *  checkpoint between here and there, we start from that instead.
+         */
+        if ((cp != NULL) && ((rewind) ||
+            (cp->uncompressed_position > finfo->uncompressed_position)))
+            rewind = !zip_resume_checkpoint(finfo, cp);  /* or start over. */
 
-        if (retval != NULL)
+        if (rewind)
         {
-            if (retval->resolved != ZIP_DIRECTORY)
-                BAIL_MACRO(PHYSFS_ERR_CORRUPT, NULL);
-            return retval;  /* already hashed. */
-        } /* if */
+            if (!io->seek(io, entry->offset + (encrypted ? 12 : 0)))
+                return 0;
+
+            zip_reset_inflater(finfo);
+            finfo->uncompressed_position = finfo->compressed_position = 0;
 
-        /* okay, this is a new dir. Build and hash us. */
-        retval = (ZIPentry *) allocator.Malloc(sizeof (ZIPentry) + namelen);
-        BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-        memset(retval, '\0', sizeof (*retval));
-        retval->name = ((char *) retval) + sizeof (ZIPentry);
-        memcpy(retval->name, name, namelen);
-        retval->name[namelen] = '\0';
-        retval->resolved = ZIP_DIRECTORY;
-        if (!zip_hash_entry(info, retval))
-        {
-            allocator.Free(retval);
-            return NULL;
+            if (encrypted)
+                memcpy(finfo->crypto_keys, finfo->initial_crypto_keys, 12);
         } /* if */
+
+        BAIL_IF_MACRO(!zip_read_forward(_io, offset), ERRPASS, 0);
     } /* else */
 
-    return retval;
-} /* zip_hash_ancestors */
+    return 1;
+} /* ZIP_seek */
 
 
-static int zip_hash_entry(ZIPinfo *info, ZIPentry *entry)
+static PHYSFS_sint64 ZIP_length(PHYSFS_Io *io)
 {
-    PHYSFS_uint32 hashval;
-    ZIPentry *parent;
+    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    return (PHYSFS_sint64) finfo->entry->uncompressed_size;
+} /* ZIP_length */
 
-    assert(!zip_find_entry(info, entry->name));  /* checked elsewhere */
 
-    parent = zip_hash_ancestors(info, entry->name);
-    if (!parent)
-        return 0;
+static PHYSFS_Io *zip_get_io(PHYSFS_Io *io, ZIPinfo *inf, ZIPentry *entry);
 
-    hashval = zip_hash_string(info, entry->name);
-    entry->hashnext = info->hash[hashval];
-    info->hash[hashval] = entry;
+/*
+ * Make (finfo)'s inflater a copy of (orig)'s, mid-stream, along with the
+ *  compressed bytes (orig) has read but not inflated yet. With miniz, the
+ *  inflate_state is flat, same as for checkpoints, so this is just copying.
+ *  Returns zero if we're out of memory, and (finfo) can only be freed.
+ */
+static int zip_clone_inflater(ZIPfileinfo *finfo, ZIPfileinfo *orig)
+{
+    const unsigned int avail = orig->stream.avail_in;
 
-    entry->sibling = parent->children;
-    parent->children = entry;
+    if (zlib_err(__PHYSFS_inflateCopy(&finfo->stream, &orig->stream)) != Z_OK)
+        return 0;
+    memcpy(finfo->buffer, orig->stream.next_in, avail);
+    finfo->stream.next_in = finfo->buffer;
+    finfo->stream.avail_in = avail;
+    finfo->stream.total_in = orig->stream.total_in;
+    finfo->stream.total_out = orig->stream.total_out;
+    finfo->compressed_position = orig->compressed_position;
+    finfo->uncompressed_position = orig->uncompressed_position;
     return 1;
-} /* zip_hash_entry */
+} /* zip_clone_inflater */
 
 
-static int zip_entry_is_symlink(const ZIPentry *entry)
+static PHYSFS_Io *ZIP_duplicate(PHYSFS_Io *io)
 {
-    return ((entry->resolved == ZIP_UNRESOLVED_SYMLINK) ||
-            (entry->resolved == ZIP_BROKEN_SYMLINK) ||
-            (entry->symlink));
-} /* zip_entry_is_symlink */
+    ZIPfileinfo *origfinfo = (ZIPfileinfo *) io->opaque;
+    PHYSFS_Io *retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    ZIPfileinfo *finfo = zip_alloc_fileinfo(origfinfo->info, origfinfo->entry);
+    const ZIPentry *entry = origfinfo->entry;
+    const PHYSFS_uint64 start = entry->offset +
+                    (zip_entry_is_tradional_crypto(entry) ? 12 : 0);
 
+    GOTO_IF_MACRO(!retval, ERRPASS, failed);
+    GOTO_IF_MACRO(!finfo, ERRPASS, failed);
 
-static int zip_version_does_symlinks(PHYSFS_uint32 version)
-{
-    int retval = 0;
-    PHYSFS_uint8 hosttype = (PHYSFS_uint8) ((version >> 8) & 0xFF);
+    finfo->io = zip_get_io(origfinfo->io, NULL, finfo->entry);
+    GOTO_IF_MACRO(!finfo->io, ERRPASS, failed);
+    finfo->seekindex = origfinfo->seekindex;
 
-    switch (hosttype)
+    memcpy(retval, io, sizeof (PHYSFS_Io));
+    retval->opaque = finfo;
+
+    /*
+     * Start the copy where the original is, so whoever duplicated a handle
+     *  mid-stream doesn't pay to decode everything up to there again. The
+     *  decoded bytes so far are all in (origfinfo)'s state: the crypto keys,
+     *  the inflater, and the compressed bytes it hasn't eaten yet.
+     */
+    memcpy(finfo->initial_crypto_keys, origfinfo->initial_crypto_keys, 12);
+    memcpy(finfo->crypto_keys, origfinfo->crypto_keys, 12);
+    memcpy(&finfo->crccheck, &origfinfo->crccheck, sizeof (finfo->crccheck));
+
+    if (entry->compression_method == COMPMETH_NONE)
     {
-            /*
-             * These are the platforms that can NOT build an archive with
-             *  symlinks, according to the Info-ZIP project.
-             */
-        case 0:  /* FS_FAT_  */
-        case 1:  /* AMIGA_   */
-        case 2:  /* VMS_     */
-        case 4:  /* VM_CSM_  */
-        case 6:  /* FS_HPFS_ */
-        case 11: /* FS_NTFS_ */
-        case 14: /* FS_VFAT_ */
-        case 13: /* ACORN_   */
-        case 15: /* MVS_     */
-        case 18: /* THEOS_   */
-            break;  /* do nothing. */
+        finfo->uncompressed_position = origfinfo->uncompressed_position;
+        GOTO_IF_MACRO(!finfo->io->seek(finfo->io,
+                                       start + finfo->uncompressed_position),
+                      ERRPASS, failed);
+    } /* if */
 
-        default:  /* assume the rest to be unix-like. */
-            retval = 1;
-            break;
-    } /* switch */
+    else if (zip_entry_is_deflated(entry))
+    {
+        GOTO_IF_MACRO(!zip_clone_inflater(finfo, origfinfo), ERRPASS, failed);
+        GOTO_IF_MACRO(!finfo->io->seek(finfo->io,
+                                       start + finfo->compressed_position),
+                      ERRPASS, failed);
+    } /* else if */
+
+    else  /* zstd and LZ4 can't be copied, so decode our way there. */
+    {
+        memcpy(finfo->crypto_keys, finfo->initial_crypto_keys, 12);
+        __PHYSFS_crcCheckInit(&finfo->crccheck);
+        GOTO_IF_MACRO(!finfo->io->seek(finfo->io, start), ERRPASS, failed);
+        GOTO_IF_MACRO(!ZIP_seek(retval, origfinfo->uncompressed_position),
+                      ERRPASS, failed);
+    } /* else */
 
     return retval;
-} /* zip_version_does_symlinks */
 
+failed:
+    if (finfo != NULL)
+    {
+        if (finfo->io != NULL)
+            finfo->io->destroy(finfo->io);
+        zip_free_fileinfo(finfo);
+    } /* if */
 
-static int zip_has_symlink_attr(ZIPentry *entry, PHYSFS_uint32 extern_attr)
-{
-    PHYSFS_uint16 xattr = ((extern_attr >> 16) & 0xFFFF);
-    return ( (zip_version_does_symlinks(entry->version)) &&
-             (entry->uncompressed_size > 0) &&
-             ((xattr & UNIX_FILETYPE_MASK) == UNIX_FILETYPE_SYMLINK) );
-} /* zip_has_symlink_attr */
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
+    return NULL;
+} /* ZIP_duplicate */
 
+static int ZIP_flush(PHYSFS_Io *io) { return 1;  /* no write support. */ }
 
-static PHYSFS_sint64 zip_dos_time_to_physfs_time(PHYSFS_uint32 dostime)
+static void ZIP_destroy(PHYSFS_Io *io)
 {
-    PHYSFS_uint32 dosdate;
-    struct tm unixtime;
-    memset(&unixtime, '\0', sizeof (unixtime));
-
-    dosdate = (PHYSFS_uint32) ((dostime >> 16) & 0xFFFF);
-    dostime &= 0xFFFF;
-
-    /* dissect date */
-    unixtime.tm_year = ((dosdate >> 9) & 0x7F) + 80;
-    unixtime.tm_mon  = ((dosdate >> 5) & 0x0F) - 1;
-    unixtime.tm_mday = ((dosdate     ) & 0x1F);
-
-    /* dissect time */
-    unixtime.tm_hour = ((dostime >> 11) & 0x1F);
-    unixtime.tm_min  = ((dostime >>  5) & 0x3F);
-    unixtime.tm_sec  = ((dostime <<  1) & 0x3E);
+    ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    finfo->io->destroy(finfo->io);
+    zip_free_fileinfo(finfo);
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
+} /* ZIP_destroy */
 
-    /* let mktime calculate daylight savings time. */
-    unixtime.tm_isdst = -1;
 
-    return ((PHYSFS_sint64) mktime(&unixtime));
-} /* zip_dos_time_to_physfs_time */
+static int ZIP_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    const ZIPentry *entry = finfo->entry;
+    const PHYSFS_uint8 *archptr = NULL;
+    PHYSFS_uint64 archlen = 0;
 
+    /* only stored, unencrypted entries are sitting there verbatim. */
+    BAIL_IF_MACRO(entry->compression_method != COMPMETH_NONE,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(zip_entry_is_tradional_crypto(entry),
+                  PHYSFS_ERR_UNSUPPORTED, 0);
 
-static ZIPentry *zip_load_entry(PHYSFS_Io *io, const int zip64,
-                                const PHYSFS_uint64 ofs_fixup)
-{
-    ZIPentry entry;
-    ZIPentry *retval = NULL;
-    PHYSFS_uint16 fnamelen, extralen, commentlen;
-    PHYSFS_uint32 external_attr;
-    PHYSFS_uint32 starting_disk;
-    PHYSFS_uint64 offset;
-    PHYSFS_uint16 ui16;
-    PHYSFS_uint32 ui32;
-    PHYSFS_sint64 si64;
+    if (!__PHYSFS_ioMap(finfo->io, (const void **) &archptr, &archlen))
+        return 0;
 
-    memset(&entry, '\0', sizeof (entry));
+    BAIL_IF_MACRO(entry->offset > archlen, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(entry->uncompressed_size > archlen - entry->offset,
+                  PHYSFS_ERR_CORRUPT, 0);
 
-    /* sanity check with central directory signature... */
-    if (!readui32(io, &ui32)) return NULL;
-    BAIL_IF_MACRO(ui32 != ZIP_CENTRAL_DIR_SIG, PHYSFS_ERR_CORRUPT, NULL);
+    *ptr = archptr + entry->offset;
+    *len = entry->uncompressed_size;
+    return 1;
+} /* ZIP_map */
 
-    /* Get the pertinent parts of the record... */
-    if (!readui16(io, &entry.version)) return NULL;
-    if (!readui16(io, &entry.version_needed)) return NULL;
-    if (!readui16(io, &entry.general_bits)) return NULL;  /* general bits */
-    if (!readui16(io, &entry.compression_method)) return NULL;
-    if (!readui32(io, &entry.dos_mod_time)) return NULL;
-    entry.last_mod_time = zip_dos_time_to_physfs_time(entry.dos_mod_time);
-    if (!readui32(io, &entry.crc)) return NULL;
-    if (!readui32(io, &ui32)) return NULL;
-    entry.compressed_size = (PHYSFS_uint64) ui32;
-    if (!readui32(io, &ui32)) return NULL;
-    entry.uncompressed_size = (PHYSFS_uint64) ui32;
-    if (!readui16(io, &fnamelen)) return NULL;
-    if (!readui16(io, &extralen)) return NULL;
-    if (!readui16(io, &commentlen)) return NULL;
-    if (!readui16(io, &ui16)) return NULL;
-    starting_disk = (PHYSFS_uint32) ui16;
-    if (!readui16(io, &ui16)) return NULL;  /* internal file attribs */
-    if (!readui32(io, &external_attr)) return NULL;
-    if (!readui32(io, &ui32)) return NULL;
-    offset = (PHYSFS_uint64) ui32;
-
-    retval = (ZIPentry *) allocator.Malloc(sizeof (ZIPentry) + fnamelen + 1);
-    BAIL_IF_MACRO(retval == NULL, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    memcpy(retval, &entry, sizeof (*retval));
-    retval->name = ((char *) retval) + sizeof (ZIPentry);
-
-    if (!__PHYSFS_readAll(io, retval->name, fnamelen))
-        goto zip_load_entry_puked;
-
-    retval->name[fnamelen] = '\0';  /* null-terminate the filename. */
-    zip_convert_dos_path(retval, retval->name);
-
-    retval->symlink = NULL;  /* will be resolved later, if necessary. */
-
-    if (retval->name[fnamelen - 1] == '/')
-    {
-        retval->name[fnamelen - 1] = '\0';
-        retval->resolved = ZIP_DIRECTORY;
-    } /* if */
-    else
-    {
-        retval->resolved = (zip_has_symlink_attr(&entry, external_attr)) ?
-                                ZIP_UNRESOLVED_SYMLINK : ZIP_UNRESOLVED_FILE;
-    } /* else */
 
-    si64 = io->tell(io);
-    if (si64 == -1)
-        goto zip_load_entry_puked;
+static int ZIP_advise(PHYSFS_Io *io, PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                      int hint)
+{
+    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    const ZIPentry *entry = finfo->entry;
+    const PHYSFS_uint64 size = entry->compressed_size;
 
     /*
-     * The actual sizes didn't fit in 32-bits; look for the Zip64
-     *  extended information extra field...
+     * Only stored entries line up byte for byte with what's read from
+     *  them. For anything compressed, we can't tell which compressed
+     *  bytes a range needs without inflating, so hint about all of them.
      */
-    if ( (zip64) &&
-         ((offset == 0xFFFFFFFF) ||
-          (starting_disk == 0xFFFFFFFF) ||
-          (retval->compressed_size == 0xFFFFFFFF) ||
-          (retval->uncompressed_size == 0xFFFFFFFF)) )
-    {
-        int found = 0;
-        PHYSFS_uint16 sig, len;
-        while (extralen > 4)
-        {
-            if (!readui16(io, &sig))
-                goto zip_load_entry_puked;
-            else if (!readui16(io, &len))
-                goto zip_load_entry_puked;
+    if (entry->compression_method != COMPMETH_NONE)
+        offset = len = 0;
+    else if (offset >= size)
+        return 1;  /* nothing there to hint about. */
 
-            si64 += 4 + len;
-            extralen -= 4 + len;
-            if (sig != ZIP64_EXTENDED_INFO_EXTRA_FIELD_SIG)
-            {
-                if (!io->seek(io, si64))
-                    goto zip_load_entry_puked;
-                continue;
-            } /* if */
+    if ((len == 0) || (len > size - offset))
+        len = size - offset;
+    return __PHYSFS_ioAdvise(finfo->io, entry->offset + offset, len, hint);
+} /* ZIP_advise */
 
-            found = 1;
-            break;
-        } /* while */
 
-        GOTO_IF_MACRO(!found, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
+static int ZIP_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    const ZIPentry *entry = finfo->entry;
 
-        if (retval->uncompressed_size == 0xFFFFFFFF)
-        {
-            GOTO_IF_MACRO(len < 8, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
-            if (!readui64(io, &retval->uncompressed_size))
-                goto zip_load_entry_puked;
-            len -= 8;
-        } /* if */
+    /* same as ZIP_map(): only stored, unencrypted entries are verbatim. */
+    BAIL_IF_MACRO(entry->compression_method != COMPMETH_NONE,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(zip_entry_is_tradional_crypto(entry),
+                  PHYSFS_ERR_UNSUPPORTED, 0);
 
-        if (retval->compressed_size == 0xFFFFFFFF)
-        {
-            GOTO_IF_MACRO(len < 8, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
-            if (!readui64(io, &retval->compressed_size))
-                goto zip_load_entry_puked;
-            len -= 8;
-        } /* if */
+    if (!__PHYSFS_ioBacking(finfo->io, backing))
+        return 0;
 
-        if (offset == 0xFFFFFFFF)
-        {
-            GOTO_IF_MACRO(len < 8, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
-            if (!readui64(io, &offset))
-                goto zip_load_entry_puked;
-            len -= 8;
-        } /* if */
+    BAIL_IF_MACRO(entry->offset > backing->length, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(entry->uncompressed_size > backing->length - entry->offset,
+                  PHYSFS_ERR_CORRUPT, 0);
 
-        if (starting_disk == 0xFFFFFFFF)
-        {
-            GOTO_IF_MACRO(len < 8, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
-            if (!readui32(io, &starting_disk))
-                goto zip_load_entry_puked;
-            len -= 4;
-        } /* if */
+    backing->offset += entry->offset;
+    backing->length = entry->uncompressed_size;
+    return 1;
+} /* ZIP_backing */
 
-        GOTO_IF_MACRO(len != 0, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
-    } /* if */
 
-    GOTO_IF_MACRO(starting_disk != 0, PHYSFS_ERR_CORRUPT, zip_load_entry_puked);
+static PHYSFS_Io *ZIP_raw(PHYSFS_Io *io, int *encoding)
+{
+    const ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    const ZIPentry *entry = finfo->entry;
+    PHYSFS_Io *archio;
+    PHYSFS_Io *retval;
+
+    /* deflate's the only one worth handing out; HTTP knows it, for one. */
+    BAIL_IF_MACRO(entry->compression_method != COMPMETH_DEFLATE,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    BAIL_IF_MACRO(zip_entry_is_tradional_crypto(entry),
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+
+    archio = finfo->io->duplicate(finfo->io);
+    BAIL_IF_MACRO(!archio, ERRPASS, NULL);
+    retval = __PHYSFS_createSliceIo(archio, entry->offset,
+                                    entry->compressed_size);
+    if (retval == NULL)
+    {
+        archio->destroy(archio);
+        return NULL;
+    } /* if */
 
-    retval->offset = offset + ofs_fixup;
+    *encoding = (int) PHYSFS_ENCODING_DEFLATE;
+    return retval;
+} /* ZIP_raw */
 
-    /* seek to the start of the next entry in the central directory... */
-    if (!io->seek(io, si64 + extralen + commentlen))
-        goto zip_load_entry_puked;
 
-    return retval;  /* success. */
+static const PHYSFS_Io ZIP_Io =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    ZIP_read,
+    ZIP_write,
+    ZIP_seek,
+    ZIP_tell,
+    ZIP_length,
+    ZIP_duplicate,
+    ZIP_flush,
+    ZIP_destroy,
+    ZIP_map,
+    NULL,  /* readAt: compressed entries have to be inflated in order. */
+    NULL,  /* readv */
+    ZIP_advise,
+    ZIP_backing,
+    ZIP_raw
+};
 
-zip_load_entry_puked:
-    allocator.Free(retval);
-    return NULL;  /* failure. */
-} /* zip_load_entry */
 
 
-/* This leaves things allocated on error; the caller will clean up the mess. */
-static int zip_load_entries(ZIPinfo *info,
-                            const PHYSFS_uint64 data_ofs,
-                            const PHYSFS_uint64 central_ofs,
-                            const PHYSFS_uint64 entry_count)
+static PHYSFS_sint64 zip_find_end_of_central_dir(PHYSFS_Io *io, PHYSFS_sint64 *len)
 {
-    PHYSFS_Io *io = info->io;
-    const int zip64 = info->zip64;
-    PHYSFS_uint64 i;
+    PHYSFS_uint8 buf[256];
+    PHYSFS_uint8 extra[4] = { 0, 0, 0, 0 };
+    PHYSFS_sint32 i = 0;
+    PHYSFS_sint64 filelen;
+    PHYSFS_sint64 filepos;
+    PHYSFS_sint32 maxread;
+    PHYSFS_sint32 totalread = 0;
+    int found = 0;
 
-    if (!io->seek(io, central_ofs))
-        return 0;
+    filelen = io->length(io);
+    BAIL_IF_MACRO(filelen == -1, ERRPASS, -1);
 
-    for (i = 0; i < entry_count; i++)
+    /*
+     * Jump to the end of the file and start reading backwards.
+     *  The last thing in the file is the zipfile comment, which is variable
+     *  length, and the field that specifies its size is before it in the
+     *  file (argh!)...this means that we need to scan backwards until we
+     *  hit the end-of-central-dir signature. We can then sanity check that
+     *  the comment was as big as it should be to make sure we're in the
+     *  right place. The comment length field is 16 bits, so we can stop
+     *  searching for that signature after a little more than 64k at most,
+     *  and call it a corrupted zipfile.
+     */
+
+    if (sizeof (buf) < filelen)
+    {
+        filepos = filelen - sizeof (buf);
+        maxread = sizeof (buf);
+    } /* if */
+    else
     {
-        ZIPentry *entry = zip_load_entry(io, zip64, data_ofs);
-        ZIPentry *find;
+        filepos = 0;
+        maxread = (PHYSFS_uint32) filelen;
+    } /* else */
 
-        if (!entry)
-            return 0;
+    while ((totalread < filelen) && (totalread < 65557))
+    {
+        BAIL_IF_MACRO(!io->seek(io, filepos), ERRPASS, -1);
 
-        find = zip_find_entry(info, entry->name);
-        if (find != NULL)  /* duplicate? */
+        /* make sure we catch a signature between buffers. */
+        if (totalread != 0)
         {
-            if (find->last_mod_time != 0)  /* duplicate? */
-            {
-                allocator.Free(entry);
-                BAIL_MACRO(PHYSFS_ERR_CORRUPT, 0);
-            } /* if */
-            else  /* we filled this in as a placeholder. Update it. */
-            {
-                find->offset = entry->offset;
-                find->version = entry->version;
-                find->version_needed = entry->version_needed;
-                find->compression_method = entry->compression_method;
-                find->crc = entry->crc;
-                find->compressed_size = entry->compressed_size;
-                find->uncompressed_size = entry->uncompressed_size;
-                find->last_mod_time = entry->last_mod_time;
-                allocator.Free(entry);
-                continue;
-            } /* else */
+            if (!__PHYSFS_readAll(io, buf, maxread - 4))
+                return -1;
+            memcpy(&buf[maxread - 4], &extra, sizeof (extra));
+            totalread += maxread - 4;
         } /* if */
+        else
+        {
+            if (!__PHYSFS_readAll(io, buf, maxread))
+                return -1;
+            totalread += maxread;
+        } /* else */
+
+        memcpy(&extra, buf, sizeof (extra));
 
-        if (!zip_hash_entry(info, entry))
+        for (i = maxread - 4; i > 0; i--)
         {
-            allocator.Free(entry);
-            return 0;
-        } /* if */
+            if ((buf[i + 0] == 0x50) &&
+                (buf[i + 1] == 0x4B) &&
+                (buf[i + 2] == 0x05) &&
+                (buf[i + 3] == 0x06) )
+            {
+                found = 1;  /* that's the signature! */
+                break;  
+            } /* if */
+        } /* for */
 
-        if (zip_entry_is_tradional_crypto(entry))
-            info->has_crypto = 1;
-    } /* for */
+        if (found)
+            break;
 
-    return 1;
-} /* zip_load_entries */
+        filepos -= (maxread - 4);
+        if (filepos < 0)
+            filepos = 0;
+    } /* while */
 
+    BAIL_IF_MACRO(!found, PHYSFS_ERR_UNSUPPORTED, -1);
 
-static PHYSFS_sint64 zip64_find_end_of_central_dir(PHYSFS_Io *io,
-                                                   PHYSFS_sint64 _pos,
-                                                   PHYSFS_uint64 offset)
+    if (len != NULL)
+        *len = filelen;
+
+    return (filepos + i);
+} /* zip_find_end_of_central_dir */
+
+
+static int isZip(PHYSFS_Io *io)
 {
+    PHYSFS_uint32 sig = 0;
+    int retval = 0;
+
     /*
-     * Naturally, the offset is useless to us; it is the offset from the
-     *  start of file, which is meaningless if we've appended this .zip to
-     *  a self-extracting .exe. We need to find this on our own. It should
-     *  be directly before the locator record, but the record in question,
-     *  like the original end-of-central-directory record, ends with a
-     *  variable-length field. Unlike the original, which has to store the
-     *  size of that variable-length field in a 16-bit int and thus has to be
-     *  within 64k, the new one gets 64-bits.
-     *
-     * Fortunately, the only currently-specified record for that variable
-     *  length block is some weird proprietary thing that deals with EBCDIC
-     *  and tape backups or something. So we don't seek far.
+     * The first thing in a zip file might be the signature of the
+     *  first local file record, so it makes for a quick determination.
      */
+    if (readui32(io, &sig))
+        retval = (sig == ZIP_LOCAL_FILE_SIG);
 
-    PHYSFS_uint32 ui32;
-    const PHYSFS_uint64 pos = (PHYSFS_uint64) _pos;
+    if (!retval)
+    {
+        /*
+         * No sig...might be a ZIP with data at the start
+         *  (a self-extracting executable, etc), so we'll have to do
+         *  it the hard way. That's also the way if the start wouldn't
+         *  read: it might not have downloaded yet, while the end has.
+         */
+        retval = (zip_find_end_of_central_dir(io, NULL) != -1);
+    } /* if */
 
-    assert(_pos > 0);
+    return retval;
+} /* isZip */
 
-    /* Try offset specified in the Zip64 end of central directory locator. */
-    /* This works if the entire PHYSFS_Io is the zip file. */
-    BAIL_IF_MACRO(!io->seek(io, offset), ERRPASS, -1);
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
-    if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
-        return offset;
 
-    /* Try 56 bytes before the Zip64 end of central directory locator. */
-    /* This works if the record isn't variable length and is version 1. */
-    if (pos > 56)
-    {
-        BAIL_IF_MACRO(!io->seek(io, pos-56), ERRPASS, -1);
-        BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
-        if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
-            return pos-56;
-    } /* if */
+/* Find the ZIPentry for (path), when we already have its hash, (hashval). */
+static ZIPentry *zip_find_hashed(ZIPinfo *info, const char *path,
+                                 const PHYSFS_uint32 hashval)
+{
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 i;
 
-    /* Try 84 bytes before the Zip64 end of central directory locator. */
-    /* This works if the record isn't variable length and is version 2. */
-    if (pos > 84)
-    {
-        BAIL_IF_MACRO(!io->seek(io, pos-84), ERRPASS, -1);
-        BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
-        if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
-            return pos-84;
-    } /* if */
+    if (*path == '\0')
+        return &info->entries[0];  /* root dir. */
 
-    /* Ok, brute force: we know it's between (offset) and (pos) somewhere. */
-    /*  Just try moving back at most 256k. Oh well. */
-    if ((offset < pos) && (pos > 4))
+    /*
+     * Lookups can run on several threads at once, so the table has to
+     *  stay read-only after the archive is opened.
+     */
+    while ((i = __PHYSFS_hashTableFind(&info->hash, hashval, &probe)) != 0)
+    {
+        ZIPentry *entry = &info->entries[i];
+        if (strcmp(zip_entry_name(info, entry), path) == 0)
+            return entry;
+    } /* for */
+
+    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, NULL);
+} /* zip_find_hashed */
+
+
+/* Find the ZIPentry for a path in platform-independent notation. */
+static ZIPentry *zip_find_entry(ZIPinfo *info, const char *path)
+{
+    return zip_find_hashed(info, path, zip_hash_string(path));
+} /* zip_find_entry */
+
+
+/* Convert paths from old, buggy DOS zippers... */
+static void zip_convert_dos_path(ZIPentry *entry, char *path)
+{
+    PHYSFS_uint8 hosttype = (PHYSFS_uint8) ((entry->version >> 8) & 0xFF);
+    if (hosttype == 0)  /* FS_FAT_ */
+    {
+        while (*path)
+        {
+            if (*path == '\\')
+                *path = '/';
+            path++;
+        } /* while */
+    } /* if */
+} /* zip_convert_dos_path */
+
+
+static void zip_expand_symlink_path(char *path)
+{
+    char *ptr = path;
+    char *prevptr = path;
+
+    while (1)
+    {
+        ptr = strchr(ptr, '/');
+        if (ptr == NULL)
+            break;
+
+        if (*(ptr + 1) == '.')
+        {
+            if (*(ptr + 2) == '/')
+            {
+                /* current dir in middle of string: ditch it. */
+                memmove(ptr, ptr + 2, strlen(ptr + 2) + 1);
+            } /* else if */
+
+            else if (*(ptr + 2) == '\0')
+            {
+                /* current dir at end of string: ditch it. */
+                *ptr = '\0';
+            } /* else if */
+
+            else if (*(ptr + 2) == '.')
+            {
+                if (*(ptr + 3) == '/')
+                {
+                    /* parent dir in middle: move back one, if possible. */
+                    memmove(prevptr, ptr + 4, strlen(ptr + 4) + 1);
+                    ptr = prevptr;
+                    while (prevptr != path)
+                    {
+                        prevptr--;
+                        if (*prevptr == '/')
+                        {
+                            prevptr++;
+                            break;
+                        } /* if */
+                    } /* while */
+                } /* if */
+
+                if (*(ptr + 3) == '\0')
+                {
+                    /* parent dir at end: move back one, if possible. */
+                    *prevptr = '\0';
+                } /* if */
+            } /* if */
+        } /* if */
+        else
+        {
+            prevptr = ptr;
+            ptr++;
+        } /* else */
+    } /* while */
+} /* zip_expand_symlink_path */
+
+/* (forward reference: zip_follow_symlink and zip_resolve call each other.) */
+static int zip_resolve_hops(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry,
+                            const PHYSFS_uint32 hops);
+
+/*
+ * Look for the entry named by (path). If it exists, resolve it, and return
+ *  a pointer to that entry. If it's another symlink, keep resolving until you
+ *  hit a real file and then return a pointer to the final non-symlink entry.
+ *  If there's a problem, return NULL. (hops) is how many symlinks we've
+ *  followed to get here.
+ */
+static ZIPentry *zip_follow_symlink(PHYSFS_Io *io, ZIPinfo *info, char *path,
+                                    const PHYSFS_uint32 hops)
+{
+    ZIPentry *entry;
+
+    zip_expand_symlink_path(path);
+    entry = zip_find_entry(info, path);
+    if (entry != NULL)
+    {
+        if (!zip_resolve_hops(io, info, entry, hops))  /* recursive! */
+            entry = NULL;
+        else
+        {
+            if (entry->symlink != 0)
+                entry = zip_symlink_target(info, entry);
+        } /* else */
+    } /* if */
+
+    return entry;
+} /* zip_follow_symlink */
+
+
+static int zip_resolve_symlink(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry,
+                               const PHYSFS_uint32 hops)
+{
+    const PHYSFS_uint64 size = entry->uncompressed_size;
+    char *path = NULL;
+    int rc = 0;
+
+    /* a long enough chain would run us out of stack, loop or not. */
+    BAIL_IF_MACRO(hops >= info->max_hops, PHYSFS_ERR_SYMLINK_LOOP, 0);
+
+    /*
+     * We've already parsed the local file header of the symlink at this
+     *  point. Now we need to read the actual link from the file data and
+     *  follow it.
+     */
+
+    BAIL_IF_MACRO(!io->seek(io, entry->offset), ERRPASS, 0);
+
+    path = (char *) __PHYSFS_smallAlloc(size + 1);
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    
+    if (entry->compression_method == COMPMETH_NONE)
+        rc = __PHYSFS_readAll(io, path, size);
+
+    else if (!zip_entry_is_deflated(entry))
+        PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+
+    else  /* symlink target path is compressed... */
+    {
+        z_stream stream;
+        const PHYSFS_uint64 complen = entry->compressed_size;
+        PHYSFS_uint8 *compressed = (PHYSFS_uint8*) __PHYSFS_smallAlloc(complen);
+        if (compressed != NULL)
+        {
+            if (__PHYSFS_readAll(io, compressed, complen))
+            {
+                initializeZStream(&stream, NULL);
+                stream.next_in = compressed;
+                stream.avail_in = complen;
+                stream.next_out = (unsigned char *) path;
+                stream.avail_out = size;
+                if (zlib_err(inflateInit2(&stream, -MAX_WBITS)) == Z_OK)
+                {
+                    rc = zlib_err(inflate(&stream, Z_FINISH));
+                    inflateEnd(&stream);
+
+                    /* both are acceptable outcomes... */
+                    rc = ((rc == Z_OK) || (rc == Z_STREAM_END));
+                } /* if */
+            } /* if */
+            __PHYSFS_smallFree(compressed);
+        } /* if */
+    } /* else */
+
+    if (rc)
+    {
+        ZIPentry *target;
+        path[entry->uncompressed_size] = '\0';    /* null-terminate it. */
+        zip_convert_dos_path(entry, path);
+        target = zip_follow_symlink(io, info, path, hops + 1);
+        if (target != NULL)
+            entry->symlink = (PHYSFS_uint32) (target - info->entries);
+    } /* else */
+
+    __PHYSFS_smallFree(path);
+
+    return (entry->symlink != 0);
+} /* zip_resolve_symlink */
+
+
+static inline PHYSFS_uint16 zip_le16(const PHYSFS_uint8 *ptr)
+{
+    return (PHYSFS_uint16) (ptr[0] | (ptr[1] << 8));
+} /* zip_le16 */
+
+
+static inline PHYSFS_uint32 zip_le32(const PHYSFS_uint8 *ptr)
+{
+    return ((PHYSFS_uint32) ptr[0]) | (((PHYSFS_uint32) ptr[1]) << 8) |
+           (((PHYSFS_uint32) ptr[2]) << 16) | (((PHYSFS_uint32) ptr[3]) << 24);
+} /* zip_le32 */
+
+
+static inline PHYSFS_uint64 zip_le64(const PHYSFS_uint8 *ptr)
+{
+    return ((PHYSFS_uint64) zip_le32(ptr)) |
+           (((PHYSFS_uint64) zip_le32(ptr + 4)) << 32);
+} /* zip_le64 */
+
+
+/*
+ * Check the fixed part of an entry's local file header, (hdr), against what
+ *  the central directory said. Returns the whole local header's size, so
+ *  entry->offset plus that is where the data starts, or zero if it doesn't
+ *  match. Doesn't set an error, since this is used from threads that don't
+ *  report any.
+ */
+static PHYSFS_uint32 zip_check_local(const PHYSFS_uint8 *hdr,
+                                     const ZIPentry *entry)
+{
+    PHYSFS_uint32 ui32;
+
+    /*
+     * crc and (un)compressed_size are always zero if this is a "JAR"
+     *  archive created with Sun's Java tools, apparently. We only
+     *  consider this archive corrupted if those entries don't match and
+     *  aren't zero. That seems to work well.
+     * We also ignore a mismatch if the value is 0xFFFFFFFF here, since it's
+     *  possible that's a Zip64 thing.
+     */
+
+    /* !!! FIXME: apparently these are zero if general purpose bit 3 is set,
+       !!! FIXME:  which is probably true for Jar files, fwiw, but we don't
+       !!! FIXME:  care about these values anyhow. */
+
+    if (zip_le32(hdr) != ZIP_LOCAL_FILE_SIG)
+        return 0;
+    else if (zip_le16(hdr + 4) != entry->version_needed)
+        return 0;
+    /* general bits at hdr + 6. */
+    else if (zip_le16(hdr + 8) != entry->compression_method)
+        return 0;
+    /* date/time at hdr + 10. */
+
+    ui32 = zip_le32(hdr + 14);
+    if (ui32 && (ui32 != entry->crc))
+        return 0;
+
+    ui32 = zip_le32(hdr + 18);
+    if (ui32 && (ui32 != 0xFFFFFFFF) && (ui32 != entry->compressed_size))
+        return 0;
+
+    ui32 = zip_le32(hdr + 22);
+    if (ui32 && (ui32 != 0xFFFFFFFF) && (ui32 != entry->uncompressed_size))
+        return 0;
+
+    return ZIP_LOCAL_HEADER_SIZE + zip_le16(hdr + 26) + zip_le16(hdr + 28);
+} /* zip_check_local */
+
+
+/*
+ * Parse the local file header of an entry, and update entry->offset.
+ */
+static int zip_parse_local(PHYSFS_Io *io, ZIPentry *entry)
+{
+    PHYSFS_uint8 hdr[ZIP_LOCAL_HEADER_SIZE];
+    PHYSFS_uint32 hdrlen;
+
+    BAIL_IF_MACRO(!io->seek(io, entry->offset), ERRPASS, 0);
+    BAIL_IF_MACRO(!__PHYSFS_readAll(io, hdr, sizeof (hdr)), ERRPASS, 0);
+    hdrlen = zip_check_local(hdr, entry);
+    BAIL_IF_MACRO(!hdrlen, PHYSFS_ERR_CORRUPT, 0);
+    entry->offset += hdrlen;
+    return 1;
+} /* zip_parse_local */
+
+
+static int zip_resolve_hops(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry,
+                            const PHYSFS_uint32 hops)
+{
+    int retval = 1;
+    const ZipResolveType resolve_type = entry->resolved;
+
+    if (resolve_type == ZIP_DIRECTORY)
+        return 1;   /* we're good. */
+
+    /* Don't bother if we've failed to resolve this entry before. */
+    BAIL_IF_MACRO(resolve_type == ZIP_BROKEN_FILE, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(resolve_type == ZIP_BROKEN_SYMLINK, PHYSFS_ERR_CORRUPT, 0);
+
+    /* uhoh...infinite symlink loop! */
+    BAIL_IF_MACRO(resolve_type == ZIP_RESOLVING, PHYSFS_ERR_SYMLINK_LOOP, 0);
+
+    /*
+     * We fix up the offset to point to the actual data on the
+     *  first open, since we don't want to seek across the whole file on
+     *  archive open (can be SLOW on large, CD-stored files), but we
+     *  need to check the local file header...not just for corruption,
+     *  but since it stores offset info the central directory does not.
+     */
+    if (resolve_type != ZIP_RESOLVED)
+    {
+        entry->resolved = ZIP_RESOLVING;
+
+        retval = zip_parse_local(io, entry);
+        if (retval)
+        {
+            /*
+             * If it's a symlink, find the original file. This will cause
+             *  resolution of other entries (other symlinks and, eventually,
+             *  the real file) if all goes well.
+             */
+            if (resolve_type == ZIP_UNRESOLVED_SYMLINK)
+                retval = zip_resolve_symlink(io, info, entry, hops);
+        } /* if */
+
+        if (!retval)
+        {
+            /* data that hasn't downloaded yet isn't broken; try again later. */
+            const PHYSFS_ErrorCode err = PHYSFS_getLastErrorCode();
+            PHYSFS_setErrorCode(err);
+            if (err == PHYSFS_ERR_UNAVAILABLE)
+            {
+                entry->resolved = resolve_type;
+                return 0;
+            } /* if */
+        } /* if */
+
+        if (resolve_type == ZIP_UNRESOLVED_SYMLINK)
+            entry->resolved = ((retval) ? ZIP_RESOLVED : ZIP_BROKEN_SYMLINK);
+        else if (resolve_type == ZIP_UNRESOLVED_FILE)
+            entry->resolved = ((retval) ? ZIP_RESOLVED : ZIP_BROKEN_FILE);
+    } /* if */
+
+    return retval;
+} /* zip_resolve_hops */
+
+
+static int zip_resolve(PHYSFS_Io *io, ZIPinfo *info, ZIPentry *entry)
+{
+    return zip_resolve_hops(io, info, entry, 0);
+} /* zip_resolve */
+
+
+/*
+ * Make room for (needed) elements of (size) bytes at (ptr), which has room
+ *  for (*allocated) now. Returns the new block, or NULL if we're out of
+ *  memory, in which case (ptr) is still good.
+ */
+static void *zip_grow(void *ptr, PHYSFS_uint32 *allocated,
+                      const PHYSFS_uint64 needed, const size_t size)
+{
+    PHYSFS_uint64 count = (PHYSFS_uint64) *allocated;
+
+    count += (count / 8) + 64;
+    if (count < needed)
+        count = needed;
+    if (count > 0xFFFFFFFF)
+        count = 0xFFFFFFFF;
+
+    BAIL_IF_MACRO(needed > count, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    BAIL_IF_MACRO(count > ((size_t) -1) / size, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    ptr = allocator.Realloc(ptr, (PHYSFS_uint64) (count * size));
+    BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    *allocated = (PHYSFS_uint32) count;
+    return ptr;
+} /* zip_grow */
+
+
+/*
+ * Bring the PHYSFS_MEMORY_INDEX charged for (info) up to date with what its
+ *  entries, names and hash have grown to. Returns zero if that's more than
+ *  PHYSFS_setMountLimits() allows it; it's still charged, and the caller
+ *  should give up on the archive.
+ */
+static int zip_charge_index(ZIPinfo *info)
+{
+    const PHYSFS_uint64 bytes =
+        (((PHYSFS_uint64) info->entries_allocated) * sizeof (ZIPentry)) +
+        info->names_allocated + __PHYSFS_hashTableBytes(&info->hash);
+
+    if (bytes != info->index_charged)
+    {
+        __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                           (PHYSFS_sint64) (bytes - info->index_charged));
+        info->index_charged = bytes;
+    } /* if */
+
+    BAIL_IF_MACRO(info->max_index && (bytes > info->max_index),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    return 1;
+} /* zip_charge_index */
+
+
+/*
+ * Add a zeroed entry, with room for a (namelen) byte name in the pool, which
+ *  is null-terminated but otherwise left for the caller to fill in. Returns
+ *  the new entry's index, or zero if we're out of memory. This can move
+ *  the entries and names around, so don't hold pointers into either over it.
+ */
+static PHYSFS_uint32 zip_add_entry(ZIPinfo *info, const size_t namelen)
+{
+    const PHYSFS_uint64 names_needed = info->names_used + namelen + 1;
+    ZIPentry *entry;
+    void *ptr;
+
+    /* the root dir doesn't count. */
+    BAIL_IF_MACRO(info->max_entries && (info->entries_used > info->max_entries),
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+
+    if (info->entries_used == info->entries_allocated)
+    {
+        ptr = zip_grow(info->entries, &info->entries_allocated,
+                       ((PHYSFS_uint64) info->entries_used) + 1,
+                       sizeof (ZIPentry));
+        BAIL_IF_MACRO(!ptr, ERRPASS, 0);
+        info->entries = (ZIPentry *) ptr;
+    } /* if */
+
+    if (names_needed > info->names_allocated)
+    {
+        ptr = zip_grow(info->names, &info->names_allocated, names_needed, 1);
+        BAIL_IF_MACRO(!ptr, ERRPASS, 0);
+        info->names = (char *) ptr;
+    } /* if */
+
+    BAIL_IF_MACRO(!zip_charge_index(info), ERRPASS, 0);
+    entry = &info->entries[info->entries_used];
+    memset(entry, '\0', sizeof (*entry));
+    entry->name = info->names_used;
+    info->names[entry->name + namelen] = '\0';
+    info->names_used = (PHYSFS_uint32) names_needed;
+    return info->entries_used++;
+} /* zip_add_entry */
+
+
+/* Take back the latest zip_add_entry(), which nothing may point to yet. */
+static void zip_pop_entry(ZIPinfo *info)
+{
+    assert(info->entries_used > 1);
+    info->entries_used--;
+    info->names_used = info->entries[info->entries_used].name;
+} /* zip_pop_entry */
+
+
+/* Hash entry (idx) under (hashval), and make it one of (parent)'s kids. */
+static int zip_link_entry(ZIPinfo *info, const PHYSFS_uint32 idx,
+                          const PHYSFS_uint32 parent,
+                          const PHYSFS_uint32 hashval)
+{
+    ZIPentry *entry = &info->entries[idx];
+
+    if (!__PHYSFS_hashTableInsert(&info->hash, hashval, idx))
+        return 0;
+    BAIL_IF_MACRO(!zip_charge_index(info), ERRPASS, 0);
+
+    entry->sibling = info->entries[parent].children;
+    info->entries[parent].children = idx;
+    return 1;
+} /* zip_link_entry */
+
+
+/*
+ * Fill in missing parent directories, and put the index of entry (idx)'s
+ *  parent in (*parent). This works up from the deepest parent to the first
+ *  one that's already there, then back down making the rest, without
+ *  recursing, so a deep path can't run us out of stack. Returns zero on
+ *  error.
+ */
+static int zip_hash_ancestors(ZIPinfo *info, const PHYSFS_uint32 idx,
+                              PHYSFS_uint32 *parent)
+{
+    const PHYSFS_uint32 nameofs = info->entries[idx].name;
+    char *name = info->names + nameofs;
+    char *sep = strrchr(name, '/');
+    ZIPentry *found = NULL;
+    size_t parentlen;
+    size_t len;
+
+    *parent = 0;  /* the root dir. */
+    if (!sep)
+        return 1;
+
+    parentlen = len = (size_t) (sep - name);
+    while (1)
+    {
+        const char ch = name[len];
+        name[len] = '\0';  /* chop it off here for a moment. */
+        found = zip_find_entry(info, name);
+        name[len] = ch;
+        if ((found != NULL) || (len == 0))
+            break;
+        while ((len > 0) && (name[--len] != '/')) { /* spin. */ }
+    } /* while */
+
+    BAIL_IF_MACRO(!found, PHYSFS_ERR_CORRUPT, 0);  /* can't happen. */
+    BAIL_IF_MACRO(found->resolved != ZIP_DIRECTORY, PHYSFS_ERR_CORRUPT, 0);
+    *parent = (PHYSFS_uint32) (found - info->entries);
+
+    /* okay, these are new dirs. Build and hash them, from the top down. */
+    while (len < parentlen)
+    {
+        PHYSFS_uint32 dir;
+        char *dirname;
+
+        if ((len > 0) || (name[0] == '/'))
+            len++;  /* skip the '/'. */
+        while ((len < parentlen) && (name[len] != '/'))
+            len++;
+
+        dir = zip_add_entry(info, len);
+        if (dir == 0)
+            return 0;  /* the caller cleans up the whole table. */
+        name = info->names + nameofs;  /* the pool might have moved. */
+        dirname = zip_entry_name(info, &info->entries[dir]);
+        memcpy(dirname, name, len);
+        info->entries[dir].resolved = ZIP_DIRECTORY;
+        if (!zip_link_entry(info, dir, *parent, zip_hash_string(dirname)))
+            return 0;
+        *parent = dir;
+    } /* while */
+
+    return 1;
+} /* zip_hash_ancestors */
+
+
+/*
+ * Hash entry (idx), whose name hashes to (hashval), and link it into its
+ *  parent dir. If it's a dir we already made a placeholder for, because
+ *  something in it came first, the placeholder gets its details instead.
+ *  Returns 1 if (idx) went in, -1 if it went into a placeholder and should
+ *  be thrown away, or zero on error.
+ */
+static int zip_merge_entry(ZIPinfo *info, const PHYSFS_uint32 idx,
+                           const PHYSFS_uint32 hashval)
+{
+    ZIPentry *entry = &info->entries[idx];
+    ZIPentry *find = zip_find_hashed(info, zip_entry_name(info, entry), hashval);
+    PHYSFS_uint32 parent;
+
+    if (find != NULL)  /* duplicate? */
+    {
+        if (find->dos_mod_time != 0)  /* duplicate? */
+            BAIL_MACRO(PHYSFS_ERR_CORRUPT, 0);
+
+        /* we filled this in as a placeholder. Update it. */
+        find->offset = entry->offset;
+        find->version = entry->version;
+        find->version_needed = entry->version_needed;
+        find->compression_method = entry->compression_method;
+        find->crc = entry->crc;
+        find->compressed_size = entry->compressed_size;
+        find->uncompressed_size = entry->uncompressed_size;
+        find->dos_mod_time = entry->dos_mod_time;
+        return -1;
+    } /* if */
+
+    if (!zip_hash_ancestors(info, idx, &parent))
+        return 0;
+    if (!zip_link_entry(info, idx, parent, hashval))
+        return 0;
+
+    if (zip_entry_is_tradional_crypto(&info->entries[idx]))
+        info->has_crypto = 1;
+    return 1;
+} /* zip_merge_entry */
+
+
+static int zip_entry_is_symlink(const ZIPentry *entry)
+{
+    return ((entry->resolved == ZIP_UNRESOLVED_SYMLINK) ||
+            (entry->resolved == ZIP_BROKEN_SYMLINK) ||
+            (entry->symlink != 0));
+} /* zip_entry_is_symlink */
+
+
+static int zip_version_does_symlinks(PHYSFS_uint32 version)
+{
+    int retval = 0;
+    PHYSFS_uint8 hosttype = (PHYSFS_uint8) ((version >> 8) & 0xFF);
+
+    switch (hosttype)
+    {
+            /*
+             * These are the platforms that can NOT build an archive with
+             *  symlinks, according to the Info-ZIP project.
+             */
+        case 0:  /* FS_FAT_  */
+        case 1:  /* AMIGA_   */
+        case 2:  /* VMS_     */
+        case 4:  /* VM_CSM_  */
+        case 6:  /* FS_HPFS_ */
+        case 11: /* FS_NTFS_ */
+        case 14: /* FS_VFAT_ */
+        case 13: /* ACORN_   */
+        case 15: /* MVS_     */
+        case 18: /* THEOS_   */
+            break;  /* do nothing. */
+
+        default:  /* assume the rest to be unix-like. */
+            retval = 1;
+            break;
+    } /* switch */
+
+    return retval;
+} /* zip_version_does_symlinks */
+
+
+static int zip_has_symlink_attr(ZIPentry *entry, PHYSFS_uint32 extern_attr)
+{
+    PHYSFS_uint16 xattr = ((extern_attr >> 16) & 0xFFFF);
+    return ( (zip_version_does_symlinks(entry->version)) &&
+             (entry->uncompressed_size > 0) &&
+             ((xattr & UNIX_FILETYPE_MASK) == UNIX_FILETYPE_SYMLINK) );
+} /* zip_has_symlink_attr */
+
+
+static PHYSFS_sint64 zip_dos_time_to_physfs_time(PHYSFS_uint32 dostime)
+{
+    PHYSFS_uint32 dosdate;
+    struct tm unixtime;
+    memset(&unixtime, '\0', sizeof (unixtime));
+
+    dosdate = (PHYSFS_uint32) ((dostime >> 16) & 0xFFFF);
+    dostime &= 0xFFFF;
+
+    /* dissect date */
+    unixtime.tm_year = ((dosdate >> 9) & 0x7F) + 80;
+    unixtime.tm_mon  = ((dosdate >> 5) & 0x0F) - 1;
+    unixtime.tm_mday = ((dosdate     ) & 0x1F);
+
+    /* dissect time */
+    unixtime.tm_hour = ((dostime >> 11) & 0x1F);
+    unixtime.tm_min  = ((dostime >>  5) & 0x3F);
+    unixtime.tm_sec  = ((dostime <<  1) & 0x3E);
+
+    /* let mktime calculate daylight savings time. */
+    unixtime.tm_isdst = -1;
+
+    return ((PHYSFS_sint64) mktime(&unixtime));
+} /* zip_dos_time_to_physfs_time */
+
+
+/* Size of a central dir record with no name, extra field or comment. */
+#define ZIP_CENTRAL_DIR_RECORD_SIZE 46
+
+/*
+ * The whole size of the central dir record at (rec), or zero if it isn't
+ *  one, or doesn't fit in the (avail) bytes of the central dir left there.
+ */
+static PHYSFS_uint64 zip_record_size(const PHYSFS_uint8 *rec,
+                                     const PHYSFS_uint64 avail)
+{
+    PHYSFS_uint64 len;
+
+    if (avail < ZIP_CENTRAL_DIR_RECORD_SIZE)
+        return 0;
+    else if (zip_le32(rec) != ZIP_CENTRAL_DIR_SIG)
+        return 0;
+
+    /* the name, the extra field and the comment. */
+    len = ZIP_CENTRAL_DIR_RECORD_SIZE + zip_le16(rec + 28) +
+          zip_le16(rec + 30) + zip_le16(rec + 32);
+    return (len > avail) ? 0 : len;
+} /* zip_record_size */
+
+
+/*
+ * Fill in (entry) from the central dir record at (rec), which
+ *  zip_record_size() said is all there, with its name going in the pool at
+ *  (nameofs), where there's room for it and a null. This touches nothing
+ *  else in (info), so runs of records can be parsed on several threads at
+ *  once; for the same reason, it returns an error code instead of setting
+ *  it: PHYSFS_ERR_OK on success.
+ */
+static PHYSFS_ErrorCode zip_parse_record(const ZIPinfo *info,
+                                         const PHYSFS_uint8 *rec,
+                                         const PHYSFS_uint64 ofs_fixup,
+                                         ZIPentry *entry,
+                                         const PHYSFS_uint32 nameofs)
+{
+    const PHYSFS_uint16 fnamelen = zip_le16(rec + 28);
+    const PHYSFS_uint32 external_attr = zip_le32(rec + 38);
+    const PHYSFS_uint8 *extra = rec + ZIP_CENTRAL_DIR_RECORD_SIZE + fnamelen;
+    PHYSFS_uint32 extralen = zip_le16(rec + 30);
+    PHYSFS_uint32 starting_disk = zip_le16(rec + 34);
+    PHYSFS_uint64 offset = zip_le32(rec + 42);
+    char *name = info->names + nameofs;
+
+    /* Get the pertinent parts of the record... */
+    memset(entry, '\0', sizeof (*entry));
+    entry->name = nameofs;
+    entry->version = zip_le16(rec + 4);
+    entry->version_needed = zip_le16(rec + 6);
+    entry->general_bits = zip_le16(rec + 8);
+    entry->compression_method = zip_le16(rec + 10);
+    entry->dos_mod_time = zip_le32(rec + 12);
+    entry->crc = zip_le32(rec + 16);
+    entry->compressed_size = (PHYSFS_uint64) zip_le32(rec + 20);
+    entry->uncompressed_size = (PHYSFS_uint64) zip_le32(rec + 24);
+    /* rec + 36 is the internal file attribs, which we don't need. */
+
+    memcpy(name, rec + ZIP_CENTRAL_DIR_RECORD_SIZE, fnamelen);
+    name[fnamelen] = '\0';
+    zip_convert_dos_path(entry, name);
+
+    if ((fnamelen > 0) && (name[fnamelen - 1] == '/'))
+    {
+        name[fnamelen - 1] = '\0';
+        entry->resolved = ZIP_DIRECTORY;
+    } /* if */
+    else
+    {
+        entry->resolved = (zip_has_symlink_attr(entry, external_attr)) ?
+                                ZIP_UNRESOLVED_SYMLINK : ZIP_UNRESOLVED_FILE;
+    } /* else */
+
+    /* every piece of the path can mean a parent dir to look up or make. */
+    if (info->max_depth)
+    {
+        const char *ptr;
+        PHYSFS_uint32 depth = 1;
+        for (ptr = strchr(name, '/'); ptr != NULL; ptr = strchr(ptr + 1, '/'))
+        {
+            if (++depth > info->max_depth)
+                return PHYSFS_ERR_UNSUPPORTED;
+        } /* for */
+    } /* if */
+
+    /*
+     * The actual sizes didn't fit in 32-bits; look for the Zip64
+     *  extended information extra field...
+     */
+    if ( (info->zip64) &&
+         ((offset == 0xFFFFFFFF) ||
+          (starting_disk == 0xFFFFFFFF) ||
+          (entry->compressed_size == 0xFFFFFFFF) ||
+          (entry->uncompressed_size == 0xFFFFFFFF)) )
+    {
+        int found = 0;
+        PHYSFS_uint32 len = 0;
+        while (extralen > 4)
+        {
+            const PHYSFS_uint16 sig = zip_le16(extra);
+            len = zip_le16(extra + 2);
+            if (len > extralen - 4)
+                return PHYSFS_ERR_CORRUPT;
+
+            extra += 4;
+            extralen -= 4;
+            if (sig == ZIP64_EXTENDED_INFO_EXTRA_FIELD_SIG)
+            {
+                found = 1;
+                break;
+            } /* if */
+
+            extra += len;
+            extralen -= len;
+        } /* while */
+
+        if (!found)
+            return PHYSFS_ERR_CORRUPT;
+
+        if (entry->uncompressed_size == 0xFFFFFFFF)
+        {
+            if (len < 8)
+                return PHYSFS_ERR_CORRUPT;
+            entry->uncompressed_size = zip_le64(extra);
+            extra += 8;
+            len -= 8;
+        } /* if */
+
+        if (entry->compressed_size == 0xFFFFFFFF)
+        {
+            if (len < 8)
+                return PHYSFS_ERR_CORRUPT;
+            entry->compressed_size = zip_le64(extra);
+            extra += 8;
+            len -= 8;
+        } /* if */
+
+        if (offset == 0xFFFFFFFF)
+        {
+            if (len < 8)
+                return PHYSFS_ERR_CORRUPT;
+            offset = zip_le64(extra);
+            extra += 8;
+            len -= 8;
+        } /* if */
+
+        if (starting_disk == 0xFFFFFFFF)
+        {
+            if (len < 4)
+                return PHYSFS_ERR_CORRUPT;
+            starting_disk = zip_le32(extra);
+            len -= 4;
+        } /* if */
+
+        if (len != 0)
+            return PHYSFS_ERR_CORRUPT;
+    } /* if */
+
+    if (starting_disk != 0)
+        return PHYSFS_ERR_CORRUPT;
+
+    entry->offset = offset + ofs_fixup;
+    return PHYSFS_ERR_OK;
+} /* zip_parse_record */
+
+
+/* One thread's share of zip_load_entries_parallel(). */
+typedef struct
+{
+    const ZIPinfo *info;        /* the archive we're parsing for.         */
+    const PHYSFS_uint8 *start;  /* our first central dir record.          */
+    PHYSFS_uint64 len;          /* bytes of records, starting there.      */
+    PHYSFS_uint64 ofs_fixup;    /* added to every entry's offset.         */
+    PHYSFS_uint32 first;        /* entry index our first record goes in.  */
+    PHYSFS_uint32 count;        /* records in our run.                    */
+    PHYSFS_uint32 names;        /* where in the pool our names start.     */
+    PHYSFS_uint32 *hashes;      /* each record's name's hash goes here.   */
+    PHYSFS_ErrorCode error;     /* why we stopped, or PHYSFS_ERR_OK.      */
+    void *thread;               /* doing this, or NULL for the caller.    */
+} ZIPparseRun;
+
+
+/*
+ * Parse a run of records into the entries and name pool slots set aside
+ *  for them, hashing each name while it's still hot in the cache.
+ */
+static void zip_parse_run(void *data)
+{
+    ZIPparseRun *run = (ZIPparseRun *) data;
+    const PHYSFS_uint8 *rec = run->start;
+    const PHYSFS_uint8 *end = run->start + (size_t) run->len;
+    PHYSFS_uint32 nameofs = run->names;
+    PHYSFS_uint32 i;
+
+    for (i = 0; i < run->count; i++)
+    {
+        ZIPentry *entry = &run->info->entries[run->first + i];
+        const PHYSFS_uint64 reclen = zip_record_size(rec, end - rec);
+
+        if (reclen == 0)
+            run->error = PHYSFS_ERR_CORRUPT;  /* the caller checked this... */
+        else
+            run->error = zip_parse_record(run->info, rec, run->ofs_fixup,
+                                          entry, nameofs);
+        if (run->error != PHYSFS_ERR_OK)
+            return;
+
+        run->hashes[i] = zip_hash_string(zip_entry_name(run->info, entry));
+        nameofs += zip_le16(rec + 28) + 1;
+        rec += (size_t) reclen;
+    } /* for */
+} /* zip_parse_run */
+
+
+/*
+ * Close up the holes zip_load_entries_parallel() leaves where records went
+ *  into placeholders (their name is zero, which only the root's can be
+ *  otherwise), renumbering every link and hash slot to match.
+ */
+static int zip_close_holes(ZIPinfo *info)
+{
+    const PHYSFS_uint32 total = info->entries_used;
+    __PHYSFS_HashSlot *slots = info->hash.slots;
+    PHYSFS_uint32 *remap;
+    PHYSFS_uint64 nslots;
+    PHYSFS_uint64 s;
+    PHYSFS_uint32 used = 1;
+    PHYSFS_uint32 i;
+
+    remap = (PHYSFS_uint32 *) allocator.Malloc(sizeof (PHYSFS_uint32) * total);
+    BAIL_IF_MACRO(!remap, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    remap[0] = 0;  /* the root stays put, and "none" stays "none". */
+    for (i = 1; i < total; i++)
+    {
+        if (info->entries[i].name == 0)
+            remap[i] = 0;  /* nothing links to a hole. */
+        else
+        {
+            if (used != i)
+                memcpy(&info->entries[used], &info->entries[i], sizeof (ZIPentry));
+            remap[i] = used++;
+        } /* else */
+    } /* for */
+
+    for (i = 0; i < used; i++)
+    {
+        ZIPentry *entry = &info->entries[i];
+        entry->symlink = remap[entry->symlink];
+        entry->children = remap[entry->children];
+        entry->sibling = remap[entry->sibling];
+    } /* for */
+
+    nslots = (slots == NULL) ? 0 : (((PHYSFS_uint64) 1) << info->hash.bits);
+    for (s = 0; s < nslots; s++)
+        slots[s].index = remap[slots[s].index];
+
+    info->entries_used = used;
+    allocator.Free(remap);
+    return 1;
+} /* zip_close_holes */
+
+
+/*
+ * zip_load_entries() for big central directories: split them into runs of
+ *  records that are parsed on their own threads, straight into the entries
+ *  they'll end up in, then hash them all here, in order. Returns -1 if this
+ *  didn't try, without setting an error, so the caller should do it the
+ *  usual way, which is also what reports anything wrong with the records.
+ */
+static int zip_load_entries_parallel(ZIPinfo *info, const PHYSFS_uint8 *dir,
+                                     const PHYSFS_uint64 dirlen,
+                                     const PHYSFS_uint64 data_ofs,
+                                     const PHYSFS_uint32 entry_count)
+{
+    ZIPparseRun runs[ZIP_PARSE_THREADS];
+    PHYSFS_uint32 *hashes;
+    PHYSFS_uint64 names = info->names_used;
+    PHYSFS_uint64 pos = 0;
+    PHYSFS_uint32 numruns;
+    PHYSFS_uint32 holes = 0;
+    PHYSFS_uint32 per;
+    PHYSFS_uint32 i;
+    int retval = 0;
+
+    /* zip_alloc_entries() made room for all of them; they go in 1 to N. */
+    assert(info->entries_used == 1);
+    assert(info->entries_allocated > entry_count);
+
+    hashes = (PHYSFS_uint32 *) allocator.Malloc(sizeof (PHYSFS_uint32) *
+                                                entry_count);
+    if (hashes == NULL)
+        return -1;
+
+    numruns = entry_count / ZIP_PARSE_PER_THREAD;
+    if (numruns > ZIP_PARSE_THREADS)
+        numruns = ZIP_PARSE_THREADS;
+    per = (entry_count + numruns - 1) / numruns;
+
+    /* split them up at record boundaries, and give out the name pool. */
+    memset(runs, '\0', sizeof (runs));
+    for (i = 0; i < entry_count; i++)
+    {
+        const PHYSFS_uint64 reclen = zip_record_size(dir + pos, dirlen - pos);
+        ZIPparseRun *run = &runs[i / per];
+
+        if (reclen == 0)
+        {
+            allocator.Free(hashes);
+            return -1;
+        } /* if */
+
+        if (run->count == 0)
+        {
+            run->info = info;
+            run->start = dir + pos;
+            run->ofs_fixup = data_ofs;
+            run->first = i + 1;
+            run->names = (PHYSFS_uint32) names;
+            run->hashes = hashes + i;
+        } /* if */
+
+        run->len += reclen;
+        run->count++;
+        names += zip_le16(dir + pos + 28) + 1;
+        pos += reclen;
+        if (names > 0xFFFFFFFF)
+        {
+            allocator.Free(hashes);
+            return -1;
+        } /* if */
+    } /* for */
+
+    if (names > info->names_allocated)
+    {
+        void *ptr = zip_grow(info->names, &info->names_allocated, names, 1);
+        GOTO_IF_MACRO(!ptr, ERRPASS, zip_load_parallel_done);
+        info->names = (char *) ptr;
+    } /* if */
+
+    for (i = 1; i < numruns; i++)  /* we do the first one. */
+        runs[i].thread = __PHYSFS_startTask(zip_parse_run, &runs[i]);
+
+    /* our run, and any a thread couldn't be started for. */
+    for (i = 0; i < numruns; i++)
+    {
+        if (runs[i].thread == NULL)
+            zip_parse_run(&runs[i]);
+    } /* for */
+
+    for (i = 0; i < numruns; i++)
+    {
+        if (runs[i].thread != NULL)
+            __PHYSFS_waitTask(runs[i].thread);
+    } /* for */
+
+    /* the earliest bad record is the one the usual way would report. */
+    for (i = 0; i < numruns; i++)
+        GOTO_IF_MACRO(runs[i].error != PHYSFS_ERR_OK, runs[i].error,
+                      zip_load_parallel_done);
+
+    info->entries_used = entry_count + 1;
+    info->names_used = (PHYSFS_uint32) names;
+    GOTO_IF_MACRO(!zip_charge_index(info), ERRPASS, zip_load_parallel_done);
+
+    /*
+     * Placeholders and duplicates depend on what came before, so this part
+     *  goes in order, but it's just table inserts now. A record that goes
+     *  into a placeholder can't be popped off the end like it would be
+     *  the usual way, so it's left as a hole, closed up afterwards.
+     */
+    for (i = 1; i <= entry_count; i++)
+    {
+        const int rc = zip_merge_entry(info, i, hashes[i - 1]);
+        if (rc == 0)
+            goto zip_load_parallel_done;
+        else if (rc < 0)
+        {
+            info->entries[i].name = 0;
+            holes++;
+        } /* else if */
+    } /* for */
+
+    if ((holes > 0) && (!zip_close_holes(info)))
+        goto zip_load_parallel_done;
+
+    retval = 1;
+
+zip_load_parallel_done:
+    allocator.Free(hashes);
+    return retval;
+} /* zip_load_entries_parallel */
+
+
+/*
+ * (io) is the central directory read in by zip_read_central_dir(). This
+ *  leaves things allocated on error; the caller will clean up the mess.
+ */
+static int zip_load_entries(ZIPinfo *info, PHYSFS_Io *io,
+                            const PHYSFS_uint64 data_ofs,
+                            const PHYSFS_uint64 entry_count)
+{
+    const PHYSFS_uint8 *dir = NULL;
+    PHYSFS_uint64 dirlen = 0;
+    PHYSFS_uint64 pos = 0;
+    PHYSFS_uint64 i;
+
+    /* it's always in memory, so we can walk it instead of reading it. */
+    BAIL_IF_MACRO(!__PHYSFS_ioMap(io, (const void **) &dir, &dirlen),
+                  ERRPASS, 0);
+
+    if (entry_count >= (ZIP_PARSE_PER_THREAD * 2))
+    {
+        const int rc = zip_load_entries_parallel(info, dir, dirlen, data_ofs,
+                                                 (PHYSFS_uint32) entry_count);
+        if (rc >= 0)
+            return rc;
+    } /* if */
+
+    for (i = 0; i < entry_count; i++)
+    {
+        const PHYSFS_uint64 reclen = zip_record_size(dir + pos, dirlen - pos);
+        PHYSFS_ErrorCode err;
+        PHYSFS_uint32 idx;
+        ZIPentry *entry;
+        int rc;
+
+        BAIL_IF_MACRO(reclen == 0, PHYSFS_ERR_CORRUPT, 0);
+        idx = zip_add_entry(info, zip_le16(dir + pos + 28));
+        if (idx == 0)
+            return 0;
+
+        entry = &info->entries[idx];
+        err = zip_parse_record(info, dir + pos, data_ofs, entry, entry->name);
+        if (err != PHYSFS_ERR_OK)
+        {
+            zip_pop_entry(info);
+            BAIL_MACRO(err, 0);
+        } /* if */
+        pos += reclen;
+
+        rc = zip_merge_entry(info, idx,
+                             zip_hash_string(zip_entry_name(info, entry)));
+        if (rc == 0)
+            return 0;
+        else if (rc < 0)
+            zip_pop_entry(info);  /* it went into a placeholder. */
+    } /* for */
+
+    return 1;
+} /* zip_load_entries */
+
+
+static PHYSFS_sint64 zip64_find_end_of_central_dir(PHYSFS_Io *io,
+                                                   PHYSFS_sint64 _pos,
+                                                   PHYSFS_uint64 offset)
+{
+    /*
+     * Naturally, the offset is useless to us; it is the offset from the
+     *  start of file, which is meaningless if we've appended this .zip to
+     *  a self-extracting .exe. We need to find this on our own. It should
+     *  be directly before the locator record, but the record in question,
+     *  like the original end-of-central-directory record, ends with a
+     *  variable-length field. Unlike the original, which has to store the
+     *  size of that variable-length field in a 16-bit int and thus has to be
+     *  within 64k, the new one gets 64-bits.
+     *
+     * Fortunately, the only currently-specified record for that variable
+     *  length block is some weird proprietary thing that deals with EBCDIC
+     *  and tape backups or something. So we don't seek far.
+     */
+
+    PHYSFS_uint32 ui32;
+    const PHYSFS_uint64 pos = (PHYSFS_uint64) _pos;
+
+    assert(_pos > 0);
+
+    /* Try offset specified in the Zip64 end of central directory locator. */
+    /* This works if the entire PHYSFS_Io is the zip file. */
+    BAIL_IF_MACRO(!io->seek(io, offset), ERRPASS, -1);
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
+    if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
+        return offset;
+
+    /* Try 56 bytes before the Zip64 end of central directory locator. */
+    /* This works if the record isn't variable length and is version 1. */
+    if (pos > 56)
+    {
+        BAIL_IF_MACRO(!io->seek(io, pos-56), ERRPASS, -1);
+        BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
+        if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
+            return pos-56;
+    } /* if */
+
+    /* Try 84 bytes before the Zip64 end of central directory locator. */
+    /* This works if the record isn't variable length and is version 2. */
+    if (pos > 84)
+    {
+        BAIL_IF_MACRO(!io->seek(io, pos-84), ERRPASS, -1);
+        BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, -1);
+        if (ui32 == ZIP64_END_OF_CENTRAL_DIR_SIG)
+            return pos-84;
+    } /* if */
+
+    /* Ok, brute force: we know it's between (offset) and (pos) somewhere. */
+    /*  Just try moving back at most 256k. Oh well. */
+    if ((offset < pos) && (pos > 4))
     {
         const PHYSFS_uint64 maxbuflen = 256 * 1024;
         PHYSFS_uint64 len = pos - offset;
         PHYSFS_uint8 *buf = NULL;
         PHYSFS_sint32 i;
 
-        if (len > maxbuflen)
-            len = maxbuflen;
+        if (len > maxbuflen)
+            len = maxbuflen;
+
+        buf = (PHYSFS_uint8 *) __PHYSFS_smallAlloc(len);
+        BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, -1);
+
+        if (!io->seek(io, pos - len) || !__PHYSFS_readAll(io, buf, len))
+        {
+            __PHYSFS_smallFree(buf);
+            return -1;  /* error was set elsewhere. */
+        } /* if */
+
+        for (i = (PHYSFS_sint32) (len - 4); i >= 0; i--)
+        {
+            if ( (buf[i] == 0x50) && (buf[i+1] == 0x4b) &&
+                 (buf[i+2] == 0x06) && (buf[i+3] == 0x06) )
+            {
+                __PHYSFS_smallFree(buf);
+                return pos - (len - i);
+            } /* if */
+        } /* for */
+
+        __PHYSFS_smallFree(buf);
+    } /* if */
+
+    BAIL_MACRO(PHYSFS_ERR_CORRUPT, -1);  /* didn't find it. */
+} /* zip64_find_end_of_central_dir */
+
+
+static int zip64_parse_end_of_central_dir(ZIPinfo *info,
+                                          PHYSFS_uint64 *data_start,
+                                          PHYSFS_uint64 *dir_ofs,
+                                          PHYSFS_uint64 *dir_size,
+                                          PHYSFS_uint64 *entry_count,
+                                          PHYSFS_sint64 pos)
+{
+    PHYSFS_Io *io = info->io;
+    PHYSFS_uint64 ui64;
+    PHYSFS_uint32 ui32;
+    PHYSFS_uint16 ui16;
+
+    /* We should be positioned right past the locator signature. */
+
+    if ((pos < 0) || (!io->seek(io, pos)))
+        return 0;
+
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    if (ui32 != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG)
+        return -1;  /* it's not a Zip64 archive. Not an error, though! */
+
+    info->zip64 = 1;
+
+    /* number of the disk with the start of the central directory. */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
+
+    /* offset of Zip64 end of central directory record. */
+    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+
+    /* total number of disks */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != 1, PHYSFS_ERR_CORRUPT, 0);
+
+    pos = zip64_find_end_of_central_dir(io, pos, ui64);
+    if (pos < 0)
+        return 0;  /* oh well. */
+
+    /*
+     * For self-extracting archives, etc, there's crapola in the file
+     *  before the zipfile records; we calculate how much data there is
+     *  prepended by determining how far the zip64-end-of-central-directory
+     *  offset is from where it is supposed to be...the difference in bytes
+     *  is how much arbitrary data is at the start of the physical file.
+     */
+    assert(((PHYSFS_uint64) pos) >= ui64);
+    *data_start = ((PHYSFS_uint64) pos) - ui64;
+
+    BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
+
+    /* check signature again, just in case. */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != ZIP64_END_OF_CENTRAL_DIR_SIG, PHYSFS_ERR_CORRUPT, 0);
+
+    /* size of Zip64 end of central directory record. */
+    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+
+    /* version made by. */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+
+    /* version needed to extract. */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+
+    /* number of this disk. */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
+
+    /* number of disk with start of central directory record. */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
+
+    /* total number of entries in the central dir on this disk */
+    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+
+    /* total number of entries in the central dir */
+    BAIL_IF_MACRO(!readui64(io, entry_count), ERRPASS, 0);
+    BAIL_IF_MACRO(ui64 != *entry_count, PHYSFS_ERR_CORRUPT, 0);
+
+    /* size of the central directory */
+    BAIL_IF_MACRO(!readui64(io, dir_size), ERRPASS, 0);
+
+    /* offset of central directory */
+    BAIL_IF_MACRO(!readui64(io, dir_ofs), ERRPASS, 0);
+
+    /* Since we know the difference, fix up the central dir offset... */
+    *dir_ofs += *data_start;
+
+    /*
+     * There are more fields here, for encryption and feature-specific things,
+     *  but we don't care about any of them at the moment.
+     */
+
+    return 1;  /* made it. */
+} /* zip64_parse_end_of_central_dir */
+
+
+static int zip_parse_end_of_central_dir(ZIPinfo *info,
+                                        PHYSFS_uint64 *data_start,
+                                        PHYSFS_uint64 *dir_ofs,
+                                        PHYSFS_uint64 *dir_size,
+                                        PHYSFS_uint64 *entry_count)
+{
+    PHYSFS_Io *io = info->io;
+    PHYSFS_uint16 entryCount16;
+    PHYSFS_uint32 offset32;
+    PHYSFS_uint32 ui32;
+    PHYSFS_uint16 ui16;
+    PHYSFS_sint64 len;
+    PHYSFS_sint64 pos;
+    int rc;
+
+    /* find the end-of-central-dir record, and seek to it. */
+    pos = zip_find_end_of_central_dir(io, &len);
+    BAIL_IF_MACRO(pos == -1, ERRPASS, 0);
+    BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
+
+    /* check signature again, just in case. */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    BAIL_IF_MACRO(ui32 != ZIP_END_OF_CENTRAL_DIR_SIG, PHYSFS_ERR_CORRUPT, 0);
+
+    /* Seek back to see if "Zip64 end of central directory locator" exists. */
+    /* this record is 20 bytes before end-of-central-dir */
+    rc = zip64_parse_end_of_central_dir(info, data_start, dir_ofs, dir_size,
+                                        entry_count, pos - 20);
+
+    /* Error or success? Bounce out of here. Keep going if not zip64. */
+    if ((rc == 0) || (rc == 1))
+        return rc;
+
+    assert(rc == -1);  /* no error, just not a Zip64 archive. */
+
+    /* Not Zip64? Seek back to where we were and keep processing. */
+    BAIL_IF_MACRO(!io->seek(io, pos + 4), ERRPASS, 0);
+
+    /* number of this disk */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    BAIL_IF_MACRO(ui16 != 0, PHYSFS_ERR_CORRUPT, 0);
+
+    /* number of the disk with the start of the central directory */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    BAIL_IF_MACRO(ui16 != 0, PHYSFS_ERR_CORRUPT, 0);
+
+    /* total number of entries in the central dir on this disk */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+
+    /* total number of entries in the central dir */
+    BAIL_IF_MACRO(!readui16(io, &entryCount16), ERRPASS, 0);
+    BAIL_IF_MACRO(ui16 != entryCount16, PHYSFS_ERR_CORRUPT, 0);
+
+    *entry_count = entryCount16;
+
+    /* size of the central directory */
+    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    *dir_size = (PHYSFS_uint64) ui32;
+
+    /* offset of central directory */
+    BAIL_IF_MACRO(!readui32(io, &offset32), ERRPASS, 0);
+    *dir_ofs = (PHYSFS_uint64) offset32;
+    BAIL_IF_MACRO(pos < (*dir_ofs + ui32), PHYSFS_ERR_CORRUPT, 0);
+
+    /*
+     * For self-extracting archives, etc, there's crapola in the file
+     *  before the zipfile records; we calculate how much data there is
+     *  prepended by determining how far the central directory offset is
+     *  from where it is supposed to be (start of end-of-central-dir minus
+     *  sizeof central dir)...the difference in bytes is how much arbitrary
+     *  data is at the start of the physical file.
+     */
+    *data_start = (PHYSFS_uint64) (pos - (*dir_ofs + ui32));
+
+    /* Now that we know the difference, fix up the central dir offset... */
+    *dir_ofs += *data_start;
+
+    /* zipfile comment length */
+    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+
+    /*
+     * Make sure that the comment length matches to the end of file...
+     *  If it doesn't, we're either in the wrong part of the file, or the
+     *  file is corrupted, but we give up either way.
+     */
+    BAIL_IF_MACRO((pos + 22 + ui16) != len, PHYSFS_ERR_CORRUPT, 0);
+
+    return 1;  /* made it. */
+} /* zip_parse_end_of_central_dir */
+
+
+/*
+ * Set up the entry table, hash and name pool for (entry_count) entries out
+ *  of a central directory of (dir_size) bytes, with just the root dir in
+ *  it. Parent dirs that aren't in the archive get added as we go, so all
+ *  of this can grow later, but this is usually the lot.
+ */
+static int zip_alloc_entries(ZIPinfo *info, const PHYSFS_uint64 entry_count,
+                             const PHYSFS_uint64 dir_size)
+{
+    /* every central dir record is 46 bytes and then its name and such. */
+    const PHYSFS_uint64 names_len = (dir_size > (entry_count * 46)) ?
+                                        (dir_size - (entry_count * 46)) : 0;
+
+    BAIL_IF_MACRO(entry_count >= 0xFFFFFFFF, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!__PHYSFS_hashTableInit(&info->hash, entry_count),
+                  ERRPASS, 0);
+
+    info->entries = (ZIPentry *) zip_grow(NULL, &info->entries_allocated,
+                                          entry_count + 1, sizeof (ZIPentry));
+    BAIL_IF_MACRO(!info->entries, ERRPASS, 0);
+    info->names = (char *) zip_grow(NULL, &info->names_allocated,
+                                    names_len + 1, 1);
+    BAIL_IF_MACRO(!info->names, ERRPASS, 0);
+
+    /* the root dir, which has no name, and is also "none". See ZIPentry. */
+    memset(&info->entries[0], '\0', sizeof (ZIPentry));
+    info->entries[0].resolved = ZIP_DIRECTORY;
+    info->entries_used = 1;
+    info->names[0] = '\0';
+    info->names_used = 1;
+    return zip_charge_index(info);
+} /* zip_alloc_entries */
+
+/*
+ * Read (count) checkpoint positions from (io) for (entry), and make sure
+ *  they make sense for it. Returns zero if they don't, or we're out of
+ *  memory, in which case (entry) does without.
+ */
+static int zip_load_stored_checkpoints(ZIPinfo *info, PHYSFS_Io *io,
+                                       ZIPentry *entry,
+                                       const PHYSFS_uint32 count)
+{
+    const size_t len = sizeof (ZIPstored) + (sizeof (ZIPcheckpoint) * count);
+    ZIPcheckpoint *checkpoints;
+    ZIPstored *stored;
+    PHYSFS_uint64 last = 0;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(count > entry->uncompressed_size, PHYSFS_ERR_CORRUPT, 0);
+    stored = (ZIPstored *) __PHYSFS_arenaAlloc(&info->arena, len);
+    BAIL_IF_MACRO(!stored, ERRPASS, 0);
+    checkpoints = (ZIPcheckpoint *) (stored + 1);
+
+    for (i = 0; i < count; i++)
+    {
+        ZIPcheckpoint *cp = &checkpoints[i];
+        cp->state = NULL;
+        if ( (!readui64(io, &cp->uncompressed_position)) ||
+             (!readui64(io, &cp->compressed_position)) )
+            break;
+        else if ((cp->uncompressed_position <= last) ||
+                 (cp->uncompressed_position > entry->uncompressed_size) ||
+                 (cp->compressed_position > entry->compressed_size))
+            break;  /* nonsense, don't trust any of it. */
+        last = cp->uncompressed_position;
+    } /* for */
+
+    /* (stored) stays in the arena until close; not worth rolling back. */
+    BAIL_IF_MACRO(i < count, PHYSFS_ERR_CORRUPT, 0);
+
+    stored->checkpoints = checkpoints;
+    stored->count = count;
+    stored->states = (PHYSFS_uint64) io->tell(io);
+    entry->stored = stored;
+    return 1;
+} /* zip_load_stored_checkpoints */
+
+
+static int zip_parse_seek_index(ZIPinfo *info, PHYSFS_Io *io)
+{
+    PHYSFS_uint32 sig, version, statelen, byteorder, count, i;
+
+    BAIL_IF_MACRO(!readui32(io, &sig), ERRPASS, 0);
+    BAIL_IF_MACRO(!readui32(io, &version), ERRPASS, 0);
+    BAIL_IF_MACRO(!readui32(io, &statelen), ERRPASS, 0);
+    BAIL_IF_MACRO(!__PHYSFS_readAll(io, &byteorder, 4), ERRPASS, 0);
+    BAIL_IF_MACRO(!readui32(io, &count), ERRPASS, 0);
+    BAIL_IF_MACRO(sig != ZIP_SEEKINDEX_SIG, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(version != ZIP_SEEKINDEX_VERSION, PHYSFS_ERR_UNSUPPORTED, 0);
+
+    /* the inflater states are only good for builds that lay them out alike. */
+    if ((statelen != PHYSFS_INFLATE_STATE_SIZE) || (statelen == 0) ||
+        (byteorder != ZIP_SEEKINDEX_BYTEORDER))
+        BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+
+    for (i = 0; i < count; i++)
+    {
+        PHYSFS_uint32 namelen, crc, cpcount;
+        PHYSFS_uint64 compsize, uncompsize, pos;
+        ZIPentry *entry;
+        char *name;
+
+        BAIL_IF_MACRO(!readui32(io, &namelen), ERRPASS, 0);
+        BAIL_IF_MACRO(namelen > 0xFFFF, PHYSFS_ERR_CORRUPT, 0);
+        name = (char *) __PHYSFS_smallAlloc(namelen + 1);
+        BAIL_IF_MACRO(!name, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        if (!__PHYSFS_readAll(io, name, namelen))
+        {
+            __PHYSFS_smallFree(name);
+            return 0;
+        } /* if */
+        name[namelen] = '\0';
+        entry = zip_find_entry(info, name);
+        __PHYSFS_smallFree(name);
+
+        BAIL_IF_MACRO(!readui32(io, &crc), ERRPASS, 0);
+        BAIL_IF_MACRO(!readui64(io, &compsize), ERRPASS, 0);
+        BAIL_IF_MACRO(!readui64(io, &uncompsize), ERRPASS, 0);
+        BAIL_IF_MACRO(!readui32(io, &cpcount), ERRPASS, 0);
+        pos = (PHYSFS_uint64) io->tell(io);
+
+        /* entries are unresolved at this point; symlinks don't count. */
+        if ( (entry != NULL) && (entry->resolved == ZIP_UNRESOLVED_FILE) &&
+             (entry->stored == NULL) && (cpcount > 0) &&
+             (entry->crc == crc) && (entry->compressed_size == compsize) &&
+             (entry->uncompressed_size == uncompsize) &&
+             (zip_entry_is_deflated(entry)) &&
+             (!zip_entry_is_tradional_crypto(entry)) )
+        {
+            /* optional; (entry) just does without if this fails. */
+            zip_load_stored_checkpoints(info, io, entry, cpcount);
+        } /* if */
+
+        pos += ((PHYSFS_uint64) cpcount) * (8 + PHYSFS_INFLATE_STATE_SIZE);
+        BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
+    } /* for */
+
+    return 1;
+} /* zip_parse_seek_index */
+
+
+static void zip_free_stored_checkpoints(ZIPinfo *info)
+{
+    PHYSFS_uint32 i;
+    for (i = 0; i < info->entries_used; i++)
+        info->entries[i].stored = NULL;
+    __PHYSFS_arenaDeinit(&info->arena);
+} /* zip_free_stored_checkpoints */
+
+
+/*
+ * Pick up (name)'s seek index, if it's a native file and has one. This is
+ *  strictly optional, so it never fails, or leaves an error code behind.
+ */
+static void zip_load_seek_index(ZIPinfo *info, const char *name)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const size_t len = strlen(name) + sizeof (ZIP_SEEKINDEX_EXTENSION);
+    char *path = (char *) __PHYSFS_smallAlloc(len);
+    PHYSFS_Io *io = NULL;
+
+    if (path != NULL)
+    {
+        strcpy(path, name);
+        strcat(path, ZIP_SEEKINDEX_EXTENSION);
+        io = __PHYSFS_createNativeIo(path, 'r');
+        __PHYSFS_smallFree(path);
+    } /* if */
+
+    if (io != NULL)
+    {
+        if (zip_parse_seek_index(info, io))
+            info->seekindex = io;
+        else
+        {
+            zip_free_stored_checkpoints(info);
+            io->destroy(io);
+        } /* else */
+    } /* if */
+
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+} /* zip_load_seek_index */
+
+
+/*
+ * Read in all (len) bytes of the central directory at (ofs) with one read,
+ *  or use them where they are if (io) can be mapped, so parsing it later
+ *  is a walk through memory instead of a pile of little reads.
+ */
+static PHYSFS_Io *zip_read_central_dir(PHYSFS_Io *io, const PHYSFS_uint64 ofs,
+                                       const PHYSFS_uint64 len)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const PHYSFS_uint8 *mapped = NULL;
+    PHYSFS_uint64 mappedlen = 0;
+    PHYSFS_uint8 *buf;
+    PHYSFS_Io *retval;
+
+    /* a failed map is no error as far as our caller is concerned. */
+    if (!__PHYSFS_ioMap(io, (const void **) &mapped, &mappedlen))
+        mapped = NULL;
+    else if ((ofs > mappedlen) || (len > mappedlen - ofs))
+        mapped = NULL;
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    if (mapped != NULL)  /* (io) outlives the central dir, so this is safe. */
+        return __PHYSFS_createMemoryIo(mapped + ofs, len, NULL);
+
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(len),
+                  PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    buf = (PHYSFS_uint8 *) allocator.Malloc((size_t) (len ? len : 1));
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+
+    if ((!io->seek(io, ofs)) || (!__PHYSFS_readAll(io, buf, len)))
+    {
+        allocator.Free(buf);
+        return NULL;
+    } /* if */
+
+    retval = __PHYSFS_createMemoryIo(buf, len, zip_free_buffer);
+    if (retval == NULL)
+        allocator.Free(buf);
+    return retval;
+} /* zip_read_central_dir */
+
+
+/*
+ * The central directory is only parsed, and its entries hashed, the first
+ *  time something needs to look in the archive, so mounting a big one is
+ *  just reading it in. If it turns out to be bad, that's reported by the
+ *  first lookup, and every one after it. Every lookup comes through here,
+ *  so once it's loaded, they only hold the lock shared.
+ */
+static int zip_load_central_dir(ZIPinfo *info)
+{
+    PHYSFS_ErrorCode err;
+    PHYSFS_Io *centraldir;
+
+    __PHYSFS_platformGrabRWLockShared(info->rwlock);
+    centraldir = info->centraldir;
+    err = info->load_error;
+    __PHYSFS_platformReleaseRWLockShared(info->rwlock);
+    if (centraldir == NULL)
+    {
+        BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+        return 1;
+    } /* if */
+
+    /* someone else might get it first; we'll see after we grab this. */
+    __PHYSFS_platformGrabRWLockExclusive(info->rwlock);
+    centraldir = info->centraldir;
+    info->centraldir = NULL;  /* so our own lookups don't end up here. */
+    if (centraldir != NULL)
+    {
+        if ( (!zip_alloc_entries(info, info->entry_count,
+                                 centraldir->length(centraldir))) ||
+             (!zip_load_entries(info, centraldir, info->data_start,
+                                info->entry_count)) )
+        {
+            info->load_error = PHYSFS_getLastErrorCode();
+            if (info->load_error == PHYSFS_ERR_OK)
+                info->load_error = PHYSFS_ERR_CORRUPT;
+        } /* if */
+
+        else
+        {
+            assert(info->entries[0].sibling == 0);
+            if (info->name != NULL)
+                zip_load_seek_index(info, info->name);
+        } /* else */
+
+        allocator.Free(info->name);
+        info->name = NULL;
+    } /* if */
+    err = info->load_error;
+    __PHYSFS_platformReleaseRWLockExclusive(info->rwlock);
+
+    /* memoryIos take stateLock to go away, so not while we hold ours. */
+    if (centraldir != NULL)
+        centraldir->destroy(centraldir);
+
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+} /* zip_load_central_dir */
+
+
+/* One thread's share of zip_resolve_all(). */
+typedef struct
+{
+    PHYSFS_Io *io;          /* our own duplicate of the archive's i/o.  */
+    ZIPentry **entries;     /* our run of them, sorted by offset.       */
+    PHYSFS_uint32 count;    /* elements in entries.                     */
+    void *thread;           /* doing this, or NULL for the caller.      */
+} ZIPresolveRun;
+
+static int cmpEntryOffsets(void *_a, size_t one, size_t two)
+{
+    ZIPentry **a = (ZIPentry **) _a;
+    if (a[one]->offset < a[two]->offset)
+        return -1;
+    return (a[one]->offset > a[two]->offset) ? 1 : 0;
+} /* cmpEntryOffsets */
+
+static void swapEntryOffsets(void *_a, size_t one, size_t two)
+{
+    ZIPentry **a = (ZIPentry **) _a;
+    ZIPentry *tmp = a[one];
+    a[one] = a[two];
+    a[two] = tmp;
+} /* swapEntryOffsets */
+
+
+/*
+ * Check the local headers of a run of unresolved files, sorted by offset,
+ *  a window of the archive at a time. Anything we can't read is left for
+ *  its first open to try again and report why; headers that don't match
+ *  are marked broken, just like that open would have.
+ */
+static void zip_resolve_run(void *data)
+{
+    ZIPresolveRun *run = (ZIPresolveRun *) data;
+    PHYSFS_Io *io = run->io;
+    const PHYSFS_sint64 iolen = io->length(io);
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) allocator.Malloc(ZIP_RESOLVE_WINDOW);
+    PHYSFS_uint64 bufstart = 0;
+    PHYSFS_uint64 buflen = 0;
+    PHYSFS_uint32 i;
+
+    if ((buf == NULL) || (iolen < 0))
+    {
+        allocator.Free(buf);
+        return;  /* they'll all just resolve on first open. */
+    } /* if */
+
+    for (i = 0; i < run->count; i++)
+    {
+        ZIPentry *entry = run->entries[i];
+        const PHYSFS_uint64 ofs = entry->offset;
+        PHYSFS_uint32 hdrlen;
+
+        if ( (ofs < bufstart) ||
+             (ofs + ZIP_LOCAL_HEADER_SIZE > bufstart + buflen) )
+        {
+            PHYSFS_uint64 want = ZIP_RESOLVE_WINDOW;
+            PHYSFS_sint64 br = -1;
+            if (ofs >= (PHYSFS_uint64) iolen)
+                want = 0;
+            else if (want > ((PHYSFS_uint64) iolen) - ofs)
+                want = ((PHYSFS_uint64) iolen) - ofs;
+
+            if ((want > 0) && (io->seek(io, ofs)))
+                br = io->read(io, buf, want);
+            bufstart = ofs;
+            buflen = (br > 0) ? (PHYSFS_uint64) br : 0;
+            if (buflen < ZIP_LOCAL_HEADER_SIZE)
+                continue;
+        } /* if */
+
+        hdrlen = zip_check_local(buf + (size_t) (ofs - bufstart), entry);
+        if (hdrlen == 0)
+            entry->resolved = ZIP_BROKEN_FILE;
+        else
+        {
+            entry->offset += hdrlen;
+            entry->resolved = ZIP_RESOLVED;
+        } /* else */
+    } /* for */
+
+    allocator.Free(buf);
+} /* zip_resolve_run */
+
+
+/*
+ * Load the central directory and resolve every entry in it now, instead of
+ *  on each one's first open, for PHYSFS_setResolveOnMount(). Call this
+ *  before anyone else can see (info). Failures are left for lookups and
+ *  opens to report, so this never fails, and leaves the error state alone.
+ */
+static void zip_resolve_all(ZIPinfo *info)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    ZIPresolveRun runs[ZIP_RESOLVE_THREADS];
+    ZIPentry **sorted = NULL;
+    PHYSFS_uint32 numruns = 0;
+    PHYSFS_uint32 count = 0;
+    PHYSFS_uint32 per;
+    PHYSFS_uint32 i;
+    PHYSFS_Io *io;
+
+    if (!zip_load_central_dir(info))
+        goto zip_resolve_all_done;
+
+    sorted = (ZIPentry **) allocator.Malloc(sizeof (ZIPentry *) *
+                                            info->entries_used);
+    if (sorted != NULL)
+    {
+        for (i = 1; i < info->entries_used; i++)
+        {
+            if (info->entries[i].resolved == ZIP_UNRESOLVED_FILE)
+                sorted[count++] = &info->entries[i];
+        } /* for */
+        __PHYSFS_sort(sorted, count, cmpEntryOffsets, swapEntryOffsets);
+
+        numruns = (count + ZIP_RESOLVE_PER_THREAD - 1) / ZIP_RESOLVE_PER_THREAD;
+        if (numruns > ZIP_RESOLVE_THREADS)
+            numruns = ZIP_RESOLVE_THREADS;
+    } /* if */
+
+    if (numruns > 0)
+    {
+        per = (count + numruns - 1) / numruns;
+        memset(runs, '\0', sizeof (runs));
+        for (i = 0; i < numruns; i++)
+        {
+            runs[i].entries = sorted + (i * per);
+            runs[i].count = ((count - (i * per)) < per) ? count - (i*per) : per;
+            runs[i].io = info->io->duplicate(info->io);
+            if ((runs[i].io != NULL) && (i > 0))  /* we do the first one. */
+                runs[i].thread = __PHYSFS_startTask(zip_resolve_run, &runs[i]);
+        } /* for */
+
+        /* our run, and any a thread couldn't be started for. */
+        for (i = 0; i < numruns; i++)
+        {
+            if ((runs[i].io != NULL) && (runs[i].thread == NULL))
+                zip_resolve_run(&runs[i]);
+        } /* for */
+
+        for (i = 0; i < numruns; i++)
+        {
+            if (runs[i].thread != NULL)
+                __PHYSFS_waitTask(runs[i].thread);
+            if (runs[i].io != NULL)
+                runs[i].io->destroy(runs[i].io);
+        } /* for */
+    } /* if */
+
+    allocator.Free(sorted);
+
+    /* symlinks need their targets looked up, so they're done one by one. */
+    io = info->io->duplicate(info->io);
+    if (io != NULL)
+    {
+        for (i = 1; i < info->entries_used; i++)
+        {
+            if (info->entries[i].resolved == ZIP_UNRESOLVED_SYMLINK)
+                zip_resolve(io, info, &info->entries[i]);
+        } /* for */
+        io->destroy(io);
+    } /* if */
+
+zip_resolve_all_done:
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+} /* zip_resolve_all */
+
+
+static void ZIP_closeArchive(void *opaque);
+
+/*
+ * Open (io) for reading. On failure, (io) is left for the caller to destroy.
+ *  (resolve) is non-zero to resolve every entry now; see zip_resolve_all().
+ */
+static ZIPinfo *zip_open_reader(PHYSFS_Io *io, const char *name,
+                                const int resolve)
+{
+    ZIPinfo *info = NULL;
+    PHYSFS_uint64 cdir_ofs;  /* central dir offset */
+    PHYSFS_uint64 cdir_size;  /* central dir size */
+    PHYSFS_sint64 len;
+
+    BAIL_IF_MACRO(!isZip(io), ERRPASS, NULL);
+
+    info = (ZIPinfo *) allocator.Malloc(sizeof (ZIPinfo));
+    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(info, '\0', sizeof (ZIPinfo));
+    info->io = io;
+    info->mem = __PHYSFS_memMountAccount();
+
+    info->rwlock = __PHYSFS_platformCreateRWLock();
+    GOTO_IF_MACRO(!info->rwlock, ERRPASS, zip_open_reader_failed);
+    info->spare_mutex = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!info->spare_mutex, ERRPASS, zip_open_reader_failed);
+
+    if (!zip_parse_end_of_central_dir(info, &info->data_start, &cdir_ofs,
+                                      &cdir_size, &info->entry_count))
+        goto zip_open_reader_failed;
+
+    /*
+     * Everything after this costs in proportion to the central dir, so make
+     *  sure the file really has one that big, and that it really has room
+     *  for as many entries as it says (every record is at least 46 bytes),
+     *  before we believe either of them.
+     */
+    __PHYSFS_getMountLimits(&info->max_entries, &info->max_depth,
+                            &info->max_hops, &info->max_index);
+    len = io->length(io);
+    GOTO_IF_MACRO(len < 0, ERRPASS, zip_open_reader_failed);
+    GOTO_IF_MACRO((cdir_ofs > (PHYSFS_uint64) len) ||
+                  (cdir_size > ((PHYSFS_uint64) len) - cdir_ofs) ||
+                  (info->entry_count > cdir_size / 46),
+                  PHYSFS_ERR_CORRUPT, zip_open_reader_failed);
+    GOTO_IF_MACRO(info->max_entries &&
+                  (info->entry_count > info->max_entries),
+                  PHYSFS_ERR_UNSUPPORTED, zip_open_reader_failed);
+    GOTO_IF_MACRO(info->max_index &&
+                  (((info->entry_count + 1) * sizeof (ZIPentry)) +
+                   (cdir_size - (info->entry_count * 46)) > info->max_index),
+                  PHYSFS_ERR_OUT_OF_MEMORY, zip_open_reader_failed);
+
+    info->centraldir = zip_read_central_dir(io, cdir_ofs, cdir_size);
+    GOTO_IF_MACRO(!info->centraldir, ERRPASS, zip_open_reader_failed);
+    info->centraldir_ofs = cdir_ofs;
+
+    if (name != NULL)
+    {
+        info->name = (char *) allocator.Malloc(strlen(name) + 1);
+        GOTO_IF_MACRO(!info->name, PHYSFS_ERR_OUT_OF_MEMORY,
+                      zip_open_reader_failed);
+        strcpy(info->name, name);
+    } /* if */
+
+    if (resolve)
+        zip_resolve_all(info);
+
+    return info;
+
+zip_open_reader_failed:
+    info->io = NULL;  /* don't let ZIP_closeArchive destroy (io). */
+    ZIP_closeArchive(info);
+    return NULL;
+} /* zip_open_reader */
+
+
+static void *zip_open_writer(PHYSFS_Io *io, const char *name);
+static void zipw_enumerate(struct _ZIPwriter *w, const char *dname,
+                           PHYSFS_EnumFilesCallback cb,
+                           PHYSFS_EnumFilesStatCallback statcb,
+                           const char *origdir, void *callbackdata);
+
+static void *ZIP_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
+{
+    assert(io != NULL);  /* shouldn't ever happen. */
+
+    if (forWriting)
+        return zip_open_writer(io, name);
+
+    return zip_open_reader(io, name, __PHYSFS_getResolveOnMount());
+} /* ZIP_openArchive */
+
+
+static void ZIP_enumerateFiles(void *opaque, const char *dname,
+                               PHYSFS_EnumFilesCallback cb,
+                               const char *origdir, void *callbackdata)
+{
+    ZIPinfo *info = ((ZIPinfo *) opaque);
+    const ZIPentry *entry;
+
+    if (info->writer)
+    {
+        zipw_enumerate(info->writer, dname, cb, NULL, origdir, callbackdata);
+        return;
+    } /* if */
+
+    if (!zip_load_central_dir(info))
+        return;
+
+    entry = zip_find_entry(info, dname);
+    if (entry && (entry->resolved == ZIP_DIRECTORY))
+    {
+        PHYSFS_uint32 i;
+        for (i = entry->children; i != 0; i = info->entries[i].sibling)
+        {
+            const char *name = zip_entry_name(info, &info->entries[i]);
+            const char *ptr = strrchr(name, '/');
+            cb(callbackdata, origdir, ptr ? ptr + 1 : name);
+        } /* for */
+    } /* if */
+} /* ZIP_enumerateFiles */
+
+
+static void ZIP_enumerateFilesPrefix(void *opaque, const char *dname,
+                                     const char *prefix,
+                                     PHYSFS_EnumFilesCallback cb,
+                                     const char *origdir, void *callbackdata)
+{
+    ZIPinfo *info = ((ZIPinfo *) opaque);
+    const PHYSFS_uint32 prefixlen = (PHYSFS_uint32) strlen(prefix);
+    const ZIPentry *entry;
+
+    /* the caller filters whatever we report, so just list it all. */
+    if (info->writer)
+    {
+        zipw_enumerate(info->writer, dname, cb, NULL, origdir, callbackdata);
+        return;
+    } /* if */
+
+    if (!zip_load_central_dir(info))
+        return;
+
+    /*
+     * The children aren't sorted, but only (dname)'s are looked at at all,
+     *  and the misses never get as far as the caller.
+     */
+    entry = zip_find_entry(info, dname);
+    if (entry && (entry->resolved == ZIP_DIRECTORY))
+    {
+        PHYSFS_uint32 i;
+        for (i = entry->children; i != 0; i = info->entries[i].sibling)
+        {
+            const char *name = zip_entry_name(info, &info->entries[i]);
+            const char *ptr = strrchr(name, '/');
+            ptr = ptr ? ptr + 1 : name;
+            if (__PHYSFS_strnicmpASCII(ptr, prefix, prefixlen) == 0)
+                cb(callbackdata, origdir, ptr);
+        } /* for */
+    } /* if */
+} /* ZIP_enumerateFilesPrefix */
+
+
+static PHYSFS_Io *zip_get_io(PHYSFS_Io *io, ZIPinfo *inf, ZIPentry *entry)
+{
+    int success;
+    PHYSFS_Io *retval = io->duplicate(io);
+    BAIL_IF_MACRO(!retval, ERRPASS, NULL);
+
+    /* !!! FIXME: if you open a dir here, it should bail ERR_NOT_A_FILE */
+
+    /* (inf) can be NULL if we already resolved. */
+    if (inf == NULL)
+        success = 1;
+    else
+    {
+        /* once it's resolved, it never changes, so most opens just look. */
+        __PHYSFS_platformGrabRWLockShared(inf->rwlock);
+        success = (entry->resolved == ZIP_RESOLVED);
+        __PHYSFS_platformReleaseRWLockShared(inf->rwlock);
+
+        /* resolving updates (entry), and another thread might be opening it. */
+        if (!success)
+        {
+            __PHYSFS_platformGrabRWLockExclusive(inf->rwlock);
+            success = zip_resolve(retval, inf, entry);
+            __PHYSFS_platformReleaseRWLockExclusive(inf->rwlock);
+        } /* if */
+    } /* else */
+    if (success)
+    {
+        PHYSFS_uint64 offset = entry->offset;
+        if (entry->symlink != 0)
+        {
+            assert(inf != NULL);  /* NULL means it's already the target. */
+            offset = zip_symlink_target(inf, entry)->offset;
+        } /* if */
+        success = retval->seek(retval, offset);
+    } /* if */
+
+    if (!success)
+    {
+        retval->destroy(retval);
+        retval = NULL;
+    } /* if */
+
+    return retval;
+} /* zip_get_io */
+
+
+static int zip_entry_is_cacheable(const ZIPentry *entry,
+                                  const PHYSFS_uint64 budget)
+{
+    if (entry->compression_method == COMPMETH_NONE)
+        return 0;  /* already cheap to open. */
+    else if (zip_entry_is_tradional_crypto(entry))
+        return 0;  /* keep needing the password. */
+    else if (entry->uncompressed_size == 0)
+        return 0;  /* nothing to save. */
+    else if (!__PHYSFS_ui64FitsAddressSpace(entry->uncompressed_size))
+        return 0;
+    return (entry->uncompressed_size <= (budget / 4));
+} /* zip_entry_is_cacheable */
+
+
+/* Unlink (cached) from (info)'s LRU list. Hold info->rwlock exclusive. */
+static void zip_cache_unlink(ZIPinfo *info, ZIPcached *cached)
+{
+    if (cached->prev != NULL)
+        cached->prev->next = cached->next;
+    else
+        info->cache_head = cached->next;
+
+    if (cached->next != NULL)
+        cached->next->prev = cached->prev;
+    else
+        info->cache_tail = cached->prev;
+
+    cached->prev = cached->next = NULL;
+} /* zip_cache_unlink */
+
+
+/* Make (cached) the most recently used. Hold info->rwlock exclusive. */
+static void zip_cache_push(ZIPinfo *info, ZIPcached *cached)
+{
+    cached->prev = NULL;
+    cached->next = info->cache_head;
+    if (info->cache_head != NULL)
+        info->cache_head->prev = cached;
+    else
+        info->cache_tail = cached;
+    info->cache_head = cached;
+} /* zip_cache_push */
+
+
+static void zip_free_cached(ZIPcached *cached)
+{
+    while (cached != NULL)
+    {
+        ZIPcached *next = cached->next;
+        cached->io->destroy(cached->io);  /* open files keep theirs. */
+        allocator.Free(cached);
+        cached = next;
+    } /* while */
+} /* zip_free_cached */
+
+
+/* Hand out another reference to (entry)'s cached data, or NULL. */
+static PHYSFS_Io *zip_cache_lookup(ZIPinfo *info, ZIPentry *entry)
+{
+    PHYSFS_Io *retval = NULL;
+    ZIPcached *cached;
+
+    if (entry->symlink != 0)  /* only resolved entries get cached. */
+        entry = zip_symlink_target(info, entry);
+
+    /* misses are the common case, and don't need to touch the LRU list. */
+    __PHYSFS_platformGrabRWLockShared(info->rwlock);
+    cached = entry->cached;
+    __PHYSFS_platformReleaseRWLockShared(info->rwlock);
+    if (cached == NULL)
+        return NULL;
+
+    __PHYSFS_platformGrabRWLockExclusive(info->rwlock);
+    cached = entry->cached;  /* might have been evicted meanwhile. */
+    if (cached != NULL)
+    {
+        retval = cached->io->duplicate(cached->io);
+        if ((retval != NULL) && (cached != info->cache_head))
+        {
+            zip_cache_unlink(info, cached);
+            zip_cache_push(info, cached);
+        } /* if */
+    } /* if */
+    __PHYSFS_platformReleaseRWLockExclusive(info->rwlock);
+
+    return retval;
+} /* zip_cache_lookup */
+
+
+/*
+ * If (io), a ZIP_Io fresh from zip_open_read(), is for something worth
+ *  caching, inflate the whole thing into the cache and hand back a memoryIo
+ *  of it instead (for this open and the ones to come). The cache is only an
+ *  optimization, so if anything goes wrong, you just get (io) back.
+ */
+static PHYSFS_Io *zip_cache_fill(ZIPinfo *info, PHYSFS_Io *io)
+{
+    const PHYSFS_uint64 budget = __PHYSFS_getDecompressionCacheSize();
+    ZIPentry *entry = ((ZIPfileinfo *) io->opaque)->entry;
+    ZIPcached *evicted = NULL;
+    ZIPcached *cached = NULL;
+    PHYSFS_uint64 excess;
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_Io *memio = NULL;
+    PHYSFS_Io *retval = NULL;
+    size_t len;
+
+    if (!zip_entry_is_cacheable(entry, budget))
+        return io;
+    else if (!__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES,
+                                  entry->uncompressed_size))
+        return io;  /* stream it through the inflater instead. */
+
+    len = (size_t) entry->uncompressed_size;
+    buf = (PHYSFS_uint8 *) __PHYSFS_cacheAlloc(len);
+    cached = (ZIPcached *) allocator.Malloc(sizeof (ZIPcached));
+    if ((buf == NULL) || (cached == NULL))
+        goto zip_cache_fill_failed;
+
+    __PHYSFS_cacheOwner(buf, info->mem);
+    if (!__PHYSFS_readAll(io, buf, len))
+        goto zip_cache_fill_failed;
+    else if ((memio = __PHYSFS_createMemoryIo(buf, len,
+                                              __PHYSFS_cacheFree)) == NULL)
+        goto zip_cache_fill_failed;
+
+    buf = NULL;  /* memio owns it now. */
+    retval = memio->duplicate(memio);
+    if (retval == NULL)
+        goto zip_cache_fill_failed;
+
+    io->destroy(io);
+    cached->entry = entry;
+    cached->io = memio;
+    cached->len = len;
+    cached->prev = cached->next = NULL;
+
+    __PHYSFS_platformGrabRWLockExclusive(info->rwlock);
+    if (entry->cached != NULL)  /* another thread beat us to it. */
+        evicted = cached;  /* just drop ours. */
+    else
+    {
+        entry->cached = cached;
+        zip_cache_push(info, cached);
+        info->cache_used += len;
+
+        /* make room, least recently used first. */
+        excess = __PHYSFS_memExcess(PHYSFS_MEMORY_CACHES);
+        while (((info->cache_used > budget) || (excess > 0)) &&
+               (info->cache_tail != cached))
+        {
+            ZIPcached *victim = info->cache_tail;
+            excess -= (excess < victim->len) ? excess : victim->len;
+            zip_cache_unlink(info, victim);
+            victim->entry->cached = NULL;
+            info->cache_used -= victim->len;
+            victim->next = evicted;
+            evicted = victim;
+        } /* while */
+    } /* else */
+    __PHYSFS_platformReleaseRWLockExclusive(info->rwlock);
+
+    zip_free_cached(evicted);  /* not with the lock held: this locks, too. */
+    return retval;
+
+zip_cache_fill_failed:
+    if (memio != NULL)
+        memio->destroy(memio);
+    __PHYSFS_cacheFree(buf);
+    allocator.Free(cached);
+
+    /* whatever we read of (io) has to be unread. */
+    if (!io->seek(io, 0))
+    {
+        io->destroy(io);
+        return NULL;
+    } /* if */
+    return io;
+} /* zip_cache_fill */
+
+
+/*
+ * This does the actual work of ZIP_openRead(). (usecache) is zero to never
+ *  hand out anything but a ZIP_Io.
+ */
+static PHYSFS_Io *zip_open_read(ZIPinfo *info, const char *filename,
+                                const int usecache)
+{
+    PHYSFS_Io *retval = NULL;
+    ZIPentry *entry = NULL;
+    ZIPfileinfo *finfo = NULL;
+    PHYSFS_Io *io = NULL;
+    PHYSFS_uint8 *password = NULL;
+    int i;
+
+    BAIL_IF_MACRO(!zip_load_central_dir(info), ERRPASS, NULL);
+    entry = zip_find_entry(info, filename);
+
+    /* if not found, see if maybe "$PASSWORD" is appended. */
+    if ((!entry) && (info->has_crypto))
+    {
+        const char *ptr = strrchr(filename, '$');
+        if (ptr != NULL)
+        {
+            const PHYSFS_uint64 len = (PHYSFS_uint64) (ptr - filename);
+            char *str = (char *) __PHYSFS_smallAlloc(len + 1);
+            BAIL_IF_MACRO(!str, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+            memcpy(str, filename, len);
+            str[len] = '\0';
+            entry = zip_find_entry(info, str);
+            __PHYSFS_smallFree(str);
+            password = (PHYSFS_uint8 *) (ptr + 1);
+        } /* if */
+    } /* if */
+
+    BAIL_IF_MACRO(!entry, ERRPASS, NULL);
+
+    if ((usecache) && (password == NULL))
+    {
+        retval = zip_cache_lookup(info, entry);
+        if (retval != NULL)
+            return retval;
+    } /* if */
+
+    retval = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, ERRPASS, ZIP_openRead_failed);
+
+    io = zip_get_io(info->io, info, entry);
+    GOTO_IF_MACRO(!io, ERRPASS, ZIP_openRead_failed);
+
+    /* (entry) is resolved now, so we know what we're really reading. */
+    finfo = zip_alloc_fileinfo(info, ((entry->symlink != 0) ?
+                                zip_symlink_target(info, entry) : entry));
+    GOTO_IF_MACRO(!finfo, ERRPASS, ZIP_openRead_failed);
+    finfo->io = io;
+    finfo->seekindex = info->seekindex;
+    GOTO_IF_MACRO(!zip_entry_is_supported(finfo->entry),
+                  PHYSFS_ERR_UNSUPPORTED, ZIP_openRead_failed);
+
+    if (!zip_entry_is_tradional_crypto(entry))
+        GOTO_IF_MACRO(password != NULL, PHYSFS_ERR_BAD_PASSWORD, ZIP_openRead_failed);
+    else
+    {
+        PHYSFS_uint8 crypto_header[12];
+        GOTO_IF_MACRO(password == NULL, PHYSFS_ERR_BAD_PASSWORD, ZIP_openRead_failed);
+        if (io->read(io, crypto_header, 12) != 12)
+            goto ZIP_openRead_failed;
+        else if (!zip_prep_crypto_keys(finfo, crypto_header, password))
+            goto ZIP_openRead_failed;
+    } /* if */
+
+    memcpy(retval, &ZIP_Io, sizeof (PHYSFS_Io));
+    retval->opaque = finfo;
+
+    return (usecache) ? zip_cache_fill(info, retval) : retval;
+
+ZIP_openRead_failed:
+    if (io != NULL)
+        io->destroy(io);
+
+    if (finfo != NULL)
+        zip_free_fileinfo(finfo);
+
+    __PHYSFS_poolFree(retval, sizeof (PHYSFS_Io));
+    return NULL;
+} /* zip_open_read */
+
+
+/*
+ * Writing.
+ *
+ * A ZIP file can be the write dir (PHYSFS_setWriteDir("cache.zip")). Its
+ *  central directory is kept in memory and written once, when the write
+ *  dir is closed. Files opened for writing collect their data in memory,
+ *  stored or deflated as it's written, and each goes out as a local header
+ *  and its data right after the last one when it's closed, so any number
+ *  can be open at once and the archive only ever sees sequential writes.
+ *
+ * Opening an existing archive this way reads its central directory, and new
+ *  entries go where that was. Old entries' data is never moved: deleting or
+ *  replacing one only drops it from the central directory that's written
+ *  at the end. Once anything's been written, the archive isn't a valid ZIP
+ *  file again until the write dir is closed.
+ */
+
+/* what a ZIPwentry is. Deleted entries stay in the hash, to be reused. */
+#define ZIPW_FILE 0
+#define ZIPW_DIR 1
+#define ZIPW_IMPLICIT_DIR 2  /* a parent of something, with no record. */
+#define ZIPW_DELETED 3
+
+/* "made by" MS-DOS, so nobody reads unix permissions into these. */
+#define ZIPW_VERSION_MADE_BY 20
+#define ZIPW_VERSION_NEEDED 20
+#define ZIPW_VERSION_NEEDED_ZIP64 45
+#define ZIPW_GENERAL_BITS_UTF8 0x0800
+#define ZIPW_MSDOS_DIRECTORY 0x10
+
+typedef struct
+{
+    char *name;                         /* no trailing '/', even for dirs. */
+    PHYSFS_uint64 offset;               /* local header, from file start.  */
+    PHYSFS_uint64 compressed_size;
+    PHYSFS_uint64 uncompressed_size;
+    PHYSFS_uint32 crc;
+    PHYSFS_uint32 dos_mod_time;
+    PHYSFS_uint32 external_attr;
+    PHYSFS_uint32 parent;               /* index of our dir, zero for root. */
+    PHYSFS_uint32 children;             /* live entries in here, if a dir.  */
+    PHYSFS_uint16 version;
+    PHYSFS_uint16 version_needed;
+    PHYSFS_uint16 general_bits;
+    PHYSFS_uint16 compression_method;
+    PHYSFS_uint8 type;                  /* ZIPW_* */
+} ZIPwentry;
+
+typedef struct _ZIPwriter
+{
+    PHYSFS_Io *io;             /* the archive, opened for writing.         */
+    char *path;                /* the archive, to read old entries back.   */
+    void *mutex;               /* serializes everything below.             */
+    ZIPwentry *entries;        /* element zero is unused; zero is "none".  */
+    PHYSFS_uint32 entries_used;
+    PHYSFS_uint32 entries_allocated;
+    __PHYSFS_HashTable hash;   /* entry indices by name.                   */
+    PHYSFS_uint64 append_pos;  /* where the next local entry goes.         */
+    PHYSFS_uint64 old_length;  /* archive's size when we opened it.        */
+    int dirty;                 /* central dir needs writing at close.      */
+    PHYSFS_ErrorCode error;    /* a close that failed, for the next call.  */
+} ZIPwriter;
+
+
+/*
+ * A streaming deflater, for files written with PHYSFS_setWriteCompression()
+ *  enabled. It's LZ77 over a 32k window, with a short hash chain search and
+ *  the fixed Huffman codes: nowhere near zlib's ratios, but quick. Input is
+ *  compressed a window's worth at a time, and any block that wouldn't come
+ *  out smaller than its input is stored instead.
+ *
+ * Input is collected into segments of ZIP_DEFLATE_SEGMENT bytes, and up to
+ *  ZIP_DEFLATE_THREADS of them are compressed at once, each on its own
+ *  thread with its own deflater, primed with the 32k before it so it loses
+ *  nothing to the split. Each segment's output ends with an empty stored
+ *  block, to get back to a byte boundary, so they just go one after another
+ *  into a single deflate stream, the way pigz does it. Files smaller than a
+ *  segment never start a thread.
+ */
+#define ZIP_DEFLATE_WINDOW 32768
+#define ZIP_DEFLATE_CHUNK (ZIP_DEFLATE_WINDOW - 1)  /* so positions fit. */
+#define ZIP_DEFLATE_HASH_BITS 15
+#define ZIP_DEFLATE_CHAIN 16  /* most earlier matches to look at. */
+#define ZIP_DEFLATE_SEGMENT (1024 * 1024)
+#define ZIP_DEFLATE_THREADS 4
+#define ZIP_DEFLATE_PENDING \
+    (ZIP_DEFLATE_WINDOW + (ZIP_DEFLATE_SEGMENT * ZIP_DEFLATE_THREADS))
+
+typedef struct
+{
+    /* the last 32k we compressed, then what hasn't been compressed yet. */
+    PHYSFS_uint8 window[ZIP_DEFLATE_WINDOW + ZIP_DEFLATE_CHUNK];
+    PHYSFS_uint16 head[1 << ZIP_DEFLATE_HASH_BITS];  /* latest pos + 1.   */
+    PHYSFS_uint16 prev[ZIP_DEFLATE_WINDOW + ZIP_DEFLATE_CHUNK];  /* same. */
+    PHYSFS_uint32 have;        /* bytes in window.                        */
+    PHYSFS_uint32 start;       /* first byte in window not compressed.    */
+    PHYSFS_uint32 bits;        /* output bits not in a whole byte yet...  */
+    int bitcount;              /* ...and how many.                        */
+} ZIPdeflater;
+
+/* A file open for writing in a ZIPwriter. */
+typedef struct
+{
+    ZIPwriter *writer;
+    char *name;
+    PHYSFS_uint8 *data;        /* what goes after the local header.       */
+    PHYSFS_uint64 data_len;
+    PHYSFS_uint64 data_allocated;
+    PHYSFS_uint64 written;     /* uncompressed bytes written so far.      */
+    PHYSFS_uint32 crc;
+    ZIPdeflater *deflater;     /* NULL if this is stored.                 */
+    PHYSFS_uint8 *pending;     /* deflate: last 32k done, then new input. */
+    PHYSFS_uint32 pending_dict;  /* bytes at the start already done...    */
+    PHYSFS_uint32 pending_len;   /* ...and all the bytes in (pending).    */
+    PHYSFS_uint32 pending_allocated;
+    int failed;                /* a write failed; don't commit this.      */
+} ZIPwfile;
+
+
+static PHYSFS_uint8 *zip_put16(PHYSFS_uint8 *ptr, const PHYSFS_uint32 val)
+{
+    ptr[0] = (PHYSFS_uint8) (val & 0xFF);
+    ptr[1] = (PHYSFS_uint8) ((val >> 8) & 0xFF);
+    return ptr + 2;
+} /* zip_put16 */
+
+static PHYSFS_uint8 *zip_put32(PHYSFS_uint8 *ptr, const PHYSFS_uint32 val)
+{
+    ptr = zip_put16(ptr, val & 0xFFFF);
+    return zip_put16(ptr, (val >> 16) & 0xFFFF);
+} /* zip_put32 */
+
+static PHYSFS_uint8 *zip_put64(PHYSFS_uint8 *ptr, const PHYSFS_uint64 val)
+{
+    ptr = zip_put32(ptr, (PHYSFS_uint32) (val & 0xFFFFFFFF));
+    return zip_put32(ptr, (PHYSFS_uint32) (val >> 32));
+} /* zip_put64 */
+
+
+static PHYSFS_uint32 zip_physfs_time_to_dos_time(const time_t t)
+{
+    const struct tm *tm = localtime(&t);
+    if ((tm == NULL) || (tm->tm_year < 80))
+        return (1 << 21) | (1 << 16);  /* 1980-01-01, as early as it goes. */
+
+    return (((PHYSFS_uint32) (tm->tm_year - 80)) << 25) |
+           (((PHYSFS_uint32) (tm->tm_mon + 1)) << 21) |
+           (((PHYSFS_uint32) tm->tm_mday) << 16) |
+           (((PHYSFS_uint32) tm->tm_hour) << 11) |
+           (((PHYSFS_uint32) tm->tm_min) << 5) |
+           (((PHYSFS_uint32) tm->tm_sec) >> 1);
+} /* zip_physfs_time_to_dos_time */
+
+
+/* Make room for (len) more bytes of (wfile)'s data. */
+static int zipw_reserve(ZIPwfile *wfile, const PHYSFS_uint64 len)
+{
+    const PHYSFS_uint64 needed = wfile->data_len + len;
+    PHYSFS_uint64 newsize;
+    void *ptr;
+
+    if (needed <= wfile->data_allocated)
+        return 1;
+
+    newsize = (wfile->data_allocated) ? (wfile->data_allocated * 2) : 4096;
+    while (newsize < needed)
+        newsize *= 2;
+
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(newsize),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    ptr = allocator.Realloc(wfile->data, (size_t) newsize);
+    BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    wfile->data = (PHYSFS_uint8 *) ptr;
+    wfile->data_allocated = newsize;
+    return 1;
+} /* zipw_reserve */
+
+
+/* Deflate output goes out least significant bit first. Reserve room first! */
+static void zip_deflate_bits(ZIPwfile *wfile, PHYSFS_uint32 val, int count)
+{
+    ZIPdeflater *d = wfile->deflater;
+    d->bits |= val << d->bitcount;
+    d->bitcount += count;
+    while (d->bitcount >= 8)
+    {
+        wfile->data[wfile->data_len++] = (PHYSFS_uint8) (d->bits & 0xFF);
+        d->bits >>= 8;
+        d->bitcount -= 8;
+    } /* while */
+} /* zip_deflate_bits */
+
+
+/* ...but Huffman codes go out most significant bit first. */
+static void zip_deflate_code(ZIPwfile *wfile, PHYSFS_uint32 code, int count)
+{
+    PHYSFS_uint32 reversed = 0;
+    int i;
+    for (i = 0; i < count; i++)
+        reversed |= ((code >> i) & 1) << (count - 1 - i);
+    zip_deflate_bits(wfile, reversed, count);
+} /* zip_deflate_code */
+
+
+/* A literal/length symbol, in the fixed Huffman code. */
+static void zip_deflate_symbol(ZIPwfile *wfile, PHYSFS_uint32 sym)
+{
+    if (sym < 144)
+        zip_deflate_code(wfile, 0x30 + sym, 8);
+    else if (sym < 256)
+        zip_deflate_code(wfile, 0x190 + (sym - 144), 9);
+    else if (sym < 280)
+        zip_deflate_code(wfile, sym - 256, 7);
+    else
+        zip_deflate_code(wfile, 0xC0 + (sym - 280), 8);
+} /* zip_deflate_symbol */
+
+
+static void zip_deflate_match(ZIPwfile *wfile, PHYSFS_uint32 len,
+                              PHYSFS_uint32 dist)
+{
+    static const PHYSFS_uint16 lenbase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51,
+        59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const PHYSFS_uint8 lenextra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,
+        4, 5, 5, 5, 5, 0
+    };
+    static const PHYSFS_uint16 distbase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+        513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385,
+        24577
+    };
+    static const PHYSFS_uint8 distextra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+        10, 11, 11, 12, 12, 13, 13
+    };
+    int i;
+
+    for (i = 28; lenbase[i] > len; i--) { /* spin */ }
+    zip_deflate_symbol(wfile, 257 + i);
+    zip_deflate_bits(wfile, len - lenbase[i], lenextra[i]);
+
+    for (i = 29; distbase[i] > dist; i--) { /* spin */ }
+    zip_deflate_code(wfile, i, 5);
+    zip_deflate_bits(wfile, dist - distbase[i], distextra[i]);
+} /* zip_deflate_match */
+
+
+static inline PHYSFS_uint32 zip_deflate_hash(const PHYSFS_uint8 *p)
+{
+    const PHYSFS_uint32 val = (p[0] << 10) ^ (p[1] << 5) ^ p[2];
+    return val & ((1 << ZIP_DEFLATE_HASH_BITS) - 1);
+} /* zip_deflate_hash */
+
+
+/* Note that position (i) starts with its hash, for later matches. */
+static inline void zip_deflate_insert(ZIPdeflater *d, const PHYSFS_uint32 i)
+{
+    const PHYSFS_uint32 hash = zip_deflate_hash(d->window + i);
+    d->prev[i] = d->head[hash];
+    d->head[hash] = (PHYSFS_uint16) (i + 1);
+} /* zip_deflate_insert */
+
+
+/*
+ * Compress everything in (wfile)'s window that isn't yet as one block, and
+ *  then slide the window down so it just has the last 32k in it.
+ */
+static int zip_deflate_block(ZIPwfile *wfile)
+{
+    ZIPdeflater *d = wfile->deflater;
+    const PHYSFS_uint32 have = d->have;
+    const PHYSFS_uint32 len = have - d->start;
+    const PHYSFS_uint64 rollback_len = wfile->data_len;
+    const PHYSFS_uint32 rollback_bits = d->bits;
+    const int rollback_bitcount = d->bitcount;
+    PHYSFS_uint32 i = d->start;
+
+    if (len == 0)
+        return 1;
+
+    /* fixed codes are at most 9 bits per byte; a stored block is len + 5. */
+    BAIL_IF_MACRO(!zipw_reserve(wfile, len + (len / 4) + 16), ERRPASS, 0);
+
+    zip_deflate_bits(wfile, 0, 1);  /* BFINAL: no, there's always another. */
+    zip_deflate_bits(wfile, 1, 2);  /* BTYPE: fixed Huffman codes. */
+
+    while (i < have)
+    {
+        PHYSFS_uint32 matchlen = 0;
+        PHYSFS_uint32 matchpos = 0;
+
+        if (have - i >= 3)
+        {
+            const PHYSFS_uint32 most = ((have - i) < 258) ? (have - i) : 258;
+            PHYSFS_uint32 cand = d->head[zip_deflate_hash(d->window + i)];
+            int chain = ZIP_DEFLATE_CHAIN;
+
+            while ((cand != 0) && (chain-- > 0))
+            {
+                const PHYSFS_uint32 pos = cand - 1;
+                const PHYSFS_uint8 *a = d->window + pos;
+                const PHYSFS_uint8 *b = d->window + i;
+                PHYSFS_uint32 n = 0;
+
+                if (i - pos > ZIP_DEFLATE_WINDOW)
+                    break;  /* too far back; the rest of the chain is, too. */
+
+                while ((n < most) && (a[n] == b[n]))
+                    n++;
+
+                if (n > matchlen)
+                {
+                    matchlen = n;
+                    matchpos = pos;
+                    if (n == most)
+                        break;
+                } /* if */
+
+                cand = d->prev[pos];
+            } /* while */
+
+            zip_deflate_insert(d, i);
+        } /* if */
+
+        if (matchlen >= 3)
+        {
+            PHYSFS_uint32 j;
+            zip_deflate_match(wfile, matchlen, i - matchpos);
+            for (j = 1; (j < matchlen) && (i + j + 3 <= have); j++)
+                zip_deflate_insert(d, i + j);
+            i += matchlen;
+        } /* if */
+        else
+        {
+            zip_deflate_symbol(wfile, d->window[i++]);
+        } /* else */
+    } /* while */
+
+    zip_deflate_symbol(wfile, 256);  /* end of block. */
+
+    /* didn't help? Store it instead. */
+    if ((wfile->data_len - rollback_len) > (len + 5))
+    {
+        PHYSFS_uint8 *ptr;
+        wfile->data_len = rollback_len;
+        d->bits = rollback_bits;
+        d->bitcount = rollback_bitcount;
+        zip_deflate_bits(wfile, 0, 3);  /* BFINAL no, BTYPE stored. */
+        if (d->bitcount > 0)
+            zip_deflate_bits(wfile, 0, 8 - d->bitcount);  /* to a byte. */
+        ptr = wfile->data + wfile->data_len;
+        ptr = zip_put16(ptr, len);
+        ptr = zip_put16(ptr, ~len & 0xFFFF);
+        memcpy(ptr, d->window + d->start, len);
+        wfile->data_len += len + 4;
+    } /* if */
+
+    /* slide the last 32k down to the start of the window. */
+    if (have > ZIP_DEFLATE_WINDOW)
+    {
+        const PHYSFS_uint32 shift = have - ZIP_DEFLATE_WINDOW;
+        PHYSFS_uint32 j;
+
+        memmove(d->window, d->window + shift, ZIP_DEFLATE_WINDOW);
+        memmove(d->prev, d->prev + shift, ZIP_DEFLATE_WINDOW * sizeof (d->prev[0]));
+        for (j = 0; j < __PHYSFS_ARRAYLEN(d->head); j++)
+            d->head[j] = (d->head[j] > shift) ? (d->head[j] - shift) : 0;
+        for (j = 0; j < ZIP_DEFLATE_WINDOW; j++)
+            d->prev[j] = (d->prev[j] > shift) ? (d->prev[j] - shift) : 0;
+        d->have = ZIP_DEFLATE_WINDOW;
+    } /* if */
+
+    d->start = d->have;
+    return 1;
+} /* zip_deflate_block */
+
+
+/*
+ * Compress (len) bytes at (buf) into (wfile), whose deflater starts fresh
+ *  with the (dictlen) bytes before them at (dict) in its window, so matches
+ *  can reach back into those. Ends on a byte boundary, with an empty stored
+ *  block, so whatever follows can start a new block at the next byte.
+ */
+static int zip_deflate_segment(ZIPwfile *wfile, const PHYSFS_uint8 *dict,
+                               const PHYSFS_uint32 dictlen,
+                               const PHYSFS_uint8 *buf, PHYSFS_uint32 len)
+{
+    ZIPdeflater *d = wfile->deflater;
+    PHYSFS_uint8 *ptr;
+    PHYSFS_uint32 i;
+
+    assert(dictlen <= ZIP_DEFLATE_WINDOW);
+    memset(d->head, '\0', sizeof (d->head));
+    memcpy(d->window, dict, dictlen);
+    d->have = d->start = dictlen;
+    d->bits = 0;
+    d->bitcount = 0;
+    for (i = 0; i + 3 <= dictlen; i++)
+        zip_deflate_insert(d, i);
+
+    while (len > 0)
+    {
+        const PHYSFS_uint32 avail = sizeof (d->window) - d->have;
+        const PHYSFS_uint32 cpy = (len < avail) ? len : avail;
+        memcpy(d->window + d->have, buf, cpy);
+        d->have += cpy;
+        buf += cpy;
+        len -= cpy;
+        if (d->have == sizeof (d->window))
+            BAIL_IF_MACRO(!zip_deflate_block(wfile), ERRPASS, 0);
+    } /* while */
+
+    BAIL_IF_MACRO(!zip_deflate_block(wfile), ERRPASS, 0);
+    BAIL_IF_MACRO(!zipw_reserve(wfile, 6), ERRPASS, 0);
+    zip_deflate_bits(wfile, 0, 3);  /* BFINAL no, BTYPE stored. */
+    if (d->bitcount > 0)
+        zip_deflate_bits(wfile, 0, 8 - d->bitcount);  /* to a byte. */
+    ptr = wfile->data + wfile->data_len;
+    ptr = zip_put16(ptr, 0);
+    zip_put16(ptr, 0xFFFF);
+    wfile->data_len += 4;
+    return 1;
+} /* zip_deflate_segment */
+
+
+/* One segment of zip_deflate_pending(), for a thread to compress. */
+typedef struct
+{
+    ZIPwfile out;               /* just (data) and (deflater) are used.  */
+    const PHYSFS_uint8 *dict;   /* the 32k (or less) before (buf).       */
+    PHYSFS_uint32 dictlen;
+    const PHYSFS_uint8 *buf;
+    PHYSFS_uint32 len;
+    void *thread;               /* doing this, or NULL for the caller.   */
+    int ok;
+} ZIPdeflateJob;
+
+static void zip_deflate_job(void *data)
+{
+    ZIPdeflateJob *job = (ZIPdeflateJob *) data;
+    job->ok = zip_deflate_segment(&job->out, job->dict, job->dictlen,
+                                  job->buf, job->len);
+} /* zip_deflate_job */
+
+
+/*
+ * Compress all of (wfile)'s pending input into its data, a segment per
+ *  thread, and keep the last 32k of it for the next batch to start from.
+ */
+static int zip_deflate_pending(ZIPwfile *wfile)
+{
+    ZIPdeflateJob jobs[ZIP_DEFLATE_THREADS];
+    const PHYSFS_uint32 dict = wfile->pending_dict;
+    const PHYSFS_uint32 total = wfile->pending_len - dict;
+    const PHYSFS_uint32 numjobs = (total + ZIP_DEFLATE_SEGMENT - 1) /
+                                  ZIP_DEFLATE_SEGMENT;
+    PHYSFS_uint32 keep;
+    PHYSFS_uint32 i;
+    int retval = 1;
+
+    if (total == 0)
+        return 1;
+
+    assert(numjobs <= ZIP_DEFLATE_THREADS);
+    memset(jobs, '\0', sizeof (jobs));
+    for (i = 0; i < numjobs; i++)
+    {
+        ZIPdeflateJob *job = &jobs[i];
+        const PHYSFS_uint32 start = dict + (i * ZIP_DEFLATE_SEGMENT);
+        const PHYSFS_uint32 left = wfile->pending_len - start;
+        job->dictlen = (start < ZIP_DEFLATE_WINDOW) ? start :
+                                                     ZIP_DEFLATE_WINDOW;
+        job->dict = wfile->pending + start - job->dictlen;
+        job->buf = wfile->pending + start;
+        job->len = (left < ZIP_DEFLATE_SEGMENT) ? left : ZIP_DEFLATE_SEGMENT;
+
+        if (i == 0)  /* we do the first one, straight into (wfile). */
+            continue;
+
+        job->out.deflater = (ZIPdeflater *)
+                                allocator.Malloc(sizeof (ZIPdeflater));
+        if (job->out.deflater != NULL)
+            job->thread = __PHYSFS_startTask(zip_deflate_job, job);
+    } /* for */
+
+    /* the first, and any that couldn't get a thread (or memory). */
+    retval = zip_deflate_segment(wfile, jobs[0].dict, jobs[0].dictlen,
+                                 jobs[0].buf, jobs[0].len);
+    for (i = 1; i < numjobs; i++)
+    {
+        ZIPdeflateJob *job = &jobs[i];
+        if (job->thread != NULL)
+            __PHYSFS_waitTask(job->thread);
+        else if ((retval) && (job->out.deflater == NULL))
+        {
+            job->out.deflater = wfile->deflater;  /* free again; borrow it. */
+            job->ok = zip_deflate_segment(&job->out, job->dict, job->dictlen,
+                                          job->buf, job->len);
+            job->out.deflater = NULL;
+        } /* else if */
+        else if (retval)
+            zip_deflate_job(job);
+
+        if ((retval) && (!job->ok))
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);  /* all it does. */
+            retval = 0;
+        } /* if */
+
+        if ((retval) && (zipw_reserve(wfile, job->out.data_len)))
+        {
+            memcpy(wfile->data + wfile->data_len, job->out.data,
+                   (size_t) job->out.data_len);
+            wfile->data_len += job->out.data_len;
+        } /* if */
+        else
+        {
+            retval = 0;
+        } /* else */
+
+        allocator.Free(job->out.deflater);
+        allocator.Free(job->out.data);
+    } /* for */
+
+    BAIL_IF_MACRO(!retval, ERRPASS, 0);
+
+    /* the next batch's first segment reaches back into the end of this. */
+    keep = (wfile->pending_len < ZIP_DEFLATE_WINDOW) ? wfile->pending_len :
+                                                       ZIP_DEFLATE_WINDOW;
+    memmove(wfile->pending, wfile->pending + wfile->pending_len - keep, keep);
+    wfile->pending_dict = wfile->pending_len = keep;
+    return 1;
+} /* zip_deflate_pending */
+
+
+/* Make room for (len) more bytes of (wfile)'s pending input. */
+static int zip_deflate_reserve(ZIPwfile *wfile, const PHYSFS_uint32 len)
+{
+    const PHYSFS_uint32 needed = wfile->pending_len + len;
+    PHYSFS_uint32 newsize;
+    void *ptr;
+
+    assert(needed <= ZIP_DEFLATE_PENDING);
+    if (needed <= wfile->pending_allocated)
+        return 1;
+
+    newsize = (wfile->pending_allocated) ? (wfile->pending_allocated * 2) :
+                                           (64 * 1024);
+    while (newsize < needed)
+        newsize *= 2;
+    if (newsize > ZIP_DEFLATE_PENDING)
+        newsize = ZIP_DEFLATE_PENDING;
+
+    ptr = allocator.Realloc(wfile->pending, newsize);
+    BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    wfile->pending = (PHYSFS_uint8 *) ptr;
+    wfile->pending_allocated = newsize;
+    return 1;
+} /* zip_deflate_reserve */
+
+
+/* Compress what's left, and finish the deflate stream. */
+static int zip_deflate_finish(ZIPwfile *wfile)
+{
+    ZIPdeflater *d = wfile->deflater;
+    BAIL_IF_MACRO(!zip_deflate_pending(wfile), ERRPASS, 0);
+    BAIL_IF_MACRO(!zipw_reserve(wfile, 4), ERRPASS, 0);
+    zip_deflate_bits(wfile, 1, 1);  /* BFINAL */
+    zip_deflate_bits(wfile, 1, 2);  /* BTYPE: fixed Huffman codes. */
+    zip_deflate_symbol(wfile, 256);  /* ...and nothing in it. */
+    if (d->bitcount > 0)
+        zip_deflate_bits(wfile, 0, 8 - d->bitcount);  /* to a byte. */
+    return 1;
+} /* zip_deflate_finish */
+
+
+static PHYSFS_uint32 zipw_find(const ZIPwriter *w, const char *name)
+{
+    const PHYSFS_uint32 hash = zip_hash_string(name);
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 idx;
+
+    while ((idx = __PHYSFS_hashTableFind(&w->hash, hash, &probe)) != 0)
+    {
+        if (strcmp(w->entries[idx].name, name) == 0)
+            return idx;
+    } /* while */
+
+    return 0;
+} /* zipw_find */
+
+
+static int zipw_is_live(const ZIPwriter *w, const PHYSFS_uint32 idx)
+{
+    return ((idx != 0) && (w->entries[idx].type != ZIPW_DELETED));
+} /* zipw_is_live */
+
+
+static PHYSFS_uint32 zipw_add(ZIPwriter *w, const char *name, const int type);
+
+/*
+ * Make sure (name)'s parent dir exists, filling it in (and its parents) if
+ *  not. Sets (*parent) to its index, or zero if that's the root.
+ */
+static int zipw_add_parent(ZIPwriter *w, const char *name,
+                           PHYSFS_uint32 *parent)
+{
+    const char *sep = strrchr(name, '/');
+    PHYSFS_uint32 idx = 0;
+
+    if (sep != NULL)
+    {
+        const size_t len = (size_t) (sep - name);
+        char *dname = (char *) __PHYSFS_smallAlloc(len + 1);
+        BAIL_IF_MACRO(!dname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        memcpy(dname, name, len);
+        dname[len] = '\0';
+
+        idx = zipw_find(w, dname);
+        if (!zipw_is_live(w, idx))
+            idx = zipw_add(w, dname, ZIPW_IMPLICIT_DIR);
+        else if (w->entries[idx].type == ZIPW_FILE)
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
+            idx = 0;
+        } /* else if */
+
+        __PHYSFS_smallFree(dname);
+        BAIL_IF_MACRO(!idx, ERRPASS, 0);
+    } /* if */
+
+    *parent = idx;
+    return 1;
+} /* zipw_add_parent */
+
+
+/*
+ * Make (name) a live entry of (type), reusing its old entry if it had one.
+ *  The caller fills in the rest. Returns its index, or zero on error.
+ */
+static PHYSFS_uint32 zipw_add(ZIPwriter *w, const char *name, const int type)
+{
+    PHYSFS_uint32 parent = 0;
+    PHYSFS_uint32 idx;
+    ZIPwentry *entry;
+
+    BAIL_IF_MACRO(!zipw_add_parent(w, name, &parent), ERRPASS, 0);
+
+    idx = zipw_find(w, name);
+    if (idx == 0)
+    {
+        char *str;
+
+        if (w->entries_used == w->entries_allocated)
+        {
+            void *ptr = zip_grow(w->entries, &w->entries_allocated,
+                                 ((PHYSFS_uint64) w->entries_used) + 1,
+                                 sizeof (ZIPwentry));
+            BAIL_IF_MACRO(!ptr, ERRPASS, 0);
+            w->entries = (ZIPwentry *) ptr;
+        } /* if */
+
+        str = (char *) allocator.Malloc(strlen(name) + 1);
+        BAIL_IF_MACRO(!str, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        strcpy(str, name);
+
+        idx = w->entries_used;
+        if (!__PHYSFS_hashTableInsert(&w->hash, zip_hash_string(name), idx))
+        {
+            allocator.Free(str);
+            return 0;
+        } /* if */
+
+        entry = &w->entries[idx];
+        memset(entry, '\0', sizeof (*entry));
+        entry->name = str;
+        entry->type = ZIPW_DELETED;  /* comes to life below. */
+        w->entries_used++;
+    } /* if */
+
+    entry = &w->entries[idx];
+    if (entry->type == ZIPW_DELETED)
+    {
+        entry->parent = parent;
+        entry->children = 0;
+        if (parent != 0)
+            w->entries[parent].children++;
+    } /* if */
+
+    entry->type = (PHYSFS_uint8) type;
+    return idx;
+} /* zipw_add */
+
+
+/* Drop (idx) from the archive. It stays in the hash, for reuse. */
+static void zipw_delete(ZIPwriter *w, const PHYSFS_uint32 idx)
+{
+    ZIPwentry *entry = &w->entries[idx];
+    assert(zipw_is_live(w, idx));
+    if (entry->parent != 0)
+        w->entries[entry->parent].children--;
+    entry->type = ZIPW_DELETED;
+    w->dirty = 1;
+} /* zipw_delete */
+
+
+static int zipw_needs_zip64(const ZIPwentry *entry)
+{
+    return ( (entry->offset >= 0xFFFFFFFF) ||
+             (entry->compressed_size >= 0xFFFFFFFF) ||
+             (entry->uncompressed_size >= 0xFFFFFFFF) );
+} /* zipw_needs_zip64 */
+
+
+static int zipw_write(ZIPwriter *w, const void *buf, const PHYSFS_uint64 len)
+{
+    if (len == 0)
+        return 1;
+    BAIL_IF_MACRO(w->io->write(w->io, buf, len) != (PHYSFS_sint64) len,
+                  ERRPASS, 0);
+    return 1;
+} /* zipw_write */
+
+
+/*
+ * Write (entry)'s local header, and then (len) bytes of (data), at the end
+ *  of what's in the archive so far, and set entry->offset to match. Call
+ *  with w->mutex held.
+ */
+static int zipw_write_local(ZIPwriter *w, ZIPwentry *entry,
+                            const PHYSFS_uint8 *data, const PHYSFS_uint64 len)
+{
+    const int isdir = (entry->type == ZIPW_DIR);
+    const size_t namelen = strlen(entry->name) + (isdir ? 1 : 0);
+    const int zip64 = ( (entry->compressed_size >= 0xFFFFFFFF) ||
+                        (entry->uncompressed_size >= 0xFFFFFFFF) );
+    const size_t hdrlen = ZIP_LOCAL_HEADER_SIZE + namelen + (zip64 ? 20 : 0);
+    PHYSFS_uint8 *hdr = (PHYSFS_uint8 *) __PHYSFS_smallAlloc(hdrlen);
+    PHYSFS_uint8 *ptr = hdr;
+    int rc;
+
+    BAIL_IF_MACRO(!hdr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (zip64)
+        entry->version_needed = ZIPW_VERSION_NEEDED_ZIP64;
+
+    ptr = zip_put32(ptr, ZIP_LOCAL_FILE_SIG);
+    ptr = zip_put16(ptr, entry->version_needed);
+    ptr = zip_put16(ptr, entry->general_bits);
+    ptr = zip_put16(ptr, entry->compression_method);
+    ptr = zip_put32(ptr, entry->dos_mod_time);
+    ptr = zip_put32(ptr, entry->crc);
+    ptr = zip_put32(ptr, zip64 ? 0xFFFFFFFF :
+                            (PHYSFS_uint32) entry->compressed_size);
+    ptr = zip_put32(ptr, zip64 ? 0xFFFFFFFF :
+                            (PHYSFS_uint32) entry->uncompressed_size);
+    ptr = zip_put16(ptr, (PHYSFS_uint32) namelen);
+    ptr = zip_put16(ptr, zip64 ? 20 : 0);
+    memcpy(ptr, entry->name, strlen(entry->name));
+    ptr += strlen(entry->name);
+    if (isdir)
+        *(ptr++) = '/';
+    if (zip64)
+    {
+        ptr = zip_put16(ptr, ZIP64_EXTENDED_INFO_EXTRA_FIELD_SIG);
+        ptr = zip_put16(ptr, 16);
+        ptr = zip_put64(ptr, entry->uncompressed_size);
+        ptr = zip_put64(ptr, entry->compressed_size);
+    } /* if */
+    assert(ptr == hdr + hdrlen);
+
+    rc = ( (w->io->seek(w->io, w->append_pos)) &&
+           (zipw_write(w, hdr, hdrlen)) &&
+           (zipw_write(w, data, len)) );
+    __PHYSFS_smallFree(hdr);
+    BAIL_IF_MACRO(!rc, ERRPASS, 0);
+
+    entry->offset = w->append_pos;
+    w->append_pos += hdrlen + len;
+    w->dirty = 1;
+    return 1;
+} /* zipw_write_local */
+
+
+/* Size of (entry)'s central directory record. Sets (*zip64) if it needs to. */
+static PHYSFS_uint64 zipw_record_size(const ZIPwentry *entry, int *zip64)
+{
+    PHYSFS_uint64 retval = 46 + strlen(entry->name);
+    if (entry->type == ZIPW_DIR)
+        retval++;  /* trailing '/' */
+    if (zipw_needs_zip64(entry))
+    {
+        *zip64 = 1;
+        retval += 4 + 24;  /* room for all three, whether they need it or not. */
+    } /* if */
+    return retval;
+} /* zipw_record_size */
+
+
+static PHYSFS_uint8 *zipw_put_record(PHYSFS_uint8 *ptr,
+                                     const ZIPwentry *entry)
+{
+    const int isdir = (entry->type == ZIPW_DIR);
+    const size_t namelen = strlen(entry->name);
+    const int zip64 = zipw_needs_zip64(entry);
+
+    ptr = zip_put32(ptr, ZIP_CENTRAL_DIR_SIG);
+    ptr = zip_put16(ptr, entry->version);
+    ptr = zip_put16(ptr, entry->version_needed);
+    ptr = zip_put16(ptr, entry->general_bits);
+    ptr = zip_put16(ptr, entry->compression_method);
+    ptr = zip_put32(ptr, entry->dos_mod_time);
+    ptr = zip_put32(ptr, entry->crc);
+    ptr = zip_put32(ptr, zip64 ? 0xFFFFFFFF :
+                            (PHYSFS_uint32) entry->compressed_size);
+    ptr = zip_put32(ptr, zip64 ? 0xFFFFFFFF :
+                            (PHYSFS_uint32) entry->uncompressed_size);
+    ptr = zip_put16(ptr, (PHYSFS_uint32) (namelen + (isdir ? 1 : 0)));
+    ptr = zip_put16(ptr, zip64 ? 28 : 0);  /* extra field */
+    ptr = zip_put16(ptr, 0);  /* comment */
+    ptr = zip_put16(ptr, 0);  /* starting disk */
+    ptr = zip_put16(ptr, 0);  /* internal attributes */
+    ptr = zip_put32(ptr, entry->external_attr);
+    ptr = zip_put32(ptr, zip64 ? 0xFFFFFFFF : (PHYSFS_uint32) entry->offset);
+    memcpy(ptr, entry->name, namelen);
+    ptr += namelen;
+    if (isdir)
+        *(ptr++) = '/';
+    if (zip64)
+    {
+        ptr = zip_put16(ptr, ZIP64_EXTENDED_INFO_EXTRA_FIELD_SIG);
+        ptr = zip_put16(ptr, 24);
+        ptr = zip_put64(ptr, entry->uncompressed_size);
+        ptr = zip_put64(ptr, entry->compressed_size);
+        ptr = zip_put64(ptr, entry->offset);
+    } /* if */
+    return ptr;
+} /* zipw_put_record */
+
+
+/*
+ * Write the central directory, and the end of central directory records,
+ *  after the last local entry. If that would end the archive before its
+ *  old end, the central directory is moved down to end it right there, so
+ *  the end record is the last thing in the file, like it has to be.
+ */
+static int zipw_write_central_dir(ZIPwriter *w)
+{
+    PHYSFS_uint64 count = 0;
+    PHYSFS_uint64 size = 0;
+    PHYSFS_uint64 total;
+    PHYSFS_uint64 cdir_ofs;
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_uint8 *ptr;
+    int zip64 = 0;
+    PHYSFS_uint32 i;
+    int rc;
+
+    for (i = 1; i < w->entries_used; i++)
+    {
+        const ZIPwentry *entry = &w->entries[i];
+        if ((entry->type == ZIPW_FILE) || (entry->type == ZIPW_DIR))
+        {
+            size += zipw_record_size(entry, &zip64);
+            count++;
+        } /* if */
+    } /* for */
+
+    cdir_ofs = w->append_pos;
+    if ((count >= 0xFFFF) || (size >= 0xFFFFFFFF) || (cdir_ofs >= 0xFFFFFFFF))
+        zip64 = 1;
+
+    total = size + (zip64 ? (56 + 20) : 0) + 22;
+    if (cdir_ofs + total < w->old_length)
+        cdir_ofs = w->old_length - total;
+
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(total),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    buf = (PHYSFS_uint8 *) allocator.Malloc((size_t) total);
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    ptr = buf;
+    for (i = 1; i < w->entries_used; i++)
+    {
+        const ZIPwentry *entry = &w->entries[i];
+        if ((entry->type == ZIPW_FILE) || (entry->type == ZIPW_DIR))
+            ptr = zipw_put_record(ptr, entry);
+    } /* for */
+    assert(ptr == buf + size);
+
+    if (zip64)
+    {
+        ptr = zip_put32(ptr, ZIP64_END_OF_CENTRAL_DIR_SIG);
+        ptr = zip_put64(ptr, 44);  /* size of the rest of this record. */
+        ptr = zip_put16(ptr, ZIPW_VERSION_NEEDED_ZIP64);  /* made by */
+        ptr = zip_put16(ptr, ZIPW_VERSION_NEEDED_ZIP64);  /* needed */
+        ptr = zip_put32(ptr, 0);  /* this disk */
+        ptr = zip_put32(ptr, 0);  /* disk with the central dir */
+        ptr = zip_put64(ptr, count);  /* entries on this disk */
+        ptr = zip_put64(ptr, count);  /* entries, total */
+        ptr = zip_put64(ptr, size);
+        ptr = zip_put64(ptr, cdir_ofs);
+
+        ptr = zip_put32(ptr, ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG);
+        ptr = zip_put32(ptr, 0);  /* disk with the zip64 end record */
+        ptr = zip_put64(ptr, cdir_ofs + size);  /* where it is. */
+        ptr = zip_put32(ptr, 1);  /* total disks */
+    } /* if */
+
+    ptr = zip_put32(ptr, ZIP_END_OF_CENTRAL_DIR_SIG);
+    ptr = zip_put16(ptr, 0);  /* this disk */
+    ptr = zip_put16(ptr, 0);  /* disk with the central dir */
+    ptr = zip_put16(ptr, (count >= 0xFFFF) ? 0xFFFF : (PHYSFS_uint32) count);
+    ptr = zip_put16(ptr, (count >= 0xFFFF) ? 0xFFFF : (PHYSFS_uint32) count);
+    ptr = zip_put32(ptr, (size >= 0xFFFFFFFF) ?
+                            0xFFFFFFFF : (PHYSFS_uint32) size);
+    ptr = zip_put32(ptr, (cdir_ofs >= 0xFFFFFFFF) ?
+                            0xFFFFFFFF : (PHYSFS_uint32) cdir_ofs);
+    ptr = zip_put16(ptr, 0);  /* comment */
+    assert(ptr == buf + total);
+
+    rc = ( (w->io->seek(w->io, cdir_ofs)) &&
+           (zipw_write(w, buf, total)) &&
+           ((w->io->flush == NULL) || (w->io->flush(w->io))) );
+    allocator.Free(buf);
+    return rc;
+} /* zipw_write_central_dir */
+
+
+/* Copy the entries out of the archive that's already there, at w->path. */
+static int zipw_load_existing(ZIPwriter *w)
+{
+    PHYSFS_Io *io = NULL;
+    ZIPinfo *info = NULL;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!w->path, PHYSFS_ERR_UNSUPPORTED, 0);
+    io = __PHYSFS_createNativeIo(w->path, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    info = zip_open_reader(io, NULL, 0);
+    if (!info)
+    {
+        io->destroy(io);
+        return 0;
+    } /* if */
+
+    GOTO_IF_MACRO(!zip_load_central_dir(info), ERRPASS, load_existing_failed);
+
+    /* we'd have to fix up every offset; self-extractors aren't worth it. */
+    GOTO_IF_MACRO(info->data_start != 0, PHYSFS_ERR_UNSUPPORTED,
+                  load_existing_failed);
+
+    for (i = 1; i < info->entries_used; i++)
+    {
+        const ZIPentry *old = &info->entries[i];
+        const int isdir = (old->resolved == ZIP_DIRECTORY);
+        PHYSFS_uint32 idx;
+        ZIPwentry *entry;
+
+        if ((isdir) && (old->version_needed == 0) && (old->dos_mod_time == 0))
+            continue;  /* a placeholder for a missing parent dir. */
+
+        idx = zipw_add(w, zip_entry_name(info, old),
+                       isdir ? ZIPW_DIR : ZIPW_FILE);
+        GOTO_IF_MACRO(!idx, ERRPASS, load_existing_failed);
+
+        entry = &w->entries[idx];
+        entry->offset = old->offset;  /* unresolved: the local header. */
+        entry->compressed_size = old->compressed_size;
+        entry->uncompressed_size = old->uncompressed_size;
+        entry->crc = old->crc;
+        entry->dos_mod_time = old->dos_mod_time;
+        entry->version = old->version;
+        entry->version_needed = old->version_needed;
+        entry->general_bits = old->general_bits;
+        entry->compression_method = old->compression_method;
+        if (isdir)
+            entry->external_attr = ZIPW_MSDOS_DIRECTORY;
+        else if (old->resolved == ZIP_UNRESOLVED_SYMLINK)
+            entry->external_attr = (UNIX_FILETYPE_SYMLINK | 0777) << 16;
+    } /* for */
+
+    w->append_pos = info->centraldir_ofs;
+    ZIP_closeArchive(info);
+    return 1;
+
+load_existing_failed:
+    ZIP_closeArchive(info);
+    return 0;
+} /* zipw_load_existing */
+
+
+static void *zip_open_writer(PHYSFS_Io *io, const char *name)
+{
+    const PHYSFS_sint64 len = io->length(io);
+    ZIPinfo *info = NULL;
+    ZIPwriter *w = NULL;
+
+    BAIL_IF_MACRO(len < 0, ERRPASS, NULL);
+
+    /* don't make just any new file a ZIP file; it has to ask to be one. */
+    if (len == 0)
+    {
+        const char *ext = (name) ? strrchr(name, '.') : NULL;
+        BAIL_IF_MACRO(!ext || (__PHYSFS_utf8stricmp(ext + 1, "zip") != 0),
+                      PHYSFS_ERR_UNSUPPORTED, NULL);
+    } /* if */
+
+    info = (ZIPinfo *) allocator.Malloc(sizeof (ZIPinfo));
+    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(info, '\0', sizeof (ZIPinfo));
+
+    w = (ZIPwriter *) allocator.Malloc(sizeof (ZIPwriter));
+    GOTO_IF_MACRO(!w, PHYSFS_ERR_OUT_OF_MEMORY, zip_open_writer_failed);
+    memset(w, '\0', sizeof (ZIPwriter));
+    info->writer = w;
+    w->old_length = (PHYSFS_uint64) len;
+
+    w->mutex = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!w->mutex, ERRPASS, zip_open_writer_failed);
+
+    GOTO_IF_MACRO(!__PHYSFS_hashTableInit(&w->hash, 64), ERRPASS,
+                  zip_open_writer_failed);
+
+    w->entries_allocated = 64;
+    w->entries_used = 1;  /* zero means "none." */
+    w->entries = (ZIPwentry *) allocator.Malloc(sizeof (ZIPwentry) * 64);
+    GOTO_IF_MACRO(!w->entries, PHYSFS_ERR_OUT_OF_MEMORY,
+                  zip_open_writer_failed);
+    memset(&w->entries[0], '\0', sizeof (ZIPwentry));
+
+    if (name != NULL)
+    {
+        w->path = (char *) allocator.Malloc(strlen(name) + 1);
+        GOTO_IF_MACRO(!w->path, PHYSFS_ERR_OUT_OF_MEMORY,
+                      zip_open_writer_failed);
+        strcpy(w->path, name);
+    } /* if */
+
+    if ((len > 0) && (!zipw_load_existing(w)))
+        goto zip_open_writer_failed;
+
+    w->dirty = 0;  /* nothing's changed yet. */
+    w->io = io;
+    return info;
+
+zip_open_writer_failed:
+    ZIP_closeArchive(info);  /* (io) is still NULL, so the caller keeps it. */
+    return NULL;
+} /* zip_open_writer */
+
+
+/* Write out the central directory if it changed, and free (w). */
+static void zip_close_writer(ZIPwriter *w)
+{
+    PHYSFS_uint32 i;
+
+    /* nowhere to report it, but at least don't leave the file broken. */
+    if ((w->dirty) && (w->io != NULL))
+        zipw_write_central_dir(w);
+
+    if (w->io != NULL)
+        w->io->destroy(w->io);
+
+    for (i = 1; i < w->entries_used; i++)
+        allocator.Free(w->entries[i].name);
+    allocator.Free(w->entries);
+    __PHYSFS_hashTableDeinit(&w->hash);
+    allocator.Free(w->path);
+    if (w->mutex)
+        __PHYSFS_platformDestroyMutex(w->mutex);
+    allocator.Free(w);
+} /* zip_close_writer */
+
+
+static PHYSFS_sint64 ZIPW_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
+{
+    BAIL_MACRO(PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+} /* ZIPW_read */
+
+
+static PHYSFS_sint64 ZIPW_write(PHYSFS_Io *io, const void *_buf,
+                                PHYSFS_uint64 len)
+{
+    ZIPwfile *wfile = (ZIPwfile *) io->opaque;
+    const PHYSFS_uint8 *buf = (const PHYSFS_uint8 *) _buf;
+    ZIPdeflater *d = wfile->deflater;
+
+    BAIL_IF_MACRO(wfile->failed, PHYSFS_ERR_IO, -1);
+
+    if (d == NULL)
+    {
+        BAIL_IF_MACRO(!zipw_reserve(wfile, len), ERRPASS, -1);
+        memcpy(wfile->data + wfile->data_len, buf, (size_t) len);
+        wfile->data_len += len;
+    } /* if */
+
+    else
+    {
+        PHYSFS_uint64 remain = len;
+        while (remain > 0)
+        {
+            const PHYSFS_uint32 full = wfile->pending_dict +
+                               (ZIP_DEFLATE_SEGMENT * ZIP_DEFLATE_THREADS);
+            const PHYSFS_uint32 avail = full - wfile->pending_len;
+            const PHYSFS_uint32 cpy = (remain < avail) ? (PHYSFS_uint32) remain : avail;
+            if (!zip_deflate_reserve(wfile, cpy))
+            {
+                wfile->failed = (remain < len);  /* no good if half got in. */
+                return -1;
+            } /* if */
+            memcpy(wfile->pending + wfile->pending_len, buf, cpy);
+            wfile->pending_len += cpy;
+            buf += cpy;
+            remain -= cpy;
+            if (wfile->pending_len == full)
+            {
+                if (!zip_deflate_pending(wfile))
+                {
+                    /* half of this got in, so the file's no good now. */
+                    wfile->failed = 1;
+                    return -1;
+                } /* if */
+            } /* if */
+        } /* while */
+    } /* else */
+
+    wfile->crc = PHYSFS_crc32(wfile->crc, _buf, len);
+    wfile->written += len;
+    return (PHYSFS_sint64) len;
+} /* ZIPW_write */
+
+
+static int ZIPW_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    const ZIPwfile *wfile = (const ZIPwfile *) io->opaque;
+    BAIL_IF_MACRO(offset != wfile->written, PHYSFS_ERR_UNSUPPORTED, 0);
+    return 1;  /* nowhere to go but where we are. */
+} /* ZIPW_seek */
+
+
+static PHYSFS_sint64 ZIPW_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((const ZIPwfile *) io->opaque)->written;
+} /* ZIPW_tell */
+
+
+static PHYSFS_sint64 ZIPW_length(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((const ZIPwfile *) io->opaque)->written;
+} /* ZIPW_length */
+
+
+static PHYSFS_Io *ZIPW_duplicate(PHYSFS_Io *io)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* ZIPW_duplicate */
+
+
+static int ZIPW_flush(PHYSFS_Io *io)
+{
+    return 1;  /* it all goes out on close. */
+} /* ZIPW_flush */
+
+
+/* Put (wfile) in the archive, for ZIPW_destroy(). */
+static int zipw_commit(ZIPwfile *wfile)
+{
+    ZIPwriter *w = wfile->writer;
+    PHYSFS_uint32 idx;
+    ZIPwentry *entry;
+    ZIPwentry tmp;
+    int rc;
+
+    BAIL_IF_MACRO(wfile->failed, PHYSFS_ERR_IO, 0);
+    if (wfile->deflater != NULL)
+        BAIL_IF_MACRO(!zip_deflate_finish(wfile), ERRPASS, 0);
+
+    memset(&tmp, '\0', sizeof (tmp));
+    tmp.name = wfile->name;
+    tmp.type = ZIPW_FILE;
+    tmp.compressed_size = wfile->data_len;
+    tmp.uncompressed_size = wfile->written;
+    tmp.crc = wfile->crc;
+    tmp.dos_mod_time = zip_physfs_time_to_dos_time(time(NULL));
+    tmp.version = ZIPW_VERSION_MADE_BY;
+    tmp.version_needed = ZIPW_VERSION_NEEDED;
+    tmp.general_bits = ZIPW_GENERAL_BITS_UTF8;
+    tmp.compression_method = (wfile->deflater) ? COMPMETH_DEFLATE :
+                                                 COMPMETH_NONE;
+
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, wfile->name);
+    if (zipw_is_live(w, idx) && (w->entries[idx].type != ZIPW_FILE))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);  /* mkdir'd meanwhile. */
+        rc = 0;
+    } /* if */
+    else
+    {
+        rc = zipw_write_local(w, &tmp, wfile->data, wfile->data_len);
+    } /* else */
+
+    if (rc)
+        rc = ((idx = zipw_add(w, wfile->name, ZIPW_FILE)) != 0);
+
+    if (rc)
+    {
+        entry = &w->entries[idx];
+        tmp.name = entry->name;
+        tmp.parent = entry->parent;
+        tmp.children = 0;
+        memcpy(entry, &tmp, sizeof (*entry));
+    } /* if */
+    __PHYSFS_platformReleaseMutex(w->mutex);
+
+    return rc;
+} /* zipw_commit */
+
+
+static void ZIPW_destroy(PHYSFS_Io *io)
+{
+    ZIPwfile *wfile = (ZIPwfile *) io->opaque;
+    ZIPwriter *w = wfile->writer;
+
+    if (!zipw_commit(wfile))
+    {
+        /* nobody to tell now; the next thing done in the write dir fails. */
+        __PHYSFS_platformGrabMutex(w->mutex);
+        w->error = PHYSFS_getLastErrorCode();
+        if (w->error == PHYSFS_ERR_OK)
+            w->error = PHYSFS_ERR_IO;
+        __PHYSFS_platformReleaseMutex(w->mutex);
+    } /* if */
+
+    allocator.Free(wfile->deflater);
+    allocator.Free(wfile->pending);
+    allocator.Free(wfile->data);
+    allocator.Free(wfile->name);
+    allocator.Free(wfile);
+    allocator.Free(io);
+} /* ZIPW_destroy */
+
+
+static const PHYSFS_Io ZIPW_Io =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    ZIPW_read,
+    ZIPW_write,
+    ZIPW_seek,
+    ZIPW_tell,
+    ZIPW_length,
+    ZIPW_duplicate,
+    ZIPW_flush,
+    ZIPW_destroy,
+    NULL,  /* map */
+    NULL   /* readAt */
+};
+
+
+/* Report, and forget, a close that failed since the last call. */
+static int zipw_check_error(ZIPwriter *w)
+{
+    PHYSFS_ErrorCode err;
+    __PHYSFS_platformGrabMutex(w->mutex);
+    err = w->error;
+    w->error = PHYSFS_ERR_OK;
+    __PHYSFS_platformReleaseMutex(w->mutex);
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+} /* zipw_check_error */
+
+
+static PHYSFS_Io *zipw_open_write(ZIPwriter *w, const char *filename)
+{
+    PHYSFS_Io *io = NULL;
+    ZIPwfile *wfile = NULL;
+    PHYSFS_uint32 parent = 0;
+    PHYSFS_uint32 idx;
+    int rc;
+
+    BAIL_IF_MACRO(!zipw_check_error(w), ERRPASS, NULL);
+
+    /* the entry shows up on close, but the parent dirs are there now. */
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, filename);
+    if (zipw_is_live(w, idx) && (w->entries[idx].type != ZIPW_FILE))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
+        rc = 0;
+    } /* if */
+    else
+    {
+        rc = zipw_add_parent(w, filename, &parent);
+    } /* else */
+    __PHYSFS_platformReleaseMutex(w->mutex);
+    BAIL_IF_MACRO(!rc, ERRPASS, NULL);
+
+    io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!io, PHYSFS_ERR_OUT_OF_MEMORY, zipw_open_write_failed);
+    wfile = (ZIPwfile *) allocator.Malloc(sizeof (ZIPwfile));
+    GOTO_IF_MACRO(!wfile, PHYSFS_ERR_OUT_OF_MEMORY, zipw_open_write_failed);
+    memset(wfile, '\0', sizeof (ZIPwfile));
+    wfile->writer = w;
+
+    wfile->name = (char *) allocator.Malloc(strlen(filename) + 1);
+    GOTO_IF_MACRO(!wfile->name, PHYSFS_ERR_OUT_OF_MEMORY,
+                  zipw_open_write_failed);
+    strcpy(wfile->name, filename);
+
+    if (__PHYSFS_getWriteCompression())
+    {
+        wfile->deflater = (ZIPdeflater *) allocator.Malloc(sizeof (ZIPdeflater));
+        GOTO_IF_MACRO(!wfile->deflater, PHYSFS_ERR_OUT_OF_MEMORY,
+                      zipw_open_write_failed);
+        memset(wfile->deflater, '\0', sizeof (ZIPdeflater));
+    } /* if */
+
+    memcpy(io, &ZIPW_Io, sizeof (*io));
+    io->opaque = wfile;
+    return io;
+
+zipw_open_write_failed:
+    if (wfile != NULL)
+    {
+        allocator.Free(wfile->deflater);
+        allocator.Free(wfile->name);
+        allocator.Free(wfile);
+    } /* if */
+    allocator.Free(io);
+    return NULL;
+} /* zipw_open_write */
+
+
+/*
+ * Read back everything in an entry that's in the archive already, so an
+ *  append can start with it. Sets (*buf) to the allocated data.
+ */
+static int zipw_read_entry(ZIPwriter *w, const ZIPwentry *entry,
+                           PHYSFS_uint8 **buf)
+{
+    PHYSFS_uint8 hdr[ZIP_LOCAL_HEADER_SIZE];
+    PHYSFS_uint8 *compressed = NULL;
+    PHYSFS_uint8 *data = NULL;
+    PHYSFS_Io *io = NULL;
+    ZIPentry old;
+    PHYSFS_uint32 hdrlen;
+
+    *buf = NULL;
+
+    BAIL_IF_MACRO(!w->path, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(entry->general_bits & 0x0001, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO( (entry->compression_method != COMPMETH_NONE) &&
+                   (entry->compression_method != COMPMETH_DEFLATE),
+                   PHYSFS_ERR_UNSUPPORTED, 0 );
+    BAIL_IF_MACRO( (!__PHYSFS_ui64FitsAddressSpace(entry->compressed_size)) ||
+                   (!__PHYSFS_ui64FitsAddressSpace(entry->uncompressed_size)),
+                   PHYSFS_ERR_OUT_OF_MEMORY, 0 );
+
+    memset(&old, '\0', sizeof (old));
+    old.version_needed = entry->version_needed;
+    old.compression_method = entry->compression_method;
+    old.crc = entry->crc;
+    old.compressed_size = entry->compressed_size;
+    old.uncompressed_size = entry->uncompressed_size;
+
+    io = __PHYSFS_createNativeIo(w->path, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    GOTO_IF_MACRO(!io->seek(io, entry->offset), ERRPASS, read_entry_done);
+    GOTO_IF_MACRO(!__PHYSFS_readAll(io, hdr, sizeof (hdr)), ERRPASS,
+                  read_entry_done);
+    hdrlen = zip_check_local(hdr, &old);
+    GOTO_IF_MACRO(!hdrlen, PHYSFS_ERR_CORRUPT, read_entry_done);
+    GOTO_IF_MACRO(!io->seek(io, entry->offset + hdrlen), ERRPASS,
+                  read_entry_done);
+
+    data = (PHYSFS_uint8 *) allocator.Malloc((size_t) (entry->uncompressed_size + 1));
+    GOTO_IF_MACRO(!data, PHYSFS_ERR_OUT_OF_MEMORY, read_entry_done);
+
+    if (entry->compression_method == COMPMETH_NONE)
+    {
+        GOTO_IF_MACRO(!__PHYSFS_readAll(io, data, entry->uncompressed_size),
+                      ERRPASS, read_entry_done);
+    } /* if */
+    else
+    {
+        z_stream stream;
+        int rc;
+        compressed = (PHYSFS_uint8 *) allocator.Malloc((size_t) (entry->compressed_size + 1));
+        GOTO_IF_MACRO(!compressed, PHYSFS_ERR_OUT_OF_MEMORY, read_entry_done);
+        GOTO_IF_MACRO(!__PHYSFS_readAll(io, compressed, entry->compressed_size),
+                      ERRPASS, read_entry_done);
+        initializeZStream(&stream, NULL);
+        stream.next_in = compressed;
+        stream.avail_in = (unsigned int) entry->compressed_size;
+        stream.next_out = data;
+        stream.avail_out = (unsigned int) entry->uncompressed_size;
+        GOTO_IF_MACRO(zlib_err(inflateInit2(&stream, -MAX_WBITS)) != Z_OK,
+                      ERRPASS, read_entry_done);
+        rc = zlib_err(inflate(&stream, Z_FINISH));
+        inflateEnd(&stream);
+        GOTO_IF_MACRO(rc != Z_STREAM_END, PHYSFS_ERR_CORRUPT, read_entry_done);
+        GOTO_IF_MACRO(stream.total_out != entry->uncompressed_size,
+                      PHYSFS_ERR_CORRUPT, read_entry_done);
+    } /* else */
+
+    GOTO_IF_MACRO(PHYSFS_crc32(0, data, entry->uncompressed_size) != entry->crc,
+                  PHYSFS_ERR_CORRUPT, read_entry_done);
 
-        buf = (PHYSFS_uint8 *) __PHYSFS_smallAlloc(len);
-        BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, -1);
+    *buf = data;
+    data = NULL;
 
-        if (!io->seek(io, pos - len) || !__PHYSFS_readAll(io, buf, len))
-        {
-            __PHYSFS_smallFree(buf);
-            return -1;  /* error was set elsewhere. */
-        } /* if */
+read_entry_done:
+    allocator.Free(compressed);
+    allocator.Free(data);
+    io->destroy(io);
+    return (*buf != NULL);
+} /* zipw_read_entry */
 
-        for (i = (PHYSFS_sint32) (len - 4); i >= 0; i--)
-        {
-            if ( (buf[i] == 0x50) && (buf[i+1] == 0x4b) &&
-                 (buf[i+2] == 0x06) && (buf[i+3] == 0x06) )
-            {
-                __PHYSFS_smallFree(buf);
-                return pos - (len - i);
-            } /* if */
-        } /* for */
 
-        __PHYSFS_smallFree(buf);
+static PHYSFS_Io *zipw_open_append(ZIPwriter *w, const char *filename)
+{
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_Io *io = NULL;
+    PHYSFS_uint64 len = 0;
+    PHYSFS_uint32 idx;
+    ZIPwentry entry;
+    int exists;
+
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, filename);
+    exists = zipw_is_live(w, idx);
+    if (exists)
+        memcpy(&entry, &w->entries[idx], sizeof (entry));
+    __PHYSFS_platformReleaseMutex(w->mutex);
+
+    io = zipw_open_write(w, filename);
+    if ((io == NULL) || (!exists))
+        return io;  /* new file, or failed; either way, that's it. */
+
+    /* ZIP entries can't grow in place, so start the new one with the old. */
+    len = entry.uncompressed_size;
+    if ( (!zipw_read_entry(w, &entry, &buf)) ||
+         (io->write(io, buf, len) != (PHYSFS_sint64) len) )
+    {
+        ZIPwfile *wfile = (ZIPwfile *) io->opaque;
+        allocator.Free(wfile->deflater);
+        allocator.Free(wfile->pending);
+        allocator.Free(wfile->data);
+        allocator.Free(wfile->name);
+        allocator.Free(wfile);
+        allocator.Free(io);  /* not destroy(): that would commit it. */
+        io = NULL;
     } /* if */
 
-    BAIL_MACRO(PHYSFS_ERR_CORRUPT, -1);  /* didn't find it. */
-} /* zip64_find_end_of_central_dir */
+    allocator.Free(buf);
+    return io;
+} /* zipw_open_append */
 
 
-static int zip64_parse_end_of_central_dir(ZIPinfo *info,
-                                          PHYSFS_uint64 *data_start,
-                                          PHYSFS_uint64 *dir_ofs,
-                                          PHYSFS_uint64 *entry_count,
-                                          PHYSFS_sint64 pos)
+static int zipw_remove(ZIPwriter *w, const char *name)
 {
-    PHYSFS_Io *io = info->io;
-    PHYSFS_uint64 ui64;
-    PHYSFS_uint32 ui32;
-    PHYSFS_uint16 ui16;
+    PHYSFS_uint32 idx;
+    int rc = 1;
 
-    /* We should be positioned right past the locator signature. */
+    BAIL_IF_MACRO(!zipw_check_error(w), ERRPASS, 0);
 
-    if ((pos < 0) || (!io->seek(io, pos)))
-        return 0;
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, name);
+    if (!zipw_is_live(w, idx))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+        rc = 0;
+    } /* if */
+    else if (w->entries[idx].children > 0)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_DIR_NOT_EMPTY);
+        rc = 0;
+    } /* else if */
+    else
+    {
+        zipw_delete(w, idx);
+    } /* else */
+    __PHYSFS_platformReleaseMutex(w->mutex);
 
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    if (ui32 != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG)
-        return -1;  /* it's not a Zip64 archive. Not an error, though! */
+    return rc;
+} /* zipw_remove */
 
-    info->zip64 = 1;
 
-    /* number of the disk with the start of the central directory. */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
+static int zipw_mkdir(ZIPwriter *w, const char *name)
+{
+    PHYSFS_uint32 idx;
+    ZIPwentry tmp;
+    int rc = 1;
+
+    BAIL_IF_MACRO(!zipw_check_error(w), ERRPASS, 0);
+
+    memset(&tmp, '\0', sizeof (tmp));
+    tmp.type = ZIPW_DIR;
+    tmp.dos_mod_time = zip_physfs_time_to_dos_time(time(NULL));
+    tmp.external_attr = ZIPW_MSDOS_DIRECTORY;
+    tmp.version = ZIPW_VERSION_MADE_BY;
+    tmp.version_needed = ZIPW_VERSION_NEEDED;
+    tmp.general_bits = ZIPW_GENERAL_BITS_UTF8;
+    tmp.compression_method = COMPMETH_NONE;
+
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, name);
+    if (zipw_is_live(w, idx) && (w->entries[idx].type == ZIPW_FILE))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_DUPLICATE);
+        rc = 0;
+    } /* if */
+    else if (zipw_is_live(w, idx) && (w->entries[idx].type == ZIPW_DIR))
+    {
+        rc = 1;  /* already there. */
+    } /* else if */
+    else
+    {
+        /* implicit dirs get a record of their own, too, now. */
+        tmp.name = (char *) name;
+        rc = ( (zipw_write_local(w, &tmp, NULL, 0)) &&
+               ((idx = zipw_add(w, name, ZIPW_DIR)) != 0) );
+        if (rc)
+        {
+            ZIPwentry *entry = &w->entries[idx];
+            tmp.name = entry->name;
+            tmp.parent = entry->parent;
+            tmp.children = entry->children;
+            memcpy(entry, &tmp, sizeof (*entry));
+        } /* if */
+    } /* else */
+    __PHYSFS_platformReleaseMutex(w->mutex);
 
-    /* offset of Zip64 end of central directory record. */
-    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+    return rc;
+} /* zipw_mkdir */
 
-    /* total number of disks */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != 1, PHYSFS_ERR_CORRUPT, 0);
 
-    pos = zip64_find_end_of_central_dir(io, pos, ui64);
-    if (pos < 0)
-        return 0;  /* oh well. */
+static void zipw_entry_stat(const ZIPwentry *entry, PHYSFS_Stat *stat)
+{
+    if (entry->type == ZIPW_FILE)
+    {
+        const int symlink = ( (zip_version_does_symlinks(entry->version)) &&
+                              (((entry->external_attr >> 16) &
+                                UNIX_FILETYPE_MASK) == UNIX_FILETYPE_SYMLINK) );
+        stat->filesize = symlink ? 0 : (PHYSFS_sint64) entry->uncompressed_size;
+        stat->filetype = symlink ? PHYSFS_FILETYPE_SYMLINK :
+                                   PHYSFS_FILETYPE_REGULAR;
+    } /* if */
+    else
+    {
+        stat->filesize = 0;
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+    } /* else */
 
-    /*
-     * For self-extracting archives, etc, there's crapola in the file
-     *  before the zipfile records; we calculate how much data there is
-     *  prepended by determining how far the zip64-end-of-central-directory
-     *  offset is from where it is supposed to be...the difference in bytes
-     *  is how much arbitrary data is at the start of the physical file.
-     */
-    assert(((PHYSFS_uint64) pos) >= ui64);
-    *data_start = ((PHYSFS_uint64) pos) - ui64;
+    stat->modtime = (entry->dos_mod_time == 0) ? 0 :
+                        zip_dos_time_to_physfs_time(entry->dos_mod_time);
+    stat->createtime = stat->modtime;
+    stat->accesstime = 0;
+    stat->readonly = 0;
+} /* zipw_entry_stat */
 
-    BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
 
-    /* check signature again, just in case. */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != ZIP64_END_OF_CENTRAL_DIR_SIG, PHYSFS_ERR_CORRUPT, 0);
+static int zipw_stat(ZIPwriter *w, const char *name, PHYSFS_Stat *stat)
+{
+    PHYSFS_uint32 idx;
+    int rc = 1;
 
-    /* size of Zip64 end of central directory record. */
-    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+    if (*name == '\0')  /* the root. */
+    {
+        memset(stat, '\0', sizeof (*stat));
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        return 1;
+    } /* if */
 
-    /* version made by. */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    __PHYSFS_platformGrabMutex(w->mutex);
+    idx = zipw_find(w, name);
+    if (!zipw_is_live(w, idx))
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+        rc = 0;
+    } /* if */
+    else
+    {
+        zipw_entry_stat(&w->entries[idx], stat);
+    } /* else */
+    __PHYSFS_platformReleaseMutex(w->mutex);
 
-    /* version needed to extract. */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    return rc;
+} /* zipw_stat */
 
-    /* number of this disk. */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
 
-    /* number of disk with start of central directory record. */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != 0, PHYSFS_ERR_CORRUPT, 0);
+/*
+ * The write dir isn't in the search path, so this is only for completeness;
+ *  it just checks every entry. The callbacks run with w->mutex held.
+ */
+static void zipw_enumerate(ZIPwriter *w, const char *dname,
+                           PHYSFS_EnumFilesCallback cb,
+                           PHYSFS_EnumFilesStatCallback statcb,
+                           const char *origdir, void *callbackdata)
+{
+    PHYSFS_uint32 parent = 0;
+    PHYSFS_uint32 i;
 
-    /* total number of entries in the central dir on this disk */
-    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
+    __PHYSFS_platformGrabMutex(w->mutex);
+    if (*dname != '\0')
+    {
+        parent = zipw_find(w, dname);
+        if ( (!zipw_is_live(w, parent)) ||
+             (w->entries[parent].type == ZIPW_FILE) )
+            parent = (PHYSFS_uint32) -1;  /* nothing to list. */
+    } /* if */
 
-    /* total number of entries in the central dir */
-    BAIL_IF_MACRO(!readui64(io, entry_count), ERRPASS, 0);
-    BAIL_IF_MACRO(ui64 != *entry_count, PHYSFS_ERR_CORRUPT, 0);
+    for (i = 1; i < w->entries_used; i++)
+    {
+        const ZIPwentry *entry = &w->entries[i];
+        if ((entry->type != ZIPW_DELETED) && (entry->parent == parent))
+        {
+            const char *ptr = strrchr(entry->name, '/');
+            const char *name = ptr ? ptr + 1 : entry->name;
+            if (statcb == NULL)
+                cb(callbackdata, origdir, name);
+            else
+            {
+                PHYSFS_Stat stat;
+                zipw_entry_stat(entry, &stat);
+                statcb(callbackdata, origdir, name, &stat);
+            } /* else */
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(w->mutex);
+} /* zipw_enumerate */
 
-    /* size of the central directory */
-    BAIL_IF_MACRO(!readui64(io, &ui64), ERRPASS, 0);
 
-    /* offset of central directory */
-    BAIL_IF_MACRO(!readui64(io, dir_ofs), ERRPASS, 0);
+static PHYSFS_Io *ZIP_openRead(void *opaque, const char *filename)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    BAIL_IF_MACRO(info->writer, PHYSFS_ERR_UNSUPPORTED, NULL);
+    return zip_open_read(info, filename, 1);
+} /* ZIP_openRead */
 
-    /* Since we know the difference, fix up the central dir offset... */
-    *dir_ofs += *data_start;
 
-    /*
-     * There are more fields here, for encryption and feature-specific things,
-     *  but we don't care about any of them at the moment.
-     */
+static PHYSFS_Io *ZIP_openWrite(void *opaque, const char *filename)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    BAIL_IF_MACRO(!info->writer, PHYSFS_ERR_READ_ONLY, NULL);
+    return zipw_open_write(info->writer, filename);
+} /* ZIP_openWrite */
 
-    return 1;  /* made it. */
-} /* zip64_parse_end_of_central_dir */
+
+static PHYSFS_Io *ZIP_openAppend(void *opaque, const char *filename)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    BAIL_IF_MACRO(!info->writer, PHYSFS_ERR_READ_ONLY, NULL);
+    return zipw_open_append(info->writer, filename);
+} /* ZIP_openAppend */
 
 
-static int zip_parse_end_of_central_dir(ZIPinfo *info,
-                                        PHYSFS_uint64 *data_start,
-                                        PHYSFS_uint64 *dir_ofs,
-                                        PHYSFS_uint64 *entry_count)
+static void ZIP_closeArchive(void *opaque)
 {
-    PHYSFS_Io *io = info->io;
-    PHYSFS_uint16 entryCount16;
-    PHYSFS_uint32 offset32;
-    PHYSFS_uint32 ui32;
-    PHYSFS_uint16 ui16;
-    PHYSFS_sint64 len;
-    PHYSFS_sint64 pos;
-    int rc;
+    ZIPinfo *info = (ZIPinfo *) (opaque);
 
-    /* find the end-of-central-dir record, and seek to it. */
-    pos = zip_find_end_of_central_dir(io, &len);
-    BAIL_IF_MACRO(pos == -1, ERRPASS, 0);
-    BAIL_IF_MACRO(!io->seek(io, pos), ERRPASS, 0);
+    if (!info)
+        return;
 
-    /* check signature again, just in case. */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
-    BAIL_IF_MACRO(ui32 != ZIP_END_OF_CENTRAL_DIR_SIG, PHYSFS_ERR_CORRUPT, 0);
+    if (info->writer)
+        zip_close_writer(info->writer);
 
-    /* Seek back to see if "Zip64 end of central directory locator" exists. */
-    /* this record is 20 bytes before end-of-central-dir */
-    rc = zip64_parse_end_of_central_dir(info, data_start, dir_ofs,
-                                        entry_count, pos - 20);
+    if (info->centraldir)  /* never looked at. */
+        info->centraldir->destroy(info->centraldir);
+    allocator.Free(info->name);
 
-    /* Error or success? Bounce out of here. Keep going if not zip64. */
-    if ((rc == 0) || (rc == 1))
-        return rc;
+    if (info->io)
+        info->io->destroy(info->io);
 
-    assert(rc == -1);  /* no error, just not a Zip64 archive. */
+    if (info->seekindex)
+        info->seekindex->destroy(info->seekindex);
 
-    /* Not Zip64? Seek back to where we were and keep processing. */
-    BAIL_IF_MACRO(!io->seek(io, pos + 4), ERRPASS, 0);
+    zip_free_cached(info->cache_head);  /* all files are closed by now. */
 
-    /* number of this disk */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
-    BAIL_IF_MACRO(ui16 != 0, PHYSFS_ERR_CORRUPT, 0);
+    if (__PHYSFS_isFastDeinit())
+        return;  /* the process is exiting; leave the index to the OS. */
 
-    /* number of the disk with the start of the central directory */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
-    BAIL_IF_MACRO(ui16 != 0, PHYSFS_ERR_CORRUPT, 0);
+    while (info->spares != NULL)
+    {
+        ZIPfileinfo *finfo = info->spares;
+        info->spares = finfo->next_spare;
+        zip_free_decoder(finfo);
+        inflateEnd(&finfo->stream);
+        zip_free_readbuf(info->mem, finfo->buffer);
+        __PHYSFS_poolFree(finfo, sizeof (ZIPfileinfo));
+    } /* while */
 
-    /* total number of entries in the central dir on this disk */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    if (info->entries)
+    {
+        assert(info->entries[0].sibling == 0);
+        zip_free_stored_checkpoints(info);
+        allocator.Free(info->entries);
+    } /* if */
 
-    /* total number of entries in the central dir */
-    BAIL_IF_MACRO(!readui16(io, &entryCount16), ERRPASS, 0);
-    BAIL_IF_MACRO(ui16 != entryCount16, PHYSFS_ERR_CORRUPT, 0);
+    allocator.Free(info->names);
+    __PHYSFS_hashTableDeinit(&info->hash);
+    __PHYSFS_memCharge(info->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) info->index_charged));
 
-    *entry_count = entryCount16;
+    if (info->rwlock)
+        __PHYSFS_platformDestroyRWLock(info->rwlock);
 
-    /* size of the central directory */
-    BAIL_IF_MACRO(!readui32(io, &ui32), ERRPASS, 0);
+    if (info->spare_mutex)
+        __PHYSFS_platformDestroyMutex(info->spare_mutex);
 
-    /* offset of central directory */
-    BAIL_IF_MACRO(!readui32(io, &offset32), ERRPASS, 0);
-    *dir_ofs = (PHYSFS_uint64) offset32;
-    BAIL_IF_MACRO(pos < (*dir_ofs + ui32), PHYSFS_ERR_CORRUPT, 0);
+    allocator.Free(info);
+} /* ZIP_closeArchive */
 
-    /*
-     * For self-extracting archives, etc, there's crapola in the file
-     *  before the zipfile records; we calculate how much data there is
-     *  prepended by determining how far the central directory offset is
-     *  from where it is supposed to be (start of end-of-central-dir minus
-     *  sizeof central dir)...the difference in bytes is how much arbitrary
-     *  data is at the start of the physical file.
-     */
-    *data_start = (PHYSFS_uint64) (pos - (*dir_ofs + ui32));
 
-    /* Now that we know the difference, fix up the central dir offset... */
-    *dir_ofs += *data_start;
+static int ZIP_remove(void *opaque, const char *name)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    BAIL_IF_MACRO(!info->writer, PHYSFS_ERR_READ_ONLY, 0);
+    return zipw_remove(info->writer, name);
+} /* ZIP_remove */
+
+
+static int ZIP_mkdir(void *opaque, const char *name)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    BAIL_IF_MACRO(!info->writer, PHYSFS_ERR_READ_ONLY, 0);
+    return zipw_mkdir(info->writer, name);
+} /* ZIP_mkdir */
+
+
+/*
+ * Everything zip_entry_stat() does but the timestamps, which cost more. It
+ *  all comes from the central directory, so stat and enumeration never
+ *  resolve (entry): its local header isn't read until it's opened. A
+ *  symlink is reported as one, without looking up what it points to.
+ */
+static void zip_entry_stat_type(const ZIPentry *entry, PHYSFS_Stat *stat)
+{
+    if (entry->resolved == ZIP_DIRECTORY)
+    {
+        stat->filesize = 0;
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+    } /* if */
+
+    else if (zip_entry_is_symlink(entry))
+    {
+        stat->filesize = 0;
+        stat->filetype = PHYSFS_FILETYPE_SYMLINK;
+    } /* else if */
+
+    else
+    {
+        stat->filesize = (PHYSFS_sint64) entry->uncompressed_size;
+        stat->filetype = PHYSFS_FILETYPE_REGULAR;
+    } /* else */
 
-    /* zipfile comment length */
-    BAIL_IF_MACRO(!readui16(io, &ui16), ERRPASS, 0);
+    stat->readonly = 1; /* .zip files are always read only */
+} /* zip_entry_stat_type */
 
-    /*
-     * Make sure that the comment length matches to the end of file...
-     *  If it doesn't, we're either in the wrong part of the file, or the
-     *  file is corrupted, but we give up either way.
-     */
-    BAIL_IF_MACRO((pos + 22 + ui16) != len, PHYSFS_ERR_CORRUPT, 0);
 
-    return 1;  /* made it. */
-} /* zip_parse_end_of_central_dir */
+static void zip_entry_stat(const ZIPentry *entry, PHYSFS_Stat *stat)
+{
+    zip_entry_stat_type(entry, stat);
+
+    /* this is mktime() under the hood, so only when someone asks. */
+    stat->modtime = (entry->dos_mod_time == 0) ? 0 :
+                        zip_dos_time_to_physfs_time(entry->dos_mod_time);
+    stat->createtime = stat->modtime;
+    stat->accesstime = 0;
+} /* zip_entry_stat */
 
 
-static int zip_alloc_hashtable(ZIPinfo *info, const PHYSFS_uint64 entry_count)
+static int ZIP_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
 {
-    size_t alloclen;
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    const ZIPentry *entry;
 
-    info->hashBuckets = (size_t) (entry_count / 5);
-    if (!info->hashBuckets)
-        info->hashBuckets = 1;
+    if (info->writer)
+        return zipw_stat(info->writer, filename, stat);
 
-    alloclen = info->hashBuckets * sizeof (ZIPentry *);
-    info->hash = (ZIPentry **) allocator.Malloc(alloclen);
-    BAIL_IF_MACRO(!info->hash, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    memset(info->hash, '\0', alloclen);
+    BAIL_IF_MACRO(!zip_load_central_dir(info), ERRPASS, 0);
+    entry = zip_find_entry(info, filename);
+    if (entry == NULL)
+        return 0;
 
+    zip_entry_stat(entry, stat);
     return 1;
-} /* zip_alloc_hashtable */
+} /* ZIP_stat */
 
-static void ZIP_closeArchive(void *opaque);
 
-static void *ZIP_openArchive(PHYSFS_Io *io, const char *name, int forWriting)
+static int ZIP_checksum(void *opaque, const char *filename,
+                        PHYSFS_uint32 *crc)
 {
-    ZIPinfo *info = NULL;
-    PHYSFS_uint64 dstart;  /* data start */
-    PHYSFS_uint64 cdir_ofs;  /* central dir offset */
-    PHYSFS_uint64 entry_count;
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    const ZIPentry *entry;
 
-    assert(io != NULL);  /* shouldn't ever happen. */
+    /* a file being written has no central directory entry yet. */
+    BAIL_IF_MACRO(info->writer, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!zip_load_central_dir(info), ERRPASS, 0);
+    entry = zip_find_entry(info, filename);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->resolved == ZIP_DIRECTORY, PHYSFS_ERR_NOT_A_FILE, 0);
 
-    BAIL_IF_MACRO(forWriting, PHYSFS_ERR_READ_ONLY, NULL);
-    BAIL_IF_MACRO(!isZip(io), ERRPASS, NULL);
+    /* the crc is the link's own; reading it finds what it points to. */
+    BAIL_IF_MACRO(zip_entry_is_symlink(entry), PHYSFS_ERR_UNSUPPORTED, 0);
 
-    info = (ZIPinfo *) allocator.Malloc(sizeof (ZIPinfo));
-    BAIL_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    memset(info, '\0', sizeof (ZIPinfo));
-    info->root.resolved = ZIP_DIRECTORY;
-    info->io = io;
+    *crc = entry->crc;
+    return 1;
+} /* ZIP_checksum */
 
-    if (!zip_parse_end_of_central_dir(info, &dstart, &cdir_ofs, &entry_count))
-        goto ZIP_openarchive_failed;
-    else if (!zip_alloc_hashtable(info, entry_count))
-        goto ZIP_openarchive_failed;
-    else if (!zip_load_entries(info, dstart, cdir_ofs, entry_count))
-        goto ZIP_openarchive_failed;
 
-    assert(info->root.sibling == NULL);
-    return info;
+static int ZIP_layout(void *opaque, const char *filename,
+                      PHYSFS_EntryLayout *layout)
+{
+    ZIPinfo *info = (ZIPinfo *) opaque;
+    ZIPentry *entry;
+    PHYSFS_Io *io;
 
-ZIP_openarchive_failed:
-    info->io = NULL;  /* don't let ZIP_closeArchive destroy (io). */
-    ZIP_closeArchive(info);
-    return NULL;
-} /* ZIP_openArchive */
+    BAIL_IF_MACRO(info->writer, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!zip_load_central_dir(info), ERRPASS, 0);
+    entry = zip_find_entry(info, filename);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
+    BAIL_IF_MACRO(entry->resolved == ZIP_DIRECTORY, PHYSFS_ERR_NOT_A_FILE, 0);
+
+    /* until it's resolved, (offset) is its local header, not its data. */
+    io = zip_get_io(info->io, info, entry);
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    io->destroy(io);
+
+    if (entry->symlink != 0)
+        entry = zip_symlink_target(info, entry);
+
+    layout->offset = entry->offset;  /* a crypto header's part of it. */
+    layout->storedSize = entry->compressed_size;
+    layout->size = entry->uncompressed_size;
+    layout->method = entry->compression_method;
+    if (zip_entry_is_tradional_crypto(entry))
+        layout->encoding = PHYSFS_ENCODING_OTHER;
+    else if (entry->compression_method == COMPMETH_NONE)
+        layout->encoding = PHYSFS_ENCODING_IDENTITY;
+    else if (entry->compression_method == COMPMETH_DEFLATE)
+        layout->encoding = PHYSFS_ENCODING_DEFLATE;
+    else if (zip_entry_is_zstd(entry))
+        layout->encoding = PHYSFS_ENCODING_ZSTD;
+    else if (zip_entry_is_lz4(entry))
+        layout->encoding = PHYSFS_ENCODING_LZ4;
+    else
+        layout->encoding = PHYSFS_ENCODING_OTHER;
 
+    return 1;
+} /* ZIP_layout */
 
-static void ZIP_enumerateFiles(void *opaque, const char *dname,
-                               PHYSFS_EnumFilesCallback cb,
-                               const char *origdir, void *callbackdata)
+
+static void zip_enumerate_stat(ZIPinfo *info, const char *dname,
+                               PHYSFS_EnumFilesStatCallback cb,
+                               const char *origdir, void *callbackdata,
+                               const int typeonly)
 {
-    ZIPinfo *info = ((ZIPinfo *) opaque);
-    const ZIPentry *entry = zip_find_entry(info, dname);
+    const ZIPentry *entry;
+
+    if (info->writer)
+    {
+        zipw_enumerate(info->writer, dname, NULL, cb, origdir, callbackdata);
+        return;
+    } /* if */
+
+    if (!zip_load_central_dir(info))
+        return;
+
+    entry = zip_find_entry(info, dname);
     if (entry && (entry->resolved == ZIP_DIRECTORY))
     {
-        for (entry = entry->children; entry; entry = entry->sibling)
+        PHYSFS_uint32 i;
+        for (i = entry->children; i != 0; i = info->entries[i].sibling)
         {
-            const char *ptr = strrchr(entry->name, '/');
-            cb(callbackdata, origdir, ptr ? ptr + 1 : entry->name);
+            const ZIPentry *child = &info->entries[i];
+            const char *name = zip_entry_name(info, child);
+            const char *ptr = strrchr(name, '/');
+            PHYSFS_Stat stat;
+            if (!typeonly)
+                zip_entry_stat(child, &stat);
+            else
+            {
+                zip_entry_stat_type(child, &stat);
+                stat.modtime = stat.createtime = stat.accesstime = -1;
+            } /* else */
+            cb(callbackdata, origdir, ptr ? ptr + 1 : name, &stat);
         } /* for */
     } /* if */
-} /* ZIP_enumerateFiles */
+} /* zip_enumerate_stat */
 
 
-static PHYSFS_Io *zip_get_io(PHYSFS_Io *io, ZIPinfo *inf, ZIPentry *entry)
+static void ZIP_enumerateFilesStat(void *opaque, const char *dname,
+                                   PHYSFS_EnumFilesStatCallback cb,
+                                   const char *origdir, void *callbackdata)
 {
-    int success;
-    PHYSFS_Io *retval = io->duplicate(io);
-    BAIL_IF_MACRO(!retval, ERRPASS, NULL);
+    zip_enumerate_stat((ZIPinfo *) opaque, dname, cb, origdir,
+                       callbackdata, 0);
+} /* ZIP_enumerateFilesStat */
 
-    /* !!! FIXME: if you open a dir here, it should bail ERR_NOT_A_FILE */
 
-    /* (inf) can be NULL if we already resolved. */
-    success = (inf == NULL) || zip_resolve(retval, inf, entry);
-    if (success)
+void __PHYSFS_zipEnumerateFilesType(void *opaque, const char *dname,
+                                    PHYSFS_EnumFilesStatCallback cb,
+                                    const char *origdir, void *callbackdata)
+{
+    zip_enumerate_stat((ZIPinfo *) opaque, dname, cb, origdir,
+                       callbackdata, 1);
+} /* __PHYSFS_zipEnumerateFilesType */
+
+
+/*
+ * Inflate all of (entry), keeping checkpoints every (interval) bytes, and
+ *  write them to (out) as a seek index record. Entries that can't use one,
+ *  or are too small to get any checkpoints, are skipped.
+ */
+static int zip_write_seek_index_entry(ZIPinfo *info, ZIPentry *entry,
+                                      PHYSFS_Io *out,
+                                      const PHYSFS_uint32 interval,
+                                      PHYSFS_uint8 *buf,
+                                      PHYSFS_uint32 *written)
+{
+    const ZIPcheckpoint *checkpoints;
+    ZIPfileinfo *finfo;
+    PHYSFS_uint32 namelen;
+    PHYSFS_uint32 count;
+    PHYSFS_uint32 i;
+    PHYSFS_sint64 br;
+    PHYSFS_Io *io;
+    int ok;
+
+    /* symlinks are covered by the record for what they point to. */
+    if ((entry->resolved == ZIP_DIRECTORY) || (zip_entry_is_symlink(entry)))
+        return 1;
+    else if (!zip_entry_is_deflated(entry))
+        return 1;  /* stored, or a decoder we can't snapshot. */
+    else if (zip_entry_is_tradional_crypto(entry))
+        return 1;
+
+    /* has to be a ZIP_Io. */
+    io = zip_open_read(info, zip_entry_name(info, entry), 0);
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    finfo = (ZIPfileinfo *) io->opaque;
+    finfo->checkpoint_interval = interval;
+
+    do
     {
-        PHYSFS_sint64 offset;
-        offset = ((entry->symlink) ? entry->symlink->offset : entry->offset);
-        success = retval->seek(retval, offset);
-    } /* if */
+        br = io->read(io, buf, ZIP_READBUFSIZE);
+    } while (br > 0);
 
-    if (!success)
+    ok = ((br == 0) &&
+          (finfo->uncompressed_position == entry->uncompressed_size));
+    if (!ok)
+        PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+
+    else if (finfo->checkpoint_count > 0)
     {
-        retval->destroy(retval);
-        retval = NULL;
-    } /* if */
+        const char *name = zip_entry_name(info, entry);
+        namelen = (PHYSFS_uint32) strlen(name);
+        count = finfo->checkpoint_count;
+        checkpoints = finfo->checkpoints;
+
+        ok = ( (writeui32(out, namelen)) &&
+               (out->write(out, name, namelen) == namelen) &&
+               (writeui32(out, entry->crc)) &&
+               (writeui64(out, entry->compressed_size)) &&
+               (writeui64(out, entry->uncompressed_size)) &&
+               (writeui32(out, count)) );
+
+        for (i = 0; (ok) && (i < count); i++)
+        {
+            ok = ( (writeui64(out, checkpoints[i].uncompressed_position)) &&
+                   (writeui64(out, checkpoints[i].compressed_position)) );
+        } /* for */
 
-    return retval;
-} /* zip_get_io */
+        for (i = 0; (ok) && (i < count); i++)
+        {
+            ok = (out->write(out, checkpoints[i].state,
+                             PHYSFS_INFLATE_STATE_SIZE) ==
+                                PHYSFS_INFLATE_STATE_SIZE);
+        } /* for */
+
+        if (ok)
+            (*written)++;
+    } /* else if */
 
+    io->destroy(io);
+    return ok;
+} /* zip_write_seek_index_entry */
 
-static PHYSFS_Io *ZIP_openRead(void *opaque, const char *filename)
+
+int __PHYSFS_zipBuildSeekIndex(const char *archive,
+                               const PHYSFS_uint32 interval)
 {
-    PHYSFS_Io *retval = NULL;
-    ZIPinfo *info = (ZIPinfo *) opaque;
-    ZIPentry *entry = zip_find_entry(info, filename);
-    ZIPfileinfo *finfo = NULL;
-    PHYSFS_Io *io = NULL;
-    PHYSFS_uint8 *password = NULL;
-    int i;
+    const size_t len = strlen(archive) + sizeof (ZIP_SEEKINDEX_EXTENSION);
+    const PHYSFS_uint32 byteorder = ZIP_SEEKINDEX_BYTEORDER;
+    PHYSFS_uint32 written = 0;
+    PHYSFS_uint8 *buf = NULL;
+    ZIPinfo *info = NULL;
+    PHYSFS_Io *out = NULL;
+    char *path = NULL;
+    PHYSFS_Io *io;
+    size_t i;
 
-    /* if not found, see if maybe "$PASSWORD" is appended. */
-    if ((!entry) && (info->has_crypto))
+    assert(interval > 0);
+
+    /* there's nothing to save if our inflater can't be saved. */
+    BAIL_IF_MACRO(!PHYSFS_INFLATE_FLAT_STATE, PHYSFS_ERR_UNSUPPORTED, 0);
+
+    io = __PHYSFS_createNativeIo(archive, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    info = (ZIPinfo *) ZIP_openArchive(io, NULL, 0);  /* NULL: no seek index. */
+    if (info == NULL)
     {
-        const char *ptr = strrchr(filename, '$');
-        if (ptr != NULL)
-        {
-            const PHYSFS_uint64 len = (PHYSFS_uint64) (ptr - filename);
-            char *str = (char *) __PHYSFS_smallAlloc(len + 1);
-            BAIL_IF_MACRO(!str, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-            memcpy(str, filename, len);
-            str[len] = '\0';
-            entry = zip_find_entry(info, str);
-            __PHYSFS_smallFree(str);
-            password = (PHYSFS_uint8 *) (ptr + 1);
-        } /* if */
+        io->destroy(io);
+        return 0;
     } /* if */
 
-    BAIL_IF_MACRO(!entry, ERRPASS, NULL);
+    GOTO_IF_MACRO(!zip_load_central_dir(info), ERRPASS, buildSeekIndexFailed);
 
-    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, ZIP_openRead_failed);
+    path = (char *) allocator.Malloc(len);
+    GOTO_IF_MACRO(!path, PHYSFS_ERR_OUT_OF_MEMORY, buildSeekIndexFailed);
+    strcpy(path, archive);
+    strcat(path, ZIP_SEEKINDEX_EXTENSION);
 
-    finfo = (ZIPfileinfo *) allocator.Malloc(sizeof (ZIPfileinfo));
-    GOTO_IF_MACRO(!finfo, PHYSFS_ERR_OUT_OF_MEMORY, ZIP_openRead_failed);
-    memset(finfo, '\0', sizeof (ZIPfileinfo));
+    buf = (PHYSFS_uint8 *) allocator.Malloc(ZIP_READBUFSIZE);
+    GOTO_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, buildSeekIndexFailed);
 
-    io = zip_get_io(info->io, info, entry);
-    GOTO_IF_MACRO(!io, ERRPASS, ZIP_openRead_failed);
-    finfo->io = io;
-    finfo->entry = ((entry->symlink != NULL) ? entry->symlink : entry);
-    initializeZStream(&finfo->stream);
+    out = __PHYSFS_createNativeIo(path, 'w');
+    GOTO_IF_MACRO(!out, ERRPASS, buildSeekIndexFailed);
 
-    if (finfo->entry->compression_method != COMPMETH_NONE)
-    {
-        finfo->buffer = (PHYSFS_uint8 *) allocator.Malloc(ZIP_READBUFSIZE);
-        if (!finfo->buffer)
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, ZIP_openRead_failed);
-        else if (zlib_err(inflateInit2(&finfo->stream, -MAX_WBITS)) != Z_OK)
-            goto ZIP_openRead_failed;
-    } /* if */
+    /* the entry count is zero until we know what it really is. */
+    if ( (!writeui32(out, ZIP_SEEKINDEX_SIG)) ||
+         (!writeui32(out, ZIP_SEEKINDEX_VERSION)) ||
+         (!writeui32(out, PHYSFS_INFLATE_STATE_SIZE)) ||
+         (out->write(out, &byteorder, 4) != 4) ||
+         (!writeui32(out, 0)) )
+        goto buildSeekIndexFailed;
 
-    if (!zip_entry_is_tradional_crypto(entry))
-        GOTO_IF_MACRO(password != NULL, PHYSFS_ERR_BAD_PASSWORD, ZIP_openRead_failed);
-    else
+    for (i = 1; i < info->entries_used; i++)  /* skip the root dir. */
     {
-        PHYSFS_uint8 crypto_header[12];
-        GOTO_IF_MACRO(password == NULL, PHYSFS_ERR_BAD_PASSWORD, ZIP_openRead_failed);
-        if (io->read(io, crypto_header, 12) != 12)
-            goto ZIP_openRead_failed;
-        else if (!zip_prep_crypto_keys(finfo, crypto_header, password))
-            goto ZIP_openRead_failed;
-    } /* if */
+        if (!zip_write_seek_index_entry(info, &info->entries[i], out,
+                                        interval, buf, &written))
+            goto buildSeekIndexFailed;
+    } /* for */
 
-    memcpy(retval, &ZIP_Io, sizeof (PHYSFS_Io));
-    retval->opaque = finfo;
+    if ( (!out->seek(out, 16)) || (!writeui32(out, written)) ||
+         (!out->flush(out)) )
+        goto buildSeekIndexFailed;
 
-    return retval;
+    out->destroy(out);
+    allocator.Free(buf);
+    allocator.Free(path);
+    ZIP_closeArchive(info);
+    return 1;
 
-ZIP_openRead_failed:
-    if (finfo != NULL)
+buildSeekIndexFailed:
+    if (out != NULL)
     {
-        if (finfo->io != NULL)
-            finfo->io->destroy(finfo->io);
-
-        if (finfo->buffer != NULL)
-        {
-            allocator.Free(finfo->buffer);
-            inflateEnd(&finfo->stream);
-        } /* if */
-
-        allocator.Free(finfo);
+        out->destroy(out);
+        __PHYSFS_platformDelete(path);  /* don't leave half of one around. */
     } /* if */
+    allocator.Free(buf);
+    allocator.Free(path);
+    ZIP_closeArchive(info);
+    return 0;
+} /* __PHYSFS_zipBuildSeekIndex */
 
-    if (retval != NULL)
-        allocator.Free(retval);
-
-    return NULL;
-} /* ZIP_openRead */
 
+static int cmpWentryOffsets(void *_a, size_t one, size_t two)
+{
+    ZIPwentry **a = (ZIPwentry **) _a;
+    if (a[one]->offset < a[two]->offset)
+        return -1;
+    return (a[one]->offset > a[two]->offset) ? 1 : 0;
+} /* cmpWentryOffsets */
 
-static PHYSFS_Io *ZIP_openWrite(void *opaque, const char *filename)
+static void swapWentryOffsets(void *_a, size_t one, size_t two)
 {
-    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
-} /* ZIP_openWrite */
+    ZIPwentry **a = (ZIPwentry **) _a;
+    ZIPwentry *tmp = a[one];
+    a[one] = a[two];
+    a[two] = tmp;
+} /* swapWentryOffsets */
 
 
-static PHYSFS_Io *ZIP_openAppend(void *opaque, const char *filename)
+/*
+ * Copy (entry)'s local header and data, still compressed, from (in), the
+ *  archive it's in, to the end of (w)'s archive. (buf) is ZIP_READBUFSIZE
+ *  bytes of scratch space.
+ */
+static int zipw_copy_entry(ZIPwriter *w, PHYSFS_Io *in, ZIPwentry *entry,
+                           PHYSFS_uint8 *buf)
 {
-    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, NULL);
-} /* ZIP_openAppend */
+    PHYSFS_uint8 hdr[ZIP_LOCAL_HEADER_SIZE];
+    PHYSFS_uint64 remaining = entry->compressed_size;
+    PHYSFS_uint32 hdrlen;
+    ZIPentry old;
+
+    memset(&old, '\0', sizeof (old));
+    old.version_needed = entry->version_needed;
+    old.compression_method = entry->compression_method;
+    old.crc = entry->crc;
+    old.compressed_size = entry->compressed_size;
+    old.uncompressed_size = entry->uncompressed_size;
+
+    BAIL_IF_MACRO(!in->seek(in, entry->offset), ERRPASS, 0);
+    BAIL_IF_MACRO(!__PHYSFS_readAll(in, hdr, sizeof (hdr)), ERRPASS, 0);
+    hdrlen = zip_check_local(hdr, &old);
+    BAIL_IF_MACRO(!hdrlen, PHYSFS_ERR_CORRUPT, 0);
+    BAIL_IF_MACRO(!in->seek(in, entry->offset + hdrlen), ERRPASS, 0);
 
+    /*
+     * The new local header has the sizes and CRC, so the data descriptor,
+     *  if there was one, is left behind. Not for encrypted files, though:
+     *  with bit 3 set, their password check byte comes from the time.
+     */
+    if ((entry->general_bits & 0x0001) == 0)
+        entry->general_bits &= ~0x0008;
 
-static void ZIP_closeArchive(void *opaque)
-{
-    ZIPinfo *info = (ZIPinfo *) (opaque);
+    BAIL_IF_MACRO(!zipw_write_local(w, entry, NULL, 0), ERRPASS, 0);
+    while (remaining > 0)
+    {
+        const PHYSFS_uint64 len = (remaining < ZIP_READBUFSIZE) ?
+                                        remaining : ZIP_READBUFSIZE;
+        BAIL_IF_MACRO(!__PHYSFS_readAll(in, buf, len), ERRPASS, 0);
+        BAIL_IF_MACRO(!zipw_write(w, buf, len), ERRPASS, 0);
+        remaining -= len;
+    } /* while */
 
-    if (!info)
-        return;
+    w->append_pos += entry->compressed_size;
+    return 1;
+} /* zipw_copy_entry */
 
-    if (info->io)
-        info->io->destroy(info->io);
 
-    assert(info->root.sibling == NULL);
-    assert(info->hash || (info->root.children == NULL));
+int __PHYSFS_zipCompact(const char *archive)
+{
+    ZIPwentry **sorted = NULL;
+    PHYSFS_uint8 *buf = NULL;
+    ZIPinfo *info = NULL;
+    PHYSFS_Io *out = NULL;
+    PHYSFS_uint32 count = 0;
+    PHYSFS_uint32 i;
+    char *tmp = NULL;
+    int created = 0;
+    int retval = 0;
+    ZIPwriter *w;
+    PHYSFS_Io *io;
 
-    if (info->hash)
+    io = __PHYSFS_createNativeIo(archive, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    info = (ZIPinfo *) zip_open_writer(io, archive);
+    if (info == NULL)
     {
-        size_t i;
-        for (i = 0; i < info->hashBuckets; i++)
-        {
-            ZIPentry *entry;
-            ZIPentry *next;
-            for (entry = info->hash[i]; entry; entry = next)
-            {
-                next = entry->hashnext;
-                allocator.Free(entry);
-            } /* for */
-        } /* for */
-        allocator.Free(info->hash);
+        io->destroy(io);
+        return 0;
     } /* if */
 
-    allocator.Free(info);
-} /* ZIP_closeArchive */
+    /* (w) reads the old entries through (io), and writes through (out). */
+    w = info->writer;
 
+    sorted = (ZIPwentry **) allocator.Malloc(sizeof (ZIPwentry *) *
+                                             w->entries_used);
+    GOTO_IF_MACRO(!sorted, PHYSFS_ERR_OUT_OF_MEMORY, compactDone);
+    for (i = 1; i < w->entries_used; i++)
+    {
+        ZIPwentry *entry = &w->entries[i];
+        if ((entry->type == ZIPW_FILE) || (entry->type == ZIPW_DIR))
+            sorted[count++] = entry;
+    } /* for */
+    __PHYSFS_sort(sorted, count, cmpWentryOffsets, swapWentryOffsets);
 
-static int ZIP_remove(void *opaque, const char *name)
-{
-    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
-} /* ZIP_remove */
+    buf = (PHYSFS_uint8 *) allocator.Malloc(ZIP_READBUFSIZE);
+    GOTO_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, compactDone);
 
+    /* written under a name of its own, so nobody sees half of it. */
+    tmp = (char *) allocator.Malloc(strlen(archive) + 40);
+    GOTO_IF_MACRO(!tmp, PHYSFS_ERR_OUT_OF_MEMORY, compactDone);
+    sprintf(tmp, "%s.%p.tmp", archive, __PHYSFS_platformGetThreadID());
 
-static int ZIP_mkdir(void *opaque, const char *name)
+    out = __PHYSFS_createNativeIo(tmp, 'w');
+    GOTO_IF_MACRO(!out, ERRPASS, compactDone);
+    created = 1;
+
+    w->io = out;
+    w->append_pos = w->old_length = 0;
+    for (i = 0; i < count; i++)
+    {
+        GOTO_IF_MACRO(!zipw_copy_entry(w, io, sorted[i], buf), ERRPASS,
+                      compactDone);
+    } /* for */
+    GOTO_IF_MACRO(!zipw_write_central_dir(w), ERRPASS, compactDone);
+
+    w->io = io;
+    out->destroy(out);
+    out = NULL;
+    GOTO_IF_MACRO(!__PHYSFS_platformSyncData(tmp), ERRPASS, compactDone);
+    GOTO_IF_MACRO(!__PHYSFS_platformRename(tmp, archive), ERRPASS,
+                  compactDone);
+    retval = 1;
+
+compactDone:
+    if (out != NULL)
+        out->destroy(out);
+    if ((created) && (!retval))
+        __PHYSFS_platformDelete(tmp);
+    w->io = io;  /* so closing it closes (io), and... */
+    w->dirty = 0;  /* ...doesn't write anything there. */
+    ZIP_closeArchive(info);
+    allocator.Free(tmp);
+    allocator.Free(buf);
+    allocator.Free(sorted);
+    return retval;
+} /* __PHYSFS_zipCompact */
+
+
+int __PHYSFS_zipGetRawSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len, int *encoding)
 {
-    BAIL_MACRO(PHYSFS_ERR_READ_ONLY, 0);
-} /* ZIP_mkdir */
+    const ZIPfileinfo *finfo;
+    const ZIPentry *entry;
 
+    if (io->read != ZIP_read)
+        return 0;  /* not ours, or it's come from the cache. */
 
-static int ZIP_stat(void *opaque, const char *filename, PHYSFS_Stat *stat)
+    finfo = (const ZIPfileinfo *) io->opaque;
+    entry = finfo->entry;
+    if (finfo->uncompressed_position != 0)
+        return 0;
+    else if (zip_entry_is_tradional_crypto(entry))
+        return 0;
+    else if (entry->compression_method == COMPMETH_NONE)
+    {
+        if (entry->compressed_size != entry->uncompressed_size)
+            return 0;  /* let ZIP_read() sort that out. */
+    } /* else if */
+    else if ((!zip_entry_is_deflated(entry)) ||
+             (!zip_can_inflate_whole(finfo)))
+        return 0;
+
+    *archive = finfo->info;
+    *src = finfo->io;
+    *pos = entry->offset;
+    *len = entry->compressed_size;
+    *encoding = (entry->compression_method == COMPMETH_NONE) ?
+                    (int) PHYSFS_ENCODING_IDENTITY :
+                    (int) PHYSFS_ENCODING_DEFLATE;
+    return 1;
+} /* __PHYSFS_zipGetRawSpan */
+
+
+int __PHYSFS_zipGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len)
 {
-    ZIPinfo *info = (ZIPinfo *) opaque;
-    const ZIPentry *entry = zip_find_entry(info, filename);
+    const ZIPfileinfo *finfo;
+    const ZIPentry *entry;
 
-    /* !!! FIXME: does this need to resolve entries here? */
+    if (io->read != ZIP_read)
+        return 0;
 
-    if (entry == NULL)
+    finfo = (const ZIPfileinfo *) io->opaque;
+    entry = finfo->entry;
+    if (entry->compression_method != COMPMETH_NONE)
+        return 0;
+    else if (entry->compressed_size != entry->uncompressed_size)
+        return 0;
+    else if (zip_entry_is_tradional_crypto(entry))
         return 0;
 
-    else if (entry->resolved == ZIP_DIRECTORY)
-    {
-        stat->filesize = 0;
-        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
-    } /* if */
+    *archive = finfo->info;
+    *src = finfo->io;
+    *pos = entry->offset;
+    *len = entry->uncompressed_size;
+    return 1;
+} /* __PHYSFS_zipGetStoredSpan */
 
-    else if (zip_entry_is_symlink(entry))
-    {
-        stat->filesize = 0;
-        stat->filetype = PHYSFS_FILETYPE_SYMLINK;
-    } /* else if */
 
+int __PHYSFS_zipCheckWhole(PHYSFS_Io *io, const void *buf, PHYSFS_uint64 len)
+{
+    ZIPfileinfo *finfo;
+
+    if (io->read != ZIP_read)
+        return 1;
+
+    finfo = (ZIPfileinfo *) io->opaque;
+    return __PHYSFS_crcCheckRead(&finfo->crccheck, buf, len, 0,
+                                 finfo->entry->uncompressed_size,
+                                 finfo->entry->crc);
+} /* __PHYSFS_zipCheckWhole */
+
+
+int __PHYSFS_zipDecodeRaw(PHYSFS_Io *io, const void *raw, void *buf)
+{
+    ZIPfileinfo *finfo = (ZIPfileinfo *) io->opaque;
+    const ZIPentry *entry = finfo->entry;
+
+    assert(io->read == ZIP_read);
+    assert(finfo->uncompressed_position == 0);
+
+    if (entry->compression_method == COMPMETH_NONE)
+        memcpy(buf, raw, (size_t) entry->uncompressed_size);
     else
     {
-        stat->filesize = (PHYSFS_sint64) entry->uncompressed_size;
-        stat->filetype = PHYSFS_FILETYPE_REGULAR;
+        const char *name = zip_entry_name(finfo->info, entry);
+        const PHYSFS_sint64 size = (PHYSFS_sint64) entry->uncompressed_size;
+        int rc;
+
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_DECOMPRESS, name, NULL, size);
+        rc = zip_inflate_all(finfo, (const PHYSFS_uint8 *) raw, buf);
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_DECOMPRESS, name, NULL,
+                           rc ? size : -1, rc);
+        if (!rc)
+            return 0;
+        __PHYSFS_STAT_ADD(bytesDecompressedZip, size);
     } /* else */
 
-    stat->modtime = ((entry) ? entry->last_mod_time : 0);
-    stat->createtime = stat->modtime;
-    stat->accesstime = 0;
-    stat->readonly = 1; /* .zip files are always read only */
-
+    /*
+     * Leave (io) at EOF, as if it had read all of this itself. Nothing
+     *  reads finfo->io from there without seeking it first, so we don't
+     *  touch it; another thread might be reading this file's data with it.
+     */
+    finfo->uncompressed_position = entry->uncompressed_size;
     return 1;
-} /* ZIP_stat */
+} /* __PHYSFS_zipDecodeRaw */
+
+
+static int ZIP_claim(const void *head, PHYSFS_uint64 headLen,
+                     const void *tail, PHYSFS_uint64 tailLen,
+                     PHYSFS_uint64 fileLen)
+{
+    const PHYSFS_uint8 *ptr = (const PHYSFS_uint8 *) tail;
+    PHYSFS_uint32 sig;
+    size_t i;
+
+    /* what isZip() looks for: a local file header first... */
+    if (headLen >= 4)
+    {
+        memcpy(&sig, head, 4);
+        if (PHYSFS_swapULE32(sig) == ZIP_LOCAL_FILE_SIG)
+            return 1;
+    } /* if */
+
+    /* ...or an end of central directory record near the end. */
+    for (i = (size_t) tailLen; i >= 4; i--)
+    {
+        memcpy(&sig, ptr + (i - 4), 4);
+        if (PHYSFS_swapULE32(sig) == ZIP_END_OF_CENTRAL_DIR_SIG)
+            return 1;
+    } /* for */
+
+    return 0;
+} /* ZIP_claim */
 
 
 const PHYSFS_Archiver __PHYSFS_Archiver_ZIP =
@@ -1865,7 +6542,12 @@ const PHYSFS_Archiver __PHYSFS_Archiver_ZIP =
     ZIP_remove,
     ZIP_mkdir,
     ZIP_stat,
-    ZIP_closeArchive
+    ZIP_closeArchive,
+    ZIP_enumerateFilesStat,
+    ZIP_claim,
+    ZIP_enumerateFilesPrefix,
+    ZIP_checksum,
+    ZIP_layout
 };
 
 #endif  /* defined PHYSFS_SUPPORTS_ZIP */
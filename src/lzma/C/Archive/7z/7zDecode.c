@@ -17,6 +17,9 @@
 
 #define k_Copy 0
 #define k_LZMA 0x30101
+/* BEGIN PHYSFS CHANGE */
+#define k_LZMA2 0x21
+/* END PHYSFS CHANGE */
 #define k_BCJ 0x03030103
 #define k_BCJ2 0x0303011B
 
@@ -137,7 +140,9 @@ SZ_RESULT SzDecodeCopy(CFileSize inSize, ISzInStream *inStream, Byte *outBuffer)
 }
 #endif
 
-#define IS_UNSUPPORTED_METHOD(m) ((m) != k_Copy && (m) != k_LZMA)
+/* BEGIN PHYSFS CHANGE */
+#define IS_UNSUPPORTED_METHOD(m) ((m) != k_Copy && (m) != k_LZMA && (m) != k_LZMA2)
+/* END PHYSFS CHANGE */
 #define IS_UNSUPPORTED_CODER(c) (IS_UNSUPPORTED_METHOD(c.MethodID) || c.NumInStreams != 1 || c.NumOutStreams != 1)
 #define IS_NO_BCJ(c) (c.MethodID != k_BCJ || c.NumInStreams != 1 || c.NumOutStreams != 1)
 #define IS_NO_BCJ2(c) (c.MethodID != k_BCJ2 || c.NumInStreams != 4 || c.NumOutStreams != 1)
@@ -213,7 +218,10 @@ SZ_RESULT SzDecode2(const CFileSize *packSizes, const CFolder *folder,
   {
     CCoderInfo *coder = &folder->Coders[ci];
 
-    if (coder->MethodID == k_Copy || coder->MethodID == k_LZMA)
+    /* BEGIN PHYSFS CHANGE */
+    if (coder->MethodID == k_Copy || coder->MethodID == k_LZMA ||
+        coder->MethodID == k_LZMA2)
+    /* END PHYSFS CHANGE */
     {
       UInt32 si = 0;
       CFileSize offset;
@@ -264,6 +272,19 @@ SZ_RESULT SzDecode2(const CFileSize *packSizes, const CFolder *folder,
         memcpy(outBufCur, inBuffer + (size_t)offset, (size_t)inSize);
         #endif
       }
+      /* BEGIN PHYSFS CHANGE */
+      else if (coder->MethodID == k_LZMA2)
+      {
+        SZ_RESULT res = SzDecodeLzma2(coder, inSize,
+            #ifdef _LZMA_IN_CB
+            inStream,
+            #else
+            inBuffer + (size_t)offset,
+            #endif
+            outBufCur, outSizeCur, allocMain);
+        RINOK(res)
+      }
+      /* END PHYSFS CHANGE */
       else
       {
         SZ_RESULT res = SzDecodeLzma(coder, inSize,
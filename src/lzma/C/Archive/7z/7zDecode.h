@@ -17,4 +17,16 @@ SZ_RESULT SzDecode(const CFileSize *packSizes, const CFolder *folder,
     #endif
     Byte *outBuffer, size_t outSize, ISzAlloc *allocMain);
 
+/* BEGIN PHYSFS CHANGE */
+/* In 7zDecodeLzma2.c, apart from LzmaDecode.h, whose types clash with the
+   state decoder's that LZMA2 is built on. */
+SZ_RESULT SzDecodeLzma2(CCoderInfo *coder, CFileSize inSize,
+    #ifdef _LZMA_IN_CB
+    ISzInStream *inStream,
+    #else
+    const Byte *inBuffer,
+    #endif
+    Byte *outBuffer, size_t outSize, ISzAlloc *allocMain);
+/* END PHYSFS CHANGE */
+
 #endif
@@ -0,0 +1,83 @@
+/* 7zDecodeLzma2.c */
+
+/* BEGIN PHYSFS CHANGE */
+/* This file isn't part of LZMA SDK 4.57; it was added for PhysicsFS. */
+
+#include "7zDecode.h"
+#ifdef _SZ_ONE_DIRECTORY
+#include "Lzma2StateDecode.h"
+#else
+#include "../../Compress/Lzma/Lzma2StateDecode.h"
+#endif
+
+SZ_RESULT SzDecodeLzma2(CCoderInfo *coder, CFileSize inSize,
+    #ifdef _LZMA_IN_CB
+    ISzInStream *inStream,
+    #else
+    const Byte *inBuffer,
+    #endif
+    Byte *outBuffer, size_t outSize, ISzAlloc *allocMain)
+{
+  CLzma2DecoderState state;
+  SizeT outSizeProcessed = 0;
+  UInt32 dictionarySize;
+  int result;
+
+  if (Lzma2DecodeProperties(&dictionarySize, coder->Properties.Items,
+      (int)coder->Properties.Capacity) != LZMA_RESULT_OK)
+    return SZE_FAIL;
+
+  state.Lzma.Probs = (CProb *)allocMain->Alloc(Lzma2GetNumProbs() * sizeof(CProb));
+  if (state.Lzma.Probs == 0)
+    return SZE_OUTOFMEMORY;
+
+  /* The whole output is here, so it's all the dictionary there is. */
+  state.Lzma.Dictionary = outBuffer;
+  state.Lzma.Properties.DictionarySize = (UInt32)outSize;
+  Lzma2DecoderInit(&state);
+
+  #ifdef _LZMA_IN_CB
+  result = LZMA_RESULT_OK;
+  while (result == LZMA_RESULT_OK)
+  {
+    const void *inBuffer;
+    size_t processedSize, curSize = (1 << 18);
+    SizeT inProcessed, outProcessed;
+    if (curSize > inSize)
+      curSize = (size_t)inSize;
+    if (inStream->Read((void *)inStream, (void **)&inBuffer, curSize, &processedSize) != SZ_OK ||
+        processedSize > curSize)
+    {
+      allocMain->Free(state.Lzma.Probs);
+      return SZE_FAIL;
+    }
+    inSize -= processedSize;
+    while (result == LZMA_RESULT_OK)
+    {
+      result = Lzma2Decode(&state, (const unsigned char *)inBuffer, processedSize, &inProcessed,
+          outBuffer + outSizeProcessed, outSize - outSizeProcessed, &outProcessed);
+      inBuffer = (const Byte *)inBuffer + inProcessed;
+      processedSize -= inProcessed;
+      outSizeProcessed += outProcessed;
+      if (inProcessed == 0 && outProcessed == 0)
+        break;
+    }
+    if (processedSize != 0 || inSize == 0)
+      break;
+  }
+  #else
+  {
+    SizeT inProcessed;
+    result = Lzma2Decode(&state, inBuffer, (SizeT)inSize, &inProcessed,
+        outBuffer, (SizeT)outSize, &outSizeProcessed);
+  }
+  #endif
+
+  allocMain->Free(state.Lzma.Probs);
+  if (result == LZMA_RESULT_DATA_ERROR)
+    return SZE_DATA_ERROR;
+  if (result != LZMA_RESULT_OK)
+    return SZE_FAIL;
+  return (outSizeProcessed == outSize) ? SZ_OK : SZE_DATA_ERROR;
+}
+/* END PHYSFS CHANGE */
@@ -0,0 +1,228 @@
+/*
+  Lzma2StateDecode.c
+  LZMA2 Decoder (State version)
+
+  This file isn't part of LZMA SDK 4.57; it was added for PhysicsFS, on
+  top of LzmaStateDecode.c, and is distributed under the same terms.
+*/
+
+#include "Lzma2StateDecode.h"
+
+#define LZMA2_STATE_UNPACK0 1
+#define LZMA2_STATE_UNPACK1 2
+#define LZMA2_STATE_PACK0 3
+#define LZMA2_STATE_PACK1 4
+#define LZMA2_STATE_PROP 5
+#define LZMA2_STATE_DATA 6
+#define LZMA2_STATE_SKIP 7
+#define LZMA2_STATE_FINISHED 8
+
+#define LZMA2_CONTROL_COPY_RESET_DIC 1
+#define LZMA2_CONTROL_COPY 2
+#define LZMA2_CONTROL_LZMA 0x80
+
+#define LZMA2_IS_COPY(vs) ((vs)->Control < LZMA2_CONTROL_LZMA)
+#define LZMA2_GET_MODE(vs) (((vs)->Control >> 5) & 3)
+
+int Lzma2DecodeProperties(UInt32 *dictionarySize, const unsigned char *propsData, int size)
+{
+  unsigned char prop;
+  if (size < LZMA2_PROPERTIES_SIZE)
+    return LZMA_RESULT_DATA_ERROR;
+  prop = propsData[0];
+  if (prop > 40)
+    return LZMA_RESULT_DATA_ERROR;
+  if (prop == 40)
+    *dictionarySize = 0xFFFFFFFF;
+  else
+    *dictionarySize = (UInt32)(2 | (prop & 1)) << (prop / 2 + 11);
+  return LZMA_RESULT_OK;
+}
+
+static void Lzma2ResetDictionary(CLzma2DecoderState *vs)
+{
+  /* DictionaryPos stays put, in case the dictionary is the output buffer. */
+  vs->Lzma.GlobalPos = 0;
+  vs->Lzma.DistanceLimit = 0;
+}
+
+static int Lzma2StartChunk(CLzma2DecoderState *vs)
+{
+  int mode = LZMA2_GET_MODE(vs);
+  if (mode == 3)
+    Lzma2ResetDictionary(vs);
+  LzmaDecoderInitChunk(&vs->Lzma, mode != 0);
+  return LZMA2_STATE_DATA;
+}
+
+/* Returns the state after header byte b, or -1 if b is no good there. */
+static int Lzma2UpdateState(CLzma2DecoderState *vs, unsigned char b)
+{
+  switch (vs->State)
+  {
+    case LZMA2_STATE_CONTROL:
+      vs->Control = b;
+      if (b == 0)
+        return LZMA2_STATE_FINISHED;
+      if (LZMA2_IS_COPY(vs))
+      {
+        if (b == LZMA2_CONTROL_COPY_RESET_DIC)
+        {
+          Lzma2ResetDictionary(vs);
+          vs->NeedInitLevel = 0xC0;
+        }
+        else if (b > LZMA2_CONTROL_COPY || vs->NeedInitLevel == 0xE0)
+          return -1;
+        vs->UnpackSize = 0;
+      }
+      else
+      {
+        if (b < vs->NeedInitLevel)
+          return -1;
+        vs->NeedInitLevel = 0;
+        vs->UnpackSize = (UInt32)(b & 0x1F) << 16;
+      }
+      return LZMA2_STATE_UNPACK0;
+
+    case LZMA2_STATE_UNPACK0:
+      vs->UnpackSize |= (UInt32)b << 8;
+      return LZMA2_STATE_UNPACK1;
+
+    case LZMA2_STATE_UNPACK1:
+      vs->UnpackSize |= (UInt32)b;
+      vs->UnpackSize++;
+      if (LZMA2_IS_COPY(vs))
+      {
+        vs->PackSize = vs->UnpackSize;
+        return LZMA2_STATE_DATA;
+      }
+      return LZMA2_STATE_PACK0;
+
+    case LZMA2_STATE_PACK0:
+      vs->PackSize = (UInt32)b << 8;
+      return LZMA2_STATE_PACK1;
+
+    case LZMA2_STATE_PACK1:
+      vs->PackSize |= (UInt32)b;
+      vs->PackSize++;
+      if (LZMA2_GET_MODE(vs) >= 2)
+        return LZMA2_STATE_PROP;
+      return Lzma2StartChunk(vs);
+
+    case LZMA2_STATE_PROP:
+    {
+      CLzmaProperties *props = &vs->Lzma.Properties;
+      if (b >= (9 * 5 * 5))
+        return -1;
+      props->lc = b % 9;
+      b /= 9;
+      props->lp = b % 5;
+      props->pb = b / 5;
+      if (props->lc + props->lp > LZMA2_LCLP_MAX)
+        return -1;
+      return Lzma2StartChunk(vs);
+    }
+  }
+  return -1;
+}
+
+static void Lzma2CopyToDictionary(CLzmaDecoderState *vs, const unsigned char *data, SizeT size)
+{
+  UInt32 dictionarySize = vs->Properties.DictionarySize;
+  UInt32 dictionaryPos = vs->DictionaryPos;
+  vs->GlobalPos += (UInt32)size;
+  if (dictionarySize - vs->DistanceLimit > size)
+    vs->DistanceLimit += (UInt32)size;
+  else
+    vs->DistanceLimit = dictionarySize;
+  while (size-- != 0)
+  {
+    vs->Dictionary[dictionaryPos] = *data++;
+    if (++dictionaryPos == dictionarySize)
+      dictionaryPos = 0;
+  }
+  vs->DictionaryPos = dictionaryPos;
+}
+
+int Lzma2Decode(CLzma2DecoderState *vs,
+    const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
+    unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
+{
+  (*inSizeProcessed) = 0;
+  (*outSizeProcessed) = 0;
+
+  for (;;)
+  {
+    if (vs->State == LZMA2_STATE_FINISHED)
+      break;
+
+    if (vs->State == LZMA2_STATE_DATA)
+    {
+      SizeT inCur = inSize, outCur = outSize;
+      SizeT inDone, outDone;
+      if (inCur > vs->PackSize)
+        inCur = vs->PackSize;
+      if (outCur > vs->UnpackSize)
+        outCur = vs->UnpackSize;
+
+      if (LZMA2_IS_COPY(vs))
+      {
+        SizeT i;
+        inDone = outDone = (inCur < outCur) ? inCur : outCur;
+        for (i = 0; i < outDone; i++)
+          outStream[i] = inStream[i];
+        Lzma2CopyToDictionary(&vs->Lzma, outStream, outDone);
+      }
+      else
+      {
+        int res = LzmaDecode(&vs->Lzma, inStream, inCur, &inDone,
+            outStream, outCur, &outDone, inCur == vs->PackSize);
+        if (res != LZMA_RESULT_OK)
+          return res;
+      }
+
+      inStream += inDone;
+      inSize -= inDone;
+      (*inSizeProcessed) += inDone;
+      outStream += outDone;
+      outSize -= outDone;
+      (*outSizeProcessed) += outDone;
+      vs->PackSize -= (UInt32)inDone;
+      vs->UnpackSize -= (UInt32)outDone;
+
+      if (vs->UnpackSize == 0)
+        vs->State = (vs->PackSize == 0) ? LZMA2_STATE_CONTROL : LZMA2_STATE_SKIP;
+      else if (inDone == 0 && outDone == 0)
+      {
+        /* all of the chunk was there, with room to spare, and it's short? */
+        if (outCur != 0 && inCur == vs->PackSize)
+          return LZMA_RESULT_DATA_ERROR;
+        break;
+      }
+      continue;
+    }
+
+    if (inSize == 0)
+      break;
+
+    if (vs->State == LZMA2_STATE_SKIP)
+    {
+      /* what the range coder didn't need of an LZMA chunk's end. */
+      SizeT inCur = (inSize > vs->PackSize) ? vs->PackSize : inSize;
+      inStream += inCur;
+      inSize -= inCur;
+      (*inSizeProcessed) += inCur;
+      vs->PackSize -= (UInt32)inCur;
+      if (vs->PackSize == 0)
+        vs->State = LZMA2_STATE_CONTROL;
+      continue;
+    }
+
+    vs->State = Lzma2UpdateState(vs, *inStream++);
+    inSize--;
+    (*inSizeProcessed)++;
+    if (vs->State < 0)
+      return LZMA_RESULT_DATA_ERROR;
+  }
+  return LZMA_RESULT_OK;
+}
@@ -0,0 +1,54 @@
+/*
+  Lzma2StateDecode.h
+  LZMA2 Decoder interface (State version)
+
+  This file isn't part of LZMA SDK 4.57; it was added for PhysicsFS, on
+  top of LzmaStateDecode.c, and is distributed under the same terms.
+
+  LZMA2 splits a stream into chunks, each either stored or LZMA with a
+  fresh range coder, that may reset the state, properties and dictionary.
+*/
+
+#ifndef __LZMA2STATEDECODE_H
+#define __LZMA2STATEDECODE_H
+
+#include "LzmaStateDecode.h"
+
+#define LZMA2_PROPERTIES_SIZE 1
+
+/* LZMA2 never uses more literal context than this (lc + lp). */
+#define LZMA2_LCLP_MAX 4
+
+#define Lzma2GetNumProbs() (LZMA_BASE_SIZE + (LZMA_LIT_SIZE << LZMA2_LCLP_MAX))
+
+typedef struct _CLzma2DecoderState
+{
+  CLzmaDecoderState Lzma;
+  UInt32 PackSize;    /* bytes of current chunk still to be read */
+  UInt32 UnpackSize;  /* bytes of current chunk still to be written */
+  int State;
+  int Control;        /* first byte of current chunk */
+  int NeedInitLevel;  /* lowest control byte current chunk may have */
+} CLzma2DecoderState;
+
+int Lzma2DecodeProperties(UInt32 *dictionarySize, const unsigned char *propsData, int size);
+
+#define LZMA2_STATE_CONTROL 0
+
+/* Probs, Dictionary and Properties.DictionarySize are set by caller. */
+#define Lzma2DecoderInit(vs) { LzmaDecoderInit(&(vs)->Lzma); \
+  (vs)->Lzma.DictionaryPos = (vs)->Lzma.GlobalPos = (vs)->Lzma.DistanceLimit = 0; \
+  (vs)->State = LZMA2_STATE_CONTROL; (vs)->NeedInitLevel = 0xE0; }
+
+/* Lzma2Decode: decoding from input stream to output stream, like
+  LzmaDecode, except chunks say where they end, so there's no need to say
+  where the input does. If nothing was processed with input and output
+  to spare, then the stream is finished or broken. The dictionary may be
+  outStream itself, if it's as big as the whole output and outStream moves
+  along it. */
+
+int Lzma2Decode(CLzma2DecoderState *vs,
+    const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
+    unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed);
+
+#endif
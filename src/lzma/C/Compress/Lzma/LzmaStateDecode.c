@@ -184,7 +184,10 @@ int LzmaDecode(
     tempDictionary[0] = vs->TempDictionary[0];
   }
 
-  if (len == kLzmaNeedInitId)
+  /* BEGIN PHYSFS CHANGE */
+  if (len == kLzmaNeedInitId || len == kLzmaNeedInitStateId ||
+      len == kLzmaNeedInitRangeId)
+  /* END PHYSFS CHANGE */
   {
     while (inSize > 0 && BufferSize < kLzmaInBufferSize)
     {
@@ -197,6 +200,9 @@ int LzmaDecode(
       vs->BufferSize = BufferSize;
       return finishDecoding ? LZMA_RESULT_DATA_ERROR : LZMA_RESULT_OK;
     }
+    /* BEGIN PHYSFS CHANGE */
+    if (len != kLzmaNeedInitRangeId)
+    /* END PHYSFS CHANGE */
     {
       UInt32 numProbs = Literal + ((UInt32)LZMA_LIT_SIZE << (lc + vs->Properties.lp));
       UInt32 i;
@@ -204,12 +210,17 @@ int LzmaDecode(
         p[i] = kBitModelTotal >> 1; 
       rep0 = rep1 = rep2 = rep3 = 1;
       state = 0;
-      globalPos = 0;
-      distanceLimit = 0;
-      dictionaryPos = 0;
-      dictionary[dictionarySize - 1] = 0;
-      RC_INIT;
+      /* BEGIN PHYSFS CHANGE */
+      if (len == kLzmaNeedInitId)
+      {
+        globalPos = 0;
+        distanceLimit = 0;
+        dictionaryPos = 0;
+        dictionary[dictionarySize - 1] = 0;
+      }
     }
+    RC_INIT;
+    /* END PHYSFS CHANGE */
     len = 0;
   }
   while(len != 0 && nowPos < outSize)
@@ -226,6 +237,11 @@ int LzmaDecode(
     previousByte = dictionary[dictionarySize - 1];
   else
     previousByte = dictionary[dictionaryPos - 1];
+  /* BEGIN PHYSFS CHANGE */
+  /* Nothing came before, even if the dictionary was reset mid-buffer. */
+  if (distanceLimit == 0)
+    previousByte = 0;
+  /* END PHYSFS CHANGE */
 
   for (;;)
   {
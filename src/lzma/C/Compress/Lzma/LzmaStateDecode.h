@@ -24,6 +24,12 @@
 
 #include "LzmaTypes.h"
 
+/* BEGIN PHYSFS CHANGE */
+/* LzmaDecode.c is built in too, so don't clash with its functions. */
+#define LzmaDecodeProperties LzmaStateDecodeProperties
+#define LzmaDecode LzmaStateDecode
+/* END PHYSFS CHANGE */
+
 /* #define _LZMA_PROB32 */
 /* It can increase speed on some 32-bit CPUs, 
    but memory usage will be doubled in that case */
@@ -84,6 +90,17 @@ typedef struct _CLzmaDecoderState
 
 #define LzmaDecoderInit(vs) { (vs)->RemainLen = kLzmaNeedInitId; (vs)->BufferSize = 0; }
 
+/* BEGIN PHYSFS CHANGE */
+/* For LZMA2 (see Lzma2StateDecode.h), whose chunks each start a new range
+   coder, and may reset the state (probabilities, reps) with it, while the
+   dictionary carries on. */
+#define kLzmaNeedInitStateId (-3)
+#define kLzmaNeedInitRangeId (-4)
+
+#define LzmaDecoderInitChunk(vs, initState) { (vs)->RemainLen = \
+  (initState) ? kLzmaNeedInitStateId : kLzmaNeedInitRangeId; (vs)->BufferSize = 0; }
+/* END PHYSFS CHANGE */
+
 /* LzmaDecode: decoding from input stream to output stream.
   If finishDecoding != 0, then there are no more bytes in input stream
   after inStream[inSize - 1]. */
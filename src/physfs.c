@@ -11,9 +11,150 @@
 /* !!! FIXME: ERR_PAST_EOF shouldn't trigger for reads. Just return zero. */
 /* !!! FIXME: use snprintf(), not sprintf(). */
 
+/* before physfs_internal.h, which poisons malloc(); <mm_malloc.h> uses it. */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PHYSFS_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+#define PHYSFS_HAVE_ARM_CRC32 1
+#include <arm_acle.h>
+#endif
+
 #define __PHYSICSFS_INTERNAL__
 #include "physfs_internal.h"
 
+#include <stddef.h>
+#include <time.h>
+
+
+/* A directory verifyPath() found no symlinks in, so it needn't look again. */
+#define VERIFY_CACHE_SLOTS 16  /* must be a power of two. */
+typedef struct
+{
+    char *path;  /* archive path of the directory, or NULL. */
+    PHYSFS_uint32 hash;
+    int generation;  /* searchGeneration from before it was checked. */
+    time_t when;  /* when it was checked, for native directories. */
+} VerifiedDir;
+
+
+/* A native directory's listing, kept so it needn't be read again. */
+#define LISTING_CACHE_SLOTS 16  /* must be a power of two. */
+typedef struct
+{
+    PHYSFS_uint32 refcount;  /* the cache slot holds one; each reader too. */
+    PHYSFS_uint32 count;  /* entries in stats and names. */
+    PHYSFS_Stat *stats;  /* points just past this struct. */
+    char *names;  /* (count) null-terminated names in a row, after stats. */
+} DirListing;
+
+typedef struct
+{
+    char *path;  /* archive path of the directory, or NULL. */
+    PHYSFS_uint32 hash;
+    int generation;  /* searchGeneration from before it was read. */
+    time_t when;  /* when it was read. */
+    DirListing *listing;  /* NULL if this slot is empty. */
+} CachedListing;
+
+
+/* A native file's read handle, kept after closing so it needn't reopen. */
+#define HANDLE_CACHE_SLOTS 8  /* most recently closed first. */
+typedef struct
+{
+    char *path;  /* archive path of the file, or NULL. */
+    PHYSFS_uint32 hash;
+    int generation;  /* searchGeneration from before it was opened. */
+    time_t when;  /* when it was opened. */
+    PHYSFS_Io *io;  /* rewound, with no hint left on it; NULL if empty. */
+} CachedHandle;
+
+
+/* A native path's metadata, kept so it needn't be looked up again. */
+#define STAT_CACHE_SLOTS 256  /* must be a power of two. */
+typedef struct
+{
+    char *path;  /* archive path, or NULL if this slot is empty. */
+    PHYSFS_uint32 hash;
+    int generation;  /* searchGeneration from before it was looked up. */
+    time_t when;  /* when it was looked up. */
+    int found;  /* zero if it wasn't there; (stat) means nothing then. */
+    PHYSFS_Stat stat;
+} CachedStat;
+
+
+/*
+ * Archives mounted by path are shared by every mount of the same file, in
+ *  one context or several, so each one's directory is only parsed and held
+ *  in memory once. Files are matched by path, size and modification time,
+ *  so a file that's been replaced since is opened fresh. The archive is
+ *  closed when the last DirHandle using it goes away.
+ */
+typedef struct __PHYSFS_SHAREDARCHIVE__
+{
+    char *path;  /* as it was mounted. */
+    PHYSFS_sint64 size;
+    PHYSFS_sint64 modtime;
+    void *opaque;
+    const PHYSFS_Archiver *funcs;
+    const PHYSFS_Archiver *realFuncs;
+    int reentrant;
+    int indexMode;
+    __PHYSFS_MemAccount *mem;
+    PHYSFS_uint32 refcount;  /* DirHandles using it. Under sharedLock. */
+    struct __PHYSFS_SHAREDARCHIVE__ *next;
+} SharedArchive;
+
+
+/* PHYSFS_createRamDir() names, and the RAM dirs (from archiver_ram.c). */
+typedef struct __PHYSFS_RAMDIR__
+{
+    char *name;
+    void *fs;
+    struct __PHYSFS_RAMDIR__ *next;
+} RamDir;
+
+
+/*
+ * PHYSFS_setMountRoutes() prefixes: sanitized virtual paths, with lengths.
+ *  Lookups read these without a lock, so one that's replaced is kept (on
+ *  (prev)) until its DirHandle is freed. It's all one allocation.
+ */
+typedef struct __PHYSFS_MOUNTROUTE__
+{
+    const char *path;
+    size_t len;
+} MountRoute;
+
+typedef struct __PHYSFS_MOUNTROUTES__
+{
+    MountRoute *include;  /* none means everything. */
+    size_t numInclude;
+    MountRoute *exclude;
+    size_t numExclude;
+    size_t size;  /* of the whole allocation, for copyMountRoutes(). */
+    struct __PHYSFS_MOUNTROUTES__ *prev;  /* what this replaced, if any. */
+} MountRoutes;
+
+
+/*
+ * A file PHYSFS_pin() read into memory. Each DirHandle has a list of the
+ *  ones it served, changed and searched under pinLock. (io) is a memoryIo
+ *  over the contents; opens get duplicates of it, so the memory lasts
+ *  until the last of those is closed, pinned or not.
+ */
+typedef struct __PHYSFS_PINNEDFILE__
+{
+    char *path;  /* Virtual path, sanitized. Allocated with this struct. */
+    char *arcfname;  /* Path in the archive. Same allocation. */
+    PHYSFS_uint32 hash;  /* hashIndexPath(arcfname). */
+    PHYSFS_Io *io;
+    struct __PHYSFS_PINNEDFILE__ *next;
+} PinnedFile;
+
 
 typedef struct __PHYSFS_DIRHANDLE__
 {
@@ -21,42 +162,209 @@ typedef struct __PHYSFS_DIRHANDLE__
     char *dirName;  /* Path to archive in platform-dependent notation. */
     char *mountPoint; /* Mountpoint in virtual file tree. */
     const PHYSFS_Archiver *funcs;  /* Ptr to archiver info for this handle. */
+    const PHYSFS_Archiver *realFuncs;  /* Behind a snapshot, or NULL. */
+    PHYSFS_Context *ctx;  /* Context whose search path or write dir it's in. */
+    int reentrant;  /* Non-zero if funcs can be called without stateLock. */
+    int native;  /* Non-zero if this is a real directory, not an archive. */
+    void *verifyLock;  /* protects verified, listings. NULL if no caches. */
+    VerifiedDir verified[VERIFY_CACHE_SLOTS];  /* verifyPath() cache. */
+    CachedListing listings[LISTING_CACHE_SLOTS];  /* native dirs only. */
+    CachedHandle handles[HANDLE_CACHE_SLOTS];  /* same; under verifyLock. */
+    CachedStat * volatile stats;  /* STAT_CACHE_SLOTS, or NULL. Same lock. */
+    volatile int statTime;  /* PHYSFS_setMountStatCacheTime(). */
+    int indexMode;  /* INDEX_* value: how this goes in the search index. */
+    int accessHint;  /* PHYSFS_setMountAccessHint(), for each openRead. */
+    char *indexNames;  /* Every path it holds, '\0'-separated, or NULL. */
+    size_t indexCount;  /* Number of strings in indexNames. */
+    size_t indexNamesLen;  /* Bytes in indexNames, for accounting. */
+    __PHYSFS_MemAccount *mem;  /* What it's using, by category. */
+    SharedArchive *shared;  /* Where (opaque) came from, or NULL if ours. */
+    MountRoutes * volatile routes;  /* Paths lookups try it for, or NULL. */
+    PinnedFile * volatile pins;  /* PHYSFS_pin()'d files, or NULL. */
+    int retiredEpoch;  /* searchPathEpoch when this handle was retired. */
+    PHYSFS_uint32 openFiles;  /* FileHandles open on it. Under ctx->lock. */
+    PHYSFS_uint32 serial;  /* Unique to this mount, for PHYSFS_Entry. */
+    struct __PHYSFS_DIRHANDLE__ *retiredNext;  /* retired list stuff. */
     struct __PHYSFS_DIRHANDLE__ *next;  /* linked list stuff. */
 } DirHandle;
 
 
+/* How (and whether) a DirHandle's contents go in the search path index. */
+#define INDEX_NONE 0          /* not indexed; always ask the archiver.  */
+#define INDEX_EXACT 1         /* archiver matches names exactly.        */
+#define INDEX_NOCASE_ASCII 2  /* archiver ignores low-ASCII case.       */
+
+
+typedef struct __PHYSFS_SEARCHINDEXSLOT__
+{
+    const char *path;  /* Virtual path, owned by a DirHandle. NULL if empty. */
+    PHYSFS_uint32 hash;  /* Case-folded hash of path. */
+    PHYSFS_uint32 rank;  /* Position in SearchIndex::handles. */
+} SearchIndexSlot;
+
+
+/*
+ * Every mount point, and every directory above one, gets one of these in
+ *  a SearchIndex, so a lookup only has to try archives mounted where they
+ *  could have its path, instead of the whole search path.
+ */
+typedef struct __PHYSFS_MOUNTNODE__
+{
+    const char *path;  /* A DirHandle's mountPoint, or "". NULL if unused. */
+    size_t pathlen;  /* Just this much of (path) is this dir's name. */
+    PHYSFS_uint32 hash;  /* hashIndexPath() of that much of it. */
+    PHYSFS_uint32 parent;  /* Slot of the dir above this one. */
+    PHYSFS_uint32 numAbove;  /* Length of above. */
+    PHYSFS_uint32 numAll;  /* Length of all. */
+    PHYSFS_uint32 *above;  /* Ranks mounted here or above, in order. */
+    PHYSFS_uint32 *all;  /* Those, plus ranks mounted anywhere under here. */
+} MountNode;
+
+
+/*
+ * An immutable snapshot of the search path, with its mount points, plus
+ *  (if enabled) a hash of every path in the indexed archives, pointing at
+ *  the first archive that has it. A new one replaces this on every mount
+ *  or unmount.
+ */
+typedef struct __PHYSFS_SEARCHINDEX__
+{
+    size_t numHandles;  /* Length of handles and indexed. */
+    DirHandle **handles;  /* Everything in the search path, in order. */
+    PHYSFS_uint8 *indexed;  /* Non-zero if handles[i] is in slots. */
+    size_t numSlots;  /* Always a power of two. Zero if not indexing. */
+    SearchIndexSlot *slots;  /* Open-addressed hash table. */
+    size_t numMountSlots;  /* Always a power of two. */
+    MountNode *mountSlots;  /* Open-addressed hash table. */
+    PHYSFS_uint32 rootMountSlot;  /* mountSlots[] entry for "". */
+    PHYSFS_uint32 *mountRanks;  /* What MountNode::above and all point to. */
+    int retiredEpoch;  /* searchPathEpoch when this index was retired. */
+    struct __PHYSFS_SEARCHINDEX__ *retiredNext;  /* retired list stuff. */
+} SearchIndex;
+
+
 typedef struct __PHYSFS_FILEHANDLE__
 {
     PHYSFS_Io *io;  /* Instance data unique to the archiver for this file. */
     PHYSFS_uint8 forReading; /* Non-zero if reading, zero if write/append */
     const DirHandle *dirHandle;  /* Archiver instance that created this */
     PHYSFS_uint8 *buffer;  /* Buffer, if set (NULL otherwise). Don't touch! */
-    PHYSFS_uint32 bufsize;  /* Bufsize, if set (0 otherwise). Don't touch! */
-    PHYSFS_uint32 buffill;  /* Buffer fill size. Don't touch! */
-    PHYSFS_uint32 bufpos;  /* Buffer position. Don't touch! */
+    PHYSFS_uint64 bufsize;  /* Bufsize, if set (0 otherwise). Don't touch! */
+    PHYSFS_uint64 buffill;  /* Buffer fill size. Don't touch! */
+    PHYSFS_uint64 bufpos;  /* Buffer position. Don't touch! */
+    PHYSFS_uint64 bufmax;  /* Adaptive buffer's cap; 0 if not adaptive. */
+    PHYSFS_uint64 readahead;  /* Adaptive: bytes to read at next refill. */
+    PHYSFS_uint8 sequential;  /* Adaptive: no seek since the last refill. */
+    struct __PHYSFS_READAHEAD__ *ahead;  /* Background refill, or NULL. */
+    struct __PHYSFS_WRITEBEHIND__ *behind;  /* Background flush, or NULL. */
+    struct __PHYSFS_ATOMICWRITE__ *atomic;  /* Renamed on close, or NULL. */
+    struct __PHYSFS_PROFILEFILE__ *profile;  /* Access record, or NULL. */
+    char *tracePath;  /* Path for trace events, if tracing when opened. */
+    CachedHandle keep;  /* Where io is kept when closed, if keep.path. */
+    struct __PHYSFS_FILEHANDLE__ **list;  /* open list it's in, or NULL. */
+    struct __PHYSFS_FILEHANDLE__ *prev;  /* linked list stuff. */
     struct __PHYSFS_FILEHANDLE__ *next;  /* linked list stuff. */
 } FileHandle;
 
 
+/* A file from PHYSFS_openWriteAtomic(), written under a temporary name. */
+typedef struct __PHYSFS_ATOMICWRITE__
+{
+    char *tmpname;  /* what's being written, in the write dir. */
+    char *fname;  /* what it's renamed to when it's done. */
+    int flags;  /* PHYSFS_AtomicWriteFlags */
+    int failed;  /* non-zero if a commit gave up on this one. */
+    const DirHandle *dirHandle;  /* the write dir it's in. */
+    struct __PHYSFS_ATOMICWRITE__ *next;  /* pending list stuff. */
+} AtomicWrite;
+
+
+/* Blocks __PHYSFS_poolAlloc() keeps per thread: 64, 128, ... 512 bytes. */
+#define POOL_GRANULARITY 64
+#define POOL_CLASSES 8
+#define POOL_MAX_SPARES 32  /* per class, per thread. */
+
+/* Each thread's state: its error code, and its spare pool blocks. */
 typedef struct __PHYSFS_ERRSTATETYPE__
 {
     void *tid;
     PHYSFS_ErrorCode code;
+    void *pool[POOL_CLASSES];  /* spare blocks, linked by first pointer. */
+    PHYSFS_uint32 pooled[POOL_CLASSES];  /* blocks in each pool list. */
+    struct __PHYSFS_LATENCYTABLE__ *latency;  /* NULL until timing starts. */
+    __PHYSFS_MemAccount *mounting;  /* __PHYSFS_memMountAccount(). */
+    PHYSFS_Context *context;  /* PHYSFS_setCurrentContext(), or NULL. */
     struct __PHYSFS_ERRSTATETYPE__ *next;
 } ErrState;
 
 
+/*
+ * Latency histograms are log-linear, like HdrHistogram: values under 8
+ *  get a bucket each, then every power of two is split in 8, so a bucket
+ *  is never more than an eighth of its value wide. Each thread keeps its
+ *  own, hanging off its ErrState; only that thread ever adds to them, and
+ *  PHYSFS_getLatency() adds them up. They're allocated on first use.
+ */
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+#define LATENCY_OPS 3  /* PHYSFS_LatencyOp values. */
+#define LATENCY_SLOTS 16  /* slot 0 is "no archiver"; the rest by ext. */
+
+typedef struct
+{
+    PHYSFS_uint64 max;
+    PHYSFS_uint64 buckets[LATENCY_BUCKETS];
+} LatencyHist;
+
+typedef struct __PHYSFS_LATENCYTABLE__
+{
+    LatencyHist * volatile hists[LATENCY_OPS][LATENCY_SLOTS];
+} LatencyTable;
+
+
 /* General PhysicsFS state ... */
 static int initialized = 0;
 static ErrState *errorStates = NULL;
-static DirHandle *searchPath = NULL;
-static DirHandle *writeDir = NULL;
-static FileHandle *openWriteList = NULL;
-static FileHandle *openReadList = NULL;
+static PHYSFS_uint32 atomicCounter = 0;  /* to make temp names unique. */
+static SharedArchive *sharedArchives = NULL;
+static RamDir * volatile ramDirs = NULL;
 static char *baseDir = NULL;
 static char *userDir = NULL;
 static char *prefDir = NULL;
-static int allowSymLinks = 0;
+static int nativeVerifyTime = 0;  /* seconds; 0 for never, -1 for forever. */
+static int nativeListingTime = 0;  /* same, for native dir listings. */
+static int nativeHandleTime = 0;  /* same, for closed native read handles. */
+static int useMissCache = 0;
+static int wantBatchIo = 0;  /* app asked for io_uring, etc. */
+static int batchIo = 0;  /* __PHYSFS_platformReadBatch() is worth using. */
+static PHYSFS_Inflater inflater;  /* from PHYSFS_setInflater(). */
+static int wantInflater = 0;  /* app set (inflater). */
+static int inflaterReady = 0;  /* (inflater) initialized and usable. */
+static PHYSFS_uint32 seekIndexInterval = 0;
+static PHYSFS_uint64 decompressionCacheSize = 0;
+static PHYSFS_uint64 readCoalesceGap = 64 * 1024;  /* see below. */
+static PHYSFS_uint64 readCoalesceMax = 8 * 1024 * 1024;
+static volatile int cacheHugePages = 0;  /* PHYSFS_setCacheHugePages(). */
+static PHYSFS_uint32 sectorCacheSize = 16;
+static PHYSFS_uint32 mountCacheBlockSize = 0;  /* PHYSFS_setMountBlockCache() */
+static PHYSFS_uint32 mountCacheBlocks = 0;  /* ...zero when it's disabled. */
+static int resolveOnMount = 0;
+static int fastDeinit = 0;  /* PHYSFS_setFastDeinit(). */
+static PHYSFS_uint64 nestedInflateLimit = 0;  /* PHYSFS_setNestedInflate(). */
+static PHYSFS_uint64 slurpLimit = 0;  /* PHYSFS_setSlurpOnOpen(). */
+static PHYSFS_uint32 mountMaxEntries = 0;  /* PHYSFS_setMountLimits()... */
+static PHYSFS_uint32 mountMaxPathDepth = 0;
+static PHYSFS_uint32 mountMaxSymlinkHops = 64;
+static PHYSFS_uint64 mountMaxIndexBytes = 0;
+static int deinitingFast = 0;  /* ...and a deinit is using it right now. */
+static int verifyChecksums = 0;
+static int writeCompression = 0;
+static char *indexCacheDir = NULL;  /* where index snapshots go, or NULL. */
+static char *spillCacheDir = NULL;  /* where decompressed data goes, or NULL. */
+static int spillPersist = 0;
+static PHYSFS_SubmitCallback executorSubmit = NULL;  /* or our own pool. */
+static void *executorData = NULL;
 static const PHYSFS_Archiver **archivers = NULL;
 static const PHYSFS_ArchiveInfo **archiveInfo = NULL;
 static volatile size_t numArchivers = 0;
@@ -64,28 +372,590 @@ static volatile size_t numArchivers = 0;
 /* mutexes ... */
 static void *errorLock = NULL;     /* protects error message list.        */
 static void *stateLock = NULL;     /* protects other PhysFS static state. */
+static void *contextLock = NULL;   /* protects the list of contexts.      */
+static void *sharedLock = NULL;    /* protects sharedArchives.            */
+static void *errorTls = NULL;      /* each thread's ErrState, if possible. */
+static void *asyncTls = NULL;      /* async request thread's servicing.  */
+static void *missCacheLock = NULL; /* protects missCache.                 */
+static void *blobCacheLock = NULL; /* protects the blob cache.            */
+static void *pinLock = NULL;       /* protects every DirHandle's pins.    */
+static void *scratchLock = NULL;   /* protects scratchPool.               */
+static void *ramLock = NULL;       /* protects ramDirs.                   */
+static void *watchLock = NULL;     /* protects nativeWatches, changeCb.   */
+static void *profileLock = NULL;   /* protects the access profile.        */
+static void *predictLock = NULL;   /* protects the prefetch predictor.    */
+static void *taskLock = NULL;      /* protects tasks and the task pool.   */
+static void *captureLock = NULL;   /* protects the trace capture.         */
+static void *cdromLock = NULL;     /* protects cdromCache; held to detect. */
+
+/* Archivers, by extension, that have latency slots; errorLock guards it. */
+static char * volatile latencyExts[LATENCY_SLOTS];
+static volatile int timingLatency = 0;
+
+/*
+ * Everything that goes with one search path. The API works on the calling
+ *  thread's current context (see currentContext()), which is usually
+ *  defaultContext; PHYSFS_createContext() makes more. A DirHandle knows
+ *  which context it's in, so files can be used and closed from any thread.
+ *
+ * Lookups walk the search path without holding (lock), so nothing that
+ *  changes it (which still holds (lock)) may free a DirHandle someone
+ *  could be looking at. Unmounting just unlinks the handle and puts it on
+ *  retiredDirHandles; it gets closed later, when every reader that might
+ *  have seen it is done and no open file refers to it. Readers register in
+ *  searchPathReaders[searchPathEpoch & 1]; see reclaimRetired().
+ *
+ * After PHYSFS_freeze(), nothing can change the search path or retire
+ *  anything, so readers skip searchPathReaders, and files opened for
+ *  reading skip openReadList (and the lock): they point at frozenReadList,
+ *  which stays empty, and are only counted in frozenOpenFiles.
+ *
+ * (lock) comes after contextLock and watchLock, and before stateLock, for
+ *  anything that needs more than one of them.
+ */
+struct PHYSFS_Context
+{
+    void *lock;  /* protects everything below that's changed. */
+    DirHandle *searchPath;
+    DirHandle *writeDir;
+    FileHandle *openWriteList;
+    FileHandle *openReadList;
+    FileHandle *frozenReadList;  /* always empty. */
+    AtomicWrite *atomicPending;  /* closed, but not committed. */
+    int allowSymLinks;
+    int useSearchIndex;
+    volatile int frozen;
+    volatile int frozenOpenFiles;
+    volatile int searchPathEpoch;
+    volatile int searchPathReaders[2];
+    DirHandle * volatile retiredDirHandles;
+    SearchIndex * volatile searchIndex;  /* NULL if no memory. */
+    SearchIndex * volatile retiredIndexes;
+    volatile int searchGeneration;  /* see MissCacheSlot. */
+    PHYSFS_Context *next;  /* every context, after defaultContext. */
+};
+
+static PHYSFS_Context defaultContext;
+static int usingContexts = 0;  /* a thread ever left defaultContext. */
+static volatile int dirHandleSerial = 0;  /* last DirHandle::serial. */
+static PHYSFS_uint32 hashSeed = 0;  /* for __PHYSFS_hashString(). */
+
+/*
+ * Paths that lookups recently failed to find. An entry only counts if its
+ *  generation matches its context's searchGeneration, which goes up after
+ *  anything that could make a missing path exist (mounting, writing, etc).
+ */
+#define MISS_CACHE_SLOTS 256  /* must be a power of two. */
+typedef struct
+{
+    char *path;  /* sanitized path that wasn't found, or NULL. */
+    PHYSFS_uint32 hash;
+    const PHYSFS_Context *ctx;
+    int generation;
+} MissCacheSlot;
+static MissCacheSlot missCache[MISS_CACHE_SLOTS];
+
+/*
+ * Decompressed files whose archives vouch for their content hash, shared by
+ *  every mounted archive, so two archives that ship the same file keep one
+ *  copy. Each blob is a memoryIo that open files hold duplicates of, so
+ *  evicting one that's still open just drops the cache's reference.
+ */
+#define BLOB_CACHE_SLOTS 256  /* must be a power of two. */
+typedef struct __PHYSFS_CACHEDBLOB__
+{
+    PHYSFS_uint8 hash[__PHYSFS_CONTENT_HASH_LEN];
+    PHYSFS_uint64 len;
+    PHYSFS_Io *io;  /* memoryIo we hand out dups of. */
+    struct __PHYSFS_CACHEDBLOB__ *chain;  /* next in its slot.              */
+    struct __PHYSFS_CACHEDBLOB__ *prev;   /* more recently used, or NULL.  */
+    struct __PHYSFS_CACHEDBLOB__ *next;   /* less recently used, or NULL.  */
+} CachedBlob;
+static CachedBlob *blobSlots[BLOB_CACHE_SLOTS];
+static CachedBlob *blobHead = NULL;
+static CachedBlob *blobTail = NULL;
+static PHYSFS_uint64 blobCacheUsed = 0;
+
+/*
+ * The access profile: every file opened for reading while profiling is on,
+ *  grouped by the DirHandle it came from, in the order they were first
+ *  opened, with the spans of them that were read. Reads that pick up where
+ *  the last one stopped just extend its span.
+ */
+typedef struct __PHYSFS_PROFILESPAN__
+{
+    PHYSFS_uint64 offset;
+    PHYSFS_uint64 len;
+    struct __PHYSFS_PROFILESPAN__ *next;
+} ProfileSpan;
+
+typedef struct __PHYSFS_PROFILEFILE__
+{
+    char *path;  /* path inside the archive. */
+    PHYSFS_uint32 hash;
+    PHYSFS_uint64 order;  /* when it was first opened, counting from 1. */
+    PHYSFS_uint64 opens;
+    PHYSFS_uint64 bytesRead;
+    struct __PHYSFS_PROFILEMOUNT__ *mount;
+    ProfileSpan *spans;  /* in the order they were read. */
+    ProfileSpan *lastSpan;
+    struct __PHYSFS_PROFILEFILE__ *hashNext;  /* profileHash chain. */
+    struct __PHYSFS_PROFILEFILE__ *next;  /* mount's list, in open order. */
+} ProfileFile;
+
+typedef struct __PHYSFS_PROFILEMOUNT__
+{
+    const DirHandle *dirHandle;  /* NULL once it's been freed. */
+    char *dirName;
+    char *mountPoint;
+    ProfileFile *files;
+    ProfileFile *lastFile;
+    struct __PHYSFS_PROFILEMOUNT__ *next;  /* in first-use order. */
+} ProfileMount;
+
+#define PROFILE_HASH_SLOTS 256  /* must be a power of two. */
+static volatile int profiling = 0;
+static PHYSFS_uint64 profileOrder = 0;
+static ProfileMount *profileMounts = NULL;
+static ProfileMount *lastProfileMount = NULL;
+static ProfileFile *profileHash[PROFILE_HASH_SLOTS];
+
+/*
+ * The prefetch predictor: for each file opened while it's on, the few files
+ *  opened right after it most often, and how often. Each node's successors
+ *  are kept most frequent first. See PHYSFS_enablePredictivePrefetch().
+ */
+#define PREDICT_HASH_SLOTS 1024  /* must be a power of two. */
+#define PREDICT_SUCCESSORS 4  /* most files remembered to follow each one. */
+#define PREDICT_RECENT 32  /* opens a prefetch is expected to be used in. */
+#define PREDICT_MIN_COUNT 2  /* times it has to have happened to predict. */
+#define PREDICT_MAX_LOOKAHEAD 16
+#define PREDICT_MAX_PENDING 32  /* prefetches queued at once, at most. */
+#define PREDICT_MAX_NODES 65536  /* past this, new files aren't learned. */
+
+typedef struct __PHYSFS_PREDICTNODE__
+{
+    char *path;  /* sanitized, as it was opened. */
+    PHYSFS_uint32 hash;
+    struct __PHYSFS_PREDICTNODE__ *next[PREDICT_SUCCESSORS];
+    PHYSFS_uint32 count[PREDICT_SUCCESSORS];
+    PHYSFS_uint32 prefetchedAt;  /* predictOpens when it was, or zero. */
+    struct __PHYSFS_PREDICTNODE__ *hashNext;  /* predictHash chain. */
+} PredictNode;
+
+static PHYSFS_AsyncQueue * volatile predictQueue = NULL;  /* NULL if off. */
+static PHYSFS_uint32 predictLookahead = 0;
+static PredictNode *predictHash[PREDICT_HASH_SLOTS];
+static PHYSFS_uint32 predictNodeCount = 0;
+static PredictNode *predictLast = NULL;  /* the last file opened. */
+static PHYSFS_uint32 predictOpens = 0;  /* files opened, never zero. */
+static volatile int predictPending = 0;  /* prefetches queued, not done. */
+
+#ifdef PHYSFS_NEED_ATOMIC_OP_FALLBACK
+int __PHYSFS_ATOMIC_INCR(volatile int *ptrval)
+{
+    int retval;
+    __PHYSFS_platformGrabMutex(stateLock);
+    retval = ++(*ptrval);
+    __PHYSFS_platformReleaseMutex(stateLock);
+    return retval;
+} /* __PHYSFS_ATOMIC_INCR */
+
+int __PHYSFS_ATOMIC_DECR(volatile int *ptrval)
+{
+    int retval;
+    __PHYSFS_platformGrabMutex(stateLock);
+    retval = --(*ptrval);
+    __PHYSFS_platformReleaseMutex(stateLock);
+    return retval;
+} /* __PHYSFS_ATOMIC_DECR */
+#endif
+
+PHYSFS_Stats __PHYSFS_stats;
+volatile int __PHYSFS_tracing = 0;
+static PHYSFS_TraceHooks traceHooks;
+
+/*
+ * PHYSFS_startTraceCapture()'s state; captureLock guards all of it. Each
+ *  thread that reports events gets a slot, where the events it's in the
+ *  middle of wait for their ends; its slot number is its number in the
+ *  capture. Slots are never reused, so threads past the last one all show
+ *  up as thread zero, with no durations.
+ */
+#define CAPTURE_THREADS 256
+#define CAPTURE_DEPTH 8
+typedef struct
+{
+    void *thread;
+    PHYSFS_uint32 depth;
+    PHYSFS_uint64 start[CAPTURE_DEPTH];
+    PHYSFS_sint64 bytes[CAPTURE_DEPTH];
+} CaptureThread;
+static volatile int capturing = 0;
+static void *captureFile = NULL;
+static int captureFailed = 0;
+static PHYSFS_uint64 captureStart = 0;
+static CaptureThread *captureThreads = NULL;
+static PHYSFS_uint32 captureThreadCount = 0;
+static char captureBuf[64 * 1024];
+static size_t captureLen = 0;
+
+/*
+ * Grab (lock), stateLock or a context's, counting how long we had to wait
+ *  for it. The clock is only read if someone else has the lock, so the
+ *  usual case costs nothing.
+ */
+static void grabLock(void *lock)
+{
+    PHYSFS_uint64 start;
+
+    if (__PHYSFS_platformTryGrabMutex(lock))
+        return;
+
+    start = __PHYSFS_platformGetTicks();
+    __PHYSFS_platformGrabMutex(lock);
+    __PHYSFS_STAT_INCR(stateLockWaits);
+    __PHYSFS_STAT_ADD(stateLockWaitNs, __PHYSFS_platformGetTicks() - start);
+} /* grabLock */
+
+
+static void grabStateLock(void)
+{
+    grabLock(stateLock);
+} /* grabStateLock */
+
+#if !PHYSFS_MINIMUM_GCC_VERSION(4, 1) && !defined(__clang__)
+void __PHYSFS_memoryBarrier(void)
+{
+    static volatile int dummy = 0;
+    __PHYSFS_ATOMIC_INCR(&dummy);  /* atomic ops are full barriers. */
+} /* __PHYSFS_memoryBarrier */
+#endif
 
 /* allocator ... */
 static int externalAllocator = 0;
 PHYSFS_Allocator allocator;
+static void *(*allocatorAlignedMalloc)(PHYSFS_uint64, PHYSFS_uint64) = NULL;
+static void (*allocatorFreeSized)(void *, PHYSFS_uint64) = NULL;
+
+/*
+ * File buffers are aligned, and freed with their size: fh->bufsize is
+ *  always the size of fh->buffer, and read-ahead and write-behind buffers
+ *  track theirs, too. They're charged to (acct), the file's mount.
+ */
+static PHYSFS_uint8 *allocFileBuffer(__PHYSFS_MemAccount *acct,
+                                     PHYSFS_uint64 len)
+{
+    void *retval = __PHYSFS_alignedMalloc((size_t) len, __PHYSFS_SIMD_ALIGN);
+    if (retval != NULL)
+        __PHYSFS_memCharge(acct, PHYSFS_MEMORY_BUFFERS, (PHYSFS_sint64) len);
+    return (PHYSFS_uint8 *) retval;
+} /* allocFileBuffer */
+
+
+static void freeFileBuffer(__PHYSFS_MemAccount *acct, PHYSFS_uint8 *buf,
+                           PHYSFS_uint64 len)
+{
+    if (buf != NULL)
+    {
+        __PHYSFS_alignedFree(buf, (size_t) len, __PHYSFS_SIMD_ALIGN);
+        __PHYSFS_memCharge(acct, PHYSFS_MEMORY_BUFFERS,
+                           -((PHYSFS_sint64) len));
+    } /* if */
+} /* freeFileBuffer */
+
+
+/* Replace (*buf) with (len) new bytes. Contents aren't kept. */
+static int resizeFileBuffer(__PHYSFS_MemAccount *acct, PHYSFS_uint8 **buf,
+                            PHYSFS_uint64 *size, PHYSFS_uint64 len)
+{
+    PHYSFS_uint8 *newbuf = allocFileBuffer(acct, len);
+    if (newbuf == NULL)
+        return 0;
+    freeFileBuffer(acct, *buf, *size);
+    *buf = newbuf;
+    *size = len;
+    return 1;
+} /* resizeFileBuffer */
+
+
+/* A zeroed FileHandle for a file open from (dh), or NULL on failure. */
+static FileHandle *allocFileHandle(const DirHandle *dh)
+{
+    FileHandle *retval = (FileHandle *) __PHYSFS_poolAlloc(sizeof (*retval));
+    if (retval != NULL)
+    {
+        memset(retval, '\0', sizeof (*retval));
+        retval->dirHandle = dh;
+        __PHYSFS_memCharge(dh->mem, PHYSFS_MEMORY_HANDLES,
+                           (PHYSFS_sint64) sizeof (*retval));
+    } /* if */
+    return retval;
+} /* allocFileHandle */
+
+
+static void freeFileHandle(FileHandle *fh)
+{
+    __PHYSFS_memCharge(fh->dirHandle->mem, PHYSFS_MEMORY_HANDLES,
+                       -((PHYSFS_sint64) sizeof (*fh)));
+    __PHYSFS_poolFree(fh, sizeof (*fh));
+} /* freeFileHandle */
+
+
+/*
+ * Put (fh) at the front of open list (*list), and count it against its
+ *  DirHandle. MAKE SURE you hold its context's lock before calling this!
+ */
+static void linkFileHandle(FileHandle **list, FileHandle *fh)
+{
+    fh->list = list;
+    fh->prev = NULL;
+    fh->next = *list;
+    if (*list != NULL)
+        (*list)->prev = fh;
+    *list = fh;
+    ((DirHandle *) fh->dirHandle)->openFiles++;
+} /* linkFileHandle */
+
+
+/* Undo linkFileHandle(). MAKE SURE you hold the context's lock, too. */
+static void unlinkFileHandle(FileHandle *fh)
+{
+    if (fh->prev != NULL)
+        fh->prev->next = fh->next;
+    else
+        *fh->list = fh->next;
+    if (fh->next != NULL)
+        fh->next->prev = fh->prev;
+    fh->list = NULL;
+    ((DirHandle *) fh->dirHandle)->openFiles--;
+} /* unlinkFileHandle */
 
 
 /* PHYSFS_Io implementation for i/o to physical filesystem... */
 
+/*
+ * PHYSFS_ACCESS_STREAM reads skip the OS cache through a buffer this big,
+ *  and only for files at least NATIVEIO_DIRECT_MIN bytes long; anything
+ *  smaller is better off in the cache with everything else.
+ */
+#define NATIVEIO_DIRECT_BUFSIZE (1024 * 1024)
+#define NATIVEIO_DIRECT_MIN (4 * 1024 * 1024)
+
 /* !!! FIXME: maybe refcount the paths in a string pool? */
 typedef struct __PHYSFS_NativeIoInfo
 {
     void *handle;
-    const char *path;
+    const char *path;  /* lives right after this struct. */
     int mode;   /* 'r', 'w', or 'a' */
+    PHYSFS_uint8 *directbuf;  /* non-NULL while reads skip the OS cache. */
+    PHYSFS_uint64 directpos;  /* file position; the OS's isn't kept up. */
+    PHYSFS_uint64 bufpos;  /* file offset of directbuf[0]... */
+    PHYSFS_uint64 buffill;  /* ...and how much of it is valid. */
 } NativeIoInfo;
 
+/*
+ * Read (len) bytes at (pos) from a file that skips the OS cache. Whatever
+ *  lines up goes straight into (ptr); the rest goes through (bounce),
+ *  which is aligned and (bouncelen) bytes, a multiple of the alignment.
+ *  This doesn't touch the NativeIoInfo, so any thread can do it.
+ */
+static PHYSFS_sint64 directReadAt(void *handle, PHYSFS_uint8 *bounce,
+                                  const PHYSFS_uint64 bouncelen,
+                                  PHYSFS_uint8 *ptr, PHYSFS_uint64 len,
+                                  PHYSFS_uint64 pos)
+{
+    const PHYSFS_uint64 align = __PHYSFS_DIRECT_IO_ALIGN;
+    PHYSFS_sint64 retval = 0;
+    int eof = 0;
+
+    while ((len > 0) && (!eof))
+    {
+        const PHYSFS_uint64 skew = pos % align;
+        PHYSFS_uint64 avail;
+        PHYSFS_sint64 rc;
+
+        if ((skew == 0) && (len >= align) && ((((size_t) ptr) % align) == 0))
+        {
+            const PHYSFS_uint64 want = len - (len % align);
+            rc = __PHYSFS_platformReadAt(handle, ptr, want, pos);
+            if (rc < 0)
+                return (retval == 0) ? -1 : retval;
+            avail = (PHYSFS_uint64) rc;
+            eof = (avail < want);
+        } /* if */
+
+        else
+        {
+            rc = __PHYSFS_platformReadAt(handle, bounce, bouncelen,
+                                         pos - skew);
+            if (rc < 0)
+                return (retval == 0) ? -1 : retval;
+            eof = (((PHYSFS_uint64) rc) < bouncelen);
+            avail = (((PHYSFS_uint64) rc) > skew) ? rc - skew : 0;
+            if (avail > len)
+            {
+                avail = len;
+                eof = 0;
+            } /* if */
+            memcpy(ptr, bounce + skew, (size_t) avail);
+        } /* else */
+
+        ptr += avail;
+        pos += avail;
+        len -= avail;
+        retval += (PHYSFS_sint64) avail;
+    } /* while */
+
+    return retval;
+} /* directReadAt */
+
+/* sequential reads that skip the OS cache, with directbuf as a window. */
+static PHYSFS_sint64 nativeIo_directRead(NativeIoInfo *info,
+                                         PHYSFS_uint8 *ptr, PHYSFS_uint64 len)
+{
+    PHYSFS_sint64 retval = 0;
+
+    while (len > 0)
+    {
+        const PHYSFS_uint64 off = info->directpos - info->bufpos;
+        PHYSFS_uint64 avail;
+        PHYSFS_sint64 rc;
+
+        if ((info->directpos >= info->bufpos) && (off < info->buffill))
+        {
+            avail = info->buffill - off;
+            if (avail > len)
+                avail = len;
+            memcpy(ptr, info->directbuf + off, (size_t) avail);
+        } /* if */
+
+        else if (len >= NATIVEIO_DIRECT_BUFSIZE)  /* big; skip the window. */
+        {
+            info->buffill = 0;  /* directReadAt() may scribble on it. */
+            rc = directReadAt(info->handle, info->directbuf,
+                              NATIVEIO_DIRECT_BUFSIZE, ptr, len,
+                              info->directpos);
+            if (rc < 0)
+                return (retval == 0) ? -1 : retval;
+            info->directpos += (PHYSFS_uint64) rc;
+            return retval + rc;
+        } /* else if */
+
+        else
+        {
+            info->bufpos = info->directpos -
+                           (info->directpos % __PHYSFS_DIRECT_IO_ALIGN);
+            info->buffill = 0;
+            rc = __PHYSFS_platformReadAt(info->handle, info->directbuf,
+                                         NATIVEIO_DIRECT_BUFSIZE,
+                                         info->bufpos);
+            if (rc < 0)
+                return (retval == 0) ? -1 : retval;
+            info->buffill = (PHYSFS_uint64) rc;
+            if (info->directpos - info->bufpos >= info->buffill)
+                break;  /* EOF. */
+            continue;
+        } /* else */
+
+        ptr += avail;
+        len -= avail;
+        info->directpos += avail;
+        retval += (PHYSFS_sint64) avail;
+    } /* while */
+
+    return retval;
+} /* nativeIo_directRead */
+
+static void chargeAsyncRead(const PHYSFS_uint64 bytes);
+
 static PHYSFS_sint64 nativeIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
 {
     NativeIoInfo *info = (NativeIoInfo *) io->opaque;
-    return __PHYSFS_platformRead(info->handle, buf, len);
+    PHYSFS_sint64 rc;
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    else if (info->directbuf != NULL)
+        rc = nativeIo_directRead(info, (PHYSFS_uint8 *) buf, len);
+    else
+        rc = __PHYSFS_platformRead(info->handle, buf, len);
+
+    if (rc > 0)
+    {
+        __PHYSFS_STAT_ADD(bytesReadPhysical, rc);
+        chargeAsyncRead((PHYSFS_uint64) rc);
+    } /* if */
+    return rc;
 } /* nativeIo_read */
 
+static PHYSFS_sint64 nativeIo_readAt(PHYSFS_Io *io, void *buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    PHYSFS_sint64 rc;
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    else if (info->directbuf == NULL)
+        rc = __PHYSFS_platformReadAt(info->handle, buf, len, pos);
+    else
+    {
+        /* other threads may be reading, so directbuf is off limits. */
+        const PHYSFS_uint64 align = __PHYSFS_DIRECT_IO_ALIGN;
+        PHYSFS_uint64 bouncelen = len - (len % align) + (2 * align);
+        PHYSFS_uint8 *bounce;
+
+        if (bouncelen > NATIVEIO_DIRECT_BUFSIZE)
+            bouncelen = NATIVEIO_DIRECT_BUFSIZE;
+        bounce = (PHYSFS_uint8 *) __PHYSFS_alignedMalloc((size_t) bouncelen,
+                                                         (size_t) align);
+        BAIL_IF_MACRO(!bounce, PHYSFS_ERR_OUT_OF_MEMORY, -1);
+        rc = directReadAt(info->handle, bounce, bouncelen,
+                          (PHYSFS_uint8 *) buf, len, pos);
+        __PHYSFS_alignedFree(bounce, (size_t) bouncelen, (size_t) align);
+    } /* else */
+
+    if (rc > 0)
+    {
+        __PHYSFS_STAT_ADD(bytesReadPhysical, rc);
+        chargeAsyncRead((PHYSFS_uint64) rc);
+    } /* if */
+    return rc;
+} /* nativeIo_readAt */
+
+static PHYSFS_sint64 nativeIo_readv(PHYSFS_Io *io, const PHYSFS_IoVec *iov,
+                                    PHYSFS_uint32 count)
+{
+    NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    PHYSFS_sint64 rc = 0;
+
+    if (info->directbuf == NULL)
+        rc = __PHYSFS_platformReadv(info->handle, iov, count);
+    else
+    {
+        PHYSFS_uint32 i;
+        for (i = 0; i < count; i++)
+        {
+            const PHYSFS_sint64 br = nativeIo_read(io, iov[i].buf,
+                                                   iov[i].len);
+            if (br < 0)
+                return (rc == 0) ? -1 : rc;
+            rc += br;
+            if (((PHYSFS_uint64) br) < iov[i].len)
+                break;  /* EOF. */
+        } /* for */
+        return rc;  /* nativeIo_read() counted it already. */
+    } /* else */
+
+    if (rc > 0)
+    {
+        __PHYSFS_STAT_ADD(bytesReadPhysical, rc);
+        chargeAsyncRead((PHYSFS_uint64) rc);
+    } /* if */
+    return rc;
+} /* nativeIo_readv */
+
 static PHYSFS_sint64 nativeIo_write(PHYSFS_Io *io, const void *buffer,
                                     PHYSFS_uint64 len)
 {
@@ -96,12 +966,16 @@ static PHYSFS_sint64 nativeIo_write(PHYSFS_Io *io, const void *buffer,
 static int nativeIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
 {
     NativeIoInfo *info = (NativeIoInfo *) io->opaque;
-    return __PHYSFS_platformSeek(info->handle, offset);
+    BAIL_IF_MACRO(!__PHYSFS_platformSeek(info->handle, offset), ERRPASS, 0);
+    info->directpos = offset;
+    return 1;
 } /* nativeIo_seek */
 
 static PHYSFS_sint64 nativeIo_tell(PHYSFS_Io *io)
 {
     NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    if (info->directbuf != NULL)
+        return (PHYSFS_sint64) info->directpos;
     return __PHYSFS_platformTell(info->handle);
 } /* nativeIo_tell */
 
@@ -119,48 +993,150 @@ static PHYSFS_Io *nativeIo_duplicate(PHYSFS_Io *io)
 
 static int nativeIo_flush(PHYSFS_Io *io)
 {
-    return __PHYSFS_platformFlush(io->opaque);
+    NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    return __PHYSFS_platformFlush(info->handle);
 } /* nativeIo_flush */
 
 static void nativeIo_destroy(PHYSFS_Io *io)
 {
     NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    const size_t len = sizeof (NativeIoInfo) + strlen(info->path) + 1;
     __PHYSFS_platformClose(info->handle);
-    allocator.Free((void *) info->path);
-    allocator.Free(info);
-    allocator.Free(io);
+    __PHYSFS_alignedFree(info->directbuf, NATIVEIO_DIRECT_BUFSIZE,
+                         __PHYSFS_DIRECT_IO_ALIGN);
+    __PHYSFS_poolFree(info, len);  /* path is in the same block. */
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
 } /* nativeIo_destroy */
 
-static const PHYSFS_Io __PHYSFS_nativeIoInterface =
+/* Returns zero, maybe without an error code, if reads still use the cache. */
+static int nativeIo_startDirect(NativeIoInfo *info, PHYSFS_uint64 offset,
+                                PHYSFS_uint64 len)
 {
-    CURRENT_PHYSFS_IO_API_VERSION, NULL,
-    nativeIo_read,
-    nativeIo_write,
-    nativeIo_seek,
+    PHYSFS_sint64 pos;
+    PHYSFS_uint8 *buf;
+
+    if (info->directbuf != NULL)
+        return 1;  /* already going. */
+    else if (info->mode != 'r')
+        return 0;
+
+    if (len == 0)
+    {
+        const PHYSFS_sint64 flen = __PHYSFS_platformFileLength(info->handle);
+        if ((flen < 0) || (offset >= (PHYSFS_uint64) flen))
+            return 0;
+        len = ((PHYSFS_uint64) flen) - offset;
+    } /* if */
+
+    if (len < NATIVEIO_DIRECT_MIN)
+        return 0;
+
+    pos = __PHYSFS_platformTell(info->handle);
+    BAIL_IF_MACRO(pos < 0, ERRPASS, 0);
+    buf = (PHYSFS_uint8 *) __PHYSFS_alignedMalloc(NATIVEIO_DIRECT_BUFSIZE,
+                                                  __PHYSFS_DIRECT_IO_ALIGN);
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    if (!__PHYSFS_platformSetDirectIo(info->handle, 1))
+    {
+        __PHYSFS_alignedFree(buf, NATIVEIO_DIRECT_BUFSIZE,
+                             __PHYSFS_DIRECT_IO_ALIGN);
+        return 0;
+    } /* if */
+
+    info->directbuf = buf;
+    info->directpos = (PHYSFS_uint64) pos;
+    info->bufpos = info->buffill = 0;
+    return 1;
+} /* nativeIo_startDirect */
+
+static int nativeIo_stopDirect(NativeIoInfo *info)
+{
+    BAIL_IF_MACRO(!__PHYSFS_platformSetDirectIo(info->handle, 0), ERRPASS, 0);
+    __PHYSFS_alignedFree(info->directbuf, NATIVEIO_DIRECT_BUFSIZE,
+                         __PHYSFS_DIRECT_IO_ALIGN);
+    info->directbuf = NULL;
+    /* reads didn't move the OS's file pointer, so catch it up. */
+    return __PHYSFS_platformSeek(info->handle, info->directpos);
+} /* nativeIo_stopDirect */
+
+static int nativeIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint)
+{
+    NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+
+    if (hint == PHYSFS_ACCESS_STREAM)
+    {
+        const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+        if (nativeIo_startDirect(info, offset, len))
+            return 1;
+        PHYSFS_getLastErrorCode();  /* not worth it, or can't; quietly... */
+        PHYSFS_setErrorCode(prevErr);
+        hint = PHYSFS_ACCESS_SEQUENTIAL;  /* ...do the next best thing. */
+    } /* if */
+
+    else if (info->directbuf != NULL)
+    {
+        BAIL_IF_MACRO(!nativeIo_stopDirect(info), ERRPASS, 0);
+    } /* else if */
+
+    return __PHYSFS_platformAdvise(info->handle, offset, len, hint);
+} /* nativeIo_advise */
+
+static int nativeIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    const NativeIoInfo *info = (NativeIoInfo *) io->opaque;
+    PHYSFS_sint64 len;
+
+    /* written files are still changing, and uncached reads want alignment. */
+    BAIL_IF_MACRO(info->mode != 'r', PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(info->directbuf != NULL, PHYSFS_ERR_UNSUPPORTED, 0);
+
+    len = __PHYSFS_platformFileLength(info->handle);
+    BAIL_IF_MACRO(len < 0, ERRPASS, 0);
+    BAIL_IF_MACRO(!__PHYSFS_platformFileBacking(info->handle, backing),
+                  ERRPASS, 0);
+    backing->offset = 0;
+    backing->length = (PHYSFS_uint64) len;
+    return 1;
+} /* nativeIo_backing */
+
+static const PHYSFS_Io __PHYSFS_nativeIoInterface =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    nativeIo_read,
+    nativeIo_write,
+    nativeIo_seek,
     nativeIo_tell,
     nativeIo_length,
     nativeIo_duplicate,
     nativeIo_flush,
-    nativeIo_destroy
+    nativeIo_destroy,
+    NULL,  /* map: mapped files use memoryIo instead. */
+    nativeIo_readAt,
+    nativeIo_readv,
+    nativeIo_advise,
+    nativeIo_backing
 };
 
-PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode)
+PHYSFS_Io *__PHYSFS_createNativeIoAt(void *dir, const char *relpath,
+                                     const char *path, const int mode)
 {
+    const size_t infolen = sizeof (NativeIoInfo) + strlen(path) + 1;
     PHYSFS_Io *io = NULL;
     NativeIoInfo *info = NULL;
     void *handle = NULL;
-    char *pathdup = NULL;
 
     assert((mode == 'r') || (mode == 'w') || (mode == 'a'));
+    assert((dir == NULL) || (mode == 'r'));
 
-    io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    GOTO_IF_MACRO(!io, PHYSFS_ERR_OUT_OF_MEMORY, createNativeIo_failed);
-    info = (NativeIoInfo *) allocator.Malloc(sizeof (NativeIoInfo));
-    GOTO_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, createNativeIo_failed);
-    pathdup = (char *) allocator.Malloc(strlen(path) + 1);
-    GOTO_IF_MACRO(!pathdup, PHYSFS_ERR_OUT_OF_MEMORY, createNativeIo_failed);
+    io = (PHYSFS_Io *) __PHYSFS_poolAlloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!io, ERRPASS, createNativeIo_failed);
+    info = (NativeIoInfo *) __PHYSFS_poolAlloc(infolen);
+    GOTO_IF_MACRO(!info, ERRPASS, createNativeIo_failed);
 
-    if (mode == 'r')
+    if (dir != NULL)
+        handle = __PHYSFS_platformOpenReadAt(dir, relpath);
+    else if (mode == 'r')
         handle = __PHYSFS_platformOpenRead(path);
     else if (mode == 'w')
         handle = __PHYSFS_platformOpenWrite(path);
@@ -169,9 +1145,10 @@ PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode)
 
     GOTO_IF_MACRO(!handle, ERRPASS, createNativeIo_failed);
 
-    strcpy(pathdup, path);
+    strcpy((char *) (info + 1), path);
+    memset(info, '\0', sizeof (NativeIoInfo));
     info->handle = handle;
-    info->path = pathdup;
+    info->path = (const char *) (info + 1);
     info->mode = mode;
     memcpy(io, &__PHYSFS_nativeIoInterface, sizeof (*io));
     io->opaque = info;
@@ -179,10 +1156,15 @@ PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode)
 
 createNativeIo_failed:
     if (handle != NULL) __PHYSFS_platformClose(handle);
-    if (pathdup != NULL) allocator.Free(pathdup);
-    if (info != NULL) allocator.Free(info);
-    if (io != NULL) allocator.Free(io);
+    __PHYSFS_poolFree(info, infolen);
+    __PHYSFS_poolFree(io, sizeof (PHYSFS_Io));
     return NULL;
+} /* __PHYSFS_createNativeIoAt */
+
+
+PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode)
+{
+    return __PHYSFS_createNativeIoAt(NULL, NULL, path, mode);
 } /* __PHYSFS_createNativeIo */
 
 
@@ -194,8 +1176,9 @@ typedef struct __PHYSFS_MemoryIoInfo
     PHYSFS_uint64 len;
     PHYSFS_uint64 pos;
     PHYSFS_Io *parent;
-    volatile PHYSFS_uint32 refcount;
+    volatile int refcount;  /* only touch with __PHYSFS_ATOMIC_*. */
     void (*destruct)(void *);
+    void *destructarg;  /* what to pass to destruct(); usually (buf). */
 } MemoryIoInfo;
 
 static PHYSFS_sint64 memoryIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
@@ -215,6 +1198,21 @@ static PHYSFS_sint64 memoryIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
     return len;
 } /* memoryIo_read */
 
+static PHYSFS_sint64 memoryIo_readAt(PHYSFS_Io *io, void *buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    const MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
+
+    if (pos >= info->len)
+        return 0;  /* at or past EOF; nothing to do. */
+
+    if (len > (info->len - pos))
+        len = info->len - pos;
+
+    memcpy(buf, info->buf + pos, (size_t) len);
+    return len;
+} /* memoryIo_readAt */
+
 static PHYSFS_sint64 memoryIo_write(PHYSFS_Io *io, const void *buffer,
                                     PHYSFS_uint64 len)
 {
@@ -266,10 +1264,8 @@ static PHYSFS_Io *memoryIo_duplicate(PHYSFS_Io *io)
         BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
     } /* if */
 
-    /* !!! FIXME: want lockless atomic increment. */
-    __PHYSFS_platformGrabMutex(stateLock);
-    info->refcount++;
-    __PHYSFS_platformReleaseMutex(stateLock);
+    /* every open from a memory mount gets here; don't serialize them. */
+    __PHYSFS_ATOMIC_INCR(&info->refcount);
 
     memset(newinfo, '\0', sizeof (*info));
     newinfo->buf = info->buf;
@@ -278,6 +1274,7 @@ static PHYSFS_Io *memoryIo_duplicate(PHYSFS_Io *io)
     newinfo->parent = io;
     newinfo->refcount = 0;
     newinfo->destruct = NULL;
+    newinfo->destructarg = NULL;
 
     memcpy(retval, io, sizeof (*retval));
     retval->opaque = newinfo;
@@ -286,6 +1283,56 @@ static PHYSFS_Io *memoryIo_duplicate(PHYSFS_Io *io)
 
 static int memoryIo_flush(PHYSFS_Io *io) { return 1;  /* it's read-only. */ }
 
+static int memoryIo_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    const MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
+    *ptr = info->buf;
+    *len = info->len;
+    return 1;
+} /* memoryIo_map */
+
+static int memoryIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint)
+{
+    const MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
+    const MemoryIoInfo *owner = info;
+
+    if (info->parent != NULL)
+        owner = (const MemoryIoInfo *) info->parent->opaque;
+
+    /* plain memory has no cache to hint about; mapped files do. */
+    BAIL_IF_MACRO(owner->destruct != __PHYSFS_platformUnmapFile,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+
+    if (offset >= info->len)
+        return 1;  /* nothing there to hint about. */
+    else if ((len == 0) || (len > info->len - offset))
+        len = info->len - offset;
+
+    if (hint == PHYSFS_ACCESS_STREAM)
+        hint = PHYSFS_ACCESS_SEQUENTIAL;  /* it's mapped; no way around it. */
+    return __PHYSFS_platformAdviseMapping(owner->destructarg,
+                                          info->buf + offset, len, hint);
+} /* memoryIo_advise */
+
+static int memoryIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    const MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
+    const MemoryIoInfo *owner = info;
+
+    if (info->parent != NULL)
+        owner = (const MemoryIoInfo *) info->parent->opaque;
+
+    /* plain memory isn't in any file; mapped files are. */
+    BAIL_IF_MACRO(owner->destruct != __PHYSFS_platformUnmapFile,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!__PHYSFS_platformMappingBacking(owner->destructarg,
+                                                   backing), ERRPASS, 0);
+    backing->offset = 0;  /* we always map the whole file. */
+    backing->length = info->len;
+    return 1;
+} /* memoryIo_backing */
+
 static void memoryIo_destroy(PHYSFS_Io *io)
 {
     MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
@@ -307,21 +1354,17 @@ static void memoryIo_destroy(PHYSFS_Io *io)
     /* we _are_ the parent. */
     assert(info->refcount > 0);  /* even in a race, we hold a reference. */
 
-    /* !!! FIXME: want lockless atomic decrement. */
-    __PHYSFS_platformGrabMutex(stateLock);
-    info->refcount--;
-    should_die = (info->refcount == 0);
-    __PHYSFS_platformReleaseMutex(stateLock);
+    should_die = (__PHYSFS_ATOMIC_DECR(&info->refcount) == 0);
 
     if (should_die)
     {
         void (*destruct)(void *) = info->destruct;
-        void *buf = (void *) info->buf;
+        void *arg = info->destructarg;
         io->opaque = NULL;  /* kill this here in case of race. */
         allocator.Free(info);
         allocator.Free(io);
         if (destruct != NULL)
-            destruct(buf);
+            destruct(arg);
     } /* if */
 } /* memoryIo_destroy */
 
@@ -336,7 +1379,12 @@ static const PHYSFS_Io __PHYSFS_memoryIoInterface =
     memoryIo_length,
     memoryIo_duplicate,
     memoryIo_flush,
-    memoryIo_destroy
+    memoryIo_destroy,
+    memoryIo_map,
+    memoryIo_readAt,
+    NULL,  /* readv */
+    memoryIo_advise,
+    memoryIo_backing
 };
 
 PHYSFS_Io *__PHYSFS_createMemoryIo(const void *buf, PHYSFS_uint64 len,
@@ -357,6 +1405,7 @@ PHYSFS_Io *__PHYSFS_createMemoryIo(const void *buf, PHYSFS_uint64 len,
     info->parent = NULL;
     info->refcount = 1;
     info->destruct = destruct;
+    info->destructarg = (void *) buf;
 
     memcpy(io, &__PHYSFS_memoryIoInterface, sizeof (*io));
     io->opaque = info;
@@ -369,2531 +1418,16350 @@ createMemoryIo_failed:
 } /* __PHYSFS_createMemoryIo */
 
 
-/* PHYSFS_Io implementation for i/o to a PHYSFS_File... */
+/* PHYSFS_Io implementation for a memory-mapped physical file... */
 
-static PHYSFS_sint64 handleIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
+/*
+ * This is just a memoryIo whose buffer is a read-only mapping of the file,
+ *  so reads are a memcpy from the page cache instead of a syscall, and
+ *  duplicates share the one mapping through the memoryIo refcount. The
+ *  mapping is released when the last duplicate is destroyed.
+ */
+PHYSFS_Io *__PHYSFS_createMappedIo(const char *path)
 {
-    return PHYSFS_readBytes((PHYSFS_File *) io->opaque, buf, len);
-} /* handleIo_read */
+    PHYSFS_Io *io = NULL;
+    const void *ptr = NULL;
+    PHYSFS_uint64 len = 0;
+    void *mapping = __PHYSFS_platformMapFile(path, &ptr, &len);
+    BAIL_IF_MACRO(!mapping, ERRPASS, NULL);
 
-static PHYSFS_sint64 handleIo_write(PHYSFS_Io *io, const void *buffer,
-                                    PHYSFS_uint64 len)
-{
-    return PHYSFS_writeBytes((PHYSFS_File *) io->opaque, buffer, len);
-} /* handleIo_write */
+    io = __PHYSFS_createMemoryIo(ptr, len, __PHYSFS_platformUnmapFile);
+    if (io == NULL)
+    {
+        __PHYSFS_platformUnmapFile(mapping);
+        return NULL;
+    } /* if */
 
-static int handleIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
-{
-    return PHYSFS_seek((PHYSFS_File *) io->opaque, offset);
-} /* handleIo_seek */
+    ((MemoryIoInfo *) io->opaque)->destructarg = mapping;
+    return io;
+} /* __PHYSFS_createMappedIo */
 
-static PHYSFS_sint64 handleIo_tell(PHYSFS_Io *io)
-{
-    return PHYSFS_tell((PHYSFS_File *) io->opaque);
-} /* handleIo_tell */
 
-static PHYSFS_sint64 handleIo_length(PHYSFS_Io *io)
+/* PHYSFS_Io implementation for a range of bytes in another PHYSFS_Io... */
+
+typedef struct
 {
-    return PHYSFS_fileLength((PHYSFS_File *) io->opaque);
-} /* handleIo_length */
+    PHYSFS_Io *io;  /* what we read from; we own it. */
+    PHYSFS_uint64 offset;  /* where our byte zero is in (io). */
+    PHYSFS_uint64 len;
+    PHYSFS_uint64 pos;
+} SliceIoInfo;
 
-static PHYSFS_Io *handleIo_duplicate(PHYSFS_Io *io)
+static PHYSFS_sint64 sliceIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
 {
-    /*
-     * There's no duplicate at the PHYSFS_File level, so we break the
-     *  abstraction. We're allowed to: we're physfs.c!
-     */
-    FileHandle *origfh = (FileHandle *) io->opaque;
-    FileHandle *newfh = (FileHandle *) allocator.Malloc(sizeof (FileHandle));
-    PHYSFS_Io *retval = NULL;
+    SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    PHYSFS_sint64 rc;
 
-    GOTO_IF_MACRO(!newfh, PHYSFS_ERR_OUT_OF_MEMORY, handleIo_dupe_failed);
-    memset(newfh, '\0', sizeof (*newfh));
+    if (len > info->len - info->pos)
+        len = info->len - info->pos;
+    if (len == 0)
+        return 0;
 
-    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, handleIo_dupe_failed);
+    rc = info->io->read(info->io, buf, len);
+    if (rc > 0)
+        info->pos += (PHYSFS_uint64) rc;
+    return rc;
+} /* sliceIo_read */
 
-#if 0  /* we don't buffer the duplicate, at least not at the moment. */
-    if (origfh->buffer != NULL)
-    {
-        newfh->buffer = (PHYSFS_uint8 *) allocator.Malloc(origfh->bufsize);
-        if (!newfh->buffer)
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, handleIo_dupe_failed);
-        newfh->bufsize = origfh->bufsize;
-    } /* if */
-#endif
+static PHYSFS_sint64 sliceIo_write(PHYSFS_Io *io, const void *b,
+                                   PHYSFS_uint64 len)
+{
+    BAIL_MACRO(PHYSFS_ERR_OPEN_FOR_READING, -1);
+} /* sliceIo_write */
 
-    newfh->io = origfh->io->duplicate(origfh->io);
-    GOTO_IF_MACRO(!newfh->io, ERRPASS, handleIo_dupe_failed);
+static int sliceIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    BAIL_IF_MACRO(offset > info->len, PHYSFS_ERR_PAST_EOF, 0);
+    BAIL_IF_MACRO(!info->io->seek(info->io, info->offset + offset),
+                  ERRPASS, 0);
+    info->pos = offset;
+    return 1;
+} /* sliceIo_seek */
 
-    newfh->forReading = origfh->forReading;
-    newfh->dirHandle = origfh->dirHandle;
+static PHYSFS_sint64 sliceIo_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((SliceIoInfo *) io->opaque)->pos;
+} /* sliceIo_tell */
 
-    __PHYSFS_platformGrabMutex(stateLock);
-    if (newfh->forReading)
-    {
-        newfh->next = openReadList;
-        openReadList = newfh;
-    } /* if */
-    else
-    {
-        newfh->next = openWriteList;
-        openWriteList = newfh;
-    } /* else */
-    __PHYSFS_platformReleaseMutex(stateLock);
+static PHYSFS_sint64 sliceIo_length(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((SliceIoInfo *) io->opaque)->len;
+} /* sliceIo_length */
 
-    memcpy(retval, io, sizeof (PHYSFS_Io));
-    retval->opaque = newfh;
+static PHYSFS_Io *sliceIo_duplicate(PHYSFS_Io *io)
+{
+    const SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    PHYSFS_Io *dup = info->io->duplicate(info->io);
+    PHYSFS_Io *retval;
+
+    BAIL_IF_MACRO(!dup, ERRPASS, NULL);
+    retval = __PHYSFS_createSliceIo(dup, info->offset, info->len);
+    if (retval == NULL)
+        dup->destroy(dup);
     return retval;
+} /* sliceIo_duplicate */
 
-handleIo_dupe_failed:
-    if (newfh)
-    {
-        if (newfh->io != NULL) newfh->io->destroy(newfh->io);
-        if (newfh->buffer != NULL) allocator.Free(newfh->buffer);
-        allocator.Free(newfh);
-    } /* if */
+static int sliceIo_flush(PHYSFS_Io *io) { return 1;  /* it's read-only. */ }
 
-    return NULL;
-} /* handleIo_duplicate */
+static void sliceIo_destroy(PHYSFS_Io *io)
+{
+    SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    info->io->destroy(info->io);
+    allocator.Free(info);
+    allocator.Free(io);
+} /* sliceIo_destroy */
 
-static int handleIo_flush(PHYSFS_Io *io)
+static int sliceIo_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
 {
-    return PHYSFS_flush((PHYSFS_File *) io->opaque);
-} /* handleIo_flush */
+    const SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    const PHYSFS_uint8 *parentptr = NULL;
+    PHYSFS_uint64 parentlen = 0;
 
-static void handleIo_destroy(PHYSFS_Io *io)
+    if (!__PHYSFS_ioMap(info->io, (const void **) &parentptr, &parentlen))
+        return 0;
+    BAIL_IF_MACRO(info->offset + info->len > parentlen,
+                  PHYSFS_ERR_CORRUPT, 0);
+    *ptr = parentptr + info->offset;
+    *len = info->len;
+    return 1;
+} /* sliceIo_map */
+
+static PHYSFS_sint64 sliceIo_readAt(PHYSFS_Io *io, void *buf,
+                                    PHYSFS_uint64 len, PHYSFS_uint64 pos)
 {
-    if (io->opaque != NULL)
-        PHYSFS_close((PHYSFS_File *) io->opaque);
-    allocator.Free(io);
-} /* handleIo_destroy */
+    const SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    if (pos >= info->len)
+        return 0;  /* at or past EOF; nothing to do. */
+    else if (len > info->len - pos)
+        len = info->len - pos;
+    return __PHYSFS_ioReadAt(info->io, buf, len, info->offset + pos);
+} /* sliceIo_readAt */
+
+static int sliceIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                          PHYSFS_uint64 len, int hint)
+{
+    const SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    if (offset >= info->len)
+        return 1;  /* nothing there to hint about. */
+    else if ((len == 0) || (len > info->len - offset))
+        len = info->len - offset;
+    return __PHYSFS_ioAdvise(info->io, info->offset + offset, len, hint);
+} /* sliceIo_advise */
+
+static int sliceIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    const SliceIoInfo *info = (SliceIoInfo *) io->opaque;
+    if (!__PHYSFS_ioBacking(info->io, backing))
+        return 0;
+    BAIL_IF_MACRO(info->offset + info->len > backing->length,
+                  PHYSFS_ERR_CORRUPT, 0);
+    backing->offset += info->offset;
+    backing->length = info->len;
+    return 1;
+} /* sliceIo_backing */
 
-static const PHYSFS_Io __PHYSFS_handleIoInterface =
+static const PHYSFS_Io __PHYSFS_sliceIoInterface =
 {
     CURRENT_PHYSFS_IO_API_VERSION, NULL,
-    handleIo_read,
-    handleIo_write,
-    handleIo_seek,
-    handleIo_tell,
-    handleIo_length,
-    handleIo_duplicate,
-    handleIo_flush,
-    handleIo_destroy
+    sliceIo_read,
+    sliceIo_write,
+    sliceIo_seek,
+    sliceIo_tell,
+    sliceIo_length,
+    sliceIo_duplicate,
+    sliceIo_flush,
+    sliceIo_destroy,
+    sliceIo_map,
+    sliceIo_readAt,
+    NULL,  /* readv */
+    sliceIo_advise,
+    sliceIo_backing,
+    NULL   /* raw: it's whatever it is already. */
 };
 
-static PHYSFS_Io *__PHYSFS_createHandleIo(PHYSFS_File *f)
+PHYSFS_Io *__PHYSFS_createSliceIo(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                                  PHYSFS_uint64 len)
 {
-    PHYSFS_Io *io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
-    BAIL_IF_MACRO(!io, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    memcpy(io, &__PHYSFS_handleIoInterface, sizeof (*io));
-    io->opaque = f;
-    return io;
-} /* __PHYSFS_createHandleIo */
+    PHYSFS_Io *retval = NULL;
+    SliceIoInfo *info = NULL;
 
+    BAIL_IF_MACRO(!io->seek(io, offset), ERRPASS, NULL);
+
+    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, createSliceIo_failed);
+    info = (SliceIoInfo *) allocator.Malloc(sizeof (SliceIoInfo));
+    GOTO_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, createSliceIo_failed);
+
+    info->io = io;
+    info->offset = offset;
+    info->len = len;
+    info->pos = 0;
+    memcpy(retval, &__PHYSFS_sliceIoInterface, sizeof (*retval));
+    retval->opaque = info;
+    return retval;
+
+createSliceIo_failed:
+    if (info != NULL) allocator.Free(info);
+    if (retval != NULL) allocator.Free(retval);
+    return NULL;
+} /* __PHYSFS_createSliceIo */
 
-/* functions ... */
 
+/* PHYSFS_Io implementation for a block cache over another PHYSFS_Io... */
+
+typedef struct CachedIoBlock
+{
+    PHYSFS_uint64 index;  /* which block of the data this is. */
+    PHYSFS_uint64 len;  /* blockSize, except for the data's last block. */
+    struct CachedIoBlock *hashnext;
+    struct CachedIoBlock *older;
+    struct CachedIoBlock *newer;
+    PHYSFS_uint8 data[1];  /* really blockSize bytes. */
+} CachedIoBlock;
+
+/* What every duplicate of a cached Io shares. */
 typedef struct
 {
-    char **list;
-    PHYSFS_uint32 size;
-    PHYSFS_ErrorCode errcode;
-} EnumStringListCallbackData;
+    void *lock;
+    PHYSFS_uint32 refcount;
+    PHYSFS_uint32 blockSize;
+    PHYSFS_uint32 capacity;
+    PHYSFS_uint32 count;
+    PHYSFS_uint64 length;
+    CachedIoBlock **buckets;
+    PHYSFS_uint32 bucketmask;
+    CachedIoBlock *newest;
+    CachedIoBlock *oldest;
+} CachedIoShared;
 
-static void enumStringListCallback(void *data, const char *str)
+typedef struct
 {
-    void *ptr;
-    char *newstr;
-    EnumStringListCallbackData *pecd = (EnumStringListCallbackData *) data;
+    CachedIoShared *shared;
+    PHYSFS_Io *io;  /* our own duplicate of the data, for its position. */
+    PHYSFS_uint64 pos;
+} CachedIoInfo;
 
-    if (pecd->errcode)
-        return;
+static size_t cachedIoBlockBytes(const CachedIoShared *sh)
+{
+    return sizeof (CachedIoBlock) - 1 + sh->blockSize;
+} /* cachedIoBlockBytes */
 
-    ptr = allocator.Realloc(pecd->list, (pecd->size + 2) * sizeof (char *));
-    newstr = (char *) allocator.Malloc(strlen(str) + 1);
-    if (ptr != NULL)
-        pecd->list = (char **) ptr;
+/* Find block (index), making it the newest. Lock held. */
+static CachedIoBlock *cachedIoFind(CachedIoShared *sh, PHYSFS_uint64 index)
+{
+    CachedIoBlock *b = sh->buckets[((PHYSFS_uint32) index) & sh->bucketmask];
+    while ((b != NULL) && (b->index != index))
+        b = b->hashnext;
 
-    if ((ptr == NULL) || (newstr == NULL))
+    if ((b != NULL) && (b != sh->newest))
     {
-        pecd->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
-        pecd->list[pecd->size] = NULL;
-        PHYSFS_freeList(pecd->list);
-        return;
+        b->newer->older = b->older;  /* not the newest, so (newer) is set. */
+        if (b->older != NULL)
+            b->older->newer = b->newer;
+        else
+            sh->oldest = b->newer;
+        b->older = sh->newest;
+        b->newer = NULL;
+        sh->newest->newer = b;
+        sh->newest = b;
     } /* if */
 
-    strcpy(newstr, str);
-    pecd->list[pecd->size] = newstr;
-    pecd->size++;
-} /* enumStringListCallback */
-
+    return b;
+} /* cachedIoFind */
 
-static char **doEnumStringList(void (*func)(PHYSFS_StringCallback, void *))
+/* Take the oldest block out of the cache, to reuse. Lock held. */
+static CachedIoBlock *cachedIoEvict(CachedIoShared *sh)
 {
-    EnumStringListCallbackData ecd;
-    memset(&ecd, '\0', sizeof (ecd));
-    ecd.list = (char **) allocator.Malloc(sizeof (char *));
-    BAIL_IF_MACRO(!ecd.list, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    func(enumStringListCallback, &ecd);
+    CachedIoBlock *b = sh->oldest;
+    CachedIoBlock **prev;
 
-    if (ecd.errcode)
-    {
-        PHYSFS_setErrorCode(ecd.errcode);
+    if (b == NULL)
         return NULL;
-    } /* if */
 
-    ecd.list[ecd.size] = NULL;
-    return ecd.list;
-} /* doEnumStringList */
+    prev = &sh->buckets[((PHYSFS_uint32) b->index) & sh->bucketmask];
+    while (*prev != b)
+        prev = &(*prev)->hashnext;
+    *prev = b->hashnext;
 
+    sh->oldest = b->newer;
+    if (sh->oldest != NULL)
+        sh->oldest->older = NULL;
+    else
+        sh->newest = NULL;
+    sh->count--;
+    return b;
+} /* cachedIoEvict */
 
-static void __PHYSFS_bubble_sort(void *a, size_t lo, size_t hi,
-                                 int (*cmpfn)(void *, size_t, size_t),
-                                 void (*swapfn)(void *, size_t, size_t))
+/* Add (b) as the newest block. Lock held, and (b) isn't cached yet. */
+static void cachedIoInsert(CachedIoShared *sh, CachedIoBlock *b)
 {
-    size_t i;
-    int sorted;
+    CachedIoBlock **bucket;
+    bucket = &sh->buckets[((PHYSFS_uint32) b->index) & sh->bucketmask];
+    b->hashnext = *bucket;
+    *bucket = b;
+    b->older = sh->newest;
+    b->newer = NULL;
+    if (sh->newest != NULL)
+        sh->newest->newer = b;
+    else
+        sh->oldest = b;
+    sh->newest = b;
+    sh->count++;
+} /* cachedIoInsert */
 
-    do
+/*
+ * A block to read (index) into: a new one if there's room for it, else the
+ *  least recently used one. NULL if there's no memory for any at all.
+ */
+static CachedIoBlock *cachedIoGetBlock(CachedIoShared *sh)
+{
+    const size_t len = cachedIoBlockBytes(sh);
+    CachedIoBlock *retval = NULL;
+
+    __PHYSFS_platformGrabMutex(sh->lock);
+    if ((sh->count >= sh->capacity) ||
+        ((sh->count > 0) && (!__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES, len))))
+        retval = cachedIoEvict(sh);
+    __PHYSFS_platformReleaseMutex(sh->lock);
+
+    if ((retval == NULL) && (__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES, len)))
     {
-        sorted = 1;
-        for (i = lo; i < hi; i++)
-        {
-            if (cmpfn(a, i, i + 1) > 0)
-            {
-                swapfn(a, i, i + 1);
-                sorted = 0;
-            } /* if */
-        } /* for */
-    } while (!sorted);
-} /* __PHYSFS_bubble_sort */
+        retval = (CachedIoBlock *) allocator.Malloc(len);
+        if (retval != NULL)
+            __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_CACHES, (PHYSFS_sint64) len);
+    } /* if */
 
+    return retval;
+} /* cachedIoGetBlock */
 
-static void __PHYSFS_quick_sort(void *a, size_t lo, size_t hi,
-                         int (*cmpfn)(void *, size_t, size_t),
-                         void (*swapfn)(void *, size_t, size_t))
+static void cachedIoFreeBlock(CachedIoShared *sh, CachedIoBlock *b)
 {
-    size_t i;
-    size_t j;
-    size_t v;
+    const size_t len = cachedIoBlockBytes(sh);
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_CACHES, -((PHYSFS_sint64) len));
+    __PHYSFS_sizedFree(b, len);
+} /* cachedIoFreeBlock */
 
-    if ((hi - lo) <= PHYSFS_QUICKSORT_THRESHOLD)
-        __PHYSFS_bubble_sort(a, lo, hi, cmpfn, swapfn);
-    else
+static PHYSFS_sint64 cachedIo_readAt(PHYSFS_Io *io, void *_buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    const CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    CachedIoShared *sh = info->shared;
+    const PHYSFS_uint64 bs = sh->blockSize;
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) _buf;
+    PHYSFS_uint64 done = 0;
+
+    if (pos >= sh->length)
+        return 0;
+    else if (len > sh->length - pos)
+        len = sh->length - pos;
+
+    while (done < len)
     {
-        i = (hi + lo) / 2;
+        const PHYSFS_uint64 at = pos + done;
+        const PHYSFS_uint64 from = at % bs;
+        const PHYSFS_uint64 left = len - done;
+        CachedIoBlock *b;
+        CachedIoBlock *fresh;
+        PHYSFS_uint64 cpy;
+        PHYSFS_sint64 rc;
+
+        __PHYSFS_platformGrabMutex(sh->lock);
+        b = cachedIoFind(sh, at / bs);
+        if (b != NULL)
+        {
+            cpy = (b->len - from < left) ? b->len - from : left;
+            memcpy(buf + done, b->data + from, (size_t) cpy);
+            __PHYSFS_platformReleaseMutex(sh->lock);
+            done += cpy;
+            continue;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(sh->lock);
 
-        if (cmpfn(a, lo, i) > 0) swapfn(a, lo, i);
-        if (cmpfn(a, lo, hi) > 0) swapfn(a, lo, hi);
-        if (cmpfn(a, i, hi) > 0) swapfn(a, i, hi);
+        /* whole blocks are read straight in; caching them would just push
+           out the small stuff that's worth keeping. */
+        if ((from == 0) && (left >= bs))
+        {
+            cpy = left - (left % bs);
+            rc = __PHYSFS_ioReadAt(info->io, buf + done, cpy, at);
+            if (rc <= 0)
+                return (done > 0) ? (PHYSFS_sint64) done : rc;
+            done += (PHYSFS_uint64) rc;
+            if ((PHYSFS_uint64) rc < cpy)
+                break;  /* data's shorter than it said; that's all there is. */
+            continue;
+        } /* if */
 
-        j = hi - 1;
-        swapfn(a, i, j);
-        i = lo;
-        v = j;
-        while (1)
+        fresh = cachedIoGetBlock(sh);
+        if (fresh == NULL)  /* no memory to cache in; read it uncached. */
         {
-            while(cmpfn(a, ++i, v) < 0) { /* do nothing */ }
-            while(cmpfn(a, --j, v) > 0) { /* do nothing */ }
-            if (j < i)
+            cpy = (bs - from < left) ? bs - from : left;
+            rc = __PHYSFS_ioReadAt(info->io, buf + done, cpy, at);
+            if (rc <= 0)
+                return (done > 0) ? (PHYSFS_sint64) done : rc;
+            done += (PHYSFS_uint64) rc;
+            if ((PHYSFS_uint64) rc < cpy)
                 break;
-            swapfn(a, i, j);
-        } /* while */
-        if (i != (hi-1))
-            swapfn(a, i, hi-1);
-        __PHYSFS_quick_sort(a, lo, j, cmpfn, swapfn);
-        __PHYSFS_quick_sort(a, i+1, hi, cmpfn, swapfn);
-    } /* else */
-} /* __PHYSFS_quick_sort */
+            continue;
+        } /* if */
 
+        fresh->index = at / bs;
+        fresh->len = (sh->length - (at - from) < bs) ?
+                        sh->length - (at - from) : bs;
+        rc = __PHYSFS_ioReadAt(info->io, fresh->data, fresh->len, at - from);
+        if ((rc <= 0) || ((PHYSFS_uint64) rc <= from))
+        {
+            cachedIoFreeBlock(sh, fresh);
+            return (done > 0) ? (PHYSFS_sint64) done : ((rc < 0) ? rc : 0);
+        } /* if */
+        fresh->len = (PHYSFS_uint64) rc;
 
-void __PHYSFS_sort(void *entries, size_t max,
-                   int (*cmpfn)(void *, size_t, size_t),
-                   void (*swapfn)(void *, size_t, size_t))
-{
-    /*
-     * Quicksort w/ Bubblesort fallback algorithm inspired by code from here:
-     *   https://www.cs.ubc.ca/spider/harrison/Java/sorting-demo.html
-     */
-    if (max > 0)
-        __PHYSFS_quick_sort(entries, 0, max - 1, cmpfn, swapfn);
-} /* __PHYSFS_sort */
+        __PHYSFS_platformGrabMutex(sh->lock);
+        b = cachedIoFind(sh, fresh->index);
+        if (b == NULL)  /* nobody else read it while we were. */
+        {
+            cachedIoInsert(sh, fresh);
+            b = fresh;
+            fresh = NULL;
+        } /* if */
+        cpy = (b->len - from < left) ? b->len - from : left;
+        memcpy(buf + done, b->data + from, (size_t) cpy);
+        __PHYSFS_platformReleaseMutex(sh->lock);
 
+        if (fresh != NULL)
+            cachedIoFreeBlock(sh, fresh);
+        done += cpy;
+    } /* while */
 
-static ErrState *findErrorForCurrentThread(void)
+    return (PHYSFS_sint64) done;
+} /* cachedIo_readAt */
+
+static PHYSFS_sint64 cachedIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
 {
-    ErrState *i;
-    void *tid;
+    CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    const PHYSFS_sint64 rc = cachedIo_readAt(io, buf, len, info->pos);
+    if (rc > 0)
+        info->pos += (PHYSFS_uint64) rc;
+    return rc;
+} /* cachedIo_read */
+
+static PHYSFS_sint64 cachedIo_write(PHYSFS_Io *io, const void *b,
+                                    PHYSFS_uint64 len)
+{
+    BAIL_MACRO(PHYSFS_ERR_OPEN_FOR_READING, -1);
+} /* cachedIo_write */
 
-    if (errorLock != NULL)
-        __PHYSFS_platformGrabMutex(errorLock);
+static int cachedIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    BAIL_IF_MACRO(offset > info->shared->length, PHYSFS_ERR_PAST_EOF, 0);
+    info->pos = offset;
+    return 1;
+} /* cachedIo_seek */
 
-    if (errorStates != NULL)
-    {
-        tid = __PHYSFS_platformGetThreadID();
+static PHYSFS_sint64 cachedIo_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((CachedIoInfo *) io->opaque)->pos;
+} /* cachedIo_tell */
 
-        for (i = errorStates; i != NULL; i = i->next)
-        {
-            if (i->tid == tid)
-            {
-                if (errorLock != NULL)
-                    __PHYSFS_platformReleaseMutex(errorLock);
-                return i;
-            } /* if */
-        } /* for */
-    } /* if */
+static PHYSFS_sint64 cachedIo_length(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((CachedIoInfo *) io->opaque)->shared->length;
+} /* cachedIo_length */
 
-    if (errorLock != NULL)
-        __PHYSFS_platformReleaseMutex(errorLock);
+static PHYSFS_Io *createCachedIo(CachedIoShared *sh, PHYSFS_Io *io);
 
-    return NULL;   /* no error available. */
-} /* findErrorForCurrentThread */
+static PHYSFS_Io *cachedIo_duplicate(PHYSFS_Io *io)
+{
+    const CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    PHYSFS_Io *dup = info->io->duplicate(info->io);
+    PHYSFS_Io *retval;
+
+    BAIL_IF_MACRO(!dup, ERRPASS, NULL);
+    retval = createCachedIo(info->shared, dup);
+    if (retval == NULL)
+        dup->destroy(dup);
+    return retval;
+} /* cachedIo_duplicate */
 
+static int cachedIo_flush(PHYSFS_Io *io) { return 1;  /* it's read-only. */ }
 
-/* this doesn't reset the error state. */
-static inline PHYSFS_ErrorCode currentErrorCode(void)
+static void releaseCachedIoShared(CachedIoShared *sh)
 {
-    const ErrState *err = findErrorForCurrentThread();
-    return err ? err->code : PHYSFS_ERR_OK;
-} /* currentErrorCode */
+    PHYSFS_uint32 refcount;
 
+    __PHYSFS_platformGrabMutex(sh->lock);
+    refcount = --sh->refcount;
+    __PHYSFS_platformReleaseMutex(sh->lock);
 
-PHYSFS_ErrorCode PHYSFS_getLastErrorCode(void)
+    if (refcount == 0)
+    {
+        CachedIoBlock *b;
+        while ((b = cachedIoEvict(sh)) != NULL)
+            cachedIoFreeBlock(sh, b);
+        __PHYSFS_platformDestroyMutex(sh->lock);
+        allocator.Free(sh->buckets);
+        allocator.Free(sh);
+    } /* if */
+} /* releaseCachedIoShared */
+
+static void cachedIo_destroy(PHYSFS_Io *io)
 {
-    ErrState *err = findErrorForCurrentThread();
-    const PHYSFS_ErrorCode retval = (err) ? err->code : PHYSFS_ERR_OK;
-    if (err)
-        err->code = PHYSFS_ERR_OK;
-    return retval;
-} /* PHYSFS_getLastErrorCode */
+    CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    info->io->destroy(info->io);
+    releaseCachedIoShared(info->shared);
+    allocator.Free(info);
+    allocator.Free(io);
+} /* cachedIo_destroy */
 
+static int cachedIo_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    return __PHYSFS_ioMap(((CachedIoInfo *) io->opaque)->io, ptr, len);
+} /* cachedIo_map */
 
-PHYSFS_DECL const char *PHYSFS_getErrorByCode(PHYSFS_ErrorCode code)
+static int cachedIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint)
 {
-    switch (code)
-    {
-        case PHYSFS_ERR_OK: return "no error";
-        case PHYSFS_ERR_OTHER_ERROR: return "unknown error";
-        case PHYSFS_ERR_OUT_OF_MEMORY: return "out of memory";
-        case PHYSFS_ERR_NOT_INITIALIZED: return "not initialized";
-        case PHYSFS_ERR_IS_INITIALIZED: return "already initialized";
-        case PHYSFS_ERR_ARGV0_IS_NULL: return "argv[0] is NULL";
-        case PHYSFS_ERR_UNSUPPORTED: return "unsupported";
-        case PHYSFS_ERR_PAST_EOF: return "past end of file";
-        case PHYSFS_ERR_FILES_STILL_OPEN: return "files still open";
-        case PHYSFS_ERR_INVALID_ARGUMENT: return "invalid argument";
-        case PHYSFS_ERR_NOT_MOUNTED: return "not mounted";
-        case PHYSFS_ERR_NOT_FOUND: return "not found";
-        case PHYSFS_ERR_SYMLINK_FORBIDDEN: return "symlinks are forbidden";
-        case PHYSFS_ERR_NO_WRITE_DIR: return "write directory is not set";
-        case PHYSFS_ERR_OPEN_FOR_READING: return "file open for reading";
-        case PHYSFS_ERR_OPEN_FOR_WRITING: return "file open for writing";
-        case PHYSFS_ERR_NOT_A_FILE: return "not a file";
-        case PHYSFS_ERR_READ_ONLY: return "read-only filesystem";
-        case PHYSFS_ERR_CORRUPT: return "corrupted";
-        case PHYSFS_ERR_SYMLINK_LOOP: return "infinite symbolic link loop";
-        case PHYSFS_ERR_IO: return "i/o error";
-        case PHYSFS_ERR_PERMISSION: return "permission denied";
-        case PHYSFS_ERR_NO_SPACE: return "no space available for writing";
-        case PHYSFS_ERR_BAD_FILENAME: return "filename is illegal or insecure";
-        case PHYSFS_ERR_BUSY: return "tried to modify a file the OS needs";
-        case PHYSFS_ERR_DIR_NOT_EMPTY: return "directory isn't empty";
-        case PHYSFS_ERR_OS_ERROR: return "OS reported an error";
-        case PHYSFS_ERR_DUPLICATE: return "duplicate resource";
-        case PHYSFS_ERR_BAD_PASSWORD: return "bad password";
-    } /* switch */
+    return __PHYSFS_ioAdvise(((CachedIoInfo *) io->opaque)->io,
+                             offset, len, hint);
+} /* cachedIo_advise */
 
-    return NULL;  /* don't know this error code. */
-} /* PHYSFS_getErrorByCode */
+static int cachedIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    /* the data is read-only, so what's in the cache never goes stale. */
+    return __PHYSFS_ioBacking(((CachedIoInfo *) io->opaque)->io, backing);
+} /* cachedIo_backing */
 
+static const PHYSFS_Io __PHYSFS_cachedIoInterface =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    cachedIo_read,
+    cachedIo_write,
+    cachedIo_seek,
+    cachedIo_tell,
+    cachedIo_length,
+    cachedIo_duplicate,
+    cachedIo_flush,
+    cachedIo_destroy,
+    cachedIo_map,
+    cachedIo_readAt,
+    NULL,  /* readv */
+    cachedIo_advise,
+    cachedIo_backing,
+    NULL   /* raw: it's whatever it is already. */
+};
 
-void PHYSFS_setErrorCode(PHYSFS_ErrorCode errcode)
+/* A new Io on (sh), which owns (io) if this works. Counts itself in (sh). */
+static PHYSFS_Io *createCachedIo(CachedIoShared *sh, PHYSFS_Io *io)
 {
-    ErrState *err;
+    PHYSFS_Io *retval = NULL;
+    CachedIoInfo *info = NULL;
 
-    if (!errcode)
-        return;
+    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, createCachedIo_failed);
+    info = (CachedIoInfo *) allocator.Malloc(sizeof (CachedIoInfo));
+    GOTO_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, createCachedIo_failed);
 
-    err = findErrorForCurrentThread();
-    if (err == NULL)
-    {
-        err = (ErrState *) allocator.Malloc(sizeof (ErrState));
-        if (err == NULL)
-            return;   /* uhh...? */
+    __PHYSFS_platformGrabMutex(sh->lock);
+    sh->refcount++;
+    __PHYSFS_platformReleaseMutex(sh->lock);
 
-        memset(err, '\0', sizeof (ErrState));
-        err->tid = __PHYSFS_platformGetThreadID();
+    info->shared = sh;
+    info->io = io;
+    info->pos = 0;
+    memcpy(retval, &__PHYSFS_cachedIoInterface, sizeof (*retval));
+    retval->opaque = info;
+    return retval;
 
-        if (errorLock != NULL)
-            __PHYSFS_platformGrabMutex(errorLock);
+createCachedIo_failed:
+    if (info != NULL) allocator.Free(info);
+    if (retval != NULL) allocator.Free(retval);
+    return NULL;
+} /* createCachedIo */
 
-        err->next = errorStates;
-        errorStates = err;
+PHYSFS_Io *__PHYSFS_createCachedIo(PHYSFS_Io *io, PHYSFS_uint32 blockSize,
+                                   PHYSFS_uint32 capacity)
+{
+    const PHYSFS_sint64 len = io->length(io);
+    CachedIoShared *sh = NULL;
+    PHYSFS_Io *retval;
+    PHYSFS_uint32 buckets = 1;
+
+    BAIL_IF_MACRO(len < 0, ERRPASS, NULL);
+    BAIL_IF_MACRO(blockSize == 0, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(capacity == 0, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+
+    while ((buckets < capacity) && (buckets < 0x80000000))
+        buckets <<= 1;
+
+    sh = (CachedIoShared *) allocator.Malloc(sizeof (CachedIoShared));
+    BAIL_IF_MACRO(!sh, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(sh, '\0', sizeof (*sh));
+    sh->buckets = (CachedIoBlock **)
+                    allocator.Malloc(buckets * sizeof (CachedIoBlock *));
+    GOTO_IF_MACRO(!sh->buckets, PHYSFS_ERR_OUT_OF_MEMORY, createCached_failed);
+    memset(sh->buckets, '\0', buckets * sizeof (CachedIoBlock *));
+    sh->lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!sh->lock, ERRPASS, createCached_failed);
+    sh->bucketmask = buckets - 1;
+    sh->blockSize = blockSize;
+    sh->capacity = capacity;
+    sh->length = (PHYSFS_uint64) len;
+
+    retval = createCachedIo(sh, io);
+    GOTO_IF_MACRO(!retval, ERRPASS, createCached_failed);
+    return retval;
 
-        if (errorLock != NULL)
-            __PHYSFS_platformReleaseMutex(errorLock);
-    } /* if */
+createCached_failed:
+    if (sh->lock != NULL) __PHYSFS_platformDestroyMutex(sh->lock);
+    allocator.Free(sh->buckets);
+    allocator.Free(sh);
+    return NULL;
+} /* __PHYSFS_createCachedIo */
 
-    err->code = errcode;
-} /* PHYSFS_setErrorCode */
+PHYSFS_Io *__PHYSFS_uncacheIo(PHYSFS_Io *io)
+{
+    CachedIoInfo *info = (CachedIoInfo *) io->opaque;
+    PHYSFS_Io *retval = info->io;
+    releaseCachedIoShared(info->shared);
+    allocator.Free(info);
+    allocator.Free(io);
+    return retval;
+} /* __PHYSFS_uncacheIo */
 
 
-const char *PHYSFS_getLastError(void)
+/* PHYSFS_Io implementation over data that's still arriving... */
+
+#define DOWNLOAD_MAX_WANTED 64
+
+typedef struct
 {
-    const PHYSFS_ErrorCode err = PHYSFS_getLastErrorCode();
-    return (err) ? PHYSFS_getErrorByCode(err) : NULL;
-} /* PHYSFS_getLastError */
+    PHYSFS_uint64 start;
+    PHYSFS_uint64 end;  /* one past the last byte. */
+    int read;  /* nonzero if a read needed it, zero if it was only advised. */
+} DownloadRange;
 
+/* What the app's handle and every Io reading through it share. */
+struct PHYSFS_Download
+{
+    void *lock;
+    void *arrived;  /* posted once per waiter when data arrives. */
+    PHYSFS_uint32 refcount;
+    PHYSFS_uint32 waiters;
+    PHYSFS_uint32 generation;  /* bumped every time waiters are posted. */
+    PHYSFS_uint32 waitMs;
+    int cancelled;
+    PHYSFS_uint64 length;
+    DownloadRange *have;  /* sorted, and never overlapping or touching. */
+    PHYSFS_uint32 haveCount;
+    PHYSFS_uint32 haveAllocated;
+    DownloadRange wanted[DOWNLOAD_MAX_WANTED];  /* oldest first. */
+    PHYSFS_uint32 wantedCount;
+};
 
-/* MAKE SURE that errorLock is held before calling this! */
-static void freeErrorStates(void)
+typedef struct
 {
-    ErrState *i;
-    ErrState *next;
+    PHYSFS_Download *shared;
+    PHYSFS_Io *io;  /* our own duplicate of the data. */
+    PHYSFS_uint64 pos;
+} DownloadIoInfo;
 
-    for (i = errorStates; i != NULL; i = next)
+/* index of the first range in (dl) that ends at or after (pos). */
+static PHYSFS_uint32 downloadFindRange(const PHYSFS_Download *dl,
+                                       const PHYSFS_uint64 pos)
+{
+    PHYSFS_uint32 lo = 0;
+    PHYSFS_uint32 hi = dl->haveCount;
+    while (lo < hi)
     {
-        next = i->next;
-        allocator.Free(i);
-    } /* for */
+        const PHYSFS_uint32 mid = lo + ((hi - lo) / 2);
+        if (dl->have[mid].end < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    } /* while */
+    return lo;
+} /* downloadFindRange */
 
-    errorStates = NULL;
-} /* freeErrorStates */
+static int downloadHas(const PHYSFS_Download *dl, const PHYSFS_uint64 start,
+                       const PHYSFS_uint64 end)
+{
+    const PHYSFS_uint32 i = downloadFindRange(dl, end);
+    if (start == end)
+        return 1;
+    return ((i < dl->haveCount) && (dl->have[i].start <= start));
+} /* downloadHas */
 
+static int downloadIsComplete(const PHYSFS_Download *dl)
+{
+    return downloadHas(dl, 0, dl->length);
+} /* downloadIsComplete */
 
-void PHYSFS_getLinkedVersion(PHYSFS_Version *ver)
+/* Merge [start, end) into what (dl) has. Caller holds the lock. */
+static int downloadAdd(PHYSFS_Download *dl, PHYSFS_uint64 start,
+                       PHYSFS_uint64 end)
 {
-    if (ver != NULL)
+    const PHYSFS_uint32 first = downloadFindRange(dl, start);
+    PHYSFS_uint32 last = first;  /* one past the ranges this swallows. */
+    DownloadRange *r;
+
+    while ((last < dl->haveCount) && (dl->have[last].start <= end))
+        last++;
+
+    if (first == last)  /* touches nothing; needs a slot of its own. */
     {
-        ver->major = PHYSFS_VER_MAJOR;
-        ver->minor = PHYSFS_VER_MINOR;
-        ver->patch = PHYSFS_VER_PATCH;
+        if (dl->haveCount == dl->haveAllocated)
+        {
+            const PHYSFS_uint32 count = (dl->haveAllocated * 2) + 8;
+            void *ptr = allocator.Realloc(dl->have, count * sizeof (*r));
+            BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+            dl->have = (DownloadRange *) ptr;
+            dl->haveAllocated = count;
+        } /* if */
+
+        r = &dl->have[first];
+        memmove(r + 1, r, (dl->haveCount - first) * sizeof (*r));
+        dl->haveCount++;
+        r->start = start;
+        r->end = end;
+        r->read = 0;
+        return 1;
     } /* if */
-} /* PHYSFS_getLinkedVersion */
 
+    r = &dl->have[first];
+    if (r->start < start)
+        start = r->start;
+    if (dl->have[last - 1].end > end)
+        end = dl->have[last - 1].end;
+    r->start = start;
+    r->end = end;
+    memmove(r + 1, &dl->have[last], (dl->haveCount - last) * sizeof (*r));
+    dl->haveCount -= (last - first) - 1;
+    return 1;
+} /* downloadAdd */
 
-static const char *find_filename_extension(const char *fname)
+/* Note that someone wants [start, end). Caller holds the lock. */
+static void downloadWant(PHYSFS_Download *dl, const PHYSFS_uint64 start,
+                         const PHYSFS_uint64 end, const int read)
 {
-    const char *retval = NULL;
-    if (fname != NULL)
-    {
-        const char *p = strchr(fname, '.');
-        retval = p;
+    DownloadRange *r;
+    PHYSFS_uint32 i;
 
-        while (p != NULL)
+    for (i = 0; i < dl->wantedCount; i++)
+    {
+        r = &dl->wanted[i];
+        if ((r->start <= start) && (r->end >= end))
         {
-            p = strchr(p + 1, '.');
-            if (p != NULL)
-                retval = p;
-        } /* while */
+            r->read |= read;  /* already asked for. */
+            return;
+        } /* if */
+    } /* for */
 
-        if (retval != NULL)
-            retval++;  /* skip '.' */
+    /* full? The oldest asked first, but whoever wants it has likely
+       moved on, or is still waiting and will ask again. */
+    if (dl->wantedCount == DOWNLOAD_MAX_WANTED)
+    {
+        dl->wantedCount--;
+        memmove(dl->wanted, dl->wanted + 1, dl->wantedCount * sizeof (*r));
     } /* if */
 
-    return retval;
-} /* find_filename_extension */
+    r = &dl->wanted[dl->wantedCount++];
+    r->start = start;
+    r->end = end;
+    r->read = read;
+} /* downloadWant */
 
+/* Wake everything waiting on (dl). Caller holds the lock. */
+static void downloadWake(PHYSFS_Download *dl)
+{
+    while (dl->waiters > 0)
+    {
+        __PHYSFS_platformPostSemaphore(dl->arrived);
+        dl->waiters--;
+    } /* while */
+    dl->generation++;
+} /* downloadWake */
 
-static DirHandle *tryOpenDir(PHYSFS_Io *io, const PHYSFS_Archiver *funcs,
-                             const char *d, int forWriting)
+static void releaseDownload(PHYSFS_Download *dl)
 {
-    DirHandle *retval = NULL;
-    void *opaque = NULL;
+    PHYSFS_uint32 refcount;
 
-    if (io != NULL)
-        BAIL_IF_MACRO(!io->seek(io, 0), ERRPASS, NULL);
+    __PHYSFS_platformGrabMutex(dl->lock);
+    refcount = --dl->refcount;
+    __PHYSFS_platformReleaseMutex(dl->lock);
 
-    opaque = funcs->openArchive(io, d, forWriting);
-    if (opaque != NULL)
+    if (refcount == 0)
     {
-        retval = (DirHandle *) allocator.Malloc(sizeof (DirHandle));
-        if (retval == NULL)
-            funcs->closeArchive(opaque);
-        else
-        {
-            memset(retval, '\0', sizeof (DirHandle));
-            retval->mountPoint = NULL;
-            retval->funcs = funcs;
-            retval->opaque = opaque;
-        } /* else */
+        __PHYSFS_platformDestroySemaphore(dl->arrived);
+        __PHYSFS_platformDestroyMutex(dl->lock);
+        allocator.Free(dl->have);
+        allocator.Free(dl);
     } /* if */
+} /* releaseDownload */
 
-    return retval;
-} /* tryOpenDir */
-
-
-static DirHandle *openDirectory(PHYSFS_Io *io, const char *d, int forWriting)
+static PHYSFS_sint64 downloadIo_readAt(PHYSFS_Io *io, void *buf,
+                                       PHYSFS_uint64 len, PHYSFS_uint64 pos)
 {
-    DirHandle *retval = NULL;
-    const PHYSFS_Archiver **i;
-    const char *ext;
-    int created_io = 0;
+    DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    PHYSFS_Download *dl = info->shared;
+    PHYSFS_uint64 end;
 
-    assert((io != NULL) || (d != NULL));
+    if (pos >= dl->length)
+        return 0;
+    else if (len > dl->length - pos)
+        len = dl->length - pos;
+    end = pos + len;
 
-    if (io == NULL)
+    __PHYSFS_platformGrabMutex(dl->lock);
+    while (!downloadHas(dl, pos, end))
     {
-        /* DIR gets first shot (unlike the rest, it doesn't deal with files). */
-        extern const PHYSFS_Archiver __PHYSFS_Archiver_DIR;
-        retval = tryOpenDir(io, &__PHYSFS_Archiver_DIR, d, forWriting);
-        if (retval != NULL)
-            return retval;
+        const PHYSFS_uint32 generation = dl->generation;
+        int rc = 1;
 
-        io = __PHYSFS_createNativeIo(d, forWriting ? 'w' : 'r');
-        BAIL_IF_MACRO(!io, ERRPASS, 0);
-        created_io = 1;
-    } /* if */
+        BAIL_IF_MACRO_MUTEX(dl->cancelled, PHYSFS_ERR_CANCELLED, dl->lock, -1);
+        downloadWant(dl, pos, end, 1);
+        BAIL_IF_MACRO_MUTEX(!dl->waitMs, PHYSFS_ERR_UNAVAILABLE, dl->lock, -1);
 
-    ext = find_filename_extension(d);
-    if (ext != NULL)
-    {
-        /* Look for archivers with matching file extensions first... */
-        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
-        {
-            if (__PHYSFS_utf8stricmp(ext, (*i)->info.extension) == 0)
-                retval = tryOpenDir(io, *i, d, forWriting);
-        } /* for */
+        dl->waiters++;
+        __PHYSFS_platformReleaseMutex(dl->lock);
+        if (dl->waitMs == PHYSFS_DOWNLOAD_WAIT_FOREVER)
+            __PHYSFS_platformWaitSemaphore(dl->arrived);
+        else
+            rc = __PHYSFS_platformWaitSemaphoreTimeout(dl->arrived, dl->waitMs);
+        __PHYSFS_platformGrabMutex(dl->lock);
 
-        /* failing an exact file extension match, try all the others... */
-        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
+        if (!rc)
         {
-            if (__PHYSFS_utf8stricmp(ext, (*i)->info.extension) != 0)
-                retval = tryOpenDir(io, *i, d, forWriting);
-        } /* for */
-    } /* if */
+            /* if nothing was posted for us, stop counting us. If it was, the
+               leftover post just wakes someone else to check again. */
+            if (dl->generation == generation)
+                dl->waiters--;
+            if (!downloadHas(dl, pos, end))
+                BAIL_MACRO_MUTEX(PHYSFS_ERR_UNAVAILABLE, dl->lock, -1);
+        } /* if */
+    } /* while */
+    __PHYSFS_platformReleaseMutex(dl->lock);
 
-    else  /* no extension? Try them all. */
-    {
-        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
-            retval = tryOpenDir(io, *i, d, forWriting);
-    } /* else */
+    return __PHYSFS_ioReadAt(info->io, buf, len, pos);
+} /* downloadIo_readAt */
 
-    if ((!retval) && (created_io))
+static PHYSFS_sint64 downloadIo_read(PHYSFS_Io *io, void *buf,
+                                     PHYSFS_uint64 len)
+{
+    DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    const PHYSFS_sint64 rc = downloadIo_readAt(io, buf, len, info->pos);
+    if (rc > 0)
+        info->pos += (PHYSFS_uint64) rc;
+    return rc;
+} /* downloadIo_read */
+
+static PHYSFS_sint64 downloadIo_write(PHYSFS_Io *io, const void *b,
+                                      PHYSFS_uint64 len)
+{
+    BAIL_MACRO(PHYSFS_ERR_OPEN_FOR_READING, -1);
+} /* downloadIo_write */
+
+static int downloadIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    BAIL_IF_MACRO(offset > info->shared->length, PHYSFS_ERR_PAST_EOF, 0);
+    info->pos = offset;
+    return 1;
+} /* downloadIo_seek */
+
+static PHYSFS_sint64 downloadIo_tell(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((DownloadIoInfo *) io->opaque)->pos;
+} /* downloadIo_tell */
+
+static PHYSFS_sint64 downloadIo_length(PHYSFS_Io *io)
+{
+    return (PHYSFS_sint64) ((DownloadIoInfo *) io->opaque)->shared->length;
+} /* downloadIo_length */
+
+static PHYSFS_Io *createDownloadIo(PHYSFS_Download *dl, PHYSFS_Io *io);
+
+static PHYSFS_Io *downloadIo_duplicate(PHYSFS_Io *io)
+{
+    const DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    PHYSFS_Io *dup = info->io->duplicate(info->io);
+    PHYSFS_Io *retval;
+
+    BAIL_IF_MACRO(!dup, ERRPASS, NULL);
+    retval = createDownloadIo(info->shared, dup);
+    if (retval == NULL)
+        dup->destroy(dup);
+    return retval;
+} /* downloadIo_duplicate */
+
+static int downloadIo_flush(PHYSFS_Io *io) { return 1;  /* it's read-only. */ }
+
+static void downloadIo_destroy(PHYSFS_Io *io)
+{
+    DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    info->io->destroy(info->io);
+    releaseDownload(info->shared);
+    allocator.Free(info);
+    allocator.Free(io);
+} /* downloadIo_destroy */
+
+/* Mapping or going around us is only safe once there are no holes left. */
+static int downloadIo_complete(PHYSFS_Io *io)
+{
+    PHYSFS_Download *dl = ((DownloadIoInfo *) io->opaque)->shared;
+    int retval;
+    __PHYSFS_platformGrabMutex(dl->lock);
+    retval = downloadIsComplete(dl);
+    __PHYSFS_platformReleaseMutex(dl->lock);
+    return retval;
+} /* downloadIo_complete */
+
+static int downloadIo_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    BAIL_IF_MACRO(!downloadIo_complete(io), PHYSFS_ERR_UNSUPPORTED, 0);
+    return __PHYSFS_ioMap(((DownloadIoInfo *) io->opaque)->io, ptr, len);
+} /* downloadIo_map */
+
+static int downloadIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                             PHYSFS_uint64 len, int hint)
+{
+    DownloadIoInfo *info = (DownloadIoInfo *) io->opaque;
+    PHYSFS_Download *dl = info->shared;
+
+    if ((hint == PHYSFS_ACCESS_WILLNEED) && (offset < dl->length))
+    {
+        if ((len == 0) || (len > dl->length - offset))
+            len = dl->length - offset;  /* zero means "to the end." */
+        __PHYSFS_platformGrabMutex(dl->lock);
+        if (!downloadHas(dl, offset, offset + len))
+            downloadWant(dl, offset, offset + len, 0);
+        __PHYSFS_platformReleaseMutex(dl->lock);
+    } /* if */
+
+    return __PHYSFS_ioAdvise(info->io, offset, len, hint);
+} /* downloadIo_advise */
+
+static int downloadIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    BAIL_IF_MACRO(!downloadIo_complete(io), PHYSFS_ERR_UNSUPPORTED, 0);
+    return __PHYSFS_ioBacking(((DownloadIoInfo *) io->opaque)->io, backing);
+} /* downloadIo_backing */
+
+static const PHYSFS_Io __PHYSFS_downloadIoInterface =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    downloadIo_read,
+    downloadIo_write,
+    downloadIo_seek,
+    downloadIo_tell,
+    downloadIo_length,
+    downloadIo_duplicate,
+    downloadIo_flush,
+    downloadIo_destroy,
+    downloadIo_map,
+    downloadIo_readAt,
+    NULL,  /* readv */
+    downloadIo_advise,
+    downloadIo_backing,
+    NULL   /* raw: it's whatever it is already. */
+};
+
+/* A new Io on (dl), which owns (io) if this works. Counts itself in (dl). */
+static PHYSFS_Io *createDownloadIo(PHYSFS_Download *dl, PHYSFS_Io *io)
+{
+    PHYSFS_Io *retval = NULL;
+    DownloadIoInfo *info = NULL;
+
+    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, createDownloadIo_failed);
+    info = (DownloadIoInfo *) allocator.Malloc(sizeof (DownloadIoInfo));
+    GOTO_IF_MACRO(!info, PHYSFS_ERR_OUT_OF_MEMORY, createDownloadIo_failed);
+
+    __PHYSFS_platformGrabMutex(dl->lock);
+    dl->refcount++;
+    __PHYSFS_platformReleaseMutex(dl->lock);
+
+    info->shared = dl;
+    info->io = io;
+    info->pos = 0;
+    memcpy(retval, &__PHYSFS_downloadIoInterface, sizeof (*retval));
+    retval->opaque = info;
+    return retval;
+
+createDownloadIo_failed:
+    if (info != NULL) allocator.Free(info);
+    if (retval != NULL) allocator.Free(retval);
+    return NULL;
+} /* createDownloadIo */
+
+PHYSFS_Download *PHYSFS_createDownload(PHYSFS_uint64 length,
+                                       PHYSFS_uint32 waitMs)
+{
+    PHYSFS_Download *dl;
+
+    dl = (PHYSFS_Download *) allocator.Malloc(sizeof (PHYSFS_Download));
+    BAIL_IF_MACRO(!dl, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(dl, '\0', sizeof (*dl));
+    dl->lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!dl->lock, ERRPASS, createDownload_failed);
+    dl->arrived = __PHYSFS_platformCreateSemaphore();
+    GOTO_IF_MACRO(!dl->arrived, ERRPASS, createDownload_failed);
+    dl->refcount = 1;  /* the app's. */
+    dl->waitMs = waitMs;
+    dl->length = length;
+    return dl;
+
+createDownload_failed:
+    if (dl->lock != NULL) __PHYSFS_platformDestroyMutex(dl->lock);
+    allocator.Free(dl);
+    return NULL;
+} /* PHYSFS_createDownload */
+
+PHYSFS_Io *PHYSFS_createDownloadIo(PHYSFS_Download *dl, PHYSFS_Io *io)
+{
+    BAIL_IF_MACRO(!dl || !io, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(io->version > CURRENT_PHYSFS_IO_API_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    return createDownloadIo(dl, io);
+} /* PHYSFS_createDownloadIo */
+
+int PHYSFS_downloadArrived(PHYSFS_Download *dl, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len)
+{
+    PHYSFS_uint32 i, j;
+
+    BAIL_IF_MACRO(!dl, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(offset > dl->length, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(len > dl->length - offset, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    if (len == 0)
+        return 1;
+
+    __PHYSFS_platformGrabMutex(dl->lock);
+    BAIL_IF_MACRO_MUTEX(!downloadAdd(dl, offset, offset + len),
+                        ERRPASS, dl->lock, 0);
+
+    /* stop asking for what's all here now. */
+    for (i = j = 0; i < dl->wantedCount; i++)
+    {
+        const DownloadRange *r = &dl->wanted[i];
+        if (!downloadHas(dl, r->start, r->end))
+            dl->wanted[j++] = *r;
+    } /* for */
+    dl->wantedCount = j;
+
+    downloadWake(dl);
+    __PHYSFS_platformReleaseMutex(dl->lock);
+    return 1;
+} /* PHYSFS_downloadArrived */
+
+PHYSFS_uint32 PHYSFS_downloadWanted(PHYSFS_Download *dl,
+                                    PHYSFS_uint64 *offsets,
+                                    PHYSFS_uint64 *lens, PHYSFS_uint32 max)
+{
+    PHYSFS_uint32 retval = 0;
+    int pass;
+
+    BAIL_IF_MACRO(!dl, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO((max > 0) && (!offsets || !lens),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    __PHYSFS_platformGrabMutex(dl->lock);
+
+    /* what reads are stuck on first, then what was advised, oldest first. */
+    for (pass = 1; pass >= 0; pass--)
+    {
+        PHYSFS_uint32 i;
+        for (i = 0; i < dl->wantedCount; i++)
+        {
+            const DownloadRange *r = &dl->wanted[i];
+            PHYSFS_uint64 pos = r->start;
+            PHYSFS_uint32 h;
+
+            if (r->read != pass)
+                continue;
+
+            /* report the holes in it, not the parts that are here. */
+            h = downloadFindRange(dl, pos);
+            while ((pos < r->end) && (retval < max))
+            {
+                if ((h < dl->haveCount) && (dl->have[h].start <= pos))
+                    pos = dl->have[h++].end;
+                else
+                {
+                    PHYSFS_uint64 end = r->end;
+                    if ((h < dl->haveCount) && (dl->have[h].start < end))
+                        end = dl->have[h].start;
+                    offsets[retval] = pos;
+                    lens[retval] = end - pos;
+                    retval++;
+                    pos = end;
+                } /* else */
+            } /* while */
+        } /* for */
+    } /* for */
+
+    __PHYSFS_platformReleaseMutex(dl->lock);
+    return retval;
+} /* PHYSFS_downloadWanted */
+
+void PHYSFS_cancelDownload(PHYSFS_Download *dl)
+{
+    if (dl != NULL)
+    {
+        __PHYSFS_platformGrabMutex(dl->lock);
+        dl->cancelled = 1;
+        downloadWake(dl);
+        __PHYSFS_platformReleaseMutex(dl->lock);
+    } /* if */
+} /* PHYSFS_cancelDownload */
+
+void PHYSFS_destroyDownload(PHYSFS_Download *dl)
+{
+    if (dl != NULL)
+    {
+        /* nothing else can arrive, so don't let anything wait for it. */
+        PHYSFS_cancelDownload(dl);
+        releaseDownload(dl);
+    } /* if */
+} /* PHYSFS_destroyDownload */
+
+
+/*
+ * If (io) ends with an embedded archive trailer, return a slice of the
+ *  archive it points to (which owns (io)), otherwise just (io). This is only an
+ *  optimization, so anything odd about the trailer leaves (io) as-is for the
+ *  archivers to search the usual way, and sets no error.
+ */
+static PHYSFS_Io *openEmbeddedArchive(PHYSFS_Io *io)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    PHYSFS_uint8 trailer[PHYSFS_EMBEDDED_TRAILER_SIZE];
+    PHYSFS_Io *retval = io;
+    PHYSFS_uint64 offset;
+    PHYSFS_uint64 len;
+    PHYSFS_sint64 filelen = io->length(io);
+
+    if ((filelen >= (PHYSFS_sint64) sizeof (trailer)) &&
+        (io->seek(io, filelen - sizeof (trailer))) &&
+        (__PHYSFS_readAll(io, trailer, sizeof (trailer))) &&
+        (memcmp(trailer + 16, PHYSFS_EMBEDDED_TRAILER_MAGIC, 8) == 0))
+    {
+        memcpy(&offset, trailer, sizeof (offset));
+        memcpy(&len, trailer + 8, sizeof (len));
+        offset = PHYSFS_swapULE64(offset);
+        len = PHYSFS_swapULE64(len);
+        filelen -= sizeof (trailer);
+        if ((len <= (PHYSFS_uint64) filelen) &&
+            (offset <= ((PHYSFS_uint64) filelen) - len))
+        {
+            retval = __PHYSFS_createSliceIo(io, offset, len);
+            if (retval == NULL)
+                retval = io;
+        } /* if */
+    } /* if */
+
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+
+    if ((retval == io) && (!io->seek(io, 0)))
+    {
         io->destroy(io);
+        return NULL;
+    } /* if */
+
+    return retval;
+} /* openEmbeddedArchive */
+
+
+PHYSFS_Io *__PHYSFS_createArchiveIo(const char *path)
+{
+    PHYSFS_Io *io = __PHYSFS_createMappedIo(path);
+    if (io == NULL)
+        io = __PHYSFS_createNativeIo(path, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, NULL);
+    return openEmbeddedArchive(io);
+} /* __PHYSFS_createArchiveIo */
+
+
+/* PHYSFS_Io implementation for i/o to a PHYSFS_File... */
+
+static PHYSFS_sint64 handleIo_read(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len)
+{
+    return PHYSFS_readBytes((PHYSFS_File *) io->opaque, buf, len);
+} /* handleIo_read */
+
+static PHYSFS_sint64 handleIo_write(PHYSFS_Io *io, const void *buffer,
+                                    PHYSFS_uint64 len)
+{
+    return PHYSFS_writeBytes((PHYSFS_File *) io->opaque, buffer, len);
+} /* handleIo_write */
+
+static int handleIo_seek(PHYSFS_Io *io, PHYSFS_uint64 offset)
+{
+    return PHYSFS_seek((PHYSFS_File *) io->opaque, offset);
+} /* handleIo_seek */
+
+static PHYSFS_sint64 handleIo_tell(PHYSFS_Io *io)
+{
+    return PHYSFS_tell((PHYSFS_File *) io->opaque);
+} /* handleIo_tell */
+
+static PHYSFS_sint64 handleIo_length(PHYSFS_Io *io)
+{
+    return PHYSFS_fileLength((PHYSFS_File *) io->opaque);
+} /* handleIo_length */
+
+static PHYSFS_Io *handleIo_duplicate(PHYSFS_Io *io)
+{
+    /*
+     * There's no duplicate at the PHYSFS_File level, so we break the
+     *  abstraction. We're allowed to: we're physfs.c!
+     */
+    FileHandle *origfh = (FileHandle *) io->opaque;
+    FileHandle *newfh = allocFileHandle(origfh->dirHandle);
+    PHYSFS_Io *retval = NULL;
+    PHYSFS_Context *ctx;
+
+    GOTO_IF_MACRO(!newfh, ERRPASS, handleIo_dupe_failed);
+
+    retval = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, handleIo_dupe_failed);
+
+#if 0  /* we don't buffer the duplicate, at least not at the moment. */
+    if (origfh->buffer != NULL)
+    {
+        newfh->buffer = allocFileBuffer(newfh->dirHandle->mem,
+                                        origfh->bufsize);
+        if (!newfh->buffer)
+            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, handleIo_dupe_failed);
+        newfh->bufsize = origfh->bufsize;
+    } /* if */
+#endif
+
+    newfh->io = origfh->io->duplicate(origfh->io);
+    GOTO_IF_MACRO(!newfh->io, ERRPASS, handleIo_dupe_failed);
+
+    newfh->forReading = origfh->forReading;
+
+    ctx = newfh->dirHandle->ctx;
+    grabLock(ctx->lock);
+    linkFileHandle(newfh->forReading ? &ctx->openReadList :
+                   &ctx->openWriteList, newfh);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    memcpy(retval, io, sizeof (PHYSFS_Io));
+    retval->opaque = newfh;
+    return retval;
+
+handleIo_dupe_failed:
+    if (newfh)
+    {
+        if (newfh->io != NULL) newfh->io->destroy(newfh->io);
+        freeFileBuffer(newfh->dirHandle->mem, newfh->buffer,
+                       newfh->bufsize);
+        freeFileHandle(newfh);
+    } /* if */
+
+    return NULL;
+} /* handleIo_duplicate */
+
+static int handleIo_flush(PHYSFS_Io *io)
+{
+    return PHYSFS_flush((PHYSFS_File *) io->opaque);
+} /* handleIo_flush */
+
+static void handleIo_destroy(PHYSFS_Io *io)
+{
+    if (io->opaque != NULL)
+        PHYSFS_close((PHYSFS_File *) io->opaque);
+    allocator.Free(io);
+} /* handleIo_destroy */
+
+static int handleIo_map(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
+{
+    return PHYSFS_mapRead((PHYSFS_File *) io->opaque, ptr, len);
+} /* handleIo_map */
+
+static PHYSFS_sint64 handleIo_readAt(PHYSFS_Io *io, void *buf,
+                                     PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    return PHYSFS_readAt((PHYSFS_File *) io->opaque, buf, len, pos);
+} /* handleIo_readAt */
+
+static int handleIo_advise(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                           PHYSFS_uint64 len, int hint)
+{
+    return __PHYSFS_ioAdvise(((FileHandle *) io->opaque)->io, offset, len,
+                             hint);
+} /* handleIo_advise */
+
+static int handleIo_backing(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    return PHYSFS_getFileBacking((PHYSFS_File *) io->opaque, backing);
+} /* handleIo_backing */
+
+static const PHYSFS_Io __PHYSFS_handleIoInterface =
+{
+    CURRENT_PHYSFS_IO_API_VERSION, NULL,
+    handleIo_read,
+    handleIo_write,
+    handleIo_seek,
+    handleIo_tell,
+    handleIo_length,
+    handleIo_duplicate,
+    handleIo_flush,
+    handleIo_destroy,
+    handleIo_map,
+    handleIo_readAt,
+    NULL,  /* readv */
+    handleIo_advise,
+    handleIo_backing
+};
+
+static PHYSFS_Io *__PHYSFS_createHandleIo(PHYSFS_File *f)
+{
+    PHYSFS_Io *io = (PHYSFS_Io *) allocator.Malloc(sizeof (PHYSFS_Io));
+    BAIL_IF_MACRO(!io, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memcpy(io, &__PHYSFS_handleIoInterface, sizeof (*io));
+    io->opaque = f;
+    return io;
+} /* __PHYSFS_createHandleIo */
+
+
+/* functions ... */
+
+/*
+ * String lists we hand to the application are a single allocation: the
+ *  null-terminated array of pointers, followed by the strings themselves,
+ *  so PHYSFS_freeList() only has to free one block. We gather the strings
+ *  into a growing pool first, and build that block once we have them all.
+ */
+typedef struct
+{
+    char *names;  /* every string so far, each null-terminated. */
+    size_t names_len;
+    size_t names_allocated;
+    size_t *offsets;  /* where each string starts in (names). */
+    PHYSFS_uint32 size;
+    PHYSFS_uint32 allocated;
+    PHYSFS_ErrorCode errcode;
+} EnumStringListCallbackData;
+
+static void addToStringList(EnumStringListCallbackData *pecd, const char *str)
+{
+    const size_t len = strlen(str) + 1;
+
+    if (pecd->errcode)
+        return;
+
+    if (pecd->size == pecd->allocated)
+    {
+        const PHYSFS_uint32 newalloc = pecd->allocated ? pecd->allocated * 2 : 64;
+        void *ptr = allocator.Realloc(pecd->offsets, newalloc * sizeof (size_t));
+        if (ptr == NULL)
+        {
+            pecd->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return;
+        } /* if */
+        pecd->offsets = (size_t *) ptr;
+        pecd->allocated = newalloc;
+    } /* if */
+
+    if (pecd->names_allocated - pecd->names_len < len)
+    {
+        size_t newalloc = pecd->names_allocated ? pecd->names_allocated : 1024;
+        void *ptr;
+        while (newalloc - pecd->names_len < len)
+            newalloc *= 2;
+        ptr = allocator.Realloc(pecd->names, newalloc);
+        if (ptr == NULL)
+        {
+            pecd->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return;
+        } /* if */
+        pecd->names = (char *) ptr;
+        pecd->names_allocated = newalloc;
+    } /* if */
+
+    memcpy(pecd->names + pecd->names_len, str, len);
+    pecd->offsets[pecd->size++] = pecd->names_len;
+    pecd->names_len += len;
+} /* addToStringList */
+
+
+static int cmpStringListItems(void *_a, size_t one, size_t two)
+{
+    const EnumStringListCallbackData *pecd = (EnumStringListCallbackData *) _a;
+    return strcmp(pecd->names + pecd->offsets[one],
+                  pecd->names + pecd->offsets[two]);
+} /* cmpStringListItems */
+
+
+static void swapStringListItems(void *_a, size_t one, size_t two)
+{
+    EnumStringListCallbackData *pecd = (EnumStringListCallbackData *) _a;
+    const size_t tmp = pecd->offsets[one];
+    pecd->offsets[one] = pecd->offsets[two];
+    pecd->offsets[two] = tmp;
+} /* swapStringListItems */
+
+
+/*
+ * Build the final list from what (pecd) gathered, and free the pool. If
+ *  (sorted), the list comes out in strcmp() order with duplicates removed.
+ */
+static char **finishStringList(EnumStringListCallbackData *pecd, int sorted)
+{
+    char **list = NULL;
+    char *dst;
+    const char *prev = NULL;
+    size_t total = 0;
+    PHYSFS_uint32 count = 0;
+    PHYSFS_uint32 i;
+
+    GOTO_IF_MACRO(pecd->errcode, pecd->errcode, finishStringListEnd);
+
+    if (sorted)
+    {
+        __PHYSFS_sort(pecd, pecd->size, cmpStringListItems, swapStringListItems);
+
+        /* squeeze out the duplicates, now that they're all next to each other. */
+        for (i = 0; i < pecd->size; i++)
+        {
+            const char *str = pecd->names + pecd->offsets[i];
+            if ((prev == NULL) || (strcmp(prev, str) != 0))
+            {
+                pecd->offsets[count++] = pecd->offsets[i];
+                total += strlen(str) + 1;
+            } /* if */
+            prev = str;
+        } /* for */
+    } /* if */
+    else
+    {
+        count = pecd->size;
+        total = pecd->names_len;
+    } /* else */
+
+    list = (char **) allocator.Malloc((sizeof (char *) * (count + 1)) + total);
+    GOTO_IF_MACRO(!list, PHYSFS_ERR_OUT_OF_MEMORY, finishStringListEnd);
+
+    dst = (char *) (list + count + 1);
+    for (i = 0; i < count; i++)
+    {
+        const char *str = pecd->names + pecd->offsets[i];
+        const size_t len = strlen(str) + 1;
+        memcpy(dst, str, len);
+        list[i] = dst;
+        dst += len;
+    } /* for */
+    list[count] = NULL;
+
+finishStringListEnd:
+    allocator.Free(pecd->names);
+    allocator.Free(pecd->offsets);
+    return list;
+} /* finishStringList */
+
+
+static void enumStringListCallback(void *data, const char *str)
+{
+    addToStringList((EnumStringListCallbackData *) data, str);
+} /* enumStringListCallback */
+
+
+static char **doEnumStringList(void (*func)(PHYSFS_StringCallback, void *))
+{
+    EnumStringListCallbackData ecd;
+    memset(&ecd, '\0', sizeof (ecd));
+    func(enumStringListCallback, &ecd);
+    return finishStringList(&ecd, 0);
+} /* doEnumStringList */
+
+
+static void __PHYSFS_insertion_sort(void *a, size_t lo, size_t hi,
+                                    int (*cmpfn)(void *, size_t, size_t),
+                                    void (*swapfn)(void *, size_t, size_t))
+{
+    size_t i;
+    size_t j;
+
+    for (i = lo + 1; i <= hi; i++)
+    {
+        for (j = i; (j > lo) && (cmpfn(a, j - 1, j) > 0); j--)
+            swapfn(a, j - 1, j);
+    } /* for */
+} /* __PHYSFS_insertion_sort */
+
+
+/* Push element (root) of the heap at (lo), of (count) elements, down. */
+static void __PHYSFS_sift_down(void *a, size_t lo, size_t root, size_t count,
+                               int (*cmpfn)(void *, size_t, size_t),
+                               void (*swapfn)(void *, size_t, size_t))
+{
+    size_t child;
+
+    while ((child = (root * 2) + 1) < count)
+    {
+        if (((child + 1) < count) && (cmpfn(a, lo+child, lo+child+1) < 0))
+            child++;
+        if (cmpfn(a, lo + root, lo + child) >= 0)
+            break;
+        swapfn(a, lo + root, lo + child);
+        root = child;
+    } /* while */
+} /* __PHYSFS_sift_down */
+
+
+static void __PHYSFS_heap_sort(void *a, size_t lo, size_t hi,
+                               int (*cmpfn)(void *, size_t, size_t),
+                               void (*swapfn)(void *, size_t, size_t))
+{
+    const size_t count = (hi - lo) + 1;
+    size_t i;
+
+    for (i = count / 2; i-- > 0; )
+        __PHYSFS_sift_down(a, lo, i, count, cmpfn, swapfn);
+
+    for (i = count - 1; i > 0; i--)
+    {
+        swapfn(a, lo, lo + i);
+        __PHYSFS_sift_down(a, lo, 0, i, cmpfn, swapfn);
+    } /* for */
+} /* __PHYSFS_heap_sort */
+
+
+static void __PHYSFS_intro_sort(void *a, size_t lo, size_t hi, size_t depth,
+                                int (*cmpfn)(void *, size_t, size_t),
+                                void (*swapfn)(void *, size_t, size_t))
+{
+    size_t i;
+    size_t j;
+    size_t v;
+
+    while ((hi - lo) > PHYSFS_QUICKSORT_THRESHOLD)
+    {
+        if (depth-- == 0)  /* bad pivots keep coming; don't go quadratic. */
+        {
+            __PHYSFS_heap_sort(a, lo, hi, cmpfn, swapfn);
+            return;
+        } /* if */
+
+        i = lo + ((hi - lo) / 2);
+
+        if (cmpfn(a, lo, i) > 0) swapfn(a, lo, i);
+        if (cmpfn(a, lo, hi) > 0) swapfn(a, lo, hi);
+        if (cmpfn(a, i, hi) > 0) swapfn(a, i, hi);
+
+        j = hi - 1;
+        swapfn(a, i, j);
+        i = lo;
+        v = j;
+        while (1)
+        {
+            while(cmpfn(a, ++i, v) < 0) { /* do nothing */ }
+            while(cmpfn(a, --j, v) > 0) { /* do nothing */ }
+            if (j < i)
+                break;
+            swapfn(a, i, j);
+        } /* while */
+        if (i != (hi-1))
+            swapfn(a, i, hi-1);
+
+        /* recurse on the smaller side, so the stack stays O(log n). */
+        if ((j - lo) < (hi - i))
+        {
+            __PHYSFS_intro_sort(a, lo, j, depth, cmpfn, swapfn);
+            lo = i + 1;
+        } /* if */
+        else
+        {
+            __PHYSFS_intro_sort(a, i + 1, hi, depth, cmpfn, swapfn);
+            hi = j;
+        } /* else */
+    } /* while */
+
+    __PHYSFS_insertion_sort(a, lo, hi, cmpfn, swapfn);
+} /* __PHYSFS_intro_sort */
+
+
+void __PHYSFS_sort(void *entries, size_t max,
+                   int (*cmpfn)(void *, size_t, size_t),
+                   void (*swapfn)(void *, size_t, size_t))
+{
+    /*
+     * Introsort: quicksort (median of three) until the recursion gets
+     *  deeper than 2*log2(max), which only happens with bad pivots, then
+     *  heapsort for that range. Short ranges get an insertion sort.
+     */
+    size_t depth = 0;
+    size_t n;
+
+    for (n = max; n > 1; n >>= 1)
+        depth += 2;
+
+    if (max > 0)
+        __PHYSFS_intro_sort(entries, 0, max - 1, depth, cmpfn, swapfn);
+} /* __PHYSFS_sort */
+
+
+static ErrState *findErrorForCurrentThread(void)
+{
+    ErrState *i;
+    void *tid;
+
+    /* fast path: no lock, no search. */
+    if (errorTls != NULL)
+        return (ErrState *) __PHYSFS_platformGetThreadLocal(errorTls);
+
+    if (errorLock != NULL)
+        __PHYSFS_platformGrabMutex(errorLock);
+
+    if (errorStates != NULL)
+    {
+        tid = __PHYSFS_platformGetThreadID();
+
+        for (i = errorStates; i != NULL; i = i->next)
+        {
+            if (i->tid == tid)
+            {
+                if (errorLock != NULL)
+                    __PHYSFS_platformReleaseMutex(errorLock);
+                return i;
+            } /* if */
+        } /* for */
+    } /* if */
+
+    if (errorLock != NULL)
+        __PHYSFS_platformReleaseMutex(errorLock);
+
+    return NULL;   /* no error available. */
+} /* findErrorForCurrentThread */
+
+
+/* this doesn't reset the error state. */
+static inline PHYSFS_ErrorCode currentErrorCode(void)
+{
+    const ErrState *err = findErrorForCurrentThread();
+    return err ? err->code : PHYSFS_ERR_OK;
+} /* currentErrorCode */
+
+
+PHYSFS_ErrorCode PHYSFS_getLastErrorCode(void)
+{
+    ErrState *err = findErrorForCurrentThread();
+    const PHYSFS_ErrorCode retval = (err) ? err->code : PHYSFS_ERR_OK;
+    if (err)
+        err->code = PHYSFS_ERR_OK;
+    return retval;
+} /* PHYSFS_getLastErrorCode */
+
+
+PHYSFS_DECL const char *PHYSFS_getErrorByCode(PHYSFS_ErrorCode code)
+{
+    switch (code)
+    {
+        case PHYSFS_ERR_OK: return "no error";
+        case PHYSFS_ERR_OTHER_ERROR: return "unknown error";
+        case PHYSFS_ERR_OUT_OF_MEMORY: return "out of memory";
+        case PHYSFS_ERR_NOT_INITIALIZED: return "not initialized";
+        case PHYSFS_ERR_IS_INITIALIZED: return "already initialized";
+        case PHYSFS_ERR_ARGV0_IS_NULL: return "argv[0] is NULL";
+        case PHYSFS_ERR_UNSUPPORTED: return "unsupported";
+        case PHYSFS_ERR_PAST_EOF: return "past end of file";
+        case PHYSFS_ERR_FILES_STILL_OPEN: return "files still open";
+        case PHYSFS_ERR_INVALID_ARGUMENT: return "invalid argument";
+        case PHYSFS_ERR_NOT_MOUNTED: return "not mounted";
+        case PHYSFS_ERR_NOT_FOUND: return "not found";
+        case PHYSFS_ERR_SYMLINK_FORBIDDEN: return "symlinks are forbidden";
+        case PHYSFS_ERR_NO_WRITE_DIR: return "write directory is not set";
+        case PHYSFS_ERR_OPEN_FOR_READING: return "file open for reading";
+        case PHYSFS_ERR_OPEN_FOR_WRITING: return "file open for writing";
+        case PHYSFS_ERR_NOT_A_FILE: return "not a file";
+        case PHYSFS_ERR_READ_ONLY: return "read-only filesystem";
+        case PHYSFS_ERR_CORRUPT: return "corrupted";
+        case PHYSFS_ERR_SYMLINK_LOOP: return "infinite symbolic link loop";
+        case PHYSFS_ERR_IO: return "i/o error";
+        case PHYSFS_ERR_PERMISSION: return "permission denied";
+        case PHYSFS_ERR_NO_SPACE: return "no space available for writing";
+        case PHYSFS_ERR_BAD_FILENAME: return "filename is illegal or insecure";
+        case PHYSFS_ERR_BUSY: return "tried to modify a file the OS needs";
+        case PHYSFS_ERR_DIR_NOT_EMPTY: return "directory isn't empty";
+        case PHYSFS_ERR_OS_ERROR: return "OS reported an error";
+        case PHYSFS_ERR_DUPLICATE: return "duplicate resource";
+        case PHYSFS_ERR_BAD_PASSWORD: return "bad password";
+        case PHYSFS_ERR_CANCELLED: return "cancelled";
+        case PHYSFS_ERR_FROZEN: return "search path is frozen";
+        case PHYSFS_ERR_UNAVAILABLE: return "data not available yet";
+    } /* switch */
+
+    return NULL;  /* don't know this error code. */
+} /* PHYSFS_getErrorByCode */
+
+
+/* Doesn't set an error code on failure, for obvious reasons. */
+static ErrState *createStateForCurrentThread(void)
+{
+    ErrState *err = (ErrState *) allocator.Malloc(sizeof (ErrState));
+    if (err == NULL)
+        return NULL;   /* uhh...? */
+
+    memset(err, '\0', sizeof (ErrState));
+    err->tid = __PHYSFS_platformGetThreadID();
+
+    if ((errorTls != NULL) && (!__PHYSFS_platformSetThreadLocal(errorTls, err)))
+    {
+        allocator.Free(err);
+        return NULL;   /* uhh...? */
+    } /* if */
+
+    /* still keep a list, so we can free everything at deinit time. */
+    if (errorLock != NULL)
+        __PHYSFS_platformGrabMutex(errorLock);
+
+    err->next = errorStates;
+    errorStates = err;
+
+    if (errorLock != NULL)
+        __PHYSFS_platformReleaseMutex(errorLock);
+
+    return err;
+} /* createStateForCurrentThread */
+
+
+struct __PHYSFS_MemAccount
+{
+    PHYSFS_uint64 bytes[PHYSFS_MEMORY_CATEGORIES];
+    __PHYSFS_MemAccount *parent;  /* charged too, like a mount's overlay. */
+    __PHYSFS_MemAccount *children;  /* go away with this one. */
+    __PHYSFS_MemAccount *sibling;  /* next in parent's children. */
+};
+
+static __PHYSFS_MemAccount memTotals;
+static PHYSFS_uint64 memLimits[PHYSFS_MEMORY_CATEGORIES];  /* 0: none. */
+
+static __PHYSFS_MemAccount *createMemAccount(void)
+{
+    __PHYSFS_MemAccount *retval;
+    retval = (__PHYSFS_MemAccount *) allocator.Malloc(sizeof (*retval));
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(retval, '\0', sizeof (*retval));
+    return retval;
+} /* createMemAccount */
+
+
+static void destroyMemAccount(__PHYSFS_MemAccount *acct)
+{
+    while (acct != NULL)
+    {
+        __PHYSFS_MemAccount *next = acct->sibling;
+        destroyMemAccount(acct->children);
+        allocator.Free(acct);
+        acct = next;
+    } /* while */
+} /* destroyMemAccount */
+
+
+/* Charge (bytes) to (acct) and what it belongs to, but not the totals. */
+static void chargeMemAccount(__PHYSFS_MemAccount *acct,
+                             PHYSFS_MemoryCategory category,
+                             PHYSFS_sint64 bytes)
+{
+    for (; acct != NULL; acct = acct->parent)
+        __PHYSFS_ATOMIC_ADD64(&acct->bytes[category], (PHYSFS_uint64) bytes);
+} /* chargeMemAccount */
+
+
+/*
+ * Make (child) part of (parent): what's charged to it now and later counts
+ *  for (parent) as well, and it's freed when (parent) is.
+ */
+static void adoptMemAccount(__PHYSFS_MemAccount *parent,
+                            __PHYSFS_MemAccount *child)
+{
+    int i;
+    for (i = 0; i < PHYSFS_MEMORY_CATEGORIES; i++)
+    {
+        const PHYSFS_uint64 val = __PHYSFS_ATOMIC_ADD64(&child->bytes[i], 0);
+        chargeMemAccount(parent, (PHYSFS_MemoryCategory) i,
+                         (PHYSFS_sint64) val);
+    } /* for */
+    child->parent = parent;
+    child->sibling = parent->children;
+    parent->children = child;
+} /* adoptMemAccount */
+
+
+__PHYSFS_MemAccount *__PHYSFS_memSetMountAccount(__PHYSFS_MemAccount *acct)
+{
+    __PHYSFS_MemAccount *retval = NULL;
+    ErrState *err = findErrorForCurrentThread();
+    if ((err == NULL) && (acct != NULL))
+        err = createStateForCurrentThread();
+    if (err != NULL)
+    {
+        retval = err->mounting;
+        err->mounting = acct;
+    } /* if */
+    return retval;
+} /* __PHYSFS_memSetMountAccount */
+
+
+__PHYSFS_MemAccount *__PHYSFS_memMountAccount(void)
+{
+    const ErrState *err = findErrorForCurrentThread();
+    return err ? err->mounting : NULL;
+} /* __PHYSFS_memMountAccount */
+
+
+/* The context the calling thread's API calls work on. Never NULL. */
+static PHYSFS_Context *currentContext(void)
+{
+    const ErrState *err;
+
+    if (!usingContexts)  /* the usual case: don't go looking. */
+        return &defaultContext;
+
+    err = findErrorForCurrentThread();
+    return ((err) && (err->context)) ? err->context : &defaultContext;
+} /* currentContext */
+
+
+void __PHYSFS_memCharge(__PHYSFS_MemAccount *acct,
+                        PHYSFS_MemoryCategory category, PHYSFS_sint64 bytes)
+{
+    __PHYSFS_ATOMIC_ADD64(&memTotals.bytes[category], (PHYSFS_uint64) bytes);
+    chargeMemAccount(acct, category, bytes);
+} /* __PHYSFS_memCharge */
+
+
+int __PHYSFS_memAllowed(PHYSFS_MemoryCategory category, PHYSFS_uint64 bytes)
+{
+    const PHYSFS_uint64 limit = memLimits[category];
+    PHYSFS_uint64 used;
+
+    if (limit == 0)
+        return 1;
+
+    used = __PHYSFS_ATOMIC_ADD64(&memTotals.bytes[category], 0);
+    return ((used <= limit) && (bytes <= (limit - used)));
+} /* __PHYSFS_memAllowed */
+
+
+PHYSFS_uint64 __PHYSFS_memExcess(PHYSFS_MemoryCategory category)
+{
+    const PHYSFS_uint64 limit = memLimits[category];
+    PHYSFS_uint64 used;
+
+    if (limit == 0)
+        return 0;
+
+    used = __PHYSFS_ATOMIC_ADD64(&memTotals.bytes[category], 0);
+    return (used > limit) ? (used - limit) : 0;
+} /* __PHYSFS_memExcess */
+
+
+void PHYSFS_setErrorCode(PHYSFS_ErrorCode errcode)
+{
+    ErrState *err;
+
+    if (!errcode)
+        return;
+
+    err = findErrorForCurrentThread();
+    if (err == NULL)
+        err = createStateForCurrentThread();
+
+    if (err != NULL)
+        err->code = errcode;
+} /* PHYSFS_setErrorCode */
+
+
+/*
+ * Without a thread-local slot, finding this thread's state means taking
+ *  errorLock, which is no better than the allocator's own lock; so the
+ *  pools only work when there's a slot.
+ */
+void *__PHYSFS_poolAlloc(size_t len)
+{
+    const size_t idx = (len > 0) ? ((len - 1) / POOL_GRANULARITY) : 0;
+    void *retval;
+
+    if (idx < POOL_CLASSES)
+    {
+        ErrState *err = NULL;
+        if (errorTls != NULL)
+            err = (ErrState *) __PHYSFS_platformGetThreadLocal(errorTls);
+
+        if ((err != NULL) && (err->pool[idx] != NULL))
+        {
+            retval = err->pool[idx];
+            err->pool[idx] = *((void **) retval);
+            err->pooled[idx]--;
+            return retval;
+        } /* if */
+
+        len = (idx + 1) * POOL_GRANULARITY;  /* so any thread can reuse it. */
+    } /* if */
+
+    retval = allocator.Malloc(len);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    return retval;
+} /* __PHYSFS_poolAlloc */
+
+
+void __PHYSFS_poolFree(void *ptr, size_t len)
+{
+    const size_t idx = (len > 0) ? ((len - 1) / POOL_GRANULARITY) : 0;
+
+    if (ptr == NULL)
+        return;
+
+    if ((idx < POOL_CLASSES) && (errorTls != NULL))
+    {
+        ErrState *err;
+        err = (ErrState *) __PHYSFS_platformGetThreadLocal(errorTls);
+        if (err == NULL)
+            err = createStateForCurrentThread();
+
+        if ((err != NULL) && (err->pooled[idx] < POOL_MAX_SPARES))
+        {
+            *((void **) ptr) = err->pool[idx];
+            err->pool[idx] = ptr;
+            err->pooled[idx]++;
+            return;
+        } /* if */
+    } /* if */
+
+    allocator.Free(ptr);
+} /* __PHYSFS_poolFree */
+
+
+static void freeLatencyExts(void)
+{
+    size_t i;
+    timingLatency = 0;
+    for (i = 0; i < LATENCY_SLOTS; i++)
+    {
+        allocator.Free(latencyExts[i]);
+        latencyExts[i] = NULL;
+    } /* for */
+} /* freeLatencyExts */
+
+
+/*
+ * Find the latency slot for archiver extension (ext), or make one. Returns
+ *  -1 if there's no such slot and (create) is zero, or they're all taken.
+ */
+static int latencySlot(const char *ext, int create)
+{
+    int i;
+
+    for (i = 1; i < LATENCY_SLOTS; i++)  /* no lock; slots are only added. */
+    {
+        const char *slotext = latencyExts[i];
+        if (slotext == NULL)
+            break;
+        else if (__PHYSFS_utf8stricmp(slotext, ext) == 0)
+            return i;
+    } /* for */
+
+    if (!create)
+        return -1;
+
+    __PHYSFS_platformGrabMutex(errorLock);
+    for (i = 1; i < LATENCY_SLOTS; i++)  /* look again, with the lock. */
+    {
+        if (latencyExts[i] == NULL)
+        {
+            const size_t len = strlen(ext) + 1;
+            char *copy = (char *) allocator.Malloc(len);
+            if (copy != NULL)
+            {
+                memcpy(copy, ext, len);
+                __PHYSFS_MEMORY_BARRIER();  /* done before it's visible. */
+                latencyExts[i] = copy;
+            } /* if */
+            break;
+        } /* if */
+        else if (__PHYSFS_utf8stricmp(latencyExts[i], ext) == 0)
+            break;
+    } /* for */
+    __PHYSFS_platformReleaseMutex(errorLock);
+
+    if ((i == LATENCY_SLOTS) || (latencyExts[i] == NULL))
+        return -1;
+    return i;
+} /* latencySlot */
+
+
+static inline PHYSFS_uint32 latencyBucket(PHYSFS_uint64 val)
+{
+    PHYSFS_uint32 msb = 0;
+
+    if (val < LATENCY_SUB_BUCKETS)
+        return (PHYSFS_uint32) val;
+
+    while ((val >> msb) > 1)
+        msb++;
+
+    return ((msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS) +
+           (PHYSFS_uint32) ((val >> (msb - LATENCY_SUB_BITS)) &
+                            (LATENCY_SUB_BUCKETS - 1));
+} /* latencyBucket */
+
+
+/* The largest value that lands in (bucket). */
+static PHYSFS_uint64 latencyBucketMax(PHYSFS_uint32 bucket)
+{
+    PHYSFS_uint32 shift;
+    PHYSFS_uint64 base;
+
+    if (bucket < LATENCY_SUB_BUCKETS)
+        return bucket;
+
+    shift = (bucket / LATENCY_SUB_BUCKETS) - 1;
+    base = (PHYSFS_uint64) (LATENCY_SUB_BUCKETS +
+                            (bucket % LATENCY_SUB_BUCKETS)) << shift;
+    return base + ((((PHYSFS_uint64) 1) << shift) - 1);
+} /* latencyBucketMax */
+
+
+/*
+ * Record that (op) took from (start) until now, in (dh)'s archiver, or
+ *  slot 0 if (dh) is NULL. Only touches this thread's histograms.
+ */
+static void recordLatency(int op, const DirHandle *dh, PHYSFS_uint64 start)
+{
+    const PHYSFS_uint64 ns = __PHYSFS_platformGetTicks() - start;
+    LatencyHist *hist;
+    ErrState *err;
+    int slot = 0;
+
+    if (errorTls == NULL)
+        return;  /* finding our histograms would mean locking. */
+
+    err = (ErrState *) __PHYSFS_platformGetThreadLocal(errorTls);
+    if (err == NULL)
+    {
+        err = createStateForCurrentThread();
+        if (err == NULL)
+            return;
+    } /* if */
+
+    if (err->latency == NULL)
+    {
+        LatencyTable *table;
+        table = (LatencyTable *) allocator.Malloc(sizeof (LatencyTable));
+        if (table == NULL)
+            return;
+        memset(table, '\0', sizeof (LatencyTable));
+        __PHYSFS_MEMORY_BARRIER();
+        err->latency = table;
+    } /* if */
+
+    if (dh != NULL)
+    {
+        const PHYSFS_Archiver *arc = dh->realFuncs ? dh->realFuncs : dh->funcs;
+        slot = latencySlot(arc->info.extension, 1);
+        if (slot < 0)
+            return;  /* out of slots (or memory). */
+    } /* if */
+
+    hist = err->latency->hists[op][slot];
+    if (hist == NULL)
+    {
+        hist = (LatencyHist *) allocator.Malloc(sizeof (LatencyHist));
+        if (hist == NULL)
+            return;
+        memset(hist, '\0', sizeof (LatencyHist));
+        __PHYSFS_MEMORY_BARRIER();
+        err->latency->hists[op][slot] = hist;
+    } /* if */
+
+    /* atomic, so other threads adding these up never see half a value. */
+    __PHYSFS_ATOMIC_ADD64(&hist->buckets[latencyBucket(ns)], 1);
+    if (ns > hist->max)
+        __PHYSFS_ATOMIC_ADD64(&hist->max, ns - hist->max);
+} /* recordLatency */
+
+
+const char *PHYSFS_getLastError(void)
+{
+    const PHYSFS_ErrorCode err = PHYSFS_getLastErrorCode();
+    return (err) ? PHYSFS_getErrorByCode(err) : NULL;
+} /* PHYSFS_getLastError */
+
+
+/* MAKE SURE that errorLock is held before calling this! */
+static void freeErrorStates(void)
+{
+    ErrState *i;
+    ErrState *next;
+
+    for (i = errorStates; i != NULL; i = next)
+    {
+        size_t j;
+        for (j = 0; j < POOL_CLASSES; j++)
+        {
+            while (i->pool[j] != NULL)
+            {
+                void *block = i->pool[j];
+                i->pool[j] = *((void **) block);
+                allocator.Free(block);
+            } /* while */
+        } /* for */
+
+        if (i->latency != NULL)
+        {
+            LatencyHist * volatile *hists = &i->latency->hists[0][0];
+            for (j = 0; j < LATENCY_OPS * LATENCY_SLOTS; j++)
+                allocator.Free(hists[j]);
+            allocator.Free(i->latency);
+        } /* if */
+
+        next = i->next;
+        allocator.Free(i);
+    } /* for */
+
+    errorStates = NULL;
+} /* freeErrorStates */
+
+
+void PHYSFS_getLinkedVersion(PHYSFS_Version *ver)
+{
+    if (ver != NULL)
+    {
+        ver->major = PHYSFS_VER_MAJOR;
+        ver->minor = PHYSFS_VER_MINOR;
+        ver->patch = PHYSFS_VER_PATCH;
+    } /* if */
+} /* PHYSFS_getLinkedVersion */
+
+
+static const char *find_filename_extension(const char *fname)
+{
+    const char *retval = NULL;
+    if (fname != NULL)
+    {
+        const char *p = strchr(fname, '.');
+        retval = p;
+
+        while (p != NULL)
+        {
+            p = strchr(p + 1, '.');
+            if (p != NULL)
+                retval = p;
+        } /* while */
+
+        if (retval != NULL)
+            retval++;  /* skip '.' */
+    } /* if */
+
+    return retval;
+} /* find_filename_extension */
+
+
+/*
+ * The built-in archivers can take lookups from several threads at once.
+ *  We don't know that about anything the app registers, so those still
+ *  get called with stateLock held, like they always have been.
+ *  (LZMA shares per-file decoder state between opens, so it's held too.)
+ */
+static int archiverIsReentrant(const PHYSFS_Archiver *funcs)
+{
+    #define CHECK_STATIC_ARCHIVER(arc) { \
+        extern const PHYSFS_Archiver __PHYSFS_Archiver_##arc; \
+        if (funcs->openRead == __PHYSFS_Archiver_##arc.openRead) { \
+            return 1; \
+        } \
+    }
+
+    CHECK_STATIC_ARCHIVER(DIR);
+    #if PHYSFS_SUPPORTS_ZIP
+        CHECK_STATIC_ARCHIVER(ZIP);
+    #endif
+    #if PHYSFS_SUPPORTS_ISO9660
+        CHECK_STATIC_ARCHIVER(ISO9660);
+    #endif
+    #if PHYSFS_SUPPORTS_RAS
+        CHECK_STATIC_ARCHIVER(RAS);
+    #endif
+    #if PHYSFS_SUPPORTS_PPK
+        CHECK_STATIC_ARCHIVER(PPK);
+    #endif
+    CHECK_STATIC_ARCHIVER(RAM);
+
+    #undef CHECK_STATIC_ARCHIVER
+
+    /* GRP, QPAK, HOG, MVL, WAD and SLB all share this. */
+    if (funcs->openRead == UNPK_openRead)
+        return 1;
+
+    return 0;
+} /* archiverIsReentrant */
+
+
+/*
+ * An archiver can go in the search path index if its lookups only ever
+ *  find paths that its enumerateFiles lists. DIR can change under us, and
+ *  ISO9660 and LZMA match names a little more loosely than they list them,
+ *  so those (and anything the app registers) are always asked directly.
+ */
+static int archiverIndexMode(const PHYSFS_Archiver *funcs)
+{
+    #define CHECK_STATIC_ARCHIVER(arc, mode) { \
+        extern const PHYSFS_Archiver __PHYSFS_Archiver_##arc; \
+        if (funcs->openRead == __PHYSFS_Archiver_##arc.openRead) { \
+            return mode; \
+        } \
+    }
+
+    #if PHYSFS_SUPPORTS_ZIP
+        CHECK_STATIC_ARCHIVER(ZIP, INDEX_EXACT);
+    #endif
+    #if PHYSFS_SUPPORTS_RAS
+        CHECK_STATIC_ARCHIVER(RAS, INDEX_EXACT);
+    #endif
+    #if PHYSFS_SUPPORTS_PPK
+        CHECK_STATIC_ARCHIVER(PPK, INDEX_EXACT);
+    #endif
+
+    #undef CHECK_STATIC_ARCHIVER
+
+    /* GRP, QPAK, HOG, MVL, WAD and SLB all compare names like this. */
+    if (funcs->openRead == UNPK_openRead)
+        return INDEX_NOCASE_ASCII;
+
+    return INDEX_NONE;
+} /* archiverIndexMode */
+
+
+static DirHandle *tryOpenDir(PHYSFS_Io *io, const PHYSFS_Archiver *funcs,
+                             const char *d, int forWriting)
+{
+    DirHandle *retval = NULL;
+    __PHYSFS_MemAccount *mem = NULL;
+    __PHYSFS_MemAccount *prevMem;
+    void *opaque = NULL;
+
+    if (io != NULL)
+        BAIL_IF_MACRO(!io->seek(io, 0), ERRPASS, NULL);
+
+    mem = createMemAccount();
+    BAIL_IF_MACRO(!mem, ERRPASS, NULL);
+
+    prevMem = __PHYSFS_memSetMountAccount(mem);
+    opaque = funcs->openArchive(io, d, forWriting);
+    __PHYSFS_memSetMountAccount(prevMem);
+
+    if (opaque != NULL)
+    {
+        retval = (DirHandle *) allocator.Malloc(sizeof (DirHandle));
+        if (retval == NULL)
+            funcs->closeArchive(opaque);
+        else
+        {
+            memset(retval, '\0', sizeof (DirHandle));
+            retval->mountPoint = NULL;
+            retval->funcs = funcs;
+            retval->reentrant = archiverIsReentrant(funcs);
+            retval->indexMode = archiverIndexMode(funcs);
+            retval->opaque = opaque;
+            retval->mem = mem;
+        } /* else */
+    } /* if */
+
+    if (retval == NULL)
+        destroyMemAccount(mem);
+
+    return retval;
+} /* tryOpenDir */
+
+
+/*
+ * Files whose extension doesn't say what they are get offered to every
+ *  archiver, and each of those would otherwise read its own magic, from
+ *  wherever it keeps it. So they're read once, enough of the start and end
+ *  for anything built in (ISO9660 looks past 32k in; ZIP's end of central
+ *  directory can be 64k from the end), for each archiver's claim() to
+ *  look at instead.
+ */
+#define PROBE_HEAD_LEN (36 * 1024)
+#define PROBE_TAIL_LEN (66 * 1024)
+
+typedef struct
+{
+    int tried;  /* non-zero once we've tried to read it. */
+    const PHYSFS_uint8 *head;  /* NULL if it couldn't be read. */
+    size_t headLen;
+    const PHYSFS_uint8 *tail;
+    size_t tailLen;
+    PHYSFS_uint64 fileLen;
+    PHYSFS_uint8 *buf;  /* what head and tail point into, unless mapped. */
+} ArchiveProbe;
+
+
+static void readArchiveProbe(ArchiveProbe *probe, PHYSFS_Io *io)
+{
+    const void *mapped = NULL;
+    PHYSFS_uint64 mappedLen = 0;
+    PHYSFS_sint64 len;
+
+    probe->tried = 1;
+
+    if (__PHYSFS_ioMap(io, &mapped, &mappedLen))
+    {
+        probe->fileLen = mappedLen;
+        probe->head = (const PHYSFS_uint8 *) mapped;
+    } /* if */
+    else
+    {
+        len = io->length(io);
+        if (len < 0)
+            return;
+        probe->fileLen = (PHYSFS_uint64) len;
+    } /* else */
+
+    probe->headLen = PROBE_HEAD_LEN;
+    if (probe->fileLen < PROBE_HEAD_LEN)
+        probe->headLen = (size_t) probe->fileLen;
+    probe->tailLen = PROBE_TAIL_LEN;
+    if (probe->fileLen < PROBE_TAIL_LEN)
+        probe->tailLen = (size_t) probe->fileLen;
+
+    if (probe->head != NULL)  /* mapped? Nothing to read, then. */
+    {
+        probe->tail = probe->head + (probe->fileLen - probe->tailLen);
+        return;
+    } /* if */
+
+    probe->buf = (PHYSFS_uint8 *) allocator.Malloc(PROBE_HEAD_LEN +
+                                                   PROBE_TAIL_LEN);
+    if (probe->buf == NULL)
+        return;
+
+    /* small enough to read whole? Then head and tail are both of it. */
+    if (probe->fileLen <= PROBE_HEAD_LEN + PROBE_TAIL_LEN)
+    {
+        const PHYSFS_uint64 total = probe->fileLen;
+        if ((!io->seek(io, 0)) || (!__PHYSFS_readAll(io, probe->buf, total)))
+            return;
+        probe->tail = probe->buf + (size_t) (total - probe->tailLen);
+    } /* if */
+    else
+    {
+        if ((!io->seek(io, 0)) ||
+            (!__PHYSFS_readAll(io, probe->buf, PROBE_HEAD_LEN)) ||
+            (!io->seek(io, probe->fileLen - PROBE_TAIL_LEN)) ||
+            (!__PHYSFS_readAll(io, probe->buf + PROBE_HEAD_LEN,
+                               PROBE_TAIL_LEN)))
+            return;
+        probe->tail = probe->buf + PROBE_HEAD_LEN;
+    } /* else */
+
+    probe->head = probe->buf;
+} /* readArchiveProbe */
+
+
+/* Zero if (funcs) says (io) definitely isn't one of its archives. */
+static int archiverClaims(const PHYSFS_Archiver *funcs, PHYSFS_Io *io,
+                          ArchiveProbe *probe)
+{
+    if (funcs->claim == NULL)
+        return 1;
+    else if (!probe->tried)
+        readArchiveProbe(probe, io);
+
+    if (probe->head == NULL)
+        return 1;  /* couldn't look, so let it look for itself. */
+
+    return funcs->claim(probe->head, probe->headLen, probe->tail,
+                        probe->tailLen, probe->fileLen);
+} /* archiverClaims */
+
+
+/*
+ * With an index cache dir set, archives mounted read-only by path get an
+ *  index snapshot there (see archiver_snapshot.c), named for a hash of the
+ *  path. Returns that name, or NULL if there's no cache dir. Free it.
+ */
+static char *indexSnapshotName(const char *d)
+{
+    PHYSFS_uint8 hash[__PHYSFS_CONTENT_HASH_LEN];
+    char *retval;
+    char *ptr;
+    int i;
+
+    if (indexCacheDir == NULL)
+        return NULL;
+
+    retval = (char *) allocator.Malloc(strlen(indexCacheDir) + 24);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    __PHYSFS_hashContent(d, strlen(d), hash);
+    ptr = retval + sprintf(retval, "%s%c", indexCacheDir,
+                           __PHYSFS_platformDirSeparator);
+    for (i = 0; i < 8; i++)
+        ptr += sprintf(ptr, "%02x", (unsigned int) hash[i]);
+    strcpy(ptr, ".pidx");
+    return retval;
+} /* indexSnapshotName */
+
+
+/*
+ * Mount (d) from its index snapshot (fname), if it has one that's still
+ *  good. This is strictly optional, so it never leaves an error code behind.
+ */
+static DirHandle *openIndexSnapshot(const char *fname, const char *d,
+                                    const PHYSFS_Stat *st)
+{
+    extern const PHYSFS_Archiver __PHYSFS_Archiver_SNAPSHOT;
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const PHYSFS_Archiver *funcs = NULL;
+    DirHandle *retval = NULL;
+    __PHYSFS_MemAccount *mem = createMemAccount();
+    __PHYSFS_MemAccount *prevMem;
+    void *opaque = NULL;
+
+    if (mem != NULL)
+    {
+        prevMem = __PHYSFS_memSetMountAccount(mem);
+        opaque = __PHYSFS_loadIndexSnapshot(fname, d, st, archivers, &funcs);
+        __PHYSFS_memSetMountAccount(prevMem);
+    } /* if */
+
+    if (opaque != NULL)
+    {
+        retval = (DirHandle *) allocator.Malloc(sizeof (DirHandle));
+        if (retval == NULL)
+            __PHYSFS_Archiver_SNAPSHOT.closeArchive(opaque);
+        else
+        {
+            memset(retval, '\0', sizeof (DirHandle));
+            retval->funcs = &__PHYSFS_Archiver_SNAPSHOT;
+            retval->realFuncs = funcs;
+            retval->reentrant = archiverIsReentrant(funcs);
+            retval->indexMode = archiverIndexMode(funcs);
+            retval->opaque = opaque;
+            retval->mem = mem;
+        } /* else */
+    } /* if */
+
+    if (retval == NULL)
+        destroyMemAccount(mem);
+
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+    return retval;
+} /* openIndexSnapshot */
+
+
+/* Likewise, failing to save one doesn't fail the mount. */
+static void saveIndexSnapshot(const char *fname, const char *d,
+                              const PHYSFS_Stat *st, const DirHandle *dh)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    __PHYSFS_saveIndexSnapshot(fname, d, st, dh->funcs, dh->opaque,
+                               dh->indexMode);
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+} /* saveIndexSnapshot */
+
+
+/*
+ * Put a PHYSFS_setMountBlockCache() cache in front of (io), if there's
+ *  one to put there and (io) isn't in memory already. Returns NULL, and
+ *  leaves the error state alone, if (io) goes without.
+ */
+static PHYSFS_Io *cacheMountIo(PHYSFS_Io *io)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const PHYSFS_uint32 blocks = mountCacheBlocks;
+    PHYSFS_Io *retval = NULL;
+    const void *ptr = NULL;
+    PHYSFS_uint64 len = 0;
+
+    if ((blocks > 0) && (!__PHYSFS_ioMap(io, &ptr, &len)))
+        retval = __PHYSFS_createCachedIo(io, mountCacheBlockSize, blocks);
+
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+    return retval;
+} /* cacheMountIo */
+
+
+static DirHandle *openDirectory(PHYSFS_Io *io, const char *d, int forWriting)
+{
+    DirHandle *retval = NULL;
+    const PHYSFS_Archiver **i;
+    const char *ext;
+    char *snapshot = NULL;
+    ArchiveProbe probe;
+    PHYSFS_Stat st;
+    int created_io = 0;
+    int cached_io = 0;
+
+    assert((io != NULL) || (d != NULL));
+    memset(&probe, '\0', sizeof (probe));
+
+    if (io == NULL)
+    {
+        /* DIR gets first shot (unlike the rest, it doesn't deal with files). */
+        extern const PHYSFS_Archiver __PHYSFS_Archiver_DIR;
+        extern const PHYSFS_Archiver __PHYSFS_Archiver_RAM;
+
+        /* ...after RAM dirs, whose names aren't anywhere on disk. */
+        if (ramDirs != NULL)
+        {
+            retval = tryOpenDir(io, &__PHYSFS_Archiver_RAM, d, forWriting);
+            if (retval != NULL)
+                return retval;
+        } /* if */
+
+        retval = tryOpenDir(io, &__PHYSFS_Archiver_DIR, d, forWriting);
+        if (retval != NULL)
+        {
+            retval->native = 1;
+            return retval;
+        } /* if */
+
+        if ((!forWriting) && (indexCacheDir != NULL) &&
+            (__PHYSFS_platformStat(d, &st)) &&
+            (st.filetype == PHYSFS_FILETYPE_REGULAR))
+        {
+            snapshot = indexSnapshotName(d);
+            if (snapshot != NULL)
+                retval = openIndexSnapshot(snapshot, d, &st);
+            if (retval != NULL)
+            {
+                allocator.Free(snapshot);
+                return retval;
+            } /* if */
+        } /* if */
+
+        /* read-only archives get mapped if possible; fall back to read(). */
+        if (!forWriting)
+            io = __PHYSFS_createArchiveIo(d);
+        else  /* 'a', so archives we'll write to aren't truncated. */
+            io = __PHYSFS_createNativeIo(d, 'a');
+        if (io == NULL)
+        {
+            allocator.Free(snapshot);
+            return NULL;
+        } /* if */
+        created_io = 1;
+    } /* if */
+
+    if (!forWriting)
+    {
+        PHYSFS_Io *cached = cacheMountIo(io);
+        if (cached != NULL)
+        {
+            io = cached;
+            cached_io = 1;
+        } /* if */
+    } /* if */
+
+    ext = find_filename_extension(d);
+    if (ext != NULL)
+    {
+        /* Look for archivers with matching file extensions first... */
+        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
+        {
+            if (__PHYSFS_utf8stricmp(ext, (*i)->info.extension) == 0)
+                retval = tryOpenDir(io, *i, d, forWriting);
+        } /* for */
+
+        /* failing an exact file extension match, try all the others... */
+        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
+        {
+            if (__PHYSFS_utf8stricmp(ext, (*i)->info.extension) == 0)
+                continue;
+            else if ((forWriting) || (archiverClaims(*i, io, &probe)))
+                retval = tryOpenDir(io, *i, d, forWriting);
+        } /* for */
+    } /* if */
+
+    else  /* no extension? Try them all. */
+    {
+        for (i = archivers; (*i != NULL) && (retval == NULL); i++)
+        {
+            if ((forWriting) || (archiverClaims(*i, io, &probe)))
+                retval = tryOpenDir(io, *i, d, forWriting);
+        } /* for */
+    } /* else */
+
+    allocator.Free(probe.buf);
+
+    if ((!retval) && (cached_io))
+        io = __PHYSFS_uncacheIo(io);  /* the caller's (io) is theirs again. */
+
+    if ((!retval) && (created_io))
+        io->destroy(io);
+
+    if ((retval != NULL) && (snapshot != NULL))
+        saveIndexSnapshot(snapshot, d, &st, retval);
+    allocator.Free(snapshot);
+
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_UNSUPPORTED, NULL);
+    return retval;
+} /* openDirectory */
+
+
+/*
+ * Open (base) and each of (patches), and merge them into one overlay that
+ *  takes ownership of them all. See archiver_overlay.c.
+ */
+static DirHandle *openOverlay(const char *base, const char **patches,
+                              const PHYSFS_uint32 numPatches)
+{
+    extern const PHYSFS_Archiver __PHYSFS_Archiver_OVERLAY;
+    const size_t count = ((size_t) numPatches) + 1;
+    const PHYSFS_Archiver **funcs = NULL;
+    void **opaques = NULL;
+    DirHandle *retval = NULL;
+    __PHYSFS_MemAccount *mem = NULL;
+    int reentrant = 1;
+    void *opaque = NULL;
+    size_t opened = 0;
+    size_t i;
+
+    funcs = (const PHYSFS_Archiver **)
+                allocator.Malloc(count * sizeof (PHYSFS_Archiver *));
+    opaques = (void **) allocator.Malloc(count * sizeof (void *));
+    GOTO_IF_MACRO(!funcs || !opaques, PHYSFS_ERR_OUT_OF_MEMORY,
+                  openOverlay_failed);
+    mem = createMemAccount();
+    GOTO_IF_MACRO(!mem, ERRPASS, openOverlay_failed);
+
+    for (opened = 0; opened < count; opened++)
+    {
+        const char *d = (opened == 0) ? base : patches[opened - 1];
+        DirHandle *dh;
+        GOTO_IF_MACRO(!d, PHYSFS_ERR_INVALID_ARGUMENT, openOverlay_failed);
+        dh = openDirectory(NULL, d, 0);
+        GOTO_IF_MACRO(!dh, ERRPASS, openOverlay_failed);
+        funcs[opened] = dh->funcs;
+        opaques[opened] = dh->opaque;
+        reentrant = reentrant && dh->reentrant;
+        adoptMemAccount(mem, dh->mem);  /* it counts for the overlay. */
+        allocator.Free(dh);  /* the overlay will own the archive itself. */
+    } /* for */
+
+    retval = (DirHandle *) allocator.Malloc(sizeof (DirHandle));
+    GOTO_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, openOverlay_failed);
+    opaque = __PHYSFS_createOverlay(funcs, opaques, count);
+    GOTO_IF_MACRO(!opaque, ERRPASS, openOverlay_failed);
+
+    memset(retval, '\0', sizeof (DirHandle));
+    retval->funcs = &__PHYSFS_Archiver_OVERLAY;
+    retval->reentrant = reentrant;  /* it calls into all of them. */
+    retval->indexMode = INDEX_EXACT;
+    retval->opaque = opaque;
+    retval->mem = mem;
+
+    allocator.Free(funcs);
+    allocator.Free(opaques);
+    return retval;
+
+openOverlay_failed:
+    for (i = 0; i < opened; i++)
+        funcs[i]->closeArchive(opaques[i]);
+    destroyMemAccount(mem);  /* after they've given everything back. */
+    allocator.Free(retval);
+    allocator.Free(funcs);
+    allocator.Free(opaques);
+    return NULL;
+} /* openOverlay */
+
+
+/*
+ * Open (d) for reading, sharing the archive with any other mount of the
+ *  same file. Native directories, and files we can't stat, aren't shared.
+ */
+static DirHandle *openSharedDirectory(const char *d)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    SharedArchive *sa;
+    DirHandle *retval;
+    PHYSFS_Stat st;
+
+    if ((sharedLock == NULL) || (!__PHYSFS_platformStat(d, &st)) ||
+        (st.filetype != PHYSFS_FILETYPE_REGULAR))
+    {
+        PHYSFS_getLastErrorCode();  /* the open will say what's wrong. */
+        PHYSFS_setErrorCode(prevErr);
+        return openDirectory(NULL, d, 0);
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(sharedLock);
+    for (sa = sharedArchives; sa != NULL; sa = sa->next)
+    {
+        if ((sa->size == st.filesize) && (sa->modtime == st.modtime) &&
+            (strcmp(sa->path, d) == 0))
+        {
+            sa->refcount++;
+            break;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(sharedLock);
+
+    if (sa == NULL)  /* first mount of it: open it, then offer it up. */
+    {
+        retval = openDirectory(NULL, d, 0);
+        BAIL_IF_MACRO(!retval, ERRPASS, NULL);
+
+        /* if this fails, this mount just keeps the archive to itself. */
+        sa = (SharedArchive *) allocator.Malloc(sizeof (SharedArchive));
+        if (sa != NULL)
+        {
+            sa->path = (char *) allocator.Malloc(strlen(d) + 1);
+            if (sa->path == NULL)
+            {
+                allocator.Free(sa);
+                return retval;
+            } /* if */
+
+            strcpy(sa->path, d);
+            sa->size = st.filesize;
+            sa->modtime = st.modtime;
+            sa->opaque = retval->opaque;
+            sa->funcs = retval->funcs;
+            sa->realFuncs = retval->realFuncs;
+            sa->reentrant = retval->reentrant;
+            sa->indexMode = retval->indexMode;
+            sa->mem = retval->mem;
+            sa->refcount = 1;
+            retval->shared = sa;
+
+            __PHYSFS_platformGrabMutex(sharedLock);
+            sa->next = sharedArchives;
+            sharedArchives = sa;
+            __PHYSFS_platformReleaseMutex(sharedLock);
+        } /* if */
+        return retval;
+    } /* if */
+
+    retval = (DirHandle *) allocator.Malloc(sizeof (DirHandle));
+    if (retval == NULL)
+    {
+        __PHYSFS_platformGrabMutex(sharedLock);
+        sa->refcount--;  /* someone else has it, so it's not the last. */
+        __PHYSFS_platformReleaseMutex(sharedLock);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    memset(retval, '\0', sizeof (DirHandle));
+    retval->opaque = sa->opaque;
+    retval->funcs = sa->funcs;
+    retval->realFuncs = sa->realFuncs;
+    retval->reentrant = sa->reentrant;
+    retval->indexMode = sa->indexMode;
+    retval->mem = sa->mem;
+    retval->shared = sa;
+    return retval;
+} /* openSharedDirectory */
+
+
+/*
+ * Close (dh)'s archive and free its memory account, unless other mounts
+ *  still share them. Returns non-zero if they're gone.
+ */
+static int closeDirHandleArchive(DirHandle *dh)
+{
+    SharedArchive *sa = dh->shared;
+
+    if (sa != NULL)
+    {
+        SharedArchive **prev;
+        int last;
+
+        __PHYSFS_platformGrabMutex(sharedLock);
+        last = (--sa->refcount == 0);
+        if (last)
+        {
+            for (prev = &sharedArchives; *prev != sa; prev = &(*prev)->next)
+                /* just looking. */ ;
+            *prev = sa->next;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(sharedLock);
+
+        if (!last)
+            return 0;
+
+        allocator.Free(sa->path);
+        allocator.Free(sa);
+    } /* if */
+
+    if (!dh->reentrant)  /* see lockDirHandle(). */
+        grabStateLock();
+    dh->funcs->closeArchive(dh->opaque);
+    if (!dh->reentrant)
+        __PHYSFS_platformReleaseMutex(stateLock);
+    destroyMemAccount(dh->mem);
+    return 1;
+} /* closeDirHandleArchive */
+
+
+/*
+ * Non-zero if (src), which is (len) chars and doesn't start with '/', is
+ *  already sane, so sanitizing it would just copy it. Most paths are, so
+ *  this looks for anything the slow way would have to deal with (':', '\\',
+ *  "//", a trailing '/', or a '.' starting a path element, which might be
+ *  "." or ".."), sixteen chars at a time where we can.
+ */
+static int pathAlreadySane(const char *src, const size_t len)
+{
+    size_t i = 0;
+
+    if (len == 0)
+        return 1;
+    else if ((src[0] == '.') || (src[len - 1] == '/'))
+        return 0;
+
+#if PHYSFS_HAVE_SSE2
+    {
+        const __m128i slash = _mm_set1_epi8('/');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i bslash = _mm_set1_epi8('\\');
+        const __m128i dot = _mm_set1_epi8('.');
+
+        /* the second load reads one further, up to the null terminator. */
+        while ((i + 16) <= len)
+        {
+            const __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+            const __m128i b = _mm_loadu_si128((const __m128i *) (src + i + 1));
+            const __m128i sep = _mm_cmpeq_epi8(a, slash);
+            const __m128i next = _mm_or_si128(_mm_cmpeq_epi8(b, slash),
+                                              _mm_cmpeq_epi8(b, dot));
+            __m128i bad = _mm_or_si128(_mm_cmpeq_epi8(a, colon),
+                                       _mm_cmpeq_epi8(a, bslash));
+            bad = _mm_or_si128(bad, _mm_and_si128(sep, next));
+            if (_mm_movemask_epi8(bad) != 0)
+                return 0;
+            i += 16;
+        } /* while */
+    }
+#endif
+
+    for (; i < len; i++)
+    {
+        const char ch = src[i];
+        if ((ch == ':') || (ch == '\\'))
+            return 0;
+        else if ((ch == '/') && ((src[i + 1] == '/') || (src[i + 1] == '.')))
+            return 0;
+    } /* for */
+
+    return 1;
+} /* pathAlreadySane */
+
+
+/*
+ * Make a platform-independent path string sane. Doesn't actually check the
+ *  file hierarchy, it just cleans up the string.
+ *  (dst) must be a buffer at least as big as (src), as this is where the
+ *  cleaned up string is deposited.
+ * If there are illegal bits in the path (".." entries, etc) then we
+ *  return zero and (dst) is undefined. Non-zero if the path was sanitized.
+ */
+static int sanitizePlatformIndependentPath(const char *src, char *dst)
+{
+    char *prev;
+    size_t len;
+    char ch;
+
+    while (*src == '/')  /* skip initial '/' chars... */
+        src++;
+
+    len = strlen(src);
+    if (pathAlreadySane(src, len))
+    {
+        memcpy(dst, src, len + 1);
+        return 1;
+    } /* if */
+
+    prev = dst;
+    do
+    {
+        ch = *(src++);
+
+        if ((ch == ':') || (ch == '\\'))  /* illegal chars in a physfs path. */
+            BAIL_MACRO(PHYSFS_ERR_BAD_FILENAME, 0);
+
+        if (ch == '/')   /* path separator. */
+        {
+            *dst = '\0';  /* "." and ".." are illegal pathnames. */
+            if ((strcmp(prev, ".") == 0) || (strcmp(prev, "..") == 0))
+                BAIL_MACRO(PHYSFS_ERR_BAD_FILENAME, 0);
+
+            while (*src == '/')   /* chop out doubles... */
+                src++;
+
+            if (*src == '\0') /* ends with a pathsep? */
+                break;  /* we're done, don't add final pathsep to dst. */
+
+            prev = dst + 1;
+        } /* if */
+
+        *(dst++) = ch;
+    } while (ch != '\0');
+
+    return 1;
+} /* sanitizePlatformIndependentPath */
+
+
+/*
+ * Figure out if (fname) is part of (h)'s mountpoint. (fname) must be an
+ *  output from sanitizePlatformIndependentPath(), so that it is in a known
+ *  state.
+ *
+ * This only finds legitimate segments of a mountpoint. If the mountpoint is
+ *  "/a/b/c" and (fname) is "/a/b/c", "/", or "/a/b/c/d", then the results are
+ *  all zero. "/a/b" will succeed, though.
+ */
+static int partOfMountPoint(DirHandle *h, char *fname)
+{
+    /* !!! FIXME: This code feels gross. */
+    int rc;
+    size_t len, mntpntlen;
+
+    if (h->mountPoint == NULL)
+        return 0;
+    else if (*fname == '\0')
+        return 1;
+
+    len = strlen(fname);
+    mntpntlen = strlen(h->mountPoint);
+    if (len > mntpntlen)  /* can't be a subset of mountpoint. */
+        return 0;
+
+    /* if true, must be not a match or a complete match, but not a subset. */
+    if ((len + 1) == mntpntlen)
+        return 0;
+
+    rc = strncmp(fname, h->mountPoint, len); /* !!! FIXME: case insensitive? */
+    if (rc != 0)
+        return 0;  /* not a match. */
+
+    /* make sure /a/b matches /a/b/ and not /a/bc ... */
+    return h->mountPoint[len] == '/';
+} /* partOfMountPoint */
+
+
+/*
+ * (patches), if not NULL, is (numPatches) more archives to merge over
+ *  (newDir) with openOverlay(); (io) has to be NULL then.
+ */
+static DirHandle *createDirHandle(PHYSFS_Context *ctx, PHYSFS_Io *io,
+                                  const char *newDir,
+                                  const char *mountPoint, int forWriting,
+                                  const char **patches,
+                                  const PHYSFS_uint32 numPatches)
+{
+    DirHandle *dirHandle = NULL;
+    char *tmpmntpnt = NULL;
+
+    if (mountPoint != NULL)
+    {
+        const size_t len = strlen(mountPoint) + 1;
+        tmpmntpnt = (char *) __PHYSFS_smallAlloc(len);
+        GOTO_IF_MACRO(!tmpmntpnt, PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
+        if (!sanitizePlatformIndependentPath(mountPoint, tmpmntpnt))
+            goto badDirHandle;
+        mountPoint = tmpmntpnt;  /* sanitized version. */
+    } /* if */
+
+    if (patches != NULL)
+        dirHandle = openOverlay(newDir, patches, numPatches);
+    else if ((io == NULL) && (!forWriting))
+        dirHandle = openSharedDirectory(newDir);
+    else
+        dirHandle = openDirectory(io, newDir, forWriting);
+    GOTO_IF_MACRO(!dirHandle, ERRPASS, badDirHandle);
+    dirHandle->ctx = ctx;
+
+    if (newDir == NULL)
+        dirHandle->dirName = NULL;
+    else
+    {
+        dirHandle->dirName = (char *) allocator.Malloc(strlen(newDir) + 1);
+        if (!dirHandle->dirName)
+            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
+        strcpy(dirHandle->dirName, newDir);
+    } /* else */
+
+    if ((mountPoint != NULL) && (*mountPoint != '\0'))
+    {
+        dirHandle->mountPoint = (char *)allocator.Malloc(strlen(mountPoint)+2);
+        if (!dirHandle->mountPoint)
+            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
+        strcpy(dirHandle->mountPoint, mountPoint);
+        strcat(dirHandle->mountPoint, "/");
+    } /* if */
+
+    /* if this fails, verifyPath() just checks everything every time. */
+    dirHandle->verifyLock = __PHYSFS_platformCreateMutex();
+    dirHandle->serial = (PHYSFS_uint32) __PHYSFS_ATOMIC_INCR(&dirHandleSerial);
+
+    __PHYSFS_smallFree(tmpmntpnt);
+    return dirHandle;
+
+badDirHandle:
+    if (dirHandle != NULL)
+    {
+        closeDirHandleArchive(dirHandle);
+        allocator.Free(dirHandle->dirName);
+        allocator.Free(dirHandle->mountPoint);
+        allocator.Free(dirHandle);
+    } /* if */
+
+    __PHYSFS_smallFree(tmpmntpnt);
+    return NULL;
+} /* createDirHandle */
+
+
+/* Build a MountRoutes from NULL-terminated lists of virtual paths. */
+static MountRoutes *createMountRoutes(const char **include,
+                                      const char **exclude)
+{
+    MountRoutes *retval;
+    size_t numInclude = 0;
+    size_t numExclude = 0;
+    size_t len = sizeof (MountRoutes);
+    char *ptr;
+    size_t i;
+
+    for (i = 0; (include != NULL) && (include[i] != NULL); i++, numInclude++)
+        len += sizeof (MountRoute) + strlen(include[i]) + 1;
+    for (i = 0; (exclude != NULL) && (exclude[i] != NULL); i++, numExclude++)
+        len += sizeof (MountRoute) + strlen(exclude[i]) + 1;
+
+    retval = (MountRoutes *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(retval, '\0', sizeof (MountRoutes));
+    retval->size = len;
+    retval->include = (MountRoute *) (retval + 1);
+    retval->numInclude = numInclude;
+    retval->exclude = retval->include + numInclude;
+    retval->numExclude = numExclude;
+
+    ptr = (char *) (retval->exclude + numExclude);
+    for (i = 0; i < numInclude + numExclude; i++)
+    {
+        MountRoute *route = &retval->include[i];  /* exclude follows. */
+        const char *path = (i < numInclude) ? include[i] :
+                                              exclude[i - numInclude];
+        if (!sanitizePlatformIndependentPath(path, ptr))
+        {
+            allocator.Free(retval);
+            return NULL;
+        } /* if */
+        route->path = ptr;
+        route->len = strlen(ptr);
+        ptr += route->len + 1;
+    } /* for */
+
+    return retval;
+} /* createMountRoutes */
+
+
+/* A copy of (routes), without what it replaced. */
+static MountRoutes *copyMountRoutes(const MountRoutes *routes)
+{
+    const char *base = (const char *) routes;
+    MountRoutes *retval;
+    char *ptr;
+    size_t i;
+
+    retval = (MountRoutes *) allocator.Malloc(routes->size);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memcpy(retval, routes, routes->size);
+    retval->prev = NULL;
+
+    /* it's all one block, so everything in it just moves along with it. */
+    ptr = (char *) retval;
+    retval->include = (MountRoute *) (ptr + (((const char *) routes->include)
+                                             - base));
+    retval->exclude = retval->include + retval->numInclude;
+    for (i = 0; i < retval->numInclude + retval->numExclude; i++)
+    {
+        MountRoute *route = &retval->include[i];
+        route->path = ptr + (route->path - base);
+    } /* for */
+
+    return retval;
+} /* copyMountRoutes */
+
+
+static void freeMountRoutes(MountRoutes *routes)
+{
+    while (routes != NULL)
+    {
+        MountRoutes *prev = routes->prev;
+        allocator.Free(routes);
+        routes = prev;
+    } /* while */
+} /* freeMountRoutes */
+
+
+/* MAKE SURE you've got (dh)'s context's lock held before calling this! */
+static void profileForgetDirHandle(const DirHandle *dh);
+
+/*
+ * Start or stop keeping (h)'s stats for (seconds), as
+ *  PHYSFS_setMountStatCacheTime() says. Only native directories keep them.
+ *  Returns zero if out of memory. Caller holds (h)'s context's lock, if
+ *  (h) is in its search path.
+ */
+static int setStatCacheTime(DirHandle *h, const int seconds)
+{
+    if ((!h->native) || (h->verifyLock == NULL))
+        return 1;  /* nothing to do; lookups are cheap or can't be cached. */
+
+    if ((seconds != 0) && (h->stats == NULL))
+    {
+        const size_t len = sizeof (CachedStat) * STAT_CACHE_SLOTS;
+        CachedStat *stats = (CachedStat *) allocator.Malloc(len);
+        BAIL_IF_MACRO(!stats, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        memset(stats, '\0', len);
+        __PHYSFS_MEMORY_BARRIER();  /* lock-free lookups see it zeroed. */
+        h->stats = stats;  /* it stays until (h) is freed. */
+    } /* if */
+
+    h->statTime = (seconds < 0) ? -1 : seconds;
+    return 1;
+} /* setStatCacheTime */
+
+
+static void freePins(PinnedFile *pin);
+static PHYSFS_Io *openPinned(DirHandle *h, const char *arcfname);
+
+static int freeDirHandle(DirHandle *dh)
+{
+    size_t j;
+
+    if (dh == NULL)
+        return 1;
+
+    BAIL_IF_MACRO(dh->openFiles > 0, PHYSFS_ERR_FILES_STILL_OPEN, 0);
+
+    if (deinitingFast)  /* let go of OS handles; the memory goes at exit. */
+    {
+        closeDirHandleArchive(dh);
+        for (j = 0; (j < HANDLE_CACHE_SLOTS) && (dh->handles[j].io); j++)
+            dh->handles[j].io->destroy(dh->handles[j].io);
+        return 1;
+    } /* if */
+
+    freePins(dh->pins);  /* they're charged to dh->mem. */
+    allocator.Free(dh->indexNames);
+    __PHYSFS_memCharge(dh->mem, PHYSFS_MEMORY_INDEX,
+                       -((PHYSFS_sint64) dh->indexNamesLen));
+    closeDirHandleArchive(dh);
+    allocator.Free(dh->dirName);
+    allocator.Free(dh->mountPoint);
+    for (j = 0; j < VERIFY_CACHE_SLOTS; j++)
+        allocator.Free(dh->verified[j].path);
+    for (j = 0; j < LISTING_CACHE_SLOTS; j++)
+    {
+        allocator.Free(dh->listings[j].path);
+        allocator.Free(dh->listings[j].listing);  /* no readers left now. */
+    } /* for */
+    for (j = 0; (j < HANDLE_CACHE_SLOTS) && (dh->handles[j].io); j++)
+    {
+        dh->handles[j].io->destroy(dh->handles[j].io);
+        allocator.Free(dh->handles[j].path);
+    } /* for */
+    for (j = 0; (dh->stats != NULL) && (j < STAT_CACHE_SLOTS); j++)
+        allocator.Free(dh->stats[j].path);
+    allocator.Free(dh->stats);
+    if (dh->verifyLock != NULL)
+        __PHYSFS_platformDestroyMutex(dh->verifyLock);
+    freeMountRoutes(dh->routes);
+    profileForgetDirHandle(dh);
+    allocator.Free(dh);
+    return 1;
+} /* freeDirHandle */
+
+
+/*
+ * Call this before walking (ctx)'s search path without its lock, and pass
+ *  the return value to endSearchPathRead() when you're done with every
+ *  DirHandle you found. These nest, and never block.
+ */
+static int beginSearchPathRead(PHYSFS_Context *ctx)
+{
+    if (ctx->frozen)
+        return -1;  /* nothing can be retired; don't bother registering. */
+
+    while (1)
+    {
+        const int epoch = ctx->searchPathEpoch;
+        __PHYSFS_ATOMIC_INCR(&ctx->searchPathReaders[epoch & 1]);
+        if (ctx->searchPathEpoch == epoch)
+            return epoch & 1;
+
+        /* a writer moved to a new epoch under us; register there instead. */
+        __PHYSFS_ATOMIC_DECR(&ctx->searchPathReaders[epoch & 1]);
+    } /* while */
+} /* beginSearchPathRead */
+
+
+/* MAKE SURE you hold (dh)'s context's lock before calling this! */
+static int dirHandleInUse(const DirHandle *dh)
+{
+    if (dh->openFiles > 0)
+        return 1;
+
+    if ((dh->ctx->atomicPending != NULL) && (dh == dh->ctx->writeDir))
+        return 1;  /* PHYSFS_commitAtomicWrites() will need it. */
+
+    return 0;
+} /* dirHandleInUse */
+
+
+/*
+ * Close any retired DirHandles (and free any retired SearchIndexes) that
+ *  nobody can reach anymore.
+ *
+ * A retired handle might still be in use by readers that registered
+ *  during the epoch it was retired in, or any epoch before that. We only
+ *  move to the next epoch when nobody is registered under its parity,
+ *  which means everyone from two epochs ago has finished. So two moves
+ *  after a handle was retired, nothing can be looking at it.
+ *
+ * MAKE SURE you hold (ctx)'s lock before calling this!
+ */
+static void freeSearchIndex(SearchIndex *idx);
+
+static void reclaimRetired(PHYSFS_Context *ctx)
+{
+    DirHandle *prev = NULL;
+    DirHandle *next = NULL;
+    DirHandle *doomed = NULL;
+    DirHandle *i;
+    SearchIndex *previdx = NULL;
+    SearchIndex *nextidx = NULL;
+    SearchIndex *idx;
+    int moves;
+
+    for (moves = 0; moves < 2; moves++)
+    {
+        if ((!ctx->retiredDirHandles) && (!ctx->retiredIndexes))
+            break;  /* nothing to wait for. */
+        if (ctx->searchPathReaders[(ctx->searchPathEpoch + 1) & 1] != 0)
+            break;  /* someone is still reading from two epochs ago. */
+        __PHYSFS_ATOMIC_INCR(&ctx->searchPathEpoch);
+    } /* for */
+
+    for (i = ctx->retiredDirHandles; i != NULL; i = next)
+    {
+        next = i->retiredNext;
+        if ((ctx->searchPathEpoch - i->retiredEpoch < 2) ||
+            (dirHandleInUse(i)))
+            prev = i;
+        else
+        {
+            if (prev == NULL)
+                ctx->retiredDirHandles = next;
+            else
+                prev->retiredNext = next;
+
+            i->retiredNext = doomed;
+            doomed = i;
+        } /* else */
+    } /* for */
+
+    /*
+     * Closing a PHYSFS_mountHandle() archive closes its file, which comes
+     *  back here, so the list has to be done with before anything's freed.
+     */
+    while (doomed != NULL)
+    {
+        i = doomed;
+        doomed = i->retiredNext;
+        freeDirHandle(i);
+    } /* while */
+
+    /* an index is always retired before any DirHandle it points to is. */
+    for (idx = ctx->retiredIndexes; idx != NULL; idx = nextidx)
+    {
+        nextidx = idx->retiredNext;
+        if (ctx->searchPathEpoch - idx->retiredEpoch < 2)
+            previdx = idx;
+        else
+        {
+            if (previdx == NULL)
+                ctx->retiredIndexes = nextidx;
+            else
+                previdx->retiredNext = nextidx;
+
+            freeSearchIndex(idx);
+        } /* else */
+    } /* for */
+} /* reclaimRetired */
+
+
+/*
+ * Call this once (dh) is no longer reachable from its context's searchPath
+ *  or writeDir. It will be closed as soon as that's safe, which might be
+ *  right away.
+ *
+ * MAKE SURE you hold (dh)'s context's lock before calling this!
+ */
+static void retireDirHandle(DirHandle *dh)
+{
+    PHYSFS_Context *ctx = dh->ctx;
+    dh->retiredEpoch = ctx->searchPathEpoch;
+    dh->retiredNext = ctx->retiredDirHandles;
+    ctx->retiredDirHandles = dh;
+    reclaimRetired(ctx);
+} /* retireDirHandle */
+
+
+static void endSearchPathRead(PHYSFS_Context *ctx, const int reader)
+{
+    int remaining;
+
+    if (reader < 0)
+        return;  /* registered while frozen, so never registered at all. */
+
+    remaining = __PHYSFS_ATOMIC_DECR(&ctx->searchPathReaders[reader]);
+    if ((remaining == 0) && ((ctx->retiredDirHandles) ||
+                             (ctx->retiredIndexes)))
+    {
+        /* we might have been the last thing keeping something retired. */
+        grabLock(ctx->lock);
+        reclaimRetired(ctx);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+    } /* if */
+} /* endSearchPathRead */
+
+
+/*
+ * Wrap calls into (dh)'s archiver with these when you don't hold stateLock;
+ *  archivers that aren't known to be thread safe get it grabbed for them,
+ *  so they're never called from two threads at once, whatever context the
+ *  calls come from.
+ */
+static void lockDirHandle(const DirHandle *dh)
+{
+    if (!dh->reentrant)
+        grabStateLock();
+} /* lockDirHandle */
+
+
+static void unlockDirHandle(const DirHandle *dh)
+{
+    if (!dh->reentrant)
+        __PHYSFS_platformReleaseMutex(stateLock);
+} /* unlockDirHandle */
+
+
+/*
+ * The search path index.
+ *
+ * Without it, a lookup asks each archive in the search path, in order,
+ *  until one has the file, which adds up when dozens are mounted. With it,
+ *  each indexable archive lists every path it holds once, the first time
+ *  it's indexed, and the search path gets a hash table of those paths that
+ *  says which archive has each one first. A lookup probes that once, then
+ *  only asks the unindexed archives that come earlier, followed by the
+ *  winner and everything after it (so an archive failing to open the file
+ *  still falls through to the next one, like it always has).
+ *
+ * The table only needs to be a superset of what each archive would find,
+ *  so case-insensitive archives just match case-insensitively here, too.
+ */
+
+typedef struct
+{
+    char *buf;  /* '\0'-separated paths. */
+    size_t len;
+    size_t alloced;
+    size_t count;
+    int failed;
+} IndexNameList;
+
+
+/* Adds "dir/fname" to (list), or just "fname" if (dir) is empty. */
+static void appendIndexName(IndexNameList *list, const char *dir,
+                            const char *fname)
+{
+    const size_t dirlen = strlen(dir);
+    const size_t fnamelen = strlen(fname);
+    const size_t needed = dirlen + fnamelen + 2;
+    char *ptr;
+
+    if (list->failed)
+        return;
+
+    if (list->len + needed > list->alloced)
+    {
+        size_t newalloc = list->alloced * 2;
+        while (newalloc < list->len + needed)
+            newalloc *= 2;
+        ptr = (char *) allocator.Realloc(list->buf, newalloc);
+        if (ptr == NULL)
+        {
+            PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+            list->failed = 1;
+            return;
+        } /* if */
+        list->buf = ptr;
+        list->alloced = newalloc;
+    } /* if */
+
+    ptr = list->buf + list->len;
+    if (dirlen > 0)
+    {
+        memcpy(ptr, dir, dirlen);
+        ptr += dirlen;
+        *(ptr++) = '/';
+    } /* if */
+    memcpy(ptr, fname, fnamelen + 1);
+    list->len = ((size_t) (ptr - list->buf)) + fnamelen + 1;
+    list->count++;
+} /* appendIndexName */
+
+
+static void indexNamesCallback(void *data, const char *origdir,
+                               const char *fname)
+{
+    appendIndexName((IndexNameList *) data, origdir, fname);
+} /* indexNamesCallback */
+
+
+/* If the path at (pos) is a directory, add its contents to the end. */
+static void indexSubdir(DirHandle *dh, IndexNameList *list,
+                        const size_t pos, const size_t mntpntlen)
+{
+    PHYSFS_Stat statbuf;
+    size_t len = strlen(list->buf + pos) + 1;
+    char *dir;
+
+    if (!dh->funcs->stat(dh->opaque, list->buf + pos + mntpntlen, &statbuf))
+        return;
+    else if (statbuf.filetype != PHYSFS_FILETYPE_DIRECTORY)
+        return;
+
+    /* (list->buf) can move while we enumerate, so work from a copy. */
+    dir = (char *) __PHYSFS_smallAlloc(len);
+    if (dir == NULL)
+    {
+        PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+        list->failed = 1;
+        return;
+    } /* if */
+
+    memcpy(dir, list->buf + pos, len);
+    dh->funcs->enumerateFiles(dh->opaque, dir + mntpntlen,
+                              indexNamesCallback, dir, list);
+    __PHYSFS_smallFree(dir);
+} /* indexSubdir */
+
+
+/*
+ * Fill in (dh)'s list of every virtual path it can resolve: the directories
+ *  leading up to its mountpoint, the mountpoint itself, and everything in
+ *  the archive under that. This only happens once per DirHandle.
+ *
+ * MAKE SURE you hold (dh)'s context's lock, and lockDirHandle(dh), first!
+ */
+static int buildIndexNames(DirHandle *dh)
+{
+    const size_t mntpntlen = (dh->mountPoint) ? strlen(dh->mountPoint) : 0;
+    char *mntpnt = NULL;
+    IndexNameList list;
+    size_t pos = 0;
+
+    memset(&list, '\0', sizeof (list));
+    list.alloced = 256;
+    list.buf = (char *) allocator.Malloc(list.alloced);
+    BAIL_IF_MACRO(!list.buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (mntpntlen > 0)
+    {
+        char *ptr;
+        mntpnt = (char *) __PHYSFS_smallAlloc(mntpntlen + 1);
+        GOTO_IF_MACRO(!mntpnt, PHYSFS_ERR_OUT_OF_MEMORY, buildIndexFailed);
+        strcpy(mntpnt, dh->mountPoint);
+
+        /* "a/b/" adds "a" and "a/b", and leaves (mntpnt) as "a/b". */
+        for (ptr = strchr(mntpnt, '/'); ptr; ptr = strchr(ptr + 1, '/'))
+        {
+            *ptr = '\0';
+            appendIndexName(&list, "", mntpnt);
+            if (ptr[1] != '\0')
+                *ptr = '/';
+        } /* for */
+        pos = list.len;  /* these aren't in the archive; don't stat them. */
+    } /* if */
+
+    dh->funcs->enumerateFiles(dh->opaque, "", indexNamesCallback,
+                              mntpnt ? mntpnt : "", &list);
+    if (mntpnt != NULL)
+        __PHYSFS_smallFree(mntpnt);
+
+    /* (list) is its own work queue: each new directory's contents go on
+       the end, and get looked at when we reach them. */
+    while ((!list.failed) && (pos < list.len))
+    {
+        indexSubdir(dh, &list, pos, mntpntlen);
+        pos += strlen(list.buf + pos) + 1;
+    } /* while */
+
+    GOTO_IF_MACRO(list.failed, ERRPASS, buildIndexFailed);
+
+    dh->indexNames = list.buf;
+    dh->indexCount = list.count;
+    dh->indexNamesLen = list.len;
+    __PHYSFS_memCharge(dh->mem, PHYSFS_MEMORY_INDEX,
+                       (PHYSFS_sint64) dh->indexNamesLen);
+    return 1;
+
+buildIndexFailed:
+    allocator.Free(list.buf);
+    return 0;
+} /* buildIndexNames */
+
+
+/* Add (ch) to a hashIndexPath() hash that's being built a char at a time. */
+static PHYSFS_uint32 hashIndexPathChar(const PHYSFS_uint32 hash, char ch)
+{
+    if ((ch >= 'A') && (ch <= 'Z'))
+        ch -= ('A' - 'a');
+    return ((hash << 5) + hash) ^ ((PHYSFS_uint32) (PHYSFS_uint8) ch);
+} /* hashIndexPathChar */
+
+
+/* ASCII case-insensitive, so it works for INDEX_NOCASE_ASCII slots, too. */
+static PHYSFS_uint32 hashIndexPath(const char *path)
+{
+    PHYSFS_uint32 hash = 5381;
+    while (*path)
+        hash = hashIndexPathChar(hash, *(path++));
+    return hash;
+} /* hashIndexPath */
+
+
+static int indexPathsMatch(const SearchIndex *idx, const SearchIndexSlot *slot,
+                           const char *path)
+{
+    if (idx->handles[slot->rank]->indexMode == INDEX_NOCASE_ASCII)
+        return (__PHYSFS_stricmpASCII(slot->path, path) == 0);
+    return (strcmp(slot->path, path) == 0);
+} /* indexPathsMatch */
+
+
+static void addSearchIndexSlot(SearchIndex *idx, const char *path,
+                               const PHYSFS_uint32 rank)
+{
+    const PHYSFS_uint32 hash = hashIndexPath(path);
+    const size_t mask = idx->numSlots - 1;
+    const int nocase = (idx->handles[rank]->indexMode == INDEX_NOCASE_ASCII);
+    SearchIndexSlot *slot;
+    size_t i;
+
+    for (i = hash & mask; idx->slots[i].path != NULL; i = (i + 1) & mask)
+    {
+        /*
+         * Slots are added in search path order, so this one is earlier. If
+         *  it matches everything the new one would, the new one is useless.
+         */
+        slot = &idx->slots[i];
+        if ((slot->hash == hash) && (indexPathsMatch(idx, slot, path)))
+        {
+            const int prevmode = idx->handles[slot->rank]->indexMode;
+            if ((!nocase) || (prevmode == INDEX_NOCASE_ASCII))
+                return;
+        } /* if */
+    } /* for */
+
+    slot = &idx->slots[i];
+    slot->path = path;
+    slot->hash = hash;
+    slot->rank = rank;
+} /* addSearchIndexSlot */
+
+
+/*
+ * Returns the rank of the first archive that might have (path).
+ *  (hash) is hashIndexPath(path).
+ */
+static size_t findSearchIndexWinner(const SearchIndex *idx, const char *path,
+                                    const PHYSFS_uint32 hash)
+{
+    const size_t mask = idx->numSlots - 1;
+    size_t retval = idx->numHandles;
+    size_t i;
+
+    for (i = hash & mask; idx->slots[i].path != NULL; i = (i + 1) & mask)
+    {
+        const SearchIndexSlot *slot = &idx->slots[i];
+        if ((slot->hash == hash) && (slot->rank < retval))
+        {
+            if (indexPathsMatch(idx, slot, path))
+                retval = slot->rank;
+        } /* if */
+    } /* for */
+
+    return retval;
+} /* findSearchIndexWinner */
+
+
+/* Returns the mountSlots[] entry for the first (len) chars of (path). */
+static PHYSFS_uint32 findMountSlot(const SearchIndex *idx, const char *path,
+                                   const size_t len, const PHYSFS_uint32 hash)
+{
+    const size_t mask = idx->numMountSlots - 1;
+    size_t i;
+
+    for (i = hash & mask; ; i = (i + 1) & mask)
+    {
+        const MountNode *node = &idx->mountSlots[i];
+        if (node->path == NULL)
+            return (PHYSFS_uint32) i;  /* empty slot; not there. */
+        else if ((node->hash == hash) && (node->pathlen == len))
+        {
+            if (strncmp(node->path, path, len) == 0)
+                return (PHYSFS_uint32) i;
+        } /* else if */
+    } /* for */
+
+    return 0;  /* shouldn't hit this; there's always an empty slot. */
+} /* findMountSlot */
+
+
+/*
+ * Returns the deepest MountNode that (path) is, or is under. (*exact) is
+ *  set to non-zero if it's (path) itself, in which case archives mounted
+ *  below it count, too. (path) must already be sanitized.
+ */
+static const MountNode *findMountNode(const SearchIndex *idx,
+                                      const char *path, int *exact)
+{
+    const MountNode *retval = &idx->mountSlots[idx->rootMountSlot];
+    PHYSFS_uint32 hash = 5381;
+    size_t len;
+
+    *exact = 1;
+    for (len = 0; path[len] != '\0'; len++)
+    {
+        hash = hashIndexPathChar(hash, path[len]);
+        if ((path[len + 1] == '/') || (path[len + 1] == '\0'))
+        {
+            const PHYSFS_uint32 i = findMountSlot(idx, path, len + 1, hash);
+            if (idx->mountSlots[i].path == NULL)
+            {
+                *exact = 0;  /* nothing is mounted at or under this. */
+                break;
+            } /* if */
+            retval = &idx->mountSlots[i];
+        } /* if */
+    } /* for */
+
+    return retval;
+} /* findMountNode */
+
+
+/*
+ * Fill in (idx)'s MountNodes from its handles. Returns zero if out of
+ *  memory, in which case freeSearchIndex() cleans up what was done.
+ */
+static int buildMountNodes(SearchIndex *idx)
+{
+    const size_t numHandles = idx->numHandles;
+    size_t numSlots = 16;
+    size_t maxNodes = 1;  /* the root. */
+    size_t numNodes = 0;
+    size_t total = 0;
+    PHYSFS_uint32 *homes;  /* scratch: the node each rank is mounted at. */
+    PHYSFS_uint32 *order;  /* scratch: nodes as added, parents first. */
+    PHYSFS_uint32 *fill;  /* scratch: next free spot in each node's all. */
+    PHYSFS_uint32 *ranks;
+    PHYSFS_uint32 root;
+    size_t rank;
+    size_t len;
+    size_t i;
+
+    for (rank = 0; rank < numHandles; rank++)
+    {
+        const char *ptr = idx->handles[rank]->mountPoint;
+        while ((ptr != NULL) && ((ptr = strchr(ptr, '/')) != NULL))
+        {
+            maxNodes++;  /* every mountpoint ends with a '/', too. */
+            ptr++;
+        } /* while */
+    } /* for */
+
+    while (numSlots < (maxNodes * 2))  /* keep it at least half empty. */
+        numSlots *= 2;
+
+    len = numSlots * sizeof (MountNode);
+    idx->mountSlots = (MountNode *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!idx->mountSlots, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(idx->mountSlots, '\0', len);
+    idx->numMountSlots = numSlots;
+
+    len = (numHandles + maxNodes + numSlots) * sizeof (PHYSFS_uint32);
+    homes = (PHYSFS_uint32 *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!homes, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(homes, '\0', len);
+    order = homes + numHandles;
+    fill = order + maxNodes;
+
+    root = findMountSlot(idx, "", 0, 5381);
+    idx->rootMountSlot = root;
+    idx->mountSlots[root].path = "";
+    idx->mountSlots[root].hash = 5381;
+    idx->mountSlots[root].parent = root;
+    order[numNodes++] = root;
+
+    /* add every dir that leads to a mount point, and count what's where. */
+    for (rank = 0; rank < numHandles; rank++)
+    {
+        const char *mntpnt = idx->handles[rank]->mountPoint;
+        PHYSFS_uint32 hash = 5381;
+        PHYSFS_uint32 node = root;
+
+        for (i = 0; (mntpnt != NULL) && (mntpnt[i] != '\0'); i++)
+        {
+            if (mntpnt[i] == '/')
+            {
+                const PHYSFS_uint32 parent = node;
+                node = findMountSlot(idx, mntpnt, i, hash);
+                if (idx->mountSlots[node].path == NULL)
+                {
+                    MountNode *added = &idx->mountSlots[node];
+                    added->path = mntpnt;
+                    added->pathlen = i;
+                    added->hash = hash;
+                    added->parent = parent;
+                    order[numNodes++] = node;
+                } /* if */
+            } /* if */
+            hash = hashIndexPathChar(hash, mntpnt[i]);
+        } /* for */
+
+        homes[rank] = node;
+        idx->mountSlots[node].numAbove++;
+        while (1)
+        {
+            idx->mountSlots[node].numAll++;
+            if (node == root)
+                break;
+            node = idx->mountSlots[node].parent;
+        } /* while */
+    } /* for */
+
+    /* add on what's mounted above each node. Parents are done first. */
+    for (i = 0; i < numNodes; i++)
+    {
+        MountNode *node = &idx->mountSlots[order[i]];
+        if (order[i] != root)
+        {
+            const MountNode *parent = &idx->mountSlots[node->parent];
+            const PHYSFS_uint32 inherited = parent->numAbove;
+            node->numAbove += inherited;
+            node->numAll += inherited;
+        } /* if */
+        total += node->numAbove + node->numAll;
+    } /* for */
+
+    ranks = (PHYSFS_uint32 *) allocator.Malloc(total * sizeof (PHYSFS_uint32));
+    GOTO_IF_MACRO((!ranks) && (total), PHYSFS_ERR_OUT_OF_MEMORY, mountFailed);
+    idx->mountRanks = ranks;
+
+    for (i = 0; i < numNodes; i++)
+    {
+        MountNode *node = &idx->mountSlots[order[i]];
+        node->all = ranks;
+        ranks += node->numAll;
+        node->above = ranks;
+        ranks += node->numAbove;
+        fill[order[i]] = node->numAll;
+    } /* for */
+
+    /*
+     * Put what's mounted at or under each node at the end of its list.
+     *  Going backwards leaves them in search path order.
+     */
+    for (rank = numHandles; rank-- > 0; )
+    {
+        PHYSFS_uint32 node = homes[rank];
+        while (1)
+        {
+            idx->mountSlots[node].all[--fill[node]] = (PHYSFS_uint32) rank;
+            if (node == root)
+                break;
+            node = idx->mountSlots[node].parent;
+        } /* while */
+    } /* for */
+
+    /*
+     * Now merge what's mounted above each node into the front of the list,
+     *  and copy out the ones that aren't mounted under it.
+     */
+    for (i = 0; i < numNodes; i++)
+    {
+        MountNode *node = &idx->mountSlots[order[i]];
+        const MountNode *parent = &idx->mountSlots[node->parent];
+        const size_t inherited = (order[i] == root) ? 0 : parent->numAbove;
+        size_t a = 0;
+        size_t b = inherited;
+        size_t out = 0;
+
+        assert(fill[order[i]] == inherited);
+        while (a < inherited)  /* (out) never passes (b), so this is safe. */
+        {
+            if ((b < node->numAll) && (node->all[b] < parent->above[a]))
+                node->all[out++] = node->all[b++];
+            else
+                node->all[out++] = parent->above[a++];
+        } /* while */
+
+        for (a = 0, out = 0; a < node->numAll; a++)
+        {
+            const PHYSFS_uint32 r = node->all[a];
+            if (idx->mountSlots[homes[r]].pathlen <= node->pathlen)
+                node->above[out++] = r;
+        } /* for */
+        assert(out == node->numAbove);
+    } /* for */
+
+    allocator.Free(homes);
+    return 1;
+
+mountFailed:
+    allocator.Free(homes);
+    return 0;
+} /* buildMountNodes */
+
+
+static void freeSearchIndex(SearchIndex *idx)
+{
+    allocator.Free(idx->mountRanks);
+    allocator.Free(idx->mountSlots);
+    allocator.Free(idx);  /* everything else is in one allocation. */
+} /* freeSearchIndex */
+
+
+/*
+ * Build a new index of (ctx)'s search path. If indexing is enabled,
+ *  archives whose paths can't be listed (out of memory, etc) are just
+ *  left unindexed.
+ *
+ * MAKE SURE you hold (ctx)'s lock before calling this!
+ */
+static SearchIndex *buildSearchIndex(PHYSFS_Context *ctx)
+{
+    SearchIndex *retval;
+    DirHandle *dh;
+    size_t numHandles = 0;
+    size_t numNames = 0;
+    size_t numSlots = 0;
+    size_t rank;
+    size_t len;
+    char *ptr;
+
+    for (dh = ctx->searchPath; dh != NULL; dh = dh->next)
+    {
+        numHandles++;
+        if (!ctx->useSearchIndex)
+            continue;
+        else if ((dh->indexMode != INDEX_NONE) && (dh->indexNames == NULL))
+        {
+            lockDirHandle(dh);
+            buildIndexNames(dh);  /* stays unindexed if this fails. */
+            unlockDirHandle(dh);
+        } /* else if */
+        numNames += dh->indexCount;
+    } /* for */
+
+    if (ctx->useSearchIndex)
+    {
+        numSlots = 16;
+        while (numSlots < (numNames * 2))  /* keep it at least half empty. */
+            numSlots *= 2;
+    } /* if */
+
+    /* it's all in one allocation: the struct, slots, handles and flags. */
+    len = sizeof (SearchIndex) + (numSlots * sizeof (SearchIndexSlot)) +
+          (numHandles * (sizeof (DirHandle *) + sizeof (PHYSFS_uint8)));
+    ptr = (char *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(ptr, '\0', len);
+
+    retval = (SearchIndex *) ptr;
+    ptr += sizeof (SearchIndex);
+    retval->slots = (SearchIndexSlot *) ptr;
+    retval->numSlots = numSlots;
+    ptr += numSlots * sizeof (SearchIndexSlot);
+    retval->handles = (DirHandle **) ptr;
+    retval->numHandles = numHandles;
+    ptr += numHandles * sizeof (DirHandle *);
+    retval->indexed = (PHYSFS_uint8 *) ptr;
+
+    for (rank = 0, dh = ctx->searchPath; dh != NULL; rank++, dh = dh->next)
+    {
+        const char *name = dh->indexNames;
+        size_t i;
+
+        retval->handles[rank] = dh;
+        if ((name == NULL) || (!ctx->useSearchIndex))
+            continue;
+
+        retval->indexed[rank] = 1;
+        for (i = 0; i < dh->indexCount; i++, name += strlen(name) + 1)
+            addSearchIndexSlot(retval, name, (PHYSFS_uint32) rank);
+    } /* for */
+
+    if (!buildMountNodes(retval))
+    {
+        freeSearchIndex(retval);
+        return NULL;
+    } /* if */
+
+    return retval;
+} /* buildSearchIndex */
+
+
+/*
+ * Call this after any change to (ctx)'s searchPath, before retiring
+ *  anything that came out of it: the old index can still point at those
+ *  DirHandles. If this runs out of memory, lookups just walk searchPath.
+ *
+ * MAKE SURE you hold (ctx)'s lock before calling this!
+ */
+static void rebuildSearchIndex(PHYSFS_Context *ctx)
+{
+    SearchIndex *oldidx = ctx->searchIndex;
+    SearchIndex *newidx = buildSearchIndex(ctx);
+
+    __PHYSFS_MEMORY_BARRIER();  /* lookups don't lock; publish it whole. */
+    ctx->searchIndex = newidx;
+
+    if (oldidx != NULL)
+    {
+        oldidx->retiredEpoch = ctx->searchPathEpoch;
+        oldidx->retiredNext = ctx->retiredIndexes;
+        ctx->retiredIndexes = oldidx;
+        reclaimRetired(ctx);
+    } /* if */
+} /* rebuildSearchIndex */
+
+
+/*
+ * Walks the archives that might have a given path, in search path order:
+ *  the ones mounted at or above it, and (if it's a dir that leads to other
+ *  mount points) the ones mounted under it. Only use this between
+ *  beginSearchPathRead() and endSearchPathRead().
+ */
+typedef struct
+{
+    const SearchIndex *index;  /* NULL to just walk searchPath. */
+    DirHandle *next;  /* next in searchPath, if (index) is NULL. */
+    const PHYSFS_uint32 *ranks;  /* index->handles to try, otherwise. */
+    size_t numRanks;  /* Length of ranks. */
+    size_t pos;  /* next in ranks. */
+    size_t winner;  /* first indexed archive that gets a look. */
+    const char *fname;  /* what's being looked for, for routes. */
+} SearchPathIter;
+
+
+/* Is (path) (prefix), or something under it? "" is above everything. */
+static int pathUnder(const char *path, const MountRoute *prefix)
+{
+    const size_t len = prefix->len;
+    if (len == 0)
+        return 1;
+    else if (strncmp(path, prefix->path, len) != 0)
+        return 0;
+    return ((path[len] == '\0') || (path[len] == '/'));
+} /* pathUnder */
+
+
+/*
+ * Could (dh) have (fname), as far as its PHYSFS_setMountRoutes() go? The
+ *  directories above an included path are fair game too, so they still
+ *  show up in listings and PHYSFS_stat().
+ */
+static int routedTo(const DirHandle *dh, const char *fname)
+{
+    const MountRoutes *routes = dh->routes;
+    size_t i;
+
+    if (routes == NULL)
+        return 1;
+
+    for (i = 0; i < routes->numExclude; i++)
+    {
+        if (pathUnder(fname, &routes->exclude[i]))
+            return 0;
+    } /* for */
+
+    if (routes->numInclude == 0)
+        return 1;
+
+    for (i = 0; i < routes->numInclude; i++)
+    {
+        const MountRoute *route = &routes->include[i];
+        MountRoute above;
+        if (pathUnder(fname, route))
+            return 1;
+        above.path = fname;
+        above.len = strlen(fname);
+        if (pathUnder(route->path, &above))
+            return 1;
+    } /* for */
+
+    return 0;
+} /* routedTo */
+
+
+static DirHandle *nextCandidate(SearchPathIter *iter)
+{
+    const SearchIndex *idx = iter->index;
+    DirHandle *retval = NULL;
+
+    while (1)
+    {
+        if (idx == NULL)
+        {
+            retval = iter->next;
+            if (retval != NULL)
+                iter->next = retval->next;
+        } /* if */
+
+        else
+        {
+            retval = NULL;
+            while ((retval == NULL) && (iter->pos < iter->numRanks))
+            {
+                const size_t i = iter->ranks[iter->pos++];
+                if ((i >= iter->winner) || (!idx->indexed[i]))
+                    retval = idx->handles[i];
+            } /* while */
+        } /* else */
+
+        /* skip anything routed elsewhere without asking it. */
+        if ((retval == NULL) || (routedTo(retval, iter->fname)))
+            return retval;
+    } /* while */
+} /* nextCandidate */
+
+
+/*
+ * Start walking the archives mounted where they might have (fname),
+ *  skipping indexed ones earlier than (winner). (fname) must already be
+ *  sanitized.
+ */
+static DirHandle *startSearchPath(PHYSFS_Context *ctx, SearchPathIter *iter,
+                                  const char *fname, const size_t winner)
+{
+    const SearchIndex *idx = ctx->searchIndex;
+
+    memset(iter, '\0', sizeof (SearchPathIter));
+    iter->next = ctx->searchPath;
+    iter->index = idx;
+    iter->winner = winner;
+    iter->fname = fname;
+
+    if (idx != NULL)
+    {
+        int exact = 0;
+        const MountNode *node = findMountNode(idx, fname, &exact);
+        iter->ranks = (exact) ? node->all : node->above;
+        iter->numRanks = (exact) ? node->numAll : node->numAbove;
+    } /* if */
+
+    return nextCandidate(iter);
+} /* startSearchPath */
+
+
+/* Use this for directory listings, which want every archive routed to. */
+static DirHandle *routeSearchPath(PHYSFS_Context *ctx, SearchPathIter *iter,
+                                  const char *fname)
+{
+    return startSearchPath(ctx, iter, fname, 0);
+} /* routeSearchPath */
+
+
+/* Use this for looking up a single file. (hash) is hashIndexPath(fname). */
+static DirHandle *firstCandidate(PHYSFS_Context *ctx, SearchPathIter *iter,
+                                 const char *fname, const PHYSFS_uint32 hash)
+{
+    const SearchIndex *idx = ctx->searchIndex;
+    size_t winner = 0;
+    DirHandle *retval;
+
+    /* ZIP takes "file$password", which isn't a path it lists. */
+    if ((idx != NULL) && (idx->numSlots != 0) && (*fname != '\0') &&
+        (strchr(fname, '$') == NULL))
+        winner = findSearchIndexWinner(idx, fname, hash);
+
+    retval = startSearchPath(ctx, iter, fname, winner);
+    if (retval == NULL)  /* what verifyPath() would have said. */
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+    return retval;
+} /* firstCandidate */
+
+
+/*
+ * Call this after anything that might make a path exist that didn't before,
+ *  or change what a directory listing says. Lookups that started earlier
+ *  can still add a miss (or a listing), but it's already stale.
+ */
+static void bumpSearchGeneration(PHYSFS_Context *ctx)
+{
+    __PHYSFS_ATOMIC_INCR(&ctx->searchGeneration);
+} /* bumpSearchGeneration */
+
+
+/* For settings that change what every context should trust. */
+static void bumpAllSearchGenerations(void)
+{
+    PHYSFS_Context *ctx;
+
+    if (contextLock == NULL)  /* not initialized; there's only the one. */
+    {
+        bumpSearchGeneration(&defaultContext);
+        return;
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(contextLock);
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+        bumpSearchGeneration(ctx);
+    __PHYSFS_platformReleaseMutex(contextLock);
+} /* bumpAllSearchGenerations */
+
+
+/*
+ * Native directories in the search path get watched for changes while the
+ *  app has a change callback set. These are kept apart from the DirHandles,
+ *  since a watch has to be stopped without stateLock held: stopping waits
+ *  for its callback to return, and that callback might be waiting for
+ *  stateLock itself.
+ */
+typedef struct NativeWatch
+{
+    char *dirName;  /* DirHandle::dirName of what's being watched. */
+    char *mountPoint;  /* DirHandle::mountPoint, with its trailing '/'. */
+    PHYSFS_Context *ctx;  /* DirHandle::ctx. */
+    void *handle;  /* from __PHYSFS_platformWatchDir(). */
+    struct NativeWatch *next;
+} NativeWatch;
+
+static NativeWatch *nativeWatches = NULL;
+static PHYSFS_ChangeCallback changeCallback = NULL;
+static void *changeCallbackData = NULL;
+
+
+/* platform watches call this, from their own threads. */
+static void nativeDirChanged(void *data, const char *path)
+{
+    const NativeWatch *w = (const NativeWatch *) data;
+    const char *mntpnt = w->mountPoint ? w->mountPoint : "";
+    PHYSFS_ChangeCallback callback;
+    void *callbackData;
+    size_t len;
+    char *vpath;
+
+    bumpSearchGeneration(w->ctx);  /* what we remember about it is stale. */
+
+    __PHYSFS_platformGrabMutex(watchLock);
+    callback = changeCallback;
+    callbackData = changeCallbackData;
+    __PHYSFS_platformReleaseMutex(watchLock);
+
+    if (callback == NULL)
+        return;
+
+    len = strlen(mntpnt) + strlen(path) + 1;
+    vpath = (char *) __PHYSFS_smallAlloc(len);
+    if (vpath == NULL)
+        return;  /* oh well. */
+
+    strcpy(vpath, mntpnt);
+    strcat(vpath, path);
+    len = strlen(vpath);
+    if ((len > 0) && (vpath[len - 1] == '/'))
+        vpath[len - 1] = '\0';  /* the mount point itself changed. */
+
+    callback(callbackData, vpath);
+    __PHYSFS_smallFree(vpath);
+} /* nativeDirChanged */
+
+
+static int isStillWatched(const NativeWatch *w)
+{
+    const DirHandle *i;
+
+    if (changeCallback == NULL)
+        return 0;
+
+    for (i = w->ctx->searchPath; i != NULL; i = i->next)
+    {
+        if ((i->native) && (strcmp(i->dirName, w->dirName) == 0))
+        {
+            if ((i->mountPoint == NULL) || (w->mountPoint == NULL))
+                return (i->mountPoint == w->mountPoint);
+            return (strcmp(i->mountPoint, w->mountPoint) == 0);
+        } /* if */
+    } /* for */
+
+    return 0;
+} /* isStillWatched */
+
+
+static int startWatching(const DirHandle *dh)
+{
+    NativeWatch *w = (NativeWatch *) allocator.Malloc(sizeof (NativeWatch));
+    BAIL_IF_MACRO(!w, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(w, '\0', sizeof (NativeWatch));
+
+    w->ctx = dh->ctx;
+    w->dirName = __PHYSFS_strdup(dh->dirName);
+    GOTO_IF_MACRO(!w->dirName, PHYSFS_ERR_OUT_OF_MEMORY, startWatchingFailed);
+    if (dh->mountPoint != NULL)
+    {
+        w->mountPoint = __PHYSFS_strdup(dh->mountPoint);
+        GOTO_IF_MACRO(!w->mountPoint, PHYSFS_ERR_OUT_OF_MEMORY,
+                      startWatchingFailed);
+    } /* if */
+
+    w->handle = __PHYSFS_platformWatchDir(w->dirName, nativeDirChanged, w);
+    GOTO_IF_MACRO(!w->handle, ERRPASS, startWatchingFailed);
+
+    w->next = nativeWatches;
+    nativeWatches = w;
+    return 1;
+
+startWatchingFailed:
+    allocator.Free(w->dirName);
+    allocator.Free(w->mountPoint);
+    allocator.Free(w);
+    return 0;
+} /* startWatching */
+
+
+/*
+ * Make (ctx)'s nativeWatches match the native dirs in its search path: all
+ *  of them if there's a change callback, none if there isn't. Returns zero
+ *  if a dir that should be watched couldn't be. Don't hold (ctx)'s lock!
+ */
+static int syncWatches(PHYSFS_Context *ctx)
+{
+    NativeWatch *stale = NULL;
+    NativeWatch **prev;
+    NativeWatch *w;
+    DirHandle *i;
+    int retval = 1;
+
+    __PHYSFS_platformGrabMutex(watchLock);
+    grabLock(ctx->lock);
+
+    prev = &nativeWatches;
+    while ((w = *prev) != NULL)
+    {
+        if ((w->ctx != ctx) || (isStillWatched(w)))
+            prev = &w->next;
+        else
+        {
+            *prev = w->next;
+            w->next = stale;
+            stale = w;
+        } /* else */
+    } /* while */
+
+    for (i = ctx->searchPath; (i) && (changeCallback != NULL); i = i->next)
+    {
+        if (i->native)
+        {
+            for (w = nativeWatches; w != NULL; w = w->next)
+            {
+                if ((w->ctx == ctx) && (strcmp(w->dirName, i->dirName) == 0))
+                    break;
+            } /* for */
+
+            if ((w == NULL) && (!startWatching(i)))
+                retval = 0;
+        } /* if */
+    } /* for */
+
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    __PHYSFS_platformReleaseMutex(watchLock);
+
+    while (stale != NULL)
+    {
+        w = stale;
+        stale = w->next;
+        __PHYSFS_platformUnwatchDir(w->handle);
+        allocator.Free(w->dirName);
+        allocator.Free(w->mountPoint);
+        allocator.Free(w);
+    } /* while */
+
+    return retval;
+} /* syncWatches */
+
+
+int PHYSFS_setChangeCallback(PHYSFS_ChangeCallback callback, void *data)
+{
+    PHYSFS_Context *ctx;
+    int retval = 1;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    __PHYSFS_platformGrabMutex(watchLock);
+    changeCallback = callback;
+    changeCallbackData = data;
+    __PHYSFS_platformReleaseMutex(watchLock);
+
+    __PHYSFS_platformGrabMutex(contextLock);
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+    {
+        if (!syncWatches(ctx))
+            retval = 0;
+    } /* for */
+    __PHYSFS_platformReleaseMutex(contextLock);
+
+    return retval;
+} /* PHYSFS_setChangeCallback */
+
+
+/*
+ * (fname) must already be sanitized, and (hash) is hashIndexPath(fname).
+ *  Sets PHYSFS_ERR_NOT_FOUND if true.
+ */
+static int knownMissing(const PHYSFS_Context *ctx, const char *fname,
+                        const PHYSFS_uint32 hash, const int generation)
+{
+    const MissCacheSlot *slot;
+    int retval;
+
+    if (!useMissCache)
+        return 0;
+
+    slot = &missCache[hash & (MISS_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(missCacheLock);
+    retval = ( (slot->path != NULL) && (slot->generation == generation) &&
+               (slot->ctx == ctx) && (slot->hash == hash) &&
+               (strcmp(slot->path, fname) == 0) );
+    __PHYSFS_platformReleaseMutex(missCacheLock);
+
+    BAIL_IF_MACRO(retval, PHYSFS_ERR_NOT_FOUND, 1);
+    return 0;
+} /* knownMissing */
+
+
+/*
+ * Call this when a lookup of (fname) found nothing, with the generation from
+ *  before it started. Only plain "not found" gets remembered.
+ */
+static void rememberMissing(const PHYSFS_Context *ctx, const char *fname,
+                            const PHYSFS_uint32 hash, const int generation)
+{
+    const size_t len = strlen(fname) + 1;
+    MissCacheSlot *slot;
+    char *ptr;
+
+    if ((!useMissCache) || (currentErrorCode() != PHYSFS_ERR_NOT_FOUND))
+        return;
+
+    slot = &missCache[hash & (MISS_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(missCacheLock);
+    if ((slot->path != NULL) && (slot->ctx == ctx) &&
+        (strcmp(slot->path, fname) == 0))
+        slot->generation = generation;  /* already have it; refresh it. */
+    else
+    {
+        ptr = (char *) allocator.Realloc(slot->path, len);
+        if (ptr != NULL)  /* if this fails, just keep the old entry. */
+        {
+            memcpy(ptr, fname, len);
+            slot->path = ptr;
+            slot->hash = hash;
+            slot->ctx = ctx;
+            slot->generation = generation;
+        } /* if */
+    } /* else */
+    __PHYSFS_platformReleaseMutex(missCacheLock);
+} /* rememberMissing */
+
+
+/* Drop what (ctx) remembered, before something else can get its address. */
+static void forgetMissing(const PHYSFS_Context *ctx)
+{
+    size_t i;
+
+    __PHYSFS_platformGrabMutex(missCacheLock);
+    for (i = 0; i < MISS_CACHE_SLOTS; i++)
+    {
+        if (missCache[i].ctx == ctx)
+        {
+            allocator.Free(missCache[i].path);
+            missCache[i].path = NULL;
+            missCache[i].ctx = NULL;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(missCacheLock);
+} /* forgetMissing */
+
+
+/* Nothing else may be using the cache when you call this. */
+static void freeMissCache(void)
+{
+    size_t i;
+    for (i = 0; i < MISS_CACHE_SLOTS; i++)
+    {
+        allocator.Free(missCache[i].path);
+        missCache[i].path = NULL;
+    } /* for */
+} /* freeMissCache */
+
+
+/* MAKE SURE you hold profileLock, or that nobody else can, before this! */
+static void freeAccessProfile(void)
+{
+    ProfileMount *mount = profileMounts;
+    while (mount != NULL)
+    {
+        ProfileMount *nextMount = mount->next;
+        ProfileFile *file = mount->files;
+        while (file != NULL)
+        {
+            ProfileFile *nextFile = file->next;
+            ProfileSpan *span = file->spans;
+            while (span != NULL)
+            {
+                ProfileSpan *nextSpan = span->next;
+                allocator.Free(span);
+                span = nextSpan;
+            } /* while */
+            allocator.Free(file->path);
+            allocator.Free(file);
+            file = nextFile;
+        } /* while */
+        allocator.Free(mount->dirName);
+        allocator.Free(mount->mountPoint);
+        allocator.Free(mount);
+        mount = nextMount;
+    } /* while */
+
+    profileMounts = lastProfileMount = NULL;
+    memset(profileHash, '\0', sizeof (profileHash));
+    profileOrder = 0;
+} /* freeAccessProfile */
+
+
+/* MAKE SURE you hold predictLock, or that nobody else can, before this! */
+static void freePredictModel(void)
+{
+    size_t i;
+
+    for (i = 0; i < PREDICT_HASH_SLOTS; i++)
+    {
+        PredictNode *node = predictHash[i];
+        while (node != NULL)
+        {
+            PredictNode *next = node->hashNext;
+            allocator.Free(node->path);
+            allocator.Free(node);
+            node = next;
+        } /* while */
+    } /* for */
+
+    memset(predictHash, '\0', sizeof (predictHash));
+    predictNodeCount = 0;
+    predictOpens = 0;
+    predictLast = NULL;
+} /* freePredictModel */
+
+
+static char *profileStrDup(const char *str)
+{
+    const size_t len = strlen(str) + 1;
+    char *retval = (char *) allocator.Malloc(len);
+    if (retval != NULL)
+        memcpy(retval, str, len);
+    return retval;
+} /* profileStrDup */
+
+
+/* MAKE SURE you hold profileLock before calling this! */
+static ProfileMount *profileFindMount(const DirHandle *dh)
+{
+    ProfileMount *mount;
+
+    for (mount = profileMounts; mount != NULL; mount = mount->next)
+    {
+        if (mount->dirHandle == dh)
+            return mount;
+    } /* for */
+
+    mount = (ProfileMount *) allocator.Malloc(sizeof (ProfileMount));
+    BAIL_IF_MACRO(!mount, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(mount, '\0', sizeof (ProfileMount));
+    mount->dirHandle = dh;
+    mount->dirName = profileStrDup(dh->dirName);
+    mount->mountPoint = profileStrDup(dh->mountPoint ? dh->mountPoint : "/");
+    if ((mount->dirName == NULL) || (mount->mountPoint == NULL))
+    {
+        allocator.Free(mount->dirName);
+        allocator.Free(mount->mountPoint);
+        allocator.Free(mount);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    if (lastProfileMount == NULL)
+        profileMounts = mount;
+    else
+        lastProfileMount->next = mount;
+    lastProfileMount = mount;
+    return mount;
+} /* profileFindMount */
+
+
+/*
+ * Note that (fh) was just opened from (arcfname) in (dh). MAKE SURE you
+ *  hold its context's lock, and that (fh) is in openReadList, before this,
+ *  so PHYSFS_enableAccessProfile() can't miss it when dropping records.
+ *  Running out of memory just leaves the file out of the profile.
+ */
+static void profileOpen(FileHandle *fh, const DirHandle *dh,
+                        const char *arcfname)
+{
+    const PHYSFS_uint32 hash = hashIndexPath(arcfname);
+    const size_t slot = hash & (PROFILE_HASH_SLOTS - 1);
+    ProfileMount *mount;
+    ProfileFile *file;
+
+    __PHYSFS_platformGrabMutex(profileLock);
+    if (!profiling)
+        goto profileOpenEnd;
+
+    mount = profileFindMount(dh);
+    if (mount == NULL)
+        goto profileOpenEnd;
+
+    for (file = profileHash[slot]; file != NULL; file = file->hashNext)
+    {
+        if ((file->mount == mount) && (file->hash == hash) &&
+            (strcmp(file->path, arcfname) == 0))
+            break;
+    } /* for */
+
+    if (file == NULL)
+    {
+        file = (ProfileFile *) allocator.Malloc(sizeof (ProfileFile));
+        if (file == NULL)
+            goto profileOpenEnd;
+        memset(file, '\0', sizeof (ProfileFile));
+        file->path = profileStrDup(arcfname);
+        if (file->path == NULL)
+        {
+            allocator.Free(file);
+            goto profileOpenEnd;
+        } /* if */
+        file->hash = hash;
+        file->order = ++profileOrder;
+        file->mount = mount;
+        file->hashNext = profileHash[slot];
+        profileHash[slot] = file;
+        if (mount->lastFile == NULL)
+            mount->files = file;
+        else
+            mount->lastFile->next = file;
+        mount->lastFile = file;
+    } /* if */
+
+    file->opens++;
+    fh->profile = file;
+
+profileOpenEnd:
+    __PHYSFS_platformReleaseMutex(profileLock);
+} /* profileOpen */
+
+
+/* Note that (len) bytes were read from (offset) in (fh). */
+static void profileRead(FileHandle *fh, PHYSFS_uint64 offset,
+                        PHYSFS_uint64 len)
+{
+    ProfileFile *file;
+
+    if (len == 0)
+        return;
+
+    __PHYSFS_platformGrabMutex(profileLock);
+    file = fh->profile;
+    if ((profiling) && (file != NULL))
+    {
+        ProfileSpan *span = file->lastSpan;
+        file->bytesRead += len;
+        if ((span != NULL) && (span->offset + span->len == offset))
+            span->len += len;
+        else
+        {
+            span = (ProfileSpan *) allocator.Malloc(sizeof (ProfileSpan));
+            if (span != NULL)
+            {
+                span->offset = offset;
+                span->len = len;
+                span->next = NULL;
+                if (file->lastSpan == NULL)
+                    file->spans = span;
+                else
+                    file->lastSpan->next = span;
+                file->lastSpan = span;
+            } /* if */
+        } /* else */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(profileLock);
+} /* profileRead */
+
+
+/* (dh) is being freed; a new one could get its address, so let it go. */
+static void profileForgetDirHandle(const DirHandle *dh)
+{
+    ProfileMount *mount;
+
+    if (profileLock == NULL)
+        return;
+
+    __PHYSFS_platformGrabMutex(profileLock);
+    for (mount = profileMounts; mount != NULL; mount = mount->next)
+    {
+        if (mount->dirHandle == dh)
+            mount->dirHandle = NULL;
+    } /* for */
+    __PHYSFS_platformReleaseMutex(profileLock);
+} /* profileForgetDirHandle */
+
+
+static char *calculateBaseDir(const char *argv0)
+{
+    const char dirsep = __PHYSFS_platformDirSeparator;
+    char *retval = NULL;
+    char *ptr = NULL;
+
+    /* Give the platform layer first shot at this. */
+    retval = __PHYSFS_platformCalcBaseDir(argv0);
+    if (retval != NULL)
+        return retval;
+
+    /* We need argv0 to go on. */
+    BAIL_IF_MACRO(argv0 == NULL, PHYSFS_ERR_ARGV0_IS_NULL, NULL);
+
+    ptr = strrchr(argv0, dirsep);
+    if (ptr != NULL)
+    {
+        const size_t size = ((size_t) (ptr - argv0)) + 1;
+        retval = (char *) allocator.Malloc(size + 1);
+        BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+        memcpy(retval, argv0, size);
+        retval[size] = '\0';
+        return retval;
+    } /* if */
+
+    /* argv0 wasn't helpful. */
+    BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+} /* calculateBaseDir */
+
+
+static int initializeMutexes(void)
+{
+    errorLock = __PHYSFS_platformCreateMutex();
+    if (errorLock == NULL)
+        goto initializeMutexes_failed;
+
+    stateLock = __PHYSFS_platformCreateMutex();
+    if (stateLock == NULL)
+        goto initializeMutexes_failed;
+
+    missCacheLock = __PHYSFS_platformCreateMutex();
+    if (missCacheLock == NULL)
+        goto initializeMutexes_failed;
+
+    blobCacheLock = __PHYSFS_platformCreateMutex();
+    if (blobCacheLock == NULL)
+        goto initializeMutexes_failed;
+
+    pinLock = __PHYSFS_platformCreateMutex();
+    if (pinLock == NULL)
+        goto initializeMutexes_failed;
+
+    scratchLock = __PHYSFS_platformCreateMutex();
+    if (scratchLock == NULL)
+        goto initializeMutexes_failed;
+
+    ramLock = __PHYSFS_platformCreateMutex();
+    if (ramLock == NULL)
+        goto initializeMutexes_failed;
+
+    watchLock = __PHYSFS_platformCreateMutex();
+    if (watchLock == NULL)
+        goto initializeMutexes_failed;
+
+    profileLock = __PHYSFS_platformCreateMutex();
+    if (profileLock == NULL)
+        goto initializeMutexes_failed;
+
+    predictLock = __PHYSFS_platformCreateMutex();
+    if (predictLock == NULL)
+        goto initializeMutexes_failed;
+
+    taskLock = __PHYSFS_platformCreateMutex();
+    if (taskLock == NULL)
+        goto initializeMutexes_failed;
+
+    captureLock = __PHYSFS_platformCreateMutex();
+    if (captureLock == NULL)
+        goto initializeMutexes_failed;
+
+    cdromLock = __PHYSFS_platformCreateMutex();
+    if (cdromLock == NULL)
+        goto initializeMutexes_failed;
+
+    contextLock = __PHYSFS_platformCreateMutex();
+    if (contextLock == NULL)
+        goto initializeMutexes_failed;
+
+    defaultContext.lock = __PHYSFS_platformCreateMutex();
+    if (defaultContext.lock == NULL)
+        goto initializeMutexes_failed;
+
+    sharedLock = __PHYSFS_platformCreateMutex();
+    if (sharedLock == NULL)
+        goto initializeMutexes_failed;
+
+    /* if this fails, we'll just search errorStates instead. */
+    errorTls = __PHYSFS_platformCreateThreadLocal();
+
+    /* if this fails, reads in progress just can't be cancelled. */
+    asyncTls = __PHYSFS_platformCreateThreadLocal();
+
+    return 1;  /* success. */
+
+initializeMutexes_failed:
+    if (errorLock != NULL)
+        __PHYSFS_platformDestroyMutex(errorLock);
+
+    if (stateLock != NULL)
+        __PHYSFS_platformDestroyMutex(stateLock);
+
+    errorLock = stateLock = NULL;
+    return 0;  /* failed. */
+} /* initializeMutexes */
+
+
+static int doRegisterArchiver(const PHYSFS_Archiver *_archiver);
+
+static int initStaticArchivers(void)
+{
+    #define REGISTER_STATIC_ARCHIVER(arc) { \
+        extern const PHYSFS_Archiver __PHYSFS_Archiver_##arc; \
+        if (!doRegisterArchiver(&__PHYSFS_Archiver_##arc)) { \
+            return 0; \
+        } \
+    }
+
+    #if PHYSFS_SUPPORTS_ZIP
+        REGISTER_STATIC_ARCHIVER(ZIP);
+    #endif
+    #if PHYSFS_SUPPORTS_7Z
+        REGISTER_STATIC_ARCHIVER(LZMA);
+    #endif
+    #if PHYSFS_SUPPORTS_GRP
+        REGISTER_STATIC_ARCHIVER(GRP);
+    #endif
+    #if PHYSFS_SUPPORTS_QPAK
+        REGISTER_STATIC_ARCHIVER(QPAK);
+    #endif
+    #if PHYSFS_SUPPORTS_HOG
+        REGISTER_STATIC_ARCHIVER(HOG);
+    #endif
+    #if PHYSFS_SUPPORTS_MVL
+        REGISTER_STATIC_ARCHIVER(MVL);
+    #endif
+    #if PHYSFS_SUPPORTS_WAD
+        REGISTER_STATIC_ARCHIVER(WAD);
+    #endif
+    #if PHYSFS_SUPPORTS_SLB
+        REGISTER_STATIC_ARCHIVER(SLB);
+    #endif
+    #if PHYSFS_SUPPORTS_ISO9660
+        REGISTER_STATIC_ARCHIVER(ISO9660);
+    #endif
+    #if PHYSFS_SUPPORTS_RAS
+        REGISTER_STATIC_ARCHIVER(RAS);
+    #endif
+    #if PHYSFS_SUPPORTS_PPK
+        REGISTER_STATIC_ARCHIVER(PPK);
+    #endif
+
+    #undef REGISTER_STATIC_ARCHIVER
+
+    return 1;
+} /* initStaticArchivers */
+
+
+static void setDefaultAllocator(void);
+static int doDeinit(void);
+static int stopTraceCapture(void);
+static void freeCdRomCache(void);
+
+
+#define HASH_ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Stir all of (hash)'s bits into all the others. */
+static inline PHYSFS_uint32 hashFinalMix(PHYSFS_uint32 hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+    return hash;
+} /* hashFinalMix */
+
+
+/*
+ * MurmurHash3 (x86, 32-bit), seeded with hashSeed. It eats four bytes at a
+ *  time, so long asset paths go a lot faster than they did a byte at a time
+ *  with djb's hash, and every byte affects every bit of the result, so
+ *  paths with long common prefixes don't bunch up. Nothing keeps these
+ *  past the end of the process, so the seed can be different each time.
+ */
+PHYSFS_uint32 __PHYSFS_hashString(const char *str, size_t len)
+{
+    const PHYSFS_uint32 c1 = 0xCC9E2D51;
+    const PHYSFS_uint32 c2 = 0x1B873593;
+    PHYSFS_uint32 hash = hashSeed;
+    PHYSFS_uint32 k = 0;
+    size_t remain = len;
+
+    while (remain >= 4)
+    {
+        memcpy(&k, str, 4);  /* no alignment promises. */
+        k *= c1;
+        k = HASH_ROTL32(k, 15);
+        k *= c2;
+        hash ^= k;
+        hash = HASH_ROTL32(hash, 13);
+        hash = (hash * 5) + 0xE6546B64;
+        str += 4;
+        remain -= 4;
+    } /* while */
+
+    if (remain > 0)
+    {
+        k = 0;
+        memcpy(&k, str, remain);
+        k *= c1;
+        k = HASH_ROTL32(k, 15);
+        k *= c2;
+        hash ^= k;
+    } /* if */
+
+    return hashFinalMix(hash ^ ((PHYSFS_uint32) len));
+} /* __PHYSFS_hashString */
+
+
+/*
+ * Slicing-by-8 tables for the CRC-32 ZIP and 7z use (reflected 0x04C11DB7):
+ *  crcTable[0] is the usual byte-at-a-time table, and crcTable[k] is what a
+ *  byte does to the CRC when there are (k) more bytes after it, so eight
+ *  bytes go in with eight lookups and no dependency between them. These are
+ *  built even where the CPU does CRC-32 itself, since the ZIP archiver's
+ *  traditional encryption runs the byte table one byte at a time.
+ */
+static PHYSFS_uint32 crcTable[8][256];
+const PHYSFS_uint32 *__PHYSFS_crcByteTable = crcTable[0];
+static int crcTableReady = 0;
+
+static void buildCrcTable(void)
+{
+    PHYSFS_uint32 i, k;
+
+    for (i = 0; i < 256; i++)
+    {
+        PHYSFS_uint32 crc = i;
+        for (k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        crcTable[0][i] = crc;
+    } /* for */
+
+    for (i = 0; i < 256; i++)
+    {
+        for (k = 1; k < 8; k++)
+        {
+            const PHYSFS_uint32 prev = crcTable[k - 1][i];
+            crcTable[k][i] = (prev >> 8) ^ crcTable[0][prev & 0xFF];
+        } /* for */
+    } /* for */
+
+    crcTableReady = 1;
+} /* buildCrcTable */
+
+
+PHYSFS_uint32 PHYSFS_crc32(PHYSFS_uint32 crc, const void *_buf,
+                           PHYSFS_uint64 len)
+{
+    const PHYSFS_uint8 *buf = (const PHYSFS_uint8 *) _buf;
+
+    crc = ~crc;
+
+#if PHYSFS_HAVE_ARM_CRC32
+    /* ARMv8 has instructions for exactly this polynomial. */
+    for (; (len > 0) && (((size_t) buf) & 7); len--)
+        crc = __crc32b(crc, *(buf++));
+    for (; len >= 8; len -= 8, buf += 8)
+        crc = __crc32d(crc, *((const PHYSFS_uint64 *) buf));
+    for (; len > 0; len--)
+        crc = __crc32b(crc, *(buf++));
+#else
+    if (!crcTableReady)  /* PHYSFS_init() builds it; this is before that. */
+        buildCrcTable();
+
+    for (; len >= 8; len -= 8, buf += 8)
+    {
+        const PHYSFS_uint32 lo = crc ^ (((PHYSFS_uint32) buf[0]) |
+                                        (((PHYSFS_uint32) buf[1]) << 8) |
+                                        (((PHYSFS_uint32) buf[2]) << 16) |
+                                        (((PHYSFS_uint32) buf[3]) << 24));
+        const PHYSFS_uint32 hi = ((PHYSFS_uint32) buf[4]) |
+                                 (((PHYSFS_uint32) buf[5]) << 8) |
+                                 (((PHYSFS_uint32) buf[6]) << 16) |
+                                 (((PHYSFS_uint32) buf[7]) << 24);
+        crc = crcTable[7][lo & 0xFF] ^ crcTable[6][(lo >> 8) & 0xFF] ^
+              crcTable[5][(lo >> 16) & 0xFF] ^ crcTable[4][lo >> 24] ^
+              crcTable[3][hi & 0xFF] ^ crcTable[2][(hi >> 8) & 0xFF] ^
+              crcTable[1][(hi >> 16) & 0xFF] ^ crcTable[0][hi >> 24];
+    } /* for */
+
+    for (; len > 0; len--)
+        crc = (crc >> 8) ^ crcTable[0][(crc ^ *(buf++)) & 0xFF];
+#endif
+
+    return ~crc;
+} /* PHYSFS_crc32 */
+
+
+void __PHYSFS_crcCheckInit(__PHYSFS_CrcCheck *check)
+{
+    memset(check, '\0', sizeof (*check));
+    check->checking = verifyChecksums;
+} /* __PHYSFS_crcCheckInit */
+
+
+int __PHYSFS_crcCheckRead(__PHYSFS_CrcCheck *check, const void *buf,
+                          const PHYSFS_uint64 len, const PHYSFS_uint64 offset,
+                          const PHYSFS_uint64 filelen,
+                          const PHYSFS_uint32 expected)
+{
+    const PHYSFS_uint64 end = offset + len;
+
+    /* only what carries on from where the checksum left off counts. */
+    if ((check->checking) && (offset <= check->pos) && (end > check->pos))
+    {
+        const PHYSFS_uint64 skip = check->pos - offset;
+        check->crc = PHYSFS_crc32(check->crc,
+                                  ((const PHYSFS_uint8 *) buf) + skip,
+                                  len - skip);
+        check->pos = end;
+        if (end == filelen)
+        {
+            check->checking = 0;
+            check->failed = (check->crc != expected);
+        } /* if */
+    } /* if */
+
+    /* every read to the end fails once it's known to be bad. */
+    BAIL_IF_MACRO(check->failed && (end == filelen), PHYSFS_ERR_CORRUPT, 0);
+    return 1;
+} /* __PHYSFS_crcCheckRead */
+
+
+int PHYSFS_init(const char *argv0)
+{
+    BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
+
+    if (!externalAllocator)
+        setDefaultAllocator();
+
+    if ((allocator.Init != NULL) && (!allocator.Init())) return 0;
+
+    if (!__PHYSFS_platformInit())
+    {
+        if (allocator.Deinit != NULL) allocator.Deinit();
+        return 0;
+    } /* if */
+
+    /* everything below here can be cleaned up safely by doDeinit(). */
+
+    if (!initializeMutexes()) goto initFailed;
+
+    /* nothing's hashed yet; pick something an attacker can't guess well. */
+    hashSeed = (PHYSFS_uint32) __PHYSFS_platformGetTicks();
+    hashSeed ^= (PHYSFS_uint32) time(NULL);
+    hashSeed ^= (PHYSFS_uint32) (size_t) &hashSeed;
+    hashSeed = hashFinalMix(hashSeed);
+
+    if (!crcTableReady)  /* now, before there can be threads racing for it. */
+        buildCrcTable();
+
+    /* this falls back to plain reads on its own if it can't be had. */
+    batchIo = __PHYSFS_platformInitBatchIo(wantBatchIo);
+
+    /* likewise, if there's no hardware for it, we inflate on the CPU. */
+    inflaterReady = ((wantInflater) &&
+                     ((inflater.Init == NULL) ||
+                      (inflater.Init(inflater.opaque))));
+
+    baseDir = calculateBaseDir(argv0);
+    if (!baseDir) goto initFailed;
+
+    userDir = __PHYSFS_platformCalcUserDir();
+    if (!userDir) goto initFailed;
+
+    /* Platform layer is required to append a dirsep. */
+    assert(baseDir[strlen(baseDir) - 1] == __PHYSFS_platformDirSeparator);
+    assert(userDir[strlen(userDir) - 1] == __PHYSFS_platformDirSeparator);
+
+    if (!initStaticArchivers()) goto initFailed;
+
+    initialized = 1;
+
+    /* This makes sure that the error subsystem is initialized. */
+    PHYSFS_setErrorCode(PHYSFS_getLastErrorCode());
+
+    return 1;
+
+initFailed:
+    doDeinit();
+    return 0;
+} /* PHYSFS_init */
+
+
+static void freeReadAhead(FileHandle *fh);
+static void freeWriteBehind(FileHandle *fh);
+static void abortAtomicWrite(AtomicWrite *aw);
+
+/*
+ * Close (fh) without flushing it, throwing away an atomic write instead of
+ *  renaming it into place. MAKE SURE you hold its context's lock!
+ */
+static void discardFileHandle(FileHandle *fh)
+{
+    freeReadAhead(fh);
+    freeWriteBehind(fh);
+    fh->io->destroy(fh->io);
+    if (fh->atomic != NULL)  /* never closed, so it never happened. */
+        abortAtomicWrite(fh->atomic);
+    freeFileBuffer(fh->dirHandle->mem, fh->buffer, fh->bufsize);
+    allocator.Free(fh->tracePath);
+    unlinkFileHandle(fh);
+    freeFileHandle(fh);
+} /* discardFileHandle */
+
+
+/* MAKE SURE you hold the list's context's lock before calling this! */
+static int closeFileHandleList(FileHandle **list)
+{
+    FileHandle *i;
+    FileHandle *next = NULL;
+
+    for (i = *list; i != NULL; i = next)
+    {
+        PHYSFS_Io *io = i->io;
+        next = i->next;
+
+        if (io->flush && !io->flush(io))
+            return 0;  /* (i) and the rest stay open. */
+
+        discardFileHandle(i);
+    } /* for */
+
+    return 1;
+} /* closeFileHandleList */
+
+
+/* MAKE SURE you hold (ctx)'s lock before calling this! */
+static void freeSearchPath(PHYSFS_Context *ctx)
+{
+    DirHandle *i;
+    DirHandle *next = NULL;
+
+    SearchIndex *idx;
+    SearchIndex *nextidx = NULL;
+
+    closeFileHandleList(&ctx->openReadList);
+
+    /* nobody is reading anymore at this point, so drop all indexes. */
+    if ((ctx->searchIndex != NULL) && (!deinitingFast))
+        freeSearchIndex(ctx->searchIndex);
+    ctx->searchIndex = NULL;
+
+    for (idx = ctx->retiredIndexes; (idx != NULL) && (!deinitingFast);
+         idx = nextidx)
+    {
+        nextidx = idx->retiredNext;
+        freeSearchIndex(idx);
+    } /* for */
+    ctx->retiredIndexes = NULL;
+
+    if (ctx->searchPath != NULL)
+    {
+        for (i = ctx->searchPath; i != NULL; i = next)
+        {
+            next = i->next;
+            freeDirHandle(i);
+        } /* for */
+        ctx->searchPath = NULL;
+    } /* if */
+
+    /* ...and any DirHandles waiting on them. */
+    for (i = ctx->retiredDirHandles; i != NULL; i = next)
+    {
+        next = i->retiredNext;
+        freeDirHandle(i);
+    } /* for */
+    ctx->retiredDirHandles = NULL;
+} /* freeSearchPath */
+
+
+/*
+ * For the few things that have to look at every context at once: this
+ *  holds contextLock and every context's lock, in list order.
+ */
+static void lockAllContexts(void)
+{
+    PHYSFS_Context *ctx;
+    __PHYSFS_platformGrabMutex(contextLock);
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+        grabLock(ctx->lock);
+} /* lockAllContexts */
+
+
+static void unlockAllContexts(void)
+{
+    PHYSFS_Context *ctx;
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+    __PHYSFS_platformReleaseMutex(contextLock);
+} /* unlockAllContexts */
+
+
+/* MAKE SURE you hold stateLock before calling this! */
+static int archiverInUse(const PHYSFS_Archiver *arc, const DirHandle *list)
+{
+    const DirHandle *i;
+    for (i = list; i != NULL; i = i->next)
+    {
+        if ((i->funcs == arc) || (i->realFuncs == arc))
+            return 1;
+    } /* for */
+
+    return 0;  /* not in use */
+} /* archiverInUse */
+
+
+/* MAKE SURE you lockAllContexts() and hold stateLock before calling this! */
+static int doDeregisterArchiver(const size_t idx)
+{
+    const size_t len = (numArchivers - idx) * sizeof (void *);
+    const PHYSFS_ArchiveInfo *info = archiveInfo[idx];
+    const PHYSFS_Archiver *arc = archivers[idx];
+    PHYSFS_Context *ctx;
+    const DirHandle *i;
+
+    /* make sure nothing is still using this archiver */
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+    {
+        if ( (archiverInUse(arc, ctx->searchPath)) ||
+             (archiverInUse(arc, ctx->writeDir)) )
+            BAIL_MACRO(PHYSFS_ERR_FILES_STILL_OPEN, 0);
+
+        reclaimRetired(ctx);
+        for (i = ctx->retiredDirHandles; i != NULL; i = i->retiredNext)
+        {
+            BAIL_IF_MACRO((i->funcs == arc) || (i->realFuncs == arc),
+                          PHYSFS_ERR_FILES_STILL_OPEN, 0);
+        } /* for */
+    } /* for */
+
+    allocator.Free((void *) info->extension);
+    allocator.Free((void *) info->description);
+    allocator.Free((void *) info->author);
+    allocator.Free((void *) info->url);
+    allocator.Free((void *) arc);
+
+    memmove(&archiveInfo[idx], &archiveInfo[idx+1], len);
+    memmove(&archivers[idx], &archivers[idx+1], len);
+
+    assert(numArchivers > 0);
+    numArchivers--;
+
+    return 1;
+} /* doDeregisterArchiver */
+
+
+/* Does NOT hold the state lock; we're shutting down. */
+static void freeArchivers(void)
+{
+    while (numArchivers > 0)
+    {
+        if (!doDeregisterArchiver(numArchivers - 1))
+            assert(!"nothing should be mounted during shutdown.");
+    } /* while */
+
+    allocator.Free(archivers);
+    allocator.Free(archiveInfo);
+    archivers = NULL;
+    archiveInfo = NULL;
+} /* freeArchivers */
+
+
+static void discardAtomicWrites(PHYSFS_Context *ctx);
+static int setWriteDir(PHYSFS_Context *ctx, const char *newDir);
+static void freeBlobCache(void);
+static void freeScratchPool(void);
+static void freeRamDirs(void);
+static void freeSpillFiles(void);
+static void stopTaskPool(void);
+
+static int doDeinit(void)
+{
+    PHYSFS_Context *ctx;
+
+    /* these aren't on openReadList, so we can't close them for you. */
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+        BAIL_IF_MACRO(ctx->frozenOpenFiles, PHYSFS_ERR_FILES_STILL_OPEN, 0);
+
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+    {
+        ctx->frozen = 0;
+        closeFileHandleList(&ctx->openWriteList);
+        discardAtomicWrites(ctx);
+        BAIL_IF_MACRO(!setWriteDir(ctx, NULL), PHYSFS_ERR_FILES_STILL_OPEN, 0);
+    } /* for */
+
+    /* writes are all out; from here on, a fast deinit skips the frees. */
+    deinitingFast = fastDeinit;
+
+    if (watchLock != NULL)  /* stop watching before the dirs go away. */
+    {
+        changeCallback = NULL;
+        for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+            syncWatches(ctx);
+    } /* if */
+
+    while (defaultContext.next != NULL)
+    {
+        ctx = defaultContext.next;
+        defaultContext.next = ctx->next;
+        freeSearchPath(ctx);
+        __PHYSFS_platformDestroyMutex(ctx->lock);
+        allocator.Free(ctx);
+    } /* while */
+
+    freeSearchPath(&defaultContext);
+    freeArchivers();
+    freeMissCache();
+    freeBlobCache();
+    freeScratchPool();
+    freeRamDirs();
+    profiling = 0;
+    freeAccessProfile();
+    predictQueue = NULL;
+    freePredictModel();
+    stopTraceCapture();
+    freeCdRomCache();
+    stopTaskPool();
+
+    if (asyncTls != NULL)
+    {
+        __PHYSFS_platformDestroyThreadLocal(asyncTls);
+        asyncTls = NULL;
+    } /* if */
+
+    /* drop the slot first, so nothing can find the states we're freeing. */
+    if (errorTls != NULL)
+    {
+        __PHYSFS_platformDestroyThreadLocal(errorTls);
+        errorTls = NULL;
+    } /* if */
+
+    freeErrorStates();
+    freeLatencyExts();
+
+    if (baseDir != NULL)
+    {
+        allocator.Free(baseDir);
+        baseDir = NULL;
+    } /* if */
+
+    if (userDir != NULL)
+    {
+        allocator.Free(userDir);
+        userDir = NULL;
+    } /* if */
+
+    if (prefDir != NULL)
+    {
+        allocator.Free(prefDir);
+        prefDir = NULL;
+    } /* if */
+
+    if (indexCacheDir != NULL)
+    {
+        allocator.Free(indexCacheDir);
+        indexCacheDir = NULL;
+    } /* if */
+
+    freeSpillFiles();
+    if (spillCacheDir != NULL)
+    {
+        allocator.Free(spillCacheDir);
+        spillCacheDir = NULL;
+    } /* if */
+
+    if (archiveInfo != NULL)
+    {
+        allocator.Free(archiveInfo);
+        archiveInfo = NULL;
+    } /* if */
+
+    if (archivers != NULL)
+    {
+        allocator.Free(archivers);
+        archivers = NULL;
+    } /* if */
+
+    if (deinitingFast)  /* none of what's left over is ours anymore. */
+    {
+        memset(&memTotals, '\0', sizeof (memTotals));
+        deinitingFast = 0;
+    } /* if */
+
+    nativeVerifyTime = 0;
+    nativeListingTime = 0;
+    nativeHandleTime = 0;
+    useMissCache = 0;
+    usingContexts = 0;
+    initialized = 0;
+
+    if (batchIo)
+    {
+        __PHYSFS_platformDeinitBatchIo();
+        batchIo = 0;
+    } /* if */
+
+    if (inflaterReady)
+    {
+        if (inflater.Deinit != NULL)
+            inflater.Deinit(inflater.opaque);
+        inflaterReady = 0;
+    } /* if */
+
+    if (errorLock) __PHYSFS_platformDestroyMutex(errorLock);
+    if (stateLock) __PHYSFS_platformDestroyMutex(stateLock);
+    if (missCacheLock) __PHYSFS_platformDestroyMutex(missCacheLock);
+    if (blobCacheLock) __PHYSFS_platformDestroyMutex(blobCacheLock);
+    if (pinLock) __PHYSFS_platformDestroyMutex(pinLock);
+    if (scratchLock) __PHYSFS_platformDestroyMutex(scratchLock);
+    if (ramLock) __PHYSFS_platformDestroyMutex(ramLock);
+    if (watchLock) __PHYSFS_platformDestroyMutex(watchLock);
+    if (profileLock) __PHYSFS_platformDestroyMutex(profileLock);
+    if (predictLock) __PHYSFS_platformDestroyMutex(predictLock);
+    if (taskLock) __PHYSFS_platformDestroyMutex(taskLock);
+    if (captureLock) __PHYSFS_platformDestroyMutex(captureLock);
+    if (cdromLock) __PHYSFS_platformDestroyMutex(cdromLock);
+    if (contextLock) __PHYSFS_platformDestroyMutex(contextLock);
+    if (defaultContext.lock) __PHYSFS_platformDestroyMutex(defaultContext.lock);
+    if (sharedLock) __PHYSFS_platformDestroyMutex(sharedLock);
+
+    if (allocator.Deinit != NULL)
+        allocator.Deinit();
+
+    errorLock = stateLock = watchLock = profileLock = blobCacheLock = NULL;
+    predictLock = taskLock = NULL;
+    pinLock = scratchLock = ramLock = NULL;
+    contextLock = sharedLock = captureLock = cdromLock = NULL;
+    memset(&defaultContext, '\0', sizeof (defaultContext));
+
+    /* !!! FIXME: what on earth are you supposed to do if this fails? */
+    BAIL_IF_MACRO(!__PHYSFS_platformDeinit(), ERRPASS, 0);
+
+    return 1;
+} /* doDeinit */
+
+
+int PHYSFS_deinit(void)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    return doDeinit();
+} /* PHYSFS_deinit */
+
+
+int PHYSFS_isInit(void)
+{
+    return initialized;
+} /* PHYSFS_isInit */
+
+
+char *__PHYSFS_strdup(const char *str)
+{
+    char *retval = (char *) allocator.Malloc(strlen(str) + 1);
+    if (retval)
+        strcpy(retval, str);
+    return retval;
+} /* __PHYSFS_strdup */
+
+
+/*
+ * Where (hash) starts probing in a table of (1 << bits) slots. Some callers
+ *  still use djb's hash, which is weak in the low bits for similar names,
+ *  so stir it before picking.
+ */
+static inline PHYSFS_uint32 hashTableStart(const PHYSFS_uint32 hash,
+                                           const PHYSFS_uint32 bits)
+{
+    return (PHYSFS_uint32) ((hash * 0x9E3779B1) >> (32 - bits));
+} /* hashTableStart */
+
+
+/* Set up an empty table of (1 << bits) slots for (table) to move into. */
+static int hashTableAlloc(__PHYSFS_HashTable *table, const PHYSFS_uint32 bits)
+{
+    const size_t len = ((size_t) 1 << bits) * sizeof (__PHYSFS_HashSlot);
+    table->slots = (__PHYSFS_HashSlot *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!table->slots, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(table->slots, '\0', len);
+    table->bits = bits;
+    table->used = 0;
+    return 1;
+} /* hashTableAlloc */
+
+
+/* Put (index) in the first free slot for (hash); there has to be one. */
+static void hashTablePut(__PHYSFS_HashTable *table, const PHYSFS_uint32 hash,
+                         const PHYSFS_uint32 index)
+{
+    const PHYSFS_uint32 mask = (((PHYSFS_uint32) 1) << table->bits) - 1;
+    PHYSFS_uint32 i = hashTableStart(hash, table->bits);
+
+    while (table->slots[i].index != 0)
+        i = (i + 1) & mask;
+
+    table->slots[i].hash = hash;
+    table->slots[i].index = index;
+    table->used++;
+} /* hashTablePut */
+
+
+/* Smallest table that keeps (count) items at most three quarters full. */
+static PHYSFS_uint32 hashTableBits(const PHYSFS_uint64 count)
+{
+    PHYSFS_uint32 bits = 4;
+    while ((bits < 31) && ((((PHYSFS_uint64) 1) << bits) * 3 < count * 4))
+        bits++;
+    return bits;
+} /* hashTableBits */
+
+
+int __PHYSFS_hashTableInit(__PHYSFS_HashTable *table, PHYSFS_uint64 count)
+{
+    memset(table, '\0', sizeof (*table));
+    BAIL_IF_MACRO(count > 0x60000000, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    return hashTableAlloc(table, hashTableBits(count));
+} /* __PHYSFS_hashTableInit */
+
+
+void __PHYSFS_hashTableDeinit(__PHYSFS_HashTable *table)
+{
+    allocator.Free(table->slots);
+    memset(table, '\0', sizeof (*table));
+} /* __PHYSFS_hashTableDeinit */
+
+
+int __PHYSFS_hashTableInsert(__PHYSFS_HashTable *table, PHYSFS_uint32 hash,
+                             PHYSFS_uint32 index)
+{
+    assert(index != 0);
+    assert(table->slots != NULL);
+
+    if ((((PHYSFS_uint64) table->used) + 1) * 4 >
+        (((PHYSFS_uint64) 1) << table->bits) * 3)
+    {
+        const __PHYSFS_HashSlot *oldslots = table->slots;
+        const PHYSFS_uint32 oldcount = ((PHYSFS_uint32) 1) << table->bits;
+        __PHYSFS_HashTable grown;
+        PHYSFS_uint32 i;
+
+        BAIL_IF_MACRO(table->bits >= 31, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        BAIL_IF_MACRO(!hashTableAlloc(&grown, table->bits + 1), ERRPASS, 0);
+        for (i = 0; i < oldcount; i++)
+        {
+            if (oldslots[i].index != 0)
+                hashTablePut(&grown, oldslots[i].hash, oldslots[i].index);
+        } /* for */
+
+        allocator.Free(table->slots);
+        *table = grown;
+    } /* if */
+
+    hashTablePut(table, hash, index);
+    return 1;
+} /* __PHYSFS_hashTableInsert */
+
+
+PHYSFS_uint32 __PHYSFS_hashTableFind(const __PHYSFS_HashTable *table,
+                                     PHYSFS_uint32 hash, PHYSFS_uint32 *probe)
+{
+    const PHYSFS_uint32 mask = (((PHYSFS_uint32) 1) << table->bits) - 1;
+    PHYSFS_uint32 i = *probe;
+
+    if (table->slots == NULL)
+        return 0;
+
+    /* never full, so this always hits an empty slot eventually. */
+    while (1)
+    {
+        const __PHYSFS_HashSlot *slot;
+        slot = &table->slots[(hashTableStart(hash, table->bits) + i) & mask];
+        i++;
+        if (slot->index == 0)
+            break;
+        else if (slot->hash == hash)
+        {
+            *probe = i;
+            return slot->index;
+        } /* else if */
+    } /* while */
+
+    *probe = i - 1;  /* keep coming back to the empty slot. */
+    return 0;
+} /* __PHYSFS_hashTableFind */
+
+
+/* Most archives' metadata fits in a handful of these. */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+void __PHYSFS_arenaInit(__PHYSFS_Arena *arena)
+{
+    memset(arena, '\0', sizeof (*arena));
+} /* __PHYSFS_arenaInit */
+
+
+void *__PHYSFS_arenaAlloc(__PHYSFS_Arena *arena, size_t len)
+{
+    const size_t align = sizeof (__PHYSFS_ArenaBlock);
+    __PHYSFS_ArenaBlock *block;
+    size_t blocklen;
+
+    BAIL_IF_MACRO(len > ((size_t) -1) / 2, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    len = ((len ? len : 1) + (align - 1)) & ~(align - 1);
+    if (len <= arena->avail)
+    {
+        void *retval = ((PHYSFS_uint8 *) (arena->blocks + 1)) + arena->used;
+        arena->used += len;
+        arena->avail -= len;
+        return retval;
+    } /* if */
+
+    /*
+     * Something big gets a block of its own behind the current one, so
+     *  whatever is left of the current one still gets used.
+     */
+    blocklen = (len > ARENA_BLOCK_SIZE / 4) ? len : ARENA_BLOCK_SIZE;
+    block = (__PHYSFS_ArenaBlock *) allocator.Malloc(sizeof (*block) + blocklen);
+    BAIL_IF_MACRO(!block, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    arena->size += sizeof (*block) + blocklen;
+
+    if ((blocklen == len) && (arena->blocks != NULL))
+    {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+    } /* if */
+    else
+    {
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->used = len;
+        arena->avail = blocklen - len;
+    } /* else */
+
+    return block + 1;
+} /* __PHYSFS_arenaAlloc */
+
+
+char *__PHYSFS_arenaStrdup(__PHYSFS_Arena *arena, const char *str)
+{
+    const size_t len = strlen(str) + 1;
+    char *retval = (char *) __PHYSFS_arenaAlloc(arena, len);
+    if (retval != NULL)
+        memcpy(retval, str, len);
+    return retval;
+} /* __PHYSFS_arenaStrdup */
+
+
+void __PHYSFS_arenaDeinit(__PHYSFS_Arena *arena)
+{
+    __PHYSFS_ArenaBlock *block = arena->blocks;
+    while (block != NULL)
+    {
+        __PHYSFS_ArenaBlock *next = block->next;
+        allocator.Free(block);
+        block = next;
+    } /* while */
+    memset(arena, '\0', sizeof (*arena));
+} /* __PHYSFS_arenaDeinit */
+
+
+/* MAKE SURE you hold stateLock before calling this! */
+static int doRegisterArchiver(const PHYSFS_Archiver *_archiver)
+{
+    const PHYSFS_uint32 maxver = CURRENT_PHYSFS_ARCHIVER_API_VERSION;
+    const size_t len = (numArchivers + 2) * sizeof (void *);
+    PHYSFS_Archiver *archiver = NULL;
+    PHYSFS_ArchiveInfo *info = NULL;
+    const char *ext = NULL;
+    void *ptr = NULL;
+    size_t i;
+
+    BAIL_IF_MACRO(!_archiver, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(_archiver->version > maxver, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!_archiver->info.extension, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->info.description, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->info.author, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->info.url, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->openArchive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->enumerateFiles, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->openRead, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->openWrite, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->openAppend, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->remove, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->mkdir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->closeArchive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!_archiver->stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    ext = _archiver->info.extension;
+    for (i = 0; i < numArchivers; i++)
+    {
+        if (__PHYSFS_utf8stricmp(archiveInfo[i]->extension, ext) == 0)
+            BAIL_MACRO(PHYSFS_ERR_DUPLICATE, 0);  /* !!! FIXME: better error? ERR_IN_USE? */
+    } /* for */
+
+    /* make a copy of the data. */
+    archiver = (PHYSFS_Archiver *) allocator.Malloc(sizeof (*archiver));
+    GOTO_IF_MACRO(!archiver, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
+
+    /* Version 0 structs end at closeArchive, 1 at enumerateFilesStat... */
+    memset(archiver, '\0', sizeof (*archiver));
+    if (_archiver->version == 0)
+        memcpy(archiver, _archiver, offsetof(PHYSFS_Archiver, enumerateFilesStat));
+    else if (_archiver->version == 1)
+        memcpy(archiver, _archiver, offsetof(PHYSFS_Archiver, claim));
+    else if (_archiver->version == 2)
+        memcpy(archiver, _archiver,
+               offsetof(PHYSFS_Archiver, enumerateFilesPrefix));
+    else if (_archiver->version == 3)
+        memcpy(archiver, _archiver, offsetof(PHYSFS_Archiver, checksum));
+    else if (_archiver->version == 4)
+        memcpy(archiver, _archiver, offsetof(PHYSFS_Archiver, layout));
+    else
+        memcpy(archiver, _archiver, sizeof (*archiver));
+
+    info = (PHYSFS_ArchiveInfo *) &archiver->info;
+    memset(info, '\0', sizeof (*info));  /* NULL in case an alloc fails. */
+    #define CPYSTR(item) \
+        info->item = __PHYSFS_strdup(_archiver->info.item); \
+        GOTO_IF_MACRO(!info->item, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
+    CPYSTR(extension);
+    CPYSTR(description);
+    CPYSTR(author);
+    CPYSTR(url);
+    info->supportsSymlinks = _archiver->info.supportsSymlinks;
+    #undef CPYSTR
+
+    ptr = allocator.Realloc(archiveInfo, len);
+    GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
+    archiveInfo = (const PHYSFS_ArchiveInfo **) ptr;
+
+    ptr = allocator.Realloc(archivers, len);
+    GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
+    archivers = (const PHYSFS_Archiver **) ptr;
+
+    archiveInfo[numArchivers] = info;
+    archiveInfo[numArchivers + 1] = NULL;
+
+    archivers[numArchivers] = archiver;
+    archivers[numArchivers + 1] = NULL;
+
+    numArchivers++;
+
+    return 1;
+
+regfailed:
+    if (info != NULL)
+    {
+        allocator.Free((void *) info->extension);
+        allocator.Free((void *) info->description);
+        allocator.Free((void *) info->author);
+        allocator.Free((void *) info->url);
+    } /* if */
+    allocator.Free(archiver);
+
+    return 0;
+} /* doRegisterArchiver */
+
+
+int PHYSFS_registerArchiver(const PHYSFS_Archiver *archiver)
+{
+    int retval;
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    grabStateLock();
+    retval = doRegisterArchiver(archiver);
+    __PHYSFS_platformReleaseMutex(stateLock);
+    return retval;
+} /* PHYSFS_registerArchiver */
+
+
+int PHYSFS_deregisterArchiver(const char *ext)
+{
+    size_t i;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!ext, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    lockAllContexts();
+    grabStateLock();
+    for (i = 0; i < numArchivers; i++)
+    {
+        if (__PHYSFS_utf8stricmp(archiveInfo[i]->extension, ext) == 0)
+        {
+            const int retval = doDeregisterArchiver(i);
+            __PHYSFS_platformReleaseMutex(stateLock);
+            unlockAllContexts();
+            return retval;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(stateLock);
+    unlockAllContexts();
+
+    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, 0);
+} /* PHYSFS_deregisterArchiver */
+
+
+const PHYSFS_ArchiveInfo **PHYSFS_supportedArchiveTypes(void)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
+    return archiveInfo;
+} /* PHYSFS_supportedArchiveTypes */
+
+
+void PHYSFS_freeList(void *list)
+{
+    /* every list we return is one block; see finishStringList(). */
+    if (list != NULL)
+        allocator.Free(list);
+} /* PHYSFS_freeList */
+
+
+const char *PHYSFS_getDirSeparator(void)
+{
+    static char retval[2] = { __PHYSFS_platformDirSeparator, '\0' };
+    return retval;
+} /* PHYSFS_getDirSeparator */
+
+
+/*
+ * What the last disc detection found, which is good until the platform
+ *  says the mounts changed. cdromLock is held for the whole detection, so
+ *  asking while PHYSFS_startCdRomDetection()'s thread is at it waits for
+ *  that instead of waking the drives a second time. stateLock guards
+ *  cdromThread.
+ */
+static char **cdromCache = NULL;
+static void *cdromThread = NULL;
+static volatile int cdromDone = 0;
+
+/* Hold cdromLock. */
+static void refreshCdRomCache(void)
+{
+    /* always ask, so the first time sets up the change notification. */
+    const int changed = __PHYSFS_platformCdRomsChanged();
+    if ((cdromCache == NULL) || (changed))
+    {
+        char **list = doEnumStringList(__PHYSFS_platformDetectAvailableCDs);
+        if (list != NULL)  /* keep the old one if we're out of memory. */
+        {
+            PHYSFS_freeList(cdromCache);
+            cdromCache = list;
+        } /* if */
+    } /* if */
+} /* refreshCdRomCache */
+
+
+static void enumCdRomCache(PHYSFS_StringCallback callback, void *data)
+{
+    char **i;
+
+    __PHYSFS_platformGrabMutex(cdromLock);
+    refreshCdRomCache();
+    for (i = cdromCache; (i != NULL) && (*i != NULL); i++)
+        callback(data, *i);
+    __PHYSFS_platformReleaseMutex(cdromLock);
+} /* enumCdRomCache */
+
+
+static void cdromDetectThread(void *unused)
+{
+    __PHYSFS_platformGrabMutex(cdromLock);
+    refreshCdRomCache();
+    __PHYSFS_platformReleaseMutex(cdromLock);
+    cdromDone = 1;
+} /* cdromDetectThread */
+
+
+/* Wait out PHYSFS_startCdRomDetection() and forget what it found. */
+static void freeCdRomCache(void)
+{
+    if (cdromThread != NULL)
+    {
+        __PHYSFS_platformWaitThread(cdromThread);
+        cdromThread = NULL;
+    } /* if */
+    PHYSFS_freeList(cdromCache);
+    cdromCache = NULL;
+    cdromDone = 0;
+} /* freeCdRomCache */
+
+
+char **PHYSFS_getCdRomDirs(void)
+{
+    if (!initialized)  /* no cache without locks; just look. */
+        return doEnumStringList(__PHYSFS_platformDetectAvailableCDs);
+    return doEnumStringList(enumCdRomCache);
+} /* PHYSFS_getCdRomDirs */
+
+
+void PHYSFS_getCdRomDirsCallback(PHYSFS_StringCallback callback, void *data)
+{
+    char **list;
+    char **i;
+
+    if (!initialized)
+    {
+        __PHYSFS_platformDetectAvailableCDs(callback, data);
+        return;
+    } /* if */
+
+    /* call them with a copy, so they can call back into us. */
+    list = PHYSFS_getCdRomDirs();
+    for (i = list; (i != NULL) && (*i != NULL); i++)
+        callback(data, *i);
+    PHYSFS_freeList(list);
+} /* PHYSFS_getCdRomDirsCallback */
+
+
+int PHYSFS_startCdRomDetection(void)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    grabStateLock();
+    if ((cdromThread != NULL) && (cdromDone))
+    {
+        __PHYSFS_platformWaitThread(cdromThread);
+        cdromThread = NULL;
+    } /* if */
+
+    if (cdromThread == NULL)
+    {
+        cdromDone = 0;
+        cdromThread = __PHYSFS_platformCreateThread(cdromDetectThread, NULL);
+        if (cdromThread == NULL)  /* no threads here; do it now. */
+            cdromDetectThread(NULL);
+    } /* if */
+    __PHYSFS_platformReleaseMutex(stateLock);
+
+    return 1;
+} /* PHYSFS_startCdRomDetection */
+
+
+int PHYSFS_isCdRomDetectionDone(void)
+{
+    int retval;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    grabStateLock();
+    retval = ((cdromThread == NULL) || (cdromDone));
+    __PHYSFS_platformReleaseMutex(stateLock);
+    return retval;
+} /* PHYSFS_isCdRomDetectionDone */
+
+
+const char *PHYSFS_getPrefDir(const char *org, const char *app)
+{
+    const char dirsep = __PHYSFS_platformDirSeparator;
+    PHYSFS_Stat statbuf;
+    char *ptr = NULL;
+    char *endstr = NULL;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!org, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(*org == '\0', PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(!app, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(*app == '\0', PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+
+    allocator.Free(prefDir);
+    prefDir = __PHYSFS_platformCalcPrefDir(org, app);
+    BAIL_IF_MACRO(!prefDir, ERRPASS, NULL);
+
+    assert(strlen(prefDir) > 0);
+    endstr = prefDir + (strlen(prefDir) - 1);
+    assert(*endstr == dirsep);
+    *endstr = '\0';  /* mask out the final dirsep for now. */
+
+    if (!__PHYSFS_platformStat(prefDir, &statbuf))
+    {
+        for (ptr = strchr(prefDir, dirsep); ptr; ptr = strchr(ptr+1, dirsep))
+        {
+            *ptr = '\0';
+            __PHYSFS_platformMkDir(prefDir);
+            *ptr = dirsep;
+        } /* for */
+
+        if (!__PHYSFS_platformMkDir(prefDir))
+        {
+            allocator.Free(prefDir);
+            prefDir = NULL;
+        } /* if */
+    } /* if */
+
+    *endstr = dirsep;  /* readd the final dirsep. */
+
+    return prefDir;
+} /* PHYSFS_getPrefDir */
+
+
+const char *PHYSFS_getBaseDir(void)
+{
+    return baseDir;   /* this is calculated in PHYSFS_init()... */
+} /* PHYSFS_getBaseDir */
+
+
+const char *__PHYSFS_getUserDir(void)  /* not deprecated internal version. */
+{
+    return userDir;   /* this is calculated in PHYSFS_init()... */
+} /* __PHYSFS_getUserDir */
+
+
+const char *PHYSFS_getUserDir(void)
+{
+    return __PHYSFS_getUserDir();
+} /* PHYSFS_getUserDir */
+
+
+const char *PHYSFS_getWriteDir(void)
+{
+    PHYSFS_Context *ctx = currentContext();
+    const char *retval = NULL;
+
+    grabLock(ctx->lock);
+    if (ctx->writeDir != NULL)
+        retval = ctx->writeDir->dirName;
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    return retval;
+} /* PHYSFS_getWriteDir */
+
+
+static int setWriteDir(PHYSFS_Context *ctx, const char *newDir)
+{
+    int retval = 1;
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(ctx->frozen, PHYSFS_ERR_FROZEN, ctx->lock, 0);
+
+    if (ctx->writeDir != NULL)
+    {
+        DirHandle *dh = ctx->writeDir;
+        BAIL_IF_MACRO_MUTEX(dirHandleInUse(dh), PHYSFS_ERR_FILES_STILL_OPEN,
+                            ctx->lock, 0);
+        ctx->writeDir = NULL;
+        retireDirHandle(dh);  /* PHYSFS_stat() might still be looking at it. */
+    } /* if */
+
+    if (newDir != NULL)
+    {
+        /* !!! FIXME: PHYSFS_Io shouldn't be NULL */
+        DirHandle *dh;
+        grabStateLock();  /* for the archiver list. */
+        dh = createDirHandle(ctx, NULL, newDir, NULL, 1, NULL, 0);
+        __PHYSFS_platformReleaseMutex(stateLock);
+        __PHYSFS_MEMORY_BARRIER();  /* finish building it before publishing. */
+        ctx->writeDir = dh;
+        retval = (ctx->writeDir != NULL);
+    } /* if */
+
+    bumpSearchGeneration(ctx);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    return retval;
+} /* setWriteDir */
+
+
+int PHYSFS_setWriteDir(const char *newDir)
+{
+    return setWriteDir(currentContext(), newDir);
+} /* PHYSFS_setWriteDir */
+
+
+static int addToSearchPath(PHYSFS_Io *io, const char *fname,
+                           const char *mountPoint, int appendToPath,
+                           const char **patches, PHYSFS_uint32 numPatches)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *dh;
+    DirHandle *prev = NULL;
+    DirHandle *i;
+
+    if (mountPoint == NULL)
+        mountPoint = "/";
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(ctx->frozen, PHYSFS_ERR_FROZEN, ctx->lock, 0);
+
+    if (fname != NULL)
+    {
+        for (i = ctx->searchPath; i != NULL; i = i->next)
+        {
+            /* already in search path? */
+            if ((i->dirName != NULL) && (strcmp(fname, i->dirName) == 0))
+                BAIL_MACRO_MUTEX(ERRPASS, ctx->lock, 1);
+            prev = i;
+        } /* for */
+    } /* if */
+
+    grabStateLock();  /* for the archiver list. */
+    dh = createDirHandle(ctx, io, fname, mountPoint, 0, patches, numPatches);
+    __PHYSFS_platformReleaseMutex(stateLock);
+    BAIL_IF_MACRO_MUTEX(!dh, ERRPASS, ctx->lock, 0);
+
+    /* lookups don't lock, so (dh) must be complete before it's linked in. */
+    if (appendToPath)
+    {
+        __PHYSFS_MEMORY_BARRIER();
+        if (prev == NULL)
+            ctx->searchPath = dh;
+        else
+            prev->next = dh;
+    } /* if */
+    else
+    {
+        dh->next = ctx->searchPath;
+        __PHYSFS_MEMORY_BARRIER();
+        ctx->searchPath = dh;
+    } /* else */
+
+    rebuildSearchIndex(ctx);
+    bumpSearchGeneration(ctx);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    if (changeCallback != NULL)
+        syncWatches(ctx);  /* failing to watch it doesn't fail the mount. */
+
+    return 1;
+} /* addToSearchPath */
+
+
+static int doMount(PHYSFS_Io *io, const char *fname,
+                   const char *mountPoint, int appendToPath,
+                   const char **patches, PHYSFS_uint32 numPatches)
+{
+    int retval;
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_MOUNT, fname, NULL, 0);
+    retval = addToSearchPath(io, fname, mountPoint, appendToPath,
+                             patches, numPatches);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_MOUNT, fname, NULL, 0, retval);
+    return retval;
+} /* doMount */
+
+
+int PHYSFS_mountIo(PHYSFS_Io *io, const char *fname,
+                   const char *mountPoint, int appendToPath)
+{
+    BAIL_IF_MACRO(!io, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(io->version > CURRENT_PHYSFS_IO_API_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+    return doMount(io, fname, mountPoint, appendToPath, NULL, 0);
+} /* PHYSFS_mountIo */
+
+
+int PHYSFS_mountMemory(const void *buf, PHYSFS_uint64 len, void (*del)(void *),
+                       const char *fname, const char *mountPoint,
+                       int appendToPath)
+{
+    int retval = 0;
+    PHYSFS_Io *io = NULL;
+
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    io = __PHYSFS_createMemoryIo(buf, len, del);
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    retval = doMount(io, fname, mountPoint, appendToPath, NULL, 0);
+    if (!retval)
+    {
+        /* docs say not to call (del) in case of failure, so cheat. */
+        MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
+        info->destruct = NULL;
+        io->destroy(io);
+    } /* if */
+
+    return retval;
+} /* PHYSFS_mountMemory */
+
+
+static int ioGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len);
+
+/*
+ * Something to mount the archive in (fh) from that doesn't read through
+ *  the handle, and so through every archive it's nested in: a slice of the
+ *  archive it's stored in, byte for byte, or else all of it decompressed
+ *  into memory, if it's within PHYSFS_setNestedInflate()'s limit. Returns
+ *  NULL, without an error, if it has to be read through the handle.
+ */
+static PHYSFS_Io *flattenHandleIo(FileHandle *fh)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const void *archive;
+    PHYSFS_Io *retval = NULL;
+    PHYSFS_Io *src;
+    PHYSFS_uint64 pos;
+    PHYSFS_uint64 len;
+    PHYSFS_sint64 flen;
+    void *buf;
+
+    if (!fh->forReading)
+        return NULL;
+
+    if (ioGetStoredSpan(fh->io, &archive, &src, &pos, &len))
+    {
+        /* slices of slices are fine: it's still one read of the real file. */
+        PHYSFS_Io *dup = src->duplicate(src);
+        if (dup != NULL)
+        {
+            retval = __PHYSFS_createSliceIo(dup, pos, len);
+            if (retval == NULL)
+                dup->destroy(dup);
+        } /* if */
+    } /* if */
+    else if (nestedInflateLimit > 0)
+    {
+        flen = fh->io->length(fh->io);
+        if ((flen > 0) && ((PHYSFS_uint64) flen <= nestedInflateLimit) &&
+            ((PHYSFS_uint64) flen == (size_t) flen))
+        {
+            buf = __PHYSFS_cacheAlloc((size_t) flen);
+            if (buf != NULL)
+            {
+                if (PHYSFS_readAt((PHYSFS_File *) fh, buf,
+                                  (PHYSFS_uint64) flen, 0) == flen)
+                {
+                    retval = __PHYSFS_createMemoryIo(buf, (PHYSFS_uint64) flen,
+                                                     __PHYSFS_cacheFree);
+                } /* if */
+
+                if (retval == NULL)
+                    __PHYSFS_cacheFree(buf);
+            } /* if */
+        } /* if */
+    } /* else if */
+
+    if (retval == NULL)
+    {
+        PHYSFS_getLastErrorCode();  /* the handle will do; that's fine. */
+        PHYSFS_setErrorCode(prevErr);
+    } /* if */
+
+    return retval;
+} /* flattenHandleIo */
+
+
+int PHYSFS_mountHandle(PHYSFS_File *file, const char *fname,
+                       const char *mountPoint, int appendToPath)
+{
+    int retval = 0;
+    PHYSFS_Io *io = NULL;
+
+    BAIL_IF_MACRO(file == NULL, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    io = flattenHandleIo((FileHandle *) file);
+    if (io != NULL)
+    {
+        retval = doMount(io, fname, mountPoint, appendToPath, NULL, 0);
+        if (!retval)
+            io->destroy(io);
+        else
+            PHYSFS_close(file);  /* (io) doesn't need it. */
+        return retval;
+    } /* if */
+
+    io = __PHYSFS_createHandleIo(file);
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+    retval = doMount(io, fname, mountPoint, appendToPath, NULL, 0);
+    if (!retval)
+    {
+        /* docs say not to destruct in case of failure, so cheat. */
+        io->opaque = NULL;
+        io->destroy(io);
+    } /* if */
+
+    return retval;
+} /* PHYSFS_mountHandle */
+
+
+PHYSFS_Io *PHYSFS_createSubIo(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                              PHYSFS_uint64 len)
+{
+    PHYSFS_sint64 iolen;
+
+    BAIL_IF_MACRO(!io, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(io->version > CURRENT_PHYSFS_IO_API_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    iolen = io->length(io);
+    BAIL_IF_MACRO(iolen == -1, ERRPASS, NULL);
+    BAIL_IF_MACRO(len > (PHYSFS_uint64) iolen, PHYSFS_ERR_PAST_EOF, NULL);
+    BAIL_IF_MACRO(offset > ((PHYSFS_uint64) iolen) - len,
+                  PHYSFS_ERR_PAST_EOF, NULL);
+    return __PHYSFS_createSliceIo(io, offset, len);
+} /* PHYSFS_createSubIo */
+
+
+int PHYSFS_mountRange(const char *path, PHYSFS_uint64 offset,
+                      PHYSFS_uint64 len, const char *fname,
+                      const char *mountPoint, int appendToPath)
+{
+    int retval = 0;
+    PHYSFS_Io *io = NULL;
+    PHYSFS_Io *sub = NULL;
+
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    io = __PHYSFS_createMappedIo(path);
+    if (io == NULL)
+        io = __PHYSFS_createNativeIo(path, 'r');
+    BAIL_IF_MACRO(!io, ERRPASS, 0);
+
+    sub = PHYSFS_createSubIo(io, offset, len);
+    if (sub == NULL)
+    {
+        io->destroy(io);
+        return 0;
+    } /* if */
+
+    retval = doMount(sub, fname, mountPoint, appendToPath, NULL, 0);
+    if (!retval)
+        sub->destroy(sub);  /* ...which destroys (io), too. */
+
+    return retval;
+} /* PHYSFS_mountRange */
+
+
+int PHYSFS_mount(const char *newDir, const char *mountPoint, int appendToPath)
+{
+    BAIL_IF_MACRO(!newDir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    return doMount(NULL, newDir, mountPoint, appendToPath, NULL, 0);
+} /* PHYSFS_mount */
+
+
+int PHYSFS_mountOverlay(const char *base, const char **patches,
+                        PHYSFS_uint32 numPatches, const char *mountPoint,
+                        int appendToPath)
+{
+    BAIL_IF_MACRO(!base, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO((!patches) && (numPatches), PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    if (numPatches == 0)  /* nothing to merge; don't bother. */
+        return doMount(NULL, base, mountPoint, appendToPath, NULL, 0);
+    return doMount(NULL, base, mountPoint, appendToPath, patches, numPatches);
+} /* PHYSFS_mountOverlay */
+
+
+/* PHYSFS_mountMany() opens archives on up to this many threads, ours too. */
+#define MOUNT_MANY_THREADS 8
+
+typedef struct
+{
+    const PHYSFS_MountSpec *spec;
+    DirHandle *dh;  /* NULL until it's opened. */
+    PHYSFS_ErrorCode err;  /* why it couldn't be, if it couldn't. */
+    int skip;  /* already mounted, or named earlier; leave it be. */
+} MountJob;
+
+typedef struct
+{
+    PHYSFS_Context *ctx;
+    MountJob *jobs;
+    int count;
+    volatile int next;  /* the next job anyone takes, plus one. */
+    volatile int failed;  /* once anything fails, nothing new is started. */
+} MountJobs;
+
+
+/* Each thread takes the next job nobody has until they're all taken. */
+static void mountWorker(void *data)
+{
+    MountJobs *work = (MountJobs *) data;
+    int i;
+
+    while ((!work->failed) && ((i = __PHYSFS_ATOMIC_INCR(&work->next)) <=
+                               work->count))
+    {
+        MountJob *job = &work->jobs[i - 1];
+        const char *fname = job->spec->newDir;
+        const char *mountPoint = job->spec->mountPoint;
+
+        if (job->skip)
+            continue;
+
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_MOUNT, fname, NULL, 0);
+        job->dh = createDirHandle(work->ctx, NULL, fname,
+                                  mountPoint ? mountPoint : "/", 0, NULL, 0);
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_MOUNT, fname, NULL, 0,
+                           job->dh != NULL);
+
+        if (job->dh == NULL)
+        {
+            job->err = PHYSFS_getLastErrorCode();
+            work->failed = 1;
+        } /* if */
+    } /* while */
+} /* mountWorker */
+
+
+/* MAKE SURE you hold ctx->lock before calling this! */
+static int isMounted(const PHYSFS_Context *ctx, const char *fname,
+                     const MountJob *jobs, const int count)
+{
+    const DirHandle *i;
+    int j;
+
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if ((i->dirName != NULL) && (strcmp(fname, i->dirName) == 0))
+            return 1;
+    } /* for */
+
+    for (j = 0; j < count; j++)
+    {
+        if ((!jobs[j].skip) && (strcmp(fname, jobs[j].spec->newDir) == 0))
+            return 1;
+    } /* for */
+
+    return 0;
+} /* isMounted */
+
+
+int PHYSFS_mountMany(const PHYSFS_MountSpec *specs, PHYSFS_uint32 count)
+{
+    void *threads[MOUNT_MANY_THREADS - 1];
+    DirHandle *firstAppended = NULL;
+    DirHandle *lastAppended = NULL;
+    DirHandle *prepended = NULL;
+    DirHandle *tail = NULL;
+    PHYSFS_Context *ctx = currentContext();
+    MountJobs work;
+    int numThreads = 0;
+    int i;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO((!specs) && (count), PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(count > 0x7FFFFFFF, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    for (i = 0; i < (int) count; i++)
+        BAIL_IF_MACRO(!specs[i].newDir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    if (count == 0)
+        return 1;
+
+    memset(&work, '\0', sizeof (work));
+    work.ctx = ctx;
+    work.count = (int) count;
+    work.jobs = (MountJob *) allocator.Malloc(sizeof (MountJob) * count);
+    BAIL_IF_MACRO(!work.jobs, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(work.jobs, '\0', sizeof (MountJob) * count);
+
+    /* held throughout, like PHYSFS_mount() holds them while it opens one. */
+    grabLock(ctx->lock);
+    grabStateLock();
+    if (ctx->frozen)
+    {
+        __PHYSFS_platformReleaseMutex(stateLock);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+        allocator.Free(work.jobs);
+        BAIL_MACRO(PHYSFS_ERR_FROZEN, 0);
+    } /* if */
+
+    for (i = 0; i < work.count; i++)
+    {
+        work.jobs[i].spec = &specs[i];
+        work.jobs[i].skip = isMounted(ctx, specs[i].newDir, work.jobs, i);
+    } /* for */
+
+    while ((numThreads + 1 < MOUNT_MANY_THREADS) &&
+           (numThreads + 1 < work.count))
+    {
+        void *thread = __PHYSFS_startTask(mountWorker, &work);
+        if (thread == NULL)
+            break;  /* go with what we've got. */
+        threads[numThreads++] = thread;
+    } /* while */
+
+    mountWorker(&work);  /* we work too, so this works without threads. */
+    for (i = 0; i < numThreads; i++)
+        __PHYSFS_waitTask(threads[i]);
+
+    if (work.failed)
+    {
+        PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+        for (i = work.count - 1; i >= 0; i--)  /* the first one wins. */
+        {
+            if (work.jobs[i].err != PHYSFS_ERR_OK)
+                err = work.jobs[i].err;
+            freeDirHandle(work.jobs[i].dh);
+        } /* for */
+        __PHYSFS_platformReleaseMutex(stateLock);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+        allocator.Free(work.jobs);
+        BAIL_MACRO(err, 0);
+    } /* if */
+
+    /*
+     * Mounting them one at a time would leave the prepended ones in reverse
+     *  order at the front, and the appended ones in order at the end. Chain
+     *  each of those up first, so lookups see either none or all of them.
+     */
+    for (i = 0; i < work.count; i++)
+    {
+        DirHandle *dh = work.jobs[i].dh;
+        if (dh == NULL)
+            continue;
+        else if (!work.jobs[i].spec->appendToPath)
+        {
+            dh->next = prepended;
+            prepended = dh;
+        } /* else if */
+        else
+        {
+            if (lastAppended == NULL)
+                firstAppended = dh;
+            else
+                lastAppended->next = dh;
+            lastAppended = dh;
+        } /* else */
+    } /* for */
+
+    __PHYSFS_platformReleaseMutex(stateLock);  /* done with archivers. */
+
+    for (tail = ctx->searchPath; (tail != NULL) && (tail->next != NULL); )
+        tail = tail->next;
+
+    if (firstAppended != NULL)
+    {
+        __PHYSFS_MEMORY_BARRIER();
+        if (tail == NULL)
+            ctx->searchPath = firstAppended;
+        else
+            tail->next = firstAppended;
+    } /* if */
+
+    if (prepended != NULL)
+    {
+        DirHandle *last = prepended;
+        while (last->next != NULL)
+            last = last->next;
+        last->next = ctx->searchPath;
+        __PHYSFS_MEMORY_BARRIER();
+        ctx->searchPath = prepended;
+    } /* if */
+
+    rebuildSearchIndex(ctx);
+    bumpSearchGeneration(ctx);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    allocator.Free(work.jobs);
+
+    if (changeCallback != NULL)
+        syncWatches(ctx);  /* failing to watch them doesn't fail the mount. */
+
+    return 1;
+} /* PHYSFS_mountMany */
+
+
+int PHYSFS_addToSearchPath(const char *newDir, int appendToPath)
+{
+    return doMount(NULL, newDir, NULL, appendToPath, NULL, 0);
+} /* PHYSFS_addToSearchPath */
+
+
+int PHYSFS_removeFromSearchPath(const char *oldDir)
+{
+    return PHYSFS_unmount(oldDir);
+} /* PHYSFS_removeFromSearchPath */
+
+
+int PHYSFS_unmount(const char *oldDir)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *i;
+    DirHandle *prev = NULL;
+    DirHandle *next = NULL;
+
+    BAIL_IF_MACRO(oldDir == NULL, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(ctx->frozen, PHYSFS_ERR_FROZEN, ctx->lock, 0);
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if ((i->dirName != NULL) && (strcmp(i->dirName, oldDir) == 0))
+        {
+            next = i->next;
+
+            /*
+             * (i->next) stays valid for anyone still walking past (i), and
+             *  files still open in (i) keep it from being closed until
+             *  they're closed too; see reclaimRetired().
+             */
+            if (prev == NULL)
+                ctx->searchPath = next;
+            else
+                prev->next = next;
+
+            rebuildSearchIndex(ctx);
+            retireDirHandle(i);
+            bumpSearchGeneration(ctx);
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+            if (changeCallback != NULL)
+                syncWatches(ctx);
+            return 1;
+        } /* if */
+        prev = i;
+    } /* for */
+
+    BAIL_MACRO_MUTEX(PHYSFS_ERR_NOT_MOUNTED, ctx->lock, 0);
+} /* PHYSFS_unmount */
+
+
+/* MAKE SURE you hold ctx->lock before calling this! */
+static DirHandle *findMounted(const PHYSFS_Context *ctx, const char *dirName,
+                              DirHandle **prev)
+{
+    DirHandle *i;
+
+    *prev = NULL;
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if ((i->dirName != NULL) && (strcmp(i->dirName, dirName) == 0))
+            return i;
+        *prev = i;
+    } /* for */
+
+    return NULL;
+} /* findMounted */
+
+
+int PHYSFS_replaceMount(const char *oldDir, const char *newDir)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+    DirHandle *old;
+    DirHandle *prev;
+    DirHandle *dh;
+    char *mountPoint = NULL;
+
+    BAIL_IF_MACRO(!oldDir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!newDir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(ctx->frozen, PHYSFS_ERR_FROZEN, ctx->lock, 0);
+    old = findMounted(ctx, oldDir, &prev);
+    BAIL_IF_MACRO_MUTEX(!old, PHYSFS_ERR_NOT_MOUNTED, ctx->lock, 0);
+    if (old->mountPoint != NULL)  /* it's kept with a '/' on the end. */
+    {
+        const size_t len = strlen(old->mountPoint);
+        mountPoint = (char *) __PHYSFS_smallAlloc(len);
+        BAIL_IF_MACRO_MUTEX(!mountPoint, PHYSFS_ERR_OUT_OF_MEMORY,
+                            ctx->lock, 0);
+        memcpy(mountPoint, old->mountPoint, len - 1);
+        mountPoint[len - 1] = '\0';
+    } /* if */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    /* lookups carry on in (old) while the new one is opened and parsed. */
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_MOUNT, newDir, NULL, 0);
+    grabStateLock();  /* for the archiver list. */
+    dh = createDirHandle(ctx, NULL, newDir, mountPoint ? mountPoint : "/",
+                         0, NULL, 0);
+    __PHYSFS_platformReleaseMutex(stateLock);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_MOUNT, newDir, NULL, 0, dh != NULL);
+    __PHYSFS_smallFree(mountPoint);
+    BAIL_IF_MACRO(!dh, ERRPASS, 0);
+
+    /*
+     * List it for the search index now, so rebuilding that is quick. Nobody
+     *  else can see (dh) yet, so this doesn't need ctx->lock.
+     */
+    if ((ctx->useSearchIndex) && (dh->indexMode != INDEX_NONE))
+    {
+        lockDirHandle(dh);
+        buildIndexNames(dh);  /* stays unindexed if this fails. */
+        unlockDirHandle(dh);
+    } /* if */
+
+    /* the search path might have changed while we weren't holding it. */
+    grabLock(ctx->lock);
+    if (ctx->frozen)
+        err = PHYSFS_ERR_FROZEN;
+    else if (findMounted(ctx, oldDir, &prev) != old)
+        err = PHYSFS_ERR_NOT_MOUNTED;
+    else if (strcmp(oldDir, newDir) != 0)
+    {
+        DirHandle *ignored;
+        if (findMounted(ctx, newDir, &ignored) != NULL)
+            err = PHYSFS_ERR_DUPLICATE;
+    } /* else if */
+
+    /* it takes (old)'s place in every way it can. */
+    if ((err == PHYSFS_ERR_OK) && (old->routes != NULL))
+    {
+        dh->routes = copyMountRoutes(old->routes);
+        if (dh->routes == NULL)
+            err = PHYSFS_ERR_OUT_OF_MEMORY;
+    } /* if */
+
+    if ((err == PHYSFS_ERR_OK) && (!setStatCacheTime(dh, old->statTime)))
+        err = PHYSFS_ERR_OUT_OF_MEMORY;
+
+    if (err != PHYSFS_ERR_OK)
+    {
+        freeDirHandle(dh);
+        BAIL_MACRO_MUTEX(err, ctx->lock, 0);
+    } /* if */
+
+    dh->accessHint = old->accessHint;
+
+    /* lookups see one or the other, never neither; (old->next) stays. */
+    dh->next = old->next;
+    __PHYSFS_MEMORY_BARRIER();
+    if (prev == NULL)
+        ctx->searchPath = dh;
+    else
+        prev->next = dh;
+
+    rebuildSearchIndex(ctx);
+    retireDirHandle(old);
+    bumpSearchGeneration(ctx);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    if (changeCallback != NULL)
+        syncWatches(ctx);
+
+    return 1;
+} /* PHYSFS_replaceMount */
+
+
+char **PHYSFS_getSearchPath(void)
+{
+    return doEnumStringList(PHYSFS_getSearchPathCallback);
+} /* PHYSFS_getSearchPath */
+
+
+const char *PHYSFS_getMountPoint(const char *dir)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *i;
+    grabLock(ctx->lock);
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if (strcmp(i->dirName, dir) == 0)
+        {
+            const char *retval = ((i->mountPoint) ? i->mountPoint : "/");
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+            return retval;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    BAIL_MACRO(PHYSFS_ERR_NOT_MOUNTED, NULL);
+} /* PHYSFS_getMountPoint */
+
+
+void PHYSFS_getSearchPathCallback(PHYSFS_StringCallback callback, void *data)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *i;
+
+    grabLock(ctx->lock);
+
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+        callback(data, i->dirName);
+
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+} /* PHYSFS_getSearchPathCallback */
+
+
+/* Split out to avoid stack allocation in a loop. */
+static void setSaneCfgAddPath(const char *i, const size_t l, const char *dirsep,
+                              int archivesFirst)
+{
+    const char *d = PHYSFS_getRealDir(i);
+    const size_t allocsize = strlen(d) + strlen(dirsep) + l + 1;
+    char *str = (char *) __PHYSFS_smallAlloc(allocsize);
+    if (str != NULL)
+    {
+        sprintf(str, "%s%s%s", d, dirsep, i);
+        PHYSFS_mount(str, NULL, archivesFirst == 0);
+        __PHYSFS_smallFree(str);
+    } /* if */
+} /* setSaneCfgAddPath */
+
+
+int PHYSFS_setSaneConfig(const char *organization, const char *appName,
+                         const char *archiveExt, int includeCdRoms,
+                         int archivesFirst)
+{
+    const char *dirsep = PHYSFS_getDirSeparator();
+    const char *basedir;
+    const char *prefdir;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    /* let the drives spin up while we sort out everything else. */
+    if (includeCdRoms)
+        PHYSFS_startCdRomDetection();
+
+    prefdir = PHYSFS_getPrefDir(organization, appName);
+    BAIL_IF_MACRO(!prefdir, ERRPASS, 0);
+
+    basedir = PHYSFS_getBaseDir();
+    BAIL_IF_MACRO(!basedir, ERRPASS, 0);
+
+    BAIL_IF_MACRO(!PHYSFS_setWriteDir(prefdir), PHYSFS_ERR_NO_WRITE_DIR, 0);
+
+    /* Put write dir first in search path... */
+    PHYSFS_mount(prefdir, NULL, 0);
+
+    /* Put base path on search path... */
+    PHYSFS_mount(basedir, NULL, 1);
+
+    /* handle CD-ROMs... */
+    if (includeCdRoms)
+    {
+        char **cds = PHYSFS_getCdRomDirs();
+        char **i;
+        for (i = cds; *i != NULL; i++)
+            PHYSFS_mount(*i, NULL, 1);
+        PHYSFS_freeList(cds);
+    } /* if */
+
+    /* Root out archives, and add them to search path... */
+    if (archiveExt != NULL)
+    {
+        char **rc = PHYSFS_enumerateFiles("/");
+        char **i;
+        size_t extlen = strlen(archiveExt);
+        char *ext;
+
+        for (i = rc; *i != NULL; i++)
+        {
+            size_t l = strlen(*i);
+            if ((l > extlen) && ((*i)[l - extlen - 1] == '.'))
+            {
+                ext = (*i) + (l - extlen);
+                if (__PHYSFS_utf8stricmp(ext, archiveExt) == 0)
+                    setSaneCfgAddPath(*i, l, dirsep, archivesFirst);
+            } /* if */
+        } /* for */
+
+        PHYSFS_freeList(rc);
+    } /* if */
+
+    return 1;
+} /* PHYSFS_setSaneConfig */
+
+
+void PHYSFS_permitSymbolicLinks(int allow)
+{
+    PHYSFS_Context *ctx = currentContext();
+    BAIL_IF_MACRO(ctx->frozen, PHYSFS_ERR_FROZEN, ) /*0*/;
+    ctx->allowSymLinks = allow;
+    bumpSearchGeneration(ctx);
+} /* PHYSFS_permitSymbolicLinks */
+
+
+int PHYSFS_symbolicLinksPermitted(void)
+{
+    return currentContext()->allowSymLinks;
+} /* PHYSFS_symbolicLinksPermitted */
+
+
+void PHYSFS_setSymbolicLinkCheckCacheTime(int seconds)
+{
+    nativeVerifyTime = (seconds < 0) ? -1 : seconds;
+    bumpAllSearchGenerations();  /* don't keep trusting anything past it. */
+} /* PHYSFS_setSymbolicLinkCheckCacheTime */
+
+
+/*
+ * Did verifyPath() already find no symlinks anywhere in (dir), an archive
+ *  path in (h)? Archives don't change, so the answer stays good until
+ *  something bumps searchGeneration. Native directories can change behind
+ *  our backs, so those are only trusted for nativeVerifyTime seconds.
+ */
+static int dirAlreadyVerified(DirHandle *h, const char *dir,
+                              const int generation)
+{
+    const VerifiedDir *slot;
+    PHYSFS_uint32 hash;
+    int retval;
+
+    if (h->verifyLock == NULL)
+        return 0;
+    else if ((h->native) && (nativeVerifyTime == 0))
+        return 0;
+
+    hash = hashIndexPath(dir);
+    slot = &h->verified[hash & (VERIFY_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    retval = ( (slot->path != NULL) && (slot->generation == generation) &&
+               (slot->hash == hash) && (strcmp(slot->path, dir) == 0) );
+    if ((retval) && (h->native) && (nativeVerifyTime > 0))
+        retval = (difftime(time(NULL), slot->when) < nativeVerifyTime);
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    return retval;
+} /* dirAlreadyVerified */
+
+
+static void rememberVerifiedDir(DirHandle *h, const char *dir,
+                                const int generation)
+{
+    const size_t len = strlen(dir) + 1;
+    VerifiedDir *slot;
+    PHYSFS_uint32 hash;
+    char *ptr;
+
+    if (h->verifyLock == NULL)
+        return;
+    else if ((h->native) && (nativeVerifyTime == 0))
+        return;
+
+    hash = hashIndexPath(dir);
+    slot = &h->verified[hash & (VERIFY_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    if ((slot->path != NULL) && (strcmp(slot->path, dir) == 0))
+        ptr = slot->path;
+    else
+    {
+        ptr = (char *) allocator.Realloc(slot->path, len);
+        if (ptr != NULL)  /* if this fails, just keep the old entry. */
+        {
+            memcpy(ptr, dir, len);
+            slot->path = ptr;
+            slot->hash = hash;
+        } /* if */
+    } /* else */
+
+    if (ptr != NULL)
+    {
+        slot->generation = generation;
+        slot->when = time(NULL);
+    } /* if */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+} /* rememberVerifiedDir */
+
+
+void PHYSFS_setDirListingCacheTime(int seconds)
+{
+    nativeListingTime = (seconds < 0) ? -1 : seconds;
+    bumpAllSearchGenerations();  /* don't keep trusting anything past it. */
+} /* PHYSFS_setDirListingCacheTime */
+
+
+void PHYSFS_invalidateCache(void)
+{
+    bumpAllSearchGenerations();  /* the native dirs changed for everyone. */
+} /* PHYSFS_invalidateCache */
+
+
+PHYSFS_uint32 PHYSFS_getSearchPathGeneration(void)
+{
+    return (PHYSFS_uint32) currentContext()->searchGeneration;
+} /* PHYSFS_getSearchPathGeneration */
+
+
+struct PHYSFS_Path
+{
+    PHYSFS_uint32 hash;  /* hashIndexPath(path). */
+    size_t len;  /* strlen(path). */
+    char *path;  /* Sanitized. Allocated along with this struct. */
+};
+
+
+PHYSFS_Path *PHYSFS_internPath(const char *_path)
+{
+    PHYSFS_Path *retval;
+    char *path;
+    size_t len;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
+    BAIL_IF_MACRO(!_path, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+
+    /* sanitizing never makes it longer. */
+    len = strlen(_path) + 1;
+    retval = (PHYSFS_Path *) allocator.Malloc(sizeof (PHYSFS_Path) + len);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    path = ((char *) retval) + sizeof (PHYSFS_Path);
+    if (!sanitizePlatformIndependentPath(_path, path))
+    {
+        allocator.Free(retval);
+        return NULL;
+    } /* if */
+
+    retval->hash = hashIndexPath(path);
+    retval->len = strlen(path);
+    retval->path = path;
+    return retval;
+} /* PHYSFS_internPath */
+
+
+void PHYSFS_freePath(PHYSFS_Path *path)
+{
+    allocator.Free(path);  /* struct and string are one allocation. */
+} /* PHYSFS_freePath */
+
+
+static void releaseDirListing(DirHandle *h, DirListing *listing)
+{
+    int freeit;
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    freeit = (--listing->refcount == 0);
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+    if (freeit)
+        allocator.Free(listing);
+} /* releaseDirListing */
+
+
+typedef struct
+{
+    EnumStringListCallbackData names;
+    PHYSFS_Stat *stats;
+    PHYSFS_uint32 allocated;  /* how many (stats) has room for. */
+} DirListingBuilder;
+
+static void buildDirListingCallback(void *_data, const char *origdir,
+                                    const char *fname, const PHYSFS_Stat *st)
+{
+    DirListingBuilder *b = (DirListingBuilder *) _data;
+    const PHYSFS_uint32 i = b->names.size;
+
+    if (b->names.errcode)
+        return;
+
+    if (i == b->allocated)
+    {
+        const PHYSFS_uint32 newalloc = b->allocated ? b->allocated * 2 : 64;
+        void *ptr = allocator.Realloc(b->stats, newalloc * sizeof (PHYSFS_Stat));
+        if (ptr == NULL)
+        {
+            b->names.errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return;
+        } /* if */
+        b->stats = (PHYSFS_Stat *) ptr;
+        b->allocated = newalloc;
+    } /* if */
+
+    addToStringList(&b->names, fname);
+    if (!b->names.errcode)
+        memcpy(&b->stats[i], st, sizeof (PHYSFS_Stat));
+} /* buildDirListingCallback */
+
+
+static DirListing *readDirListing(DirHandle *h, const char *dir)
+{
+    DirListing *retval = NULL;
+    DirListingBuilder b;
+    size_t statslen;
+
+    memset(&b, '\0', sizeof (b));
+    h->funcs->enumerateFilesStat(h->opaque, dir, buildDirListingCallback,
+                                 "", &b);
+
+    if (!b.names.errcode)
+    {
+        statslen = b.names.size * sizeof (PHYSFS_Stat);
+        retval = (DirListing *) allocator.Malloc(sizeof (DirListing) +
+                                                 statslen + b.names.names_len);
+    } /* if */
+
+    if (retval != NULL)
+    {
+        retval->refcount = 1;
+        retval->count = b.names.size;
+        retval->stats = (PHYSFS_Stat *) (retval + 1);
+        retval->names = ((char *) retval->stats) + statslen;
+        if (b.names.size != 0)
+        {
+            memcpy(retval->stats, b.stats, statslen);
+            memcpy(retval->names, b.names.names, b.names.names_len);
+        } /* if */
+    } /* if */
+
+    allocator.Free(b.stats);
+    allocator.Free(b.names.names);
+    allocator.Free(b.names.offsets);
+    return retval;
+} /* readDirListing */
+
+
+/*
+ * Get (dir)'s listing, an archive path in (h), from the cache, reading it
+ *  into the cache first if it isn't there or has gone stale. Returns NULL
+ *  if (h) isn't a native directory, the cache is off, or memory ran out;
+ *  then just ask the archiver. Give it back with releaseDirListing().
+ *  Caller holds (h)'s lock, as for any other archiver call.
+ */
+static DirListing *getDirListing(DirHandle *h, const char *dir)
+{
+    const int generation = h->ctx->searchGeneration;
+    DirListing *retval = NULL;
+    DirListing *stale = NULL;
+    CachedListing *slot;
+    PHYSFS_uint32 hash;
+
+    if ((!h->native) || (nativeListingTime == 0) || (h->verifyLock == NULL))
+        return NULL;
+    else if (h->funcs->enumerateFilesStat == NULL)
+        return NULL;
+
+    hash = hashIndexPath(dir);
+    slot = &h->listings[hash & (LISTING_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    if ( (slot->listing != NULL) && (slot->generation == generation) &&
+         (slot->hash == hash) && (strcmp(slot->path, dir) == 0) )
+    {
+        if ( (nativeListingTime < 0) ||
+             (difftime(time(NULL), slot->when) < nativeListingTime) )
+        {
+            retval = slot->listing;
+            retval->refcount++;
+        } /* if */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    if (retval != NULL)
+        return retval;
+
+    retval = readDirListing(h, dir);
+    if (retval == NULL)
+        return NULL;
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    if ((slot->path == NULL) || (strcmp(slot->path, dir) != 0))
+    {
+        const size_t len = strlen(dir) + 1;
+        char *ptr = (char *) allocator.Realloc(slot->path, len);
+        if (ptr != NULL)
+        {
+            memcpy(ptr, dir, len);
+            slot->path = ptr;
+            slot->hash = hash;
+        } /* if */
+        else  /* can't remember this one; drop what the slot had. */
+        {
+            allocator.Free(slot->path);
+            slot->path = NULL;
+        } /* else */
+    } /* if */
+
+    stale = slot->listing;
+    slot->listing = NULL;
+    if (slot->path != NULL)
+    {
+        retval->refcount++;  /* one for us, one for the slot. */
+        slot->listing = retval;
+        slot->generation = generation;
+        slot->when = time(NULL);
+    } /* if */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    if (stale != NULL)
+        releaseDirListing(h, stale);
+
+    return retval;
+} /* getDirListing */
+
+
+/*
+ * Stat (path), an archive path in (h), as its archiver would, but answer
+ *  from (h)'s stat cache if it's on and has a fresh enough answer. Misses
+ *  are kept, too: those are most of what verifyPath() and a search path
+ *  full of native directories look up. Caller holds (h)'s lock, as for
+ *  any other archiver call.
+ */
+static int statArchive(const DirHandle *h, const char *path,
+                       PHYSFS_Stat *stat)
+{
+    const int seconds = h->statTime;
+    const int generation = h->ctx->searchGeneration;
+    CachedStat *slot;
+    PHYSFS_uint32 hash;
+    int retval = -1;
+
+    if ((seconds == 0) || (h->stats == NULL))
+        return h->funcs->stat(h->opaque, path, stat);
+
+    hash = hashIndexPath(path);
+    slot = &h->stats[hash & (STAT_CACHE_SLOTS - 1)];
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    if ( (slot->path != NULL) && (slot->generation == generation) &&
+         (slot->hash == hash) && (strcmp(slot->path, path) == 0) )
+    {
+        if ((seconds < 0) || (difftime(time(NULL), slot->when) < seconds))
+        {
+            retval = slot->found;
+            if (retval)
+                memcpy(stat, &slot->stat, sizeof (PHYSFS_Stat));
+        } /* if */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    if (retval != -1)
+    {
+        BAIL_IF_MACRO(!retval, PHYSFS_ERR_NOT_FOUND, 0);
+        return 1;
+    } /* if */
+
+    retval = h->funcs->stat(h->opaque, path, stat);
+    if ((!retval) && (currentErrorCode() != PHYSFS_ERR_NOT_FOUND))
+        return 0;  /* only keep answers, not I/O errors and such. */
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    if ((slot->path == NULL) || (strcmp(slot->path, path) != 0))
+    {
+        const size_t len = strlen(path) + 1;
+        char *ptr = (char *) allocator.Realloc(slot->path, len);
+        if (ptr != NULL)
+        {
+            memcpy(ptr, path, len);
+            slot->path = ptr;
+        } /* if */
+        else  /* can't remember this one; drop what the slot had. */
+        {
+            allocator.Free(slot->path);
+            slot->path = NULL;
+        } /* else */
+    } /* if */
+
+    if (slot->path != NULL)
+    {
+        slot->hash = hash;
+        slot->generation = generation;
+        slot->when = time(NULL);
+        slot->found = retval;
+        if (retval)
+            memcpy(&slot->stat, stat, sizeof (PHYSFS_Stat));
+    } /* if */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    return retval;
+} /* statArchive */
+
+
+int PHYSFS_setMountStatCacheTime(const char *dir, int seconds)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *i;
+
+    BAIL_IF_MACRO(!dir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    grabLock(ctx->lock);
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if (strcmp(i->dirName, dir) == 0)
+            break;
+    } /* for */
+    BAIL_IF_MACRO_MUTEX(!i, PHYSFS_ERR_NOT_MOUNTED, ctx->lock, 0);
+    BAIL_IF_MACRO_MUTEX(!setStatCacheTime(i, seconds), ERRPASS, ctx->lock, 0);
+    bumpSearchGeneration(ctx);  /* don't keep trusting anything past it. */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    return 1;
+} /* PHYSFS_setMountStatCacheTime */
+
+
+/* Is a handle kept as (c) says still good to use, or to keep? */
+static int keptHandleGood(const CachedHandle *c, const int generation)
+{
+    if ((nativeHandleTime == 0) || (c->generation != generation))
+        return 0;
+    else if (nativeHandleTime < 0)
+        return 1;
+    return (difftime(time(NULL), c->when) < nativeHandleTime);
+} /* keptHandleGood */
+
+
+/*
+ * Open (arcfname), an archive path in (h), for reading. If it's a native
+ *  directory and the cache is on, a handle kept from when the same file
+ *  was last closed is used instead, if it's still good, and (keep) is set
+ *  up so this one is kept when closed, too; otherwise (keep)'s path is
+ *  NULL. Caller holds (h)'s lock, as for any other archiver call.
+ */
+static PHYSFS_Io *openReadKept(DirHandle *h, const char *arcfname,
+                               CachedHandle *keep)
+{
+    const int generation = h->ctx->searchGeneration;
+    PHYSFS_Io *retval;
+    PHYSFS_uint32 hash;
+    size_t j;
+
+    memset(keep, '\0', sizeof (*keep));
+
+    if (h->pins != NULL)
+    {
+        retval = openPinned(h, arcfname);
+        if (retval != NULL)
+            return retval;
+    } /* if */
+
+    if ((!h->native) || (nativeHandleTime == 0) || (h->verifyLock == NULL))
+        return h->funcs->openRead(h->opaque, arcfname);
+
+    hash = hashIndexPath(arcfname);
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    for (j = 0; (j < HANDLE_CACHE_SLOTS) && (h->handles[j].io); j++)
+    {
+        CachedHandle *slot = &h->handles[j];
+        if ((slot->hash == hash) && (strcmp(slot->path, arcfname) == 0))
+        {
+            *keep = *slot;
+            memmove(slot, slot + 1,
+                    (HANDLE_CACHE_SLOTS - j - 1) * sizeof (CachedHandle));
+            memset(&h->handles[HANDLE_CACHE_SLOTS - 1], '\0',
+                   sizeof (CachedHandle));
+            break;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    if (keep->io != NULL)
+    {
+        retval = keep->io;
+        keep->io = NULL;
+        if (keptHandleGood(keep, generation))
+            return retval;
+        retval->destroy(retval);  /* stale; open it fresh. */
+    } /* if */
+
+    retval = h->funcs->openRead(h->opaque, arcfname);
+    if (retval == NULL)
+    {
+        allocator.Free(keep->path);
+        keep->path = NULL;
+        return NULL;
+    } /* if */
+
+    if (keep->path == NULL)  /* if this fails, it just isn't kept. */
+        keep->path = __PHYSFS_strdup(arcfname);
+    keep->hash = hash;
+    keep->generation = generation;
+    keep->when = time(NULL);
+    return retval;
+} /* openReadKept */
+
+
+/*
+ * A file opened by openReadKept() was closed; put its (io) in (h)'s cache,
+ *  as (keep) says, for the next open of the same file, or close it if
+ *  that's no good. Either way, this takes (keep)'s path.
+ */
+static void keepReadHandle(DirHandle *h, CachedHandle *keep, PHYSFS_Io *io)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    CachedHandle evicted;
+    int good;
+
+    good = keptHandleGood(keep, h->ctx->searchGeneration);
+    if (good)
+        good = io->seek(io, 0);
+    if ((good) && (h->accessHint != PHYSFS_ACCESS_NORMAL))
+        good = __PHYSFS_ioAdvise(io, 0, 0, PHYSFS_ACCESS_NORMAL);
+    PHYSFS_setErrorCode(prevErr);
+
+    if (!good)
+    {
+        io->destroy(io);
+        allocator.Free(keep->path);
+        return;
+    } /* if */
+
+    keep->io = io;
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    evicted = h->handles[HANDLE_CACHE_SLOTS - 1];
+    memmove(&h->handles[1], &h->handles[0],
+            (HANDLE_CACHE_SLOTS - 1) * sizeof (CachedHandle));
+    h->handles[0] = *keep;
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    if (evicted.io != NULL)
+    {
+        evicted.io->destroy(evicted.io);
+        allocator.Free(evicted.path);
+    } /* if */
+} /* keepReadHandle */
+
+
+/* Close every handle (h) kept. */
+static void dropKeptHandles(DirHandle *h)
+{
+    CachedHandle dropped[HANDLE_CACHE_SLOTS];
+    size_t j;
+
+    if (h->verifyLock == NULL)
+        return;
+
+    __PHYSFS_platformGrabMutex(h->verifyLock);
+    memcpy(dropped, h->handles, sizeof (dropped));
+    memset(h->handles, '\0', sizeof (h->handles));
+    __PHYSFS_platformReleaseMutex(h->verifyLock);
+
+    for (j = 0; (j < HANDLE_CACHE_SLOTS) && (dropped[j].io); j++)
+    {
+        dropped[j].io->destroy(dropped[j].io);
+        allocator.Free(dropped[j].path);
+    } /* for */
+} /* dropKeptHandles */
+
+
+void PHYSFS_setOpenFileCacheTime(int seconds)
+{
+    PHYSFS_Context *ctx;
+    DirHandle *i;
+
+    nativeHandleTime = (seconds < 0) ? -1 : seconds;
+    bumpAllSearchGenerations();  /* don't keep trusting anything past it. */
+
+    if (contextLock == NULL)
+        return;  /* not initialized; nothing's mounted. */
+
+    /* what's kept would only be thrown out later; let it go now. */
+    __PHYSFS_platformGrabMutex(contextLock);
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+    {
+        grabLock(ctx->lock);
+        for (i = ctx->searchPath; i != NULL; i = i->next)
+            dropKeptHandles(i);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+    } /* for */
+    __PHYSFS_platformReleaseMutex(contextLock);
+} /* PHYSFS_setOpenFileCacheTime */
+
+
+int PHYSFS_enableSearchPathIndex(int enable)
+{
+    PHYSFS_Context *ctx = currentContext();
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(ctx->frozen, PHYSFS_ERR_FROZEN, ctx->lock, 0);
+    ctx->useSearchIndex = (enable != 0);
+    rebuildSearchIndex(ctx);
+    if ((ctx->useSearchIndex) && (ctx->searchIndex == NULL))
+    {
+        ctx->useSearchIndex = 0;
+        BAIL_MACRO_MUTEX(ERRPASS, ctx->lock, 0);
+    } /* if */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    return 1;
+} /* PHYSFS_enableSearchPathIndex */
+
+
+int PHYSFS_freeze(void)
+{
+    PHYSFS_Context *ctx = currentContext();
+    int prevUseIndex;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    grabLock(ctx->lock);
+    prevUseIndex = ctx->useSearchIndex;
+    if (!ctx->frozen)
+    {
+        /* everything is looked up in the index from here on out. */
+        ctx->useSearchIndex = 1;
+        rebuildSearchIndex(ctx);
+        if (ctx->searchIndex == NULL)
+        {
+            ctx->useSearchIndex = prevUseIndex;
+            rebuildSearchIndex(ctx);
+            BAIL_MACRO_MUTEX(ERRPASS, ctx->lock, 0);
+        } /* if */
+
+        __PHYSFS_MEMORY_BARRIER();  /* the index is done before we say so. */
+        ctx->frozen = 1;
+    } /* if */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    return 1;
+} /* PHYSFS_freeze */
+
+
+int PHYSFS_isFrozen(void)
+{
+    return currentContext()->frozen;
+} /* PHYSFS_isFrozen */
+
+
+PHYSFS_Context *PHYSFS_createContext(void)
+{
+    PHYSFS_Context *ctx;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
+
+    ctx = (PHYSFS_Context *) allocator.Malloc(sizeof (PHYSFS_Context));
+    BAIL_IF_MACRO(!ctx, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(ctx, '\0', sizeof (PHYSFS_Context));
+
+    ctx->lock = __PHYSFS_platformCreateMutex();
+    if (ctx->lock == NULL)
+    {
+        allocator.Free(ctx);
+        BAIL_MACRO(ERRPASS, NULL);
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(contextLock);
+    ctx->next = defaultContext.next;
+    defaultContext.next = ctx;
+    __PHYSFS_platformReleaseMutex(contextLock);
+
+    return ctx;
+} /* PHYSFS_createContext */
+
+
+/* MAKE SURE you hold contextLock before calling this! */
+static int isContext(const PHYSFS_Context *ctx)
+{
+    const PHYSFS_Context *i;
+    for (i = defaultContext.next; i != NULL; i = i->next)
+    {
+        if (i == ctx)
+            return 1;
+    } /* for */
+    return 0;
+} /* isContext */
+
+
+int PHYSFS_destroyContext(PHYSFS_Context *ctx)
+{
+    PHYSFS_Context **prev;
+    ErrState *err;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!ctx, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    __PHYSFS_platformGrabMutex(contextLock);
+    BAIL_IF_MACRO_MUTEX(!isContext(ctx), PHYSFS_ERR_INVALID_ARGUMENT,
+                        contextLock, 0);
+
+    grabLock(ctx->lock);
+    if ( (ctx->frozenOpenFiles) || (ctx->openReadList != NULL) ||
+         (ctx->openWriteList != NULL) )
+    {
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+        BAIL_MACRO_MUTEX(PHYSFS_ERR_FILES_STILL_OPEN, contextLock, 0);
+    } /* if */
+
+    /* nothing's open, so none of this can fail. */
+    ctx->frozen = 0;
+    discardAtomicWrites(ctx);
+    setWriteDir(ctx, NULL);
+    freeSearchPath(ctx);
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    if (watchLock != NULL)
+        syncWatches(ctx);  /* nothing's mounted, so this drops its watches. */
+    forgetMissing(ctx);
+
+    for (prev = &defaultContext.next; *prev != ctx; prev = &(*prev)->next)
+        /* just looking. */ ;
+    *prev = ctx->next;
+    __PHYSFS_platformReleaseMutex(contextLock);
+
+    err = findErrorForCurrentThread();
+    if ((err != NULL) && (err->context == ctx))
+        err->context = NULL;
+
+    __PHYSFS_platformDestroyMutex(ctx->lock);
+    allocator.Free(ctx);
+    return 1;
+} /* PHYSFS_destroyContext */
+
+
+int PHYSFS_setCurrentContext(PHYSFS_Context *ctx)
+{
+    ErrState *err;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    if (ctx != NULL)
+    {
+        int found;
+        __PHYSFS_platformGrabMutex(contextLock);
+        found = isContext(ctx);
+        __PHYSFS_platformReleaseMutex(contextLock);
+        BAIL_IF_MACRO(!found, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    } /* if */
+
+    err = findErrorForCurrentThread();
+    if ((err == NULL) && (ctx != NULL))
+    {
+        err = createStateForCurrentThread();
+        BAIL_IF_MACRO(!err, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+
+    if (err != NULL)
+    {
+        usingContexts = 1;  /* from now on, lookups have to check. */
+        err->context = ctx;
+    } /* if */
+
+    return 1;
+} /* PHYSFS_setCurrentContext */
+
+
+PHYSFS_Context *PHYSFS_getCurrentContext(void)
+{
+    const ErrState *err = findErrorForCurrentThread();
+    return err ? err->context : NULL;
+} /* PHYSFS_getCurrentContext */
+
+
+int PHYSFS_enableMissCache(int enable)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    useMissCache = (enable != 0);
+    bumpAllSearchGenerations();  /* forget everything, either way. */
+    return 1;
+} /* PHYSFS_enableMissCache */
+
+
+/*
+ * Verify that (fname) (in platform-independent notation), in relation
+ *  to (h) is secure. That means that each element of fname is checked
+ *  for symlinks (if they aren't permitted). This also allows for quick
+ *  rejection of files that exist outside an archive's mountpoint.
+ *
+ * With some exceptions (like PHYSFS_mkdir(), which builds multiple subdirs
+ *  at a time), you should always pass zero for "allowMissing" for efficiency.
+ *
+ * (fname) must point to an output from sanitizePlatformIndependentPath(),
+ *  since it will make sure that path names are in the right format for
+ *  passing certain checks. It will also do checks for "insecure" pathnames
+ *  like ".." which should be done once instead of once per archive. This also
+ *  gives us license to treat (fname) as scratch space in this function.
+ *
+ * Returns non-zero if string is safe, zero if there's a security issue.
+ *  PHYSFS_getLastError() will specify what was wrong. (*fname) will be
+ *  updated to point past any mount point elements so it is prepared to
+ *  be used with the archiver directly.
+ */
+static int verifyPath(DirHandle *h, char **_fname, int allowMissing)
+{
+    char *fname = *_fname;
+    int retval = 1;
+    char *start;
+    char *end;
+
+    if (*fname == '\0')  /* quick rejection. */
+        return 1;
+
+    /* !!! FIXME: This codeblock sucks. */
+    if (h->mountPoint != NULL)  /* NULL mountpoint means "/". */
+    {
+        size_t mntpntlen = strlen(h->mountPoint);
+        size_t len = strlen(fname);
+        assert(mntpntlen > 1); /* root mount points should be NULL. */
+        /* not under the mountpoint, so skip this archive. */
+        BAIL_IF_MACRO(len < mntpntlen-1, PHYSFS_ERR_NOT_FOUND, 0);
+        /* !!! FIXME: Case insensitive? */
+        retval = strncmp(h->mountPoint, fname, mntpntlen-1);
+        BAIL_IF_MACRO(retval != 0, PHYSFS_ERR_NOT_FOUND, 0);
+        if (len > mntpntlen-1)  /* corner case... */
+            BAIL_IF_MACRO(fname[mntpntlen-1]!='/', PHYSFS_ERR_NOT_FOUND, 0);
+        fname += mntpntlen-1;  /* move to start of actual archive path. */
+        if (*fname == '/')
+            fname++;
+        *_fname = fname;  /* skip mountpoint for later use. */
+        retval = 1;  /* may be reset, below. */
+    } /* if */
+
+    start = fname;
+    if (!h->ctx->allowSymLinks)
+    {
+        const int generation = h->ctx->searchGeneration;
+        char *lastsep = strrchr(fname, '/');
+        int knownParent = 0;
+
+        /* if the whole parent dir checked out lately, just do the rest. */
+        if (lastsep != NULL)
+        {
+            *lastsep = '\0';
+            knownParent = dirAlreadyVerified(h, fname, generation);
+            *lastsep = '/';
+            if (knownParent)
+                start = lastsep + 1;
+        } /* if */
+
+        while (1)
+        {
+            PHYSFS_Stat statbuf;
+            int rc = 0;
+            end = strchr(start, '/');
+
+            if (end != NULL) *end = '\0';
+            rc = statArchive(h, fname, &statbuf);
+            if (rc)
+                rc = (statbuf.filetype == PHYSFS_FILETYPE_SYMLINK);
+            else if (currentErrorCode() == PHYSFS_ERR_NOT_FOUND)
+                retval = 0;
+
+            if (end != NULL) *end = '/';
+
+            /* insecure path (has a disallowed symlink in it)? */
+            BAIL_IF_MACRO(rc, PHYSFS_ERR_SYMLINK_FORBIDDEN, 0);
+
+            /* made it to the last element, so everything before it is ok. */
+            if ((end == NULL) && (lastsep != NULL) && (!knownParent))
+            {
+                *lastsep = '\0';
+                rememberVerifiedDir(h, fname, generation);
+                *lastsep = '/';
+            } /* if */
+
+            /* break out early if path element is missing. */
+            if (!retval)
+            {
+                /*
+                 * We need to clear it if it's the last element of the path,
+                 *  since this might be a non-existant file we're opening
+                 *  for writing...
+                 */
+                if ((end == NULL) || (allowMissing))
+                    retval = 1;
+                break;
+            } /* if */
+
+            if (end == NULL)
+                break;
+
+            start = end + 1;
+        } /* while */
+    } /* if */
+
+    return retval;
+} /* verifyPath */
+
+
+static int doMkdir(const char *_dname, char *dname)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *h;
+    char *start;
+    char *end;
+    int retval = 0;
+    int exists = 1;  /* force existance check on first path element. */
+
+    BAIL_IF_MACRO(!sanitizePlatformIndependentPath(_dname, dname), ERRPASS, 0);
+
+    grabLock(ctx->lock);
+    BAIL_IF_MACRO_MUTEX(!ctx->writeDir, PHYSFS_ERR_NO_WRITE_DIR, ctx->lock, 0);
+    h = ctx->writeDir;
+    lockDirHandle(h);
+    if (!verifyPath(h, &dname, 1))
+    {
+        unlockDirHandle(h);
+        BAIL_MACRO_MUTEX(ERRPASS, ctx->lock, 0);
+    } /* if */
+
+    start = dname;
+    while (1)
+    {
+        end = strchr(start, '/');
+        if (end != NULL)
+            *end = '\0';
+
+        /* only check for existance if all parent dirs existed, too... */
+        if (exists)
+        {
+            PHYSFS_Stat statbuf;
+            const int rc = h->funcs->stat(h->opaque, dname, &statbuf);
+            if ((!rc) && (currentErrorCode() == PHYSFS_ERR_NOT_FOUND))
+                exists = 0;
+            retval = ((rc) && (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY));
+        } /* if */
+
+        if (!exists)
+            retval = h->funcs->mkdir(h->opaque, dname);
+
+        if (!retval)
+            break;
+
+        if (end == NULL)
+            break;
+
+        *end = '/';
+        start = end + 1;
+    } /* while */
+
+    unlockDirHandle(h);
+    bumpSearchGeneration(ctx);  /* even on failure; some might be made. */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    return retval;
+} /* doMkdir */
+
+
+int PHYSFS_mkdir(const char *_dname)
+{
+    int retval = 0;
+    char *dname;
+    size_t len;
+
+    BAIL_IF_MACRO(!_dname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    len = strlen(_dname) + 1;
+    dname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!dname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    retval = doMkdir(_dname, dname);
+    __PHYSFS_smallFree(dname);
+    return retval;
+} /* PHYSFS_mkdir */
+
+
+static int doDelete(const char *_fname, char *fname)
+{
+    PHYSFS_Context *ctx = currentContext();
+    int retval = 0;
+    DirHandle *h;
+    BAIL_IF_MACRO(!sanitizePlatformIndependentPath(_fname, fname), ERRPASS, 0);
+
+    grabLock(ctx->lock);
+
+    BAIL_IF_MACRO_MUTEX(!ctx->writeDir, PHYSFS_ERR_NO_WRITE_DIR, ctx->lock, 0);
+    h = ctx->writeDir;
+    lockDirHandle(h);
+    if (verifyPath(h, &fname, 0))
+        retval = h->funcs->remove(h->opaque, fname);
+    unlockDirHandle(h);
+    bumpSearchGeneration(ctx);  /* might uncover the same path elsewhere. */
+
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    return retval;
+} /* doDelete */
+
+
+int PHYSFS_delete(const char *_fname)
+{
+    int retval;
+    char *fname;
+    size_t len;
+
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    retval = doDelete(_fname, fname);
+    __PHYSFS_smallFree(fname);
+    return retval;
+} /* PHYSFS_delete */
+
+
+const char *PHYSFS_getRealDir(const char *_fname)
+{
+    PHYSFS_Context *ctx = currentContext();
+    const char *retval = NULL;
+    char *fname = NULL;
+    size_t len;
+
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    len = strlen(_fname) + 1;
+    fname = __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    if (sanitizePlatformIndependentPath(_fname, fname))
+    {
+        DirHandle *i;
+        SearchPathIter iter;
+        const PHYSFS_uint32 hash = hashIndexPath(fname);
+        const int generation = ctx->searchGeneration;
+        const int reader = beginSearchPathRead(ctx);
+        i = NULL;
+        if (!knownMissing(ctx, fname, hash, generation))
+            i = firstCandidate(ctx, &iter, fname, hash);
+        for (; (i != NULL) && (retval == NULL); i = nextCandidate(&iter))
+        {
+            char *arcfname = fname;
+            if (partOfMountPoint(i, arcfname))
+                retval = i->dirName;
+            else
+            {
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                {
+                    PHYSFS_Stat statbuf;
+                    if (statArchive(i, arcfname, &statbuf))
+                        retval = i->dirName;
+                } /* if */
+                unlockDirHandle(i);
+            } /* else */
+        } /* for */
+        endSearchPathRead(ctx, reader);
+
+        if (retval == NULL)
+            rememberMissing(ctx, fname, hash, generation);
+    } /* if */
+
+    __PHYSFS_smallFree(fname);
+    return retval;
+} /* PHYSFS_getRealDir */
+
+
+static void enumFilesCallback(void *data, const char *origdir, const char *str)
+{
+    addToStringList((EnumStringListCallbackData *) data, str);
+} /* enumFilesCallback */
+
+
+char **PHYSFS_enumerateFiles(const char *path)
+{
+    /*
+     * Gather everything from every mount, then sort and drop duplicates
+     *  once at the end, instead of keeping the list sorted as we go.
+     */
+    EnumStringListCallbackData ecd;
+    memset(&ecd, '\0', sizeof (ecd));
+    PHYSFS_enumerateFilesCallback(path, enumFilesCallback, &ecd);
+    return finishStringList(&ecd, 1);
+} /* PHYSFS_enumerateFiles */
+
+
+/*
+ * Broke out to seperate function so we can use stack allocation gratuitously.
+ */
+static void enumerateFromMountPoint(DirHandle *i, const char *arcfname,
+                                    PHYSFS_EnumFilesCallback callback,
+                                    const char *_fname, void *data)
+{
+    const size_t len = strlen(arcfname);
+    char *ptr = NULL;
+    char *end = NULL;
+    const size_t slen = strlen(i->mountPoint) + 1;
+    char *mountPoint = (char *) __PHYSFS_smallAlloc(slen);
+
+    if (mountPoint == NULL)
+        return;  /* oh well. */
+
+    strcpy(mountPoint, i->mountPoint);
+    ptr = mountPoint + ((len) ? len + 1 : 0);
+    end = strchr(ptr, '/');
+    assert(end);  /* should always find a terminating '/'. */
+    *end = '\0';
+    callback(data, _fname, ptr);
+    __PHYSFS_smallFree(mountPoint);
+} /* enumerateFromMountPoint */
+
+
+typedef struct SymlinkFilterData
+{
+    PHYSFS_EnumFilesCallback callback;
+    void *callbackData;
+    DirHandle *dirhandle;
+    const char *arcfname;  /* dir being enumerated, minus the mountpoint. */
+} SymlinkFilterData;
+
+static void enumCallbackFilterSymLinks(void *_data, const char *origdir,
+                                       const char *fname)
+{
+    SymlinkFilterData *data = (SymlinkFilterData *) _data;
+    const char *arcfname = data->arcfname;
+    const size_t slen = strlen(arcfname) + strlen(fname) + 2;
+    char *path = (char *) __PHYSFS_smallAlloc(slen);
+
+    if (path != NULL)
+    {
+        const DirHandle *dh = data->dirhandle;
+        PHYSFS_Stat statbuf;
+
+        /* stat it in the archive's terms, not the mountpoint's. */
+        sprintf(path, "%s%s%s", arcfname, *arcfname ? "/" : "", fname);
+        if (statArchive(dh, path, &statbuf))
+        {
+            /* Pass it on to the application if it's not a symlink. */
+            if (statbuf.filetype != PHYSFS_FILETYPE_SYMLINK)
+                data->callback(data->callbackData, origdir, fname);
+        } /* if */
+
+        __PHYSFS_smallFree(path);
+    } /* if */
+} /* enumCallbackFilterSymLinks */
+
+
+/* The same filter, for archivers that tell us each entry's type anyhow. */
+static void enumStatCallbackFilterSymLinksName(void *_data,
+                                               const char *origdir,
+                                               const char *fname,
+                                               const PHYSFS_Stat *stat)
+{
+    SymlinkFilterData *data = (SymlinkFilterData *) _data;
+    if (stat->filetype != PHYSFS_FILETYPE_SYMLINK)
+        data->callback(data->callbackData, origdir, fname);
+} /* enumStatCallbackFilterSymLinksName */
+
+
+static void enumerateFromDirListing(const DirListing *listing,
+                                    const int allowSymLinks,
+                                    PHYSFS_EnumFilesCallback callback,
+                                    const char *_fname, void *data)
+{
+    const char *name = listing->names;
+    PHYSFS_uint32 i;
+
+    for (i = 0; i < listing->count; i++)
+    {
+        if ( (allowSymLinks) ||
+             (listing->stats[i].filetype != PHYSFS_FILETYPE_SYMLINK) )
+            callback(data, _fname, name);
+        name += strlen(name) + 1;
+    } /* for */
+} /* enumerateFromDirListing */
+
+
+typedef struct PrefixFilterData
+{
+    PHYSFS_EnumFilesCallback callback;
+    void *callbackData;
+    const char *prefix;
+    PHYSFS_uint32 prefixlen;
+} PrefixFilterData;
+
+static void enumCallbackFilterPrefix(void *_data, const char *origdir,
+                                     const char *fname)
+{
+    const PrefixFilterData *data = (const PrefixFilterData *) _data;
+    if (__PHYSFS_strnicmpASCII(fname, data->prefix, data->prefixlen) == 0)
+        data->callback(data->callbackData, origdir, fname);
+} /* enumCallbackFilterPrefix */
+
+
+/* Caller holds (i)'s lock; (arcfname) is in (i)'s terms. */
+static void enumerateFromDirHandle(DirHandle *i, const char *arcfname,
+                                   const char *prefix,
+                                   PHYSFS_EnumFilesCallback callback,
+                                   const char *origdir, void *data)
+{
+    /* (callback) filters by (prefix) itself; this just saves it work. */
+    if ((prefix != NULL) && (i->funcs->enumerateFilesPrefix != NULL))
+    {
+        i->funcs->enumerateFilesPrefix(i->opaque, arcfname, prefix,
+                                       callback, origdir, data);
+    } /* if */
+    else
+    {
+        i->funcs->enumerateFiles(i->opaque, arcfname,
+                                 callback, origdir, data);
+    } /* else */
+} /* enumerateFromDirHandle */
+
+
+/*
+ * Enumerate (arcfname) in (i) with only each entry's filetype sure to be
+ *  filled in, if (i) can do that for less than a stat per entry: from
+ *  d_type for native dirs, or the central directory for .zip files.
+ *  Returns zero, having done nothing, if it can't. Caller holds (i)'s lock.
+ */
+static int enumerateTypesFromDirHandle(DirHandle *i, const char *arcfname,
+                                       PHYSFS_EnumFilesStatCallback cb,
+                                       const char *origdir, void *data)
+{
+    extern const PHYSFS_Archiver __PHYSFS_Archiver_DIR;
+#if PHYSFS_SUPPORTS_ZIP
+    extern const PHYSFS_Archiver __PHYSFS_Archiver_ZIP;
+#endif
+
+    if (i->funcs == &__PHYSFS_Archiver_DIR)
+        __PHYSFS_DIR_enumerateFilesType(i->opaque, arcfname, cb, origdir, data);
+#if PHYSFS_SUPPORTS_ZIP
+    /* registered archivers are copies, so this is how to spot ours. */
+    else if (i->funcs->openArchive == __PHYSFS_Archiver_ZIP.openArchive)
+        __PHYSFS_zipEnumerateFilesType(i->opaque, arcfname, cb, origdir, data);
+#endif
+    else
+        return 0;
+
+    return 1;
+} /* enumerateTypesFromDirHandle */
+
+
+/*
+ * Report everything in (data->arcfname) but symlinks, asking (i) for their
+ *  types in the cheapest way it has. Caller holds (i)'s lock.
+ */
+static void enumerateNoSymLinks(DirHandle *i, const char *arcfname,
+                                const char *prefix, const char *origdir,
+                                SymlinkFilterData *data)
+{
+    if (enumerateTypesFromDirHandle(i, arcfname,
+                                    enumStatCallbackFilterSymLinksName,
+                                    origdir, data))
+        return;  /* done. */
+
+    else if (i->funcs->enumerateFilesStat != NULL)
+    {
+        i->funcs->enumerateFilesStat(i->opaque, arcfname,
+                                     enumStatCallbackFilterSymLinksName,
+                                     origdir, data);
+    } /* else if */
+
+    else  /* stat each name, then. */
+    {
+        enumerateFromDirHandle(i, arcfname, prefix,
+                               enumCallbackFilterSymLinks, origdir, data);
+    } /* else */
+} /* enumerateNoSymLinks */
+
+
+/* (prefix) is NULL to report everything. */
+static void doEnumerateFiles(const char *_fname, const char *prefix,
+                             PHYSFS_EnumFilesCallback callback, void *data)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PrefixFilterData prefixdata;
+    size_t len;
+    char *fname;
+
+    if (prefix != NULL)
+    {
+        prefixdata.callback = callback;
+        prefixdata.callbackData = data;
+        prefixdata.prefix = prefix;
+        prefixdata.prefixlen = (PHYSFS_uint32) strlen(prefix);
+        callback = enumCallbackFilterPrefix;
+        data = &prefixdata;
+    } /* if */
+
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, ) /*0*/;
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_ENUMERATE, _fname, NULL, 0);
+
+    if (sanitizePlatformIndependentPath(_fname, fname))
+    {
+        DirHandle *i;
+        SearchPathIter iter;
+        SymlinkFilterData filterdata;
+        const int reader = beginSearchPathRead(ctx);
+
+        if (!ctx->allowSymLinks)
+        {
+            memset(&filterdata, '\0', sizeof (filterdata));
+            filterdata.callback = callback;
+            filterdata.callbackData = data;
+        } /* if */
+
+        i = routeSearchPath(ctx, &iter, fname);
+        for (; i != NULL; i = nextCandidate(&iter))
+        {
+            char *arcfname = fname;
+            if (partOfMountPoint(i, arcfname))
+                enumerateFromMountPoint(i, arcfname, callback, _fname, data);
+
+            else
+            {
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                {
+                    DirListing *listing = getDirListing(i, arcfname);
+                    if (listing != NULL)
+                    {
+                        enumerateFromDirListing(listing, ctx->allowSymLinks,
+                                                callback, _fname, data);
+                        releaseDirListing(i, listing);
+                    } /* if */
+                    else if ( (!ctx->allowSymLinks) &&
+                              (i->funcs->info.supportsSymlinks) )
+                    {
+                        filterdata.dirhandle = i;
+                        filterdata.arcfname = arcfname;
+                        enumerateNoSymLinks(i, arcfname, prefix,
+                                            _fname, &filterdata);
+                    } /* else if */
+                    else
+                    {
+                        enumerateFromDirHandle(i, arcfname, prefix,
+                                               callback, _fname, data);
+                    } /* else */
+                } /* if */
+                unlockDirHandle(i);
+            } /* else */
+        } /* for */
+        endSearchPathRead(ctx, reader);
+    } /* if */
+
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_ENUMERATE, _fname, NULL, 0, 1);
+    __PHYSFS_smallFree(fname);
+} /* doEnumerateFiles */
+
+
+/* !!! FIXME: this should report error conditions. */
+void PHYSFS_enumerateFilesCallback(const char *_fname,
+                                   PHYSFS_EnumFilesCallback callback,
+                                   void *data)
+{
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    doEnumerateFiles(_fname, NULL, callback, data);
+} /* PHYSFS_enumerateFilesCallback */
+
+
+void PHYSFS_enumerateFilesPrefixCallback(const char *_fname,
+                                         const char *prefix,
+                                         PHYSFS_EnumFilesCallback callback,
+                                         void *data)
+{
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    BAIL_IF_MACRO(!prefix, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    BAIL_IF_MACRO(strchr(prefix, '/'), PHYSFS_ERR_BAD_FILENAME, ) /*0*/;
+    doEnumerateFiles(_fname, (*prefix) ? prefix : NULL, callback, data);
+} /* PHYSFS_enumerateFilesPrefixCallback */
+
+
+typedef struct EnumStatData
+{
+    PHYSFS_EnumFilesStatCallback callback;
+    void *callbackData;
+    DirHandle *dirhandle;
+    const char *arcfname;  /* the dir being listed, in (dirhandle)'s terms. */
+    int typeonly;  /* PHYSFS_WALK_TYPES_ONLY */
+} EnumStatData;
+
+static void enumStatCallbackFilterSymLinks(void *_data, const char *origdir,
+                                           const char *fname,
+                                           const PHYSFS_Stat *stat)
+{
+    EnumStatData *data = (EnumStatData *) _data;
+    const int allowSymLinks = data->dirhandle->ctx->allowSymLinks;
+    if ((allowSymLinks) || (stat->filetype != PHYSFS_FILETYPE_SYMLINK))
+        data->callback(data->callbackData, origdir, fname, stat);
+} /* enumStatCallbackFilterSymLinks */
+
+
+/* For archivers without enumerateFilesStat(), stat each name as it comes. */
+static void enumStatCallbackFallback(void *_data, const char *origdir,
+                                     const char *fname)
+{
+    EnumStatData *data = (EnumStatData *) _data;
+    const DirHandle *dh = data->dirhandle;
+    const DirHandle *wd = dh->ctx->writeDir;  /* retired if it's reset. */
+    const char *dir = data->arcfname;
+    const size_t slen = strlen(dir) + strlen(fname) + 2;
+    char *path = (char *) __PHYSFS_smallAlloc(slen);
+    PHYSFS_Stat statbuf;
+
+    if (path == NULL)
+        return;  /* oh well. */
+
+    sprintf(path, "%s%s%s", dir, *dir ? "/" : "", fname);
+
+    /* same defaults as PHYSFS_stat(). */
+    statbuf.filesize = -1;
+    statbuf.modtime = -1;
+    statbuf.createtime = -1;
+    statbuf.accesstime = -1;
+    statbuf.filetype = PHYSFS_FILETYPE_OTHER;
+    statbuf.readonly = !(wd && (strcmp(wd->dirName, dh->dirName) == 0));
+    if (statArchive(dh, path, &statbuf))
+        enumStatCallbackFilterSymLinks(data, origdir, fname, &statbuf);
+
+    __PHYSFS_smallFree(path);
+} /* enumStatCallbackFallback */
+
+
+/* Mount points show up as directories; see PHYSFS_stat(). */
+static void enumStatCallbackMountPoint(void *_data, const char *origdir,
+                                       const char *fname)
+{
+    EnumStatData *data = (EnumStatData *) _data;
+    PHYSFS_Stat statbuf;
+
+    statbuf.filesize = -1;
+    statbuf.modtime = -1;
+    statbuf.createtime = -1;
+    statbuf.accesstime = -1;
+    statbuf.filetype = PHYSFS_FILETYPE_DIRECTORY;
+    statbuf.readonly = 1;  /* !!! FIXME */
+    data->callback(data->callbackData, origdir, fname, &statbuf);
+} /* enumStatCallbackMountPoint */
+
+
+/* Caller holds (i)'s lock; (arcfname) is in (i)'s terms. */
+static void enumerateStatFromDirHandle(DirHandle *i, const char *arcfname,
+                                       const char *origdir,
+                                       EnumStatData *statdata)
+{
+    DirListing *listing = getDirListing(i, arcfname);
+
+    statdata->arcfname = arcfname;
+    if (listing != NULL)
+    {
+        const char *name = listing->names;
+        PHYSFS_uint32 j;
+        for (j = 0; j < listing->count; j++)
+        {
+            enumStatCallbackFilterSymLinks(statdata, origdir, name,
+                                           &listing->stats[j]);
+            name += strlen(name) + 1;
+        } /* for */
+        releaseDirListing(i, listing);
+    } /* if */
+    else if ((statdata->typeonly) &&
+             (enumerateTypesFromDirHandle(i, arcfname,
+                                          enumStatCallbackFilterSymLinks,
+                                          origdir, statdata)))
+        return;  /* that's all it asked for. */
+    else if (i->funcs->enumerateFilesStat != NULL)
+    {
+        i->funcs->enumerateFilesStat(i->opaque, arcfname,
+                                     enumStatCallbackFilterSymLinks,
+                                     origdir, statdata);
+    } /* if */
+    else
+    {
+        i->funcs->enumerateFiles(i->opaque, arcfname,
+                                 enumStatCallbackFallback,
+                                 origdir, statdata);
+    } /* else */
+} /* enumerateStatFromDirHandle */
+
+
+void PHYSFS_enumerateFilesStatCallback(const char *_fname,
+                                       PHYSFS_EnumFilesStatCallback callback,
+                                       void *data)
+{
+    PHYSFS_Context *ctx = currentContext();
+    size_t len;
+    char *fname;
+
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, ) /*0*/;
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_ENUMERATE, _fname, NULL, 0);
+
+    if (sanitizePlatformIndependentPath(_fname, fname))
+    {
+        DirHandle *i;
+        SearchPathIter iter;
+        EnumStatData statdata;
+        const int reader = beginSearchPathRead(ctx);
+
+        memset(&statdata, '\0', sizeof (statdata));
+        statdata.callback = callback;
+        statdata.callbackData = data;
+
+        i = routeSearchPath(ctx, &iter, fname);
+        for (; i != NULL; i = nextCandidate(&iter))
+        {
+            char *arcfname = fname;
+            statdata.dirhandle = i;
+            if (partOfMountPoint(i, arcfname))
+            {
+                enumerateFromMountPoint(i, arcfname, enumStatCallbackMountPoint,
+                                        _fname, &statdata);
+            } /* if */
+
+            else
+            {
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                    enumerateStatFromDirHandle(i, arcfname, _fname, &statdata);
+                unlockDirHandle(i);
+            } /* else */
+        } /* for */
+        endSearchPathRead(ctx, reader);
+    } /* if */
+
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_ENUMERATE, _fname, NULL, 0, 1);
+    __PHYSFS_smallFree(fname);
+} /* PHYSFS_enumerateFilesStatCallback */
+
+
+/*
+ * PHYSFS_openDirectory() cursors list one mount at a time, as they're read
+ *  from, so nothing is held between PHYSFS_readDirectory() calls: not the
+ *  search path, and not an archive. Mounts are remembered by serial, so one
+ *  that's unmounted in the meantime is just skipped.
+ */
+struct PHYSFS_Directory
+{
+    PHYSFS_Context *ctx;
+    char *path;  /* as the app gave it, for origdir. */
+    char *fname;  /* sanitized. */
+    PHYSFS_uint32 *serials;  /* DirHandle::serial of each mount to list. */
+    size_t numMounts;
+    size_t nextMount;  /* next in (serials) to list. */
+    EnumStringListCallbackData batch;  /* what the last mount listed... */
+    PHYSFS_Stat *stats;  /* ...and each of those's stat. */
+    PHYSFS_uint32 statsAllocated;
+    PHYSFS_uint32 pos;  /* next in (batch) to hand back. */
+    int remember;  /* more mounts to come, so keep (seen) up. */
+    EnumStringListCallbackData seen;  /* every name so far... */
+    __PHYSFS_HashTable seenhash;  /* ...and an index to find them by. */
+    PHYSFS_ErrorCode errcode;
+};
+
+
+static void directoryCallback(void *_data, const char *origdir,
+                              const char *fname, const PHYSFS_Stat *stat)
+{
+    PHYSFS_Directory *dir = (PHYSFS_Directory *) _data;
+    EnumStringListCallbackData *batch = &dir->batch;
+    const PHYSFS_uint32 hash = __PHYSFS_hashString(fname, strlen(fname));
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 idx;
+
+    if (dir->errcode)
+        return;
+
+    /* earlier mounts win, like they do in PHYSFS_stat(). */
+    while ((idx = __PHYSFS_hashTableFind(&dir->seenhash, hash, &probe)) != 0)
+    {
+        if (strcmp(dir->seen.names + dir->seen.offsets[idx - 1], fname) == 0)
+            return;
+    } /* while */
+
+    if (dir->remember)
+    {
+        addToStringList(&dir->seen, fname);
+        if ( (dir->seen.errcode) ||
+             (!__PHYSFS_hashTableInsert(&dir->seenhash, hash,
+                                        dir->seen.size)) )
+        {
+            dir->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return;
+        } /* if */
+    } /* if */
+
+    if (batch->size == dir->statsAllocated)
+    {
+        const PHYSFS_uint32 newalloc = batch->size ? batch->size * 2 : 64;
+        void *ptr = allocator.Realloc(dir->stats,
+                                      newalloc * sizeof (PHYSFS_Stat));
+        if (ptr == NULL)
+        {
+            dir->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return;
+        } /* if */
+        dir->stats = (PHYSFS_Stat *) ptr;
+        dir->statsAllocated = newalloc;
+    } /* if */
+
+    memcpy(&dir->stats[batch->size], stat, sizeof (PHYSFS_Stat));
+    addToStringList(batch, fname);
+    if (batch->errcode)
+        dir->errcode = batch->errcode;
+} /* directoryCallback */
+
+
+/* List the next mount that's still there into (dir->batch). */
+static void listNextMount(PHYSFS_Directory *dir)
+{
+    PHYSFS_Context *ctx = dir->ctx;
+    const PHYSFS_uint32 serial = dir->serials[dir->nextMount++];
+    DirHandle *i;
+    SearchPathIter iter;
+    EnumStatData statdata;
+    const int reader = beginSearchPathRead(ctx);
+
+    memset(&statdata, '\0', sizeof (statdata));
+    statdata.callback = directoryCallback;
+    statdata.callbackData = dir;
+    dir->batch.size = 0;
+    dir->batch.names_len = 0;
+    dir->pos = 0;
+    dir->remember = (dir->nextMount < dir->numMounts);
+
+    i = routeSearchPath(ctx, &iter, dir->fname);
+    while ((i != NULL) && (i->serial != serial))
+        i = nextCandidate(&iter);
+
+    if (i != NULL)
+    {
+        char *arcfname = dir->fname;
+        statdata.dirhandle = i;
+        if (partOfMountPoint(i, arcfname))
+        {
+            enumerateFromMountPoint(i, arcfname, enumStatCallbackMountPoint,
+                                    dir->path, &statdata);
+        } /* if */
+
+        else
+        {
+            lockDirHandle(i);
+            if (verifyPath(i, &arcfname, 0))
+                enumerateStatFromDirHandle(i, arcfname, dir->path, &statdata);
+            unlockDirHandle(i);
+        } /* else */
+    } /* if */
+
+    endSearchPathRead(ctx, reader);
+} /* listNextMount */
+
+
+PHYSFS_Directory *PHYSFS_openDirectory(const char *path)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_Directory *retval;
+    SearchPathIter iter;
+    DirHandle *i;
+    size_t len;
+    int reader;
+
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+
+    retval = (PHYSFS_Directory *) allocator.Malloc(sizeof (PHYSFS_Directory));
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(retval, '\0', sizeof (PHYSFS_Directory));
+    retval->ctx = ctx;
+
+    len = strlen(path) + 1;
+    retval->path = (char *) allocator.Malloc(len * 2);
+    GOTO_IF_MACRO(!retval->path, PHYSFS_ERR_OUT_OF_MEMORY, openDirFailed);
+    memcpy(retval->path, path, len);
+    retval->fname = retval->path + len;
+    if (!sanitizePlatformIndependentPath(path, retval->fname))
+        goto openDirFailed;
+
+    GOTO_IF_MACRO(!__PHYSFS_hashTableInit(&retval->seenhash, 64),
+                  ERRPASS, openDirFailed);
+
+    /* just note which mounts to list; they're listed as they're read. */
+    reader = beginSearchPathRead(ctx);
+    i = routeSearchPath(ctx, &iter, retval->fname);
+    for (; i != NULL; i = nextCandidate(&iter))
+    {
+        if ((retval->numMounts & (retval->numMounts + 1)) == 0)  /* 2^n-1 */
+        {
+            const size_t newalloc = (retval->numMounts + 1) * 2;
+            void *ptr = allocator.Realloc(retval->serials,
+                                          newalloc * sizeof (PHYSFS_uint32));
+            if (ptr == NULL)
+            {
+                endSearchPathRead(ctx, reader);
+                GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, openDirFailed);
+            } /* if */
+            retval->serials = (PHYSFS_uint32 *) ptr;
+        } /* if */
+        retval->serials[retval->numMounts++] = i->serial;
+    } /* for */
+    endSearchPathRead(ctx, reader);
+
+    return retval;
+
+openDirFailed:
+    PHYSFS_closeDirectory(retval);
+    return NULL;
+} /* PHYSFS_openDirectory */
+
+
+int PHYSFS_readDirectory(PHYSFS_Directory *dir, const char **name,
+                         PHYSFS_Stat *stat)
+{
+    BAIL_IF_MACRO(!dir, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(!name, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    while ((dir->pos == dir->batch.size) && (dir->nextMount < dir->numMounts))
+    {
+        BAIL_IF_MACRO(dir->errcode, dir->errcode, -1);
+        listNextMount(dir);
+    } /* while */
+
+    /* it's done if it failed partway, too: the rest might be missing. */
+    BAIL_IF_MACRO(dir->errcode, dir->errcode, -1);
+
+    if (dir->pos == dir->batch.size)
+        return 0;  /* that's everything. */
+
+    *name = dir->batch.names + dir->batch.offsets[dir->pos];
+    if (stat != NULL)
+        memcpy(stat, &dir->stats[dir->pos], sizeof (PHYSFS_Stat));
+    dir->pos++;
+    return 1;
+} /* PHYSFS_readDirectory */
+
+
+int PHYSFS_closeDirectory(PHYSFS_Directory *dir)
+{
+    BAIL_IF_MACRO(!dir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    __PHYSFS_hashTableDeinit(&dir->seenhash);
+    allocator.Free(dir->seen.names);
+    allocator.Free(dir->seen.offsets);
+    allocator.Free(dir->batch.names);
+    allocator.Free(dir->batch.offsets);
+    allocator.Free(dir->stats);
+    allocator.Free(dir->serials);
+    allocator.Free(dir->path);
+    allocator.Free(dir);
+    return 1;
+} /* PHYSFS_closeDirectory */
+
+
+/*
+ * PHYSFS_walkTree() visits one DirHandle at a time, listing each directory
+ *  straight from that archive, so it never goes back to the search path
+ *  for a subdirectory. Subdirectories are queued while a directory is
+ *  listed and visited once the archiver is done with it, since we can't
+ *  touch (path) while an archiver might still be looking at it.
+ */
+typedef struct WalkTreeData
+{
+    PHYSFS_EnumFilesStatCallback callback;
+    void *callbackData;
+    DirHandle *dirhandle;
+    EnumStatData statdata;  /* feeds walkTreeCallback(). */
+    char *path;  /* dir being listed, in platform-independent notation. */
+    size_t pathlen;
+    size_t pathallocated;
+    size_t arcoffset;  /* (path) from here on is in (dirhandle)'s terms. */
+    EnumStringListCallbackData pending;  /* subdirs waiting for a visit. */
+    int unique;  /* PHYSFS_WALK_UNIQUE */
+    int remember;  /* note what (dirhandle) reports, for later archives. */
+    EnumStringListCallbackData seen;  /* every path reported so far... */
+    __PHYSFS_HashTable seenhash;  /* ...and an index to find them by. */
+    char *scratch;
+    size_t scratchallocated;
+    PHYSFS_ErrorCode errcode;
+} WalkTreeData;
+
+static int walkTreeReserve(WalkTreeData *w, char **buf, size_t *allocated,
+                           size_t needed)
+{
+    if (needed > *allocated)
+    {
+        size_t newalloc = *allocated ? *allocated : 256;
+        void *ptr;
+        while (newalloc < needed)
+            newalloc *= 2;
+        ptr = allocator.Realloc(*buf, newalloc);
+        if (ptr == NULL)
+        {
+            w->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return 0;
+        } /* if */
+        *buf = (char *) ptr;
+        *allocated = newalloc;
+    } /* if */
+
+    return 1;
+} /* walkTreeReserve */
+
+
+static int walkTreeAppend(WalkTreeData *w, const char *name)
+{
+    const size_t len = strlen(name);
+    const size_t sep = (w->pathlen != 0) ? 1 : 0;
+    if (!walkTreeReserve(w, &w->path, &w->pathallocated, w->pathlen+sep+len+1))
+        return 0;
+    if (sep)
+        w->path[w->pathlen++] = '/';
+    memcpy(w->path + w->pathlen, name, len + 1);
+    w->pathlen += len;
+    return 1;
+} /* walkTreeAppend */
+
+
+/* For PHYSFS_WALK_UNIQUE: non-zero if $dir/$name hasn't been reported yet. */
+static int walkTreeFirstSighting(WalkTreeData *w, const char *dir,
+                                 const char *name)
+{
+    size_t dirlen = strlen(dir);
+    const size_t len = dirlen + strlen(name) + 2;
+    PHYSFS_uint32 probe = 0;
+    PHYSFS_uint32 hash;
+    PHYSFS_uint32 idx;
+    char *path;
+
+    if ((w->seen.size == 0) && (!w->remember))
+        return 1;  /* nothing to compare against, nothing to keep. */
+
+    if (!walkTreeReserve(w, &w->scratch, &w->scratchallocated, len))
+        return 0;
+
+    path = w->scratch;
+    memcpy(path, dir, dirlen);
+    if (dirlen != 0)
+        path[dirlen++] = '/';
+    strcpy(path + dirlen, name);
+
+    hash = __PHYSFS_hashString(path, strlen(path));
+    while ((idx = __PHYSFS_hashTableFind(&w->seenhash, hash, &probe)) != 0)
+    {
+        if (strcmp(w->seen.names + w->seen.offsets[idx - 1], path) == 0)
+            return 0;
+    } /* while */
+
+    if (w->remember)
+    {
+        addToStringList(&w->seen, path);
+        if ( (w->seen.errcode) ||
+             (!__PHYSFS_hashTableInsert(&w->seenhash, hash, w->seen.size)) )
+        {
+            w->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+            return 0;
+        } /* if */
+    } /* if */
+
+    return 1;
+} /* walkTreeFirstSighting */
+
+
+static void walkTreeCallback(void *_data, const char *origdir,
+                             const char *fname, const PHYSFS_Stat *stat)
+{
+    WalkTreeData *w = (WalkTreeData *) _data;
+
+    if (w->errcode)
+        return;
+
+    if ((!w->unique) || (walkTreeFirstSighting(w, origdir, fname)))
+        w->callback(w->callbackData, origdir, fname, stat);
+    else if (w->errcode)
+        return;
+
+    /* a dir seen in an earlier archive may still have new things in it. */
+    if (stat->filetype == PHYSFS_FILETYPE_DIRECTORY)
+    {
+        addToStringList(&w->pending, fname);
+        if (w->pending.errcode)
+            w->errcode = w->pending.errcode;
+    } /* if */
+} /* walkTreeCallback */
+
+
+/* Caller holds (w->dirhandle)'s lock. */
+static void walkTreeDir(WalkTreeData *w)
+{
+    const size_t pathlen = w->pathlen;
+    const PHYSFS_uint32 first = w->pending.size;
+    const char *arcfname = "";
+    PHYSFS_uint32 last;
+    PHYSFS_uint32 i;
+
+    if (pathlen > w->arcoffset)
+        arcfname = w->path + w->arcoffset;
+
+    enumerateStatFromDirHandle(w->dirhandle, arcfname, w->path, &w->statdata);
+
+    last = w->pending.size;
+    for (i = first; (i < last) && (!w->errcode); i++)
+    {
+        if (walkTreeAppend(w, w->pending.names + w->pending.offsets[i]))
+            walkTreeDir(w);
+        w->pathlen = pathlen;
+        w->path[pathlen] = '\0';
+    } /* for */
+
+    if (first < last)
+    {
+        w->pending.names_len = w->pending.offsets[first];
+        w->pending.size = first;
+    } /* if */
+} /* walkTreeDir */
+
+
+/* (root) is above (w->dirhandle)'s mount point: fake the dirs down to it. */
+static void walkTreeFromMountPoint(WalkTreeData *w, const char *root)
+{
+    const size_t rootlen = strlen(root);
+    const size_t slen = strlen(w->dirhandle->mountPoint) + 1;
+    char *mountPoint = (char *) __PHYSFS_smallAlloc(slen);
+    PHYSFS_Stat statbuf;
+    char *ptr;
+    char *end;
+
+    if (mountPoint == NULL)
+    {
+        w->errcode = PHYSFS_ERR_OUT_OF_MEMORY;
+        return;
+    } /* if */
+
+    statbuf.filesize = -1;
+    statbuf.modtime = -1;
+    statbuf.createtime = -1;
+    statbuf.accesstime = -1;
+    statbuf.filetype = PHYSFS_FILETYPE_DIRECTORY;
+    statbuf.readonly = 1;  /* !!! FIXME */
+
+    strcpy(mountPoint, w->dirhandle->mountPoint);
+    ptr = mountPoint + ((rootlen) ? rootlen + 1 : 0);
+    while ((!w->errcode) && ((end = strchr(ptr, '/')) != NULL))
+    {
+        *end = '\0';
+        if ((!w->unique) || (walkTreeFirstSighting(w, w->path, ptr)))
+            w->callback(w->callbackData, w->path, ptr, &statbuf);
+        if (!w->errcode)
+            walkTreeAppend(w, ptr);
+        ptr = end + 1;
+    } /* while */
+
+    __PHYSFS_smallFree(mountPoint);
+
+    if (!w->errcode)
+    {
+        lockDirHandle(w->dirhandle);
+        walkTreeDir(w);
+        unlockDirHandle(w->dirhandle);
+    } /* if */
+} /* walkTreeFromMountPoint */
+
+
+int PHYSFS_walkTree(const char *_root, PHYSFS_EnumFilesStatCallback callback,
+                    void *data, PHYSFS_uint32 flags)
+{
+    PHYSFS_Context *ctx = currentContext();
+    WalkTreeData w;
+    size_t len;
+    char *root;
+
+    BAIL_IF_MACRO(!_root, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    len = strlen(_root) + 1;
+    root = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!root, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (!sanitizePlatformIndependentPath(_root, root))
+    {
+        __PHYSFS_smallFree(root);
+        return 0;
+    } /* if */
+
+    memset(&w, '\0', sizeof (w));
+    w.callback = callback;
+    w.callbackData = data;
+    w.statdata.callback = walkTreeCallback;
+    w.statdata.callbackData = &w;
+    w.unique = ((flags & PHYSFS_WALK_UNIQUE) != 0);
+    w.statdata.typeonly = ((flags & PHYSFS_WALK_TYPES_ONLY) != 0);
+
+    if ((w.unique) && (!__PHYSFS_hashTableInit(&w.seenhash, 64)))
+        w.errcode = currentErrorCode();
+    else
+    {
+        DirHandle *i;
+        const int reader = beginSearchPathRead(ctx);
+        for (i = ctx->searchPath; (i != NULL) && (!w.errcode); i = i->next)
+        {
+            char *arcfname = root;
+            if (!routedTo(i, root))
+                continue;
+
+            w.dirhandle = w.statdata.dirhandle = i;
+            w.remember = ((w.unique) && (i->next != NULL));
+            w.arcoffset = (i->mountPoint) ? strlen(i->mountPoint) : 0;
+            w.pathlen = 0;
+            if (!walkTreeAppend(&w, root))
+                break;
+
+            if (partOfMountPoint(i, arcfname))
+                walkTreeFromMountPoint(&w, root);
+
+            else
+            {
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                    walkTreeDir(&w);
+                unlockDirHandle(i);
+            } /* else */
+        } /* for */
+        endSearchPathRead(ctx, reader);
+    } /* else */
+
+    __PHYSFS_hashTableDeinit(&w.seenhash);
+    allocator.Free(w.seen.names);
+    allocator.Free(w.seen.offsets);
+    allocator.Free(w.pending.names);
+    allocator.Free(w.pending.offsets);
+    allocator.Free(w.scratch);
+    allocator.Free(w.path);
+    __PHYSFS_smallFree(root);
+
+    BAIL_IF_MACRO(w.errcode, w.errcode, 0);
+    return 1;
+} /* PHYSFS_walkTree */
+
+
+int PHYSFS_exists(const char *fname)
+{
+    int retval;
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_STAT, fname, NULL, 0);
+    retval = (PHYSFS_getRealDir(fname) != NULL);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_STAT, fname, NULL, 0, retval);
+    return retval;
+} /* PHYSFS_exists */
+
+
+PHYSFS_sint64 PHYSFS_getLastModTime(const char *fname)
+{
+    PHYSFS_Stat statbuf;
+    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, -1);
+    return statbuf.modtime;
+} /* PHYSFS_getLastModTime */
+
+
+int PHYSFS_isDirectory(const char *fname)
+{
+    PHYSFS_Stat statbuf;
+    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, 0);
+    return (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY);
+} /* PHYSFS_isDirectory */
+
+
+int PHYSFS_isSymbolicLink(const char *fname)
+{
+    PHYSFS_Stat statbuf;
+    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, 0);
+    return (statbuf.filetype == PHYSFS_FILETYPE_SYMLINK);
+} /* PHYSFS_isSymbolicLink */
+
+
+/*
+ * Everything PHYSFS_openWriteAtomic() writes goes to a hidden file next to
+ *  where it belongs, named after it, and it's renamed into place when it's
+ *  closed, or by PHYSFS_commitAtomicWrites(). The DIR archiver is the only
+ *  one that can rename things, so that's the only kind of write dir this
+ *  works with.
+ *
+ * All of these need the write dir's context's lock held.
+ */
+static AtomicWrite *createAtomicWrite(const DirHandle *h, const char *fname,
+                                      const int flags)
+{
+    const char *base = strrchr(fname, '/');
+    const size_t dirlen = (base) ? ((size_t) (base - fname)) + 1 : 0;
+    const size_t len = strlen(fname) + 32;  /* ".", ".%u-%u.tmp", null. */
+    AtomicWrite *aw;
+
+    base = (base) ? base + 1 : fname;
+
+    aw = (AtomicWrite *) allocator.Malloc(sizeof (AtomicWrite));
+    BAIL_IF_MACRO(!aw, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(aw, '\0', sizeof (AtomicWrite));
+    aw->fname = __PHYSFS_strdup(fname);
+    aw->tmpname = (char *) allocator.Malloc(len);
+    if ((aw->fname == NULL) || (aw->tmpname == NULL))
+    {
+        allocator.Free(aw->fname);
+        allocator.Free(aw->tmpname);
+        allocator.Free(aw);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    /* the ticks keep other processes writing the same file out of our way. */
+    memcpy(aw->tmpname, fname, dirlen);
+    sprintf(aw->tmpname + dirlen, ".%s.%u-%u.tmp", base,
+             (unsigned int) ++atomicCounter,
+             (unsigned int) (__PHYSFS_platformGetTicks() & 0xFFFFFFFF));
+    aw->flags = flags;
+    aw->dirHandle = h;
+    return aw;
+} /* createAtomicWrite */
+
+
+static void freeAtomicWrite(AtomicWrite *aw)
+{
+    allocator.Free(aw->tmpname);
+    allocator.Free(aw->fname);
+    allocator.Free(aw);
+} /* freeAtomicWrite */
+
+
+/* Delete (aw)'s temp file, and forget about it. Errors are left alone. */
+static void abortAtomicWrite(AtomicWrite *aw)
+{
+    const PHYSFS_ErrorCode err = currentErrorCode();
+    const DirHandle *h = aw->dirHandle;
+    h->funcs->remove(h->opaque, aw->tmpname);
+    PHYSFS_setErrorCode(err);
+    freeAtomicWrite(aw);
+} /* abortAtomicWrite */
+
+
+/* Get (aw)'s data to the disk before it's closed, if that's asked for now. */
+static int syncAtomicWrite(const AtomicWrite *aw, PHYSFS_Io *io)
+{
+    if ((aw->flags & PHYSFS_ATOMIC_SYNC) && !(aw->flags & PHYSFS_ATOMIC_BATCH))
+        BAIL_IF_MACRO(io->flush && !io->flush(io), ERRPASS, 0);
+    return 1;
+} /* syncAtomicWrite */
+
+
+/*
+ * Sync the directory (fname) is in, in the DIR archiver (opaque), so files
+ *  created or renamed there are on the disk, too.
+ */
+static int syncParentDir(void *opaque, const char *fname)
+{
+    const char *sep = strrchr(fname, '/');
+    const size_t len = (sep) ? (size_t) (sep - fname) : 0;
+    char *dname = (char *) __PHYSFS_smallAlloc(len + 1);
+    int retval;
+
+    BAIL_IF_MACRO(!dname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memcpy(dname, fname, len);
+    dname[len] = '\0';
+    retval = __PHYSFS_DIR_sync(opaque, dname);
+    __PHYSFS_smallFree(dname);
+    return retval;
+} /* syncParentDir */
+
+
+/* Non-zero if (a) and (b) are in the same directory. */
+static int sameParentDir(const char *a, const char *b)
+{
+    const char *asep = strrchr(a, '/');
+    const char *bsep = strrchr(b, '/');
+    const size_t alen = (asep) ? (size_t) (asep - a) : 0;
+    const size_t blen = (bsep) ? (size_t) (bsep - b) : 0;
+    return ((alen == blen) && (memcmp(a, b, alen) == 0));
+} /* sameParentDir */
+
+
+/* Put (aw) where it belongs. If that fails, its temp file is deleted. */
+static int renameAtomicWrite(AtomicWrite *aw)
+{
+    const DirHandle *h = aw->dirHandle;
+    if (__PHYSFS_DIR_rename(h->opaque, aw->tmpname, aw->fname))
+        return 1;
+
+    aw->failed = 1;
+    h->funcs->remove(h->opaque, aw->tmpname);  /* error stays the rename's. */
+    return 0;
+} /* renameAtomicWrite */
+
+
+/* (aw)'s file was closed; rename it now, or save it for a batch. */
+static int finishAtomicWrite(AtomicWrite *aw)
+{
+    PHYSFS_Context *ctx = aw->dirHandle->ctx;
+    int retval;
+
+    if (aw->flags & PHYSFS_ATOMIC_BATCH)
+    {
+        aw->next = ctx->atomicPending;
+        ctx->atomicPending = aw;
+        return 1;
+    } /* if */
+
+    retval = renameAtomicWrite(aw);
+    if ((retval) && (aw->flags & PHYSFS_ATOMIC_SYNC))
+        retval = syncParentDir(aw->dirHandle->opaque, aw->fname);
+    freeAtomicWrite(aw);
+    return retval;
+} /* finishAtomicWrite */
+
+
+/* Throw away a batch nobody committed. Temp files are deleted. */
+static void discardAtomicWrites(PHYSFS_Context *ctx)
+{
+    while (ctx->atomicPending != NULL)
+    {
+        AtomicWrite *aw = ctx->atomicPending;
+        ctx->atomicPending = aw->next;
+        abortAtomicWrite(aw);
+    } /* while */
+} /* discardAtomicWrites */
+
+
+static PHYSFS_File *doOpenWrite(const char *_fname, int appending,
+                                int atomic, int atomicFlags)
+{
+    PHYSFS_Context *ctx = currentContext();
+    FileHandle *fh = NULL;
+    AtomicWrite *aw = NULL;
+    size_t len;
+    char *fname;
+
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (sanitizePlatformIndependentPath(_fname, fname))
+    {
+        PHYSFS_Io *io = NULL;
+        DirHandle *h = NULL;
+        const PHYSFS_Archiver *f;
+
+        grabLock(ctx->lock);
+
+        GOTO_IF_MACRO(!ctx->writeDir, PHYSFS_ERR_NO_WRITE_DIR, doOpenWriteEnd);
+
+        h = ctx->writeDir;
+        lockDirHandle(h);
+        GOTO_IF_MACRO(!verifyPath(h, &fname, 0), ERRPASS, doOpenWriteEnd);
+
+        f = h->funcs;
+        if (atomic)
+        {
+            GOTO_IF_MACRO(!h->native, PHYSFS_ERR_UNSUPPORTED, doOpenWriteEnd);
+            aw = createAtomicWrite(h, fname, atomicFlags);
+            GOTO_IF_MACRO(!aw, ERRPASS, doOpenWriteEnd);
+            io = f->openWrite(h->opaque, aw->tmpname);
+            if (io == NULL)
+            {
+                freeAtomicWrite(aw);
+                aw = NULL;
+            } /* if */
+        } /* if */
+        else if (appending)
+            io = f->openAppend(h->opaque, fname);
+        else
+            io = f->openWrite(h->opaque, fname);
+
+        bumpSearchGeneration(ctx);  /* the file might exist now. */
+        GOTO_IF_MACRO(!io, ERRPASS, doOpenWriteEnd);
+
+        fh = allocFileHandle(h);
+        if (fh == NULL)
+        {
+            io->destroy(io);
+            if (aw != NULL)
+                abortAtomicWrite(aw);
+            GOTO_MACRO(ERRPASS, doOpenWriteEnd);
+        } /* if */
+        else
+        {
+            fh->io = io;
+            fh->atomic = aw;
+            linkFileHandle(&ctx->openWriteList, fh);
+            __PHYSFS_STAT_INCR(opens);
+        } /* else */
+
+        doOpenWriteEnd:
+        if (h != NULL)
+            unlockDirHandle(h);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+    } /* if */
+
+    __PHYSFS_smallFree(fname);
+    return ((PHYSFS_File *) fh);
+} /* doOpenWrite */
+
+
+PHYSFS_File *PHYSFS_openWrite(const char *filename)
+{
+    return doOpenWrite(filename, 0, 0, 0);
+} /* PHYSFS_openWrite */
+
+
+PHYSFS_File *PHYSFS_openAppend(const char *filename)
+{
+    return doOpenWrite(filename, 1, 0, 0);
+} /* PHYSFS_openAppend */
+
+
+PHYSFS_File *PHYSFS_openWriteAtomic(const char *filename, PHYSFS_uint32 flags)
+{
+    const PHYSFS_uint32 known = PHYSFS_ATOMIC_SYNC | PHYSFS_ATOMIC_BATCH;
+    BAIL_IF_MACRO(flags & ~known, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    return doOpenWrite(filename, 0, 1, (int) flags);
+} /* PHYSFS_openWriteAtomic */
+
+
+int PHYSFS_commitAtomicWrites(void)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+    AtomicWrite *list = NULL;
+    AtomicWrite *aw;
+    AtomicWrite *i;
+
+    grabLock(ctx->lock);
+
+    /* pending is newest first; renames go oldest first, so the last wins. */
+    while (ctx->atomicPending != NULL)
+    {
+        aw = ctx->atomicPending;
+        ctx->atomicPending = aw->next;
+        aw->next = list;
+        list = aw;
+    } /* while */
+
+    /* everything's data goes to the disk before anything's renamed... */
+    for (aw = list; aw != NULL; aw = aw->next)
+    {
+        const DirHandle *h = aw->dirHandle;
+        if (!(aw->flags & PHYSFS_ATOMIC_SYNC))
+            continue;
+        else if (!__PHYSFS_DIR_sync(h->opaque, aw->tmpname))
+        {
+            if (err == PHYSFS_ERR_OK)
+                err = currentErrorCode();
+            aw->failed = 1;
+            h->funcs->remove(h->opaque, aw->tmpname);
+        } /* else if */
+    } /* for */
+
+    /* ...then it's all renamed... */
+    for (aw = list; aw != NULL; aw = aw->next)
+    {
+        if ((!aw->failed) && (!renameAtomicWrite(aw)) && (err == PHYSFS_ERR_OK))
+            err = currentErrorCode();
+    } /* for */
+
+    /* ...and each directory that changed is synced once. */
+    for (aw = list; aw != NULL; aw = aw->next)
+    {
+        if ((aw->failed) || !(aw->flags & PHYSFS_ATOMIC_SYNC))
+            continue;
+
+        for (i = list; i != aw; i = i->next)
+        {
+            if ((!i->failed) && (i->flags & PHYSFS_ATOMIC_SYNC) &&
+                (sameParentDir(i->fname, aw->fname)))
+                break;  /* already did this one. */
+        } /* for */
+
+        if ((i == aw) && (!syncParentDir(aw->dirHandle->opaque, aw->fname)))
+        {
+            if (err == PHYSFS_ERR_OK)
+                err = currentErrorCode();
+        } /* if */
+    } /* for */
+
+    while (list != NULL)
+    {
+        aw = list;
+        list = aw->next;
+        freeAtomicWrite(aw);
+    } /* while */
+
+    bumpSearchGeneration(ctx);  /* files moved around. */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+} /* PHYSFS_commitAtomicWrites */
+
+
+#define COPY_BUFSIZE (1024 * 1024)
+
+/*
+ * Copy all of (in), just opened for reading, to (out), just opened for
+ *  writing. Have the OS do it if both are native files (or (in) is stored
+ *  as-is in one), so the bytes don't pass through here at all; failing
+ *  that, write straight from a mapping of (in); failing that, read and
+ *  write it in big pieces.
+ */
+static int copyFileData(FileHandle *in, FileHandle *out)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    PHYSFS_FileBacking backing;
+    PHYSFS_uint8 *buf;
+    const void *ptr;
+    PHYSFS_uint64 len;
+    PHYSFS_sint64 rc = 0;
+
+    if ( (out->io->destroy == nativeIo_destroy) &&
+         (__PHYSFS_ioBacking(in->io, &backing)) )
+    {
+        void *dst = ((NativeIoInfo *) out->io->opaque)->handle;
+        PHYSFS_uint64 done = 0;
+
+        while (done < backing.length)
+        {
+            rc = __PHYSFS_platformCopyRange(&backing, backing.length - done,
+                                            dst);
+            if (rc <= 0)
+                break;
+            backing.offset += (PHYSFS_uint64) rc;
+            done += (PHYSFS_uint64) rc;
+        } /* while */
+
+        if (done == backing.length)
+            return 1;
+        BAIL_IF_MACRO(rc == 0, PHYSFS_ERR_IO, 0);  /* it got shorter? */
+        BAIL_IF_MACRO(done > 0, ERRPASS, 0);  /* too late to start over. */
+        BAIL_IF_MACRO(currentErrorCode() != PHYSFS_ERR_UNSUPPORTED,
+                      ERRPASS, 0);
+    } /* if */
+    PHYSFS_getLastErrorCode();  /* no such luck; that's fine. */
+    PHYSFS_setErrorCode(prevErr);
+
+    if (PHYSFS_mapRead((PHYSFS_File *) in, &ptr, &len))
+    {
+        rc = PHYSFS_writeBytes((PHYSFS_File *) out, ptr, len);
+        return (rc == (PHYSFS_sint64) len);
+    } /* if */
+    PHYSFS_getLastErrorCode();  /* not mapped; that's fine, too. */
+    PHYSFS_setErrorCode(prevErr);
+
+    buf = (PHYSFS_uint8 *) allocator.Malloc(COPY_BUFSIZE);
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    while ((rc = PHYSFS_readBytes((PHYSFS_File *) in, buf, COPY_BUFSIZE)) > 0)
+    {
+        if (PHYSFS_writeBytes((PHYSFS_File *) out, buf,
+                              (PHYSFS_uint64) rc) != rc)
+        {
+            rc = -1;
+            break;
+        } /* if */
+    } /* while */
+    allocator.Free(buf);
+
+    return (rc == 0);
+} /* copyFileData */
+
+
+int PHYSFS_copyFile(const char *src, const char *dst)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_File *in;
+    PHYSFS_File *out;
+    int atomic = 1;
+
+    BAIL_IF_MACRO(!src, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!dst, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    in = PHYSFS_openRead(src);
+    BAIL_IF_MACRO(!in, ERRPASS, 0);
+
+    /* into a temp file, so (dst) can be (src), and is never half there. */
+    out = doOpenWrite(dst, 0, 1, 0);
+    if ((out == NULL) && (currentErrorCode() == PHYSFS_ERR_UNSUPPORTED))
+    {
+        atomic = 0;  /* the write dir is an archive; just write it. */
+        out = doOpenWrite(dst, 0, 0, 0);
+    } /* if */
+
+    if (out == NULL)
+    {
+        PHYSFS_close(in);
+        BAIL_MACRO(ERRPASS, 0);
+    } /* if */
+
+    if (!copyFileData((FileHandle *) in, (FileHandle *) out))
+    {
+        PHYSFS_close(in);
+        grabLock(ctx->lock);
+        discardFileHandle((FileHandle *) out);
+        bumpSearchGeneration(ctx);  /* its temp file came and went. */
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+        if (!atomic)  /* don't leave a piece of it behind. */
+        {
+            const PHYSFS_ErrorCode err = currentErrorCode();
+            PHYSFS_delete(dst);
+            PHYSFS_setErrorCode(err);
+        } /* if */
+        return 0;
+    } /* if */
+
+    PHYSFS_close(in);
+    return PHYSFS_close(out);
+} /* PHYSFS_copyFile */
+
+
+struct PHYSFS_Entry
+{
+    PHYSFS_uint32 serial;  /* DirHandle::serial of the archive it's in. */
+    size_t rank;  /* Where that was in the search path. Just a hint. */
+    int mountPointDir;  /* Non-zero if only a dir leading to a mountpoint. */
+    char *arcfname;  /* The path in the archive. Points into (path). */
+    char *path;  /* Sanitized. Allocated along with this struct. */
+};
+
+
+static DirHandle *findEntryHandle(PHYSFS_Context *ctx,
+                                  const PHYSFS_Entry *entry);
+
+/*
+ * (fname) is (_fname), already sanitized, in a buffer we can scribble on,
+ *  or NULL if it didn't sanitize. (hash) is hashIndexPath(fname). If
+ *  (entry) isn't NULL, it says where the file is, and (fname) is ignored.
+ *  The search path is (ctx)'s.
+ */
+/* What's in front of a slurped file's contents, so they can be freed. */
+typedef struct
+{
+    __PHYSFS_MemAccount *acct;  /* the mount's; it outlives open files. */
+    size_t len;  /* what __PHYSFS_poolAlloc() was asked for. */
+} SlurpHeader;
+
+static void freeSlurped(void *buf)
+{
+    SlurpHeader *hdr = ((SlurpHeader *) buf) - 1;
+    __PHYSFS_memCharge(hdr->acct, PHYSFS_MEMORY_BUFFERS,
+                       -((PHYSFS_sint64) hdr->len));
+    __PHYSFS_poolFree(hdr, hdr->len);
+} /* freeSlurped */
+
+
+/*
+ * If (fh), just opened, is within PHYSFS_setSlurpOnOpen()'s limit, read
+ *  all of it into memory and read from there instead, closing what the
+ *  archiver opened (a native file's descriptor, a decompressor). Small
+ *  buffers come from __PHYSFS_poolAlloc(), so opening one small file after
+ *  another reuses them. If it can't, (fh) is left as it was, without an
+ *  error; the open worked regardless.
+ */
+static void slurpOpened(FileHandle *fh)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    PHYSFS_Io *io = fh->io;
+    PHYSFS_Io *memio = NULL;
+    PHYSFS_uint8 *buf = NULL;
+    SlurpHeader *hdr = NULL;
+    PHYSFS_uint64 got = 0;
+    PHYSFS_sint64 flen;
+    size_t len;
+
+    if (io->read == memoryIo_read)
+        return;  /* pinned, or otherwise already in memory. */
+
+    flen = io->length(io);
+    if ((flen < 0) || ((PHYSFS_uint64) flen > slurpLimit) ||
+        ((PHYSFS_uint64) flen != (size_t) flen))
+        return;
+
+    len = sizeof (SlurpHeader) + (size_t) flen;
+    if (__PHYSFS_memAllowed(PHYSFS_MEMORY_BUFFERS, (PHYSFS_uint64) len))
+        hdr = (SlurpHeader *) __PHYSFS_poolAlloc(len);
+    GOTO_IF_MACRO(!hdr, ERRPASS, slurpOpened_failed);
+    hdr->acct = fh->dirHandle->mem;
+    hdr->len = len;
+    buf = (PHYSFS_uint8 *) (hdr + 1);
+
+    while (got < (PHYSFS_uint64) flen)
+    {
+        const PHYSFS_sint64 rc = __PHYSFS_ioReadAt(io, buf + got,
+                                                   flen - got, got);
+        GOTO_IF_MACRO(rc <= 0, ERRPASS, slurpOpened_failed);
+        got += (PHYSFS_uint64) rc;
+    } /* while */
+
+    memio = __PHYSFS_createMemoryIo(buf, (PHYSFS_uint64) flen, freeSlurped);
+    GOTO_IF_MACRO(!memio, ERRPASS, slurpOpened_failed);
+    __PHYSFS_memCharge(hdr->acct, PHYSFS_MEMORY_BUFFERS, (PHYSFS_sint64) len);
+
+    io->destroy(io);
+    fh->io = memio;
+    allocator.Free(fh->keep.path);  /* there's no native handle to keep. */
+    fh->keep.path = NULL;
+    return;
+
+slurpOpened_failed:
+    __PHYSFS_poolFree(hdr, len);
+    PHYSFS_getLastErrorCode();  /* the archiver's Io will do. */
+    PHYSFS_setErrorCode(prevErr);
+} /* slurpOpened */
+
+
+static PHYSFS_File *doOpenRead(PHYSFS_Context *ctx, const char *_fname,
+                               char *fname, const PHYSFS_uint32 hash,
+                               const PHYSFS_Entry *entry)
+{
+    const PHYSFS_uint64 start = timingLatency ? __PHYSFS_platformGetTicks() : 0;
+    FileHandle *fh = NULL;
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_OPENREAD, _fname, NULL, 0);
+
+    if ((fname != NULL) || (entry != NULL))
+    {
+        DirHandle *i = NULL;
+        PHYSFS_Io *io = NULL;
+        char *arcfname = NULL;
+        CachedHandle keep;
+        SearchPathIter iter;
+        const int generation = ctx->searchGeneration;
+        const int reader = beginSearchPathRead(ctx);
+
+        if (entry != NULL)
+        {
+            i = findEntryHandle(ctx, entry);
+            GOTO_IF_MACRO(!i, ERRPASS, openReadEnd);
+            GOTO_IF_MACRO(entry->mountPointDir, PHYSFS_ERR_NOT_A_FILE,
+                          openReadEnd);
+            arcfname = entry->arcfname;
+            lockDirHandle(i);
+            io = openReadKept(i, arcfname, &keep);
+            unlockDirHandle(i);
+        } /* if */
+
+        else
+        {
+            GOTO_IF_MACRO(!ctx->searchPath, PHYSFS_ERR_NOT_FOUND,
+                          openReadEnd);
+            GOTO_IF_MACRO(knownMissing(ctx, fname, hash, generation),
+                          ERRPASS, openReadEnd);
+
+            i = firstCandidate(ctx, &iter, fname, hash);
+            for (; i != NULL; i = nextCandidate(&iter))
+            {
+                arcfname = fname;
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                    io = openReadKept(i, arcfname, &keep);
+                unlockDirHandle(i);
+                if (io)
+                    break;
+            } /* for */
+
+            if (!io)
+                rememberMissing(ctx, fname, hash, generation);
+        } /* else */
+
+        GOTO_IF_MACRO(!io, ERRPASS, openReadEnd);
+
+        fh = allocFileHandle(i);
+        if (fh == NULL)
+        {
+            io->destroy(io);
+            allocator.Free(keep.path);
+            GOTO_MACRO(ERRPASS, openReadEnd);
+        } /* if */
+
+        fh->io = io;
+        fh->forReading = 1;
+        fh->keep = keep;
+
+        if (slurpLimit > 0)
+            slurpOpened(fh);
+
+        if (i->accessHint != PHYSFS_ACCESS_NORMAL)
+        {
+            /* just a hint; the open worked regardless. */
+            const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+            __PHYSFS_ioAdvise(io, 0, 0, i->accessHint);
+            PHYSFS_setErrorCode(prevErr);
+        } /* if */
+
+        if (__PHYSFS_tracing)  /* if this fails, events just lack a path. */
+        {
+            const size_t len = strlen(_fname) + 1;
+            fh->tracePath = (char *) allocator.Malloc(len);
+            if (fh->tracePath != NULL)
+                memcpy(fh->tracePath, _fname, len);
+        } /* if */
+
+        /* (i) can't be closed until we stop reading, even if unmounted. */
+        if ((ctx->frozen) && (!profiling))
+        {
+            fh->list = &ctx->frozenReadList;  /* nothing can unmount (i). */
+            __PHYSFS_ATOMIC_INCR(&ctx->frozenOpenFiles);
+        } /* if */
+        else
+        {
+            grabLock(ctx->lock);
+            linkFileHandle(&ctx->openReadList, fh);
+            if (profiling)
+                profileOpen(fh, i, arcfname);
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+        } /* else */
+
+        openReadEnd:
+        endSearchPathRead(ctx, reader);
+    } /* if */
+
+    if (fh != NULL)
+        __PHYSFS_STAT_INCR(opens);
+    else if (currentErrorCode() == PHYSFS_ERR_NOT_FOUND)
+        __PHYSFS_STAT_INCR(openMisses);
+
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_OPENREAD, _fname, (PHYSFS_File *) fh,
+                       0, fh != NULL);
+    if (timingLatency)
+    {
+        recordLatency(PHYSFS_LATENCY_OPENREAD, fh ? fh->dirHandle : NULL,
+                      start);
+    } /* if */
+    return ((PHYSFS_File *) fh);
+} /* doOpenRead */
+
+
+static PHYSFS_File *openRead(PHYSFS_Context *ctx, const char *_fname)
+{
+    PHYSFS_File *retval;
+    char *fname;
+    size_t len;
+
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    if (sanitizePlatformIndependentPath(_fname, fname))
+        retval = doOpenRead(ctx, _fname, fname, hashIndexPath(fname), NULL);
+    else
+        retval = doOpenRead(ctx, _fname, NULL, 0, NULL);
+
+    __PHYSFS_smallFree(fname);
+    return retval;
+} /* openRead */
+
+
+static void predictOpened(PHYSFS_Context *ctx, const char *_fname);
+
+PHYSFS_File *PHYSFS_openRead(const char *_fname)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_File *retval = openRead(ctx, _fname);
+    if ((retval != NULL) && (predictQueue != NULL))
+        predictOpened(ctx, _fname);
+    return retval;
+} /* PHYSFS_openRead */
+
+
+PHYSFS_File *PHYSFS_openReadInterned(const PHYSFS_Path *path)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_File *retval;
+    char *fname;
+
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    fname = (char *) __PHYSFS_smallAlloc(path->len + 1);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    /* a copy, since verifyPath() writes to it, and (path) can be shared. */
+    memcpy(fname, path->path, path->len + 1);
+    retval = doOpenRead(ctx, path->path, fname, path->hash, NULL);
+
+    __PHYSFS_smallFree(fname);
+    if ((retval != NULL) && (predictQueue != NULL))
+        predictOpened(ctx, path->path);
+    return retval;
+} /* PHYSFS_openReadInterned */
+
+
+/*
+ * Close (handle), a file open for writing. MAKE SURE you hold its context's
+ *  lock! -1 == close failure, so it's still open. 1 == success.
+ *  -2 == closed, but PHYSFS_openWriteAtomic()'s rename failed.
+ */
+static int closeWriteHandle(FileHandle *handle)
+{
+    PHYSFS_Io *io = handle->io;
+    AtomicWrite *atomic = handle->atomic;
+
+    if (!PHYSFS_flush((PHYSFS_File *) handle))
+        return -1;
+    if ((atomic != NULL) && (!syncAtomicWrite(atomic, io)))
+        return -1;
+    freeWriteBehind(handle);
+    io->destroy(io);
+
+    /* free any associated buffer. */
+    freeFileBuffer(handle->dirHandle->mem, handle->buffer, handle->bufsize);
+    allocator.Free(handle->tracePath);
+    unlinkFileHandle(handle);
+    freeFileHandle(handle);
+
+    /* it's closed either way, but it might not be where it goes. */
+    if ((atomic != NULL) && (!finishAtomicWrite(atomic)))
+        return -2;
+    return 1;
+} /* closeWriteHandle */
+
+
+/*
+ * Let go of everything (handle), a file open for reading, has but the
+ *  FileHandle itself. Its DirHandle can't go away while it's still in
+ *  openReadList, so this doesn't need its context's lock.
+ */
+static void releaseReadHandle(FileHandle *handle)
+{
+    freeReadAhead(handle);
+    if (handle->keep.path != NULL)
+        keepReadHandle((DirHandle *) handle->dirHandle, &handle->keep,
+                       handle->io);
+    else
+        handle->io->destroy(handle->io);
+    freeFileBuffer(handle->dirHandle->mem, handle->buffer, handle->bufsize);
+    allocator.Free(handle->tracePath);
+} /* releaseReadHandle */
+
+
+int PHYSFS_close(PHYSFS_File *_handle)
+{
+    FileHandle *handle = (FileHandle *) _handle;
+    PHYSFS_Context *ctx;
+    int rc;
+
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    ctx = handle->dirHandle->ctx;
+    if (handle->list == &ctx->frozenReadList)  /* never linked; no lock. */
+    {
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_CLOSE, NULL, _handle, 0);
+        releaseReadHandle(handle);
+        freeFileHandle(handle);
+        __PHYSFS_ATOMIC_DECR(&ctx->frozenOpenFiles);
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_CLOSE, NULL, _handle, 0, 1);
+        return 1;
+    } /* if */
+
+    grabLock(ctx->lock);
+    if (handle->list == &ctx->openReadList)
+    {
+        /* the slow part (joining readahead, closing fds) goes unlocked. */
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_CLOSE, NULL, _handle, 0);
+        releaseReadHandle(handle);
+        grabLock(ctx->lock);
+        unlinkFileHandle(handle);
+        freeFileHandle(handle);
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_CLOSE, NULL, _handle, 0, 1);
+    } /* if */
+    else if (handle->list == &ctx->openWriteList)
+    {
+        const DirHandle *dh = handle->dirHandle;  /* (handle) gets freed. */
+        lockDirHandle(dh);
+        rc = closeWriteHandle(handle);
+        unlockDirHandle(dh);
+        BAIL_IF_MACRO_MUTEX(rc == -1, ERRPASS, ctx->lock, 0);
+        bumpSearchGeneration(ctx);  /* listings have its size from before. */
+        BAIL_IF_MACRO_MUTEX(rc == -2, ERRPASS, ctx->lock, 0);
+    } /* else if */
+    else
+    {
+        BAIL_MACRO_MUTEX(PHYSFS_ERR_INVALID_ARGUMENT, ctx->lock, 0);
+    } /* else */
+
+    /* this might have been the last file in an unmounted archive. */
+    if (ctx->retiredDirHandles != NULL)
+        reclaimRetired(ctx);
+
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+    return 1;
+} /* PHYSFS_close */
+
+
+static PHYSFS_sint64 doAdaptiveRead(FileHandle *fh, void *buffer,
+                                    PHYSFS_uint64 len);
+static PHYSFS_uint64 readAheadBytes(FileHandle *fh);
+static void dropReadAhead(FileHandle *fh);
+
+static PHYSFS_sint64 doBufferedRead(FileHandle *fh, void *buffer,
+                                    PHYSFS_uint64 len)
+{
+    PHYSFS_Io *io = NULL;
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_uint64 buffered = 0;
+    PHYSFS_sint64 rc = 0;
+
+    if (len == 0)
+        return 0;
+
+    buffered = fh->buffill - fh->bufpos;
+    if (buffered >= len)  /* totally in the buffer, just copy and return! */
+    {
+        memcpy(buffer, fh->buffer + fh->bufpos, (size_t) len);
+        fh->bufpos += len;
+        return (PHYSFS_sint64) len;
+    } /* if */
+
+    else if (buffered > 0) /* partially in the buffer... */
+    {
+        memcpy(buffer, fh->buffer + fh->bufpos, (size_t) buffered);
+        buffer = ((PHYSFS_uint8 *) buffer) + buffered;
+        len -= buffered;
+        retval = (PHYSFS_sint64) buffered;
+    } /* if */
+
+    /* if you got here, the buffer is drained and we still need bytes. */
+    assert(len > 0);
+
+    fh->buffill = fh->bufpos = 0;
+
+    io = fh->io;
+    if (len >= fh->bufsize)  /* need more than the buffer takes. */
+    {
+        /* leave buffer empty, go right to output instead. */
+        rc = io->read(io, buffer, len);
+        if (rc < 0)
+            return ((retval == 0) ? rc : retval);
+        return retval + rc;
+    } /* if */
+
+    /* need less than buffer can take. Fill buffer. */
+    rc = io->read(io, fh->buffer, fh->bufsize);
+    if (rc <= 0)  /* error or EOF; don't recurse forever on an empty fill. */
+        return ((retval == 0) ? rc : retval);
+
+    assert(fh->bufpos == 0);
+    fh->buffill = (PHYSFS_uint64) rc;
+    rc = doBufferedRead(fh, buffer, len);  /* go from the start, again. */
+    if (rc < 0)
+        return ((retval == 0) ? rc : retval);
+
+    return retval + rc;
+} /* doBufferedRead */
+
+
+PHYSFS_sint64 PHYSFS_read(PHYSFS_File *handle, void *buffer,
+                          PHYSFS_uint32 size, PHYSFS_uint32 count)
+{
+    const PHYSFS_uint64 len = ((PHYSFS_uint64) size) * ((PHYSFS_uint64) count);
+    const PHYSFS_sint64 retval = PHYSFS_readBytes(handle, buffer, len);
+    return ( (retval <= 0) ? retval : (retval / ((PHYSFS_sint64) size)) );
+} /* PHYSFS_read */
+
+
+PHYSFS_sint64 PHYSFS_readBytes(PHYSFS_File *handle, void *buffer,
+                               PHYSFS_uint64 len)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_uint64 start = 0;
+    PHYSFS_sint64 pos = -1;
+    PHYSFS_sint64 retval;
+
+#ifdef PHYSFS_NO_64BIT_SUPPORT
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
+#else
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
+#endif
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    BAIL_IF_MACRO(len > maxlen, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+    BAIL_IF_MACRO(len == 0, ERRPASS, 0);
+
+    if (profiling)
+        pos = PHYSFS_tell(handle);
+
+    if (timingLatency)
+        start = __PHYSFS_platformGetTicks();
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_READ, NULL, handle, len);
+
+    if ((fh->bufmax) || (fh->buffer))
+    {
+        if (fh->buffill - fh->bufpos >= len)
+            __PHYSFS_STAT_INCR(bufferHits);
+        else
+            __PHYSFS_STAT_INCR(bufferMisses);
+    } /* if */
+
+    if (fh->bufmax)
+        retval = doAdaptiveRead(fh, buffer, len);
+    else if (fh->buffer)
+        retval = doBufferedRead(fh, buffer, len);
+    else
+        retval = fh->io->read(fh->io, buffer, len);
+
+    if (retval > 0)
+    {
+        __PHYSFS_STAT_ADD(bytesRead, retval);
+        if (pos >= 0)
+            profileRead(fh, (PHYSFS_uint64) pos, (PHYSFS_uint64) retval);
+    } /* if */
+
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_READ, NULL, handle, retval, retval >= 0);
+    if (start != 0)
+        recordLatency(PHYSFS_LATENCY_READ, fh->dirHandle, start);
+    return retval;
+} /* PHYSFS_readBytes */
+
+
+PHYSFS_sint64 PHYSFS_readv(PHYSFS_File *handle, const PHYSFS_IoVec *iov,
+                           PHYSFS_uint32 count)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_uint64 total = 0;
+    PHYSFS_uint32 i;
+
+#ifdef PHYSFS_NO_64BIT_SUPPORT
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
+#else
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
+#endif
+
+    BAIL_IF_MACRO(!fh, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO((!iov) && (count > 0), PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_uint64 len = iov[i].len;
+        BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(len),
+                      PHYSFS_ERR_INVALID_ARGUMENT, -1);
+        BAIL_IF_MACRO(len > maxlen - total, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+        total += len;
+    } /* for */
+
+    BAIL_IF_MACRO(total == 0, ERRPASS, 0);
+
+    if ((fh->buffer == NULL) && (!fh->bufmax))
+    {
+        const PHYSFS_sint64 pos = profiling ? fh->io->tell(fh->io) : -1;
+        __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_READ, NULL, handle, total);
+        retval = __PHYSFS_ioReadv(fh->io, iov, count);
+        if (retval > 0)
+        {
+            __PHYSFS_STAT_ADD(bytesRead, retval);
+            if (pos >= 0)
+                profileRead(fh, (PHYSFS_uint64) pos, (PHYSFS_uint64) retval);
+        } /* if */
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_READ, NULL, handle, retval,
+                           retval >= 0);
+        return retval;
+    } /* if */
+
+    /* buffered: let the buffer soak up the small pieces. */
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_sint64 rc = PHYSFS_readBytes(handle, iov[i].buf,
+                                                  iov[i].len);
+        if (rc < 0)
+            return (retval == 0) ? -1 : retval;
+        retval += rc;
+        if (((PHYSFS_uint64) rc) < iov[i].len)
+            break;  /* EOF. */
+    } /* for */
+
+    return retval;
+} /* PHYSFS_readv */
+
+
+/* What PHYSFS_readFile() starts with when a file's length is unknown. */
+#define READFILE_UNKNOWN_LEN_START (64 * 1024)
+
+int PHYSFS_readFile(const char *filename, void **buf, PHYSFS_uint64 *len)
+{
+    PHYSFS_File *handle = NULL;
+    PHYSFS_uint8 *data = NULL;
+    PHYSFS_uint64 total = 0;
+    PHYSFS_uint64 avail = 0;
+    PHYSFS_uint64 maplen = 0;
+    const void *mapped = NULL;
+    PHYSFS_ErrorCode prevErr;
+    PHYSFS_sint64 filelen;
+    PHYSFS_Io *io;
+
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    *buf = NULL;
+    if (len != NULL)
+        *len = 0;
+
+    handle = PHYSFS_openRead(filename);
+    BAIL_IF_MACRO(!handle, ERRPASS, 0);
+    io = ((FileHandle *) handle)->io;  /* unbuffered; skip the middleman. */
+
+    filelen = io->length(io);
+    if (filelen >= 0)
+        avail = (PHYSFS_uint64) filelen;
+    else
+        avail = READFILE_UNKNOWN_LEN_START;
+
+    GOTO_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(avail + 1),
+                  PHYSFS_ERR_OUT_OF_MEMORY, readFileFailed);
+    data = (PHYSFS_uint8 *) allocator.Malloc((size_t) (avail + 1));
+    GOTO_IF_MACRO(!data, PHYSFS_ERR_OUT_OF_MEMORY, readFileFailed);
+
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_READ, NULL, handle,
+                         (PHYSFS_sint64) avail);
+
+    /* data already in memory (mapped files, cached entries) is one copy. */
+    prevErr = PHYSFS_getLastErrorCode();
+    if ((filelen >= 0) && (__PHYSFS_ioMap(io, &mapped, &maplen)) &&
+        (maplen == (PHYSFS_uint64) filelen))
+    {
+        memcpy(data, mapped, (size_t) maplen);
+        total = maplen;
+    } /* if */
+
+    else
+    {
+        PHYSFS_getLastErrorCode();  /* a failed map is no error. */
+        PHYSFS_setErrorCode(prevErr);
+
+        /*
+         * Ask for everything at once; ZIP entries inflate in one shot that
+         *  way. Keep going on short reads until EOF, growing the buffer if
+         *  we didn't know how big the file was.
+         */
+        while (1)
+        {
+            PHYSFS_sint64 rc;
+
+            if (total == avail)
+            {
+                void *ptr;
+                if (filelen >= 0)
+                    break;  /* got it all. */
+                GOTO_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(avail * 2 + 1),
+                              PHYSFS_ERR_OUT_OF_MEMORY, readFileFailed);
+                ptr = allocator.Realloc(data, (size_t) (avail * 2 + 1));
+                GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, readFileFailed);
+                data = (PHYSFS_uint8 *) ptr;
+                avail *= 2;
+            } /* if */
+
+            rc = io->read(io, data + total, avail - total);
+            GOTO_IF_MACRO(rc < 0, ERRPASS, readFileFailed);
+            if (rc == 0)
+                break;  /* EOF (early, if the file shrank). */
+            total += (PHYSFS_uint64) rc;
+        } /* while */
+    } /* else */
+
+    if (profiling)
+        profileRead((FileHandle *) handle, 0, total);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_READ, NULL, handle,
+                       (PHYSFS_sint64) total, 1);
+    PHYSFS_close(handle);
+    __PHYSFS_STAT_ADD(bytesRead, total);
+    data[total] = '\0';
+    *buf = data;
+    if (len != NULL)
+        *len = total;
+    return 1;
+
+readFileFailed:
+    if (data != NULL)  /* got as far as reading? */
+    {
+        __PHYSFS_TRACE_END(PHYSFS_TRACE_READ, NULL, handle, -1, 0);
+        allocator.Free(data);
+    } /* if */
+    PHYSFS_close(handle);
+    return 0;
+} /* PHYSFS_readFile */
+
+
+int PHYSFS_mapRead(PHYSFS_File *handle, const void **ptr, PHYSFS_uint64 *len)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    BAIL_IF_MACRO(!fh || !ptr || !len, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, 0);
+    readAheadBytes(fh);  /* don't map under a background read. */
+    return __PHYSFS_ioMap(fh->io, ptr, len);
+} /* PHYSFS_mapRead */
+
+
+int PHYSFS_getFileBacking(PHYSFS_File *handle, PHYSFS_FileBacking *backing)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    BAIL_IF_MACRO(!fh || !backing, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, 0);
+    return __PHYSFS_ioBacking(fh->io, backing);
+} /* PHYSFS_getFileBacking */
+
+
+PHYSFS_File *PHYSFS_openReadRaw(const char *filename,
+                                PHYSFS_Encoding *encoding)
+{
+    PHYSFS_ErrorCode prevErr;
+    FileHandle *fh;
+    PHYSFS_Io *raw;
+    int enc = (int) PHYSFS_ENCODING_IDENTITY;
+
+    BAIL_IF_MACRO(!encoding, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    fh = (FileHandle *) PHYSFS_openRead(filename);
+    BAIL_IF_MACRO(!fh, ERRPASS, NULL);
+
+    /* nothing's been read or buffered yet, so just swap in the raw io. */
+    prevErr = PHYSFS_getLastErrorCode();
+    raw = __PHYSFS_ioRaw(fh->io, &enc);
+    if (raw == NULL)
+    {
+        PHYSFS_getLastErrorCode();  /* no compressed form; that's fine. */
+        PHYSFS_setErrorCode(prevErr);
+        enc = (int) PHYSFS_ENCODING_IDENTITY;
+    } /* if */
+    else
+    {
+        fh->io->destroy(fh->io);
+        fh->io = raw;
+        allocator.Free(fh->keep.path);  /* (raw) isn't what would be kept. */
+        fh->keep.path = NULL;
+    } /* else */
+
+    *encoding = (PHYSFS_Encoding) enc;
+    return (PHYSFS_File *) fh;
+} /* PHYSFS_openReadRaw */
+
+
+PHYSFS_sint64 PHYSFS_readAt(PHYSFS_File *handle, void *buffer,
+                            PHYSFS_uint64 len, PHYSFS_uint64 offset)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_sint64 retval;
+
+#ifdef PHYSFS_NO_64BIT_SUPPORT
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
+#else
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
+#endif
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    BAIL_IF_MACRO(len > maxlen, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
+    BAIL_IF_MACRO(len == 0, ERRPASS, 0);
+
+    /*
+     * This bypasses fh->buffer entirely: the buffer only holds data from the
+     *  sequential position, and files opened for reading never change, so
+     *  there's nothing in it we could be out of sync with.
+     */
+    __PHYSFS_TRACE_BEGIN_AT(PHYSFS_TRACE_READ, handle, len,
+                            (PHYSFS_sint64) offset);
+    retval = __PHYSFS_ioReadAt(fh->io, buffer, len, offset);
+    if (retval > 0)
+    {
+        __PHYSFS_STAT_ADD(bytesRead, retval);
+        if (profiling)
+            profileRead(fh, offset, (PHYSFS_uint64) retval);
+    } /* if */
+    __PHYSFS_TRACE_END_AT(PHYSFS_TRACE_READ, handle, retval,
+                          (PHYSFS_sint64) offset, retval >= 0);
+    return retval;
+} /* PHYSFS_readAt */
+
+
+/*
+ * Is (io) a file stored as it is in an archive? If so, say where, like
+ *  __PHYSFS_zipGetStoredSpan() and friends do.
+ */
+static int ioGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len)
+{
+    if (__PHYSFS_unpkGetStoredSpan(io, archive, src, pos, len))
+        return 1;
+#if PHYSFS_SUPPORTS_ZIP
+    if (__PHYSFS_zipGetStoredSpan(io, archive, src, pos, len))
+        return 1;
+#endif
+#if PHYSFS_SUPPORTS_RAS
+    if (__PHYSFS_rasGetStoredSpan(io, archive, src, pos, len))
+        return 1;
+#endif
+#if PHYSFS_SUPPORTS_PPK
+    if (__PHYSFS_ppkGetStoredSpan(io, archive, src, pos, len))
+        return 1;
+#endif
+#if PHYSFS_SUPPORTS_7Z
+    if (__PHYSFS_lzmaGetStoredSpan(io, archive, src, pos, len))
+        return 1;
+#endif
+    return 0;
+} /* ioGetStoredSpan */
+
+
+/*
+ * Tasks are PhysicsFS's own parallel work: parsing a big ZIP directory,
+ *  mounting several archives at once, deflating a big write. They go to
+ *  the app's executor, from PHYSFS_setExecutor(), or else to our pool of
+ *  TASK_POOL_THREADS threads, started as they're needed. Whoever waits for
+ *  a task that hasn't started yet runs it itself instead, so a task never
+ *  waits for a thread that's busy waiting for it, and an executor that's
+ *  slow to get to one only costs the parallelism.
+ */
+#define TASK_POOL_THREADS 8
+
+typedef enum
+{
+    TASK_QUEUED,
+    TASK_RUNNING,
+    TASK_DONE
+} TaskState;
+
+typedef struct __PHYSFS_TASK__
+{
+    void (*fn)(void *);
+    void *data;
+    TaskState state;  /* taskLock guards this and (refcount). */
+    int refcount;  /* the waiter's, and the executor's until it's run it. */
+    void *done;  /* semaphore; posted if someone else ran it. */
+    struct __PHYSFS_TASK__ *next;  /* in the pool's queue. */
+} Task;
+
+static Task *taskHead = NULL;  /* the pool's queue; taskLock guards it. */
+static Task *taskTail = NULL;
+static PHYSFS_uint32 taskQueued = 0;
+static void *taskPending = NULL;  /* semaphore; one post per queued task. */
+static void *taskThreads[TASK_POOL_THREADS];
+static PHYSFS_uint32 taskNumThreads = 0;
+static PHYSFS_uint32 taskIdle = 0;  /* pool threads with nothing to do. */
+static int taskQuit = 0;
+
+/* Let go of a reference to (task). Call with taskLock held. */
+static void releaseTask(Task *task)
+{
+    if (--task->refcount == 0)
+    {
+        __PHYSFS_platformDestroySemaphore(task->done);
+        allocator.Free(task);
+    } /* if */
+} /* releaseTask */
+
+
+/* What the executor runs: (data)'s task, unless its waiter got to it. */
+static void runTask(void *data)
+{
+    Task *task = (Task *) data;
+    int run;
+
+    __PHYSFS_platformGrabMutex(taskLock);
+    run = (task->state == TASK_QUEUED);
+    if (run)
+        task->state = TASK_RUNNING;
+    __PHYSFS_platformReleaseMutex(taskLock);
+
+    if (run)
+        task->fn(task->data);
+
+    __PHYSFS_platformGrabMutex(taskLock);
+    if (run)
+    {
+        task->state = TASK_DONE;
+        __PHYSFS_platformPostSemaphore(task->done);
+    } /* if */
+    releaseTask(task);
+    __PHYSFS_platformReleaseMutex(taskLock);
+} /* runTask */
+
+
+static void taskPoolWorker(void *unused)
+{
+    while (1)
+    {
+        Task *task;
+
+        __PHYSFS_platformWaitSemaphore(taskPending);
+        __PHYSFS_platformGrabMutex(taskLock);
+        task = taskHead;
+        if ((task == NULL) && (taskQuit))
+        {
+            __PHYSFS_platformReleaseMutex(taskLock);
+            break;
+        } /* if */
+
+        if (task != NULL)
+        {
+            taskHead = task->next;
+            if (taskHead == NULL)
+                taskTail = NULL;
+            taskQueued--;
+            taskIdle--;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(taskLock);
+
+        if (task != NULL)
+        {
+            runTask(task);
+            __PHYSFS_platformGrabMutex(taskLock);
+            taskIdle++;
+            __PHYSFS_platformReleaseMutex(taskLock);
+        } /* if */
+    } /* while */
+} /* taskPoolWorker */
+
+
+/* Queue (task) for our pool, starting a thread if it's needed and there's
+ *  room. Returns zero if there are no threads to run it. */
+static int submitPoolTask(Task *task)
+{
+    __PHYSFS_platformGrabMutex(taskLock);
+
+    if (taskPending == NULL)
+    {
+        taskPending = __PHYSFS_platformCreateSemaphore();
+        BAIL_IF_MACRO_MUTEX(!taskPending, ERRPASS, taskLock, 0);
+    } /* if */
+
+    if ((taskQueued >= taskIdle) && (taskNumThreads < TASK_POOL_THREADS))
+    {
+        void *thread = __PHYSFS_platformCreateThread(taskPoolWorker, NULL);
+        if (thread != NULL)
+        {
+            taskThreads[taskNumThreads++] = thread;
+            taskIdle++;
+        } /* if */
+    } /* if */
+
+    BAIL_IF_MACRO_MUTEX(taskNumThreads == 0, ERRPASS, taskLock, 0);
+
+    if (taskTail == NULL)
+        taskHead = task;
+    else
+        taskTail->next = task;
+    taskTail = task;
+    taskQueued++;
+    __PHYSFS_platformReleaseMutex(taskLock);
+
+    __PHYSFS_platformPostSemaphore(taskPending);
+    return 1;
+} /* submitPoolTask */
+
+
+/* Stop the pool's threads, once they've run what's queued. */
+static void stopTaskPool(void)
+{
+    PHYSFS_uint32 i;
+
+    if (taskLock == NULL)
+        return;
+
+    __PHYSFS_platformGrabMutex(taskLock);
+    taskQuit = 1;
+    __PHYSFS_platformReleaseMutex(taskLock);
+
+    for (i = 0; i < taskNumThreads; i++)
+        __PHYSFS_platformPostSemaphore(taskPending);
+    for (i = 0; i < taskNumThreads; i++)
+        __PHYSFS_platformWaitThread(taskThreads[i]);
+
+    assert(taskHead == NULL);
+    if (taskPending != NULL)
+        __PHYSFS_platformDestroySemaphore(taskPending);
+    taskPending = NULL;
+    taskNumThreads = taskIdle = taskQueued = 0;
+    taskQuit = 0;
+} /* stopTaskPool */
+
+
+void *__PHYSFS_startTask(void (*fn)(void *), void *data)
+{
+    const PHYSFS_SubmitCallback submit = executorSubmit;
+    void *submitData = executorData;
+    Task *task;
+
+    if (taskLock == NULL)
+        return NULL;  /* not initialized; do it inline. */
+
+    task = (Task *) allocator.Malloc(sizeof (Task));
+    BAIL_IF_MACRO(!task, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    task->done = __PHYSFS_platformCreateSemaphore();
+    if (task->done == NULL)
+    {
+        allocator.Free(task);
+        return NULL;
+    } /* if */
+
+    task->fn = fn;
+    task->data = data;
+    task->state = TASK_QUEUED;
+    task->refcount = 2;
+    task->next = NULL;
+
+    if (submit != NULL)
+        submit(runTask, task, submitData);
+    else if (!submitPoolTask(task))
+    {
+        __PHYSFS_platformDestroySemaphore(task->done);
+        allocator.Free(task);
+        return NULL;
+    } /* else if */
+
+    return task;
+} /* __PHYSFS_startTask */
+
+
+void __PHYSFS_waitTask(void *_task)
+{
+    Task *task = (Task *) _task;
+    int run;
+    int wait;
+
+    __PHYSFS_platformGrabMutex(taskLock);
+    run = (task->state == TASK_QUEUED);
+    wait = (task->state == TASK_RUNNING);
+    if (run)
+        task->state = TASK_RUNNING;
+    __PHYSFS_platformReleaseMutex(taskLock);
+
+    if (run)  /* nobody's started it, so we'll do it. */
+        task->fn(task->data);
+    else if (wait)
+        __PHYSFS_platformWaitSemaphore(task->done);
+
+    __PHYSFS_platformGrabMutex(taskLock);
+    if (run)
+        task->state = TASK_DONE;
+    releaseTask(task);
+    __PHYSFS_platformReleaseMutex(taskLock);
+} /* __PHYSFS_waitTask */
+
+
+void PHYSFS_setExecutor(PHYSFS_SubmitCallback submit, void *userdata)
+{
+    executorData = userdata;
+    executorSubmit = submit;
+} /* PHYSFS_setExecutor */
+
+
+typedef struct __PHYSFS_ASYNCREQUEST__
+{
+    PHYSFS_File *handle;
+    void *buffer;
+    PHYSFS_uint64 len;
+    PHYSFS_uint64 offset;
+    PHYSFS_AsyncCallback callback;
+    void (*job)(void *userdata);  /* if not NULL, run this instead. */
+    void *userdata;
+    PHYSFS_AsyncPriority priority;  /* zero, critical, unless it's set. */
+    PHYSFS_uint64 deadline;  /* ticks it's dropped at, if not started; or 0. */
+    PHYSFS_uint64 id;  /* for PHYSFS_cancelAsync(); zero for jobs. */
+    volatile int cancelled;  /* set while it's running to stop it. */
+    PHYSFS_AsyncQueue *queue;  /* the one it's on; its reads count there. */
+    const void *archive;  /* if it's all in one stored file, its archive. */
+    PHYSFS_Io *src;  /* ...which has the data we want from here... */
+    PHYSFS_uint64 srcpos;
+    PHYSFS_uint64 srclen;  /* ...to here, less past the end of the file. */
+    struct __PHYSFS_ASYNCREQUEST__ *next;
+} AsyncRequest;
+
+
+/* most requests a worker takes at once, if the platform can batch them. */
+#define ASYNC_BATCH_MAX 32
+
+#define ASYNC_PRIORITIES (PHYSFS_ASYNC_PREFETCH + 1)
+
+/* a token bucket; see PHYSFS_setAsyncBandwidth(). */
+typedef struct
+{
+    PHYSFS_uint64 rate;  /* bytes per second; zero for no limit. */
+    PHYSFS_uint64 burst;  /* most (tokens) can build up to. */
+    PHYSFS_sint64 tokens;  /* bytes that can be read now; may go negative. */
+    PHYSFS_uint64 last;  /* ticks when (tokens) was last topped up. */
+} AsyncBandwidth;
+
+struct PHYSFS_AsyncQueue
+{
+    void *lock;  /* protects everything below but threads. */
+    void *pending;  /* semaphore; one post per queued request, or exit. */
+    int shuttingDown;  /* workers quit when they find nothing queued. */
+    AsyncRequest *head[ASYNC_PRIORITIES];  /* next request to service. */
+    AsyncRequest *tail[ASYNC_PRIORITIES];  /* where new requests go. */
+    AsyncRequest *running;  /* being serviced, so they can be cancelled. */
+    AsyncRequest *unused;  /* finished requests, kept for reuse. */
+    PHYSFS_uint64 nextId;  /* for the next request with an id. */
+    AsyncBandwidth bandwidth[ASYNC_PRIORITIES];
+    PHYSFS_uint32 numThreads;  /* zero if we service requests inline. */
+    void **threads;
+    PHYSFS_SubmitCallback submit;  /* the app's executor, instead of threads. */
+    void *submitData;
+    PHYSFS_uint32 numTasks;  /* submitted, up to numThreads at once. */
+    void *idle;  /* semaphore; posted when numTasks drops to 0 at shutdown. */
+};
+
+
+int __PHYSFS_asyncCancelled(void)
+{
+    const AsyncRequest *req;
+    if (asyncTls == NULL)
+        return 0;
+    req = (const AsyncRequest *) __PHYSFS_platformGetThreadLocal(asyncTls);
+    return ((req != NULL) && (req->cancelled));
+} /* __PHYSFS_asyncCancelled */
+
+
+/*
+ * Top up (bw) for the time since it last was, and return how many
+ *  milliseconds until anything more can be read, or zero if it can be now.
+ *  (now) is the time, or zero to have it looked up. Call this with the
+ *  queue's lock held.
+ */
+static PHYSFS_uint32 asyncBandwidthWait(AsyncBandwidth *bw,
+                                        PHYSFS_uint64 *now)
+{
+    PHYSFS_uint64 ms;
+
+    if (*now == 0)
+        *now = __PHYSFS_platformGetTicks();
+
+    ms = (*now - bw->last) / 1000000;
+    if (ms >= ((bw->burst / bw->rate) + 1) * 1000)
+        bw->tokens = (PHYSFS_sint64) bw->burst;  /* it's been a while. */
+    else if (ms > 0)
+    {
+        bw->tokens += (PHYSFS_sint64) ((ms * bw->rate) / 1000);
+        if (bw->tokens > (PHYSFS_sint64) bw->burst)
+            bw->tokens = (PHYSFS_sint64) bw->burst;
+    } /* else if */
+    bw->last += ms * 1000000;
+
+    if (bw->tokens > 0)
+        return 0;
+
+    ms = ((((PHYSFS_uint64) (1 - bw->tokens)) * 1000) + bw->rate - 1) /
+            bw->rate;
+    return (ms > 0x7FFFFFFF) ? 0x7FFFFFFF : (PHYSFS_uint32) ms;
+} /* asyncBandwidthWait */
+
+
+/* Count (bytes) read from the OS for work of (priority) on (queue). */
+static void chargeAsyncBandwidth(PHYSFS_AsyncQueue *queue,
+                                 const PHYSFS_AsyncPriority priority,
+                                 const PHYSFS_uint64 bytes)
+{
+    AsyncBandwidth *bw = &queue->bandwidth[(int) priority];
+
+    if (priority == PHYSFS_ASYNC_CRITICAL)
+        __PHYSFS_STAT_ADD(asyncBytesCritical, bytes);
+    else if (priority == PHYSFS_ASYNC_VISIBLE)
+        __PHYSFS_STAT_ADD(asyncBytesVisible, bytes);
+    else
+        __PHYSFS_STAT_ADD(asyncBytesPrefetch, bytes);
+
+    if (bw->rate != 0)  /* only a hint; checked again with the lock. */
+    {
+        __PHYSFS_platformGrabMutex(queue->lock);
+        if (bw->rate != 0)
+            bw->tokens -= (PHYSFS_sint64) bytes;
+        __PHYSFS_platformReleaseMutex(queue->lock);
+    } /* if */
+} /* chargeAsyncBandwidth */
+
+
+/* Count (bytes) the OS just read for us, if it was for an async request. */
+static void chargeAsyncRead(const PHYSFS_uint64 bytes)
+{
+    const AsyncRequest *req;
+    if (asyncTls == NULL)
+        return;
+    req = (const AsyncRequest *) __PHYSFS_platformGetThreadLocal(asyncTls);
+    if (req != NULL)
+        chargeAsyncBandwidth(req->queue, req->priority, bytes);
+} /* chargeAsyncRead */
+
+
+/* Tell (req)'s callback it was cancelled, or dropped past its deadline. */
+static void cancelAsyncRequest(const AsyncRequest *req)
+{
+    PHYSFS_setErrorCode(PHYSFS_ERR_CANCELLED);
+    req->callback(req->userdata, req->handle, req->buffer, -1);
+} /* cancelAsyncRequest */
+
+
+static void serviceAsyncRequest(AsyncRequest *req)
+{
+    PHYSFS_sint64 rc;
+
+    /*
+     * Let whatever's decompressing it see if it should give up, and count
+     *  what it reads against its priority's bandwidth.
+     */
+    if (asyncTls != NULL)
+        __PHYSFS_platformSetThreadLocal(asyncTls, (void *) req);
+
+    if (req->job != NULL)
+    {
+        req->job(req->userdata);
+        if (asyncTls != NULL)
+            __PHYSFS_platformSetThreadLocal(asyncTls, NULL);
+        return;
+    } /* if */
+
+    rc = PHYSFS_readAt(req->handle, req->buffer, req->len, req->offset);
+    if (asyncTls != NULL)
+        __PHYSFS_platformSetThreadLocal(asyncTls, NULL);
+
+    if (req->cancelled)
+        cancelAsyncRequest(req);
+    else
+        req->callback(req->userdata, req->handle, req->buffer, rc);
+} /* serviceAsyncRequest */
+
+
+/* Returns (handle)'s platform file handle if it's a native file, or NULL. */
+static void *nativeHandleForFile(PHYSFS_File *handle)
+{
+    const PHYSFS_Io *io = ((FileHandle *) handle)->io;
+    const NativeIoInfo *info;
+    if (io->destroy != nativeIo_destroy)
+        return NULL;
+    info = (const NativeIoInfo *) io->opaque;
+    if (info->directbuf != NULL)
+        return NULL;  /* reads have to line up; nativeIo_readAt() does that. */
+    return info->handle;
+} /* nativeHandleForFile */
+
+
+/*
+ * Read reqs[0] through reqs[count - 1], all from stored files in the same
+ *  archive, with one read of everything from (start) to (end), and give
+ *  each its part. If that doesn't work out, they're read one at a time.
+ */
+static void serviceAsyncRun(AsyncRequest **reqs, const PHYSFS_uint32 count,
+                            const PHYSFS_uint64 start, const PHYSFS_uint64 end)
+{
+    const PHYSFS_uint64 len = end - start;
+    AsyncRequest *urgent = reqs[0];
+    PHYSFS_uint8 *data = NULL;
+    PHYSFS_ErrorCode prevErr;
+    PHYSFS_uint32 i;
+    int ok = 0;
+
+    /* the read's for the most urgent of them, as far as bandwidth goes. */
+    for (i = 1; i < count; i++)
+    {
+        if (reqs[i]->priority < urgent->priority)
+            urgent = reqs[i];
+    } /* for */
+
+    /* failing here is no error; they'll just be read the usual way. */
+    prevErr = PHYSFS_getLastErrorCode();
+    if (__PHYSFS_ui64FitsAddressSpace(len))
+        data = (PHYSFS_uint8 *) allocator.Malloc((size_t) len);
+    if (data != NULL)
+    {
+        if (asyncTls != NULL)
+            __PHYSFS_platformSetThreadLocal(asyncTls, (void *) urgent);
+        ok = (__PHYSFS_ioReadAt(reqs[0]->src, data, len, start) ==
+                (PHYSFS_sint64) len);
+        if (asyncTls != NULL)
+            __PHYSFS_platformSetThreadLocal(asyncTls, NULL);
+    } /* if */
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    for (i = 0; i < count; i++)
+    {
+        AsyncRequest *req = reqs[i];
+        if (!ok)
+            serviceAsyncRequest(req);
+        else if (req->cancelled)
+            cancelAsyncRequest(req);
+        else
+        {
+            memcpy(req->buffer, data + (req->srcpos - start),
+                   (size_t) req->srclen);
+            __PHYSFS_STAT_ADD(bytesRead, req->srclen);
+            __PHYSFS_STAT_INCR(readsCoalesced);
+            if (profiling)
+            {
+                profileRead((FileHandle *) req->handle, req->offset,
+                            req->srclen);
+            } /* if */
+            req->callback(req->userdata, req->handle, req->buffer,
+                          (PHYSFS_sint64) req->srclen);
+        } /* else */
+    } /* for */
+
+    allocator.Free(data);
+} /* serviceAsyncRun */
+
+
+static int cmpAsyncRequests(void *_a, size_t one, size_t two)
+{
+    AsyncRequest **reqs = (AsyncRequest **) _a;
+    const AsyncRequest *a = reqs[one];
+    const AsyncRequest *b = reqs[two];
+
+    if (a->archive != b->archive)
+        return (a->archive < b->archive) ? -1 : 1;
+    else if (a->srcpos != b->srcpos)
+        return (a->srcpos < b->srcpos) ? -1 : 1;
+    return 0;
+} /* cmpAsyncRequests */
+
+
+static void swapAsyncRequests(void *_a, size_t one, size_t two)
+{
+    AsyncRequest **reqs = (AsyncRequest **) _a;
+    AsyncRequest *tmp = reqs[one];
+    reqs[one] = reqs[two];
+    reqs[two] = tmp;
+} /* swapAsyncRequests */
+
+
+/*
+ * Sort requests for stored files by where their data is, and read the ones
+ *  from the same archive that are close enough together in one go, like an
+ *  elevator. See PHYSFS_setReadCoalescing().
+ */
+static void serviceAsyncSpans(AsyncRequest **reqs, const PHYSFS_uint32 count)
+{
+    const PHYSFS_uint64 gap = readCoalesceGap;
+    const PHYSFS_uint64 max = readCoalesceMax;
+    PHYSFS_uint32 i = 0;
+
+    __PHYSFS_sort(reqs, count, cmpAsyncRequests, swapAsyncRequests);
+
+    while (i < count)
+    {
+        const PHYSFS_uint64 start = reqs[i]->srcpos;
+        PHYSFS_uint64 end = start + reqs[i]->srclen;
+        PHYSFS_uint32 n = 1;
+
+        while ((i + n < count) && (reqs[i + n]->archive == reqs[i]->archive))
+        {
+            const AsyncRequest *next = reqs[i + n];
+            const PHYSFS_uint64 nextend = next->srcpos + next->srclen;
+            if (next->srcpos > end + gap)
+                break;
+            else if ((nextend > end) && (nextend - start > max))
+                break;
+            if (nextend > end)
+                end = nextend;
+            n++;
+        } /* while */
+
+        if (n == 1)
+            serviceAsyncRequest(reqs[i]);
+        else
+            serviceAsyncRun(&reqs[i], n, start, end);
+        i += n;
+    } /* while */
+} /* serviceAsyncSpans */
+
+
+/*
+ * Native files go to the platform in one batch, so they can all be in
+ *  flight at once; stored files in archives are read a run at a time, by
+ *  serviceAsyncSpans(); everything else is read one at a time.
+ */
+static void serviceAsyncRequests(AsyncRequest **reqs, PHYSFS_uint32 count)
+{
+    __PHYSFS_PlatformReadRequest platreqs[ASYNC_BATCH_MAX];
+    AsyncRequest *batched[ASYNC_BATCH_MAX];
+    AsyncRequest *spanned[ASYNC_BATCH_MAX];
+    PHYSFS_uint32 numBatched = 0;
+    PHYSFS_uint32 numSpanned = 0;
+    PHYSFS_uint32 i;
+
+    assert(count <= ASYNC_BATCH_MAX);
+
+    for (i = 0; i < count; i++)
+    {
+        AsyncRequest *req = reqs[i];
+        void *opaque = NULL;
+
+        if ((count > 1) && (req->job == NULL) && (req->archive != NULL))
+        {
+            spanned[numSpanned++] = req;
+            continue;
+        } /* if */
+
+        if ((count > 1) && (req->job == NULL))
+            opaque = nativeHandleForFile(req->handle);
+
+        /* anything PHYSFS_readAt() would fuss about goes through it. */
+        if ((opaque == NULL) || (req->len == 0) ||
+            (req->len > __PHYSFS_UI64(0x7FFFFFFF)))
+            serviceAsyncRequest(req);
+        else
+        {
+            __PHYSFS_PlatformReadRequest *platreq = &platreqs[numBatched];
+            platreq->opaque = opaque;
+            platreq->buffer = req->buffer;
+            platreq->len = req->len;
+            platreq->pos = req->offset;
+            batched[numBatched++] = req;
+        } /* else */
+    } /* for */
+
+    if (numSpanned > 0)
+        serviceAsyncSpans(spanned, numSpanned);
+
+    if (numBatched == 0)
+        return;
+
+    __PHYSFS_platformReadBatch(platreqs, numBatched);
+    for (i = 0; i < numBatched; i++)
+    {
+        const AsyncRequest *req = batched[i];
+        if (req->cancelled)
+        {
+            cancelAsyncRequest(req);  /* too late to stop, but unwanted. */
+            continue;
+        } /* if */
+        else if (platreqs[i].result < 0)
+            PHYSFS_setErrorCode(platreqs[i].error);  /* for the callback. */
+        else
+        {
+            __PHYSFS_STAT_ADD(bytesRead, platreqs[i].result);
+            __PHYSFS_STAT_ADD(bytesReadPhysical, platreqs[i].result);
+            chargeAsyncBandwidth(req->queue, req->priority,
+                                 (PHYSFS_uint64) platreqs[i].result);
+            if (profiling)
+            {
+                profileRead((FileHandle *) req->handle, req->offset,
+                            (PHYSFS_uint64) platreqs[i].result);
+            } /* if */
+        } /* else */
+        req->callback(req->userdata, req->handle, req->buffer,
+                      platreqs[i].result);
+    } /* for */
+} /* serviceAsyncRequests */
+
+
+/*
+ * Take any requests from (queue) for stored data near reqs[0]'s, in the
+ *  same archive, and add them to the (count) in (reqs), up to
+ *  ASYNC_BATCH_MAX in all, so serviceAsyncSpans() can read them with it.
+ *  Returns the new count. Call this with (queue->lock) held.
+ */
+static PHYSFS_uint32 takeNearbyAsyncRequests(PHYSFS_AsyncQueue *queue,
+                                             AsyncRequest **reqs,
+                                             PHYSFS_uint32 count)
+{
+    const void *archive = reqs[0]->archive;
+    const PHYSFS_uint64 gap = readCoalesceGap;
+    const PHYSFS_uint64 max = readCoalesceMax;
+    PHYSFS_uint64 lo = reqs[0]->srcpos;
+    PHYSFS_uint64 hi = lo + reqs[0]->srclen;
+    PHYSFS_uint64 now = 0;
+    int i;
+
+    for (i = 0; (i < ASYNC_PRIORITIES) && (count < ASYNC_BATCH_MAX); i++)
+    {
+        const AsyncBandwidth *bw = &queue->bandwidth[i];
+        AsyncRequest **prev = &queue->head[i];
+        AsyncRequest *last = NULL;
+
+        if ((bw->rate != 0) && (bw->tokens <= 0) && (!queue->shuttingDown))
+            continue;  /* we'd be sneaking them past their limit. */
+
+        while ((*prev != NULL) && (count < ASYNC_BATCH_MAX))
+        {
+            AsyncRequest *req = *prev;
+            const PHYSFS_uint64 end = req->srcpos + req->srclen;
+            const PHYSFS_uint64 newlo = (req->srcpos < lo) ? req->srcpos : lo;
+            const PHYSFS_uint64 newhi = (end > hi) ? end : hi;
+            int take = ( (req->archive == archive) &&
+                         (req->srcpos <= hi + gap) && (end + gap >= lo) &&
+                         (newhi - newlo <= max) );
+
+            /* leave expired ones for takeAsyncRequests() to drop. */
+            if ((take) && (req->deadline != 0))
+            {
+                if (now == 0)
+                    now = __PHYSFS_platformGetTicks();
+                take = (now < req->deadline);
+            } /* if */
+
+            if (!take)
+            {
+                last = req;
+                prev = &req->next;
+                continue;
+            } /* if */
+
+            *prev = req->next;
+            if (queue->tail[i] == req)
+                queue->tail[i] = last;
+            req->next = queue->running;
+            queue->running = req;
+            reqs[count++] = req;
+            lo = newlo;
+            hi = newhi;
+        } /* while */
+    } /* for */
+
+    return count;
+} /* takeNearbyAsyncRequests */
+
+
+/*
+ * Take up to (max) requests off (queue), most urgent first, into (reqs),
+ *  and any that are past their deadlines into (expired), which has room
+ *  for (max) more. Taken requests go on the running list. Priorities that
+ *  are over their bandwidth are left alone. A priority with a limit gives
+ *  up one request at a time, so it can't get far ahead of it, and
+ *  (throttled) is set to how many milliseconds until another of its
+ *  requests can go, or zero if none are waiting. Call this with
+ *  (queue->lock) held.
+ */
+static PHYSFS_uint32 takeAsyncRequests(PHYSFS_AsyncQueue *queue,
+                                       AsyncRequest **reqs,
+                                       AsyncRequest **expired,
+                                       PHYSFS_uint32 *numExpired,
+                                       const PHYSFS_uint32 max,
+                                       PHYSFS_uint32 *throttled)
+{
+    PHYSFS_uint64 now = 0;
+    PHYSFS_uint32 count = 0;
+    int i;
+
+    *numExpired = 0;
+    *throttled = 0;
+    for (i = 0; i < ASYNC_PRIORITIES; i++)
+    {
+        /* once it's shutting down, everything goes as fast as it can. */
+        const int limited = ( (queue->bandwidth[i].rate != 0) &&
+                              (!queue->shuttingDown) );
+
+        if ((limited) && (queue->head[i] != NULL))
+        {
+            const PHYSFS_uint32 wait =
+                asyncBandwidthWait(&queue->bandwidth[i], &now);
+            if (wait != 0)
+            {
+                if ((*throttled == 0) || (wait < *throttled))
+                    *throttled = wait;
+                continue;
+            } /* if */
+        } /* if */
+
+        while ((queue->head[i] != NULL) && (count < max) &&
+               (*numExpired < max))
+        {
+            AsyncRequest *req = queue->head[i];
+            queue->head[i] = req->next;
+
+            if ((req->deadline != 0) && (now == 0))
+                now = __PHYSFS_platformGetTicks();
+
+            if ((req->deadline != 0) && (now >= req->deadline))
+                expired[(*numExpired)++] = req;
+            else
+            {
+                req->next = queue->running;
+                queue->running = req;
+                reqs[count++] = req;
+                if (limited)
+                    break;
+            } /* else */
+        } /* while */
+
+        if (queue->head[i] == NULL)
+            queue->tail[i] = NULL;
+
+        /* their posts may be gone, so we'll have to come back for them. */
+        else if (limited)
+            *throttled = 1;
+    } /* for */
+
+    if ((count > 0) && (reqs[0]->archive != NULL))
+        count = takeNearbyAsyncRequests(queue, reqs, count);
+
+    return count;
+} /* takeAsyncRequests */
+
+
+/* Take (req) off (queue)'s running list. Call with (queue->lock) held. */
+static void finishAsyncRequest(PHYSFS_AsyncQueue *queue, AsyncRequest *req)
+{
+    AsyncRequest **prev = &queue->running;
+    while (*prev != req)
+        prev = &(*prev)->next;
+    *prev = req->next;
+    req->next = queue->unused;
+    queue->unused = req;
+} /* finishAsyncRequest */
+
+
+/*
+ * Take what's ready in (queue) and service it. Returns how many requests
+ *  that was, or -1 when the caller should stop: the queue is shutting down
+ *  and empty or, if (draining), nothing was ready to take.
+ */
+static int asyncServiceReady(PHYSFS_AsyncQueue *queue, const int draining,
+                             PHYSFS_uint32 *throttled)
+{
+    AsyncRequest *reqs[ASYNC_BATCH_MAX];
+    AsyncRequest *expired[ASYNC_BATCH_MAX];
+
+    /* taking more than one at a time only helps if they run at once. */
+    const PHYSFS_uint32 maxreqs = (batchIo) ? ASYNC_BATCH_MAX : 1;
+
+    PHYSFS_uint32 numExpired = 0;
+    PHYSFS_uint32 count = 0;
+    PHYSFS_uint32 i;
+    int quit;
+
+    __PHYSFS_platformGrabMutex(queue->lock);
+    count = takeAsyncRequests(queue, reqs, expired, &numExpired, maxreqs,
+                              throttled);
+    if ((count > 0) || (numExpired > 0))
+        quit = 0;
+    else if (!draining)
+        quit = queue->shuttingDown;
+    else
+    {
+        /* done, unless it's just bandwidth. Once we're not counted,
+           queueAsyncRequest() submits a new task for what comes next. */
+        quit = (*throttled == 0);
+        if ((quit) && (--queue->numTasks == 0) && (queue->shuttingDown))
+            __PHYSFS_platformPostSemaphore(queue->idle);
+    } /* else */
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    if (quit)
+        return -1;
+
+    for (i = 0; i < numExpired; i++)
+        cancelAsyncRequest(expired[i]);
+
+    if (count > 0)
+        serviceAsyncRequests(reqs, count);
+    /* else someone else took ours as part of a batch, or it expired. */
+
+    __PHYSFS_platformGrabMutex(queue->lock);
+    for (i = 0; i < count; i++)
+        finishAsyncRequest(queue, reqs[i]);
+    for (i = 0; i < numExpired; i++)
+    {
+        expired[i]->next = queue->unused;
+        queue->unused = expired[i];
+    } /* for */
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    return (int) count;
+} /* asyncServiceReady */
+
+
+/* Wait for (queue) to have something, or for (throttled) ms if nonzero. */
+static void asyncWaitPending(PHYSFS_AsyncQueue *queue,
+                             const PHYSFS_uint32 throttled)
+{
+    /*
+     * Requests held back for bandwidth may have had their posts used up
+     *  already, so while there are any, check back when they can go.
+     */
+    if (throttled == 0)
+        __PHYSFS_platformWaitSemaphore(queue->pending);
+    else
+    {
+        const PHYSFS_uint64 start = __PHYSFS_platformGetTicks();
+        __PHYSFS_platformWaitSemaphoreTimeout(queue->pending, throttled);
+        __PHYSFS_STAT_INCR(throttleWaits);
+        __PHYSFS_STAT_ADD(throttleWaitNs, __PHYSFS_platformGetTicks() - start);
+    } /* else */
+} /* asyncWaitPending */
+
+
+static void asyncWorker(void *data)
+{
+    PHYSFS_AsyncQueue *queue = (PHYSFS_AsyncQueue *) data;
+    PHYSFS_uint32 throttled = 0;
+
+    do
+    {
+        asyncWaitPending(queue, throttled);
+    } while (asyncServiceReady(queue, 0, &throttled) >= 0);
+} /* asyncWorker */
+
+
+/* An executor's task: service (data)'s requests until there are none. */
+static void asyncDrain(void *data)
+{
+    PHYSFS_AsyncQueue *queue = (PHYSFS_AsyncQueue *) data;
+    PHYSFS_uint32 throttled = 0;
+    int rc;
+
+    while ((rc = asyncServiceReady(queue, 1, &throttled)) >= 0)
+    {
+        if ((rc == 0) && (throttled != 0))
+            asyncWaitPending(queue, throttled);
+    } /* while */
+} /* asyncDrain */
+
+
+PHYSFS_AsyncQueue *PHYSFS_createAsyncQueue(PHYSFS_uint32 threads)
+{
+    PHYSFS_AsyncQueue *queue;
+    size_t len;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
+
+    queue = (PHYSFS_AsyncQueue *) allocator.Malloc(sizeof (*queue));
+    BAIL_IF_MACRO(!queue, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(queue, '\0', sizeof (*queue));
+
+    queue->lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!queue->lock, ERRPASS, createAsyncQueueFailed);
+
+    if ((threads > 0) && (executorSubmit != NULL))
+    {
+        /* tasks go to the app as requests come; pending is for throttling. */
+        queue->pending = __PHYSFS_platformCreateSemaphore();
+        queue->idle = __PHYSFS_platformCreateSemaphore();
+        if ((queue->pending != NULL) && (queue->idle != NULL))
+        {
+            queue->submit = executorSubmit;
+            queue->submitData = executorData;
+            queue->numThreads = threads;
+        } /* if */
+        else  /* run reads inline. */
+        {
+            if (queue->pending != NULL)
+                __PHYSFS_platformDestroySemaphore(queue->pending);
+            if (queue->idle != NULL)
+                __PHYSFS_platformDestroySemaphore(queue->idle);
+            queue->pending = queue->idle = NULL;
+        } /* else */
+    } /* if */
+
+    else if (threads > 0)
+    {
+        len = sizeof (void *) * threads;
+        queue->threads = (void **) allocator.Malloc(len);
+        GOTO_IF_MACRO(!queue->threads, PHYSFS_ERR_OUT_OF_MEMORY,
+                      createAsyncQueueFailed);
+
+        /* if there's no semaphore or thread to be had, run reads inline. */
+        queue->pending = __PHYSFS_platformCreateSemaphore();
+        while ((queue->pending != NULL) && (queue->numThreads < threads))
+        {
+            void *thread = __PHYSFS_platformCreateThread(asyncWorker, queue);
+            if (thread == NULL)
+                break;  /* go with what we've got. */
+            queue->threads[queue->numThreads++] = thread;
+        } /* while */
+
+        if ((queue->numThreads == 0) && (queue->pending != NULL))
+        {
+            __PHYSFS_platformDestroySemaphore(queue->pending);
+            queue->pending = NULL;
+        } /* if */
+    } /* if */
+
+    return queue;
+
+createAsyncQueueFailed:
+    if (queue->lock != NULL)
+        __PHYSFS_platformDestroyMutex(queue->lock);
+    allocator.Free(queue->threads);
+    allocator.Free(queue);
+    return NULL;
+} /* PHYSFS_createAsyncQueue */
+
+
+void PHYSFS_destroyAsyncQueue(PHYSFS_AsyncQueue *queue)
+{
+    AsyncRequest *req;
+    AsyncRequest *next;
+    PHYSFS_uint32 i;
+
+    if (queue == NULL)
+        return;
+
+    /* stop the predictor handing it more; what's queued still gets done. */
+    if (predictLock != NULL)
+    {
+        __PHYSFS_platformGrabMutex(predictLock);
+        if (predictQueue == queue)
+            predictQueue = NULL;
+        __PHYSFS_platformReleaseMutex(predictLock);
+    } /* if */
+
+    /* workers finish everything already queued before they quit. */
+    __PHYSFS_platformGrabMutex(queue->lock);
+    queue->shuttingDown = 1;
+    __PHYSFS_platformReleaseMutex(queue->lock);
+    for (i = 0; i < queue->numThreads; i++)
+        __PHYSFS_platformPostSemaphore(queue->pending);
+
+    if (queue->submit != NULL)
+    {
+        /* no threads to join; the last task out tells us it's done. */
+        __PHYSFS_platformGrabMutex(queue->lock);
+        while (queue->numTasks > 0)
+        {
+            __PHYSFS_platformReleaseMutex(queue->lock);
+            __PHYSFS_platformWaitSemaphore(queue->idle);
+            __PHYSFS_platformGrabMutex(queue->lock);
+        } /* while */
+        __PHYSFS_platformReleaseMutex(queue->lock);
+    } /* if */
+
+    else
+    {
+        for (i = 0; i < queue->numThreads; i++)
+            __PHYSFS_platformWaitThread(queue->threads[i]);
+    } /* else */
+
+    for (i = 0; i < ASYNC_PRIORITIES; i++)
+        assert(queue->head[i] == NULL);
+    assert(queue->running == NULL);
+    for (req = queue->unused; req != NULL; req = next)
+    {
+        next = req->next;
+        allocator.Free(req);
+    } /* for */
+
+    if (queue->pending != NULL)
+        __PHYSFS_platformDestroySemaphore(queue->pending);
+    if (queue->idle != NULL)
+        __PHYSFS_platformDestroySemaphore(queue->idle);
+    __PHYSFS_platformDestroyMutex(queue->lock);
+    allocator.Free(queue->threads);
+    allocator.Free(queue);
+} /* PHYSFS_destroyAsyncQueue */
+
+
+/*
+ * Hand a copy of (from) to (queue), or service it now if there's no one.
+ *  Returns its id, if it has one, or non-zero, or zero on failure.
+ */
+static PHYSFS_uint64 queueAsyncRequest(PHYSFS_AsyncQueue *queue,
+                                       const AsyncRequest *from)
+{
+    const int priority = (int) from->priority;
+    PHYSFS_uint64 retval = 1;
+    int submit = 0;
+    AsyncRequest *req;
+
+    __PHYSFS_platformGrabMutex(queue->lock);
+    req = queue->unused;
+    if (req != NULL)
+        queue->unused = req->next;
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    if (req == NULL)
+    {
+        req = (AsyncRequest *) allocator.Malloc(sizeof (AsyncRequest));
+        BAIL_IF_MACRO(!req, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+
+    memcpy(req, from, sizeof (*req));
+    req->queue = queue;
+    req->next = NULL;
+
+    if (queue->numThreads == 0)  /* nobody to hand it to; do it now. */
+    {
+        if (req->job == NULL)
+        {
+            __PHYSFS_platformGrabMutex(queue->lock);
+            retval = req->id = ++queue->nextId;
+            __PHYSFS_platformReleaseMutex(queue->lock);
+        } /* if */
+        serviceAsyncRequest(req);
+        __PHYSFS_platformGrabMutex(queue->lock);
+        req->next = queue->unused;
+        queue->unused = req;
+        __PHYSFS_platformReleaseMutex(queue->lock);
+        return retval;
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(queue->lock);
+    if (req->job == NULL)
+        retval = req->id = ++queue->nextId;
+    if (queue->tail[priority] == NULL)
+        queue->head[priority] = req;
+    else
+        queue->tail[priority]->next = req;
+    queue->tail[priority] = req;
+    if ((queue->submit != NULL) && (queue->numTasks < queue->numThreads))
+    {
+        queue->numTasks++;  /* room for one more; else a running one gets it. */
+        submit = 1;
+    } /* if */
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    if (submit)
+        queue->submit(asyncDrain, queue, queue->submitData);
+    else
+        __PHYSFS_platformPostSemaphore(queue->pending);
+    return retval;
+} /* queueAsyncRequest */
+
+
+int PHYSFS_readAsync(PHYSFS_AsyncQueue *queue, PHYSFS_File *handle,
+                     void *buffer, PHYSFS_uint64 len, PHYSFS_uint64 offset,
+                     PHYSFS_AsyncCallback callback, void *userdata)
+{
+    return (PHYSFS_readAsyncPriority(queue, handle, buffer, len, offset,
+                                     PHYSFS_ASYNC_VISIBLE, 0, callback,
+                                     userdata) != 0);
+} /* PHYSFS_readAsync */
+
+
+PHYSFS_uint64 PHYSFS_readAsyncPriority(PHYSFS_AsyncQueue *queue,
+                                       PHYSFS_File *handle, void *buffer,
+                                       PHYSFS_uint64 len, PHYSFS_uint64 offset,
+                                       PHYSFS_AsyncPriority priority,
+                                       PHYSFS_uint32 deadline,
+                                       PHYSFS_AsyncCallback callback,
+                                       void *userdata)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    AsyncRequest req;
+
+    BAIL_IF_MACRO(!queue, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(((int) priority < 0) || (priority >= ASYNC_PRIORITIES),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, 0);
+
+    memset(&req, '\0', sizeof (req));
+    req.handle = handle;
+    req.buffer = buffer;
+    req.len = len;
+    req.offset = offset;
+    req.callback = callback;
+    req.userdata = userdata;
+    req.priority = priority;
+    if (deadline != 0)
+    {
+        req.deadline = __PHYSFS_platformGetTicks() +
+                       (((PHYSFS_uint64) deadline) * 1000000);
+    } /* if */
+
+    /* a stored file's data can be read along with its neighbours'. */
+    if ((readCoalesceMax > 0) && (len > 0) &&
+        (ioGetStoredSpan(fh->io, &req.archive, &req.src, &req.srcpos,
+                         &req.srclen)) && (offset < req.srclen))
+    {
+        req.srcpos += offset;
+        req.srclen -= offset;
+        if (req.srclen > len)
+            req.srclen = len;
+    } /* if */
+    else
+        req.archive = NULL;
+
+    return queueAsyncRequest(queue, &req);
+} /* PHYSFS_readAsyncPriority */
+
+
+int PHYSFS_setAsyncBandwidth(PHYSFS_AsyncQueue *queue,
+                             PHYSFS_AsyncPriority priority,
+                             PHYSFS_uint64 bytesPerSecond,
+                             PHYSFS_uint64 burst)
+{
+    AsyncBandwidth *bw;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!queue, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(((int) priority < 0) || (priority >= ASYNC_PRIORITIES),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    bw = &queue->bandwidth[(int) priority];
+    __PHYSFS_platformGrabMutex(queue->lock);
+    bw->rate = bytesPerSecond;
+    bw->burst = (burst != 0) ? burst : bytesPerSecond;
+    bw->tokens = (PHYSFS_sint64) bw->burst;
+    bw->last = __PHYSFS_platformGetTicks();
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    /* wake the workers, in case they're waiting on the old limit. */
+    for (i = 0; i < queue->numThreads; i++)
+        __PHYSFS_platformPostSemaphore(queue->pending);
+
+    return 1;
+} /* PHYSFS_setAsyncBandwidth */
+
+
+int PHYSFS_cancelAsync(PHYSFS_AsyncQueue *queue, PHYSFS_uint64 id)
+{
+    AsyncRequest *found = NULL;
+    AsyncRequest **prev;
+    AsyncRequest *req;
+    int i;
+
+    BAIL_IF_MACRO(!queue, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(id == 0, PHYSFS_ERR_NOT_FOUND, 0);
+
+    __PHYSFS_platformGrabMutex(queue->lock);
+    for (i = 0; (i < ASYNC_PRIORITIES) && (!found); i++)
+    {
+        AsyncRequest *last = NULL;
+        for (prev = &queue->head[i]; *prev != NULL; prev = &(*prev)->next)
+        {
+            if ((*prev)->id == id)
+            {
+                found = *prev;
+                *prev = found->next;
+                if (queue->tail[i] == found)
+                    queue->tail[i] = last;
+                break;
+            } /* if */
+            last = *prev;
+        } /* for */
+    } /* for */
+
+    /* a running one stops itself, and calls its own callback. */
+    if (found == NULL)
+    {
+        for (req = queue->running; req != NULL; req = req->next)
+        {
+            if (req->id == id)
+            {
+                req->cancelled = 1;
+                break;
+            } /* if */
+        } /* for */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(queue->lock);
+
+    if (found == NULL)
+    {
+        BAIL_IF_MACRO(req == NULL, PHYSFS_ERR_NOT_FOUND, 0);
+        return 1;
+    } /* if */
+
+    /* its post on (queue->pending) just wakes a worker to find nothing. */
+    cancelAsyncRequest(found);
+    __PHYSFS_platformGrabMutex(queue->lock);
+    found->next = queue->unused;
+    queue->unused = found;
+    __PHYSFS_platformReleaseMutex(queue->lock);
+    return 1;
+} /* PHYSFS_cancelAsync */
+
+
+/* Adaptive buffers start this small, and after every seek, too. */
+#define ADAPTIVE_BUFFER_MIN 1024
+
+/*
+ * The next chunk of a sequentially-read file, read by an async queue's
+ *  worker while the app works through the chunk before it. While a read is
+ *  pending, the worker owns the handle's i/o; only the handle's own thread
+ *  waits for it, through readAheadBytes().
+ */
+typedef struct __PHYSFS_READAHEAD__
+{
+    PHYSFS_AsyncQueue *queue;  /* where the reads go. */
+    void *done;  /* semaphore, posted when a read finishes. */
+    int pending;  /* non-zero if a read is queued and not waited for. */
+    int valid;  /* non-zero if (buffer) holds what comes after fh->buffer. */
+    PHYSFS_uint8 *buffer;
+    PHYSFS_uint64 size;  /* bytes allocated at (buffer). */
+    PHYSFS_uint64 len;  /* bytes asked for. */
+    PHYSFS_sint64 result;  /* what the read returned. */
+    PHYSFS_ErrorCode error;  /* why (result) is -1. */
+    FileHandle *fh;
+} ReadAhead;
+
+
+static void readAheadJob(void *data)
+{
+    ReadAhead *ahead = (ReadAhead *) data;
+    PHYSFS_Io *io = ahead->fh->io;
+    ahead->result = io->read(io, ahead->buffer, ahead->len);
+    ahead->error = PHYSFS_getLastErrorCode();  /* this clears it, too. */
+    __PHYSFS_platformPostSemaphore(ahead->done);
+} /* readAheadJob */
+
+
+/* Wait for any background read; how many bytes it left for us to use. */
+static PHYSFS_uint64 readAheadBytes(FileHandle *fh)
+{
+    ReadAhead *ahead = fh->ahead;
+    if (ahead == NULL)
+        return 0;
+
+    if (ahead->pending)
+    {
+        __PHYSFS_platformWaitSemaphore(ahead->done);
+        ahead->pending = 0;
+        ahead->valid = 1;
+    } /* if */
+
+    if ((!ahead->valid) || (ahead->result <= 0))
+        return 0;
+    return (PHYSFS_uint64) ahead->result;
+} /* readAheadBytes */
+
+
+/* Forget what was read ahead; the caller is moving the i/o elsewhere. */
+static void dropReadAhead(FileHandle *fh)
+{
+    if (fh->ahead != NULL)
+    {
+        readAheadBytes(fh);
+        fh->ahead->valid = 0;
+    } /* if */
+} /* dropReadAhead */
+
+
+static void freeReadAhead(FileHandle *fh)
+{
+    ReadAhead *ahead = fh->ahead;
+    if (ahead != NULL)
+    {
+        readAheadBytes(fh);
+        __PHYSFS_platformDestroySemaphore(ahead->done);
+        freeFileBuffer(fh->dirHandle->mem, ahead->buffer, ahead->size);
+        allocator.Free(ahead);
+        fh->ahead = NULL;
+    } /* if */
+} /* freeReadAhead */
+
+
+/* Start reading (fh->readahead) more bytes in the background, if we can. */
+static void startReadAhead(FileHandle *fh)
+{
+    ReadAhead *ahead = fh->ahead;
+    AsyncRequest req;
+
+    if ((ahead == NULL) || (!fh->sequential))
+        return;  /* no queue, or we'd likely waste it on a seek. */
+
+    assert(!ahead->pending);
+    assert(!ahead->valid);
+
+    if (ahead->size < fh->readahead)
+    {
+        /* oh well, they'll just have to wait for it. */
+        if (!__PHYSFS_memAllowed(PHYSFS_MEMORY_BUFFERS,
+                                 fh->readahead - ahead->size))
+            return;
+        else if (!resizeFileBuffer(fh->dirHandle->mem, &ahead->buffer,
+                                   &ahead->size, fh->readahead))
+            return;
+    } /* if */
+
+    memset(&req, '\0', sizeof (req));
+    req.job = readAheadJob;
+    req.userdata = ahead;
+    req.priority = PHYSFS_ASYNC_VISIBLE;
+    ahead->len = fh->readahead;
+    ahead->pending = 1;
+    if (!queueAsyncRequest(ahead->queue, &req))
+    {
+        PHYSFS_getLastErrorCode();  /* not the app's problem. */
+        ahead->pending = 0;
+    } /* if */
+} /* startReadAhead */
+
+
+/* Make (fh->buffer) what was read ahead. Returns bytes in it, -1 on error. */
+static PHYSFS_sint64 takeReadAhead(FileHandle *fh)
+{
+    ReadAhead *ahead = fh->ahead;
+    PHYSFS_uint8 *buffer = fh->buffer;
+    const PHYSFS_uint64 size = fh->bufsize;
+    const PHYSFS_uint64 len = readAheadBytes(fh);
+
+    ahead->valid = 0;
+    if (ahead->result < 0)
+        BAIL_MACRO(ahead->error, -1);
+
+    fh->buffer = ahead->buffer;
+    fh->bufsize = ahead->size;
+    fh->buffill = len;
+    fh->bufpos = 0;
+    ahead->buffer = buffer;
+    ahead->size = size;
+    return (PHYSFS_sint64) len;
+} /* takeReadAhead */
+
+
+/*
+ * An adaptive buffer's next read size doubles every time it's drained with
+ *  no seek since it was filled, up to fh->bufmax, so reading a file start
+ *  to finish soon goes in big chunks. A seek puts it back to small, so
+ *  random access doesn't drag in data nobody wants.
+ */
+static PHYSFS_sint64 doAdaptiveRead(FileHandle *fh, void *buffer,
+                                    PHYSFS_uint64 len)
+{
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buffer;
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_sint64 rc = 0;
+
+    while (len > 0)
+    {
+        PHYSFS_Io *io = fh->io;
+        const PHYSFS_uint64 buffered = fh->buffill - fh->bufpos;
+
+        if (buffered > 0)
+        {
+            const PHYSFS_uint64 cpy = (len < buffered) ? len : buffered;
+            memcpy(ptr, fh->buffer + fh->bufpos, (size_t) cpy);
+            fh->bufpos += cpy;
+            ptr += cpy;
+            len -= cpy;
+            retval += cpy;
+            continue;
+        } /* if */
+
+        if ((fh->ahead != NULL) && (fh->ahead->pending || fh->ahead->valid))
+        {
+            rc = takeReadAhead(fh);
+            if (rc <= 0)
+                break;  /* EOF or error. */
+            startReadAhead(fh);
+            continue;
+        } /* if */
+
+        if ((fh->sequential) && (fh->readahead < fh->bufmax))
+        {
+            fh->readahead = (fh->readahead > fh->bufmax / 2) ?
+                                fh->bufmax : fh->readahead * 2;
+        } /* if */
+        fh->sequential = 1;
+
+        if ((fh->bufsize < fh->readahead) && (len < fh->readahead) &&
+            (__PHYSFS_memAllowed(PHYSFS_MEMORY_BUFFERS,
+                                 fh->readahead - fh->bufsize)))
+        {
+            resizeFileBuffer(fh->dirHandle->mem, &fh->buffer, &fh->bufsize,
+                             fh->readahead);
+        } /* if */
+
+        fh->buffill = fh->bufpos = 0;
+        if ((len >= fh->readahead) || (len >= fh->bufsize))
+        {
+            /* big enough to skip the buffer, like doBufferedRead(). */
+            rc = io->read(io, ptr, len);
+            if (rc > 0)
+                retval += rc;
+            if (rc == (PHYSFS_sint64) len)
+                startReadAhead(fh);
+            break;
+        } /* if */
+
+        rc = io->read(io, fh->buffer, fh->readahead);
+        if (rc <= 0)
+            break;  /* EOF or error. */
+        fh->buffill = (PHYSFS_uint64) rc;
+        if (rc == (PHYSFS_sint64) fh->readahead)
+            startReadAhead(fh);
+    } /* while */
+
+    if ((rc < 0) && (retval == 0))
+        return -1;
+    return retval;
+} /* doAdaptiveRead */
+
+
+int PHYSFS_setAdaptiveBuffer(PHYSFS_File *handle, PHYSFS_uint64 maxsize,
+                             PHYSFS_AsyncQueue *queue)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    ReadAhead *ahead = NULL;
+
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, 0);
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(maxsize),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    /* this drops whatever buffering there was, and rewinds to match. */
+    BAIL_IF_MACRO(!PHYSFS_setBuffer(handle, 0), ERRPASS, 0);
+    if (maxsize == 0)
+        return 1;
+
+    if (queue != NULL)
+    {
+        ahead = (ReadAhead *) allocator.Malloc(sizeof (ReadAhead));
+        BAIL_IF_MACRO(!ahead, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        memset(ahead, '\0', sizeof (ReadAhead));
+        ahead->done = __PHYSFS_platformCreateSemaphore();
+        if (ahead->done == NULL)
+        {
+            allocator.Free(ahead);
+            return 0;
+        } /* if */
+        ahead->queue = queue;
+        ahead->fh = fh;
+    } /* if */
+
+    fh->ahead = ahead;
+    fh->bufmax = maxsize;
+    fh->readahead = (fh->bufmax < ADAPTIVE_BUFFER_MIN) ?
+                        fh->bufmax : ADAPTIVE_BUFFER_MIN;
+    fh->sequential = 0;
+    return 1;
+} /* PHYSFS_setAdaptiveBuffer */
+
+
+/*
+ * The last full buffer of a file opened for writing, being written by an
+ *  async queue's worker while the app fills the next one. There's only ever
+ *  one of these in flight per file, so writes stay in order, and the app
+ *  waits for it before handing off another. While a write is pending, the
+ *  worker owns the handle's i/o.
+ */
+typedef struct __PHYSFS_WRITEBEHIND__
+{
+    PHYSFS_AsyncQueue *queue;  /* where the writes go. */
+    void *done;  /* semaphore, posted when a write finishes. */
+    int pending;  /* non-zero if a write is queued and not waited for. */
+    PHYSFS_uint8 *buffer;  /* being written, or the next fh->buffer. */
+    PHYSFS_uint64 len;  /* bytes to write from (buffer). */
+    PHYSFS_ErrorCode error;  /* first failed write not reported yet. */
+    FileHandle *fh;
+} WriteBehind;
+
+
+static void writeBehindJob(void *data)
+{
+    WriteBehind *behind = (WriteBehind *) data;
+    PHYSFS_Io *io = behind->fh->io;
+    const PHYSFS_sint64 rc = io->write(io, behind->buffer, behind->len);
+    const PHYSFS_ErrorCode err = PHYSFS_getLastErrorCode();  /* clears it. */
+
+    if ((rc != (PHYSFS_sint64) behind->len) && (!behind->error))
+        behind->error = (err != PHYSFS_ERR_OK) ? err : PHYSFS_ERR_IO;
+    __PHYSFS_platformPostSemaphore(behind->done);
+} /* writeBehindJob */
+
+
+/* Wait for any background write. */
+static void waitWriteBehind(FileHandle *fh)
+{
+    WriteBehind *behind = fh->behind;
+    if ((behind != NULL) && (behind->pending))
+    {
+        __PHYSFS_platformWaitSemaphore(behind->done);
+        behind->pending = 0;
+    } /* if */
+} /* waitWriteBehind */
+
+
+/* Wait for any background write, and report it if any write failed. */
+static int finishWriteBehind(FileHandle *fh)
+{
+    WriteBehind *behind = fh->behind;
+    PHYSFS_ErrorCode err;
+
+    if (behind == NULL)
+        return 1;
+
+    waitWriteBehind(fh);
+    err = behind->error;
+    behind->error = PHYSFS_ERR_OK;  /* only tell them once. */
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+} /* finishWriteBehind */
+
+
+static void freeWriteBehind(FileHandle *fh)
+{
+    WriteBehind *behind = fh->behind;
+    if (behind != NULL)
+    {
+        waitWriteBehind(fh);
+        __PHYSFS_platformDestroySemaphore(behind->done);
+        freeFileBuffer(fh->dirHandle->mem, behind->buffer, fh->bufsize);
+        allocator.Free(behind);
+        fh->behind = NULL;
+    } /* if */
+} /* freeWriteBehind */
+
+
+/* Hand (fh->buffer) to the queue to write, and fill the other one. */
+static int startWriteBehind(FileHandle *fh)
+{
+    WriteBehind *behind = fh->behind;
+    PHYSFS_uint8 *buffer = fh->buffer;
+    AsyncRequest req;
+
+    BAIL_IF_MACRO(!finishWriteBehind(fh), ERRPASS, 0);
+
+    fh->buffer = behind->buffer;
+    behind->buffer = buffer;
+    behind->len = fh->buffill;
+    fh->buffill = fh->bufpos = 0;
+
+    memset(&req, '\0', sizeof (req));
+    req.job = writeBehindJob;
+    req.userdata = behind;
+    behind->pending = 1;
+    if (!queueAsyncRequest(behind->queue, &req))
+    {
+        PHYSFS_getLastErrorCode();  /* not the app's problem. */
+        writeBehindJob(behind);  /* just do it here, then. */
+    } /* if */
+
+    return 1;
+} /* startWriteBehind */
+
+
+/* Like doBufferedWrite(), but a full buffer never waits on the i/o. */
+static PHYSFS_sint64 doWriteBehind(FileHandle *fh, const void *buffer,
+                                   PHYSFS_uint64 len)
+{
+    const PHYSFS_uint8 *ptr = (const PHYSFS_uint8 *) buffer;
+    PHYSFS_uint64 remain = len;
+
+    while (remain > 0)
+    {
+        const PHYSFS_uint64 avail = fh->bufsize - fh->buffill;
+        const PHYSFS_uint64 cpy = (remain < avail) ? remain : avail;
+        memcpy(fh->buffer + fh->buffill, ptr, (size_t) cpy);
+        fh->buffill += cpy;
+        ptr += cpy;
+        remain -= cpy;
+        if (fh->buffill == fh->bufsize)
+            BAIL_IF_MACRO(!startWriteBehind(fh), ERRPASS, -1);
+    } /* while */
+
+    return (PHYSFS_sint64) len;
+} /* doWriteBehind */
+
+
+int PHYSFS_setWriteBehind(PHYSFS_File *handle, PHYSFS_uint64 bufsize,
+                          PHYSFS_AsyncQueue *queue)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    WriteBehind *behind = NULL;
+
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(fh->forReading, PHYSFS_ERR_OPEN_FOR_READING, 0);
+
+    /* this writes out whatever was buffered, and drops any old queue. */
+    BAIL_IF_MACRO(!PHYSFS_setBuffer(handle, bufsize), ERRPASS, 0);
+    if ((bufsize == 0) || (queue == NULL))
+        return 1;  /* just a plain buffer, then. */
+
+    behind = (WriteBehind *) allocator.Malloc(sizeof (WriteBehind));
+    BAIL_IF_MACRO(!behind, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(behind, '\0', sizeof (WriteBehind));
+    behind->buffer = allocFileBuffer(fh->dirHandle->mem, bufsize);
+    GOTO_IF_MACRO(!behind->buffer, PHYSFS_ERR_OUT_OF_MEMORY, setWriteBehindFailed);
+    behind->done = __PHYSFS_platformCreateSemaphore();
+    GOTO_IF_MACRO(!behind->done, ERRPASS, setWriteBehindFailed);
+    behind->queue = queue;
+    behind->fh = fh;
+
+    fh->behind = behind;
+    return 1;
+
+setWriteBehindFailed:
+    freeFileBuffer(fh->dirHandle->mem, behind->buffer, bufsize);
+    allocator.Free(behind);
+    return 0;
+} /* PHYSFS_setWriteBehind */
+
+
+int PHYSFS_setAccessHint(PHYSFS_File *handle, PHYSFS_AccessHint hint)
+{
+    FileHandle *fh = (FileHandle *) handle;
+
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO((hint < PHYSFS_ACCESS_NORMAL) ||
+                  (hint > PHYSFS_ACCESS_STREAM),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    /* the next open of this file shouldn't get the hint, so don't keep it. */
+    allocator.Free(fh->keep.path);
+    fh->keep.path = NULL;
+    return __PHYSFS_ioAdvise(fh->io, 0, 0, (int) hint);
+} /* PHYSFS_setAccessHint */
+
+
+int PHYSFS_setMountAccessHint(const char *dir, PHYSFS_AccessHint hint)
+{
+    PHYSFS_Context *ctx = currentContext();
+    DirHandle *i;
+
+    BAIL_IF_MACRO(!dir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO((hint < PHYSFS_ACCESS_NORMAL) ||
+                  (hint > PHYSFS_ACCESS_STREAM),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    grabLock(ctx->lock);
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if (strcmp(i->dirName, dir) == 0)
+        {
+            i->accessHint = (int) hint;
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+            return 1;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    BAIL_MACRO(PHYSFS_ERR_NOT_MOUNTED, 0);
+} /* PHYSFS_setMountAccessHint */
+
+
+int PHYSFS_setMountRoutes(const char *dir, const char **include,
+                          const char **exclude)
+{
+    PHYSFS_Context *ctx = currentContext();
+    MountRoutes *routes;
+    DirHandle *i;
+
+    BAIL_IF_MACRO(!dir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    routes = createMountRoutes(include, exclude);
+    BAIL_IF_MACRO(!routes, ERRPASS, 0);
+
+    grabLock(ctx->lock);
+    if (ctx->frozen)
+    {
+        allocator.Free(routes);
+        BAIL_MACRO_MUTEX(PHYSFS_ERR_FROZEN, ctx->lock, 0);
+    } /* if */
+
+    for (i = ctx->searchPath; i != NULL; i = i->next)
+    {
+        if ((i->dirName != NULL) && (strcmp(i->dirName, dir) == 0))
+        {
+            /* lookups might be reading the old one; it stays until (i). */
+            routes->prev = i->routes;
+            __PHYSFS_MEMORY_BARRIER();
+            i->routes = routes;
+            bumpSearchGeneration(ctx);  /* misses might not be, now. */
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+            return 1;
+        } /* if */
+    } /* for */
+
+    allocator.Free(routes);
+    BAIL_MACRO_MUTEX(PHYSFS_ERR_NOT_MOUNTED, ctx->lock, 0);
+} /* PHYSFS_setMountRoutes */
+
+
+/* groups at least this big try one sync of the whole filesystem first. */
+#define DURABILITY_SYNCFS_MIN 64
+
+struct PHYSFS_DurabilityGroup
+{
+    char **names;  /* sanitized, in platform-independent notation. */
+    PHYSFS_uint32 count;
+    PHYSFS_uint32 capacity;
+};
+
+/* One file of a PHYSFS_commitDurabilityGroup(), maybe on a worker thread. */
+typedef struct
+{
+    void *opaque;  /* write dir's DIR archiver. */
+    const char *name;  /* past the write dir's mount point. */
+    PHYSFS_ErrorCode error;  /* why it failed, or PHYSFS_ERR_OK. */
+    void *done;  /* semaphore to post when finished, or NULL. */
+} DurableFile;
+
+
+static void durableFileJob(void *data)
+{
+    DurableFile *df = (DurableFile *) data;
+    if (!__PHYSFS_DIR_syncData(df->opaque, df->name))
+    {
+        df->error = PHYSFS_getLastErrorCode();  /* clears it. */
+        if (df->error == PHYSFS_ERR_OK)
+            df->error = PHYSFS_ERR_IO;
+    } /* if */
+
+    if (df->done != NULL)
+        __PHYSFS_platformPostSemaphore(df->done);
+} /* durableFileJob */
+
+
+/*
+ * Sync every file in (files) a file at a time, on (queue) if there is one,
+ *  then each directory they're in, once. Returns the first error.
+ */
+static PHYSFS_ErrorCode syncDurableFiles(DurableFile *files,
+                                         const PHYSFS_uint32 count,
+                                         PHYSFS_AsyncQueue *queue)
+{
+    PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+    void *done = NULL;
+    PHYSFS_uint32 i, j;
+
+    if ((queue != NULL) && (queue->numThreads > 0))
+        done = __PHYSFS_platformCreateSemaphore();
+
+    for (i = 0; i < count; i++)
+    {
+        AsyncRequest req;
+        files[i].done = done;
+        if (done == NULL)
+        {
+            durableFileJob(&files[i]);
+            continue;
+        } /* if */
+
+        memset(&req, '\0', sizeof (req));
+        req.job = durableFileJob;
+        req.userdata = &files[i];
+        if (!queueAsyncRequest(queue, &req))
+        {
+            PHYSFS_getLastErrorCode();  /* not the app's problem. */
+            durableFileJob(&files[i]);  /* just do it here, then. */
+        } /* if */
+    } /* for */
+
+    if (done != NULL)
+    {
+        for (i = 0; i < count; i++)
+            __PHYSFS_platformWaitSemaphore(done);
+        __PHYSFS_platformDestroySemaphore(done);
+    } /* if */
+
+    for (i = 0; (i < count) && (err == PHYSFS_ERR_OK); i++)
+        err = files[i].error;
+
+    /* files that were just created aren't safe until their dir is synced. */
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < i; j++)
+        {
+            if (sameParentDir(files[j].name, files[i].name))
+                break;  /* already did this one. */
+        } /* for */
+
+        if ((j == i) && (!syncParentDir(files[i].opaque, files[i].name)))
+        {
+            if (err == PHYSFS_ERR_OK)
+                err = currentErrorCode();
+        } /* if */
+    } /* for */
+
+    return err;
+} /* syncDurableFiles */
+
+
+PHYSFS_DurabilityGroup *PHYSFS_createDurabilityGroup(void)
+{
+    const size_t len = sizeof (PHYSFS_DurabilityGroup);
+    PHYSFS_DurabilityGroup *retval;
+    retval = (PHYSFS_DurabilityGroup *) allocator.Malloc(len);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(retval, '\0', len);
+    return retval;
+} /* PHYSFS_createDurabilityGroup */
+
+
+int PHYSFS_addToDurabilityGroup(PHYSFS_DurabilityGroup *group,
+                                const char *filename)
+{
+    char *fname;
+
+    BAIL_IF_MACRO(!group, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!filename, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    if (group->count == group->capacity)
+    {
+        const PHYSFS_uint32 newcap = group->capacity ? group->capacity * 2 : 16;
+        void *ptr = allocator.Realloc(group->names, newcap * sizeof (char *));
+        BAIL_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        group->names = (char **) ptr;
+        group->capacity = newcap;
+    } /* if */
+
+    fname = (char *) allocator.Malloc(strlen(filename) + 1);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    if (!sanitizePlatformIndependentPath(filename, fname))
+    {
+        allocator.Free(fname);
+        return 0;
+    } /* if */
+
+    group->names[group->count++] = fname;
+    return 1;
+} /* PHYSFS_addToDurabilityGroup */
+
+
+/* Forget everything in (group). */
+static void clearDurabilityGroup(PHYSFS_DurabilityGroup *group)
+{
+    PHYSFS_uint32 i;
+    for (i = 0; i < group->count; i++)
+        allocator.Free(group->names[i]);
+    group->count = 0;
+} /* clearDurabilityGroup */
+
+
+int PHYSFS_commitDurabilityGroup(PHYSFS_DurabilityGroup *group,
+                                 PHYSFS_AsyncQueue *queue)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+    DurableFile *files = NULL;
+    DirHandle *h;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!group, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    if (group->count == 0)
+        return 1;
+
+    grabLock(ctx->lock);
+
+    h = ctx->writeDir;
+    if (h == NULL)
+        err = PHYSFS_ERR_NO_WRITE_DIR;
+    else if (!h->native)
+        err = PHYSFS_ERR_UNSUPPORTED;
+    else
+    {
+        files = (DurableFile *) allocator.Malloc(sizeof (DurableFile) *
+                                                 group->count);
+        if (files == NULL)
+            err = PHYSFS_ERR_OUT_OF_MEMORY;
+    } /* else */
+
+    for (i = 0; (err == PHYSFS_ERR_OK) && (i < group->count); i++)
+    {
+        char *fname = group->names[i];
+        if (!verifyPath(h, &fname, 0))
+            err = currentErrorCode();
+        files[i].opaque = h->opaque;
+        files[i].name = fname;
+        files[i].error = PHYSFS_ERR_OK;
+        files[i].done = NULL;
+    } /* for */
+
+    if (err == PHYSFS_ERR_OK)
+    {
+        int synced = 0;
+        if (group->count >= DURABILITY_SYNCFS_MIN)
+        {
+            synced = __PHYSFS_DIR_syncFilesystem(h->opaque);
+            if (!synced)
+            {
+                err = PHYSFS_getLastErrorCode();  /* clears it. */
+                if (err == PHYSFS_ERR_UNSUPPORTED)
+                    err = PHYSFS_ERR_OK;  /* do it the slow way, then. */
+            } /* if */
+        } /* if */
+
+        if ((!synced) && (err == PHYSFS_ERR_OK))
+            err = syncDurableFiles(files, group->count, queue);
+    } /* if */
+
+    __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    allocator.Free(files);
+    if (err == PHYSFS_ERR_OK)
+        clearDurabilityGroup(group);
+
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+} /* PHYSFS_commitDurabilityGroup */
+
+
+void PHYSFS_destroyDurabilityGroup(PHYSFS_DurabilityGroup *group)
+{
+    if (group != NULL)
+    {
+        clearDurabilityGroup(group);
+        allocator.Free(group->names);
+        allocator.Free(group);
+    } /* if */
+} /* PHYSFS_destroyDurabilityGroup */
+
+
+/* most raw data to have read while waiting for workers to decode it. */
+#define BATCH_INFLIGHT_MAX (64 * 1024 * 1024)
+
+typedef struct __PHYSFS_BATCHCHUNK__
+{
+    PHYSFS_uint8 *data;      /* raw data for several files, back to back. */
+    PHYSFS_uint64 len;       /* bytes at (data). */
+    PHYSFS_uint32 refcount;  /* files still decoding from (data). */
+} BatchChunk;
+
+typedef struct __PHYSFS_BATCH__
+{
+    PHYSFS_AsyncQueue *queue;  /* NULL if we do it all on this thread. */
+    void *lock;                /* protects everything below. */
+    void *done;                /* posted as each queued file finishes. */
+    PHYSFS_uint64 inflight;    /* bytes in chunks not freed yet. */
+} Batch;
+
+typedef struct __PHYSFS_BATCHFILE__
+{
+    Batch *batch;
+    PHYSFS_File *handle;      /* NULL if it didn't open. */
+    void *buffer;             /* caller's buffer for this file. */
+    PHYSFS_uint64 len;        /* bytes the caller has room for. */
+    PHYSFS_sint64 result;     /* what PHYSFS_readBytes() would say. */
+    PHYSFS_ErrorCode error;   /* why (result) is -1. */
+    int queued;               /* non-zero if it went to batch->queue. */
+    const void *archive;      /* from __PHYSFS_*GetRawSpan(), or NULL. */
+    PHYSFS_Io *src;           /* ...the rest of what it said. */
+    PHYSFS_uint64 pos;
+    PHYSFS_uint64 rawlen;
+    int encoding;
+    int keepRaw;              /* non-zero to hand over (raw) as it is. */
+    int stored;               /* non-zero if (raw) is the file as it is. */
+    BatchChunk *chunk;        /* where (raw) is, or NULL. */
+    const PHYSFS_uint8 *raw;  /* this file's raw data, if we got it. */
+    PHYSFS_uint32 folder;     /* 7z folder, from __PHYSFS_lzmaGetFileSpan(). */
+    struct __PHYSFS_BATCHFILE__ *next;  /* next file in (folder), or NULL. */
+} BatchFile;
+
+
+static void batchReleaseChunk(Batch *batch, BatchChunk *chunk)
+{
+    int last;
+
+    __PHYSFS_platformGrabMutex(batch->lock);
+    last = (--chunk->refcount == 0);
+    if (last)
+        batch->inflight -= chunk->len;
+    __PHYSFS_platformReleaseMutex(batch->lock);
+
+    if (last)
+    {
+        allocator.Free(chunk->data);
+        allocator.Free(chunk);
+    } /* if */
+} /* batchReleaseChunk */
+
+
+/* Read (file)'s compressed data, for PHYSFS_readFilesBatchRaw(). */
+static void batchReadFileRaw(BatchFile *file)
+{
+    if (file->raw != NULL)
+        memcpy(file->buffer, file->raw, (size_t) file->rawlen);
+
+    /* we couldn't read it with the rest, so read it on its own. */
+    else if (__PHYSFS_ioReadAt(file->src, file->buffer, file->rawlen,
+                               file->pos) != (PHYSFS_sint64) file->rawlen)
+    {
+        file->error = PHYSFS_getLastErrorCode();
+        if (file->error == PHYSFS_ERR_OK)
+            file->error = PHYSFS_ERR_CORRUPT;  /* came up short. */
+        return;
+    } /* else if */
+
+    file->result = (PHYSFS_sint64) file->rawlen;
+} /* batchReadFileRaw */
+
+
+/*
+ * We read (io)'s data ourselves, all (len) bytes of it into (buf), so check
+ *  it the way (io) would have; see __PHYSFS_zipCheckWhole().
+ */
+static int batchCheckWhole(PHYSFS_Io *io, const void *buf, PHYSFS_uint64 len)
+{
+#if PHYSFS_SUPPORTS_ZIP
+    if (!__PHYSFS_zipCheckWhole(io, buf, len))
+        return 0;
+#endif
+#if PHYSFS_SUPPORTS_7Z
+    if (!__PHYSFS_lzmaCheckWhole(io, buf, len))
+        return 0;
+#endif
+    return 1;
+} /* batchCheckWhole */
+
+
+/* Read all of one file, decoding its raw data if we have it. */
+static void batchReadFileData(BatchFile *file)
+{
+    PHYSFS_Io *io = ((FileHandle *) file->handle)->io;
+    int decoded = 0;
+
+    if (file->keepRaw)
+        batchReadFileRaw(file);  /* decoding it is the caller's job. */
+    else
+    {
+        if ((file->raw != NULL) && (file->stored))
+        {
+            memcpy(file->buffer, file->raw, (size_t) file->rawlen);
+            decoded = 1;
+        } /* if */
+#if PHYSFS_SUPPORTS_ZIP
+        else if (file->raw != NULL)
+            decoded = __PHYSFS_zipDecodeRaw(io, file->raw, file->buffer);
+#endif
+
+        if (decoded)
+        {
+            file->result = io->length(io);
+            if (!batchCheckWhole(io, file->buffer,
+                                 (PHYSFS_uint64) file->result))
+            {
+                file->result = -1;
+                file->error = PHYSFS_getLastErrorCode();
+            } /* if */
+        } /* if */
+        else
+        {
+            file->result = PHYSFS_readBytes(file->handle, file->buffer,
+                                            file->len);
+            if (file->result < 0)
+                file->error = PHYSFS_getLastErrorCode();
+        } /* else */
+    } /* else */
+
+    if (file->chunk != NULL)
+        batchReleaseChunk(file->batch, file->chunk);
+} /* batchReadFileData */
+
+
+static void batchReadFile(void *data)
+{
+    BatchFile *file = (BatchFile *) data;
+    batchReadFileData(file);
+    if (file->queued)
+        __PHYSFS_platformPostSemaphore(file->batch->done);
+} /* batchReadFile */
+
+
+#if PHYSFS_SUPPORTS_7Z
+/*
+ * Read every file in a 7z folder, listed from (data) on in the order
+ *  they're in it. We keep the folder decompressed until they're all done,
+ *  so it's decompressed once, whatever the cache budget, and if it's
+ *  streamed instead, that's one pass from front to back.
+ */
+static void batchReadFolder(void *data)
+{
+    BatchFile *file = (BatchFile *) data;
+    PHYSFS_Io *io = ((FileHandle *) file->handle)->io;
+    PHYSFS_ErrorCode prevErr;
+    int held;
+
+    /* failing here is no error; each file will say so if need be. */
+    prevErr = PHYSFS_getLastErrorCode();
+    held = __PHYSFS_lzmaHoldFolder(io);
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    for (; file != NULL; file = file->next)
+        batchReadFileData(file);
+
+    if (held)
+        __PHYSFS_lzmaReleaseFolder(io);
+
+    /* once the last one's posted, the caller might free all of these. */
+    file = (BatchFile *) data;
+    while (file != NULL)
+    {
+        BatchFile *next = file->next;
+        if (file->queued)
+            __PHYSFS_platformPostSemaphore(file->batch->done);
+        file = next;
+    } /* while */
+} /* batchReadFolder */
+#endif
+
+
+/* Run (job) on (file) and any files after it in the same 7z folder. */
+static void batchStartFile(Batch *batch, BatchFile *file,
+                           void (*job)(void *data))
+{
+    AsyncRequest req;
+    BatchFile *i;
+
+    if (batch->queue != NULL)
+    {
+        memset(&req, '\0', sizeof (req));
+        req.job = job;
+        req.userdata = file;
+        for (i = file; i != NULL; i = i->next)
+            i->queued = 1;
+        if (queueAsyncRequest(batch->queue, &req))
+            return;
+        for (i = file; i != NULL; i = i->next)
+            i->queued = 0;
+    } /* if */
+
+    job(file);  /* no queue, or out of memory; do it ourselves. */
+} /* batchStartFile */
+
+
+/* Wait until there's room for another (len) bytes of raw data. */
+static void batchWaitForRoom(Batch *batch, const PHYSFS_uint64 len,
+                             PHYSFS_uint32 *waited)
+{
+    while (batch->queue != NULL)
+    {
+        int full;
+        __PHYSFS_platformGrabMutex(batch->lock);
+        full = ( (batch->inflight > 0) &&
+                 (batch->inflight + len > BATCH_INFLIGHT_MAX) );
+        __PHYSFS_platformReleaseMutex(batch->lock);
+        if (!full)
+            break;
+
+        /* something's still decoding, so somebody will post this. */
+        __PHYSFS_platformWaitSemaphore(batch->done);
+        (*waited)++;
+    } /* while */
+} /* batchWaitForRoom */
+
+
+/*
+ * Read the raw data for files[0] through files[count - 1], all from the
+ *  same archive in offset order, from (src), and set them going. A file
+ *  we can't get the raw data for is just read the usual way.
+ */
+static void batchReadChunk(Batch *batch, PHYSFS_Io *src, BatchFile **files,
+                           const PHYSFS_uint32 count, PHYSFS_uint32 *waited)
+{
+    const PHYSFS_uint64 start = files[0]->pos;
+    PHYSFS_uint64 end = start;
+    BatchChunk *chunk = NULL;
+    PHYSFS_ErrorCode prevErr;
+    PHYSFS_uint32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (files[i]->pos + files[i]->rawlen > end)
+            end = files[i]->pos + files[i]->rawlen;
+    } /* for */
+
+    batchWaitForRoom(batch, end - start, waited);
+
+    /* failing here is no error; the files will just be read normally. */
+    prevErr = PHYSFS_getLastErrorCode();
+    if ((src != NULL) && (__PHYSFS_ui64FitsAddressSpace(end - start)))
+        chunk = (BatchChunk *) allocator.Malloc(sizeof (BatchChunk));
+    if (chunk != NULL)
+    {
+        chunk->len = end - start;
+        chunk->refcount = count;
+        chunk->data = (PHYSFS_uint8 *) allocator.Malloc((size_t) chunk->len);
+        if ( (chunk->data == NULL) ||
+             (__PHYSFS_ioReadAt(src, chunk->data, chunk->len, start) !=
+                (PHYSFS_sint64) chunk->len) )
+        {
+            allocator.Free(chunk->data);
+            allocator.Free(chunk);
+            chunk = NULL;
+        } /* if */
+    } /* if */
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    if (chunk != NULL)
+    {
+        __PHYSFS_platformGrabMutex(batch->lock);
+        batch->inflight += chunk->len;
+        __PHYSFS_platformReleaseMutex(batch->lock);
+    } /* if */
+
+    for (i = 0; i < count; i++)
+    {
+        if (chunk != NULL)
+        {
+            files[i]->chunk = chunk;
+            files[i]->raw = chunk->data + (files[i]->pos - start);
+        } /* if */
+        batchStartFile(batch, files[i], batchReadFile);
+    } /* for */
+} /* batchReadChunk */
+
+
+/*
+ * Can we read (file)'s raw data ourselves? See __PHYSFS_zipGetRawSpan and
+ *  __PHYSFS_ppkGetRawSpan. If it's compressed, at least (rawMin) bytes
+ *  uncompressed, and the caller wants compressed data, it'll get that
+ *  instead. We only decode raw data from ZIPs, so PPKs' are only for that.
+ *  Files stored as they are in other archives get read the same way.
+ */
+static int batchGetRawSpan(BatchFile *file, const PHYSFS_uint64 rawMin)
+{
+    PHYSFS_Io *io = ((FileHandle *) file->handle)->io;
+    const PHYSFS_sint64 len = io->length(io);
+    int decodable = 0;
+    int found = 0;
+
+    if (len < 0)
+        return 0;
+
+#if PHYSFS_SUPPORTS_ZIP
+    found = decodable = __PHYSFS_zipGetRawSpan(io, &file->archive,
+                                               &file->src, &file->pos,
+                                               &file->rawlen, &file->encoding);
+#endif
+#if PHYSFS_SUPPORTS_PPK
+    if ((!found) && (rawMin > 0))
+    {
+        found = __PHYSFS_ppkGetRawSpan(io, &file->archive, &file->src,
+                                       &file->pos, &file->rawlen,
+                                       &file->encoding);
+    } /* if */
+#endif
+
+    if ((!found) && (ioGetStoredSpan(io, &file->archive, &file->src,
+                                     &file->pos, &file->rawlen)))
+    {
+        found = decodable = file->stored = 1;
+        file->encoding = (int) PHYSFS_ENCODING_IDENTITY;
+    } /* if */
+
+    if (!found)
+        return 0;
+
+    file->keepRaw = ((rawMin > 0) &&
+                     (file->encoding != (int) PHYSFS_ENCODING_IDENTITY) &&
+                     ((PHYSFS_uint64) len >= rawMin));
+    if (file->keepRaw)
+        return (file->rawlen <= file->len);
+    else if (!decodable)
+        return 0;
+    return ((PHYSFS_uint64) len <= file->len);  /* or wants only part. */
+} /* batchGetRawSpan */
+
+
+/* Is (file) in a 7z archive? Those get read a folder at a time. */
+static int batchGetFolderSpan(BatchFile *file)
+{
+#if PHYSFS_SUPPORTS_7Z
+    PHYSFS_Io *io = ((FileHandle *) file->handle)->io;
+    return __PHYSFS_lzmaGetFileSpan(io, &file->archive, &file->folder,
+                                    &file->pos);
+#else
+    return 0;
+#endif
+} /* batchGetFolderSpan */
+
+
+static int cmpBatchFiles(void *_a, size_t one, size_t two)
+{
+    BatchFile **files = (BatchFile **) _a;
+    const BatchFile *a = files[one];
+    const BatchFile *b = files[two];
+
+    if (a->archive != b->archive)
+        return (a->archive < b->archive) ? -1 : 1;
+    else if (a->folder != b->folder)
+        return (a->folder < b->folder) ? -1 : 1;
+    else if (a->pos != b->pos)
+        return (a->pos < b->pos) ? -1 : 1;
+    return 0;
+} /* cmpBatchFiles */
+
+
+static void swapBatchFiles(void *_a, size_t one, size_t two)
+{
+    BatchFile **files = (BatchFile **) _a;
+    BatchFile *tmp = files[one];
+    files[one] = files[two];
+    files[two] = tmp;
+} /* swapBatchFiles */
+
+
+/*
+ * PHYSFS_readFilesBatch() and PHYSFS_readFilesBatchRaw(). (encodings) is
+ *  NULL and (rawMin) is zero for the former.
+ */
+static int readFilesBatch(PHYSFS_AsyncQueue *queue, const char **paths,
+                          void **buffers, const PHYSFS_uint64 *lens,
+                          PHYSFS_sint64 *results,
+                          PHYSFS_Encoding *encodings,
+                          const PHYSFS_uint64 rawMin,
+                          PHYSFS_uint32 count)
+{
+    PHYSFS_ErrorCode err = PHYSFS_ERR_OK;
+    BatchFile *files = NULL;
+    BatchFile **sorted = NULL;
+    BatchFile **solid = NULL;
+    PHYSFS_uint32 numSorted = 0;
+    PHYSFS_uint32 numSolid = 0;
+    PHYSFS_uint32 numQueued = 0;
+    PHYSFS_uint32 waited = 0;
+    PHYSFS_uint64 gap;
+    PHYSFS_uint64 max;
+    PHYSFS_uint32 i;
+    Batch batch;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(count == 0, ERRPASS, 1);
+    BAIL_IF_MACRO(!paths || !buffers, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!lens || !results, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    memset(&batch, '\0', sizeof (batch));
+    batch.lock = __PHYSFS_platformCreateMutex();
+    GOTO_IF_MACRO(!batch.lock, ERRPASS, readFilesBatchFailed);
+    if ((queue != NULL) && (queue->numThreads > 0))
+    {
+        /* without a semaphore, we can't wait for them; do it ourselves. */
+        batch.done = __PHYSFS_platformCreateSemaphore();
+        if (batch.done != NULL)
+            batch.queue = queue;
+    } /* if */
+
+    files = (BatchFile *) allocator.Malloc(sizeof (BatchFile) * count);
+    sorted = (BatchFile **) allocator.Malloc(sizeof (BatchFile *) *
+                                             count * 2);
+    GOTO_IF_MACRO(!files || !sorted, PHYSFS_ERR_OUT_OF_MEMORY,
+                  readFilesBatchFailed);
+    memset(files, '\0', sizeof (BatchFile) * count);
+    solid = sorted + count;
+
+    /*
+     * Open everything first. Files we can read raw data for get sorted
+     *  by where that is, and read in big sequential pieces below. Files in
+     *  7z archives get sorted by folder, and each folder's are read in one
+     *  go, on the queue. The rest are read the usual way, on the queue,
+     *  while we do all that.
+     */
+    for (i = 0; i < count; i++)
+    {
+        BatchFile *file = &files[i];
+
+        file->batch = &batch;
+        file->buffer = buffers[i];
+        file->len = lens[i];
+        file->result = -1;
+        file->handle = PHYSFS_openRead(paths[i]);
+        if (file->handle == NULL)
+        {
+            file->error = PHYSFS_getLastErrorCode();
+            continue;
+        } /* if */
+
+        if (batchGetRawSpan(file, rawMin))
+            sorted[numSorted++] = file;
+        else if (batchGetFolderSpan(file))
+            solid[numSolid++] = file;
+        else
+        {
+            file->archive = NULL;
+            file->keepRaw = 0;
+            batchStartFile(&batch, file, batchReadFile);
+        } /* else */
+    } /* for */
+
+#if PHYSFS_SUPPORTS_7Z
+    __PHYSFS_sort(solid, numSolid, cmpBatchFiles, swapBatchFiles);
+
+    /* one job per 7z folder, so that's all decompressed in one place. */
+    i = 0;
+    while (i < numSolid)
+    {
+        PHYSFS_uint32 n = 1;
+        while ((i + n < numSolid) &&
+               (solid[i + n]->archive == solid[i]->archive) &&
+               (solid[i + n]->folder == solid[i]->folder))
+        {
+            solid[i + n - 1]->next = solid[i + n];
+            n++;
+        } /* while */
+
+        batchStartFile(&batch, solid[i], batchReadFolder);
+        i += n;
+    } /* while */
+#endif
+
+    __PHYSFS_sort(sorted, numSorted, cmpBatchFiles, swapBatchFiles);
+
+    gap = readCoalesceGap;
+    max = readCoalesceMax;
+    i = 0;
+    while (i < numSorted)
+    {
+        const void *archive = sorted[i]->archive;
+        PHYSFS_Io *src = sorted[i]->src->duplicate(sorted[i]->src);
+
+        /* (src) is ours, so reading it doesn't get in the workers' way. */
+        while ((i < numSorted) && (sorted[i]->archive == archive))
+        {
+            const PHYSFS_uint64 start = sorted[i]->pos;
+            PHYSFS_uint64 end = start + sorted[i]->rawlen;
+            PHYSFS_uint32 n = 1;
+
+            while ((i + n < numSorted) && (sorted[i+n]->archive == archive))
+            {
+                const BatchFile *next = sorted[i + n];
+                const PHYSFS_uint64 nextend = next->pos + next->rawlen;
+                if (next->pos > end + gap)
+                    break;
+                else if ((nextend > end) && (nextend - start > max))
+                    break;
+                if (nextend > end)
+                    end = nextend;
+                n++;
+            } /* while */
+
+            batchReadChunk(&batch, src, &sorted[i], n, &waited);
+            i += n;
+        } /* while */
+
+        if (src != NULL)
+            src->destroy(src);
+    } /* while */
+
+    for (i = 0; i < count; i++)
+        numQueued += files[i].queued ? 1 : 0;
+    while (waited < numQueued)
+    {
+        __PHYSFS_platformWaitSemaphore(batch.done);
+        waited++;
+    } /* while */
+
+    for (i = 0; i < count; i++)
+    {
+        results[i] = files[i].result;
+        if (encodings != NULL)
+        {
+            encodings[i] = (files[i].keepRaw) ?
+                (PHYSFS_Encoding) files[i].encoding :
+                PHYSFS_ENCODING_IDENTITY;
+        } /* if */
+        if ((files[i].result < 0) && (err == PHYSFS_ERR_OK))
+            err = (files[i].error != PHYSFS_ERR_OK) ?
+                    files[i].error : PHYSFS_ERR_OTHER_ERROR;
+        if (files[i].handle != NULL)
+            PHYSFS_close(files[i].handle);
+    } /* for */
+
+    allocator.Free(sorted);
+    allocator.Free(files);
+    if (batch.done != NULL)
+        __PHYSFS_platformDestroySemaphore(batch.done);
+    __PHYSFS_platformDestroyMutex(batch.lock);
+
+    BAIL_IF_MACRO(err != PHYSFS_ERR_OK, err, 0);
+    return 1;
+
+readFilesBatchFailed:
+    allocator.Free(sorted);
+    allocator.Free(files);
+    if (batch.done != NULL)
+        __PHYSFS_platformDestroySemaphore(batch.done);
+    if (batch.lock != NULL)
+        __PHYSFS_platformDestroyMutex(batch.lock);
+    return 0;
+} /* readFilesBatch */
+
+
+int PHYSFS_readFilesBatch(PHYSFS_AsyncQueue *queue, const char **paths,
+                          void **buffers, const PHYSFS_uint64 *lens,
+                          PHYSFS_sint64 *results, PHYSFS_uint32 count)
+{
+    return readFilesBatch(queue, paths, buffers, lens, results, NULL, 0,
+                          count);
+} /* PHYSFS_readFilesBatch */
+
+
+int PHYSFS_readFilesBatchRaw(PHYSFS_AsyncQueue *queue, const char **paths,
+                             void **buffers, const PHYSFS_uint64 *lens,
+                             PHYSFS_sint64 *results,
+                             PHYSFS_Encoding *encodings,
+                             PHYSFS_uint64 minRawSize, PHYSFS_uint32 count)
+{
+    BAIL_IF_MACRO(!encodings, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    if (minRawSize == 0)
+        minRawSize = 1;  /* zero means "never" to readFilesBatch(). */
+    return readFilesBatch(queue, paths, buffers, lens, results, encodings,
+                          minRawSize, count);
+} /* PHYSFS_readFilesBatchRaw */
+
+
+typedef struct __PHYSFS_PREFETCHOPEN__
+{
+    PHYSFS_Context *ctx;   /* the caller's, not the worker thread's. */
+    const char *path;
+    PHYSFS_File *handle;   /* NULL if it couldn't be opened. */
+    int queued;            /* non-zero if it went to the queue. */
+    void *done;            /* posted when a queued one finishes. */
+} PrefetchOpen;
+
+
+/*
+ * Open one file for PHYSFS_prefetch(). That alone puts a compressed ZIP
+ *  entry in the decompression cache, if it fits. Then ask the OS to start
+ *  reading whatever the file's data really is: its range of a mapped or
+ *  native archive, its sectors of an ISO, or the file itself.
+ */
+static void prefetchOpen(void *data)
+{
+    PrefetchOpen *po = (PrefetchOpen *) data;
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+
+    /* it's only a hint, so files that aren't there are no error. */
+    po->handle = openRead(po->ctx, po->path);
+    if (po->handle != NULL)
+    {
+        __PHYSFS_ioAdvise(((FileHandle *) po->handle)->io, 0, 0,
+                          PHYSFS_ACCESS_WILLNEED);
+    } /* if */
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    if (po->queued)
+        __PHYSFS_platformPostSemaphore(po->done);
+} /* prefetchOpen */
+
+
+#if PHYSFS_SUPPORTS_7Z
+typedef struct __PHYSFS_PREFETCHFOLDER__
+{
+    void *archive;         /* from __PHYSFS_lzmaGetFolder()... */
+    PHYSFS_Io *src;        /* ...and the rest, (src) being a copy once wanted. */
+    PHYSFS_uint32 folder;
+    PHYSFS_uint64 len;
+    int wanted;            /* non-zero if it fits in the cache budget. */
+    int queued;            /* non-zero if it went to the queue. */
+    void *done;            /* posted when a queued one finishes. */
+    void *data;            /* decompressed folder, or NULL if that failed. */
+    size_t datalen;
+} PrefetchFolder;
+
+
+static void prefetchDecodeFolder(void *data)
+{
+    PrefetchFolder *pf = (PrefetchFolder *) data;
+    PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+
+    /* failing is no error; it just won't be cached, and that's that. */
+    if (!__PHYSFS_lzmaDecodeFolder(pf->archive, pf->folder, pf->src,
+                                   &pf->data, &pf->datalen))
+        pf->data = NULL;
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+
+    if (pf->queued)
+        __PHYSFS_platformPostSemaphore(pf->done);
+} /* prefetchDecodeFolder */
+
+
+static int cmpPrefetchFolders(void *_a, size_t one, size_t two)
+{
+    const PrefetchFolder *a = ((PrefetchFolder *) _a) + one;
+    const PrefetchFolder *b = ((PrefetchFolder *) _a) + two;
+
+    if (a->archive != b->archive)
+        return (a->archive < b->archive) ? -1 : 1;
+    else if (a->folder != b->folder)
+        return (a->folder < b->folder) ? -1 : 1;
+    return 0;
+} /* cmpPrefetchFolders */
+
+
+static void swapPrefetchFolders(void *_a, size_t one, size_t two)
+{
+    PrefetchFolder *folders = (PrefetchFolder *) _a;
+    PrefetchFolder tmp;
+    memcpy(&tmp, &folders[one], sizeof (tmp));
+    memcpy(&folders[one], &folders[two], sizeof (tmp));
+    memcpy(&folders[two], &tmp, sizeof (tmp));
+} /* swapPrefetchFolders */
+
+
+/*
+ * Decompress the 7z folders that (handles) are in, as many as fit in their
+ *  archives' caches, on (queue) if it has threads, and cache them.
+ */
+static int prefetchFolders(PHYSFS_AsyncQueue *queue, PHYSFS_File **handles,
+                           const PHYSFS_uint32 count)
+{
+    const PHYSFS_uint64 budget = __PHYSFS_getDecompressionCacheSize();
+    PrefetchFolder *folders = NULL;
+    PHYSFS_uint32 numFolders = 0;
+    PHYSFS_uint32 numQueued = 0;
+    PHYSFS_uint64 used = 0;
+    void *done = NULL;
+    PHYSFS_uint32 i;
+
+    folders = (PrefetchFolder *) allocator.Malloc(sizeof (PrefetchFolder) *
+                                                  count);
+    BAIL_IF_MACRO(!folders, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(folders, '\0', sizeof (PrefetchFolder) * count);
+
+    grabStateLock();
+    for (i = 0; i < count; i++)
+    {
+        PrefetchFolder *pf = &folders[numFolders];
+        if (handles[i] == NULL)
+            continue;
+        else if (__PHYSFS_lzmaGetFolder(((FileHandle *) handles[i])->io,
+                                        &pf->archive, &pf->src,
+                                        &pf->folder, &pf->len))
+            numFolders++;
+    } /* for */
+    __PHYSFS_platformReleaseMutex(stateLock);
+
+    /* one of each, and only as much of each archive as it'll keep. */
+    __PHYSFS_sort(folders, numFolders, cmpPrefetchFolders, swapPrefetchFolders);
+    for (i = 0; i < numFolders; i++)
+    {
+        PrefetchFolder *pf = &folders[i];
+        if ((i == 0) || (pf->archive != folders[i-1].archive))
+            used = 0;
+        else if (pf->folder == folders[i-1].folder)
+            continue;
+
+        if ((pf->len <= budget) && (budget - pf->len >= used) &&
+            (__PHYSFS_ui64FitsAddressSpace(pf->len)))
+        {
+            pf->wanted = 1;
+            used += pf->len;
+        } /* if */
+    } /* for */
+
+    if ((queue != NULL) && (queue->numThreads > 0))
+        done = __PHYSFS_platformCreateSemaphore();
+
+    for (i = 0; i < numFolders; i++)
+    {
+        PrefetchFolder *pf = &folders[i];
+        AsyncRequest req;
+
+        if (!pf->wanted)
+            continue;
+
+        pf->src = pf->src->duplicate(pf->src);
+        if (pf->src == NULL)
+        {
+            pf->wanted = 0;
+            continue;
+        } /* if */
+
+        if (done != NULL)
+        {
+            memset(&req, '\0', sizeof (req));
+            req.job = prefetchDecodeFolder;
+            req.userdata = pf;
+            req.priority = PHYSFS_ASYNC_PREFETCH;
+            pf->done = done;
+            pf->queued = 1;
+            if (queueAsyncRequest(queue, &req))
+            {
+                numQueued++;
+                continue;
+            } /* if */
+            pf->queued = 0;
+        } /* if */
+
+        prefetchDecodeFolder(pf);  /* no queue, or out of memory. */
+    } /* for */
+
+    for (i = 0; i < numQueued; i++)
+        __PHYSFS_platformWaitSemaphore(done);
+
+    grabStateLock();
+    for (i = 0; i < numFolders; i++)
+    {
+        PrefetchFolder *pf = &folders[i];
+        if (!pf->wanted)
+            continue;
+        pf->src->destroy(pf->src);
+        if (pf->data != NULL)
+        {
+            __PHYSFS_lzmaCacheFolder(pf->archive, pf->folder,
+                                     pf->data, pf->datalen);
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(stateLock);
+
+    if (done != NULL)
+        __PHYSFS_platformDestroySemaphore(done);
+    allocator.Free(folders);
+    return 1;
+} /* prefetchFolders */
+#endif
+
+
+int PHYSFS_prefetch(PHYSFS_AsyncQueue *queue, const char **paths,
+                    PHYSFS_uint32 count)
+{
+    PrefetchOpen *opens = NULL;
+    PHYSFS_File **handles = NULL;
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_uint32 numQueued = 0;
+    void *done = NULL;
+    int retval = 1;
+    PHYSFS_uint32 i;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(count == 0, ERRPASS, 1);
+    BAIL_IF_MACRO(!paths, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    handles = (PHYSFS_File **) allocator.Malloc(sizeof (PHYSFS_File *) *
+                                                count);
+    BAIL_IF_MACRO(!handles, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    opens = (PrefetchOpen *) allocator.Malloc(sizeof (PrefetchOpen) * count);
+    if (!opens)
+    {
+        allocator.Free(handles);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+    memset(opens, '\0', sizeof (PrefetchOpen) * count);
+
+    /* opening is what inflates into the ZIP cache, so spread it out, too. */
+    if ((queue != NULL) && (queue->numThreads > 0))
+        done = __PHYSFS_platformCreateSemaphore();
+
+    for (i = 0; i < count; i++)
+    {
+        PrefetchOpen *po = &opens[i];
+        po->ctx = ctx;
+        po->path = paths[i];
+        if (done != NULL)
+        {
+            AsyncRequest req;
+            memset(&req, '\0', sizeof (req));
+            req.job = prefetchOpen;
+            req.userdata = po;
+            req.priority = PHYSFS_ASYNC_PREFETCH;
+            po->done = done;
+            po->queued = 1;
+            if (queueAsyncRequest(queue, &req))
+            {
+                numQueued++;
+                continue;
+            } /* if */
+            po->queued = 0;
+        } /* if */
+
+        prefetchOpen(po);  /* no queue, or out of memory. */
+    } /* for */
+
+    for (i = 0; i < numQueued; i++)
+        __PHYSFS_platformWaitSemaphore(done);
+    if (done != NULL)
+        __PHYSFS_platformDestroySemaphore(done);
+
+    for (i = 0; i < count; i++)
+        handles[i] = opens[i].handle;
+    allocator.Free(opens);
+
+    /* (handles) stay open meanwhile, so their archives can't go away. */
+#if PHYSFS_SUPPORTS_7Z
+    retval = prefetchFolders(queue, handles, count);
+#endif
+
+    for (i = 0; i < count; i++)
+    {
+        if (handles[i] != NULL)
+            PHYSFS_close(handles[i]);
+    } /* for */
+    allocator.Free(handles);
+
+    return retval;
+} /* PHYSFS_prefetch */
+
+
+/* PHYSFS_Stats is nothing but PHYSFS_uint64s, so walk it like an array. */
+#define NUM_STATS (sizeof (PHYSFS_Stats) / sizeof (PHYSFS_uint64))
+
+void PHYSFS_getStats(PHYSFS_Stats *stats)
+{
+    PHYSFS_uint64 *counters = (PHYSFS_uint64 *) &__PHYSFS_stats;
+    PHYSFS_uint64 *out = (PHYSFS_uint64 *) stats;
+    size_t i;
+
+    if (stats == NULL)
+        return;
+
+    for (i = 0; i < NUM_STATS; i++)
+        out[i] = __PHYSFS_ATOMIC_ADD64(&counters[i], 0);  /* atomic read. */
+} /* PHYSFS_getStats */
+
+
+void PHYSFS_resetStats(void)
+{
+    PHYSFS_uint64 *counters = (PHYSFS_uint64 *) &__PHYSFS_stats;
+    size_t i;
+
+    /* subtract what we saw, so counts that race with us aren't lost. */
+    for (i = 0; i < NUM_STATS; i++)
+    {
+        const PHYSFS_uint64 val = __PHYSFS_ATOMIC_ADD64(&counters[i], 0);
+        __PHYSFS_ATOMIC_ADD64(&counters[i], (PHYSFS_uint64) 0 - val);
+    } /* for */
+} /* PHYSFS_resetStats */
+
+
+int PHYSFS_getMemoryUsage(const char *dir, PHYSFS_MemoryUsage *usage)
+{
+    __PHYSFS_MemAccount *acct = &memTotals;
+    PHYSFS_Context *ctx = NULL;
+    DirHandle *i;
+    int c;
+
+    BAIL_IF_MACRO(!usage, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    if (dir != NULL)
+    {
+        BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+        ctx = currentContext();
+        grabLock(ctx->lock);
+        for (i = ctx->searchPath; i != NULL; i = i->next)
+        {
+            if (strcmp(i->dirName, dir) == 0)
+                break;
+        } /* for */
+        BAIL_IF_MACRO_MUTEX(!i, PHYSFS_ERR_NOT_MOUNTED, ctx->lock, 0);
+        acct = i->mem;
+    } /* if */
+
+    /* accounts live as long as their mounts: read it before letting go. */
+    usage->total = 0;
+    for (c = 0; c < PHYSFS_MEMORY_CATEGORIES; c++)
+    {
+        usage->bytes[c] = __PHYSFS_ATOMIC_ADD64(&acct->bytes[c], 0);
+        usage->total += usage->bytes[c];
+    } /* for */
+
+    if (ctx != NULL)
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+
+    return 1;
+} /* PHYSFS_getMemoryUsage */
+
+
+int PHYSFS_setMemoryLimit(PHYSFS_MemoryCategory category,
+                          PHYSFS_uint64 bytes)
+{
+    BAIL_IF_MACRO((category < 0) || (category >= PHYSFS_MEMORY_CATEGORIES),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    /* nothing can go without an index or a file handle, or unpinning. */
+    BAIL_IF_MACRO((category == PHYSFS_MEMORY_INDEX) ||
+                  (category == PHYSFS_MEMORY_HANDLES) ||
+                  (category == PHYSFS_MEMORY_PINNED),
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+
+    memLimits[category] = bytes;
+    return 1;
+} /* PHYSFS_setMemoryLimit */
+
+
+int PHYSFS_enableAccessProfile(int enable)
+{
+    PHYSFS_Context *ctx;
+    FileHandle *fh;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    if (!enable)
+    {
+        profiling = 0;  /* keep what we have for PHYSFS_writeAccessProfile. */
+        return 1;
+    } /* if */
+
+    /* start over: files already open don't count. */
+    lockAllContexts();
+    __PHYSFS_platformGrabMutex(profileLock);
+    for (ctx = &defaultContext; ctx != NULL; ctx = ctx->next)
+    {
+        for (fh = ctx->openReadList; fh != NULL; fh = fh->next)
+            fh->profile = NULL;
+    } /* for */
+    freeAccessProfile();
+    profiling = 1;
+    __PHYSFS_platformReleaseMutex(profileLock);
+    unlockAllContexts();
+    return 1;
+} /* PHYSFS_enableAccessProfile */
+
+
+typedef struct
+{
+    PHYSFS_File *out;
+    int ok;  /* zero once a write fails; everything after is skipped. */
+} ProfileWriter;
+
+static void profilePuts(ProfileWriter *w, const char *str)
+{
+    const PHYSFS_uint64 len = (PHYSFS_uint64) strlen(str);
+    if ((w->ok) && (PHYSFS_writeBytes(w->out, str, len) != (PHYSFS_sint64) len))
+        w->ok = 0;
+} /* profilePuts */
+
+static void profilePutNum(ProfileWriter *w, PHYSFS_uint64 val)
+{
+    char buf[24];
+    char *ptr = buf + sizeof (buf) - 1;
+
+    *ptr = '\0';
+    do
+    {
+        *(--ptr) = (char) ('0' + (int) (val % 10));
+        val /= 10;
+    } while (val > 0);
+
+    profilePuts(w, ptr);
+} /* profilePutNum */
+
+/* write (str) as a quoted CSV field or JSON string. */
+static void profilePutString(ProfileWriter *w, const char *str, int json)
+{
+    char buf[8];
+
+    profilePuts(w, "\"");
+    for (; *str; str++)
+    {
+        const unsigned char ch = (unsigned char) *str;
+        if (ch == '"')
+            profilePuts(w, json ? "\\\"" : "\"\"");
+        else if ((json) && (ch == '\\'))
+            profilePuts(w, "\\\\");
+        else if ((json) && (ch < 0x20))
+        {
+            static const char hex[] = "0123456789abcdef";
+            buf[0] = '\\'; buf[1] = 'u'; buf[2] = '0'; buf[3] = '0';
+            buf[4] = hex[ch >> 4]; buf[5] = hex[ch & 0xF]; buf[6] = '\0';
+            profilePuts(w, buf);
+        } /* else if */
+        else
+        {
+            buf[0] = (char) ch;
+            buf[1] = '\0';
+            profilePuts(w, buf);
+        } /* else */
+    } /* for */
+    profilePuts(w, "\"");
+} /* profilePutString */
+
+static void profileWriteCsv(ProfileWriter *w)
+{
+    const ProfileMount *mount;
+    const ProfileFile *file;
+    const ProfileSpan *span;
+
+    profilePuts(w, "archive,mountpoint,order,path,opens,bytesread,"
+                   "offset,length\n");
+    for (mount = profileMounts; mount != NULL; mount = mount->next)
+    {
+        for (file = mount->files; file != NULL; file = file->next)
+        {
+            /* one row per span read; files never read still get a row. */
+            span = file->spans;
+            do
+            {
+                profilePutString(w, mount->dirName, 0);
+                profilePuts(w, ",");
+                profilePutString(w, mount->mountPoint, 0);
+                profilePuts(w, ",");
+                profilePutNum(w, file->order);
+                profilePuts(w, ",");
+                profilePutString(w, file->path, 0);
+                profilePuts(w, ",");
+                profilePutNum(w, file->opens);
+                profilePuts(w, ",");
+                profilePutNum(w, file->bytesRead);
+                profilePuts(w, ",");
+                if (span != NULL)
+                {
+                    profilePutNum(w, span->offset);
+                    profilePuts(w, ",");
+                    profilePutNum(w, span->len);
+                    span = span->next;
+                } /* if */
+                else
+                {
+                    profilePuts(w, ",");
+                } /* else */
+                profilePuts(w, "\n");
+            } while (span != NULL);
+        } /* for */
+    } /* for */
+} /* profileWriteCsv */
+
+static void profileWriteJson(ProfileWriter *w)
+{
+    const ProfileMount *mount;
+    const ProfileFile *file;
+    const ProfileSpan *span;
 
-    BAIL_IF_MACRO(!retval, PHYSFS_ERR_UNSUPPORTED, NULL);
-    return retval;
-} /* openDirectory */
+    profilePuts(w, "{\n  \"mounts\": [");
+    for (mount = profileMounts; mount != NULL; mount = mount->next)
+    {
+        profilePuts(w, (mount == profileMounts) ? "\n" : ",\n");
+        profilePuts(w, "    {\n      \"archive\": ");
+        profilePutString(w, mount->dirName, 1);
+        profilePuts(w, ",\n      \"mountPoint\": ");
+        profilePutString(w, mount->mountPoint, 1);
+        profilePuts(w, ",\n      \"files\": [");
+        for (file = mount->files; file != NULL; file = file->next)
+        {
+            profilePuts(w, (file == mount->files) ? "\n" : ",\n");
+            profilePuts(w, "        { \"order\": ");
+            profilePutNum(w, file->order);
+            profilePuts(w, ", \"path\": ");
+            profilePutString(w, file->path, 1);
+            profilePuts(w, ", \"opens\": ");
+            profilePutNum(w, file->opens);
+            profilePuts(w, ", \"bytesRead\": ");
+            profilePutNum(w, file->bytesRead);
+            profilePuts(w, ", \"reads\": [");
+            for (span = file->spans; span != NULL; span = span->next)
+            {
+                profilePuts(w, (span == file->spans) ? "[" : ", [");
+                profilePutNum(w, span->offset);
+                profilePuts(w, ", ");
+                profilePutNum(w, span->len);
+                profilePuts(w, "]");
+            } /* for */
+            profilePuts(w, "] }");
+        } /* for */
+        profilePuts(w, (mount->files != NULL) ? "\n      ]\n    }" : "]\n    }");
+    } /* for */
+    profilePuts(w, (profileMounts != NULL) ? "\n  ]\n}\n" : "]\n}\n");
+} /* profileWriteJson */
+
+
+int PHYSFS_writeAccessProfile(const char *filename, PHYSFS_ProfileFormat fmt)
+{
+    ProfileWriter w;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO((fmt != PHYSFS_PROFILE_CSV) && (fmt != PHYSFS_PROFILE_JSON),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    w.out = PHYSFS_openWrite(filename);
+    BAIL_IF_MACRO(!w.out, ERRPASS, 0);
+    PHYSFS_setBuffer(w.out, 64 * 1024);  /* lots of tiny writes coming. */
+    w.ok = 1;
+
+    __PHYSFS_platformGrabMutex(profileLock);
+    if (fmt == PHYSFS_PROFILE_CSV)
+        profileWriteCsv(&w);
+    else
+        profileWriteJson(&w);
+    __PHYSFS_platformReleaseMutex(profileLock);
+
+    if (!PHYSFS_close(w.out))  /* last flush failed? */
+        w.ok = 0;
+
+    return w.ok;
+} /* PHYSFS_writeAccessProfile */
 
 
 /*
- * Make a platform-independent path string sane. Doesn't actually check the
- *  file hierarchy, it just cleans up the string.
- *  (dst) must be a buffer at least as big as (src), as this is where the
- *  cleaned up string is deposited.
- * If there are illegal bits in the path (".." entries, etc) then we
- *  return zero and (dst) is undefined. Non-zero if the path was sanitized.
+ * Find (path)'s node in the predictor, adding it if (create) is non-zero
+ *  and there's room. MAKE SURE you hold predictLock before calling this!
  */
-static int sanitizePlatformIndependentPath(const char *src, char *dst)
+static PredictNode *predictFindNode(const char *path, const int create)
 {
-    char *prev;
-    char ch;
+    const PHYSFS_uint32 hash = hashIndexPath(path);
+    const size_t slot = hash & (PREDICT_HASH_SLOTS - 1);
+    const size_t len = strlen(path) + 1;
+    PredictNode *node;
 
-    while (*src == '/')  /* skip initial '/' chars... */
-        src++;
+    for (node = predictHash[slot]; node != NULL; node = node->hashNext)
+    {
+        if ((node->hash == hash) && (strcmp(node->path, path) == 0))
+            return node;
+    } /* for */
 
-    prev = dst;
-    do
+    if ((!create) || (predictNodeCount >= PREDICT_MAX_NODES))
+        return NULL;
+
+    node = (PredictNode *) allocator.Malloc(sizeof (PredictNode));
+    if (node == NULL)
+        return NULL;
+    memset(node, '\0', sizeof (PredictNode));
+    node->path = (char *) allocator.Malloc(len);
+    if (node->path == NULL)
     {
-        ch = *(src++);
+        allocator.Free(node);
+        return NULL;
+    } /* if */
 
-        if ((ch == ':') || (ch == '\\'))  /* illegal chars in a physfs path. */
-            BAIL_MACRO(PHYSFS_ERR_BAD_FILENAME, 0);
+    memcpy(node->path, path, len);
+    node->hash = hash;
+    node->hashNext = predictHash[slot];
+    predictHash[slot] = node;
+    predictNodeCount++;
+    return node;
+} /* predictFindNode */
 
-        if (ch == '/')   /* path separator. */
-        {
-            *dst = '\0';  /* "." and ".." are illegal pathnames. */
-            if ((strcmp(prev, ".") == 0) || (strcmp(prev, "..") == 0))
-                BAIL_MACRO(PHYSFS_ERR_BAD_FILENAME, 0);
 
-            while (*src == '/')   /* chop out doubles... */
-                src++;
+/* Note (to) was opened right after (from) (count) more times. Hold predictLock. */
+static void predictLearn(PredictNode *from, PredictNode *to,
+                         const PHYSFS_uint32 count)
+{
+    PHYSFS_uint32 i;
 
-            if (*src == '\0') /* ends with a pathsep? */
-                break;  /* we're done, don't add final pathsep to dst. */
+    for (i = 0; i < PREDICT_SUCCESSORS - 1; i++)
+    {
+        if ((from->next[i] == to) || (from->next[i] == NULL))
+            break;
+    } /* for */
 
-            prev = dst + 1;
-        } /* if */
+    /* not there, and no room: it takes the least frequent one's place. */
+    if (from->next[i] != to)
+    {
+        from->next[i] = to;
+        from->count[i] = 0;
+    } /* if */
 
-        *(dst++) = ch;
-    } while (ch != '\0');
+    if (from->count[i] > 0xFFFFFFFF - count)
+        from->count[i] = 0xFFFFFFFF;
+    else
+        from->count[i] += count;
 
-    return 1;
-} /* sanitizePlatformIndependentPath */
+    /* keep them most frequent first. */
+    while ((i > 0) && (from->count[i] > from->count[i - 1]))
+    {
+        PredictNode *node = from->next[i];
+        const PHYSFS_uint32 tmp = from->count[i];
+        from->next[i] = from->next[i - 1];
+        from->count[i] = from->count[i - 1];
+        from->next[i - 1] = node;
+        from->count[i - 1] = tmp;
+        i--;
+    } /* while */
+} /* predictLearn */
 
 
 /*
- * Figure out if (fname) is part of (h)'s mountpoint. (fname) must be an
- *  output from sanitizePlatformIndependentPath(), so that it is in a known
- *  state.
- *
- * This only finds legitimate segments of a mountpoint. If the mountpoint is
- *  "/a/b/c" and (fname) is "/a/b/c", "/", or "/a/b/c/d", then the results are
- *  all zero. "/a/b" will succeed, though.
+ * Was (node) prefetched, and not opened since, lately enough that it's
+ *  probably still waiting in a cache? Hold predictLock.
  */
-static int partOfMountPoint(DirHandle *h, char *fname)
+static int predictIsPrefetched(const PredictNode *node)
 {
-    /* !!! FIXME: This code feels gross. */
-    int rc;
-    size_t len, mntpntlen;
+    return ((node->prefetchedAt != 0) &&
+            ((predictOpens - node->prefetchedAt) < PREDICT_RECENT));
+} /* predictIsPrefetched */
 
-    if (h->mountPoint == NULL)
-        return 0;
-    else if (*fname == '\0')
-        return 1;
 
-    len = strlen(fname);
-    mntpntlen = strlen(h->mountPoint);
-    if (len > mntpntlen)  /* can't be a subset of mountpoint. */
-        return 0;
+typedef struct __PHYSFS_PREDICTJOB__
+{
+    PHYSFS_Context *ctx;  /* the opener's, not the worker thread's. */
+    char *path;  /* right after this struct, in the same allocation. */
+} PredictJob;
 
-    /* if true, must be not a match or a complete match, but not a subset. */
-    if ((len + 1) == mntpntlen)
-        return 0;
 
-    rc = strncmp(fname, h->mountPoint, len); /* !!! FIXME: case insensitive? */
-    if (rc != 0)
-        return 0;  /* not a match. */
+/* What PHYSFS_prefetch() does for one file, on a worker thread. */
+static void predictJob(void *data)
+{
+    PredictJob *job = (PredictJob *) data;
+    PrefetchOpen po;
+
+    memset(&po, '\0', sizeof (po));
+    po.ctx = job->ctx;
+    po.path = job->path;
+    prefetchOpen(&po);
+    if (po.handle != NULL)
+    {
+#if PHYSFS_SUPPORTS_7Z
+        const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+        prefetchFolders(NULL, &po.handle, 1);
+        PHYSFS_getLastErrorCode();
+        PHYSFS_setErrorCode(prevErr);
+#endif
+        PHYSFS_close(po.handle);
+    } /* if */
 
-    /* make sure /a/b matches /a/b/ and not /a/bc ... */
-    return h->mountPoint[len] == '/';
-} /* partOfMountPoint */
+    __PHYSFS_ATOMIC_DECR(&predictPending);
+    allocator.Free(job);
+} /* predictJob */
 
 
-static DirHandle *createDirHandle(PHYSFS_Io *io, const char *newDir,
-                                  const char *mountPoint, int forWriting)
+/*
+ * Hand (node)'s file to (queue) to prefetch, unless there's too much queued
+ *  already. Hold predictLock.
+ */
+static void predictQueueJob(PHYSFS_AsyncQueue *queue, PHYSFS_Context *ctx,
+                            const PredictNode *node)
 {
-    DirHandle *dirHandle = NULL;
-    char *tmpmntpnt = NULL;
+    const size_t len = strlen(node->path) + 1;
+    AsyncRequest req;
+    PredictJob *job;
 
-    if (mountPoint != NULL)
+    if (predictPending >= PREDICT_MAX_PENDING)
+        return;
+
+    job = (PredictJob *) allocator.Malloc(sizeof (PredictJob) + len);
+    if (job == NULL)
+        return;
+    job->ctx = ctx;
+    job->path = (char *) (job + 1);
+    memcpy(job->path, node->path, len);
+
+    memset(&req, '\0', sizeof (req));
+    req.job = predictJob;
+    req.userdata = job;
+    req.priority = PHYSFS_ASYNC_PREFETCH;
+    __PHYSFS_ATOMIC_INCR(&predictPending);
+    if (!queueAsyncRequest(queue, &req))
     {
-        const size_t len = strlen(mountPoint) + 1;
-        tmpmntpnt = (char *) __PHYSFS_smallAlloc(len);
-        GOTO_IF_MACRO(!tmpmntpnt, PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
-        if (!sanitizePlatformIndependentPath(mountPoint, tmpmntpnt))
-            goto badDirHandle;
-        mountPoint = tmpmntpnt;  /* sanitized version. */
+        __PHYSFS_ATOMIC_DECR(&predictPending);
+        allocator.Free(job);
     } /* if */
+} /* predictQueueJob */
 
-    dirHandle = openDirectory(io, newDir, forWriting);
-    GOTO_IF_MACRO(!dirHandle, ERRPASS, badDirHandle);
 
-    if (newDir == NULL)
-        dirHandle->dirName = NULL;
+/*
+ * (_fname) was just opened for reading in (ctx) by the app. Learn that it
+ *  followed the last file opened, and queue prefetches of the files that
+ *  usually come after it. This is only a hint, so it never fails, and
+ *  leaves the error state alone.
+ */
+static void predictOpened(PHYSFS_Context *ctx, const char *_fname)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    const size_t len = strlen(_fname) + 1;
+    char *fname = (char *) __PHYSFS_smallAlloc(len);
+    PHYSFS_AsyncQueue *queue;
+    PredictNode *node = NULL;
+    PredictNode *walk;
+    PHYSFS_uint32 i;
+
+    if (fname == NULL)
+        return;
+
+    __PHYSFS_platformGrabMutex(predictLock);
+    queue = predictQueue;
+    if ((queue != NULL) && (sanitizePlatformIndependentPath(_fname, fname)))
+        node = predictFindNode(fname, 1);
+
+    if (node != NULL)
+    {
+        if ((predictLast != NULL) && (predictLast != node))
+            predictLearn(predictLast, node, 1);
+        predictLast = node;
+        node->prefetchedAt = 0;  /* it's been used. */
+        if (++predictOpens == 0)
+            predictOpens = 1;
+
+        /* follow the likeliest next file, then the one after that... */
+        walk = node;
+        for (i = 0; i < predictLookahead; i++)
+        {
+            if ((walk->next[0] == NULL) ||
+                (walk->count[0] < PREDICT_MIN_COUNT))
+                break;
+            walk = walk->next[0];
+            if (walk == node)
+                break;  /* back where we started. */
+            else if (!predictIsPrefetched(walk))
+            {
+                walk->prefetchedAt = predictOpens;
+                predictQueueJob(queue, ctx, walk);
+            } /* else if */
+        } /* for */
+    } /* if */
+    __PHYSFS_platformReleaseMutex(predictLock);
+
+    __PHYSFS_smallFree(fname);
+    PHYSFS_getLastErrorCode();
+    PHYSFS_setErrorCode(prevErr);
+} /* predictOpened */
+
+
+int PHYSFS_enablePredictivePrefetch(PHYSFS_AsyncQueue *queue,
+                                    PHYSFS_uint32 lookahead)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    if (lookahead == 0)
+        queue = NULL;  /* turn it off. */
     else
     {
-        dirHandle->dirName = (char *) allocator.Malloc(strlen(newDir) + 1);
-        if (!dirHandle->dirName)
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
-        strcpy(dirHandle->dirName, newDir);
+        /* without threads, prefetches would run inside PHYSFS_openRead(). */
+        BAIL_IF_MACRO((!queue) || (queue->numThreads == 0),
+                      PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        if (lookahead > PREDICT_MAX_LOOKAHEAD)
+            lookahead = PREDICT_MAX_LOOKAHEAD;
     } /* else */
 
-    if ((mountPoint != NULL) && (*mountPoint != '\0'))
+    __PHYSFS_platformGrabMutex(predictLock);
+    predictQueue = queue;
+    predictLookahead = lookahead;
+    predictLast = NULL;  /* what came before this isn't a sequence. */
+    __PHYSFS_platformReleaseMutex(predictLock);
+    return 1;
+} /* PHYSFS_enablePredictivePrefetch */
+
+
+int PHYSFS_writePrefetchModel(const char *filename)
+{
+    const PredictNode *node;
+    ProfileWriter w;
+    size_t i;
+    int j;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    w.out = PHYSFS_openWrite(filename);
+    BAIL_IF_MACRO(!w.out, ERRPASS, 0);
+    PHYSFS_setBuffer(w.out, 64 * 1024);  /* lots of tiny writes coming. */
+    w.ok = 1;
+
+    profilePuts(&w, "count,from,to\n");
+    __PHYSFS_platformGrabMutex(predictLock);
+    for (i = 0; i < PREDICT_HASH_SLOTS; i++)
     {
-        dirHandle->mountPoint = (char *)allocator.Malloc(strlen(mountPoint)+2);
-        if (!dirHandle->mountPoint)
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, badDirHandle);
-        strcpy(dirHandle->mountPoint, mountPoint);
-        strcat(dirHandle->mountPoint, "/");
-    } /* if */
+        for (node = predictHash[i]; node != NULL; node = node->hashNext)
+        {
+            for (j = 0; (j < PREDICT_SUCCESSORS) && (node->next[j]); j++)
+            {
+                profilePutNum(&w, node->count[j]);
+                profilePuts(&w, ",");
+                profilePutString(&w, node->path, 0);
+                profilePuts(&w, ",");
+                profilePutString(&w, node->next[j]->path, 0);
+                profilePuts(&w, "\n");
+            } /* for */
+        } /* for */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(predictLock);
 
-    __PHYSFS_smallFree(tmpmntpnt);
-    return dirHandle;
+    if (!PHYSFS_close(w.out))  /* last flush failed? */
+        w.ok = 0;
 
-badDirHandle:
-    if (dirHandle != NULL)
+    return w.ok;
+} /* PHYSFS_writePrefetchModel */
+
+
+/*
+ * Unquote the CSV string at (*ptr), as profilePutString() wrote it, in
+ *  place, and point (*ptr) past it. Returns NULL if it isn't one.
+ */
+static char *predictParseString(char **ptr)
+{
+    char *src = *ptr;
+    char *dst;
+    char *retval;
+
+    if (*src != '"')
+        return NULL;
+
+    retval = dst = ++src;
+    while (1)
     {
-        dirHandle->funcs->closeArchive(dirHandle->opaque);
-        allocator.Free(dirHandle->dirName);
-        allocator.Free(dirHandle->mountPoint);
-        allocator.Free(dirHandle);
-    } /* if */
+        if ((*src == '\0') || (*src == '\n'))
+            return NULL;
+        else if (*src != '"')
+            *(dst++) = *(src++);
+        else if (src[1] == '"')
+        {
+            *(dst++) = '"';
+            src += 2;
+        } /* else if */
+        else
+            break;
+    } /* while */
 
-    __PHYSFS_smallFree(tmpmntpnt);
-    return NULL;
-} /* createDirHandle */
+    *ptr = src + 1;
+    *dst = '\0';  /* might land on the closing quote; we're past it. */
+    return retval;
+} /* predictParseString */
 
 
-/* MAKE SURE you've got the stateLock held before calling this! */
-static int freeDirHandle(DirHandle *dh, FileHandle *openList)
+/*
+ * Learn every line of a PHYSFS_writePrefetchModel() file, (ptr), which this
+ *  writes over. Returns zero if it isn't one, though what came before the
+ *  bad line is learned. Hold predictLock.
+ */
+static int predictParseModel(char *ptr)
 {
-    FileHandle *i;
+    if (strncmp(ptr, "count,", 6) == 0)  /* the header line. */
+        ptr += strcspn(ptr, "\n");
 
-    if (dh == NULL)
-        return 1;
+    while (*ptr)
+    {
+        PHYSFS_uint64 count = 0;
+        PredictNode *from;
+        PredictNode *to;
+        char *fromstr;
+        char *tostr;
 
-    for (i = openList; i != NULL; i = i->next)
-        BAIL_IF_MACRO(i->dirHandle == dh, PHYSFS_ERR_FILES_STILL_OPEN, 0);
+        if ((*ptr == '\n') || (*ptr == '\r'))
+        {
+            ptr++;
+            continue;
+        } /* if */
+
+        BAIL_IF_MACRO((*ptr < '0') || (*ptr > '9'), PHYSFS_ERR_CORRUPT, 0);
+        for (; (*ptr >= '0') && (*ptr <= '9'); ptr++)
+        {
+            count = (count * 10) + (PHYSFS_uint64) (*ptr - '0');
+            if (count > 0xFFFFFFFF)
+                count = 0xFFFFFFFF;
+        } /* for */
+
+        BAIL_IF_MACRO(*(ptr++) != ',', PHYSFS_ERR_CORRUPT, 0);
+        fromstr = predictParseString(&ptr);
+        BAIL_IF_MACRO(!fromstr, PHYSFS_ERR_CORRUPT, 0);
+        BAIL_IF_MACRO(*(ptr++) != ',', PHYSFS_ERR_CORRUPT, 0);
+        tostr = predictParseString(&ptr);
+        BAIL_IF_MACRO(!tostr, PHYSFS_ERR_CORRUPT, 0);
+        if (*ptr == '\r')
+            ptr++;
+        BAIL_IF_MACRO((*ptr != '\n') && (*ptr != '\0'), PHYSFS_ERR_CORRUPT, 0);
+
+        from = predictFindNode(fromstr, 1);
+        to = predictFindNode(tostr, 1);
+        if ((from != NULL) && (to != NULL) && (from != to) && (count > 0))
+            predictLearn(from, to, (PHYSFS_uint32) count);
+    } /* while */
 
-    dh->funcs->closeArchive(dh->opaque);
-    allocator.Free(dh->dirName);
-    allocator.Free(dh->mountPoint);
-    allocator.Free(dh);
     return 1;
-} /* freeDirHandle */
+} /* predictParseModel */
 
 
-static char *calculateBaseDir(const char *argv0)
+int PHYSFS_loadPrefetchModel(const char *filename)
 {
-    const char dirsep = __PHYSFS_platformDirSeparator;
-    char *retval = NULL;
-    char *ptr = NULL;
+    PHYSFS_File *in;
+    PHYSFS_sint64 len;
+    char *buf;
+    int retval;
 
-    /* Give the platform layer first shot at this. */
-    retval = __PHYSFS_platformCalcBaseDir(argv0);
-    if (retval != NULL)
-        return retval;
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
 
-    /* We need argv0 to go on. */
-    BAIL_IF_MACRO(argv0 == NULL, PHYSFS_ERR_ARGV0_IS_NULL, NULL);
+    /* not PHYSFS_openRead(), so this isn't learned as part of a sequence. */
+    in = openRead(currentContext(), filename);
+    BAIL_IF_MACRO(!in, ERRPASS, 0);
+    len = PHYSFS_fileLength(in);
+    buf = NULL;
+    if ((len >= 0) && (__PHYSFS_ui64FitsAddressSpace(len + 1)))
+        buf = (char *) allocator.Malloc((size_t) (len + 1));
+    if (buf == NULL)
+    {
+        PHYSFS_close(in);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+
+    if (PHYSFS_readBytes(in, buf, (PHYSFS_uint64) len) != len)
+    {
+        allocator.Free(buf);
+        PHYSFS_close(in);
+        BAIL_MACRO(PHYSFS_ERR_CORRUPT, 0);  /* it got shorter? */
+    } /* if */
+    PHYSFS_close(in);
+    buf[len] = '\0';
+
+    __PHYSFS_platformGrabMutex(predictLock);
+    retval = predictParseModel(buf);
+    __PHYSFS_platformReleaseMutex(predictLock);
+
+    allocator.Free(buf);
+    return retval;
+} /* PHYSFS_loadPrefetchModel */
+
+
+/* Write out what's been captured so far. Hold captureLock. */
+static void captureFlush(void)
+{
+    const PHYSFS_sint64 len = (PHYSFS_sint64) captureLen;
+    if ((len > 0) && (__PHYSFS_platformWrite(captureFile, captureBuf,
+                                             (PHYSFS_uint64) len) != len))
+        captureFailed = 1;  /* PHYSFS_stopTraceCapture() reports it. */
+    captureLen = 0;
+} /* captureFlush */
+
+/* Hold captureLock. */
+static void capturePut(const char *str, size_t len)
+{
+    while (len > 0)
+    {
+        const size_t avail = sizeof (captureBuf) - captureLen;
+        const size_t cpy = (len < avail) ? len : avail;
+        memcpy(captureBuf + captureLen, str, cpy);
+        captureLen += cpy;
+        str += cpy;
+        len -= cpy;
+        if (captureLen == sizeof (captureBuf))
+            captureFlush();
+    } /* while */
+} /* capturePut */
+
+/* Write (val) and a space. Hold captureLock. */
+static void capturePutNum(PHYSFS_sint64 val)
+{
+    PHYSFS_uint64 uval = (val < 0) ? (PHYSFS_uint64) -val : (PHYSFS_uint64) val;
+    char buf[24];
+    char *ptr = buf + sizeof (buf);
+
+    *(--ptr) = ' ';
+    do
+    {
+        *(--ptr) = (char) ('0' + (int) (uval % 10));
+        uval /= 10;
+    } while (uval > 0);
+
+    if (val < 0)
+        *(--ptr) = '-';
+    capturePut(ptr, (size_t) ((buf + sizeof (buf)) - ptr));
+} /* capturePutNum */
+
+/* This thread's slot, or NULL if they're all taken. Hold captureLock. */
+static CaptureThread *captureThread(PHYSFS_uint32 *num)
+{
+    void *thread = __PHYSFS_platformGetThreadID();
+    CaptureThread *slot;
+    PHYSFS_uint32 i;
+
+    for (i = 0; i < captureThreadCount; i++)
+    {
+        if (captureThreads[i].thread == thread)
+        {
+            *num = i + 1;
+            return &captureThreads[i];
+        } /* if */
+    } /* for */
+
+    *num = 0;
+    if (captureThreadCount == CAPTURE_THREADS)
+        return NULL;
+
+    slot = &captureThreads[captureThreadCount++];
+    memset(slot, '\0', sizeof (*slot));
+    slot->thread = thread;
+    *num = captureThreadCount;
+    return slot;
+} /* captureThread */
+
+/*
+ * Record an event for PHYSFS_startTraceCapture(). Begins are held until
+ *  their ends, which write the whole thing out as one line.
+ */
+static void captureEvent(int begin, PHYSFS_TraceEvent event, const char *path,
+                         PHYSFS_File *file, PHYSFS_sint64 bytes,
+                         PHYSFS_sint64 offset, int success)
+{
+    static const char *names[] = {
+        "mount", "open", "read", "seek", "enumerate", NULL, "stat", "close"
+    };
+    const PHYSFS_uint64 now = __PHYSFS_platformGetTicks();
+    PHYSFS_uint64 start = now;
+    PHYSFS_sint64 asked = bytes;
+    PHYSFS_uint32 num = 0;
+    CaptureThread *slot;
+    const char *ptr;
+
+    if ((((size_t) event) >= sizeof (names) / sizeof (names[0])) ||
+        (names[event] == NULL))
+        return;  /* decompressing is internal; replays do it themselves. */
+
+    __PHYSFS_platformGrabMutex(captureLock);
+    if (captureFile == NULL)
+    {
+        __PHYSFS_platformReleaseMutex(captureLock);  /* just stopped. */
+        return;
+    } /* if */
+
+    slot = captureThread(&num);
+    if (begin)
+    {
+        if ((slot != NULL) && (slot->depth < CAPTURE_DEPTH))
+        {
+            slot->start[slot->depth] = now;
+            slot->bytes[slot->depth] = bytes;
+        } /* if */
+        if (slot != NULL)
+            slot->depth++;
+        __PHYSFS_platformReleaseMutex(captureLock);
+        return;
+    } /* if */
 
-    ptr = strrchr(argv0, dirsep);
-    if (ptr != NULL)
+    if ((slot != NULL) && (slot->depth > 0))
     {
-        const size_t size = ((size_t) (ptr - argv0)) + 1;
-        retval = (char *) allocator.Malloc(size + 1);
-        BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-        memcpy(retval, argv0, size);
-        retval[size] = '\0';
-        return retval;
+        if (--slot->depth < CAPTURE_DEPTH)
+        {
+            start = slot->start[slot->depth];
+            asked = slot->bytes[slot->depth];
+        } /* if */
     } /* if */
 
-    /* argv0 wasn't helpful. */
-    BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, NULL);
-} /* calculateBaseDir */
+    /* start duration thread event handle bytes result offset path */
+    capturePutNum((PHYSFS_sint64) (start - captureStart));
+    capturePutNum((PHYSFS_sint64) (now - start));
+    capturePutNum((PHYSFS_sint64) num);
+    capturePut(names[event], strlen(names[event]));
+    capturePut(" ", 1);
+    capturePutNum((PHYSFS_sint64) (size_t) file);
+    capturePutNum(asked);
+    capturePutNum((event == PHYSFS_TRACE_READ) ? bytes : (success != 0));
+    capturePutNum(offset);
+    for (ptr = path; (ptr != NULL) && (*ptr); ptr++)
+    {
+        if (*ptr == '\\')
+            capturePut("\\\\", 2);
+        else if (*ptr == '\n')
+            capturePut("\\n", 2);
+        else
+            capturePut(ptr, 1);
+    } /* for */
+    capturePut("\n", 1);
+    __PHYSFS_platformReleaseMutex(captureLock);
+} /* captureEvent */
 
 
-static int initializeMutexes(void)
+void __PHYSFS_traceEvent(int begin, PHYSFS_TraceEvent event, const char *path,
+                         PHYSFS_File *file, PHYSFS_sint64 bytes,
+                         PHYSFS_sint64 offset, int success)
 {
-    errorLock = __PHYSFS_platformCreateMutex();
-    if (errorLock == NULL)
-        goto initializeMutexes_failed;
+    const PHYSFS_TraceCallback cb = begin ? traceHooks.begin : traceHooks.end;
+    PHYSFS_TraceInfo info;
 
-    stateLock = __PHYSFS_platformCreateMutex();
-    if (stateLock == NULL)
-        goto initializeMutexes_failed;
-
-    return 1;  /* success. */
-
-initializeMutexes_failed:
-    if (errorLock != NULL)
-        __PHYSFS_platformDestroyMutex(errorLock);
+    /* a close's handle is gone by its end. */
+    if ((path == NULL) && (file != NULL) &&
+        ((begin) || (event != PHYSFS_TRACE_CLOSE)))
+        path = ((const FileHandle *) file)->tracePath;
 
-    if (stateLock != NULL)
-        __PHYSFS_platformDestroyMutex(stateLock);
+    if (capturing)
+        captureEvent(begin, event, path, file, bytes, offset, success);
 
-    errorLock = stateLock = NULL;
-    return 0;  /* failed. */
-} /* initializeMutexes */
+    if (cb == NULL)
+        return;
 
+    info.event = event;
+    info.path = path;
+    info.file = file;
+    info.bytes = bytes;
+    info.success = success;
+    info.offset = offset;
+    cb(traceHooks.data, &info);
+} /* __PHYSFS_traceEvent */
 
-static int doRegisterArchiver(const PHYSFS_Archiver *_archiver);
 
-static int initStaticArchivers(void)
+static void updateTracing(void)
 {
-    #define REGISTER_STATIC_ARCHIVER(arc) { \
-        extern const PHYSFS_Archiver __PHYSFS_Archiver_##arc; \
-        if (!doRegisterArchiver(&__PHYSFS_Archiver_##arc)) { \
-            return 0; \
-        } \
-    }
-
-    #if PHYSFS_SUPPORTS_ZIP
-        REGISTER_STATIC_ARCHIVER(ZIP);
-    #endif
-    #if PHYSFS_SUPPORTS_7Z
-        REGISTER_STATIC_ARCHIVER(LZMA);
-    #endif
-    #if PHYSFS_SUPPORTS_GRP
-        REGISTER_STATIC_ARCHIVER(GRP);
-    #endif
-    #if PHYSFS_SUPPORTS_QPAK
-        REGISTER_STATIC_ARCHIVER(QPAK);
-    #endif
-    #if PHYSFS_SUPPORTS_HOG
-        REGISTER_STATIC_ARCHIVER(HOG);
-    #endif
-    #if PHYSFS_SUPPORTS_MVL
-        REGISTER_STATIC_ARCHIVER(MVL);
-    #endif
-    #if PHYSFS_SUPPORTS_WAD
-        REGISTER_STATIC_ARCHIVER(WAD);
-    #endif
-    #if PHYSFS_SUPPORTS_SLB
-        REGISTER_STATIC_ARCHIVER(SLB);
-    #endif
-    #if PHYSFS_SUPPORTS_ISO9660
-        REGISTER_STATIC_ARCHIVER(ISO9660);
-    #endif
-    #if PHYSFS_SUPPORTS_RAS
-        REGISTER_STATIC_ARCHIVER(RAS);
-    #endif
-
-    #undef REGISTER_STATIC_ARCHIVER
+    __PHYSFS_tracing = ( (capturing) || (traceHooks.begin != NULL) ||
+                         (traceHooks.end != NULL) );
+} /* updateTracing */
 
-    return 1;
-} /* initStaticArchivers */
 
+void PHYSFS_setTraceHooks(const PHYSFS_TraceHooks *hooks)
+{
+    __PHYSFS_tracing = 0;
+    if (hooks == NULL)
+        memset(&traceHooks, '\0', sizeof (traceHooks));
+    else
+        memcpy(&traceHooks, hooks, sizeof (traceHooks));
+    updateTracing();
+} /* PHYSFS_setTraceHooks */
 
-static void setDefaultAllocator(void);
-static int doDeinit(void);
 
-int PHYSFS_init(const char *argv0)
+int PHYSFS_startTraceCapture(const char *filename)
 {
-    BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
+    static const char header[] = "PHYSFS-TRACE 1\n";
+    void *file;
 
-    if (!externalAllocator)
-        setDefaultAllocator();
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!filename, PHYSFS_ERR_INVALID_ARGUMENT, 0);
 
-    if ((allocator.Init != NULL) && (!allocator.Init())) return 0;
+    file = __PHYSFS_platformOpenWrite(filename);
+    BAIL_IF_MACRO(!file, ERRPASS, 0);
 
-    if (!__PHYSFS_platformInit())
+    __PHYSFS_platformGrabMutex(captureLock);
+    if (captureFile != NULL)
     {
-        if (allocator.Deinit != NULL) allocator.Deinit();
-        return 0;
+        __PHYSFS_platformReleaseMutex(captureLock);
+        __PHYSFS_platformClose(file);
+        __PHYSFS_platformDelete(filename);
+        BAIL_MACRO(PHYSFS_ERR_IS_INITIALIZED, 0);  /* one at a time. */
     } /* if */
 
-    /* everything below here can be cleaned up safely by doDeinit(). */
+    if (captureThreads == NULL)
+    {
+        captureThreads = (CaptureThread *) allocator.Malloc(
+                                sizeof (CaptureThread) * CAPTURE_THREADS);
+        if (captureThreads == NULL)
+        {
+            __PHYSFS_platformReleaseMutex(captureLock);
+            __PHYSFS_platformClose(file);
+            __PHYSFS_platformDelete(filename);
+            BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        } /* if */
+    } /* if */
 
-    if (!initializeMutexes()) goto initFailed;
+    captureFile = file;
+    captureFailed = 0;
+    captureThreadCount = 0;
+    captureLen = 0;
+    captureStart = __PHYSFS_platformGetTicks();
+    capturePut(header, sizeof (header) - 1);
+    capturing = 1;
+    updateTracing();
+    __PHYSFS_platformReleaseMutex(captureLock);
+    return 1;
+} /* PHYSFS_startTraceCapture */
 
-    baseDir = calculateBaseDir(argv0);
-    if (!baseDir) goto initFailed;
 
-    userDir = __PHYSFS_platformCalcUserDir();
-    if (!userDir) goto initFailed;
+/* Stop capturing, and flush and close the capture. */
+static int stopTraceCapture(void)
+{
+    int retval = 1;
 
-    /* Platform layer is required to append a dirsep. */
-    assert(baseDir[strlen(baseDir) - 1] == __PHYSFS_platformDirSeparator);
-    assert(userDir[strlen(userDir) - 1] == __PHYSFS_platformDirSeparator);
+    if (captureLock == NULL)
+        return 1;  /* never initialized. */
 
-    if (!initStaticArchivers()) goto initFailed;
+    capturing = 0;
+    updateTracing();
 
-    initialized = 1;
+    __PHYSFS_platformGrabMutex(captureLock);
+    if (captureFile != NULL)
+    {
+        captureFlush();
+        if (!__PHYSFS_platformFlush(captureFile))
+            captureFailed = 1;
+        __PHYSFS_platformClose(captureFile);
+        captureFile = NULL;
+        retval = !captureFailed;
+    } /* if */
+    allocator.Free(captureThreads);
+    captureThreads = NULL;
+    __PHYSFS_platformReleaseMutex(captureLock);
 
-    /* This makes sure that the error subsystem is initialized. */
-    PHYSFS_setErrorCode(PHYSFS_getLastErrorCode());
+    return retval;
+} /* stopTraceCapture */
 
+
+int PHYSFS_stopTraceCapture(void)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!stopTraceCapture(), PHYSFS_ERR_IO, 0);
     return 1;
+} /* PHYSFS_stopTraceCapture */
 
-initFailed:
-    doDeinit();
-    return 0;
-} /* PHYSFS_init */
+
+int PHYSFS_enableLatencyHistograms(int enable)
+{
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    timingLatency = (enable != 0);
+    return 1;
+} /* PHYSFS_enableLatencyHistograms */
 
 
-/* MAKE SURE you hold stateLock before calling this! */
-static int closeFileHandleList(FileHandle **list)
+int PHYSFS_getLatency(PHYSFS_LatencyOp op, const char *ext,
+                      PHYSFS_Latency *lat)
 {
-    FileHandle *i;
-    FileHandle *next = NULL;
+    PHYSFS_uint64 *buckets;
+    PHYSFS_uint64 count = 0;
+    PHYSFS_uint64 max = 0;
+    PHYSFS_uint64 seen = 0;
+    const double percentiles[3] = { 0.5, 0.99, 0.999 };
+    PHYSFS_uint64 *results[3];
+    PHYSFS_uint32 b;
+    int firstSlot = 0;
+    int lastSlot = LATENCY_SLOTS - 1;
+    int p = 0;
+    size_t len;
+    ErrState *i;
 
-    for (i = *list; i != NULL; i = next)
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!lat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(((int) op < 0) || ((int) op >= LATENCY_OPS),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    memset(lat, '\0', sizeof (*lat));
+    if (ext != NULL)
     {
-        PHYSFS_Io *io = i->io;
-        next = i->next;
+        firstSlot = lastSlot = latencySlot(ext, 0);
+        if (firstSlot < 0)
+            return 1;  /* never timed anything from that archiver. */
+    } /* if */
 
-        if (io->flush && !io->flush(io))
+    len = LATENCY_BUCKETS * sizeof (PHYSFS_uint64);
+    buckets = (PHYSFS_uint64 *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!buckets, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(buckets, '\0', len);
+
+    __PHYSFS_platformGrabMutex(errorLock);
+    for (i = errorStates; i != NULL; i = i->next)
+    {
+        const LatencyTable *table = i->latency;
+        int slot;
+
+        if (table == NULL)
+            continue;
+
+        for (slot = firstSlot; slot <= lastSlot; slot++)
         {
-            *list = i;
-            return 0;
-        } /* if */
+            LatencyHist *hist = table->hists[op][slot];
+            PHYSFS_uint64 histmax;
+            if (hist == NULL)
+                continue;
+            histmax = __PHYSFS_ATOMIC_ADD64(&hist->max, 0);
+            if (histmax > max)
+                max = histmax;
+            for (b = 0; b < LATENCY_BUCKETS; b++)
+                buckets[b] += __PHYSFS_ATOMIC_ADD64(&hist->buckets[b], 0);
+        } /* for */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(errorLock);
 
-        io->destroy(io);
-        allocator.Free(i);
+    for (b = 0; b < LATENCY_BUCKETS; b++)
+        count += buckets[b];
+
+    results[0] = &lat->p50;
+    results[1] = &lat->p99;
+    results[2] = &lat->p999;
+    for (b = 0; (b < LATENCY_BUCKETS) && (p < 3); b++)
+    {
+        seen += buckets[b];
+        while ((p < 3) && (count > 0) &&
+               ((double) seen >= percentiles[p] * (double) count))
+        {
+            const PHYSFS_uint64 val = latencyBucketMax(b);
+            *results[p++] = (val < max) ? val : max;
+        } /* while */
     } /* for */
 
-    *list = NULL;
+    lat->count = count;
+    lat->max = max;
+    __PHYSFS_smallFree(buckets);
     return 1;
-} /* closeFileHandleList */
+} /* PHYSFS_getLatency */
 
 
-/* MAKE SURE you hold the stateLock before calling this! */
-static void freeSearchPath(void)
+void PHYSFS_resetLatency(void)
 {
-    DirHandle *i;
-    DirHandle *next = NULL;
+    ErrState *i;
+    size_t j;
+    PHYSFS_uint32 b;
 
-    closeFileHandleList(&openReadList);
+    if (errorLock == NULL)
+        return;  /* not initialized; nothing to reset. */
 
-    if (searchPath != NULL)
+    __PHYSFS_platformGrabMutex(errorLock);
+    for (i = errorStates; i != NULL; i = i->next)
     {
-        for (i = searchPath; i != NULL; i = next)
+        LatencyHist * volatile *hists;
+        if (i->latency == NULL)
+            continue;
+
+        hists = &i->latency->hists[0][0];
+        for (j = 0; j < LATENCY_OPS * LATENCY_SLOTS; j++)
         {
-            next = i->next;
-            freeDirHandle(i, openReadList);
+            LatencyHist *hist = hists[j];
+            PHYSFS_uint64 val;
+            if (hist == NULL)
+                continue;
+
+            /* subtract what we saw, so concurrent adds aren't lost. */
+            for (b = 0; b < LATENCY_BUCKETS; b++)
+            {
+                PHYSFS_uint64 *bucket = &hist->buckets[b];
+                val = __PHYSFS_ATOMIC_ADD64(bucket, 0);
+                if (val != 0)
+                    __PHYSFS_ATOMIC_ADD64(bucket, (PHYSFS_uint64) 0 - val);
+            } /* for */
+            val = __PHYSFS_ATOMIC_ADD64(&hist->max, 0);
+            __PHYSFS_ATOMIC_ADD64(&hist->max, (PHYSFS_uint64) 0 - val);
         } /* for */
-        searchPath = NULL;
-    } /* if */
-} /* freeSearchPath */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(errorLock);
+} /* PHYSFS_resetLatency */
 
 
-/* MAKE SURE you hold stateLock before calling this! */
-static int archiverInUse(const PHYSFS_Archiver *arc, const DirHandle *list)
+static PHYSFS_sint64 doBufferedWrite(PHYSFS_File *handle, const void *buffer,
+                                     PHYSFS_uint64 len)
 {
-    const DirHandle *i;
-    for (i = list; i != NULL; i = i->next)
+    FileHandle *fh = (FileHandle *) handle;
+
+    if (fh->behind != NULL)
+        return doWriteBehind(fh, buffer, len);
+
+    /* whole thing fits in the buffer? */
+    if ( (((PHYSFS_uint64) fh->buffill) + len) < fh->bufsize )
     {
-        if (i->funcs == arc)
-            return 1;
-    } /* for */
+        memcpy(fh->buffer + fh->buffill, buffer, (size_t) len);
+        fh->buffill += len;
+        return (PHYSFS_sint64) len;
+    } /* if */
 
-    return 0;  /* not in use */
-} /* archiverInUse */
+    /* would overflow buffer. Flush and then write the new objects, too. */
+    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, -1);
+    return fh->io->write(fh->io, buffer, len);
+} /* doBufferedWrite */
 
 
-/* MAKE SURE you hold stateLock before calling this! */
-static int doDeregisterArchiver(const size_t idx)
+PHYSFS_sint64 PHYSFS_write(PHYSFS_File *handle, const void *buffer,
+                           PHYSFS_uint32 size, PHYSFS_uint32 count)
 {
-    const size_t len = (numArchivers - idx) * sizeof (void *);
-    const PHYSFS_ArchiveInfo *info = archiveInfo[idx];
-    const PHYSFS_Archiver *arc = archivers[idx];
+    const PHYSFS_uint64 len = ((PHYSFS_uint64) size) * ((PHYSFS_uint64) count);
+    const PHYSFS_sint64 retval = PHYSFS_writeBytes(handle, buffer, len);
+    return ( (retval <= 0) ? retval : (retval / ((PHYSFS_sint64) size)) );
+} /* PHYSFS_write */
 
-    /* make sure nothing is still using this archiver */
-    if (archiverInUse(arc, searchPath) || archiverInUse(arc, writeDir))
-        BAIL_MACRO(PHYSFS_ERR_FILES_STILL_OPEN, 0);
 
-    allocator.Free((void *) info->extension);
-    allocator.Free((void *) info->description);
-    allocator.Free((void *) info->author);
-    allocator.Free((void *) info->url);
-    allocator.Free((void *) arc);
+PHYSFS_sint64 PHYSFS_writeBytes(PHYSFS_File *handle, const void *buffer,
+                                PHYSFS_uint64 len)
+{
+    FileHandle *fh = (FileHandle *) handle;
 
-    memmove(&archiveInfo[idx], &archiveInfo[idx+1], len);
-    memmove(&archivers[idx], &archivers[idx+1], len);
+#ifdef PHYSFS_NO_64BIT_SUPPORT
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
+#else
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
+#endif
 
-    assert(numArchivers > 0);
-    numArchivers--;
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
 
-    return 1;
-} /* doDeregisterArchiver */
+    BAIL_IF_MACRO(len > maxlen, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(fh->forReading, PHYSFS_ERR_OPEN_FOR_READING, -1);
+    BAIL_IF_MACRO(len == 0, ERRPASS, 0);
+    if (fh->buffer)
+        return doBufferedWrite(handle, buffer, len);
 
+    return fh->io->write(fh->io, buffer, len);
+} /* PHYSFS_write */
 
-/* Does NOT hold the state lock; we're shutting down. */
-static void freeArchivers(void)
+
+int PHYSFS_eof(PHYSFS_File *handle)
 {
-    while (numArchivers > 0)
+    FileHandle *fh = (FileHandle *) handle;
+
+    if (!fh->forReading)  /* never EOF on files opened for write/append. */
+        return 0;
+
+    /* can't be eof if buffer isn't empty */
+    if ((fh->bufpos == fh->buffill) && (readAheadBytes(fh) == 0))
     {
-        if (!doDeregisterArchiver(numArchivers - 1))
-            assert(!"nothing should be mounted during shutdown.");
-    } /* while */
+        /* check the Io. */
+        PHYSFS_Io *io = fh->io;
+        const PHYSFS_sint64 pos = io->tell(io);
+        const PHYSFS_sint64 len = io->length(io);
+        if ((pos < 0) || (len < 0))
+            return 0;  /* beats me. */
+        return (pos >= len);
+    } /* if */
 
-    allocator.Free(archivers);
-    allocator.Free(archiveInfo);
-    archivers = NULL;
-    archiveInfo = NULL;
-} /* freeArchivers */
+    return 0;
+} /* PHYSFS_eof */
 
 
-static int doDeinit(void)
+PHYSFS_sint64 PHYSFS_tell(PHYSFS_File *handle)
 {
-    closeFileHandleList(&openWriteList);
-    BAIL_IF_MACRO(!PHYSFS_setWriteDir(NULL), PHYSFS_ERR_FILES_STILL_OPEN, 0);
+    FileHandle *fh = (FileHandle *) handle;
+    const PHYSFS_sint64 fill = (PHYSFS_sint64) fh->buffill;
+    PHYSFS_sint64 ahead = 0;
+    PHYSFS_sint64 pos;
 
-    freeSearchPath();
-    freeArchivers();
-    freeErrorStates();
+    if (fh->forReading)
+        ahead = (PHYSFS_sint64) readAheadBytes(fh);
+    else
+        waitWriteBehind(fh);  /* the worker moves the i/o, too. */
 
-    if (baseDir != NULL)
-    {
-        allocator.Free(baseDir);
-        baseDir = NULL;
-    } /* if */
+    pos = fh->io->tell(fh->io);
+    if (!fh->forReading)
+        return (pos + fill);
+    return (pos - fill - ahead) + (PHYSFS_sint64) fh->bufpos;
+} /* PHYSFS_tell */
 
-    if (userDir != NULL)
-    {
-        allocator.Free(userDir);
-        userDir = NULL;
-    } /* if */
 
-    if (prefDir != NULL)
+static int doSeek(FileHandle *fh, PHYSFS_uint64 pos)
+{
+    PHYSFS_File *handle = (PHYSFS_File *) fh;
+    PHYSFS_sint64 curpos = -1;
+
+    if (fh->buffer && fh->forReading)
     {
-        allocator.Free(prefDir);
-        prefDir = NULL;
+        /* avoid throwing away our precious buffer if seeking within it. */
+        PHYSFS_sint64 offset;
+        curpos = PHYSFS_tell(handle);
+        offset = pos - curpos;
+        if ( /* seeking within the already-buffered range? */
+            ((offset >= 0) &&  /* fwd */
+                (((PHYSFS_uint64) offset) <= fh->buffill - fh->bufpos))
+            || ((offset < 0) &&  /* backward */
+                (((PHYSFS_uint64) -offset) <= fh->bufpos)) )
+        {
+            fh->bufpos += (PHYSFS_uint64) offset;  /* wraps for backward. */
+            return 1; /* successful seek */
+        } /* if */
     } /* if */
 
-    if (archiveInfo != NULL)
+    /* we have to fall back to a 'raw' seek. */
+    fh->buffill = fh->bufpos = 0;
+    if (fh->bufmax)  /* start over small; this might be random access. */
     {
-        allocator.Free(archiveInfo);
-        archiveInfo = NULL;
+        dropReadAhead(fh);
+        fh->readahead = (fh->bufmax < ADAPTIVE_BUFFER_MIN) ?
+                            fh->bufmax : ADAPTIVE_BUFFER_MIN;
+        fh->sequential = 0;
     } /* if */
 
-    if (archivers != NULL)
+    if (!fh->io->seek(fh->io, pos))
     {
-        allocator.Free(archivers);
-        archivers = NULL;
+        /* the i/o was past what we buffered; put it where the app was. */
+        if (curpos >= 0)
+            fh->io->seek(fh->io, (PHYSFS_uint64) curpos);
+        return 0;
     } /* if */
 
-    allowSymLinks = 0;
-    initialized = 0;
+    return 1;
+} /* doSeek */
 
-    if (errorLock) __PHYSFS_platformDestroyMutex(errorLock);
-    if (stateLock) __PHYSFS_platformDestroyMutex(stateLock);
 
-    if (allocator.Deinit != NULL)
-        allocator.Deinit();
+int PHYSFS_seek(PHYSFS_File *handle, PHYSFS_uint64 pos)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    int retval;
 
-    errorLock = stateLock = NULL;
+    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, 0);
+    __PHYSFS_STAT_INCR(seeks);
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_SEEK, NULL, handle,
+                         (PHYSFS_sint64) pos);
+    retval = doSeek(fh, pos);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_SEEK, NULL, handle,
+                       (PHYSFS_sint64) pos, retval);
+    return retval;
+} /* PHYSFS_seek */
 
-    /* !!! FIXME: what on earth are you supposed to do if this fails? */
-    BAIL_IF_MACRO(!__PHYSFS_platformDeinit(), ERRPASS, 0);
 
-    return 1;
-} /* doDeinit */
+PHYSFS_sint64 PHYSFS_fileLength(PHYSFS_File *handle)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    if (fh->forReading)
+        readAheadBytes(fh);  /* don't ask under a background read. */
+    else
+        waitWriteBehind(fh);  /* ...or write. */
+    return fh->io->length(fh->io);
+} /* PHYSFS_filelength */
 
 
-int PHYSFS_deinit(void)
+int PHYSFS_setBuffer(PHYSFS_File *handle, PHYSFS_uint64 _bufsize)
 {
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
-    return doDeinit();
-} /* PHYSFS_deinit */
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_uint64 bufsize;
 
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(_bufsize),
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    bufsize = _bufsize;
 
-int PHYSFS_isInit(void)
-{
-    return initialized;
-} /* PHYSFS_isInit */
+    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, 0);
+
+    /*
+     * For reads, we need to move the file pointer to where it would be
+     *  if we weren't buffering, so that the next read will get the
+     *  right chunk of stuff from the file. PHYSFS_flush() handles writes.
+     */
+    if ((fh->forReading) && ((fh->buffill != fh->bufpos) || (fh->ahead)))
+    {
+        PHYSFS_uint64 pos;
+        const PHYSFS_sint64 curpos = PHYSFS_tell(handle);
+        BAIL_IF_MACRO(curpos == -1, ERRPASS, 0);
+        pos = (PHYSFS_uint64) curpos;
+        BAIL_IF_MACRO(!fh->io->seek(fh->io, pos), ERRPASS, 0);
+    } /* if */
 
+    freeReadAhead(fh);  /* a fixed buffer doesn't adapt... */
+    freeWriteBehind(fh);  /* ...or write in the background. */
+    fh->bufmax = 0;
 
-char *__PHYSFS_strdup(const char *str)
-{
-    char *retval = (char *) allocator.Malloc(strlen(str) + 1);
-    if (retval)
-        strcpy(retval, str);
-    return retval;
-} /* __PHYSFS_strdup */
+    if (bufsize == 0)  /* delete existing buffer. */
+    {
+        freeFileBuffer(fh->dirHandle->mem, fh->buffer, fh->bufsize);
+        fh->buffer = NULL;
+        fh->bufsize = 0;
+    } /* if */
 
+    else if ((fh->buffer == NULL) || (fh->bufsize != bufsize))
+    {
+        BAIL_IF_MACRO(!resizeFileBuffer(fh->dirHandle->mem, &fh->buffer,
+                                        &fh->bufsize, bufsize),
+                      PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* else if */
 
-PHYSFS_uint32 __PHYSFS_hashString(const char *str, size_t len)
-{
-    PHYSFS_uint32 hash = 5381;
-    while (len--)
-        hash = ((hash << 5) + hash) ^ *(str++);
-    return hash;
-} /* __PHYSFS_hashString */
+    fh->buffill = fh->bufpos = 0;
+    return 1;
+} /* PHYSFS_setBuffer */
 
 
-/* MAKE SURE you hold stateLock before calling this! */
-static int doRegisterArchiver(const PHYSFS_Archiver *_archiver)
+int PHYSFS_flush(PHYSFS_File *handle)
 {
-    const PHYSFS_uint32 maxver = CURRENT_PHYSFS_ARCHIVER_API_VERSION;
-    const size_t len = (numArchivers + 2) * sizeof (void *);
-    PHYSFS_Archiver *archiver = NULL;
-    PHYSFS_ArchiveInfo *info = NULL;
-    const char *ext = NULL;
-    void *ptr = NULL;
-    size_t i;
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_Io *io;
+    PHYSFS_sint64 rc;
 
-    BAIL_IF_MACRO(!_archiver, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(_archiver->version > maxver, PHYSFS_ERR_UNSUPPORTED, 0);
-    BAIL_IF_MACRO(!_archiver->info.extension, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->info.description, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->info.author, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->info.url, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->openArchive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->enumerateFiles, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->openRead, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->openWrite, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->openAppend, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->remove, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->mkdir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->closeArchive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!_archiver->stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    /* a barrier: everything handed off before now is written, or failed. */
+    BAIL_IF_MACRO(!finishWriteBehind(fh), ERRPASS, 0);
 
-    ext = _archiver->info.extension;
-    for (i = 0; i < numArchivers; i++)
-    {
-        if (__PHYSFS_utf8stricmp(archiveInfo[i]->extension, ext) == 0)
-            BAIL_MACRO(PHYSFS_ERR_DUPLICATE, 0);  /* !!! FIXME: better error? ERR_IN_USE? */
-    } /* for */
+    if ((fh->forReading) || (fh->bufpos == fh->buffill))
+        return 1;  /* open for read or buffer empty are successful no-ops. */
 
-    /* make a copy of the data. */
-    archiver = (PHYSFS_Archiver *) allocator.Malloc(sizeof (*archiver));
-    GOTO_IF_MACRO(!archiver, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
+    /* dump buffer to disk. */
+    io = fh->io;
+    rc = io->write(io, fh->buffer + fh->bufpos, fh->buffill - fh->bufpos);
+    BAIL_IF_MACRO(rc <= 0, ERRPASS, 0);
+    fh->bufpos = fh->buffill = 0;
+    return io->flush ? io->flush(io) : 1;
+} /* PHYSFS_flush */
 
-    /* Must copy sizeof (OLD_VERSION_OF_STRUCT) when version changes! */
-    memcpy(archiver, _archiver, sizeof (*archiver));
 
-    info = (PHYSFS_ArchiveInfo *) &archiver->info;
-    memset(info, '\0', sizeof (*info));  /* NULL in case an alloc fails. */
-    #define CPYSTR(item) \
-        info->item = __PHYSFS_strdup(_archiver->info.item); \
-        GOTO_IF_MACRO(!info->item, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
-    CPYSTR(extension);
-    CPYSTR(description);
-    CPYSTR(author);
-    CPYSTR(url);
-    info->supportsSymlinks = _archiver->info.supportsSymlinks;
-    #undef CPYSTR
+/* What PHYSFS_readUntil() gives a handle with no fixed buffer of its own. */
+#define RECORD_BUFFER_DEFAULT (64 * 1024)
 
-    ptr = allocator.Realloc(archiveInfo, len);
-    GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
-    archiveInfo = (const PHYSFS_ArchiveInfo **) ptr;
+/*
+ * Make room at the end of (fh)'s buffer for another read: slide the bytes
+ *  not handed out yet to the front, or if they fill it, double the buffer.
+ */
+static int makeRecordRoom(FileHandle *fh)
+{
+    const PHYSFS_uint64 pending = fh->buffill - fh->bufpos;
+    __PHYSFS_MemAccount *mem = fh->dirHandle->mem;
+    PHYSFS_uint64 newsize;
+    PHYSFS_uint8 *newbuf;
 
-    ptr = allocator.Realloc(archivers, len);
-    GOTO_IF_MACRO(!ptr, PHYSFS_ERR_OUT_OF_MEMORY, regfailed);
-    archivers = (const PHYSFS_Archiver **) ptr;
+    if (fh->buffill < fh->bufsize)
+        return 1;  /* there's room already. */
 
-    archiveInfo[numArchivers] = info;
-    archiveInfo[numArchivers + 1] = NULL;
+    else if (fh->bufpos > 0)
+    {
+        memmove(fh->buffer, fh->buffer + fh->bufpos, (size_t) pending);
+        fh->buffill = pending;
+        fh->bufpos = 0;
+        return 1;
+    } /* else if */
+
+    /* one record is the whole buffer; it has to grow to hold it. */
+    newsize = fh->bufsize * 2;
+    BAIL_IF_MACRO(!__PHYSFS_ui64FitsAddressSpace(newsize),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    BAIL_IF_MACRO(!__PHYSFS_memAllowed(PHYSFS_MEMORY_BUFFERS, fh->bufsize),
+                  PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    newbuf = allocFileBuffer(mem, newsize);
+    BAIL_IF_MACRO(!newbuf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memcpy(newbuf, fh->buffer, (size_t) pending);
+    freeFileBuffer(mem, fh->buffer, fh->bufsize);
+    fh->buffer = newbuf;
+    fh->bufsize = newsize;
+    return 1;
+} /* makeRecordRoom */
 
-    archivers[numArchivers] = archiver;
-    archivers[numArchivers + 1] = NULL;
 
-    numArchivers++;
+int PHYSFS_readUntil(PHYSFS_File *handle, int delim, const void **data,
+                     PHYSFS_uint64 *len)
+{
+    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_uint64 scanned = 0;
+    PHYSFS_sint64 pos = -1;
+    PHYSFS_uint64 avail;
+    PHYSFS_uint64 used;
+    PHYSFS_uint8 *start;
+    PHYSFS_uint8 *found;
+    PHYSFS_sint64 rc;
 
-    return 1;
+    BAIL_IF_MACRO(!handle, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!data, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!len, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, 0);
 
-regfailed:
-    if (info != NULL)
+    *data = NULL;
+    *len = 0;
+
+    /* records are handed out of the buffer, so it has to be a fixed one. */
+    if ((fh->buffer == NULL) || (fh->bufmax))
     {
-        allocator.Free((void *) info->extension);
-        allocator.Free((void *) info->description);
-        allocator.Free((void *) info->author);
-        allocator.Free((void *) info->url);
+        const PHYSFS_uint64 size = fh->bufmax ? fh->bufmax :
+                                   RECORD_BUFFER_DEFAULT;
+        BAIL_IF_MACRO(!PHYSFS_setBuffer(handle, size), ERRPASS, 0);
     } /* if */
-    allocator.Free(archiver);
 
-    return 0;
-} /* doRegisterArchiver */
+    if (profiling)
+        pos = PHYSFS_tell(handle);
+
+    while (1)
+    {
+        start = fh->buffer + fh->bufpos;
+        avail = fh->buffill - fh->bufpos;
+        found = (PHYSFS_uint8 *) memchr(start + scanned, delim,
+                                        (size_t) (avail - scanned));
+        if (found != NULL)
+        {
+            *len = (PHYSFS_uint64) (found - start);
+            used = *len + 1;  /* the delimiter is used up, too. */
+            break;
+        } /* if */
 
+        scanned = avail;  /* no need to look at these again. */
+        BAIL_IF_MACRO(!makeRecordRoom(fh), ERRPASS, 0);
+        rc = fh->io->read(fh->io, fh->buffer + fh->buffill,
+                          fh->bufsize - fh->buffill);
+        BAIL_IF_MACRO(rc < 0, ERRPASS, 0);
+        if (rc == 0)  /* EOF: what's left is the last record, if any. */
+        {
+            if (avail == 0)
+                return 0;
+            *len = used = avail;
+            break;
+        } /* if */
+        fh->buffill += (PHYSFS_uint64) rc;
+    } /* while */
 
-int PHYSFS_registerArchiver(const PHYSFS_Archiver *archiver)
+    *data = start;
+    fh->bufpos += used;
+    __PHYSFS_STAT_ADD(bytesRead, used);
+    if (pos >= 0)
+        profileRead(fh, (PHYSFS_uint64) pos, used);
+    return 1;
+} /* PHYSFS_readUntil */
+
+
+int PHYSFS_readLine(PHYSFS_File *handle, const char **line,
+                    PHYSFS_uint64 *len)
 {
-    int retval;
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
-    __PHYSFS_platformGrabMutex(stateLock);
-    retval = doRegisterArchiver(archiver);
-    __PHYSFS_platformReleaseMutex(stateLock);
-    return retval;
-} /* PHYSFS_registerArchiver */
+    const void *data = NULL;
+    BAIL_IF_MACRO(!line, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    *line = NULL;
+    if (!PHYSFS_readUntil(handle, '\n', &data, len))
+        return 0;
 
+    *line = (const char *) data;
+    if ((*len > 0) && ((*line)[*len - 1] == '\r'))
+        (*len)--;  /* DOS line endings. */
+    return 1;
+} /* PHYSFS_readLine */
 
-int PHYSFS_deregisterArchiver(const char *ext)
+
+/*
+ * (fname) is already sanitized, in a buffer we can scribble on, or NULL if
+ *  it didn't sanitize. (hash) is hashIndexPath(fname).
+ */
+/*
+ * The guts of PHYSFS_stat(), for a sanitized (fname), or NULL if it wasn't
+ *  sane. Only use this between beginSearchPathRead() and
+ *  endSearchPathRead(). (*found) is set to the DirHandle that had it.
+ */
+static int statSearchPath(PHYSFS_Context *ctx, char *fname,
+                          const PHYSFS_uint32 hash, PHYSFS_Stat *stat,
+                          const DirHandle **found)
 {
-    size_t i;
+    int retval = 0;
 
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
-    BAIL_IF_MACRO(!ext, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    /* set some sane defaults... */
+    stat->filesize = -1;
+    stat->modtime = -1;
+    stat->createtime = -1;
+    stat->accesstime = -1;
+    stat->filetype = PHYSFS_FILETYPE_OTHER;
+    stat->readonly = 1;  /* !!! FIXME */
+    *found = NULL;
 
-    __PHYSFS_platformGrabMutex(stateLock);
-    for (i = 0; i < numArchivers; i++)
+    if (fname != NULL)
     {
-        if (__PHYSFS_utf8stricmp(archiveInfo[i]->extension, ext) == 0)
+        if (*fname == '\0')
         {
-            const int retval = doDeregisterArchiver(i);
-            __PHYSFS_platformReleaseMutex(stateLock);
-            return retval;
+            stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+            stat->readonly = !ctx->writeDir; /* Writeable if there's one */
+            retval = 1;
         } /* if */
-    } /* for */
-    __PHYSFS_platformReleaseMutex(stateLock);
+        else
+        {
+            DirHandle *i;
+            SearchPathIter iter;
+            int exists = 0;
+            const int generation = ctx->searchGeneration;
+            const DirHandle *wd = ctx->writeDir;  /* retired if it's reset. */
+            i = NULL;
+            if (!knownMissing(ctx, fname, hash, generation))
+                i = firstCandidate(ctx, &iter, fname, hash);
+            for (; (i != NULL) && (!exists); i = nextCandidate(&iter))
+            {
+                char *arcfname = fname;
+                exists = partOfMountPoint(i, arcfname);
+                if (exists)
+                {
+                    stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+                    stat->readonly = 1;  /* !!! FIXME */
+                    retval = 1;
+                } /* if */
+                else
+                {
+                    lockDirHandle(i);
+                    if (verifyPath(i, &arcfname, 0))
+                    {
+                        /* !!! FIXME: this test is wrong and should be elsewhere. */
+                        stat->readonly = !(wd &&
+                                     (strcmp(wd->dirName, i->dirName) == 0));
+                        retval = statArchive(i, arcfname, stat);
+                        if ((retval) || (currentErrorCode() != PHYSFS_ERR_NOT_FOUND))
+                        {
+                            exists = 1;
+                            *found = i;
+                        } /* if */
+                    } /* if */
+                    unlockDirHandle(i);
+                } /* else */
+            } /* for */
 
-    BAIL_MACRO(PHYSFS_ERR_NOT_FOUND, 0);
-} /* PHYSFS_deregisterArchiver */
+            if (!exists)
+                rememberMissing(ctx, fname, hash, generation);
+        } /* else */
+    } /* if */
+
+    return retval;
+} /* statSearchPath */
 
 
-const PHYSFS_ArchiveInfo **PHYSFS_supportedArchiveTypes(void)
+static int doStat(char *fname, const PHYSFS_uint32 hash, PHYSFS_Stat *stat)
 {
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
-    return archiveInfo;
-} /* PHYSFS_supportedArchiveTypes */
+    const PHYSFS_uint64 start = timingLatency ? __PHYSFS_platformGetTicks() : 0;
+    PHYSFS_Context *ctx = currentContext();
+    const DirHandle *found = NULL;
+    const int reader = beginSearchPathRead(ctx);
+    const int retval = statSearchPath(ctx, fname, hash, stat, &found);
+    endSearchPathRead(ctx, reader);
 
+    if (timingLatency)
+        recordLatency(PHYSFS_LATENCY_STAT, found, start);
 
-void PHYSFS_freeList(void *list)
+    return retval;
+} /* doStat */
+
+
+int PHYSFS_stat(const char *_fname, PHYSFS_Stat *stat)
 {
-    void **i;
-    if (list != NULL)
-    {
-        for (i = (void **) list; *i != NULL; i++)
-            allocator.Free(*i);
+    int retval;
+    char *fname;
+    size_t len;
 
-        allocator.Free(list);
-    } /* if */
-} /* PHYSFS_freeList */
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
 
+    __PHYSFS_TRACE_BEGIN(PHYSFS_TRACE_STAT, _fname, NULL, 0);
+    if (sanitizePlatformIndependentPath(_fname, fname))
+        retval = doStat(fname, hashIndexPath(fname), stat);
+    else
+        retval = doStat(NULL, 0, stat);
+    __PHYSFS_TRACE_END(PHYSFS_TRACE_STAT, _fname, NULL, 0, retval);
 
-const char *PHYSFS_getDirSeparator(void)
-{
-    static char retval[2] = { __PHYSFS_platformDirSeparator, '\0' };
+    __PHYSFS_smallFree(fname);
     return retval;
-} /* PHYSFS_getDirSeparator */
+} /* PHYSFS_stat */
 
 
-char **PHYSFS_getCdRomDirs(void)
+typedef struct
 {
-    return doEnumStringList(__PHYSFS_platformDetectAvailableCDs);
-} /* PHYSFS_getCdRomDirs */
+    const char **paths;
+    PHYSFS_uint32 *order;  /* indexes into (paths); this is what's sorted. */
+} StatManySort;
 
-
-void PHYSFS_getCdRomDirsCallback(PHYSFS_StringCallback callback, void *data)
+static int cmpStatManyPaths(void *_data, size_t one, size_t two)
 {
-    __PHYSFS_platformDetectAvailableCDs(callback, data);
-} /* PHYSFS_getCdRomDirsCallback */
+    const StatManySort *data = (const StatManySort *) _data;
+    return strcmp(data->paths[data->order[one]],
+                  data->paths[data->order[two]]);
+} /* cmpStatManyPaths */
 
 
-const char *PHYSFS_getPrefDir(const char *org, const char *app)
+static void swapStatManyPaths(void *_data, size_t one, size_t two)
 {
-    const char dirsep = __PHYSFS_platformDirSeparator;
-    PHYSFS_Stat statbuf;
-    char *ptr = NULL;
-    char *endstr = NULL;
+    PHYSFS_uint32 *order = ((StatManySort *) _data)->order;
+    const PHYSFS_uint32 tmp = order[one];
+    order[one] = order[two];
+    order[two] = tmp;
+} /* swapStatManyPaths */
 
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
-    BAIL_IF_MACRO(!org, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
-    BAIL_IF_MACRO(*org == '\0', PHYSFS_ERR_INVALID_ARGUMENT, NULL);
-    BAIL_IF_MACRO(!app, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
-    BAIL_IF_MACRO(*app == '\0', PHYSFS_ERR_INVALID_ARGUMENT, NULL);
 
-    allocator.Free(prefDir);
-    prefDir = __PHYSFS_platformCalcPrefDir(org, app);
-    BAIL_IF_MACRO(!prefDir, ERRPASS, NULL);
+/* (stats) and (results) can each be NULL. */
+static int doStatMany(const char **paths, PHYSFS_Stat *stats, int *results,
+                      const PHYSFS_uint32 count)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_uint32 *order;
+    char *fname = NULL;
+    size_t fnamelen = 0;
+    int retval = 0;
+    int reader;
+    PHYSFS_uint32 i;
 
-    assert(strlen(prefDir) > 0);
-    endstr = prefDir + (strlen(prefDir) - 1);
-    assert(*endstr == dirsep);
-    *endstr = '\0';  /* mask out the final dirsep for now. */
+    BAIL_IF_MACRO((!paths) && (count), PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(count > 0x7FFFFFFF, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    for (i = 0; i < count; i++)
+        BAIL_IF_MACRO(!paths[i], PHYSFS_ERR_INVALID_ARGUMENT, -1);
 
-    if (!__PHYSFS_platformStat(prefDir, &statbuf))
+    /*
+     * Sorted, paths in the same directory come one after another, so each
+     *  archive's verifyPath() cache and whatever the archiver keeps warm
+     *  get used while they're still good. If there's no memory to sort
+     *  them, they just go in the order they came.
+     */
+    order = (PHYSFS_uint32 *) allocator.Malloc(sizeof (PHYSFS_uint32) * count);
+    if (order != NULL)
     {
-        for (ptr = strchr(prefDir, dirsep); ptr; ptr = strchr(ptr+1, dirsep))
-        {
-            *ptr = '\0';
-            __PHYSFS_platformMkDir(prefDir);
-            *ptr = dirsep;
-        } /* for */
-
-        if (!__PHYSFS_platformMkDir(prefDir))
-        {
-            allocator.Free(prefDir);
-            prefDir = NULL;
-        } /* if */
+        StatManySort sortdata;
+        for (i = 0; i < count; i++)
+            order[i] = i;
+        sortdata.paths = paths;
+        sortdata.order = order;
+        __PHYSFS_sort(&sortdata, count, cmpStatManyPaths, swapStatManyPaths);
     } /* if */
 
-    *endstr = dirsep;  /* readd the final dirsep. */
+    reader = beginSearchPathRead(ctx);  /* once, for all of them. */
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_uint32 idx = (order != NULL) ? order[i] : i;
+        const PHYSFS_uint64 start = timingLatency ?
+                                        __PHYSFS_platformGetTicks() : 0;
+        const size_t len = strlen(paths[idx]) + 1;
+        const DirHandle *found = NULL;
+        PHYSFS_Stat statbuf;
+        PHYSFS_Stat *stat = (stats != NULL) ? &stats[idx] : &statbuf;
+        int rc;
 
-    return prefDir;
-} /* PHYSFS_getPrefDir */
+        if (len > fnamelen)
+        {
+            void *ptr = allocator.Realloc(fname, len);
+            if (ptr == NULL)
+            {
+                retval = -1;
+                PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+                break;
+            } /* if */
+            fname = (char *) ptr;
+            fnamelen = len;
+        } /* if */
 
+        if (sanitizePlatformIndependentPath(paths[idx], fname))
+            rc = statSearchPath(ctx, fname, hashIndexPath(fname), stat, &found);
+        else
+            rc = statSearchPath(ctx, NULL, 0, stat, &found);
 
-const char *PHYSFS_getBaseDir(void)
-{
-    return baseDir;   /* this is calculated in PHYSFS_init()... */
-} /* PHYSFS_getBaseDir */
+        if (timingLatency)
+            recordLatency(PHYSFS_LATENCY_STAT, found, start);
 
+        if (results != NULL)
+            results[idx] = rc;
+        if (rc)
+            retval++;
+    } /* for */
+    endSearchPathRead(ctx, reader);
 
-const char *__PHYSFS_getUserDir(void)  /* not deprecated internal version. */
-{
-    return userDir;   /* this is calculated in PHYSFS_init()... */
-} /* __PHYSFS_getUserDir */
+    allocator.Free(fname);
+    allocator.Free(order);
+    return retval;
+} /* doStatMany */
 
 
-const char *PHYSFS_getUserDir(void)
+int PHYSFS_statMany(const char **paths, PHYSFS_Stat *stats, int *results,
+                    PHYSFS_uint32 count)
 {
-    return __PHYSFS_getUserDir();
-} /* PHYSFS_getUserDir */
+    BAIL_IF_MACRO((!stats) && (count), PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    return doStatMany(paths, stats, results, count);
+} /* PHYSFS_statMany */
 
 
-const char *PHYSFS_getWriteDir(void)
+int PHYSFS_existsMany(const char **paths, int *results, PHYSFS_uint32 count)
 {
-    const char *retval = NULL;
-
-    __PHYSFS_platformGrabMutex(stateLock);
-    if (writeDir != NULL)
-        retval = writeDir->dirName;
-    __PHYSFS_platformReleaseMutex(stateLock);
-
-    return retval;
-} /* PHYSFS_getWriteDir */
+    return doStatMany(paths, NULL, results, count);
+} /* PHYSFS_existsMany */
 
 
-int PHYSFS_setWriteDir(const char *newDir)
+int PHYSFS_statInterned(const PHYSFS_Path *path, PHYSFS_Stat *stat)
 {
-    int retval = 1;
-
-    __PHYSFS_platformGrabMutex(stateLock);
-
-    if (writeDir != NULL)
-    {
-        BAIL_IF_MACRO_MUTEX(!freeDirHandle(writeDir, openWriteList), ERRPASS,
-                            stateLock, 0);
-        writeDir = NULL;
-    } /* if */
+    int retval;
+    char *fname;
 
-    if (newDir != NULL)
-    {
-        /* !!! FIXME: PHYSFS_Io shouldn't be NULL */
-        writeDir = createDirHandle(NULL, newDir, NULL, 1);
-        retval = (writeDir != NULL);
-    } /* if */
+    BAIL_IF_MACRO(!path, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    fname = (char *) __PHYSFS_smallAlloc(path->len + 1);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
 
-    __PHYSFS_platformReleaseMutex(stateLock);
+    memcpy(fname, path->path, path->len + 1);
+    retval = doStat(fname, path->hash, stat);
 
+    __PHYSFS_smallFree(fname);
     return retval;
-} /* PHYSFS_setWriteDir */
+} /* PHYSFS_statInterned */
 
 
-static int doMount(PHYSFS_Io *io, const char *fname,
-                   const char *mountPoint, int appendToPath)
+/*
+ * Find the DirHandle that (entry) was in, or NULL if it was unmounted.
+ *  Only use this between beginSearchPathRead() and endSearchPathRead().
+ */
+static DirHandle *findEntryHandle(PHYSFS_Context *ctx,
+                                  const PHYSFS_Entry *entry)
 {
-    DirHandle *dh;
-    DirHandle *prev = NULL;
+    const SearchIndex *idx = ctx->searchIndex;
     DirHandle *i;
 
-    if (mountPoint == NULL)
-        mountPoint = "/";
-
-    __PHYSFS_platformGrabMutex(stateLock);
-
-    if (fname != NULL)
+    if (idx == NULL)
     {
-        for (i = searchPath; i != NULL; i = i->next)
+        for (i = ctx->searchPath; i != NULL; i = i->next)
         {
-            /* already in search path? */
-            if ((i->dirName != NULL) && (strcmp(fname, i->dirName) == 0))
-                BAIL_MACRO_MUTEX(ERRPASS, stateLock, 1);
-            prev = i;
+            if (i->serial == entry->serial)
+                return i;
         } /* for */
     } /* if */
 
-    dh = createDirHandle(io, fname, mountPoint, 0);
-    BAIL_IF_MACRO_MUTEX(!dh, ERRPASS, stateLock, 0);
-
-    if (appendToPath)
-    {
-        if (prev == NULL)
-            searchPath = dh;
-        else
-            prev->next = dh;
-    } /* if */
     else
     {
-        dh->next = searchPath;
-        searchPath = dh;
-    } /* else */
-
-    __PHYSFS_platformReleaseMutex(stateLock);
-    return 1;
-} /* doMount */
+        size_t rank = entry->rank;
+        if ((rank < idx->numHandles) &&
+            (idx->handles[rank]->serial == entry->serial))
+            return idx->handles[rank];
 
+        /* something was mounted or unmounted ahead of it. */
+        for (rank = 0; rank < idx->numHandles; rank++)
+        {
+            if (idx->handles[rank]->serial == entry->serial)
+                return idx->handles[rank];
+        } /* for */
+    } /* else */
 
-int PHYSFS_mountIo(PHYSFS_Io *io, const char *fname,
-                   const char *mountPoint, int appendToPath)
-{
-    BAIL_IF_MACRO(!io, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(io->version != 0, PHYSFS_ERR_UNSUPPORTED, 0);
-    return doMount(io, fname, mountPoint, appendToPath);
-} /* PHYSFS_mountIo */
+    BAIL_MACRO(PHYSFS_ERR_NOT_MOUNTED, NULL);
+} /* findEntryHandle */
 
 
-int PHYSFS_mountMemory(const void *buf, PHYSFS_uint64 len, void (*del)(void *),
-                       const char *fname, const char *mountPoint,
-                       int appendToPath)
+PHYSFS_Entry *PHYSFS_lookup(const char *_fname)
 {
-    int retval = 0;
-    PHYSFS_Io *io = NULL;
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_Entry *retval = NULL;
+    DirHandle *found = NULL;
+    int mountPointDir = 0;
+    size_t arcofs = 0;
+    size_t rank = 0;
+    char *fname;
+    size_t len;
 
-    BAIL_IF_MACRO(!buf, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
+    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    len = strlen(_fname) + 1;
+    fname = (char *) __PHYSFS_smallAlloc(len);
+    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
 
-    io = __PHYSFS_createMemoryIo(buf, len, del);
-    BAIL_IF_MACRO(!io, ERRPASS, 0);
-    retval = doMount(io, fname, mountPoint, appendToPath);
-    if (!retval)
+    if (sanitizePlatformIndependentPath(_fname, fname))
     {
-        /* docs say not to call (del) in case of failure, so cheat. */
-        MemoryIoInfo *info = (MemoryIoInfo *) io->opaque;
-        info->destruct = NULL;
-        io->destroy(io);
-    } /* if */
-
-    return retval;
-} /* PHYSFS_mountMemory */
+        DirHandle *i = NULL;
+        SearchPathIter iter;
+        int failed = 0;
+        const PHYSFS_uint32 hash = hashIndexPath(fname);
+        const int generation = ctx->searchGeneration;
+        const int reader = beginSearchPathRead(ctx);
+
+        if (!knownMissing(ctx, fname, hash, generation))
+            i = firstCandidate(ctx, &iter, fname, hash);
+        for (; (i != NULL) && (!failed); i = nextCandidate(&iter))
+        {
+            char *arcfname = fname;
+            int rc = 0;
 
+            if (partOfMountPoint(i, arcfname))
+                mountPointDir = rc = 1;
+            else
+            {
+                lockDirHandle(i);
+                if (verifyPath(i, &arcfname, 0))
+                {
+                    PHYSFS_Stat statbuf;
+                    rc = statArchive(i, arcfname, &statbuf);
+                    if ((!rc) && (currentErrorCode() != PHYSFS_ERR_NOT_FOUND))
+                        failed = 1;  /* worse than missing; report that. */
+                } /* if */
+                unlockDirHandle(i);
+            } /* else */
 
-int PHYSFS_mountHandle(PHYSFS_File *file, const char *fname,
-                       const char *mountPoint, int appendToPath)
-{
-    int retval = 0;
-    PHYSFS_Io *io = NULL;
+            if (rc)
+            {
+                found = i;
+                arcofs = (size_t) (arcfname - fname);
+                /* a hint for findEntryHandle(); plain walks have none. */
+                rank = (iter.index != NULL) ? iter.ranks[iter.pos - 1] : 0;
+                break;
+            } /* if */
+        } /* for */
+        endSearchPathRead(ctx, reader);
 
-    BAIL_IF_MACRO(file == NULL, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        if (found != NULL)
+        {
+            retval = (PHYSFS_Entry *) allocator.Malloc(sizeof (*retval) + len);
+            if (retval == NULL)
+                PHYSFS_setErrorCode(PHYSFS_ERR_OUT_OF_MEMORY);
+            else
+            {
+                retval->serial = found->serial;
+                retval->rank = rank;
+                retval->mountPointDir = mountPointDir;
+                retval->path = ((char *) retval) + sizeof (*retval);
+                strcpy(retval->path, fname);
+                retval->arcfname = retval->path + arcofs;
+            } /* else */
+        } /* if */
 
-    io = __PHYSFS_createHandleIo(file);
-    BAIL_IF_MACRO(!io, ERRPASS, 0);
-    retval = doMount(io, fname, mountPoint, appendToPath);
-    if (!retval)
-    {
-        /* docs say not to destruct in case of failure, so cheat. */
-        io->opaque = NULL;
-        io->destroy(io);
+        else if (!failed)
+        {
+            rememberMissing(ctx, fname, hash, generation);
+        } /* else if */
     } /* if */
 
+    __PHYSFS_smallFree(fname);
     return retval;
-} /* PHYSFS_mountHandle */
+} /* PHYSFS_lookup */
 
 
-int PHYSFS_mount(const char *newDir, const char *mountPoint, int appendToPath)
-{
-    BAIL_IF_MACRO(!newDir, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    return doMount(NULL, newDir, mountPoint, appendToPath);
-} /* PHYSFS_mount */
-
-
-int PHYSFS_addToSearchPath(const char *newDir, int appendToPath)
+void PHYSFS_freeEntry(PHYSFS_Entry *entry)
 {
-    return doMount(NULL, newDir, NULL, appendToPath);
-} /* PHYSFS_addToSearchPath */
+    allocator.Free(entry);  /* struct and strings are one allocation. */
+} /* PHYSFS_freeEntry */
 
 
-int PHYSFS_removeFromSearchPath(const char *oldDir)
+PHYSFS_File *PHYSFS_openEntry(const PHYSFS_Entry *entry)
 {
-    return PHYSFS_unmount(oldDir);
-} /* PHYSFS_removeFromSearchPath */
+    BAIL_IF_MACRO(!entry, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    return doOpenRead(currentContext(), entry->path, NULL, 0, entry);
+} /* PHYSFS_openEntry */
 
 
-int PHYSFS_unmount(const char *oldDir)
+int PHYSFS_statEntry(const PHYSFS_Entry *entry, PHYSFS_Stat *stat)
 {
+    const PHYSFS_uint64 start = timingLatency ? __PHYSFS_platformGetTicks() : 0;
+    PHYSFS_Context *ctx = currentContext();
     DirHandle *i;
-    DirHandle *prev = NULL;
-    DirHandle *next = NULL;
+    int retval = 0;
+    int reader;
 
-    BAIL_IF_MACRO(oldDir == NULL, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!entry, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    /* set some sane defaults... */
+    stat->filesize = -1;
+    stat->modtime = -1;
+    stat->createtime = -1;
+    stat->accesstime = -1;
+    stat->filetype = PHYSFS_FILETYPE_OTHER;
+    stat->readonly = 1;  /* !!! FIXME */
 
-    __PHYSFS_platformGrabMutex(stateLock);
-    for (i = searchPath; i != NULL; i = i->next)
+    reader = beginSearchPathRead(ctx);
+    i = findEntryHandle(ctx, entry);
+    if ((i != NULL) && (entry->mountPointDir))
     {
-        if (strcmp(i->dirName, oldDir) == 0)
-        {
-            next = i->next;
-            BAIL_IF_MACRO_MUTEX(!freeDirHandle(i, openReadList), ERRPASS,
-                                stateLock, 0);
-
-            if (prev == NULL)
-                searchPath = next;
-            else
-                prev->next = next;
+        stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        retval = 1;
+    } /* if */
 
-            BAIL_MACRO_MUTEX(ERRPASS, stateLock, 1);
-        } /* if */
-        prev = i;
-    } /* for */
+    else if (i != NULL)
+    {
+        const DirHandle *wd = ctx->writeDir;  /* retired if it's reset. */
+        lockDirHandle(i);
+        /* !!! FIXME: this test is wrong and should be elsewhere. */
+        stat->readonly = !(wd && (strcmp(wd->dirName, i->dirName) == 0));
+        retval = statArchive(i, entry->arcfname, stat);
+        unlockDirHandle(i);
+    } /* else if */
+    endSearchPathRead(ctx, reader);
+
+    if (timingLatency)
+        recordLatency(PHYSFS_LATENCY_STAT, i, start);
 
-    BAIL_MACRO_MUTEX(PHYSFS_ERR_NOT_MOUNTED, stateLock, 0);
-} /* PHYSFS_unmount */
+    return retval;
+} /* PHYSFS_statEntry */
 
 
-char **PHYSFS_getSearchPath(void)
+/*
+ * Ask (entry)'s archive for the CRC-32 it has stored for it. 1 == got it,
+ *  0 == failed, -1 == it has none, so the file has to be read for one.
+ */
+static int storedChecksum(const PHYSFS_Entry *entry, PHYSFS_uint32 *crc)
 {
-    return doEnumStringList(PHYSFS_getSearchPathCallback);
-} /* PHYSFS_getSearchPath */
+    PHYSFS_Context *ctx = currentContext();
+    const int reader = beginSearchPathRead(ctx);
+    DirHandle *i = findEntryHandle(ctx, entry);
+    int retval = 0;
 
+    if ((i != NULL) && (entry->mountPointDir))
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
 
-const char *PHYSFS_getMountPoint(const char *dir)
-{
-    DirHandle *i;
-    __PHYSFS_platformGrabMutex(stateLock);
-    for (i = searchPath; i != NULL; i = i->next)
+    else if ((i != NULL) && (i->funcs->checksum == NULL))
+        retval = -1;
+
+    else if (i != NULL)
     {
-        if (strcmp(i->dirName, dir) == 0)
+        lockDirHandle(i);
+        if (i->funcs->checksum(i->opaque, entry->arcfname, crc))
+            retval = 1;
+        else if (currentErrorCode() == PHYSFS_ERR_UNSUPPORTED)
         {
-            const char *retval = ((i->mountPoint) ? i->mountPoint : "/");
-            __PHYSFS_platformReleaseMutex(stateLock);
-            return retval;
-        } /* if */
-    } /* for */
-    __PHYSFS_platformReleaseMutex(stateLock);
+            PHYSFS_getLastErrorCode();  /* not the app's problem. */
+            retval = -1;
+        } /* else if */
+        unlockDirHandle(i);
+    } /* else if */
 
-    BAIL_MACRO(PHYSFS_ERR_NOT_MOUNTED, NULL);
-} /* PHYSFS_getMountPoint */
+    endSearchPathRead(ctx, reader);
+    return retval;
+} /* storedChecksum */
 
 
-void PHYSFS_getSearchPathCallback(PHYSFS_StringCallback callback, void *data)
+#define CHECKSUM_BUFFER_SIZE (64 * 1024)
+
+/* Read all of (entry) to work out its CRC-32, for archives that don't say. */
+static int computeChecksum(const PHYSFS_Entry *entry, PHYSFS_uint32 *crc)
 {
-    DirHandle *i;
+    PHYSFS_File *f = NULL;
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_uint32 sum = 0;
+    PHYSFS_sint64 rc;
 
-    __PHYSFS_platformGrabMutex(stateLock);
+    buf = (PHYSFS_uint8 *) allocator.Malloc(CHECKSUM_BUFFER_SIZE);
+    BAIL_IF_MACRO(!buf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    f = PHYSFS_openEntry(entry);
+    GOTO_IF_MACRO(!f, ERRPASS, computeChecksum_failed);
 
-    for (i = searchPath; i != NULL; i = i->next)
-        callback(data, i->dirName);
+    while ((rc = PHYSFS_readBytes(f, buf, CHECKSUM_BUFFER_SIZE)) > 0)
+        sum = PHYSFS_crc32(sum, buf, (PHYSFS_uint64) rc);
+    GOTO_IF_MACRO(rc < 0, ERRPASS, computeChecksum_failed);
 
-    __PHYSFS_platformReleaseMutex(stateLock);
-} /* PHYSFS_getSearchPathCallback */
+    PHYSFS_close(f);
+    allocator.Free(buf);
+    *crc = sum;
+    return 1;
 
+computeChecksum_failed:
+    if (f != NULL)
+        PHYSFS_close(f);
+    allocator.Free(buf);
+    return 0;
+} /* computeChecksum */
 
-/* Split out to avoid stack allocation in a loop. */
-static void setSaneCfgAddPath(const char *i, const size_t l, const char *dirsep,
-                              int archivesFirst)
+
+int PHYSFS_getChecksum(const char *fname, PHYSFS_uint32 *crc)
 {
-    const char *d = PHYSFS_getRealDir(i);
-    const size_t allocsize = strlen(d) + strlen(dirsep) + l + 1;
-    char *str = (char *) __PHYSFS_smallAlloc(allocsize);
-    if (str != NULL)
-    {
-        sprintf(str, "%s%s%s", d, dirsep, i);
-        PHYSFS_mount(str, NULL, archivesFirst == 0);
-        __PHYSFS_smallFree(str);
-    } /* if */
-} /* setSaneCfgAddPath */
+    PHYSFS_Entry *entry;
+    int retval;
 
+    BAIL_IF_MACRO(!crc, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    entry = PHYSFS_lookup(fname);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
 
-int PHYSFS_setSaneConfig(const char *organization, const char *appName,
-                         const char *archiveExt, int includeCdRoms,
-                         int archivesFirst)
-{
-    const char *dirsep = PHYSFS_getDirSeparator();
-    const char *basedir;
-    const char *prefdir;
+    retval = storedChecksum(entry, crc);
+    if (retval == -1)
+        retval = computeChecksum(entry, crc);
 
-    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    PHYSFS_freeEntry(entry);
+    return retval;
+} /* PHYSFS_getChecksum */
 
-    prefdir = PHYSFS_getPrefDir(organization, appName);
-    BAIL_IF_MACRO(!prefdir, ERRPASS, 0);
 
-    basedir = PHYSFS_getBaseDir();
-    BAIL_IF_MACRO(!basedir, ERRPASS, 0);
+int PHYSFS_statLayout(const char *fname, PHYSFS_EntryLayout *layout)
+{
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_Entry *entry;
+    DirHandle *i;
+    int reader;
+    int retval = 0;
 
-    BAIL_IF_MACRO(!PHYSFS_setWriteDir(prefdir), PHYSFS_ERR_NO_WRITE_DIR, 0);
+    BAIL_IF_MACRO(!layout, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    entry = PHYSFS_lookup(fname);
+    BAIL_IF_MACRO(!entry, ERRPASS, 0);
 
-    /* Put write dir first in search path... */
-    PHYSFS_mount(prefdir, NULL, 0);
+    reader = beginSearchPathRead(ctx);
+    i = findEntryHandle(ctx, entry);
+    if ((i != NULL) && (entry->mountPointDir))
+        PHYSFS_setErrorCode(PHYSFS_ERR_NOT_A_FILE);
 
-    /* Put base path on search path... */
-    PHYSFS_mount(basedir, NULL, 1);
+    else if ((i != NULL) && (i->funcs->layout == NULL))
+        PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
 
-    /* handle CD-ROMs... */
-    if (includeCdRoms)
+    else if (i != NULL)
     {
-        char **cds = PHYSFS_getCdRomDirs();
-        char **i;
-        for (i = cds; *i != NULL; i++)
-            PHYSFS_mount(*i, NULL, 1);
-        PHYSFS_freeList(cds);
-    } /* if */
+        memset(layout, '\0', sizeof (*layout));
+        layout->group = -1;
+        lockDirHandle(i);
+        retval = i->funcs->layout(i->opaque, entry->arcfname, layout);
+        unlockDirHandle(i);
+        layout->mount = i->dirName;
+    } /* else if */
+    endSearchPathRead(ctx, reader);
+
+    PHYSFS_freeEntry(entry);
+    return retval;
+} /* PHYSFS_statLayout */
 
-    /* Root out archives, and add them to search path... */
-    if (archiveExt != NULL)
-    {
-        char **rc = PHYSFS_enumerateFiles("/");
-        char **i;
-        size_t extlen = strlen(archiveExt);
-        char *ext;
 
-        for (i = rc; *i != NULL; i++)
-        {
-            size_t l = strlen(*i);
-            if ((l > extlen) && ((*i)[l - extlen - 1] == '.'))
-            {
-                ext = (*i) + (l - extlen);
-                if (__PHYSFS_utf8stricmp(ext, archiveExt) == 0)
-                    setSaneCfgAddPath(*i, l, dirsep, archivesFirst);
-            } /* if */
-        } /* for */
+int __PHYSFS_readAll(PHYSFS_Io *io, void *buf, const PHYSFS_uint64 len)
+{
+    return (io->read(io, buf, len) == len);
+} /* __PHYSFS_readAll */
 
-        PHYSFS_freeList(rc);
-    } /* if */
 
-    return 1;
-} /* PHYSFS_setSaneConfig */
+void PHYSFS_setSeekIndexInterval(PHYSFS_uint32 interval)
+{
+    seekIndexInterval = interval;
+} /* PHYSFS_setSeekIndexInterval */
 
 
-void PHYSFS_permitSymbolicLinks(int allow)
+void PHYSFS_setDecompressionCacheSize(PHYSFS_uint64 bytes)
 {
-    allowSymLinks = allow;
-} /* PHYSFS_permitSymbolicLinks */
+    decompressionCacheSize = bytes;
+} /* PHYSFS_setDecompressionCacheSize */
 
 
-int PHYSFS_symbolicLinksPermitted(void)
+PHYSFS_uint64 __PHYSFS_getDecompressionCacheSize(void)
 {
-    return allowSymLinks;
-} /* PHYSFS_symbolicLinksPermitted */
+    return decompressionCacheSize;
+} /* __PHYSFS_getDecompressionCacheSize */
 
 
-/*
- * Verify that (fname) (in platform-independent notation), in relation
- *  to (h) is secure. That means that each element of fname is checked
- *  for symlinks (if they aren't permitted). This also allows for quick
- *  rejection of files that exist outside an archive's mountpoint.
- *
- * With some exceptions (like PHYSFS_mkdir(), which builds multiple subdirs
- *  at a time), you should always pass zero for "allowMissing" for efficiency.
- *
- * (fname) must point to an output from sanitizePlatformIndependentPath(),
- *  since it will make sure that path names are in the right format for
- *  passing certain checks. It will also do checks for "insecure" pathnames
- *  like ".." which should be done once instead of once per archive. This also
- *  gives us license to treat (fname) as scratch space in this function.
- *
- * Returns non-zero if string is safe, zero if there's a security issue.
- *  PHYSFS_getLastError() will specify what was wrong. (*fname) will be
- *  updated to point past any mount point elements so it is prepared to
- *  be used with the archiver directly.
- */
-static int verifyPath(DirHandle *h, char **_fname, int allowMissing)
+void PHYSFS_setReadCoalescing(PHYSFS_uint64 maxGap, PHYSFS_uint64 maxRead)
 {
-    char *fname = *_fname;
-    int retval = 1;
-    char *start;
-    char *end;
+    readCoalesceGap = maxGap;
+    readCoalesceMax = maxRead;
+} /* PHYSFS_setReadCoalescing */
 
-    if (*fname == '\0')  /* quick rejection. */
-        return 1;
 
-    /* !!! FIXME: This codeblock sucks. */
-    if (h->mountPoint != NULL)  /* NULL mountpoint means "/". */
-    {
-        size_t mntpntlen = strlen(h->mountPoint);
-        size_t len = strlen(fname);
-        assert(mntpntlen > 1); /* root mount points should be NULL. */
-        /* not under the mountpoint, so skip this archive. */
-        BAIL_IF_MACRO(len < mntpntlen-1, PHYSFS_ERR_NOT_FOUND, 0);
-        /* !!! FIXME: Case insensitive? */
-        retval = strncmp(h->mountPoint, fname, mntpntlen-1);
-        BAIL_IF_MACRO(retval != 0, PHYSFS_ERR_NOT_FOUND, 0);
-        if (len > mntpntlen-1)  /* corner case... */
-            BAIL_IF_MACRO(fname[mntpntlen-1]!='/', PHYSFS_ERR_NOT_FOUND, 0);
-        fname += mntpntlen-1;  /* move to start of actual archive path. */
-        if (*fname == '/')
-            fname++;
-        *_fname = fname;  /* skip mountpoint for later use. */
-        retval = 1;  /* may be reset, below. */
-    } /* if */
+void PHYSFS_setCacheHugePages(int enable)
+{
+    cacheHugePages = enable;
+} /* PHYSFS_setCacheHugePages */
 
-    start = fname;
-    if (!allowSymLinks)
-    {
-        while (1)
-        {
-            PHYSFS_Stat statbuf;
-            int rc = 0;
-            end = strchr(start, '/');
 
-            if (end != NULL) *end = '\0';
-            rc = h->funcs->stat(h->opaque, fname, &statbuf);
-            if (rc)
-                rc = (statbuf.filetype == PHYSFS_FILETYPE_SYMLINK);
-            else if (currentErrorCode() == PHYSFS_ERR_NOT_FOUND)
-                retval = 0;
+/*
+ * Cache buffers start with a header saying how they were allocated, so
+ *  they can be freed without anyone remembering. The first size_t is the
+ *  length of the whole block, header and all, and the second is non-zero
+ *  if it came from __PHYSFS_platformAllocHuge() instead of
+ *  __PHYSFS_alignedMalloc(). It's a cache line, so the data stays aligned.
+ */
+/* This goes in front of each, padded so what follows is still aligned. */
+typedef struct
+{
+    size_t len;  /* everything, this included. */
+    int huge;  /* from __PHYSFS_platformAllocHuge(). */
+    __PHYSFS_MemAccount *owner;  /* charged with the totals, or NULL. */
+} CacheAllocHeader;
 
-            if (end != NULL) *end = '/';
+#define CACHE_ALLOC_HEADER __PHYSFS_SIMD_ALIGN
 
-            /* insecure path (has a disallowed symlink in it)? */
-            BAIL_IF_MACRO(rc, PHYSFS_ERR_SYMLINK_FORBIDDEN, 0);
+void *__PHYSFS_cacheAlloc(size_t len)
+{
+    CacheAllocHeader *header = NULL;
+    int huge = 0;
 
-            /* break out early if path element is missing. */
-            if (!retval)
-            {
-                /*
-                 * We need to clear it if it's the last element of the path,
-                 *  since this might be a non-existant file we're opening
-                 *  for writing...
-                 */
-                if ((end == NULL) || (allowMissing))
-                    retval = 1;
-                break;
-            } /* if */
+    if (len > ((size_t) -1) - CACHE_ALLOC_HEADER)
+        return NULL;
 
-            if (end == NULL)
-                break;
+    len += CACHE_ALLOC_HEADER;
 
-            start = end + 1;
-        } /* while */
+    /* an app's allocator wants to see all of our memory. */
+    if ((cacheHugePages) && (!externalAllocator) &&
+        (len >= __PHYSFS_HUGE_PAGE_MIN))
+    {
+        header = (CacheAllocHeader *) __PHYSFS_platformAllocHuge(len);
+        huge = (header != NULL);
     } /* if */
 
-    return retval;
-} /* verifyPath */
-
-
-static int doMkdir(const char *_dname, char *dname)
-{
-    DirHandle *h;
-    char *start;
-    char *end;
-    int retval = 0;
-    int exists = 1;  /* force existance check on first path element. */
-
-    BAIL_IF_MACRO(!sanitizePlatformIndependentPath(_dname, dname), ERRPASS, 0);
-
-    __PHYSFS_platformGrabMutex(stateLock);
-    BAIL_IF_MACRO_MUTEX(!writeDir, PHYSFS_ERR_NO_WRITE_DIR, stateLock, 0);
-    h = writeDir;
-    BAIL_IF_MACRO_MUTEX(!verifyPath(h, &dname, 1), ERRPASS, stateLock, 0);
-
-    start = dname;
-    while (1)
+    if (header == NULL)
     {
-        end = strchr(start, '/');
-        if (end != NULL)
-            *end = '\0';
+        header = (CacheAllocHeader *) __PHYSFS_alignedMalloc(len,
+                                                    __PHYSFS_SIMD_ALIGN);
+        if (header == NULL)
+            return NULL;
+    } /* if */
 
-        /* only check for existance if all parent dirs existed, too... */
-        if (exists)
-        {
-            PHYSFS_Stat statbuf;
-            const int rc = h->funcs->stat(h->opaque, dname, &statbuf);
-            if ((!rc) && (currentErrorCode() == PHYSFS_ERR_NOT_FOUND))
-                exists = 0;
-            retval = ((rc) && (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY));
-        } /* if */
+    header->len = len;
+    header->huge = huge;
+    header->owner = NULL;
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_CACHES, (PHYSFS_sint64) len);
+    return ((PHYSFS_uint8 *) header) + CACHE_ALLOC_HEADER;
+} /* __PHYSFS_cacheAlloc */
 
-        if (!exists)
-            retval = h->funcs->mkdir(h->opaque, dname);
 
-        if (!retval)
-            break;
+void __PHYSFS_cacheFree(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        CacheAllocHeader *header = (CacheAllocHeader *)
+                                (((PHYSFS_uint8 *) ptr) - CACHE_ALLOC_HEADER);
+        __PHYSFS_memCharge(header->owner, PHYSFS_MEMORY_CACHES,
+                           -((PHYSFS_sint64) header->len));
+        if (header->huge)
+            __PHYSFS_platformFreeHuge(header, header->len);
+        else
+            __PHYSFS_alignedFree(header, header->len, __PHYSFS_SIMD_ALIGN);
+    } /* if */
+} /* __PHYSFS_cacheFree */
 
-        if (end == NULL)
-            break;
 
-        *end = '/';
-        start = end + 1;
-    } /* while */
+void __PHYSFS_cacheOwner(void *ptr, __PHYSFS_MemAccount *acct)
+{
+    CacheAllocHeader *header = (CacheAllocHeader *)
+                                (((PHYSFS_uint8 *) ptr) - CACHE_ALLOC_HEADER);
+    assert(header->owner == NULL);
+    header->owner = acct;
+    chargeMemAccount(acct, PHYSFS_MEMORY_CACHES, (PHYSFS_sint64) header->len);
+} /* __PHYSFS_cacheOwner */
 
-    __PHYSFS_platformReleaseMutex(stateLock);
-    return retval;
-} /* doMkdir */
 
+/*
+ * Scratch blocks are rounded up to a power of two, so the next decode of
+ *  a similar folder finds one that fits. Ones bigger than SCRATCH_POOL_MAX
+ *  aren't worth keeping: decoding that much dwarfs the allocation.
+ */
+#define SCRATCH_POOL_SLOTS 8
+#define SCRATCH_POOL_MIN (4 * 1024)
+#define SCRATCH_POOL_MAX (8 * 1024 * 1024)
 
-int PHYSFS_mkdir(const char *_dname)
+typedef struct
 {
-    int retval = 0;
-    char *dname;
-    size_t len;
+    size_t len;  /* everything, this included. */
+} ScratchAllocHeader;
 
-    BAIL_IF_MACRO(!_dname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    len = strlen(_dname) + 1;
-    dname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!dname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    retval = doMkdir(_dname, dname);
-    __PHYSFS_smallFree(dname);
-    return retval;
-} /* PHYSFS_mkdir */
+#define SCRATCH_ALLOC_HEADER __PHYSFS_SIMD_ALIGN
 
+static ScratchAllocHeader *scratchPool[SCRATCH_POOL_SLOTS];
 
-static int doDelete(const char *_fname, char *fname)
+void *__PHYSFS_scratchAlloc(size_t len)
 {
-    int retval;
-    DirHandle *h;
-    BAIL_IF_MACRO(!sanitizePlatformIndependentPath(_fname, fname), ERRPASS, 0);
+    ScratchAllocHeader *header = NULL;
+    size_t cap = SCRATCH_POOL_MIN;
+    size_t i;
 
-    __PHYSFS_platformGrabMutex(stateLock);
+    if (len > SCRATCH_POOL_MAX)
+        cap = len;
+    else
+    {
+        while (cap < len)
+            cap <<= 1;
+    } /* else */
 
-    BAIL_IF_MACRO_MUTEX(!writeDir, PHYSFS_ERR_NO_WRITE_DIR, stateLock, 0);
-    h = writeDir;
-    BAIL_IF_MACRO_MUTEX(!verifyPath(h, &fname, 0), ERRPASS, stateLock, 0);
-    retval = h->funcs->remove(h->opaque, fname);
+    if (cap > ((size_t) -1) - SCRATCH_ALLOC_HEADER)
+        return NULL;
+    cap += SCRATCH_ALLOC_HEADER;
 
-    __PHYSFS_platformReleaseMutex(stateLock);
-    return retval;
-} /* doDelete */
+    if ((cap <= SCRATCH_POOL_MAX + SCRATCH_ALLOC_HEADER) &&
+        (scratchLock != NULL))
+    {
+        ScratchAllocHeader **best = NULL;
+        __PHYSFS_platformGrabMutex(scratchLock);
+        for (i = 0; i < SCRATCH_POOL_SLOTS; i++)
+        {
+            ScratchAllocHeader *h = scratchPool[i];
+            if ((h != NULL) && (h->len >= cap) &&
+                ((best == NULL) || (h->len < (*best)->len)))
+                best = &scratchPool[i];
+        } /* for */
+        if (best != NULL)
+        {
+            header = *best;
+            *best = NULL;
+        } /* if */
+        __PHYSFS_platformReleaseMutex(scratchLock);
+    } /* if */
 
+    if (header == NULL)
+    {
+        header = (ScratchAllocHeader *) __PHYSFS_alignedMalloc(cap,
+                                                    __PHYSFS_SIMD_ALIGN);
+        if (header == NULL)
+            return NULL;
+        header->len = cap;
+        __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_DECODERS, (PHYSFS_sint64) cap);
+    } /* if */
 
-int PHYSFS_delete(const char *_fname)
-{
-    int retval;
-    char *fname;
-    size_t len;
+    return ((PHYSFS_uint8 *) header) + SCRATCH_ALLOC_HEADER;
+} /* __PHYSFS_scratchAlloc */
 
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    len = strlen(_fname) + 1;
-    fname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    retval = doDelete(_fname, fname);
-    __PHYSFS_smallFree(fname);
-    return retval;
-} /* PHYSFS_delete */
+
+static void freeScratch(ScratchAllocHeader *header)
+{
+    __PHYSFS_memCharge(NULL, PHYSFS_MEMORY_DECODERS,
+                       -((PHYSFS_sint64) header->len));
+    __PHYSFS_alignedFree(header, header->len, __PHYSFS_SIMD_ALIGN);
+} /* freeScratch */
 
 
-const char *PHYSFS_getRealDir(const char *_fname)
+void __PHYSFS_scratchFree(void *ptr)
 {
-    const char *retval = NULL;
-    char *fname = NULL;
-    size_t len;
+    ScratchAllocHeader *header;
+    size_t i;
 
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
-    len = strlen(_fname) + 1;
-    fname = __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    if (sanitizePlatformIndependentPath(_fname, fname))
+    if (ptr == NULL)
+        return;
+
+    header = (ScratchAllocHeader *)
+                (((PHYSFS_uint8 *) ptr) - SCRATCH_ALLOC_HEADER);
+
+    /* pool it, unless it's huge, or decoders are over their limit. */
+    if ((header->len <= SCRATCH_POOL_MAX + SCRATCH_ALLOC_HEADER) &&
+        (scratchLock != NULL) && (!__PHYSFS_memExcess(PHYSFS_MEMORY_DECODERS)))
     {
-        DirHandle *i;
-        __PHYSFS_platformGrabMutex(stateLock);
-        for (i = searchPath; i != NULL; i = i->next)
+        __PHYSFS_platformGrabMutex(scratchLock);
+        for (i = 0; i < SCRATCH_POOL_SLOTS; i++)
         {
-            char *arcfname = fname;
-            if (partOfMountPoint(i, arcfname))
+            if (scratchPool[i] == NULL)
             {
-                retval = i->dirName;
+                scratchPool[i] = header;
+                header = NULL;
                 break;
             } /* if */
-            else if (verifyPath(i, &arcfname, 0))
-            {
-                PHYSFS_Stat statbuf;
-                if (i->funcs->stat(i->opaque, arcfname, &statbuf))
-                {
-                    retval = i->dirName;
-                    break;
-                } /* if */
-            } /* if */
         } /* for */
-        __PHYSFS_platformReleaseMutex(stateLock);
+        __PHYSFS_platformReleaseMutex(scratchLock);
     } /* if */
 
-    __PHYSFS_smallFree(fname);
+    if (header != NULL)
+        freeScratch(header);
+} /* __PHYSFS_scratchFree */
+
+
+static void freeScratchPool(void)
+{
+    size_t i;
+    for (i = 0; i < SCRATCH_POOL_SLOTS; i++)
+    {
+        if (scratchPool[i] != NULL)
+        {
+            freeScratch(scratchPool[i]);
+            scratchPool[i] = NULL;
+        } /* if */
+    } /* for */
+} /* freeScratchPool */
+
+
+void *__PHYSFS_ramLookup(const char *name)
+{
+    void *retval = NULL;
+    RamDir *i;
+
+    __PHYSFS_platformGrabMutex(ramLock);
+    for (i = ramDirs; i != NULL; i = i->next)
+    {
+        if (strcmp(i->name, name) == 0)
+        {
+            retval = i->fs;
+            __PHYSFS_ramRetain(retval);
+            break;
+        } /* if */
+    } /* for */
+    __PHYSFS_platformReleaseMutex(ramLock);
+
     return retval;
-} /* PHYSFS_getRealDir */
+} /* __PHYSFS_ramLookup */
 
 
-static int locateInStringList(const char *str,
-                              char **list,
-                              PHYSFS_uint32 *pos)
+int PHYSFS_createRamDir(const char *name, PHYSFS_uint64 spillLimit,
+                        const char *spillDir)
 {
-    PHYSFS_uint32 len = *pos;
-    PHYSFS_uint32 half_len;
-    PHYSFS_uint32 lo = 0;
-    PHYSFS_uint32 middle;
-    int cmp;
+    RamDir *ramDir;
+    RamDir *i;
 
-    while (len > 0)
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!name, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(*name == '\0', PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    ramDir = (RamDir *) allocator.Malloc(sizeof (RamDir) + strlen(name) + 1);
+    BAIL_IF_MACRO(!ramDir, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    ramDir->name = (char *) (ramDir + 1);
+    strcpy(ramDir->name, name);
+    ramDir->fs = __PHYSFS_ramCreate(spillLimit, spillDir);
+    if (ramDir->fs == NULL)
     {
-        half_len = len >> 1;
-        middle = lo + half_len;
-        cmp = strcmp(list[middle], str);
+        allocator.Free(ramDir);
+        return 0;
+    } /* if */
 
-        if (cmp == 0)  /* it's in the list already. */
-            return 1;
-        else if (cmp > 0)
-            len = half_len;
-        else
-        {
-            lo = middle + 1;
-            len -= half_len + 1;
-        } /* else */
-    } /* while */
+    __PHYSFS_platformGrabMutex(ramLock);
+    for (i = ramDirs; i != NULL; i = i->next)
+    {
+        if (strcmp(i->name, name) == 0)
+            break;
+    } /* for */
 
-    *pos = lo;
-    return 0;
-} /* locateInStringList */
+    if (i == NULL)
+    {
+        ramDir->next = ramDirs;
+        ramDirs = ramDir;
+    } /* if */
+    __PHYSFS_platformReleaseMutex(ramLock);
+
+    if (i != NULL)
+    {
+        __PHYSFS_ramRelease(ramDir->fs);
+        allocator.Free(ramDir);
+        BAIL_MACRO(PHYSFS_ERR_DUPLICATE, 0);
+    } /* if */
+
+    return 1;
+} /* PHYSFS_createRamDir */
 
 
-static void enumFilesCallback(void *data, const char *origdir, const char *str)
+int PHYSFS_destroyRamDir(const char *name)
 {
-    PHYSFS_uint32 pos;
-    void *ptr;
-    char *newstr;
-    EnumStringListCallbackData *pecd = (EnumStringListCallbackData *) data;
+    RamDir *prev = NULL;
+    RamDir *i;
 
-    /*
-     * See if file is in the list already, and if not, insert it in there
-     *  alphabetically...
-     */
-    pos = pecd->size;
-    if (locateInStringList(str, pecd->list, &pos))
-        return;  /* already in the list. */
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!name, PHYSFS_ERR_INVALID_ARGUMENT, 0);
 
-    ptr = allocator.Realloc(pecd->list, (pecd->size + 2) * sizeof (char *));
-    newstr = (char *) allocator.Malloc(strlen(str) + 1);
-    if (ptr != NULL)
-        pecd->list = (char **) ptr;
+    __PHYSFS_platformGrabMutex(ramLock);
+    for (i = ramDirs; i != NULL; i = i->next)
+    {
+        if (strcmp(i->name, name) == 0)
+        {
+            if (prev == NULL)
+                ramDirs = i->next;
+            else
+                prev->next = i->next;
+            break;
+        } /* if */
+        prev = i;
+    } /* for */
+    __PHYSFS_platformReleaseMutex(ramLock);
 
-    if ((ptr == NULL) || (newstr == NULL))
-        return;  /* better luck next time. */
+    BAIL_IF_MACRO(!i, PHYSFS_ERR_NOT_FOUND, 0);
 
-    strcpy(newstr, str);
+    /* mounts and the write dir keep their own references. */
+    __PHYSFS_ramRelease(i->fs);
+    allocator.Free(i);
+    return 1;
+} /* PHYSFS_destroyRamDir */
+
+
+/* the search path and write dir are gone by now, so this is the last ref. */
+static void freeRamDirs(void)
+{
+    while (ramDirs != NULL)
+    {
+        RamDir *next = ramDirs->next;
+        __PHYSFS_ramRelease(ramDirs->fs);
+        allocator.Free(ramDirs);
+        ramDirs = next;
+    } /* while */
+} /* freeRamDirs */
+
+
+int PHYSFS_setIndexCacheDir(const char *dir)
+{
+    char *copy = NULL;
+    char *prev;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
 
-    if (pos != pecd->size)
+    if (dir != NULL)
     {
-        memmove(&pecd->list[pos+1], &pecd->list[pos],
-                 sizeof (char *) * ((pecd->size) - pos));
+        PHYSFS_Stat st;
+        BAIL_IF_MACRO(!__PHYSFS_platformStat(dir, &st), ERRPASS, 0);
+        BAIL_IF_MACRO(st.filetype != PHYSFS_FILETYPE_DIRECTORY,
+                      PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        copy = (char *) allocator.Malloc(strlen(dir) + 1);
+        BAIL_IF_MACRO(!copy, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        strcpy(copy, dir);
     } /* if */
 
-    pecd->list[pos] = newstr;
-    pecd->size++;
-} /* enumFilesCallback */
+    grabStateLock();
+    prev = indexCacheDir;
+    indexCacheDir = copy;
+    __PHYSFS_platformReleaseMutex(stateLock);
 
+    allocator.Free(prev);
+    return 1;
+} /* PHYSFS_setIndexCacheDir */
 
-char **PHYSFS_enumerateFiles(const char *path)
+
+static PHYSFS_uint64 hashRead64(const PHYSFS_uint8 *ptr)
 {
-    EnumStringListCallbackData ecd;
-    memset(&ecd, '\0', sizeof (ecd));
-    ecd.list = (char **) allocator.Malloc(sizeof (char *));
-    BAIL_IF_MACRO(!ecd.list, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
-    PHYSFS_enumerateFilesCallback(path, enumFilesCallback, &ecd);
-    ecd.list[ecd.size] = NULL;
-    return ecd.list;
-} /* PHYSFS_enumerateFiles */
+    PHYSFS_uint64 val;
+    memcpy(&val, ptr, sizeof (val));
+    return PHYSFS_swapULE64(val);
+} /* hashRead64 */
+
+
+static PHYSFS_uint64 hashMix64(PHYSFS_uint64 k)
+{
+    k ^= k >> 33;
+    k *= __PHYSFS_UI64(0xFF51AFD7ED558CCD);
+    k ^= k >> 33;
+    k *= __PHYSFS_UI64(0xC4CEB9FE1A85EC53);
+    k ^= k >> 33;
+    return k;
+} /* hashMix64 */
+
+
+#define HASH_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* MurmurHash3 x64_128 with a zero seed; a zero-padded tail mixes the same. */
+void __PHYSFS_hashContent(const void *_buf, PHYSFS_uint64 len,
+                          PHYSFS_uint8 *hash)
+{
+    const PHYSFS_uint64 c1 = __PHYSFS_UI64(0x87C37B91114253D5);
+    const PHYSFS_uint64 c2 = __PHYSFS_UI64(0x4CF5AD432745937F);
+    const PHYSFS_uint8 *buf = (const PHYSFS_uint8 *) _buf;
+    PHYSFS_uint64 remain = len;
+    PHYSFS_uint64 h1 = 0;
+    PHYSFS_uint64 h2 = 0;
+    PHYSFS_uint64 k1, k2;
+    PHYSFS_uint8 tail[16];
+
+    for (; remain >= 16; remain -= 16, buf += 16)
+    {
+        k1 = hashRead64(buf) * c1;
+        k1 = HASH_ROTL64(k1, 31) * c2;
+        h1 ^= k1;
+        h1 = HASH_ROTL64(h1, 27) + h2;
+        h1 = (h1 * 5) + 0x52DCE729;
+
+        k2 = hashRead64(buf + 8) * c2;
+        k2 = HASH_ROTL64(k2, 33) * c1;
+        h2 ^= k2;
+        h2 = HASH_ROTL64(h2, 31) + h1;
+        h2 = (h2 * 5) + 0x38495AB5;
+    } /* for */
+
+    memset(tail, '\0', sizeof (tail));
+    memcpy(tail, buf, (size_t) remain);
+    k1 = hashRead64(tail) * c1;
+    h1 ^= HASH_ROTL64(k1, 31) * c2;
+    k2 = hashRead64(tail + 8) * c2;
+    h2 ^= HASH_ROTL64(k2, 33) * c1;
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = hashMix64(h1);
+    h2 = hashMix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    h1 = PHYSFS_swapULE64(h1);
+    h2 = PHYSFS_swapULE64(h2);
+    memcpy(hash, &h1, sizeof (h1));
+    memcpy(hash + 8, &h2, sizeof (h2));
+} /* __PHYSFS_hashContent */
 
 
 /*
- * Broke out to seperate function so we can use stack allocation gratuitously.
+ * The spill cache. Each file is a header, SPILL_MAGIC and then the data's
+ *  length as a little-endian uint64, padded to SPILL_HEADER_LEN so the data
+ *  after it stays aligned once it's mapped, and then the data.
  */
-static void enumerateFromMountPoint(DirHandle *i, const char *arcfname,
-                                    PHYSFS_EnumFilesCallback callback,
-                                    const char *_fname, void *data)
-{
-    const size_t len = strlen(arcfname);
-    char *ptr = NULL;
-    char *end = NULL;
-    const size_t slen = strlen(i->mountPoint) + 1;
-    char *mountPoint = (char *) __PHYSFS_smallAlloc(slen);
+#define SPILL_MAGIC "PHYSPILL"
+#define SPILL_HEADER_LEN 32
 
-    if (mountPoint == NULL)
-        return;  /* oh well. */
+/* Spill files this run saved, to delete when it's done, unless persisting. */
+typedef struct __PHYSFS_SPILLFILE__
+{
+    char *name;
+    struct __PHYSFS_SPILLFILE__ *next;
+} SpillFile;
 
-    strcpy(mountPoint, i->mountPoint);
-    ptr = mountPoint + ((len) ? len + 1 : 0);
-    end = strchr(ptr, '/');
-    assert(end);  /* should always find a terminating '/'. */
-    *end = '\0';
-    callback(data, _fname, ptr);
-    __PHYSFS_smallFree(mountPoint);
-} /* enumerateFromMountPoint */
+static SpillFile *spillFiles = NULL;
 
 
-typedef struct SymlinkFilterData
+/* Delete every file in spillFiles. Hold stateLock, or be shutting down. */
+static void freeSpillFiles(void)
 {
-    PHYSFS_EnumFilesCallback callback;
-    void *callbackData;
-    DirHandle *dirhandle;
-} SymlinkFilterData;
+    while (spillFiles != NULL)
+    {
+        SpillFile *next = spillFiles->next;
+        __PHYSFS_platformDelete(spillFiles->name);
+        allocator.Free(spillFiles->name);
+        allocator.Free(spillFiles);
+        spillFiles = next;
+    } /* while */
+} /* freeSpillFiles */
 
-/* !!! FIXME: broken if in a virtual mountpoint (stat call fails). */
-static void enumCallbackFilterSymLinks(void *_data, const char *origdir,
-                                       const char *fname)
+
+/* The spill file for (key), or NULL if there's no spill dir. Free it. */
+static char *spillFileName(const void *key, const size_t keylen)
 {
-    const char *trimmedDir = (*origdir == '/') ? (origdir+1) : origdir;
-    const size_t slen = strlen(trimmedDir) + strlen(fname) + 2;
-    char *path = (char *) __PHYSFS_smallAlloc(slen);
+    PHYSFS_uint8 hash[__PHYSFS_CONTENT_HASH_LEN];
+    char *retval = NULL;
+    char *ptr;
+    int i;
 
-    if (path != NULL)
-    {
-        SymlinkFilterData *data = (SymlinkFilterData *) _data;
-        const DirHandle *dh = data->dirhandle;
-        PHYSFS_Stat statbuf;
+    __PHYSFS_hashContent(key, keylen, hash);
 
-        sprintf(path, "%s%s%s", trimmedDir, *trimmedDir ? "/" : "", fname);
-        if (dh->funcs->stat(dh->opaque, path, &statbuf))
+    grabStateLock();
+    if (spillCacheDir != NULL)
+    {
+        /* separator, two hex digits a hash byte, ".spill", null. */
+        retval = (char *) allocator.Malloc(strlen(spillCacheDir) +
+                                           (__PHYSFS_CONTENT_HASH_LEN * 2) +
+                                           8);
+        if (retval != NULL)
         {
-            /* Pass it on to the application if it's not a symlink. */
-            if (statbuf.filetype != PHYSFS_FILETYPE_SYMLINK)
-                data->callback(data->callbackData, origdir, fname);
+            ptr = retval + sprintf(retval, "%s%c", spillCacheDir,
+                                   __PHYSFS_platformDirSeparator);
+            for (i = 0; i < __PHYSFS_CONTENT_HASH_LEN; i++)
+                ptr += sprintf(ptr, "%02x", (unsigned int) hash[i]);
+            strcpy(ptr, ".spill");
         } /* if */
-
-        __PHYSFS_smallFree(path);
     } /* if */
-} /* enumCallbackFilterSymLinks */
+    __PHYSFS_platformReleaseMutex(stateLock);
 
+    return retval;
+} /* spillFileName */
 
-/* !!! FIXME: this should report error conditions. */
-void PHYSFS_enumerateFilesCallback(const char *_fname,
-                                   PHYSFS_EnumFilesCallback callback,
-                                   void *data)
+
+void *__PHYSFS_spillLoad(const void *key, const size_t keylen,
+                         const PHYSFS_uint64 len, const void **ptr)
 {
-    size_t len;
-    char *fname;
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    char *name = spillFileName(key, keylen);
+    const PHYSFS_uint8 *base = NULL;
+    PHYSFS_uint64 maplen = 0;
+    void *retval = NULL;
 
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
-    BAIL_IF_MACRO(!callback, PHYSFS_ERR_INVALID_ARGUMENT, ) /*0*/;
+    if (name != NULL)
+    {
+        retval = __PHYSFS_platformMapFile(name, (const void **) &base,
+                                          &maplen);
+        allocator.Free(name);
+    } /* if */
 
-    len = strlen(_fname) + 1;
-    fname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, ) /*0*/;
+    /* a different length is a different file, or one that got cut off. */
+    if ( (retval != NULL) &&
+         ( (maplen != len + SPILL_HEADER_LEN) ||
+           (memcmp(base, SPILL_MAGIC, 8) != 0) ||
+           (hashRead64(base + 8) != len) ) )
+    {
+        __PHYSFS_platformUnmapFile(retval);
+        retval = NULL;
+    } /* if */
 
-    if (sanitizePlatformIndependentPath(_fname, fname))
+    if (retval != NULL)
     {
-        DirHandle *i;
-        SymlinkFilterData filterdata;
+        __PHYSFS_STAT_INCR(spillHits);
+        *ptr = base + SPILL_HEADER_LEN;
+    } /* if */
+
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+    return retval;
+} /* __PHYSFS_spillLoad */
+
 
-        __PHYSFS_platformGrabMutex(stateLock);
+void __PHYSFS_spillSave(const void *key, const size_t keylen,
+                        const void *buf, const PHYSFS_uint64 len)
+{
+    const PHYSFS_ErrorCode prevErr = PHYSFS_getLastErrorCode();
+    PHYSFS_uint8 header[SPILL_HEADER_LEN];
+    SpillFile *spilled = NULL;
+    char *name = spillFileName(key, keylen);
+    char *tmp = NULL;
+    void *handle = NULL;
+    PHYSFS_uint64 swapped;
+    PHYSFS_Stat st;
+    int ok = 0;
+
+    if (name == NULL)
+        goto spillSaveDone;
+    else if (__PHYSFS_platformStat(name, &st))
+        goto spillSaveDone;  /* someone saved it already. */
+
+    /* written under a name of its own, so nobody maps half of it. */
+    tmp = (char *) allocator.Malloc(strlen(name) + 40);
+    if (tmp == NULL)
+        goto spillSaveDone;
+    sprintf(tmp, "%s.%p.tmp", name, __PHYSFS_platformGetThreadID());
+
+    memset(header, '\0', sizeof (header));
+    memcpy(header, SPILL_MAGIC, 8);
+    swapped = PHYSFS_swapULE64(len);
+    memcpy(header + 8, &swapped, sizeof (swapped));
+
+    handle = __PHYSFS_platformOpenWrite(tmp);
+    if (handle != NULL)
+    {
+        ok = ((__PHYSFS_platformWrite(handle, header, sizeof (header)) ==
+                    (PHYSFS_sint64) sizeof (header)) &&
+              (__PHYSFS_platformWrite(handle, buf, len) ==
+                    (PHYSFS_sint64) len));
+        ok = __PHYSFS_platformFlush(handle) && ok;
+        __PHYSFS_platformClose(handle);
+        ok = ok && __PHYSFS_platformRename(tmp, name);
+        if (!ok)
+            __PHYSFS_platformDelete(tmp);
+    } /* if */
 
-        if (!allowSymLinks)
+    if (ok)
+    {
+        __PHYSFS_STAT_ADD(spillBytesWritten, len);
+        grabStateLock();
+        if ((!spillPersist) &&
+            ((spilled = (SpillFile *) allocator.Malloc(sizeof (*spilled)))))
         {
-            memset(&filterdata, '\0', sizeof (filterdata));
-            filterdata.callback = callback;
-            filterdata.callbackData = data;
+            spilled->name = name;
+            spilled->next = spillFiles;
+            spillFiles = spilled;
+            name = NULL;  /* it's spillFiles' now. */
         } /* if */
+        __PHYSFS_platformReleaseMutex(stateLock);
+    } /* if */
 
-        for (i = searchPath; i != NULL; i = i->next)
-        {
-            char *arcfname = fname;
-            if (partOfMountPoint(i, arcfname))
-                enumerateFromMountPoint(i, arcfname, callback, _fname, data);
+spillSaveDone:
+    allocator.Free(tmp);
+    allocator.Free(name);
+    PHYSFS_getLastErrorCode();  /* clear anything we set... */
+    PHYSFS_setErrorCode(prevErr);  /* ...and put back what was there. */
+} /* __PHYSFS_spillSave */
 
-            else if (verifyPath(i, &arcfname, 0))
-            {
-                if ((!allowSymLinks) && (i->funcs->info.supportsSymlinks))
-                {
-                    filterdata.dirhandle = i;
-                    i->funcs->enumerateFiles(i->opaque, arcfname,
-                                             enumCallbackFilterSymLinks,
-                                             _fname, &filterdata);
-                } /* if */
-                else
-                {
-                    i->funcs->enumerateFiles(i->opaque, arcfname,
-                                             callback, _fname, data);
-                } /* else */
-            } /* else if */
-        } /* for */
-        __PHYSFS_platformReleaseMutex(stateLock);
+
+int PHYSFS_setSpillCacheDir(const char *dir, int persist)
+{
+    char *copy = NULL;
+    char *prev;
+
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+
+    if (dir != NULL)
+    {
+        PHYSFS_Stat st;
+        BAIL_IF_MACRO(!__PHYSFS_platformStat(dir, &st), ERRPASS, 0);
+        BAIL_IF_MACRO(st.filetype != PHYSFS_FILETYPE_DIRECTORY,
+                      PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        copy = (char *) allocator.Malloc(strlen(dir) + 1);
+        BAIL_IF_MACRO(!copy, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        strcpy(copy, dir);
     } /* if */
 
-    __PHYSFS_smallFree(fname);
-} /* PHYSFS_enumerateFilesCallback */
+    grabStateLock();
+    freeSpillFiles();  /* the last dir's, if they weren't to be kept. */
+    prev = spillCacheDir;
+    spillCacheDir = copy;
+    spillPersist = persist;
+    __PHYSFS_platformReleaseMutex(stateLock);
+
+    allocator.Free(prev);
+    return 1;
+} /* PHYSFS_setSpillCacheDir */
 
+#undef HASH_ROTL64
 
-int PHYSFS_exists(const char *fname)
+
+static CachedBlob **blobSlot(const PHYSFS_uint8 *hash)
 {
-    return (PHYSFS_getRealDir(fname) != NULL);
-} /* PHYSFS_exists */
+    PHYSFS_uint32 idx;
+    memcpy(&idx, hash, sizeof (idx));  /* it's a hash already. */
+    return &blobSlots[idx & (BLOB_CACHE_SLOTS - 1)];
+} /* blobSlot */
 
 
-PHYSFS_sint64 PHYSFS_getLastModTime(const char *fname)
+/* Find (hash, len) in the blob cache. Hold blobCacheLock. */
+static CachedBlob *findBlob(const PHYSFS_uint8 *hash, const PHYSFS_uint64 len)
 {
-    PHYSFS_Stat statbuf;
-    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, -1);
-    return statbuf.modtime;
-} /* PHYSFS_getLastModTime */
+    CachedBlob *blob;
+    for (blob = *blobSlot(hash); blob != NULL; blob = blob->chain)
+    {
+        if (blob->len != len)
+            continue;
+        else if (memcmp(blob->hash, hash, sizeof (blob->hash)) == 0)
+            return blob;
+    } /* for */
+    return NULL;
+} /* findBlob */
 
 
-int PHYSFS_isDirectory(const char *fname)
+/* Unlink (blob) from the LRU list. Hold blobCacheLock. */
+static void unlinkBlob(CachedBlob *blob)
 {
-    PHYSFS_Stat statbuf;
-    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, 0);
-    return (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY);
-} /* PHYSFS_isDirectory */
+    if (blob->prev != NULL)
+        blob->prev->next = blob->next;
+    else
+        blobHead = blob->next;
 
+    if (blob->next != NULL)
+        blob->next->prev = blob->prev;
+    else
+        blobTail = blob->prev;
 
-int PHYSFS_isSymbolicLink(const char *fname)
+    blob->prev = blob->next = NULL;
+} /* unlinkBlob */
+
+
+/* Make (blob) the most recently used. Hold blobCacheLock. */
+static void pushBlob(CachedBlob *blob)
 {
-    PHYSFS_Stat statbuf;
-    BAIL_IF_MACRO(!PHYSFS_stat(fname, &statbuf), ERRPASS, 0);
-    return (statbuf.filetype == PHYSFS_FILETYPE_SYMLINK);
-} /* PHYSFS_isSymbolicLink */
+    blob->prev = NULL;
+    blob->next = blobHead;
+    if (blobHead != NULL)
+        blobHead->prev = blob;
+    else
+        blobTail = blob;
+    blobHead = blob;
+} /* pushBlob */
 
 
-static PHYSFS_File *doOpenWrite(const char *_fname, int appending)
+/* Forget (blob) entirely. Hold blobCacheLock. */
+static void evictBlob(CachedBlob *blob)
 {
-    FileHandle *fh = NULL;
-    size_t len;
-    char *fname;
+    CachedBlob **prev = blobSlot(blob->hash);
+    while (*prev != blob)
+        prev = &(*prev)->chain;
+    *prev = blob->chain;
+    unlinkBlob(blob);
+    blobCacheUsed -= blob->len;
+} /* evictBlob */
 
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    len = strlen(_fname) + 1;
-    fname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
 
-    if (sanitizePlatformIndependentPath(_fname, fname))
+static void freeBlobs(CachedBlob *blob)
+{
+    while (blob != NULL)
     {
-        PHYSFS_Io *io = NULL;
-        DirHandle *h = NULL;
-        const PHYSFS_Archiver *f;
+        CachedBlob *next = blob->next;
+        blob->io->destroy(blob->io);  /* open files keep theirs. */
+        allocator.Free(blob);
+        blob = next;
+    } /* while */
+} /* freeBlobs */
 
-        __PHYSFS_platformGrabMutex(stateLock);
 
-        GOTO_IF_MACRO(!writeDir, PHYSFS_ERR_NO_WRITE_DIR, doOpenWriteEnd);
+/* Nothing else may be using the cache when you call this. */
+static void freeBlobCache(void)
+{
+    freeBlobs(blobHead);
+    memset(blobSlots, '\0', sizeof (blobSlots));
+    blobHead = blobTail = NULL;
+    blobCacheUsed = 0;
+} /* freeBlobCache */
 
-        h = writeDir;
-        GOTO_IF_MACRO(!verifyPath(h, &fname, 0), ERRPASS, doOpenWriteEnd);
 
-        f = h->funcs;
-        if (appending)
-            io = f->openAppend(h->opaque, fname);
-        else
-            io = f->openWrite(h->opaque, fname);
+PHYSFS_Io *__PHYSFS_blobCacheLookup(const PHYSFS_uint8 *hash,
+                                    const PHYSFS_uint64 len)
+{
+    PHYSFS_Io *retval = NULL;
+    CachedBlob *blob;
 
-        GOTO_IF_MACRO(!io, ERRPASS, doOpenWriteEnd);
+    if (decompressionCacheSize == 0)
+        return NULL;
 
-        fh = (FileHandle *) allocator.Malloc(sizeof (FileHandle));
-        if (fh == NULL)
+    __PHYSFS_platformGrabMutex(blobCacheLock);
+    blob = findBlob(hash, len);
+    if (blob != NULL)
+    {
+        retval = blob->io->duplicate(blob->io);
+        if ((retval != NULL) && (blob != blobHead))
         {
-            io->destroy(io);
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, doOpenWriteEnd);
+            unlinkBlob(blob);
+            pushBlob(blob);
         } /* if */
-        else
-        {
-            memset(fh, '\0', sizeof (FileHandle));
-            fh->io = io;
-            fh->dirHandle = h;
-            fh->next = openWriteList;
-            openWriteList = fh;
-        } /* else */
-
-        doOpenWriteEnd:
-        __PHYSFS_platformReleaseMutex(stateLock);
     } /* if */
+    __PHYSFS_platformReleaseMutex(blobCacheLock);
 
-    __PHYSFS_smallFree(fname);
-    return ((PHYSFS_File *) fh);
-} /* doOpenWrite */
+    return retval;
+} /* __PHYSFS_blobCacheLookup */
 
 
-PHYSFS_File *PHYSFS_openWrite(const char *filename)
+PHYSFS_Io *__PHYSFS_blobCacheFill(const PHYSFS_uint8 *hash, PHYSFS_Io *io)
 {
-    return doOpenWrite(filename, 0);
-} /* PHYSFS_openWrite */
+    const PHYSFS_uint64 budget = decompressionCacheSize;
+    const PHYSFS_sint64 len = io->length(io);
+    PHYSFS_uint8 actual[__PHYSFS_CONTENT_HASH_LEN];
+    CachedBlob *evicted = NULL;
+    CachedBlob *blob = NULL;
+    PHYSFS_uint64 excess;
+    PHYSFS_uint8 *buf = NULL;
+    PHYSFS_Io *memio = NULL;
+    PHYSFS_Io *retval = NULL;
+
+    if ((len <= 0) || (((PHYSFS_uint64) len) > (budget / 4)))
+        return io;
+    else if (!__PHYSFS_ui64FitsAddressSpace(len))
+        return io;
+    else if (!__PHYSFS_memAllowed(PHYSFS_MEMORY_CACHES, len))
+        return io;
+
+    buf = (PHYSFS_uint8 *) __PHYSFS_cacheAlloc((size_t) len);
+    blob = (CachedBlob *) allocator.Malloc(sizeof (CachedBlob));
+    if ((buf == NULL) || (blob == NULL))
+        goto blobCacheFill_failed;
+    else if (!__PHYSFS_readAll(io, buf, (PHYSFS_uint64) len))
+        goto blobCacheFill_failed;
+
+    /* a blob other archives will be handed has to be what it claims. */
+    __PHYSFS_hashContent(buf, (PHYSFS_uint64) len, actual);
+    if (memcmp(actual, hash, sizeof (actual)) != 0)
+        goto blobCacheFill_failed;
+    else if ((memio = __PHYSFS_createMemoryIo(buf, (PHYSFS_uint64) len,
+                                              __PHYSFS_cacheFree)) == NULL)
+        goto blobCacheFill_failed;
+
+    buf = NULL;  /* memio owns it now. */
+    retval = memio->duplicate(memio);
+    if (retval == NULL)
+        goto blobCacheFill_failed;
+
+    io->destroy(io);
+    memcpy(blob->hash, hash, sizeof (blob->hash));
+    blob->len = (PHYSFS_uint64) len;
+    blob->io = memio;
+    blob->prev = blob->next = NULL;
+
+    __PHYSFS_platformGrabMutex(blobCacheLock);
+    if (findBlob(hash, blob->len) != NULL)  /* another thread beat us. */
+        evicted = blob;  /* just drop ours. */
+    else
+    {
+        CachedBlob **slot = blobSlot(hash);
+        blob->chain = *slot;
+        *slot = blob;
+        pushBlob(blob);
+        blobCacheUsed += blob->len;
+
+        /* make room, least recently used first. */
+        excess = __PHYSFS_memExcess(PHYSFS_MEMORY_CACHES);
+        while (((blobCacheUsed > budget) || (excess > 0)) &&
+               (blobTail != blob))
+        {
+            CachedBlob *victim = blobTail;
+            excess -= (excess < victim->len) ? excess : victim->len;
+            evictBlob(victim);
+            victim->next = evicted;
+            evicted = victim;
+        } /* while */
+    } /* else */
+    __PHYSFS_platformReleaseMutex(blobCacheLock);
+
+    freeBlobs(evicted);
+    return retval;
 
+blobCacheFill_failed:
+    if (memio != NULL)
+        memio->destroy(memio);
+    __PHYSFS_cacheFree(buf);
+    allocator.Free(blob);
 
-PHYSFS_File *PHYSFS_openAppend(const char *filename)
+    /* whatever we read of (io) has to be unread. */
+    if (!io->seek(io, 0))
+    {
+        io->destroy(io);
+        return NULL;
+    } /* if */
+    return io;
+} /* __PHYSFS_blobCacheFill */
+
+
+/*
+ * Pinned files' contents start with this, padded so what follows is still
+ *  aligned, so pinFree() knows where it came from. It's the memoryIo's
+ *  destructor, so it runs when the last open file and the pin are gone.
+ */
+typedef struct
 {
-    return doOpenWrite(filename, 1);
-} /* PHYSFS_openAppend */
+    size_t len;  /* everything, this included. */
+    int locked;  /* from __PHYSFS_platformAllocLocked(). */
+    __PHYSFS_MemAccount *owner;  /* charged with it. */
+} PinAllocHeader;
 
+#define PIN_ALLOC_HEADER __PHYSFS_SIMD_ALIGN
 
-PHYSFS_File *PHYSFS_openRead(const char *_fname)
+static void *pinAlloc(__PHYSFS_MemAccount *owner, PHYSFS_uint64 _len)
 {
-    FileHandle *fh = NULL;
-    char *fname;
-    size_t len;
+    PinAllocHeader *header = NULL;
+    const size_t len = (size_t) _len + PIN_ALLOC_HEADER;
+    int locked = 0;
 
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    len = strlen(_fname) + 1;
-    fname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    BAIL_IF_MACRO(_len > ((size_t) -1) - PIN_ALLOC_HEADER,
+                  PHYSFS_ERR_OUT_OF_MEMORY, NULL);
 
-    if (sanitizePlatformIndependentPath(_fname, fname))
+    /* an app's allocator wants to see all of our memory. */
+    if (!externalAllocator)
     {
-        DirHandle *i = NULL;
-        PHYSFS_Io *io = NULL;
+        header = (PinAllocHeader *) __PHYSFS_platformAllocLocked(len);
+        locked = (header != NULL);
+    } /* if */
 
-        __PHYSFS_platformGrabMutex(stateLock);
+    if (header == NULL)
+    {
+        header = (PinAllocHeader *) __PHYSFS_alignedMalloc(len,
+                                                    __PHYSFS_SIMD_ALIGN);
+        BAIL_IF_MACRO(!header, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
 
-        GOTO_IF_MACRO(!searchPath, PHYSFS_ERR_NOT_FOUND, openReadEnd);
+    header->len = len;
+    header->locked = locked;
+    header->owner = owner;
+    __PHYSFS_memCharge(owner, PHYSFS_MEMORY_PINNED, (PHYSFS_sint64) len);
+    return ((PHYSFS_uint8 *) header) + PIN_ALLOC_HEADER;
+} /* pinAlloc */
 
-        for (i = searchPath; i != NULL; i = i->next)
-        {
-            char *arcfname = fname;
-            if (verifyPath(i, &arcfname, 0))
-            {
-                io = i->funcs->openRead(i->opaque, arcfname);
-                if (io)
-                    break;
-            } /* if */
-        } /* for */
 
-        GOTO_IF_MACRO(!io, ERRPASS, openReadEnd);
+static void pinFree(void *ptr)
+{
+    PinAllocHeader *header = (PinAllocHeader *)
+                                (((PHYSFS_uint8 *) ptr) - PIN_ALLOC_HEADER);
+    __PHYSFS_memCharge(header->owner, PHYSFS_MEMORY_PINNED,
+                       -((PHYSFS_sint64) header->len));
+    if (header->locked)
+        __PHYSFS_platformFreeLocked(header, header->len);
+    else
+        __PHYSFS_alignedFree(header, header->len, __PHYSFS_SIMD_ALIGN);
+} /* pinFree */
 
-        fh = (FileHandle *) allocator.Malloc(sizeof (FileHandle));
-        if (fh == NULL)
-        {
-            io->destroy(io);
-            GOTO_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, openReadEnd);
-        } /* if */
 
-        memset(fh, '\0', sizeof (FileHandle));
-        fh->io = io;
-        fh->forReading = 1;
-        fh->dirHandle = i;
-        fh->next = openReadList;
-        openReadList = fh;
+static void freePins(PinnedFile *pin)
+{
+    while (pin != NULL)
+    {
+        PinnedFile *next = pin->next;
+        pin->io->destroy(pin->io);  /* open files keep theirs. */
+        allocator.Free(pin);
+        pin = next;
+    } /* while */
+} /* freePins */
 
-        openReadEnd:
-        __PHYSFS_platformReleaseMutex(stateLock);
-    } /* if */
 
-    __PHYSFS_smallFree(fname);
-    return ((PHYSFS_File *) fh);
-} /* PHYSFS_openRead */
+/* Find (arcfname), which hashes to (hash), in (h)'s pins. Hold pinLock. */
+static PinnedFile *findPin(const DirHandle *h, const char *arcfname,
+                           const PHYSFS_uint32 hash)
+{
+    PinnedFile *pin;
+    for (pin = h->pins; pin != NULL; pin = pin->next)
+    {
+        if ((pin->hash == hash) && (strcmp(pin->arcfname, arcfname) == 0))
+            return pin;
+    } /* for */
+    return NULL;
+} /* findPin */
 
 
-static int closeHandleInOpenList(FileHandle **list, FileHandle *handle)
+/* A new Io over (arcfname)'s pinned contents, or NULL if it's not pinned. */
+static PHYSFS_Io *openPinned(DirHandle *h, const char *arcfname)
 {
-    FileHandle *prev = NULL;
-    FileHandle *i;
-    int rc = 1;
+    const PHYSFS_uint32 hash = hashIndexPath(arcfname);
+    PHYSFS_Io *retval = NULL;
+    PinnedFile *pin;
+
+    __PHYSFS_platformGrabMutex(pinLock);
+    pin = findPin(h, arcfname, hash);
+    if (pin != NULL)
+        retval = pin->io->duplicate(pin->io);
+    __PHYSFS_platformReleaseMutex(pinLock);
+
+    return retval;
+} /* openPinned */
+
+
+/* Read (_fname) from the archive PHYSFS_openRead() would, and pin it there. */
+static int pinFile(PHYSFS_Context *ctx, const char *_fname)
+{
+    const size_t pathlen = strlen(_fname) + 1;
+    PinnedFile *pin = NULL;
+    PHYSFS_Io *io = NULL;
+    void *buf = NULL;
+    DirHandle *i = NULL;
+    char *arcfname = NULL;
+    char *fname = NULL;
+    SearchPathIter iter;
+    PHYSFS_sint64 len;
+    PHYSFS_uint32 hash;
+    int reader;
+    int retval = 0;
+
+    /* the path, then the path in the archive, which is no longer. */
+    pin = (PinnedFile *) allocator.Malloc(sizeof (PinnedFile) + pathlen * 2);
+    BAIL_IF_MACRO(!pin, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    memset(pin, '\0', sizeof (PinnedFile));
+    pin->path = (char *) (pin + 1);
+    pin->arcfname = pin->path + pathlen;
 
-    for (i = *list; i != NULL; i = i->next)
+    fname = (char *) __PHYSFS_smallAlloc(pathlen);
+    if (!fname)
     {
-        if (i == handle)  /* handle is in this list? */
-        {
-            PHYSFS_Io *io = handle->io;
-            PHYSFS_uint8 *tmp = handle->buffer;
-            rc = PHYSFS_flush((PHYSFS_File *) handle);
-            if (!rc)
-                return -1;
-            io->destroy(io);
+        allocator.Free(pin);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
 
-            if (tmp != NULL)  /* free any associated buffer. */
-                allocator.Free(tmp);
+    if (!sanitizePlatformIndependentPath(_fname, fname))
+    {
+        __PHYSFS_smallFree(fname);
+        allocator.Free(pin);
+        return 0;
+    } /* if */
+    strcpy(pin->path, fname);  /* verifyPath() scribbles on (fname). */
 
-            if (prev == NULL)
-                *list = handle->next;
-            else
-                prev->next = handle->next;
+    reader = beginSearchPathRead(ctx);
+    GOTO_IF_MACRO(!ctx->searchPath, PHYSFS_ERR_NOT_FOUND, pinFile_end);
 
-            allocator.Free(handle);
-            return 1;
-        } /* if */
-        prev = i;
+    hash = hashIndexPath(fname);
+    for (i = firstCandidate(ctx, &iter, fname, hash); i != NULL;
+         i = nextCandidate(&iter))
+    {
+        arcfname = fname;
+        lockDirHandle(i);
+        if (verifyPath(i, &arcfname, 0))
+            io = i->funcs->openRead(i->opaque, arcfname);
+        unlockDirHandle(i);
+        if (io)
+            break;
     } /* for */
 
-    return 0;
-} /* closeHandleInOpenList */
+    GOTO_IF_MACRO(!io, ERRPASS, pinFile_end);
+    strcpy(pin->arcfname, arcfname);
+    pin->hash = hashIndexPath(pin->arcfname);
 
+    __PHYSFS_platformGrabMutex(pinLock);
+    retval = (findPin(i, pin->arcfname, pin->hash) != NULL);
+    __PHYSFS_platformReleaseMutex(pinLock);
+    if (retval)
+        goto pinFile_end;  /* already pinned; nothing to do. */
 
-int PHYSFS_close(PHYSFS_File *_handle)
-{
-    FileHandle *handle = (FileHandle *) _handle;
-    int rc;
+    len = io->length(io);
+    GOTO_IF_MACRO(len < 0, ERRPASS, pinFile_end);
+    buf = pinAlloc(i->mem, (PHYSFS_uint64) len);
+    GOTO_IF_MACRO(!buf, ERRPASS, pinFile_end);
+    GOTO_IF_MACRO(!__PHYSFS_readAll(io, buf, (PHYSFS_uint64) len),
+                  ERRPASS, pinFile_end);
 
-    __PHYSFS_platformGrabMutex(stateLock);
+    pin->io = __PHYSFS_createMemoryIo(buf, (PHYSFS_uint64) len, pinFree);
+    GOTO_IF_MACRO(!pin->io, ERRPASS, pinFile_end);
+    buf = NULL;  /* (pin->io) frees it now. */
 
-    /* -1 == close failure. 0 == not found. 1 == success. */
-    rc = closeHandleInOpenList(&openReadList, handle);
-    BAIL_IF_MACRO_MUTEX(rc == -1, ERRPASS, stateLock, 0);
-    if (!rc)
+    __PHYSFS_platformGrabMutex(pinLock);
+    if (findPin(i, pin->arcfname, pin->hash) == NULL)  /* not beaten to it. */
     {
-        rc = closeHandleInOpenList(&openWriteList, handle);
-        BAIL_IF_MACRO_MUTEX(rc == -1, ERRPASS, stateLock, 0);
+        pin->next = i->pins;
+        i->pins = pin;
+        pin = NULL;
     } /* if */
+    __PHYSFS_platformReleaseMutex(pinLock);
+    retval = 1;
 
-    __PHYSFS_platformReleaseMutex(stateLock);
-    BAIL_IF_MACRO(!rc, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    return 1;
-} /* PHYSFS_close */
+pinFile_end:
+    endSearchPathRead(ctx, reader);
+    if (io != NULL)
+        io->destroy(io);
+    if (buf != NULL)
+        pinFree(buf);
+    if (pin != NULL)
+    {
+        if (pin->io != NULL)
+            pin->io->destroy(pin->io);
+        allocator.Free(pin);
+    } /* if */
+    __PHYSFS_smallFree(fname);
+    return retval;
+} /* pinFile */
 
 
-static PHYSFS_sint64 doBufferedRead(FileHandle *fh, void *buffer,
-                                    PHYSFS_uint64 len)
+int PHYSFS_pin(const char **paths, PHYSFS_uint32 count)
 {
-    PHYSFS_Io *io = NULL;
-    PHYSFS_sint64 retval = 0;
-    PHYSFS_uint32 buffered = 0;
-    PHYSFS_sint64 rc = 0;
+    PHYSFS_Context *ctx = currentContext();
+    PHYSFS_uint32 i;
 
-    if (len == 0)
-        return 0;
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO((!paths) && (count > 0), PHYSFS_ERR_INVALID_ARGUMENT, 0);
 
-    buffered = fh->buffill - fh->bufpos;
-    if (buffered >= len)  /* totally in the buffer, just copy and return! */
+    for (i = 0; i < count; i++)
     {
-        memcpy(buffer, fh->buffer + fh->bufpos, (size_t) len);
-        fh->bufpos += (PHYSFS_uint32) len;
-        return (PHYSFS_sint64) len;
-    } /* if */
+        BAIL_IF_MACRO(!paths[i], PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        BAIL_IF_MACRO(!pinFile(ctx, paths[i]), ERRPASS, 0);
+    } /* for */
 
-    else if (buffered > 0) /* partially in the buffer... */
-    {
-        memcpy(buffer, fh->buffer + fh->bufpos, (size_t) buffered);
-        buffer = ((PHYSFS_uint8 *) buffer) + buffered;
-        len -= buffered;
-        retval = buffered;
-    } /* if */
+    return 1;
+} /* PHYSFS_pin */
 
-    /* if you got here, the buffer is drained and we still need bytes. */
-    assert(len > 0);
 
-    fh->buffill = fh->bufpos = 0;
+void PHYSFS_unpin(const char **paths, PHYSFS_uint32 count)
+{
+    PHYSFS_Context *ctx;
+    PinnedFile *unpinned = NULL;
+    PHYSFS_uint32 j;
 
-    io = fh->io;
-    if (len >= fh->bufsize)  /* need more than the buffer takes. */
+    if ((!initialized) || (!paths))
+        return;
+
+    ctx = currentContext();
+    for (j = 0; j < count; j++)
     {
-        /* leave buffer empty, go right to output instead. */
-        rc = io->read(io, buffer, len);
-        if (rc < 0)
-            return ((retval == 0) ? rc : retval);
-        return retval + rc;
-    } /* if */
+        char *fname;
+        DirHandle *i;
 
-    /* need less than buffer can take. Fill buffer. */
-    rc = io->read(io, fh->buffer, fh->bufsize);
-    if (rc < 0)
-        return ((retval == 0) ? rc : retval);
+        if (paths[j] == NULL)
+            continue;
 
-    assert(fh->bufpos == 0);
-    fh->buffill = (PHYSFS_uint32) rc;
-    rc = doBufferedRead(fh, buffer, len);  /* go from the start, again. */
-    if (rc < 0)
-        return ((retval == 0) ? rc : retval);
+        fname = (char *) __PHYSFS_smallAlloc(strlen(paths[j]) + 1);
+        if (fname == NULL)
+            continue;
 
-    return retval + rc;
-} /* doBufferedRead */
+        if (sanitizePlatformIndependentPath(paths[j], fname))
+        {
+            grabLock(ctx->lock);
+            __PHYSFS_platformGrabMutex(pinLock);
+            for (i = ctx->searchPath; i != NULL; i = i->next)
+            {
+                PinnedFile **prev = (PinnedFile **) &i->pins;
+                while (*prev != NULL)
+                {
+                    PinnedFile *pin = *prev;
+                    if (strcmp(pin->path, fname) != 0)
+                        prev = &pin->next;
+                    else
+                    {
+                        *prev = pin->next;
+                        pin->next = unpinned;
+                        unpinned = pin;
+                    } /* else */
+                } /* while */
+            } /* for */
+            __PHYSFS_platformReleaseMutex(pinLock);
+            __PHYSFS_platformReleaseMutex(ctx->lock);
+        } /* if */
 
+        __PHYSFS_smallFree(fname);
+    } /* for */
 
-PHYSFS_sint64 PHYSFS_read(PHYSFS_File *handle, void *buffer,
-                          PHYSFS_uint32 size, PHYSFS_uint32 count)
+    freePins(unpinned);  /* open files keep reading what they had. */
+} /* PHYSFS_unpin */
+
+
+void PHYSFS_setSectorCacheSize(PHYSFS_uint32 sectors)
 {
-    const PHYSFS_uint64 len = ((PHYSFS_uint64) size) * ((PHYSFS_uint64) count);
-    const PHYSFS_sint64 retval = PHYSFS_readBytes(handle, buffer, len);
-    return ( (retval <= 0) ? retval : (retval / ((PHYSFS_sint64) size)) );
-} /* PHYSFS_read */
+    sectorCacheSize = sectors;
+} /* PHYSFS_setSectorCacheSize */
+
+
+PHYSFS_uint32 __PHYSFS_getSectorCacheSize(void)
+{
+    return sectorCacheSize;
+} /* __PHYSFS_getSectorCacheSize */
+
+
+void PHYSFS_setResolveOnMount(int enabled)
+{
+    resolveOnMount = enabled;
+} /* PHYSFS_setResolveOnMount */
+
+
+int __PHYSFS_getResolveOnMount(void)
+{
+    return resolveOnMount;
+} /* __PHYSFS_getResolveOnMount */
+
+
+void PHYSFS_setFastDeinit(int enabled)
+{
+    fastDeinit = enabled;
+} /* PHYSFS_setFastDeinit */
+
+
+int __PHYSFS_isFastDeinit(void)
+{
+    return deinitingFast;
+} /* __PHYSFS_isFastDeinit */
 
 
-PHYSFS_sint64 PHYSFS_readBytes(PHYSFS_File *handle, void *buffer,
-                               PHYSFS_uint64 len)
+void PHYSFS_setNestedInflate(PHYSFS_uint64 maxBytes)
 {
-    FileHandle *fh = (FileHandle *) handle;
+    nestedInflateLimit = maxBytes;
+} /* PHYSFS_setNestedInflate */
 
-#ifdef PHYSFS_NO_64BIT_SUPPORT
-    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
-#else
-    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
-#endif
 
-    if (!__PHYSFS_ui64FitsAddressSpace(len))
-        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+void PHYSFS_setSlurpOnOpen(PHYSFS_uint64 maxBytes)
+{
+    slurpLimit = maxBytes;
+} /* PHYSFS_setSlurpOnOpen */
 
-    BAIL_IF_MACRO(len > maxlen, PHYSFS_ERR_INVALID_ARGUMENT, -1);
-    BAIL_IF_MACRO(!fh->forReading, PHYSFS_ERR_OPEN_FOR_WRITING, -1);
-    BAIL_IF_MACRO(len == 0, ERRPASS, 0);
-    if (fh->buffer)
-        return doBufferedRead(fh, buffer, len);
 
-    return fh->io->read(fh->io, buffer, len);
-} /* PHYSFS_readBytes */
+void PHYSFS_setMountLimits(PHYSFS_uint32 maxEntries,
+                           PHYSFS_uint32 maxPathDepth,
+                           PHYSFS_uint32 maxSymlinkHops,
+                           PHYSFS_uint64 maxIndexBytes)
+{
+    mountMaxEntries = maxEntries;
+    mountMaxPathDepth = maxPathDepth;
+    mountMaxSymlinkHops = (maxSymlinkHops == 0) ? 64 : maxSymlinkHops;
+    mountMaxIndexBytes = maxIndexBytes;
+} /* PHYSFS_setMountLimits */
 
 
-static PHYSFS_sint64 doBufferedWrite(PHYSFS_File *handle, const void *buffer,
-                                     PHYSFS_uint64 len)
+void __PHYSFS_getMountLimits(PHYSFS_uint32 *maxEntries,
+                             PHYSFS_uint32 *maxPathDepth,
+                             PHYSFS_uint32 *maxSymlinkHops,
+                             PHYSFS_uint64 *maxIndexBytes)
 {
-    FileHandle *fh = (FileHandle *) handle;
+    *maxEntries = mountMaxEntries;
+    *maxPathDepth = mountMaxPathDepth;
+    *maxSymlinkHops = mountMaxSymlinkHops;
+    *maxIndexBytes = mountMaxIndexBytes;
+} /* __PHYSFS_getMountLimits */
 
-    /* whole thing fits in the buffer? */
-    if ( (((PHYSFS_uint64) fh->buffill) + len) < fh->bufsize )
-    {
-        memcpy(fh->buffer + fh->buffill, buffer, (size_t) len);
-        fh->buffill += (PHYSFS_uint32) len;
-        return (PHYSFS_sint64) len;
-    } /* if */
 
-    /* would overflow buffer. Flush and then write the new objects, too. */
-    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, -1);
-    return fh->io->write(fh->io, buffer, len);
-} /* doBufferedWrite */
+PHYSFS_Io *PHYSFS_createCachedIo(PHYSFS_Io *io, PHYSFS_uint32 blockSize,
+                                 PHYSFS_uint32 capacity)
+{
+    BAIL_IF_MACRO(!io, PHYSFS_ERR_INVALID_ARGUMENT, NULL);
+    BAIL_IF_MACRO(io->version > CURRENT_PHYSFS_IO_API_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, NULL);
+    if (blockSize == 0)
+        blockSize = 64 * 1024;
+    if (capacity == 0)
+        capacity = 64;
+    return __PHYSFS_createCachedIo(io, blockSize, capacity);
+} /* PHYSFS_createCachedIo */
+
+
+void PHYSFS_setMountBlockCache(PHYSFS_uint32 blockSize, PHYSFS_uint32 capacity)
+{
+    mountCacheBlockSize = (blockSize == 0) ? (64 * 1024) : blockSize;
+    mountCacheBlocks = capacity;
+} /* PHYSFS_setMountBlockCache */
 
 
-PHYSFS_sint64 PHYSFS_write(PHYSFS_File *handle, const void *buffer,
-                           PHYSFS_uint32 size, PHYSFS_uint32 count)
+void PHYSFS_setVerifyChecksums(int enabled)
 {
-    const PHYSFS_uint64 len = ((PHYSFS_uint64) size) * ((PHYSFS_uint64) count);
-    const PHYSFS_sint64 retval = PHYSFS_writeBytes(handle, buffer, len);
-    return ( (retval <= 0) ? retval : (retval / ((PHYSFS_sint64) size)) );
-} /* PHYSFS_write */
+    verifyChecksums = enabled;
+} /* PHYSFS_setVerifyChecksums */
 
 
-PHYSFS_sint64 PHYSFS_writeBytes(PHYSFS_File *handle, const void *buffer,
-                                PHYSFS_uint64 len)
+int __PHYSFS_getVerifyChecksums(void)
 {
-    FileHandle *fh = (FileHandle *) handle;
+    return verifyChecksums;
+} /* __PHYSFS_getVerifyChecksums */
 
-#ifdef PHYSFS_NO_64BIT_SUPPORT
-    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
-#else
-    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
-#endif
 
-    if (!__PHYSFS_ui64FitsAddressSpace(len))
-        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+void PHYSFS_setWriteCompression(int enabled)
+{
+    writeCompression = enabled;
+} /* PHYSFS_setWriteCompression */
 
-    BAIL_IF_MACRO(len > maxlen, PHYSFS_ERR_INVALID_ARGUMENT, -1);
-    BAIL_IF_MACRO(fh->forReading, PHYSFS_ERR_OPEN_FOR_READING, -1);
-    BAIL_IF_MACRO(len == 0, ERRPASS, 0);
-    if (fh->buffer)
-        return doBufferedWrite(handle, buffer, len);
 
-    return fh->io->write(fh->io, buffer, len);
-} /* PHYSFS_write */
+int __PHYSFS_getWriteCompression(void)
+{
+    return writeCompression;
+} /* __PHYSFS_getWriteCompression */
 
 
-int PHYSFS_eof(PHYSFS_File *handle)
+int PHYSFS_buildSeekIndex(const char *archive)
 {
-    FileHandle *fh = (FileHandle *) handle;
+    PHYSFS_uint32 interval = seekIndexInterval;
 
-    if (!fh->forReading)  /* never EOF on files opened for write/append. */
-        return 0;
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!archive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
 
-    /* can't be eof if buffer isn't empty */
-    if (fh->bufpos == fh->buffill)
-    {
-        /* check the Io. */
-        PHYSFS_Io *io = fh->io;
-        const PHYSFS_sint64 pos = io->tell(io);
-        const PHYSFS_sint64 len = io->length(io);
-        if ((pos < 0) || (len < 0))
-            return 0;  /* beats me. */
-        return (pos >= len);
-    } /* if */
+    if (interval == 0)
+        interval = 1024 * 1024;
 
-    return 0;
-} /* PHYSFS_eof */
+#if PHYSFS_SUPPORTS_ZIP
+    return __PHYSFS_zipBuildSeekIndex(archive, interval);
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* PHYSFS_buildSeekIndex */
 
 
-PHYSFS_sint64 PHYSFS_tell(PHYSFS_File *handle)
+/* Non-zero if (dir), in platform-dependent notation, is any write dir. */
+static int isAnyWriteDir(const char *dir)
 {
-    FileHandle *fh = (FileHandle *) handle;
-    const PHYSFS_sint64 pos = fh->io->tell(fh->io);
-    const PHYSFS_sint64 retval = fh->forReading ?
-                                 (pos - fh->buffill) + fh->bufpos :
-                                 (pos + fh->buffill);
+    PHYSFS_Context *ctx;
+    int retval = 0;
+
+    __PHYSFS_platformGrabMutex(contextLock);
+    for (ctx = &defaultContext; (ctx != NULL) && (!retval); ctx = ctx->next)
+    {
+        grabLock(ctx->lock);
+        if (ctx->writeDir != NULL)
+            retval = (strcmp(ctx->writeDir->dirName, dir) == 0);
+        __PHYSFS_platformReleaseMutex(ctx->lock);
+    } /* for */
+    __PHYSFS_platformReleaseMutex(contextLock);
+
     return retval;
-} /* PHYSFS_tell */
+} /* isAnyWriteDir */
 
 
-int PHYSFS_seek(PHYSFS_File *handle, PHYSFS_uint64 pos)
+int PHYSFS_compactArchive(const char *archive)
 {
-    FileHandle *fh = (FileHandle *) handle;
-    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, 0);
+    BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(!archive, PHYSFS_ERR_INVALID_ARGUMENT, 0);
 
-    if (fh->buffer && fh->forReading)
-    {
-        /* avoid throwing away our precious buffer if seeking within it. */
-        PHYSFS_sint64 offset = pos - PHYSFS_tell(handle);
-        if ( /* seeking within the already-buffered range? */
-            ((offset >= 0) && (offset <= fh->buffill - fh->bufpos)) /* fwd */
-            || ((offset < 0) && (-offset <= fh->bufpos)) /* backward */ )
-        {
-            fh->bufpos += (PHYSFS_uint32) offset;
-            return 1; /* successful seek */
-        } /* if */
-    } /* if */
+    /* its writer would go on appending to the file we replaced. */
+    BAIL_IF_MACRO(isAnyWriteDir(archive), PHYSFS_ERR_FILES_STILL_OPEN, 0);
 
-    /* we have to fall back to a 'raw' seek. */
-    fh->buffill = fh->bufpos = 0;
-    return fh->io->seek(fh->io, pos);
-} /* PHYSFS_seek */
+#if PHYSFS_SUPPORTS_ZIP
+    return __PHYSFS_zipCompact(archive);
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* PHYSFS_compactArchive */
 
 
-PHYSFS_sint64 PHYSFS_fileLength(PHYSFS_File *handle)
+PHYSFS_uint32 __PHYSFS_getSeekIndexInterval(void)
 {
-    PHYSFS_Io *io = ((FileHandle *) handle)->io;
-    return io->length(io);
-} /* PHYSFS_filelength */
+    return seekIndexInterval;
+} /* __PHYSFS_getSeekIndexInterval */
 
 
-int PHYSFS_setBuffer(PHYSFS_File *handle, PHYSFS_uint64 _bufsize)
+int __PHYSFS_ioMap(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len)
 {
-    FileHandle *fh = (FileHandle *) handle;
-    PHYSFS_uint32 bufsize;
-
-    /* !!! FIXME: actually, why use 32 bits here? */
-    /*BAIL_IF_MACRO(_bufsize > 0xFFFFFFFF, "buffer must fit in 32-bits", 0);*/
-    BAIL_IF_MACRO(_bufsize > 0xFFFFFFFF, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    bufsize = (PHYSFS_uint32) _bufsize;
-
-    BAIL_IF_MACRO(!PHYSFS_flush(handle), ERRPASS, 0);
+    /* version 0 structs don't even have the map field; don't touch it! */
+    BAIL_IF_MACRO(io->version < 1, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(io->map == NULL, PHYSFS_ERR_UNSUPPORTED, 0);
+    return io->map(io, ptr, len);
+} /* __PHYSFS_ioMap */
 
-    /*
-     * For reads, we need to move the file pointer to where it would be
-     *  if we weren't buffering, so that the next read will get the
-     *  right chunk of stuff from the file. PHYSFS_flush() handles writes.
-     */
-    if ((fh->forReading) && (fh->buffill != fh->bufpos))
-    {
-        PHYSFS_uint64 pos;
-        const PHYSFS_sint64 curpos = fh->io->tell(fh->io);
-        BAIL_IF_MACRO(curpos == -1, ERRPASS, 0);
-        pos = ((curpos - fh->buffill) + fh->bufpos);
-        BAIL_IF_MACRO(!fh->io->seek(fh->io, pos), ERRPASS, 0);
-    } /* if */
 
-    if (bufsize == 0)  /* delete existing buffer. */
-    {
-        if (fh->buffer)
-        {
-            allocator.Free(fh->buffer);
-            fh->buffer = NULL;
-        } /* if */
-    } /* if */
+PHYSFS_sint64 __PHYSFS_ioReadAt(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len,
+                                PHYSFS_uint64 pos)
+{
+    PHYSFS_sint64 origpos;
+    PHYSFS_sint64 retval;
 
-    else
-    {
-        PHYSFS_uint8 *newbuf;
-        newbuf = (PHYSFS_uint8 *) allocator.Realloc(fh->buffer, bufsize);
-        BAIL_IF_MACRO(!newbuf, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-        fh->buffer = newbuf;
-    } /* else */
+    if ((io->version >= 1) && (io->readAt != NULL))
+        return io->readAt(io, buf, len, pos);
 
-    fh->bufsize = bufsize;
-    fh->buffill = fh->bufpos = 0;
-    return 1;
-} /* PHYSFS_setBuffer */
+    /* no native support; do it the slow way, and serialize callers. */
+    grabStateLock();
 
+    origpos = io->tell(io);
+    BAIL_IF_MACRO_MUTEX(origpos == -1, ERRPASS, stateLock, -1);
 
-int PHYSFS_flush(PHYSFS_File *handle)
-{
-    FileHandle *fh = (FileHandle *) handle;
-    PHYSFS_Io *io;
-    PHYSFS_sint64 rc;
+    /* seeking past EOF is an error, but reading there is just empty. */
+    if (pos >= (PHYSFS_uint64) io->length(io))
+        BAIL_MACRO_MUTEX(ERRPASS, stateLock, 0);
 
-    if ((fh->forReading) || (fh->bufpos == fh->buffill))
-        return 1;  /* open for read or buffer empty are successful no-ops. */
+    BAIL_IF_MACRO_MUTEX(!io->seek(io, pos), ERRPASS, stateLock, -1);
+    retval = io->read(io, buf, len);
+    if (!io->seek(io, (PHYSFS_uint64) origpos))
+        retval = -1;
 
-    /* dump buffer to disk. */
-    io = fh->io;
-    rc = io->write(io, fh->buffer + fh->bufpos, fh->buffill - fh->bufpos);
-    BAIL_IF_MACRO(rc <= 0, ERRPASS, 0);
-    fh->bufpos = fh->buffill = 0;
-    return io->flush ? io->flush(io) : 1;
-} /* PHYSFS_flush */
+    __PHYSFS_platformReleaseMutex(stateLock);
+    return retval;
+} /* __PHYSFS_ioReadAt */
 
 
-int PHYSFS_stat(const char *_fname, PHYSFS_Stat *stat)
+PHYSFS_sint64 __PHYSFS_ioReadv(PHYSFS_Io *io, const PHYSFS_IoVec *iov,
+                               PHYSFS_uint32 count)
 {
-    int retval = 0;
-    char *fname;
-    size_t len;
-
-    BAIL_IF_MACRO(!_fname, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(!stat, PHYSFS_ERR_INVALID_ARGUMENT, 0);
-    len = strlen(_fname) + 1;
-    fname = (char *) __PHYSFS_smallAlloc(len);
-    BAIL_IF_MACRO(!fname, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_uint32 i;
 
-    /* set some sane defaults... */
-    stat->filesize = -1;
-    stat->modtime = -1;
-    stat->createtime = -1;
-    stat->accesstime = -1;
-    stat->filetype = PHYSFS_FILETYPE_OTHER;
-    stat->readonly = 1;  /* !!! FIXME */
+    if ((io->version >= 2) && (io->readv != NULL))
+        return io->readv(io, iov, count);
 
-    if (sanitizePlatformIndependentPath(_fname, fname))
+    for (i = 0; i < count; i++)
     {
-        if (*fname == '\0')
-        {
-            stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
-            stat->readonly = !writeDir; /* Writeable if we have a writeDir */
-            retval = 1;
-        } /* if */
-        else
-        {
-            DirHandle *i;
-            int exists = 0;
-            __PHYSFS_platformGrabMutex(stateLock);
-            for (i = searchPath; ((i != NULL) && (!exists)); i = i->next)
-            {
-                char *arcfname = fname;
-                exists = partOfMountPoint(i, arcfname);
-                if (exists)
-                {
-                    stat->filetype = PHYSFS_FILETYPE_DIRECTORY;
-                    stat->readonly = 1;  /* !!! FIXME */
-                    retval = 1;
-                } /* if */
-                else if (verifyPath(i, &arcfname, 0))
-                {
-                    /* !!! FIXME: this test is wrong and should be elsewhere. */
-                    stat->readonly = !(writeDir &&
-                                 (strcmp(writeDir->dirName, i->dirName) == 0));
-                    retval = i->funcs->stat(i->opaque, arcfname, stat);
-                    if ((retval) || (currentErrorCode() != PHYSFS_ERR_NOT_FOUND))
-                        exists = 1;
-                } /* else if */
-            } /* for */
-            __PHYSFS_platformReleaseMutex(stateLock);
-        } /* else */
-    } /* if */
+        const PHYSFS_sint64 rc = io->read(io, iov[i].buf, iov[i].len);
+        if (rc < 0)
+            return (retval == 0) ? -1 : retval;
+        retval += rc;
+        if (((PHYSFS_uint64) rc) < iov[i].len)
+            break;  /* EOF. */
+    } /* for */
 
-    __PHYSFS_smallFree(fname);
     return retval;
-} /* PHYSFS_stat */
+} /* __PHYSFS_ioReadv */
 
 
-int __PHYSFS_readAll(PHYSFS_Io *io, void *buf, const PHYSFS_uint64 len)
+int __PHYSFS_ioAdvise(PHYSFS_Io *io, PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                      int hint)
 {
-    return (io->read(io, buf, len) == len);
-} /* __PHYSFS_readAll */
+    /* older structs don't even have the advise field; don't touch it! */
+    BAIL_IF_MACRO(io->version < 3, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(io->advise == NULL, PHYSFS_ERR_UNSUPPORTED, 0);
+    return io->advise(io, offset, len, hint);
+} /* __PHYSFS_ioAdvise */
+
+
+int __PHYSFS_ioBacking(PHYSFS_Io *io, PHYSFS_FileBacking *backing)
+{
+    /* older structs don't even have the backing field; don't touch it! */
+    BAIL_IF_MACRO(io->version < 4, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(io->backing == NULL, PHYSFS_ERR_UNSUPPORTED, 0);
+    return io->backing(io, backing);
+} /* __PHYSFS_ioBacking */
+
+
+PHYSFS_Io *__PHYSFS_ioRaw(PHYSFS_Io *io, int *encoding)
+{
+    /* older structs don't even have the raw field; don't touch it! */
+    BAIL_IF_MACRO(io->version < 5, PHYSFS_ERR_UNSUPPORTED, NULL);
+    BAIL_IF_MACRO(io->raw == NULL, PHYSFS_ERR_UNSUPPORTED, NULL);
+    return io->raw(io, encoding);
+} /* __PHYSFS_ioRaw */
 
 
 void *__PHYSFS_initSmallAlloc(void *ptr, PHYSFS_uint64 len)
@@ -2928,6 +17796,44 @@ void __PHYSFS_smallFree(void *ptr)
 } /* __PHYSFS_smallFree */
 
 
+int PHYSFS_enableIoUring(int enable)
+{
+    BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
+    wantBatchIo = (enable != 0);
+    return 1;
+} /* PHYSFS_enableIoUring */
+
+
+int PHYSFS_setInflater(const PHYSFS_Inflater *i)
+{
+    BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
+    if (i != NULL)
+    {
+        BAIL_IF_MACRO(i->version > CURRENT_PHYSFS_INFLATER_API_VERSION,
+                      PHYSFS_ERR_UNSUPPORTED, 0);
+        BAIL_IF_MACRO(i->Inflate == NULL, PHYSFS_ERR_INVALID_ARGUMENT, 0);
+        memcpy(&inflater, i, sizeof (PHYSFS_Inflater));
+    } /* if */
+
+    wantInflater = (i != NULL);
+    return 1;
+} /* PHYSFS_setInflater */
+
+
+int __PHYSFS_offloadInflate(const void *src, const PHYSFS_uint64 srclen,
+                            void *dst, const PHYSFS_uint64 dstlen)
+{
+    /* (inflater) doesn't change between PHYSFS_init() and deinit. */
+    if ((!inflaterReady) || (dstlen < inflater.minSize))
+        return 0;
+    else if (!inflater.Inflate(inflater.opaque, src, srclen, dst, dstlen))
+        return 0;
+
+    __PHYSFS_STAT_INCR(inflatesOffloaded);
+    return 1;
+} /* __PHYSFS_offloadInflate */
+
+
 int PHYSFS_setAllocator(const PHYSFS_Allocator *a)
 {
     BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
@@ -2935,10 +17841,95 @@ int PHYSFS_setAllocator(const PHYSFS_Allocator *a)
     if (externalAllocator)
         memcpy(&allocator, a, sizeof (PHYSFS_Allocator));
 
+    allocatorAlignedMalloc = NULL;
+    allocatorFreeSized = NULL;
     return 1;
 } /* PHYSFS_setAllocator */
 
 
+int PHYSFS_setAllocatorEx(const PHYSFS_AllocatorEx *a)
+{
+    BAIL_IF_MACRO(initialized, PHYSFS_ERR_IS_INITIALIZED, 0);
+    if (a == NULL)
+        return PHYSFS_setAllocator(NULL);
+
+    BAIL_IF_MACRO(a->version > CURRENT_PHYSFS_ALLOCATOR_API_VERSION,
+                  PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!a->base.Malloc || !a->base.Realloc || !a->base.Free,
+                  PHYSFS_ERR_INVALID_ARGUMENT, 0);
+
+    PHYSFS_setAllocator(&a->base);
+    allocatorAlignedMalloc = a->AlignedMalloc;
+    allocatorFreeSized = a->FreeSized;
+    return 1;
+} /* PHYSFS_setAllocatorEx */
+
+
+/*
+ * Without the app's AlignedMalloc, we over-allocate by (align) plus a
+ *  pointer, and keep the block's real address just before the aligned one.
+ */
+static size_t alignedMallocAlign(size_t align)
+{
+    assert((align != 0) && ((align & (align - 1)) == 0));
+    return (align < sizeof (void *)) ? sizeof (void *) : align;
+} /* alignedMallocAlign */
+
+
+void *__PHYSFS_alignedMalloc(size_t len, size_t align)
+{
+    PHYSFS_uint8 *raw;
+    size_t aligned;
+    size_t pad;
+
+    align = alignedMallocAlign(align);
+    if (allocatorAlignedMalloc != NULL)
+    {
+        return allocatorAlignedMalloc((PHYSFS_uint64) len,
+                                      (PHYSFS_uint64) align);
+    } /* if */
+
+    pad = align + sizeof (void *);
+    if (len > ((size_t) -1) - pad)
+        return NULL;
+
+    raw = (PHYSFS_uint8 *) allocator.Malloc(len + pad);
+    if (raw == NULL)
+        return NULL;
+
+    aligned = (((size_t) raw) + sizeof (void *) + (align - 1)) & ~(align - 1);
+    memcpy(((PHYSFS_uint8 *) aligned) - sizeof (void *), &raw, sizeof (raw));
+    return (void *) aligned;
+} /* __PHYSFS_alignedMalloc */
+
+
+void __PHYSFS_alignedFree(void *ptr, size_t len, size_t align)
+{
+    align = alignedMallocAlign(align);
+    if (ptr == NULL)
+        return;
+    else if (allocatorAlignedMalloc != NULL)
+        __PHYSFS_sizedFree(ptr, len);
+    else
+    {
+        void *raw;
+        memcpy(&raw, ((PHYSFS_uint8 *) ptr) - sizeof (void *), sizeof (raw));
+        __PHYSFS_sizedFree(raw, len + align + sizeof (void *));
+    } /* else */
+} /* __PHYSFS_alignedFree */
+
+
+void __PHYSFS_sizedFree(void *ptr, size_t len)
+{
+    if (ptr == NULL)
+        return;
+    else if (allocatorFreeSized != NULL)
+        allocatorFreeSized(ptr, (PHYSFS_uint64) len);
+    else
+        allocator.Free(ptr);
+} /* __PHYSFS_sizedFree */
+
+
 const PHYSFS_Allocator *PHYSFS_getAllocator(void)
 {
     BAIL_IF_MACRO(!initialized, PHYSFS_ERR_NOT_INITIALIZED, NULL);
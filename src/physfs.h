@@ -124,7 +124,10 @@
  *
  * PhysicsFS is mostly thread safe. The error messages returned by
  *  PHYSFS_getLastError() are unique by thread, and library-state-setting
- *  functions are mutex'd. For efficiency, individual file accesses are 
+ *  functions are mutex'd. Lookups in the search path (PHYSFS_openRead(),
+ *  PHYSFS_stat(), PHYSFS_exists(), PHYSFS_enumerateFiles(), etc) don't hold
+ *  that mutex, so many threads can open files at once without waiting on
+ *  each other. For efficiency, individual file accesses are 
  *  not locked, so you can not safely read/write/seek/close/etc the same 
  *  file from two threads at the same time. Other race conditions are bugs 
  *  that should be reported/patched.
@@ -743,7 +746,11 @@ PHYSFS_DECL void PHYSFS_permitSymbolicLinks(int allow);
  * PHYSFS_freeList(cds);
  * \endcode
  *
- * This call may block while drives spin up. Be forewarned.
+ * This call may block while drives spin up. Be forewarned. Once PhysicsFS
+ *  is initialized, what it finds is kept until the system says the mounts
+ *  changed (or, where it can't say, the next call), so asking again is
+ *  cheap on systems that can. Call PHYSFS_startCdRomDetection() early to
+ *  have the looking done on another thread while you do other things.
  *
  * When you are done with the returned information, you may dispose of the
  *  resources by calling PHYSFS_freeList() with the returned pointer.
@@ -1477,10 +1484,14 @@ PHYSFS_DECL int PHYSFS_setBuffer(PHYSFS_File *handle, PHYSFS_uint64 bufsize);
  * For buffered files opened for reading or unbuffered files, this is a safe
  *  no-op, and will report success.
  *
+ * For files with PHYSFS_setWriteBehind(), this waits for the background
+ *  write first, and fails if that, or any before it, failed.
+ *
  *   \param handle handle returned from PHYSFS_open*().
  *  \return nonzero if successful, zero on error.
  *
  * \sa PHYSFS_setBuffer
+ * \sa PHYSFS_setWriteBehind
  * \sa PHYSFS_close
  */
 PHYSFS_DECL int PHYSFS_flush(PHYSFS_File *handle);
@@ -2152,6 +2163,89 @@ typedef struct PHYSFS_Allocator
  */
 PHYSFS_DECL int PHYSFS_setAllocator(const PHYSFS_Allocator *allocator);
 
+
+/**
+ * \struct PHYSFS_AllocatorEx
+ * \brief PHYSFS_Allocator, plus aligned and sized allocation.
+ *
+ * (This is for limited, hardcore use. If you don't immediately see a need
+ *  for it, you can probably ignore this forever.)
+ *
+ * You create one of these structures for use with PHYSFS_setAllocatorEx.
+ *  PhysicsFS wants aligned memory for file buffers and decompression caches,
+ *  so they suit direct i/o and SIMD code, and it always knows how big those
+ *  are when it frees them. Allocators that can make use of either can say
+ *  so here; ones that can't should stick with PHYSFS_setAllocator(), and
+ *  PhysicsFS pads out blocks from Malloc() to align them itself.
+ *
+ * \sa PHYSFS_setAllocatorEx
+ */
+typedef struct PHYSFS_AllocatorEx
+{
+    /**
+     * \brief Binary compatibility information.
+     *
+     * This must be set to zero at this time. Future versions of this struct
+     *  will increment this field, so we know what a given implementation
+     *  supports.
+     */
+    PHYSFS_uint32 version;
+
+    /**
+     * \brief The usual entry points.
+     *
+     * These work exactly as they do in PHYSFS_setAllocator(), and
+     *  PHYSFS_getAllocator() returns a copy of them. Malloc, Realloc and
+     *  Free can't be NULL.
+     */
+    PHYSFS_Allocator base;
+
+    /**
+     * \brief Allocate memory aligned to a power of two.
+     *
+     * Return (len) bytes whose address is a multiple of (alignment), or NULL
+     *  on failure. (alignment) is a power of two no smaller than
+     *  sizeof (void *). Memory from here is freed through FreeSized() if
+     *  it isn't NULL, or base.Free() otherwise, so C11's aligned_alloc()
+     *  and POSIX's posix_memalign() fit, but Windows' _aligned_malloc()
+     *  doesn't. This can be NULL, and PhysicsFS will pad blocks from
+     *  base.Malloc() instead.
+     */
+    void *(*AlignedMalloc)(PHYSFS_uint64 len, PHYSFS_uint64 alignment);
+
+    /**
+     * \brief Free memory, being told how big it is.
+     *
+     * Like base.Free(), but (len) is what was asked of base.Malloc() or
+     *  AlignedMalloc() for (ptr), if PhysicsFS knows it. Blocks it doesn't
+     *  know the size of, like anything from base.Realloc(), still go to
+     *  base.Free(). This can be NULL, and everything goes to base.Free().
+     */
+    void (*FreeSized)(void *ptr, PHYSFS_uint64 len);
+} PHYSFS_AllocatorEx;
+
+
+/**
+ * \fn int PHYSFS_setAllocatorEx(const PHYSFS_AllocatorEx *allocator)
+ * \brief Hook your own allocation routines, aligned and sized ones too.
+ *
+ * (This is for limited, hardcore use. If you don't immediately see a need
+ *  for it, you can probably ignore this forever.)
+ *
+ * This is PHYSFS_setAllocator(), for a PHYSFS_AllocatorEx, and has all the
+ *  same rules: it only works before PHYSFS_init() or after PHYSFS_deinit(),
+ *  and NULL goes back to the platform's default allocator. Calling either
+ *  one replaces whatever either of them set before.
+ *
+ *    \param allocator Structure containing your allocator's entry points.
+ *   \return zero on failure, non-zero on success. This call fails when used
+ *           between PHYSFS_init() and PHYSFS_deinit() calls, or if
+ *           (allocator)'s version isn't one this PhysicsFS understands.
+ *
+ * \sa PHYSFS_setAllocator
+ */
+PHYSFS_DECL int PHYSFS_setAllocatorEx(const PHYSFS_AllocatorEx *allocator);
+
 #endif  /* SWIG */
 
 
@@ -2181,6 +2275,15 @@ PHYSFS_DECL int PHYSFS_setAllocator(const PHYSFS_Allocator *allocator);
  *  mountpoints and archive contents can overlap...the interpolation mechanism
  *  still functions as usual.
  *
+ * If (newDir) is a file that ends with an embedded archive trailer (see
+ *  PHYSFS_EMBEDDED_TRAILER_MAGIC), only the archive that the trailer points
+ *  to is mounted, without searching the rest of the file for it.
+ *
+ * An archive that's already mounted by the same path, in any context (see
+ *  PHYSFS_Context), isn't opened and read again: the mounts share it, so
+ *  its directory is only parsed and kept in memory once. If the file's size
+ *  or modification time has changed since, it's opened fresh instead.
+ *
  *   \param newDir directory or archive to add to the path, in
  *                   platform-dependent notation.
  *   \param mountPoint Location in the interpolated tree that this archive
@@ -2195,11 +2298,135 @@ PHYSFS_DECL int PHYSFS_setAllocator(const PHYSFS_Allocator *allocator);
  * \sa PHYSFS_getSearchPath
  * \sa PHYSFS_getMountPoint
  * \sa PHYSFS_mountIo
+ * \sa PHYSFS_EMBEDDED_TRAILER_MAGIC
  */
 PHYSFS_DECL int PHYSFS_mount(const char *newDir,
                              const char *mountPoint,
                              int appendToPath);
 
+
+/**
+ * \def PHYSFS_EMBEDDED_TRAILER_MAGIC
+ * \brief Marks an archive embedded in a larger file, like an executable.
+ *
+ * A packaging tool that appends an archive to a program (or anything else)
+ *  can follow it with a PHYSFS_EMBEDDED_TRAILER_SIZE byte trailer, and the
+ *  file must end with it. The trailer is, in order:
+ *
+ *  - the archive's offset from the start of the file (64-bit littleendian).
+ *  - the archive's length in bytes (64-bit littleendian).
+ *  - the 8 bytes of PHYSFS_EMBEDDED_TRAILER_MAGIC, without a null char.
+ *
+ * PHYSFS_mount() of such a file then opens those bytes as an archive of
+ *  their own, so they must make a complete archive by themselves, with any
+ *  offsets in it relative to its own start (that is, don't run "zip -A" on
+ *  it). Any archive type works, not just the .zip files that otherwise have
+ *  to be used for this, and a big executable doesn't need to be searched
+ *  for where the archive is. A trailer that doesn't fit in the file is
+ *  ignored, and the file is treated as if it had none.
+ *
+ * \sa PHYSFS_mount
+ */
+#define PHYSFS_EMBEDDED_TRAILER_MAGIC "PhysFSv1"
+#define PHYSFS_EMBEDDED_TRAILER_SIZE 24
+
+
+/**
+ * \fn int PHYSFS_mountOverlay(const char *base, const char **patches, PHYSFS_uint32 numPatches, const char *mountPoint, int appendToPath)
+ * \brief Mount an archive with patch archives merged over it.
+ *
+ * Mounting patches ahead of the archive they patch works, but every lookup
+ *  then asks each patch before it gets to the base, and a patch has no way
+ *  to say a file is gone. This mounts (base) and (patches) as one search
+ *  path entry instead: each of them is listed once, now, into one table of
+ *  which of them every path comes from, so lookups are a single probe of
+ *  that table no matter how many patches there are.
+ *
+ * (patches) are applied in order, each one over (base) and the patches
+ *  before it, at the same place in each: a file in a patch replaces the
+ *  same file under it, and directories are merged. A patch deletes NAME
+ *  from everything under it with a file named ".wh.NAME" next to where it
+ *  was (a "whiteout"), or everything in a directory it also has with a
+ *  file named ".wh..wh..opq" in it. Those files aren't listed themselves.
+ *
+ * Names are matched exactly, even in archives that would otherwise ignore
+ *  case. The result is read-only, and can't be the write dir.
+ *
+ * It's all one entry in the search path, named (base): pass (base) to
+ *  PHYSFS_unmount() to remove the lot. To apply another patch, unmount it
+ *  and mount it again with the new patch on the end.
+ *
+ *   \param base archive or directory to patch, in platform-dependent
+ *               notation.
+ *   \param patches (numPatches) archives or directories to merge over
+ *                  (base), in platform-dependent notation, each one over
+ *                  the ones before it.
+ *   \param numPatches number of elements in (patches). Zero is the same as
+ *                     PHYSFS_mount(base, mountPoint, appendToPath).
+ *   \param mountPoint Location in the interpolated tree that this overlay
+ *                     will be "mounted", in platform-independent notation.
+ *                     NULL or "" is equivalent to "/".
+ *   \param appendToPath nonzero to append to search path, zero to prepend.
+ *  \return nonzero if added to path, zero on failure (any of them can't be
+ *          opened, etc). Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mount
+ * \sa PHYSFS_unmount
+ */
+PHYSFS_DECL int PHYSFS_mountOverlay(const char *base, const char **patches,
+                                    PHYSFS_uint32 numPatches,
+                                    const char *mountPoint,
+                                    int appendToPath);
+
+
+/**
+ * \struct PHYSFS_MountSpec
+ * \brief One archive for PHYSFS_mountMany() to mount.
+ *
+ * These are the arguments PHYSFS_mount() would take to mount it.
+ *
+ * \sa PHYSFS_mountMany
+ */
+typedef struct PHYSFS_MountSpec
+{
+    const char *newDir;  /**< directory or archive, platform-dependent. */
+    const char *mountPoint;  /**< where it goes; NULL or "" for "/". */
+    int appendToPath;  /**< nonzero to append, zero to prepend. */
+} PHYSFS_MountSpec;
+
+
+/**
+ * \fn int PHYSFS_mountMany(const PHYSFS_MountSpec *specs, PHYSFS_uint32 count)
+ * \brief Mount several archives at once, opening them in parallel.
+ *
+ * This does what calling PHYSFS_mount() on each of (specs), in order, would
+ *  do, except that the archives are opened, and their directories read, on
+ *  several threads at once, so mounting lots of archives takes about as
+ *  long as the slowest few of them instead of all of them added up. Once
+ *  they're all open, they go into the search path all at once, in the
+ *  order they'd have gone in one by one; nothing looking up files in the
+ *  meantime ever sees just some of them.
+ *
+ * It's all or nothing: if any of them can't be mounted, none of them are,
+ *  and the error is the one the first of those (in (specs) order) got.
+ *  Any of them already in the search path (or named more than once) are
+ *  left where they are, just like PHYSFS_mount() would.
+ *
+ * Systems that can't start threads open them one at a time, but they still
+ *  go into the search path all at once.
+ *
+ *   \param specs (count) archives to mount, in the order to mount them.
+ *   \param count number of elements in (specs).
+ *  \return nonzero if they were all added to the path, zero on failure.
+ *          Specifics of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mount
+ * \sa PHYSFS_MountSpec
+ */
+PHYSFS_DECL int PHYSFS_mountMany(const PHYSFS_MountSpec *specs,
+                                 PHYSFS_uint32 count);
+
 /**
  * \fn int PHYSFS_getMountPoint(const char *dir)
  * \brief Determine a mounted archive's mountpoint.
@@ -2312,7 +2539,8 @@ typedef void (*PHYSFS_EnumFilesCallback)(void *data, const char *origdir,
  * PHYSFS_getCdRomDirsCallback(foundDisc, NULL);
  * \endcode
  *
- * This call may block while drives spin up. Be forewarned.
+ * This call may block while drives spin up. Be forewarned. It uses the same
+ *  cache as PHYSFS_getCdRomDirs().
  *
  *    \param c Callback function to notify about detected drives.
  *    \param d Application-defined data passed to callback. Can be NULL.
@@ -2549,8 +2777,15 @@ PHYSFS_DECL void PHYSFS_utf8FromLatin1(const char *src, char *dst,
  * This must be a (case-sensitive) match to a dir or archive already in the
  *  search path, specified in platform-dependent notation.
  *
- * This call will fail (and fail to remove from the path) if the element still
- *  has files open in it.
+ * The element is removed from the search path right away, even if it still
+ *  has files open in it: new lookups won't find anything in it, but files
+ *  already open keep working, and it's only closed once the last of them
+ *  is. So a pack can be swapped for a new version while it's being read
+ *  from, by unmounting the old one and mounting the new one, without
+ *  waiting for every reader to finish first. The same goes for another
+ *  thread in the middle of a lookup (PHYSFS_openRead(), PHYSFS_stat(), etc)
+ *  when you call this: the archive isn't closed until that lookup is done,
+ *  and if it opened a file, until that file is closed.
  *
  *    \param oldDir dir/archive to remove.
  *   \return nonzero on success, zero on failure.
@@ -2662,6 +2897,127 @@ typedef struct PHYSFS_Stat
 PHYSFS_DECL int PHYSFS_stat(const char *fname, PHYSFS_Stat *stat);
 
 
+/**
+ * \typedef PHYSFS_EnumFilesStatCallback
+ * \brief Function signature for callbacks that enumerate files with metadata.
+ *
+ * This works like PHYSFS_EnumFilesCallback, but each entry also comes with
+ *  what PHYSFS_stat() would have reported for it, straight from the archive
+ *  or directory that supplied it.
+ *
+ *    \param data User-defined data pointer, passed through from the API
+ *                that eventually called the callback.
+ *    \param origdir A string containing the full path, in platform-independent
+ *                   notation, of the directory containing this file.
+ *    \param fname The filename that is being enumerated, without the path.
+ *    \param stat Metadata for $origdir/$fname. This is only valid until the
+ *                callback returns; copy it if you need it longer.
+ *
+ * \sa PHYSFS_enumerateFilesStatCallback
+ */
+typedef void (*PHYSFS_EnumFilesStatCallback)(void *data, const char *origdir,
+                                             const char *fname,
+                                             const PHYSFS_Stat *stat);
+
+
+/**
+ * \fn void PHYSFS_enumerateFilesStatCallback(const char *dir, PHYSFS_EnumFilesStatCallback c, void *d)
+ * \brief Get a file listing of a search path's directory, with metadata.
+ *
+ * This is PHYSFS_enumerateFilesCallback(), except every entry arrives with
+ *  its PHYSFS_Stat, filled in from the same archive metadata (or directory
+ *  listing) the enumeration walks anyhow. Listing a directory and then
+ *  calling PHYSFS_stat() on every name looks up each name across the whole
+ *  search path again; this does it all in one pass.
+ *
+ * Ordering and duplicates are as for PHYSFS_enumerateFilesCallback(): a name
+ *  that exists in several archives is reported once per archive, each time
+ *  with that archive's metadata. The first report is the one that
+ *  PHYSFS_stat() and PHYSFS_openRead() would see. Symlinks are left out
+ *  unless PHYSFS_permitSymbolicLinks() allows them. Entries whose metadata
+ *  can't be read are skipped. Directories that only exist as part of a
+ *  mount point are reported as read-only, with unknown size and times.
+ *
+ *    \param dir Directory, in platform-independent notation, to enumerate.
+ *    \param c Callback function to notify about each entry.
+ *    \param d Application-defined data passed to callback. Can be NULL.
+ *
+ * \sa PHYSFS_EnumFilesStatCallback
+ * \sa PHYSFS_enumerateFilesCallback
+ * \sa PHYSFS_stat
+ */
+PHYSFS_DECL void PHYSFS_enumerateFilesStatCallback(const char *dir,
+                                          PHYSFS_EnumFilesStatCallback c,
+                                          void *d);
+
+
+/**
+ * \enum PHYSFS_WalkTreeFlags
+ * \brief Flags for PHYSFS_walkTree().
+ *
+ * Combine these with bitwise OR; pass zero for the defaults.
+ *
+ * \sa PHYSFS_walkTree
+ */
+typedef enum PHYSFS_WalkTreeFlags
+{
+	PHYSFS_WALK_UNIQUE = (1 << 0), /**< report each path only once */
+	PHYSFS_WALK_TYPES_ONLY = (1 << 1) /**< only filetype is needed */
+} PHYSFS_WalkTreeFlags;
+
+/**
+ * \fn int PHYSFS_walkTree(const char *root, PHYSFS_EnumFilesStatCallback c, void *d, PHYSFS_uint32 flags)
+ * \brief Recursively list everything under a search path directory.
+ *
+ * This reports every file, directory and (if PHYSFS_permitSymbolicLinks()
+ *  allows them) symlink below (root), with its metadata, the same way
+ *  PHYSFS_enumerateFilesStatCallback() would. Symlinks are never followed.
+ *  Calling PHYSFS_enumerateFilesCallback() again for each subdirectory
+ *  walks the whole search path once per directory. This walks each archive
+ *  once, straight through its own directory tree.
+ *
+ * The search path is visited in order, one archive or directory at a time.
+ *  Inside each one, the walk is depth-first: a directory's own entries are
+ *  reported before anything inside its subdirectories. (origdir) is the
+ *  full path of the directory holding (fname), in platform-independent
+ *  notation, without a leading or trailing '/'. It's "" for entries
+ *  directly in the root of the search path.
+ *
+ * By default, a path that exists in several archives is reported once for
+ *  each archive, as PHYSFS_enumerateFilesCallback() does. With
+ *  PHYSFS_WALK_UNIQUE, only the first report of each path is passed on,
+ *  which is the one that PHYSFS_stat() would see. This costs memory for
+ *  every path in all but the last archive of the search path, so don't ask
+ *  for it if you don't need it.
+ *
+ * With PHYSFS_WALK_TYPES_ONLY, you promise to look at nothing but each
+ *  entry's filetype. Native directories can then be walked straight from
+ *  the OS's directory listing where it says what each entry is, instead of
+ *  a stat call per entry; their other PHYSFS_Stat fields may be -1. So may
+ *  the timestamps of .zip entries, which skip converting them. Other
+ *  archives report everything either way, since it costs them nothing.
+ *
+ * Your callback may read files and write to the write dir. Don't change
+ *  the search path from inside it.
+ *
+ *    \param root Directory, in platform-independent notation, to walk.
+ *                Use "" to walk the whole search path.
+ *    \param c Callback function to notify about each entry.
+ *    \param d Application-defined data passed to callback. Can be NULL.
+ *    \param flags Zero or more PHYSFS_WalkTreeFlags, OR'd together.
+ *   \return non-zero on success, zero on failure. If it fails partway
+ *           through (usually because it ran out of memory), some entries
+ *           may have been reported already. Use PHYSFS_getLastErrorCode()
+ *           to find out what went wrong.
+ *
+ * \sa PHYSFS_WalkTreeFlags
+ * \sa PHYSFS_enumerateFilesStatCallback
+ */
+PHYSFS_DECL int PHYSFS_walkTree(const char *root,
+                                PHYSFS_EnumFilesStatCallback c,
+                                void *d, PHYSFS_uint32 flags);
+
+
 #ifndef SWIG  /* not available from scripting languages. */
 
 /**
@@ -2774,6 +3130,40 @@ PHYSFS_DECL PHYSFS_sint64 PHYSFS_writeBytes(PHYSFS_File *handle,
 
 #ifndef SWIG  /* not available from scripting languages. */
 
+/**
+ * \struct PHYSFS_IoVec
+ * \brief One destination buffer for a vectored read.
+ *
+ * \sa PHYSFS_readv
+ * \sa PHYSFS_Io::readv
+ */
+typedef struct PHYSFS_IoVec
+{
+    void *buf;  /**< where to store this piece of the data. */
+    PHYSFS_uint64 len;  /**< bytes to store at (buf). */
+} PHYSFS_IoVec;
+
+
+/**
+ * \struct PHYSFS_FileBacking
+ * \brief Where a file's bytes sit, unchanged, in a real file on disk.
+ *
+ * Exactly one of (fd) and (handle) is set, depending on the platform. The
+ *  file's contents are the (length) bytes starting at byte (offset) of that
+ *  OS file, so they can go straight to sendfile(), TransmitFile(), etc.
+ *
+ * \sa PHYSFS_getFileBacking
+ * \sa PHYSFS_Io::backing
+ */
+typedef struct PHYSFS_FileBacking
+{
+    int fd;  /**< Unix file descriptor, or -1. */
+    void *handle;  /**< Windows HANDLE, or NULL. */
+    PHYSFS_uint64 offset;  /**< where the file starts in (fd) or (handle). */
+    PHYSFS_uint64 length;  /**< the file's length, in bytes. */
+} PHYSFS_FileBacking;
+
+
 /**
  * \struct PHYSFS_Io
  * \brief An abstract i/o interface.
@@ -2816,10 +3206,16 @@ typedef struct PHYSFS_Io
     /**
      * \brief Binary compatibility information.
      *
-     * This must be set to zero at this time. Future versions of this
-     *  struct will increment this field, so we know what a given
-     *  implementation supports. We'll presumably keep supporting older
+     * This must be set to a value from zero to five at this time. Future
+     *  versions of this struct will increment this field, so we know what a
+     *  given implementation supports. We'll presumably keep supporting older
      *  versions as we offer new features, though.
+     *
+     * Version 0 structs end at destroy(). Version 1 adds map() and readAt().
+     *  Version 2 adds readv(), version 3 adds advise(), version 4 adds
+     *  backing(), and version 5 adds raw(). The system won't touch fields
+     *  past the ones your version promises, so older implementations keep
+     *  working unchanged.
      */
     PHYSFS_uint32 version;
 
@@ -2920,7 +3316,10 @@ typedef struct PHYSFS_Io
     /**
      * \brief Duplicate this i/o instance.
      *
-     *  // !!! FIXME: write me.
+     *  The new instance reads the same data as this one, independently of
+     *  it. Where it starts isn't promised, so seek it before use; some
+     *  implementations (ZIP, for one) start it where (io) is now, so that
+     *  seek costs nothing if it's where you wanted to be anyhow.
      *
      *   \param io The i/o instance to duplicate.
      *  \return A new value for a stream's (opaque) field, or NULL on error.
@@ -2960,6 +3359,138 @@ typedef struct PHYSFS_Io
      *   \param s The i/o instance to destroy.
      */
     void (*destroy)(struct PHYSFS_Io *io);
+
+    /**
+     * \brief Get a pointer to the whole dataset, if it's already in memory.
+     *
+     * This field is only used if (version) is 1 or higher.
+     *
+     * If the data behind this i/o instance is contiguous in memory (a
+     *  memory buffer, a memory-mapped file, an uncompressed entry inside
+     *  one of those...), set (*ptr) to the start of it and (*len) to its
+     *  size in bytes. The pointer must stay valid and unchanged until this
+     *  instance is destroyed. The i/o position is not affected.
+     *
+     * This method can be NULL if it isn't implemented. It's also allowed
+     *  to fail at any time, in which case callers will fall back to read().
+     *
+     *   \param io The i/o instance to query.
+     *   \param ptr On success, receives a read-only pointer to the data.
+     *   \param len On success, receives the length of the data, in bytes.
+     *  \return non-zero on success, zero if the data isn't available this way.
+     */
+    int (*map)(struct PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len);
+
+    /**
+     * \brief Read data from a specific offset, leaving the i/o position alone.
+     *
+     * This field is only used if (version) is 1 or higher.
+     *
+     * Read (len) bytes, starting at byte (offset) of the dataset, and store
+     *  them in (buf), like pread() does. The i/o position used by read(),
+     *  seek() and tell() must not change, and it must be safe for several
+     *  threads to call this on the same instance at the same time.
+     *
+     * This method can be NULL if it isn't implemented, in which case the
+     *  system emulates it with seek() and read() and serializes callers.
+     *
+     *   \param io The i/o instance to read from.
+     *   \param buf The buffer to store data into. It must be at least
+     *                 (len) bytes long and can't be NULL.
+     *   \param len The number of bytes to read from the interface.
+     *   \param offset The byte offset to start reading from.
+     *  \return number of bytes read from file, 0 on EOF, -1 if complete
+     *          failure.
+     */
+    PHYSFS_sint64 (*readAt)(struct PHYSFS_Io *io, void *buf, PHYSFS_uint64 len,
+                            PHYSFS_uint64 offset);
+
+    /**
+     * \brief Read data into several buffers at once.
+     *
+     * This field is only used if (version) is 2 or higher.
+     *
+     * Read the next iov[0].len bytes into iov[0].buf, the bytes after
+     *  those into iov[1].buf, and so on for (count) buffers, like readv()
+     *  does, and advance the i/o position past them. As with read(), a
+     *  short read means EOF, and the bytes that were read fill the buffers
+     *  in order.
+     *
+     * This method can be NULL if it isn't implemented, in which case the
+     *  system calls read() once per buffer.
+     *
+     *   \param io The i/o instance to read from.
+     *   \param iov The buffers to fill, in file order.
+     *   \param count The number of elements in (iov).
+     *  \return total number of bytes read, 0 on EOF, -1 if complete failure.
+     */
+    PHYSFS_sint64 (*readv)(struct PHYSFS_Io *io, const PHYSFS_IoVec *iov,
+                           PHYSFS_uint32 count);
+
+    /**
+     * \brief Pass an access hint along to whatever holds the data.
+     *
+     * This field is only used if (version) is 3 or higher.
+     *
+     * (hint) is a PHYSFS_AccessHint for (len) bytes of the dataset starting
+     *  at byte (offset); a (len) of zero means everything from (offset) to
+     *  the end. Pass it to the OS, or to the PHYSFS_Io you read from, with
+     *  the range moved to where the data really is. It must not change
+     *  what reads return or the i/o position.
+     *
+     * This method can be NULL if there's nothing to tell, in which case
+     *  PHYSFS_setAccessHint() reports PHYSFS_ERR_UNSUPPORTED.
+     *
+     *   \param io The i/o instance the hint is for.
+     *   \param offset The first byte the hint covers.
+     *   \param len The number of bytes it covers, or zero for the rest.
+     *   \param hint A PHYSFS_AccessHint value.
+     *  \return non-zero if the hint was passed along, zero on error.
+     */
+    int (*advise)(struct PHYSFS_Io *io, PHYSFS_uint64 offset,
+                  PHYSFS_uint64 len, int hint);
+
+    /**
+     * \brief Find the real file the whole dataset sits in, verbatim.
+     *
+     * This field is only used if (version) is 4 or higher.
+     *
+     * If every byte of the dataset is stored, unchanged and in order, in a
+     *  file the OS can hand to sendfile() and friends (a native file, an
+     *  uncompressed entry inside one, a memory-mapped file...), fill in
+     *  (backing) with the OS handle, where the dataset starts in it and its
+     *  length. The handle must stay open until this instance is destroyed.
+     *  The i/o position is not affected.
+     *
+     * This method can be NULL if it isn't implemented. It's also allowed
+     *  to fail at any time, in which case callers will fall back to read().
+     *
+     *   \param io The i/o instance to query.
+     *   \param backing On success, receives where the data is.
+     *  \return non-zero on success, zero if the data isn't available this way.
+     */
+    int (*backing)(struct PHYSFS_Io *io, PHYSFS_FileBacking *backing);
+
+    /**
+     * \brief Open the dataset's bytes as they're stored, still compressed.
+     *
+     * This field is only used if (version) is 5 or higher.
+     *
+     * If this instance decompresses what it reads, and the compressed form
+     *  is a format someone else could decode (see PHYSFS_Encoding), return
+     *  a new i/o instance that reads the compressed bytes instead, from
+     *  the start, and set (*encoding) to a PHYSFS_Encoding that says what
+     *  they are. This instance is left as it was.
+     *
+     * This method can be NULL if it isn't implemented. It's also allowed
+     *  to fail at any time, in which case callers will read the data
+     *  decompressed.
+     *
+     *   \param io The i/o instance to query.
+     *   \param encoding On success, receives a PHYSFS_Encoding.
+     *  \return a new i/o instance, or NULL if there's no such thing.
+     */
+    struct PHYSFS_Io *(*raw)(struct PHYSFS_Io *io, int *encoding);
 } PHYSFS_Io;
 
 
@@ -2981,8 +3512,9 @@ typedef struct PHYSFS_Io
  *  of them do.
  *
  * (io) must remain until the archive is unmounted. When the archive is
- *  unmounted, the system will call (io)->destroy(io), which will give you
- *  a chance to free your resources.
+ *  unmounted, and any files still open in it are closed, the system will
+ *  call (io)->destroy(io), which will give you a chance to free your
+ *  resources.
  *
  * If this function fails, (io)->destroy(io) is not called.
  *
@@ -3023,10 +3555,10 @@ PHYSFS_DECL int PHYSFS_mountIo(PHYSFS_Io *io, const char *fname,
  *  of them do.
  *
  * (ptr) must remain until the archive is unmounted. When the archive is
- *  unmounted, the system will call (del)(ptr), which will notify you that
- *  the system is done with the buffer, and give you a chance to free your
- *  resources. (del) can be NULL, in which case the system will make no
- *  attempt to free the buffer.
+ *  unmounted, and any files still open in it are closed, the system will
+ *  call (del)(ptr), which will notify you that the system is done with the
+ *  buffer, and give you a chance to free your resources. (del) can be NULL,
+ *  in which case the system will make no attempt to free the buffer.
  *
  * If this function fails, (del) is not called.
  *
@@ -3066,7 +3598,12 @@ PHYSFS_DECL int PHYSFS_mountMemory(const void *buf, PHYSFS_uint64 len,
  *          if mounted this way. Plan accordingly: if you, say, have a
  *          self-extracting .zip file, and want to mount something in it,
  *          compress the contents of the inner archive and make sure the outer
- *          .zip file doesn't compress the inner archive too.
+ *          .zip file doesn't compress the inner archive too. An inner
+ *          archive stored uncompressed in a ZIP, PPK, RAS or unpacked
+ *          archive is read straight out of the outer archive's file, as if
+ *          it were mounted with PHYSFS_mountRange(), instead of through
+ *          (file). PHYSFS_setNestedInflate() lets small compressed ones be
+ *          decompressed into memory once, up front.
  *
  * This function operates just like PHYSFS_mount(), but takes a PHYSFS_File
  *  handle instead of a pathname. This handle contains all the data of the
@@ -3082,9 +3619,11 @@ PHYSFS_DECL int PHYSFS_mountMemory(const void *buf, PHYSFS_uint64 len,
  *  of them do.
  *
  * (file) must remain until the archive is unmounted. When the archive is
- *  unmounted, the system will call PHYSFS_close(file). If you need this
+ *  unmounted, and any files still open in it are closed, the system will
+ *  call PHYSFS_close(file). If you need this
  *  handle to survive, you will have to wrap this in a PHYSFS_Io and use
- *  PHYSFS_mountIo() instead.
+ *  PHYSFS_mountIo() instead. If the archive doesn't need (file) to be read
+ *  (see above), PHYSFS_close(file) is called before this returns.
  *
  * If this function fails, PHYSFS_close(file) is not called.
  *
@@ -3105,6 +3644,80 @@ PHYSFS_DECL int PHYSFS_mountMemory(const void *buf, PHYSFS_uint64 len,
 PHYSFS_DECL int PHYSFS_mountHandle(PHYSFS_File *file, const char *fname,
                                    const char *mountPoint, int appendToPath);
 
+#ifndef SWIG  /* not available from scripting languages. */
+
+/**
+ * \fn PHYSFS_Io *PHYSFS_createSubIo(PHYSFS_Io *io, PHYSFS_uint64 offset, PHYSFS_uint64 len)
+ * \brief Make a PHYSFS_Io for a range of bytes in another one.
+ *
+ * The new i/o instance reads the (len) bytes of (io) that start at byte
+ *  (offset), as if they were a file of their own: its byte zero is (io)'s
+ *  byte (offset), and its length is (len). Nothing is copied; reads go
+ *  straight to (io), positional reads and memory mapping included if (io)
+ *  supports them, and duplicates share (io)'s duplicates the same way. It's
+ *  read-only, even if (io) isn't.
+ *
+ * This is useful for mounting one of many archives that were concatenated
+ *  into a single file, with PHYSFS_mountIo(). PHYSFS_mountRange() does that
+ *  for a file in the physical filesystem.
+ *
+ * On success, the new instance owns (io), and calls (io)->destroy(io) when
+ *  it is destroyed itself. Since (io) keeps track of the current position
+ *  for the new instance, don't use it directly after this. If this function
+ *  fails, (io) is left alone.
+ *
+ *   \param io i/o instance with the data in it.
+ *   \param offset Byte in (io) where the range starts.
+ *   \param len Number of bytes in the range. It must fit in (io).
+ *  \return a new i/o instance, or NULL on failure. Specifics of the error
+ *          can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mountIo
+ * \sa PHYSFS_mountRange
+ */
+PHYSFS_DECL PHYSFS_Io *PHYSFS_createSubIo(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                                          PHYSFS_uint64 len);
+
+#endif  /* SWIG */
+
+
+/**
+ * \fn int PHYSFS_mountRange(const char *path, PHYSFS_uint64 offset, PHYSFS_uint64 len, const char *fname, const char *mountPoint, int appendToPath)
+ * \brief Add an archive at some offset in a file to the search path.
+ *
+ * This function operates just like PHYSFS_mount(), but only looks at the
+ *  (len) bytes of (path) that start at byte (offset), and mounts them as an
+ *  archive in their own right. Any offsets in the archive are relative to
+ *  its own start, as if it were a separate file. This lets you ship many
+ *  archives concatenated into one big file and mount them each, without
+ *  writing your own PHYSFS_Io for PHYSFS_mountIo().
+ *
+ * Since several archives may come from the same (path), (fname) is what
+ *  names this one: PHYSFS_unmount() and duplicate checking use it, and it
+ *  helps archiver selection, as with PHYSFS_mountIo(). It doesn't need to
+ *  refer to a real file, and can be NULL, in which case this archive can't
+ *  be unmounted by name or found to be a duplicate.
+ *
+ *   \param path file with the archive in it, in platform-dependent notation.
+ *   \param offset Byte in (path) where the archive starts.
+ *   \param len Size of the archive in bytes. It must fit in (path).
+ *   \param fname Filename that can represent this archive. Can be NULL.
+ *   \param mountPoint Location in the interpolated tree that this archive
+ *                     will be "mounted", in platform-independent notation.
+ *                     NULL or "" is equivalent to "/".
+ *   \param appendToPath nonzero to append to search path, zero to prepend.
+ *  \return nonzero if added to path, zero on failure (bogus archive, file
+ *                   missing, range past the end of it, etc). Specifics of
+ *                   the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_createSubIo
+ * \sa PHYSFS_mount
+ * \sa PHYSFS_unmount
+ */
+PHYSFS_DECL int PHYSFS_mountRange(const char *path, PHYSFS_uint64 offset,
+                                  PHYSFS_uint64 len, const char *fname,
+                                  const char *mountPoint, int appendToPath);
+
 
 /**
  * \enum PHYSFS_ErrorCode
@@ -3154,7 +3767,10 @@ typedef enum PHYSFS_ErrorCode
     PHYSFS_ERR_DIR_NOT_EMPTY,    /**< Tried to delete dir with files in it. */
     PHYSFS_ERR_OS_ERROR,         /**< Unspecified OS-level error.           */
     PHYSFS_ERR_DUPLICATE,        /**< Duplicate entry.                      */
-    PHYSFS_ERR_BAD_PASSWORD      /**< Bad password.                         */
+    PHYSFS_ERR_BAD_PASSWORD,     /**< Bad password.                         */
+    PHYSFS_ERR_CANCELLED,        /**< Cancelled, or too late to be useful.  */
+    PHYSFS_ERR_FROZEN,           /**< Search path was frozen.               */
+    PHYSFS_ERR_UNAVAILABLE       /**< Data hasn't arrived yet.              */
 } PHYSFS_ErrorCode;
 
 
@@ -3317,6 +3933,8 @@ PHYSFS_DECL void PHYSFS_setErrorCode(PHYSFS_ErrorCode code);
 PHYSFS_DECL const char *PHYSFS_getPrefDir(const char *org, const char *app);
 
 
+struct PHYSFS_EntryLayout;  /* defined with PHYSFS_statLayout(). */
+
 /**
  * \struct PHYSFS_Archiver
  * \brief Abstract interface to provide support for user-defined archives.
@@ -3360,7 +3978,12 @@ PHYSFS_DECL const char *PHYSFS_getPrefDir(const char *org, const char *app);
  *  PHYSFS_setErrorCode() before returning. PhysicsFS will pass these errors
  *  back to the application unmolested in most cases.
  *
- * Thread safety: TO BE DECIDED.  !!! FIXME
+ * Thread safety: PhysicsFS serializes calls into archivers you register, so
+ *  they don't have to be reentrant, but they may be called from any thread.
+ *  The PHYSFS_Io instances they return can be used from other threads while
+ *  the archiver is busy, though, so anything those share with the archiver
+ *  needs its own protection. (Most built-in archivers are reentrant, and
+ *  PhysicsFS lets lookups in them run in parallel.)
  *
  * \sa PHYSFS_registerArchiver
  * \sa PHYSFS_deregisterArchiver
@@ -3374,10 +3997,16 @@ typedef struct PHYSFS_Archiver
     /**
      * \brief Binary compatibility information.
      *
-     * This must be set to zero at this time. Future versions of this
-     *  struct will increment this field, so we know what a given
+     * This must be set to zero through five at this time. Future versions
+     *  of this struct will increment this field, so we know what a given
      *  implementation supports. We'll presumably keep supporting older
      *  versions as we offer new features, though.
+     *
+     * Version 0 structs end at closeArchive(). Version 1 adds
+     *  enumerateFilesStat(), version 2 adds claim(), version 3 adds
+     *  enumerateFilesPrefix(), version 4 adds checksum(), and version 5
+     *  adds layout(). The system won't touch fields past the ones your
+     *  version promises, so older implementations keep working unchanged.
      */
     PHYSFS_uint32 version;
 
@@ -3493,6 +4122,82 @@ typedef struct PHYSFS_Archiver
      *  there are still files open from this archive.
      */
     void (*closeArchive)(void *opaque);
+
+    /**
+     * List all files in (dirname) like enumerateFiles() does, but also
+     *  pass each one's metadata to (cb), filled in the way stat() would.
+     *  (dirname) is in platform-independent notation.
+     *  This method may be NULL, and is only used in version 1 structs and
+     *  later. Without it, PhysicsFS calls stat() on each enumerated entry.
+     */
+    void (*enumerateFilesStat)(void *opaque, const char *dirname,
+                               PHYSFS_EnumFilesStatCallback cb,
+                               const char *origdir, void *callbackdata);
+
+    /**
+     * Say whether a file could be one of your archives, from a look at
+     *  the start and end of it, without any I/O of your own.
+     *  When a file's extension doesn't say which archiver it's for,
+     *  PhysicsFS reads (at most) the first 36 kilobytes and the last 66
+     *  kilobytes of it once, and asks every archiver that has this before
+     *  calling its openArchive(), so unknown files don't cost every
+     *  archiver its own seeks and reads to rule them out.
+     * (head) is the first (headLen) bytes of the file, and (tail) is the
+     *  last (tailLen) bytes; they're the whole file, and might overlap, if
+     *  it's shorter than those. (fileLen) is the file's real length.
+     * Return zero if it definitely isn't yours, and openArchive() won't
+     *  be called for it. Return non-zero if it might be; openArchive()
+     *  still gets the final say.
+     *  This method may be NULL, and is only used in version 2 structs and
+     *  later. Without it, openArchive() is always called.
+     */
+    int (*claim)(const void *head, PHYSFS_uint64 headLen,
+                 const void *tail, PHYSFS_uint64 tailLen,
+                 PHYSFS_uint64 fileLen);
+
+    /**
+     * List the files in (dirname) whose names start with (prefix), like
+     *  enumerateFiles() does. The comparison is ASCII case-insensitive;
+     *  reporting a few extra names is harmless, as PhysicsFS checks them
+     *  again, but leaving out a match is not. This lets an archive that
+     *  keeps its names sorted or indexed skip the ones that can't match,
+     *  instead of reporting every one just to have it thrown away.
+     *  (dirname) is in platform-independent notation. (prefix) is never
+     *  empty and never has a '/' in it.
+     *  This method may be NULL, and is only used in version 3 structs and
+     *  later. Without it, PhysicsFS filters what enumerateFiles() reports.
+     */
+    void (*enumerateFilesPrefix)(void *opaque, const char *dirname,
+                                 const char *prefix,
+                                 PHYSFS_EnumFilesCallback cb,
+                                 const char *origdir, void *callbackdata);
+
+    /**
+     * Set (*crc) to the CRC-32 of (filename)'s contents, as the archive
+     *  already has it stored, without reading the file. It's the one ZIP
+     *  uses, and PHYSFS_crc32() works out. Return zero and set
+     *  PHYSFS_ERR_UNSUPPORTED if there's none stored for this file, and
+     *  PhysicsFS reads the file to work it out instead; any other error is
+     *  passed on to the app. (filename) is in platform-independent
+     *  notation.
+     *  This method may be NULL, and is only used in version 4 structs and
+     *  later. Without it, PhysicsFS always reads the file.
+     */
+    int (*checksum)(void *opaque, const char *filename, PHYSFS_uint32 *crc);
+
+    /**
+     * Say where (filename)'s data is stored in the archive, by filling in
+     *  every field of (layout) but (mount), which PhysicsFS fills in.
+     *  (layout) is zeroed, with (group) at -1, before this is called.
+     *  Return zero and set PHYSFS_ERR_UNSUPPORTED if the file isn't stored
+     *  anywhere an app could read it from itself; any other error is
+     *  passed on to the app. (filename) is in platform-independent
+     *  notation.
+     *  This method may be NULL, and is only used in version 5 structs and
+     *  later. Without it, PHYSFS_statLayout() fails as unsupported.
+     */
+    int (*layout)(void *opaque, const char *filename,
+                  struct PHYSFS_EntryLayout *layout);
 } PHYSFS_Archiver;
 
 /**
@@ -3535,6 +4240,4033 @@ PHYSFS_DECL int PHYSFS_deregisterArchiver(const char *ext);
 
 /* Everything above this line is part of the PhysicsFS 2.1 API. */
 
+
+/**
+ * \fn int PHYSFS_readFile(const char *filename, void **buf, PHYSFS_uint64 *len)
+ * \brief Read all of a file into a new buffer.
+ *
+ * This does what most programs do with most files: opens (filename), gets
+ *  its length, allocates that much memory, reads the whole file into it,
+ *  and closes it again. Doing it in one call lets PhysicsFS pick the
+ *  cheapest way for each file: data that's already in memory (memory
+ *  mapped files, entries in the decompression cache) is copied once,
+ *  compressed ZIP entries are inflated in one shot straight into the new
+ *  buffer, and nothing goes through a file handle's buffer.
+ *
+ * On success, (*buf) points to the file's contents, followed by one null
+ *  byte that isn't counted in (*len), so text files can be used as C
+ *  strings. It was allocated with the PhysicsFS allocator; free it with
+ *  PHYSFS_getAllocator()->Free() before calling PHYSFS_deinit().
+ *
+ *   \param filename File to read, in platform-independent notation.
+ *   \param buf On success, receives the new buffer. NULL on failure.
+ *   \param len On success, receives the file's length in bytes. May be
+ *              NULL if you don't need it.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openRead
+ * \sa PHYSFS_readBytes
+ * \sa PHYSFS_getAllocator
+ */
+PHYSFS_DECL int PHYSFS_readFile(const char *filename, void **buf,
+                                PHYSFS_uint64 *len);
+
+
+/**
+ * \fn int PHYSFS_mapRead(PHYSFS_File *handle, const void **ptr, PHYSFS_uint64 *len)
+ * \brief Get a read-only pointer to a file's contents without copying.
+ *
+ * Some files are already sitting contiguously in memory: files inside an
+ *  archive mounted with PHYSFS_mountMemory(), uncompressed entries in a
+ *  memory-mapped .zip, decompressed 7zip blocks, small ISO9660 files, etc.
+ *  For those, this hands back a pointer straight into that storage, so you
+ *  don't have to allocate a buffer and PHYSFS_readBytes() into it just to
+ *  hand the data to something else.
+ *
+ * The pointer covers the whole file, from byte zero, regardless of the
+ *  current file position, and the file position isn't changed. It stays
+ *  valid until (handle) is closed. Do not write through it.
+ *
+ * This is an optimization and can fail for any file; when it does, read
+ *  the file normally. The file must be opened for reading.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param ptr On success, receives a pointer to the file's contents.
+ *   \param len On success, receives the file's length in bytes.
+ *  \return non-zero on success, zero if the data can't be mapped. Specifics
+ *          of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readBytes
+ */
+PHYSFS_DECL int PHYSFS_mapRead(PHYSFS_File *handle, const void **ptr,
+                               PHYSFS_uint64 *len);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readAt(PHYSFS_File *handle, void *buffer, PHYSFS_uint64 len, PHYSFS_uint64 offset)
+ * \brief Read bytes from a specific offset, without moving the file position.
+ *
+ * This works like PHYSFS_readBytes(), but reads starting at (offset) instead
+ *  of the current file position, and doesn't change the file position.
+ *  Several threads may call this on the same handle at once, so parallel
+ *  workers can share one handle instead of each opening their own; don't
+ *  mix this with PHYSFS_readBytes() or PHYSFS_seek() on the same handle from
+ *  other threads, though.
+ *
+ * Native files, memory-backed archives and uncompressed archive formats do
+ *  this without any locking, except that on Windows, threads reading the
+ *  same native handle take turns, since each read there briefly moves the
+ *  handle's file pointer. Files in 7z archives only make threads wait for
+ *  each other while they need the same solid block decompressed. Other
+ *  files (compressed entries, etc) still work, but callers take turns
+ *  seeking and reading behind the scenes, which can be slow for compressed
+ *  data.
+ *
+ * The file must be opened for reading. Reads past the end of the file are
+ *  short, not errors.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param buffer buffer of at least (len) bytes to store read data into.
+ *   \param len number of bytes being read from (handle).
+ *   \param offset byte offset into the file to start reading from.
+ *  \return number of bytes read, 0 at or past EOF, -1 if complete failure.
+ *
+ * \sa PHYSFS_readBytes
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readAt(PHYSFS_File *handle, void *buffer,
+                                        PHYSFS_uint64 len,
+                                        PHYSFS_uint64 offset);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readv(PHYSFS_File *handle, const PHYSFS_IoVec *iov, PHYSFS_uint32 count)
+ * \brief Read the next bytes of a file into several buffers.
+ *
+ * This reads iov[0].len bytes from the current file position into
+ *  iov[0].buf, the iov[1].len bytes after those into iov[1].buf, and so
+ *  on, as if PHYSFS_readBytes() was called once for each buffer. A file
+ *  laid out as a header followed by a few blocks of data can be loaded
+ *  straight to where each part goes, with no bounce buffer.
+ *
+ * Unbuffered files in native directories do this with one system call
+ *  (readv()), where the platform has it; other files just read each piece
+ *  in turn.
+ *
+ * As with PHYSFS_readBytes(), a short read means EOF was reached; the bytes
+ *  that were read fill the buffers in order, and the rest are untouched.
+ *  The file must be opened for reading.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param iov the buffers to fill, in file order.
+ *   \param count number of elements in (iov).
+ *  \return total number of bytes read, 0 at EOF, -1 if complete failure.
+ *
+ * \sa PHYSFS_readBytes
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readv(PHYSFS_File *handle,
+                                       const PHYSFS_IoVec *iov,
+                                       PHYSFS_uint32 count);
+
+
+/**
+ * \fn int PHYSFS_enableSearchPathIndex(int enable)
+ * \brief Enable or disable the search path index.
+ *
+ * Normally, looking up a file asks each archive mounted where it could
+ *  have that file (at or above the file's directory), in search path
+ *  order, until one has it. With many archives mounted at the same place
+ *  (patch archives, mods, etc), that's a lot of work for every
+ *  PHYSFS_openRead(), PHYSFS_exists(), PHYSFS_stat() and
+ *  PHYSFS_getRealDir() call.
+ *
+ * With the index enabled, PhysicsFS lists the contents of each ZIP, RAS,
+ *  PPK, GRP, HOG, MVL, QPAK, SLB and WAD archive once, when it's first
+ *  indexed, and keeps a table of which archive in the search path has each
+ *  file first. Lookups then check that table and skip the archives that can't
+ *  have the file. Native directories, ISO9660 and 7zip archives, and
+ *  archivers registered by the application aren't indexed, and are still
+ *  asked every time, so the results are exactly the same either way.
+ *
+ * The table is updated on every PHYSFS_mount() and PHYSFS_unmount(), which
+ *  makes those a little slower and costs some memory per file in indexed
+ *  archives. Enumerating files doesn't use the index.
+ *
+ * The index is disabled by default, and when PHYSFS_deinit() is called.
+ *
+ *   \param enable non-zero to enable the index, zero to disable it.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError(). If enabling fails, the
+ *          index stays disabled, but everything else works as usual.
+ *
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL int PHYSFS_enableSearchPathIndex(int enable);
+
+
+/**
+ * \fn int PHYSFS_enableMissCache(int enable)
+ * \brief Enable or disable remembering paths that weren't found.
+ *
+ * Probing for optional files ("foo.dds", then "foo.png", then "foo.tga")
+ *  usually misses, and every miss asks every archive in the search path.
+ *  With this enabled, PhysicsFS remembers a few hundred recent misses, and
+ *  PHYSFS_openRead(), PHYSFS_exists(), PHYSFS_stat() and PHYSFS_getRealDir()
+ *  fail right away with PHYSFS_ERR_NOT_FOUND if they're asked again.
+ *
+ * Everything remembered is forgotten whenever the search path or write dir
+ *  changes, PHYSFS_openWrite(), PHYSFS_openAppend(), PHYSFS_mkdir() or
+ *  PHYSFS_delete() is called, or PHYSFS_permitSymbolicLinks() is called.
+ *  PhysicsFS can't see files that appear in a native directory by other
+ *  means, though: if something besides PhysicsFS might create files in the
+ *  search path, call PHYSFS_invalidateCache() to forget everything after
+ *  it does.
+ *
+ * This is disabled by default, and when PHYSFS_deinit() is called.
+ *
+ *   \param enable non-zero to enable the cache, zero to disable it.
+ *  \return non-zero on success, zero if PhysicsFS isn't initialized.
+ *
+ * \sa PHYSFS_enableSearchPathIndex
+ * \sa PHYSFS_invalidateCache
+ */
+PHYSFS_DECL int PHYSFS_enableMissCache(int enable);
+
+
+/**
+ * \fn void PHYSFS_setSymbolicLinkCheckCacheTime(int seconds)
+ * \brief Set how long symlink checks in native directories are trusted.
+ *
+ * When symbolic links aren't permitted (the default), PhysicsFS checks each
+ *  element of a path before using it, so "a/b/c/file" costs four checks
+ *  on every open; for native directories, each is a system call. PhysicsFS
+ *  remembers directories it recently found to be free of symlinks, so later
+ *  opens of files in the same directory only check the file itself.
+ *
+ * Archives can't change while mounted, so this is always done for them.
+ *  Native directories can, though: something outside PhysicsFS could
+ *  replace a directory with a symlink after it was checked. So by default,
+ *  checks in native directories aren't remembered at all. This lets you set
+ *  how long they're trusted for, when you don't need to worry about that.
+ *
+ * Either way, everything remembered is forgotten whenever the search path
+ *  or write dir changes, PhysicsFS writes, creates or deletes anything, or
+ *  PHYSFS_permitSymbolicLinks() or this function is called.
+ *
+ * This goes back to zero when PHYSFS_deinit() is called.
+ *
+ *   \param seconds how long to trust a native directory's check. Zero to not
+ *                  remember them (the default), -1 to trust them until
+ *                  something changes, as above.
+ *
+ * \sa PHYSFS_permitSymbolicLinks
+ */
+PHYSFS_DECL void PHYSFS_setSymbolicLinkCheckCacheTime(int seconds);
+
+
+/**
+ * \fn void PHYSFS_setDirListingCacheTime(int seconds)
+ * \brief Set how long listings of native directories are kept.
+ *
+ * Every PHYSFS_enumerateFiles(), PHYSFS_enumerateFilesCallback(),
+ *  PHYSFS_enumerateFilesStatCallback() or PHYSFS_walkTree() that reaches a
+ *  native directory in the search path reads that directory from the
+ *  filesystem again. That's cheap on a local disk, but not on a slow
+ *  network share. With this set, PhysicsFS keeps the last few listings
+ *  (names and metadata) of each mounted native directory, and hands those
+ *  out again instead. Archives are never read twice like this anyhow.
+ *
+ * Whatever is kept is forgotten whenever the search path or write dir
+ *  changes, PhysicsFS writes, creates or deletes anything,
+ *  PHYSFS_permitSymbolicLinks() or this function is called, or you call
+ *  PHYSFS_invalidateCache(). If something else might change these
+ *  directories, either pick a time you're willing to see old listings for,
+ *  invalidate it yourself, or let PHYSFS_setChangeCallback() do it.
+ *  Sizes and times of files that are still open for writing may be out of
+ *  date until they're closed.
+ *
+ * This goes back to zero when PHYSFS_deinit() is called.
+ *
+ *   \param seconds how long to keep a listing. Zero to not keep them (the
+ *                  default), -1 to keep them until something changes, as
+ *                  above.
+ *
+ * \sa PHYSFS_invalidateCache
+ * \sa PHYSFS_setChangeCallback
+ * \sa PHYSFS_setSymbolicLinkCheckCacheTime
+ */
+PHYSFS_DECL void PHYSFS_setDirListingCacheTime(int seconds);
+
+
+/**
+ * \fn void PHYSFS_invalidateCache(void)
+ * \brief Forget everything PhysicsFS remembers about the search path.
+ *
+ * Call this after something besides PhysicsFS changes files in a mounted
+ *  native directory. It drops remembered misses (PHYSFS_enableMissCache()),
+ *  symlink checks (PHYSFS_setSymbolicLinkCheckCacheTime()), directory
+ *  listings (PHYSFS_setDirListingCacheTime()), metadata
+ *  (PHYSFS_setMountStatCacheTime()) and files kept open
+ *  (PHYSFS_setOpenFileCacheTime()), so the next lookup asks the filesystem
+ *  again. It's cheap: nothing is freed until it would be replaced anyhow.
+ *
+ * \sa PHYSFS_enableMissCache
+ * \sa PHYSFS_setSymbolicLinkCheckCacheTime
+ * \sa PHYSFS_setDirListingCacheTime
+ * \sa PHYSFS_setMountStatCacheTime
+ * \sa PHYSFS_setOpenFileCacheTime
+ */
+PHYSFS_DECL void PHYSFS_invalidateCache(void);
+
+
+/**
+ * \typedef PHYSFS_ChangeCallback
+ * \brief Function signature for callbacks that hear about changed files.
+ *
+ *   \param data User-defined data pointer, passed through from the
+ *               PHYSFS_setChangeCallback() call.
+ *   \param path Platform-independent path, in the search path, of what
+ *               changed. This is "" when the platform couldn't say what, so
+ *               assume anything might have.
+ *
+ * \sa PHYSFS_setChangeCallback
+ */
+typedef void (*PHYSFS_ChangeCallback)(void *data, const char *path);
+
+
+/**
+ * \fn int PHYSFS_setChangeCallback(PHYSFS_ChangeCallback callback, void *data)
+ * \brief Watch mounted native directories for changes.
+ *
+ * With a callback set, PhysicsFS asks the OS (inotify on Linux, FSEvents on
+ *  Mac OS X, ReadDirectoryChangesW() on Windows) to tell it whenever
+ *  something is created, deleted, renamed or written in a native directory
+ *  in the search path, or anywhere below one. Every such change forgets
+ *  what PhysicsFS remembers about the search path, as
+ *  PHYSFS_invalidateCache() does, and then calls (callback). So this pairs
+ *  well with PHYSFS_setDirListingCacheTime(-1): listings are kept until
+ *  they're actually out of date. Directories mounted later are watched as
+ *  they're mounted, and unmounted ones stop being watched. Archives aren't
+ *  watched.
+ *
+ * (callback) runs on a thread of PhysicsFS's, not yours, so it should be
+ *  quick and thread safe. It can use the rest of PhysicsFS, but must not
+ *  mount, unmount, or call this function. Changes can be reported more
+ *  than once, some time after they happen, and a change to one path may
+ *  be reported for its parent instead.
+ *
+ * Passing a NULL callback stops watching; it's stopped by PHYSFS_deinit(),
+ *  too. Once this returns, the old callback isn't running and won't be
+ *  called again.
+ *
+ *   \param callback Function to call about changes. NULL to stop watching.
+ *   \param data Passed through to (callback).
+ *  \return nonzero if every mounted native directory is being watched, zero
+ *          if one or more couldn't be (PHYSFS_ERR_UNSUPPORTED if the
+ *          platform can't do it at all). The callback is set either way,
+ *          and still hears about the directories that are watched. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_invalidateCache
+ * \sa PHYSFS_setDirListingCacheTime
+ */
+PHYSFS_DECL int PHYSFS_setChangeCallback(PHYSFS_ChangeCallback callback,
+                                         void *data);
+
+
+/**
+ * \typedef PHYSFS_TaskFunc
+ * \brief A piece of work PhysicsFS wants run, for PHYSFS_SubmitCallback.
+ *
+ *    \param taskdata what the PHYSFS_SubmitCallback got with it.
+ *
+ * \sa PHYSFS_setExecutor
+ */
+typedef void (*PHYSFS_TaskFunc)(void *taskdata);
+
+
+/**
+ * \typedef PHYSFS_SubmitCallback
+ * \brief Function signature for PHYSFS_setExecutor().
+ *
+ * Arrange for (task)(taskdata) to be called, once, on some thread. It can
+ *  be called from inside this callback, or later, from a job system's
+ *  worker, but it has to be called eventually: something in PhysicsFS is
+ *  waiting for it. Tasks read from archives, so they can block on I/O.
+ *
+ *    \param task what to call.
+ *    \param taskdata what to pass to it.
+ *    \param userdata what was passed to PHYSFS_setExecutor().
+ *
+ * \sa PHYSFS_setExecutor
+ */
+typedef void (*PHYSFS_SubmitCallback)(PHYSFS_TaskFunc task, void *taskdata,
+                                      void *userdata);
+
+
+/**
+ * \fn void PHYSFS_setExecutor(PHYSFS_SubmitCallback submit, void *userdata)
+ * \brief Run PhysicsFS's background work on your own threads.
+ *
+ * PhysicsFS splits some jobs across threads: parsing a big ZIP's central
+ *  directory, PHYSFS_mountMany(), compressing big ZIP writes. By default
+ *  that work goes to a pool of up to eight threads of its own, started the
+ *  first time there's work for them, and stopped by PHYSFS_deinit(). If
+ *  your program already has a job system, this hands that work to it
+ *  instead, so the two aren't competing for the same cores.
+ *
+ * Whoever is waiting on a task that hasn't started yet runs it itself, so
+ *  a busy job system only costs the parallelism, never a deadlock; tasks
+ *  you get to after that return right away.
+ *
+ * This also covers queues from PHYSFS_createAsyncQueue() made while an
+ *  executor is set: they start no threads of their own, and instead submit
+ *  up to as many tasks at once as they'd have had threads, each of which
+ *  reads requests until the queue is empty.
+ *
+ * This can be called before PHYSFS_init(), and affects work started after
+ *  it returns. Don't call it while other threads are using PhysicsFS.
+ *
+ *   \param submit how to run a task, or NULL for PhysicsFS's own threads.
+ *   \param userdata passed to (submit) as-is.
+ *
+ * \sa PHYSFS_createAsyncQueue
+ * \sa PHYSFS_mountMany
+ */
+PHYSFS_DECL void PHYSFS_setExecutor(PHYSFS_SubmitCallback submit,
+                                    void *userdata);
+
+
+/**
+ * \struct PHYSFS_AsyncQueue
+ * \brief A pool of worker threads that service PHYSFS_readAsync() calls.
+ *
+ * This is opaque; you get one from PHYSFS_createAsyncQueue() and give it
+ *  back with PHYSFS_destroyAsyncQueue().
+ *
+ * \sa PHYSFS_createAsyncQueue
+ * \sa PHYSFS_readAsync
+ */
+typedef struct PHYSFS_AsyncQueue PHYSFS_AsyncQueue;
+
+
+/**
+ * \typedef PHYSFS_AsyncCallback
+ * \brief Function signature for PHYSFS_readAsync() completions.
+ *
+ * This is called once per PHYSFS_readAsync() call, when the read is done,
+ *  usually on one of the queue's worker threads.
+ *
+ *    \param userdata what was passed to PHYSFS_readAsync().
+ *    \param handle the file that was read from.
+ *    \param buffer the buffer that was read into.
+ *    \param result what PHYSFS_readAt() would have returned: the number of
+ *                  bytes read, 0 at or past EOF, -1 on complete failure.
+ *                  On failure, PHYSFS_getLastErrorCode() called from the
+ *                  callback says why.
+ *
+ * \sa PHYSFS_readAsync
+ */
+typedef void (*PHYSFS_AsyncCallback)(void *userdata, PHYSFS_File *handle,
+                                     void *buffer, PHYSFS_sint64 result);
+
+
+/**
+ * \fn PHYSFS_AsyncQueue *PHYSFS_createAsyncQueue(PHYSFS_uint32 threads)
+ * \brief Start a pool of threads to service asynchronous reads.
+ *
+ * The queue keeps any number of PHYSFS_readAsync() requests in flight,
+ *  servicing them in the order they were made, by up to (threads) at once;
+ *  PHYSFS_readAsyncPriority() can put a request ahead of others.
+ *
+ * If threads can't be started on this platform (or (threads) is zero), you
+ *  still get a queue, but PHYSFS_readAsync() does each read, and calls its
+ *  callback, before it returns.
+ *
+ *   \param threads number of worker threads to start.
+ *  \return a new queue, or NULL on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_destroyAsyncQueue
+ * \sa PHYSFS_readAsync
+ */
+PHYSFS_DECL PHYSFS_AsyncQueue *PHYSFS_createAsyncQueue(PHYSFS_uint32 threads);
+
+
+/**
+ * \fn void PHYSFS_destroyAsyncQueue(PHYSFS_AsyncQueue *queue)
+ * \brief Finish all reads in a queue, then free it.
+ *
+ * This blocks until every request already made to (queue) has been read
+ *  and had its callback called, then stops the worker threads. Don't make
+ *  new requests on (queue) while this runs, or after, and destroy all your
+ *  queues before calling PHYSFS_deinit().
+ *
+ *   \param queue the queue to destroy. NULL is ignored.
+ *
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL void PHYSFS_destroyAsyncQueue(PHYSFS_AsyncQueue *queue);
+
+
+/**
+ * \fn int PHYSFS_readAsync(PHYSFS_AsyncQueue *queue, PHYSFS_File *handle, void *buffer, PHYSFS_uint64 len, PHYSFS_uint64 offset, PHYSFS_AsyncCallback callback, void *userdata)
+ * \brief Read data from a file without waiting for it.
+ *
+ * This asks (queue) to do what PHYSFS_readAt() does, and then call
+ *  (callback) with the result. It returns right away; the read happens on
+ *  one of the queue's threads. Since reads don't use the file position,
+ *  several can be in flight for the same handle at once.
+ *
+ * (buffer) must stay valid, and (handle) must stay open, until (callback)
+ *  has been called. Callbacks for different requests may run at the same
+ *  time on different threads, in any order, so they must be thread safe.
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue().
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param buffer buffer of at least (len) bytes to store read data into.
+ *   \param len number of bytes to read from (handle).
+ *   \param offset byte offset into the file to start reading from.
+ *   \param callback function to call when the read is done.
+ *   \param userdata passed to (callback) untouched.
+ *  \return non-zero if the read was queued (or done), zero if it couldn't
+ *          be; (callback) is not called in that case. Specifics of the error
+ *          can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readAt
+ * \sa PHYSFS_createAsyncQueue
+ * \sa PHYSFS_enableIoUring
+ */
+PHYSFS_DECL int PHYSFS_readAsync(PHYSFS_AsyncQueue *queue,
+                                 PHYSFS_File *handle, void *buffer,
+                                 PHYSFS_uint64 len, PHYSFS_uint64 offset,
+                                 PHYSFS_AsyncCallback callback,
+                                 void *userdata);
+
+
+/**
+ * \fn int PHYSFS_enableIoUring(int enable)
+ * \brief Let async queues hand the kernel many reads at once.
+ *
+ * On Linux kernels that support it, this sets up an io_uring, and each
+ *  PHYSFS_AsyncQueue worker submits every queued read of a plain file (one
+ *  opened from a directory mounted with PHYSFS_mount()) together, instead
+ *  of doing them one at a time. On Windows and WinRT, the same reads go out
+ *  together as overlapped reads on an I/O completion port. Reads from inside
+ *  archives aren't affected.
+ *
+ * This is off by default. If the kernel (or the platform) can't do it,
+ *  PhysicsFS quietly goes on reading one at a time, so it's always safe to
+ *  ask for.
+ *
+ * This must be called before PHYSFS_init(), and the setting lasts until
+ *  it's changed again.
+ *
+ *   \param enable non-zero to use io_uring when possible, zero to not.
+ *  \return non-zero on success, zero if PhysicsFS is already initialized.
+ *
+ * \sa PHYSFS_createAsyncQueue
+ * \sa PHYSFS_readAsync
+ */
+PHYSFS_DECL int PHYSFS_enableIoUring(int enable);
+
+
+/**
+ * \fn int PHYSFS_setAdaptiveBuffer(PHYSFS_File *handle, PHYSFS_uint64 maxsize, PHYSFS_AsyncQueue *queue)
+ * \brief Buffer a file for reading, sized by how it's being read.
+ *
+ * This is like PHYSFS_setBuffer() for files opened for reading, but the
+ *  buffer sizes itself. It starts small, and every time it's refilled
+ *  without a seek since the last refill, it reads twice as much as before,
+ *  up to (maxsize) bytes. So a file read from start to finish soon moves
+ *  in big chunks, while a file read in little pieces from all over only
+ *  ever reads a little past each piece. Any seek outside the buffered data
+ *  starts it over small.
+ *
+ * If (queue) isn't NULL, once a file is being read sequentially, the next
+ *  chunk is read on the queue while you work through the current one, so
+ *  the decompression or disk wait overlaps your own work. This costs
+ *  another (maxsize) bytes of memory. The queue must outlive the handle,
+ *  or at least its buffer.
+ *
+ * Either way, the handle still can't be used from more than one thread
+ *  at once. PHYSFS_tell(), PHYSFS_seek() and PHYSFS_eof() account for all
+ *  this, same as they do for a fixed buffer.
+ *
+ * Calling PHYSFS_setBuffer() on the handle, or this with a (maxsize) of
+ *  zero, turns adaptive buffering off again.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param maxsize most bytes to read at once.
+ *   \param queue queue from PHYSFS_createAsyncQueue() to read ahead on,
+ *                or NULL to only read when asked to.
+ *  \return nonzero if successful, zero on error. Files opened for writing
+ *          fail with PHYSFS_ERR_OPEN_FOR_WRITING.
+ *
+ * \sa PHYSFS_setBuffer
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL int PHYSFS_setAdaptiveBuffer(PHYSFS_File *handle,
+                                         PHYSFS_uint64 maxsize,
+                                         PHYSFS_AsyncQueue *queue);
+
+
+/**
+ * \fn int PHYSFS_setWriteBehind(PHYSFS_File *handle, PHYSFS_uint64 bufsize, PHYSFS_AsyncQueue *queue)
+ * \brief Buffer a file for writing, and write full buffers in the background.
+ *
+ * This is like PHYSFS_setBuffer() for files opened for writing, but when
+ *  the buffer fills up, it's handed to (queue) to write, and writes go on
+ *  into a second buffer while that happens. Only when that one fills up,
+ *  too, before the first one's written, does a write have to wait. So a
+ *  file that's written faster than the disk can take it goes at the disk's
+ *  pace, but a burst of writes, like saving a game, mostly doesn't wait
+ *  on the disk at all. This costs another (bufsize) bytes of memory.
+ *
+ * Each file has at most one buffer being written at a time, so its data
+ *  reaches the disk in the order it was written. A write that fails in the
+ *  background is reported by the next call on the handle that waits for
+ *  it: the PHYSFS_writeBytes() that fills the next buffer, PHYSFS_flush(),
+ *  PHYSFS_seek(), or PHYSFS_close(). The file should be considered
+ *  damaged after that.
+ *
+ * PHYSFS_flush() is a barrier: it waits for the background write, then
+ *  writes out what's buffered itself, so everything written before it has
+ *  made it to the file (or failed) when it returns. PHYSFS_close() does
+ *  the same. PHYSFS_tell() and PHYSFS_fileLength() wait for the background
+ *  write, but don't report its errors.
+ *
+ * The handle still can't be used from more than one thread at once. The
+ *  queue must outlive the handle, or at least its buffer. Calling
+ *  PHYSFS_setBuffer() on the handle, or this with a NULL (queue), makes it
+ *  a plain buffer again; a (bufsize) of zero turns buffering off.
+ *
+ *   \param handle handle returned from PHYSFS_openWrite() or
+ *                 PHYSFS_openAppend().
+ *   \param bufsize size of each of the two buffers, in bytes.
+ *   \param queue queue from PHYSFS_createAsyncQueue() to write on, or NULL
+ *                to write full buffers right away.
+ *  \return nonzero if successful, zero on error. Files opened for reading
+ *          fail with PHYSFS_ERR_OPEN_FOR_READING.
+ *
+ * \sa PHYSFS_setBuffer
+ * \sa PHYSFS_flush
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL int PHYSFS_setWriteBehind(PHYSFS_File *handle,
+                                      PHYSFS_uint64 bufsize,
+                                      PHYSFS_AsyncQueue *queue);
+
+
+/**
+ * \enum PHYSFS_AccessHint
+ * \brief How a file is going to be read, for PHYSFS_setAccessHint().
+ *
+ * \sa PHYSFS_setAccessHint
+ * \sa PHYSFS_setMountAccessHint
+ */
+typedef enum PHYSFS_AccessHint
+{
+    PHYSFS_ACCESS_NORMAL,      /**< No particular pattern; the default. */
+    PHYSFS_ACCESS_SEQUENTIAL,  /**< Start to finish; read well ahead. */
+    PHYSFS_ACCESS_RANDOM,      /**< All over; don't bother reading ahead. */
+    PHYSFS_ACCESS_WILLNEED,    /**< All of it, soon; start loading it now. */
+    PHYSFS_ACCESS_DONTNEED,    /**< Done with it; drop it from the cache. */
+    PHYSFS_ACCESS_STREAM       /**< Huge and read once; bypass the cache. */
+} PHYSFS_AccessHint;
+
+
+/**
+ * \fn int PHYSFS_setAccessHint(PHYSFS_File *handle, PHYSFS_AccessHint hint)
+ * \brief Tell the OS how a file is going to be read.
+ *
+ * This passes (hint) down to the OS's own file cache, with posix_fadvise()
+ *  or its local equivalent, so it can read ahead more (or less), start
+ *  loading a file you're about to need, or drop one you're done with.
+ *  For a file inside an archive, the hint only covers that file's bytes
+ *  within the archive, so WILLNEED loads exactly what you'll read, and
+ *  not the rest of the pack. A compressed file's hint covers all of its
+ *  compressed data.
+ *
+ * PHYSFS_ACCESS_STREAM is for big video and audio files that get read once
+ *  and would otherwise push everything else out of the OS's cache. Where
+ *  the OS allows it (O_DIRECT, F_NOCACHE, FILE_FLAG_NO_BUFFERING), reads
+ *  from then on skip the cache entirely; PhysicsFS deals with the sector
+ *  alignment that needs, so reads work exactly as before. Files too small
+ *  for this to pay off, files in archives PhysicsFS could memory-map, and
+ *  OSes or filesystems that can't do it get PHYSFS_ACCESS_SEQUENTIAL
+ *  instead. Any other hint turns it off again.
+ *
+ * This is only a hint. It never changes what reads return, and the OS is
+ *  free to ignore it. Files from archives that can't say where their data
+ *  lives (or that live in memory already) report PHYSFS_ERR_UNSUPPORTED,
+ *  which you can ignore just as safely.
+ *
+ *   \param handle handle returned from one of the PHYSFS_open*() functions.
+ *   \param hint how the file will be used.
+ *  \return nonzero if the OS was told, zero if it couldn't be. Use
+ *          PHYSFS_getLastErrorCode() to find out why.
+ *
+ * \sa PHYSFS_setMountAccessHint
+ */
+PHYSFS_DECL int PHYSFS_setAccessHint(PHYSFS_File *handle,
+                                     PHYSFS_AccessHint hint);
+
+
+/**
+ * \fn int PHYSFS_setMountAccessHint(const char *dir, PHYSFS_AccessHint hint)
+ * \brief Set the access hint for every file opened from an archive.
+ *
+ * After this, every file PHYSFS_openRead() opens from (dir), which must be
+ *  in the search path, gets (hint) as if you had called
+ *  PHYSFS_setAccessHint() on it yourself, so an archive full of streamed
+ *  music can be SEQUENTIAL, and one full of small records RANDOM. Files
+ *  that are already open keep what they have. Use PHYSFS_ACCESS_NORMAL to
+ *  stop.
+ *
+ *   \param dir a directory or archive, as passed to PHYSFS_mount().
+ *   \param hint hint for files opened from it from now on.
+ *  \return nonzero on success, zero if (dir) isn't mounted.
+ *
+ * \sa PHYSFS_setAccessHint
+ */
+PHYSFS_DECL int PHYSFS_setMountAccessHint(const char *dir,
+                                          PHYSFS_AccessHint hint);
+
+
+/**
+ * \enum PHYSFS_AtomicWriteFlags
+ * \brief Options for PHYSFS_openWriteAtomic().
+ *
+ * \sa PHYSFS_openWriteAtomic
+ */
+typedef enum PHYSFS_AtomicWriteFlags
+{
+    PHYSFS_ATOMIC_SYNC = (1 << 0),  /**< Data's on the disk before rename. */
+    PHYSFS_ATOMIC_BATCH = (1 << 1)  /**< Rename on commit, not on close. */
+} PHYSFS_AtomicWriteFlags;
+
+
+/**
+ * \fn PHYSFS_File *PHYSFS_openWriteAtomic(const char *filename, PHYSFS_uint32 flags)
+ * \brief Open a file for writing, replacing the old one only when it's done.
+ *
+ * This is like PHYSFS_openWrite(), but the data is written to a hidden
+ *  temporary file in the same directory, and that's renamed over (filename)
+ *  when PHYSFS_close() succeeds. Until then, (filename) is untouched, so a
+ *  crash or a failed write in the middle of saving leaves the old file, not
+ *  half of the new one. If the handle is never closed, because
+ *  PHYSFS_deinit() closed it, the temporary file is deleted instead.
+ *
+ * With PHYSFS_ATOMIC_SYNC, the data is flushed to the disk before the
+ *  rename, and the directory after it, so the new file survives a power
+ *  failure, too. That's slow: each file waits for the disk twice.
+ *
+ * With PHYSFS_ATOMIC_BATCH, PHYSFS_close() leaves the temporary file where
+ *  it is, and PHYSFS_commitAtomicWrites() renames everything closed since
+ *  the last commit at once. With PHYSFS_ATOMIC_SYNC, too, the commit syncs
+ *  all the files, then renames them all, then syncs each directory once,
+ *  so saving many files pays for a few waits on the disk instead of two
+ *  per file. The write dir can't be changed while a batch is waiting, and
+ *  PHYSFS_deinit() throws away a batch that was never committed.
+ *
+ * This only works when the write dir is a directory on the native
+ *  filesystem; otherwise it fails with PHYSFS_ERR_UNSUPPORTED. (Files
+ *  written to an archive aren't in the archive until they're closed
+ *  anyhow.) If the rename fails, PHYSFS_close() returns zero, but the
+ *  handle is closed regardless, and the temporary file is deleted.
+ *
+ *   \param filename File to open.
+ *   \param flags zero or more PHYSFS_AtomicWriteFlags, OR'd together.
+ *  \return A valid PhysicsFS filehandle on success, NULL on error. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_openWrite
+ * \sa PHYSFS_commitAtomicWrites
+ * \sa PHYSFS_close
+ */
+PHYSFS_DECL PHYSFS_File *PHYSFS_openWriteAtomic(const char *filename,
+                                                PHYSFS_uint32 flags);
+
+
+/**
+ * \fn int PHYSFS_commitAtomicWrites(void)
+ * \brief Rename every PHYSFS_ATOMIC_BATCH file that's been closed.
+ *
+ * Files are renamed in the order they were closed, so if one name was
+ *  written twice, the later one wins. If something fails, the rest are
+ *  still committed; the ones that failed have their temporary files
+ *  deleted, and the first error is reported. Either way, the batch is
+ *  empty afterwards. Files that are still open aren't part of it.
+ *
+ *  \return nonzero if everything was committed, zero on error. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_openWriteAtomic
+ */
+PHYSFS_DECL int PHYSFS_commitAtomicWrites(void);
+
+
+/**
+ * \struct PHYSFS_DurabilityGroup
+ * \brief A set of files to get onto the disk together.
+ *
+ * This is opaque; you get one from PHYSFS_createDurabilityGroup() and give
+ *  it back with PHYSFS_destroyDurabilityGroup().
+ *
+ * \sa PHYSFS_createDurabilityGroup
+ * \sa PHYSFS_commitDurabilityGroup
+ */
+typedef struct PHYSFS_DurabilityGroup PHYSFS_DurabilityGroup;
+
+
+/**
+ * \fn PHYSFS_DurabilityGroup *PHYSFS_createDurabilityGroup(void)
+ * \brief Make an empty durability group.
+ *
+ * PHYSFS_flush() and PHYSFS_close() hand what's written to the OS, but the
+ *  OS might keep it in memory for a while, and a power failure loses it.
+ *  A durability group collects files written to the write dir, and
+ *  PHYSFS_commitDurabilityGroup() makes sure all of them are really on the
+ *  disk, which is much faster than doing so a file at a time when there are
+ *  many of them, like a checkpoint that writes hundreds of small files.
+ *
+ * A group isn't safe to use from more than one thread at once.
+ *
+ *  \return A new, empty group, or NULL on error. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_addToDurabilityGroup
+ * \sa PHYSFS_commitDurabilityGroup
+ * \sa PHYSFS_destroyDurabilityGroup
+ */
+PHYSFS_DECL PHYSFS_DurabilityGroup *PHYSFS_createDurabilityGroup(void);
+
+
+/**
+ * \fn int PHYSFS_addToDurabilityGroup(PHYSFS_DurabilityGroup *group, const char *filename)
+ * \brief Add a file in the write dir to a durability group.
+ *
+ * This just remembers (filename); nothing is checked or synced until
+ *  PHYSFS_commitDurabilityGroup(). The file should be closed, or at least
+ *  flushed with PHYSFS_flush(), before then, since anything still in a
+ *  PhysicsFS buffer isn't the OS's to sync.
+ *
+ *   \param group group from PHYSFS_createDurabilityGroup().
+ *   \param filename file in the write dir, in platform-independent notation.
+ *  \return nonzero if successful, zero on error. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_commitDurabilityGroup
+ */
+PHYSFS_DECL int PHYSFS_addToDurabilityGroup(PHYSFS_DurabilityGroup *group,
+                                            const char *filename);
+
+
+/**
+ * \fn int PHYSFS_commitDurabilityGroup(PHYSFS_DurabilityGroup *group, PHYSFS_AsyncQueue *queue)
+ * \brief Make sure every file in a durability group is on the disk.
+ *
+ * Each file's data is synced, on (queue)'s worker threads if there is one,
+ *  so the disk can work on many of them at once, and then each directory
+ *  the files are in is synced once, so files that were just created are
+ *  sure to be found. Where the platform can flush a whole filesystem in one
+ *  call (Linux's syncfs()), a big group is synced that way instead. Other
+ *  PhysicsFS calls wait until this is done.
+ *
+ * This only works when the write dir is a directory on the native
+ *  filesystem; otherwise it fails with PHYSFS_ERR_UNSUPPORTED. On success,
+ *  the group is emptied, to be reused for the next batch. On failure, it's
+ *  left alone, so the commit can be tried again; the error is the first
+ *  file's that failed.
+ *
+ *   \param group group from PHYSFS_createDurabilityGroup().
+ *   \param queue queue from PHYSFS_createAsyncQueue() to sync files on, or
+ *                NULL to sync them one after another on this thread.
+ *  \return nonzero if everything is on the disk, zero on error. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_addToDurabilityGroup
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL int PHYSFS_commitDurabilityGroup(PHYSFS_DurabilityGroup *group,
+                                             PHYSFS_AsyncQueue *queue);
+
+
+/**
+ * \fn void PHYSFS_destroyDurabilityGroup(PHYSFS_DurabilityGroup *group)
+ * \brief Free a durability group.
+ *
+ * Files that were added but not committed are simply forgotten. NULL is
+ *  ignored.
+ *
+ *   \param group group from PHYSFS_createDurabilityGroup(), or NULL.
+ *
+ * \sa PHYSFS_createDurabilityGroup
+ */
+PHYSFS_DECL void PHYSFS_destroyDurabilityGroup(PHYSFS_DurabilityGroup *group);
+
+
+/**
+ * \fn void PHYSFS_setSeekIndexInterval(PHYSFS_uint32 interval)
+ * \brief Make seeking around in compressed files cheaper.
+ *
+ * Compressed data can't be jumped into the middle of, so seeking backwards
+ *  in a compressed file (deflated ZIP entries, for example) normally means
+ *  decompressing it again from the start up to the new position. With this
+ *  set, every open compressed file remembers how to resume decompressing
+ *  every (interval) bytes as it's read (or seeked through), and seeks start
+ *  from the closest of those at or before the new position instead.
+ *
+ * Each of these checkpoints costs about 43 kilobytes of memory for as long
+ *  as the file is open, so pick an interval that makes sense for the sizes
+ *  of the files you seek in; a megabyte between checkpoints costs about 4%
+ *  of what's been read. They are kept per file handle, not shared between
+ *  handles to the same file.
+ *
+ * This is zero (no checkpoints) by default. A new value affects files opened
+ *  after it's set, and may be set at any time, even before PHYSFS_init().
+ *  Files covered by a seek index file (see PHYSFS_buildSeekIndex()) use
+ *  that instead, and don't keep their own. Deflated ZIP entries don't get
+ *  checkpoints in a PhysicsFS built to use zlib or zlib-ng instead of its
+ *  own inflater (CMake's PHYSFS_INFLATE), whose state can't be copied.
+ *
+ *   \param interval bytes of decompressed data between checkpoints, or zero
+ *                   to not keep any.
+ *
+ * \sa PHYSFS_seek
+ * \sa PHYSFS_buildSeekIndex
+ */
+PHYSFS_DECL void PHYSFS_setSeekIndexInterval(PHYSFS_uint32 interval);
+
+
+/**
+ * \fn int PHYSFS_buildSeekIndex(const char *archive)
+ * \brief Save seek checkpoints for a ZIP file, for use from the first open.
+ *
+ * This decompresses every deflated file in (archive), a ZIP file in
+ *  platform-dependent notation, and writes the checkpoints described in
+ *  PHYSFS_setSeekIndexInterval() to a "seek index" file next to it, named
+ *  (archive) with ".seekindex" on the end. From then on, whenever (archive)
+ *  is mounted with PHYSFS_mount(), seeks in its compressed files start from
+ *  the closest saved checkpoint instead of the start of the file, without
+ *  any of them having to be read first. The checkpoints stay on disk, and
+ *  are only read when a seek needs one.
+ *
+ * Checkpoints are spaced by the current PHYSFS_setSeekIndexInterval()
+ *  setting, or a megabyte if that's zero. Files too small to get any are
+ *  left out. Each checkpoint takes about 43 kilobytes of disk space.
+ *
+ * The seek index is tied to the file it was built from: files in the
+ *  archive whose CRC or sizes no longer match are ignored. It's also tied
+ *  to this build of PhysicsFS (and its CPU architecture), so build it on
+ *  the platform that will use it; one from elsewhere is ignored outright.
+ *  It is trusted otherwise, so don't use seek indexes from untrusted
+ *  sources.
+ *
+ * This may take a while on big archives, and any existing seek index for
+ *  (archive) is replaced. If this fails, no seek index is left behind.
+ *  It fails with PHYSFS_ERR_UNSUPPORTED in a PhysicsFS built to use zlib or
+ *  zlib-ng (see PHYSFS_setSeekIndexInterval()).
+ *
+ *   \param archive path of a ZIP file, in platform-dependent notation.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_setSeekIndexInterval
+ */
+PHYSFS_DECL int PHYSFS_buildSeekIndex(const char *archive);
+
+
+/**
+ * \fn void PHYSFS_setDecompressionCacheSize(PHYSFS_uint64 bytes)
+ * \brief Keep small compressed files decompressed in memory.
+ *
+ * Opening a compressed file (a deflated ZIP entry, for example) normally
+ *  means setting up a decompressor and decompressing it from scratch, every
+ *  time. With this set, each mounted archive keeps up to (bytes) of small
+ *  compressed files fully decompressed after they're first opened, and
+ *  later opens of them read straight from that memory. When an archive's
+ *  cache is full, the files opened least recently are dropped first.
+ *
+ * Only files no bigger than a quarter of (bytes) are cached, and the first
+ *  open of each one decompresses the whole file up front. Files dropped from
+ *  the cache while they're still open stay in memory until they're closed.
+ *  Lowering this doesn't free anything already cached until that archive
+ *  caches something else, or is unmounted.
+ *
+ * PPK archives that store content hashes (extras/physfspack.c always does)
+ *  don't have a cache of their own: their compressed files go in one cache,
+ *  also up to (bytes), that every mounted archive shares, keyed by those
+ *  hashes. So a file that several archives ship, like an asset repeated in
+ *  every DLC pack, is decompressed once and kept in memory once, whichever
+ *  archive it's opened through. Each file's contents are checked against
+ *  its hash when it's cached. That hash isn't cryptographic, though, so
+ *  don't mount archives that might have been crafted to collide with
+ *  others while this is on.
+ *
+ * 7z archives decompress a whole solid block, or "folder," of files at a
+ *  time, and keep it around until the last open file in it is closed. With
+ *  this set, they keep up to (bytes) of folders per archive instead, open
+ *  files or not, dropping the least recently read folders first, and
+ *  decompressing them again if they're read after that. Folders bigger
+ *  than (bytes) aren't decompressed whole unless they have to be: they're
+ *  decompressed only as far as they've been read, so reading near the start
+ *  of a big one is quick, and reading one file after another through it
+ *  doesn't start it over each time.
+ *
+ * This is zero (no caching) by default, and may be set at any time, even
+ *  before PHYSFS_init().
+ *
+ *   \param bytes most bytes of decompressed data each archive may cache,
+ *                or zero to not cache any.
+ *
+ * \sa PHYSFS_openRead
+ */
+PHYSFS_DECL void PHYSFS_setDecompressionCacheSize(PHYSFS_uint64 bytes);
+
+
+/**
+ * \fn void PHYSFS_setCacheHugePages(int enable)
+ * \brief Put big decompression cache buffers on huge pages.
+ *
+ * Files and folders kept by PHYSFS_setDecompressionCacheSize() are often
+ *  megabytes each, and reading them at random through normal 4k pages costs
+ *  a TLB miss every few kilobytes. With this on, each cached buffer of 2
+ *  megabytes or more is allocated on huge pages where the OS allows it:
+ *  reserved huge pages or transparent ones on Linux, large pages on
+ *  Windows (which needs the "Lock pages in memory" privilege). Where it
+ *  can't, the buffer comes from the allocator as usual, so this never makes
+ *  anything fail.
+ *
+ * Memory from PHYSFS_setAllocator() is never bypassed: if you've set an
+ *  allocator, this does nothing.
+ *
+ * There's no separate NUMA setting. A cached buffer is filled by the
+ *  thread that decompresses it, and the OS puts pages on the node of the
+ *  thread that first touches them, so caches already end up near the
+ *  threads that read through them.
+ *
+ * This is off by default, and may be set at any time, even before
+ *  PHYSFS_init(). Buffers already cached stay where they are.
+ *
+ *   \param enable non-zero to use huge pages, zero to not.
+ *
+ * \sa PHYSFS_setDecompressionCacheSize
+ */
+PHYSFS_DECL void PHYSFS_setCacheHugePages(int enable);
+
+
+/**
+ * \fn void PHYSFS_setSectorCacheSize(PHYSFS_uint32 sectors)
+ * \brief Keep recently read sectors of disc images in memory.
+ *
+ * Each mounted disc image (an ISO9660 file) keeps the last (sectors)
+ *  2048-byte sectors it read small pieces of, so opening the same small
+ *  files again, getting their extended attributes with PHYSFS_stat(), and
+ *  reading a big file a little at a time don't each go back to the image.
+ *  This matters most for images on slow or network storage. Reads bigger
+ *  than a sector go straight to the image and aren't cached.
+ *
+ * This is 16 sectors (32 kilobytes per mounted image) by default, and may
+ *  be set at any time, even before PHYSFS_init(). A new value affects
+ *  images mounted after it's set.
+ *
+ *   \param sectors most sectors each mounted disc image may cache, or zero
+ *                  to not cache any.
+ *
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL void PHYSFS_setSectorCacheSize(PHYSFS_uint32 sectors);
+
+
+/**
+ * \fn void PHYSFS_setResolveOnMount(int enabled)
+ * \brief Do an archive's first-open work for every file when it's mounted.
+ *
+ * ZIP files keep a second header in front of each file's data, and the
+ *  first time a file is opened, PhysicsFS has to go read that header (and,
+ *  for symbolic links, the link) to find where the data really starts.
+ *  That's a little random I/O on the first open of every file, which adds
+ *  up on slow storage, and makes those first opens slower than the rest.
+ *
+ * With this enabled, ZIP files mounted afterwards have this done for all of
+ *  their files during PHYSFS_mount(), reading those headers in archive
+ *  order, many at a time, and spread over a few threads for archives with
+ *  lots of files. Opening files afterwards never has to go back to them.
+ *  Mounting takes longer, of course, and reads parts of the archive that
+ *  might never have been needed.
+ *
+ * Files found to be damaged along the way don't fail the mount; opening
+ *  them fails, just like it would have otherwise.
+ *
+ * This is disabled by default, and may be set at any time, even before
+ *  PHYSFS_init(). A new value affects archives mounted after it's set.
+ *
+ *   \param enabled non-zero to do the work at mount time, zero to do it
+ *                  when each file is first opened.
+ *
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL void PHYSFS_setResolveOnMount(int enabled);
+
+
+/**
+ * \fn int PHYSFS_setIndexCacheDir(const char *dir)
+ * \brief Keep snapshots of archives' directories, to mount them faster.
+ *
+ * Mounting an archive means reading and parsing its whole directory (a
+ *  ZIP's central directory, a 7z file's header, which is usually compressed
+ *  itself, an ISO's directory records, and so on), every time. With this
+ *  set, the first time an archive is mounted by path, with PHYSFS_mount(),
+ *  everything in it gets listed, and that list (with what PHYSFS_stat()
+ *  says about each file) is saved to a snapshot file in (dir).
+ *
+ * Later mounts of that same path, as long as the archive's size and
+ *  modification time haven't changed, use the snapshot instead, and don't
+ *  open the archive at all. Listing its directories,
+ *  PHYSFS_exists() and PHYSFS_stat() are answered from the snapshot. The
+ *  archive is opened for real, and its directory parsed like it would have
+ *  been when it was mounted, the first time a file in it is opened, if
+ *  that ever happens. So this pays off for archives only a few files are
+ *  read from, or none at all, early on. (Some archive types match names
+ *  more loosely than they list them, and for those, looking for something
+ *  the snapshot doesn't have opens the archive, too.)
+ *
+ * Where the platform can map files into memory, snapshots are mapped
+ *  read-only and used in place, never copied. Mounting from one is then
+ *  little more than opening it, and every process using the same (dir)
+ *  shares one copy of each snapshot in the OS's page cache, instead of
+ *  each keeping its own index of the archive. Mapped snapshots don't
+ *  count toward PHYSFS_getMemoryUsage(); ones that had to be read do.
+ *
+ * Snapshots are named for their archive's path, as it was passed to
+ *  PHYSFS_mount(), so mount archives by the same path each time, preferably
+ *  an absolute one. A snapshot that's out of date, damaged, or from a
+ *  different build of PhysicsFS is ignored, and replaced by a new one when
+ *  the archive's mounted. Failing to read or save a snapshot never fails
+ *  the mount. Snapshots are trusted otherwise, so (dir) shouldn't be
+ *  somewhere anyone else can write. Nothing ever deletes old snapshots;
+ *  that's up to you.
+ *
+ * Directories, and archives mounted with PHYSFS_mountIo(),
+ *  PHYSFS_mountMemory() or PHYSFS_mountHandle(), never get snapshots.
+ *
+ * This is NULL (no snapshots) by default. PhysicsFS must be initialized,
+ *  and (dir) must already exist. A new value affects archives mounted after
+ *  it's set.
+ *
+ *   \param dir directory to keep snapshots in, in platform-dependent
+ *              notation, or NULL to stop using them.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL int PHYSFS_setIndexCacheDir(const char *dir);
+
+
+/**
+ * \fn void PHYSFS_setWriteCompression(int enabled)
+ * \brief Compress files written into an archive.
+ *
+ * The write dir can be a ZIP file, instead of a directory: give
+ *  PHYSFS_setWriteDir() the path of one, and files written there go into
+ *  that archive, one after another, instead of each being a file of its own
+ *  on disk. That's much cheaper for lots of small files, like a cache.
+ *  A path that doesn't exist yet has to end in ".zip" to be made into one.
+ *
+ * Each file goes into the archive when it's closed, and the archive's
+ *  directory is written once, when the write dir is closed, by setting a
+ *  new one or by PHYSFS_deinit(). Until then, the archive isn't a valid ZIP
+ *  file, so don't mount it (or let anything else read it) while it's the
+ *  write dir. Only the new files and the directory are written, however
+ *  big the archive already is. Deleting or replacing a file that's already
+ *  in the archive leaves its old data in there, unused; the archive doesn't
+ *  shrink until PHYSFS_compactArchive() squeezes that out.
+ *
+ * With this enabled, files written into an archive are compressed as
+ *  they're written, which costs some CPU time. It's a quick compressor, not
+ *  a thorough one; for the best ratios, build the archive with a real ZIP
+ *  tool instead. Big files are compressed a megabyte at a time on several
+ *  threads at once. Files written to a plain directory are never
+ *  compressed.
+ *
+ * This is disabled by default, and may be set at any time, even before
+ *  PHYSFS_init(). A new value affects files opened for writing after it's
+ *  set.
+ *
+ *   \param enabled non-zero to compress files, zero to store them as-is.
+ *
+ * \sa PHYSFS_setWriteDir
+ * \sa PHYSFS_compactArchive
+ */
+PHYSFS_DECL void PHYSFS_setWriteCompression(int enabled);
+
+
+/**
+ * \fn int PHYSFS_readFilesBatch(PHYSFS_AsyncQueue *queue, const char **paths, void **buffers, const PHYSFS_uint64 *lens, PHYSFS_sint64 *results, PHYSFS_uint32 count)
+ * \brief Read many whole files at once.
+ *
+ * This opens each of (paths), reads up to (lens[i]) bytes from the start
+ *  of it into (buffers[i]), and closes it again, like PHYSFS_openRead(),
+ *  PHYSFS_readBytes() and PHYSFS_close() would, but does it all faster
+ *  than doing that a file at a time.
+ *
+ * Files in ZIP archives that fit in their buffers have their compressed
+ *  data read in order of where it is in the archive, several files at a
+ *  time, in big sequential reads, instead of jumping around the archive
+ *  for each one; so do files stored uncompressed in other archives. How
+ *  big those reads get is up to PHYSFS_setReadCoalescing(). If (queue) has
+ *  worker threads, they decompress that data while the next of it is read,
+ *  and read everything else (native files, other archives, and files that
+ *  don't fit their buffers) the usual way, all at once. Without (queue),
+ *  or if it has no threads, everything is done on the calling thread,
+ *  which still gets the sequential reads.
+ *
+ * Files in 7z archives are grouped by the solid block they're in, and each
+ *  block's files are read together, in the order they're stored, by one
+ *  thread. So each block is decompressed once, even if the decompression
+ *  cache budget couldn't otherwise hold it until they'd all been read.
+ *
+ * This waits until every file has been read, and up to 64 megabytes of
+ *  compressed data is held at a time while doing so. Nothing else should
+ *  use (queue) from other threads until this returns.
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue() to share the work
+ *                with, or NULL to do it all on this thread.
+ *   \param paths (count) files to read, in platform-independent notation.
+ *   \param buffers (count) buffers to read each of (paths) into.
+ *   \param lens size of each of (buffers), in bytes.
+ *   \param results receives, for each of (paths), what PHYSFS_readBytes()
+ *                  would have returned: the number of bytes read, or -1 if
+ *                  it couldn't be opened or read.
+ *   \param count number of elements in each of the arrays.
+ *  \return non-zero if every file was read, zero if any of them couldn't
+ *          be (see (results) for which), or on a problem before any of them
+ *          were read, in which case (results) isn't filled in. Specifics
+ *          of the error, for the first file that failed, can be gleaned
+ *          from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readBytes
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL int PHYSFS_readFilesBatch(PHYSFS_AsyncQueue *queue,
+                                      const char **paths, void **buffers,
+                                      const PHYSFS_uint64 *lens,
+                                      PHYSFS_sint64 *results,
+                                      PHYSFS_uint32 count);
+
+
+/**
+ * \fn int PHYSFS_prefetch(PHYSFS_AsyncQueue *queue, const char **paths, PHYSFS_uint32 count)
+ * \brief Get files ready to be read soon.
+ *
+ * This is a hint that (paths) are going to be read before long, so
+ *  PhysicsFS can do the slow part of opening them now, several at once.
+ *  Each path is looked up through the search path, and then whatever its
+ *  archive needs is done ahead of time:
+ *
+ *  - Data stored as-is, in a native file, a ZIP, an ISO or a similar
+ *    archive, is handed to the OS with PHYSFS_ACCESS_WILLNEED, so the OS
+ *    starts reading exactly that range of the file into its cache.
+ *  - A compressed ZIP entry is inflated into the ZIP's decompression
+ *    cache, if it fits.
+ *  - Each solid block, or "folder," of a 7z archive that (paths) are in
+ *    is decompressed whole and put in its archive's decompression cache,
+ *    if it fits.
+ *
+ * The caches need PHYSFS_setDecompressionCacheSize(); without it, only
+ *  the OS is told. If (queue) has worker threads, the files are opened,
+ *  and then the 7z folders decompressed, on them all at once; otherwise
+ *  it's all done on the calling thread.
+ *
+ * To have a whole archive ready right after mounting it, pass everything
+ *  in it. Only as much of each archive as fits in its cache is
+ *  decompressed, and what's cached already is left alone.
+ *
+ * This waits until it's done. Files that don't exist, or can't be opened
+ *  or decompressed, are skipped without complaint, and will fail the usual
+ *  way when they're really read. Nothing else should use (queue) from
+ *  other threads until this returns. Other threads may read from the same
+ *  7z archives meanwhile.
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue() to share the work
+ *                with, or NULL to do it all on this thread.
+ *   \param paths (count) files to get ready, in platform-independent
+ *                notation.
+ *   \param count number of elements in (paths).
+ *  \return non-zero on success, zero on a problem before anything was
+ *          done. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_setDecompressionCacheSize
+ * \sa PHYSFS_createAsyncQueue
+ */
+PHYSFS_DECL int PHYSFS_prefetch(PHYSFS_AsyncQueue *queue, const char **paths,
+                                PHYSFS_uint32 count);
+
+
+/**
+ * \struct PHYSFS_Stats
+ * \brief Counts of what PhysicsFS has been doing.
+ *
+ * Every field is a running total since PhysicsFS was first used, or since
+ *  the last PHYSFS_resetStats(). New fields may be added to the end of
+ *  this struct in later versions.
+ *
+ * \sa PHYSFS_getStats
+ */
+typedef struct PHYSFS_Stats
+{
+    PHYSFS_uint64 opens;  /**< files opened successfully. */
+    PHYSFS_uint64 openMisses;  /**< files not found by PHYSFS_openRead(). */
+    PHYSFS_uint64 bytesRead;  /**< bytes handed to the app by reads. */
+    PHYSFS_uint64 bytesReadPhysical;  /**< bytes read from the OS's files. */
+    PHYSFS_uint64 bytesDecompressedZip;  /**< bytes inflated from ZIPs. */
+    PHYSFS_uint64 bytesDecompressed7z;  /**< bytes decoded from 7zs. */
+    PHYSFS_uint64 bytesDecompressedRas;  /**< bytes inflated from RASs. */
+    PHYSFS_uint64 seeks;  /**< calls to PHYSFS_seek(). */
+    PHYSFS_uint64 zipBackwardSeeks;  /**< seeks back in compressed ZIP data. */
+    PHYSFS_uint64 folderDecodes7z;  /**< 7z folders decompressed. */
+    PHYSFS_uint64 bufferHits;  /**< buffered reads needing no i/o. */
+    PHYSFS_uint64 bufferMisses;  /**< buffered reads that went to i/o. */
+    PHYSFS_uint64 stateLockWaits;  /**< times a thread waited for the lock. */
+    PHYSFS_uint64 stateLockWaitNs;  /**< nanoseconds spent waiting for it. */
+    PHYSFS_uint64 spillHits;  /**< 7z folders loaded from the spill dir. */
+    PHYSFS_uint64 spillBytesWritten;  /**< bytes written to the spill dir. */
+    PHYSFS_uint64 inflatesOffloaded;  /**< ZIP entries a PHYSFS_Inflater did. */
+    PHYSFS_uint64 readsCoalesced;  /**< async reads merged with others. */
+    PHYSFS_uint64 asyncBytesCritical;  /**< OS bytes read for critical work. */
+    PHYSFS_uint64 asyncBytesVisible;  /**< ...for visible work. */
+    PHYSFS_uint64 asyncBytesPrefetch;  /**< ...for prefetch work. */
+    PHYSFS_uint64 throttleWaits;  /**< times workers waited for bandwidth. */
+    PHYSFS_uint64 throttleWaitNs;  /**< nanoseconds spent waiting for it. */
+} PHYSFS_Stats;
+
+
+/**
+ * \fn void PHYSFS_getStats(PHYSFS_Stats *stats)
+ * \brief Find out what PhysicsFS has been up to.
+ *
+ * This fills in (stats) with counts of opens, reads, decompression, seeks
+ *  and so on, to see what file access actually costs in a running program:
+ *  whether buffers are the right size, how much a ZIP's compression costs
+ *  over storing, how often threads fight over PhysicsFS's global lock,
+ *  and the like.
+ *
+ * Counting is always on, and cheap: each counter is bumped with a relaxed
+ *  atomic add. Counts are kept for all threads together. Each field is read
+ *  atomically, but they aren't read all at once, so they may disagree a
+ *  little if other threads are busy.
+ *
+ * "Logical" bytes (bytesRead) are what the app asked for and got;
+ *  "physical" bytes (bytesReadPhysical) are what PhysicsFS read from native
+ *  files to get them, archives included, so comparing them shows the
+ *  effect of compression and caching. Reads of memory-mapped files aren't
+ *  physical reads as far as this is concerned.
+ *
+ * This may be called at any time, even before PHYSFS_init().
+ *
+ *   \param stats receives the counters.
+ *
+ * \sa PHYSFS_resetStats
+ */
+PHYSFS_DECL void PHYSFS_getStats(PHYSFS_Stats *stats);
+
+
+/**
+ * \fn void PHYSFS_resetStats(void)
+ * \brief Start counting from zero again.
+ *
+ * This sets every counter PHYSFS_getStats() reports back to zero, so you
+ *  can measure one part of a program, like loading a level. Anything other
+ *  threads are counting while this runs is kept.
+ *
+ * \sa PHYSFS_getStats
+ */
+PHYSFS_DECL void PHYSFS_resetStats(void);
+
+
+/**
+ * \enum PHYSFS_MemoryCategory
+ * \brief What the memory PhysicsFS holds is for.
+ *
+ * \sa PHYSFS_getMemoryUsage
+ * \sa PHYSFS_setMemoryLimit
+ */
+typedef enum PHYSFS_MemoryCategory
+{
+    PHYSFS_MEMORY_INDEX,  /**< archives' tables of contents. */
+    PHYSFS_MEMORY_HANDLES,  /**< open files' own bookkeeping. */
+    PHYSFS_MEMORY_BUFFERS,  /**< read and write buffers, and read-ahead. */
+    PHYSFS_MEMORY_DECODERS,  /**< decompressors' state and windows. */
+    PHYSFS_MEMORY_CACHES,  /**< decompressed data and sectors kept around. */
+    PHYSFS_MEMORY_PINNED,  /**< files held by PHYSFS_pin(). */
+    PHYSFS_MEMORY_CATEGORIES  /**< how many there are; not a category. */
+} PHYSFS_MemoryCategory;
+
+
+/**
+ * \struct PHYSFS_MemoryUsage
+ * \brief How many bytes PhysicsFS is holding, by what they're for.
+ *
+ * New categories may be added in later versions, making this bigger.
+ *
+ * \sa PHYSFS_getMemoryUsage
+ */
+typedef struct PHYSFS_MemoryUsage
+{
+    PHYSFS_uint64 total;  /**< all of the categories added up. */
+    PHYSFS_uint64 bytes[PHYSFS_MEMORY_CATEGORIES];  /**< by category. */
+} PHYSFS_MemoryUsage;
+
+
+/**
+ * \fn int PHYSFS_getMemoryUsage(const char *dir, PHYSFS_MemoryUsage *usage)
+ * \brief Find out how much memory PhysicsFS is using, and what for.
+ *
+ * With (dir) NULL, this is everything PhysicsFS has counted: every mounted
+ *  archive and directory, the write dir, files open anywhere, and caches
+ *  that archives share. Otherwise it's only what belongs to (dir), named as
+ *  it was given to PHYSFS_mount(): its index, the files open from it, their
+ *  buffers and decompressors, and what it has cached. An archive mounted in
+ *  several contexts is shared, so it's only counted once, and each of its
+ *  mounts reports the same numbers.
+ *
+ * The counts cover the big things, not every allocation: archives' tables,
+ *  file handles, buffers, zlib and LZMA decoders, decompression caches and
+ *  disc sector caches. Small bookkeeping, and whatever external archivers
+ *  allocate, isn't counted. Some archivers' index sizes are estimates.
+ *
+ * Counts are kept with atomic adds and read the same way, so they may
+ *  disagree a little while other threads are busy. With (dir) NULL, this may
+ *  be called at any time, even before PHYSFS_init().
+ *
+ *   \param dir the archive or directory, as passed to PHYSFS_mount(), or
+ *              NULL for all of PhysicsFS.
+ *   \param usage receives the counts.
+ *  \return non-zero on success, zero if (dir) isn't mounted. Use
+ *          PHYSFS_getLastErrorCode() to obtain the specific error.
+ *
+ * \sa PHYSFS_setMemoryLimit
+ */
+PHYSFS_DECL int PHYSFS_getMemoryUsage(const char *dir,
+                                      PHYSFS_MemoryUsage *usage);
+
+
+/**
+ * \fn int PHYSFS_setMemoryLimit(PHYSFS_MemoryCategory category, PHYSFS_uint64 bytes)
+ * \brief Cap how much memory PhysicsFS uses for one thing.
+ *
+ * Limits only apply where PhysicsFS can do without the memory, so they make
+ *  things slower instead of failing:
+ *
+ *  - PHYSFS_MEMORY_CACHES: compressed files aren't decompressed into a cache
+ *    past the limit; they're read through a decompressor instead, and 7z
+ *    folders are decoded as they're read where that's possible. Caches over
+ *    the limit are trimmed, least recently used first, the next time they
+ *    are used. Disc images opened while over it keep fewer sectors, or none.
+ *  - PHYSFS_MEMORY_BUFFERS: adaptive buffers stop growing, and read-ahead
+ *    buffers stay the size they are. Buffers the app asks for with
+ *    PHYSFS_setBuffer() are always allocated.
+ *  - PHYSFS_MEMORY_DECODERS: ZIP archives stop keeping closed files'
+ *    decompressors around to reuse.
+ *
+ * There's nothing to do without an index or a file handle, and pinned files
+ *  are exactly what the app asked to keep, so limits on the other
+ *  categories fail with PHYSFS_ERR_UNSUPPORTED.
+ *
+ * Limits are on the totals for all of PhysicsFS, not each archive, and they
+ *  are checked when memory is about to be used, so nothing already allocated
+ *  is freed at once. Zero, the default, means no limit. This may be called
+ *  at any time, even before PHYSFS_init().
+ *
+ *   \param category what to limit.
+ *   \param bytes the most to use for it, or zero for no limit.
+ *  \return non-zero on success, zero on error. Use PHYSFS_getLastErrorCode()
+ *          to obtain the specific error.
+ *
+ * \sa PHYSFS_getMemoryUsage
+ */
+PHYSFS_DECL int PHYSFS_setMemoryLimit(PHYSFS_MemoryCategory category,
+                                      PHYSFS_uint64 bytes);
+
+
+/**
+ * \fn int PHYSFS_enableAccessProfile(int enable)
+ * \brief Record which files get read, in what order, and which parts.
+ *
+ * When this is on, PhysicsFS keeps a record, for each archive or directory
+ *  in the search path, of every file opened for reading from it: when it was
+ *  first opened, how often, how many bytes were read, and the spans of the
+ *  file those bytes came from (reads that carry on where the last one
+ *  stopped just lengthen its span). PHYSFS_writeAccessProfile() saves it.
+ *
+ * The point is to feed a packing tool: store an archive's entries in the
+ *  order a program first opens them, and loading a level from a cold disk
+ *  becomes one long sequential read instead of a lot of seeking.
+ *
+ * Turning this on throws away anything recorded before, and files that are
+ *  already open aren't recorded. Turning it off stops recording, but keeps
+ *  what was recorded until it's turned on again or PhysicsFS is deinit'd.
+ *
+ * This is for development builds: recording costs a mutex and an
+ *  allocation or two per read, and it makes reads on files with background
+ *  read-ahead wait for it (see PHYSFS_setAdaptiveBuffer()).
+ *
+ *   \param enable non-zero to start recording, zero to stop.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_writeAccessProfile
+ */
+PHYSFS_DECL int PHYSFS_enableAccessProfile(int enable);
+
+
+/**
+ * \enum PHYSFS_ProfileFormat
+ * \brief How PHYSFS_writeAccessProfile() writes what it knows.
+ *
+ * \sa PHYSFS_writeAccessProfile
+ */
+typedef enum PHYSFS_ProfileFormat
+{
+    PHYSFS_PROFILE_CSV,   /**< One line per span read from each file.  */
+    PHYSFS_PROFILE_JSON   /**< Mounts, each with its files and spans.  */
+} PHYSFS_ProfileFormat;
+
+
+/**
+ * \fn int PHYSFS_writeAccessProfile(const char *filename, PHYSFS_ProfileFormat fmt)
+ * \brief Save what PHYSFS_enableAccessProfile() has recorded.
+ *
+ * This writes (filename) in the write dir, replacing anything already
+ *  there. Files are grouped by the archive they came from, and listed in
+ *  the order they were first opened; the "order" of each counts up across
+ *  all archives, so you can tell which came first overall. Paths are the
+ *  ones inside the archive, without its mount point. Spans are listed in
+ *  the order they were read, as an offset into the file and a length.
+ *
+ * PHYSFS_PROFILE_CSV writes a header line, then one line per span:
+ *
+ * \code
+ * archive,mountpoint,order,path,opens,bytesread,offset,length
+ * "data/level1.zip","/",1,"maps/level1.map",1,4096,0,4096
+ * \endcode
+ *
+ * (A file that was opened but never read gets one line, with the last two
+ *  fields empty. Strings are always quoted.) PHYSFS_PROFILE_JSON writes an
+ *  object with a "mounts" array; each mount has "archive", "mountPoint" and
+ *  a "files" array, and each file has "order", "path", "opens", "bytesRead"
+ *  and "reads", an array of [offset, length] pairs.
+ *
+ * Archives unmounted since they were read from are still listed.
+ *
+ *   \param filename file to write, in platform-independent notation.
+ *   \param fmt PHYSFS_PROFILE_CSV or PHYSFS_PROFILE_JSON.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_enableAccessProfile
+ * \sa PHYSFS_setWriteDir
+ */
+PHYSFS_DECL int PHYSFS_writeAccessProfile(const char *filename,
+                                          PHYSFS_ProfileFormat fmt);
+
+
+/**
+ * \fn int PHYSFS_enablePredictivePrefetch(PHYSFS_AsyncQueue *queue, PHYSFS_uint32 lookahead)
+ * \brief Learn which files follow which, and prefetch them before they're asked for.
+ *
+ * While this is on, every file the app opens with PHYSFS_openRead() or
+ *  PHYSFS_openReadInterned() is noted as coming after the one opened before
+ *  it, and PhysicsFS keeps count of the few files that most often follow
+ *  each one. Then, when a file is opened, the file that usually comes next
+ *  is prefetched, and the one that usually comes after that, and so on, up
+ *  to (lookahead) files, as if they were passed to PHYSFS_prefetch(). That
+ *  warms the OS's cache, the ZIP decompression cache and 7z folders, just
+ *  as it does.
+ *
+ * Something has to have happened at least twice to be predicted, so a
+ *  sequence starts paying off the second time it's played. To start with
+ *  what earlier runs learned, PHYSFS_loadPrefetchModel() a file that
+ *  PHYSFS_writePrefetchModel() saved.
+ *
+ * The prefetches go to (queue) at PHYSFS_ASYNC_PREFETCH priority, so they
+ *  never hold up the open that triggered them, or anything more urgent on
+ *  the queue. A file that was prefetched isn't prefetched again until it
+ *  has been opened, or a few dozen other files have, and only so many are
+ *  queued at once. It's all a hint: a prefetch that fails is dropped
+ *  without complaint.
+ *
+ * Opens from all threads count as one sequence, so this works best when
+ *  one thread does the loading. Opens made by PhysicsFS itself, like
+ *  PHYSFS_prefetch()'s, aren't learned.
+ *
+ * Destroying (queue) turns this off. Queued prefetches still run, in the
+ *  context that made them, so destroy the queue before destroying that
+ *  context, or calling PHYSFS_deinit().
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue(), which needs worker
+ *                threads, to do the prefetching on.
+ *   \param lookahead how many files ahead to prefetch, up to 16, or zero
+ *                    to stop learning and prefetching. What was learned is
+ *                    kept until PHYSFS_deinit().
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_prefetch
+ * \sa PHYSFS_writePrefetchModel
+ * \sa PHYSFS_loadPrefetchModel
+ */
+PHYSFS_DECL int PHYSFS_enablePredictivePrefetch(PHYSFS_AsyncQueue *queue,
+                                                PHYSFS_uint32 lookahead);
+
+
+/**
+ * \fn int PHYSFS_writePrefetchModel(const char *filename)
+ * \brief Save what PHYSFS_enablePredictivePrefetch() has learned.
+ *
+ * This writes (filename) in the write dir, replacing anything already
+ *  there, as CSV: a header line, then one line for each file and a file
+ *  that follows it, with how many times it did.
+ *
+ * \code
+ * count,from,to
+ * 12,"maps/level1.map","textures/level1.pak"
+ * \endcode
+ *
+ *   \param filename file to write, in platform-independent notation.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_loadPrefetchModel
+ * \sa PHYSFS_setWriteDir
+ */
+PHYSFS_DECL int PHYSFS_writePrefetchModel(const char *filename);
+
+
+/**
+ * \fn int PHYSFS_loadPrefetchModel(const char *filename)
+ * \brief Add what PHYSFS_writePrefetchModel() saved to what's been learned.
+ *
+ * (filename) is read from the search path. Its counts are added to the
+ *  ones PHYSFS_enablePredictivePrefetch() has, so loading one profile
+ *  after another, or the same one twice, weighs them together. This can
+ *  be done whether prediction is on or not. The file can be written by
+ *  hand, too: the paths are the ones PHYSFS_openRead() would take.
+ *
+ *   \param filename file to read, in platform-independent notation.
+ *  \return nonzero on success, zero on error. If the file has a bad line,
+ *          this fails with PHYSFS_ERR_CORRUPT, but the lines before it are
+ *          still learned. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_writePrefetchModel
+ * \sa PHYSFS_enablePredictivePrefetch
+ */
+PHYSFS_DECL int PHYSFS_loadPrefetchModel(const char *filename);
+
+
+/**
+ * \enum PHYSFS_TraceEvent
+ * \brief What a PHYSFS_TraceInfo is about.
+ *
+ * \sa PHYSFS_TraceInfo
+ * \sa PHYSFS_setTraceHooks
+ */
+typedef enum PHYSFS_TraceEvent
+{
+    PHYSFS_TRACE_MOUNT,       /**< PHYSFS_mount() and friends.             */
+    PHYSFS_TRACE_OPENREAD,    /**< PHYSFS_openRead().                      */
+    PHYSFS_TRACE_READ,        /**< PHYSFS_readBytes(), readAt(), readv().   */
+    PHYSFS_TRACE_SEEK,        /**< PHYSFS_seek().                          */
+    PHYSFS_TRACE_ENUMERATE,   /**< PHYSFS_enumerateFilesCallback(), etc.   */
+    PHYSFS_TRACE_DECOMPRESS,  /**< An archiver decompressing data.          */
+    PHYSFS_TRACE_STAT,        /**< PHYSFS_stat() and PHYSFS_exists().      */
+    PHYSFS_TRACE_CLOSE        /**< PHYSFS_close() of a read handle.        */
+} PHYSFS_TraceEvent;
+
+
+/**
+ * \struct PHYSFS_TraceInfo
+ * \brief One event passed to PHYSFS_TraceHooks.
+ *
+ * (bytes) depends on the event: for PHYSFS_TRACE_READ and
+ *  PHYSFS_TRACE_DECOMPRESS, it's how many bytes were asked for at the
+ *  beginning, and how many came out at the end (-1 on error). For
+ *  PHYSFS_TRACE_SEEK, it's the position sought, both times. It's zero for
+ *  everything else.
+ *
+ * (offset) is where a PHYSFS_readAt() read from, and -1 for everything else.
+ *
+ * A PHYSFS_TRACE_CLOSE's handle is gone by the time it ends, so (path) is
+ *  NULL at its end; the pointer in (file) is only good for matching it up.
+ *
+ * \sa PHYSFS_setTraceHooks
+ */
+typedef struct PHYSFS_TraceInfo
+{
+    PHYSFS_TraceEvent event;  /**< What's happening. */
+    const char *path;  /**< File, dir or archive it's happening to, or NULL. */
+    PHYSFS_File *file;  /**< Handle it's happening to, or NULL. */
+    PHYSFS_sint64 bytes;  /**< Byte count, as described above. */
+    int success;  /**< Non-zero at the beginning, or if it worked. */
+    PHYSFS_sint64 offset;  /**< PHYSFS_readAt()'s offset, as described above. */
+} PHYSFS_TraceInfo;
+
+
+/**
+ * \typedef PHYSFS_TraceCallback
+ * \brief Function signature for PHYSFS_TraceHooks' members.
+ *
+ * (data) is the PHYSFS_TraceHooks' data field. (info) and the strings it
+ *  points to are only good until this returns.
+ *
+ * These are called from whatever thread did the work, sometimes with
+ *  PhysicsFS's locks held, so they must be quick, thread safe, and must not
+ *  call into PhysicsFS.
+ *
+ * \sa PHYSFS_TraceHooks
+ */
+typedef void (*PHYSFS_TraceCallback)(void *data, const PHYSFS_TraceInfo *info);
+
+
+/**
+ * \struct PHYSFS_TraceHooks
+ * \brief Functions to tell an external profiler what PhysicsFS is doing.
+ *
+ * (begin) is called when an event starts, and (end) when it's done, on the
+ *  same thread, so they map straight onto the zones or slices a profiler
+ *  like Tracy or Perfetto draws on its timeline. Events nest: a
+ *  PHYSFS_TRACE_DECOMPRESS happens inside the PHYSFS_TRACE_READ that
+ *  needed it, and so on.
+ *
+ * \sa PHYSFS_setTraceHooks
+ */
+typedef struct PHYSFS_TraceHooks
+{
+    PHYSFS_TraceCallback begin;  /**< An event is starting. */
+    PHYSFS_TraceCallback end;  /**< An event is over. */
+    void *data;  /**< Passed to both, as is. */
+} PHYSFS_TraceHooks;
+
+
+/**
+ * \fn void PHYSFS_setTraceHooks(const PHYSFS_TraceHooks *hooks)
+ * \brief Have PhysicsFS report where its time goes.
+ *
+ * Mounting, opening, reading, seeking, enumerating, stats, closes and
+ *  decompressing in archives are reported to (hooks) as begin and end
+ *  events; see
+ *  PHYSFS_TraceHooks. Pass NULL to stop. (hooks) is copied, so it doesn't
+ *  have to stick around.
+ *
+ * Handles opened while hooks are set remember their path, so reads and
+ *  seeks on them have one to report; ones opened before only report the
+ *  handle.
+ *
+ * This may be called before PHYSFS_init(), but not while other threads are
+ *  using PhysicsFS.
+ *
+ *   \param hooks functions to call, or NULL to stop.
+ *
+ * \sa PHYSFS_TraceHooks
+ */
+PHYSFS_DECL void PHYSFS_setTraceHooks(const PHYSFS_TraceHooks *hooks);
+
+
+/**
+ * \enum PHYSFS_LatencyOp
+ * \brief Operations PHYSFS_getLatency() can report on.
+ *
+ * \sa PHYSFS_getLatency
+ */
+typedef enum PHYSFS_LatencyOp
+{
+    PHYSFS_LATENCY_OPENREAD,  /**< PHYSFS_openRead().   */
+    PHYSFS_LATENCY_READ,      /**< PHYSFS_readBytes().  */
+    PHYSFS_LATENCY_STAT       /**< PHYSFS_stat().       */
+} PHYSFS_LatencyOp;
+
+
+/**
+ * \struct PHYSFS_Latency
+ * \brief How long an operation has been taking.
+ *
+ * All times are in nanoseconds. Percentiles are accurate to within about
+ *  an eighth of their value, and never under; (max) is exact.
+ *
+ * \sa PHYSFS_getLatency
+ */
+typedef struct PHYSFS_Latency
+{
+    PHYSFS_uint64 count;  /**< How many times it was timed. */
+    PHYSFS_uint64 p50;  /**< Half took no longer than this. */
+    PHYSFS_uint64 p99;  /**< 99% took no longer than this. */
+    PHYSFS_uint64 p999;  /**< 99.9% took no longer than this. */
+    PHYSFS_uint64 max;  /**< The longest it took. */
+} PHYSFS_Latency;
+
+
+/**
+ * \fn int PHYSFS_enableLatencyHistograms(int enable)
+ * \brief Start or stop timing opens, reads and stats.
+ *
+ * While this is on, every PHYSFS_openRead(), PHYSFS_readBytes() and
+ *  PHYSFS_stat() is timed, and the time goes in a histogram for that
+ *  operation and the archiver that did the work. Use PHYSFS_getLatency()
+ *  to get percentiles out, say to send to telemetry and spot when a new
+ *  archive format or mount order makes loading slower.
+ *
+ * Each thread keeps its own histograms, so timing costs no locks, just two
+ *  clock reads per call. PHYSFS_getLatency() adds every thread's together.
+ *  Nothing's thrown away when this is turned off; see PHYSFS_resetLatency().
+ *
+ * This needs thread-local storage from the platform; without it, nothing
+ *  is timed.
+ *
+ *   \param enable non-zero to start timing, zero to stop.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_getLatency
+ * \sa PHYSFS_resetLatency
+ */
+PHYSFS_DECL int PHYSFS_enableLatencyHistograms(int enable);
+
+
+/**
+ * \fn int PHYSFS_getLatency(PHYSFS_LatencyOp op, const char *ext, PHYSFS_Latency *lat)
+ * \brief Get percentiles of how long an operation has been taking.
+ *
+ * (ext) picks the archiver, by its PHYSFS_ArchiveInfo::extension, like
+ *  "ZIP"; case doesn't matter. Real directories are "". Pass NULL to get
+ *  every call together, including ones that didn't find anything to
+ *  open or stat, which don't count against any archiver.
+ *
+ * If nothing matching was timed, this succeeds with (lat) all zeros.
+ *
+ *   \param op which operation.
+ *   \param ext archiver's extension, or NULL for all of them.
+ *   \param lat receives the numbers.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_enableLatencyHistograms
+ */
+PHYSFS_DECL int PHYSFS_getLatency(PHYSFS_LatencyOp op, const char *ext,
+                                  PHYSFS_Latency *lat);
+
+
+/**
+ * \fn void PHYSFS_resetLatency(void)
+ * \brief Empty every latency histogram.
+ *
+ * Calls that finish while this runs might still count.
+ *
+ * \sa PHYSFS_getLatency
+ */
+PHYSFS_DECL void PHYSFS_resetLatency(void);
+
+
+/**
+ * \fn int PHYSFS_getFileBacking(PHYSFS_File *handle, PHYSFS_FileBacking *backing)
+ * \brief Find the OS file that holds an open file's bytes, as-is.
+ *
+ * Loose files in a real directory, stored (uncompressed, unencrypted)
+ *  entries in a .zip, and entries in the uncompressed formats (.grp, .pak,
+ *  .wad, etc) are just a run of bytes inside some file on disk. For those,
+ *  this reports the OS file descriptor (or HANDLE, on Windows), where the
+ *  file starts in it and how long it is, so the OS can copy it somewhere
+ *  else without it passing through your buffers: a web server can hand it
+ *  straight to sendfile() or TransmitFile(), for example.
+ *
+ * The descriptor belongs to PhysicsFS and stays open until (handle) is
+ *  closed; don't close it. Read it with calls that take an explicit offset
+ *  (pread(), sendfile() with an offset, etc); it may be shared with other
+ *  open files, so anything that moves its file position (read(), lseek(),
+ *  TransmitFile()...) can confuse reads from PhysicsFS. The file position
+ *  of (handle) isn't changed.
+ *
+ * This is an optimization and can fail for any file (compressed data,
+ *  archives in memory, platforms without the means...); when it does, read
+ *  the file normally. The file must be opened for reading.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param backing On success, receives where the file's bytes are.
+ *  \return non-zero on success, zero if there's no such file. Specifics
+ *          of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mapRead
+ */
+PHYSFS_DECL int PHYSFS_getFileBacking(PHYSFS_File *handle,
+                                      PHYSFS_FileBacking *backing);
+
+
+/**
+ * \enum PHYSFS_Encoding
+ * \brief How the bytes from PHYSFS_openReadRaw() are encoded.
+ *
+ * \sa PHYSFS_openReadRaw
+ */
+typedef enum PHYSFS_Encoding
+{
+    PHYSFS_ENCODING_IDENTITY,  /**< Not at all; it's the file itself. */
+    PHYSFS_ENCODING_DEFLATE,   /**< Raw deflate data (RFC 1951), no header. */
+    PHYSFS_ENCODING_ZSTD,      /**< A Zstandard frame (RFC 8878). */
+    PHYSFS_ENCODING_LZ4,       /**< An LZ4 frame. */
+    PHYSFS_ENCODING_OTHER      /**< Something else; PHYSFS_statLayout() only. */
+} PHYSFS_Encoding;
+
+
+/**
+ * \fn PHYSFS_File *PHYSFS_openReadRaw(const char *filename, PHYSFS_Encoding *encoding)
+ * \brief Open a file for reading, compressed if that's how it's stored.
+ *
+ * This opens (filename) like PHYSFS_openRead(), but if the file is stored
+ *  compressed in a format other programs understand (a deflated .zip
+ *  entry, say), the handle reads the compressed bytes straight out of the
+ *  archive instead of decompressing them. (*encoding) says which you got.
+ *  A web server, for example, can send a deflated entry to a client that
+ *  takes "Content-Encoding: deflate" without inflating it first.
+ *
+ * When you get compressed data, PHYSFS_fileLength() and PHYSFS_seek() are
+ *  about the compressed bytes. Anything that isn't stored in a useful
+ *  compressed form opens just like PHYSFS_openRead() would, with
+ *  PHYSFS_ENCODING_IDENTITY.
+ *
+ *   \param filename File to open.
+ *   \param encoding Receives a PHYSFS_Encoding for the bytes you'll read.
+ *  \return A valid PhysicsFS filehandle on success, NULL on error. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openRead
+ */
+PHYSFS_DECL PHYSFS_File *PHYSFS_openReadRaw(const char *filename,
+                                           PHYSFS_Encoding *encoding);
+
+
+/**
+ * \struct PHYSFS_EntryLayout
+ * \brief Where a file's data physically is, from PHYSFS_statLayout().
+ *
+ * \sa PHYSFS_statLayout
+ */
+typedef struct PHYSFS_EntryLayout
+{
+    const char *mount;  /**< what PHYSFS_getRealDir() says it's in. */
+    PHYSFS_uint64 offset;  /**< where its stored bytes start in (mount). */
+    PHYSFS_uint64 storedSize;  /**< how many stored bytes there are. */
+    PHYSFS_uint64 size;  /**< its size once decoded: PHYSFS_Stat::filesize. */
+    PHYSFS_Encoding encoding;  /**< how the stored bytes are encoded. */
+    PHYSFS_uint32 method;  /**< the archive format's own id for that. */
+    PHYSFS_sint64 group;  /**< what it's decoded with, or -1; see below. */
+    PHYSFS_uint64 groupOffset;  /**< where it starts in (group), decoded. */
+} PHYSFS_EntryLayout;
+
+
+/**
+ * \fn int PHYSFS_statLayout(const char *filename, PHYSFS_EntryLayout *layout)
+ * \brief Find out where a file's data is stored.
+ *
+ * This tells you where (filename), as PHYSFS_openRead() would find it,
+ *  physically lives, so a streamer that sorts and merges its own requests
+ *  can put reads of one archive in order of where they are in it, instead
+ *  of leaving that to PHYSFS_readAsync(). Reading those bytes yourself is
+ *  only as good as your understanding of (encoding), though.
+ *
+ * (offset) is from the start of the archive as PhysicsFS reads it: the file
+ *  named by (mount), or, for archives mounted with PHYSFS_mountIo() and the
+ *  like, what you gave it. (storedSize) bytes from there are the file's
+ *  data, encoded as (encoding) says; (method) is the archive's own number
+ *  for that, like 8 for a deflated ZIP entry. For a file in a native
+ *  directory, (mount) is the directory, and the file is its own storage,
+ *  from offset zero.
+ *
+ * Some archives, like "solid" 7z ones, compress files together, and a file
+ *  can only be decoded by decoding the group it's in from the start. Files
+ *  with the same (group) are in the same one, which starts at (offset) and
+ *  takes (storedSize) bytes; this file is at (groupOffset) once that's
+ *  decoded. A (group) of -1 means the file is stored on its own.
+ *
+ * (mount) stays valid until that archive is unmounted.
+ *
+ *   \param filename File to look up, in platform-independent notation.
+ *   \param layout Receives where it is.
+ *  \return non-zero on success, zero on failure: the file doesn't exist,
+ *          is a directory, or is somewhere that doesn't say, like a
+ *          PHYSFS_createRamDir() directory (PHYSFS_ERR_UNSUPPORTED). Use
+ *          PHYSFS_getLastErrorCode() to find out which.
+ *
+ * \sa PHYSFS_stat
+ * \sa PHYSFS_getRealDir
+ * \sa PHYSFS_openReadRaw
+ */
+PHYSFS_DECL int PHYSFS_statLayout(const char *filename,
+                                  PHYSFS_EntryLayout *layout);
+
+
+/**
+ * \fn void PHYSFS_enumerateFilesPrefixCallback(const char *dir, const char *prefix, PHYSFS_EnumFilesCallback c, void *d)
+ * \brief Enumerate only the names in a directory that start with a prefix.
+ *
+ * This is PHYSFS_enumerateFilesCallback(), except only names that start
+ *  with (prefix) are reported. The comparison ignores the case of ASCII
+ *  letters, like the archives that don't keep case do; if you need the
+ *  case to match too, check that in your callback. Ordering and duplicates
+ *  are as for PHYSFS_enumerateFilesCallback().
+ *
+ * Archives that keep their names sorted can find the matches without
+ *  looking at the rest of the directory, so asking for "ui_" in a
+ *  directory of thousands of textures can cost a handful of lookups
+ *  instead of a callback for every file. Elsewhere, PhysicsFS just filters
+ *  the names before they get to you.
+ *
+ *    \param dir Directory, in platform-independent notation, to enumerate.
+ *    \param prefix What the names must start with. This can't have a '/'
+ *                  in it. An empty string reports everything.
+ *    \param c Callback function to notify about each matching name.
+ *    \param d Application-defined data passed to callback. Can be NULL.
+ *
+ * \sa PHYSFS_enumerateFilesCallback
+ */
+PHYSFS_DECL void PHYSFS_enumerateFilesPrefixCallback(const char *dir,
+                                                 const char *prefix,
+                                                 PHYSFS_EnumFilesCallback c,
+                                                 void *d);
+
+
+/**
+ * \fn int PHYSFS_caseFold(const PHYSFS_uint32 from, PHYSFS_uint32 *to)
+ * \brief Fold a Unicode codepoint, the way PhysicsFS compares names.
+ *
+ * Archives that don't keep case find their names by comparing them with
+ *  their case folded away; this is what each codepoint folds to. Fold
+ *  every codepoint of two strings and they're the same, ignoring case,
+ *  when the results are the same. Most codepoints fold to themselves, or
+ *  to one other codepoint ('A' to 'a'), but a few fold to more than one
+ *  (U+00DF, "sharp s", folds to "ss").
+ *
+ *   \param from The codepoint to fold.
+ *   \param to Receives the folded codepoints. This needs room for three.
+ *  \return How many codepoints were written to (to): 1, 2 or 3.
+ *
+ * \sa PHYSFS_utf8ToUcs4
+ */
+PHYSFS_DECL int PHYSFS_caseFold(const PHYSFS_uint32 from, PHYSFS_uint32 *to);
+
+
+/**
+ * \fn PHYSFS_uint32 PHYSFS_getSearchPathGeneration(void)
+ * \brief Find out if the search path might look different than it did.
+ *
+ * This number changes whenever what's in the search path might have: on
+ *  every mount and unmount, whenever PhysicsFS writes, creates or deletes
+ *  anything, on PHYSFS_invalidateCache(), and on every change that
+ *  PHYSFS_setChangeCallback() hears about. It's the same events that make
+ *  PhysicsFS forget what it remembers about the search path.
+ *
+ * If you build something of your own from enumerating the search path, a
+ *  table of names, say, keep the number you got when you built it. As long
+ *  as this still returns the same number, it's up to date, as far as
+ *  PhysicsFS knows. It's cheap to call.
+ *
+ *  \return An arbitrary number, only good for comparing with another one
+ *          from this function.
+ *
+ * \sa PHYSFS_invalidateCache
+ * \sa PHYSFS_setChangeCallback
+ */
+PHYSFS_DECL PHYSFS_uint32 PHYSFS_getSearchPathGeneration(void);
+
+
+/**
+ * \struct PHYSFS_Path
+ * \brief A path that's been prepared once for repeated lookups.
+ *
+ * This is opaque; you get one from PHYSFS_internPath() and give it back
+ *  with PHYSFS_freePath().
+ *
+ * \sa PHYSFS_internPath
+ * \sa PHYSFS_openReadInterned
+ * \sa PHYSFS_statInterned
+ */
+typedef struct PHYSFS_Path PHYSFS_Path;
+
+
+/**
+ * \fn PHYSFS_Path *PHYSFS_internPath(const char *path)
+ * \brief Prepare a path for looking up over and over.
+ *
+ * Every PHYSFS_openRead() and PHYSFS_stat() call has to check and clean up
+ *  the path it's given, and hash it for the search path index and the miss
+ *  cache, before it can look for anything. If you look up the same paths
+ *  again and again (every time a level loads, say), do that work once with
+ *  this, and use PHYSFS_openReadInterned() and PHYSFS_statInterned().
+ *
+ * The result doesn't remember where the file was found, so it stays good
+ *  across mounts and unmounts; the search path is still searched each time,
+ *  just with less work up front. You can use the same one from several
+ *  threads at once.
+ *
+ * Free it with PHYSFS_freePath() when you're done, before PHYSFS_deinit().
+ *
+ *   \param path a path, in platform-independent notation, the same as you'd
+ *               give PHYSFS_openRead().
+ *  \return a new handle, or NULL if (path) isn't valid or there was some
+ *          other error. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_freePath
+ * \sa PHYSFS_openReadInterned
+ * \sa PHYSFS_statInterned
+ */
+PHYSFS_DECL PHYSFS_Path *PHYSFS_internPath(const char *path);
+
+
+/**
+ * \fn void PHYSFS_freePath(PHYSFS_Path *path)
+ * \brief Free a path from PHYSFS_internPath().
+ *
+ *   \param path the path to free. NULL is ignored.
+ *
+ * \sa PHYSFS_internPath
+ */
+PHYSFS_DECL void PHYSFS_freePath(PHYSFS_Path *path);
+
+
+/**
+ * \fn PHYSFS_File *PHYSFS_openReadInterned(const PHYSFS_Path *path)
+ * \brief Open a file for reading, by a path from PHYSFS_internPath().
+ *
+ * This is exactly PHYSFS_openRead(), without preparing the path again.
+ *
+ *   \param path the file to open, from PHYSFS_internPath().
+ *  \return A valid PhysicsFS filehandle on success, NULL on error. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openRead
+ * \sa PHYSFS_internPath
+ */
+PHYSFS_DECL PHYSFS_File *PHYSFS_openReadInterned(const PHYSFS_Path *path);
+
+
+/**
+ * \fn int PHYSFS_statInterned(const PHYSFS_Path *path, PHYSFS_Stat *stat)
+ * \brief Get information about a file, by a path from PHYSFS_internPath().
+ *
+ * This is exactly PHYSFS_stat(), without preparing the path again.
+ *
+ *   \param path the file to check, from PHYSFS_internPath().
+ *   \param stat pointer to structure to fill in with data about (path).
+ *  \return non-zero on success, zero on failure. On failure, the reason can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_stat
+ * \sa PHYSFS_internPath
+ */
+PHYSFS_DECL int PHYSFS_statInterned(const PHYSFS_Path *path,
+                                    PHYSFS_Stat *stat);
+
+
+/**
+ * \struct PHYSFS_Entry
+ * \brief Where a file was found in the search path.
+ *
+ * This is opaque; you get one from PHYSFS_lookup() and give it back with
+ *  PHYSFS_freeEntry().
+ *
+ * \sa PHYSFS_lookup
+ * \sa PHYSFS_openEntry
+ * \sa PHYSFS_statEntry
+ */
+typedef struct PHYSFS_Entry PHYSFS_Entry;
+
+
+/**
+ * \fn PHYSFS_Entry *PHYSFS_lookup(const char *filename)
+ * \brief Find a file in the search path once, to use over and over.
+ *
+ * This does the work PHYSFS_stat() does to find (filename), and remembers
+ *  which archive had it. PHYSFS_openEntry() and PHYSFS_statEntry() then go
+ *  straight to that archive, without searching the search path again. A
+ *  resource manager that reloads the same files can keep these instead of
+ *  path strings.
+ *
+ * An entry sticks with the archive it was found in until that archive is
+ *  unmounted. It doesn't notice if something mounted later would now win
+ *  for (filename); look it up again if that matters (the number from
+ *  PHYSFS_getSearchPathGeneration() changing is a good hint). After its
+ *  archive is unmounted, using an entry fails with PHYSFS_ERR_NOT_MOUNTED,
+ *  even if the same archive is mounted again.
+ *
+ * Free it with PHYSFS_freeEntry() when you're done, before PHYSFS_deinit().
+ *  You can use the same entry from several threads at once.
+ *
+ *   \param filename file to look for, in platform-independent notation.
+ *  \return a new entry, or NULL if it wasn't found or there was some other
+ *          error. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_freeEntry
+ * \sa PHYSFS_openEntry
+ * \sa PHYSFS_statEntry
+ */
+PHYSFS_DECL PHYSFS_Entry *PHYSFS_lookup(const char *filename);
+
+
+/**
+ * \fn void PHYSFS_freeEntry(PHYSFS_Entry *entry)
+ * \brief Free an entry from PHYSFS_lookup().
+ *
+ *   \param entry the entry to free. NULL is ignored.
+ *
+ * \sa PHYSFS_lookup
+ */
+PHYSFS_DECL void PHYSFS_freeEntry(PHYSFS_Entry *entry);
+
+
+/**
+ * \fn PHYSFS_File *PHYSFS_openEntry(const PHYSFS_Entry *entry)
+ * \brief Open a file from PHYSFS_lookup() for reading.
+ *
+ * This is PHYSFS_openRead(), straight from the archive the file was found
+ *  in. Directories that only lead to a mount point fail with
+ *  PHYSFS_ERR_NOT_A_FILE.
+ *
+ *   \param entry the file to open, from PHYSFS_lookup().
+ *  \return A valid PhysicsFS filehandle on success, NULL on error. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openRead
+ * \sa PHYSFS_lookup
+ */
+PHYSFS_DECL PHYSFS_File *PHYSFS_openEntry(const PHYSFS_Entry *entry);
+
+
+/**
+ * \fn int PHYSFS_statEntry(const PHYSFS_Entry *entry, PHYSFS_Stat *stat)
+ * \brief Get information about a file from PHYSFS_lookup().
+ *
+ * This is PHYSFS_stat(), straight from the archive the file was found in.
+ *
+ *   \param entry the file to check, from PHYSFS_lookup().
+ *   \param stat pointer to structure to fill in with data about (entry).
+ *  \return non-zero on success, zero on failure. On failure, the reason can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_stat
+ * \sa PHYSFS_lookup
+ */
+PHYSFS_DECL int PHYSFS_statEntry(const PHYSFS_Entry *entry, PHYSFS_Stat *stat);
+
+
+/**
+ * \fn void PHYSFS_swapArrayULE16(PHYSFS_uint16 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 16-bit little-endian values to native order, in place.
+ *
+ * Every value in (vals) is converted from little-endian to the platform's
+ *  native byte order, in place. This is PHYSFS_swapULE16() on each
+ *  element, but a good deal faster on a large array. On a little-endian
+ *  platform, this does nothing.
+ *
+ * Arrays of signed values can be cast and passed here too.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapULE16
+ * \sa PHYSFS_readULE16Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayULE16(PHYSFS_uint16 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn void PHYSFS_swapArrayUBE16(PHYSFS_uint16 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 16-bit big-endian values to native order, in place.
+ *
+ * This is PHYSFS_swapArrayULE16() for big-endian, 16-bit values.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapUBE16
+ * \sa PHYSFS_readUBE16Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayUBE16(PHYSFS_uint16 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn void PHYSFS_swapArrayULE32(PHYSFS_uint32 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 32-bit little-endian values to native order, in place.
+ *
+ * This is PHYSFS_swapArrayULE16() for little-endian, 32-bit values.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapULE32
+ * \sa PHYSFS_readULE32Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayULE32(PHYSFS_uint32 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn void PHYSFS_swapArrayUBE32(PHYSFS_uint32 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 32-bit big-endian values to native order, in place.
+ *
+ * This is PHYSFS_swapArrayULE16() for big-endian, 32-bit values.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapUBE32
+ * \sa PHYSFS_readUBE32Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayUBE32(PHYSFS_uint32 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn void PHYSFS_swapArrayULE64(PHYSFS_uint64 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 64-bit little-endian values to native order, in place.
+ *
+ * This is PHYSFS_swapArrayULE16() for little-endian, 64-bit values.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapULE64
+ * \sa PHYSFS_readULE64Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayULE64(PHYSFS_uint64 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn void PHYSFS_swapArrayUBE64(PHYSFS_uint64 *vals, PHYSFS_uint64 count)
+ * \brief Swap unsigned 64-bit big-endian values to native order, in place.
+ *
+ * This is PHYSFS_swapArrayULE16() for big-endian, 64-bit values.
+ *
+ *    \param vals values to convert, in place. NULL is ignored.
+ *    \param count number of values in (vals).
+ *
+ * \sa PHYSFS_swapUBE64
+ * \sa PHYSFS_readUBE64Array
+ */
+PHYSFS_DECL void PHYSFS_swapArrayUBE64(PHYSFS_uint64 *vals,
+                                        PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readULE16Array(PHYSFS_File *file, PHYSFS_uint16 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 16-bit little-endian values.
+ *
+ * Convenience function. Read (count) unsigned 16-bit little-endian values
+ *  from a file with a single read, and convert them to the platform's
+ *  native byte order. This is much faster than calling PHYSFS_readULE16()
+ *  in a loop.
+ *
+ * If the file ends partway through a value, that value is not stored, and
+ *  the file position is left at its start. Arrays of signed values can be
+ *  cast and passed here too.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readULE16
+ * \sa PHYSFS_swapArrayULE16
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readULE16Array(PHYSFS_File *file,
+                                           PHYSFS_uint16 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readUBE16Array(PHYSFS_File *file, PHYSFS_uint16 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 16-bit big-endian values.
+ *
+ * This is PHYSFS_readULE16Array() for big-endian, 16-bit values.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readUBE16
+ * \sa PHYSFS_swapArrayUBE16
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readUBE16Array(PHYSFS_File *file,
+                                           PHYSFS_uint16 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readULE32Array(PHYSFS_File *file, PHYSFS_uint32 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 32-bit little-endian values.
+ *
+ * This is PHYSFS_readULE16Array() for little-endian, 32-bit values.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readULE32
+ * \sa PHYSFS_swapArrayULE32
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readULE32Array(PHYSFS_File *file,
+                                           PHYSFS_uint32 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readUBE32Array(PHYSFS_File *file, PHYSFS_uint32 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 32-bit big-endian values.
+ *
+ * This is PHYSFS_readULE16Array() for big-endian, 32-bit values.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readUBE32
+ * \sa PHYSFS_swapArrayUBE32
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readUBE32Array(PHYSFS_File *file,
+                                           PHYSFS_uint32 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readULE64Array(PHYSFS_File *file, PHYSFS_uint64 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 64-bit little-endian values.
+ *
+ * This is PHYSFS_readULE16Array() for little-endian, 64-bit values.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readULE64
+ * \sa PHYSFS_swapArrayULE64
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readULE64Array(PHYSFS_File *file,
+                                           PHYSFS_uint64 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn PHYSFS_sint64 PHYSFS_readUBE64Array(PHYSFS_File *file, PHYSFS_uint64 *vals, PHYSFS_uint64 count)
+ * \brief Read an array of unsigned 64-bit big-endian values.
+ *
+ * This is PHYSFS_readULE16Array() for big-endian, 64-bit values.
+ *
+ *    \param file PhysicsFS file handle from which to read.
+ *    \param vals pointer to where to store the values. Must hold (count)
+ *                 of them.
+ *    \param count number of values to read.
+ *   \return number of whole values read, or -1 if complete failure. Specifics
+ *           of the error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readUBE64
+ * \sa PHYSFS_swapArrayUBE64
+ */
+PHYSFS_DECL PHYSFS_sint64 PHYSFS_readUBE64Array(PHYSFS_File *file,
+                                           PHYSFS_uint64 *vals,
+                                           PHYSFS_uint64 count);
+
+
+/**
+ * \fn int PHYSFS_readUntil(PHYSFS_File *handle, int delim, const void **data, PHYSFS_uint64 *len)
+ * \brief Read a record ending in a delimiter, without copying it.
+ *
+ * This finds the next (delim) byte in the file, and hands back everything
+ *  before it, straight out of the file's buffer: nothing is allocated or
+ *  copied per record, so this is a quick way to walk through a text file a
+ *  line at a time, or any file made of delimited records. The delimiter is
+ *  used up, but isn't part of the record. The last record in the file
+ *  doesn't need a delimiter after it.
+ *
+ * (*data) points into the buffer, and is only good until the next call
+ *  that uses (handle). Copy it if you need it longer. It isn't
+ *  null-terminated.
+ *
+ * This reads through the buffer from PHYSFS_setBuffer(); if (handle) hasn't
+ *  got one, or has an adaptive one, it gets a fixed buffer of its own. A
+ *  record too big for the buffer makes it grow until the record fits. You
+ *  can mix this with PHYSFS_readBytes() and friends on the same handle.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param delim the byte that ends a record.
+ *   \param data on success, set to the start of the record.
+ *   \param len on success, set to the record's length, in bytes, without
+ *               the delimiter.
+ *  \return non-zero if a record was read, zero at the end of the file or
+ *          on error. PHYSFS_eof() tells you which.
+ *
+ * \sa PHYSFS_readLine
+ * \sa PHYSFS_setBuffer
+ */
+PHYSFS_DECL int PHYSFS_readUntil(PHYSFS_File *handle, int delim,
+                                 const void **data, PHYSFS_uint64 *len);
+
+
+/**
+ * \fn int PHYSFS_readLine(PHYSFS_File *handle, const char **line, PHYSFS_uint64 *len)
+ * \brief Read a line of text, without copying it.
+ *
+ * This is PHYSFS_readUntil() with a newline for the delimiter, and a
+ *  carriage return before it dropped, too, so DOS line endings work.
+ *
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param line on success, set to the start of the line. It isn't
+ *                null-terminated, and is only good until the next call
+ *                that uses (handle).
+ *   \param len on success, set to the line's length, in bytes, without the
+ *               line ending.
+ *  \return non-zero if a line was read, zero at the end of the file or on
+ *          error. PHYSFS_eof() tells you which.
+ *
+ * \sa PHYSFS_readUntil
+ */
+PHYSFS_DECL int PHYSFS_readLine(PHYSFS_File *handle, const char **line,
+                                PHYSFS_uint64 *len);
+
+
+/**
+ * \fn PHYSFS_uint32 PHYSFS_crc32(PHYSFS_uint32 crc, const void *buf, PHYSFS_uint64 len)
+ * \brief Calculate a CRC-32 checksum.
+ *
+ * This is the CRC-32 that ZIP, 7z, PNG and zlib use, so the result matches
+ *  zlib's crc32(). Pass zero for (crc) to start, then pass back what this
+ *  returned to continue the checksum with more data.
+ *
+ * This can be called before PHYSFS_init().
+ *
+ *   \param crc the checksum so far, or zero to start a new one.
+ *   \param buf the data to add to it.
+ *   \param len the number of bytes at (buf).
+ *  \return the checksum of everything so far, (buf) included.
+ *
+ * \sa PHYSFS_getChecksum
+ */
+PHYSFS_DECL PHYSFS_uint32 PHYSFS_crc32(PHYSFS_uint32 crc, const void *buf,
+                                       PHYSFS_uint64 len);
+
+
+/**
+ * \fn int PHYSFS_getChecksum(const char *filename, PHYSFS_uint32 *crc)
+ * \brief Get the CRC-32 checksum of a file's contents.
+ *
+ * The file is found in the search path like PHYSFS_openRead() would find
+ *  it. Archives that store a checksum for each file, like ZIP and 7z, answer
+ *  this straight from their directory, without reading or decompressing
+ *  anything, so this is a quick way to see if an asset changed. Files in
+ *  anything else (like a plain directory) are read start to finish to work
+ *  it out, which is still quicker than reading them yourself.
+ *
+ * Stored checksums are trusted: this doesn't check that the file really
+ *  matches its checksum.
+ *
+ *   \param filename the file to check, in platform-independent notation.
+ *   \param crc on success, set to the file's CRC-32, as PHYSFS_crc32()
+ *              would work it out.
+ *  \return non-zero on success, zero on failure. On failure, the reason can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_crc32
+ */
+PHYSFS_DECL int PHYSFS_getChecksum(const char *filename, PHYSFS_uint32 *crc);
+
+
+/**
+ * \fn void PHYSFS_setVerifyChecksums(int enabled)
+ * \brief Check files in ZIP and 7z archives against their checksums.
+ *
+ * ZIP and 7z archives store a CRC-32 of every file, but PhysicsFS doesn't
+ *  normally check them, so a damaged archive just hands back damaged data.
+ *  With this enabled, files opened afterwards have their CRC-32 worked out
+ *  as they're read, with PHYSFS_crc32(), and if a file read start to finish
+ *  doesn't match, the read that gets to its end fails with
+ *  PHYSFS_ERR_CORRUPT (and so does any other read to the end after that).
+ *  That's one pass over the data the read was making anyhow, instead of
+ *  checking the whole archive separately.
+ *
+ * Only a file read from its start to its end, in order, gets checked.
+ *  Skipping ahead with a seek stops the check for that file; going back
+ *  and rereading is fine. Files read from a PHYSFS_mapRead() mapping aren't
+ *  checked.
+ *
+ * This is disabled by default, and may be set at any time, even before
+ *  PHYSFS_init(). A new value affects files opened after it's set.
+ *
+ *   \param enabled non-zero to check files as they're read, zero not to.
+ *
+ * \sa PHYSFS_getChecksum
+ */
+PHYSFS_DECL void PHYSFS_setVerifyChecksums(int enabled);
+
+
+/**
+ * \fn int PHYSFS_setSpillCacheDir(const char *dir, int persist)
+ * \brief Keep decompressed 7z data on disk, to avoid decompressing it twice.
+ *
+ * 7z archives compress files together, in "folders," and reading any file
+ *  in a folder means decompressing the folder up to it. PhysicsFS keeps
+ *  decompressed folders in memory, within PHYSFS_setDecompressionCacheSize()'s
+ *  budget, but one that gets pushed out of that is decompressed all over
+ *  again the next time a file in it is read. With this set, every folder
+ *  decompressed is also written to a file in (dir), and a folder that isn't
+ *  in memory is mapped back in from its file, if it has one, instead. That's
+ *  usually much quicker than decompressing it, and mapped files don't count
+ *  against the decompression cache's budget.
+ *
+ * Spill files are named for their folder's stored checksum and size, so
+ *  the same folder in different archives, or in an archive that was
+ *  replaced, shares one file. A folder without a stored checksum is never
+ *  spilled. Failing to read or write a spill file never fails a read, but
+ *  spill files are otherwise trusted (unless PHYSFS_setVerifyChecksums() is
+ *  enabled), so (dir) shouldn't be somewhere anyone else can write.
+ *
+ * If (persist) is zero, spill files this program writes are deleted when
+ *  PHYSFS_deinit() is called, or this is called again. Otherwise they're
+ *  left for the next run to use, and nothing ever deletes them; that's up
+ *  to you.
+ *
+ * This is NULL (no spilling) by default. PhysicsFS must be initialized,
+ *  and (dir) must already exist. A new value takes effect right away.
+ *
+ *   \param dir directory to keep spill files in, in platform-dependent
+ *              notation, or NULL to stop spilling.
+ *   \param persist non-zero to keep spill files for later runs, zero to
+ *                  delete them when they're no longer used.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_setDecompressionCacheSize
+ * \sa PHYSFS_setIndexCacheDir
+ */
+PHYSFS_DECL int PHYSFS_setSpillCacheDir(const char *dir, int persist);
+
+
+#ifndef SWIG  /* not available from scripting languages. */
+
+/**
+ * \struct PHYSFS_Inflater
+ * \brief Another way to inflate ZIP entries, like a hardware accelerator.
+ *
+ * (This is for limited, hardcore use. If you don't immediately see a need
+ *  for it, you can probably ignore this forever.)
+ *
+ * You create one of these structures for use with PHYSFS_setInflater().
+ *  When a deflated file in a ZIP archive is read all at once, which is what
+ *  most loaders do, PhysicsFS hands all of its compressed data to Inflate()
+ *  first, and only inflates it itself if that says no. This is meant for
+ *  compression offload hardware (Intel's IAA and QAT, through QPL or
+ *  QATzip, say), which can only really help with a whole buffer at a time,
+ *  so files read a piece at a time, or encrypted, are always inflated by
+ *  PhysicsFS.
+ *
+ * \sa PHYSFS_setInflater
+ */
+typedef struct PHYSFS_Inflater
+{
+    /**
+     * \brief Binary compatibility information.
+     *
+     * This must be set to zero at this time. Future versions of this struct
+     *  will increment this field, so we know what a given implementation
+     *  supports.
+     */
+    PHYSFS_uint32 version;
+
+    /**
+     * \brief Pointer passed to your callbacks.
+     *
+     * PhysicsFS doesn't use this for anything but passing it along.
+     */
+    void *opaque;
+
+    /**
+     * \brief Files smaller than this, inflated, are never handed over.
+     *
+     * Handing work to hardware has a cost of its own, which small files
+     *  don't make up for. Zero hands over everything.
+     */
+    PHYSFS_uint64 minSize;
+
+    /**
+     * \brief Get ready to inflate, from PHYSFS_init().
+     *
+     * Return zero if it can't be done (there's no such hardware here, say),
+     *  and PhysicsFS inflates everything itself until PHYSFS_deinit(),
+     *  without failing PHYSFS_init() over it. This can be NULL.
+     */
+    int (*Init)(void *opaque);
+
+    /**
+     * \brief Clean up, from PHYSFS_deinit().
+     *
+     * Only called if Init() succeeded (or was NULL). This can be NULL.
+     */
+    void (*Deinit)(void *opaque);
+
+    /**
+     * \brief Inflate a whole file.
+     *
+     * (src) is (srclen) bytes of raw deflate data (no zlib or gzip header),
+     *  and (dst) has room for exactly (dstlen) bytes, what the archive says
+     *  it inflates to. Return non-zero if it inflated to exactly that, and
+     *  zero for anything else: bad data, a busy or missing device, whatever.
+     *  PhysicsFS then inflates it itself, so a failure here is never seen
+     *  by the app, and damaged data is reported like it would have been
+     *  without this. This is called from whatever threads read files, at
+     *  the same time, and can't be NULL.
+     */
+    int (*Inflate)(void *opaque, const void *src, PHYSFS_uint64 srclen,
+                   void *dst, PHYSFS_uint64 dstlen);
+} PHYSFS_Inflater;
+
+
+/**
+ * \fn int PHYSFS_setInflater(const PHYSFS_Inflater *inflater)
+ * \brief Hook your own routine for inflating ZIP entries.
+ *
+ * (This is for limited, hardcore use. If you don't immediately see a need
+ *  for it, you can probably ignore this forever.)
+ *
+ * Like PHYSFS_setAllocator(), this only works before PHYSFS_init() or after
+ *  PHYSFS_deinit(), and PhysicsFS keeps a copy of (inflater), so it doesn't
+ *  have to stay around. Pass NULL to go back to inflating everything with
+ *  PhysicsFS's own inflater, which is the default.
+ *
+ * Whether it's being used shows up in PHYSFS_getStats(), as
+ *  inflatesOffloaded.
+ *
+ *    \param inflater Structure containing your inflater's entry points.
+ *   \return zero on failure, non-zero on success. This call fails when used
+ *           between PHYSFS_init() and PHYSFS_deinit() calls, or if
+ *           (inflater)'s version isn't one this PhysicsFS understands.
+ *
+ * \sa PHYSFS_Inflater
+ * \sa PHYSFS_setAllocator
+ */
+PHYSFS_DECL int PHYSFS_setInflater(const PHYSFS_Inflater *inflater);
+
+#endif  /* SWIG */
+
+
+/**
+ * \fn int PHYSFS_readFilesBatchRaw(PHYSFS_AsyncQueue *queue, const char **paths, void **buffers, const PHYSFS_uint64 *lens, PHYSFS_sint64 *results, PHYSFS_Encoding *encodings, PHYSFS_uint64 minRawSize, PHYSFS_uint32 count)
+ * \brief Read many whole files at once, leaving big ones compressed.
+ *
+ * This is PHYSFS_readFilesBatch(), but compressed files in ZIP archives
+ *  (deflated ones) and PPK archives (Zstandard and LZ4 ones) that are at
+ *  least (minRawSize) bytes long, uncompressed, are handed over compressed,
+ *  like PHYSFS_openReadRaw() would, for you to decompress yourself: with a
+ *  GPU decompressor, say, into memory the GPU can read, so a texture
+ *  streamer's CPU doesn't have to do it. They're read from each archive in
+ *  big sequential reads, in the order they're stored, straight into
+ *  (buffers), which only need room for the compressed data.
+ *  (encodings[i]) says which you got for each file, and (results[i]) how
+ *  many bytes of it; PHYSFS_stat() says how big it is once it's
+ *  decompressed.
+ *
+ * Everything else (smaller files, files stored uncompressed, files in
+ *  other kinds of archive, files too big for their buffer, even compressed,
+ *  PPK files that need their archive's Zstandard dictionary) is read and
+ *  decompressed just like PHYSFS_readFilesBatch() does, and gets
+ *  PHYSFS_ENCODING_IDENTITY.
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue() to share the work
+ *                with, or NULL to do it all on this thread.
+ *   \param paths (count) files to read, in platform-independent notation.
+ *   \param buffers (count) buffers to read each of (paths) into.
+ *   \param lens size of each of (buffers), in bytes.
+ *   \param results receives, for each of (paths), the number of bytes read
+ *                  into its buffer, or -1 if it couldn't be opened or read.
+ *   \param encodings receives, for each of (paths), how what was read into
+ *                    its buffer is encoded.
+ *   \param minRawSize the smallest file, uncompressed, to leave compressed.
+ *   \param count number of elements in each of the arrays.
+ *  \return non-zero if every file was read, zero if any of them couldn't
+ *          be (see (results) for which), or on a problem before any of them
+ *          were read, in which case (results) and (encodings) aren't filled
+ *          in. Specifics of the error, for the first file that failed, can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readFilesBatch
+ * \sa PHYSFS_openReadRaw
+ */
+PHYSFS_DECL int PHYSFS_readFilesBatchRaw(PHYSFS_AsyncQueue *queue,
+                                         const char **paths, void **buffers,
+                                         const PHYSFS_uint64 *lens,
+                                         PHYSFS_sint64 *results,
+                                         PHYSFS_Encoding *encodings,
+                                         PHYSFS_uint64 minRawSize,
+                                         PHYSFS_uint32 count);
+
+
+/**
+ * \enum PHYSFS_AsyncPriority
+ * \brief How urgently an asynchronous read is needed.
+ *
+ * An async queue's workers take every queued critical read before any
+ *  visible one, and every visible one before any prefetch. Reads of the same
+ *  priority are taken in the order they were made.
+ *
+ * PhysicsFS's own background work on a queue has a priority too:
+ *  PHYSFS_prefetch() is prefetch, read-ahead is visible, and
+ *  PHYSFS_readFilesBatch() is critical. Each priority can be held to a
+ *  bandwidth with PHYSFS_setAsyncBandwidth().
+ *
+ * \sa PHYSFS_readAsyncPriority
+ * \sa PHYSFS_setAsyncBandwidth
+ */
+typedef enum PHYSFS_AsyncPriority
+{
+    PHYSFS_ASYNC_CRITICAL,  /**< Something's waiting on it right now.     */
+    PHYSFS_ASYNC_VISIBLE,   /**< Needed soon. What PHYSFS_readAsync() uses. */
+    PHYSFS_ASYNC_PREFETCH   /**< Might be needed; whenever there's time.  */
+} PHYSFS_AsyncPriority;
+
+
+/**
+ * \fn PHYSFS_uint64 PHYSFS_readAsyncPriority(PHYSFS_AsyncQueue *queue, PHYSFS_File *handle, void *buffer, PHYSFS_uint64 len, PHYSFS_uint64 offset, PHYSFS_AsyncPriority priority, PHYSFS_uint32 deadline, PHYSFS_AsyncCallback callback, void *userdata)
+ * \brief Read data from a file without waiting for it, when it's due.
+ *
+ * This is PHYSFS_readAsync(), but (priority) says where the read goes in
+ *  (queue)'s line, and (deadline), if it isn't zero, is how many
+ *  milliseconds from now it's worth doing at all: a streaming system can
+ *  queue plenty of prefetches without them holding up what the player can
+ *  see, and the ones that are still waiting when they stop mattering are
+ *  dropped instead of read.
+ *
+ * A dropped read still gets its callback, with a result of -1, and
+ *  PHYSFS_getLastErrorCode() in the callback says PHYSFS_ERR_CANCELLED.
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue().
+ *   \param handle handle returned from PHYSFS_openRead().
+ *   \param buffer buffer of at least (len) bytes to store read data into.
+ *   \param len number of bytes to read from (handle).
+ *   \param offset byte offset into the file to start reading from.
+ *   \param priority how urgently it's needed.
+ *   \param deadline milliseconds from now after which to drop it, if it
+ *                   hasn't been started, or zero to never drop it.
+ *   \param callback function to call when the read is done, or dropped.
+ *   \param userdata passed to (callback) untouched.
+ *  \return a non-zero id for the read, to give PHYSFS_cancelAsync(), or
+ *          zero if it couldn't be queued (or done); (callback) is not
+ *          called in that case. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readAsync
+ * \sa PHYSFS_cancelAsync
+ */
+PHYSFS_DECL PHYSFS_uint64 PHYSFS_readAsyncPriority(PHYSFS_AsyncQueue *queue,
+                                                PHYSFS_File *handle,
+                                                void *buffer,
+                                                PHYSFS_uint64 len,
+                                                PHYSFS_uint64 offset,
+                                                PHYSFS_AsyncPriority priority,
+                                                PHYSFS_uint32 deadline,
+                                                PHYSFS_AsyncCallback callback,
+                                                void *userdata);
+
+
+/**
+ * \fn int PHYSFS_cancelAsync(PHYSFS_AsyncQueue *queue, PHYSFS_uint64 id)
+ * \brief Take back an asynchronous read that's no longer wanted.
+ *
+ * If the read (id) names hasn't been started, it's taken off (queue) and
+ *  its callback is called, on this thread, before this returns. If it's
+ *  being read right now, it's stopped as soon as it can be; a compressed
+ *  ZIP entry stops between the chunks it's decompressed in, but a read the
+ *  OS already has can only finish. Either way, the callback gets a result
+ *  of -1 and PHYSFS_ERR_CANCELLED, and (buffer)'s contents are undefined.
+ *
+ * The buffer and handle have to stay valid until the callback's been
+ *  called, as always; if this returns while the read's in progress, that
+ *  may not have happened yet.
+ *
+ *   \param queue queue the read was made on.
+ *   \param id what PHYSFS_readAsyncPriority() returned for it.
+ *  \return non-zero if the read was cancelled, zero if it couldn't be
+ *          because it's already finished (or (id) is bogus), in which case
+ *          the error is PHYSFS_ERR_NOT_FOUND.
+ *
+ * \sa PHYSFS_readAsyncPriority
+ */
+PHYSFS_DECL int PHYSFS_cancelAsync(PHYSFS_AsyncQueue *queue,
+                                   PHYSFS_uint64 id);
+
+
+/**
+ * \fn void PHYSFS_setReadCoalescing(PHYSFS_uint64 maxGap, PHYSFS_uint64 maxRead)
+ * \brief Set how reads of files near each other in an archive are merged.
+ *
+ * Archives like GRP, PAK, WAD and uncompressed ZIPs store their files as
+ *  they are, back to back. When an async queue's worker picks up a read of
+ *  one of those, it also takes any other queued reads, of any priority,
+ *  for data near it in the same archive, sorts them all by where that data
+ *  is, and reads each run of them with one big read instead of seeking
+ *  back and forth for each. Every request still gets its own callback.
+ *  PHYSFS_readFilesBatch() merges reads the same way.
+ *
+ * Reads are merged when there's no more than (maxGap) bytes between their
+ *  data, and the merged read would be no bigger than (maxRead); the bytes
+ *  in the gaps are read and thrown away. The defaults are 64 kilobytes and
+ *  8 megabytes. On an SSD, a smaller gap may do better; on optical media
+ *  or a hard disk, a bigger one. A (maxRead) of zero turns merging off for
+ *  async queues; PHYSFS_readFilesBatch() still reads each file's data in
+ *  one piece.
+ *
+ * This may be set at any time, and affects reads queued after that. How
+ *  many reads were merged shows up in PHYSFS_getStats(), as readsCoalesced.
+ *
+ *   \param maxGap most bytes between two reads' data to merge them.
+ *   \param maxRead most bytes to read at once, or zero to never merge.
+ *
+ * \sa PHYSFS_readAsyncPriority
+ * \sa PHYSFS_readFilesBatch
+ */
+PHYSFS_DECL void PHYSFS_setReadCoalescing(PHYSFS_uint64 maxGap,
+                                          PHYSFS_uint64 maxRead);
+
+
+/**
+ * \fn int PHYSFS_setAsyncBandwidth(PHYSFS_AsyncQueue *queue, PHYSFS_AsyncPriority priority, PHYSFS_uint64 bytesPerSecond, PHYSFS_uint64 burst)
+ * \brief Limit how fast a queue reads for one priority of work.
+ *
+ * Background work, like PHYSFS_prefetch() or reading a whole patch to check
+ *  it, can keep the disk so busy that reads something's waiting on queue up
+ *  behind it. This holds (queue)'s work of (priority) to about
+ *  (bytesPerSecond), averaged over time, so there's always some of the
+ *  device left over for the rest, which still goes as fast as it can.
+ *
+ * It's a token bucket: the work can read up to (burst) bytes at once after
+ *  it's been idle, then is held to the rate. Only bytes read from the OS
+ *  count, whether by reads, or by jobs like PHYSFS_prefetch() decompressing
+ *  on the queue's threads; reads of memory-mapped archives, or of data
+ *  already cached, are free. A read already started is never held up, so
+ *  one big read can put the priority over its limit, and it then waits
+ *  until it's paid that back. Waiting requests of a limited priority don't
+ *  hold up other priorities' requests, even less urgent ones.
+ *
+ * Limits don't apply on a queue without threads, which does everything
+ *  immediately, or to what's left on a queue that's being destroyed. How
+ *  much each priority read, and how long workers waited for bandwidth,
+ *  shows up in PHYSFS_getStats().
+ *
+ *   \param queue queue from PHYSFS_createAsyncQueue().
+ *   \param priority the priority to limit.
+ *   \param bytesPerSecond the limit, or zero for none, which is the default.
+ *   \param burst most bytes to read at once after being idle, or zero for
+ *                a second's worth.
+ *  \return non-zero on success, zero if (queue) or (priority) is bogus.
+ *
+ * \sa PHYSFS_readAsyncPriority
+ * \sa PHYSFS_prefetch
+ */
+PHYSFS_DECL int PHYSFS_setAsyncBandwidth(PHYSFS_AsyncQueue *queue,
+                                         PHYSFS_AsyncPriority priority,
+                                         PHYSFS_uint64 bytesPerSecond,
+                                         PHYSFS_uint64 burst);
+
+
+/**
+ * \fn int PHYSFS_freeze(void)
+ * \brief Stop the search path from changing, so lookups are cheaper.
+ *
+ * Most programs mount everything at startup and never touch the search
+ *  path again, but every PHYSFS_openRead(), PHYSFS_stat(), PHYSFS_exists()
+ *  and enumeration still has to keep track of itself in case some other
+ *  thread unmounts what it's looking at, and opening and closing files
+ *  takes a lock to keep track of what each archive has open. With many
+ *  threads opening lots of small files, those add up.
+ *
+ * Once this is called, PHYSFS_mount() and friends, PHYSFS_unmount(),
+ *  PHYSFS_setWriteDir(), PHYSFS_permitSymbolicLinks() and
+ *  PHYSFS_enableSearchPathIndex() fail with PHYSFS_ERR_FROZEN, and
+ *  lookups and opening and closing files for reading don't take any locks
+ *  or keep track of anything. This also enables the search path index
+ *  (see PHYSFS_enableSearchPathIndex()), built right now, so the first
+ *  lookups don't pay for it. Archivers that aren't known to be thread safe
+ *  still take a lock while they're used, as usual.
+ *
+ * Writing files in the write directory still works. Files opened for
+ *  reading after this aren't closed by PHYSFS_deinit(); it fails with
+ *  PHYSFS_ERR_FILES_STILL_OPEN until you close them. Files opened while
+ *  PHYSFS_enableAccessProfile() is on are tracked as usual, so they can be
+ *  profiled.
+ *
+ * There's no way to thaw the search path again short of PHYSFS_deinit().
+ *  Calling this when it's already frozen does nothing, successfully.
+ *
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError(). If it fails, nothing was
+ *          frozen.
+ *
+ * \sa PHYSFS_isFrozen
+ * \sa PHYSFS_enableSearchPathIndex
+ */
+PHYSFS_DECL int PHYSFS_freeze(void);
+
+
+/**
+ * \fn int PHYSFS_isFrozen(void)
+ * \brief Determine if PHYSFS_freeze() has been called.
+ *
+ *  \return non-zero if the search path is frozen, zero if it isn't.
+ *
+ * \sa PHYSFS_freeze
+ */
+PHYSFS_DECL int PHYSFS_isFrozen(void);
+
+
+/**
+ * \struct PHYSFS_Context
+ * \brief A search path and write directory of its own.
+ *
+ * Everything PhysicsFS does with paths happens in a context: it has its own
+ *  search path, write directory, PHYSFS_permitSymbolicLinks() setting,
+ *  search path index, and PHYSFS_freeze(). A program that hosts several
+ *  independent pieces, like a game and its mods' sandboxes, or an editor
+ *  and the game it's running, can give each one a context, and they won't
+ *  see each other's files, or wait on each other's locks to find them.
+ *
+ * There's always a default context, which is what you get without ever
+ *  thinking about this. Other contexts come from PHYSFS_createContext() and
+ *  go away with PHYSFS_destroyContext() or PHYSFS_deinit(). Each thread
+ *  picks which one its calls use with PHYSFS_setCurrentContext().
+ *
+ * The allocator, archivers, error state, cache timeouts, change callback,
+ *  async queues, access profile and stats are still shared by everything.
+ *  Archivers that aren't known to be thread safe still take a lock that's
+ *  shared by all contexts while they're used.
+ *
+ * This is opaque.
+ *
+ * \sa PHYSFS_createContext
+ * \sa PHYSFS_setCurrentContext
+ */
+typedef struct PHYSFS_Context PHYSFS_Context;
+
+
+/**
+ * \fn PHYSFS_Context *PHYSFS_createContext(void)
+ * \brief Make a new, empty context.
+ *
+ * The new context has nothing mounted, no write directory, symbolic links
+ *  forbidden, and no search path index, like the default context right
+ *  after PHYSFS_init(). It isn't used for anything until some thread makes
+ *  it current with PHYSFS_setCurrentContext().
+ *
+ *  \return the new context, or NULL on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_destroyContext
+ * \sa PHYSFS_setCurrentContext
+ */
+PHYSFS_DECL PHYSFS_Context *PHYSFS_createContext(void);
+
+
+/**
+ * \fn int PHYSFS_destroyContext(PHYSFS_Context *ctx)
+ * \brief Unmount everything in a context and free it.
+ *
+ * This fails with PHYSFS_ERR_FILES_STILL_OPEN if any file opened in (ctx)
+ *  is still open, and nothing is changed. Otherwise, everything in its
+ *  search path is unmounted, its write directory is dropped, and its
+ *  pending atomic writes are discarded, as PHYSFS_deinit() would.
+ *
+ * If (ctx) is the calling thread's current context, the thread goes back to
+ *  the default context. Other threads mustn't still have (ctx) current; it's
+ *  up to you to move them off of it first. The default context can't be
+ *  destroyed. PHYSFS_deinit() destroys any contexts that are left.
+ *
+ *   \param ctx a context from PHYSFS_createContext().
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_createContext
+ */
+PHYSFS_DECL int PHYSFS_destroyContext(PHYSFS_Context *ctx);
+
+
+/**
+ * \fn int PHYSFS_setCurrentContext(PHYSFS_Context *ctx)
+ * \brief Choose which context the calling thread works in.
+ *
+ * From here on, everything this thread does that involves the search path
+ *  or the write directory, from PHYSFS_mount() to PHYSFS_openRead() to
+ *  PHYSFS_enumerate(), uses (ctx). Other threads aren't affected; threads
+ *  start out in the default context.
+ *
+ * An open PHYSFS_File stays with the context it was opened in, so it can
+ *  be handed to another thread, whatever context that thread is in.
+ *  PHYSFS_prefetch() and PHYSFS_readFilesBatch() use the calling thread's
+ *  context, even when the work is done on an async queue's threads.
+ *
+ *   \param ctx a context from PHYSFS_createContext(), or NULL for the
+ *              default context.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_getCurrentContext
+ */
+PHYSFS_DECL int PHYSFS_setCurrentContext(PHYSFS_Context *ctx);
+
+
+/**
+ * \fn PHYSFS_Context *PHYSFS_getCurrentContext(void)
+ * \brief Find out which context the calling thread works in.
+ *
+ *  \return what was last given to PHYSFS_setCurrentContext() on this
+ *          thread, or NULL if it's in the default context.
+ *
+ * \sa PHYSFS_setCurrentContext
+ */
+PHYSFS_DECL PHYSFS_Context *PHYSFS_getCurrentContext(void);
+
+
+/**
+ * \fn int PHYSFS_replaceMount(const char *oldDir, const char *newDir)
+ * \brief Swap an archive in the search path for another, all at once.
+ *
+ * This mounts (newDir) where (oldDir) is: at the same mount point, and in
+ *  the same place in the search path, and unmounts (oldDir), in one step.
+ *  Unmounting one and mounting the other would leave a moment where
+ *  lookups find neither; here, every lookup finds one or the other.
+ *
+ * (newDir) is opened, and its directory read, before anything changes,
+ *  while lookups carry on using (oldDir) as usual. If it can't be, this
+ *  fails and (oldDir) stays mounted. Files already open in (oldDir) keep
+ *  working, as they do after PHYSFS_unmount(), and it's closed once the
+ *  last of them is.
+ *
+ * (oldDir) must be a (case-sensitive) match to something in the search
+ *  path, as with PHYSFS_unmount(). (newDir) can be the same path, to pick
+ *  up an archive that was replaced on disk; it can't be anything else that
+ *  is already mounted.
+ *
+ *   \param oldDir dir/archive to replace, in platform-dependent notation.
+ *   \param newDir dir/archive to put in its place, likewise.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mount
+ * \sa PHYSFS_unmount
+ */
+PHYSFS_DECL int PHYSFS_replaceMount(const char *oldDir, const char *newDir);
+
+
+/**
+ * \fn int PHYSFS_setMountRoutes(const char *dir, const char **include, const char **exclude)
+ * \brief Say which paths an archive in the search path can have.
+ *
+ * Every lookup tries every archive mounted where it could have the path,
+ *  in search path order, until one has it; a file that isn't anywhere has
+ *  to be looked for in all of them. If you know that everything under
+ *  "/audio" is in the audio packs, and nothing else is, say so here, and
+ *  lookups won't bother the other archives with anything under "/audio",
+ *  or the audio packs with anything that isn't.
+ *
+ * (include) and (exclude) are NULL-terminated lists of paths, in platform-
+ *  independent notation, with the archive's mount point (if any) included,
+ *  like the paths you look things up by. Either can be NULL, for an empty
+ *  list. (dir) is then only tried for paths at or under something in
+ *  (include), if (include) lists anything, and never for paths at or under
+ *  anything in (exclude). Directories leading to an included path are
+ *  tried too, so they still show up in listings and PHYSFS_stat(). Paths
+ *  are matched exactly, whole path elements at a time, even in archives
+ *  that ignore case.
+ *
+ * These are promises about where things are, and they're kept: a file in
+ *  (dir) that's outside of its routes can't be found, listed or opened
+ *  anymore (though an excluded directory's own name still shows up when
+ *  the directory above it is listed). PHYSFS_walkTree() skips (dir)
+ *  entirely, unless where it starts is routed to (dir).
+ *
+ * Each call replaces what was set before; NULL for both lists tries (dir)
+ *  for everything again, as it is when it's mounted. PHYSFS_replaceMount()
+ *  keeps the routes of the archive it replaces.
+ *
+ *   \param dir dir/archive in the search path, in platform-dependent
+ *              notation, as it was mounted.
+ *   \param include paths (dir) is tried for, or NULL for everything.
+ *   \param exclude paths (dir) is never tried for, or NULL.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL int PHYSFS_setMountRoutes(const char *dir, const char **include,
+                                      const char **exclude);
+
+
+/**
+ * \struct PHYSFS_Directory
+ * \brief A directory listing in progress.
+ *
+ * Get one from PHYSFS_openDirectory(), read entries from it with
+ *  PHYSFS_readDirectory(), and free it with PHYSFS_closeDirectory().
+ *
+ * \sa PHYSFS_openDirectory
+ */
+typedef struct PHYSFS_Directory PHYSFS_Directory;
+
+
+/**
+ * \fn PHYSFS_Directory *PHYSFS_openDirectory(const char *dir)
+ * \brief Start listing a directory, to read its entries one at a time.
+ *
+ * This lists the same things PHYSFS_enumerateFilesStatCallback() would,
+ *  but you ask for each entry, with PHYSFS_readDirectory(), instead of
+ *  having them all handed to a callback at once, and nothing is locked or
+ *  held between reads. So you can stop partway, page through a listing a
+ *  few entries at a time, or do whatever you like with each one as it
+ *  comes, without blocking anything else.
+ *
+ * Nothing is listed yet when this returns. Each archive in the search path
+ *  is listed when the reads get to it, so the first entries come back as
+ *  soon as the first archive is listed, not once every one of them has
+ *  been. Entries come back in no particular order, and each name only
+ *  once, with the PHYSFS_Stat of the archive that's first in the search
+ *  path, like PHYSFS_stat() would say.
+ *
+ * Archives that are unmounted before the reads get to them are skipped.
+ *  Archives mounted after this is called aren't listed.
+ *
+ *   \param dir directory in platform-independent notation to list.
+ *  \return a listing to pass to PHYSFS_readDirectory(), or NULL on error.
+ *          Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_readDirectory
+ * \sa PHYSFS_closeDirectory
+ * \sa PHYSFS_enumerateFilesStatCallback
+ */
+PHYSFS_DECL PHYSFS_Directory *PHYSFS_openDirectory(const char *dir);
+
+
+/**
+ * \fn int PHYSFS_readDirectory(PHYSFS_Directory *dir, const char **name, PHYSFS_Stat *stat)
+ * \brief Get the next entry of a directory listing.
+ *
+ * (*name) is set to the entry's name, without the directory in front of
+ *  it. It stays valid until the next call to this or PHYSFS_closeDirectory()
+ *  with (dir); copy it if you need it longer than that.
+ *
+ *   \param dir a listing from PHYSFS_openDirectory().
+ *   \param name where to put the entry's name.
+ *   \param stat where to put the entry's metadata. Can be NULL.
+ *  \return 1 if (*name) and (*stat) were filled in, 0 if there's nothing
+ *          left, or -1 on error, in which case nothing more can be read.
+ *          Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openDirectory
+ */
+PHYSFS_DECL int PHYSFS_readDirectory(PHYSFS_Directory *dir, const char **name,
+                                     PHYSFS_Stat *stat);
+
+
+/**
+ * \fn int PHYSFS_closeDirectory(PHYSFS_Directory *dir)
+ * \brief Free a directory listing.
+ *
+ * This can be called at any point, whether or not every entry was read.
+ *
+ *   \param dir a listing from PHYSFS_openDirectory().
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openDirectory
+ */
+PHYSFS_DECL int PHYSFS_closeDirectory(PHYSFS_Directory *dir);
+
+
+/**
+ * \fn int PHYSFS_statMany(const char **paths, PHYSFS_Stat *stats, int *results, PHYSFS_uint32 count)
+ * \brief Get metadata for many files at once.
+ *
+ * This is PHYSFS_stat() for each of (paths), but cheaper than calling it
+ *  that many times: the search path is walked under one registration for
+ *  all of them, and they're looked up in sorted order, so paths in the
+ *  same directory are looked up one after another, while whatever each
+ *  archive remembers about that directory is still handy. It's meant for
+ *  checking thousands of paths at a time.
+ *
+ * (stats)[i] is filled in for (paths)[i], just like PHYSFS_stat() would.
+ *  If (results) isn't NULL, (results)[i] is set to what PHYSFS_stat() would
+ *  have returned for it: non-zero if it was found, zero if it wasn't.
+ *
+ *   \param paths (count) filenames to look up, in platform-independent
+ *                notation.
+ *   \param stats (count) PHYSFS_Stat structs to fill in.
+ *   \param results (count) ints to set, or NULL.
+ *   \param count number of paths.
+ *  \return number of paths found, or -1 on error (bad arguments, or out of
+ *          memory partway). Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_stat
+ * \sa PHYSFS_existsMany
+ */
+PHYSFS_DECL int PHYSFS_statMany(const char **paths, PHYSFS_Stat *stats,
+                                int *results, PHYSFS_uint32 count);
+
+
+/**
+ * \fn int PHYSFS_existsMany(const char **paths, int *results, PHYSFS_uint32 count)
+ * \brief Find out which of many files exist, all at once.
+ *
+ * This is PHYSFS_statMany() without the PHYSFS_Stat structs, for when you
+ *  only care whether each path is there.
+ *
+ *   \param paths (count) filenames to look for, in platform-independent
+ *                notation.
+ *   \param results (count) ints to set, non-zero for each path that
+ *                  exists, or NULL to just count them.
+ *   \param count number of paths.
+ *  \return number of paths that exist, or -1 on error. Specifics of the
+ *          error can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_exists
+ * \sa PHYSFS_statMany
+ */
+PHYSFS_DECL int PHYSFS_existsMany(const char **paths, int *results,
+                                  PHYSFS_uint32 count);
+
+
+/**
+ * \fn void PHYSFS_setOpenFileCacheTime(int seconds)
+ * \brief Set how long closed files in native directories are kept open.
+ *
+ * Each PHYSFS_openRead() of a file in a mounted native directory opens it
+ *  with the OS, and PHYSFS_close() closes it again. When the same files are
+ *  opened over and over, as development builds running from loose files
+ *  tend to do, that's a lot of system calls for nothing. With this set,
+ *  PhysicsFS keeps the last few files closed in each mounted native
+ *  directory open behind the scenes, and the next PHYSFS_openRead() of the
+ *  same file uses that instead of opening it again. Archives don't need
+ *  this; they're only opened once.
+ *
+ * Whatever is kept is forgotten whenever the search path or write dir
+ *  changes, PhysicsFS writes, creates or deletes anything,
+ *  PHYSFS_permitSymbolicLinks() or this function is called, or you call
+ *  PHYSFS_invalidateCache(). A kept file is whatever was at that path when
+ *  it was opened: if something else replaces it, you'll read the old one.
+ *  If that might happen, either pick a time you're willing to see old
+ *  files for, invalidate it yourself, or let PHYSFS_setChangeCallback() do
+ *  it. On Windows, a file that's kept open can't be deleted or renamed by
+ *  other programs until it's forgotten.
+ *
+ * Files given a hint with PHYSFS_setAccessHint() aren't kept.
+ *
+ * This goes back to zero when PHYSFS_deinit() is called.
+ *
+ *   \param seconds how long to keep a file open after it was opened. Zero
+ *                  to close them right away (the default), -1 to keep them
+ *                  until something changes, as above.
+ *
+ * \sa PHYSFS_invalidateCache
+ * \sa PHYSFS_setChangeCallback
+ * \sa PHYSFS_setDirListingCacheTime
+ */
+PHYSFS_DECL void PHYSFS_setOpenFileCacheTime(int seconds);
+
+
+/**
+ * \fn int PHYSFS_setMountStatCacheTime(const char *dir, int seconds)
+ * \brief Set how long metadata from a native directory is trusted.
+ *
+ * PHYSFS_stat(), PHYSFS_exists(), PHYSFS_isDirectory(),
+ *  PHYSFS_getLastModTime(), PHYSFS_getRealDir() and friends all ask the
+ *  filesystem about a file in a native directory every time, and so does
+ *  the symlink check for every element of every path opened from one,
+ *  unless PHYSFS_permitSymbolicLinks() was called. On a local disk that's
+ *  cheap; on a network share, each can take milliseconds. With this set,
+ *  PhysicsFS remembers the answers for (dir), including which files
+ *  weren't there, and gives them out again instead of asking. Archives
+ *  don't need this; their metadata is already in memory, and this does
+ *  nothing for them.
+ *
+ * Whatever is remembered is forgotten whenever the search path or write
+ *  dir changes, PhysicsFS writes, creates or deletes anything,
+ *  PHYSFS_permitSymbolicLinks() or this function is called, or you call
+ *  PHYSFS_invalidateCache(). If something else might change (dir), either
+ *  pick a time you're willing to see old answers for, invalidate it
+ *  yourself, or let PHYSFS_setChangeCallback() do it. Sizes and times of
+ *  files that are still open for writing may be out of date until they're
+ *  closed.
+ *
+ * PHYSFS_replaceMount() keeps this setting for whatever replaces (dir).
+ *
+ *   \param dir a directory, as passed to PHYSFS_mount().
+ *   \param seconds how long to trust what was looked up. Zero to not
+ *                  remember anything (the default), -1 to trust it until
+ *                  something changes, as above.
+ *  \return nonzero on success, zero if (dir) isn't mounted or memory ran
+ *          out. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_invalidateCache
+ * \sa PHYSFS_setChangeCallback
+ * \sa PHYSFS_setSymbolicLinkCheckCacheTime
+ */
+PHYSFS_DECL int PHYSFS_setMountStatCacheTime(const char *dir, int seconds);
+
+
+/**
+ * \fn int PHYSFS_copyFile(const char *src, const char *dst)
+ * \brief Copy a file from the search path into the write dir.
+ *
+ * This does what opening (src) with PHYSFS_openRead(), (dst) with
+ *  PHYSFS_openWrite(), and reading one into the other would, but usually
+ *  much faster: when (src) is a file in a native directory, or stored
+ *  as-is in an archive (see PHYSFS_getFileBacking()), the OS is asked to
+ *  copy it without the bytes passing through your program at all, which
+ *  on some filesystems just shares the blocks with the original. When it
+ *  can't be, the data is written straight from a mapping of (src) if
+ *  there is one (see PHYSFS_mapRead()), and read and written in large
+ *  pieces if not.
+ *
+ * (dst) is written under a temporary name and renamed into place when
+ *  it's done, like PHYSFS_openWriteAtomic() does, so it's never there
+ *  half-copied, and copying a file onto itself is harmless. If the write
+ *  dir is an archive that can't do that, (dst) is written directly, and
+ *  deleted if the copy fails.
+ *
+ *   \param src file to copy, in platform-independent notation, found in
+ *              the search path.
+ *   \param dst where to put it, in platform-independent notation,
+ *              relative to the write dir. It's replaced if it exists.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_openRead
+ * \sa PHYSFS_openWriteAtomic
+ * \sa PHYSFS_getFileBacking
+ */
+PHYSFS_DECL int PHYSFS_copyFile(const char *src, const char *dst);
+
+
+/**
+ * \fn int PHYSFS_compactArchive(const char *archive)
+ * \brief Squeeze the unused space out of a ZIP archive.
+ *
+ * When the write dir is a ZIP archive, replacing or deleting a file that's
+ *  already in it just leaves the old data there, unused, so adding to even
+ *  a huge archive only costs what's added (see
+ *  PHYSFS_setWriteCompression()). This rewrites (archive) with only the
+ *  files that are still in it, one after another, copying their data as
+ *  it is, without compressing it again.
+ *
+ * The new archive is written next to the old one, under a temporary name,
+ *  and renamed over it when it's done, so (archive) is never left
+ *  half-written, but there has to be room for both for a while. This
+ *  fails with PHYSFS_ERR_FILES_STILL_OPEN if (archive) is the write dir;
+ *  set another one first. Mounts of it keep reading the old file where the
+ *  OS lets a replaced file stay open, and fail where it doesn't, so
+ *  unmount it first if you can.
+ *
+ *   \param archive the ZIP file, in platform-dependent notation.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_setWriteDir
+ * \sa PHYSFS_setWriteCompression
+ */
+PHYSFS_DECL int PHYSFS_compactArchive(const char *archive);
+
+
+/**
+ * \fn int PHYSFS_startTraceCapture(const char *filename)
+ * \brief Record everything PhysicsFS is asked to do, for replaying later.
+ *
+ * This writes the events PHYSFS_setTraceHooks() would report to (filename),
+ *  a platform-dependent path that needn't be in the write dir, along with
+ *  when they started, how long they took and which thread asked. It works
+ *  alongside any hooks that are set.
+ *
+ * The file is plain text, one event per line, after a "PHYSFS-TRACE 1"
+ *  line:
+ *
+ * \code
+ * start_ns duration_ns thread event handle bytes result offset path
+ * \endcode
+ *
+ * (event) is one of mount, open, read, seek, enumerate, stat or close.
+ *  Times are in nanoseconds since the capture started. (thread) counts up
+ *  from 1 in the order threads first showed up; past 256 of them they're
+ *  all 0. (handle) is the PHYSFS_File pointer, as a number, so opens,
+ *  reads and closes can be matched up. (bytes) and (offset) are as in
+ *  PHYSFS_TraceInfo, from the beginning of the event; (result) is how many
+ *  bytes came out of a read, and non-zero if anything else worked. (path)
+ *  is the rest of the line, with backslashes and newlines escaped as "\\"
+ *  and "\n".
+ *
+ * Lines are written as events end, so they aren't quite in start order;
+ *  sort on the first field if that matters. Decompression isn't recorded,
+ *  since a replay does its own. The physfs_replay program in the test
+ *  directory plays a capture back against a search path, with the original
+ *  threads and timing, to see how a change to PhysicsFS or the data would
+ *  have gone for a real session.
+ *
+ * Only one capture runs at a time. PHYSFS_deinit() stops it.
+ *
+ *   \param filename Platform-dependent file to write the capture to.
+ *  \return nonzero on success, zero on error. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastErrorCode().
+ *
+ * \sa PHYSFS_stopTraceCapture
+ * \sa PHYSFS_setTraceHooks
+ */
+PHYSFS_DECL int PHYSFS_startTraceCapture(const char *filename);
+
+
+/**
+ * \fn int PHYSFS_stopTraceCapture(void)
+ * \brief Finish what PHYSFS_startTraceCapture() started.
+ *
+ * Anything still buffered is written and the file is closed. Stopping when
+ *  no capture is running does nothing.
+ *
+ *  \return nonzero on success, zero if any of the capture couldn't be
+ *          written. Specifics of the error can be gleaned from
+ *          PHYSFS_getLastErrorCode().
+ *
+ * \sa PHYSFS_startTraceCapture
+ */
+PHYSFS_DECL int PHYSFS_stopTraceCapture(void);
+
+
+/**
+ * \fn int PHYSFS_startCdRomDetection(void)
+ * \brief Look for discs on another thread, so it doesn't hold up startup.
+ *
+ * Finding inserted discs can mean reading the system's mount table or
+ *  waiting for optical drives to spin up, which can take seconds. This
+ *  starts that on a background thread and returns right away; the next
+ *  PHYSFS_getCdRomDirs(), PHYSFS_getCdRomDirsCallback() or
+ *  PHYSFS_setSaneConfig() with (includeCdRoms) uses what it found,
+ *  waiting only for whatever's left of it. PHYSFS_setSaneConfig() calls
+ *  this itself, so the drives spin while it sets up everything else.
+ *
+ * If the last detection is still running, this doesn't start another. On
+ *  systems without threads, this does the detection before returning.
+ *
+ *  \return nonzero on success, zero if PhysicsFS isn't initialized.
+ *
+ * \sa PHYSFS_isCdRomDetectionDone
+ * \sa PHYSFS_getCdRomDirs
+ */
+PHYSFS_DECL int PHYSFS_startCdRomDetection(void);
+
+
+/**
+ * \fn int PHYSFS_isCdRomDetectionDone(void)
+ * \brief See if PHYSFS_startCdRomDetection() is finished.
+ *
+ * Poll this to know when PHYSFS_getCdRomDirs() will return without
+ *  waiting on the drives.
+ *
+ *  \return nonzero if no detection is running, zero if one is, or if
+ *          PhysicsFS isn't initialized.
+ *
+ * \sa PHYSFS_startCdRomDetection
+ */
+PHYSFS_DECL int PHYSFS_isCdRomDetectionDone(void);
+
+
+#ifndef SWIG  /* not available from scripting languages. */
+
+/**
+ * \fn PHYSFS_Io *PHYSFS_createCachedIo(PHYSFS_Io *io, PHYSFS_uint32 blockSize, PHYSFS_uint32 capacity)
+ * \brief Put a block cache in front of a PHYSFS_Io.
+ *
+ * Archivers make lots of small reads: headers, directory records, the
+ *  little header in front of every ZIP entry. Where each read of (io) is
+ *  expensive (a network connection, a file inside another archive, slow
+ *  flash), reading through this is much faster. Reads are served from the
+ *  last (capacity) (blockSize)-byte blocks of (io) that were read, least
+ *  recently used going first; a miss reads the whole block. Reads of whole
+ *  blocks go straight to (io), so one big read doesn't push everything
+ *  else out of the cache.
+ *
+ * The new instance is read-only, and its duplicates all share one cache,
+ *  which is safe to use from several threads at once. (io) has to know its
+ *  length, and must not change underneath it. The cache counts as
+ *  PHYSFS_MEMORY_CACHES, and stops growing at that limit.
+ *
+ * On success, the new instance owns (io), and calls (io)->destroy(io) when
+ *  it is destroyed itself. Don't use (io) directly after this. If this
+ *  function fails, (io) is left alone.
+ *
+ * PHYSFS_setMountBlockCache() puts one of these in front of archives as
+ *  they're mounted.
+ *
+ *   \param io i/o instance to read through the cache.
+ *   \param blockSize bytes per block, or zero for 64 kilobytes.
+ *   \param capacity most blocks to keep, or zero for 64.
+ *  \return a new i/o instance, or NULL on failure. Specifics of the error
+ *          can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_mountIo
+ * \sa PHYSFS_setMountBlockCache
+ */
+PHYSFS_DECL PHYSFS_Io *PHYSFS_createCachedIo(PHYSFS_Io *io,
+                                             PHYSFS_uint32 blockSize,
+                                             PHYSFS_uint32 capacity);
+
+
+/**
+ * \struct PHYSFS_Download
+ * \brief Which parts of a file that's still arriving are there yet.
+ *
+ * This is opaque; you get one from PHYSFS_createDownload() and give it
+ *  back with PHYSFS_destroyDownload().
+ *
+ * \sa PHYSFS_createDownload
+ * \sa PHYSFS_createDownloadIo
+ */
+typedef struct PHYSFS_Download PHYSFS_Download;
+
+/**
+ * \def PHYSFS_DOWNLOAD_WAIT_FOREVER
+ * \brief A wait for PHYSFS_createDownload() that never gives up.
+ */
+#define PHYSFS_DOWNLOAD_WAIT_FOREVER 0xFFFFFFFF
+
+/**
+ * \fn PHYSFS_Download *PHYSFS_createDownload(PHYSFS_uint64 length, PHYSFS_uint32 waitMs)
+ * \brief Start keeping track of a file that's still arriving.
+ *
+ * This lets you mount an archive while it's still downloading (or being
+ *  copied off a disc, or unpacked by an installer). You tell it which
+ *  byte ranges have arrived with PHYSFS_downloadArrived(), in whatever
+ *  order they come, and read the file through PHYSFS_createDownloadIo(),
+ *  which only reads the parts that are there.
+ *
+ * A read that needs something that hasn't arrived waits up to (waitMs)
+ *  milliseconds for it, then fails with PHYSFS_ERR_UNAVAILABLE. With zero,
+ *  it fails right away, so the game can show something else and try
+ *  again; with PHYSFS_DOWNLOAD_WAIT_FOREVER it waits until it's there,
+ *  which suits a loading thread.
+ *
+ * An archiver reads its directory while the archive is being mounted, so
+ *  that part has to be there first: for a ZIP, that's the end of the file.
+ *  If mounting fails because it isn't, PHYSFS_downloadWanted() says which
+ *  ranges it tried to read.
+ *
+ *   \param length how many bytes the file will have when it's all there.
+ *   \param waitMs how long reads wait for missing data, in milliseconds.
+ *  \return a new download, or NULL on failure. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_createDownloadIo
+ * \sa PHYSFS_downloadArrived
+ * \sa PHYSFS_downloadWanted
+ * \sa PHYSFS_destroyDownload
+ */
+PHYSFS_DECL PHYSFS_Download *PHYSFS_createDownload(PHYSFS_uint64 length,
+                                                   PHYSFS_uint32 waitMs);
+
+/**
+ * \fn PHYSFS_Io *PHYSFS_createDownloadIo(PHYSFS_Download *dl, PHYSFS_Io *io)
+ * \brief Read a file that's still arriving, one range at a time.
+ *
+ * (io) reads the file as it is so far: a native file that's being
+ *  written to, say, or memory the downloader fills in. The new instance
+ *  has the length (dl) was created with, and reads (io) only where
+ *  PHYSFS_downloadArrived() says the data is, waiting or failing (as
+ *  PHYSFS_createDownload() describes) everywhere else. It won't map (io)
+ *  or hand out its backing file until the whole thing has arrived.
+ *  PHYSFS_ACCESS_WILLNEED advice for ranges that aren't there yet is
+ *  remembered for PHYSFS_downloadWanted().
+ *
+ * Give the result to PHYSFS_mountIo() to mount the archive. It's
+ *  read-only, and its duplicates all share (dl), so they're safe to read
+ *  from several threads at once. It keeps (dl) alive until it's destroyed,
+ *  even after PHYSFS_destroyDownload().
+ *
+ * On success, the new instance owns (io), and calls (io)->destroy(io) when
+ *  it is destroyed itself. Don't use (io) directly after this. If this
+ *  function fails, (io) is left alone.
+ *
+ *   \param dl what has arrived so far.
+ *   \param io i/o instance over the data that has arrived.
+ *  \return a new i/o instance, or NULL on failure. Specifics of the error
+ *          can be gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_createDownload
+ * \sa PHYSFS_mountIo
+ */
+PHYSFS_DECL PHYSFS_Io *PHYSFS_createDownloadIo(PHYSFS_Download *dl,
+                                               PHYSFS_Io *io);
+
+/**
+ * \fn int PHYSFS_downloadArrived(PHYSFS_Download *dl, PHYSFS_uint64 offset, PHYSFS_uint64 len)
+ * \brief Say that another part of a file has arrived.
+ *
+ * Call this once (len) bytes at (offset) can be read from the PHYSFS_Io
+ *  that was given to PHYSFS_createDownloadIo(), not before. Ranges may
+ *  arrive in any order, and overlap ones that are already there. Reads
+ *  waiting on them carry on.
+ *
+ * This is safe to call from any thread.
+ *
+ *   \param dl the download the data belongs to.
+ *   \param offset where the new data starts.
+ *   \param len how many bytes arrived.
+ *  \return nonzero on success, zero if the range is past the end of the
+ *          file or we ran out of memory. Specifics of the error can be
+ *          gleaned from PHYSFS_getLastError().
+ *
+ * \sa PHYSFS_downloadWanted
+ */
+PHYSFS_DECL int PHYSFS_downloadArrived(PHYSFS_Download *dl,
+                                       PHYSFS_uint64 offset,
+                                       PHYSFS_uint64 len);
+
+/**
+ * \fn PHYSFS_uint32 PHYSFS_downloadWanted(PHYSFS_Download *dl, PHYSFS_uint64 *offsets, PHYSFS_uint64 *lens, PHYSFS_uint32 max)
+ * \brief Find out which parts of a file to download next.
+ *
+ * This lists the missing ranges that something has asked for: first the
+ *  ones reads are waiting on (or failed for, with a zero wait), oldest
+ *  first, then the ones that were only advised with
+ *  PHYSFS_ACCESS_WILLNEED, by PHYSFS_setAccessHint() or PHYSFS_prefetch().
+ *  A downloader that fetches these before the rest of the file gets the
+ *  files the game is opening to it soonest. Ranges drop off the list as
+ *  they arrive; only the last 64 requests are remembered.
+ *
+ *   \param dl the download to ask about.
+ *   \param offsets where each range starts.
+ *   \param lens how long each range is.
+ *   \param max the most ranges (offsets) and (lens) have room for.
+ *  \return how many ranges were written, zero if nothing is waiting.
+ *
+ * \sa PHYSFS_downloadArrived
+ */
+PHYSFS_DECL PHYSFS_uint32 PHYSFS_downloadWanted(PHYSFS_Download *dl,
+                                                PHYSFS_uint64 *offsets,
+                                                PHYSFS_uint64 *lens,
+                                                PHYSFS_uint32 max);
+
+/**
+ * \fn void PHYSFS_cancelDownload(PHYSFS_Download *dl)
+ * \brief Give up on the rest of a file.
+ *
+ * Reads that are waiting for data, and later reads of data that hasn't
+ *  arrived, fail with PHYSFS_ERR_CANCELLED. What has arrived can still be
+ *  read. Call this if the download fails, so nothing waits forever.
+ *
+ *   \param dl the download to give up on.
+ *
+ * \sa PHYSFS_destroyDownload
+ */
+PHYSFS_DECL void PHYSFS_cancelDownload(PHYSFS_Download *dl);
+
+/**
+ * \fn void PHYSFS_destroyDownload(PHYSFS_Download *dl)
+ * \brief Let go of a download.
+ *
+ * Nothing more can arrive after this, so it cancels whatever hasn't (see
+ *  PHYSFS_cancelDownload()); only call it once the file is all there, or
+ *  you're giving up on it. Instances from PHYSFS_createDownloadIo() keep
+ *  working on what arrived until they're destroyed.
+ *
+ *   \param dl the download to let go of. NULL is ignored.
+ *
+ * \sa PHYSFS_createDownload
+ */
+PHYSFS_DECL void PHYSFS_destroyDownload(PHYSFS_Download *dl);
+
+#endif  /* SWIG */
+
+
+/**
+ * \fn void PHYSFS_setMountBlockCache(PHYSFS_uint32 blockSize, PHYSFS_uint32 capacity)
+ * \brief Cache blocks of archives that aren't in memory as they're mounted.
+ *
+ * With (capacity) non-zero, archives mounted afterwards read their data
+ *  through PHYSFS_createCachedIo(io, blockSize, capacity), unless it's
+ *  already in memory (a mapped file, PHYSFS_mountMemory()...) where there's
+ *  nothing to gain. That includes archives from PHYSFS_mount(),
+ *  PHYSFS_mountIo(), PHYSFS_mountHandle() and PHYSFS_mountRange(). Every
+ *  file opened from such an archive shares its cache. Directories, and
+ *  archives opened for writing, don't get one.
+ *
+ * This is disabled by default, and may be set at any time, even before
+ *  PHYSFS_init(). A new value affects archives mounted after it's set.
+ *
+ *   \param blockSize bytes per block, or zero for 64 kilobytes.
+ *   \param capacity most blocks each archive keeps, or zero to not cache.
+ *
+ * \sa PHYSFS_createCachedIo
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL void PHYSFS_setMountBlockCache(PHYSFS_uint32 blockSize,
+                                           PHYSFS_uint32 capacity);
+
+
+/**
+ * \fn void PHYSFS_setNestedInflate(PHYSFS_uint64 maxBytes)
+ * \brief Decompress small nested archives into memory to mount them.
+ *
+ * PHYSFS_mountHandle() reads an inner archive that's stored compressed
+ *  through its handle, so every seek the archiver makes can mean
+ *  decompressing the outer file's entry from the start again. With this
+ *  set, an inner archive of up to (maxBytes), decompressed, that can't be
+ *  read straight out of the outer archive is instead decompressed into
+ *  memory once, when it's mounted, and mounted from there. That memory
+ *  counts as PHYSFS_MEMORY_CACHES until it's unmounted.
+ *
+ * This is zero (disabled) by default, and may be set at any time, even
+ *  before PHYSFS_init(). A new value affects archives mounted after it's
+ *  set.
+ *
+ *   \param maxBytes biggest inner archive to decompress, or zero for none.
+ *
+ * \sa PHYSFS_mountHandle
+ */
+PHYSFS_DECL void PHYSFS_setNestedInflate(PHYSFS_uint64 maxBytes);
+
+
+/**
+ * \fn void PHYSFS_setSlurpOnOpen(PHYSFS_uint64 maxBytes)
+ * \brief Read small files whole when they're opened.
+ *
+ * An open file normally holds on to whatever its archiver opened for it
+ *  until it's closed: a file descriptor for a file in a native directory,
+ *  a decompressor for a compressed one. With this set, PHYSFS_openRead()
+ *  reads a file of up to (maxBytes) into memory right away, lets go of all
+ *  that, and serves reads and seeks from memory until the file is closed.
+ *  For lots of small files each read once, that's far fewer descriptors
+ *  open at once, and reads that are just a copy.
+ *
+ * Memory for the smallest files is reused from file to file. It counts as
+ *  PHYSFS_MEMORY_BUFFERS until the file is closed, and files that would go
+ *  over that category's limit are opened as usual. So are files that can't
+ *  be read when they're opened; their errors show up when you read them.
+ *  A file read this way isn't kept open by PHYSFS_setOpenFileCacheTime().
+ *
+ * This is zero (disabled) by default, and may be set at any time, even
+ *  before PHYSFS_init(). A new value affects files opened after it's set.
+ *
+ *   \param maxBytes biggest file to read when opened, or zero for none.
+ *
+ * \sa PHYSFS_openRead
+ * \sa PHYSFS_setOpenFileCacheTime
+ */
+PHYSFS_DECL void PHYSFS_setSlurpOnOpen(PHYSFS_uint64 maxBytes);
+
+
+/**
+ * \fn void PHYSFS_setMountLimits(PHYSFS_uint32 maxEntries, PHYSFS_uint32 maxPathDepth, PHYSFS_uint32 maxSymlinkHops, PHYSFS_uint64 maxIndexBytes)
+ * \brief Cap what mounting an archive you don't trust can cost.
+ *
+ * How long a ZIP archive takes to mount, and how much memory its index
+ *  needs, is up to whoever made it. If you mount archives from users, set
+ *  these so a hostile one fails to mount instead.
+ *
+ * An archive whose central directory claims more than (maxEntries) entries,
+ *  or more than its size has room for, or an index bigger than
+ *  (maxIndexBytes), fails to mount, before anything is allocated for it.
+ *  The central directory is only parsed when something first looks in the
+ *  archive, though, so the rest is found then: if there turn out to be
+ *  more entries than that (parent dirs the archive doesn't list count
+ *  too), or a path with more than (maxPathDepth) pieces ("a/b/c" is
+ *  three), every lookup in the archive fails with PHYSFS_ERR_UNSUPPORTED,
+ *  or PHYSFS_ERR_OUT_OF_MEMORY if the index outgrows (maxIndexBytes).
+ *  Parsing stops as soon as a limit is hit. Within these limits, it costs
+ *  time in proportion to the central directory times the deepest path.
+ *
+ * A symlink reached through more than (maxSymlinkHops) other symlinks fails
+ *  to open with PHYSFS_ERR_SYMLINK_LOOP, whatever's at the end of it.
+ *
+ * Zero means no limit, except for (maxSymlinkHops), where it means 64, the
+ *  default. The rest are unlimited by default. This may be set at any
+ *  time, even before PHYSFS_init(). New values affect archives mounted
+ *  after they're set.
+ *
+ *   \param maxEntries most entries an archive may have, or zero.
+ *   \param maxPathDepth most pieces a path in an archive may have, or zero.
+ *   \param maxSymlinkHops most symlinks to follow to open one, or zero.
+ *   \param maxIndexBytes most memory an archive's index may use, or zero.
+ *
+ * \sa PHYSFS_mount
+ * \sa PHYSFS_getMemoryUsage
+ */
+PHYSFS_DECL void PHYSFS_setMountLimits(PHYSFS_uint32 maxEntries,
+                                       PHYSFS_uint32 maxPathDepth,
+                                       PHYSFS_uint32 maxSymlinkHops,
+                                       PHYSFS_uint64 maxIndexBytes);
+
+
+/**
+ * \fn void PHYSFS_setFastDeinit(int enabled)
+ * \brief Make PHYSFS_deinit() quick, for when the process is about to exit.
+ *
+ * Tearing down a big search path means freeing every entry of every
+ *  archive's index, which can take a noticeable while, all to hand memory
+ *  back to an OS that's about to reclaim it anyhow.
+ *
+ * With this enabled, PHYSFS_deinit() still flushes and closes the write dir
+ *  and everything open for writing first, and still closes every file and
+ *  socket it holds, but it leaves the indexes, names and other bookkeeping
+ *  where they are instead of freeing them piece by piece. The counts
+ *  PHYSFS_getMemoryUsage() reports start over at zero.
+ *
+ * Only use this if the process exits (or at least never frees the memory
+ *  some other way) soon after PHYSFS_deinit(); otherwise it's a leak. A
+ *  leak checker will report it as one, too.
+ *
+ * This is disabled by default, and may be set at any time, even before
+ *  PHYSFS_init().
+ *
+ *   \param enabled non-zero to skip the frees, zero to do them.
+ *
+ * \sa PHYSFS_deinit
+ */
+PHYSFS_DECL void PHYSFS_setFastDeinit(int enabled);
+
+
+/**
+ * \fn int PHYSFS_pin(const char **paths, PHYSFS_uint32 count)
+ * \brief Keep files in memory for good, so opening them never waits on I/O.
+ *
+ * Each of (paths) is found in the search path as PHYSFS_openRead() would,
+ *  read whole, decompressed, into memory, and kept there. From then on,
+ *  opening it from that archive reads that memory instead, however many
+ *  times it's opened and whatever the caches are doing: pinned files are
+ *  never evicted or trimmed, PHYSFS_setMemoryLimit() or not.
+ *
+ * The memory is locked where the OS allows it (mlock(), VirtualLock()), so
+ *  it isn't paged out either. Locking is limited by the OS (RLIMIT_MEMLOCK,
+ *  the working set size on Windows) and files past that are still pinned,
+ *  just not locked. If you've set an allocator with PHYSFS_setAllocator(),
+ *  pinned files come from it, and aren't locked.
+ *
+ * Pins belong to the archive the file was found in. Unmounting it unpins
+ *  its files, and an archive mounted ahead of it later is searched first,
+ *  as usual. Pinning a file that's already pinned does nothing. Pinned
+ *  bytes are counted in PHYSFS_getMemoryUsage() as PHYSFS_MEMORY_PINNED.
+ *
+ * Files are pinned in order, stopping at the first one that can't be; the
+ *  ones before it stay pinned.
+ *
+ *   \param paths (count) files to pin, in platform-independent notation.
+ *   \param count number of elements in (paths).
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastErrorCode().
+ *
+ * \sa PHYSFS_unpin
+ * \sa PHYSFS_getMemoryUsage
+ */
+PHYSFS_DECL int PHYSFS_pin(const char **paths, PHYSFS_uint32 count);
+
+
+/**
+ * \fn void PHYSFS_unpin(const char **paths, PHYSFS_uint32 count)
+ * \brief Let go of files kept by PHYSFS_pin().
+ *
+ * Each of (paths) is unpinned from every archive it's pinned in. Files open
+ *  from that memory keep reading it until they're closed; later opens go to
+ *  the archive again. Paths that aren't pinned are ignored.
+ *
+ *   \param paths (count) files to unpin, in platform-independent notation.
+ *   \param count number of elements in (paths).
+ *
+ * \sa PHYSFS_pin
+ */
+PHYSFS_DECL void PHYSFS_unpin(const char **paths, PHYSFS_uint32 count);
+
+
+/**
+ * \fn int PHYSFS_createRamDir(const char *name, PHYSFS_uint64 spillLimit, const char *spillDir)
+ * \brief Make a writable directory that lives in memory.
+ *
+ * This makes an empty directory tree, kept in memory, that you can hand to
+ *  PHYSFS_setWriteDir() and PHYSFS_mount() by (name) as if it were a real
+ *  directory, so scratch files never cost any disk I/O. Every mount of it,
+ *  and the write dir, see the same files, as soon as they're written.
+ *  Pick a (name) that isn't a real path, like "ram:scratch"; it's looked
+ *  for before the disk is.
+ *
+ * Files are stored in chunks that grow with them, so writing never moves
+ *  what's already there, and reading them is a copy out of memory, or none
+ *  at all for PHYSFS_mapRead() and the like, if the file is in one piece.
+ *  A file opened for reading stays as it was when it was opened, whatever
+ *  is written to it afterwards.
+ *
+ * When the files would take more than (spillLimit) bytes, a file that
+ *  needs more room is moved to a temporary file in (spillDir), a real
+ *  directory in platform-dependent notation, and carries on there. Without
+ *  a (spillDir), that write fails with PHYSFS_ERR_NO_SPACE instead. A
+ *  (spillLimit) of zero means there's no limit. Spilled files are deleted
+ *  when they're deleted from the RAM directory, or it goes away.
+ *
+ * File contents count in PHYSFS_getMemoryUsage() as PHYSFS_MEMORY_BUFFERS.
+ *
+ *   \param name What to call the directory in PHYSFS_mount() and friends.
+ *   \param spillLimit Bytes of file data to keep in memory, zero for any.
+ *   \param spillDir Where files past (spillLimit) go, or NULL.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastErrorCode();
+ *          PHYSFS_ERR_DUPLICATE if there's a RAM directory by that name.
+ *
+ * \sa PHYSFS_destroyRamDir
+ * \sa PHYSFS_setWriteDir
+ * \sa PHYSFS_mount
+ */
+PHYSFS_DECL int PHYSFS_createRamDir(const char *name,
+                                    PHYSFS_uint64 spillLimit,
+                                    const char *spillDir);
+
+
+/**
+ * \fn int PHYSFS_destroyRamDir(const char *name)
+ * \brief Forget a directory made by PHYSFS_createRamDir().
+ *
+ * (name) can't be mounted or made the write dir after this, and can be
+ *  used for a new RAM directory. If it's mounted or the write dir now, it
+ *  stays there, files and all, until it's unmounted or replaced; then
+ *  everything in it is thrown away. PHYSFS_deinit() does this for every
+ *  RAM directory that's left.
+ *
+ *   \param name The name PHYSFS_createRamDir() was given.
+ *  \return non-zero on success, zero on error. Specifics of the error can
+ *          be gleaned from PHYSFS_getLastErrorCode().
+ *
+ * \sa PHYSFS_createRamDir
+ */
+PHYSFS_DECL int PHYSFS_destroyRamDir(const char *name);
+
 #ifdef __cplusplus
 }
 #endif
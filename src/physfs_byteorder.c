@@ -8,6 +8,16 @@
  *  This file written by Ryan C. Gordon.
  */
 
+/* before physfs_internal.h, which poisons malloc(); <mm_malloc.h> uses it. */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PHYSFS_HAVE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PHYSFS_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
 #define __PHYSICSFS_INTERNAL__
 #include "physfs_internal.h"
 
@@ -108,6 +118,157 @@ PHYSFS_BYTEORDER_READ(sint64, SBE64)
 PHYSFS_BYTEORDER_READ(uint64, UBE64)
 
 
+/*
+ * Byteswap arrays in place. The vector loops do sixteen bytes a step; the
+ *  scalar loop mops up whatever is left (or does it all, without SIMD).
+ */
+static void swapArray16(void *_vals, PHYSFS_uint64 count)
+{
+    PHYSFS_uint16 *vals = (PHYSFS_uint16 *) _vals;
+
+#if PHYSFS_HAVE_SSE2
+    for (; count >= 8; count -= 8, vals += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) vals);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *) vals, v);
+    } /* for */
+#elif PHYSFS_HAVE_NEON
+    for (; count >= 8; count -= 8, vals += 8)
+        vst1q_u16(vals, vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(
+                                                  (const uint8_t *) vals))));
+#endif
+
+    for (; count; count--, vals++)
+        *vals = PHYSFS_Swap16(*vals);
+} /* swapArray16 */
+
+
+static void swapArray32(void *_vals, PHYSFS_uint64 count)
+{
+    PHYSFS_uint32 *vals = (PHYSFS_uint32 *) _vals;
+
+#if PHYSFS_HAVE_SSE2
+    for (; count >= 4; count -= 4, vals += 4)
+    {
+        /* swap the 16-bit halves of each value, then the bytes in each. */
+        __m128i v = _mm_loadu_si128((const __m128i *) vals);
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *) vals, v);
+    } /* for */
+#elif PHYSFS_HAVE_NEON
+    for (; count >= 4; count -= 4, vals += 4)
+        vst1q_u32(vals, vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(
+                                                  (const uint8_t *) vals))));
+#endif
+
+    for (; count; count--, vals++)
+        *vals = PHYSFS_Swap32(*vals);
+} /* swapArray32 */
+
+
+static void swapArray64(void *_vals, PHYSFS_uint64 count)
+{
+    PHYSFS_uint64 *vals = (PHYSFS_uint64 *) _vals;
+
+#ifndef PHYSFS_NO_64BIT_SUPPORT
+#if PHYSFS_HAVE_SSE2
+    for (; count >= 2; count -= 2, vals += 2)
+    {
+        /* reverse the 16-bit words of each value, then the bytes in each. */
+        __m128i v = _mm_loadu_si128((const __m128i *) vals);
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *) vals, v);
+    } /* for */
+#elif PHYSFS_HAVE_NEON
+    for (; count >= 2; count -= 2, vals += 2)
+        vst1q_u64(vals, vreinterpretq_u64_u8(vrev64q_u8(vld1q_u8(
+                                                  (const uint8_t *) vals))));
+#endif
+#endif
+
+    for (; count; count--, vals++)
+        *vals = PHYSFS_Swap64(*vals);
+} /* swapArray64 */
+
+
+static PHYSFS_sint64 readArray(PHYSFS_File *file, void *vals,
+                               const PHYSFS_uint64 count, const size_t size,
+                               void (*swapper)(void *, PHYSFS_uint64))
+{
+    PHYSFS_sint64 rc;
+    PHYSFS_uint64 extra;
+
+#ifdef PHYSFS_NO_64BIT_SUPPORT
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFF);
+#else
+    const PHYSFS_uint64 maxlen = __PHYSFS_UI64(0x7FFFFFFFFFFFFFFF);
+#endif
+
+    BAIL_IF_MACRO((vals == NULL) && count, PHYSFS_ERR_INVALID_ARGUMENT, -1);
+    BAIL_IF_MACRO(count > (maxlen / size), PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    /* one read for the lot, then swap it all in memory. */
+    rc = PHYSFS_readBytes(file, vals, count * size);
+    BAIL_IF_MACRO(rc < 0, ERRPASS, -1);
+
+    /* put back the start of a value the file ended in the middle of. */
+    extra = ((PHYSFS_uint64) rc) % size;
+    if (extra)
+    {
+        const PHYSFS_sint64 pos = PHYSFS_tell(file);
+        if (pos >= 0)
+            PHYSFS_seek(file, ((PHYSFS_uint64) pos) - extra);
+    } /* if */
+
+    rc /= (PHYSFS_sint64) size;
+    if (swapper != NULL)
+        swapper(vals, (PHYSFS_uint64) rc);
+    return rc;
+} /* readArray */
+
+#if PHYSFS_BYTEORDER == PHYSFS_LIL_ENDIAN
+#define swapArrayLE16 NULL
+#define swapArrayLE32 NULL
+#define swapArrayLE64 NULL
+#define swapArrayBE16 swapArray16
+#define swapArrayBE32 swapArray32
+#define swapArrayBE64 swapArray64
+#else
+#define swapArrayLE16 swapArray16
+#define swapArrayLE32 swapArray32
+#define swapArrayLE64 swapArray64
+#define swapArrayBE16 NULL
+#define swapArrayBE32 NULL
+#define swapArrayBE64 NULL
+#endif
+
+#define PHYSFS_BYTEORDER_ARRAY(datatype, order, bits) \
+    void PHYSFS_swapArrayU##order##bits(PHYSFS_##datatype *vals, \
+                                        PHYSFS_uint64 count) { \
+        void (*swapper)(void *, PHYSFS_uint64) = swapArray##order##bits; \
+        if ((swapper != NULL) && (vals != NULL)) \
+            swapper(vals, count); \
+    } \
+    PHYSFS_sint64 PHYSFS_readU##order##bits##Array(PHYSFS_File *file, \
+                                                  PHYSFS_##datatype *vals, \
+                                                  PHYSFS_uint64 count) { \
+        return readArray(file, vals, count, sizeof (PHYSFS_##datatype), \
+                         swapArray##order##bits); \
+    }
+
+PHYSFS_BYTEORDER_ARRAY(uint16, LE, 16)
+PHYSFS_BYTEORDER_ARRAY(uint16, BE, 16)
+PHYSFS_BYTEORDER_ARRAY(uint32, LE, 32)
+PHYSFS_BYTEORDER_ARRAY(uint32, BE, 32)
+PHYSFS_BYTEORDER_ARRAY(uint64, LE, 64)
+PHYSFS_BYTEORDER_ARRAY(uint64, BE, 64)
+
+
 static inline int writeAll(PHYSFS_File *f, const void *val, const size_t len)
 {
     return (PHYSFS_writeBytes(f, val, len) == len);
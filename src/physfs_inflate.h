@@ -0,0 +1,74 @@
+/*
+ * The inflater the ZIP and RAS archivers use, through zlib's names: the
+ *  bundled miniz, or whatever CMake's PHYSFS_INFLATE picked instead. That's
+ *  "zlib" for the system's zlib.h (zlib itself, or zlib-ng built with
+ *  ZLIB_COMPAT), or "zlib-ng" for zlib-ng's native API.
+ *
+ * PHYSFS_INFLATE_STATE_SIZE is how many bytes of a z_stream's state make a
+ *  complete copy of it, which is how ZIP checkpoints and seek index files
+ *  save an inflater partway through an entry. miniz's is flat, so that's
+ *  all of it (and PHYSFS_INFLATE_FLAT_STATE is 1). zlib's points into
+ *  itself, so it's zero there, and ZIP seeks backwards inflate from the
+ *  start of the entry again instead.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#ifndef _INCLUDE_PHYSFS_INFLATE_H_
+#define _INCLUDE_PHYSFS_INFLATE_H_
+
+#ifndef __PHYSICSFS_INTERNAL__
+#error Do not include this header from your applications.
+#endif
+
+#if PHYSFS_INFLATE_ZLIB
+#define ZLIB_CONST  /* so next_in can point at mapped, read-only archives. */
+#include <zlib.h>
+#define PHYSFS_INFLATE_FLAT_STATE 0
+
+#elif PHYSFS_INFLATE_ZLIBNG
+#include <zlib-ng.h>
+#define voidpf void*
+#define uInt unsigned int
+#define z_stream zng_stream
+#define inflateInit2 zng_inflateInit2
+#define inflate zng_inflate
+#define inflateReset zng_inflateReset
+#define inflateEnd zng_inflateEnd
+#define inflateCopy zng_inflateCopy
+#define PHYSFS_INFLATE_FLAT_STATE 0
+
+#else
+#include "physfs_miniz.h"
+#define PHYSFS_INFLATE_FLAT_STATE 1
+#endif
+
+#if PHYSFS_INFLATE_FLAT_STATE
+#define PHYSFS_INFLATE_STATE_SIZE (sizeof (inflate_state))
+#else
+#define PHYSFS_INFLATE_STATE_SIZE 0
+#endif
+
+
+/*
+ * Make (dst), an inflater that's already initialized, a copy of (src) as it
+ *  is now, window and all, but not its next_in/next_out cursors, which are
+ *  the caller's to point at its own buffers. Returns zlib's result code; if
+ *  it isn't Z_OK, (dst) has been ended (its state is NULL), and can only be
+ *  thrown away.
+ */
+static inline int __PHYSFS_inflateCopy(z_stream *dst, z_stream *src)
+{
+#if !PHYSFS_INFLATE_FLAT_STATE
+    /* zlib's state has pointers into itself; it has to do this itself. */
+    inflateEnd(dst);
+    return inflateCopy(dst, src);
+#else
+    memcpy(dst->state, src->state, PHYSFS_INFLATE_STATE_SIZE);
+    return Z_OK;
+#endif
+} /* __PHYSFS_inflateCopy */
+
+#endif  /* _INCLUDE_PHYSFS_INFLATE_H_ */
+
+/* end of physfs_inflate.h ... */
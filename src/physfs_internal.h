@@ -123,12 +123,19 @@ void __PHYSFS_smallFree(void *ptr);
 #ifndef PHYSFS_SUPPORTS_RAS
 #define PHYSFS_SUPPORTS_RAS 0
 #endif
+#ifndef PHYSFS_SUPPORTS_PPK
+#define PHYSFS_SUPPORTS_PPK 0
+#endif
 
 /* The latest supported PHYSFS_Io::version value. */
-#define CURRENT_PHYSFS_IO_API_VERSION 0
+#define CURRENT_PHYSFS_IO_API_VERSION 5
 
 /* The latest supported PHYSFS_Archiver::version value. */
-#define CURRENT_PHYSFS_ARCHIVER_API_VERSION 0
+#define CURRENT_PHYSFS_ARCHIVER_API_VERSION 5
+
+/* The latest supported PHYSFS_AllocatorEx::version value. */
+#define CURRENT_PHYSFS_ALLOCATOR_API_VERSION 0
+#define CURRENT_PHYSFS_INFLATER_API_VERSION 0
 
 /* This byteorder stuff was lifted from SDL. https://www.libsdl.org/ */
 #define PHYSFS_LIL_ENDIAN  1234
@@ -151,22 +158,25 @@ void __PHYSFS_smallFree(void *ptr);
 
 
 /*
- * When sorting the entries in an archive, we use a modified QuickSort.
- *  When there are less then PHYSFS_QUICKSORT_THRESHOLD entries left to sort,
- *  we switch over to a BubbleSort for the remainder. Tweak to taste.
+ * When sorting the entries in an archive, we use an IntroSort (a QuickSort
+ *  that switches to a HeapSort if it's going badly). When there are less
+ *  than PHYSFS_QUICKSORT_THRESHOLD entries left to sort, we switch over to
+ *  an InsertionSort for the remainder. Tweak to taste; it has to be at
+ *  least 2.
  *
  * You can override this setting by defining PHYSFS_QUICKSORT_THRESHOLD
  *  before #including "physfs_internal.h".
  */
 #ifndef PHYSFS_QUICKSORT_THRESHOLD
-#define PHYSFS_QUICKSORT_THRESHOLD 4
+#define PHYSFS_QUICKSORT_THRESHOLD 16
 #endif
 
 /*
- * Sort an array (or whatever) of (max) elements. This uses a mixture of
- *  a QuickSort and BubbleSort internally.
+ * Sort an array (or whatever) of (max) elements. This is O(n log n) in the
+ *  worst case, and doesn't recurse more than O(log n) deep.
  * (cmpfn) is used to determine ordering, and (swapfn) does the actual
- *  swapping of elements in the list.
+ *  swapping of elements in the list. If the elements are big, it's faster
+ *  to sort an array of indices to them and rearrange them after.
  */
 void __PHYSFS_sort(void *entries, size_t max,
                    int (*cmpfn)(void *, size_t, size_t),
@@ -218,6 +228,123 @@ void __PHYSFS_sort(void *entries, size_t max,
 )
 
 
+/*
+ * Atomic increment/decrement of an int, returning the new value, and a full
+ *  memory barrier (the atomic ops are full barriers, too). These are used
+ *  where we want to avoid grabbing stateLock, like the search path lookups
+ *  and refcounts on shared resources (memory Io duplicates, for one).
+ *  Compilers without the right intrinsics fall back to a mutex.
+ */
+#if PHYSFS_MINIMUM_GCC_VERSION(4, 1) || defined(__clang__)
+#define __PHYSFS_ATOMIC_INCR(ptrval) __sync_add_and_fetch(ptrval, 1)
+#define __PHYSFS_ATOMIC_DECR(ptrval) __sync_add_and_fetch(ptrval, -1)
+#define __PHYSFS_MEMORY_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && (_MSC_VER >= 1500)
+#include <intrin.h>
+#define __PHYSFS_ATOMIC_INCR(ptrval) _InterlockedIncrement((volatile long *) (ptrval))
+#define __PHYSFS_ATOMIC_DECR(ptrval) _InterlockedDecrement((volatile long *) (ptrval))
+#define __PHYSFS_MEMORY_BARRIER() __PHYSFS_memoryBarrier()
+void __PHYSFS_memoryBarrier(void);
+#else
+#define PHYSFS_NEED_ATOMIC_OP_FALLBACK 1
+int __PHYSFS_ATOMIC_INCR(volatile int *ptrval);
+int __PHYSFS_ATOMIC_DECR(volatile int *ptrval);
+#define __PHYSFS_MEMORY_BARRIER() __PHYSFS_memoryBarrier()
+void __PHYSFS_memoryBarrier(void);
+#endif
+
+/*
+ * Add to a 64-bit counter without ordering anything else around it, for
+ *  statistics. Without the right intrinsics, it's a plain add, so counts
+ *  might come up a little short if threads race, which is fine for stats.
+ */
+#if PHYSFS_MINIMUM_GCC_VERSION(4, 7) || defined(__clang__)
+#define __PHYSFS_ATOMIC_ADD64(ptrval, val) \
+    __atomic_add_fetch(ptrval, val, __ATOMIC_RELAXED)
+#elif PHYSFS_MINIMUM_GCC_VERSION(4, 1)
+#define __PHYSFS_ATOMIC_ADD64(ptrval, val) __sync_add_and_fetch(ptrval, val)
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700)
+#define __PHYSFS_ATOMIC_ADD64(ptrval, val) \
+    ((PHYSFS_uint64) _InterlockedExchangeAdd64((volatile __int64 *) (ptrval), \
+                                               (__int64) (val)) + (val))
+#else
+#define __PHYSFS_ATOMIC_ADD64(ptrval, val) (*(ptrval) += (val))
+#endif
+
+/*
+ * The counters PHYSFS_getStats() reports. Bump them with __PHYSFS_STAT_ADD()
+ *  and __PHYSFS_STAT_INCR(), like __PHYSFS_STAT_INCR(opens).
+ */
+extern PHYSFS_Stats __PHYSFS_stats;
+#define __PHYSFS_STAT_ADD(field, val) \
+    ((void) __PHYSFS_ATOMIC_ADD64(&__PHYSFS_stats.field, (PHYSFS_uint64) (val)))
+#define __PHYSFS_STAT_INCR(field) __PHYSFS_STAT_ADD(field, 1)
+
+/*
+ * Memory accounting, for PHYSFS_getMemoryUsage() and PHYSFS_setMemoryLimit().
+ *  Every mount gets a __PHYSFS_MemAccount, which archivers can find with
+ *  __PHYSFS_memMountAccount() while their openArchive runs, and keep for
+ *  later. __PHYSFS_memCharge() adds (bytes), negative to give them back,
+ *  to the totals and to (acct), which may be NULL for memory no mount owns.
+ *  Everything charged to an account must be given back before the archive
+ *  closes, since the account goes away with it.
+ */
+typedef struct __PHYSFS_MemAccount __PHYSFS_MemAccount;
+void __PHYSFS_memCharge(__PHYSFS_MemAccount *acct,
+                        PHYSFS_MemoryCategory category, PHYSFS_sint64 bytes);
+
+/* The account of whatever this thread is mounting, NULL if nothing. */
+__PHYSFS_MemAccount *__PHYSFS_memMountAccount(void);
+
+/*
+ * Make (acct) what __PHYSFS_memMountAccount() returns on this thread, for
+ *  opening an archive later on its mount's behalf. Returns what it was, to
+ *  put back after.
+ */
+__PHYSFS_MemAccount *__PHYSFS_memSetMountAccount(__PHYSFS_MemAccount *acct);
+
+/*
+ * Non-zero if (bytes) more in (category) stay under its limit. This is only
+ *  advice: it's checked without a lock, and for things that can do without.
+ */
+int __PHYSFS_memAllowed(PHYSFS_MemoryCategory category, PHYSFS_uint64 bytes);
+
+/* How far over its limit (category) is, zero if it isn't. */
+PHYSFS_uint64 __PHYSFS_memExcess(PHYSFS_MemoryCategory category);
+
+/* What a built __PHYSFS_HashTable's slots take up, for accounting. */
+#define __PHYSFS_hashTableBytes(table) \
+    (((table)->slots == NULL) ? 0 : \
+        (((PHYSFS_uint64) sizeof (__PHYSFS_HashSlot)) << (table)->bits))
+
+/*
+ * Report an event to the app's PHYSFS_TraceHooks, and to the trace capture.
+ *  These cost a test of a global when nobody's listening. Every begin needs
+ *  a matching end. The _AT versions are for reads at (offset), instead of
+ *  at the file's position.
+ */
+extern volatile int __PHYSFS_tracing;
+void __PHYSFS_traceEvent(int begin, PHYSFS_TraceEvent event, const char *path,
+                         PHYSFS_File *file, PHYSFS_sint64 bytes,
+                         PHYSFS_sint64 offset, int success);
+#define __PHYSFS_TRACE_BEGIN(event, path, file, bytes) do { \
+    if (__PHYSFS_tracing) \
+        __PHYSFS_traceEvent(1, event, path, file, bytes, -1, 1); \
+} while (0)
+#define __PHYSFS_TRACE_END(event, path, file, bytes, success) do { \
+    if (__PHYSFS_tracing) \
+        __PHYSFS_traceEvent(0, event, path, file, bytes, -1, success); \
+} while (0)
+#define __PHYSFS_TRACE_BEGIN_AT(event, file, bytes, offset) do { \
+    if (__PHYSFS_tracing) \
+        __PHYSFS_traceEvent(1, event, NULL, file, bytes, offset, 1); \
+} while (0)
+#define __PHYSFS_TRACE_END_AT(event, file, bytes, offset, success) do { \
+    if (__PHYSFS_tracing) \
+        __PHYSFS_traceEvent(0, event, NULL, file, bytes, offset, success); \
+} while (0)
+
+
 /*
  * This is a strcasecmp() or stricmp() replacement that expects both strings
  *  to be in UTF-8 encoding. It will do "case folding" to decide if the
@@ -256,10 +383,137 @@ int __PHYSFS_strnicmpASCII(const char *s1, const char *s2, PHYSFS_uint32 l);
 char *__PHYSFS_strdup(const char *str);
 
 /*
- * Give a hash value for a C string (uses djb's xor hashing algorithm).
+ * Give a hash value for (len) bytes of a string. It's seeded differently
+ *  every run, so don't save it anywhere.
  */
 PHYSFS_uint32 __PHYSFS_hashString(const char *str, size_t len);
 
+/*
+ * The byte-at-a-time CRC-32 table behind PHYSFS_crc32(), for code that has
+ *  to feed the CRC one byte at a time and can't afford a call per byte.
+ *  crc = __PHYSFS_crcByteTable[(crc ^ byte) & 0xFF] ^ (crc >> 8). It's
+ *  filled in by PHYSFS_init().
+ */
+extern const PHYSFS_uint32 *__PHYSFS_crcByteTable;
+
+/*
+ * An open-addressed hash table of 32-bit indices into an array the caller
+ *  owns, for archivers to look up their entries by name. Every slot keeps
+ *  the full hash next to the index, so a probe only has to look at the
+ *  caller's entry (and its name) when the hashes match. Index zero is never
+ *  stored; it means "empty", so it's handy for a root dir that's never
+ *  looked up by hash anyhow.
+ *
+ * Changing the table isn't thread safe, but once it's built, any number of
+ *  threads can search it at once.
+ */
+typedef struct __PHYSFS_HashSlot
+{
+    PHYSFS_uint32 hash;   /* __PHYSFS_hashString() of the entry's name. */
+    PHYSFS_uint32 index;  /* caller's index of that entry, zero if none. */
+} __PHYSFS_HashSlot;
+
+typedef struct __PHYSFS_HashTable
+{
+    __PHYSFS_HashSlot *slots;
+    PHYSFS_uint32 bits;   /* there are (1 << bits) slots.   */
+    PHYSFS_uint32 used;   /* slots with an index in them.   */
+} __PHYSFS_HashTable;
+
+/*
+ * Set up (table) with room for (count) items before it has to grow. Returns
+ *  zero and sets the error state on failure.
+ */
+int __PHYSFS_hashTableInit(__PHYSFS_HashTable *table, PHYSFS_uint64 count);
+
+/*
+ * Free (table)'s slots. It's safe to call this on a zeroed table that was
+ *  never set up.
+ */
+void __PHYSFS_hashTableDeinit(__PHYSFS_HashTable *table);
+
+/*
+ * Add (index), which can't be zero, to (table) under (hash). This doesn't
+ *  check for duplicates. Returns zero and sets the error state if (table)
+ *  had to grow and couldn't, in which case (table) is unchanged.
+ */
+int __PHYSFS_hashTableInsert(__PHYSFS_HashTable *table, PHYSFS_uint32 hash,
+                             PHYSFS_uint32 index);
+
+/*
+ * Find the next index in (table) stored under (hash). (*probe) must be zero
+ *  for the first call; pass it back unchanged to get the next candidate,
+ *  until this returns zero. It's up to the caller to see if the candidate
+ *  is really the one it wants, since different names can hash the same.
+ */
+PHYSFS_uint32 __PHYSFS_hashTableFind(const __PHYSFS_HashTable *table,
+                                     PHYSFS_uint32 hash, PHYSFS_uint32 *probe);
+
+/*
+ * Get (len) bytes for a short-lived object that gets made and thrown away
+ *  over and over, like an open file's PHYSFS_Io and its opaque struct.
+ *  Each thread keeps a few freed blocks of each small size around and hands
+ *  them back out, so opening and closing files doesn't have to go through
+ *  the allocator (and whatever lock it takes) every time. Anything over
+ *  512 bytes just goes to the allocator.
+ *
+ * Blocks can be freed on any thread, but ONLY with __PHYSFS_poolFree(),
+ *  with the same (len) they were allocated with, and never realloc'd.
+ *  Returns NULL and sets the error state if out of memory.
+ */
+void *__PHYSFS_poolAlloc(size_t len);
+
+/*
+ * Give back (ptr), which came from __PHYSFS_poolAlloc(len). NULL is
+ *  ignored. Spares are only returned to the allocator by PHYSFS_deinit().
+ */
+void __PHYSFS_poolFree(void *ptr, size_t len);
+
+/*
+ * A bump allocator for things an archiver keeps as long as it's mounted,
+ *  like entry names: it carves them out of big blocks from the allocator,
+ *  and gives them all back at once, instead of going to the heap once per
+ *  entry. Nothing allocated from it can be freed or resized on its own.
+ *  Allocations are aligned for any PhysicsFS type.
+ *
+ * This isn't thread safe, but an archive's metadata is built by one thread
+ *  before anyone else can see it.
+ */
+typedef union __PHYSFS_ArenaBlock
+{
+    union __PHYSFS_ArenaBlock *next;  /* data starts right after this. */
+    PHYSFS_uint64 align;
+} __PHYSFS_ArenaBlock;
+
+typedef struct __PHYSFS_Arena
+{
+    __PHYSFS_ArenaBlock *blocks;  /* newest first. */
+    size_t used;    /* bytes used in blocks' data so far.  */
+    size_t avail;   /* bytes still free in blocks' data.   */
+    size_t size;    /* bytes of all blocks, for accounting. */
+} __PHYSFS_Arena;
+
+/*
+ * Start (arena) out empty. Nothing's allocated until something's needed,
+ *  so this can't fail, and a zeroed arena is already initialized.
+ */
+void __PHYSFS_arenaInit(__PHYSFS_Arena *arena);
+
+/*
+ * Get (len) bytes from (arena). Returns NULL and sets the error state if
+ *  the allocator fails.
+ */
+void *__PHYSFS_arenaAlloc(__PHYSFS_Arena *arena, size_t len);
+
+/* Copy (str) into (arena), like __PHYSFS_strdup(). */
+char *__PHYSFS_arenaStrdup(__PHYSFS_Arena *arena, const char *str);
+
+/*
+ * Free everything allocated from (arena), and leave it empty again. It's
+ *  safe to call this on an arena that never allocated anything.
+ */
+void __PHYSFS_arenaDeinit(__PHYSFS_Arena *arena);
+
 
 /*
  * The current allocator. Not valid before PHYSFS_init is called!
@@ -269,6 +523,32 @@ extern PHYSFS_Allocator __PHYSFS_AllocatorHooks;
 /* convenience macro to make this less cumbersome internally... */
 #define allocator __PHYSFS_AllocatorHooks
 
+/*
+ * Buffers that data gets copied or decompressed through are aligned to this:
+ *  a cache line, which suits SIMD loads and stores, too.
+ */
+#define __PHYSFS_SIMD_ALIGN 64
+
+/*
+ * Get (len) bytes aligned to (align), a power of two, from the app's
+ *  AlignedMalloc if PHYSFS_setAllocatorEx() gave one, else by padding a
+ *  block from allocator.Malloc(). Like allocator.Malloc(), this returns
+ *  NULL on failure without promising to set an error. Free it with
+ *  __PHYSFS_alignedFree(), with the same (len) and (align), and nothing
+ *  else.
+ */
+void *__PHYSFS_alignedMalloc(size_t len, size_t align);
+
+/* Free memory from __PHYSFS_alignedMalloc(). (ptr) may be NULL. */
+void __PHYSFS_alignedFree(void *ptr, size_t len, size_t align);
+
+/*
+ * allocator.Free(), but the app's FreeSized gets (len), what (ptr) was
+ *  allocated with, if it has one. Not for anything allocator.Realloc()
+ *  touched, since its size is anyone's guess. (ptr) may be NULL.
+ */
+void __PHYSFS_sizedFree(void *ptr, size_t len);
+
 /*
  * Create a PHYSFS_Io for a file in the physical filesystem.
  *  This path is in platform-dependent notation. (mode) must be 'r', 'w', or
@@ -276,6 +556,14 @@ extern PHYSFS_Allocator __PHYSFS_AllocatorHooks;
  */
 PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode);
 
+/*
+ * __PHYSFS_createNativeIo(), but open the file as (relpath) under (dir), a
+ *  handle from __PHYSFS_platformOpenDir(), if (dir) isn't NULL. (path) is
+ *  still the file's full path, for duplicate(). Only mode 'r' can use (dir).
+ */
+PHYSFS_Io *__PHYSFS_createNativeIoAt(void *dir, const char *relpath,
+                                     const char *path, const int mode);
+
 /*
  * Create a PHYSFS_Io for a buffer of memory (READ-ONLY). If you already
  *  have one of these, just use its duplicate() method, and it'll increment
@@ -284,6 +572,87 @@ PHYSFS_Io *__PHYSFS_createNativeIo(const char *path, const int mode);
 PHYSFS_Io *__PHYSFS_createMemoryIo(const void *buf, PHYSFS_uint64 len,
                                    void (*destruct)(void *));
 
+/*
+ * Create a read-only PHYSFS_Io for a file in the physical filesystem that
+ *  is backed by a memory mapping instead of read() calls. This path is in
+ *  platform-dependent notation. Duplicates share the mapping, like
+ *  __PHYSFS_createMemoryIo(). Returns NULL if the file can't be mapped;
+ *  use __PHYSFS_createNativeIo() instead in that case.
+ */
+PHYSFS_Io *__PHYSFS_createMappedIo(const char *path);
+
+/*
+ * Open the archive file at (path), in platform-dependent notation, for
+ *  reading: mapped if possible, native otherwise. If the file ends with an
+ *  embedded archive trailer (see PHYSFS_EMBEDDED_TRAILER_MAGIC), you get a
+ *  slice of just the archive it points to instead of the whole file.
+ */
+PHYSFS_Io *__PHYSFS_createArchiveIo(const char *path);
+
+/*
+ * Make a PHYSFS_Io that reads the (len) bytes of (io) from byte (offset)
+ *  as a dataset of their own. The new instance owns (io) and destroys it
+ *  along with itself, but leaves (io) alone if this fails.
+ */
+PHYSFS_Io *__PHYSFS_createSliceIo(PHYSFS_Io *io, PHYSFS_uint64 offset,
+                                  PHYSFS_uint64 len);
+
+/*
+ * Make a PHYSFS_Io that reads (io) through a cache of up to (capacity)
+ *  (blockSize)-byte blocks, shared by all of its duplicates. The new
+ *  instance owns (io), but leaves it alone if this fails.
+ *  __PHYSFS_uncacheIo() destroys just the cache and hands (io) back, for
+ *  when whatever it was made for didn't work out.
+ */
+PHYSFS_Io *__PHYSFS_createCachedIo(PHYSFS_Io *io, PHYSFS_uint32 blockSize,
+                                   PHYSFS_uint32 capacity);
+PHYSFS_Io *__PHYSFS_uncacheIo(PHYSFS_Io *io);
+
+/*
+ * Call (io)->map() if (io) is new enough to have it and implements it.
+ *  Returns zero (and sets PHYSFS_ERR_UNSUPPORTED if (io) has no map method)
+ *  if the data isn't contiguous in memory. See PHYSFS_Io::map for details.
+ */
+int __PHYSFS_ioMap(PHYSFS_Io *io, const void **ptr, PHYSFS_uint64 *len);
+
+/*
+ * Read (len) bytes at offset (pos) of (io) without moving its i/o position.
+ *  Uses (io)->readAt() if available, otherwise seeks there, reads, and seeks
+ *  back while holding the state lock, so concurrent positional reads are
+ *  safe either way (mixing them with other threads' read() calls is not).
+ *  Returns what read() would.
+ */
+PHYSFS_sint64 __PHYSFS_ioReadAt(PHYSFS_Io *io, void *buf, PHYSFS_uint64 len,
+                                PHYSFS_uint64 pos);
+
+/*
+ * Read into each of (count) buffers in turn from (io)'s i/o position. Uses
+ *  (io)->readv() if available, otherwise read() for each buffer until one
+ *  comes up short. Returns the total bytes read, or -1 if nothing was.
+ */
+PHYSFS_sint64 __PHYSFS_ioReadv(PHYSFS_Io *io, const PHYSFS_IoVec *iov,
+                               PHYSFS_uint32 count);
+
+/*
+ * Pass PHYSFS_AccessHint (hint) for (len) bytes of (io) from (offset), or
+ *  everything from there if (len) is zero, to (io)->advise(). Returns zero
+ *  with PHYSFS_ERR_UNSUPPORTED if (io) has no advise method.
+ */
+int __PHYSFS_ioAdvise(PHYSFS_Io *io, PHYSFS_uint64 offset, PHYSFS_uint64 len,
+                      int hint);
+
+/*
+ * Ask (io)->backing() where (io)'s bytes sit in a real file. Returns zero
+ *  with PHYSFS_ERR_UNSUPPORTED if (io) has no backing method.
+ */
+int __PHYSFS_ioBacking(PHYSFS_Io *io, PHYSFS_FileBacking *backing);
+
+/*
+ * Ask (io)->raw() for an i/o instance reading (io)'s compressed bytes.
+ *  Returns NULL with PHYSFS_ERR_UNSUPPORTED if (io) has no raw method.
+ */
+PHYSFS_Io *__PHYSFS_ioRaw(PHYSFS_Io *io, int *encoding);
+
 
 /*
  * Read (len) bytes from (io) into (buf). Returns non-zero on success,
@@ -291,6 +660,441 @@ PHYSFS_Io *__PHYSFS_createMemoryIo(const void *buf, PHYSFS_uint64 len,
  */
 int __PHYSFS_readAll(PHYSFS_Io *io, void *buf, const PHYSFS_uint64 len);
 
+/*
+ * How many bytes of decompressed data archivers should go between seek
+ *  checkpoints in compressed files, or zero to not keep any. See
+ *  PHYSFS_setSeekIndexInterval().
+ */
+PHYSFS_uint32 __PHYSFS_getSeekIndexInterval(void);
+
+/*
+ * How many bytes of decompressed files each archive may keep cached, or
+ *  zero to not cache any. See PHYSFS_setDecompressionCacheSize().
+ */
+PHYSFS_uint64 __PHYSFS_getDecompressionCacheSize(void);
+
+/*
+ * Memory for what the decompression caches keep: whole decompressed files
+ *  and 7z folders. With PHYSFS_setCacheHugePages() on, and no allocator
+ *  from the app, big buffers go on huge pages; anything else comes from
+ *  allocator.Malloc(). Like that, __PHYSFS_cacheAlloc() returns NULL on
+ *  failure without setting an error. Free these with __PHYSFS_cacheFree()
+ *  and nothing else. They count as PHYSFS_MEMORY_CACHES, in the totals
+ *  until __PHYSFS_cacheOwner() says which mount's they are.
+ */
+void *__PHYSFS_cacheAlloc(size_t len);
+void __PHYSFS_cacheFree(void *ptr);
+void __PHYSFS_cacheOwner(void *ptr, __PHYSFS_MemAccount *acct);
+
+/*
+ * Scratch memory for one decode: packed input, probability tables, and
+ *  the like. __PHYSFS_scratchFree() keeps a few freed blocks in a pool
+ *  every thread shares, so decoding one small folder after another reuses
+ *  them instead of going to the allocator each time. Don't count on what
+ *  they hold. Like __PHYSFS_cacheAlloc(), this returns NULL on failure
+ *  without setting an error. They count as PHYSFS_MEMORY_DECODERS in the
+ *  totals, pooled or not. __PHYSFS_scratchFree() takes NULL.
+ */
+void *__PHYSFS_scratchAlloc(size_t len);
+void __PHYSFS_scratchFree(void *ptr);
+
+/*
+ * Run (fn)(data) on the app's executor, or our thread pool if there isn't
+ *  one, and return a handle to it. Every handle has to go to
+ *  __PHYSFS_waitTask() later. Returns NULL if it can't be started (no
+ *  threads, or out of memory); do the work inline, then.
+ */
+void *__PHYSFS_startTask(void (*fn)(void *), void *data);
+
+/*
+ * Block until (task), from __PHYSFS_startTask(), has run, and free it. If
+ *  nothing has started it yet, it runs here, on the calling thread.
+ */
+void __PHYSFS_waitTask(void *task);
+
+/*
+ * Merge (count) opened archives into an overlay, as PHYSFS_mountOverlay()
+ *  describes: (funcs)[0] and (opaques)[0] are the base, and each after that
+ *  is a patch over the ones before it. Returns the overlay's opaque, for
+ *  __PHYSFS_Archiver_OVERLAY, which closes them all when it's closed. On
+ *  failure, returns NULL and they're still the caller's to close.
+ */
+void *__PHYSFS_createOverlay(const PHYSFS_Archiver **funcs, void **opaques,
+                             const size_t count);
+
+/*
+ * RAM directories, for PHYSFS_createRamDir(). __PHYSFS_ramCreate() makes an
+ *  empty one with one reference, for the caller; __PHYSFS_Archiver_RAM's
+ *  openArchive takes another each time one is mounted, and closeArchive
+ *  gives it back. It's freed, spill files and all, with the last one.
+ *  __PHYSFS_ramLookup() finds the one PHYSFS_createRamDir() named (name),
+ *  with a reference for the caller, or returns NULL without an error.
+ */
+void *__PHYSFS_ramCreate(PHYSFS_uint64 spillLimit, const char *spillDir);
+void __PHYSFS_ramRetain(void *ramdir);
+void __PHYSFS_ramRelease(void *ramdir);
+void *__PHYSFS_ramLookup(const char *name);
+
+/*
+ * Every path an opened archive lists, from its root down, with what it says
+ *  about each; directories always come before what's in them. Fill one in
+ *  with __PHYSFS_listArchive(), which returns zero if it couldn't list it
+ *  all, and free it with __PHYSFS_freeArchiveListing() either way.
+ */
+typedef struct __PHYSFS_ArchiveListing
+{
+    char **paths;
+    PHYSFS_Stat *stats;
+    size_t count;
+    size_t alloced;
+    int failed;
+} __PHYSFS_ArchiveListing;
+
+int __PHYSFS_listArchive(const PHYSFS_Archiver *funcs, void *opaque,
+                         __PHYSFS_ArchiveListing *list);
+void __PHYSFS_freeArchiveListing(__PHYSFS_ArchiveListing *list);
+
+/*
+ * Index snapshots; see archiver_snapshot.c. __PHYSFS_saveIndexSnapshot()
+ *  lists (opaque), archive (funcs) opened from native file (path), which
+ *  (st) describes, into snapshot file (fname). (indexMode) is how it
+ *  matches names, as physfs.c's INDEX_* values.
+ *
+ * __PHYSFS_loadIndexSnapshot() hands back an opaque for
+ *  __PHYSFS_Archiver_SNAPSHOT from (fname), if it's a snapshot of (path)
+ *  that (st) still matches, made by one of (archivers), a NULL-terminated
+ *  list. That one goes in (*funcs), and only opens (path) itself when it
+ *  has to. Otherwise, it returns NULL.
+ */
+int __PHYSFS_saveIndexSnapshot(const char *fname, const char *path,
+                               const PHYSFS_Stat *st,
+                               const PHYSFS_Archiver *funcs, void *opaque,
+                               const int indexMode);
+void *__PHYSFS_loadIndexSnapshot(const char *fname, const char *path,
+                                 const PHYSFS_Stat *st,
+                                 const PHYSFS_Archiver **archivers,
+                                 const PHYSFS_Archiver **funcs);
+
+/*
+ * For __PHYSFS_Archiver_DIR opaques: enumerateFilesStat(), but only the
+ *  filetype is sure to be filled in, as __PHYSFS_platformEnumerateFilesType()
+ *  does it.
+ */
+void __PHYSFS_DIR_enumerateFilesType(void *opaque, const char *dname,
+                                     PHYSFS_EnumFilesStatCallback cb,
+                                     const char *origdir, void *callbackdata);
+
+/*
+ * The same for __PHYSFS_Archiver_ZIP opaques: entries come straight from
+ *  the central directory, without converting their DOS timestamps.
+ */
+void __PHYSFS_zipEnumerateFilesType(void *opaque, const char *dname,
+                                    PHYSFS_EnumFilesStatCallback cb,
+                                    const char *origdir, void *callbackdata);
+
+/* Bytes in a content hash from __PHYSFS_hashContent(). */
+#define __PHYSFS_CONTENT_HASH_LEN 16
+
+/*
+ * Hash (len) bytes at (buf) into (hash), __PHYSFS_CONTENT_HASH_LEN bytes:
+ *  the 128-bit MurmurHash3 (x64 variant, zero seed) of them, h1 then h2,
+ *  each little endian. Archive formats that store content hashes use this.
+ */
+void __PHYSFS_hashContent(const void *buf, PHYSFS_uint64 len,
+                          PHYSFS_uint8 *hash);
+
+/*
+ * The blob cache keeps decompressed files by content hash for every
+ *  mounted archive at once, within the __PHYSFS_getDecompressionCacheSize()
+ *  budget, so a file that several archives ship is decompressed and kept
+ *  only once. Only use it for data whose hash the archive has stored.
+ *
+ * __PHYSFS_blobCacheLookup() hands back a new memoryIo of the blob with
+ *  (hash), __PHYSFS_CONTENT_HASH_LEN bytes, that's (len) bytes long, or NULL
+ *  if it isn't cached. Otherwise, open the file the slow way and pass that
+ *  to __PHYSFS_blobCacheFill(), which reads the whole thing into the cache
+ *  and hands back a memoryIo instead, if it's small enough and its contents
+ *  really hash to (hash). If not, or anything goes wrong, you get (io) back,
+ *  at position zero; NULL only if it couldn't be rewound (and it's gone).
+ */
+PHYSFS_Io *__PHYSFS_blobCacheLookup(const PHYSFS_uint8 *hash,
+                                    const PHYSFS_uint64 len);
+PHYSFS_Io *__PHYSFS_blobCacheFill(const PHYSFS_uint8 *hash, PHYSFS_Io *io);
+
+/*
+ * Inflate (srclen) bytes of raw deflate data at (src) into exactly (dstlen)
+ *  bytes at (dst) with the app's PHYSFS_Inflater, if there is one and it
+ *  wants something this big. Returns zero if it didn't, and then (dst)'s
+ *  contents are undefined and the caller should inflate it itself. Never
+ *  sets an error. Any thread may call this.
+ */
+int __PHYSFS_offloadInflate(const void *src, const PHYSFS_uint64 srclen,
+                            void *dst, const PHYSFS_uint64 dstlen);
+
+/*
+ * Non-zero if this thread is servicing an async read that's been cancelled
+ *  with PHYSFS_cancelAsync(). Long decompression loops check it between
+ *  chunks, and give up with PHYSFS_ERR_CANCELLED.
+ */
+int __PHYSFS_asyncCancelled(void);
+
+/*
+ * The spill cache keeps decompressed data in files, in the directory from
+ *  PHYSFS_setSpillCacheDir(), so what falls out of the decompression cache
+ *  can be mapped back in instead of decompressed again. Data is found by
+ *  (key), (keylen) bytes that have to identify the content itself, not just
+ *  where it came from (a stored checksum and the size, say), since spill
+ *  files can outlive the archive they came from.
+ *
+ * __PHYSFS_spillLoad() maps the (len) bytes saved under (key), points (ptr)
+ *  at them, and returns a mapping for __PHYSFS_platformUnmapFile(), or NULL
+ *  if there's nothing saved (or no spill dir). __PHYSFS_spillSave() saves
+ *  (len) bytes at (buf) under (key), if it isn't saved already. Neither one
+ *  ever sets an error; spilling is only ever an optimization.
+ */
+void *__PHYSFS_spillLoad(const void *key, const size_t keylen,
+                         const PHYSFS_uint64 len, const void **ptr);
+void __PHYSFS_spillSave(const void *key, const size_t keylen,
+                        const void *buf, const PHYSFS_uint64 len);
+
+/*
+ * How many 2048-byte sectors each mounted disc image may keep cached, or
+ *  zero to not cache any. See PHYSFS_setSectorCacheSize().
+ */
+PHYSFS_uint32 __PHYSFS_getSectorCacheSize(void);
+
+/*
+ * Non-zero if archivers should do the work they'd otherwise put off until
+ *  each file's first open while mounting. See PHYSFS_setResolveOnMount().
+ */
+int __PHYSFS_getResolveOnMount(void);
+
+/*
+ * Non-zero while PHYSFS_deinit() is tearing things down for an app that
+ *  called PHYSFS_setFastDeinit(): closeArchive should destroy its Ios, so
+ *  files and sockets get closed, and can skip freeing everything else.
+ */
+int __PHYSFS_isFastDeinit(void);
+
+/*
+ * What PHYSFS_setMountLimits() allows an archive being mounted now. Zero
+ *  means no limit, except for (*maxSymlinkHops), which is never zero.
+ */
+void __PHYSFS_getMountLimits(PHYSFS_uint32 *maxEntries,
+                             PHYSFS_uint32 *maxPathDepth,
+                             PHYSFS_uint32 *maxSymlinkHops,
+                             PHYSFS_uint64 *maxIndexBytes);
+
+/*
+ * A file's CRC-32, worked out as it's read, for PHYSFS_setVerifyChecksums().
+ *  Archivers keep one per open file, __PHYSFS_crcCheckInit() it when it's
+ *  opened, and pass everything read through __PHYSFS_crcCheckRead(). Reads
+ *  that don't carry on from the last are skipped, so seeking around is
+ *  fine, but only a file read start to finish gets checked.
+ */
+typedef struct __PHYSFS_CrcCheck
+{
+    PHYSFS_uint64 pos;  /* (crc) covers this many bytes from the start. */
+    PHYSFS_uint32 crc;  /* PHYSFS_crc32() of those. */
+    int checking;  /* non-zero until the end is reached, if it's enabled. */
+    int failed;  /* non-zero if the end was reached and it didn't match. */
+} __PHYSFS_CrcCheck;
+
+void __PHYSFS_crcCheckInit(__PHYSFS_CrcCheck *check);
+
+/*
+ * Add (len) bytes read from (offset) at (buf) to (check), for a file that's
+ *  (filelen) bytes long and should have a CRC-32 of (expected). Returns
+ *  zero, with PHYSFS_ERR_CORRUPT set, if this read reaches the end of the
+ *  file and the file's checksum doesn't match.
+ */
+int __PHYSFS_crcCheckRead(__PHYSFS_CrcCheck *check, const void *buf,
+                          const PHYSFS_uint64 len, const PHYSFS_uint64 offset,
+                          const PHYSFS_uint64 filelen,
+                          const PHYSFS_uint32 expected);
+
+/*
+ * Non-zero if archivers that can write should compress what they write.
+ *  See PHYSFS_setWriteCompression().
+ */
+int __PHYSFS_getWriteCompression(void);
+
+/*
+ * Rename (src) to (dst), both in platform-independent notation, in a
+ *  directory the DIR archiver opened as (opaque), replacing (dst). See
+ *  __PHYSFS_platformRename().
+ */
+int __PHYSFS_DIR_rename(void *opaque, const char *src, const char *dst);
+
+/*
+ * __PHYSFS_platformSyncPath() on (name), in platform-independent notation,
+ *  in a directory the DIR archiver opened as (opaque). "" is the directory
+ *  itself.
+ */
+int __PHYSFS_DIR_sync(void *opaque, const char *name);
+
+/*
+ * __PHYSFS_platformSyncData() on file (name), in platform-independent
+ *  notation, in a directory the DIR archiver opened as (opaque).
+ */
+int __PHYSFS_DIR_syncData(void *opaque, const char *name);
+
+/*
+ * __PHYSFS_platformSyncFilesystem() on the directory the DIR archiver
+ *  opened as (opaque).
+ */
+int __PHYSFS_DIR_syncFilesystem(void *opaque);
+
+#if PHYSFS_SUPPORTS_ZIP
+/*
+ * Write the seek index for the native zip file (archive), with checkpoints
+ *  every (interval) bytes. See PHYSFS_buildSeekIndex().
+ */
+int __PHYSFS_zipBuildSeekIndex(const char *archive,
+                               const PHYSFS_uint32 interval);
+
+/*
+ * Rewrite the native zip file (archive) without the space that replaced
+ *  and deleted entries left behind. See PHYSFS_compactArchive().
+ */
+int __PHYSFS_zipCompact(const char *archive);
+
+/*
+ * If (io) is a file from a ZIP archive, not read from yet, that
+ *  __PHYSFS_zipDecodeRaw() can do all at once, say where its data is in the
+ *  archive: (*len) bytes at (*pos) in (*src), encoded as (*encoding), a
+ *  PHYSFS_Encoding. Files from the same archive get the same (*archive).
+ *  Returns zero, without setting an error, if (io) has to be read the
+ *  usual way.
+ */
+int __PHYSFS_zipGetRawSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len, int *encoding);
+
+/*
+ * Decode all of (io), which __PHYSFS_zipGetRawSpan() said yes to, into
+ *  (buf) from (raw), the data where it said, leaving (io) at the end of the
+ *  file. This doesn't touch (*src), so it can be reading other files' data
+ *  meanwhile. Returns zero if the data is bad, leaving (io) to be read the
+ *  usual way, which will report the problem.
+ */
+int __PHYSFS_zipDecodeRaw(PHYSFS_Io *io, const void *raw, void *buf);
+#endif
+
+#if PHYSFS_SUPPORTS_PPK
+/*
+ * If (io) is a compressed file from a PPK archive, not read from yet, say
+ *  where its compressed data is: (*len) bytes at (*pos) in (*src), which
+ *  is only ever read with __PHYSFS_ioReadAt(), encoded as (*encoding), a
+ *  PHYSFS_Encoding. Files from the same archive get the same (*archive).
+ *  Returns zero, without setting an error, if it isn't one of those.
+ */
+int __PHYSFS_ppkGetRawSpan(PHYSFS_Io *io, const void **archive,
+                           PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                           PHYSFS_uint64 *len, int *encoding);
+#endif
+
+/*
+ * If (io) is a file stored in its archive as it is, byte for byte, say
+ *  where: (*len) bytes at (*pos) in (*src), which is only ever read with
+ *  __PHYSFS_ioReadAt(). Files from the same archive get the same
+ *  (*archive), so reads of several can be merged into one. It doesn't
+ *  matter where (io)'s read position is. Returns zero, without setting an
+ *  error, if it isn't one of those; files in archives that are in memory
+ *  anyway may not be.
+ */
+int __PHYSFS_unpkGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                               PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                               PHYSFS_uint64 *len);
+#if PHYSFS_SUPPORTS_ZIP
+int __PHYSFS_zipGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len);
+#endif
+#if PHYSFS_SUPPORTS_RAS
+int __PHYSFS_rasGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len);
+#endif
+#if PHYSFS_SUPPORTS_PPK
+int __PHYSFS_ppkGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                              PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                              PHYSFS_uint64 *len);
+#endif
+#if PHYSFS_SUPPORTS_7Z
+int __PHYSFS_lzmaGetStoredSpan(PHYSFS_Io *io, const void **archive,
+                               PHYSFS_Io **src, PHYSFS_uint64 *pos,
+                               PHYSFS_uint64 *len);
+#endif
+
+/*
+ * Check (buf), all (len) bytes of (io)'s file, got some way other than
+ *  reading (io), against the file's CRC-32, as reading it through (io) to
+ *  the end would have if PHYSFS_setVerifyChecksums() was on when it was
+ *  opened. Returns zero, with PHYSFS_ERR_CORRUPT set, if it doesn't match,
+ *  and reading (io) to the end fails from then on, too. Returns non-zero
+ *  if it matches, or there's nothing to check it against.
+ */
+#if PHYSFS_SUPPORTS_ZIP
+int __PHYSFS_zipCheckWhole(PHYSFS_Io *io, const void *buf, PHYSFS_uint64 len);
+#endif
+#if PHYSFS_SUPPORTS_7Z
+int __PHYSFS_lzmaCheckWhole(PHYSFS_Io *io, const void *buf, PHYSFS_uint64 len);
+#endif
+
+#if PHYSFS_SUPPORTS_7Z
+/*
+ * If (io) is a file from a 7z archive whose folder (solid block) isn't
+ *  cached, say which: folder number (*folder) of (*archive), (*len) bytes
+ *  decompressed, kept in (*src). Files in the same archive get the same
+ *  (*archive). Returns zero, without setting an error, if there's nothing
+ *  to decompress. Call with stateLock held.
+ */
+int __PHYSFS_lzmaGetFolder(PHYSFS_Io *io, void **archive, PHYSFS_Io **src,
+                           PHYSFS_uint32 *folder, PHYSFS_uint64 *len);
+
+/*
+ * Decompress all of folder (folder) of (archive) from what
+ *  __PHYSFS_lzmaGetFolder() said, reading (src) only with
+ *  __PHYSFS_ioReadAt(), into a new buffer at (*buf), (*len) bytes. This
+ *  changes nothing, so several can run on different threads at once, even
+ *  on the same (src). Returns zero on failure, with the error set.
+ */
+int __PHYSFS_lzmaDecodeFolder(const void *archive, PHYSFS_uint32 folder,
+                              PHYSFS_Io *src, void **buf, size_t *len);
+
+/*
+ * Put (buf), from __PHYSFS_lzmaDecodeFolder(), in (archive)'s folder cache,
+ *  or free it if that folder's been cached since. (archive) must still be
+ *  mounted.
+ */
+void __PHYSFS_lzmaCacheFolder(void *archive, PHYSFS_uint32 folder,
+                              void *buf, size_t len);
+
+/*
+ * If (io) is a file from a 7z archive, say where it is: (*offset) bytes into
+ *  folder (*folder) of (*archive). Files from the same archive get the same
+ *  (*archive). Returns zero, without setting an error, if (io) isn't one.
+ */
+int __PHYSFS_lzmaGetFileSpan(PHYSFS_Io *io, const void **archive,
+                             PHYSFS_uint32 *folder, PHYSFS_uint64 *offset);
+
+/*
+ * Decompress the folder of (io), which __PHYSFS_lzmaGetFileSpan() said yes
+ *  to, and keep it cached, over the cache budget if need be, until
+ *  __PHYSFS_lzmaReleaseFolder(). Returns zero if it wasn't held: it's too
+ *  big to cache and gets streamed instead, or it couldn't be decompressed,
+ *  in which case reading it will say so.
+ */
+int __PHYSFS_lzmaHoldFolder(PHYSFS_Io *io);
+
+/*
+ * Let go of what __PHYSFS_lzmaHoldFolder() held, through (io) or another
+ *  file in the same folder.
+ */
+void __PHYSFS_lzmaReleaseFolder(PHYSFS_Io *io);
+#endif
+
 
 /* These are shared between some archivers. */
 
@@ -306,12 +1110,28 @@ void *UNPK_openArchive(PHYSFS_Io *io,UNPKentry *e,const PHYSFS_uint32 n);
 void UNPK_enumerateFiles(void *opaque, const char *dname,
                          PHYSFS_EnumFilesCallback cb,
                          const char *origdir, void *callbackdata);
+void UNPK_enumerateFilesStat(void *opaque, const char *dname,
+                             PHYSFS_EnumFilesStatCallback cb,
+                             const char *origdir, void *callbackdata);
+void UNPK_enumerateFilesPrefix(void *opaque, const char *dname,
+                               const char *prefix,
+                               PHYSFS_EnumFilesCallback cb,
+                               const char *origdir, void *callbackdata);
 PHYSFS_Io *UNPK_openRead(void *opaque, const char *name);
 PHYSFS_Io *UNPK_openWrite(void *opaque, const char *name);
 PHYSFS_Io *UNPK_openAppend(void *opaque, const char *name);
 int UNPK_remove(void *opaque, const char *name);
 int UNPK_mkdir(void *opaque, const char *name);
 int UNPK_stat(void *opaque, const char *fn, PHYSFS_Stat *st);
+int UNPK_layout(void *opaque, const char *fn, PHYSFS_EntryLayout *layout);
+
+/*
+ * Read (count) fixed-size directory records of (recLen) bytes each from
+ *  (io)'s current position with a single read, so loaders can parse them
+ *  from memory instead of reading a few bytes at a time. Returns a buffer
+ *  to allocator.Free() when done, or NULL on error.
+ */
+void *UNPK_readTable(PHYSFS_Io *io, PHYSFS_uint32 count, PHYSFS_uint32 recLen);
 
 
 /*--------------------------------------------------------------------------*/
@@ -422,6 +1242,68 @@ void *__PHYSFS_platformOpenAppend(const char *filename);
  */
 PHYSFS_sint64 __PHYSFS_platformRead(void *opaque, void *buf, PHYSFS_uint64 len);
 
+/*
+ * Read up to (len) bytes from a platform-specific file handle into (buf),
+ *  starting at byte offset (pos), like pread(). This must not change the
+ *  file pointer that __PHYSFS_platformRead() and friends use, and it must
+ *  be safe to call from several threads at once on the same handle.
+ *  Returns the number of bytes read (short at EOF), or (-1) on total
+ *  failure, after calling PHYSFS_setErrorCode().
+ */
+PHYSFS_sint64 __PHYSFS_platformReadAt(void *opaque, void *buf,
+                                      PHYSFS_uint64 len, PHYSFS_uint64 pos);
+
+/*
+ * Read into each of (count) buffers in turn, like __PHYSFS_platformRead()
+ *  does for one, and leave the file pointer after the last byte read.
+ *  Platforms without readv() can loop over __PHYSFS_platformRead(). Returns
+ *  the total bytes read (short at EOF), or (-1) if nothing could be read,
+ *  after calling PHYSFS_setErrorCode().
+ */
+PHYSFS_sint64 __PHYSFS_platformReadv(void *opaque, const PHYSFS_IoVec *iov,
+                                     PHYSFS_uint32 count);
+
+/*
+ * One read for __PHYSFS_platformReadBatch(). The platform fills in (result)
+ *  with what __PHYSFS_platformReadAt() would have returned, and (error)
+ *  with the error code if that's (-1).
+ */
+typedef struct
+{
+    void *opaque;  /* from __PHYSFS_platformOpenRead(). */
+    void *buffer;
+    PHYSFS_uint64 len;
+    PHYSFS_uint64 pos;
+    PHYSFS_sint64 result;
+    PHYSFS_ErrorCode error;
+} __PHYSFS_PlatformReadRequest;
+
+/*
+ * Do every read in (reqs), in any order and possibly all at once, and
+ *  return when they're all done. Report errors through each request's
+ *  (error) field; the calling thread's error state doesn't matter after.
+ *
+ * Platforms without a way to batch reads just loop over
+ *  __PHYSFS_platformReadAt(); PhysicsFS won't batch reads for them unless
+ *  __PHYSFS_platformInitBatchIo() said it could.
+ */
+void __PHYSFS_platformReadBatch(__PHYSFS_PlatformReadRequest *reqs,
+                                PHYSFS_uint32 count);
+
+/*
+ * Called by PHYSFS_init(), after the mutexes exist. If (wanted) is non-zero,
+ *  the app asked for the kernel's batched I/O (io_uring on Linux); set it up
+ *  and return non-zero if that worked. Return zero if it wasn't wanted,
+ *  isn't available, or failed; this can't fail PHYSFS_init().
+ */
+int __PHYSFS_platformInitBatchIo(int wanted);
+
+/*
+ * Called by PHYSFS_deinit(), if __PHYSFS_platformInitBatchIo() returned
+ *  non-zero. Nothing will be using it anymore.
+ */
+void __PHYSFS_platformDeinitBatchIo(void);
+
 /*
  * Write more data to a platform-specific file handle. (opaque) should be
  *  cast to whatever data type your platform uses. Write a maximum of (len)
@@ -479,6 +1361,29 @@ PHYSFS_sint64 __PHYSFS_platformFileLength(void *handle);
  */
 int __PHYSFS_platformStat(const char *fn, PHYSFS_Stat *stat);
 
+/*
+ * Hold directory (dirname), in platform-dependent notation, open, so
+ *  __PHYSFS_platformStatAt() and __PHYSFS_platformOpenReadAt() can find
+ *  things relative to it without the OS walking the whole path each time.
+ *  Return NULL if you can't or don't want to; the caller goes on using full
+ *  paths, so don't set an error code. The handle still points at the same
+ *  directory if it's renamed later.
+ */
+void *__PHYSFS_platformOpenDir(const char *dirname);
+
+/*
+ * Let go of a handle from __PHYSFS_platformOpenDir().
+ */
+void __PHYSFS_platformCloseDir(void *dir);
+
+/*
+ * __PHYSFS_platformStat() and __PHYSFS_platformOpenRead(), for (relpath)
+ *  under (dir), a handle from __PHYSFS_platformOpenDir(). (relpath) uses
+ *  '/' between path elements and is "." for (dir) itself.
+ */
+int __PHYSFS_platformStatAt(void *dir, const char *relpath, PHYSFS_Stat *st);
+void *__PHYSFS_platformOpenReadAt(void *dir, const char *relpath);
+
 /*
  * Flush any pending writes to disk. (opaque) should be cast to whatever data
  *  type your platform uses. Be sure to check for errors; the caller expects
@@ -488,6 +1393,52 @@ int __PHYSFS_platformStat(const char *fn, PHYSFS_Stat *stat);
  */
 int __PHYSFS_platformFlush(void *opaque);
 
+/*
+ * Tell the OS how (len) bytes of file (opaque) from (pos) will be read, or
+ *  everything from there if (len) is zero. (hint) is a PHYSFS_AccessHint.
+ *  This can't change what reads return. Return non-zero if the OS took the
+ *  hint, or zero with an error code if it can't be told.
+ */
+int __PHYSFS_platformAdvise(void *opaque, PHYSFS_uint64 pos,
+                            PHYSFS_uint64 len, int hint);
+
+/*
+ * Set (backing)->fd or (backing)->handle, whichever this platform uses, to
+ *  the OS's own handle for file (opaque), and the other one to -1 or NULL.
+ *  Leave the rest of (backing) alone. Return zero with an error code if
+ *  there's no such thing to hand out.
+ */
+int __PHYSFS_platformFileBacking(void *opaque, PHYSFS_FileBacking *backing);
+
+/*
+ * Copy up to (len) bytes, from (src)->offset in (src)->fd or (src)->handle,
+ *  into file (dst), opened for writing, at its file position, without them
+ *  passing through us: in the kernel, or by sharing blocks on filesystems
+ *  that can. This may copy less than (len); call it again for the rest.
+ *  Return the number of bytes copied, or -1 with an error code;
+ *  PHYSFS_ERR_UNSUPPORTED means it can't be done that way here at all, so
+ *  copy it by hand.
+ */
+PHYSFS_sint64 __PHYSFS_platformCopyRange(const PHYSFS_FileBacking *src,
+                                         PHYSFS_uint64 len, void *dst);
+
+/*
+ * Reads that skip the OS's cache have to start on, and be a multiple of,
+ *  this many bytes, into memory aligned the same way. That covers the
+ *  sector size of anything we're likely to see.
+ */
+#define __PHYSFS_DIRECT_IO_ALIGN 4096
+
+/*
+ * Make reads from file (opaque), opened for reading, skip the OS's cache,
+ *  or go back to normal if (enable) is zero. While it's on, PhysicsFS only
+ *  reads it with __PHYSFS_platformReadAt(), with everything lined up to
+ *  __PHYSFS_DIRECT_IO_ALIGN, although a read may run past the end of the
+ *  file. The file pointer may be anywhere afterwards. Return zero with an
+ *  error code if the OS or the filesystem can't do it.
+ */
+int __PHYSFS_platformSetDirectIo(void *opaque, int enable);
+
 /*
  * Close file and deallocate resources. (opaque) should be cast to whatever
  *  data type your platform uses. This should close the file in any scenario:
@@ -498,6 +1449,77 @@ int __PHYSFS_platformFlush(void *opaque);
  */
 void __PHYSFS_platformClose(void *opaque);
 
+/*
+ * Map an entire file into memory, read-only. (filename) is in platform-
+ *  dependent notation. On success, (*ptr) points to the file's contents,
+ *  (*len) is filled in with the file length, and an opaque handle
+ *  is returned that should be passed to __PHYSFS_platformUnmapFile() later.
+ *
+ * The mapping holds its own reference to the file, but keep the file open
+ *  anyhow if __PHYSFS_platformMappingBacking() needs it. Return NULL and
+ *  call PHYSFS_setErrorCode() if the file can't (or shouldn't) be mapped,
+ *  such as zero-length files or files too large for the address space. The caller falls back to
+ *  __PHYSFS_platformOpenRead() in that case, so this is never fatal.
+ */
+void *__PHYSFS_platformMapFile(const char *filename, const void **ptr,
+                               PHYSFS_uint64 *len);
+
+/*
+ * Release a mapping returned by __PHYSFS_platformMapFile(). The pointer
+ *  it handed back is invalid after this call. This should never fail.
+ */
+void __PHYSFS_platformUnmapFile(void *mapping);
+
+/*
+ * Like __PHYSFS_platformFileBacking(), but for the file behind (mapping),
+ *  from __PHYSFS_platformMapFile(). The handle has to stay open until the
+ *  mapping is released.
+ */
+int __PHYSFS_platformMappingBacking(void *mapping,
+                                    PHYSFS_FileBacking *backing);
+
+/*
+ * Cache buffers at least this big are worth putting on huge pages; it's
+ *  the usual huge page size, too.
+ */
+#define __PHYSFS_HUGE_PAGE_MIN (2 * 1024 * 1024)
+
+/*
+ * Get (len) bytes of zeroed, read/write memory backed by huge pages, or at
+ *  least memory the OS is encouraged to back with them. (len) is at least
+ *  __PHYSFS_HUGE_PAGE_MIN. Return NULL, without setting an error, if the
+ *  platform can't; the caller falls back to allocator.Malloc().
+ */
+void *__PHYSFS_platformAllocHuge(size_t len);
+
+/*
+ * Release memory from __PHYSFS_platformAllocHuge(). (len) is what was asked
+ *  for. This should never fail.
+ */
+void __PHYSFS_platformFreeHuge(void *ptr, size_t len);
+
+/*
+ * Get (len) bytes of read/write memory that's locked in RAM, so it's never
+ *  paged out (mlock(), VirtualLock()...). Return NULL, without setting an
+ *  error, if the platform can't or won't, like when it's over the process's
+ *  limit on locked memory; the caller falls back to allocator.Malloc().
+ */
+void *__PHYSFS_platformAllocLocked(size_t len);
+
+/*
+ * Unlock and release memory from __PHYSFS_platformAllocLocked(). (len) is
+ *  what was asked for. This should never fail.
+ */
+void __PHYSFS_platformFreeLocked(void *ptr, size_t len);
+
+/*
+ * __PHYSFS_platformAdvise(), for (len) bytes at (ptr), which is somewhere
+ *  inside (mapping), from __PHYSFS_platformMapFile(). (len) is never zero.
+ *  Neither gets PHYSFS_ACCESS_STREAM; that's handled before it gets here.
+ */
+int __PHYSFS_platformAdviseMapping(void *mapping, const void *ptr,
+                                   PHYSFS_uint64 len, int hint);
+
 /*
  * Platform implementation of PHYSFS_getCdRomDirsCallback()...
  *  CD directories are discovered and reported to the callback one at a time.
@@ -507,6 +1529,15 @@ void __PHYSFS_platformClose(void *opaque);
  */
 void __PHYSFS_platformDetectAvailableCDs(PHYSFS_StringCallback cb, void *data);
 
+/*
+ * Return non-zero if the discs __PHYSFS_platformDetectAvailableCDs() would
+ *  report might have changed since this was last called, and zero if
+ *  they're certainly the same, so PhysicsFS can keep reporting what it
+ *  found last time. Platforms that can't tell cheaply should always return
+ *  non-zero. The first call should set up whatever later ones check.
+ */
+int __PHYSFS_platformCdRomsChanged(void);
+
 /*
  * Calculate the base dir, if your platform needs special consideration.
  *  Just return NULL if the standard routines will suffice. (see
@@ -562,6 +1593,30 @@ void __PHYSFS_platformEnumerateFiles(const char *dirname,
                                      const char *origdir,
                                      void *callbackdata);
 
+/*
+ * Enumerate a directory of files like __PHYSFS_platformEnumerateFiles(),
+ *  but also report each entry's metadata, as __PHYSFS_platformStat() would
+ *  fill it in. Use whatever the directory listing itself provides where you
+ *  can, so this is cheaper than a stat per name. Entries you can't get
+ *  metadata for are skipped.
+ */
+void __PHYSFS_platformEnumerateFilesStat(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata);
+
+/*
+ * Like __PHYSFS_platformEnumerateFilesStat(), but the caller only needs
+ *  each entry's filetype. Fill that in from the listing alone where it
+ *  says, and set everything else to -1, so there's no stat per entry; stat
+ *  the ones the listing can't tell you about. If the listing already has
+ *  full metadata, just call __PHYSFS_platformEnumerateFilesStat().
+ */
+void __PHYSFS_platformEnumerateFilesType(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata);
+
 /*
  * Make a directory in the actual filesystem. (path) is specified in
  *  platform-dependent notation. On error, return zero and set the error
@@ -583,6 +1638,47 @@ int __PHYSFS_platformMkDir(const char *path);
  */
 int __PHYSFS_platformDelete(const char *path);
 
+/*
+ * Rename (src) to (dst), both in platform-dependent notation and in the
+ *  same directory, replacing (dst) if it exists. If the filesystem can do
+ *  that in one step, so that anything opening (dst) sees either the old
+ *  file or the new one, do it that way.
+ *
+ * On error, return zero and set the error message. Return non-zero on success.
+ */
+int __PHYSFS_platformRename(const char *src, const char *dst);
+
+/*
+ * Make sure everything written to (path), a file or a directory in
+ *  platform-dependent notation, is on the disk and not just in the OS's
+ *  cache; for a directory, that's which files are in it. Platforms whose
+ *  filesystems don't need this for directories can just report success.
+ *
+ * On error, return zero and set the error message. Return non-zero on success.
+ */
+int __PHYSFS_platformSyncPath(const char *path);
+
+/*
+ * Like __PHYSFS_platformSyncPath(), for a file, but only what's needed to
+ *  read its data back: its contents and size, but not, say, its timestamps,
+ *  if the platform can skip those. Platforms that can't tell the difference
+ *  can just do __PHYSFS_platformSyncPath().
+ *
+ * On error, return zero and set the error message. Return non-zero on success.
+ */
+int __PHYSFS_platformSyncData(const char *path);
+
+/*
+ * Make sure everything written to the filesystem that (path), a directory
+ *  in platform-dependent notation, is on is on the disk, in one call. This
+ *  is for syncing many files at once, when one big flush is cheaper than
+ *  one per file. Platforms that can't do this fail with
+ *  PHYSFS_ERR_UNSUPPORTED, and get synced a file at a time.
+ *
+ * On error, return zero and set the error message. Return non-zero on success.
+ */
+int __PHYSFS_platformSyncFilesystem(const char *path);
+
 
 /*
  * Create a platform-specific mutex. This can be whatever datatype your
@@ -630,6 +1726,173 @@ int __PHYSFS_platformGrabMutex(void *mutex);
  */
 void __PHYSFS_platformReleaseMutex(void *mutex);
 
+/*
+ * Like __PHYSFS_platformGrabMutex(), but return zero at once instead of
+ *  waiting if another thread has the mutex. Returns non-zero if the mutex
+ *  is now held (recursively, if this thread already had it).
+ */
+int __PHYSFS_platformTryGrabMutex(void *mutex);
+
+/*
+ * Create a platform-specific reader-writer lock, cast to a (void *) like a
+ *  mutex. Any number of threads can hold it shared at once, but only one
+ *  can hold it exclusive, and then nobody holds it shared. Platforms that
+ *  can't do better can hand out a plain mutex and treat both kinds of grab
+ *  the same; it's only slower.
+ *
+ * Unlike mutexes, these are NOT recursive: a thread must not grab one it
+ *  already holds, either way, and can't turn a shared hold into an exclusive
+ *  one; let go and grab it exclusive, then check again whatever it was that
+ *  made you want to write.
+ *
+ * Return (NULL) if you couldn't create one. Systems without threads can
+ *  return any arbitrary non-NULL value.
+ */
+void *__PHYSFS_platformCreateRWLock(void);
+
+/*
+ * Destroy a lock from __PHYSFS_platformCreateRWLock(). Nobody may hold it.
+ */
+void __PHYSFS_platformDestroyRWLock(void *rwlock);
+
+/*
+ * Grab (rwlock) shared, for reading, blocking while someone has it
+ *  exclusive. Return zero only on unrecoverable system errors. The same
+ *  _DO NOT_ call PHYSFS_setErrorCode() rule as platformGrabMutex applies.
+ */
+int __PHYSFS_platformGrabRWLockShared(void *rwlock);
+
+/*
+ * Let go of a shared grab of (rwlock).
+ */
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock);
+
+/*
+ * Grab (rwlock) exclusive, for writing, blocking until nobody else holds
+ *  it either way. Return zero only on unrecoverable system errors.
+ */
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock);
+
+/*
+ * Let go of an exclusive grab of (rwlock).
+ */
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock);
+
+/*
+ * A monotonic clock, in nanoseconds since some arbitrary point. It only has
+ *  to be good for measuring how long things take.
+ */
+PHYSFS_uint64 __PHYSFS_platformGetTicks(void);
+
+/*
+ * Create a slot that holds one pointer per thread, using the platform's
+ *  native thread-local storage. Every thread's value starts out NULL,
+ *  including threads that had a value in a slot destroyed before this one
+ *  was created.
+ *
+ * Return (NULL) if the platform can't do this; PhysicsFS will find its
+ *  per-thread state some slower way. Systems without threads can return
+ *  any arbitrary non-NULL value and keep a single global pointer.
+ *
+ * _DO NOT_ call PHYSFS_setErrorCode() in here or in the other ThreadLocal
+ *  functions! The error state lives in this slot. This means you can't
+ *  use the BAIL_*MACRO* macros, either.
+ */
+void *__PHYSFS_platformCreateThreadLocal(void);
+
+/*
+ * Destroy a slot created by __PHYSFS_platformCreateThreadLocal(). This
+ *  doesn't touch whatever the values point to.
+ */
+void __PHYSFS_platformDestroyThreadLocal(void *tls);
+
+/*
+ * Get the current thread's value in (tls). NULL if it was never set.
+ */
+void *__PHYSFS_platformGetThreadLocal(void *tls);
+
+/*
+ * Set the current thread's value in (tls). Return zero on failure, non-zero
+ *  on success.
+ */
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value);
+
+/*
+ * Start a new thread that calls (fn) with (data), and return a handle to
+ *  it, cast to a (void *).
+ *
+ * Return (NULL) if you can't start threads; PhysicsFS will do the work on
+ *  the calling thread instead. Systems without threads should do this.
+ */
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data);
+
+/*
+ * Block until (thread), from __PHYSFS_platformCreateThread(), returns from
+ *  its function, then clean up anything associated with it.
+ */
+void __PHYSFS_platformWaitThread(void *thread);
+
+/*
+ * Create a counting semaphore that starts at zero, cast to a (void *).
+ *
+ * Return (NULL) if you couldn't create one. This is only used when
+ *  __PHYSFS_platformCreateThread() works, so systems without threads
+ *  can just return NULL.
+ */
+void *__PHYSFS_platformCreateSemaphore(void);
+
+/*
+ * Destroy a semaphore from __PHYSFS_platformCreateSemaphore(). Nothing will
+ *  be waiting on it.
+ */
+void __PHYSFS_platformDestroySemaphore(void *sem);
+
+/*
+ * Increment (sem), waking one thread waiting on it, if any.
+ */
+void __PHYSFS_platformPostSemaphore(void *sem);
+
+/*
+ * Block until (sem) is above zero, then decrement it.
+ */
+void __PHYSFS_platformWaitSemaphore(void *sem);
+
+/*
+ * Like __PHYSFS_platformWaitSemaphore(), but give up after about (ms)
+ *  milliseconds. Return non-zero if (sem) was decremented, zero if it
+ *  timed out first.
+ */
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms);
+
+/*
+ * Called by a __PHYSFS_platformWatchDir() watch, from whatever thread the
+ *  platform likes, with the (data) it was given and the path of what
+ *  changed. (path) is relative to the watched dir, in platform-independent
+ *  notation; it's "" for the dir itself, or when the platform can't tell
+ *  what changed (so anything in there might have).
+ */
+typedef void (*__PHYSFS_WatchCallback)(void *data, const char *path);
+
+/*
+ * Start watching the native directory (dirname), in platform-dependent
+ *  notation, and everything under it. Call (cb) soon after anything in
+ *  there is created, deleted, renamed, or written to. Reporting a change
+ *  more than once, or reporting a parent dir instead, is fine.
+ *
+ * Return a handle for __PHYSFS_platformUnwatchDir(), cast to a (void *),
+ *  or NULL if you can't watch it. Platforms with no way to watch for
+ *  changes should fail with PHYSFS_ERR_UNSUPPORTED.
+ */
+void *__PHYSFS_platformWatchDir(const char *dirname, __PHYSFS_WatchCallback cb,
+                                void *data);
+
+/*
+ * Stop a watch from __PHYSFS_platformWatchDir(). Once this returns, its
+ *  callback must not be running, and won't be called again. This is never
+ *  called from inside that callback.
+ */
+void __PHYSFS_platformUnwatchDir(void *watch);
+
 /*
  * Called at the start of PHYSFS_init() to prepare the allocator, if the user
  *  hasn't selected their own allocator via PHYSFS_setAllocator().
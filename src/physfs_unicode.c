@@ -189,12 +189,29 @@ static PHYSFS_uint32 utf8codepoint(const char **_str)
 } /* utf8codepoint */
 
 
+/*
+ * Paths are overwhelmingly ASCII, and an ASCII byte is its own codepoint in
+ *  every encoding we convert between, so the converters below copy runs of
+ *  it straight across and only do the full decode/encode for everything
+ *  else. These loops stop at the null terminator like the slow path does.
+ */
+#define IS_ASCII_CHAR(ch) (((ch) != 0) && ((ch) < 0x80))
+
 void PHYSFS_utf8ToUcs4(const char *src, PHYSFS_uint32 *dst, PHYSFS_uint64 len)
 {
     len -= sizeof (PHYSFS_uint32);   /* save room for null char. */
     while (len >= sizeof (PHYSFS_uint32))
     {
-        PHYSFS_uint32 cp = utf8codepoint(&src);
+        PHYSFS_uint32 cp = (PHYSFS_uint32) ((PHYSFS_uint8) *src);
+        if (IS_ASCII_CHAR(cp))
+        {
+            src++;
+            *(dst++) = cp;
+            len -= sizeof (PHYSFS_uint32);
+            continue;
+        } /* if */
+
+        cp = utf8codepoint(&src);
         if (cp == 0)
             break;
         else if (cp == UNICODE_BOGUS_CHAR_VALUE)
@@ -212,7 +229,16 @@ void PHYSFS_utf8ToUcs2(const char *src, PHYSFS_uint16 *dst, PHYSFS_uint64 len)
     len -= sizeof (PHYSFS_uint16);   /* save room for null char. */
     while (len >= sizeof (PHYSFS_uint16))
     {
-        PHYSFS_uint32 cp = utf8codepoint(&src);
+        PHYSFS_uint32 cp = (PHYSFS_uint32) ((PHYSFS_uint8) *src);
+        if (IS_ASCII_CHAR(cp))
+        {
+            src++;
+            *(dst++) = (PHYSFS_uint16) cp;
+            len -= sizeof (PHYSFS_uint16);
+            continue;
+        } /* if */
+
+        cp = utf8codepoint(&src);
         if (cp == 0)
             break;
         else if (cp == UNICODE_BOGUS_CHAR_VALUE)
@@ -234,7 +260,16 @@ void PHYSFS_utf8ToUtf16(const char *src, PHYSFS_uint16 *dst, PHYSFS_uint64 len)
     len -= sizeof (PHYSFS_uint16);   /* save room for null char. */
     while (len >= sizeof (PHYSFS_uint16))
     {
-        PHYSFS_uint32 cp = utf8codepoint(&src);
+        PHYSFS_uint32 cp = (PHYSFS_uint32) ((PHYSFS_uint8) *src);
+        if (IS_ASCII_CHAR(cp))
+        {
+            src++;
+            *(dst++) = (PHYSFS_uint16) cp;
+            len -= sizeof (PHYSFS_uint16);
+            continue;
+        } /* if */
+
+        cp = utf8codepoint(&src);
         if (cp == 0)
             break;
         else if (cp == UNICODE_BOGUS_CHAR_VALUE)
@@ -344,6 +379,7 @@ static void utf8fromcodepoint(PHYSFS_uint32 cp, char **_dst, PHYSFS_uint64 *_len
     while (len) \
     { \
         const PHYSFS_uint32 cp = (PHYSFS_uint32) ((typ) (*(src++))); \
+        if (IS_ASCII_CHAR(cp)) { *(dst++) = (char) cp; len--; continue; } \
         if (cp == 0) break; \
         utf8fromcodepoint(cp, &dst, &len); \
     } \
@@ -377,6 +413,13 @@ void PHYSFS_utf8FromUtf16(const PHYSFS_uint16 *src, char *dst, PHYSFS_uint64 len
     while (len)
     {
         PHYSFS_uint32 cp = (PHYSFS_uint32) *(src++);
+        if (IS_ASCII_CHAR(cp))
+        {
+            *(dst++) = (char) cp;
+            len--;
+            continue;
+        } /* if */
+
         if (cp == 0)
             break;
 
@@ -404,38 +447,30 @@ void PHYSFS_utf8FromUtf16(const PHYSFS_uint16 *src, char *dst, PHYSFS_uint64 len
 
 typedef struct CaseFoldMapping
 {
-    PHYSFS_uint32 from;
     PHYSFS_uint32 to0;
     PHYSFS_uint32 to1;
     PHYSFS_uint32 to2;
 } CaseFoldMapping;
 
-typedef struct CaseFoldHashBucket
-{
-    const PHYSFS_uint8 count;
-    const CaseFoldMapping *list;
-} CaseFoldHashBucket;
-
 #include "physfs_casefolding.h"
 
 static void locate_case_fold_mapping(const PHYSFS_uint32 from,
                                      PHYSFS_uint32 *to)
 {
-    PHYSFS_uint32 i;
-    const PHYSFS_uint8 hashed = ((from ^ (from >> 8)) & 0xFF);
-    const CaseFoldHashBucket *bucket = &case_fold_hash[hashed];
-    const CaseFoldMapping *mapping = bucket->list;
-
-    for (i = 0; i < bucket->count; i++, mapping++)
+    if (from < CASE_FOLD_LIMIT)
     {
-        if (mapping->from == from)
+        const PHYSFS_uint32 block = case_fold_blockmap[from >> CASE_FOLD_BLOCK_SHIFT];
+        const PHYSFS_uint32 mask = (1 << CASE_FOLD_BLOCK_SHIFT) - 1;
+        const PHYSFS_uint16 idx = case_fold_entries[(block << CASE_FOLD_BLOCK_SHIFT) | (from & mask)];
+        if (idx != 0)
         {
+            const CaseFoldMapping *mapping = &case_fold_mappings[idx - 1];
             to[0] = mapping->to0;
             to[1] = mapping->to1;
             to[2] = mapping->to2;
             return;
         } /* if */
-    } /* for */
+    } /* if */
 
     /* Not found...there's no remapping for this codepoint. */
     to[0] = from;
@@ -444,6 +479,17 @@ static void locate_case_fold_mapping(const PHYSFS_uint32 from,
 } /* locate_case_fold_mapping */
 
 
+int PHYSFS_caseFold(const PHYSFS_uint32 from, PHYSFS_uint32 *to)
+{
+    locate_case_fold_mapping(from, to);
+    if (to[1] == 0)
+        return 1;
+    else if (to[2] == 0)
+        return 2;
+    return 3;
+} /* PHYSFS_caseFold */
+
+
 static int utf8codepointcmp(const PHYSFS_uint32 cp1, const PHYSFS_uint32 cp2)
 {
     PHYSFS_uint32 folded1[3], folded2[3];
@@ -471,17 +517,85 @@ static int utf8codepointcmp(const PHYSFS_uint32 cp1, const PHYSFS_uint32 cp2)
 } /* utf8codepointcmp */
 
 
+/*
+ * Most paths are plain ASCII, where case folding is just 'A'-'Z' to 'a'-'z',
+ *  so compare those bytes directly and only decode and fold codepoints from
+ *  the first byte that isn't ASCII in either string. An ASCII byte is always
+ *  a whole codepoint, so the slow path picks up right where this stops.
+ *  Returns nonzero when it stopped at a difference, with it in (*rc).
+ */
+#define FOLD_ASCII(ch) ((((ch) >= 'A') && ((ch) <= 'Z')) ? ((ch) + 32) : (ch))
+
+static int asciicmp(const char **_str1, const char **_str2,
+                    PHYSFS_uint32 *_n, int *rc)
+{
+    const PHYSFS_uint8 *str1 = (const PHYSFS_uint8 *) *_str1;
+    const PHYSFS_uint8 *str2 = (const PHYSFS_uint8 *) *_str2;
+    PHYSFS_uint32 n = *_n;
+    int done = 0;
+
+    while (n > 0)
+    {
+        const PHYSFS_uint32 ch1 = *str1;
+        const PHYSFS_uint32 ch2 = *str2;
+
+        if ((ch1 | ch2) & 0x80)
+            break;  /* not ASCII; let the caller do it the hard way. */
+
+        else if (ch1 != ch2)
+        {
+            const PHYSFS_uint32 cp1 = FOLD_ASCII(ch1);
+            const PHYSFS_uint32 cp2 = FOLD_ASCII(ch2);
+            if (cp1 != cp2)
+            {
+                *rc = (cp1 < cp2) ? -1 : 1;
+                done = 1;
+                break;
+            } /* if */
+        } /* else if */
+
+        else if (ch1 == 0)  /* both null chars: complete match. */
+        {
+            *rc = 0;
+            done = 1;
+            break;
+        } /* else if */
+
+        str1++;
+        str2++;
+        n--;
+    } /* while */
+
+    *_str1 = (const char *) str1;
+    *_str2 = (const char *) str2;
+    *_n = n;
+    return done;
+} /* asciicmp */
+
+
 int __PHYSFS_utf8stricmp(const char *str1, const char *str2)
 {
+    PHYSFS_uint32 n = 0xFFFFFFFF;
+    int rc;
+
     while (1)
     {
-        const PHYSFS_uint32 cp1 = utf8codepoint(&str1);
-        const PHYSFS_uint32 cp2 = utf8codepoint(&str2);
-        const int rc = utf8codepointcmp(cp1, cp2);
-        if (rc != 0)
+        PHYSFS_uint32 cp1, cp2;
+
+        if (asciicmp(&str1, &str2, &n, &rc))
             return rc;
-        else if (cp1 == 0)
-            break;  /* complete match. */
+        else if (n == 0)
+            n = 0xFFFFFFFF;  /* a huge ASCII run; keep going. */
+        else
+        {
+            cp1 = utf8codepoint(&str1);
+            cp2 = utf8codepoint(&str2);
+            rc = utf8codepointcmp(cp1, cp2);
+            if (rc != 0)
+                return rc;
+            else if (cp1 == 0)
+                break;  /* complete match. */
+        } /* else */
     } /* while */
 
     return 0;
@@ -492,9 +606,17 @@ int __PHYSFS_utf8strnicmp(const char *str1, const char *str2, PHYSFS_uint32 n)
 {
     while (n > 0)
     {
-        const PHYSFS_uint32 cp1 = utf8codepoint(&str1);
-        const PHYSFS_uint32 cp2 = utf8codepoint(&str2);
-        const int rc = utf8codepointcmp(cp1, cp2);
+        PHYSFS_uint32 cp1, cp2;
+        int rc;
+
+        if (asciicmp(&str1, &str2, &n, &rc))
+            return rc;
+        else if (n == 0)
+            break;  /* matched to n chars. */
+
+        cp1 = utf8codepoint(&str1);
+        cp2 = utf8codepoint(&str2);
+        rc = utf8codepointcmp(cp1, cp2);
         if (rc != 0)
             return rc;
         else if (cp1 == 0)
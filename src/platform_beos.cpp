@@ -204,6 +204,126 @@ void *__PHYSFS_platformGetThreadID(void)
 } /* __PHYSFS_platformGetThreadID */
 
 
+/*
+ * BeOS TLS slots can't be freed, so values would outlive PHYSFS_deinit().
+ *  Let physfs.c search its list instead.
+ */
+void *__PHYSFS_platformCreateThreadLocal(void)
+{
+    return NULL;
+} /* __PHYSFS_platformCreateThreadLocal */
+
+
+void __PHYSFS_platformDestroyThreadLocal(void *tls)
+{
+} /* __PHYSFS_platformDestroyThreadLocal */
+
+
+void *__PHYSFS_platformGetThreadLocal(void *tls)
+{
+    return NULL;
+} /* __PHYSFS_platformGetThreadLocal */
+
+
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value)
+{
+    return 0;
+} /* __PHYSFS_platformSetThreadLocal */
+
+
+typedef struct
+{
+    thread_id thread;
+    void (*fn)(void *);
+    void *data;
+} BeOSThread;
+
+
+static int32 beosThreadEntry(void *arg)
+{
+    BeOSThread *t = (BeOSThread *) arg;
+    t->fn(t->data);
+    return 0;
+} /* beosThreadEntry */
+
+
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data)
+{
+    BeOSThread *t = (BeOSThread *) allocator.Malloc(sizeof (*t));
+    BAIL_IF_MACRO(!t, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    t->fn = fn;
+    t->data = data;
+    t->thread = spawn_thread(beosThreadEntry, "PhysicsFS worker",
+                             B_NORMAL_PRIORITY, t);
+    if ((t->thread < B_OK) || (resume_thread(t->thread) != B_OK))
+    {
+        allocator.Free(t);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, NULL);
+    } /* if */
+    return t;
+} /* __PHYSFS_platformCreateThread */
+
+
+void __PHYSFS_platformWaitThread(void *thread)
+{
+    BeOSThread *t = (BeOSThread *) thread;
+    status_t rc;
+    wait_for_thread(t->thread, &rc);
+    allocator.Free(t);
+} /* __PHYSFS_platformWaitThread */
+
+
+void *__PHYSFS_platformCreateSemaphore(void)
+{
+    const sem_id sem = create_sem(0, "PhysicsFS semaphore");
+    BAIL_IF_MACRO(sem < B_OK, PHYSFS_ERR_OS_ERROR, NULL);
+    return (void *) (((size_t) sem) + 1);  /* so it can't look NULL. */
+} /* __PHYSFS_platformCreateSemaphore */
+
+
+void __PHYSFS_platformDestroySemaphore(void *sem)
+{
+    delete_sem((sem_id) (((size_t) sem) - 1));
+} /* __PHYSFS_platformDestroySemaphore */
+
+
+void __PHYSFS_platformPostSemaphore(void *sem)
+{
+    release_sem((sem_id) (((size_t) sem) - 1));
+} /* __PHYSFS_platformPostSemaphore */
+
+
+void __PHYSFS_platformWaitSemaphore(void *sem)
+{
+    const sem_id id = (sem_id) (((size_t) sem) - 1);
+    while (acquire_sem(id) == B_INTERRUPTED) { /* try again. */ }
+} /* __PHYSFS_platformWaitSemaphore */
+
+
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms)
+{
+    const sem_id id = (sem_id) (((size_t) sem) - 1);
+    const bigtime_t usecs = ((bigtime_t) ms) * 1000;
+    status_t rc;
+    while ((rc = acquire_sem_etc(id, 1, B_RELATIVE_TIMEOUT, usecs)) ==
+            B_INTERRUPTED) { /* try again. */ }
+    return (rc == B_OK);
+} /* __PHYSFS_platformWaitSemaphoreTimeout */
+
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    /* no-op; nothing is ever watched. */
+} /* __PHYSFS_platformUnwatchDir */
+
+
 void *__PHYSFS_platformCreateMutex(void)
 {
     return new BLocker("PhysicsFS lock", true);
@@ -222,12 +342,55 @@ int __PHYSFS_platformGrabMutex(void *mutex)
 } /* __PHYSFS_platformGrabMutex */
 
 
+int __PHYSFS_platformTryGrabMutex(void *mutex)
+{
+    return (((BLocker *) mutex)->LockWithTimeout(0) == B_OK) ? 1 : 0;
+} /* __PHYSFS_platformTryGrabMutex */
+
+
 void __PHYSFS_platformReleaseMutex(void *mutex)
 {
     ((BLocker *) mutex)->Unlock();
 } /* __PHYSFS_platformReleaseMutex */
 
 
+/* !!! FIXME: BLocker has no shared mode; everyone takes turns for now. */
+void *__PHYSFS_platformCreateRWLock(void)
+{
+    return new BLocker("PhysicsFS rwlock", false);
+} /* __PHYSFS_platformCreateRWLock */
+
+
+void __PHYSFS_platformDestroyRWLock(void *rwlock)
+{
+    delete ((BLocker *) rwlock);
+} /* __PHYSFS_platformDestroyRWLock */
+
+
+int __PHYSFS_platformGrabRWLockShared(void *rwlock)
+{
+    return ((BLocker *) rwlock)->Lock() ? 1 : 0;
+} /* __PHYSFS_platformGrabRWLockShared */
+
+
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock)
+{
+    ((BLocker *) rwlock)->Unlock();
+} /* __PHYSFS_platformReleaseRWLockShared */
+
+
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock)
+{
+    return ((BLocker *) rwlock)->Lock() ? 1 : 0;
+} /* __PHYSFS_platformGrabRWLockExclusive */
+
+
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock)
+{
+    ((BLocker *) rwlock)->Unlock();
+} /* __PHYSFS_platformReleaseRWLockExclusive */
+
+
 int __PHYSFS_platformSetDefaultAllocator(PHYSFS_Allocator *a)
 {
     return 0;  /* just use malloc() and friends. */
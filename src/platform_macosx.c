@@ -12,6 +12,14 @@
 #ifdef PHYSFS_PLATFORM_MACOSX
 
 #include <CoreFoundation/CoreFoundation.h>
+#include <AvailabilityMacros.h>
+
+#if MAC_OS_X_VERSION_MIN_REQUIRED >= 1070  /* file-level FSEvents. */
+#define PHYSFS_USE_FSEVENTS 1
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+#include <stdlib.h>  /* realpath() */
+#endif
 
 #if !defined(PHYSFS_NO_CDROM_SUPPORT)
 #include <Carbon/Carbon.h>  /* !!! FIXME */
@@ -198,6 +206,16 @@ void __PHYSFS_platformDetectAvailableCDs(PHYSFS_StringCallback cb, void *data)
 } /* __PHYSFS_platformDetectAvailableCDs */
 
 
+int __PHYSFS_platformCdRomsChanged(void)
+{
+#if !defined(PHYSFS_NO_CDROM_SUPPORT)
+    return 1;  /* no cheap way to tell; always look. */
+#else
+    return 0;
+#endif
+} /* __PHYSFS_platformCdRomsChanged */
+
+
 static char *convertCFString(CFStringRef cfstr)
 {
     CFIndex len = CFStringGetMaximumSizeForEncoding(CFStringGetLength(cfstr),
@@ -263,6 +281,137 @@ char *__PHYSFS_platformCalcPrefDir(const char *org, const char *app)
 } /* __PHYSFS_platformCalcPrefDir */
 
 
+#if PHYSFS_USE_FSEVENTS
+
+typedef struct
+{
+    FSEventStreamRef stream;
+    dispatch_queue_t queue;
+    char *root;  /* real path, with a trailing '/'. */
+    size_t rootlen;
+    __PHYSFS_WatchCallback callback;
+    void *data;
+} MacWatch;
+
+
+static void fseventsCallback(ConstFSEventStreamRef stream, void *info,
+                             size_t numEvents, void *eventPaths,
+                             const FSEventStreamEventFlags *eventFlags,
+                             const FSEventStreamEventId *eventIds)
+{
+    const FSEventStreamEventFlags rescan = kFSEventStreamEventFlagMustScanSubDirs
+                                         | kFSEventStreamEventFlagRootChanged;
+    MacWatch *w = (MacWatch *) info;
+    char **paths = (char **) eventPaths;
+    size_t i;
+
+    for (i = 0; i < numEvents; i++)
+    {
+        const char *path = paths[i];
+        if ((eventFlags[i] & rescan) ||
+            (strncmp(path, w->root, w->rootlen) != 0))
+            path = "";  /* don't know exactly; say anything might be. */
+        else
+            path += w->rootlen;
+        w->callback(w->data, path);
+    } /* for */
+} /* fseventsCallback */
+
+
+static void fseventsNoop(void *data) {}
+
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    FSEventStreamContext ctx;
+    CFStringRef cfstr = NULL;
+    CFArrayRef cfarray = NULL;
+    char resolved[PATH_MAX];
+    MacWatch *w;
+
+    BAIL_IF_MACRO(!realpath(dirname, resolved), PHYSFS_ERR_NOT_FOUND, NULL);
+
+    w = (MacWatch *) allocator.Malloc(sizeof (MacWatch));
+    BAIL_IF_MACRO(!w, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(w, '\0', sizeof (MacWatch));
+    w->callback = cb;
+    w->data = data;
+
+    w->rootlen = strlen(resolved) + 1;
+    w->root = (char *) allocator.Malloc(w->rootlen + 1);
+    GOTO_IF_MACRO(!w->root, PHYSFS_ERR_OUT_OF_MEMORY, watchDirFailed);
+    strcpy(w->root, resolved);
+    strcat(w->root, "/");
+
+    cfstr = CFStringCreateWithCString(cfallocator, resolved,
+                                      kCFStringEncodingUTF8);
+    GOTO_IF_MACRO(!cfstr, PHYSFS_ERR_OUT_OF_MEMORY, watchDirFailed);
+    cfarray = CFArrayCreate(cfallocator, (const void **) &cfstr, 1,
+                            &kCFTypeArrayCallBacks);
+    CFRelease(cfstr);
+    GOTO_IF_MACRO(!cfarray, PHYSFS_ERR_OUT_OF_MEMORY, watchDirFailed);
+
+    memset(&ctx, '\0', sizeof (ctx));
+    ctx.info = w;
+    w->stream = FSEventStreamCreate(cfallocator, fseventsCallback, &ctx,
+                                    cfarray, kFSEventStreamEventIdSinceNow,
+                                    0.1, kFSEventStreamCreateFlagFileEvents |
+                                         kFSEventStreamCreateFlagNoDefer);
+    CFRelease(cfarray);
+    GOTO_IF_MACRO(!w->stream, PHYSFS_ERR_OS_ERROR, watchDirFailed);
+
+    w->queue = dispatch_queue_create("org.icculus.physfs.watch", NULL);
+    GOTO_IF_MACRO(!w->queue, PHYSFS_ERR_OS_ERROR, watchDirFailed);
+    FSEventStreamSetDispatchQueue(w->stream, w->queue);
+    if (!FSEventStreamStart(w->stream))
+    {
+        FSEventStreamInvalidate(w->stream);
+        GOTO_MACRO(PHYSFS_ERR_OS_ERROR, watchDirFailed);
+    } /* if */
+
+    return w;
+
+watchDirFailed:
+    if (w->stream)
+        FSEventStreamRelease(w->stream);
+    if (w->queue)
+        dispatch_release(w->queue);
+    allocator.Free(w->root);
+    allocator.Free(w);
+    return NULL;
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    MacWatch *w = (MacWatch *) watch;
+    FSEventStreamStop(w->stream);
+    FSEventStreamInvalidate(w->stream);
+    FSEventStreamRelease(w->stream);
+    dispatch_sync_f(w->queue, NULL, fseventsNoop);  /* let callbacks finish. */
+    dispatch_release(w->queue);
+    allocator.Free(w->root);
+    allocator.Free(w);
+} /* __PHYSFS_platformUnwatchDir */
+
+#else
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    /* no-op; nothing is ever watched. */
+} /* __PHYSFS_platformUnwatchDir */
+
+#endif
+
+
 /* Platform allocator uses default CFAllocator at PHYSFS_init() time. */
 
 static CFAllocatorRef cfallocdef = NULL;
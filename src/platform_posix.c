@@ -8,6 +8,15 @@
 
 /* !!! FIXME: check for EINTR? */
 
+/*
+ * syncfs() and O_DIRECT are GNU extensions, and have to be asked for before
+ *  any header.
+ */
+#if ((defined PHYSFS_HAVE_SYNCFS) || (defined __linux__)) && \
+    (!defined _GNU_SOURCE)
+#define _GNU_SOURCE 1
+#endif
+
 #define __PHYSICSFS_INTERNAL__
 #include "physfs_platforms.h"
 
@@ -21,11 +30,56 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+/* iovecs per readv() call; these live on the stack. */
+#if (!defined IOV_MAX) || (IOV_MAX > 64)
+#define READV_MAX 64
+#else
+#define READV_MAX IOV_MAX
+#endif
+
+/* fstatat() lets enumeration stat entries without rebuilding full paths. */
+#ifdef AT_SYMLINK_NOFOLLOW
+#define PHYSFS_HAVE_FSTATAT 1
+#endif
+
+#if (defined __linux__) && (defined O_DIRECTORY)
+#include <sys/syscall.h>
+#ifdef SYS_getdents64
+#define PHYSFS_HAVE_GETDENTS64 1
+#endif
+#endif
+
+/* copy_file_range() copies in the kernel, or clones blocks where it can. */
+#ifdef __linux__
+#include <sys/syscall.h>
+#ifdef SYS_copy_file_range
+#define PHYSFS_HAVE_COPY_FILE_RANGE 1
+#endif
+#endif
+
+/* original BeOS lacks mmap(), but Haiku has it. */
+#if ((!defined PHYSFS_PLATFORM_BEOS) || (defined PHYSFS_PLATFORM_HAIKU))
+#define PHYSFS_HAVE_MMAP 1
+#include <sys/mman.h>
+#endif
 
 #if ((!defined PHYSFS_NO_THREAD_SUPPORT) && (!defined PHYSFS_PLATFORM_BEOS))
 #include <pthread.h>
 #endif
 
+#ifdef PHYSFS_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#ifndef PHYSFS_HAVE_MMAP
+#error io_uring needs mmap().
+#endif
+#endif
+
 #include "physfs_internal.h"
 
 
@@ -121,38 +175,283 @@ char *__PHYSFS_platformCalcUserDir(void)
 } /* __PHYSFS_platformCalcUserDir */
 
 
+static void statFromStatbuf(const struct stat *statbuf, PHYSFS_Stat *st)
+{
+    if (S_ISREG(statbuf->st_mode))
+    {
+        st->filetype = PHYSFS_FILETYPE_REGULAR;
+        st->filesize = statbuf->st_size;
+    } /* if */
+
+    else if(S_ISDIR(statbuf->st_mode))
+    {
+        st->filetype = PHYSFS_FILETYPE_DIRECTORY;
+        st->filesize = 0;
+    } /* else if */
+
+    else if(S_ISLNK(statbuf->st_mode))
+    {
+        st->filetype = PHYSFS_FILETYPE_SYMLINK;
+        st->filesize = 0;
+    } /* else if */
+
+    else
+    {
+        st->filetype = PHYSFS_FILETYPE_OTHER;
+        st->filesize = statbuf->st_size;
+    } /* else */
+
+    st->modtime = statbuf->st_mtime;
+    st->createtime = statbuf->st_ctime;
+    st->accesstime = statbuf->st_atime;
+} /* statFromStatbuf */
+
+
+/*
+ * Directory listings. On Linux, we skip readdir() and pull entries from
+ *  the kernel with getdents64(), a big buffer at a time; that adds up for
+ *  directories with a huge number of entries.
+ */
+#ifdef PHYSFS_HAVE_GETDENTS64
+#define DIRREADER_BUFSIZE (64 * 1024)
+
+typedef struct LinuxDirent64
+{
+    PHYSFS_uint64 d_ino;
+    PHYSFS_sint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+} LinuxDirent64;
+
+typedef struct DirReader
+{
+    int fd;
+    char *buf;
+    size_t len;
+    size_t pos;
+} DirReader;
+
+static int openDirReader(DirReader *r, const char *dirname)
+{
+    r->fd = open(dirname, O_RDONLY | O_DIRECTORY);
+    if (r->fd == -1)
+        return 0;
+
+    r->buf = (char *) allocator.Malloc(DIRREADER_BUFSIZE);
+    if (r->buf == NULL)
+    {
+        close(r->fd);
+        return 0;
+    } /* if */
+
+    r->len = r->pos = 0;
+    return 1;
+} /* openDirReader */
+
+static const char *readDirReader(DirReader *r, unsigned char *type)
+{
+    const LinuxDirent64 *ent;
+
+    if (r->pos >= r->len)
+    {
+        const long rc = syscall(SYS_getdents64, r->fd, r->buf,
+                                DIRREADER_BUFSIZE);
+        if (rc <= 0)
+            return NULL;  /* end of the directory, or an error. */
+        r->len = (size_t) rc;
+        r->pos = 0;
+    } /* if */
+
+    ent = (const LinuxDirent64 *) (r->buf + r->pos);
+    r->pos += ent->d_reclen;
+    *type = ent->d_type;
+    return ent->d_name;
+} /* readDirReader */
+
+static void closeDirReader(DirReader *r)
+{
+    allocator.Free(r->buf);
+    close(r->fd);
+} /* closeDirReader */
+
+#define dirReaderFd(r) ((r)->fd)
+
+#else
+
+typedef struct DirReader
+{
+    DIR *dir;
+} DirReader;
+
+static int openDirReader(DirReader *r, const char *dirname)
+{
+    r->dir = opendir(dirname);
+    return (r->dir != NULL);
+} /* openDirReader */
+
+static const char *readDirReader(DirReader *r, unsigned char *type)
+{
+    const struct dirent *ent = readdir(r->dir);
+    if (ent == NULL)
+        return NULL;
+#ifdef DT_UNKNOWN
+    *type = ent->d_type;
+#else
+    *type = 0;
+#endif
+    return ent->d_name;
+} /* readDirReader */
+
+static void closeDirReader(DirReader *r)
+{
+    closedir(r->dir);
+} /* closeDirReader */
+
+#define dirReaderFd(r) dirfd((r)->dir)
+
+#endif
+
+
 void __PHYSFS_platformEnumerateFiles(const char *dirname,
                                      PHYSFS_EnumFilesCallback callback,
                                      const char *origdir,
                                      void *callbackdata)
 {
-    DIR *dir;
-    struct dirent *ent;
-    char *buf = NULL;
+    DirReader dir;
+    const char *name;
+    unsigned char type;
 
     errno = 0;
-    dir = opendir(dirname);
-    if (dir == NULL)
-    {
-        allocator.Free(buf);
+    if (!openDirReader(&dir, dirname))
         return;
-    } /* if */
 
-    while ((ent = readdir(dir)) != NULL)
+    while ((name = readDirReader(&dir, &type)) != NULL)
     {
-        if (strcmp(ent->d_name, ".") == 0)
+        if (strcmp(name, ".") == 0)
             continue;
-        else if (strcmp(ent->d_name, "..") == 0)
+        else if (strcmp(name, "..") == 0)
             continue;
 
-        callback(callbackdata, origdir, ent->d_name);
+        callback(callbackdata, origdir, name);
     } /* while */
 
-    allocator.Free(buf);
-    closedir(dir);
+    closeDirReader(&dir);
 } /* __PHYSFS_platformEnumerateFiles */
 
 
+/* d_type is a BSD/glibc extension; without it, every entry gets a stat. */
+#ifdef DT_UNKNOWN
+static int fileTypeFromDirent(const unsigned char type, PHYSFS_Stat *st)
+{
+    switch (type)
+    {
+        case DT_UNKNOWN: return 0;  /* some filesystems never fill it in. */
+        case DT_REG: st->filetype = PHYSFS_FILETYPE_REGULAR; break;
+        case DT_DIR: st->filetype = PHYSFS_FILETYPE_DIRECTORY; break;
+        case DT_LNK: st->filetype = PHYSFS_FILETYPE_SYMLINK; break;
+        default: st->filetype = PHYSFS_FILETYPE_OTHER; break;
+    } /* switch */
+
+    st->filesize = -1;
+    st->modtime = -1;
+    st->createtime = -1;
+    st->accesstime = -1;
+    st->readonly = -1;
+    return 1;
+} /* fileTypeFromDirent */
+#else
+#define fileTypeFromDirent(type, st) (0)
+#endif
+
+
+static void enumerateFilesStat(const char *dirname,
+                               PHYSFS_EnumFilesStatCallback callback,
+                               const char *origdir, void *callbackdata,
+                               const int typeonly)
+{
+    DirReader dir;
+    const char *name;
+    unsigned char type;
+    struct stat statbuf;
+    PHYSFS_Stat st;
+#ifndef PHYSFS_HAVE_FSTATAT
+    const size_t dirlen = strlen(dirname);
+    char *path = NULL;
+    size_t pathlen = 0;
+#endif
+
+    if (!openDirReader(&dir, dirname))
+        return;
+
+    while ((name = readDirReader(&dir, &type)) != NULL)
+    {
+        if (strcmp(name, ".") == 0)
+            continue;
+        else if (strcmp(name, "..") == 0)
+            continue;
+
+        if ((typeonly) && (fileTypeFromDirent(type, &st)))
+        {
+            callback(callbackdata, origdir, name, &st);
+            continue;
+        } /* if */
+
+#ifdef PHYSFS_HAVE_FSTATAT
+        /* relative to the open dir, so the kernel doesn't walk it again. */
+        if (fstatat(dirReaderFd(&dir), name, &statbuf,
+                    AT_SYMLINK_NOFOLLOW) == -1)
+            continue;
+        statFromStatbuf(&statbuf, &st);
+        st.readonly = faccessat(dirReaderFd(&dir), name, W_OK, 0);
+#else
+        {
+            const size_t len = dirlen + strlen(name) + 2;
+            if (len > pathlen)
+            {
+                void *ptr = allocator.Realloc(path, len);
+                if (ptr == NULL)
+                    break;
+                path = (char *) ptr;
+                pathlen = len;
+            } /* if */
+
+            sprintf(path, "%s/%s", dirname, name);
+            if (lstat(path, &statbuf) == -1)
+                continue;
+            statFromStatbuf(&statbuf, &st);
+            st.readonly = access(path, W_OK);
+        }
+#endif
+
+        callback(callbackdata, origdir, name, &st);
+    } /* while */
+
+#ifndef PHYSFS_HAVE_FSTATAT
+    allocator.Free(path);
+#endif
+    closeDirReader(&dir);
+} /* enumerateFilesStat */
+
+
+void __PHYSFS_platformEnumerateFilesStat(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata)
+{
+    enumerateFilesStat(dirname, callback, origdir, callbackdata, 0);
+} /* __PHYSFS_platformEnumerateFilesStat */
+
+
+void __PHYSFS_platformEnumerateFilesType(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata)
+{
+    enumerateFilesStat(dirname, callback, origdir, callbackdata, 1);
+} /* __PHYSFS_platformEnumerateFilesType */
+
+
 int __PHYSFS_platformMkDir(const char *path)
 {
     const int rc = mkdir(path, S_IRWXU);
@@ -161,17 +460,10 @@ int __PHYSFS_platformMkDir(const char *path)
 } /* __PHYSFS_platformMkDir */
 
 
-static void *doOpen(const char *filename, int mode)
+static void *finishOpen(const int fd, const int appending)
 {
-    const int appending = (mode & O_APPEND);
-    int fd;
     int *retval;
-    errno = 0;
-
-    /* O_APPEND doesn't actually behave as we'd like. */
-    mode &= ~O_APPEND;
 
-    fd = open(filename, mode, S_IRUSR | S_IWUSR);
     BAIL_IF_MACRO(fd < 0, errcodeFromErrno(), NULL);
 
     if (appending)
@@ -193,6 +485,20 @@ static void *doOpen(const char *filename, int mode)
 
     *retval = fd;
     return ((void *) retval);
+} /* finishOpen */
+
+
+static void *doOpen(const char *filename, int mode)
+{
+    const int appending = (mode & O_APPEND);
+    int fd;
+    errno = 0;
+
+    /* O_APPEND doesn't actually behave as we'd like. */
+    mode &= ~O_APPEND;
+
+    fd = open(filename, mode, S_IRUSR | S_IWUSR);
+    return finishOpen(fd, appending);
 } /* doOpen */
 
 
@@ -214,6 +520,17 @@ void *__PHYSFS_platformOpenAppend(const char *filename)
 } /* __PHYSFS_platformOpenAppend */
 
 
+void *__PHYSFS_platformOpenReadAt(void *dir, const char *relpath)
+{
+#ifdef PHYSFS_HAVE_FSTATAT
+    errno = 0;
+    return finishOpen(openat(*((int *) dir), relpath, O_RDONLY), 0);
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);  /* OpenDir gave out nothing. */
+#endif
+} /* __PHYSFS_platformOpenReadAt */
+
+
 PHYSFS_sint64 __PHYSFS_platformRead(void *opaque, void *buffer,
                                     PHYSFS_uint64 len)
 {
@@ -231,8 +548,8 @@ PHYSFS_sint64 __PHYSFS_platformRead(void *opaque, void *buffer,
 } /* __PHYSFS_platformRead */
 
 
-PHYSFS_sint64 __PHYSFS_platformWrite(void *opaque, const void *buffer,
-                                     PHYSFS_uint64 len)
+PHYSFS_sint64 __PHYSFS_platformReadAt(void *opaque, void *buffer,
+                                      PHYSFS_uint64 len, PHYSFS_uint64 pos)
 {
     const int fd = *((int *) opaque);
     ssize_t rc = 0;
@@ -240,129 +557,926 @@ PHYSFS_sint64 __PHYSFS_platformWrite(void *opaque, const void *buffer,
     if (!__PHYSFS_ui64FitsAddressSpace(len))
         BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
 
-    rc = write(fd, (void *) buffer, (size_t) len);
-    BAIL_IF_MACRO(rc == -1, errcodeFromErrno(), rc);
+    rc = pread(fd, buffer, (size_t) len, (off_t) pos);
+    BAIL_IF_MACRO(rc == -1, errcodeFromErrno(), -1);
     assert(rc >= 0);
     assert(rc <= len);
     return (PHYSFS_sint64) rc;
-} /* __PHYSFS_platformWrite */
+} /* __PHYSFS_platformReadAt */
 
 
-int __PHYSFS_platformSeek(void *opaque, PHYSFS_uint64 pos)
+PHYSFS_sint64 __PHYSFS_platformReadv(void *opaque, const PHYSFS_IoVec *iov,
+                                     PHYSFS_uint32 count)
 {
     const int fd = *((int *) opaque);
-    const int rc = lseek(fd, (off_t) pos, SEEK_SET);
-    BAIL_IF_MACRO(rc == -1, errcodeFromErrno(), 0);
-    return 1;
-} /* __PHYSFS_platformSeek */
+    PHYSFS_sint64 retval = 0;
+    struct iovec vec[READV_MAX];
 
+    while (count > 0)
+    {
+        PHYSFS_uint64 want = 0;
+        PHYSFS_sint64 rc;
+        int n = 0;
 
-PHYSFS_sint64 __PHYSFS_platformTell(void *opaque)
-{
-    const int fd = *((int *) opaque);
-    PHYSFS_sint64 retval;
-    retval = (PHYSFS_sint64) lseek(fd, 0, SEEK_CUR);
-    BAIL_IF_MACRO(retval == -1, errcodeFromErrno(), -1);
-    return retval;
-} /* __PHYSFS_platformTell */
+        /* readv() fails outright if the total overflows an ssize_t. */
+        while ((n < READV_MAX) && (((PHYSFS_uint32) n) < count) &&
+               (iov[n].len <= ((PHYSFS_uint64) SSIZE_MAX) - want))
+        {
+            vec[n].iov_base = iov[n].buf;
+            vec[n].iov_len = (size_t) iov[n].len;
+            want += iov[n].len;
+            n++;
+        } /* while */
 
+        if (n == 0)  /* a single piece too big for one readv() call. */
+        {
+            want = iov[0].len;
+            n = 1;
+            rc = __PHYSFS_platformRead(opaque, iov[0].buf, want);
+            if (rc < 0)
+                return (retval == 0) ? -1 : retval;
+        } /* if */
 
-PHYSFS_sint64 __PHYSFS_platformFileLength(void *opaque)
-{
-    const int fd = *((int *) opaque);
-    struct stat statbuf;
-    BAIL_IF_MACRO(fstat(fd, &statbuf) == -1, errcodeFromErrno(), -1);
-    return ((PHYSFS_sint64) statbuf.st_size);
-} /* __PHYSFS_platformFileLength */
+        else
+        {
+            rc = (PHYSFS_sint64) readv(fd, vec, n);
+            if (rc == -1)
+            {
+                if (retval == 0)
+                    BAIL_MACRO(errcodeFromErrno(), -1);
+                break;  /* report what we got; the next read will fail. */
+            } /* if */
+        } /* else */
 
+        retval += rc;
+        if (((PHYSFS_uint64) rc) < want)
+            break;  /* EOF. */
 
-int __PHYSFS_platformFlush(void *opaque)
-{
-    const int fd = *((int *) opaque);
-    if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDONLY)
-        BAIL_IF_MACRO(fsync(fd) == -1, errcodeFromErrno(), 0);
-    return 1;
-} /* __PHYSFS_platformFlush */
+        iov += n;
+        count -= (PHYSFS_uint32) n;
+    } /* while */
+
+    return retval;
+} /* __PHYSFS_platformReadv */
 
 
-void __PHYSFS_platformClose(void *opaque)
+static void readBatchOneByOne(__PHYSFS_PlatformReadRequest *reqs,
+                              PHYSFS_uint32 count)
 {
-    const int fd = *((int *) opaque);
-    (void) close(fd);  /* we don't check this. You should have used flush! */
-    allocator.Free(opaque);
-} /* __PHYSFS_platformClose */
+    PHYSFS_uint32 i;
+    for (i = 0; i < count; i++)
+    {
+        __PHYSFS_PlatformReadRequest *req = &reqs[i];
+        req->result = __PHYSFS_platformReadAt(req->opaque, req->buffer,
+                                              req->len, req->pos);
+        req->error = PHYSFS_ERR_OK;
+        if (req->result < 0)
+            req->error = PHYSFS_getLastErrorCode();
+    } /* for */
+} /* readBatchOneByOne */
 
 
-int __PHYSFS_platformDelete(const char *path)
+#ifdef PHYSFS_HAVE_IO_URING
+
+/*
+ * A bare-bones io_uring, so we don't need liburing. Batches take turns on
+ *  the one ring: each submits its reads, then waits for all of them, so
+ *  every completion we see belongs to the batch that's holding the lock.
+ */
+
+#define IO_RING_ENTRIES 64
+#define IO_RING_MAX_READ 0x40000000  /* bigger reads just use pread(). */
+
+typedef struct
 {
-    BAIL_IF_MACRO(remove(path) == -1, errcodeFromErrno(), 0);
-    return 1;
-} /* __PHYSFS_platformDelete */
+    int fd;
+    void *lock;
+    unsigned int entries;
+    void *sqring;
+    size_t sqringlen;
+    void *cqring;
+    size_t cqringlen;
+    struct io_uring_sqe *sqes;
+    size_t sqeslen;
+    volatile unsigned int *sqtail;
+    unsigned int sqmask;
+    unsigned int *sqarray;
+    volatile unsigned int *cqhead;
+    volatile unsigned int *cqtail;
+    unsigned int cqmask;
+    struct io_uring_cqe *cqes;
+} IoRing;
+
+static IoRing *ioRing = NULL;
+
+
+static void freeIoRing(IoRing *ring)
+{
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqeslen);
+    if (ring->cqring != NULL)
+        munmap(ring->cqring, ring->cqringlen);
+    if (ring->sqring != NULL)
+        munmap(ring->sqring, ring->sqringlen);
+    if (ring->fd != -1)
+        close(ring->fd);
+    if (ring->lock != NULL)
+        __PHYSFS_platformDestroyMutex(ring->lock);
+    allocator.Free(ring);
+} /* freeIoRing */
+
+
+static void *mapIoRing(const int fd, const size_t len, const off_t off)
+{
+    void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, off);
+    return (ptr == MAP_FAILED) ? NULL : ptr;
+} /* mapIoRing */
 
 
-int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+int __PHYSFS_platformInitBatchIo(int wanted)
 {
-    struct stat statbuf;
+    struct io_uring_params params;
+    IoRing *ring;
+    char *ptr;
 
-    BAIL_IF_MACRO(lstat(filename, &statbuf) == -1, errcodeFromErrno(), 0);
+    if (!wanted)
+        return 0;
 
-    if (S_ISREG(statbuf.st_mode))
-    {
-        st->filetype = PHYSFS_FILETYPE_REGULAR;
-        st->filesize = statbuf.st_size;
-    } /* if */
+    ring = (IoRing *) allocator.Malloc(sizeof (IoRing));
+    if (ring == NULL)
+        return 0;
 
-    else if(S_ISDIR(statbuf.st_mode))
+    memset(ring, '\0', sizeof (IoRing));
+    memset(&params, '\0', sizeof (params));
+    ring->fd = (int) syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &params);
+    if (ring->fd < 0)  /* old kernel, seccomp, etc. */
     {
-        st->filetype = PHYSFS_FILETYPE_DIRECTORY;
-        st->filesize = 0;
-    } /* else if */
+        ring->fd = -1;
+        freeIoRing(ring);
+        return 0;
+    } /* if */
 
-    else if(S_ISLNK(statbuf.st_mode))
+    ring->lock = __PHYSFS_platformCreateMutex();
+    ring->entries = params.sq_entries;
+    ring->sqringlen = params.sq_off.array +
+                      (params.sq_entries * sizeof (unsigned int));
+    ring->cqringlen = params.cq_off.cqes +
+                      (params.cq_entries * sizeof (struct io_uring_cqe));
+    ring->sqeslen = params.sq_entries * sizeof (struct io_uring_sqe);
+    ring->sqring = mapIoRing(ring->fd, ring->sqringlen, IORING_OFF_SQ_RING);
+    ring->cqring = mapIoRing(ring->fd, ring->cqringlen, IORING_OFF_CQ_RING);
+    ring->sqes = (struct io_uring_sqe *) mapIoRing(ring->fd, ring->sqeslen,
+                                                   IORING_OFF_SQES);
+
+    if (!ring->lock || !ring->sqring || !ring->cqring || !ring->sqes)
     {
-        st->filetype = PHYSFS_FILETYPE_SYMLINK;
-        st->filesize = 0;
-    } /* else if */
+        freeIoRing(ring);
+        return 0;
+    } /* if */
 
-    else
-    {
-        st->filetype = PHYSFS_FILETYPE_OTHER;
-        st->filesize = statbuf.st_size;
-    } /* else */
+    ptr = (char *) ring->sqring;
+    ring->sqtail = (volatile unsigned int *) (ptr + params.sq_off.tail);
+    ring->sqmask = *((unsigned int *) (ptr + params.sq_off.ring_mask));
+    ring->sqarray = (unsigned int *) (ptr + params.sq_off.array);
 
-    st->modtime = statbuf.st_mtime;
-    st->createtime = statbuf.st_ctime;
-    st->accesstime = statbuf.st_atime;
+    ptr = (char *) ring->cqring;
+    ring->cqhead = (volatile unsigned int *) (ptr + params.cq_off.head);
+    ring->cqtail = (volatile unsigned int *) (ptr + params.cq_off.tail);
+    ring->cqmask = *((unsigned int *) (ptr + params.cq_off.ring_mask));
+    ring->cqes = (struct io_uring_cqe *) (ptr + params.cq_off.cqes);
 
-    /* !!! FIXME: maybe we should just report full permissions? */
-    st->readonly = access(filename, W_OK);
+    ioRing = ring;
     return 1;
-} /* __PHYSFS_platformStat */
-
-
-#ifndef PHYSFS_PLATFORM_BEOS  /* BeOS has its own code in platform_beos.cpp */
-#if (defined PHYSFS_NO_THREAD_SUPPORT)
-
-void *__PHYSFS_platformGetThreadID(void) { return ((void *) 0x0001); }
-void *__PHYSFS_platformCreateMutex(void) { return ((void *) 0x0001); }
-void __PHYSFS_platformDestroyMutex(void *mutex) {}
-int __PHYSFS_platformGrabMutex(void *mutex) { return 1; }
-void __PHYSFS_platformReleaseMutex(void *mutex) {}
+} /* __PHYSFS_platformInitBatchIo */
 
-#else
 
-typedef struct
+void __PHYSFS_platformDeinitBatchIo(void)
 {
-    pthread_mutex_t mutex;
-    pthread_t owner;
-    PHYSFS_uint32 count;
-} PthreadMutex;
+    if (ioRing != NULL)
+    {
+        freeIoRing(ioRing);
+        ioRing = NULL;
+    } /* if */
+} /* __PHYSFS_platformDeinitBatchIo */
 
 
-void *__PHYSFS_platformGetThreadID(void)
+/* Returns number of completions reaped. */
+static PHYSFS_uint32 reapIoRing(IoRing *ring,
+                                __PHYSFS_PlatformReadRequest *reqs)
 {
-    return ( (void *) ((size_t) pthread_self()) );
-} /* __PHYSFS_platformGetThreadID */
+    PHYSFS_uint32 retval = 0;
+    unsigned int head = *ring->cqhead;
+
+    __PHYSFS_MEMORY_BARRIER();  /* see the kernel's tail before its cqes. */
+    while (head != *ring->cqtail)
+    {
+        const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cqmask];
+        __PHYSFS_PlatformReadRequest *req = &reqs[cqe->user_data];
+        if (cqe->res >= 0)
+        {
+            req->result = (PHYSFS_sint64) cqe->res;
+            req->error = PHYSFS_ERR_OK;
+        } /* if */
+        else
+        {
+            req->result = -1;
+            req->error = errcodeFromErrnoError(-cqe->res);
+        } /* else */
+        head++;
+        retval++;
+    } /* while */
+
+    __PHYSFS_MEMORY_BARRIER();  /* done with the cqes before handing back. */
+    *ring->cqhead = head;
+    return retval;
+} /* reapIoRing */
+
+
+/* Submit (count) reads, starting at (reqs), and wait for all of them. */
+static int runIoRing(IoRing *ring, __PHYSFS_PlatformReadRequest *reqs,
+                     const PHYSFS_uint32 first, const PHYSFS_uint32 count)
+{
+    unsigned int tail = *ring->sqtail;
+    PHYSFS_uint32 submitting = count;
+    PHYSFS_uint32 pending = count;
+    PHYSFS_uint32 i;
+
+    for (i = first; i < first + count; i++)
+    {
+        const unsigned int idx = tail & ring->sqmask;
+        struct io_uring_sqe *sqe = &ring->sqes[idx];
+        memset(sqe, '\0', sizeof (*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = *((int *) reqs[i].opaque);
+        sqe->addr = (PHYSFS_uint64) (size_t) reqs[i].buffer;
+        sqe->len = (PHYSFS_uint32) reqs[i].len;
+        sqe->off = reqs[i].pos;
+        sqe->user_data = i;
+        ring->sqarray[idx] = idx;
+        tail++;
+    } /* for */
+
+    __PHYSFS_MEMORY_BARRIER();  /* finish the sqes before publishing them. */
+    *ring->sqtail = tail;
+
+    while (pending > 0)
+    {
+        const long rc = syscall(__NR_io_uring_enter, ring->fd, submitting, 1,
+                                IORING_ENTER_GETEVENTS, NULL, 0);
+        if (rc < 0)
+        {
+            if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY))
+                continue;
+            return 0;  /* something's badly wrong; give up on the ring. */
+        } /* if */
+
+        submitting -= (PHYSFS_uint32) rc;
+        pending -= reapIoRing(ring, reqs);
+    } /* while */
+
+    return 1;
+} /* runIoRing */
+
+
+void __PHYSFS_platformReadBatch(__PHYSFS_PlatformReadRequest *reqs,
+                                PHYSFS_uint32 count)
+{
+    IoRing *ring = ioRing;
+    PHYSFS_uint32 i = 0;
+
+    if (ring == NULL)
+    {
+        readBatchOneByOne(reqs, count);
+        return;
+    } /* if */
+
+    __PHYSFS_platformGrabMutex(ring->lock);
+    while ((ring != NULL) && (i < count))
+    {
+        PHYSFS_uint32 n = 0;
+
+        /* huge reads go alone, through pread(). */
+        if (reqs[i].len > IO_RING_MAX_READ)
+        {
+            readBatchOneByOne(&reqs[i++], 1);
+            continue;
+        } /* if */
+
+        while ((i + n < count) && (n < ring->entries) &&
+               (reqs[i + n].len <= IO_RING_MAX_READ))
+            n++;
+
+        /*
+         * If the ring breaks, redo this chunk (and the rest) one by one. Any
+         *  read still in flight is reading the same data into the same
+         *  place, so that's harmless.
+         */
+        if (!runIoRing(ring, reqs, i, n))
+            ring = NULL;
+        else
+            i += n;
+    } /* while */
+    __PHYSFS_platformReleaseMutex(ioRing->lock);
+
+    if (i < count)
+        readBatchOneByOne(&reqs[i], count - i);
+} /* __PHYSFS_platformReadBatch */
+
+#else
+
+void __PHYSFS_platformReadBatch(__PHYSFS_PlatformReadRequest *reqs,
+                                PHYSFS_uint32 count)
+{
+    readBatchOneByOne(reqs, count);
+} /* __PHYSFS_platformReadBatch */
+
+
+int __PHYSFS_platformInitBatchIo(int wanted)
+{
+    return 0;  /* no kernel support compiled in. */
+} /* __PHYSFS_platformInitBatchIo */
+
+
+void __PHYSFS_platformDeinitBatchIo(void)
+{
+} /* __PHYSFS_platformDeinitBatchIo */
+
+#endif /* PHYSFS_HAVE_IO_URING */
+
+
+PHYSFS_sint64 __PHYSFS_platformWrite(void *opaque, const void *buffer,
+                                     PHYSFS_uint64 len)
+{
+    const int fd = *((int *) opaque);
+    ssize_t rc = 0;
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    rc = write(fd, (void *) buffer, (size_t) len);
+    BAIL_IF_MACRO(rc == -1, errcodeFromErrno(), rc);
+    assert(rc >= 0);
+    assert(rc <= len);
+    return (PHYSFS_sint64) rc;
+} /* __PHYSFS_platformWrite */
+
+
+int __PHYSFS_platformSeek(void *opaque, PHYSFS_uint64 pos)
+{
+    const int fd = *((int *) opaque);
+    const int rc = lseek(fd, (off_t) pos, SEEK_SET);
+    BAIL_IF_MACRO(rc == -1, errcodeFromErrno(), 0);
+    return 1;
+} /* __PHYSFS_platformSeek */
+
+
+PHYSFS_sint64 __PHYSFS_platformTell(void *opaque)
+{
+    const int fd = *((int *) opaque);
+    PHYSFS_sint64 retval;
+    retval = (PHYSFS_sint64) lseek(fd, 0, SEEK_CUR);
+    BAIL_IF_MACRO(retval == -1, errcodeFromErrno(), -1);
+    return retval;
+} /* __PHYSFS_platformTell */
+
+
+PHYSFS_sint64 __PHYSFS_platformFileLength(void *opaque)
+{
+    const int fd = *((int *) opaque);
+    struct stat statbuf;
+    BAIL_IF_MACRO(fstat(fd, &statbuf) == -1, errcodeFromErrno(), -1);
+    return ((PHYSFS_sint64) statbuf.st_size);
+} /* __PHYSFS_platformFileLength */
+
+
+int __PHYSFS_platformFlush(void *opaque)
+{
+    const int fd = *((int *) opaque);
+    if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDONLY)
+        BAIL_IF_MACRO(fsync(fd) == -1, errcodeFromErrno(), 0);
+    return 1;
+} /* __PHYSFS_platformFlush */
+
+
+int __PHYSFS_platformAdvise(void *opaque, PHYSFS_uint64 pos,
+                            PHYSFS_uint64 len, int hint)
+{
+    const int fd = *((int *) opaque);
+#if (defined POSIX_FADV_NORMAL)
+    int advice = POSIX_FADV_NORMAL;
+    int rc;
+
+    switch (hint)
+    {
+        case PHYSFS_ACCESS_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+        case PHYSFS_ACCESS_RANDOM: advice = POSIX_FADV_RANDOM; break;
+        case PHYSFS_ACCESS_WILLNEED: advice = POSIX_FADV_WILLNEED; break;
+        case PHYSFS_ACCESS_DONTNEED: advice = POSIX_FADV_DONTNEED; break;
+        default: break;
+    } /* switch */
+
+    /* this returns the error instead of setting errno. */
+    rc = posix_fadvise(fd, (off_t) pos, (off_t) len, advice);
+    BAIL_IF_MACRO(rc != 0, errcodeFromErrnoError(rc), 0);
+    return 1;
+#elif (defined F_RDADVISE)  /* Mac OS X has its own knobs. */
+    if (hint == PHYSFS_ACCESS_WILLNEED)
+    {
+        struct radvisory ra;
+        ra.ra_offset = (off_t) pos;
+        ra.ra_count = ((len == 0) || (len > 0x7FFFFFFF)) ?
+                        0x7FFFFFFF : (int) len;
+        BAIL_IF_MACRO(fcntl(fd, F_RDADVISE, &ra) == -1, errcodeFromErrno(), 0);
+    } /* if */
+    else if ((hint == PHYSFS_ACCESS_SEQUENTIAL) ||
+             (hint == PHYSFS_ACCESS_RANDOM) || (hint == PHYSFS_ACCESS_NORMAL))
+    {
+        /* readahead is per-file here, not per-range. */
+        const int ahead = (hint != PHYSFS_ACCESS_RANDOM);
+        BAIL_IF_MACRO(fcntl(fd, F_RDAHEAD, ahead) == -1,
+                      errcodeFromErrno(), 0);
+    } /* else if */
+    else
+    {
+        BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);  /* no DONTNEED. */
+    } /* else */
+    return 1;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* __PHYSFS_platformAdvise */
+
+
+int __PHYSFS_platformSetDirectIo(void *opaque, int enable)
+{
+    const int fd = *((int *) opaque);
+#if (defined O_DIRECT)
+    int flags = fcntl(fd, F_GETFL);
+    BAIL_IF_MACRO(flags == -1, errcodeFromErrno(), 0);
+    flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    /* filesystems that can't do it (like some tmpfs) fail here. */
+    BAIL_IF_MACRO(fcntl(fd, F_SETFL, flags) == -1, errcodeFromErrno(), 0);
+    return 1;
+#elif (defined F_NOCACHE)  /* Mac OS X. */
+    BAIL_IF_MACRO(fcntl(fd, F_NOCACHE, enable ? 1 : 0) == -1,
+                  errcodeFromErrno(), 0);
+    return 1;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* __PHYSFS_platformSetDirectIo */
+
+
+int __PHYSFS_platformFileBacking(void *opaque, PHYSFS_FileBacking *backing)
+{
+    backing->fd = *((int *) opaque);
+    backing->handle = NULL;
+    return 1;
+} /* __PHYSFS_platformFileBacking */
+
+
+PHYSFS_sint64 __PHYSFS_platformCopyRange(const PHYSFS_FileBacking *src,
+                                         PHYSFS_uint64 len, void *dst)
+{
+#ifdef PHYSFS_HAVE_COPY_FILE_RANGE
+    const int fd = *((int *) dst);
+    loff_t off = (loff_t) src->offset;
+    long rc;
+
+    if (len > 0x40000000)
+        len = 0x40000000;  /* it stops around 2 gigs per call anyhow. */
+
+    do
+    {
+        rc = syscall(SYS_copy_file_range, src->fd, &off, fd, NULL,
+                     (size_t) len, 0);
+    } while ((rc == -1) && (errno == EINTR));
+
+    if (rc == -1)
+    {
+        /* old kernels, different filesystems, etc: do it the long way. */
+        const int err = errno;
+        BAIL_IF_MACRO((err == ENOSYS) || (err == EXDEV) || (err == EINVAL) ||
+                      (err == EOPNOTSUPP), PHYSFS_ERR_UNSUPPORTED, -1);
+        BAIL_MACRO(errcodeFromErrnoError(err), -1);
+    } /* if */
+
+    return (PHYSFS_sint64) rc;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, -1);
+#endif
+} /* __PHYSFS_platformCopyRange */
+
+
+void __PHYSFS_platformClose(void *opaque)
+{
+    const int fd = *((int *) opaque);
+    (void) close(fd);  /* we don't check this. You should have used flush! */
+    allocator.Free(opaque);
+} /* __PHYSFS_platformClose */
+
+
+PHYSFS_uint64 __PHYSFS_platformGetTicks(void)
+{
+    struct timeval tv;
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    {
+        return (((PHYSFS_uint64) ts.tv_sec) * __PHYSFS_UI64(1000000000)) +
+               ((PHYSFS_uint64) ts.tv_nsec);
+    } /* if */
+#endif
+
+    gettimeofday(&tv, NULL);  /* not monotonic, but it'll do. */
+    return (((PHYSFS_uint64) tv.tv_sec) * __PHYSFS_UI64(1000000000)) +
+           (((PHYSFS_uint64) tv.tv_usec) * 1000);
+} /* __PHYSFS_platformGetTicks */
+
+
+#ifdef PHYSFS_HAVE_MMAP
+typedef struct
+{
+    void *addr;
+    size_t len;
+    int fd;  /* kept for __PHYSFS_platformMappingBacking(). */
+} PosixMapping;
+#endif
+
+void *__PHYSFS_platformMapFile(const char *filename, const void **ptr,
+                               PHYSFS_uint64 *len)
+{
+#ifndef PHYSFS_HAVE_MMAP
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+#else
+    PosixMapping *retval = NULL;
+    struct stat statbuf;
+    void *addr;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    BAIL_IF_MACRO(fd < 0, errcodeFromErrno(), NULL);
+
+    if (fstat(fd, &statbuf) == -1)
+    {
+        const int err = errno;
+        close(fd);
+        BAIL_MACRO(errcodeFromErrnoError(err), NULL);
+    } /* if */
+
+    /* can't map empty files, and pipes, devices, etc aren't mappable. */
+    if ( (!S_ISREG(statbuf.st_mode)) || (statbuf.st_size <= 0) ||
+         (!__PHYSFS_ui64FitsAddressSpace((PHYSFS_uint64) statbuf.st_size)) )
+    {
+        close(fd);
+        BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+    } /* if */
+
+    addr = mmap(NULL, (size_t) statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        const int err = errno;
+        close(fd);
+        BAIL_MACRO(errcodeFromErrnoError(err), NULL);
+    } /* if */
+
+    retval = (PosixMapping *) allocator.Malloc(sizeof (PosixMapping));
+    if (!retval)
+    {
+        munmap(addr, (size_t) statbuf.st_size);
+        close(fd);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    retval->addr = addr;
+    retval->len = (size_t) statbuf.st_size;
+    retval->fd = fd;
+    *ptr = addr;
+    *len = (PHYSFS_uint64) statbuf.st_size;
+    return retval;
+#endif
+} /* __PHYSFS_platformMapFile */
+
+
+void __PHYSFS_platformUnmapFile(void *mapping)
+{
+#ifdef PHYSFS_HAVE_MMAP
+    PosixMapping *m = (PosixMapping *) mapping;
+    (void) munmap(m->addr, m->len);
+    (void) close(m->fd);
+    allocator.Free(m);
+#endif
+} /* __PHYSFS_platformUnmapFile */
+
+
+int __PHYSFS_platformMappingBacking(void *mapping,
+                                    PHYSFS_FileBacking *backing)
+{
+#ifndef PHYSFS_HAVE_MMAP
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);  /* never mapped anything. */
+#else
+    backing->fd = ((PosixMapping *) mapping)->fd;
+    backing->handle = NULL;
+    return 1;
+#endif
+} /* __PHYSFS_platformMappingBacking */
+
+
+int __PHYSFS_platformAdviseMapping(void *mapping, const void *ptr,
+                                   PHYSFS_uint64 len, int hint)
+{
+#if (defined PHYSFS_HAVE_MMAP) && (defined MADV_NORMAL)
+    const size_t pagesize = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t skew = ((size_t) ptr) % pagesize;  /* must be aligned. */
+    char *addr = ((char *) ptr) - skew;
+    int advice = MADV_NORMAL;
+
+    switch (hint)
+    {
+        case PHYSFS_ACCESS_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case PHYSFS_ACCESS_RANDOM: advice = MADV_RANDOM; break;
+        case PHYSFS_ACCESS_WILLNEED: advice = MADV_WILLNEED; break;
+        case PHYSFS_ACCESS_DONTNEED: advice = MADV_DONTNEED; break;
+        default: break;
+    } /* switch */
+
+    BAIL_IF_MACRO(madvise(addr, ((size_t) len) + skew, advice) == -1,
+                  errcodeFromErrno(), 0);
+    return 1;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* __PHYSFS_platformAdviseMapping */
+
+
+#if (defined PHYSFS_HAVE_MMAP) && \
+    ((defined MAP_HUGETLB) || (defined MADV_HUGEPAGE))
+#define PHYSFS_HAVE_HUGE_PAGES 1
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+void *__PHYSFS_platformAllocHuge(size_t len)
+{
+#ifndef PHYSFS_HAVE_HUGE_PAGES
+    return NULL;
+#else
+    const size_t pagesize = __PHYSFS_HUGE_PAGE_MIN;
+    void *addr = MAP_FAILED;
+
+    if (len > ((size_t) -1) - pagesize)
+        return NULL;
+    len = ((len + pagesize - 1) / pagesize) * pagesize;
+
+    /* reserved huge pages first, if the admin set any aside... */
+#ifdef MAP_HUGETLB
+    addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    /* ...else ask for transparent ones. */
+#ifdef MADV_HUGEPAGE
+    if (addr == MAP_FAILED)
+    {
+        addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr != MAP_FAILED)
+            (void) madvise(addr, len, MADV_HUGEPAGE);  /* just a hint. */
+    } /* if */
+#endif
+
+    return (addr == MAP_FAILED) ? NULL : addr;
+#endif
+} /* __PHYSFS_platformAllocHuge */
+
+
+void __PHYSFS_platformFreeHuge(void *ptr, size_t len)
+{
+#ifdef PHYSFS_HAVE_HUGE_PAGES
+    const size_t pagesize = __PHYSFS_HUGE_PAGE_MIN;
+    (void) munmap(ptr, ((len + pagesize - 1) / pagesize) * pagesize);
+#endif
+} /* __PHYSFS_platformFreeHuge */
+
+
+void *__PHYSFS_platformAllocLocked(size_t len)
+{
+#ifndef PHYSFS_HAVE_MMAP
+    return NULL;
+#else
+    /* pages of our own, so unlocking them can't unlock anyone else's. */
+    void *addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (addr == MAP_FAILED)
+        return NULL;
+    else if (mlock(addr, len) != 0)  /* RLIMIT_MEMLOCK, usually. */
+    {
+        (void) munmap(addr, len);
+        return NULL;
+    } /* else if */
+    return addr;
+#endif
+} /* __PHYSFS_platformAllocLocked */
+
+
+void __PHYSFS_platformFreeLocked(void *ptr, size_t len)
+{
+#ifdef PHYSFS_HAVE_MMAP
+    (void) munlock(ptr, len);
+    (void) munmap(ptr, len);
+#endif
+} /* __PHYSFS_platformFreeLocked */
+
+
+int __PHYSFS_platformDelete(const char *path)
+{
+    BAIL_IF_MACRO(remove(path) == -1, errcodeFromErrno(), 0);
+    return 1;
+} /* __PHYSFS_platformDelete */
+
+
+int __PHYSFS_platformRename(const char *src, const char *dst)
+{
+    BAIL_IF_MACRO(rename(src, dst) == -1, errcodeFromErrno(), 0);
+    return 1;
+} /* __PHYSFS_platformRename */
+
+
+int __PHYSFS_platformSyncPath(const char *path)
+{
+    int err = 0;
+    const int fd = open(path, O_RDONLY);  /* fsync() works on these, too. */
+    BAIL_IF_MACRO(fd < 0, errcodeFromErrno(), 0);
+    if (fsync(fd) == -1)
+        err = errno;
+    close(fd);
+    BAIL_IF_MACRO(err != 0, errcodeFromErrnoError(err), 0);
+    return 1;
+} /* __PHYSFS_platformSyncPath */
+
+
+/* Mac OS X has fdatasync(), but doesn't declare it or document it. */
+#if (defined _POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0) && \
+    (!defined PHYSFS_PLATFORM_MACOSX)
+#define PHYSFS_HAVE_FDATASYNC 1
+#endif
+
+int __PHYSFS_platformSyncData(const char *path)
+{
+#ifdef PHYSFS_HAVE_FDATASYNC
+    int err = 0;
+    const int fd = open(path, O_RDONLY);
+    BAIL_IF_MACRO(fd < 0, errcodeFromErrno(), 0);
+    if (fdatasync(fd) == -1)
+        err = errno;
+    close(fd);
+    BAIL_IF_MACRO(err != 0, errcodeFromErrnoError(err), 0);
+    return 1;
+#else
+    return __PHYSFS_platformSyncPath(path);
+#endif
+} /* __PHYSFS_platformSyncData */
+
+
+int __PHYSFS_platformSyncFilesystem(const char *path)
+{
+#ifdef PHYSFS_HAVE_SYNCFS
+    int err = 0;
+    const int fd = open(path, O_RDONLY);
+    BAIL_IF_MACRO(fd < 0, errcodeFromErrno(), 0);
+    if (syncfs(fd) == -1)
+        err = errno;
+    close(fd);
+    BAIL_IF_MACRO(err != 0, errcodeFromErrnoError(err), 0);
+    return 1;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+#endif
+} /* __PHYSFS_platformSyncFilesystem */
+
+
+int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+{
+    struct stat statbuf;
+
+    BAIL_IF_MACRO(lstat(filename, &statbuf) == -1, errcodeFromErrno(), 0);
+    statFromStatbuf(&statbuf, st);
+
+    /* !!! FIXME: maybe we should just report full permissions? */
+    st->readonly = access(filename, W_OK);
+    return 1;
+} /* __PHYSFS_platformStat */
+
+
+void *__PHYSFS_platformOpenDir(const char *dirname)
+{
+#ifdef PHYSFS_HAVE_FSTATAT
+#ifdef O_DIRECTORY
+    const int fd = open(dirname, O_RDONLY | O_DIRECTORY);
+#else
+    const int fd = open(dirname, O_RDONLY);
+#endif
+    int *retval;
+
+    if (fd == -1)
+        return NULL;
+
+    retval = (int *) allocator.Malloc(sizeof (int));
+    if (retval == NULL)
+        close(fd);
+    else
+        *retval = fd;
+    return retval;
+#else
+    return NULL;
+#endif
+} /* __PHYSFS_platformOpenDir */
+
+
+void __PHYSFS_platformCloseDir(void *dir)
+{
+    close(*((int *) dir));
+    allocator.Free(dir);
+} /* __PHYSFS_platformCloseDir */
+
+
+int __PHYSFS_platformStatAt(void *dir, const char *relpath, PHYSFS_Stat *st)
+{
+#ifdef PHYSFS_HAVE_FSTATAT
+    const int fd = *((int *) dir);
+    struct stat statbuf;
+
+    BAIL_IF_MACRO(fstatat(fd, relpath, &statbuf, AT_SYMLINK_NOFOLLOW) == -1,
+                  errcodeFromErrno(), 0);
+    statFromStatbuf(&statbuf, st);
+    st->readonly = faccessat(fd, relpath, W_OK, 0);
+    return 1;
+#else
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);  /* OpenDir gave out nothing. */
+#endif
+} /* __PHYSFS_platformStatAt */
+
+
+#ifndef PHYSFS_PLATFORM_BEOS  /* BeOS has its own code in platform_beos.cpp */
+#if (defined PHYSFS_NO_THREAD_SUPPORT)
+
+void *__PHYSFS_platformGetThreadID(void) { return ((void *) 0x0001); }
+void *__PHYSFS_platformCreateMutex(void) { return ((void *) 0x0001); }
+void __PHYSFS_platformDestroyMutex(void *mutex) {}
+int __PHYSFS_platformGrabMutex(void *mutex) { return 1; }
+int __PHYSFS_platformTryGrabMutex(void *mutex) { return 1; }
+void __PHYSFS_platformReleaseMutex(void *mutex) {}
+void *__PHYSFS_platformCreateRWLock(void) { return ((void *) 0x0001); }
+void __PHYSFS_platformDestroyRWLock(void *rwlock) {}
+int __PHYSFS_platformGrabRWLockShared(void *rwlock) { return 1; }
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock) {}
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock) { return 1; }
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock) {}
+
+static void *threadLocalValue = NULL;
+void *__PHYSFS_platformCreateThreadLocal(void)
+{
+    threadLocalValue = NULL;
+    return ((void *) 0x0001);
+} /* __PHYSFS_platformCreateThreadLocal */
+void __PHYSFS_platformDestroyThreadLocal(void *tls) {}
+void *__PHYSFS_platformGetThreadLocal(void *tls) { return threadLocalValue; }
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value)
+{
+    threadLocalValue = value;
+    return 1;
+} /* __PHYSFS_platformSetThreadLocal */
+
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data)
+{
+    return NULL;
+} /* __PHYSFS_platformCreateThread */
+void __PHYSFS_platformWaitThread(void *thread) {}
+void *__PHYSFS_platformCreateSemaphore(void) { return NULL; }
+void __PHYSFS_platformDestroySemaphore(void *sem) {}
+void __PHYSFS_platformPostSemaphore(void *sem) {}
+void __PHYSFS_platformWaitSemaphore(void *sem) {}
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms)
+{
+    return 0;
+} /* __PHYSFS_platformWaitSemaphoreTimeout */
+
+#else
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_t owner;
+    PHYSFS_uint32 count;
+} PthreadMutex;
+
+
+void *__PHYSFS_platformGetThreadID(void)
+{
+    return ( (void *) ((size_t) pthread_self()) );
+} /* __PHYSFS_platformGetThreadID */
 
 
 void *__PHYSFS_platformCreateMutex(void)
@@ -412,6 +1526,22 @@ int __PHYSFS_platformGrabMutex(void *mutex)
 } /* __PHYSFS_platformGrabMutex */
 
 
+int __PHYSFS_platformTryGrabMutex(void *mutex)
+{
+    PthreadMutex *m = (PthreadMutex *) mutex;
+    pthread_t tid = pthread_self();
+    if (m->owner != tid)
+    {
+        if (pthread_mutex_trylock(&m->mutex) != 0)
+            return 0;
+        m->owner = tid;
+    } /* if */
+
+    m->count++;
+    return 1;
+} /* __PHYSFS_platformTryGrabMutex */
+
+
 void __PHYSFS_platformReleaseMutex(void *mutex)
 {
     PthreadMutex *m = (PthreadMutex *) mutex;
@@ -427,6 +1557,221 @@ void __PHYSFS_platformReleaseMutex(void *mutex)
     } /* if */
 } /* __PHYSFS_platformReleaseMutex */
 
+
+void *__PHYSFS_platformCreateRWLock(void)
+{
+    pthread_rwlock_t *rw;
+    rw = (pthread_rwlock_t *) allocator.Malloc(sizeof (pthread_rwlock_t));
+    BAIL_IF_MACRO(!rw, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    if (pthread_rwlock_init(rw, NULL) != 0)
+    {
+        allocator.Free(rw);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, NULL);
+    } /* if */
+    return ((void *) rw);
+} /* __PHYSFS_platformCreateRWLock */
+
+
+void __PHYSFS_platformDestroyRWLock(void *rwlock)
+{
+    pthread_rwlock_destroy((pthread_rwlock_t *) rwlock);
+    allocator.Free(rwlock);
+} /* __PHYSFS_platformDestroyRWLock */
+
+
+int __PHYSFS_platformGrabRWLockShared(void *rwlock)
+{
+    return (pthread_rwlock_rdlock((pthread_rwlock_t *) rwlock) == 0);
+} /* __PHYSFS_platformGrabRWLockShared */
+
+
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock)
+{
+    pthread_rwlock_unlock((pthread_rwlock_t *) rwlock);
+} /* __PHYSFS_platformReleaseRWLockShared */
+
+
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock)
+{
+    return (pthread_rwlock_wrlock((pthread_rwlock_t *) rwlock) == 0);
+} /* __PHYSFS_platformGrabRWLockExclusive */
+
+
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock)
+{
+    pthread_rwlock_unlock((pthread_rwlock_t *) rwlock);
+} /* __PHYSFS_platformReleaseRWLockExclusive */
+
+
+void *__PHYSFS_platformCreateThreadLocal(void)
+{
+    pthread_key_t *key = (pthread_key_t *) allocator.Malloc(sizeof (*key));
+    if (key == NULL)
+        return NULL;  /* don't set an error here; see physfs_internal.h. */
+
+    if (pthread_key_create(key, NULL) != 0)
+    {
+        allocator.Free(key);
+        return NULL;
+    } /* if */
+
+    return key;
+} /* __PHYSFS_platformCreateThreadLocal */
+
+
+void __PHYSFS_platformDestroyThreadLocal(void *tls)
+{
+    pthread_key_t *key = (pthread_key_t *) tls;
+    pthread_key_delete(*key);
+    allocator.Free(key);
+} /* __PHYSFS_platformDestroyThreadLocal */
+
+
+void *__PHYSFS_platformGetThreadLocal(void *tls)
+{
+    return pthread_getspecific(*((pthread_key_t *) tls));
+} /* __PHYSFS_platformGetThreadLocal */
+
+
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value)
+{
+    return (pthread_setspecific(*((pthread_key_t *) tls), value) == 0);
+} /* __PHYSFS_platformSetThreadLocal */
+
+
+typedef struct
+{
+    pthread_t thread;
+    void (*fn)(void *);
+    void *data;
+} PthreadThread;
+
+
+static void *pthreadThreadEntry(void *arg)
+{
+    PthreadThread *t = (PthreadThread *) arg;
+    t->fn(t->data);
+    return NULL;
+} /* pthreadThreadEntry */
+
+
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data)
+{
+    PthreadThread *t = (PthreadThread *) allocator.Malloc(sizeof (*t));
+    BAIL_IF_MACRO(!t, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    t->fn = fn;
+    t->data = data;
+    if (pthread_create(&t->thread, NULL, pthreadThreadEntry, t) != 0)
+    {
+        allocator.Free(t);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, NULL);
+    } /* if */
+    return t;
+} /* __PHYSFS_platformCreateThread */
+
+
+void __PHYSFS_platformWaitThread(void *thread)
+{
+    PthreadThread *t = (PthreadThread *) thread;
+    pthread_join(t->thread, NULL);
+    allocator.Free(t);
+} /* __PHYSFS_platformWaitThread */
+
+
+/* Mac OS X doesn't do unnamed POSIX semaphores, so build one. */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    PHYSFS_uint32 count;
+} PthreadSemaphore;
+
+
+void *__PHYSFS_platformCreateSemaphore(void)
+{
+    PthreadSemaphore *s = (PthreadSemaphore *) allocator.Malloc(sizeof (*s));
+    BAIL_IF_MACRO(!s, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    if (pthread_mutex_init(&s->mutex, NULL) != 0)
+    {
+        allocator.Free(s);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, NULL);
+    } /* if */
+
+    if (pthread_cond_init(&s->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&s->mutex);
+        allocator.Free(s);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, NULL);
+    } /* if */
+
+    s->count = 0;
+    return s;
+} /* __PHYSFS_platformCreateSemaphore */
+
+
+void __PHYSFS_platformDestroySemaphore(void *sem)
+{
+    PthreadSemaphore *s = (PthreadSemaphore *) sem;
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->mutex);
+    allocator.Free(s);
+} /* __PHYSFS_platformDestroySemaphore */
+
+
+void __PHYSFS_platformPostSemaphore(void *sem)
+{
+    PthreadSemaphore *s = (PthreadSemaphore *) sem;
+    pthread_mutex_lock(&s->mutex);
+    s->count++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+} /* __PHYSFS_platformPostSemaphore */
+
+
+void __PHYSFS_platformWaitSemaphore(void *sem)
+{
+    PthreadSemaphore *s = (PthreadSemaphore *) sem;
+    pthread_mutex_lock(&s->mutex);
+    while (s->count == 0)
+        pthread_cond_wait(&s->cond, &s->mutex);
+    s->count--;
+    pthread_mutex_unlock(&s->mutex);
+} /* __PHYSFS_platformWaitSemaphore */
+
+
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms)
+{
+    PthreadSemaphore *s = (PthreadSemaphore *) sem;
+    struct timespec ts;
+    struct timeval tv;
+    int retval = 0;
+
+    /* condition variables time out by the wall clock. */
+    gettimeofday(&tv, NULL);
+    ts.tv_sec = tv.tv_sec + (time_t) (ms / 1000);
+    ts.tv_nsec = (long) (tv.tv_usec * 1000) + (long) ((ms % 1000) * 1000000);
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    } /* if */
+
+    pthread_mutex_lock(&s->mutex);
+    while (s->count == 0)
+    {
+        if (pthread_cond_timedwait(&s->cond, &s->mutex, &ts) == ETIMEDOUT)
+            break;
+    } /* while */
+
+    if (s->count > 0)
+    {
+        s->count--;
+        retval = 1;
+    } /* if */
+    pthread_mutex_unlock(&s->mutex);
+    return retval;
+} /* __PHYSFS_platformWaitSemaphoreTimeout */
+
 #endif /* !PHYSFS_NO_THREAD_SUPPORT */
 #endif /* !PHYSFS_PLATFORM_BEOS */
 
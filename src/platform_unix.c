@@ -41,12 +41,24 @@
 
 #ifdef PHYSFS_HAVE_MNTENT_H
 #include <mntent.h>
+#if PHYSFS_PLATFORM_LINUX
+#define PHYSFS_USE_PROC_MOUNTS 1
+#include <poll.h>
+#include <fcntl.h>
+#endif
 #endif
 
 #ifdef PHYSFS_HAVE_SYS_MNTTAB_H
 #include <sys/mnttab.h>
 #endif
 
+#if (defined PHYSFS_HAVE_INOTIFY) && (!defined PHYSFS_NO_THREAD_SUPPORT)
+#define PHYSFS_USE_INOTIFY 1
+#include <sys/inotify.h>
+#include <poll.h>
+#include <fcntl.h>
+#endif
+
 #include "physfs_internal.h"
 
 int __PHYSFS_platformInit(void)
@@ -55,12 +67,53 @@ int __PHYSFS_platformInit(void)
 } /* __PHYSFS_platformInit */
 
 
+#if PHYSFS_USE_PROC_MOUNTS
+/*
+ * The kernel flags this with POLLPRI when the mount table changes after
+ *  it's opened, so we reopen it after each change.
+ */
+static int procMountsFd = -1;
+#endif
+
+
 int __PHYSFS_platformDeinit(void)
 {
+#if PHYSFS_USE_PROC_MOUNTS
+    if (procMountsFd != -1)
+    {
+        close(procMountsFd);
+        procMountsFd = -1;
+    } /* if */
+#endif
     return 1;  /* always succeed. */
 } /* __PHYSFS_platformDeinit */
 
 
+int __PHYSFS_platformCdRomsChanged(void)
+{
+#if (defined PHYSFS_NO_CDROM_SUPPORT)
+    return 0;  /* there's never anything. */
+#elif PHYSFS_USE_PROC_MOUNTS
+    struct pollfd pfd;
+
+    if (procMountsFd != -1)
+    {
+        pfd.fd = procMountsFd;
+        pfd.events = POLLPRI;
+        pfd.revents = 0;
+        if ((poll(&pfd, 1, 0) == 0) && (pfd.revents == 0))
+            return 0;
+        close(procMountsFd);
+    } /* if */
+
+    procMountsFd = open("/proc/self/mounts", O_RDONLY);
+    return 1;  /* changed, or we can't tell. */
+#else
+    return 1;  /* no way to tell; always look. */
+#endif
+} /* __PHYSFS_platformCdRomsChanged */
+
+
 /* Stub version for platforms without CD-ROM support. */
 void __PHYSFS_platformDetectAvailableCDs(PHYSFS_StringCallback cb, void *data)
 {
@@ -360,6 +413,328 @@ char *__PHYSFS_platformCalcPrefDir(const char *org, const char *app)
 } /* __PHYSFS_platformCalcPrefDir */
 
 
+#if PHYSFS_USE_INOTIFY
+
+#define INOTIFY_MASK (IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_ATTRIB | \
+                      IN_MOVED_FROM | IN_MOVED_TO)
+
+/*
+ * One inotify instance per watched dir. inotify isn't recursive, so every
+ *  subdir gets its own watch descriptor; dirs[wd] is the path of that
+ *  subdir relative to root, with a trailing '/' ("" is root itself). Only
+ *  the watch thread touches dirs once it's started.
+ */
+typedef struct
+{
+    int fd;
+    int wakepipe[2];
+    void *thread;
+    char *root;  /* with a trailing '/'. */
+    char **dirs;
+    int dircount;
+    __PHYSFS_WatchCallback callback;
+    void *data;
+} InotifyWatch;
+
+
+static char *concatPath(const char *a, const char *b)
+{
+    const size_t alen = strlen(a);
+    char *retval = (char *) allocator.Malloc(alen + strlen(b) + 1);
+    BAIL_IF_MACRO(!retval, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    strcpy(retval, a);
+    strcpy(retval + alen, b);
+    return retval;
+} /* concatPath */
+
+
+/* (reldir) has a trailing '/', or is "". Subdirs are added, too. */
+static int addInotifyDir(InotifyWatch *w, const char *reldir)
+{
+    char *path = concatPath(w->root, reldir);
+    struct dirent *ent;
+    char *copy;
+    DIR *dir;
+    int wd;
+
+    BAIL_IF_MACRO(!path, ERRPASS, 0);
+    wd = inotify_add_watch(w->fd, path,
+                           INOTIFY_MASK | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd < 0)
+    {
+        allocator.Free(path);
+        BAIL_MACRO(PHYSFS_ERR_OS_ERROR, 0);
+    } /* if */
+
+    copy = __PHYSFS_strdup(reldir);
+    if (copy == NULL)
+    {
+        inotify_rm_watch(w->fd, wd);
+        allocator.Free(path);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    } /* if */
+
+    if (wd >= w->dircount)
+    {
+        const int count = wd + 32;
+        void *ptr = allocator.Realloc(w->dirs, count * sizeof (char *));
+        if (ptr == NULL)
+        {
+            inotify_rm_watch(w->fd, wd);
+            allocator.Free(copy);
+            allocator.Free(path);
+            BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, 0);
+        } /* if */
+        w->dirs = (char **) ptr;
+        memset(w->dirs + w->dircount, '\0',
+               (count - w->dircount) * sizeof (char *));
+        w->dircount = count;
+    } /* if */
+
+    allocator.Free(w->dirs[wd]);  /* same dir, found twice. */
+    w->dirs[wd] = copy;
+
+    /* Subdirs that can't be watched are just missed; root must work. */
+    dir = opendir(path);
+    while ((dir != NULL) && ((ent = readdir(dir)) != NULL))
+    {
+        const char *name = ent->d_name;
+        char *sub;
+        int isdir;
+
+        if ((strcmp(name, ".") == 0) || (strcmp(name, "..") == 0))
+            continue;
+
+        #ifdef DT_DIR
+        if (ent->d_type != DT_UNKNOWN)
+            isdir = (ent->d_type == DT_DIR);
+        else
+        #endif
+        {
+            struct stat statbuf;
+            char *full = concatPath(path, name);
+            isdir = ((full != NULL) && (lstat(full, &statbuf) == 0) &&
+                     (S_ISDIR(statbuf.st_mode)));
+            allocator.Free(full);
+        } /* else */
+
+        if (!isdir)
+            continue;
+
+        sub = (char *) allocator.Malloc(strlen(reldir) + strlen(name) + 2);
+        if (sub != NULL)
+        {
+            sprintf(sub, "%s%s/", reldir, name);
+            addInotifyDir(w, sub);
+            allocator.Free(sub);
+        } /* if */
+    } /* while */
+
+    if (dir != NULL)
+        closedir(dir);
+
+    allocator.Free(path);
+    return 1;
+} /* addInotifyDir */
+
+
+/* (reldir) moved away; its watches follow it, but the paths we know don't. */
+static void dropInotifyDir(InotifyWatch *w, const char *reldir)
+{
+    const size_t len = strlen(reldir);
+    int i;
+
+    for (i = 0; i < w->dircount; i++)
+    {
+        if ((w->dirs[i] != NULL) && (strncmp(w->dirs[i], reldir, len) == 0))
+            inotify_rm_watch(w->fd, i);  /* IN_IGNORED frees dirs[i]. */
+    } /* for */
+} /* dropInotifyDir */
+
+
+static void handleInotifyEvent(InotifyWatch *w, const struct inotify_event *ev)
+{
+    const char *dir;
+    char *path;
+    size_t len;
+
+    if (ev->mask & IN_Q_OVERFLOW)
+    {
+        w->callback(w->data, "");  /* lost track of what changed. */
+        return;
+    } /* if */
+
+    if ((ev->wd < 0) || (ev->wd >= w->dircount) || (!w->dirs[ev->wd]))
+        return;
+
+    dir = w->dirs[ev->wd];
+    if (ev->mask & IN_IGNORED)
+    {
+        if (*dir == '\0')
+            w->callback(w->data, "");  /* root itself is gone. */
+        allocator.Free(w->dirs[ev->wd]);
+        w->dirs[ev->wd] = NULL;
+        return;
+    } /* if */
+
+    path = (char *) allocator.Malloc(strlen(dir) + ev->len + 2);
+    if (path == NULL)
+    {
+        w->callback(w->data, "");  /* oh well, we know _something_ did. */
+        return;
+    } /* if */
+
+    strcpy(path, dir);
+    if (ev->len > 0)
+    {
+        strcat(path, ev->name);
+        if (ev->mask & IN_ISDIR)
+        {
+            strcat(path, "/");
+            if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+                addInotifyDir(w, path);
+            else if (ev->mask & IN_MOVED_FROM)
+                dropInotifyDir(w, path);
+        } /* if */
+    } /* if */
+
+    len = strlen(path);
+    if ((len > 0) && (path[len - 1] == '/'))
+        path[len - 1] = '\0';
+
+    w->callback(w->data, path);
+    allocator.Free(path);
+} /* handleInotifyEvent */
+
+
+static void inotifyThread(void *data)
+{
+    InotifyWatch *w = (InotifyWatch *) data;
+    union
+    {
+        struct inotify_event ev;
+        char buf[4096];
+    } events;
+
+    while (1)
+    {
+        struct pollfd fds[2];
+        ssize_t br;
+        ssize_t i;
+
+        fds[0].fd = w->fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = w->wakepipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        } /* if */
+
+        if (fds[1].revents)
+            break;  /* being unwatched. */
+
+        br = read(w->fd, events.buf, sizeof (events.buf));
+        if (br <= 0)
+        {
+            if ((br < 0) && ((errno == EINTR) || (errno == EAGAIN)))
+                continue;
+            break;
+        } /* if */
+
+        for (i = 0; i < br; )
+        {
+            const struct inotify_event *ev;
+            ev = (const struct inotify_event *) (events.buf + i);
+            handleInotifyEvent(w, ev);
+            i += sizeof (struct inotify_event) + ev->len;
+        } /* for */
+    } /* while */
+} /* inotifyThread */
+
+
+static void freeInotifyWatch(InotifyWatch *w)
+{
+    int i;
+
+    if (w->fd != -1)
+        close(w->fd);
+    if (w->wakepipe[0] != -1)
+        close(w->wakepipe[0]);
+    if (w->wakepipe[1] != -1)
+        close(w->wakepipe[1]);
+    for (i = 0; i < w->dircount; i++)
+        allocator.Free(w->dirs[i]);
+    allocator.Free(w->dirs);
+    allocator.Free(w->root);
+    allocator.Free(w);
+} /* freeInotifyWatch */
+
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    const size_t len = strlen(dirname);
+    InotifyWatch *w = (InotifyWatch *) allocator.Malloc(sizeof (*w));
+    BAIL_IF_MACRO(!w, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(w, '\0', sizeof (*w));
+    w->fd = w->wakepipe[0] = w->wakepipe[1] = -1;
+    w->callback = cb;
+    w->data = data;
+
+    if ((len > 0) && (dirname[len - 1] == '/'))
+        w->root = __PHYSFS_strdup(dirname);
+    else
+        w->root = concatPath(dirname, "/");
+    GOTO_IF_MACRO(!w->root, PHYSFS_ERR_OUT_OF_MEMORY, watchDirFailed);
+
+    w->fd = inotify_init1(IN_CLOEXEC);
+    GOTO_IF_MACRO(w->fd == -1, PHYSFS_ERR_OS_ERROR, watchDirFailed);
+    GOTO_IF_MACRO(pipe(w->wakepipe) == -1, PHYSFS_ERR_OS_ERROR, watchDirFailed);
+    fcntl(w->wakepipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(w->wakepipe[1], F_SETFD, FD_CLOEXEC);
+
+    GOTO_IF_MACRO(!addInotifyDir(w, ""), ERRPASS, watchDirFailed);
+
+    w->thread = __PHYSFS_platformCreateThread(inotifyThread, w);
+    GOTO_IF_MACRO(!w->thread, ERRPASS, watchDirFailed);
+    return w;
+
+watchDirFailed:
+    freeInotifyWatch(w);
+    return NULL;
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    InotifyWatch *w = (InotifyWatch *) watch;
+    const char ch = 0;
+
+    while ((write(w->wakepipe[1], &ch, 1) < 0) && (errno == EINTR)) {}
+    __PHYSFS_platformWaitThread(w->thread);
+    freeInotifyWatch(w);
+} /* __PHYSFS_platformUnwatchDir */
+
+#else
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    /* no-op; nothing is ever watched. */
+} /* __PHYSFS_platformUnwatchDir */
+
+#endif
+
+
 int __PHYSFS_platformSetDefaultAllocator(PHYSFS_Allocator *a)
 {
     return 0;  /* just use malloc() and friends. */
@@ -44,6 +44,10 @@
 /* Not defined before the Vista SDK. */
 #define PHYSFS_IO_REPARSE_TAG_SYMLINK    0xA000000C
 
+/* FindFirstFileExW() knobs from the Windows 7 SDK. */
+#define PHYSFS_FIND_EX_INFO_BASIC        ((FINDEX_INFO_LEVELS) 1)
+#define PHYSFS_FIND_FIRST_EX_LARGE_FETCH 2
+
 
 #define UTF8_TO_UNICODE_STACK_MACRO(w_assignto, str) { \
     if (str == NULL) \
@@ -56,6 +60,30 @@
     } \
 } \
 
+/*
+ * Like UTF8_TO_UNICODE_STACK_MACRO, but into (scratch), a WCHAR array the
+ *  caller has on the stack, when it fits. It's a lot bigger than what
+ *  __PHYSFS_smallAlloc() will put on the stack, so the full paths we open
+ *  and stat all the time don't hit the heap. Free with UNICODE_SCRATCH_FREE.
+ */
+#define UTF8_TO_UNICODE_SCRATCH_MACRO(w_assignto, str, scratch) { \
+    const PHYSFS_uint64 len = (PHYSFS_uint64) ((strlen(str) + 1) * 2); \
+    if (len <= sizeof (scratch)) \
+        w_assignto = scratch; \
+    else \
+        w_assignto = (WCHAR *) allocator.Malloc((size_t) len); \
+    if (w_assignto != NULL) \
+        PHYSFS_utf8ToUtf16(str, (PHYSFS_uint16 *) w_assignto, len); \
+} \
+
+#define UNICODE_SCRATCH_FREE(w, scratch) { \
+    if ((w) != (scratch)) \
+        allocator.Free(w); \
+} \
+
+/* WCHARs in a scratch buffer; plenty for any path that isn't \\?\ style. */
+#define UNICODE_SCRATCH_LEN 1024
+
 /* Note this counts WCHARs, not codepoints! */
 static PHYSFS_uint64 wStrLen(const WCHAR *wstr)
 {
@@ -86,6 +114,8 @@ static char *unicodeToUtf8Heap(const WCHAR *w_str)
 typedef struct
 {
     HANDLE handle;
+    HANDLE async;  /* FILE_FLAG_OVERLAPPED twin, for batched reads, or NULL. */
+    void *readAtLock;  /* held while ReadAt() borrows the file pointer. */
     int readonly;
 } WinApiFile;
 
@@ -325,6 +355,13 @@ void __PHYSFS_platformDetectAvailableCDs(PHYSFS_StringCallback cb, void *data)
 } /* __PHYSFS_platformDetectAvailableCDs */
 
 
+int __PHYSFS_platformCdRomsChanged(void)
+{
+    /* detectCDThread keeps the bitmap current, so looking is free. */
+    return 1;
+} /* __PHYSFS_platformCdRomsChanged */
+
+
 char *__PHYSFS_platformCalcBaseDir(const char *argv0)
 {
     DWORD buflen = 64;
@@ -480,21 +517,271 @@ void *__PHYSFS_platformGetThreadID(void)
     return ( (void *) ((size_t) GetCurrentThreadId()) );
 } /* __PHYSFS_platformGetThreadID */
 
-void __PHYSFS_platformEnumerateFiles(const char *dirname,
-                                     PHYSFS_EnumFilesCallback callback,
-                                     const char *origdir,
-                                     void *callbackdata)
+
+/* TLS indices start at zero, so we store them plus one, to not look NULL. */
+void *__PHYSFS_platformCreateThreadLocal(void)
+{
+    const DWORD idx = TlsAlloc();
+    if (idx == TLS_OUT_OF_INDEXES)
+        return NULL;  /* don't set an error here; see physfs_internal.h. */
+    return (void *) (((size_t) idx) + 1);
+} /* __PHYSFS_platformCreateThreadLocal */
+
+
+void __PHYSFS_platformDestroyThreadLocal(void *tls)
+{
+    TlsFree((DWORD) (((size_t) tls) - 1));
+} /* __PHYSFS_platformDestroyThreadLocal */
+
+
+void *__PHYSFS_platformGetThreadLocal(void *tls)
+{
+    return TlsGetValue((DWORD) (((size_t) tls) - 1));
+} /* __PHYSFS_platformGetThreadLocal */
+
+
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value)
+{
+    return (TlsSetValue((DWORD) (((size_t) tls) - 1), value) != 0);
+} /* __PHYSFS_platformSetThreadLocal */
+
+
+typedef struct
+{
+    HANDLE handle;
+    void (*fn)(void *);
+    void *data;
+} WinApiThread;
+
+
+static DWORD WINAPI winApiThreadEntry(LPVOID arg)
+{
+    WinApiThread *t = (WinApiThread *) arg;
+    t->fn(t->data);
+    return 0;
+} /* winApiThreadEntry */
+
+
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data)
+{
+    WinApiThread *t = (WinApiThread *) allocator.Malloc(sizeof (*t));
+    BAIL_IF_MACRO(!t, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    t->fn = fn;
+    t->data = data;
+    t->handle = CreateThread(NULL, 0, winApiThreadEntry, t, 0, NULL);
+    if (t->handle == NULL)
+    {
+        allocator.Free(t);
+        BAIL_MACRO(errcodeFromWinApi(), NULL);
+    } /* if */
+    return t;
+} /* __PHYSFS_platformCreateThread */
+
+
+void __PHYSFS_platformWaitThread(void *thread)
+{
+    WinApiThread *t = (WinApiThread *) thread;
+    WaitForSingleObject(t->handle, INFINITE);
+    CloseHandle(t->handle);
+    allocator.Free(t);
+} /* __PHYSFS_platformWaitThread */
+
+
+void *__PHYSFS_platformCreateSemaphore(void)
+{
+    HANDLE h = CreateSemaphoreW(NULL, 0, 0x7FFFFFFF, NULL);
+    BAIL_IF_MACRO(h == NULL, errcodeFromWinApi(), NULL);
+    return (void *) h;
+} /* __PHYSFS_platformCreateSemaphore */
+
+
+void __PHYSFS_platformDestroySemaphore(void *sem)
+{
+    CloseHandle((HANDLE) sem);
+} /* __PHYSFS_platformDestroySemaphore */
+
+
+void __PHYSFS_platformPostSemaphore(void *sem)
+{
+    ReleaseSemaphore((HANDLE) sem, 1, NULL);
+} /* __PHYSFS_platformPostSemaphore */
+
+
+void __PHYSFS_platformWaitSemaphore(void *sem)
+{
+    WaitForSingleObject((HANDLE) sem, INFINITE);
+} /* __PHYSFS_platformWaitSemaphore */
+
+
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms)
+{
+    return (WaitForSingleObject((HANDLE) sem, (DWORD) ms) == WAIT_OBJECT_0);
+} /* __PHYSFS_platformWaitSemaphoreTimeout */
+
+
+typedef struct
+{
+    HANDLE dir;
+    HANDLE stopEvent;
+    void *thread;
+    __PHYSFS_WatchCallback callback;
+    void *data;
+} WinApiWatch;
+
+
+/* A FILE_NOTIFY_INFORMATION's name isn't NUL-terminated. */
+static void reportDirChange(WinApiWatch *w, const FILE_NOTIFY_INFORMATION *info)
+{
+    const DWORD wlen = info->FileNameLength / sizeof (WCHAR);
+    const PHYSFS_uint64 len = (wlen * 4) + 1;
+    WCHAR *wpath = (WCHAR *) __PHYSFS_smallAlloc((wlen + 1) * sizeof (WCHAR));
+    char *path = (char *) __PHYSFS_smallAlloc(len);
+    char *ptr;
+
+    if ((wpath == NULL) || (path == NULL))
+        w->callback(w->data, "");  /* something changed, anyhow. */
+    else
+    {
+        memcpy(wpath, info->FileName, wlen * sizeof (WCHAR));
+        wpath[wlen] = 0;
+        PHYSFS_utf8FromUtf16((const PHYSFS_uint16 *) wpath, path, len);
+        for (ptr = path; *ptr; ptr++)
+        {
+            if (*ptr == '\\')
+                *ptr = '/';
+        } /* for */
+        w->callback(w->data, path);
+    } /* else */
+
+    __PHYSFS_smallFree(path);
+    __PHYSFS_smallFree(wpath);
+} /* reportDirChange */
+
+
+static void winApiWatchThread(void *data)
+{
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME |
+                         FILE_NOTIFY_CHANGE_DIR_NAME |
+                         FILE_NOTIFY_CHANGE_SIZE |
+                         FILE_NOTIFY_CHANGE_LAST_WRITE |
+                         FILE_NOTIFY_CHANGE_ATTRIBUTES;
+    WinApiWatch *w = (WinApiWatch *) data;
+    DWORD buffer[4096];  /* DWORD-aligned, as ReadDirectoryChangesW wants. */
+    OVERLAPPED ov;
+    HANDLE handles[2];
+
+    memset(&ov, '\0', sizeof (ov));
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (ov.hEvent == NULL)
+        return;
+
+    handles[0] = ov.hEvent;
+    handles[1] = w->stopEvent;
+
+    while (1)
+    {
+        const BYTE *ptr = (const BYTE *) buffer;
+        DWORD br = 0;
+
+        ResetEvent(ov.hEvent);
+        if (!ReadDirectoryChangesW(w->dir, buffer, sizeof (buffer), TRUE,
+                                   filter, NULL, &ov, NULL))
+            break;
+
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIo(w->dir);
+            GetOverlappedResult(w->dir, &ov, &br, TRUE);
+            break;  /* being unwatched. */
+        } /* if */
+
+        if (!GetOverlappedResult(w->dir, &ov, &br, FALSE))
+            break;  /* dir went away? */
+
+        if (br == 0)  /* buffer overflowed; lost track of what changed. */
+        {
+            w->callback(w->data, "");
+            continue;
+        } /* if */
+
+        while (1)
+        {
+            const FILE_NOTIFY_INFORMATION *info;
+            info = (const FILE_NOTIFY_INFORMATION *) ptr;
+            reportDirChange(w, info);
+            if (info->NextEntryOffset == 0)
+                break;
+            ptr += info->NextEntryOffset;
+        } /* while */
+    } /* while */
+
+    CloseHandle(ov.hEvent);
+} /* winApiWatchThread */
+
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    const DWORD flags = FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED;
+    WinApiWatch *w;
+    WCHAR *wdir;
+
+    w = (WinApiWatch *) allocator.Malloc(sizeof (WinApiWatch));
+    BAIL_IF_MACRO(!w, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    memset(w, '\0', sizeof (WinApiWatch));
+    w->dir = INVALID_HANDLE_VALUE;
+    w->callback = cb;
+    w->data = data;
+
+    UTF8_TO_UNICODE_STACK_MACRO(wdir, dirname);
+    GOTO_IF_MACRO(!wdir, PHYSFS_ERR_OUT_OF_MEMORY, watchDirFailed);
+    w->dir = CreateFileW(wdir, FILE_LIST_DIRECTORY, share, NULL,
+                         OPEN_EXISTING, flags, NULL);
+    __PHYSFS_smallFree(wdir);
+    GOTO_IF_MACRO(w->dir == INVALID_HANDLE_VALUE, errcodeFromWinApi(),
+                  watchDirFailed);
+
+    w->stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    GOTO_IF_MACRO(!w->stopEvent, errcodeFromWinApi(), watchDirFailed);
+
+    w->thread = __PHYSFS_platformCreateThread(winApiWatchThread, w);
+    GOTO_IF_MACRO(!w->thread, ERRPASS, watchDirFailed);
+    return w;
+
+watchDirFailed:
+    if (w->stopEvent != NULL)
+        CloseHandle(w->stopEvent);
+    if (w->dir != INVALID_HANDLE_VALUE)
+        CloseHandle(w->dir);
+    allocator.Free(w);
+    return NULL;
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+    WinApiWatch *w = (WinApiWatch *) watch;
+    SetEvent(w->stopEvent);
+    __PHYSFS_platformWaitThread(w->thread);
+    CloseHandle(w->stopEvent);
+    CloseHandle(w->dir);
+    allocator.Free(w);
+} /* __PHYSFS_platformUnwatchDir */
+
+/* Start listing (dirname); INVALID_HANDLE_VALUE if we can't. */
+static HANDLE findFirstInDir(const char *dirname, WIN32_FIND_DATAW *entw)
 {
     HANDLE dir = INVALID_HANDLE_VALUE;
-    WIN32_FIND_DATAW entw;
     size_t len = strlen(dirname);
     char *searchPath = NULL;
     WCHAR *wSearchPath = NULL;
+    WCHAR scratch[UNICODE_SCRATCH_LEN];
 
     /* Allocate a new string for path, maybe '\\', "*", and NULL terminator */
     searchPath = (char *) __PHYSFS_smallAlloc(len + 3);
     if (searchPath == NULL)
-        return;
+        return INVALID_HANDLE_VALUE;
 
     /* Copy current dirname */
     strcpy(searchPath, dirname);
@@ -509,14 +796,36 @@ void __PHYSFS_platformEnumerateFiles(const char *dirname,
     /* Append the "*" to the end of the string */
     strcat(searchPath, "*");
 
-    UTF8_TO_UNICODE_STACK_MACRO(wSearchPath, searchPath);
-    if (!wSearchPath)
-        return;  /* oh well. */
-
-    dir = FindFirstFileW(wSearchPath, &entw);
+    UTF8_TO_UNICODE_SCRATCH_MACRO(wSearchPath, searchPath, scratch);
+    if (wSearchPath != NULL)
+    {
+        /*
+         * Skip the 8.3 names we never use, and fetch entries in big gulps,
+         *  which matters a lot on network drives. Before Windows 7, neither
+         *  is understood, so ask again the old way.
+         */
+        dir = FindFirstFileExW(wSearchPath, PHYSFS_FIND_EX_INFO_BASIC, entw,
+                               FindExSearchNameMatch, NULL,
+                               PHYSFS_FIND_FIRST_EX_LARGE_FETCH);
+        if ((dir == INVALID_HANDLE_VALUE) &&
+            (GetLastError() == ERROR_INVALID_PARAMETER))
+            dir = FindFirstFileW(wSearchPath, entw);
+        UNICODE_SCRATCH_FREE(wSearchPath, scratch);
+    } /* if */
 
-    __PHYSFS_smallFree(wSearchPath);
     __PHYSFS_smallFree(searchPath);
+    return dir;
+} /* findFirstInDir */
+
+
+void __PHYSFS_platformEnumerateFiles(const char *dirname,
+                                     PHYSFS_EnumFilesCallback callback,
+                                     const char *origdir,
+                                     void *callbackdata)
+{
+    WIN32_FIND_DATAW entw;
+    HANDLE dir = findFirstInDir(dirname, &entw);
+
     if (dir == INVALID_HANDLE_VALUE)
         return;
 
@@ -554,8 +863,102 @@ int __PHYSFS_platformMkDir(const char *path)
 } /* __PHYSFS_platformMkDir */
 
 
+/*
+ * Slim reader-writer locks showed up in Vista, so we look for them at
+ *  runtime; on XP, our rwlocks are just critical sections, and everyone
+ *  takes turns. An SRWLOCK is a single pointer that starts out NULL.
+ */
+typedef void (WINAPI *fnSRWLOCK)(void **srw);
+static fnSRWLOCK pAcquireSRWLockShared = NULL;
+static fnSRWLOCK pReleaseSRWLockShared = NULL;
+static fnSRWLOCK pAcquireSRWLockExclusive = NULL;
+static fnSRWLOCK pReleaseSRWLockExclusive = NULL;
+
+static void loadSRWLocks(void)
+{
+    HANDLE lib = LoadLibraryA("kernel32.dll");
+    if (lib)
+    {
+        pAcquireSRWLockShared = (fnSRWLOCK)
+                            GetProcAddress(lib, "AcquireSRWLockShared");
+        pReleaseSRWLockShared = (fnSRWLOCK)
+                            GetProcAddress(lib, "ReleaseSRWLockShared");
+        pAcquireSRWLockExclusive = (fnSRWLOCK)
+                            GetProcAddress(lib, "AcquireSRWLockExclusive");
+        pReleaseSRWLockExclusive = (fnSRWLOCK)
+                            GetProcAddress(lib, "ReleaseSRWLockExclusive");
+    } /* if */
+
+    /* all or nothing. */
+    if ( (!pAcquireSRWLockShared) || (!pReleaseSRWLockShared) ||
+         (!pAcquireSRWLockExclusive) || (!pReleaseSRWLockExclusive) )
+    {
+        pAcquireSRWLockShared = pReleaseSRWLockShared = NULL;
+        pAcquireSRWLockExclusive = pReleaseSRWLockExclusive = NULL;
+    } /* if */
+} /* loadSRWLocks */
+
+
+/*
+ * PrefetchVirtualMemory() showed up in Windows 8, so we look for it at
+ *  runtime, too, with our own copy of its range struct for older SDKs.
+ */
+typedef struct PHYSFS_WinMemoryRange
+{
+    void *VirtualAddress;
+    SIZE_T NumberOfBytes;
+} PHYSFS_WinMemoryRange;
+
+typedef BOOL (WINAPI *fnPrefetchVirtualMemory)(HANDLE, ULONG_PTR,
+                                               PHYSFS_WinMemoryRange *, ULONG);
+static fnPrefetchVirtualMemory pPrefetchVirtualMemory = NULL;
+
+static void loadPrefetchVirtualMemory(void)
+{
+    HANDLE lib = LoadLibraryA("kernel32.dll");
+    if (lib)
+    {
+        pPrefetchVirtualMemory = (fnPrefetchVirtualMemory)
+                            GetProcAddress(lib, "PrefetchVirtualMemory");
+    } /* if */
+} /* loadPrefetchVirtualMemory */
+
+
+/* ReOpenFile() is Vista and later; we only need it for uncached reads. */
+typedef HANDLE (WINAPI *fnReOpenFile)(HANDLE, DWORD, DWORD, DWORD);
+static fnReOpenFile pReOpenFile = NULL;
+
+static void loadReOpenFile(void)
+{
+    HANDLE lib = LoadLibraryA("kernel32.dll");
+    if (lib)
+        pReOpenFile = (fnReOpenFile) GetProcAddress(lib, "ReOpenFile");
+} /* loadReOpenFile */
+
+
+/* GetLargePageMinimum() is Vista and later, too. */
+typedef SIZE_T (WINAPI *fnGetLargePageMinimum)(void);
+static SIZE_T largePageSize = 0;
+
+static void loadLargePageMinimum(void)
+{
+    HANDLE lib = LoadLibraryA("kernel32.dll");
+    if (lib)
+    {
+        fnGetLargePageMinimum pGetLargePageMinimum = (fnGetLargePageMinimum)
+                            GetProcAddress(lib, "GetLargePageMinimum");
+        if (pGetLargePageMinimum)
+            largePageSize = pGetLargePageMinimum();
+    } /* if */
+} /* loadLargePageMinimum */
+
+
 int __PHYSFS_platformInit(void)
 {
+    loadSRWLocks();
+    loadPrefetchVirtualMemory();
+    loadReOpenFile();
+    loadLargePageMinimum();
     return 1;  /* It's all good */
 } /* __PHYSFS_platformInit */
 
@@ -581,12 +984,13 @@ static void *doOpen(const char *fname, DWORD mode, DWORD creation, int rdonly)
     HANDLE fileh;
     WinApiFile *retval;
     WCHAR *wfname;
+    WCHAR scratch[UNICODE_SCRATCH_LEN];
 
-    UTF8_TO_UNICODE_STACK_MACRO(wfname, fname);
+    UTF8_TO_UNICODE_SCRATCH_MACRO(wfname, fname, scratch);
     BAIL_IF_MACRO(!wfname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
     fileh = CreateFileW(wfname, mode, FILE_SHARE_READ | FILE_SHARE_WRITE,
                              NULL, creation, FILE_ATTRIBUTE_NORMAL, NULL);
-    __PHYSFS_smallFree(wfname);
+    UNICODE_SCRATCH_FREE(wfname, scratch);
 
     BAIL_IF_MACRO(fileh == INVALID_HANDLE_VALUE,errcodeFromWinApi(), NULL);
 
@@ -597,8 +1001,17 @@ static void *doOpen(const char *fname, DWORD mode, DWORD creation, int rdonly)
         BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
     } /* if */
 
+    retval->readAtLock = __PHYSFS_platformCreateMutex();
+    if (!retval->readAtLock)
+    {
+        CloseHandle(fileh);
+        allocator.Free(retval);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
     retval->readonly = rdonly;
     retval->handle = fileh;
+    retval->async = NULL;
     return retval;
 } /* doOpen */
 
@@ -626,6 +1039,7 @@ void *__PHYSFS_platformOpenAppend(const char *filename)
         {
             const PHYSFS_ErrorCode err = errcodeFromWinApi();
             CloseHandle(h);
+            __PHYSFS_platformDestroyMutex(((WinApiFile *) retval)->readAtLock);
             allocator.Free(retval);
             BAIL_MACRO(err, NULL);
         } /* if */
@@ -659,6 +1073,258 @@ PHYSFS_sint64 __PHYSFS_platformRead(void *opaque, void *buf, PHYSFS_uint64 len)
 } /* __PHYSFS_platformRead */
 
 
+PHYSFS_sint64 __PHYSFS_platformReadAt(void *opaque, void *buf,
+                                      PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+    WinApiFile *fh = (WinApiFile *) opaque;
+    HANDLE Handle = fh->handle;
+    PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+    PHYSFS_sint64 totalRead = 0;
+    LARGE_INTEGER zero;
+    LARGE_INTEGER origpos;
+
+    if (!__PHYSFS_ui64FitsAddressSpace(len))
+        BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+    /*
+     * ReadFile() with an OVERLAPPED on a synchronous handle reads at the
+     *  given offset, but still moves the file pointer afterwards, so put it
+     *  back. The pointer is shared by every thread reading this handle, so
+     *  each save/read/restore holds the handle's lock; otherwise one thread
+     *  could save another's half-finished read position and restore it last.
+     */
+    zero.QuadPart = 0;
+    __PHYSFS_platformGrabMutex(fh->readAtLock);
+    if (!SetFilePointerEx(Handle, zero, &origpos, FILE_CURRENT))
+    {
+        __PHYSFS_platformReleaseMutex(fh->readAtLock);
+        BAIL_MACRO(errcodeFromWinApi(), -1);
+    } /* if */
+
+    while (len > 0)
+    {
+        const DWORD thislen = (len > 0xFFFFFFFF) ? 0xFFFFFFFF : (DWORD) len;
+        DWORD numRead = 0;
+        OVERLAPPED ov;
+        memset(&ov, '\0', sizeof (ov));
+        ov.Offset = LOWORDER_UINT64(pos);
+        ov.OffsetHigh = HIGHORDER_UINT64(pos);
+        if (!ReadFile(Handle, ptr, thislen, &numRead, &ov))
+        {
+            const DWORD err = GetLastError();
+            if (err == ERROR_HANDLE_EOF)
+                break;  /* reading past EOF isn't an error, just short. */
+            SetFilePointerEx(Handle, origpos, NULL, FILE_BEGIN);
+            __PHYSFS_platformReleaseMutex(fh->readAtLock);
+            BAIL_MACRO(errcodeFromWinApiError(err), -1);
+        } /* if */
+        len -= (PHYSFS_uint64) numRead;
+        pos += (PHYSFS_uint64) numRead;
+        ptr += numRead;
+        totalRead += (PHYSFS_sint64) numRead;
+        if (numRead != thislen)
+            break;
+    } /* while */
+
+    SetFilePointerEx(Handle, origpos, NULL, FILE_BEGIN);
+    __PHYSFS_platformReleaseMutex(fh->readAtLock);
+    return totalRead;
+} /* __PHYSFS_platformReadAt */
+
+
+PHYSFS_sint64 __PHYSFS_platformReadv(void *opaque, const PHYSFS_IoVec *iov,
+                                     PHYSFS_uint32 count)
+{
+    PHYSFS_sint64 retval = 0;
+    PHYSFS_uint32 i;
+
+    /* ReadFileScatter() wants unbuffered handles and whole pages; loop. */
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_sint64 rc = __PHYSFS_platformRead(opaque, iov[i].buf,
+                                                       iov[i].len);
+        if (rc < 0)
+            return (retval == 0) ? -1 : retval;
+        retval += rc;
+        if (((PHYSFS_uint64) rc) < iov[i].len)
+            break;  /* EOF. */
+    } /* for */
+
+    return retval;
+} /* __PHYSFS_platformReadv */
+
+
+static void readBatchOneByOne(__PHYSFS_PlatformReadRequest *reqs,
+                              PHYSFS_uint32 count)
+{
+    PHYSFS_uint32 i;
+    for (i = 0; i < count; i++)
+    {
+        __PHYSFS_PlatformReadRequest *req = &reqs[i];
+        req->result = __PHYSFS_platformReadAt(req->opaque, req->buffer,
+                                              req->len, req->pos);
+        req->error = PHYSFS_ERR_OK;
+        if (req->result < 0)
+            req->error = PHYSFS_getLastErrorCode();
+    } /* for */
+} /* readBatchOneByOne */
+
+
+/*
+ * Batched reads go through an I/O completion port. Our usual handles are
+ *  synchronous, so everything else keeps its simple file pointer, and each
+ *  file gets an overlapped twin the first time it's in a batch. Batches
+ *  take turns on the one port, like the io_uring does on Linux, so every
+ *  completion we see belongs to the batch that's holding the lock.
+ */
+static HANDLE ioPort = NULL;
+static void *ioPortLock = NULL;
+
+int __PHYSFS_platformInitBatchIo(int wanted)
+{
+    if ((!wanted) || (!pReOpenFile))
+        return 0;
+
+    ioPortLock = __PHYSFS_platformCreateMutex();
+    if (ioPortLock == NULL)
+        return 0;
+
+    ioPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (ioPort == NULL)
+    {
+        __PHYSFS_platformDestroyMutex(ioPortLock);
+        ioPortLock = NULL;
+        return 0;
+    } /* if */
+
+    return 1;
+} /* __PHYSFS_platformInitBatchIo */
+
+
+void __PHYSFS_platformDeinitBatchIo(void)
+{
+    if (ioPort != NULL)
+    {
+        CloseHandle(ioPort);
+        __PHYSFS_platformDestroyMutex(ioPortLock);
+        ioPort = NULL;
+        ioPortLock = NULL;
+    } /* if */
+} /* __PHYSFS_platformDeinitBatchIo */
+
+
+/* Call with ioPortLock held. NULL if (fh) can't do overlapped reads. */
+static HANDLE asyncHandleFor(WinApiFile *fh)
+{
+    if ((fh->async == NULL) && (fh->readonly))
+    {
+        const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE;
+        HANDLE h = pReOpenFile(fh->handle, GENERIC_READ, share,
+                               FILE_FLAG_OVERLAPPED);
+        if (h == INVALID_HANDLE_VALUE)
+            return NULL;
+        else if (CreateIoCompletionPort(h, ioPort, 0, 0) == NULL)
+        {
+            CloseHandle(h);
+            return NULL;
+        } /* else if */
+        fh->async = h;
+    } /* if */
+
+    return fh->async;
+} /* asyncHandleFor */
+
+
+void __PHYSFS_platformReadBatch(__PHYSFS_PlatformReadRequest *reqs,
+                                PHYSFS_uint32 count)
+{
+    OVERLAPPED *ovs;
+    PHYSFS_uint32 pending = 0;
+    PHYSFS_uint32 i;
+
+    if (ioPort == NULL)
+    {
+        readBatchOneByOne(reqs, count);
+        return;
+    } /* if */
+
+    ovs = (OVERLAPPED *) allocator.Malloc(sizeof (OVERLAPPED) * count);
+    if (ovs == NULL)
+    {
+        readBatchOneByOne(reqs, count);
+        return;
+    } /* if */
+    memset(ovs, '\0', sizeof (OVERLAPPED) * count);
+
+    __PHYSFS_platformGrabMutex(ioPortLock);
+    for (i = 0; i < count; i++)
+    {
+        __PHYSFS_PlatformReadRequest *req = &reqs[i];
+        HANDLE h = asyncHandleFor((WinApiFile *) req->opaque);
+        DWORD err;
+
+        if (h == NULL)
+        {
+            readBatchOneByOne(req, 1);
+            continue;
+        } /* if */
+
+        /* the caller keeps (len) under 2 gigabytes. */
+        ovs[i].Offset = LOWORDER_UINT64(req->pos);
+        ovs[i].OffsetHigh = HIGHORDER_UINT64(req->pos);
+        if (ReadFile(h, req->buffer, (DWORD) req->len, NULL, &ovs[i]))
+        {
+            pending++;  /* done already, but the port hears about it. */
+            continue;
+        } /* if */
+
+        err = GetLastError();
+        if (err == ERROR_IO_PENDING)
+            pending++;
+        else if (err == ERROR_HANDLE_EOF)
+        {
+            req->result = 0;  /* past the end is short, not an error. */
+            req->error = PHYSFS_ERR_OK;
+        } /* else if */
+        else
+        {
+            req->result = -1;
+            req->error = errcodeFromWinApiError(err);
+        } /* else */
+    } /* for */
+
+    while (pending > 0)
+    {
+        __PHYSFS_PlatformReadRequest *req;
+        OVERLAPPED *ov = NULL;
+        ULONG_PTR key = 0;
+        DWORD numRead = 0;
+        BOOL rc;
+
+        rc = GetQueuedCompletionStatus(ioPort, &numRead, &key, &ov, INFINITE);
+        if (ov == NULL)
+            break;  /* the port itself failed; nothing left to wait on. */
+
+        req = &reqs[ov - ovs];
+        req->result = (PHYSFS_sint64) numRead;
+        req->error = PHYSFS_ERR_OK;
+        if (!rc)
+        {
+            const DWORD err = GetLastError();
+            if (err != ERROR_HANDLE_EOF)
+            {
+                req->result = -1;
+                req->error = errcodeFromWinApiError(err);
+            } /* if */
+        } /* if */
+        pending--;
+    } /* while */
+    __PHYSFS_platformReleaseMutex(ioPortLock);
+
+    allocator.Free(ovs);
+} /* __PHYSFS_platformReadBatch */
+
+
 PHYSFS_sint64 __PHYSFS_platformWrite(void *opaque, const void *buffer,
                                      PHYSFS_uint64 len)
 {
@@ -773,14 +1439,216 @@ int __PHYSFS_platformFlush(void *opaque)
 } /* __PHYSFS_platformFlush */
 
 
+/*
+ * FILE_FLAG_SEQUENTIAL_SCAN and FILE_FLAG_RANDOM_ACCESS only count when the
+ *  file is opened, and PrefetchVirtualMemory() only helps mapped views, so
+ *  there's nothing to tell Windows about a file that's already open.
+ */
+int __PHYSFS_platformAdvise(void *opaque, PHYSFS_uint64 pos,
+                            PHYSFS_uint64 len, int hint)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformAdvise */
+
+
+/*
+ * FILE_FLAG_NO_BUFFERING only counts when the file is opened, so swap in a
+ *  new handle to the same file that has it (or doesn't). Our caller keeps
+ *  track of the position itself.
+ */
+int __PHYSFS_platformSetDirectIo(void *opaque, int enable)
+{
+    WinApiFile *fh = (WinApiFile *) opaque;
+    const DWORD flags = enable ? FILE_FLAG_NO_BUFFERING : 0;
+    HANDLE h;
+
+    BAIL_IF_MACRO(!pReOpenFile, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!fh->readonly, PHYSFS_ERR_UNSUPPORTED, 0);
+    h = pReOpenFile(fh->handle, GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE, flags);
+    BAIL_IF_MACRO(h == INVALID_HANDLE_VALUE, errcodeFromWinApi(), 0);
+    CloseHandle(fh->handle);
+    fh->handle = h;
+    return 1;
+} /* __PHYSFS_platformSetDirectIo */
+
+
+int __PHYSFS_platformFileBacking(void *opaque, PHYSFS_FileBacking *backing)
+{
+    backing->fd = -1;
+    backing->handle = (void *) ((WinApiFile *) opaque)->handle;
+    return 1;
+} /* __PHYSFS_platformFileBacking */
+
+
+PHYSFS_sint64 __PHYSFS_platformCopyRange(const PHYSFS_FileBacking *src,
+                                         PHYSFS_uint64 len, void *dst)
+{
+    /* CopyFileExW() wants paths, and we only have the handles here. */
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, -1);
+} /* __PHYSFS_platformCopyRange */
+
+
 void __PHYSFS_platformClose(void *opaque)
 {
-    HANDLE Handle = ((WinApiFile *) opaque)->handle;
-    (void) CloseHandle(Handle); /* ignore errors. You should have flushed! */
+    WinApiFile *fh = (WinApiFile *) opaque;
+    (void) CloseHandle(fh->handle);  /* ignore errors. Should've flushed! */
+    if (fh->async != NULL)
+        CloseHandle(fh->async);
+    __PHYSFS_platformDestroyMutex(fh->readAtLock);
     allocator.Free(opaque);
 } /* __PHYSFS_platformClose */
 
 
+typedef struct
+{
+    void *view;
+    HANDLE file;  /* kept for __PHYSFS_platformMappingBacking(). */
+} WinApiMapping;
+
+void *__PHYSFS_platformMapFile(const char *filename, const void **ptr,
+                               PHYSFS_uint64 *len)
+{
+    WinApiMapping *retval;
+    HANDLE fileh;
+    HANDLE maph;
+    LARGE_INTEGER size;
+    void *view;
+    WCHAR *wfname;
+
+    UTF8_TO_UNICODE_STACK_MACRO(wfname, filename);
+    BAIL_IF_MACRO(!wfname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    fileh = CreateFileW(wfname, GENERIC_READ, FILE_SHARE_READ,
+                        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    __PHYSFS_smallFree(wfname);
+    BAIL_IF_MACRO(fileh == INVALID_HANDLE_VALUE, errcodeFromWinApi(), NULL);
+
+    if (!GetFileSizeEx(fileh, &size))
+    {
+        const PHYSFS_ErrorCode err = errcodeFromWinApi();
+        CloseHandle(fileh);
+        BAIL_MACRO(err, NULL);
+    } /* if */
+
+    /* can't map empty files, or anything too big for the address space. */
+    if ( (size.QuadPart <= 0) ||
+         (!__PHYSFS_ui64FitsAddressSpace((PHYSFS_uint64) size.QuadPart)) )
+    {
+        CloseHandle(fileh);
+        BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+    } /* if */
+
+    maph = CreateFileMappingW(fileh, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (maph == NULL)
+    {
+        const PHYSFS_ErrorCode err = errcodeFromWinApi();
+        CloseHandle(fileh);
+        BAIL_MACRO(err, NULL);
+    } /* if */
+
+    view = MapViewOfFile(maph, FILE_MAP_READ, 0, 0, 0);
+
+    /* the view keeps the mapping alive, so close this now. */
+    CloseHandle(maph);
+    if (view == NULL)
+    {
+        const PHYSFS_ErrorCode err = errcodeFromWinApi();
+        CloseHandle(fileh);
+        BAIL_MACRO(err, NULL);
+    } /* if */
+
+    retval = (WinApiMapping *) allocator.Malloc(sizeof (WinApiMapping));
+    if (!retval)
+    {
+        UnmapViewOfFile(view);
+        CloseHandle(fileh);
+        BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    retval->view = view;
+    retval->file = fileh;
+    *ptr = view;
+    *len = (PHYSFS_uint64) size.QuadPart;
+    return retval;
+} /* __PHYSFS_platformMapFile */
+
+
+void __PHYSFS_platformUnmapFile(void *mapping)
+{
+    WinApiMapping *m = (WinApiMapping *) mapping;
+    (void) UnmapViewOfFile(m->view);
+    (void) CloseHandle(m->file);
+    allocator.Free(m);
+} /* __PHYSFS_platformUnmapFile */
+
+
+int __PHYSFS_platformMappingBacking(void *mapping,
+                                    PHYSFS_FileBacking *backing)
+{
+    backing->fd = -1;
+    backing->handle = (void *) ((WinApiMapping *) mapping)->file;
+    return 1;
+} /* __PHYSFS_platformMappingBacking */
+
+
+int __PHYSFS_platformAdviseMapping(void *mapping, const void *ptr,
+                                   PHYSFS_uint64 len, int hint)
+{
+    PHYSFS_WinMemoryRange range;
+    BAIL_IF_MACRO(hint != PHYSFS_ACCESS_WILLNEED, PHYSFS_ERR_UNSUPPORTED, 0);
+    BAIL_IF_MACRO(!pPrefetchVirtualMemory, PHYSFS_ERR_UNSUPPORTED, 0);
+    range.VirtualAddress = (void *) ptr;
+    range.NumberOfBytes = (SIZE_T) len;
+    BAIL_IF_MACRO(!pPrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0),
+                  errcodeFromWinApi(), 0);
+    return 1;
+} /* __PHYSFS_platformAdviseMapping */
+
+
+/*
+ * Large pages need SeLockMemoryPrivilege, which processes rarely hold, so
+ *  this fails more often than not; the caller copes with that.
+ */
+void *__PHYSFS_platformAllocHuge(size_t len)
+{
+    if ((largePageSize == 0) || (len > ((size_t) -1) - largePageSize))
+        return NULL;
+    len = ((len + largePageSize - 1) / largePageSize) * largePageSize;
+    return VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                        PAGE_READWRITE);
+} /* __PHYSFS_platformAllocHuge */
+
+
+void __PHYSFS_platformFreeHuge(void *ptr, size_t len)
+{
+    (void) VirtualFree(ptr, 0, MEM_RELEASE);
+} /* __PHYSFS_platformFreeHuge */
+
+
+/*
+ * VirtualLock() is limited by the working set's minimum size, which is
+ *  small unless the app raises it with SetProcessWorkingSetSize().
+ */
+void *__PHYSFS_platformAllocLocked(size_t len)
+{
+    void *retval = VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT,
+                                PAGE_READWRITE);
+    if ((retval != NULL) && (!VirtualLock(retval, len)))
+    {
+        (void) VirtualFree(retval, 0, MEM_RELEASE);
+        retval = NULL;
+    } /* if */
+    return retval;
+} /* __PHYSFS_platformAllocLocked */
+
+
+void __PHYSFS_platformFreeLocked(void *ptr, size_t len)
+{
+    (void) VirtualUnlock(ptr, len);
+    (void) VirtualFree(ptr, 0, MEM_RELEASE);
+} /* __PHYSFS_platformFreeLocked */
+
+
 static int doPlatformDelete(LPWSTR wpath)
 {
     const int isdir = (GetFileAttributesW(wpath) & FILE_ATTRIBUTE_DIRECTORY);
@@ -802,6 +1670,74 @@ int __PHYSFS_platformDelete(const char *path)
 } /* __PHYSFS_platformDelete */
 
 
+int __PHYSFS_platformRename(const char *src, const char *dst)
+{
+    const DWORD flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+    WCHAR *wsrc = NULL;
+    WCHAR *wdst = NULL;
+    BOOL rc = FALSE;
+
+    UTF8_TO_UNICODE_STACK_MACRO(wsrc, src);
+    UTF8_TO_UNICODE_STACK_MACRO(wdst, dst);
+    if ((wsrc != NULL) && (wdst != NULL))
+        rc = MoveFileExW(wsrc, wdst, flags);
+    __PHYSFS_smallFree(wdst);
+    __PHYSFS_smallFree(wsrc);
+    BAIL_IF_MACRO(!wsrc || !wdst, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    BAIL_IF_MACRO(!rc, errcodeFromWinApi(), 0);
+    return 1;
+} /* __PHYSFS_platformRename */
+
+
+int __PHYSFS_platformSyncPath(const char *path)
+{
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE;
+    WCHAR *wpath;
+    HANDLE fileh;
+    DWORD attr;
+    BOOL rc;
+
+    UTF8_TO_UNICODE_STACK_MACRO(wpath, path);
+    BAIL_IF_MACRO(!wpath, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+    /* NTFS journals directory changes itself; there's nothing to flush. */
+    attr = GetFileAttributesW(wpath);
+    if ((attr != INVALID_FILE_ATTRIBUTES) && (attr & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        __PHYSFS_smallFree(wpath);
+        return 1;
+    } /* if */
+
+    fileh = CreateFileW(wpath, GENERIC_WRITE, share, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, NULL);
+    __PHYSFS_smallFree(wpath);
+    BAIL_IF_MACRO(fileh == INVALID_HANDLE_VALUE, errcodeFromWinApi(), 0);
+    rc = FlushFileBuffers(fileh);
+    if (!rc)
+    {
+        const PHYSFS_ErrorCode err = errcodeFromWinApi();
+        CloseHandle(fileh);
+        BAIL_MACRO(err, 0);
+    } /* if */
+
+    CloseHandle(fileh);
+    return 1;
+} /* __PHYSFS_platformSyncPath */
+
+
+int __PHYSFS_platformSyncData(const char *path)
+{
+    return __PHYSFS_platformSyncPath(path);  /* FlushFileBuffers() is it. */
+} /* __PHYSFS_platformSyncData */
+
+
+int __PHYSFS_platformSyncFilesystem(const char *path)
+{
+    /* flushing a whole volume needs administrator rights. */
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformSyncFilesystem */
+
+
 void *__PHYSFS_platformCreateMutex(void)
 {
     LPCRITICAL_SECTION lpcs;
@@ -826,12 +1762,105 @@ int __PHYSFS_platformGrabMutex(void *mutex)
 } /* __PHYSFS_platformGrabMutex */
 
 
+int __PHYSFS_platformTryGrabMutex(void *mutex)
+{
+    return TryEnterCriticalSection((LPCRITICAL_SECTION) mutex) ? 1 : 0;
+} /* __PHYSFS_platformTryGrabMutex */
+
+
 void __PHYSFS_platformReleaseMutex(void *mutex)
 {
     LeaveCriticalSection((LPCRITICAL_SECTION) mutex);
 } /* __PHYSFS_platformReleaseMutex */
 
 
+typedef struct
+{
+    void *srw;  /* an SRWLOCK, if we have them... */
+    CRITICAL_SECTION cs;  /* ...otherwise, this. */
+} WinRWLock;
+
+void *__PHYSFS_platformCreateRWLock(void)
+{
+    WinRWLock *rw = (WinRWLock *) allocator.Malloc(sizeof (WinRWLock));
+    BAIL_IF_MACRO(!rw, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+    rw->srw = NULL;
+    if (!pAcquireSRWLockShared)
+        InitializeCriticalSection(&rw->cs);
+    return rw;
+} /* __PHYSFS_platformCreateRWLock */
+
+
+void __PHYSFS_platformDestroyRWLock(void *rwlock)
+{
+    WinRWLock *rw = (WinRWLock *) rwlock;
+    if (!pAcquireSRWLockShared)
+        DeleteCriticalSection(&rw->cs);
+    allocator.Free(rw);
+} /* __PHYSFS_platformDestroyRWLock */
+
+
+int __PHYSFS_platformGrabRWLockShared(void *rwlock)
+{
+    WinRWLock *rw = (WinRWLock *) rwlock;
+    if (pAcquireSRWLockShared)
+        pAcquireSRWLockShared(&rw->srw);
+    else
+        EnterCriticalSection(&rw->cs);
+    return 1;
+} /* __PHYSFS_platformGrabRWLockShared */
+
+
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock)
+{
+    WinRWLock *rw = (WinRWLock *) rwlock;
+    if (pReleaseSRWLockShared)
+        pReleaseSRWLockShared(&rw->srw);
+    else
+        LeaveCriticalSection(&rw->cs);
+} /* __PHYSFS_platformReleaseRWLockShared */
+
+
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock)
+{
+    WinRWLock *rw = (WinRWLock *) rwlock;
+    if (pAcquireSRWLockExclusive)
+        pAcquireSRWLockExclusive(&rw->srw);
+    else
+        EnterCriticalSection(&rw->cs);
+    return 1;
+} /* __PHYSFS_platformGrabRWLockExclusive */
+
+
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock)
+{
+    WinRWLock *rw = (WinRWLock *) rwlock;
+    if (pReleaseSRWLockExclusive)
+        pReleaseSRWLockExclusive(&rw->srw);
+    else
+        LeaveCriticalSection(&rw->cs);
+} /* __PHYSFS_platformReleaseRWLockExclusive */
+
+
+PHYSFS_uint64 __PHYSFS_platformGetTicks(void)
+{
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    PHYSFS_uint64 hz;
+    PHYSFS_uint64 ticks;
+
+    /* these can't fail on XP and later. */
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    hz = (PHYSFS_uint64) freq.QuadPart;
+    ticks = (PHYSFS_uint64) now.QuadPart;
+
+    /* split it up so (ticks * 1000000000) doesn't overflow. */
+    return ((ticks / hz) * __PHYSFS_UI64(1000000000)) +
+           (((ticks % hz) * __PHYSFS_UI64(1000000000)) / hz);
+} /* __PHYSFS_platformGetTicks */
+
+
 static PHYSFS_sint64 FileTimeToPhysfsTime(const FILETIME *ft)
 {
     SYSTEMTIME st_utc;
@@ -866,31 +1895,20 @@ static PHYSFS_sint64 FileTimeToPhysfsTime(const FILETIME *ft)
 } /* FileTimeToPhysfsTime */
 
 
-int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+static void statFromAttributes(const WIN32_FILE_ATTRIBUTE_DATA *winstat,
+                               PHYSFS_Stat *st)
 {
-    WIN32_FILE_ATTRIBUTE_DATA winstat;
-    WCHAR *wstr = NULL;
-    DWORD err = 0;
-    BOOL rc = 0;
+    st->modtime = FileTimeToPhysfsTime(&winstat->ftLastWriteTime);
+    st->accesstime = FileTimeToPhysfsTime(&winstat->ftLastAccessTime);
+    st->createtime = FileTimeToPhysfsTime(&winstat->ftCreationTime);
 
-    UTF8_TO_UNICODE_STACK_MACRO(wstr, filename);
-    BAIL_IF_MACRO(!wstr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-    rc = GetFileAttributesExW(wstr, GetFileExInfoStandard, &winstat);
-    err = (!rc) ? GetLastError() : 0;
-    __PHYSFS_smallFree(wstr);
-    BAIL_IF_MACRO(!rc, errcodeFromWinApiError(err), 0);
-
-    st->modtime = FileTimeToPhysfsTime(&winstat.ftLastWriteTime);
-    st->accesstime = FileTimeToPhysfsTime(&winstat.ftLastAccessTime);
-    st->createtime = FileTimeToPhysfsTime(&winstat.ftCreationTime);
-
-    if(winstat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+    if(winstat->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
     {
         st->filetype = PHYSFS_FILETYPE_DIRECTORY;
         st->filesize = 0;
     } /* if */
 
-    else if(winstat.dwFileAttributes & (FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_DEVICE))
+    else if(winstat->dwFileAttributes & (FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_DEVICE))
     {
         /* !!! FIXME: what are reparse points? */
         st->filetype = PHYSFS_FILETYPE_OTHER;
@@ -903,15 +1921,112 @@ int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
     else
     {
         st->filetype = PHYSFS_FILETYPE_REGULAR;
-        st->filesize = (((PHYSFS_uint64) winstat.nFileSizeHigh) << 32) | winstat.nFileSizeLow;
+        st->filesize = (((PHYSFS_uint64) winstat->nFileSizeHigh) << 32) | winstat->nFileSizeLow;
     } /* else */
 
-    st->readonly = ((winstat.dwFileAttributes & FILE_ATTRIBUTE_READONLY) != 0);
+    st->readonly = ((winstat->dwFileAttributes & FILE_ATTRIBUTE_READONLY) != 0);
+} /* statFromAttributes */
+
+
+int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+{
+    WIN32_FILE_ATTRIBUTE_DATA winstat;
+    WCHAR scratch[UNICODE_SCRATCH_LEN];
+    WCHAR *wstr = NULL;
+    DWORD err = 0;
+    BOOL rc = 0;
+
+    UTF8_TO_UNICODE_SCRATCH_MACRO(wstr, filename, scratch);
+    BAIL_IF_MACRO(!wstr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+    rc = GetFileAttributesExW(wstr, GetFileExInfoStandard, &winstat);
+    err = (!rc) ? GetLastError() : 0;
+    UNICODE_SCRATCH_FREE(wstr, scratch);
+    BAIL_IF_MACRO(!rc, errcodeFromWinApiError(err), 0);
 
+    statFromAttributes(&winstat, st);
     return 1;
 } /* __PHYSFS_platformStat */
 
 
+/* Full paths it is; we don't hold directories open on Windows. */
+void *__PHYSFS_platformOpenDir(const char *dirname)
+{
+    return NULL;
+} /* __PHYSFS_platformOpenDir */
+
+
+void __PHYSFS_platformCloseDir(void *dir)
+{
+} /* __PHYSFS_platformCloseDir */
+
+
+int __PHYSFS_platformStatAt(void *dir, const char *relpath, PHYSFS_Stat *st)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformStatAt */
+
+
+void *__PHYSFS_platformOpenReadAt(void *dir, const char *relpath)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformOpenReadAt */
+
+
+void __PHYSFS_platformEnumerateFilesStat(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata)
+{
+    WIN32_FIND_DATAW entw;
+    HANDLE dir = findFirstInDir(dirname, &entw);
+
+    if (dir == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        const WCHAR *fn = entw.cFileName;
+        WIN32_FILE_ATTRIBUTE_DATA winstat;
+        PHYSFS_Stat st;
+        char *utf8;
+
+        if ((fn[0] == '.') && (fn[1] == '\0'))
+            continue;
+        if ((fn[0] == '.') && (fn[1] == '.') && (fn[2] == '\0'))
+            continue;
+
+        /* the listing already has everything GetFileAttributesEx() would. */
+        winstat.dwFileAttributes = entw.dwFileAttributes;
+        winstat.ftCreationTime = entw.ftCreationTime;
+        winstat.ftLastAccessTime = entw.ftLastAccessTime;
+        winstat.ftLastWriteTime = entw.ftLastWriteTime;
+        winstat.nFileSizeHigh = entw.nFileSizeHigh;
+        winstat.nFileSizeLow = entw.nFileSizeLow;
+        statFromAttributes(&winstat, &st);
+
+        utf8 = unicodeToUtf8Heap(fn);
+        if (utf8 != NULL)
+        {
+            callback(callbackdata, origdir, utf8, &st);
+            allocator.Free(utf8);
+        } /* if */
+    } while (FindNextFileW(dir, &entw) != 0);
+
+    FindClose(dir);
+} /* __PHYSFS_platformEnumerateFilesStat */
+
+
+/* FindFirstFileW() hands over the full metadata anyhow. */
+void __PHYSFS_platformEnumerateFilesType(const char *dirname,
+                                         PHYSFS_EnumFilesStatCallback callback,
+                                         const char *origdir,
+                                         void *callbackdata)
+{
+    __PHYSFS_platformEnumerateFilesStat(dirname, callback, origdir,
+                                        callbackdata);
+} /* __PHYSFS_platformEnumerateFilesType */
+
+
 /* !!! FIXME: Don't use C runtime for allocators? */
 int __PHYSFS_platformSetDefaultAllocator(PHYSFS_Allocator *a)
 {
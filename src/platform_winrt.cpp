@@ -92,6 +92,8 @@ static PHYSFS_uint64 wStrLen(const WCHAR *wstr)
 typedef struct
 {
 	HANDLE handle;
+	HANDLE async;  /* FILE_FLAG_OVERLAPPED twin, for batched reads, or NULL. */
+	void *readAtLock;  /* held while ReadAt() borrows the file pointer. */
 	int readonly;
 } WinApiFile;
 
@@ -237,6 +239,82 @@ void *__PHYSFS_platformGetThreadID(void)
 } /* __PHYSFS_platformGetThreadID */
 
 
+/* TlsAlloc() isn't available to every WinRT target; use the slow path. */
+void *__PHYSFS_platformCreateThreadLocal(void)
+{
+	return NULL;
+} /* __PHYSFS_platformCreateThreadLocal */
+
+
+void __PHYSFS_platformDestroyThreadLocal(void *tls)
+{
+} /* __PHYSFS_platformDestroyThreadLocal */
+
+
+void *__PHYSFS_platformGetThreadLocal(void *tls)
+{
+	return NULL;
+} /* __PHYSFS_platformGetThreadLocal */
+
+
+int __PHYSFS_platformSetThreadLocal(void *tls, void *value)
+{
+	return 0;
+} /* __PHYSFS_platformSetThreadLocal */
+
+
+/* No CreateThread() here; work that would go to a thread runs inline. */
+void *__PHYSFS_platformCreateThread(void (*fn)(void *), void *data)
+{
+	return NULL;
+} /* __PHYSFS_platformCreateThread */
+
+
+void __PHYSFS_platformWaitThread(void *thread)
+{
+} /* __PHYSFS_platformWaitThread */
+
+
+void *__PHYSFS_platformCreateSemaphore(void)
+{
+	return NULL;
+} /* __PHYSFS_platformCreateSemaphore */
+
+
+void __PHYSFS_platformDestroySemaphore(void *sem)
+{
+} /* __PHYSFS_platformDestroySemaphore */
+
+
+void __PHYSFS_platformPostSemaphore(void *sem)
+{
+} /* __PHYSFS_platformPostSemaphore */
+
+
+void __PHYSFS_platformWaitSemaphore(void *sem)
+{
+} /* __PHYSFS_platformWaitSemaphore */
+
+
+int __PHYSFS_platformWaitSemaphoreTimeout(void *sem, PHYSFS_uint32 ms)
+{
+	return 0;
+} /* __PHYSFS_platformWaitSemaphoreTimeout */
+
+
+void *__PHYSFS_platformWatchDir(const char *dirname,
+                                __PHYSFS_WatchCallback cb, void *data)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformWatchDir */
+
+
+void __PHYSFS_platformUnwatchDir(void *watch)
+{
+	/* no-op; nothing is ever watched. */
+} /* __PHYSFS_platformUnwatchDir */
+
+
 static int isSymlinkAttrs(const DWORD attr, const DWORD tag)
 {
 	return ((attr & FILE_ATTRIBUTE_REPARSE_POINT) &&
@@ -244,14 +322,10 @@ static int isSymlinkAttrs(const DWORD attr, const DWORD tag)
 } /* isSymlinkAttrs */
 
 
-void __PHYSFS_platformEnumerateFiles(const char *dirname,
-	PHYSFS_EnumFilesCallback callback,
-	const char *origdir,
-	void *callbackdata)
+/* Start listing (dirname); INVALID_HANDLE_VALUE if we can't. */
+static HANDLE findFirstInDir(const char *dirname, WIN32_FIND_DATAW *entw)
 {
-
 	HANDLE dir = INVALID_HANDLE_VALUE;
-	WIN32_FIND_DATAW entw;
 	size_t len = strlen(dirname);
 	char *searchPath = NULL;
 	WCHAR *wSearchPath = NULL;
@@ -259,7 +333,7 @@ void __PHYSFS_platformEnumerateFiles(const char *dirname,
 	/* Allocate a new string for path, maybe '\\', "*", and NULL terminator */
 	searchPath = (char *)__PHYSFS_smallAlloc(len + 3);
 	if (searchPath == NULL)
-		return;
+		return INVALID_HANDLE_VALUE;
 
 	/* Copy current dirname */
 	strcpy(searchPath, dirname);
@@ -275,14 +349,28 @@ void __PHYSFS_platformEnumerateFiles(const char *dirname,
 	strcat(searchPath, "*");
 
 	UTF8_TO_UNICODE_STACK_MACRO(wSearchPath, searchPath);
-	if (!wSearchPath)
-		return;  /* oh well. */
-
-	//dir = FindFirstFileW(wSearchPath, &entw);
-	dir = FindFirstFileExW(wSearchPath, FindExInfoStandard, &entw, FindExSearchNameMatch, NULL, 0);
+	if (wSearchPath != NULL)
+	{
+		/* no 8.3 names, and entries in big gulps; first access is slow. */
+		dir = FindFirstFileExW(wSearchPath, FindExInfoBasic, entw,
+		                       FindExSearchNameMatch, NULL,
+		                       FIND_FIRST_EX_LARGE_FETCH);
+		__PHYSFS_smallFree(wSearchPath);
+	} /* if */
 
-	__PHYSFS_smallFree(wSearchPath);
 	__PHYSFS_smallFree(searchPath);
+	return dir;
+} /* findFirstInDir */
+
+
+void __PHYSFS_platformEnumerateFiles(const char *dirname,
+	PHYSFS_EnumFilesCallback callback,
+	const char *origdir,
+	void *callbackdata)
+{
+	WIN32_FIND_DATAW entw;
+	HANDLE dir = findFirstInDir(dirname, &entw);
+
 	if (dir == INVALID_HANDLE_VALUE)
 		return;
 
@@ -334,6 +422,39 @@ int __PHYSFS_platformDeinit(void)
 } /* __PHYSFS_platformDeinit */
 
 
+/*
+ * Batched reads go through an I/O completion port, each file through an
+ *  overlapped twin of its handle, so a whole queue of reads is in flight
+ *  at once instead of one blocking CreateFile2() handle at a time. Batches
+ *  take turns on the port, so every completion we see belongs to the batch
+ *  that's holding the lock. There's no ReOpenFile() here, so the twin is
+ *  opened by name, alongside the usual handle.
+ */
+static HANDLE ioPort = NULL;
+static void *ioPortLock = NULL;
+
+static HANDLE openAsyncTwin(const WCHAR *wfname)
+{
+	CREATEFILE2_EXTENDED_PARAMETERS params;
+	HANDLE h;
+
+	memset(&params, '\0', sizeof (params));
+	params.dwSize = sizeof (params);
+	params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	params.dwFileFlags = FILE_FLAG_OVERLAPPED;
+	h = CreateFile2(wfname, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+	                OPEN_EXISTING, &params);
+	if (h == INVALID_HANDLE_VALUE)
+		return NULL;
+	else if (CreateIoCompletionPort(h, ioPort, 0, 0) == NULL)
+	{
+		CloseHandle(h);
+		return NULL;
+	} /* else if */
+	return h;
+} /* openAsyncTwin */
+
+
 static void *doOpen(const char *fname, DWORD mode, DWORD creation, int rdonly)
 {
 	HANDLE fileh;
@@ -344,19 +465,36 @@ static void *doOpen(const char *fname, DWORD mode, DWORD creation, int rdonly)
 	BAIL_IF_MACRO(!wfname, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
 	//fileh = CreateFileW(wfname, mode, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, creation, FILE_ATTRIBUTE_NORMAL, NULL);
 	fileh = CreateFile2(wfname, mode, FILE_SHARE_READ | FILE_SHARE_WRITE, creation, NULL);
-	__PHYSFS_smallFree(wfname);
-
-	BAIL_IF_MACRO(fileh == INVALID_HANDLE_VALUE, errcodeFromWinApi(), NULL);
+	if (fileh == INVALID_HANDLE_VALUE)
+	{
+		const PHYSFS_ErrorCode err = errcodeFromWinApi();
+		__PHYSFS_smallFree(wfname);
+		BAIL_MACRO(err, NULL);
+	} /* if */
 
 	retval = (WinApiFile *)allocator.Malloc(sizeof(WinApiFile));
 	if (!retval)
 	{
+		__PHYSFS_smallFree(wfname);
+		CloseHandle(fileh);
+		BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+	} /* if */
+
+	retval->readAtLock = __PHYSFS_platformCreateMutex();
+	if (!retval->readAtLock)
+	{
+		__PHYSFS_smallFree(wfname);
 		CloseHandle(fileh);
+		allocator.Free(retval);
 		BAIL_MACRO(PHYSFS_ERR_OUT_OF_MEMORY, NULL);
 	} /* if */
 
 	retval->readonly = rdonly;
 	retval->handle = fileh;
+	retval->async = NULL;
+	if ((rdonly) && (ioPort != NULL))  /* NULL just means no batching. */
+		retval->async = openAsyncTwin(wfname);
+	__PHYSFS_smallFree(wfname);
 	return retval;
 } /* doOpen */
 
@@ -386,6 +524,7 @@ void *__PHYSFS_platformOpenAppend(const char *filename)
 		{
 			const PHYSFS_ErrorCode err = errcodeFromWinApi();
 			CloseHandle(h);
+			__PHYSFS_platformDestroyMutex(((WinApiFile *)retval)->readAtLock);
 			allocator.Free(retval);
 			BAIL_MACRO(err, NULL);
 		} /* if */
@@ -419,6 +558,226 @@ PHYSFS_sint64 __PHYSFS_platformRead(void *opaque, void *buf, PHYSFS_uint64 len)
 } /* __PHYSFS_platformRead */
 
 
+PHYSFS_sint64 __PHYSFS_platformReadAt(void *opaque, void *buf,
+	PHYSFS_uint64 len, PHYSFS_uint64 pos)
+{
+	WinApiFile *fh = (WinApiFile *) opaque;
+	HANDLE Handle = fh->handle;
+	PHYSFS_uint8 *ptr = (PHYSFS_uint8 *) buf;
+	PHYSFS_sint64 totalRead = 0;
+	LARGE_INTEGER zero;
+	LARGE_INTEGER origpos;
+
+	if (!__PHYSFS_ui64FitsAddressSpace(len))
+		BAIL_MACRO(PHYSFS_ERR_INVALID_ARGUMENT, -1);
+
+	/*
+	 * ReadFile() with an OVERLAPPED on a synchronous handle reads at the
+	 *  given offset, but still moves the file pointer afterwards, so put it
+	 *  back. The pointer is shared by every thread reading this handle, so
+	 *  each save/read/restore holds the handle's lock; otherwise one thread
+	 *  could save another's half-finished read position and restore it last.
+	 */
+	zero.QuadPart = 0;
+	__PHYSFS_platformGrabMutex(fh->readAtLock);
+	if (!SetFilePointerEx(Handle, zero, &origpos, FILE_CURRENT))
+	{
+		__PHYSFS_platformReleaseMutex(fh->readAtLock);
+		BAIL_MACRO(errcodeFromWinApi(), -1);
+	} /* if */
+
+	while (len > 0)
+	{
+		const DWORD thislen = (len > 0xFFFFFFFF) ? 0xFFFFFFFF : (DWORD) len;
+		DWORD numRead = 0;
+		OVERLAPPED ov;
+		memset(&ov, '\0', sizeof (ov));
+		ov.Offset = LOWORDER_UINT64(pos);
+		ov.OffsetHigh = HIGHORDER_UINT64(pos);
+		if (!ReadFile(Handle, ptr, thislen, &numRead, &ov))
+		{
+			const DWORD err = GetLastError();
+			if (err == ERROR_HANDLE_EOF)
+				break;  /* reading past EOF isn't an error, just short. */
+			SetFilePointerEx(Handle, origpos, NULL, FILE_BEGIN);
+			__PHYSFS_platformReleaseMutex(fh->readAtLock);
+			BAIL_MACRO(errcodeFromWinApiError(err), -1);
+		} /* if */
+		len -= (PHYSFS_uint64) numRead;
+		pos += (PHYSFS_uint64) numRead;
+		ptr += numRead;
+		totalRead += (PHYSFS_sint64) numRead;
+		if (numRead != thislen)
+			break;
+	} /* while */
+
+	SetFilePointerEx(Handle, origpos, NULL, FILE_BEGIN);
+	__PHYSFS_platformReleaseMutex(fh->readAtLock);
+	return totalRead;
+} /* __PHYSFS_platformReadAt */
+
+
+PHYSFS_sint64 __PHYSFS_platformReadv(void *opaque, const PHYSFS_IoVec *iov,
+                                     PHYSFS_uint32 count)
+{
+	PHYSFS_sint64 retval = 0;
+	PHYSFS_uint32 i;
+
+	/* no scatter reads for buffered handles here; just loop. */
+	for (i = 0; i < count; i++)
+	{
+		const PHYSFS_sint64 rc = __PHYSFS_platformRead(opaque, iov[i].buf,
+		                                               iov[i].len);
+		if (rc < 0)
+			return (retval == 0) ? -1 : retval;
+		retval += rc;
+		if (((PHYSFS_uint64) rc) < iov[i].len)
+			break;  /* EOF. */
+	} /* for */
+
+	return retval;
+} /* __PHYSFS_platformReadv */
+
+
+static void readBatchOneByOne(__PHYSFS_PlatformReadRequest *reqs,
+                              PHYSFS_uint32 count)
+{
+	PHYSFS_uint32 i;
+	for (i = 0; i < count; i++)
+	{
+		__PHYSFS_PlatformReadRequest *req = &reqs[i];
+		req->result = __PHYSFS_platformReadAt(req->opaque, req->buffer,
+		                                      req->len, req->pos);
+		req->error = PHYSFS_ERR_OK;
+		if (req->result < 0)
+			req->error = PHYSFS_getLastErrorCode();
+	} /* for */
+} /* readBatchOneByOne */
+
+
+void __PHYSFS_platformReadBatch(__PHYSFS_PlatformReadRequest *reqs,
+                                PHYSFS_uint32 count)
+{
+	OVERLAPPED *ovs;
+	PHYSFS_uint32 pending = 0;
+	PHYSFS_uint32 i;
+
+	if (ioPort == NULL)
+	{
+		readBatchOneByOne(reqs, count);
+		return;
+	} /* if */
+
+	ovs = (OVERLAPPED *) allocator.Malloc(sizeof (OVERLAPPED) * count);
+	if (ovs == NULL)
+	{
+		readBatchOneByOne(reqs, count);
+		return;
+	} /* if */
+	memset(ovs, '\0', sizeof (OVERLAPPED) * count);
+
+	__PHYSFS_platformGrabMutex(ioPortLock);
+	for (i = 0; i < count; i++)
+	{
+		__PHYSFS_PlatformReadRequest *req = &reqs[i];
+		HANDLE h = ((WinApiFile *) req->opaque)->async;
+		DWORD err;
+
+		if (h == NULL)
+		{
+			readBatchOneByOne(req, 1);
+			continue;
+		} /* if */
+
+		/* the caller keeps (len) under 2 gigabytes. */
+		ovs[i].Offset = LOWORDER_UINT64(req->pos);
+		ovs[i].OffsetHigh = HIGHORDER_UINT64(req->pos);
+		if (ReadFile(h, req->buffer, (DWORD) req->len, NULL, &ovs[i]))
+		{
+			pending++;  /* done already, but the port hears about it. */
+			continue;
+		} /* if */
+
+		err = GetLastError();
+		if (err == ERROR_IO_PENDING)
+			pending++;
+		else if (err == ERROR_HANDLE_EOF)
+		{
+			req->result = 0;  /* past the end is short, not an error. */
+			req->error = PHYSFS_ERR_OK;
+		} /* else if */
+		else
+		{
+			req->result = -1;
+			req->error = errcodeFromWinApiError(err);
+		} /* else */
+	} /* for */
+
+	while (pending > 0)
+	{
+		__PHYSFS_PlatformReadRequest *req;
+		OVERLAPPED *ov = NULL;
+		ULONG_PTR key = 0;
+		DWORD numRead = 0;
+		BOOL rc;
+
+		rc = GetQueuedCompletionStatus(ioPort, &numRead, &key, &ov, INFINITE);
+		if (ov == NULL)
+			break;  /* the port itself failed; nothing left to wait on. */
+
+		req = &reqs[ov - ovs];
+		req->result = (PHYSFS_sint64) numRead;
+		req->error = PHYSFS_ERR_OK;
+		if (!rc)
+		{
+			const DWORD err = GetLastError();
+			if (err != ERROR_HANDLE_EOF)
+			{
+				req->result = -1;
+				req->error = errcodeFromWinApiError(err);
+			} /* if */
+		} /* if */
+		pending--;
+	} /* while */
+	__PHYSFS_platformReleaseMutex(ioPortLock);
+
+	allocator.Free(ovs);
+} /* __PHYSFS_platformReadBatch */
+
+
+int __PHYSFS_platformInitBatchIo(int wanted)
+{
+	if (!wanted)
+		return 0;
+
+	ioPortLock = __PHYSFS_platformCreateMutex();
+	if (ioPortLock == NULL)
+		return 0;
+
+	ioPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (ioPort == NULL)
+	{
+		__PHYSFS_platformDestroyMutex(ioPortLock);
+		ioPortLock = NULL;
+		return 0;
+	} /* if */
+
+	return 1;
+} /* __PHYSFS_platformInitBatchIo */
+
+
+void __PHYSFS_platformDeinitBatchIo(void)
+{
+	if (ioPort != NULL)
+	{
+		CloseHandle(ioPort);
+		__PHYSFS_platformDestroyMutex(ioPortLock);
+		ioPort = NULL;
+		ioPortLock = NULL;
+	} /* if */
+} /* __PHYSFS_platformDeinitBatchIo */
+
+
 PHYSFS_sint64 __PHYSFS_platformWrite(void *opaque, const void *buffer,
 	PHYSFS_uint64 len)
 {
@@ -519,14 +878,95 @@ int __PHYSFS_platformFlush(void *opaque)
 } /* __PHYSFS_platformFlush */
 
 
+/*
+ * FILE_FLAG_SEQUENTIAL_SCAN and FILE_FLAG_RANDOM_ACCESS only count when the
+ *  file is opened, and PrefetchVirtualMemory() only helps mapped views, so
+ *  there's nothing to tell Windows about a file that's already open.
+ */
+int __PHYSFS_platformAdvise(void *opaque, PHYSFS_uint64 pos,
+	PHYSFS_uint64 len, int hint)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformAdvise */
+
+
+int __PHYSFS_platformSetDirectIo(void *opaque, int enable)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformSetDirectIo */
+
+
+int __PHYSFS_platformFileBacking(void *opaque, PHYSFS_FileBacking *backing)
+{
+	backing->fd = -1;
+	backing->handle = (void *)((WinApiFile *)opaque)->handle;
+	return 1;
+} /* __PHYSFS_platformFileBacking */
+
+
 void __PHYSFS_platformClose(void *opaque)
 {
-	HANDLE Handle = ((WinApiFile *)opaque)->handle;
-	(void)CloseHandle(Handle); /* ignore errors. You should have flushed! */
+	WinApiFile *fh = (WinApiFile *)opaque;
+	(void)CloseHandle(fh->handle); /* ignore errors. You should have flushed! */
+	if (fh->async != NULL)
+		CloseHandle(fh->async);
+	__PHYSFS_platformDestroyMutex(fh->readAtLock);
 	allocator.Free(opaque);
 } /* __PHYSFS_platformClose */
 
 
+/* !!! FIXME: CreateFileMappingFromApp() exists on newer WinRT targets. */
+void *__PHYSFS_platformMapFile(const char *filename, const void **ptr,
+                               PHYSFS_uint64 *len)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformMapFile */
+
+
+void __PHYSFS_platformUnmapFile(void *mapping)
+{
+    /* never mapped anything, so nothing to do. */
+} /* __PHYSFS_platformUnmapFile */
+
+
+int __PHYSFS_platformMappingBacking(void *mapping,
+                                    PHYSFS_FileBacking *backing)
+{
+    BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);  /* never mapped anything. */
+} /* __PHYSFS_platformMappingBacking */
+
+
+int __PHYSFS_platformAdviseMapping(void *mapping, const void *ptr,
+	PHYSFS_uint64 len, int hint)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformAdviseMapping */
+
+
+void *__PHYSFS_platformAllocHuge(size_t len)
+{
+	return NULL;  /* no large pages for Store apps. */
+} /* __PHYSFS_platformAllocHuge */
+
+
+void __PHYSFS_platformFreeHuge(void *ptr, size_t len)
+{
+	/* never allocated anything, so nothing to do. */
+} /* __PHYSFS_platformFreeHuge */
+
+
+void *__PHYSFS_platformAllocLocked(size_t len)
+{
+	return NULL;  /* no VirtualLock() for Store apps. */
+} /* __PHYSFS_platformAllocLocked */
+
+
+void __PHYSFS_platformFreeLocked(void *ptr, size_t len)
+{
+	/* never allocated anything, so nothing to do. */
+} /* __PHYSFS_platformFreeLocked */
+
+
 static int doPlatformDelete(LPWSTR wpath)
 {
 	//const int isdir = (GetFileAttributesW(wpath) & FILE_ATTRIBUTE_DIRECTORY);
@@ -555,6 +995,72 @@ int __PHYSFS_platformDelete(const char *path)
 } /* __PHYSFS_platformDelete */
 
 
+int __PHYSFS_platformRename(const char *src, const char *dst)
+{
+	const DWORD flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+	WCHAR *wsrc = NULL;
+	WCHAR *wdst = NULL;
+	BOOL rc = FALSE;
+
+	UTF8_TO_UNICODE_STACK_MACRO(wsrc, src);
+	UTF8_TO_UNICODE_STACK_MACRO(wdst, dst);
+	if ((wsrc != NULL) && (wdst != NULL))
+		rc = MoveFileExW(wsrc, wdst, flags);
+	__PHYSFS_smallFree(wdst);
+	__PHYSFS_smallFree(wsrc);
+	BAIL_IF_MACRO(!wsrc || !wdst, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+	BAIL_IF_MACRO(!rc, errcodeFromWinApi(), 0);
+	return 1;
+} /* __PHYSFS_platformRename */
+
+
+int __PHYSFS_platformSyncPath(const char *path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA file_info;
+	WCHAR *wpath;
+	HANDLE fileh;
+	BOOL rc;
+
+	UTF8_TO_UNICODE_STACK_MACRO(wpath, path);
+	BAIL_IF_MACRO(!wpath, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+
+	/* NTFS journals directory changes itself; there's nothing to flush. */
+	rc = GetFileAttributesEx(wpath, GetFileExInfoStandard, &file_info);
+	if ((rc) && (file_info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		__PHYSFS_smallFree(wpath);
+		return 1;
+	} /* if */
+
+	fileh = CreateFile2(wpath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING, NULL);
+	__PHYSFS_smallFree(wpath);
+	BAIL_IF_MACRO(fileh == INVALID_HANDLE_VALUE, errcodeFromWinApi(), 0);
+	rc = FlushFileBuffers(fileh);
+	if (!rc)
+	{
+		const PHYSFS_ErrorCode err = errcodeFromWinApi();
+		CloseHandle(fileh);
+		BAIL_MACRO(err, 0);
+	} /* if */
+
+	CloseHandle(fileh);
+	return 1;
+} /* __PHYSFS_platformSyncPath */
+
+
+int __PHYSFS_platformSyncData(const char *path)
+{
+	return __PHYSFS_platformSyncPath(path);  /* FlushFileBuffers() is it. */
+} /* __PHYSFS_platformSyncData */
+
+
+int __PHYSFS_platformSyncFilesystem(const char *path)
+{
+	/* flushing a whole volume needs administrator rights. */
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformSyncFilesystem */
+
+
 void *__PHYSFS_platformCreateMutex(void)
 {
 	LPCRITICAL_SECTION lpcs;
@@ -580,12 +1086,79 @@ int __PHYSFS_platformGrabMutex(void *mutex)
 } /* __PHYSFS_platformGrabMutex */
 
 
+int __PHYSFS_platformTryGrabMutex(void *mutex)
+{
+	return TryEnterCriticalSection((LPCRITICAL_SECTION)mutex) ? 1 : 0;
+} /* __PHYSFS_platformTryGrabMutex */
+
+
 void __PHYSFS_platformReleaseMutex(void *mutex)
 {
 	LeaveCriticalSection((LPCRITICAL_SECTION)mutex);
 } /* __PHYSFS_platformReleaseMutex */
 
 
+void *__PHYSFS_platformCreateRWLock(void)
+{
+	PSRWLOCK srw;
+	srw = (PSRWLOCK)allocator.Malloc(sizeof(SRWLOCK));
+	BAIL_IF_MACRO(!srw, PHYSFS_ERR_OUT_OF_MEMORY, NULL);
+	InitializeSRWLock(srw);
+	return srw;
+} /* __PHYSFS_platformCreateRWLock */
+
+
+void __PHYSFS_platformDestroyRWLock(void *rwlock)
+{
+	allocator.Free(rwlock);  /* SRW locks have nothing to clean up. */
+} /* __PHYSFS_platformDestroyRWLock */
+
+
+int __PHYSFS_platformGrabRWLockShared(void *rwlock)
+{
+	AcquireSRWLockShared((PSRWLOCK)rwlock);
+	return 1;
+} /* __PHYSFS_platformGrabRWLockShared */
+
+
+void __PHYSFS_platformReleaseRWLockShared(void *rwlock)
+{
+	ReleaseSRWLockShared((PSRWLOCK)rwlock);
+} /* __PHYSFS_platformReleaseRWLockShared */
+
+
+int __PHYSFS_platformGrabRWLockExclusive(void *rwlock)
+{
+	AcquireSRWLockExclusive((PSRWLOCK)rwlock);
+	return 1;
+} /* __PHYSFS_platformGrabRWLockExclusive */
+
+
+void __PHYSFS_platformReleaseRWLockExclusive(void *rwlock)
+{
+	ReleaseSRWLockExclusive((PSRWLOCK)rwlock);
+} /* __PHYSFS_platformReleaseRWLockExclusive */
+
+
+PHYSFS_uint64 __PHYSFS_platformGetTicks(void)
+{
+	LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+	PHYSFS_uint64 hz;
+	PHYSFS_uint64 ticks;
+
+	/* these can't fail on XP and later. */
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	hz = (PHYSFS_uint64) freq.QuadPart;
+	ticks = (PHYSFS_uint64) now.QuadPart;
+
+	/* split it up so (ticks * 1000000000) doesn't overflow. */
+	return ((ticks / hz) * __PHYSFS_UI64(1000000000)) +
+	       (((ticks % hz) * __PHYSFS_UI64(1000000000)) / hz);
+} /* __PHYSFS_platformGetTicks */
+
+
 static PHYSFS_sint64 FileTimeToPhysfsTime(const FILETIME *ft)
 {
 	SYSTEMTIME st_utc;
@@ -620,31 +1193,20 @@ static PHYSFS_sint64 FileTimeToPhysfsTime(const FILETIME *ft)
 } /* FileTimeToPhysfsTime */
 
 
-int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+static void statFromAttributes(const WIN32_FILE_ATTRIBUTE_DATA *winstat,
+	PHYSFS_Stat *st)
 {
-	WIN32_FILE_ATTRIBUTE_DATA winstat;
-	WCHAR *wstr = NULL;
-	DWORD err = 0;
-	BOOL rc = 0;
-
-	UTF8_TO_UNICODE_STACK_MACRO(wstr, filename);
-	BAIL_IF_MACRO(!wstr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
-	rc = GetFileAttributesExW(wstr, GetFileExInfoStandard, &winstat);
-	err = (!rc) ? GetLastError() : 0;
-	__PHYSFS_smallFree(wstr);
-	BAIL_IF_MACRO(!rc, errcodeFromWinApiError(err), 0);
+	st->modtime = FileTimeToPhysfsTime(&winstat->ftLastWriteTime);
+	st->accesstime = FileTimeToPhysfsTime(&winstat->ftLastAccessTime);
+	st->createtime = FileTimeToPhysfsTime(&winstat->ftCreationTime);
 
-	st->modtime = FileTimeToPhysfsTime(&winstat.ftLastWriteTime);
-	st->accesstime = FileTimeToPhysfsTime(&winstat.ftLastAccessTime);
-	st->createtime = FileTimeToPhysfsTime(&winstat.ftCreationTime);
-
-	if (winstat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	if (winstat->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 	{
 		st->filetype = PHYSFS_FILETYPE_DIRECTORY;
 		st->filesize = 0;
 	} /* if */
 
-	else if (winstat.dwFileAttributes & (FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_DEVICE))
+	else if (winstat->dwFileAttributes & (FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_DEVICE))
 	{
 		/* !!! FIXME: what are reparse points? */
 		st->filetype = PHYSFS_FILETYPE_OTHER;
@@ -657,15 +1219,110 @@ int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
 	else
 	{
 		st->filetype = PHYSFS_FILETYPE_REGULAR;
-		st->filesize = (((PHYSFS_uint64)winstat.nFileSizeHigh) << 32) | winstat.nFileSizeLow;
+		st->filesize = (((PHYSFS_uint64)winstat->nFileSizeHigh) << 32) | winstat->nFileSizeLow;
 	} /* else */
 
-	st->readonly = ((winstat.dwFileAttributes & FILE_ATTRIBUTE_READONLY) != 0);
+	st->readonly = ((winstat->dwFileAttributes & FILE_ATTRIBUTE_READONLY) != 0);
+} /* statFromAttributes */
+
 
+int __PHYSFS_platformStat(const char *filename, PHYSFS_Stat *st)
+{
+	WIN32_FILE_ATTRIBUTE_DATA winstat;
+	WCHAR *wstr = NULL;
+	DWORD err = 0;
+	BOOL rc = 0;
+
+	UTF8_TO_UNICODE_STACK_MACRO(wstr, filename);
+	BAIL_IF_MACRO(!wstr, PHYSFS_ERR_OUT_OF_MEMORY, 0);
+	rc = GetFileAttributesExW(wstr, GetFileExInfoStandard, &winstat);
+	err = (!rc) ? GetLastError() : 0;
+	__PHYSFS_smallFree(wstr);
+	BAIL_IF_MACRO(!rc, errcodeFromWinApiError(err), 0);
+
+	statFromAttributes(&winstat, st);
 	return 1;
 } /* __PHYSFS_platformStat */
 
 
+/* Full paths it is; we don't hold directories open on Windows. */
+void *__PHYSFS_platformOpenDir(const char *dirname)
+{
+	return NULL;
+} /* __PHYSFS_platformOpenDir */
+
+
+void __PHYSFS_platformCloseDir(void *dir)
+{
+} /* __PHYSFS_platformCloseDir */
+
+
+int __PHYSFS_platformStatAt(void *dir, const char *relpath, PHYSFS_Stat *st)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, 0);
+} /* __PHYSFS_platformStatAt */
+
+
+void *__PHYSFS_platformOpenReadAt(void *dir, const char *relpath)
+{
+	BAIL_MACRO(PHYSFS_ERR_UNSUPPORTED, NULL);
+} /* __PHYSFS_platformOpenReadAt */
+
+
+void __PHYSFS_platformEnumerateFilesStat(const char *dirname,
+	PHYSFS_EnumFilesStatCallback callback,
+	const char *origdir,
+	void *callbackdata)
+{
+	WIN32_FIND_DATAW entw;
+	HANDLE dir = findFirstInDir(dirname, &entw);
+
+	if (dir == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		const WCHAR *fn = entw.cFileName;
+		WIN32_FILE_ATTRIBUTE_DATA winstat;
+		PHYSFS_Stat st;
+		char *utf8;
+
+		if ((fn[0] == '.') && (fn[1] == '\0'))
+			continue;
+		if ((fn[0] == '.') && (fn[1] == '.') && (fn[2] == '\0'))
+			continue;
+
+		/* the listing already has everything GetFileAttributesEx() would. */
+		winstat.dwFileAttributes = entw.dwFileAttributes;
+		winstat.ftCreationTime = entw.ftCreationTime;
+		winstat.ftLastAccessTime = entw.ftLastAccessTime;
+		winstat.ftLastWriteTime = entw.ftLastWriteTime;
+		winstat.nFileSizeHigh = entw.nFileSizeHigh;
+		winstat.nFileSizeLow = entw.nFileSizeLow;
+		statFromAttributes(&winstat, &st);
+
+		utf8 = unicodeToUtf8Heap(fn);
+		if (utf8 != NULL)
+		{
+			callback(callbackdata, origdir, utf8, &st);
+			allocator.Free(utf8);
+		} /* if */
+	} while (FindNextFileW(dir, &entw) != 0);
+
+	FindClose(dir);
+} /* __PHYSFS_platformEnumerateFilesStat */
+
+
+/* FindFirstFileW() hands over the full metadata anyhow. */
+void __PHYSFS_platformEnumerateFilesType(const char *dirname,
+	PHYSFS_EnumFilesStatCallback callback,
+	const char *origdir,
+	void *callbackdata)
+{
+	__PHYSFS_platformEnumerateFilesStat(dirname, callback, origdir, callbackdata);
+} /* __PHYSFS_platformEnumerateFilesType */
+
+
 /* !!! FIXME: Don't use C runtime for allocators? */
 int __PHYSFS_platformSetDefaultAllocator(PHYSFS_Allocator *a)
 {
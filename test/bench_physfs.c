@@ -0,0 +1,1665 @@
+/**
+ * Benchmark program for PhysicsFS.
+ *
+ * This writes the same set of files into every archive format we can build
+ *  without outside tools, then times the common operations against each
+ *  one and prints the results as CSV (or JSON, with --json), one row per
+ *  test, so runs can be compared by scripts.
+ *
+ * The archives are made from scratch here, as PhysicsFS can't write them:
+ *  ZIP entries are stored or deflated with a simple fixed-Huffman encoder,
+ *  and 7z entries use the Copy method (there's no LZMA encoder in the
+ *  tree), so the 7z numbers measure the archiver, not the LZMA decoder.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "physfs.h"
+
+#define BENCH_SCRATCH_DIR "physfs_bench.tmp"
+#define BENCH_DIRS 16
+#define BENCH_FILES_PER_DIR 64
+#define BENCH_SMALL_FILES (BENCH_DIRS * BENCH_FILES_PER_DIR)
+#define BENCH_FILES (BENCH_SMALL_FILES + 1)  /* the last one is big.dat. */
+#define BENCH_SMALL_MIN 512
+#define BENCH_SMALL_MAX 8192
+#define BENCH_MAX_THREADS 64
+
+typedef struct
+{
+    char name[16];
+    PHYSFS_uint8 *data;
+    PHYSFS_uint32 len;
+    PHYSFS_uint32 crc;
+} BenchFile;
+
+typedef struct
+{
+    const char *name;     /* what the results call it.         */
+    const char *filename; /* in the scratch dir.                */
+    int (*build)(const char *filename);
+} BenchArchive;
+
+typedef struct
+{
+    PHYSFS_uint8 *data;
+    size_t len;
+    size_t alloc;
+} Buf;
+
+static BenchFile files[BENCH_FILES];
+static PHYSFS_uint32 bigsize = 16 * 1024 * 1024;
+static int iterations = 10;
+static int maxthreads = 8;
+static int jsonoutput = 0;
+static int resultcount = 0;
+
+
+/* Timing... */
+
+static PHYSFS_uint64 now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (PHYSFS_uint64) ((((double) count.QuadPart) * 1000000000.0) /
+                            ((double) freq.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((PHYSFS_uint64) ts.tv_sec) * 1000000000) + ts.tv_nsec;
+#endif
+} /* now_ns */
+
+
+static void report(const char *archive, const char *test, int threads,
+                   PHYSFS_uint64 ops, PHYSFS_uint64 bytes, PHYSFS_uint64 ns)
+{
+    const double perop = ops ? ((double) ns) / ((double) ops) : 0.0;
+    const double mibs = (ns && bytes) ?
+            (((double) bytes) / (1024.0 * 1024.0)) / (((double) ns) / 1e9) : 0.0;
+
+    if (!jsonoutput)
+    {
+        if (resultcount == 0)
+            printf("archive,test,threads,ops,bytes,ns,ns_per_op,mib_per_s\n");
+        printf("%s,%s,%d,%llu,%llu,%llu,%.1f,%.2f\n", archive, test, threads,
+               (unsigned long long) ops, (unsigned long long) bytes,
+               (unsigned long long) ns, perop, mibs);
+    } /* if */
+    else
+    {
+        printf("%s  {\"archive\": \"%s\", \"test\": \"%s\", \"threads\": %d, "
+               "\"ops\": %llu, \"bytes\": %llu, \"ns\": %llu, "
+               "\"ns_per_op\": %.1f, \"mib_per_s\": %.2f}",
+               resultcount ? ",\n" : "[\n", archive, test, threads,
+               (unsigned long long) ops, (unsigned long long) bytes,
+               (unsigned long long) ns, perop, mibs);
+    } /* else */
+
+    resultcount++;
+    fflush(stdout);
+} /* report */
+
+
+/* Building the file set... */
+
+static void *xmalloc(size_t len)
+{
+    void *retval = malloc(len ? len : 1);
+    if (retval == NULL)
+    {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(42);
+    } /* if */
+    return retval;
+} /* xmalloc */
+
+
+static PHYSFS_uint32 crc32(const PHYSFS_uint8 *buf, size_t len)
+{
+    static PHYSFS_uint32 table[256];
+    PHYSFS_uint32 crc = 0xFFFFFFFF;
+    size_t i;
+
+    if (table[1] == 0)
+    {
+        PHYSFS_uint32 n, k;
+        for (n = 0; n < 256; n++)
+        {
+            PHYSFS_uint32 c = n;
+            for (k = 0; k < 8; k++)
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            table[n] = c;
+        } /* for */
+    } /* if */
+
+    for (i = 0; i < len; i++)
+        crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFF;
+} /* crc32 */
+
+
+static PHYSFS_uint32 lcg(PHYSFS_uint32 *state)
+{
+    *state = (*state * 1103515245) + 12345;
+    return (*state >> 8) & 0xFFFFFF;
+} /* lcg */
+
+
+/* Text-like data, so deflate has something to do. */
+static void fill_data(PHYSFS_uint8 *buf, PHYSFS_uint32 len, PHYSFS_uint32 seed)
+{
+    static const char *words[] = {
+        "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ",
+        "dog ", "archive ", "physics ", "file ", "system ", "mount ",
+        "read ", "seek ", "buffer ", "0x7f3a ", "1024 ", "\n", "{ ", "} "
+    };
+    const PHYSFS_uint32 wordcount = sizeof (words) / sizeof (words[0]);
+    PHYSFS_uint32 state = seed;
+    PHYSFS_uint32 i = 0;
+
+    while (i < len)
+    {
+        const char *word = words[lcg(&state) % wordcount];
+        while ((*word) && (i < len))
+            buf[i++] = (PHYSFS_uint8) *(word++);
+        if ((lcg(&state) % 7) == 0)  /* some noise, too. */
+            buf[i - 1] = (PHYSFS_uint8) lcg(&state);
+    } /* while */
+} /* fill_data */
+
+
+static void make_files(void)
+{
+    PHYSFS_uint32 state = 0x1234;
+    int i;
+
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        BenchFile *file = &files[i];
+        if (i == BENCH_SMALL_FILES)
+        {
+            strcpy(file->name, "big.dat");
+            file->len = bigsize;
+        } /* if */
+        else
+        {
+            /* d00/f000 fits in a WAD's eight character names. */
+            sprintf(file->name, "d%02d/f%03d", i / BENCH_FILES_PER_DIR,
+                    i % BENCH_FILES_PER_DIR);
+            file->len = BENCH_SMALL_MIN +
+                        (lcg(&state) % (BENCH_SMALL_MAX - BENCH_SMALL_MIN));
+        } /* else */
+
+        file->data = (PHYSFS_uint8 *) xmalloc(file->len);
+        fill_data(file->data, file->len, (PHYSFS_uint32) i + 1);
+        file->crc = crc32(file->data, file->len);
+    } /* for */
+} /* make_files */
+
+
+static void free_files(void)
+{
+    int i;
+    for (i = 0; i < BENCH_FILES; i++)
+        free(files[i].data);
+} /* free_files */
+
+
+/* Writing archives... */
+
+static void buf_reserve(Buf *b, size_t len)
+{
+    if (b->len + len > b->alloc)
+    {
+        void *ptr;
+        size_t alloc = b->alloc ? b->alloc : 4096;
+        while (alloc < b->len + len)
+            alloc *= 2;
+        ptr = realloc(b->data, alloc);
+        if (ptr == NULL)
+        {
+            fprintf(stderr, "bench: out of memory\n");
+            exit(42);
+        } /* if */
+        b->data = (PHYSFS_uint8 *) ptr;
+        b->alloc = alloc;
+    } /* if */
+} /* buf_reserve */
+
+static void put_bytes(Buf *b, const void *ptr, size_t len)
+{
+    buf_reserve(b, len);
+    memcpy(b->data + b->len, ptr, len);
+    b->len += len;
+} /* put_bytes */
+
+static void put_zeros(Buf *b, size_t len)
+{
+    buf_reserve(b, len);
+    memset(b->data + b->len, '\0', len);
+    b->len += len;
+} /* put_zeros */
+
+static void put8(Buf *b, PHYSFS_uint32 val)
+{
+    const PHYSFS_uint8 byte = (PHYSFS_uint8) val;
+    put_bytes(b, &byte, 1);
+} /* put8 */
+
+static void put16(Buf *b, PHYSFS_uint32 val)
+{
+    put8(b, val);
+    put8(b, val >> 8);
+} /* put16 */
+
+static void put32(Buf *b, PHYSFS_uint32 val)
+{
+    put16(b, val);
+    put16(b, val >> 16);
+} /* put32 */
+
+static void put64(Buf *b, PHYSFS_uint64 val)
+{
+    put32(b, (PHYSFS_uint32) val);
+    put32(b, (PHYSFS_uint32) (val >> 32));
+} /* put64 */
+
+static void set32(Buf *b, size_t pos, PHYSFS_uint32 val)
+{
+    b->data[pos] = (PHYSFS_uint8) val;
+    b->data[pos + 1] = (PHYSFS_uint8) (val >> 8);
+    b->data[pos + 2] = (PHYSFS_uint8) (val >> 16);
+    b->data[pos + 3] = (PHYSFS_uint8) (val >> 24);
+} /* set32 */
+
+
+static int save_buf(const char *filename, Buf *b)
+{
+    PHYSFS_File *f = PHYSFS_openWrite(filename);
+    int retval = 0;
+
+    if (f != NULL)
+    {
+        retval = (PHYSFS_writeBytes(f, b->data, b->len) == (PHYSFS_sint64) b->len);
+        retval = PHYSFS_close(f) && retval;
+    } /* if */
+
+    free(b->data);
+    return retval;
+} /* save_buf */
+
+
+/*
+ * Deflate (RFC 1951) with the fixed Huffman codes and a one-probe hash for
+ *  matches. It's nowhere near zlib, but it makes real deflate streams with
+ *  plenty of back-references for the decoder to chew on.
+ */
+typedef struct
+{
+    Buf *out;
+    PHYSFS_uint32 bits;
+    int bitcount;
+} BitWriter;
+
+static void put_bits(BitWriter *w, PHYSFS_uint32 val, int count)
+{
+    w->bits |= val << w->bitcount;
+    w->bitcount += count;
+    while (w->bitcount >= 8)
+    {
+        put8(w->out, w->bits);
+        w->bits >>= 8;
+        w->bitcount -= 8;
+    } /* while */
+} /* put_bits */
+
+/* Huffman codes go out most significant bit first. */
+static void put_code(BitWriter *w, PHYSFS_uint32 code, int count)
+{
+    PHYSFS_uint32 reversed = 0;
+    int i;
+    for (i = 0; i < count; i++)
+        reversed |= ((code >> i) & 1) << (count - 1 - i);
+    put_bits(w, reversed, count);
+} /* put_code */
+
+static void put_symbol(BitWriter *w, PHYSFS_uint32 sym)
+{
+    if (sym < 144)
+        put_code(w, 0x30 + sym, 8);
+    else if (sym < 256)
+        put_code(w, 0x190 + (sym - 144), 9);
+    else if (sym < 280)
+        put_code(w, sym - 256, 7);
+    else
+        put_code(w, 0xC0 + (sym - 280), 8);
+} /* put_symbol */
+
+static void put_match(BitWriter *w, PHYSFS_uint32 len, PHYSFS_uint32 dist)
+{
+    static const PHYSFS_uint16 lenbase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51,
+        59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const PHYSFS_uint8 lenextra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,
+        4, 5, 5, 5, 5, 0
+    };
+    static const PHYSFS_uint16 distbase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+        513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385,
+        24577
+    };
+    static const PHYSFS_uint8 distextra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+        10, 11, 11, 12, 12, 13, 13
+    };
+    int i;
+
+    for (i = 28; lenbase[i] > len; i--) { /* spin */ }
+    put_symbol(w, 257 + i);
+    put_bits(w, len - lenbase[i], lenextra[i]);
+
+    for (i = 29; distbase[i] > dist; i--) { /* spin */ }
+    put_code(w, i, 5);
+    put_bits(w, dist - distbase[i], distextra[i]);
+} /* put_match */
+
+static void deflate_data(Buf *out, const PHYSFS_uint8 *data, PHYSFS_uint32 len)
+{
+    static PHYSFS_uint32 head[1 << 15];
+    BitWriter w;
+    PHYSFS_uint32 i = 0;
+
+    memset(head, '\0', sizeof (head));
+    w.out = out;
+    w.bits = 0;
+    w.bitcount = 0;
+    put_bits(&w, 1, 1);  /* BFINAL */
+    put_bits(&w, 1, 2);  /* BTYPE: fixed Huffman codes. */
+
+    while (i < len)
+    {
+        PHYSFS_uint32 matchlen = 0;
+        PHYSFS_uint32 hash = 0;
+        PHYSFS_uint32 cand = 0;
+
+        if (len - i >= 3)
+        {
+            hash = ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & 0x7FFF;
+            cand = head[hash];
+            head[hash] = i + 1;
+            if ((cand != 0) && (i - (cand - 1) <= 32768))
+            {
+                const PHYSFS_uint8 *a = data + (cand - 1);
+                const PHYSFS_uint32 most = ((len - i) < 258) ? (len - i) : 258;
+                while ((matchlen < most) && (a[matchlen] == data[i + matchlen]))
+                    matchlen++;
+            } /* if */
+        } /* if */
+
+        if (matchlen >= 3)
+        {
+            PHYSFS_uint32 j;
+            put_match(&w, matchlen, i - (cand - 1));
+            for (j = 1; (j < matchlen) && (i + j + 2 < len); j++)
+            {
+                const PHYSFS_uint8 *p = data + i + j;
+                head[((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & 0x7FFF] = i + j + 1;
+            } /* for */
+            i += matchlen;
+        } /* if */
+        else
+        {
+            put_symbol(&w, data[i++]);
+        } /* else */
+    } /* while */
+
+    put_symbol(&w, 256);  /* end of block. */
+    put_bits(&w, 0, 7);   /* flush to a byte. */
+} /* deflate_data */
+
+
+static int build_zip(const char *filename, const int deflated)
+{
+    PHYSFS_uint32 *offsets = (PHYSFS_uint32 *) xmalloc(sizeof (PHYSFS_uint32) * BENCH_FILES);
+    PHYSFS_uint32 *packed = (PHYSFS_uint32 *) xmalloc(sizeof (PHYSFS_uint32) * BENCH_FILES);
+    const PHYSFS_uint32 method = deflated ? 8 : 0;
+    PHYSFS_uint32 cdstart, cdsize;
+    Buf b = { NULL, 0, 0 };
+    int i;
+
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        const BenchFile *file = &files[i];
+        const PHYSFS_uint32 namelen = (PHYSFS_uint32) strlen(file->name);
+        size_t start;
+
+        offsets[i] = (PHYSFS_uint32) b.len;
+        put32(&b, 0x04034B50);  /* local file header signature. */
+        put16(&b, 20);          /* version needed to extract. */
+        put16(&b, 0);           /* flags. */
+        put16(&b, method);
+        put16(&b, 0);           /* time. */
+        put16(&b, 0x21);        /* date: 1980-01-01. */
+        put32(&b, file->crc);
+        put32(&b, 0);           /* compressed size, filled in below. */
+        put32(&b, file->len);
+        put16(&b, namelen);
+        put16(&b, 0);           /* extra field length. */
+        put_bytes(&b, file->name, namelen);
+
+        start = b.len;
+        if (deflated)
+            deflate_data(&b, file->data, file->len);
+        else
+            put_bytes(&b, file->data, file->len);
+        packed[i] = (PHYSFS_uint32) (b.len - start);
+        set32(&b, offsets[i] + 18, packed[i]);
+    } /* for */
+
+    cdstart = (PHYSFS_uint32) b.len;
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        const BenchFile *file = &files[i];
+        const PHYSFS_uint32 namelen = (PHYSFS_uint32) strlen(file->name);
+        put32(&b, 0x02014B50);  /* central directory signature. */
+        put16(&b, 20);          /* version made by. */
+        put16(&b, 20);          /* version needed to extract. */
+        put16(&b, 0);
+        put16(&b, method);
+        put16(&b, 0);
+        put16(&b, 0x21);
+        put32(&b, file->crc);
+        put32(&b, packed[i]);
+        put32(&b, file->len);
+        put16(&b, namelen);
+        put16(&b, 0);           /* extra field length. */
+        put16(&b, 0);           /* comment length. */
+        put16(&b, 0);           /* disk number start. */
+        put16(&b, 0);           /* internal attributes. */
+        put32(&b, 0);           /* external attributes. */
+        put32(&b, offsets[i]);
+        put_bytes(&b, file->name, namelen);
+    } /* for */
+
+    cdsize = (PHYSFS_uint32) b.len - cdstart;
+    put32(&b, 0x06054B50);  /* end of central directory signature. */
+    put16(&b, 0);
+    put16(&b, 0);
+    put16(&b, BENCH_FILES);
+    put16(&b, BENCH_FILES);
+    put32(&b, cdsize);
+    put32(&b, cdstart);
+    put16(&b, 0);           /* comment length. */
+
+    free(offsets);
+    free(packed);
+    return save_buf(filename, &b);
+} /* build_zip */
+
+static int build_zip_stored(const char *fname) { return build_zip(fname, 0); }
+static int build_zip_deflated(const char *fname) { return build_zip(fname, 1); }
+
+
+/* 7z's variable length numbers: leading 1 bits say how many bytes follow. */
+static void put_7z_number(Buf *b, PHYSFS_uint64 val)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        if (val < (((PHYSFS_uint64) 1) << (7 * (i + 1))))
+            break;
+    } /* for */
+
+    if (i == 8)
+        put8(b, 0xFF);
+    else
+        put8(b, ((0xFF00 >> i) & 0xFF) | (PHYSFS_uint32) (val >> (8 * i)));
+
+    for (; i > 0; i--, val >>= 8)
+        put8(b, (PHYSFS_uint32) (val & 0xFF));
+} /* put_7z_number */
+
+/*
+ * Directories come first, as empty streams, then every file. A solid
+ *  archive has one Copy folder holding everything; otherwise each file
+ *  gets its own folder.
+ */
+static int build_7z(const char *filename, const int solid)
+{
+    const PHYSFS_uint32 entries = BENCH_DIRS + BENCH_FILES;
+    const PHYSFS_uint32 folders = solid ? 1 : BENCH_FILES;
+    PHYSFS_uint64 total = 0;
+    Buf b = { NULL, 0, 0 };
+    Buf h = { NULL, 0, 0 };
+    PHYSFS_uint32 i, j;
+    PHYSFS_uint32 namebytes = 0;
+
+    put_zeros(&b, 32);  /* signature header, filled in at the end. */
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        put_bytes(&b, files[i].data, files[i].len);
+        total += files[i].len;
+    } /* for */
+
+    put8(&h, 0x01);  /* kHeader */
+    put8(&h, 0x04);  /* kMainStreamsInfo */
+
+    put8(&h, 0x06);  /* kPackInfo */
+    put_7z_number(&h, 0);
+    put_7z_number(&h, folders);
+    put8(&h, 0x09);  /* kSize */
+    for (i = 0; i < folders; i++)
+        put_7z_number(&h, solid ? total : files[i].len);
+    put8(&h, 0x00);
+
+    put8(&h, 0x07);  /* kUnPackInfo */
+    put8(&h, 0x0B);  /* kFolder */
+    put_7z_number(&h, folders);
+    put8(&h, 0x00);  /* not external. */
+    for (i = 0; i < folders; i++)
+    {
+        put_7z_number(&h, 1);  /* one coder... */
+        put8(&h, 0x01);        /* ...with a one byte id... */
+        put8(&h, 0x00);        /* ...which is Copy. */
+    } /* for */
+    put8(&h, 0x0C);  /* kCodersUnPackSize */
+    for (i = 0; i < folders; i++)
+        put_7z_number(&h, solid ? total : files[i].len);
+    put8(&h, 0x00);
+
+    put8(&h, 0x08);  /* kSubStreamsInfo */
+    if (solid)
+    {
+        put8(&h, 0x0D);  /* kNumUnPackStream */
+        put_7z_number(&h, BENCH_FILES);
+        put8(&h, 0x09);  /* kSize, all but the last. */
+        for (i = 0; i < BENCH_FILES - 1; i++)
+            put_7z_number(&h, files[i].len);
+    } /* if */
+    put8(&h, 0x00);
+    put8(&h, 0x00);  /* end of kMainStreamsInfo */
+
+    put8(&h, 0x05);  /* kFilesInfo */
+    put_7z_number(&h, entries);
+
+    put8(&h, 0x0E);  /* kEmptyStream */
+    put_7z_number(&h, (entries + 7) / 8);
+    for (i = 0; i < entries; i += 8)
+    {
+        PHYSFS_uint32 bits = 0;
+        for (j = i; (j < i + 8) && (j < entries); j++)
+        {
+            if (j < BENCH_DIRS)
+                bits |= 0x80 >> (j - i);
+        } /* for */
+        put8(&h, bits);
+    } /* for */
+
+    for (i = 0; i < BENCH_DIRS; i++)
+        namebytes += 4 * 2;  /* "d00" and a null. */
+    for (i = 0; i < BENCH_FILES; i++)
+        namebytes += (PHYSFS_uint32) (strlen(files[i].name) + 1) * 2;
+    put8(&h, 0x11);  /* kName */
+    put_7z_number(&h, namebytes + 1);
+    put8(&h, 0x00);  /* not external. */
+    for (i = 0; i < entries; i++)
+    {
+        char dirname[8];
+        const char *name = dirname;
+        if (i < BENCH_DIRS)
+            sprintf(dirname, "d%02d", (int) i);
+        else
+            name = files[i - BENCH_DIRS].name;
+        do
+        {
+            put16(&h, (PHYSFS_uint8) *name);  /* it's all ASCII. */
+        } while (*(name++));
+    } /* for */
+
+    put8(&h, 0x00);  /* end of kFilesInfo */
+    put8(&h, 0x00);  /* end of kHeader */
+
+    /* the signature header, now we know where the header is. */
+    {
+        Buf start = { NULL, 0, 0 };
+        static const PHYSFS_uint8 sig[6] = { '7', 'z', 0xBC, 0xAF, 0x27, 0x1C };
+        put64(&start, (PHYSFS_uint64) (b.len - 32));
+        put64(&start, (PHYSFS_uint64) h.len);
+        put32(&start, crc32(h.data, h.len));
+        memcpy(b.data, sig, sizeof (sig));
+        b.data[6] = 0;  /* major version. */
+        b.data[7] = 3;  /* minor version. */
+        set32(&b, 8, crc32(start.data, start.len));
+        memcpy(b.data + 12, start.data, start.len);
+        free(start.data);
+    }
+
+    put_bytes(&b, h.data, h.len);
+    free(h.data);
+    return save_buf(filename, &b);
+} /* build_7z */
+
+static int build_7z_solid(const char *fname) { return build_7z(fname, 1); }
+static int build_7z_nonsolid(const char *fname) { return build_7z(fname, 0); }
+
+
+static int build_qpak(const char *filename)
+{
+    Buf b = { NULL, 0, 0 };
+    PHYSFS_uint32 *offsets = (PHYSFS_uint32 *) xmalloc(sizeof (PHYSFS_uint32) * BENCH_FILES);
+    PHYSFS_uint32 dirpos;
+    int i;
+
+    put_bytes(&b, "PACK", 4);
+    put32(&b, 0);  /* directory offset, filled in below. */
+    put32(&b, BENCH_FILES * 64);
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        offsets[i] = (PHYSFS_uint32) b.len;
+        put_bytes(&b, files[i].data, files[i].len);
+    } /* for */
+
+    dirpos = (PHYSFS_uint32) b.len;
+    set32(&b, 4, dirpos);
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        char name[56];
+        memset(name, '\0', sizeof (name));
+        strcpy(name, files[i].name);
+        put_bytes(&b, name, sizeof (name));
+        put32(&b, offsets[i]);
+        put32(&b, files[i].len);
+    } /* for */
+
+    free(offsets);
+    return save_buf(filename, &b);
+} /* build_qpak */
+
+
+static int build_wad(const char *filename)
+{
+    Buf b = { NULL, 0, 0 };
+    PHYSFS_uint32 *offsets = (PHYSFS_uint32 *) xmalloc(sizeof (PHYSFS_uint32) * BENCH_FILES);
+    int i;
+
+    put_bytes(&b, "PWAD", 4);
+    put32(&b, BENCH_FILES);
+    put32(&b, 0);  /* directory offset, filled in below. */
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        offsets[i] = (PHYSFS_uint32) b.len;
+        put_bytes(&b, files[i].data, files[i].len);
+    } /* for */
+
+    set32(&b, 8, (PHYSFS_uint32) b.len);
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        char name[8];
+        memset(name, '\0', sizeof (name));
+        memcpy(name, files[i].name, strlen(files[i].name));  /* no null. */
+        put32(&b, offsets[i]);
+        put32(&b, files[i].len);
+        put_bytes(&b, name, sizeof (name));
+    } /* for */
+
+    free(offsets);
+    return save_buf(filename, &b);
+} /* build_wad */
+
+
+typedef struct
+{
+    char name[16];  /* ISO9660 name, with the ";1"; "\0" and "\1" for . and .. */
+    PHYSFS_uint32 namelen;
+    PHYSFS_uint32 extent;
+    PHYSFS_uint32 len;
+    int isdir;
+} IsoRecord;
+
+static void put_both32(Buf *b, PHYSFS_uint32 val)
+{
+    put32(b, val);
+    put8(b, val >> 24);
+    put8(b, val >> 16);
+    put8(b, val >> 8);
+    put8(b, val);
+} /* put_both32 */
+
+static void put_both16(Buf *b, PHYSFS_uint32 val)
+{
+    put16(b, val);
+    put8(b, val >> 8);
+    put8(b, val);
+} /* put_both16 */
+
+static void put_iso_record(Buf *b, const IsoRecord *rec)
+{
+    const PHYSFS_uint32 reclen = 33 + rec->namelen + ((rec->namelen & 1) ? 0 : 1);
+    static const PHYSFS_uint8 recordtime[7] = { 100, 1, 1, 0, 0, 0, 0 };
+
+    put8(b, reclen);
+    put8(b, 0);  /* extended attribute record length. */
+    put_both32(b, rec->extent);
+    put_both32(b, rec->len);
+    put_bytes(b, recordtime, sizeof (recordtime));
+    put8(b, rec->isdir ? 0x02 : 0x00);
+    put8(b, 0);  /* file unit size. */
+    put8(b, 0);  /* interleave gap. */
+    put_both16(b, 1);  /* volume sequence number. */
+    put8(b, rec->namelen);
+    put_bytes(b, rec->name, rec->namelen);
+    if ((rec->namelen & 1) == 0)
+        put8(b, 0);  /* pad to an even length. */
+} /* put_iso_record */
+
+/* Bytes the directory holding (recs) takes up; records can't cross sectors. */
+static PHYSFS_uint32 iso_dir_size(const IsoRecord *recs, int count)
+{
+    PHYSFS_uint32 pos = 0;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_uint32 reclen = 33 + recs[i].namelen + ((recs[i].namelen & 1) ? 0 : 1);
+        if ((pos % 2048) + reclen > 2048)
+            pos = ((pos / 2048) + 1) * 2048;
+        pos += reclen;
+    } /* for */
+    return ((pos + 2047) / 2048) * 2048;
+} /* iso_dir_size */
+
+static void put_iso_dir(Buf *b, const IsoRecord *recs, int count)
+{
+    const size_t start = b->len;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_uint32 reclen = 33 + recs[i].namelen + ((recs[i].namelen & 1) ? 0 : 1);
+        if (((b->len - start) % 2048) + reclen > 2048)
+            put_zeros(b, 2048 - ((b->len - start) % 2048));
+        put_iso_record(b, &recs[i]);
+    } /* for */
+    put_zeros(b, (2048 - ((b->len - start) % 2048)) % 2048);
+} /* put_iso_dir */
+
+static void set_iso_record(IsoRecord *rec, const char *name,
+                           PHYSFS_uint32 namelen, int isdir)
+{
+    memset(rec, '\0', sizeof (*rec));
+    memcpy(rec->name, name, namelen);
+    rec->namelen = namelen;
+    rec->isdir = isdir;
+} /* set_iso_record */
+
+/*
+ * Sectors 16 and 17 are the primary volume descriptor and the terminator,
+ *  then the root directory, each subdirectory, and all the file data.
+ */
+static int build_iso(const char *filename)
+{
+    IsoRecord root[BENCH_DIRS + 3];
+    IsoRecord dirs[BENCH_DIRS][BENCH_FILES_PER_DIR + 2];
+    PHYSFS_uint32 sector = 18;
+    PHYSFS_uint32 rootsize, dirsize[BENCH_DIRS];
+    Buf b = { NULL, 0, 0 };
+    int i, j;
+
+    set_iso_record(&root[0], "\0", 1, 1);
+    set_iso_record(&root[1], "\1", 1, 1);
+    for (i = 0; i < BENCH_DIRS; i++)
+    {
+        char name[8];
+        sprintf(name, "d%02d", i);
+        set_iso_record(&root[i + 2], name, 3, 1);
+        set_iso_record(&dirs[i][0], "\0", 1, 1);
+        set_iso_record(&dirs[i][1], "\1", 1, 1);
+        for (j = 0; j < BENCH_FILES_PER_DIR; j++)
+        {
+            sprintf(name, "f%03d;1", j);
+            set_iso_record(&dirs[i][j + 2], name, 6, 0);
+        } /* for */
+    } /* for */
+    set_iso_record(&root[BENCH_DIRS + 2], "big.dat;1", 9, 0);
+
+    /* work out where everything goes. */
+    rootsize = iso_dir_size(root, BENCH_DIRS + 3);
+    root[0].extent = root[1].extent = sector;
+    root[0].len = root[1].len = rootsize;
+    sector += rootsize / 2048;
+    for (i = 0; i < BENCH_DIRS; i++)
+    {
+        dirsize[i] = iso_dir_size(dirs[i], BENCH_FILES_PER_DIR + 2);
+        root[i + 2].extent = dirs[i][0].extent = sector;
+        root[i + 2].len = dirs[i][0].len = dirsize[i];
+        dirs[i][1].extent = root[0].extent;
+        dirs[i][1].len = rootsize;
+        sector += dirsize[i] / 2048;
+    } /* for */
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        IsoRecord *rec = (i == BENCH_SMALL_FILES) ? &root[BENCH_DIRS + 2] :
+            &dirs[i / BENCH_FILES_PER_DIR][(i % BENCH_FILES_PER_DIR) + 2];
+        rec->extent = sector;
+        rec->len = files[i].len;
+        sector += (files[i].len + 2047) / 2048;
+    } /* for */
+
+    put_zeros(&b, 16 * 2048);  /* system area. */
+
+    put8(&b, 1);  /* primary volume descriptor. */
+    put_bytes(&b, "CD001", 5);
+    put8(&b, 1);
+    put_zeros(&b, 73);
+    put_both32(&b, sector);  /* volume space size. */
+    put_zeros(&b, 32);
+    put_both16(&b, 1);  /* volume set size. */
+    put_both16(&b, 1);  /* volume sequence number. */
+    put_both16(&b, 2048);  /* logical block size. */
+    put_zeros(&b, 24);  /* no path tables; we don't read them. */
+    put_iso_record(&b, &root[0]);
+    put_zeros(&b, (17 * 2048) - b.len);
+
+    put8(&b, 255);  /* volume descriptor set terminator. */
+    put_bytes(&b, "CD001", 5);
+    put8(&b, 1);
+    put_zeros(&b, (18 * 2048) - b.len);
+
+    put_iso_dir(&b, root, BENCH_DIRS + 3);
+    for (i = 0; i < BENCH_DIRS; i++)
+        put_iso_dir(&b, dirs[i], BENCH_FILES_PER_DIR + 2);
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        put_bytes(&b, files[i].data, files[i].len);
+        put_zeros(&b, (2048 - (files[i].len % 2048)) % 2048);
+    } /* for */
+
+    return save_buf(filename, &b);
+} /* build_iso */
+
+
+static int build_tree(const char *dirname)
+{
+    char path[64];
+    int i;
+
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        PHYSFS_File *f;
+        int rc;
+
+        if ((i < BENCH_SMALL_FILES) && ((i % BENCH_FILES_PER_DIR) == 0))
+        {
+            sprintf(path, "%.32s/d%02d", dirname, i / BENCH_FILES_PER_DIR);
+            if (!PHYSFS_mkdir(path))
+                return 0;
+        } /* if */
+
+        sprintf(path, "%.32s/%.15s", dirname, files[i].name);
+        f = PHYSFS_openWrite(path);
+        if (f == NULL)
+            return 0;
+        rc = (PHYSFS_writeBytes(f, files[i].data, files[i].len) == files[i].len);
+        if (!PHYSFS_close(f) || !rc)
+            return 0;
+    } /* for */
+
+    return 1;
+} /* build_tree */
+
+
+static void remove_tree(const char *dirname)
+{
+    char path[64];
+    int i;
+
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        sprintf(path, "%.32s/%.15s", dirname, files[i].name);
+        PHYSFS_delete(path);
+    } /* for */
+
+    for (i = 0; i < BENCH_DIRS; i++)
+    {
+        sprintf(path, "%.32s/d%02d", dirname, i);
+        PHYSFS_delete(path);
+    } /* for */
+
+    PHYSFS_delete(dirname);
+} /* remove_tree */
+
+
+static const BenchArchive archives[] =
+{
+    { "dir", "tree", build_tree },
+    { "zip_stored", "stored.zip", build_zip_stored },
+    { "zip_deflated", "deflated.zip", build_zip_deflated },
+    { "7z_solid", "solid.7z", build_7z_solid },
+    { "7z_nonsolid", "nonsolid.7z", build_7z_nonsolid },
+    { "qpak", "bench.pak", build_qpak },
+    { "wad", "bench.wad", build_wad },
+    { "iso9660", "bench.iso", build_iso }
+};
+
+
+/* The benchmarks... */
+
+static char *native_path(const char *filename)
+{
+    const char *sep = PHYSFS_getDirSeparator();
+    char *retval = (char *) xmalloc(strlen(BENCH_SCRATCH_DIR) + strlen(sep) +
+                                    strlen(filename) + 1);
+    sprintf(retval, "%s%s%s", BENCH_SCRATCH_DIR, sep, filename);
+    return retval;
+} /* native_path */
+
+
+static PHYSFS_sint64 read_whole(const char *fname, void *buf, PHYSFS_uint64 len)
+{
+    PHYSFS_File *f = PHYSFS_openRead(fname);
+    PHYSFS_sint64 retval;
+    if (f == NULL)
+        return -1;
+    retval = PHYSFS_readBytes(f, buf, len);
+    PHYSFS_close(f);
+    return retval;
+} /* read_whole */
+
+
+/* Make sure the archive holds what we put in it before timing anything. */
+static int verify(const char *archive)
+{
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) xmalloc(bigsize + 1);
+    int i;
+
+    for (i = 0; i < BENCH_FILES; i++)
+    {
+        const BenchFile *file = &files[i];
+        const PHYSFS_sint64 rc = read_whole(file->name, buf, file->len + 1);
+        if ((rc != (PHYSFS_sint64) file->len) ||
+            (memcmp(buf, file->data, file->len) != 0))
+        {
+            fprintf(stderr, "bench: %s: '%s' doesn't match (%s)\n",
+                    archive, file->name,
+                    PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+            free(buf);
+            return 0;
+        } /* if */
+    } /* for */
+
+    free(buf);
+    return 1;
+} /* verify */
+
+
+static void bench_mount(const char *archive, const char *path)
+{
+    const PHYSFS_uint64 start = now_ns();
+    int i;
+
+    for (i = 0; i < iterations; i++)
+    {
+        PHYSFS_mount(path, NULL, 0);
+        PHYSFS_unmount(path);
+    } /* for */
+
+    report(archive, "mount", 1, iterations, 0, now_ns() - start);
+} /* bench_mount */
+
+
+static void bench_lookup(const char *archive)
+{
+    char missname[16];
+    PHYSFS_uint64 start;
+    int i, j;
+
+    start = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < BENCH_SMALL_FILES; j++)
+            PHYSFS_exists(files[j].name);
+    } /* for */
+    report(archive, "lookup_hit", 1, (PHYSFS_uint64) iterations * BENCH_SMALL_FILES,
+           0, now_ns() - start);
+
+    start = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < BENCH_SMALL_FILES; j++)
+        {
+            strcpy(missname, files[j].name);
+            missname[4] = 'x';  /* d00/x000: right dir, no such file. */
+            PHYSFS_exists(missname);
+        } /* for */
+    } /* for */
+    report(archive, "lookup_miss", 1, (PHYSFS_uint64) iterations * BENCH_SMALL_FILES,
+           0, now_ns() - start);
+} /* bench_lookup */
+
+
+static void bench_enumerate(const char *archive)
+{
+    const PHYSFS_uint64 start = now_ns();
+    char dirname[8];
+    int i, j;
+
+    for (i = 0; i < iterations; i++)
+    {
+        PHYSFS_freeList(PHYSFS_enumerateFiles(""));
+        for (j = 0; j < BENCH_DIRS; j++)
+        {
+            sprintf(dirname, "d%02d", j);
+            PHYSFS_freeList(PHYSFS_enumerateFiles(dirname));
+        } /* for */
+    } /* for */
+
+    report(archive, "enumerate", 1, (PHYSFS_uint64) iterations * (BENCH_DIRS + 1),
+           0, now_ns() - start);
+} /* bench_enumerate */
+
+
+static void bench_small_read(const char *archive)
+{
+    PHYSFS_uint8 buf[BENCH_SMALL_MAX];
+    PHYSFS_uint64 bytes = 0;
+    const PHYSFS_uint64 start = now_ns();
+    int i, j;
+
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < BENCH_SMALL_FILES; j++)
+        {
+            const PHYSFS_sint64 rc = read_whole(files[j].name, buf, sizeof (buf));
+            if (rc > 0)
+                bytes += (PHYSFS_uint64) rc;
+        } /* for */
+    } /* for */
+
+    report(archive, "small_read", 1, (PHYSFS_uint64) iterations * BENCH_SMALL_FILES,
+           bytes, now_ns() - start);
+} /* bench_small_read */
+
+
+static void bench_big_read(const char *archive)
+{
+    const PHYSFS_uint32 chunk = 64 * 1024;
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) xmalloc(chunk);
+    const char *bigname = files[BENCH_SMALL_FILES].name;
+    PHYSFS_uint64 bytes = 0;
+    PHYSFS_uint64 start;
+    PHYSFS_uint32 state = 0x5EED;
+    PHYSFS_File *f;
+    int rounds = (iterations + 4) / 5;
+    int seeks = iterations * 100;
+    int i;
+
+    start = now_ns();
+    for (i = 0; i < rounds; i++)
+    {
+        PHYSFS_sint64 rc;
+        f = PHYSFS_openRead(bigname);
+        if (f == NULL)
+            break;
+        while ((rc = PHYSFS_readBytes(f, buf, chunk)) > 0)
+            bytes += (PHYSFS_uint64) rc;
+        PHYSFS_close(f);
+    } /* for */
+    report(archive, "sequential_read", 1, rounds, bytes, now_ns() - start);
+
+    bytes = 0;
+    f = PHYSFS_openRead(bigname);
+    start = now_ns();
+    for (i = 0; (f != NULL) && (i < seeks); i++)
+    {
+        const PHYSFS_uint32 pos = lcg(&state) * 256 % (bigsize - 4096);
+        PHYSFS_sint64 rc;
+        PHYSFS_seek(f, pos);
+        rc = PHYSFS_readBytes(f, buf, 4096);
+        if (rc > 0)
+            bytes += (PHYSFS_uint64) rc;
+    } /* for */
+    report(archive, "random_seek_read", 1, seeks, bytes, now_ns() - start);
+    if (f != NULL)
+        PHYSFS_close(f);
+
+    free(buf);
+} /* bench_big_read */
+
+
+typedef struct
+{
+    void (*func)(void *data);
+    void *data;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} BenchThread;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg)
+{
+    BenchThread *thread = (BenchThread *) arg;
+    thread->func(thread->data);
+    return 0;
+} /* thread_main */
+#else
+static void *thread_main(void *arg)
+{
+    BenchThread *thread = (BenchThread *) arg;
+    thread->func(thread->data);
+    return NULL;
+} /* thread_main */
+#endif
+
+static int start_thread(BenchThread *thread, void (*func)(void *), void *data)
+{
+    thread->func = func;
+    thread->data = data;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+    return (thread->handle != NULL);
+#else
+    return (pthread_create(&thread->handle, NULL, thread_main, thread) == 0);
+#endif
+} /* start_thread */
+
+static void wait_thread(BenchThread *thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+} /* wait_thread */
+
+
+typedef struct
+{
+    int index;
+    PHYSFS_uint64 bytes;
+} ThreadData;
+
+/* every thread reads every small file, each starting somewhere else. */
+static void thread_work(void *arg)
+{
+    ThreadData *data = (ThreadData *) arg;
+    PHYSFS_uint8 buf[BENCH_SMALL_MAX];
+    const int first = (data->index * 97) % BENCH_SMALL_FILES;
+    int i;
+
+    for (i = 0; i < BENCH_SMALL_FILES; i++)
+    {
+        const char *fname = files[(first + i) % BENCH_SMALL_FILES].name;
+        const PHYSFS_sint64 rc = read_whole(fname, buf, sizeof (buf));
+        if (rc > 0)
+            data->bytes += (PHYSFS_uint64) rc;
+    } /* for */
+} /* thread_work */
+
+static void bench_threads(const char *archive)
+{
+    ThreadData data[BENCH_MAX_THREADS];
+    BenchThread threads[BENCH_MAX_THREADS];
+    int count, i;
+
+    for (count = 1; count <= maxthreads; count *= 2)
+    {
+        PHYSFS_uint64 bytes = 0;
+        PHYSFS_uint64 start = now_ns();
+        int started = 0;
+
+        for (i = 0; i < count; i++)
+        {
+            data[i].index = i;
+            data[i].bytes = 0;
+            if (!start_thread(&threads[i], thread_work, &data[i]))
+                break;
+            started++;
+        } /* for */
+
+        for (i = 0; i < started; i++)
+        {
+            wait_thread(&threads[i]);
+            bytes += data[i].bytes;
+        } /* for */
+
+        if (started < count)
+        {
+            fprintf(stderr, "bench: couldn't start %d threads\n", count);
+            break;
+        } /* if */
+
+        report(archive, "threaded_small_read", count,
+               (PHYSFS_uint64) count * BENCH_SMALL_FILES, bytes,
+               now_ns() - start);
+    } /* for */
+} /* bench_threads */
+
+
+static int bench_archive(const BenchArchive *archive)
+{
+    char *path = native_path(archive->filename);
+    int retval = 0;
+
+    if (!archive->build(archive->filename))
+    {
+        fprintf(stderr, "bench: couldn't write %s: %s\n", archive->filename,
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    } /* if */
+    else if (!PHYSFS_mount(path, NULL, 0))
+    {
+        /* not built in? Say so, but it's not a failure. */
+        fprintf(stderr, "bench: skipping %s: %s\n", archive->name,
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        retval = 1;
+    } /* else if */
+    else
+    {
+        retval = verify(archive->name);
+        PHYSFS_unmount(path);
+
+        if (retval)
+        {
+            bench_mount(archive->name, path);
+            PHYSFS_mount(path, NULL, 0);
+            bench_lookup(archive->name);
+            bench_enumerate(archive->name);
+            bench_small_read(archive->name);
+            bench_big_read(archive->name);
+            bench_threads(archive->name);
+            PHYSFS_unmount(path);
+        } /* if */
+    } /* else */
+
+    free(path);
+    return retval;
+} /* bench_archive */
+
+
+/*
+ * Stress testing: several threads doing a mix of opens, seeks, reads,
+ *  stats, enumerations and failed lookups against one search path (a
+ *  directory, an ISO image and a ZIP mounted from memory), while another
+ *  thread keeps mounting and unmounting a fourth archive underneath them.
+ *  Everything read is checked, so this is a correctness test as much as a
+ *  scaling benchmark.
+ */
+
+static const char *stressmounts[] = { "dir", "iso", "zip", "churn" };
+static char *stresschurnpath = NULL;  /* native path of the churn archive. */
+
+typedef struct
+{
+    int index;
+    PHYSFS_uint64 deadline;
+    PHYSFS_uint64 ops;
+    PHYSFS_uint64 bytes;
+    PHYSFS_uint64 errors;
+} StressData;
+
+static void stress_work(void *arg)
+{
+    StressData *data = (StressData *) arg;
+    PHYSFS_uint8 *buf = (PHYSFS_uint8 *) xmalloc(BENCH_SMALL_MAX);
+    PHYSFS_uint32 state = 0x9E3779B9 * (data->index + 1);
+    char path[64];
+
+    while (now_ns() < data->deadline)
+    {
+        const PHYSFS_uint32 mnt = lcg(&state) % 4;
+        const BenchFile *file = &files[lcg(&state) % BENCH_FILES];
+        const PHYSFS_uint32 op = lcg(&state) % 100;
+        const int churn = (mnt == 3);  /* this one might not be there. */
+
+        if (op < 50)  /* open, seek, read and check it. */
+        {
+            const PHYSFS_uint32 len = (file->len < BENCH_SMALL_MAX) ? file->len : BENCH_SMALL_MAX;
+            const PHYSFS_uint32 pos = lcg(&state) % (file->len - len + 1);
+            PHYSFS_File *f;
+
+            sprintf(path, "%s/%.15s", stressmounts[mnt], file->name);
+            f = PHYSFS_openRead(path);
+            if (f == NULL)
+                data->errors += churn ? 0 : 1;
+            else
+            {
+                if ( (!PHYSFS_seek(f, pos)) ||
+                     (PHYSFS_readBytes(f, buf, len) != (PHYSFS_sint64) len) ||
+                     (memcmp(buf, file->data + pos, len) != 0) )
+                    data->errors++;
+                else
+                    data->bytes += len;
+                PHYSFS_close(f);
+            } /* else */
+        } /* if */
+
+        else if (op < 70)
+        {
+            PHYSFS_Stat statbuf;
+            sprintf(path, "%s/%.15s", stressmounts[mnt], file->name);
+            if (!PHYSFS_stat(path, &statbuf))
+                data->errors += churn ? 0 : 1;
+            else if (statbuf.filesize != (PHYSFS_sint64) file->len)
+                data->errors++;
+        } /* else if */
+
+        else if (op < 85)
+        {
+            char **list;
+            sprintf(path, "%s/d%02d", stressmounts[mnt],
+                    (int) (lcg(&state) % BENCH_DIRS));
+            list = PHYSFS_enumerateFiles(path);
+            if (list == NULL)
+                data->errors++;
+            else
+            {
+                char **i;
+                int count = 0;
+                for (i = list; *i != NULL; i++)
+                    count++;
+                if ((count != BENCH_FILES_PER_DIR) && ((!churn) || (count != 0)))
+                    data->errors++;
+                PHYSFS_freeList(list);
+            } /* else */
+        } /* else if */
+
+        else  /* a miss, which goes through the error state. */
+        {
+            sprintf(path, "%s/d%02d/nope", stressmounts[mnt],
+                    (int) (lcg(&state) % BENCH_DIRS));
+            if (PHYSFS_exists(path))
+                data->errors++;
+            PHYSFS_getLastErrorCode();
+        } /* else */
+
+        data->ops++;
+    } /* while */
+
+    free(buf);
+} /* stress_work */
+
+static void stress_churn(void *arg)
+{
+    StressData *data = (StressData *) arg;
+
+    while (now_ns() < data->deadline)
+    {
+        if (!PHYSFS_mount(stresschurnpath, stressmounts[3], 1))
+        {
+            data->errors++;
+            continue;
+        } /* if */
+
+        /* the workers may have files open in it; those keep it alive. */
+        if (!PHYSFS_unmount(stresschurnpath))
+            data->errors++;
+
+        data->ops++;
+    } /* while */
+} /* stress_churn */
+
+static void free_buf(void *ptr)
+{
+    free(ptr);
+} /* free_buf */
+
+/* Mount a native file from memory, so every open duplicates its io. */
+static int mount_memory(const char *filename, const char *mntpoint)
+{
+    char *path = native_path(filename);
+    FILE *in = fopen(path, "rb");
+    void *buf = NULL;
+    long len = 0;
+    int retval = 0;
+
+    free(path);
+    if (in == NULL)
+        return 0;
+
+    if ((fseek(in, 0, SEEK_END) == 0) && ((len = ftell(in)) > 0) &&
+        (fseek(in, 0, SEEK_SET) == 0))
+    {
+        buf = xmalloc((size_t) len);
+        if (fread(buf, (size_t) len, 1, in) == 1)
+            retval = PHYSFS_mountMemory(buf, (PHYSFS_uint64) len, free_buf,
+                                        filename, mntpoint, 1);
+        if (!retval)
+            free(buf);
+    } /* if */
+
+    fclose(in);
+    return retval;
+} /* mount_memory */
+
+static int bench_stress(const PHYSFS_uint64 duration, const int keep)
+{
+    StressData data[BENCH_MAX_THREADS + 1];
+    BenchThread threads[BENCH_MAX_THREADS + 1];
+    char *treepath = native_path("stress_tree");
+    char *isopath = native_path("stress.iso");
+    PHYSFS_uint64 errors = 0;
+    int count, i;
+
+    stresschurnpath = native_path("stress.pak");
+
+    if ( (!build_tree("stress_tree")) || (!build_iso("stress.iso")) ||
+         (!build_zip_deflated("stress.zip")) || (!build_qpak("stress.pak")) )
+    {
+        fprintf(stderr, "bench: couldn't write stress archives: %s\n",
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        errors++;
+    } /* if */
+
+    else if ( (!PHYSFS_mount(treepath, stressmounts[0], 1)) ||
+              (!PHYSFS_mount(isopath, stressmounts[1], 1)) ||
+              (!mount_memory("stress.zip", stressmounts[2])) )
+    {
+        fprintf(stderr, "bench: couldn't mount stress archives: %s\n",
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        errors++;
+    } /* else if */
+
+    else
+    {
+        for (count = 1; count <= maxthreads; count *= 2)
+        {
+            const PHYSFS_uint64 start = now_ns();
+            PHYSFS_uint64 ops = 0;
+            PHYSFS_uint64 bytes = 0;
+            int started = 0;
+
+            memset(data, '\0', sizeof (data));
+            for (i = 0; i <= count; i++)
+            {
+                data[i].index = i;
+                data[i].deadline = start + duration;
+                if (!start_thread(&threads[i], (i == count) ? stress_churn :
+                                  stress_work, &data[i]))
+                    break;
+                started++;
+            } /* for */
+
+            for (i = 0; i < started; i++)
+            {
+                wait_thread(&threads[i]);
+                errors += data[i].errors;
+                if (i < count)
+                {
+                    ops += data[i].ops;
+                    bytes += data[i].bytes;
+                } /* if */
+            } /* for */
+
+            if (started <= count)
+            {
+                fprintf(stderr, "bench: couldn't start %d threads\n", count + 1);
+                errors++;
+                break;
+            } /* if */
+
+            report("stress", "mixed_ops", count, ops, bytes, now_ns() - start);
+            report("stress", "mount_unmount", count, data[count].ops, 0,
+                   now_ns() - start);
+        } /* for */
+    } /* else */
+
+    PHYSFS_unmount("stress.zip");
+    PHYSFS_unmount(isopath);
+    PHYSFS_unmount(treepath);
+
+    if (!keep)
+    {
+        remove_tree("stress_tree");
+        PHYSFS_delete("stress.iso");
+        PHYSFS_delete("stress.zip");
+        PHYSFS_delete("stress.pak");
+    } /* if */
+
+    free(stresschurnpath);
+    free(isopath);
+    free(treepath);
+
+    if (errors)
+        fprintf(stderr, "bench: stress test saw %llu errors\n", (unsigned long long) errors);
+    return (errors == 0);
+} /* bench_stress */
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "USAGE: %s [--json] [--quick] [--keep] [--threads N] [--only NAME]\n"
+        "          [--stress]\n"
+        "\n"
+        "  --json       print results as a JSON array instead of CSV.\n"
+        "  --quick      a 1MiB big file and fewer iterations.\n"
+        "  --stress     instead of the benchmarks, run mixed operations on\n"
+        "               up to N threads while another mounts and unmounts.\n"
+        "  --keep       leave the generated archives in ./%s\n"
+        "  --threads N  most threads for the scaling test (default 8).\n"
+        "  --only NAME  just this archive:", argv0, BENCH_SCRATCH_DIR);
+    {
+        size_t i;
+        for (i = 0; i < sizeof (archives) / sizeof (archives[0]); i++)
+            fprintf(stderr, " %s", archives[i].name);
+    }
+    fprintf(stderr, "\n");
+} /* usage */
+
+
+int main(int argc, char **argv)
+{
+    const char *only = NULL;
+    PHYSFS_uint64 stress = 0;
+    int keep = 0;
+    int failed = 0;
+    size_t i;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        const char *arg = argv[argi];
+        if (strcmp(arg, "--json") == 0)
+            jsonoutput = 1;
+        else if (strcmp(arg, "--quick") == 0)
+        {
+            bigsize = 1024 * 1024;
+            iterations = 2;
+        } /* else if */
+        else if (strcmp(arg, "--stress") == 0)
+            stress = 1;
+        else if (strcmp(arg, "--keep") == 0)
+            keep = 1;
+        else if ((strcmp(arg, "--threads") == 0) && (argi + 1 < argc))
+        {
+            maxthreads = atoi(argv[++argi]);
+            if ((maxthreads < 1) || (maxthreads > BENCH_MAX_THREADS))
+            {
+                usage(argv[0]);
+                return 1;
+            } /* if */
+        } /* else if */
+        else if ((strcmp(arg, "--only") == 0) && (argi + 1 < argc))
+            only = argv[++argi];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        } /* else */
+    } /* for */
+
+    if (!PHYSFS_init(argv[0]))
+    {
+        fprintf(stderr, "bench: PHYSFS_init() failed: %s\n",
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        return 1;
+    } /* if */
+
+    if ( (!PHYSFS_setWriteDir(".")) || (!PHYSFS_mkdir(BENCH_SCRATCH_DIR)) ||
+         (!PHYSFS_setWriteDir(BENCH_SCRATCH_DIR)) )
+    {
+        fprintf(stderr, "bench: can't write to ./%s: %s\n", BENCH_SCRATCH_DIR,
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        PHYSFS_deinit();
+        return 1;
+    } /* if */
+
+    make_files();
+
+    if (stress)  /* seconds per thread count. */
+        failed = !bench_stress((iterations < 10) ? 250000000 : 2000000000, keep);
+
+    for (i = 0; i < sizeof (archives) / sizeof (archives[0]); i++)
+    {
+        const BenchArchive *archive = &archives[i];
+        if ((stress) || ((only != NULL) && (strcmp(only, archive->name) != 0)))
+            continue;
+
+        if (!bench_archive(archive))
+            failed = 1;
+
+        if (!keep)
+        {
+            if (archive->build == build_tree)
+                remove_tree(archive->filename);
+            else
+                PHYSFS_delete(archive->filename);
+        } /* if */
+    } /* for */
+
+    if (jsonoutput)
+        printf("%s]\n", resultcount ? "\n" : "");
+
+    if (!keep)
+    {
+        PHYSFS_setWriteDir(".");
+        PHYSFS_delete(BENCH_SCRATCH_DIR);
+    } /* if */
+
+    free_files();
+    PHYSFS_deinit();
+    return failed;
+} /* main */
+
+/* end of bench_physfs.c ... */
@@ -0,0 +1,702 @@
+/**
+ * Replay program for PhysicsFS.
+ *
+ * This plays back a capture written by PHYSFS_startTraceCapture() against
+ *  whatever search path you give it, with one thread for each thread in
+ *  the capture, each doing its events in order at the times they happened
+ *  (or as fast as it can, with --fast). Then it prints what each kind of
+ *  event cost in the capture and in the replay as CSV, so a change to
+ *  PhysicsFS, its settings or the archives can be judged against what a
+ *  real session did, instead of a synthetic benchmark.
+ *
+ * Mounts in the capture aren't replayed, as their paths belong to the
+ *  machine it came from; mount what the replay should see on the command
+ *  line. Handles are matched up by the pointer the capture recorded, so a
+ *  read on one thread of a file another thread opened works as long as the
+ *  open happened first; with --fast, it might not, and such events are
+ *  counted as skipped.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "physfs.h"
+
+#define REPLAY_MAX_THREADS 256
+
+typedef enum
+{
+    EV_MOUNT,
+    EV_OPEN,
+    EV_READ,
+    EV_SEEK,
+    EV_ENUMERATE,
+    EV_STAT,
+    EV_CLOSE,
+    EV_TOTAL
+} EventType;
+
+static const char *eventnames[EV_TOTAL] = {
+    "mount", "open", "read", "seek", "enumerate", "stat", "close"
+};
+
+typedef struct
+{
+    PHYSFS_uint64 start;
+    PHYSFS_uint64 duration;
+    PHYSFS_uint32 thread;
+    EventType type;
+    PHYSFS_sint64 handle;
+    PHYSFS_sint64 bytes;
+    PHYSFS_sint64 result;
+    PHYSFS_sint64 offset;
+    char *path;
+    size_t line;
+} Event;
+
+typedef struct
+{
+    PHYSFS_uint64 ops;
+    PHYSFS_uint64 failed;   /* worked in the capture, not here.  */
+    PHYSFS_uint64 skipped;  /* no handle to do it to.            */
+    PHYSFS_uint64 bytes;
+    PHYSFS_uint64 captured_ns;
+    PHYSFS_uint64 replay_ns;
+} EventStats;
+
+typedef struct
+{
+    PHYSFS_sint64 handle;
+    PHYSFS_File *file;
+} OpenHandle;
+
+typedef struct
+{
+    PHYSFS_uint32 thread;
+    Event **events;
+    size_t count;
+    EventStats stats[EV_TOTAL];
+} ReplayThread;
+
+static Event *events = NULL;
+static size_t eventcount = 0;
+static int fast = 0;
+static PHYSFS_uint64 replaystart = 0;
+static OpenHandle *handles = NULL;
+static size_t handlecount = 0;
+static size_t handlealloc = 0;
+
+
+/* Timing, threads and locking... */
+
+static PHYSFS_uint64 now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (PHYSFS_uint64) ((((double) count.QuadPart) * 1000000000.0) /
+                            ((double) freq.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((PHYSFS_uint64) ts.tv_sec) * 1000000000) + ts.tv_nsec;
+#endif
+} /* now_ns */
+
+static void sleep_until(PHYSFS_uint64 when)
+{
+    const PHYSFS_uint64 now = now_ns();
+    if (when > now)
+    {
+#ifdef _WIN32
+        Sleep((DWORD) ((when - now) / 1000000));
+#else
+        struct timespec ts;
+        ts.tv_sec = (time_t) ((when - now) / 1000000000);
+        ts.tv_nsec = (long) ((when - now) % 1000000000);
+        nanosleep(&ts, NULL);
+#endif
+    } /* if */
+} /* sleep_until */
+
+
+typedef struct
+{
+    void (*func)(void *data);
+    void *data;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} Thread;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg)
+{
+    Thread *thread = (Thread *) arg;
+    thread->func(thread->data);
+    return 0;
+} /* thread_main */
+#else
+static void *thread_main(void *arg)
+{
+    Thread *thread = (Thread *) arg;
+    thread->func(thread->data);
+    return NULL;
+} /* thread_main */
+#endif
+
+static int start_thread(Thread *thread, void (*func)(void *), void *data)
+{
+    thread->func = func;
+    thread->data = data;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+    return (thread->handle != NULL);
+#else
+    return (pthread_create(&thread->handle, NULL, thread_main, thread) == 0);
+#endif
+} /* start_thread */
+
+static void wait_thread(Thread *thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+} /* wait_thread */
+
+
+#ifdef _WIN32
+static CRITICAL_SECTION handlelock;
+#define init_lock() InitializeCriticalSection(&handlelock)
+#define lock() EnterCriticalSection(&handlelock)
+#define unlock() LeaveCriticalSection(&handlelock)
+#else
+static pthread_mutex_t handlelock = PTHREAD_MUTEX_INITIALIZER;
+#define init_lock()
+#define lock() pthread_mutex_lock(&handlelock)
+#define unlock() pthread_mutex_unlock(&handlelock)
+#endif
+
+
+/* Captured handles to ours... */
+
+static int add_handle(PHYSFS_sint64 handle, PHYSFS_File *file)
+{
+    lock();
+    if (handlecount == handlealloc)
+    {
+        const size_t newalloc = handlealloc ? handlealloc * 2 : 64;
+        void *ptr = realloc(handles, newalloc * sizeof (OpenHandle));
+        if (ptr == NULL)
+        {
+            unlock();
+            return 0;
+        } /* if */
+        handles = (OpenHandle *) ptr;
+        handlealloc = newalloc;
+    } /* if */
+    handles[handlecount].handle = handle;
+    handles[handlecount].file = file;
+    handlecount++;
+    unlock();
+    return 1;
+} /* add_handle */
+
+/* (remove) takes it out of the table, for closing. */
+static PHYSFS_File *find_handle(PHYSFS_sint64 handle, int remove)
+{
+    PHYSFS_File *retval = NULL;
+    size_t i;
+
+    lock();
+    for (i = handlecount; i > 0; i--)  /* newest first; pointers get reused. */
+    {
+        if (handles[i - 1].handle == handle)
+        {
+            retval = handles[i - 1].file;
+            if (remove)
+                handles[i - 1] = handles[--handlecount];
+            break;
+        } /* if */
+    } /* for */
+    unlock();
+    return retval;
+} /* find_handle */
+
+
+/* Loading the capture... */
+
+static char *unescape(const char *str)
+{
+    char *retval = (char *) malloc(strlen(str) + 1);
+    char *dst = retval;
+
+    if (retval == NULL)
+        return NULL;
+
+    while (*str)
+    {
+        if ((str[0] == '\\') && (str[1] == 'n'))
+        {
+            *(dst++) = '\n';
+            str += 2;
+        } /* if */
+        else if ((str[0] == '\\') && (str[1] == '\\'))
+        {
+            *(dst++) = '\\';
+            str += 2;
+        } /* else if */
+        else
+        {
+            *(dst++) = *(str++);
+        } /* else */
+    } /* while */
+    *dst = '\0';
+    return retval;
+} /* unescape */
+
+static int parse_event(char *line, Event *ev)
+{
+    unsigned long long start, duration;
+    long long handle, bytes, result, offset;
+    unsigned int thread;
+    char name[16];
+    int pathpos = 0;
+    int i;
+
+    if (sscanf(line, "%llu %llu %u %15s %lld %lld %lld %lld %n", &start,
+               &duration, &thread, name, &handle, &bytes, &result, &offset,
+               &pathpos) < 8)
+        return 0;
+    else if (pathpos == 0)  /* no space before the path; it's cut off. */
+        return 0;
+
+    for (i = 0; i < EV_TOTAL; i++)
+    {
+        if (strcmp(name, eventnames[i]) == 0)
+            break;
+    } /* for */
+
+    if (i == EV_TOTAL)
+        return 0;
+
+    ev->start = (PHYSFS_uint64) start;
+    ev->duration = (PHYSFS_uint64) duration;
+    ev->thread = (PHYSFS_uint32) thread;
+    ev->type = (EventType) i;
+    ev->handle = (PHYSFS_sint64) handle;
+    ev->bytes = (PHYSFS_sint64) bytes;
+    ev->result = (PHYSFS_sint64) result;
+    ev->offset = (PHYSFS_sint64) offset;
+    ev->path = unescape(line + pathpos);
+    return (ev->path != NULL);
+} /* parse_event */
+
+static int load_capture(const char *fname)
+{
+    FILE *io = fopen(fname, "r");
+    size_t alloc = 0;
+    size_t linenum = 0;
+    char *line = NULL;
+    size_t linealloc = 0;
+    int retval = 0;
+
+    if (io == NULL)
+    {
+        fprintf(stderr, "replay: can't open %s.\n", fname);
+        return 0;
+    } /* if */
+
+    while (1)
+    {
+        size_t len = 0;
+        int ch;
+
+        /* paths can be long, so read lines by hand. */
+        while (((ch = fgetc(io)) != EOF) && (ch != '\n'))
+        {
+            if (len + 1 >= linealloc)
+            {
+                const size_t newalloc = linealloc ? linealloc * 2 : 256;
+                char *ptr = (char *) realloc(line, newalloc);
+                if (ptr == NULL)
+                    goto load_capture_failed;
+                line = ptr;
+                linealloc = newalloc;
+            } /* if */
+            line[len++] = (char) ch;
+        } /* while */
+
+        if ((ch == EOF) && (len == 0))
+            break;
+        else if (len == 0)
+            continue;  /* blank line. */
+
+        line[len] = '\0';
+        linenum++;
+
+        if (linenum == 1)
+        {
+            if (strcmp(line, "PHYSFS-TRACE 1") != 0)
+            {
+                fprintf(stderr, "replay: %s isn't a capture.\n", fname);
+                goto load_capture_failed;
+            } /* if */
+            continue;
+        } /* if */
+
+        if (eventcount == alloc)
+        {
+            const size_t newalloc = alloc ? alloc * 2 : 1024;
+            void *ptr = realloc(events, newalloc * sizeof (Event));
+            if (ptr == NULL)
+                goto load_capture_failed;
+            events = (Event *) ptr;
+            alloc = newalloc;
+        } /* if */
+
+        if (!parse_event(line, &events[eventcount]))
+        {
+            fprintf(stderr, "replay: %s:%lu is bad.\n", fname,
+                    (unsigned long) linenum);
+            goto load_capture_failed;
+        } /* if */
+
+        events[eventcount].line = linenum;
+        eventcount++;
+    } /* while */
+
+    if (linenum == 0)
+        fprintf(stderr, "replay: %s is empty.\n", fname);
+    else
+        retval = 1;
+
+load_capture_failed:
+    free(line);
+    fclose(io);
+    return retval;
+} /* load_capture */
+
+/* Lines are written as events end; put them back in the order they began. */
+static int cmp_events(const void *_a, const void *_b)
+{
+    const Event *a = (const Event *) _a;
+    const Event *b = (const Event *) _b;
+    if (a->start != b->start)
+        return (a->start < b->start) ? -1 : 1;
+    return (a->line < b->line) ? -1 : (a->line > b->line);
+} /* cmp_events */
+
+
+/* Replaying... */
+
+static void replay_event(const Event *ev, EventStats *stats,
+                         void **buf, size_t *bufsize)
+{
+    const int worked = (ev->result != 0) && (ev->result != -1);
+    PHYSFS_File *file = NULL;
+    PHYSFS_sint64 br = 0;
+    PHYSFS_uint64 start;
+    int ok = 1;
+
+    if ((ev->type == EV_READ) || (ev->type == EV_SEEK))
+    {
+        file = find_handle(ev->handle, 0);
+        if (file == NULL)
+        {
+            stats->skipped++;
+            return;
+        } /* if */
+
+        if ((ev->type == EV_READ) && ((size_t) ev->bytes > *bufsize))
+        {
+            void *ptr = realloc(*buf, (size_t) ev->bytes);
+            if (ptr == NULL)
+            {
+                stats->skipped++;
+                return;
+            } /* if */
+            *buf = ptr;
+            *bufsize = (size_t) ev->bytes;
+        } /* if */
+    } /* if */
+
+    else if (ev->type == EV_CLOSE)
+    {
+        file = find_handle(ev->handle, 1);
+        if (file == NULL)
+        {
+            stats->skipped++;
+            return;
+        } /* if */
+    } /* else if */
+
+    start = now_ns();
+    switch (ev->type)
+    {
+        case EV_OPEN:
+            file = PHYSFS_openRead(ev->path);
+            ok = (file != NULL);
+            break;
+
+        case EV_READ:
+            if (ev->offset >= 0)
+            {
+                br = PHYSFS_readAt(file, *buf, (PHYSFS_uint64) ev->bytes,
+                                   (PHYSFS_uint64) ev->offset);
+            } /* if */
+            else
+            {
+                br = PHYSFS_readBytes(file, *buf, (PHYSFS_uint64) ev->bytes);
+            } /* else */
+            ok = (br >= 0);
+            break;
+
+        case EV_SEEK:
+            ok = PHYSFS_seek(file, (PHYSFS_uint64) ev->bytes);
+            break;
+
+        case EV_ENUMERATE:
+        {
+            char **list = PHYSFS_enumerateFiles(ev->path);
+            ok = (list != NULL);
+            PHYSFS_freeList(list);
+            break;
+        } /* case */
+
+        case EV_STAT:
+        {
+            PHYSFS_Stat statbuf;
+            ok = PHYSFS_stat(ev->path, &statbuf);
+            break;
+        } /* case */
+
+        case EV_CLOSE:
+            ok = PHYSFS_close(file);
+            break;
+
+        default:
+            break;
+    } /* switch */
+    stats->replay_ns += now_ns() - start;
+
+    stats->ops++;
+    stats->captured_ns += ev->duration;
+    if (br > 0)
+        stats->bytes += (PHYSFS_uint64) br;
+    if ((worked) && (!ok))
+        stats->failed++;
+
+    if ((ev->type == EV_OPEN) && (file != NULL))
+    {
+        if (!add_handle(ev->handle, file))
+            PHYSFS_close(file);
+    } /* if */
+} /* replay_event */
+
+static void replay_thread(void *data)
+{
+    ReplayThread *thread = (ReplayThread *) data;
+    void *buf = NULL;
+    size_t bufsize = 0;
+    size_t i;
+
+    for (i = 0; i < thread->count; i++)
+    {
+        const Event *ev = thread->events[i];
+        if (ev->type == EV_MOUNT)
+            continue;  /* we use the command line's. */
+        if (!fast)
+            sleep_until(replaystart + ev->start);
+        replay_event(ev, &thread->stats[ev->type], &buf, &bufsize);
+    } /* for */
+
+    free(buf);
+} /* replay_thread */
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "USAGE: %s [--fast] <capture> <archive> [archive...]\n"
+        "  Plays a PHYSFS_startTraceCapture() capture back against the\n"
+        "  archives (or dirs), mounted at the root in the order given, and\n"
+        "  prints what each kind of event cost then and now as CSV.\n"
+        "  --fast  don't wait for each event's time; go flat out.\n", argv0);
+} /* usage */
+
+
+int main(int argc, char **argv)
+{
+    static ReplayThread threads[REPLAY_MAX_THREADS + 1];
+    static Thread running[REPLAY_MAX_THREADS + 1];
+    EventStats total[EV_TOTAL];
+    const char *capture = NULL;
+    PHYSFS_uint64 wall;
+    PHYSFS_uint64 captured_wall = 0;
+    int threadcount = 0;
+    int retval = 1;
+    int argi;
+    size_t i;
+    int t;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        if (strcmp(argv[argi], "--fast") == 0)
+            fast = 1;
+        else
+            break;
+    } /* for */
+
+    if (argi + 2 > argc)
+    {
+        usage(argv[0]);
+        return 1;
+    } /* if */
+
+    capture = argv[argi++];
+    init_lock();
+
+    if (!PHYSFS_init(argv[0]))
+    {
+        fprintf(stderr, "replay: PHYSFS_init() failed: %s\n",
+                PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        return 1;
+    } /* if */
+
+    for (; argi < argc; argi++)
+    {
+        if (!PHYSFS_mount(argv[argi], NULL, 1))
+        {
+            fprintf(stderr, "replay: can't mount %s: %s\n", argv[argi],
+                    PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+            goto main_done;
+        } /* if */
+    } /* for */
+
+    if (!load_capture(capture))
+        goto main_done;
+
+    qsort(events, eventcount, sizeof (Event), cmp_events);
+
+    /* a replay thread per captured thread; the ones past 256 share one. */
+    for (i = 0; i < eventcount; i++)
+    {
+        Event *ev = &events[i];
+        ReplayThread *thread = NULL;
+        if (ev->thread > REPLAY_MAX_THREADS)
+            ev->thread = 0;
+        for (t = 0; t < threadcount; t++)
+        {
+            if (threads[t].thread == ev->thread)
+            {
+                thread = &threads[t];
+                break;
+            } /* if */
+        } /* for */
+
+        if (thread == NULL)
+        {
+            thread = &threads[threadcount++];
+            thread->thread = ev->thread;
+            thread->events = (Event **) malloc(eventcount * sizeof (Event *));
+            if (thread->events == NULL)
+            {
+                fprintf(stderr, "replay: out of memory.\n");
+                goto main_done;
+            } /* if */
+        } /* if */
+        thread->events[thread->count++] = ev;
+
+        if (ev->start + ev->duration > captured_wall)
+            captured_wall = ev->start + ev->duration;
+    } /* for */
+
+    replaystart = now_ns();
+    for (t = 0; t < threadcount; t++)
+    {
+        if (!start_thread(&running[t], replay_thread, &threads[t]))
+        {
+            fprintf(stderr, "replay: can't start a thread.\n");
+            while (t > 0)
+                wait_thread(&running[--t]);
+            goto main_done;
+        } /* if */
+    } /* for */
+
+    for (t = 0; t < threadcount; t++)
+        wait_thread(&running[t]);
+    wall = now_ns() - replaystart;
+
+    memset(total, '\0', sizeof (total));
+    for (t = 0; t < threadcount; t++)
+    {
+        for (i = 0; i < EV_TOTAL; i++)
+        {
+            const EventStats *stats = &threads[t].stats[i];
+            total[i].ops += stats->ops;
+            total[i].failed += stats->failed;
+            total[i].skipped += stats->skipped;
+            total[i].bytes += stats->bytes;
+            total[i].captured_ns += stats->captured_ns;
+            total[i].replay_ns += stats->replay_ns;
+        } /* for */
+    } /* for */
+
+    printf("event,ops,failed,skipped,bytes,captured_ns,replay_ns,speedup\n");
+    for (i = 0; i < EV_TOTAL; i++)
+    {
+        const EventStats *stats = &total[i];
+        if ((stats->ops == 0) && (stats->skipped == 0))
+            continue;
+        printf("%s,%llu,%llu,%llu,%llu,%llu,%llu,%.2f\n", eventnames[i],
+               (unsigned long long) stats->ops,
+               (unsigned long long) stats->failed,
+               (unsigned long long) stats->skipped,
+               (unsigned long long) stats->bytes,
+               (unsigned long long) stats->captured_ns,
+               (unsigned long long) stats->replay_ns,
+               stats->replay_ns ? ((double) stats->captured_ns) /
+                                  ((double) stats->replay_ns) : 0.0);
+    } /* for */
+    printf("wall,%d,0,0,0,%llu,%llu,%.2f\n", threadcount,
+           (unsigned long long) captured_wall, (unsigned long long) wall,
+           wall ? ((double) captured_wall) / ((double) wall) : 0.0);
+
+    retval = 0;
+
+main_done:
+    /* anything the capture never closed. */
+    for (i = 0; i < handlecount; i++)
+        PHYSFS_close(handles[i].file);
+    free(handles);
+
+    for (t = 0; t < threadcount; t++)
+        free(threads[t].events);
+    for (i = 0; i < eventcount; i++)
+        free(events[i].path);
+    free(events);
+
+    PHYSFS_deinit();
+    return retval;
+} /* main */
+
+/* end of replay_physfs.c ... */
@@ -23,6 +23,12 @@
 
 #include <time.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 /* Define this, so the compiler doesn't complain about using old APIs. */
 #define PHYSFS_DEPRECATED
 
@@ -917,6 +923,523 @@ static int cmd_crc32(char *args)
 } /* cmd_crc32 */
 
 
+static int cmd_checksum(char *args)
+{
+    PHYSFS_uint32 crc = 0;
+
+    if (*args == '\"')
+    {
+        args++;
+        args[strlen(args) - 1] = '\0';
+    } /* if */
+
+    if (!PHYSFS_getChecksum(args, &crc))
+        printf("Failed. Reason: [%s].\n", PHYSFS_getLastError());
+    else
+        printf("CRC32 for %s: 0x%08X\n", args, (unsigned int) crc);
+
+    return 1;
+} /* cmd_checksum */
+
+
+/* wall clock in nanoseconds, for the bench_* commands. */
+static PHYSFS_uint64 bench_now(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (PHYSFS_uint64) ((((double) count.QuadPart) * 1000000000.0) /
+                            ((double) freq.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((PHYSFS_uint64) ts.tv_sec) * 1000000000) + ts.tv_nsec;
+#endif
+} /* bench_now */
+
+
+/* Pull the next (possibly quoted) argument off (*args). */
+static char *bench_nextarg(char **args)
+{
+    char *retval = *args;
+    char *ptr;
+
+    if (retval == NULL)
+        return NULL;
+
+    if (*retval == '\"')
+    {
+        retval++;
+        ptr = strchr(retval, '\"');
+        if (ptr == NULL)
+        {
+            printf("missing string terminator in argument.\n");
+            return NULL;
+        } /* if */
+        *(ptr++) = '\0';
+        if (*ptr == ' ')
+            ptr++;
+    } /* if */
+    else
+    {
+        ptr = strchr(retval, ' ');
+        if (ptr != NULL)
+            *(ptr++) = '\0';
+    } /* else */
+
+    *args = ptr;
+    return retval;
+} /* bench_nextarg */
+
+
+static int bench_cmp(const void *a, const void *b)
+{
+    const PHYSFS_uint64 x = *((const PHYSFS_uint64 *) a);
+    const PHYSFS_uint64 y = *((const PHYSFS_uint64 *) b);
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+} /* bench_cmp */
+
+
+/* sorts (samples). */
+static void bench_latency(const char *what, PHYSFS_uint64 *samples, size_t count)
+{
+    PHYSFS_uint64 total = 0;
+    size_t i;
+
+    if (count == 0)
+        return;
+
+    qsort(samples, count, sizeof (PHYSFS_uint64), bench_cmp);
+    for (i = 0; i < count; i++)
+        total += samples[i];
+
+    printf("%s latency (usec): min %.1f, avg %.1f, p50 %.1f, p99 %.1f, max %.1f\n",
+           what, samples[0] / 1000.0, (total / (double) count) / 1000.0,
+           samples[count / 2] / 1000.0, samples[(count * 99) / 100] / 1000.0,
+           samples[count - 1] / 1000.0);
+} /* bench_latency */
+
+
+static void bench_throughput(PHYSFS_uint64 bytes, PHYSFS_uint64 ns)
+{
+    const double secs = ns / 1000000000.0;
+    printf("%.0f bytes in %.3f ms: %.2f MB/s.\n", (double) bytes,
+           ns / 1000000.0, (secs > 0.0) ? ((bytes / secs) / 1048576.0) : 0.0);
+} /* bench_throughput */
+
+
+/* reads a native text file of PhysicsFS paths, one per line. */
+static char **bench_loadlist(const char *fname, size_t *count)
+{
+    FILE *in = fopen(fname, "r");
+    char **retval = NULL;
+    char buf[1024];
+
+    *count = 0;
+    if (in == NULL)
+    {
+        printf("Failed to open %s: %s.\n", fname, strerror(errno));
+        return NULL;
+    } /* if */
+
+    while (fgets(buf, sizeof (buf), in) != NULL)
+    {
+        size_t len = strlen(buf);
+        void *ptr;
+
+        while ((len > 0) && ((buf[len-1] == '\n') || (buf[len-1] == '\r')))
+            buf[--len] = '\0';
+        if (len == 0)
+            continue;
+
+        ptr = realloc(retval, sizeof (char *) * (*count + 1));
+        if (ptr == NULL)
+            break;
+        retval = (char **) ptr;
+        retval[*count] = (char *) malloc(len + 1);
+        if (retval[*count] == NULL)
+            break;
+        strcpy(retval[(*count)++], buf);
+    } /* while */
+
+    fclose(in);
+
+    if (*count == 0)
+        printf("No paths listed in %s.\n", fname);
+    return retval;
+} /* bench_loadlist */
+
+
+static void bench_freelist(char **list, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+        free(list[i]);
+    free(list);
+} /* bench_freelist */
+
+
+/* Open (fname), read all of it in (blocksize) pieces; -1 if it failed. */
+static PHYSFS_sint64 bench_readall(const char *fname, void *buf,
+                                   PHYSFS_uint32 blocksize,
+                                   PHYSFS_uint64 *samples, size_t *count)
+{
+    PHYSFS_File *f = PHYSFS_openRead(fname);
+    PHYSFS_sint64 retval = 0;
+
+    if (f == NULL)
+        return -1;
+
+    if ((do_buffer_size) && (!PHYSFS_setBuffer(f, do_buffer_size)))
+    {
+        PHYSFS_close(f);
+        return -1;
+    } /* if */
+
+    while (1)
+    {
+        const PHYSFS_uint64 start = (samples != NULL) ? bench_now() : 0;
+        const PHYSFS_sint64 rc = PHYSFS_readBytes(f, buf, blocksize);
+        if (samples != NULL)
+            samples[(*count)++] = bench_now() - start;
+        if (rc <= 0)
+        {
+            if (rc < 0)
+                retval = -1;
+            break;
+        } /* if */
+        retval += rc;
+    } /* while */
+
+    PHYSFS_close(f);
+    return retval;
+} /* bench_readall */
+
+
+static int cmd_bench_read(char *args)
+{
+    char *fname = bench_nextarg(&args);
+    char *blockstr = bench_nextarg(&args);
+    char *iterstr = bench_nextarg(&args);
+    PHYSFS_uint64 *samples = NULL;
+    PHYSFS_uint64 bytes = 0;
+    PHYSFS_uint64 elapsed;
+    PHYSFS_Stat statbuf;
+    size_t count = 0;
+    size_t maxsamples;
+    int blocksize, iterations, i;
+    void *buf;
+
+    if ((fname == NULL) || (blockstr == NULL) || (iterstr == NULL))
+        return 1;
+
+    blocksize = atoi(blockstr);
+    iterations = atoi(iterstr);
+    if ((blocksize <= 0) || (iterations <= 0))
+    {
+        printf("blocksize and iterations must be greater than zero.\n");
+        return 1;
+    } /* if */
+
+    /* the size is just for the samples array. */
+    if ((!PHYSFS_stat(fname, &statbuf)) || (statbuf.filesize < 0))
+    {
+        printf("failed to stat. Reason: [%s].\n", PHYSFS_getLastError());
+        return 1;
+    } /* if */
+
+    maxsamples = (size_t) ((statbuf.filesize / blocksize) + 2) * iterations;
+    samples = (PHYSFS_uint64 *) malloc(maxsamples * sizeof (PHYSFS_uint64));
+    buf = malloc(blocksize);
+    if ((samples == NULL) || (buf == NULL))
+    {
+        printf("Out of memory.\n");
+        free(samples);
+        free(buf);
+        return 1;
+    } /* if */
+
+    elapsed = bench_now();
+    for (i = 0; i < iterations; i++)
+    {
+        const PHYSFS_sint64 rc = bench_readall(fname, buf, blocksize,
+                                               samples, &count);
+        if (rc < 0)
+        {
+            printf("read failed. Reason: [%s].\n", PHYSFS_getLastError());
+            break;
+        } /* if */
+        bytes += rc;
+    } /* for */
+    elapsed = bench_now() - elapsed;
+
+    if (i == iterations)
+    {
+        bench_throughput(bytes, elapsed);
+        bench_latency("Read", samples, count);
+    } /* if */
+
+    free(samples);
+    free(buf);
+    return 1;
+} /* cmd_bench_read */
+
+
+static int cmd_bench_open(char *args)
+{
+    PHYSFS_uint64 *samples;
+    PHYSFS_uint64 elapsed;
+    size_t count, i;
+    size_t failures = 0;
+    char **list;
+
+    if (*args == '\"')
+    {
+        args++;
+        args[strlen(args) - 1] = '\0';
+    } /* if */
+
+    list = bench_loadlist(args, &count);
+    if (list == NULL)
+        return 1;
+
+    samples = (PHYSFS_uint64 *) malloc(count * sizeof (PHYSFS_uint64));
+    if (samples == NULL)
+    {
+        printf("Out of memory.\n");
+        bench_freelist(list, count);
+        return 1;
+    } /* if */
+
+    elapsed = bench_now();
+    for (i = 0; i < count; i++)
+    {
+        const PHYSFS_uint64 start = bench_now();
+        PHYSFS_File *f = PHYSFS_openRead(list[i]);
+        if (f == NULL)
+            failures++;
+        else
+            PHYSFS_close(f);
+        samples[i] = bench_now() - start;
+    } /* for */
+    elapsed = bench_now() - elapsed;
+
+    printf("Opened %lu files (%lu failed) in %.3f ms.\n",
+           (unsigned long) (count - failures), (unsigned long) failures,
+           elapsed / 1000000.0);
+    bench_latency("Open", samples, count);
+
+    free(samples);
+    bench_freelist(list, count);
+    return 1;
+} /* cmd_bench_open */
+
+
+typedef struct
+{
+    PHYSFS_uint64 dirs;
+    PHYSFS_uint64 entries;
+} BenchEnumData;
+
+static void bench_enumdir(const char *dname, BenchEnumData *data)
+{
+    char **rc = PHYSFS_enumerateFiles(dname);
+    char **i;
+
+    data->dirs++;
+    if (rc == NULL)
+        return;
+
+    for (i = rc; *i != NULL; i++)
+    {
+        const size_t len = strlen(dname) + strlen(*i) + 2;
+        char *path = (char *) malloc(len);
+        PHYSFS_Stat statbuf;
+
+        data->entries++;
+        if (path == NULL)
+            continue;
+
+        if (*dname == '\0')
+            strcpy(path, *i);
+        else
+            sprintf(path, "%s/%s", dname, *i);
+
+        if ((PHYSFS_stat(path, &statbuf)) &&
+            (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY))
+            bench_enumdir(path, data);
+
+        free(path);
+    } /* for */
+
+    PHYSFS_freeList(rc);
+} /* bench_enumdir */
+
+
+static int cmd_bench_enum(char *args)
+{
+    BenchEnumData data;
+    PHYSFS_uint64 elapsed;
+
+    if (*args == '\"')
+    {
+        args++;
+        args[strlen(args) - 1] = '\0';
+    } /* if */
+
+    if (!PHYSFS_isDirectory(args))
+    {
+        printf("Not a directory: %s.\n", args);
+        return 1;
+    } /* if */
+
+    /* walk the whole tree, stat'ing everything to find subdirs. */
+    memset(&data, '\0', sizeof (data));
+    elapsed = bench_now();
+    bench_enumdir(args, &data);
+    elapsed = bench_now() - elapsed;
+
+    printf("Enumerated %.0f entries in %.0f dirs in %.3f ms "
+           "(%.1f usec per entry).\n", (double) data.entries,
+           (double) data.dirs, elapsed / 1000000.0,
+           data.entries ? ((elapsed / (double) data.entries) / 1000.0) : 0.0);
+
+    return 1;
+} /* cmd_bench_enum */
+
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_THREAD_BLOCKSIZE (64 * 1024)
+
+typedef struct
+{
+    char **list;
+    size_t count;
+    size_t first;
+    PHYSFS_uint64 bytes;
+    PHYSFS_uint64 failures;
+    PHYSFS_uint64 elapsed;
+} BenchThreadData;
+
+/* every thread reads every file on the list, each starting somewhere else. */
+static void bench_thread_work(BenchThreadData *data)
+{
+    const PHYSFS_uint64 start = bench_now();
+    void *buf = malloc(BENCH_THREAD_BLOCKSIZE);
+    size_t i;
+
+    for (i = 0; (buf != NULL) && (i < data->count); i++)
+    {
+        const char *fname = data->list[(data->first + i) % data->count];
+        const PHYSFS_sint64 rc = bench_readall(fname, buf,
+                                      BENCH_THREAD_BLOCKSIZE, NULL, NULL);
+        if (rc < 0)
+            data->failures++;
+        else
+            data->bytes += rc;
+    } /* for */
+
+    free(buf);
+    data->elapsed = bench_now() - start;
+} /* bench_thread_work */
+
+#ifdef _WIN32
+static DWORD WINAPI bench_thread(LPVOID arg)
+{
+    bench_thread_work((BenchThreadData *) arg);
+    return 0;
+} /* bench_thread */
+#else
+static void *bench_thread(void *arg)
+{
+    bench_thread_work((BenchThreadData *) arg);
+    return NULL;
+} /* bench_thread */
+#endif
+
+static int cmd_bench_threads(char *args)
+{
+    char *numstr = bench_nextarg(&args);
+    char *fname = bench_nextarg(&args);
+    BenchThreadData data[BENCH_MAX_THREADS];
+#ifdef _WIN32
+    HANDLE threads[BENCH_MAX_THREADS];
+#else
+    pthread_t threads[BENCH_MAX_THREADS];
+#endif
+    PHYSFS_uint64 bytes = 0;
+    PHYSFS_uint64 failures = 0;
+    PHYSFS_uint64 elapsed;
+    int num, started, i;
+    size_t count;
+    char **list;
+
+    if ((numstr == NULL) || (fname == NULL))
+        return 1;
+
+    num = atoi(numstr);
+    if ((num <= 0) || (num > BENCH_MAX_THREADS))
+    {
+        printf("thread count must be between 1 and %d.\n", BENCH_MAX_THREADS);
+        return 1;
+    } /* if */
+
+    list = bench_loadlist(fname, &count);
+    if (list == NULL)
+        return 1;
+
+    elapsed = bench_now();
+    for (started = 0; started < num; started++)
+    {
+        memset(&data[started], '\0', sizeof (BenchThreadData));
+        data[started].list = list;
+        data[started].count = count;
+        data[started].first = (count * started) / num;
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0, bench_thread,
+                                        &data[started], 0, NULL);
+        if (threads[started] == NULL)
+            break;
+#else
+        if (pthread_create(&threads[started], NULL, bench_thread,
+                           &data[started]) != 0)
+            break;
+#endif
+    } /* for */
+
+    for (i = 0; i < started; i++)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+        bytes += data[i].bytes;
+        failures += data[i].failures;
+    } /* for */
+    elapsed = bench_now() - elapsed;
+
+    if (started < num)
+        printf("Only managed to start %d threads.\n", started);
+
+    printf("%d threads read %lu files each (%.0f failed opens/reads).\n",
+           started, (unsigned long) count, (double) failures);
+    bench_throughput(bytes, elapsed);
+    for (i = 0; i < started; i++)
+    {
+        printf("  thread %d: ", i);
+        bench_throughput(data[i].bytes, data[i].elapsed);
+    } /* for */
+
+    bench_freelist(list, count);
+    return 1;
+} /* cmd_bench_threads */
+
+
 static int cmd_filelength(char *args)
 {
     PHYSFS_File *f;
@@ -1111,6 +1634,38 @@ static int cmd_stat(char *args)
 } /* cmd_filelength */
 
 
+static int cmd_layout(char *args)
+{
+    PHYSFS_EntryLayout layout;
+
+    if (*args == '\"')
+    {
+        args++;
+        args[strlen(args) - 1] = '\0';
+    } /* if */
+
+    if (!PHYSFS_statLayout(args, &layout))
+    {
+        printf("Failed. Reason: [%s].\n", PHYSFS_getLastError());
+        return 1;
+    } /* if */
+
+    printf("In: %s\n", layout.mount);
+    printf("Offset: %llu\n", (unsigned long long) layout.offset);
+    printf("Stored size: %llu\n", (unsigned long long) layout.storedSize);
+    printf("Size: %llu\n", (unsigned long long) layout.size);
+    printf("Encoding: %d (method %u)\n", (int) layout.encoding,
+           (unsigned int) layout.method);
+    if (layout.group >= 0)
+    {
+        printf("Group: %lld, at %llu\n", (long long) layout.group,
+               (unsigned long long) layout.groupOffset);
+    } /* if */
+
+    return 1;
+} /* cmd_layout */
+
+
 
 /* must have spaces trimmed prior to this call. */
 static int count_args(const char *str)
@@ -1179,12 +1734,18 @@ static const command_info commands[] =
     { "cat",            cmd_cat,            1, "<fileToCat>"                },
     { "filelength",     cmd_filelength,     1, "<fileToCheck>"              },
     { "stat",           cmd_stat,           1, "<fileToStat>"               },
+    { "layout",         cmd_layout,         1, "<fileToLocate>"             },
     { "append",         cmd_append,         1, "<fileToAppend>"             },
     { "write",          cmd_write,          1, "<fileToCreateOrTrash>"      },
     { "getlastmodtime", cmd_getlastmodtime, 1, "<fileToExamine>"            },
     { "setbuffer",      cmd_setbuffer,      1, "<bufferSize>"               },
     { "stressbuffer",   cmd_stressbuffer,   1, "<bufferSize>"               },
     { "crc32",          cmd_crc32,          1, "<fileToHash>"               },
+    { "checksum",       cmd_checksum,       1, "<fileToHash>"               },
+    { "bench_read",     cmd_bench_read,     3, "<fileToRead> <blockSize> <iterations>" },
+    { "bench_open",     cmd_bench_open,     1, "<nativeListOfFiles>"        },
+    { "bench_enum",     cmd_bench_enum,     1, "<dirToWalk>"                },
+    { "bench_threads",  cmd_bench_threads,  2, "<threadCount> <nativeListOfFiles>" },
     { "getmountpoint",  cmd_getmountpoint,  1, "<dir>"                      },
     { NULL,             NULL,              -1, NULL                         }
 };